@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/cc/saved_model/fingerprinting_utils.h"
 
 #include <algorithm>
+#include <atomic>
+#include <climits>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -33,10 +35,12 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_def.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/protobuf/fingerprint.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/protobuf/saved_model.pb.h"
@@ -70,6 +74,10 @@ using tools::proto_splitter::ReadChunk;
 
 namespace fingerprinting_utils_internal {
 
+// Upper bound on the threads that read and hash chunks. Beyond this, reading
+// the chunks is bound by I/O rather than by hashing.
+constexpr int kMaxHashChunksThreads = 16;
+
 using ::tensorflow::protobuf::Map;
 using ::tensorflow::protobuf::Message;
 using ::tensorflow::protobuf::RepeatedPtrField;
@@ -200,11 +208,54 @@ std::string SerializeProto(const Message& message) {
   return serialized_message;
 }
 
+absl::StatusOr<std::vector<uint64_t>> HashChunks(
+    absl::string_view cpb_file, const std::vector<ChunkInfo>& chunks_info) {
+  std::vector<uint64_t> chunk_hashes(chunks_info.size());
+  if (chunks_info.empty()) return chunk_hashes;
+  const int num_threads = std::min<int>(
+      {kMaxHashChunksThreads, port::MaxParallelism(),
+       static_cast<int>(std::min<size_t>(chunks_info.size(), INT_MAX))});
+  std::atomic<size_t> next_chunk = 0;
+  std::vector<absl::Status> statuses(num_threads);
+  {
+    thread::ThreadPool thread_pool(Env::Default(), "fingerprint_chunks",
+                                   num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      thread_pool.Schedule([&, i]() {
+        absl::StatusOr<riegeli::RecordReader<riegeli::FdReader<>>> reader =
+            GetRiegeliReader(cpb_file);
+        if (!reader.ok()) {
+          statuses[i] = reader.status();
+          return;
+        }
+        // Chunks are handed out one at a time, so threads that get small
+        // chunks take on more of them.
+        for (size_t chunk = next_chunk++; chunk < chunks_info.size();
+             chunk = next_chunk++) {
+          absl::StatusOr<std::string> data =
+              ReadChunk(*reader, chunks_info[chunk]);
+          if (!data.ok()) {
+            statuses[i] = data.status();
+            break;
+          }
+          chunk_hashes[chunk] = Fingerprint64(*data);
+        }
+        reader->Close();
+      });
+    }
+  }
+  for (const absl::Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return chunk_hashes;
+}
+
 absl::StatusOr<uint64_t> HashFields(
     const ChunkedMessage& chunked_message,
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
     const std::vector<ChunkInfo>& chunks_info,
-    const RepeatedPtrField<FieldIndex>& field_tags, Message* merged_message) {
+    const RepeatedPtrField<FieldIndex>& field_tags, Message* merged_message,
+    const std::vector<uint64_t>* chunk_hashes) {
   uint64_t field_checksum = 0;
   // Find chunked_fields that match the field_tags.
   for (const ChunkedField& chunked_field : chunked_message.chunked_fields()) {
@@ -218,17 +269,24 @@ absl::StatusOr<uint64_t> HashFields(
     if (chunked_message.has_chunk_index() && matches == field_tags.size()) {
       // chunked_field_tags are an exact match with field_tags. Hash referenced
       // chunk.
-      TF_ASSIGN_OR_RETURN(
-          std::string chunk,
-          ReadChunk(reader, chunks_info[chunked_message.chunk_index()]));
-      field_checksum = FingerprintCat64(field_checksum, Fingerprint64(chunk));
+      uint64_t chunk_hash;
+      if (chunk_hashes != nullptr) {
+        chunk_hash = chunk_hashes->at(chunked_message.chunk_index());
+      } else {
+        TF_ASSIGN_OR_RETURN(
+            std::string chunk,
+            ReadChunk(reader, chunks_info[chunked_message.chunk_index()]));
+        chunk_hash = Fingerprint64(chunk);
+      }
+      field_checksum = FingerprintCat64(field_checksum, chunk_hash);
     } else if (matches == field_tags.size()) {
       // chunked_field_tags are an exact match, but chunked_field is further
       // broken down into separate chunked_fields (no chunk_index). Hash those
       // chunked_fields.
-      TF_ASSIGN_OR_RETURN(uint64_t hash,
-                          HashFields(chunked_message, reader, chunks_info,
-                                     field_tags, merged_message));
+      TF_ASSIGN_OR_RETURN(
+          uint64_t hash,
+          HashFields(chunked_message, reader, chunks_info, field_tags,
+                     merged_message, chunk_hashes));
       field_checksum = FingerprintCat64(field_checksum, hash);
     } else if (chunked_message.has_chunk_index() &&
                matches == chunked_field_tags.size()) {
@@ -247,17 +305,19 @@ absl::StatusOr<uint64_t> HashFields(
           std::string chunk,
           ReadChunk(reader, chunks_info[chunked_message.chunk_index()]));
       merged_message->ParseFromString(chunk);
-      TF_ASSIGN_OR_RETURN(uint64_t hash,
-                          HashFields(chunked_message, reader, chunks_info,
-                                     field_tags, merged_message));
+      TF_ASSIGN_OR_RETURN(
+          uint64_t hash,
+          HashFields(chunked_message, reader, chunks_info, field_tags,
+                     merged_message, chunk_hashes));
       field_checksum = FingerprintCat64(field_checksum, hash);
     } else if (matches == chunked_field_tags.size()) {
       // chunk_field_tags are a partial match, but chunked_field is broken down.
       // Merge chunked_fields in, attempt to locate & hash target field.
       for (const ChunkedField& cf : chunked_message.chunked_fields()) {
-        TF_ASSIGN_OR_RETURN(uint64_t hash,
-                            HashFields(cf.message(), reader, chunks_info,
-                                       field_tags, merged_message));
+        TF_ASSIGN_OR_RETURN(
+            uint64_t hash,
+            HashFields(cf.message(), reader, chunks_info, field_tags,
+                       merged_message, chunk_hashes));
         field_checksum = FingerprintCat64(field_checksum, hash);
       }
     }
@@ -336,29 +396,32 @@ absl::StatusOr<uint64_t> HashMessage(
     Message* message, const ChunkedMessage& chunked_message,
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
     const std::vector<ChunkInfo>& chunks_info,
-    const RepeatedPtrField<FieldIndex>& field_tags) {
+    const RepeatedPtrField<FieldIndex>& field_tags,
+    const std::vector<uint64_t>* chunk_hashes) {
   uint64_t total_message_hash = Fingerprint64(SerializeProto(*message));
-  TF_ASSIGN_OR_RETURN(
-      uint64_t message_hash,
-      HashFields(chunked_message, reader, chunks_info, field_tags, message));
+  TF_ASSIGN_OR_RETURN(uint64_t message_hash,
+                      HashFields(chunked_message, reader, chunks_info,
+                                 field_tags, message, chunk_hashes));
   return FingerprintCat64(total_message_hash, message_hash);
 }
 
 absl::StatusOr<uint64_t> HashGraphDef(
     ::tensorflow::GraphDef* graph_def, const ChunkedMessage& chunked_message,
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
-    const std::vector<ChunkInfo>& chunks_info) {
+    const std::vector<ChunkInfo>& chunks_info,
+    const std::vector<uint64_t>* chunk_hashes) {
   // TODO(adamcogdell): here we assume that graph_def (top-level) is contained
   // in a single chunk, which may not be the case
   return HashMessage(graph_def, chunked_message, reader, chunks_info,
-                     GraphDefFieldTags());
+                     GraphDefFieldTags(), chunk_hashes);
 }
 
 absl::StatusOr<uint64_t> HashSignatureDef(
     const Map<std::string, ::tensorflow::SignatureDef>& signature_def_map,
     const ChunkedMessage& chunked_message,
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
-    const std::vector<ChunkInfo>& chunks_info) {
+    const std::vector<ChunkInfo>& chunks_info,
+    const std::vector<uint64_t>* chunk_hashes) {
   uint64_t signature_def_hash = 0;
   std::vector<std::pair<std::string, ::tensorflow::SignatureDef>>
       signature_def_sorted(signature_def_map.begin(), signature_def_map.end());
@@ -377,7 +440,7 @@ absl::StatusOr<uint64_t> HashSignatureDef(
     TF_ASSIGN_OR_RETURN(
         uint64_t signature_def_entry_hash,
         HashFields(chunked_message, reader, chunks_info,
-                   SignatureDefFieldTags(), &signature_def_val));
+                   SignatureDefFieldTags(), &signature_def_val, chunk_hashes));
     signature_def_hash =
         FingerprintCat64(signature_def_hash, signature_def_entry_hash);
   }
@@ -388,13 +451,15 @@ absl::StatusOr<uint64_t> HashSavedObjectGraph(
     ::tensorflow::SavedObjectGraph* saved_object_graph,
     const ChunkedMessage& chunked_message,
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
-    const std::vector<ChunkInfo>& chunks_info) {
+    const std::vector<ChunkInfo>& chunks_info,
+    const std::vector<uint64_t>* chunk_hashes) {
   return HashMessage(saved_object_graph, chunked_message, reader, chunks_info,
-                     SavedObjectGraphFieldTags());
+                     SavedObjectGraphFieldTags(), chunk_hashes);
 }
 
 }  // namespace fingerprinting_utils_internal
 
+using fingerprinting_utils_internal::HashChunks;
 using fingerprinting_utils_internal::HashFields;
 using fingerprinting_utils_internal::HashGraphDef;
 using fingerprinting_utils_internal::HashSavedObjectGraph;
@@ -434,13 +499,28 @@ absl::StatusOr<FingerprintDef> CreateFingerprintDefCpb(
   std::vector<ChunkInfo> chunks_info = std::vector<ChunkInfo>(
       chunk_metadata.chunks().begin(), chunk_metadata.chunks().end());
 
+  // The checkpoint index and the chunks are hashed in parallel up front, so
+  // that the passes below only read the chunks they need to merge.
+  uint64_t checkpoint_hash = 0;
+  std::unique_ptr<Thread> checkpoint_hash_thread(Env::Default()->StartThread(
+      ThreadOptions(), "hash_checkpoint_index",
+      [&checkpoint_hash, export_dir]() {
+        checkpoint_hash = HashCheckpointIndexFile(export_dir);
+      }));
+  absl::StatusOr<std::vector<uint64_t>> chunk_hashes =
+      HashChunks(cpb_file, chunks_info);
+  if (!chunk_hashes.ok()) {
+    reader.Close();
+    return chunk_hashes.status();
+  }
+
   FingerprintDef fingerprint_def;
   SavedModel saved_model;
 
   // Set the saved_model_checksum.
   TF_ASSIGN_OR_RETURN(uint64_t saved_model_hash,
                       HashFields(chunk_metadata.message(), reader, chunks_info,
-                                 {}, &saved_model));
+                                 {}, &saved_model, &*chunk_hashes));
   saved_model_hash = FingerprintCat64(
       saved_model_hash, Fingerprint64(SerializeProto(saved_model)));
   fingerprint_def.set_saved_model_checksum(saved_model_hash);
@@ -453,7 +533,8 @@ absl::StatusOr<FingerprintDef> CreateFingerprintDefCpb(
   TF_ASSIGN_OR_RETURN(
       uint64_t graph_def_program_hash,
       HashGraphDef(saved_model.mutable_meta_graphs(0)->mutable_graph_def(),
-                   chunk_metadata.message(), reader, chunks_info));
+                   chunk_metadata.message(), reader, chunks_info,
+                   &*chunk_hashes));
   fingerprint_def.set_graph_def_program_hash(graph_def_program_hash);
 
   // TODO(adamcogdell): HashSignatureDef relies on the signatue_def map being
@@ -461,17 +542,19 @@ absl::StatusOr<FingerprintDef> CreateFingerprintDefCpb(
   TF_ASSIGN_OR_RETURN(
       uint64_t signature_def_hash,
       HashSignatureDef(saved_model.meta_graphs(0).signature_def(),
-                       chunk_metadata.message(), reader, chunks_info));
+                       chunk_metadata.message(), reader, chunks_info,
+                       &*chunk_hashes));
   fingerprint_def.set_signature_def_hash(signature_def_hash);
 
   TF_ASSIGN_OR_RETURN(
       uint64_t saved_object_graph_hash,
       HashSavedObjectGraph(
           saved_model.mutable_meta_graphs(0)->mutable_object_graph_def(),
-          chunk_metadata.message(), reader, chunks_info));
+          chunk_metadata.message(), reader, chunks_info, &*chunk_hashes));
   fingerprint_def.set_saved_object_graph_hash(saved_object_graph_hash);
 
-  fingerprint_def.set_checkpoint_hash(HashCheckpointIndexFile(export_dir));
+  checkpoint_hash_thread.reset();
+  fingerprint_def.set_checkpoint_hash(checkpoint_hash);
 
   reader.Close();
 
@@ -61,15 +61,24 @@ PruneChunkedMessage(
 // Deterministically serializes the proto `message`.
 std::string SerializeProto(const Message& message);
 
+// Returns the `Fingerprint64` of each chunk in `chunks_info`. The chunks are
+// read from `cpb_file` and hashed in parallel, each thread with its own reader.
+absl::StatusOr<std::vector<uint64_t>> HashChunks(
+    absl::string_view cpb_file,
+    const std::vector<::tensorflow::proto_splitter::ChunkInfo>& chunks_info);
+
 // Uses metadata contained in `chunked_message` to hash fields within the
-// data accessed by the `reader` using `chunks_info`.
+// data accessed by the `reader` using `chunks_info`. If `chunk_hashes` (as
+// returned by `HashChunks`) is given, chunks that are hashed as a whole are not
+// read again.
 absl::StatusOr<uint64_t> HashFields(
     const ::tensorflow::proto_splitter::ChunkedMessage& chunked_message,
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
     const std::vector<::tensorflow::proto_splitter::ChunkInfo>& chunks_info,
     const RepeatedPtrField<::tensorflow::proto_splitter::FieldIndex>&
         field_tags,
-    Message* merged_message);
+    Message* merged_message,
+    const std::vector<uint64_t>* chunk_hashes = nullptr);
 
 // Gets the field tags for `graph_def`.::tensorflow
 inline RepeatedPtrField<::tensorflow::proto_splitter::FieldIndex>
@@ -99,28 +108,32 @@ absl::StatusOr<uint64_t> HashMessage(
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
     const std::vector<::tensorflow::proto_splitter::ChunkInfo>& chunks_info,
     const RepeatedPtrField<::tensorflow::proto_splitter::FieldIndex>&
-        field_tags);
+        field_tags,
+    const std::vector<uint64_t>* chunk_hashes = nullptr);
 
 // Hashes the contents of `graph_def`.
 absl::StatusOr<uint64_t> HashGraphDef(
     tensorflow::GraphDef* graph_def,
     const ::tensorflow::proto_splitter::ChunkedMessage& chunked_message,
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
-    const std::vector<::tensorflow::proto_splitter::ChunkInfo>& chunks_info);
+    const std::vector<::tensorflow::proto_splitter::ChunkInfo>& chunks_info,
+    const std::vector<uint64_t>* chunk_hashes = nullptr);
 
 // Hashes the contents of `signature_def`.
 absl::StatusOr<uint64_t> HashSignatureDef(
     const Map<std::string, ::tensorflow::SignatureDef>& signature_def_map,
     const ::tensorflow::proto_splitter::ChunkedMessage& chunked_message,
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
-    const std::vector<::tensorflow::proto_splitter::ChunkInfo>& chunks_info);
+    const std::vector<::tensorflow::proto_splitter::ChunkInfo>& chunks_info,
+    const std::vector<uint64_t>* chunk_hashes = nullptr);
 
 // Hashes the contents of `saved_object_graph`.
 absl::StatusOr<uint64_t> HashSavedObjectGraph(
     tensorflow::SavedObjectGraph* saved_object_graph,
     const ::tensorflow::proto_splitter::ChunkedMessage& chunked_message,
     riegeli::RecordReader<riegeli::FdReader<>>& reader,
-    const std::vector<::tensorflow::proto_splitter::ChunkInfo>& chunks_info);
+    const std::vector<::tensorflow::proto_splitter::ChunkInfo>& chunks_info,
+    const std::vector<uint64_t>* chunk_hashes = nullptr);
 
 }  // namespace fingerprinting_utils_internal
 
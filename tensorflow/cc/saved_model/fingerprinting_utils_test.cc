@@ -27,6 +27,7 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/protobuf/saved_object_graph.pb.h"
@@ -45,6 +46,7 @@ namespace tensorflow::saved_model::fingerprinting {
 namespace {
 
 using fingerprinting_utils_internal::fieldTagMatches;
+using fingerprinting_utils_internal::HashChunks;
 using fingerprinting_utils_internal::HashFields;
 using fingerprinting_utils_internal::HashGraphDef;
 using fingerprinting_utils_internal::HashSavedObjectGraph;
@@ -66,6 +68,7 @@ using ::tensorflow::protobuf::io::ArrayInputStream;
 using ::tensorflow::protobuf::util::MessageDifferencer;
 using tools::proto_splitter::GetChunkMetadata;
 using tools::proto_splitter::GetRiegeliReader;
+using tools::proto_splitter::ReadChunk;
 using tsl::testing::IsOkAndHolds;
 using tsl::testing::TensorFlowSrcRoot;
 
@@ -319,6 +322,38 @@ TEST(FingerprintingTest, TestHashFieldsV2) {
   ASSERT_EQ(many_fields_hash, 14850154939410192811U);
 }
 
+TEST(FingerprintingTest, TestHashFieldsWithChunkHashes) {
+  std::string cpb_file = io::JoinPath(
+      TensorFlowSrcRoot(), "tools/proto_splitter/testdata", "many-field.cpb");
+  TF_ASSERT_OK_AND_ASSIGN(auto reader, GetRiegeliReader(cpb_file));
+
+  auto read_metadata = GetChunkMetadata(reader);
+  if (!read_metadata.ok()) {
+    reader.Close();
+    TF_ASSERT_OK(read_metadata.status());
+  }
+  ChunkMetadata chunk_metadata = read_metadata.value();
+
+  std::vector<ChunkInfo> chunks_info = std::vector<ChunkInfo>(
+      chunk_metadata.chunks().begin(), chunk_metadata.chunks().end());
+
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<uint64_t> chunk_hashes,
+                          HashChunks(cpb_file, chunks_info));
+  ASSERT_EQ(chunk_hashes.size(), chunks_info.size());
+  for (size_t i = 0; i < chunks_info.size(); ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(std::string chunk,
+                            ReadChunk(reader, chunks_info[i]));
+    EXPECT_EQ(chunk_hashes[i], Fingerprint64(chunk));
+  }
+
+  ManyFields many_fields;
+  TF_ASSERT_OK_AND_ASSIGN(
+      uint64_t many_fields_hash,
+      HashFields(chunk_metadata.message(), reader, chunks_info, {},
+                 &many_fields, &chunk_hashes));
+  ASSERT_EQ(many_fields_hash, 14850154939410192811U);
+}
+
 TEST(FingerprintingTest, TestHashGraphDef) {
   std::string cpb_file =
       io::JoinPath(TensorFlowSrcRoot(), "tools/proto_splitter/testdata",
@@ -117,6 +117,12 @@ Status LoadMetagraphIntoSession(const SessionOptions& session_options,
 /// the set of tags used at SavedModel build time. Stores a SavedModel bundle in
 /// *bundle with a session and the requested MetaGraphDef, if found.
 ///
+/// Variables are restored eagerly, before this returns. To make large models
+/// available sooner, set TF_BUNDLE_READER_LAZY_MMAP=1: variables on the host
+/// then alias copy-on-write mappings of the variable data files, which are
+/// paged in on first access while a background thread verifies and warms
+/// them. See BundleReader::Options::lazy_mmap.
+///
 /// NOTE: Prefer the overload that takes a SavedModelBundleLite* in new code.
 Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
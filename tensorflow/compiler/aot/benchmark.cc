@@ -24,6 +24,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -100,39 +101,71 @@ void DumpStatsToStdout(const Stats& stats) {
     ++max_digits;
   }
   // Dump stats out.
-  printf("Benchmark ran %zu iterations over %lld us\n", count_us,
-         static_cast<long long>(stats.total_us));  // NOLINT
+  printf("Benchmark ran %zu iterations over %lld us on %d thread(s)\n",
+         count_us, static_cast<long long>(stats.total_us),  // NOLINT
+         stats.num_threads);
+  if (stats.total_us > 0) {
+    printf("  Throughput: %.3f iterations/s\n",
+           count_us * 1e6 / stats.total_us);
+  }
   for (const auto& g : groups) {
     printf("  %-*s %*.3f us\n", max_label_size, g.first.c_str(), max_digits + 4,
            g.second);
   }
 }
 
-void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats) {
-  // If neither max_seconds or max_iters is set, stop at kDefaultMicros.
-  const int64_t max_us = (options.max_micros <= 0 && options.max_iters <= 0)
-                             ? Options::kDefaultMicros
-                             : options.max_micros;
-  // NOLINTNEXTLINE
-  printf("Running benchmark for %lld us\n", static_cast<long long>(max_us));
-  const int64_t start_us = NowMicros();
+// Runs `fn` until `max_us` or `max_iters` is reached, appending per-iteration
+// times to `per_iter_us`.
+static void RunIterations(const Options& options, int64_t max_us,
+                          int64_t start_us, const BenchmarkFn& fn,
+                          std::vector<int64_t>* per_iter_us) {
   int64_t iters = 0;
   while (true) {
     const int64_t iter_start_us = NowMicros();
     fn();
     const int64_t end_us = NowMicros();
     // Collect stats and decide whether to stop.
-    stats->per_iter_us.push_back(end_us - iter_start_us);
+    per_iter_us->push_back(end_us - iter_start_us);
     const int64_t total_us = end_us - start_us;
     ++iters;
     if ((max_us > 0 && total_us >= max_us) ||
         (options.max_iters > 0 && iters >= options.max_iters)) {
-      stats->total_us = total_us;
       break;
     }
   }
 }
 
+void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats) {
+  // If neither max_seconds or max_iters is set, stop at kDefaultMicros.
+  const int64_t max_us = (options.max_micros <= 0 && options.max_iters <= 0)
+                             ? Options::kDefaultMicros
+                             : options.max_micros;
+  const int num_threads = std::max(options.num_threads, 1);
+  // NOLINTNEXTLINE
+  printf("Running benchmark for %lld us on %d thread(s)\n",
+         static_cast<long long>(max_us), num_threads);  // NOLINT
+  const int64_t start_us = NowMicros();
+  if (num_threads == 1) {
+    RunIterations(options, max_us, start_us, fn, &stats->per_iter_us);
+  } else {
+    std::vector<std::vector<int64_t>> per_thread_iter_us(num_threads);
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&, i] {
+        RunIterations(options, max_us, start_us, fn, &per_thread_iter_us[i]);
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (const std::vector<int64_t>& iter_us : per_thread_iter_us) {
+      stats->per_iter_us.insert(stats->per_iter_us.end(), iter_us.begin(),
+                                iter_us.end());
+    }
+  }
+  stats->total_us = NowMicros() - start_us;
+  stats->num_threads = num_threads;
+}
+
 }  // namespace benchmark
 }  // namespace tfcompile
 }  // namespace tensorflow
@@ -42,14 +42,18 @@ struct Options {
 
   int64_t max_iters = 0;   // Maximum iterations to run, ignored if <= 0.
   int64_t max_micros = 0;  // Maximum microseconds to run, ignored if <= 0.
+  // Number of threads running the function concurrently. Each thread runs
+  // max_iters iterations.
+  int num_threads = 1;
 };
 
 // Stats holds statistics collected during benchmarking.
 struct Stats {
   std::vector<int64_t> per_iter_us;  // Per-iteration deltas in us.
   int64_t total_us;                  // Total time in us.
+  int num_threads;                   // Number of threads that ran iterations.
 
-  Stats() : total_us(0) { per_iter_us.reserve(5000); }
+  Stats() : total_us(0), num_threads(1) { per_iter_us.reserve(5000); }
 };
 
 // DumpStatsToStdout printfs to stdout stats in a multi-line human-friendly
@@ -60,7 +64,9 @@ void DumpStatsToStdout(const Stats& stats);
 typedef std::function<void()> BenchmarkFn;
 
 // Benchmark runs a benchmark of the function `fn`, collecting stats in `stats`.
-// Use `options` to configure benchmarking options.
+// Use `options` to configure benchmarking options. With several threads, `fn`
+// is called concurrently and must be thread-safe, e.g. by running the
+// ThreadLocal() instance of the generated class.
 void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats);
 
 }  // namespace benchmark
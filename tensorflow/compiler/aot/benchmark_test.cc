@@ -40,6 +40,16 @@ TEST(Benchmark, Benchmark) {
   EXPECT_EQ(stats5.per_iter_us.size(), 5);
 }
 
+TEST(Benchmark, MultiThreaded) {
+  Options options;
+  options.max_iters = 5;
+  options.num_threads = 3;
+  Stats stats;
+  Benchmark(options, [] { AddComp::ThreadLocal().Run(); }, &stats);
+  EXPECT_EQ(stats.per_iter_us.size(), 15);
+  EXPECT_EQ(stats.num_threads, 3);
+}
+
 }  // namespace
 }  // namespace benchmark
 }  // namespace tfcompile
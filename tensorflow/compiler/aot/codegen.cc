@@ -585,6 +585,10 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
 
 {{INCLUDE_XLA_DATA_PROTO}}
 {{INCLUDE_HLO_PROFILE_PRINTER_DATA_PROTO}}
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
 #include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -622,6 +626,9 @@ extern "C" void {{ENTRY}}(
 // o Calls to non-const methods require exclusive access to the object.
 // o Concurrent calls to const methods are OK, if those calls are made while it
 //   is guaranteed that no thread may call a non-const method.
+// To run the computation from several threads, use one instance per thread,
+// e.g. through ThreadLocal(), or RunBatch to run a batch of independent items
+// on a thread pool.
 //
 // The logical function signature is:
 //   {{PROGRAM_SHAPE}}
@@ -681,6 +688,58 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
   {{CLASS}}(const {{CLASS}}&) = delete;
   {{CLASS}}& operator=(const {{CLASS}}&) = delete;
 
+  // Returns an instance of {{CLASS}} owned by the calling thread, created
+  // with the default allocation strategy on the first call from that thread.
+  // Concurrent calls of ThreadLocal().Run() from different threads are safe:
+  // each thread runs the computation on its own preallocated arg, result and
+  // temp buffers, which are reused across its calls.
+  static {{CLASS}}& ThreadLocal() {
+    thread_local {{CLASS}} computation;
+    return computation;
+  }
+
+  // Runs the computation on each of `batch_size` independent items, split
+  // into `num_shards` contiguous shards. `schedule(fn)` must run `fn` on a
+  // thread of a caller-supplied pool, e.g.
+  //
+  //   [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); }
+  //
+  // For every item i, on the ThreadLocal() instance of the thread running its
+  // shard, `set_args(computation, i)` sets the args, the computation is run,
+  // and `get_results(computation, i)` must copy out the results. Blocks until
+  // all shards are done, and returns false if any run failed, in which case
+  // the remaining items of its shard are skipped.
+  template <typename Schedule, typename SetArgs, typename GetResults>
+  static bool RunBatch(::int64_t batch_size, int num_shards,
+                       Schedule schedule, SetArgs set_args,
+                       GetResults get_results) {
+    if (num_shards > batch_size) num_shards = batch_size;
+    if (num_shards <= 0) return true;
+    std::mutex mu;
+    std::condition_variable shards_done;
+    int pending_shards = num_shards;
+    bool ok = true;
+    for (int shard = 0; shard < num_shards; ++shard) {
+      const ::int64_t begin = batch_size * shard / num_shards;
+      const ::int64_t end = batch_size * (shard + 1) / num_shards;
+      schedule([&, begin, end] {
+        {{CLASS}}& computation = ThreadLocal();
+        bool shard_ok = true;
+        for (::int64_t i = begin; i < end && shard_ok; ++i) {
+          set_args(computation, i);
+          shard_ok = computation.Run();
+          if (shard_ok) get_results(computation, i);
+        }
+        std::lock_guard<std::mutex> lock(mu);
+        ok = ok && shard_ok;
+        if (--pending_shards == 0) shards_done.notify_all();
+      });
+    }
+    std::unique_lock<std::mutex> lock(mu);
+    shards_done.wait(lock, [&] { return pending_shards == 0; });
+    return ok;
+  }
+
   // Arg methods for managing input buffers. Buffers are in row-major order.
   // There is a set of methods for each positional argument, with the following
   // general form:
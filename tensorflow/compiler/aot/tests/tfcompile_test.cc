@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 #include <algorithm>
+#include <functional>
+#include <utility>
 #include <vector>
 #define EIGEN_USE_THREADS
 #define EIGEN_USE_CUSTOM_THREAD_POOL
@@ -120,6 +122,23 @@ TEST(TFCompileTest, Add) {
   EXPECT_EQ(add_const.result0_data(), add_const.results()[0]);
 }
 
+TEST(TFCompileTest, AddRunBatch) {
+  constexpr int kBatchSize = 100;
+  std::vector<int32> results(kBatchSize, -1);
+  Eigen::ThreadPool pool(4);
+  EXPECT_TRUE(AddComp::RunBatch(
+      kBatchSize, /*num_shards=*/8,
+      [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); },
+      [](AddComp& add, int64_t i) {
+        add.arg0() = i;
+        add.arg1() = 2 * i;
+      },
+      [&results](AddComp& add, int64_t i) { results[i] = add.result0(); }));
+  for (int i = 0; i < kBatchSize; ++i) {
+    EXPECT_EQ(results[i], 3 * i);
+  }
+}
+
 // Run tests that use set_argN_data separately, to avoid accidentally re-using
 // non-existent buffers.
 TEST(TFCompileTest, Add_SetArg) {
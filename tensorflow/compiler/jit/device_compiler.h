@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_DEVICE_COMPILER_H_
 #define TENSORFLOW_COMPILER_JIT_DEVICE_COMPILER_H_
 
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <numeric>
 #include <optional>
@@ -41,6 +43,8 @@ limitations under the License.
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 
@@ -160,6 +164,16 @@ class DeviceCompiler : public ResourceBase {
                              OpKernelContext* ctx,
                              DeviceCompilationProfiler* profiler);
 
+  // Records that `signature` was requested while its asynchronous compilation
+  // is queued or running, which keeps a queued compilation from going stale.
+  void RegisterAsyncCompilationRequest(
+      const DeviceCompilationClusterSignature& signature);
+
+  // Runs the queued asynchronous compilation of the cluster that was executed
+  // the most, after dropping the queued compilations that went stale. Called
+  // once on a compiler thread for every queued compilation.
+  void RunNextAsyncCompilation();
+
   std::unique_ptr<DeviceExecutablePersistor<ExecutableType, ClientType>>
       persistor_;
   std::unique_ptr<DeviceCompilerClient<ExecutableType, ClientType>>
@@ -169,6 +183,25 @@ class DeviceCompiler : public ResourceBase {
   // Pool of threads for asynchronous compilations.
   std::unique_ptr<thread::ThreadPool> async_compiler_threads_;
 
+  // An asynchronous compilation waiting for a compiler thread.
+  struct PendingAsyncCompilation {
+    NameAttrList function;
+    DeviceCompilationProfiler* profiler;
+    // Time of the latest request for the signature, from Env::NowMicros().
+    uint64 last_request_us;
+    std::function<void()> compile;
+  };
+
+  // Asynchronous compilations waiting for a compiler thread. Their number is
+  // bounded by the profiler's limit on ongoing compilations, so they are
+  // scanned rather than kept in a heap, and picked by the execution count of
+  // their cluster at the time a thread frees up.
+  mutex async_queue_mu_;
+  absl::flat_hash_map<DeviceCompilationClusterSignature,
+                      PendingAsyncCompilation,
+                      DeviceCompilationClusterSignature::Hash>
+      pending_async_compilations_ TF_GUARDED_BY(async_queue_mu_);
+
   mutex cluster_mutexes_mu_;
   absl::flat_hash_map<DeviceCompilationClusterSignature, std::unique_ptr<mutex>,
                       DeviceCompilationClusterSignature::Hash>
@@ -203,6 +236,17 @@ inline Status EligibleToPersist(DeviceCompileState compile_state,
   }
   return absl::OkStatus();
 }
+
+// Returns the number of threads to compile clusters asynchronously on: the
+// flag if set, otherwise half the cores, leaving the others to run the
+// fallback path, up to kNumAsyncDeviceCompilerThreads.
+inline int64_t NumAsyncCompilerThreads() {
+  const int64_t num_threads =
+      GetXlaOpsCommonFlags()->tf_xla_async_compilation_threads;
+  if (num_threads > 0) return num_threads;
+  return std::clamp<int64_t>(port::MaxParallelism() / 2, 1,
+                             kNumAsyncDeviceCompilerThreads);
+}
 }  // namespace device_compiler_internal
 
 template <typename ExecutableType, typename ClientType>
@@ -216,7 +260,7 @@ DeviceCompiler<ExecutableType, ClientType>::DeviceCompiler(
   cache_ = std::make_unique<DeviceCompilationCache<ExecutableType>>();
   async_compiler_threads_ = std::make_unique<tensorflow::thread::ThreadPool>(
       tensorflow::Env::Default(), "async_compiler_threads",
-      kNumAsyncDeviceCompilerThreads);
+      device_compiler_internal::NumAsyncCompilerThreads());
 }
 
 template <typename ExecutableType, typename ClientType>
@@ -372,7 +416,7 @@ Status DeviceCompiler<ExecutableType, ClientType>::CompileAsynchronous(
   // All values are captured by value. Make sure that all pointer values (like
   // entry) do not get freed until the lambda has finished.
   const std::string& function_name = function.name();
-  async_compiler_threads_->Schedule([=] {
+  auto compile = [=] {
     VLOG(2) << "Starting asynchronous compilation of cluster " << function_name
             << '.';
     // We don't need to lock mu, but do it anyway to satisfy thread safety
@@ -390,10 +434,73 @@ Status DeviceCompiler<ExecutableType, ClientType>::CompileAsynchronous(
       cache_->Store(signature, std::nullopt, s.status(), std::nullopt,
                     std::nullopt);
     }
-  });
+  };
+  {
+    mutex_lock lock(async_queue_mu_);
+    pending_async_compilations_.insert_or_assign(
+        signature,
+        PendingAsyncCompilation{function, profiler, Env::Default()->NowMicros(),
+                                std::move(compile)});
+  }
+  async_compiler_threads_->Schedule([this] { RunNextAsyncCompilation(); });
   return absl::OkStatus();
 }
 
+template <typename ExecutableType, typename ClientType>
+void DeviceCompiler<ExecutableType, ClientType>::
+    RegisterAsyncCompilationRequest(
+        const DeviceCompilationClusterSignature& signature) {
+  mutex_lock lock(async_queue_mu_);
+  auto it = pending_async_compilations_.find(signature);
+  if (it != pending_async_compilations_.end()) {
+    it->second.last_request_us = Env::Default()->NowMicros();
+  }
+}
+
+template <typename ExecutableType, typename ClientType>
+void DeviceCompiler<ExecutableType, ClientType>::RunNextAsyncCompilation() {
+  const int64_t staleness_us =
+      GetXlaOpsCommonFlags()->tf_xla_async_compilation_staleness_ms * 1000;
+  const uint64 now_us = Env::Default()->NowMicros();
+
+  std::function<void()> compile;
+  {
+    mutex_lock lock(async_queue_mu_);
+    auto next = pending_async_compilations_.end();
+    int64_t next_execution_count = -1;
+    for (auto it = pending_async_compilations_.begin();
+         it != pending_async_compilations_.end();) {
+      PendingAsyncCompilation& pending = it->second;
+      if (staleness_us > 0 &&
+          now_us > pending.last_request_us + staleness_us) {
+        // The signature stopped appearing, e.g. it was only seen during
+        // warmup. Return it to the uncompiled state so that it is queued again
+        // if it comes back.
+        VLOG(2) << "Dropping stale asynchronous compilation of cluster "
+                << pending.function.name() << '.';
+        cache_->Store(it->first, DeviceCompileState::kUncompiled,
+                      std::nullopt, std::nullopt, std::nullopt);
+        pending.profiler->DecrementOngoingAsyncCompilations();
+        pending_async_compilations_.erase(it++);
+        continue;
+      }
+      auto stats = pending.profiler->GetCompileStats(pending.function);
+      const int64_t execution_count = stats.ok() ? stats->execution_count : 0;
+      if (execution_count > next_execution_count) {
+        next = it;
+        next_execution_count = execution_count;
+      }
+      ++it;
+    }
+    // Stale compilations dropped above may have been this call's to run, in
+    // which case there is nothing left to do.
+    if (next == pending_async_compilations_.end()) return;
+    compile = std::move(next->second.compile);
+    pending_async_compilations_.erase(next);
+  }
+  compile();
+}
+
 template <typename ExecutableType, typename ClientType>
 Status DeviceCompiler<ExecutableType, ClientType>::CompileImpl(
     const XlaCompiler::CompileOptions& compile_options,
@@ -487,6 +594,7 @@ Status DeviceCompiler<ExecutableType, ClientType>::CompileImpl(
   } else if (state == DeviceCompileState::kCompiling) {
     VLOG(2) << "Ongoing asynchronous compilation for signature: "
             << human_signature;
+    RegisterAsyncCompilationRequest(signature);
     return absl::OkStatus();
   } else if (state == DeviceCompileState::kCompiled) {
     VLOG(2) << "Already Compiled for signature: " << human_signature;
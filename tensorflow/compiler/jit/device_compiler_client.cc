@@ -15,10 +15,35 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/device_compiler_client.h"
 
+#include <algorithm>
+
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/core/util/determinism.h"
+#include "xla/xla.pb.h"
 
 namespace tensorflow {
+namespace {
+
+// Makes the GPU compiler record every command type whose replay does not
+// depend on the host into command buffers, including small regions. Only the
+// GPU compiler reads these options, so executables for other devices are
+// unaffected.
+void EnableGpuCommandBuffers(int32_t min_size,
+                             xla::DebugOptions* debug_options) {
+  for (auto type :
+       {xla::DebugOptions::FUSION, xla::DebugOptions::CUBLAS,
+        xla::DebugOptions::CUBLASLT, xla::DebugOptions::CUDNN,
+        xla::DebugOptions::CUSTOM_CALL, xla::DebugOptions::CONDITIONALS}) {
+    const auto& enabled = debug_options->xla_gpu_enable_command_buffer();
+    if (std::find(enabled.begin(), enabled.end(), type) == enabled.end()) {
+      debug_options->add_xla_gpu_enable_command_buffer(type);
+    }
+  }
+  debug_options->set_xla_gpu_graph_min_graph_size(min_size);
+}
+
+}  // namespace
 
 xla::ExecutableBuildOptions GetExecutableBuildOptions(
     const XlaCompiler::Options& options,
@@ -40,6 +65,11 @@ xla::ExecutableBuildOptions GetExecutableBuildOptions(
   if (tensorflow::OpDeterminismRequired()) {
     build_options.mutable_debug_options()->set_xla_gpu_deterministic_ops(true);
   }
+  const XlaOpsCommonFlags& flags = *GetXlaOpsCommonFlags();
+  if (flags.tf_xla_gpu_command_buffers) {
+    EnableGpuCommandBuffers(flags.tf_xla_gpu_command_buffer_min_size,
+                            build_options.mutable_debug_options());
+  }
   return build_options;
 }
 
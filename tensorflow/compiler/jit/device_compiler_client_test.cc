@@ -15,7 +15,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/device_compiler_client.h"
 
+#include <algorithm>
+
 #include <gtest/gtest.h>
+#include "tensorflow/compiler/jit/flags.h"
+#include "xla/xla.pb.h"
 
 namespace tensorflow {
 namespace {
@@ -72,5 +76,29 @@ TEST(GetExecutableOptionTest, DumpingWithoutDetailedLogging) {
   EXPECT_TRUE(build_option.debug_options().xla_enable_dumping());
 }
 
+TEST(GetExecutableOptionTest, GpuCommandBuffers) {
+  XlaOpsCommonFlags* flags = GetXlaOpsCommonFlags();
+  const bool old_command_buffers = flags->tf_xla_gpu_command_buffers;
+  const int32_t old_min_size = flags->tf_xla_gpu_command_buffer_min_size;
+  flags->tf_xla_gpu_command_buffers = true;
+  flags->tf_xla_gpu_command_buffer_min_size = 1;
+  XlaCompiler::Options options;
+  XlaCompiler::CompilationResult result;
+
+  auto build_option =
+      GetExecutableBuildOptions(options, result, /*default_device_ordinal=*/-1);
+  flags->tf_xla_gpu_command_buffers = old_command_buffers;
+  flags->tf_xla_gpu_command_buffer_min_size = old_min_size;
+
+  const xla::DebugOptions& debug_options = build_option.debug_options();
+  EXPECT_EQ(debug_options.xla_gpu_graph_min_graph_size(), 1);
+  const auto& enabled = debug_options.xla_gpu_enable_command_buffer();
+  for (auto type :
+       {xla::DebugOptions::FUSION, xla::DebugOptions::CUBLAS,
+        xla::DebugOptions::CUDNN, xla::DebugOptions::CONDITIONALS}) {
+    EXPECT_EQ(std::count(enabled.begin(), enabled.end(), type), 1);
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/math_ops.h"
 #include "tensorflow/compiler/jit/device_compilation_cluster_signature.h"
 #include "tensorflow/compiler/jit/device_compiler_client.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/tests/device_compiler_test_helper.h"
 #include "tensorflow/compiler/jit/xla_device_compiler_client.h"
 #include "xla/client/client_library.h"
@@ -38,7 +39,9 @@ limitations under the License.
 #include "tensorflow/core/framework/graph_to_functiondef.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/status.h"
@@ -318,6 +321,119 @@ TEST_F(DeviceCompilerTest, CompileAsyncSuccess) {
   EXPECT_TRUE(cache_value->compilation_status.ok());
 }
 
+TEST_F(DeviceCompilerTest, CompileAsyncPrioritizesMostExecutedClusters) {
+  for (const char* name : {"bar", "baz"}) {
+    TF_ASSERT_OK_AND_ASSIGN(auto fdef, SampleFuntionAddXY(name));
+    TF_ASSERT_OK(flib_def_->AddFunctionDef(fdef));
+  }
+  // A single compiler thread, so that compilations queue up behind the first.
+  auto* flags = GetXlaOpsCommonFlags();
+  const int64_t old_threads = flags->tf_xla_async_compilation_threads;
+  flags->tf_xla_async_compilation_threads = 1;
+  auto restore_flags = gtl::MakeCleanup(
+      [&] { flags->tf_xla_async_compilation_threads = old_threads; });
+  XlaDeviceCompiler* device_compiler = CreateXlaDeviceCompiler();
+  core::ScopedUnref device_compiler_ref(device_compiler);
+
+  XlaCompiler::Options options = GetDefaultXlaOptions();
+  options.client = device_compiler->client();
+  const auto args = SampleArgsForAddXY();
+
+  Notification foo_compiling, release_foo, all_done;
+  std::vector<std::string> compiled;
+  EXPECT_CALL(*mock_profiler_, ShouldCompileCluster(_, _, _))
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock_profiler_, RegisterCompilation(_, _, _))
+      .WillRepeatedly([&](const NameAttrList& function, int64_t, bool) {
+        if (function.name() == "foo") {
+          foo_compiling.Notify();
+          release_foo.WaitForNotification();
+        }
+        compiled.push_back(function.name());
+        if (compiled.size() == 3) all_done.Notify();
+        return absl::OkStatus();
+      });
+
+  auto request = [&](const std::string& name) {
+    NameAttrList fn;
+    fn.set_name(name);
+    const XlaCompiler::CompilationResult* compilation_result = nullptr;
+    xla::LocalExecutable* xla_executable = nullptr;
+    TF_EXPECT_OK(device_compiler->CompileIfNeeded(
+        options, fn, args, XlaCompiler::CompileOptions{},
+        DeviceCompileMode::kAsync, mock_profiler_, &compilation_result,
+        &xla_executable));
+  };
+  request("foo");
+  foo_compiling.WaitForNotification();
+  // "bar" is queued first, but "baz" is executed more often.
+  request("bar");
+  for (int i = 0; i < 3; ++i) request("baz");
+  release_foo.Notify();
+
+  all_done.WaitForNotification();
+  EXPECT_THAT(compiled, ::testing::ElementsAre("foo", "baz", "bar"));
+}
+
+TEST_F(DeviceCompilerTest, CompileAsyncDropsStaleCompilations) {
+  TF_ASSERT_OK_AND_ASSIGN(auto fdef, SampleFuntionAddXY("bar"));
+  TF_ASSERT_OK(flib_def_->AddFunctionDef(fdef));
+  auto* flags = GetXlaOpsCommonFlags();
+  const int64_t old_threads = flags->tf_xla_async_compilation_threads;
+  const int64_t old_staleness_ms =
+      flags->tf_xla_async_compilation_staleness_ms;
+  flags->tf_xla_async_compilation_threads = 1;
+  flags->tf_xla_async_compilation_staleness_ms = 1;
+  auto restore_flags = gtl::MakeCleanup([&] {
+    flags->tf_xla_async_compilation_threads = old_threads;
+    flags->tf_xla_async_compilation_staleness_ms = old_staleness_ms;
+  });
+  XlaDeviceCompiler* device_compiler = CreateXlaDeviceCompiler();
+  core::ScopedUnref device_compiler_ref(device_compiler);
+
+  XlaCompiler::Options options = GetDefaultXlaOptions();
+  options.client = device_compiler->client();
+  const auto args = SampleArgsForAddXY();
+
+  Notification foo_compiling, release_foo;
+  EXPECT_CALL(*mock_profiler_, ShouldCompileCluster(_, _, _))
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock_profiler_, RegisterCompilation(_, _, _))
+      .WillOnce([&](const NameAttrList& function, int64_t, bool) {
+        EXPECT_EQ(function.name(), "foo");
+        foo_compiling.Notify();
+        release_foo.WaitForNotification();
+        return absl::OkStatus();
+      });
+
+  NameAttrList foo, bar;
+  foo.set_name("foo");
+  bar.set_name("bar");
+  const XlaCompiler::CompilationResult* compilation_result = nullptr;
+  xla::LocalExecutable* xla_executable = nullptr;
+  TF_EXPECT_OK(device_compiler->CompileIfNeeded(
+      options, foo, args, XlaCompiler::CompileOptions{},
+      DeviceCompileMode::kAsync, mock_profiler_, &compilation_result,
+      &xla_executable));
+  foo_compiling.WaitForNotification();
+  TF_EXPECT_OK(device_compiler->CompileIfNeeded(
+      options, bar, args, XlaCompiler::CompileOptions{},
+      DeviceCompileMode::kAsync, mock_profiler_, &compilation_result,
+      &xla_executable));
+  // "bar" is not requested again while it waits for "foo" to compile.
+  Env::Default()->SleepForMicroseconds(10 * 1000);
+  release_foo.Notify();
+
+  // Wait for the compiler thread to drain the queue.
+  while (mock_profiler_->GetNumOngoingAsyncCompilations() > 0) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  TF_ASSERT_OK_AND_ASSIGN(auto signature, Signature::Build(bar, args));
+  auto cache_value = device_compiler->cache()->Lookup(signature);
+  ASSERT_TRUE(cache_value);
+  EXPECT_EQ(cache_value->compile_state, DeviceCompileState::kUncompiled);
+}
+
 TEST_F(DeviceCompilerTest, CompilePersistentCacheEnabled) {
   auto xla_device_compiler =
       CreateXlaDeviceCompiler(/*enable_persistence=*/true);
@@ -18,20 +18,45 @@ limitations under the License.
 #include <string>
 
 #include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/fingerprint.h"
 
 namespace tensorflow {
 
-std::string XlaSerializedCacheKeyToFileName(const XlaSerializedCacheKey& key) {
-  static constexpr char kXlaSerializedCacheKeySeparator[] = "__";
+static constexpr char kXlaSerializedCacheKeySeparator[] = "__";
+
+std::string XlaSerializedCacheKeyFileNamePrefix(
+    const XlaSerializedCacheKey& key) {
+  return absl::StrCat(key.prefix(), key.prefix().empty()
+                                        ? ""
+                                        : kXlaSerializedCacheKeySeparator);
+}
+
+std::string XlaSerializedCacheKeyFileNameSuffix(
+    const XlaSerializedCacheKey& key) {
+  std::string version;
+  if (!key.compiler_version().empty() || !key.device_version().empty()) {
+    // Versions are free-form, so only their fingerprint goes in the name.
+    version = absl::StrCat(
+        kXlaSerializedCacheKeySeparator, "v",
+        absl::Hex(Fingerprint64(absl::StrCat(key.compiler_version().size(),
+                                             ":", key.compiler_version(),
+                                             key.device_version())),
+                  absl::kZeroPad16));
+  }
   return absl::StrCat(
-      key.prefix(), key.prefix().empty() ? "" : kXlaSerializedCacheKeySeparator,
-      key.signature_fingerprint(), kXlaSerializedCacheKeySeparator,
-      key.cluster_fingerprint(), kXlaSerializedCacheKeySeparator,
-      key.device_type(),
+      kXlaSerializedCacheKeySeparator, key.device_type(), version,
       key.compiled_using_pjrt()
           ? absl::StrCat(kXlaSerializedCacheKeySeparator, "pjrt")
           : "",
       ".pb");
 }
 
+std::string XlaSerializedCacheKeyToFileName(const XlaSerializedCacheKey& key) {
+  return absl::StrCat(XlaSerializedCacheKeyFileNamePrefix(key),
+                      key.signature_fingerprint(),
+                      kXlaSerializedCacheKeySeparator,
+                      key.cluster_fingerprint(),
+                      XlaSerializedCacheKeyFileNameSuffix(key));
+}
+
 }  // namespace tensorflow
@@ -16,12 +16,17 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_DEVICE_EXECUTABLE_PERSISTOR_H_
 #define TENSORFLOW_COMPILER_JIT_DEVICE_EXECUTABLE_PERSISTOR_H_
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/jit/device_compiler_client.h"
 #include "tensorflow/compiler/jit/xla_compilation_cache.pb.h"
@@ -32,9 +37,13 @@ limitations under the License.
 #include "xla/util.h"
 #include "tensorflow/core/framework/device.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/statusor.h"
@@ -44,6 +53,14 @@ namespace tensorflow {
 // Returns the persisted compilation cache file name for the given key.
 std::string XlaSerializedCacheKeyToFileName(const XlaSerializedCacheKey& key);
 
+// Returns the parts of the file name of `key` before and after its
+// fingerprints, which the file names of all the entries persisted with the
+// same prefix, device and versions share.
+std::string XlaSerializedCacheKeyFileNamePrefix(
+    const XlaSerializedCacheKey& key);
+std::string XlaSerializedCacheKeyFileNameSuffix(
+    const XlaSerializedCacheKey& key);
+
 // Offers a way to persist and/or load compiled `ExecutableType`s along with the
 // corresponding HLO (`CompilationResult`) to/from `persistent_cache_directory`
 // (if one was provided during construction) on disk  using `ClientType`.
@@ -83,11 +100,26 @@ class DeviceExecutablePersistor {
 
     // Cache is read-only if set to true.
     bool persistent_cache_directory_read_only = false;
+
+    // Identify the build of the compiler and the device model that
+    // executables are compiled with and for. Both are part of the cache key,
+    // so that a cache directory shared by replicas running different builds
+    // or on different hardware never serves an incompatible executable.
+    std::string compiler_version;
+    std::string device_version;
+
+    // If true, the cache directory is listed once at construction, and the
+    // entries of this persistor are read into memory in the background ahead
+    // of their first use. Lookups of entries missing from the listing then
+    // return without querying the file system, which saves a round trip per
+    // cluster on remote file systems; entries published by other processes
+    // after the listing are not seen.
+    bool prefetch_persistent_cache = false;
   };
 
   DeviceExecutablePersistor(const Config& config,
                             const DeviceType& device_type);
-  virtual ~DeviceExecutablePersistor() = default;
+  virtual ~DeviceExecutablePersistor();
 
   // Returns std::nullopt if persistence is not enabled (i.e.
   // `persistent_cache_directory_` is empty) or if the serialized entry is not
@@ -113,6 +145,12 @@ class DeviceExecutablePersistor {
       const ExecutableType& executable,
       DeviceCompilerClient<ExecutableType, ClientType>* client) const;
 
+  // Blocks until the cache directory has been listed and its entries read,
+  // if `prefetch_persistent_cache` is set.
+  void WaitForPrefetch() const {
+    if (prefetch_thread_ != nullptr) prefetch_done_.WaitForNotification();
+  }
+
   const DeviceType& device_type() const { return device_type_; }
   const std::string& persistence_prefix() const { return persistence_prefix_; }
   const std::string& persistent_cache_directory() const {
@@ -153,9 +191,15 @@ class DeviceExecutablePersistor {
 
   std::string GetFilePath(const XlaSerializedCacheKey& key) const;
 
+  // Lists the cache directory into `index_` and reads the entries of this
+  // persistor into `prefetched_entries_`. Runs on `prefetch_thread_`.
+  void PrefetchEntries();
+
   const DeviceType device_type_;
   const bool disable_strict_signature_checks_;
   const std::string persistence_prefix_;
+  const std::string compiler_version_;
+  const std::string device_version_;
 
   // If non-empty, JIT-compiled executables are saved to and loaded from the
   // specified file system directory path.
@@ -164,6 +208,20 @@ class DeviceExecutablePersistor {
   // Cache is read-only if set to true.
   const bool persistent_cache_directory_read_only_;
 
+  mutable mutex mu_;
+  // File names in the cache directory, once it has been listed.
+  mutable std::optional<absl::flat_hash_set<std::string>> index_
+      TF_GUARDED_BY(mu_);
+  // Entries read ahead of their first use, by file name. An entry is removed
+  // when it is looked up.
+  mutable absl::flat_hash_map<std::string, XlaSerializedCacheEntry>
+      prefetched_entries_ TF_GUARDED_BY(mu_);
+  // File names looked up so far, which there is no point in prefetching.
+  mutable absl::flat_hash_set<std::string> looked_up_ TF_GUARDED_BY(mu_);
+  bool cancel_prefetch_ TF_GUARDED_BY(mu_) = false;
+  mutable Notification prefetch_done_;
+  std::unique_ptr<Thread> prefetch_thread_;
+
   DeviceExecutablePersistor(const DeviceExecutablePersistor&) = delete;
   void operator=(const DeviceExecutablePersistor&) = delete;
 };
@@ -175,9 +233,32 @@ DeviceExecutablePersistor<ExecutableType, ClientType>::
     : device_type_(device_type),
       disable_strict_signature_checks_(config.disable_strict_signature_checks),
       persistence_prefix_(config.persistence_prefix),
+      compiler_version_(config.compiler_version),
+      device_version_(config.device_version),
       persistent_cache_directory_(config.persistent_cache_directory),
       persistent_cache_directory_read_only_(
-          config.persistent_cache_directory_read_only) {}
+          config.persistent_cache_directory_read_only) {
+  if (config.prefetch_persistent_cache &&
+      !persistent_cache_directory_.empty()) {
+    prefetch_thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "xla_persistent_cache_prefetch",
+        [this]() {
+          PrefetchEntries();
+          prefetch_done_.Notify();
+        }));
+  }
+}
+
+template <typename ExecutableType, typename ClientType>
+DeviceExecutablePersistor<ExecutableType,
+                          ClientType>::~DeviceExecutablePersistor() {
+  {
+    mutex_lock lock(mu_);
+    cancel_prefetch_ = true;
+  }
+  // Joins the thread.
+  prefetch_thread_.reset();
+}
 
 template <typename ExecutableType, typename ClientType>
 std::string DeviceExecutablePersistor<ExecutableType, ClientType>::GetFilePath(
@@ -197,6 +278,8 @@ DeviceExecutablePersistor<ExecutableType, ClientType>::BuildSerializedCacheKey(
   key.set_device_type(device_type().type_string());
   key.set_prefix(persistence_prefix());
   key.set_compiled_using_pjrt(compiled_using_pjrt);
+  key.set_compiler_version(compiler_version_);
+  key.set_device_version(device_version_);
   return key;
 }
 
@@ -217,10 +300,76 @@ DeviceExecutablePersistor<xla::PjRtLoadedExecutable, xla::PjRtClient>::
   return BuildSerializedCacheKey(signature_hash, hlo_module, true);
 }
 
+template <typename ExecutableType, typename ClientType>
+void DeviceExecutablePersistor<ExecutableType, ClientType>::PrefetchEntries() {
+  Env* env = Env::Default();
+  std::vector<std::string> file_names;
+  Status status = env->GetChildren(persistent_cache_directory_, &file_names);
+  if (!status.ok() && !absl::IsNotFound(status)) {
+    // Fall back to querying the file system on every lookup.
+    LOG(WARNING) << "Could not list XLA persistent cache at "
+                 << persistent_cache_directory_ << ": " << status;
+    return;
+  }
+  {
+    mutex_lock lock(mu_);
+    index_.emplace(file_names.begin(), file_names.end());
+  }
+
+  // Entries of this persistor differ only in their fingerprints.
+  const XlaSerializedCacheKey key =
+      BuildSerializedCacheKey(/*signature_hash=*/0, xla::HloModuleProto());
+  const std::string prefix = XlaSerializedCacheKeyFileNamePrefix(key);
+  const std::string suffix = XlaSerializedCacheKeyFileNameSuffix(key);
+  int num_prefetched = 0;
+  for (const std::string& file_name : file_names) {
+    if (!absl::StartsWith(file_name, prefix) ||
+        !absl::EndsWith(file_name, suffix)) {
+      continue;
+    }
+    {
+      mutex_lock lock(mu_);
+      if (cancel_prefetch_) return;
+      if (looked_up_.contains(file_name)) continue;
+    }
+    XlaSerializedCacheEntry entry;
+    status = ReadBinaryProto(
+        env, io::JoinPath(persistent_cache_directory_, file_name), &entry);
+    if (!status.ok()) {
+      VLOG(1) << "Could not prefetch " << file_name << ": " << status;
+      continue;
+    }
+    mutex_lock lock(mu_);
+    if (!looked_up_.contains(file_name)) {
+      prefetched_entries_.emplace(file_name, std::move(entry));
+      ++num_prefetched;
+    }
+  }
+  VLOG(1) << "Prefetched " << num_prefetched
+          << " entries from XLA persistent cache at "
+          << persistent_cache_directory_;
+}
+
 template <typename ExecutableType, typename ClientType>
 absl::StatusOr<std::optional<XlaSerializedCacheEntry>>
 DeviceExecutablePersistor<ExecutableType, ClientType>::TryToReadSerializedEntry(
     const XlaSerializedCacheKey& key) const {
+  if (prefetch_thread_ != nullptr) {
+    const std::string file_name = XlaSerializedCacheKeyToFileName(key);
+    mutex_lock lock(mu_);
+    looked_up_.insert(file_name);
+    auto it = prefetched_entries_.find(file_name);
+    if (it != prefetched_entries_.end()) {
+      std::optional<XlaSerializedCacheEntry> entry(std::move(it->second));
+      prefetched_entries_.erase(it);
+      return entry;
+    }
+    if (index_.has_value() && !index_->contains(file_name)) {
+      return absl::StatusOr<std::optional<XlaSerializedCacheEntry>>(
+          std::nullopt);
+    }
+  }
+
   Env* env = Env::Default();
   const std::string file_path = GetFilePath(key);
   if (!env->FileExists(file_path).ok()) {
@@ -270,6 +419,17 @@ template <typename ExecutableType, typename ClientType>
 Status
 DeviceExecutablePersistor<ExecutableType, ClientType>::SaveSerializedEntry(
     const XlaSerializedCacheEntry& entry) const {
+  const std::string file_name = XlaSerializedCacheKeyToFileName(entry.key());
+  {
+    // Entries are content-addressed, so an entry that is already published,
+    // e.g. by another replica sharing the directory, need not be rewritten.
+    mutex_lock lock(mu_);
+    if (index_.has_value() && index_->contains(file_name)) {
+      VLOG(2) << "Not persisting already published " << file_name;
+      return absl::OkStatus();
+    }
+  }
+
   Env* env = Env::Default();
   TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(persistent_cache_directory_));
 
@@ -291,15 +451,16 @@ DeviceExecutablePersistor<ExecutableType, ClientType>::SaveSerializedEntry(
 
   // Write to temp location, then when that completes, atomically move into the
   // final location.
-  std::string temp_path =
-      io::JoinPath(persistent_cache_directory_,
-                   XlaSerializedCacheKeyToFileName(entry.key()));
+  std::string temp_path = io::JoinPath(persistent_cache_directory_, file_name);
   if (!env->CreateUniqueFileName(&temp_path, ".tmp")) {
     return absl::UnavailableError(absl::StrCat(
         "Could not create a unique file inside ", persistent_cache_directory_));
   }
   TF_RETURN_IF_ERROR(WriteBinaryProto(env, temp_path, entry));
-  return env->RenameFile(temp_path, GetFilePath(entry.key()));
+  TF_RETURN_IF_ERROR(env->RenameFile(temp_path, GetFilePath(entry.key())));
+  mutex_lock lock(mu_);
+  if (index_.has_value()) index_->insert(file_name);
+  return absl::OkStatus();
 }
 
 template <typename ExecutableType, typename ClientType>
@@ -365,8 +526,16 @@ DeviceExecutablePersistor<ExecutableType, ClientType>::TryToLoadExecutable(
     return std::nullopt;
   }
 
-  TF_RETURN_IF_ERROR(
-      VerifyLoadedCacheEntry(cache_key, hlo_module, *serialized_entry));
+  if (Status status =
+          VerifyLoadedCacheEntry(cache_key, hlo_module, *serialized_entry);
+      !status.ok()) {
+    // Let the entry be replaced by the one compiled instead.
+    mutex_lock lock(mu_);
+    if (index_.has_value()) {
+      index_->erase(XlaSerializedCacheKeyToFileName(cache_key));
+    }
+    return status;
+  }
 
   VLOG(1) << "Loading cached entry for: " << signature_str;
   return compiler_client->LoadExecutable(options, compilation_result,
@@ -212,13 +212,17 @@ std::string GetFilePath(XlaSerializedCacheKey key,
 }
 
 absl::StatusOr<XlaSerializedCacheEntry> ReadCacheEntryFromFile(
-    XlaSerializedCacheKey key, const std::string& persistent_cache_dir) {
-  std::string file_path = GetFilePath(key, persistent_cache_dir);
+    const std::string& file_path) {
   XlaSerializedCacheEntry entry;
   TF_RETURN_IF_ERROR(ReadTextOrBinaryProto(Env::Default(), file_path, &entry));
   return entry;
 }
 
+absl::StatusOr<XlaSerializedCacheEntry> ReadCacheEntryFromFile(
+    XlaSerializedCacheKey key, const std::string& persistent_cache_dir) {
+  return ReadCacheEntryFromFile(GetFilePath(key, persistent_cache_dir));
+}
+
 XlaSerializedCacheKey CreateCacheKey(
     uint64 signature_hash,
     const XlaCompiler::CompilationResult& compilation_result,
@@ -631,5 +635,99 @@ TEST_F(DeviceExecutionPersistorTest, PersistPjRtAndXlaExecutables) {
   EXPECT_EQ(entry.executable(), serialized_xla_executable_);
 }
 
+TEST_F(DeviceExecutionPersistorTest, PersistWithVersions) {
+  XlaDeviceExecutablePersistor::Config config(
+      /*persistent_cache_directory=*/cache_dir_,
+      /*disable_strict_signature_checks=*/false,
+      /*persistence_prefix=*/"xla_versioned");
+  config.compiler_version = "compiler";
+  config.device_version = "device";
+  XlaDeviceExecutablePersistor persistor(config,
+                                         DefaultXlaOptions().device_type);
+
+  MockXlaCompilerClient mock_client;
+  EXPECT_CALL(mock_client, SerializeExecutable(_))
+      .WillOnce(Return(serialized_xla_executable_));
+  TF_ASSERT_OK_AND_ASSIGN(auto executable, BuildSampleExecutable());
+  TF_EXPECT_OK(persistor.TryToPersistExecutable(
+      /*signature_hash=*/123, "signature_string", DefaultXlaOptions(),
+      compilation_result_add_, *executable, &mock_client));
+
+  auto key =
+      CreateCacheKey(/*signature_hash=*/123, compilation_result_add_,
+                     persistor.device_type(), persistor.persistence_prefix());
+  key.set_compiler_version("compiler");
+  key.set_device_version("device");
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto entry,
+      ReadCacheEntryFromFile(
+          io::JoinPath(cache_dir_, XlaSerializedCacheKeyToFileName(key))));
+  EXPECT_EQ(entry.executable(), serialized_xla_executable_);
+
+  // An executable compiled for another device is not loaded.
+  config.device_version = "other_device";
+  XlaDeviceExecutablePersistor other_persistor(config,
+                                               DefaultXlaOptions().device_type);
+  auto loaded_executable = other_persistor.TryToLoadExecutable(
+      /*signature_hash=*/123, "signature_string", DefaultXlaOptions(),
+      compilation_result_add_, &mock_client);
+  EXPECT_FALSE(loaded_executable.has_value());
+}
+
+TEST_F(DeviceExecutionPersistorTest, LoadPrefetched) {
+  const std::string cache_dir = io::JoinPath(cache_dir_, "prefetched");
+  int64_t undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  XlaDeviceExecutablePersistor::Config config(
+      /*persistent_cache_directory=*/cache_dir,
+      /*disable_strict_signature_checks=*/false,
+      /*persistence_prefix=*/"xla");
+  {
+    XlaDeviceExecutablePersistor persistor(config,
+                                           DefaultXlaOptions().device_type);
+    MockXlaCompilerClient mock_client;
+    EXPECT_CALL(mock_client, SerializeExecutable(_))
+        .WillOnce(Return(serialized_xla_executable_));
+    TF_ASSERT_OK_AND_ASSIGN(auto executable, BuildSampleExecutable());
+    TF_EXPECT_OK(persistor.TryToPersistExecutable(
+        /*signature_hash=*/123, "signature_string", DefaultXlaOptions(),
+        compilation_result_add_, *executable, &mock_client));
+  }
+
+  config.prefetch_persistent_cache = true;
+  XlaDeviceExecutablePersistor persistor(config,
+                                         DefaultXlaOptions().device_type);
+  persistor.WaitForPrefetch();
+
+  // The entry is loaded from memory, even once it is gone from the cache
+  // directory.
+  auto key =
+      CreateCacheKey(/*signature_hash=*/123, compilation_result_add_,
+                     persistor.device_type(), persistor.persistence_prefix());
+  TF_ASSERT_OK(Env::Default()->DeleteFile(GetFilePath(key, cache_dir)));
+  MockXlaCompilerClient mock_client;
+  TF_ASSERT_OK_AND_ASSIGN(auto executable, BuildSampleExecutable());
+  EXPECT_CALL(mock_client, LoadExecutable(_, _, serialized_xla_executable_))
+      .WillOnce(Return(ByMove(std::move(executable))));
+  auto loaded_executable = persistor.TryToLoadExecutable(
+      /*signature_hash=*/123, "signature_string", DefaultXlaOptions(),
+      compilation_result_add_, &mock_client);
+  ASSERT_TRUE(loaded_executable.has_value());
+  TF_EXPECT_OK(loaded_executable->status());
+
+  // Entries missing from the listing are not looked up on disk.
+  key = CreateCacheKey(/*signature_hash=*/456, compilation_result_add_,
+                       persistor.device_type(),
+                       persistor.persistence_prefix());
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), GetFilePath(key, cache_dir),
+                                XlaSerializedCacheEntry()));
+  loaded_executable = persistor.TryToLoadExecutable(
+      /*signature_hash=*/456, "different_signature", DefaultXlaOptions(),
+      compilation_result_add_, &mock_client);
+  EXPECT_FALSE(loaded_executable.has_value());
+}
+
 }  // namespace
 }  // namespace tensorflow
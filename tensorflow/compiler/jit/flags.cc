@@ -108,6 +108,17 @@ void AppendMarkForCompilationPassFlagsInternal(std::vector<Flag>* flag_list) {
       Flag("tf_xla_max_cluster_size",
            &mark_for_compilation_flags->tf_xla_max_cluster_size,
            "Maximum number of operators in an XLA compilation."),
+      Flag("tf_xla_profitable_clustering",
+           &mark_for_compilation_flags->tf_xla_profitable_clustering,
+           "If true, auto-clustering only keeps the clusters that a cost "
+           "model estimates save more time over "
+           "tf_xla_profitable_clustering_expected_runs executions than it "
+           "takes to compile them. Experimental."),
+      Flag("tf_xla_profitable_clustering_expected_runs",
+           &mark_for_compilation_flags
+                ->tf_xla_profitable_clustering_expected_runs,
+           "Number of executions the compilation of a cluster is expected to "
+           "be amortized over, for tf_xla_profitable_clustering."),
       Flag(
           "tf_xla_ops_to_cluster",
           &mark_for_compilation_flags->tf_xla_ops_to_cluster,
@@ -167,6 +178,12 @@ void AppendMarkForCompilationPassFlagsInternal(std::vector<Flag>* flag_list) {
       Flag("tf_xla_persistent_cache_read_only",
            &mark_for_compilation_flags->tf_xla_persistent_cache_read_only,
            "If true, the persistent cache will be read-only."),
+      Flag("tf_xla_persistent_cache_prefetch",
+           &mark_for_compilation_flags->tf_xla_persistent_cache_prefetch,
+           "If true, the persistent cache directory is listed once when a "
+           "device compiler is created, and its entries for the device are "
+           "read ahead of their first use in the background. Entries "
+           "persisted by other processes after that are not loaded."),
       Flag("tf_xla_disable_strict_signature_checks",
            &mark_for_compilation_flags->tf_xla_disable_strict_signature_checks,
            "If true, entires loaded into the XLA compile cache will not have "
@@ -230,6 +247,9 @@ void AllocateAndParseFlags() {
   mark_for_compilation_flags->tf_xla_min_cluster_size = 4;
   mark_for_compilation_flags->tf_xla_max_cluster_size =
       std::numeric_limits<int32>::max();
+  mark_for_compilation_flags->tf_xla_profitable_clustering = false;
+  mark_for_compilation_flags->tf_xla_profitable_clustering_expected_runs =
+      1000;
   mark_for_compilation_flags->tf_xla_clustering_debug = false;
   mark_for_compilation_flags->tf_xla_cpu_global_jit = false;
   mark_for_compilation_flags->tf_xla_clustering_fuel =
@@ -242,6 +262,7 @@ void AllocateAndParseFlags() {
   mark_for_compilation_flags->tf_xla_persistent_cache_directory = "";
   mark_for_compilation_flags->tf_xla_persistent_cache_device_types = "";
   mark_for_compilation_flags->tf_xla_persistent_cache_read_only = false;
+  mark_for_compilation_flags->tf_xla_persistent_cache_prefetch = false;
   mark_for_compilation_flags->tf_xla_disable_strict_signature_checks = false;
   mark_for_compilation_flags->tf_xla_persistent_cache_prefix =
       "xla_compile_cache";
@@ -263,6 +284,12 @@ void AllocateAndParseFlags() {
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
   ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_async_compilation_threads = 0;
+  ops_flags->tf_xla_async_compilation_staleness_ms = 60 * 1000;
+  ops_flags->tf_xla_shape_bucketing = false;
+  ops_flags->tf_xla_shape_bucket_sizes = "";
+  ops_flags->tf_xla_gpu_command_buffers = false;
+  ops_flags->tf_xla_gpu_command_buffer_min_size = 1;
   ops_flags->tf_xla_use_device_api.enabled_for_xla_launch_ = true;
   ops_flags->tf_xla_use_device_api.enabled_for_compile_on_demand_ = true;
   ops_flags->tf_xla_use_device_api.enabled_for_compile_and_run_ = true;
@@ -334,6 +361,34 @@ void AllocateAndParseFlags() {
             "When lazy compilation is enabled, asynchronous compilation starts "
             "the cluster compilation in the background, and the fallback path "
             "is executed until the compilation has finished."),
+       Flag("tf_xla_async_compilation_threads",
+            &ops_flags->tf_xla_async_compilation_threads,
+            "Number of threads compiling clusters asynchronously for each "
+            "device. If 0, it is derived from the number of cores."),
+       Flag("tf_xla_async_compilation_staleness_ms",
+            &ops_flags->tf_xla_async_compilation_staleness_ms,
+            "Queued asynchronous compilations of cluster signatures that have "
+            "not been requested for this many milliseconds are dropped. If 0, "
+            "queued compilations are never dropped."),
+       Flag("tf_xla_shape_bucketing", &ops_flags->tf_xla_shape_bucketing,
+            "If true, XlaLaunch pads the leading dimension of the inputs of a "
+            "cluster up to a bucket size and slices it off the outputs, so "
+            "that one executable serves every size in the bucket. Only "
+            "correct for clusters that treat input rows independently."),
+       Flag("tf_xla_shape_bucket_sizes",
+            &ops_flags->tf_xla_shape_bucket_sizes,
+            "Comma-separated, increasing bucket sizes for "
+            "--tf_xla_shape_bucketing. Sizes are rounded up to the next power "
+            "of two when empty or larger than the last bucket size."),
+       Flag("tf_xla_gpu_command_buffers",
+            &ops_flags->tf_xla_gpu_command_buffers,
+            "If true, GPU executables of compiled clusters record their "
+            "kernels, library calls and control flow into command buffers "
+            "(CUDA graphs) that are replayed on every step after the first."),
+       Flag("tf_xla_gpu_command_buffer_min_size",
+            &ops_flags->tf_xla_gpu_command_buffer_min_size,
+            "Minimum number of commands in a region for it to be recorded "
+            "into a command buffer with --tf_xla_gpu_command_buffers."),
        Flag("tf_xla_use_device_api_for_xla_launch",
             &ops_flags->tf_xla_use_device_api.enabled_for_xla_launch_,
             "If true, uses Device API (PjRt) for single device compilation and "
@@ -62,6 +62,16 @@ struct MarkForCompilationPassFlags {
   // Maximum number of operators in an XLA compilation.
   int32 tf_xla_max_cluster_size;
 
+  // If true, auto-clustering only keeps the clusters that a cost model
+  // estimates save more time over tf_xla_profitable_clustering_expected_runs
+  // executions than it takes to compile them. Ignored for operators placed on
+  // an XLA device or operators explicitly marked for compilation.
+  bool tf_xla_profitable_clustering;
+
+  // Number of executions the compilation of a cluster is expected to be
+  // amortized over, for tf_xla_profitable_clustering.
+  int64_t tf_xla_profitable_clustering_expected_runs;
+
   // If non-empty, limit XLA clustering to the following TF operations.
   string tf_xla_ops_to_cluster;
 
@@ -104,6 +114,11 @@ struct MarkForCompilationPassFlags {
 
   bool tf_xla_persistent_cache_read_only;
 
+  // If true, the persistent cache directory is listed once when a device
+  // compiler is created, and its entries for the device are read ahead of
+  // their first use in the background.
+  bool tf_xla_persistent_cache_prefetch;
+
   // If true, entries loaded into the XLA compile cache will not have their
   // signatures checked strictly. This should generally not be disabled except
   // for debugging. Defaults to false.
@@ -151,6 +166,30 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile compiles the cluster asynchronously with respect to
   // the main execution. The fallback path is taken while compilation happens.
   bool tf_xla_async_compilation;
+  // Number of threads compiling clusters asynchronously for each device
+  // compiler. If 0, it is derived from the number of cores.
+  int64_t tf_xla_async_compilation_threads;
+  // Queued asynchronous compilations of signatures that have not been
+  // requested for this many milliseconds are dropped rather than compiled. If
+  // 0, queued compilations are never dropped.
+  int64_t tf_xla_async_compilation_staleness_ms;
+  // If true, XlaLaunch pads the leading dimension of the inputs of a cluster
+  // up to a bucket size and slices it off the outputs again, so that one
+  // executable serves every size in the bucket. Only correct for clusters that
+  // treat the rows of their inputs independently, e.g. batched inference.
+  bool tf_xla_shape_bucketing;
+  // Comma-separated, increasing bucket sizes for tf_xla_shape_bucketing. Sizes
+  // are rounded up to the next power of two when empty, or when larger than
+  // the last bucket size.
+  std::string tf_xla_shape_bucket_sizes;
+  // If true, the GPU executables of compiled clusters record their kernels,
+  // library calls and control flow into command buffers (CUDA graphs), which
+  // are replayed with the buffers of each step after the first execution.
+  // Ops that cannot be recorded keep running on the stream between graphs.
+  bool tf_xla_gpu_command_buffers;
+  // Minimum number of commands in a region for it to be recorded into a
+  // command buffer when tf_xla_gpu_command_buffers is set.
+  int32_t tf_xla_gpu_command_buffer_min_size;
 
   class PjRtForSingleDeviceCompilationRollout {
    public:
@@ -123,6 +123,9 @@ class ExecutableClosure {
   const ResourceVarsSnapshot& resource_var_snapshots() const {
     return resource_var_snapshots_;
   }
+  ResourceVarsSnapshot* mutable_resource_var_snapshots() {
+    return &resource_var_snapshots_;
+  }
   int num_constant_args() const { return num_constant_args_; }
 
  private:
@@ -569,6 +572,13 @@ void XlaLocalLaunchBase::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
     return;
   }
 
+  // Compile for the bucket of the leading dimension rather than the exact
+  // shapes of the inputs, which are padded to match before execution.
+  std::optional<LeadingDimensionBucket> bucket;
+  if (!platform_info_.is_on_xla_device()) {
+    bucket = BucketLeadingDimension(&xla_compiler_args);
+  }
+
   Status status = CompileToLocalExecutable(
       ctx, function_, /*has_ref_vars=*/has_ref_vars_, platform_info_,
       xla_compiler_args, DeviceCompileMode::kStrict,
@@ -578,7 +588,7 @@ void XlaLocalLaunchBase::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
 
   // Continuation of the execution, may be run in a different thread.
   auto run_xla_cluster = [ctx, client, executable, compilation_result, done,
-                          inputs, resources = resources_]() {
+                          inputs, bucket, resources = resources_]() {
     // Separate scope so that VariableInfo locks are released before done is
     // called.
     {
@@ -601,12 +611,22 @@ void XlaLocalLaunchBase::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
       XlaComputationLaunchContext launch_context =
           GetLaunchContext(platform_info, ctx, client, allocator.get());
 
+      // Padded inputs are passed like variables, which take precedence over
+      // the inputs of `ctx`. They are never updated, so never donated.
+      std::map<int, const Tensor*> input_ptrs = resource_var_ptrs;
+      std::vector<Tensor> padded_inputs;
+      if (bucket.has_value()) {
+        OP_REQUIRES_OK_ASYNC(
+            ctx, PadInputsToBucket(ctx, *bucket, &padded_inputs, &input_ptrs),
+            done);
+      }
+
       const xla::HloInputOutputAliasConfig& input_output_alias =
           executable->executable()->module().input_output_alias_config();
       absl::StatusOr<std::vector<xla::ExecutionInput>> execution_inputs =
-          launch_context.PopulateInputs(
-              ctx, compilation_result, resource_var_ptrs,
-              /*missing_ctx_input_prefix=*/0, input_output_alias);
+          launch_context.PopulateInputs(ctx, compilation_result, input_ptrs,
+                                        /*missing_ctx_input_prefix=*/0,
+                                        input_output_alias);
       OP_REQUIRES_OK_ASYNC(ctx, execution_inputs.status(), done);
 
       xla::gpu::GpuExecutableRunOptions gpu_options;
@@ -640,6 +660,7 @@ void XlaLocalLaunchBase::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
               /*missing_ctx_input_prefix=*/0, absl::MakeSpan(variable_infos),
               input_output_alias, resource_var_ptrs),
           done);
+      if (bucket.has_value()) SliceOutputsFromBucket(ctx, *bucket);
       VLOG(1) << "Done";
     }
     done();
@@ -774,20 +795,21 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
         args_and_variables_snapshot->first;
     variables_snapshot = std::move(args_and_variables_snapshot->second);
 
-    // Do not alias resource updates as locking variables in XlaCompile and
-    // unlocking them in XlaRun may lead to deadlocks.
+    // Resource updates may alias the variables: XlaRun locks the updated
+    // variables for the duration of the execution, and only donates the
+    // buffers of those it holds the only reference to.
     Status status;
     if (use_pjrt) {
       VLOG(2) << "Using PJRT for compilation. Function name: "
               << function_.name();
       status = CompileToPjRtLoadedExecutable(
           *ctx, platform_info_, function_, args, compile_mode, has_ref_vars_,
-          /*may_alias_resource_update=*/false, &kernel, &pjrt_client,
+          /*may_alias_resource_update=*/true, &kernel, &pjrt_client,
           &pjrt_executable);
     } else {
       status = CompileToLocalExecutable(
           ctx, function_, has_ref_vars_, platform_info_, args, compile_mode,
-          /*may_alias_resource_update=*/false, &client, &kernel, &executable);
+          /*may_alias_resource_update=*/true, &client, &kernel, &executable);
     }
     if (compile_mode != DeviceCompileMode::kLazy ||
         status.code() != error::UNIMPLEMENTED) {
@@ -875,20 +897,17 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
     // last input. So the inputs look like: input tensors, resource variables,
     // closure key tensor.
     std::vector<const Tensor*> inputs = InputsFromContext(ctx);
-    absl::flat_hash_map<int, const Tensor*> variable_snapshots;
-    for (const auto& [variable_index, variable_tensor] :
-         closure.resource_var_snapshots()) {
-      variable_snapshots.emplace(variable_index, variable_tensor.has_value()
-                                                     ? &variable_tensor.value()
-                                                     : nullptr);
-    }
-
     {
       absl::StatusOr<std::vector<VariableInfo>> updated_variables =
           GatherVariableInfo(ctx, *closure.compilation_result(),
                              closure.num_constant_args());
       OP_REQUIRES_OK(ctx, updated_variables.status());
       OP_REQUIRES_OK(ctx, LockVariables(absl::MakeSpan(*updated_variables)));
+      std::vector<Tensor> stale_snapshots;
+      const auto variable_snapshots =
+          GetSnapshotPtrsForUpdate<absl::flat_hash_map<int, const Tensor*>>(
+              *updated_variables, closure.num_constant_args(),
+              closure.mutable_resource_var_snapshots(), &stale_snapshots);
       OP_REQUIRES_OK(
           ctx, RunPjRtExecutable(closure.num_constant_args(), inputs,
                                  variable_snapshots, *updated_variables,
@@ -914,8 +933,17 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
   // already been baked into the compiled kernel.
   const xla::HloInputOutputAliasConfig& input_output_alias =
       closure.executable()->executable()->module().input_output_alias_config();
+
+  // The updated variables stay locked until their updates are applied, so
+  // that their buffers can be donated to the computation.
+  absl::StatusOr<std::vector<VariableInfo>> variable_infos = GatherVariableInfo(
+      ctx, *closure.compilation_result(), closure.num_constant_args());
+  OP_REQUIRES_OK(ctx, variable_infos.status());
+  OP_REQUIRES_OK(ctx, LockVariables(absl::MakeSpan(*variable_infos)));
+
   absl::StatusOr<std::vector<xla::ExecutionInput>> execution_inputs;
   std::map<int, const Tensor*> snapshot_ptrs;
+  std::vector<Tensor> stale_snapshots;
   {
     tsl::profiler::TraceMe hlo_module_activity(
         [&] {
@@ -925,12 +953,9 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
         },
         tsl::profiler::TraceMeLevel::kInfo);
 
-    for (const auto& [variable_index, variable_tensor] :
-         closure.resource_var_snapshots()) {
-      snapshot_ptrs.emplace(variable_index, variable_tensor.has_value()
-                                                ? &variable_tensor.value()
-                                                : nullptr);
-    }
+    snapshot_ptrs = GetSnapshotPtrsForUpdate<std::map<int, const Tensor*>>(
+        *variable_infos, closure.num_constant_args(),
+        closure.mutable_resource_var_snapshots(), &stale_snapshots);
     execution_inputs = launch_context.PopulateInputs(
         ctx, closure.compilation_result(), snapshot_ptrs,
         /*missing_ctx_input_prefix=*/closure.num_constant_args(),
@@ -959,10 +984,6 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
       },
       tsl::profiler::TraceMeLevel::kInfo);
 
-  absl::StatusOr<std::vector<VariableInfo>> variable_infos = GatherVariableInfo(
-      ctx, *closure.compilation_result(), closure.num_constant_args());
-  OP_REQUIRES_OK(ctx, variable_infos.status());
-  OP_REQUIRES_OK(ctx, LockVariables(absl::MakeSpan(*variable_infos)));
   OP_REQUIRES_OK(
       ctx,
       launch_context.PopulateOutputs(
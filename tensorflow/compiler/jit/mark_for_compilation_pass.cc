@@ -41,6 +41,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/device_util.h"
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/resource_operation_safety_analysis.h"
+#include "tensorflow/compiler/jit/shape_inference.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/tf2xla/const_analysis.h"
 #include "tensorflow/compiler/tf2xla/resource_operation_table.h"
@@ -92,6 +93,15 @@ using jit::DeviceSet;
 // cluster.
 const char* kXlaAlreadyClustered = "_XlaAlreadyClustered";
 
+// Parameters of the cost model of tf_xla_profitable_clustering.  These are
+// deliberately coarse: the executor overhead per operation, the bandwidth of
+// the memory that unfused intermediate tensors round trip through, and the
+// time XLA takes to compile a cluster.
+constexpr double kOpOverheadUs = 2.0;
+constexpr double kMemoryBytesPerUs = 10000.0;
+constexpr double kCompileOverheadUs = 5000.0;
+constexpr double kCompileUsPerOp = 100.0;
+
 class MarkForCompilationPassImpl {
  public:
   struct DebugOptions {
@@ -112,6 +122,13 @@ class MarkForCompilationPassImpl {
     int max_cluster_size;
     int min_cluster_size;
 
+    // If true, clusters that are not expected to run faster than their
+    // operations would in the TF executor, once the time to compile them is
+    // amortized over `expected_runs_per_cluster` executions, are not
+    // compiled.
+    bool profitable_clustering;
+    int64_t expected_runs_per_cluster;
+
     // Compiler fuel for the auto-clustering algorithm.
     //
     // We decrement this value by one on every time we choose a compilation
@@ -311,6 +328,12 @@ class MarkForCompilationPassImpl {
   // tf_xla_min_cluster_size, are applied here.
   Status CreateClusters();
 
+  // Estimates, for every cluster, whether compiling it is profitable under
+  // debug_options_.profitable_clustering.  Returns a map from the ID of the
+  // cluster in `cycles_graph_` to the estimate.
+  absl::StatusOr<absl::flat_hash_map<int, bool>>
+  EstimateClusterProfitability();
+
   Status DumpDebugInfo();
 
   bool IsCompilationCandidate(Node* n) const {
@@ -970,12 +993,18 @@ Status MarkForCompilationPassImpl::CreateClusters() {
     DumpGraphToFile("before_mark_for_compilation", *graph_, flib_def_);
   }
 
+  absl::flat_hash_map<int, bool> profitable;
+  if (debug_options_.profitable_clustering) {
+    TF_ASSIGN_OR_RETURN(profitable, EstimateClusterProfitability());
+  }
+
   // Mark clusters for compilation that:
   // * are placed on a device that requires compilation (an XlaDevice),
   // * are explicitly marked for compilation (_XlaCompile=true), or
   // * have more than debug_options_.xla_min_cluster_size elements (applicable
   //   only if compilation is enabled, otherwise there will be no such
-  //   candidates).
+  //   candidates) and, under debug_options_.profitable_clustering, are
+  //   estimated to be profitable to compile.
   for (Node* n : compilation_candidates_) {
     Cluster* cluster = GetClusterForNode(n);
     TF_ASSIGN_OR_RETURN(bool should_compile_cluster,
@@ -989,7 +1018,11 @@ Status MarkForCompilationPassImpl::CreateClusters() {
     // to (recursively) verify this fact, but that's probably not worth the
     // trouble.
 
-    if (cluster->effective_cluster_size() >= debug_options_.min_cluster_size ||
+    const bool is_profitable =
+        !debug_options_.profitable_clustering ||
+        profitable[cluster->cycles_graph_node_id()];
+    if ((cluster->effective_cluster_size() >= debug_options_.min_cluster_size &&
+         is_profitable) ||
         cluster->has_functional_control_flow() ||
         cluster->is_xla_compile_attr_true()) {
       string& name = cluster_names[cluster->cycles_graph_node_id()];
@@ -1016,6 +1049,69 @@ Status MarkForCompilationPassImpl::CreateClusters() {
   return absl::OkStatus();
 }
 
+absl::StatusOr<absl::flat_hash_map<int, bool>>
+MarkForCompilationPassImpl::EstimateClusterProfitability() {
+  // Shapes are only needed to estimate the memory traffic saved by fusion;
+  // without them the estimates are based on the number of operations alone.
+  GraphShapeInfo shape_info;
+  Status status = InferShapes(graph_, /*arg_shapes=*/{}, flib_def_,
+                              &shape_info);
+  if (!status.ok()) {
+    VLOG(2) << "Estimating cluster profitability without shapes: " << status;
+    shape_info.clear();
+  }
+
+  // Bytes of the outputs that are consumed in the cluster they are produced
+  // in, by cluster.
+  absl::flat_hash_map<int, int64_t> intermediate_bytes;
+  for (Node* n : compilation_candidates_) {
+    Cluster* cluster = GetClusterForNode(n);
+    std::set<int> intermediate_outputs;
+    for (const Edge* e : n->out_edges()) {
+      if (!e->IsControlEdge() && GetClusterForNode(e->dst()) == cluster) {
+        intermediate_outputs.insert(e->src_output());
+      }
+    }
+    auto it = shape_info.find(n->name());
+    if (it == shape_info.end()) continue;
+    for (int output : intermediate_outputs) {
+      if (output >= static_cast<int>(it->second.size()) ||
+          !it->second[output].shape.IsFullyDefined()) {
+        continue;
+      }
+      intermediate_bytes[cluster->cycles_graph_node_id()] +=
+          it->second[output].shape.num_elements() *
+          DataTypeSize(n->output_type(output));
+    }
+  }
+
+  absl::flat_hash_map<int, bool> profitable;
+  for (Node* n : compilation_candidates_) {
+    Cluster* cluster = GetClusterForNode(n);
+    auto [it, inserted] =
+        profitable.insert({cluster->cycles_graph_node_id(), false});
+    if (!inserted) continue;
+
+    // Compiling a cluster saves the per-operation overhead of the executor,
+    // and the round trips to memory of the tensors passed between its
+    // operations, which XLA fuses away.
+    const int64_t bytes = intermediate_bytes[cluster->cycles_graph_node_id()];
+    const double saved_us_per_run =
+        cluster->effective_cluster_size() * kOpOverheadUs +
+        2.0 * bytes / kMemoryBytesPerUs;
+    const double compile_us =
+        kCompileOverheadUs +
+        cluster->effective_cluster_size() * kCompileUsPerOp;
+    it->second = saved_us_per_run * debug_options_.expected_runs_per_cluster >=
+                 compile_us;
+    VLOG(3) << "Cluster " << cluster->DebugString(*graph_) << " saves "
+            << saved_us_per_run << "us per run and takes " << compile_us
+            << "us to compile: "
+            << (it->second ? "profitable" : "unprofitable");
+  }
+  return profitable;
+}
+
 Status MarkForCompilationPassImpl::DumpDebugInfo() {
   TF_RET_CHECK(initialized_ && edges_contracted_ && clusters_created_);
 
@@ -1922,6 +2018,9 @@ Status MarkForCompilationPass::Run(
       flags->tf_xla_deterministic_cluster_names;
   debug_options.max_cluster_size = flags->tf_xla_max_cluster_size;
   debug_options.min_cluster_size = flags->tf_xla_min_cluster_size;
+  debug_options.profitable_clustering = flags->tf_xla_profitable_clustering;
+  debug_options.expected_runs_per_cluster =
+      flags->tf_xla_profitable_clustering_expected_runs;
   debug_options.fuel = GetPointerToFuel(flags->tf_xla_clustering_fuel);
   debug_options.dump_graphs = flags->tf_xla_clustering_debug;
 
@@ -1941,6 +2040,9 @@ Status MarkForCompilationPass::RunForTest(
   debug_options.deterministic_cluster_names = deterministic_cluster_names;
   debug_options.max_cluster_size = flags->tf_xla_max_cluster_size;
   debug_options.min_cluster_size = flags->tf_xla_min_cluster_size;
+  debug_options.profitable_clustering = flags->tf_xla_profitable_clustering;
+  debug_options.expected_runs_per_cluster =
+      flags->tf_xla_profitable_clustering_expected_runs;
   debug_options.fuel = GetPointerToFuel(flags->tf_xla_clustering_fuel);
   debug_options.dump_graphs = flags->tf_xla_clustering_debug;
 
@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/sendrecv_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/mark_for_compilation_pass_test_helper.h"
 #include "tensorflow/compiler/jit/node_matchers.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
@@ -51,6 +52,7 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -1885,6 +1887,43 @@ TEST(XlaCompilationTest, ClusterSessionName) {
   EXPECT_THAT(cluster_name, ::testing::StartsWith("test_session_name"));
 }
 
+TEST(XlaCompilationTest, ProfitableClustering) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  // A chain of operations on scalars, which compiling barely speeds up, and
+  // one on large tensors, which compiling saves round trips to memory for.
+  Output a = ops::Placeholder(root.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({}));
+  Output a1 = ops::Negate(root.WithOpName("a1"), a);
+  Output a2 = ops::Negate(root.WithOpName("a2"), a1);
+  Output a3 = ops::Negate(root.WithOpName("a3"), a2);
+  Output b = ops::Placeholder(root.WithOpName("b"), DT_FLOAT,
+                              ops::Placeholder::Shape({1024, 1024}));
+  Output b1 = ops::Negate(root.WithOpName("b1"), b);
+  Output b2 = ops::Negate(root.WithOpName("b2"), b1);
+  Output b3 = ops::Negate(root.WithOpName("b3"), b2);
+
+  MarkForCompilationPassFlags* flags = GetMarkForCompilationPassFlags();
+  const MarkForCompilationPassFlags saved_flags = *flags;
+  auto restore_flags = gtl::MakeCleanup([&] { *flags = saved_flags; });
+  flags->tf_xla_min_cluster_size = 1;
+
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  TF_ASSERT_OK(root.ToGraph(graph.get()));
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(&graph));
+  EXPECT_EQ(GetClusters(*graph).size(), 6);
+
+  flags->tf_xla_profitable_clustering = true;
+  flags->tf_xla_profitable_clustering_expected_runs = 10;
+  graph = std::make_unique<Graph>(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(graph.get()));
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(&graph));
+  std::unordered_map<string, string> clusters = GetClusters(*graph);
+  EXPECT_EQ(clusters.size(), 3);
+  EXPECT_FALSE(clusters["b1"].empty());
+  EXPECT_EQ(clusters["b1"], clusters["b2"]);
+  EXPECT_EQ(clusters["b1"], clusters["b3"]);
+}
+
 namespace {
 Node* MakeStageNode(GraphDefBuilder& builder, string name,
                     std::initializer_list<DataType> dtypes,
@@ -20,6 +20,8 @@ limitations under the License.
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
@@ -77,6 +79,54 @@ absl::StatusOr<std::unique_ptr<Graph>> CreateSingleOpGraph(
   return graph;
 }
 
+int64_t GetBucketSize(int64_t size, absl::Span<const int64_t> bucket_sizes) {
+  for (int64_t bucket_size : bucket_sizes) {
+    if (bucket_size >= size) return bucket_size;
+  }
+  int64_t bucket_size = 1;
+  while (bucket_size < size) bucket_size *= 2;
+  return bucket_size;
+}
+
+std::optional<LeadingDimensionBucket> BucketLeadingDimension(
+    std::vector<XlaArgument>* args) {
+  const XlaOpsCommonFlags& flags = *GetXlaOpsCommonFlags();
+  if (!flags.tf_xla_shape_bucketing) return std::nullopt;
+
+  LeadingDimensionBucket bucket{/*size=*/-1, /*bucket_size=*/-1, {}};
+  for (int i = 0, end = args->size(); i < end; ++i) {
+    const XlaArgument& arg = (*args)[i];
+    if (arg.kind != XlaArgument::kParameter) continue;
+    const TensorShape* shape = std::get_if<TensorShape>(&arg.shape);
+    if (shape == nullptr) return std::nullopt;
+    if (shape->dims() == 0) continue;
+    if (bucket.size != -1 && shape->dim_size(0) != bucket.size) {
+      return std::nullopt;
+    }
+    bucket.size = shape->dim_size(0);
+    bucket.arg_indices.push_back(i);
+  }
+  if (bucket.size <= 0) return std::nullopt;
+
+  std::vector<int64_t> bucket_sizes;
+  for (absl::string_view s :
+       absl::StrSplit(flags.tf_xla_shape_bucket_sizes, ',',
+                      absl::SkipWhitespace())) {
+    int64_t bucket_size;
+    if (!absl::SimpleAtoi(s, &bucket_size)) {
+      LOG(WARNING) << "Ignoring invalid --tf_xla_shape_bucket_sizes entry: "
+                   << s;
+      continue;
+    }
+    bucket_sizes.push_back(bucket_size);
+  }
+  bucket.bucket_size = GetBucketSize(bucket.size, bucket_sizes);
+  for (int i : bucket.arg_indices) {
+    std::get<TensorShape>((*args)[i].shape).set_dim(0, bucket.bucket_size);
+  }
+  return bucket;
+}
+
 bool UsePjRtForSingleDeviceCompilation(const DeviceType& device_type) {
   const auto& rollout_config = GetXlaOpsCommonFlags()->tf_xla_use_device_api;
   return rollout_config.IsEnabledInXlaLaunchForDevice(device_type) ||
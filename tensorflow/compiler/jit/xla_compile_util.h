@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_JIT_XLA_COMPILE_UTIL_H_
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "tensorflow/compiler/tf2xla/xla_argument.h"
 #include "tensorflow/core/graph/graph.h"
@@ -38,6 +40,26 @@ enum class DeviceCompileState {
   kCompiled,
 };
 
+// The leading dimension shared by the parameters of a cluster, and the bucket
+// size it is padded to when shape bucketing is enabled.
+struct LeadingDimensionBucket {
+  int64_t size;
+  int64_t bucket_size;
+  // Indices of the arguments whose leading dimension is padded.
+  std::vector<int> arg_indices;
+};
+
+// Returns the smallest of `bucket_sizes`, which must be increasing, that is at
+// least `size`, or the next power of two if there is none.
+int64_t GetBucketSize(int64_t size, absl::Span<const int64_t> bucket_sizes);
+
+// If --tf_xla_shape_bucketing is set and all the parameters in `args` that are
+// not scalars have the same, non-zero leading dimension, replaces it with its
+// bucket size in `args` and returns the bucket. Returns std::nullopt and
+// leaves `args` untouched otherwise.
+std::optional<LeadingDimensionBucket> BucketLeadingDimension(
+    std::vector<XlaArgument>* args);
+
 // Creates a single-node graph using the specified `node_def` as the only op
 // apart from the arg and retval nodes corresponding to `args` and
 // `result_types` respectively.
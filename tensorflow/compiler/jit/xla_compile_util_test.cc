@@ -15,6 +15,8 @@ limitations under the License.
 #include "tensorflow/compiler/jit/xla_compile_util.h"
 
 #include <memory>
+#include <optional>
+#include <variant>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -119,6 +121,55 @@ TEST(XlaCompileUtilTest, PjRtXlaCompileOnDemandFlagTest) {
   EXPECT_FALSE(UsePjRtForSingleDeviceCompilation(DeviceType(DEVICE_CPU)));
 }
 
+TEST(XlaCompileUtilTest, GetBucketSize) {
+  EXPECT_EQ(GetBucketSize(1, {}), 1);
+  EXPECT_EQ(GetBucketSize(5, {}), 8);
+  EXPECT_EQ(GetBucketSize(8, {}), 8);
+  EXPECT_EQ(GetBucketSize(5, {4, 16, 64}), 16);
+  EXPECT_EQ(GetBucketSize(16, {4, 16, 64}), 16);
+  EXPECT_EQ(GetBucketSize(100, {4, 16, 64}), 128);
+}
+
+TEST(XlaCompileUtilTest, BucketLeadingDimension) {
+  auto make_args = [](int64_t batch) {
+    std::vector<XlaArgument> args(4);
+    args[0].kind = XlaArgument::kParameter;
+    args[0].shape = TensorShape({batch, 3});
+    args[1].kind = XlaArgument::kParameter;
+    args[1].shape = TensorShape({});
+    args[2].kind = XlaArgument::kConstant;
+    args[2].shape = TensorShape({2});
+    args[3].kind = XlaArgument::kParameter;
+    args[3].shape = TensorShape({batch});
+    return args;
+  };
+
+  std::vector<XlaArgument> args = make_args(5);
+  EXPECT_FALSE(BucketLeadingDimension(&args).has_value());
+
+  auto& flags = *GetXlaOpsCommonFlags();
+  flags.tf_xla_shape_bucketing = true;
+  flags.tf_xla_shape_bucket_sizes = "4,16";
+  std::optional<LeadingDimensionBucket> bucket = BucketLeadingDimension(&args);
+  ASSERT_TRUE(bucket.has_value());
+  EXPECT_EQ(bucket->size, 5);
+  EXPECT_EQ(bucket->bucket_size, 16);
+  EXPECT_EQ(bucket->arg_indices, std::vector<int>({0, 3}));
+  EXPECT_EQ(std::get<TensorShape>(args[0].shape), TensorShape({16, 3}));
+  EXPECT_EQ(std::get<TensorShape>(args[1].shape), TensorShape({}));
+  EXPECT_EQ(std::get<TensorShape>(args[2].shape), TensorShape({2}));
+  EXPECT_EQ(std::get<TensorShape>(args[3].shape), TensorShape({16}));
+
+  // Parameters whose leading dimensions differ are not bucketed.
+  args = make_args(5);
+  args[3].shape = TensorShape({6});
+  EXPECT_FALSE(BucketLeadingDimension(&args).has_value());
+  EXPECT_EQ(std::get<TensorShape>(args[0].shape), TensorShape({5, 3}));
+
+  flags.tf_xla_shape_bucketing = false;
+  flags.tf_xla_shape_bucket_sizes = "";
+}
+
 TEST(XlaCompileUtilTest, PjRtDeviceCompilerResourceName) {
   EXPECT_EQ(GetPjRtDeviceCompilerResourceName(DeviceType(DEVICE_TPU)),
             "pjrt_device_compiler_TPU");
@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/compiler/jit/xla_launch_util.h"
 
 #include <cstdint>
+#include <cstring>
+#include <map>
 #include <memory>
 #include <optional>
 #include <set>
@@ -49,6 +51,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_serving_device_selector.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
@@ -502,6 +505,10 @@ Status XlaComputationLaunchContext::PopulateOutputs(
                                    resource_vars, write.type, write.shape,
                                    allocator, allocate_xla_tensors_, stream,
                                    use_multiple_streams_, definition_event));
+    const bool aliased = output_tensor.SharesBufferWith(*var->tensor());
+    VLOG(2) << "Variable #" << i << " updated "
+            << (aliased ? "in place" : "in a new buffer");
+    metrics::UpdateXlaResourceUpdateBytes(aliased, output_tensor.TotalBytes());
     var->is_initialized |= write.modified;
     *var->tensor() = output_tensor;
     ++output_num;
@@ -819,6 +826,57 @@ xla::ExecuteOptions GetPjRtExecuteOptions(
   return options;
 }
 
+Status PadInputsToBucket(OpKernelContext* ctx,
+                         const LeadingDimensionBucket& bucket,
+                         std::vector<Tensor>* padded_inputs,
+                         std::map<int, const Tensor*>* input_ptrs) {
+  se::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  padded_inputs->reserve(bucket.arg_indices.size());
+  for (int arg_num : bucket.arg_indices) {
+    const Tensor& input = ctx->input(arg_num);
+    TensorShape padded_shape = input.shape();
+    padded_shape.set_dim(0, bucket.bucket_size);
+    Tensor& padded = padded_inputs->emplace_back();
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(input.dtype(), padded_shape, &padded));
+
+    // Padding the leading dimension of a row-major tensor appends to it.
+    const uint64_t input_bytes = input.TotalBytes();
+    const uint64_t padding_bytes = padded.TotalBytes() - input_bytes;
+    if (stream != nullptr) {
+      se::DeviceMemoryBase dst = XlaTensor::DeviceMemoryFromTensor(padded);
+      se::DeviceMemoryBase padding(
+          static_cast<char*>(dst.opaque()) + input_bytes, padding_bytes);
+      if (input_bytes > 0) {
+        TF_RETURN_IF_ERROR(stream->Memcpy(
+            &dst, XlaTensor::DeviceMemoryFromTensor(input), input_bytes));
+      }
+      if (padding_bytes > 0) {
+        TF_RETURN_IF_ERROR(stream->MemZero(&padding, padding_bytes));
+      }
+    } else {
+      char* dst = static_cast<char*>(padded.data());
+      std::memcpy(dst, input.data(), input_bytes);
+      std::memset(dst + input_bytes, 0, padding_bytes);
+    }
+    (*input_ptrs)[arg_num] = &padded;
+  }
+  return absl::OkStatus();
+}
+
+void SliceOutputsFromBucket(OpKernelContext* ctx,
+                            const LeadingDimensionBucket& bucket) {
+  for (int i = 0; i < ctx->num_outputs(); ++i) {
+    Tensor* output = ctx->mutable_output(i);
+    if (output == nullptr || output->dtype() == DT_RESOURCE ||
+        output->dims() == 0 || output->dim_size(0) != bucket.bucket_size) {
+      continue;
+    }
+    *output = output->Slice(0, bucket.size);
+  }
+}
+
 DeviceType GetDeviceType(OpKernelContext* ctx) {
   auto* device =
       tensorflow::down_cast<Device*>(ctx->device()->UnderlyingDevice());
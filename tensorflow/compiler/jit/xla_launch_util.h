@@ -24,6 +24,8 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/compiler/jit/variable_info.h"
+#include "tensorflow/compiler/jit/variable_info_util.h"
+#include "tensorflow/compiler/jit/xla_compile_util.h"
 #include "tensorflow/compiler/jit/xla_tensor.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "xla/client/local_client.h"
@@ -43,6 +45,42 @@ absl::StatusOr<std::vector<VariableInfo>> GatherVariableInfo(
     const XlaCompiler::CompilationResult& compilation_result,
     int missing_ctx_input_prefix);
 
+// Returns pointers to the snapshots in `snapshots`, keyed like them by argument
+// number. The snapshots of the variables in `updated_variables`, which must be
+// locked, are replaced by the variables themselves if they still share their
+// buffer, i.e. the variables were not assigned since the snapshot was taken.
+// Dropping the snapshot's reference to the buffer lets it be donated to the
+// computation, which then updates the variable in place.
+//
+// The snapshots of updated variables that were assigned since are still used,
+// and a reference to each is added to `stale_snapshots` so that its buffer is
+// not donated either. The caller keeps `stale_snapshots` alive until the
+// outputs of the computation are populated.
+template <typename SnapshotPtrs>
+SnapshotPtrs GetSnapshotPtrsForUpdate(
+    absl::Span<const VariableInfo> updated_variables, int num_constant_args,
+    ResourceVarsSnapshot* snapshots, std::vector<Tensor>* stale_snapshots) {
+  SnapshotPtrs snapshot_ptrs;
+  for (auto& [variable_index, variable_tensor] : *snapshots) {
+    snapshot_ptrs.emplace(variable_index, variable_tensor.has_value()
+                                              ? &variable_tensor.value()
+                                              : nullptr);
+  }
+  for (const VariableInfo& variable : updated_variables) {
+    auto it = snapshots->find(variable.index() + num_constant_args);
+    if (it == snapshots->end() || !it->second.has_value()) continue;
+    const Tensor* var_tensor = variable.var()->tensor();
+    if (var_tensor->SharesBufferWith(*it->second) &&
+        var_tensor->shape() == it->second->shape()) {
+      it->second.reset();
+      snapshot_ptrs[it->first] = var_tensor;
+    } else {
+      stale_snapshots->push_back(*it->second);
+    }
+  }
+  return snapshot_ptrs;
+}
+
 // Returns pointers to inputs stored in `ctx`.
 std::vector<const Tensor*> InputsFromContext(OpKernelContext* ctx);
 
@@ -114,6 +152,19 @@ int GetDeviceOrdinal(const DeviceBase* device);
 // Returns the device type from the OpKernelContext.
 DeviceType GetDeviceType(OpKernelContext* ctx);
 
+// Copies the inputs of `ctx` at `bucket.arg_indices` into `padded_inputs`,
+// with their leading dimension padded with zeros to `bucket.bucket_size`, and
+// points `input_ptrs` at the copies.
+Status PadInputsToBucket(OpKernelContext* ctx,
+                         const LeadingDimensionBucket& bucket,
+                         std::vector<Tensor>* padded_inputs,
+                         std::map<int, const Tensor*>* input_ptrs);
+
+// Slices the outputs of `ctx` whose leading dimension is `bucket.bucket_size`
+// back to `bucket.size`.
+void SliceOutputsFromBucket(OpKernelContext* ctx,
+                            const LeadingDimensionBucket& bucket);
+
 // Runs `executable` and populates the outputs in `ctx`. `inputs` and
 // `variables` are the input arguments to the computation, usually read from the
 // OpKernelContext, `ctx`. Requires the device-appropriate `pjrt_client` and the
@@ -16,11 +16,13 @@ limitations under the License.
 #include "tensorflow/compiler/jit/xla_launch_util.h"
 
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/compiler/jit/device_compiler.h"
 #include "tensorflow/compiler/jit/flags.h"
@@ -28,9 +30,12 @@ limitations under the License.
 #include "tensorflow/compiler/jit/variable_info.h"
 #include "tensorflow/compiler/jit/variable_info_util.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "xla/hlo/ir/hlo_input_output_alias_config.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/pjrt_common.h"
 #include "xla/pjrt/tfrt_cpu_pjrt_client.h"
+#include "xla/service/executable.h"
+#include "xla/shape_util.h"
 #include "xla/tests/literal_test_util.h"
 #include "xla/tsl/framework/allocator.h"
 #include "xla/tsl/framework/device_id_utils.h"
@@ -250,6 +255,121 @@ class PjRtExecutionUtilTest : public OpsTestBase {
     inputs_.push_back({nullptr, input});
   }
 
+  // Looks up the variable `name` in the resource manager. The caller owns the
+  // returned reference.
+  Var* LookupVariable(const string& name) {
+    ResourceMgr* rm = device_->resource_manager();
+    Var* var = nullptr;
+    TF_EXPECT_OK(rm->Lookup(rm->default_container(), name, &var));
+    return var;
+  }
+
+  // Assigns a new device tensor to `var`, which holds its only reference.
+  template <typename T>
+  void AssignVariable(Var* var, const TensorShape& shape,
+                      const gtl::ArraySlice<T> data) {
+    Tensor* host_tensor = CreateHostTensor<T>(shape, data);
+    Tensor device_tensor(device_allocator_, DataTypeToEnum<T>::v(), shape);
+    TF_EXPECT_OK(device_context_->CopyCPUTensorToDeviceSync(
+        host_tensor, device_, &device_tensor));
+    *var->tensor() = std::move(device_tensor);
+  }
+
+  // Copies `device_tensor` to a new host tensor.
+  Tensor* CopyToHost(const Tensor& device_tensor) {
+    Tensor* host_tensor = new Tensor(host_allocator_, device_tensor.dtype(),
+                                     device_tensor.shape());
+    tensors_.push_back(host_tensor);
+    TF_EXPECT_OK(device_context_->CopyDeviceTensorToCPUSync(
+        &device_tensor, "", device_, host_tensor));
+    return host_tensor;
+  }
+
+  // Sets up an AssignAddVariableOp adding {2, 2, 2} to the variable "var",
+  // which holds {1, 2, 3}, and compiles it like XlaCompile does: the variable
+  // is snapshotted in `snapshots` and its update may alias its argument.
+  void CompileVariableUpdate(ResourceVarsSnapshot* snapshots,
+                             const XlaCompiler::CompilationResult** result,
+                             xla::PjRtLoadedExecutable** executable) {
+    XlaOpRegistry::RegisterCompilationKernels();
+    TF_ASSERT_OK(
+        NodeDefBuilder("AssignAddVariableOp", "AssignAddVariableOp")
+            .Input(FakeInput(DT_RESOURCE))
+            .Input(FakeInput(DT_INT32))
+            .Attr("dtype", DT_INT32)
+            .Device("/job:localhost/replica:0/task:0/device:XLA_CPU:0")
+            .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    AddVariableInput<int32>("var", TensorShape({3}), {1, 2, 3});
+    {
+      // Drops the reference of `tensors_` to the buffer of the variable, so
+      // that it can be donated.
+      Var* var = LookupVariable("var");
+      core::ScopedUnref var_ref(var);
+      AssignVariable<int32>(var, TensorShape({3}), {1, 2, 3});
+    }
+    inputs_.push_back(
+        {nullptr, CreateDeviceTensor<int32>(TensorShape({3}), {2, 2, 2})});
+
+    CreateContext();
+
+    std::vector<const Tensor*> inputs = InputsFromContext(context_.get());
+    std::vector<int> variables_indices =
+        GetResourceVariableIndicesFromContext(context_.get());
+    std::vector<VariableInfo> variables;
+    TF_ASSERT_OK(GetVariableInfosFromInputs(context_->resource_manager(),
+                                            context_->device(), inputs,
+                                            variables_indices, &variables));
+    TF_ASSERT_OK(LockVariables(absl::MakeSpan(variables)));
+    TF_ASSERT_OK(SnapshotResourceVariables(context_.get(), variables_indices,
+                                           variables, snapshots));
+    TF_ASSERT_OK_AND_ASSIGN(
+        std::vector<XlaCompiler::Argument> args,
+        XlaComputationLaunchContext::BuildXlaCompilerArguments(
+            /*must_be_constant_idxs=*/{}, inputs, variables,
+            static_cast<Device*>(context_->device())));
+
+    XlaCompiler::CompileOptions compile_options;
+    compile_options.alias_resource_update = true;
+    CompileToExecutable(args, result, executable, compile_options);
+  }
+
+  // Runs the executable of `CompileVariableUpdate` like XlaRun does, given the
+  // `snapshots` taken at compilation. Returns whether the buffer passed for the
+  // variable may be donated to the computation.
+  absl::StatusOr<bool> RunVariableUpdate(
+      const XlaCompiler::CompilationResult& result,
+      xla::PjRtLoadedExecutable* executable, ResourceVarsSnapshot* snapshots) {
+    std::vector<const Tensor*> inputs = InputsFromContext(context_.get());
+    TF_ASSIGN_OR_RETURN(
+        std::vector<VariableInfo> updated_variables,
+        GatherVariableInfo(context_.get(), result,
+                           /*missing_ctx_input_prefix=*/0));
+    TF_RETURN_IF_ERROR(LockVariables(absl::MakeSpan(updated_variables)));
+    std::vector<Tensor> stale_snapshots;
+    const auto variable_snapshots =
+        GetSnapshotPtrsForUpdate<absl::flat_hash_map<int, const Tensor*>>(
+            updated_variables, /*num_constant_args=*/0, snapshots,
+            &stale_snapshots);
+
+    std::vector<xla::PjRtBuffer*> args;
+    absl::flat_hash_set<int> non_donatable_input_indices;
+    TF_RETURN_IF_ERROR(PreparePjRtExecutableArguments(
+        /*num_missing_prefix_ctx_inputs=*/0, result.input_mapping, inputs,
+        variable_snapshots, /*pjrt_client=*/nullptr, /*pjrt_device=*/nullptr,
+        /*use_pjrt_tensor_buffer=*/false, &args, /*owned_args=*/{},
+        &non_donatable_input_indices));
+    const int variable_arg =
+        absl::c_find(result.input_mapping, 0) - result.input_mapping.begin();
+    const bool donatable = !non_donatable_input_indices.contains(variable_arg);
+
+    TF_RETURN_IF_ERROR(RunPjRtExecutable(
+        /*num_missing_prefix_ctx_inputs=*/0, inputs, variable_snapshots,
+        updated_variables, result, pjrt_client_, executable, context_.get()));
+    return donatable;
+  }
+
  protected:
   DeviceContext* device_context_;
   Allocator* host_allocator_;
@@ -702,5 +822,193 @@ TEST_F(PjRtExecutionUtilTest, RunPjRtExecutableWithoutCtx) {
       *literal, xla::LiteralUtil::CreateR2<int32_t>({{4, 6}})));
 }
 
+TEST_F(PjRtExecutionUtilTest, RunDonatesBufferOfUnassignedVariable) {
+  ResourceVarsSnapshot snapshots;
+  const XlaCompiler::CompilationResult* result;
+  xla::PjRtLoadedExecutable* executable;
+  CompileVariableUpdate(&snapshots, &result, &executable);
+
+  TF_ASSERT_OK_AND_ASSIGN(bool donatable,
+                          RunVariableUpdate(*result, executable, &snapshots));
+  EXPECT_TRUE(donatable);
+  EXPECT_FALSE(snapshots.at(0).has_value());
+
+  Var* var = LookupVariable("var");
+  core::ScopedUnref var_ref(var);
+  Tensor* expected = CreateHostTensor<int32>(TensorShape({3}), {3, 4, 5});
+  test::ExpectTensorEqual<int32>(*expected, *CopyToHost(*var->tensor()));
+}
+
+TEST_F(PjRtExecutionUtilTest, RunUsesSnapshotOfAssignedVariable) {
+  ResourceVarsSnapshot snapshots;
+  const XlaCompiler::CompilationResult* result;
+  xla::PjRtLoadedExecutable* executable;
+  CompileVariableUpdate(&snapshots, &result, &executable);
+
+  // The variable is assigned between XlaCompile and XlaRun.
+  Var* var = LookupVariable("var");
+  core::ScopedUnref var_ref(var);
+  AssignVariable<int32>(var, TensorShape({3}), {10, 20, 30});
+
+  TF_ASSERT_OK_AND_ASSIGN(bool donatable,
+                          RunVariableUpdate(*result, executable, &snapshots));
+  EXPECT_FALSE(donatable);
+
+  // The update is computed from the snapshot, which is left intact.
+  Tensor* expected = CreateHostTensor<int32>(TensorShape({3}), {3, 4, 5});
+  test::ExpectTensorEqual<int32>(*expected, *CopyToHost(*var->tensor()));
+  ASSERT_TRUE(snapshots.at(0).has_value());
+  Tensor* expected_snapshot =
+      CreateHostTensor<int32>(TensorShape({3}), {1, 2, 3});
+  test::ExpectTensorEqual<int32>(*expected_snapshot,
+                                 *CopyToHost(*snapshots.at(0)));
+}
+
+TEST_F(PjRtExecutionUtilTest, RunKeepsBufferOfReadVariable) {
+  ResourceVarsSnapshot snapshots;
+  const XlaCompiler::CompilationResult* result;
+  xla::PjRtLoadedExecutable* executable;
+  CompileVariableUpdate(&snapshots, &result, &executable);
+
+  // A concurrent reader holds a reference to the buffer of the variable.
+  Var* var = LookupVariable("var");
+  core::ScopedUnref var_ref(var);
+  Tensor reader = *var->tensor();
+
+  TF_ASSERT_OK_AND_ASSIGN(bool donatable,
+                          RunVariableUpdate(*result, executable, &snapshots));
+  EXPECT_FALSE(donatable);
+
+  Tensor* expected = CreateHostTensor<int32>(TensorShape({3}), {3, 4, 5});
+  test::ExpectTensorEqual<int32>(*expected, *CopyToHost(*var->tensor()));
+  Tensor* expected_read = CreateHostTensor<int32>(TensorShape({3}), {1, 2, 3});
+  test::ExpectTensorEqual<int32>(*expected_read, *CopyToHost(reader));
+}
+
+// Returns the compilation result of a computation whose only argument is a
+// variable of three int32s, which it updates.
+XlaCompiler::CompilationResult VariableUpdateCompilationResult() {
+  XlaCompiler::CompilationResult result;
+  const xla::Shape shape = xla::ShapeUtil::MakeShape(xla::S32, {3});
+  result.input_mapping = {0};
+  result.xla_input_shapes = {shape};
+  result.xla_output_shape = xla::ShapeUtil::MakeTupleShape({shape});
+  XlaCompiler::ResourceUpdate update;
+  update.input_index = 0;
+  update.type = DT_INT32;
+  update.shape = TensorShape({3});
+  update.modified = true;
+  result.resource_updates = {update};
+  return result;
+}
+
+// The input populated for the variable of `VariableUpdateCompilationResult()`.
+struct VariableInput {
+  // The buffer passed to the computation.
+  const void* buffer;
+  // Whether the buffer is donated to the computation.
+  bool donated;
+};
+
+// Populates the input of `VariableUpdateCompilationResult()` from
+// `snapshot_ptrs` like XlaRun does without PjRt, the variable update aliasing
+// its argument.
+absl::StatusOr<VariableInput> PopulateVariableInput(
+    const std::map<int, const Tensor*>& snapshot_ptrs) {
+  XlaCompiler::CompilationResult result = VariableUpdateCompilationResult();
+  xla::HloInputOutputAliasConfig input_output_alias(result.xla_output_shape);
+  TF_RETURN_IF_ERROR(input_output_alias.SetUpAlias(
+      /*output_index=*/{0}, /*param_number=*/0, /*param_index=*/{}));
+
+  XlaComputationLaunchContext launch_context(
+      /*client=*/nullptr, /*xla_allocator=*/nullptr, /*device_ordinal=*/0,
+      /*allocate_xla_tensors=*/false, /*use_multiple_streams=*/false);
+  // No input is read from the context, as the only argument is a variable.
+  TF_ASSIGN_OR_RETURN(
+      std::vector<xla::ExecutionInput> execution_inputs,
+      launch_context.PopulateInputs(/*ctx=*/nullptr, &result, snapshot_ptrs,
+                                    /*missing_ctx_input_prefix=*/0,
+                                    input_output_alias));
+  xla::ExecutionInput& execution_input = execution_inputs[0];
+  VariableInput input;
+  input.buffer = execution_input.Buffer({}).AsDeviceMemoryBase().opaque();
+  input.donated = execution_input.Buffer({}).HasOwnership();
+  // Releases the buffer without freeing it, as no computation consumes it.
+  execution_input.SetUnownedIndex({});
+  return input;
+}
+
+// Holds a variable with the value {1, 2, 3}, and its snapshot taken by
+// XlaCompile.
+class VariableSnapshotTest : public ::testing::Test {
+ protected:
+  VariableSnapshotTest() : var_(new Var(DT_INT32)) {
+    *var_->tensor() = test::AsTensor<int32>({1, 2, 3});
+    var_->is_initialized = true;
+    snapshots_.emplace(0, *var_->tensor());
+  }
+
+  ~VariableSnapshotTest() override { var_->Unref(); }
+
+  // Gets the snapshot pointers like XlaRun does without PjRt, with the
+  // variable locked.
+  std::map<int, const Tensor*> GetSnapshotPtrs() {
+    std::vector<VariableInfo> updated_variables;
+    var_->Ref();
+    updated_variables.emplace_back(0, "var", var_);
+    TF_EXPECT_OK(LockVariables(absl::MakeSpan(updated_variables)));
+    return GetSnapshotPtrsForUpdate<std::map<int, const Tensor*>>(
+        updated_variables, /*num_constant_args=*/0, &snapshots_,
+        &stale_snapshots_);
+  }
+
+  Var* var_;
+  ResourceVarsSnapshot snapshots_;
+  std::vector<Tensor> stale_snapshots_;
+};
+
+TEST_F(VariableSnapshotTest, DonatesBufferOfUnassignedVariable) {
+  std::map<int, const Tensor*> snapshot_ptrs = GetSnapshotPtrs();
+  EXPECT_FALSE(snapshots_.at(0).has_value());
+  EXPECT_EQ(snapshot_ptrs.at(0), var_->tensor());
+  EXPECT_TRUE(stale_snapshots_.empty());
+
+  TF_ASSERT_OK_AND_ASSIGN(VariableInput input,
+                          PopulateVariableInput(snapshot_ptrs));
+  EXPECT_TRUE(input.donated);
+  // The computation updates the variable in place.
+  EXPECT_EQ(input.buffer, var_->tensor()->data());
+}
+
+TEST_F(VariableSnapshotTest, UsesSnapshotOfAssignedVariable) {
+  // The variable is assigned between XlaCompile and XlaRun.
+  *var_->tensor() = test::AsTensor<int32>({10, 20, 30});
+
+  std::map<int, const Tensor*> snapshot_ptrs = GetSnapshotPtrs();
+  ASSERT_TRUE(snapshots_.at(0).has_value());
+  EXPECT_EQ(snapshot_ptrs.at(0), &*snapshots_.at(0));
+  EXPECT_EQ(stale_snapshots_.size(), 1);
+
+  TF_ASSERT_OK_AND_ASSIGN(VariableInput input,
+                          PopulateVariableInput(snapshot_ptrs));
+  EXPECT_FALSE(input.donated);
+  EXPECT_EQ(input.buffer, snapshots_.at(0)->data());
+  test::ExpectTensorEqual<int32>(*snapshots_.at(0),
+                                 test::AsTensor<int32>({1, 2, 3}));
+}
+
+TEST_F(VariableSnapshotTest, KeepsBufferOfReadVariable) {
+  // A concurrent reader holds a reference to the buffer of the variable.
+  Tensor reader = *var_->tensor();
+
+  std::map<int, const Tensor*> snapshot_ptrs = GetSnapshotPtrs();
+  EXPECT_EQ(snapshot_ptrs.at(0), var_->tensor());
+
+  TF_ASSERT_OK_AND_ASSIGN(VariableInput input,
+                          PopulateVariableInput(snapshot_ptrs));
+  EXPECT_FALSE(input.donated);
+  EXPECT_EQ(input.buffer, reader.data());
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 
 #include "absl/algorithm/container.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/compiler/jit/device_executable_persistor.h"
@@ -35,6 +36,7 @@ limitations under the License.
 #include "xla/client/local_client.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/service/compiler.h"
+#include "xla/stream_executor/device_description.h"
 #include "xla/stream_executor/platform_manager.h"
 #include "xla/tsl/framework/device_type.h"
 #include "tensorflow/core/framework/function.h"
@@ -43,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/public/version.h"
 #include "tensorflow/core/tfrt/common/create_pjrt_client_util.h"
 #include "tensorflow/core/tfrt/common/global_state.h"
 #include "tensorflow/core/tfrt/common/pjrt_util.h"
@@ -59,6 +62,22 @@ using XlaDeviceExecutablePersistor =
 using PjRtDeviceExecutablePersistor =
     DeviceExecutablePersistor<xla::PjRtLoadedExecutable, xla::PjRtClient>;
 
+// Returns the configuration of the persistor of executables compiled for
+// `device_type`, short of the device version.
+template <typename Persistor>
+typename Persistor::Config GetPersistorConfig(const DeviceType& device_type) {
+  typename Persistor::Config config(
+      GetPersistentCacheDirectory(device_type),
+      GetMarkForCompilationPassFlags()->tf_xla_disable_strict_signature_checks,
+      GetMarkForCompilationPassFlags()->tf_xla_persistent_cache_prefix,
+      GetMarkForCompilationPassFlags()->tf_xla_persistent_cache_read_only);
+  config.compiler_version =
+      absl::StrCat(TF_VERSION_STRING, "-", TF_GRAPH_DEF_VERSION);
+  config.prefetch_persistent_cache =
+      GetMarkForCompilationPassFlags()->tf_xla_persistent_cache_prefetch;
+  return config;
+}
+
 XlaDeviceCompiler* CreateXlaDeviceCompiler(
     const XlaDeviceExecutablePersistor::Config& persistor_config,
     DeviceType compilation_device_type, xla::LocalClient* local_client) {
@@ -70,14 +89,14 @@ XlaDeviceCompiler* CreateXlaDeviceCompiler(
 
 PjRtDeviceCompiler* CreatePjRtDeviceCompiler(DeviceType compilation_device_type,
                                              xla::PjRtClient* pjrt_client) {
-  std::string persistent_cache_directory =
-      GetPersistentCacheDirectory(compilation_device_type);
-
-  PjRtDeviceExecutablePersistor::Config persistor_config(
-      persistent_cache_directory,
-      GetMarkForCompilationPassFlags()->tf_xla_disable_strict_signature_checks,
-      GetMarkForCompilationPassFlags()->tf_xla_persistent_cache_prefix,
-      GetMarkForCompilationPassFlags()->tf_xla_persistent_cache_read_only);
+  PjRtDeviceExecutablePersistor::Config persistor_config =
+      GetPersistorConfig<PjRtDeviceExecutablePersistor>(
+          compilation_device_type);
+  if (pjrt_client != nullptr && !pjrt_client->devices().empty()) {
+    persistor_config.device_version =
+        absl::StrCat(pjrt_client->platform_version(), "/",
+                     pjrt_client->devices().front()->device_kind());
+  }
 
   return new PjRtDeviceCompiler(
       std::make_unique<PjRtDeviceExecutablePersistor>(
@@ -217,14 +236,9 @@ Status BuildXlaDeviceCompiler(DeviceBase* device, FunctionLibraryRuntime* flr,
                                                  /*compiler_client=*/nullptr);
     return absl::OkStatus();
   }
-  std::string persistent_cache_directory =
-      GetPersistentCacheDirectory(platform_info.device_type());
-
-  XlaDeviceExecutablePersistor::Config persistor_config(
-      persistent_cache_directory,
-      GetMarkForCompilationPassFlags()->tf_xla_disable_strict_signature_checks,
-      GetMarkForCompilationPassFlags()->tf_xla_persistent_cache_prefix,
-      GetMarkForCompilationPassFlags()->tf_xla_persistent_cache_read_only);
+  XlaDeviceExecutablePersistor::Config persistor_config =
+      GetPersistorConfig<XlaDeviceExecutablePersistor>(
+          platform_info.device_type());
 
   if (platform_info.xla_device_metadata()) {
     *xla_device_compiler = CreateXlaDeviceCompiler(
@@ -289,6 +303,11 @@ Status BuildXlaDeviceCompiler(DeviceBase* device, FunctionLibraryRuntime* flr,
 
   TF_ASSIGN_OR_RETURN(
       auto client, xla::ClientLibrary::GetOrCreateLocalClient(client_options));
+  const se::DeviceDescription& device_description =
+      client->backend().default_stream_executor()->GetDeviceDescription();
+  persistor_config.device_version =
+      absl::StrCat(platform.value()->Name(), "/", device_description.name(),
+                   "/", device_description.platform_version());
 
   *xla_device_compiler = CreateXlaDeviceCompiler(
       persistor_config, compilation_device_type, client);
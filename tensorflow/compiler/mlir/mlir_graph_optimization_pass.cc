@@ -26,6 +26,7 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Arith/IR/Arith.h"  // from @llvm-project
 #include "mlir/Dialect/Func/Extensions/AllExtensions.h"  // from @llvm-project
@@ -88,6 +89,15 @@ auto* mlir_function_pass_graph_conversion_count = monitoring::Counter<1>::New(
 constexpr char kSuccess[] = "kSuccess";
 constexpr char kFailure[] = "kFailure";
 
+// Returns the thread pool shared by the MLIR contexts that graphs are imported
+// into, on which the function passes of the pipelines run in parallel. A
+// context otherwise creates a pool with a thread per core every time a graph
+// is optimized.
+static llvm::ThreadPoolInterface& GetMlirThreadPool() {
+  static auto* pool = new llvm::DefaultThreadPool();
+  return *pool;
+}
+
 static inline absl::string_view StringRefToView(llvm::StringRef ref) {
   return {ref.data(), ref.size()};
 }
@@ -217,7 +227,8 @@ Status MlirFunctionOptimizationPass::Run(
   GraphDebugInfo debug_info;
   mlir::DialectRegistry registry;
   RegisterDialects(registry);
-  mlir::MLIRContext context(registry);
+  mlir::MLIRContext context(registry, mlir::MLIRContext::Threading::DISABLED);
+  context.setThreadPool(GetMlirThreadPool());
   GraphImportConfig import_config;
   import_config.graph_as_function = true;
   import_config.control_outputs = *control_ret_node_names;
@@ -407,7 +418,8 @@ Status MlirV1CompatGraphOptimizationPass::Run(
   GraphDebugInfo debug_info;
   mlir::DialectRegistry registry;
   RegisterDialects(registry);
-  mlir::MLIRContext context(registry);
+  mlir::MLIRContext context(registry, mlir::MLIRContext::Threading::DISABLED);
+  context.setThreadPool(GetMlirThreadPool());
   GraphImportConfig import_config;
   import_config.upgrade_legacy = true;
   // Restrict functionalization to compiled nodes to avoid problems in v1
@@ -19,8 +19,10 @@ limitations under the License.
 #include <string>
 
 #include <gtest/gtest.h>
+#include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"  // from @llvm-project
 #include "mlir/IR/BuiltinOps.h"  // from @llvm-project
 #include "mlir/IR/DialectRegistry.h"  // from @llvm-project
@@ -36,6 +38,7 @@ limitations under the License.
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/resource_loader.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tsl/platform/status.h"
 
 namespace tensorflow {
@@ -162,6 +165,89 @@ TEST_F(FunctionClusterTensorflowDialectTest, LogsFallbackMode) {
             1);
 }
 
+// Returns a module with `num_functions` functions besides main, each a chain of
+// `ops_per_function` ops, so that the bridge has many functions to run its
+// function passes on.
+std::string ManyFunctionsModule(int num_functions, int ops_per_function) {
+  std::string module =
+      "module attributes {tf.versions = {bad_consumers = [], min_consumer = 0 "
+      ": i32, producer = 268 : i32}} {\n"
+      "  func.func @main() -> () {\n"
+      "    func.return\n"
+      "  }\n";
+  for (int f = 0; f < num_functions; ++f) {
+    absl::StrAppend(&module, "  func.func @f", f,
+                    "(%arg0: tensor<8x8xf32>) -> tensor<8x8xf32> {\n");
+    std::string value = "%arg0";
+    for (int i = 0; i < ops_per_function; ++i) {
+      absl::StrAppend(&module, "    %", i, " = \"tf.AddV2\"(", value,
+                      ", %arg0) : (tensor<8x8xf32>, tensor<8x8xf32>) -> "
+                      "tensor<8x8xf32>\n");
+      value = absl::StrCat("%", i);
+    }
+    absl::StrAppend(&module, "    func.return ", value,
+                    " : tensor<8x8xf32>\n  }\n");
+  }
+  absl::StrAppend(&module, "}\n");
+  return module;
+}
+
+// Runs the replicated bridge on `module_str` and returns the printed result.
+std::string RunReplicatedBridge(const std::string& module_str,
+                                bool multithreaded) {
+  DialectRegistry registry;
+  mlir::RegisterCommonToolingDialects(registry);
+  MLIRContext context(registry);
+  context.loadAllAvailableDialects();
+  context.disableMultithreading(!multithreaded);
+  OwningOpRef<ModuleOp> module =
+      mlir::parseSourceString<ModuleOp>(module_str, &context);
+  CHECK(module);
+  TF_CHECK_OK(RunFunctionTf2xlaClusteringBridge(
+      *module, /*is_supported_by_replicated_brige*/ true,
+      /*is_in_fallback_enabled_mode=*/false));
+  std::string result;
+  llvm::raw_string_ostream os(result);
+  module->print(os);
+  return result;
+}
+
+TEST(FunctionClusterTensorflowDialectMultithreadingTest,
+     OutputDoesNotDependOnThreading) {
+  const std::string module_str =
+      ManyFunctionsModule(/*num_functions=*/64, /*ops_per_function=*/16);
+  EXPECT_EQ(RunReplicatedBridge(module_str, /*multithreaded=*/false),
+            RunReplicatedBridge(module_str, /*multithreaded=*/true));
+}
+
+void BM_ReplicatedBridge(::testing::benchmark::State& state) {
+  const int num_functions = state.range(0);
+  const bool multithreaded = state.range(1);
+  DialectRegistry registry;
+  mlir::RegisterCommonToolingDialects(registry);
+  MLIRContext context(registry);
+  context.loadAllAvailableDialects();
+  context.disableMultithreading(!multithreaded);
+  const std::string module_str =
+      ManyFunctionsModule(num_functions, /*ops_per_function=*/64);
+
+  for (auto s : state) {
+    state.PauseTiming();
+    OwningOpRef<ModuleOp> module =
+        mlir::parseSourceString<ModuleOp>(module_str, &context);
+    CHECK(module);
+    state.ResumeTiming();
+    TF_CHECK_OK(RunFunctionTf2xlaClusteringBridge(
+        *module, /*is_supported_by_replicated_brige*/ true,
+        /*is_in_fallback_enabled_mode=*/false));
+  }
+}
+BENCHMARK(BM_ReplicatedBridge)
+    ->ArgPair(16, false)
+    ->ArgPair(16, true)
+    ->ArgPair(256, false)
+    ->ArgPair(256, true);
+
 }  // namespace
 }  // namespace v2
 }  // namespace tf2xla
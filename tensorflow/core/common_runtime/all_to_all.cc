@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/all_to_all.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
@@ -39,40 +40,66 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// Per-peer slices of at least twice this size are split into chunks, so that
+// transfers to different peers interleave and a large slice can use several
+// transfers at once.
+constexpr int64_t kMinChunkBytes = 1 << 20;
+constexpr int kMaxChunksPerPeer = 8;
+
+// Bounds the sends that are outstanding at a time, relative to the group size.
+constexpr int kMaxSendsInFlightPerPeer = 2;
+
+// Returns the number of chunks each per-peer slice of `slice_bytes` bytes is
+// split into. This depends only on the shape of the input, so every member of
+// the group computes the same value.
+int NumChunksPerPeer(int64_t slice_bytes) {
+  return static_cast<int>(std::clamp<int64_t>(slice_bytes / kMinChunkBytes, 1,
+                                              kMaxChunksPerPeer));
+}
+
+// Appends `num_chunks` views of consecutive elements of `slice` to `chunks`.
+void SplitIntoChunks(const Tensor& slice, int num_chunks,
+                     std::vector<Tensor>* chunks) {
+  if (num_chunks == 1) {
+    chunks->push_back(slice);
+    return;
+  }
+  const int64_t num_elements = slice.NumElements();
+  Tensor flat;
+  CHECK(flat.CopyFrom(slice, TensorShape({num_elements})));  // Crash ok.
+  const int64_t chunk_elements = (num_elements + num_chunks - 1) / num_chunks;
+  for (int c = 0; c < num_chunks; ++c) {
+    const int64_t begin = std::min(c * chunk_elements, num_elements);
+    const int64_t end = std::min(begin + chunk_elements, num_elements);
+    chunks->push_back(flat.Slice(begin, end));
+  }
+}
+
+}  // namespace
+
 AllToAll::AllToAll()
-    : col_ctx_(nullptr), col_params_(nullptr), done_(nullptr), counter_(0) {}
+    : col_ctx_(nullptr),
+      col_params_(nullptr),
+      num_chunks_(1),
+      done_(nullptr),
+      counter_(0),
+      num_pending_ops_(0) {}
 
-StatusCallback AllToAll::CheckCounterAndCallDone() {
-  return [this](const Status& s) {
-    Status final_status;
-    {
-      mutex_lock l(mu_);
-      status_.Update(s);
-      ++counter_;
-      // For all devices other than itself, there's a send and a receive. We
-      // wait until all of them complete.
-      if (counter_ < 2 * col_params_->group.group_size) {
-        return;
-      }
-      CHECK_LE(counter_, 2 * col_params_->group.group_size);  // Crash ok.
-      final_status = status_;
-    }
-    if (!final_status.ok()) {
-      done_(final_status);
+void AllToAll::OpDone(const Status& s) {
+  Status final_status;
+  {
+    mutex_lock l(mu_);
+    status_.Update(s);
+    ++counter_;
+    if (counter_ < num_pending_ops_) {
       return;
     }
-    if (col_ctx_->output->SharesBufferWith(output_buffer_)) {
-      done_(final_status);
-    } else {
-      // We are using a temp buffer. Copy to the output tensor.
-      CollectiveRemoteAccessLocal::MemCpyAsync(
-          col_ctx_->op_ctx->op_device_context(),
-          col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
-          col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
-          col_ctx_->op_ctx->output_alloc_attr(0), &output_buffer_,
-          col_ctx_->output, /*dev_to_dev_stream_index*/ 0, done_);
-    }
-  };
+    CHECK_EQ(counter_, num_pending_ops_);  // Crash ok.
+    final_status = status_;
+  }
+  done_(final_status);
 }
 
 Status AllToAll::InitializeCollectiveContext(
@@ -93,9 +120,11 @@ Status AllToAll::InitializeCollectiveContext(
 
 void AllToAll::Run(StatusCallback done) {
   done_ = std::move(done);
-  input_chunks_.reserve(col_params_->group.group_size);
-  output_chunks_.reserve(col_params_->group.group_size);
-  if (col_ctx_->input->SharesBufferWith(*col_ctx_->output)) {
+  const int group_size = col_params_->group.group_size;
+  const int default_rank = col_params_->default_rank;
+  const bool use_temp_buffer =
+      col_ctx_->input->SharesBufferWith(*col_ctx_->output);
+  if (use_temp_buffer) {
     // The input is forwarded to the output, and we need to use a temp buffer.
     output_buffer_ = Tensor(
         col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0)),
@@ -103,27 +132,133 @@ void AllToAll::Run(StatusCallback done) {
   } else {
     output_buffer_ = *col_ctx_->output;
   }
-  for (int i = 0; i < col_params_->group.group_size; ++i) {
-    input_chunks_.push_back(col_ctx_->input->SubSlice(i));
-    // Select output index based on user specified rank, if available.
-    int output_index = col_params_->group.members[i].rank;
-    output_chunks_.push_back(output_buffer_.SubSlice(output_index));
+  num_chunks_ = NumChunksPerPeer(col_ctx_->input->TotalBytes() / group_size);
+  const int num_chunks = group_size * num_chunks_;
+  input_chunks_.reserve(num_chunks);
+  output_chunks_.reserve(num_chunks);
+  for (int i = 0; i < group_size; ++i) {
+    SplitIntoChunks(col_ctx_->input->SubSlice(i), num_chunks_, &input_chunks_);
+    SplitIntoChunks(output_buffer_.SubSlice(i), num_chunks_, &output_chunks_);
+    if (use_temp_buffer) {
+      SplitIntoChunks(col_ctx_->output->SubSlice(i), num_chunks_,
+                      &final_chunks_);
+    }
+  }
+  // Every chunk is sent once and received once, and copied once more if a
+  // temp buffer is used.
+  num_pending_ops_ = num_chunks * (use_temp_buffer ? 3 : 2);
+  if (use_temp_buffer) {
+    // An output chunk can be copied once it has been received, and once the
+    // input chunk that shares its memory has been sent.
+    mutex_lock l(mu_);
+    chunk_pending_.assign(num_chunks, 2);
+  }
+  // Send the first chunk to every peer before the second chunk to any of
+  // them, starting with the next rank so that members do not all send to the
+  // same peer at once.
+  send_order_.reserve(num_chunks);
+  for (int c = 0; c < num_chunks_; ++c) {
+    for (int step = 0; step < group_size; ++step) {
+      const int target_rank = (default_rank + step) % group_size;
+      send_order_.push_back(target_rank * num_chunks_ + c);
+    }
+  }
+
+  // Issue all receives up front, so that every send can complete.
+  for (int c = 0; c < num_chunks_; ++c) {
+    for (int step = 0; step < group_size; ++step) {
+      const int src_rank = (default_rank - step + group_size) % group_size;
+      // Select output index based on user specified rank, if available.
+      const int output_index = col_params_->group.members[src_rank].rank;
+      const int chunk_index = output_index * num_chunks_ + c;
+      DispatchRecv(src_rank, default_rank, c, &output_chunks_[chunk_index],
+                   [this, chunk_index](const Status& s) {
+                     OnRecvDone(chunk_index, s);
+                   });
+    }
+  }
+  MaybeDispatchSends();
+}
+
+void AllToAll::MaybeDispatchSends() {
+  const int max_sends_in_flight =
+      kMaxSendsInFlightPerPeer * col_params_->group.group_size;
+  {
+    mutex_lock l(mu_);
+    if (dispatching_sends_) return;
+    dispatching_sends_ = true;
+  }
+  while (true) {
+    int chunk_index;
+    bool is_last_send;
+    {
+      mutex_lock l(mu_);
+      if (next_send_ == static_cast<int>(send_order_.size()) ||
+          sends_in_flight_ >= max_sends_in_flight) {
+        dispatching_sends_ = false;
+        return;
+      }
+      chunk_index = send_order_[next_send_++];
+      ++sends_in_flight_;
+      is_last_send = next_send_ == static_cast<int>(send_order_.size());
+      if (is_last_send) dispatching_sends_ = false;
+    }
+    const int target_rank = chunk_index / num_chunks_;
+    // `this` may be deleted as soon as the last send is issued.
+    DispatchSend(col_params_->default_rank, target_rank,
+                 chunk_index % num_chunks_, &input_chunks_[chunk_index],
+                 [this, chunk_index](const Status& s) {
+                   OnSendDone(chunk_index, s);
+                 });
+    if (is_last_send) return;
   }
+}
 
-  for (int i = 0; i < col_params_->group.group_size; ++i) {
-    auto default_rank = col_params_->default_rank;
-    // Issue send request from current device to all devices in group.
-    DispatchSend(default_rank, i, &input_chunks_[i], CheckCounterAndCallDone());
-    // Issue receive requests from all devices to current device.
-    DispatchRecv(i, default_rank, &output_chunks_[i],
-                 CheckCounterAndCallDone());
+void AllToAll::OnSendDone(int chunk_index, const Status& s) {
+  {
+    mutex_lock l(mu_);
+    --sends_in_flight_;
+  }
+  MaybeDispatchSends();
+  if (!final_chunks_.empty()) {
+    ReleaseChunk(chunk_index);
+  }
+  OpDone(s);
+}
+
+void AllToAll::OnRecvDone(int chunk_index, const Status& s) {
+  if (!final_chunks_.empty()) {
+    ReleaseChunk(chunk_index);
+  }
+  OpDone(s);
+}
+
+void AllToAll::ReleaseChunk(int chunk_index) {
+  bool failed;
+  {
+    mutex_lock l(mu_);
+    if (--chunk_pending_[chunk_index] > 0) return;
+    failed = !status_.ok();
+  }
+  if (failed) {
+    // There is no point in copying the chunk, but the copy still counts as
+    // completed.
+    OpDone(absl::OkStatus());
+    return;
   }
+  CollectiveRemoteAccessLocal::MemCpyAsync(
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->op_device_context(), col_ctx_->device, col_ctx_->device,
+      col_ctx_->op_ctx->input_alloc_attr(0),
+      col_ctx_->op_ctx->output_alloc_attr(0), &output_chunks_[chunk_index],
+      &final_chunks_[chunk_index], /*dev_to_dev_stream_index*/ 0,
+      [this](const Status& s) { OpDone(s); });
 }
 
-void AllToAll::DispatchSend(int src_rank, int target_rank, const Tensor* tensor,
-                            const StatusCallback& done) {
-  string send_buf_key =
-      strings::StrCat(col_ctx_->exec_key, src_rank, target_rank);
+void AllToAll::DispatchSend(int src_rank, int target_rank, int chunk,
+                            const Tensor* tensor, const StatusCallback& done) {
+  string send_buf_key = strings::StrCat(col_ctx_->exec_key, ":", src_rank, ":",
+                                        target_rank, ":", chunk);
   col_ctx_->col_exec->remote_access()->PostToPeer(
       col_params_->group.members[target_rank].device.name(),
       col_params_->group.members[target_rank].task, send_buf_key,
@@ -132,10 +267,10 @@ void AllToAll::DispatchSend(int src_rank, int target_rank, const Tensor* tensor,
       col_ctx_->op_ctx->cancellation_manager(), done);
 }
 
-void AllToAll::DispatchRecv(int src_rank, int target_rank, Tensor* tensor,
-                            const StatusCallback& done) {
-  string recv_buf_key =
-      strings::StrCat(col_ctx_->exec_key, src_rank, target_rank);
+void AllToAll::DispatchRecv(int src_rank, int target_rank, int chunk,
+                            Tensor* tensor, const StatusCallback& done) {
+  string recv_buf_key = strings::StrCat(col_ctx_->exec_key, ":", src_rank, ":",
+                                        target_rank, ":", chunk);
   col_ctx_->col_exec->remote_access()->RecvFromPeer(
       col_params_->group.members[src_rank].device.name(),
       col_params_->group.members[src_rank].task,
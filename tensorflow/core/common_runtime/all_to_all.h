@@ -45,24 +45,50 @@ class AllToAll : public CollectiveImplementationInterface {
  private:
   std::shared_ptr<CollectiveContext> col_ctx_;
   const CollectiveParams* col_params_;  // Not owned
+  // Each per-peer slice of the input and output is split into num_chunks_
+  // chunks that are transferred independently. Chunks are indexed by
+  // `slice_index * num_chunks_ + chunk`.
+  int num_chunks_;
   std::vector<Tensor> input_chunks_;
   Tensor output_buffer_;
   std::vector<Tensor> output_chunks_;
+  // If the input is forwarded to the output, chunks are received into a temp
+  // `output_buffer_` and copied to these chunks of the output once the input
+  // chunk they overwrite has been sent.
+  std::vector<Tensor> final_chunks_;
+  std::vector<int> chunk_pending_ TF_GUARDED_BY(mu_);
+  // Order in which chunks are sent. Consecutive sends go to different peers.
+  std::vector<int> send_order_;
   StatusCallback done_;
   mutex mu_;
   Status status_ TF_GUARDED_BY(mu_);
   int counter_ TF_GUARDED_BY(mu_);
+  int num_pending_ops_;
+  int next_send_ TF_GUARDED_BY(mu_) = 0;
+  int sends_in_flight_ TF_GUARDED_BY(mu_) = 0;
+  bool dispatching_sends_ TF_GUARDED_BY(mu_) = false;
 
-  void DispatchSend(int src_rank, int target_rank, const Tensor* tensor,
-                    const StatusCallback& done);
+  void DispatchSend(int src_rank, int target_rank, int chunk,
+                    const Tensor* tensor, const StatusCallback& done);
 
-  void DispatchRecv(int src_rank, int target_rank, Tensor* tensor,
+  void DispatchRecv(int src_rank, int target_rank, int chunk, Tensor* tensor,
                     const StatusCallback& done);
 
-  // Atomically increments counter_ by one for sending, one for receiving.
-  // Invokes done when counter_ reaches 2.
-  // The purpose of checking counter_ is to ensure that done_ is called once.
-  StatusCallback CheckCounterAndCallDone();
+  // Issues queued sends until the send window is full. Only one thread issues
+  // sends at a time, so that sends that complete inline do not recurse.
+  void MaybeDispatchSends();
+
+  void OnSendDone(int chunk_index, const Status& s);
+  void OnRecvDone(int chunk_index, const Status& s);
+
+  // Marks one of the two dependencies of an output chunk as satisfied when a
+  // temp buffer is used, and copies the chunk once both are.
+  void ReleaseChunk(int chunk_index);
+
+  // Records the completion of one send, receive or copy, and invokes done_
+  // once all of them have completed. This must be the last use of `this` by
+  // the caller, since done_ may delete it.
+  void OpDone(const Status& s);
 };
 
 }  // namespace tensorflow
@@ -22,7 +22,9 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace {
@@ -95,6 +97,63 @@ TEST_F(AllToAllTest, SuccessDifferentRank) {
                                   test::AsTensor<double>({9., 6., 3.}));
 }
 
+// Runs an all-to-all over `group_size` devices on tensors large enough for
+// each per-peer slice to be split into several chunks.
+void RunChunked(int group_size, bool forward_input) {
+  // 3 MiB per peer.
+  constexpr int kSliceElements = 3 * (1 << 20) / sizeof(float);
+  std::unique_ptr<CollectiveTestEnv> test_env =
+      CreateCollectiveTestEnv(/*num_workers*/ 1, group_size, DEVICE_CPU);
+  std::vector<Tensor> inputs;
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < group_size; ++i) {
+    Tensor input(DT_FLOAT, TensorShape({group_size, kSliceElements}));
+    auto matrix = input.matrix<float>();
+    for (int j = 0; j < group_size; ++j) {
+      for (int k = 0; k < kSliceElements; ++k) {
+        matrix(j, k) = i * group_size + j + k * 1e-3f;
+      }
+    }
+    inputs.push_back(input);
+    outputs.push_back(forward_input ? input : Tensor(DT_FLOAT, input.shape()));
+  }
+  std::vector<Tensor> expected;
+  for (int i = 0; i < group_size; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({group_size, kSliceElements}));
+    auto matrix = t.matrix<float>();
+    for (int j = 0; j < group_size; ++j) {
+      for (int k = 0; k < kSliceElements; ++k) {
+        matrix(j, k) = j * group_size + i + k * 1e-3f;
+      }
+    }
+    expected.push_back(t);
+  }
+  BlockingCounter counter(group_size);
+  for (int i = 0; i < group_size; ++i) {
+    SchedClosure([&, i]() {
+      auto col_params = CreateCollectiveParams(*test_env, i, "AllToAll",
+                                               ALL_TO_ALL_COLLECTIVE, DT_FLOAT,
+                                               inputs[i].shape());
+      Device* device = nullptr;
+      TF_CHECK_OK(test_env->device_mgr->LookupDevice(
+          col_params->group.members[i].device.name(), &device));
+      TF_CHECK_OK(RunCollective(test_env.get(), col_params.get(), device,
+                                &inputs[i], &outputs[i]));
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  for (int i = 0; i < group_size; ++i) {
+    test::ExpectTensorEqual<float>(outputs[i], expected[i]);
+  }
+}
+
+TEST_F(AllToAllTest, Chunked) { RunChunked(/*group_size=*/4, false); }
+
+TEST_F(AllToAllTest, ChunkedForwardedInput) {
+  RunChunked(/*group_size=*/4, true);
+}
+
 TEST_F(AllToAllTest, Failure) {
   test_env_ = CreateCollectiveTestEnv(/*num_workers*/ 1,
                                       /*num_devices_per_worker*/ 3, DEVICE_CPU);
@@ -156,5 +215,50 @@ TEST_F(AllToAllTest, WrongFirstDimensionSize) {
   counter.Wait();
 }
 
+// Exchanges `state.range(0)` floats per peer over a group of `state.range(1)`
+// CPU devices.
+void BM_AllToAll(::testing::benchmark::State& state) {
+  const int slice_elements = state.range(0);
+  const int group_size = state.range(1);
+  std::unique_ptr<CollectiveTestEnv> test_env =
+      CreateCollectiveTestEnv(/*num_workers*/ 1, group_size, DEVICE_CPU);
+  std::vector<core::RefCountPtr<CollectiveParams>> col_params(group_size);
+  std::vector<Device*> devices(group_size);
+  std::vector<Tensor> inputs;
+  std::vector<Tensor> outputs;
+  const TensorShape shape({group_size, slice_elements});
+  for (int rank = 0; rank < group_size; ++rank) {
+    col_params[rank] = CreateCollectiveParams(
+        *test_env, rank, "AllToAll", ALL_TO_ALL_COLLECTIVE, DT_FLOAT, shape);
+    TF_CHECK_OK(test_env->device_mgr->LookupDevice(
+        col_params[rank]->group.members[rank].device.name(), &devices[rank]));
+    inputs.emplace_back(DT_FLOAT, shape);
+    inputs.back().flat<float>().setConstant(1.0f);
+    outputs.emplace_back(DT_FLOAT, shape);
+  }
+  for (auto s : state) {
+    BlockingCounter counter(group_size);
+    for (int rank = 0; rank < group_size; ++rank) {
+      SchedClosure([&, rank] {
+        TF_CHECK_OK(RunCollective(test_env.get(), col_params[rank].get(),
+                                  devices[rank], &inputs[rank],
+                                  &outputs[rank]));
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+  state.SetBytesProcessed(state.iterations() * group_size * group_size *
+                          slice_elements * sizeof(float));
+}
+BENCHMARK(BM_AllToAll)
+    ->ArgPair(1 << 10, 2)
+    ->ArgPair(1 << 10, 8)
+    ->ArgPair(1 << 18, 2)
+    ->ArgPair(1 << 18, 4)
+    ->ArgPair(1 << 18, 8)
+    ->ArgPair(1 << 18, 16)
+    ->ArgPair(1 << 20, 8);
+
 }  // namespace
 }  // namespace tensorflow
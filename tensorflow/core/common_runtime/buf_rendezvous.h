@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_BUF_RENDEZVOUS_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BUF_RENDEZVOUS_H_
 
+#include <atomic>
 #include <functional>
 #include <string>
 
@@ -121,12 +122,31 @@ class BufRendezvous {
   void LogContents();
 
  protected:
+  typedef absl::flat_hash_map<string, Hook*> HookTable;
+
+  // The hook table is sharded by key hash so that concurrent collectives, which
+  // use distinct keys, do not all contend on one lock.
+  static constexpr int kNumShards = 16;
+  struct Shard {
+    mutex mu;
+    HookTable hook_table TF_GUARDED_BY(mu);
+  };
+
+  Shard& ShardForKey(const string& key);
+
+  // Returns the status the rendezvous was aborted with, or OK. Callers that
+  // insert into a shard must call this with the shard's lock held, so that
+  // StartAbort() either observes the new hook or the insertion observes the
+  // abort.
+  Status status();
+
   const uint64 step_id_;
   const DeviceMgr* const dev_mgr_;  // Not owned.
-  mutex mu_;
-  Status status_ TF_GUARDED_BY(mu_);
-  typedef absl::flat_hash_map<string, Hook*> HookTable;
-  HookTable hook_table_ TF_GUARDED_BY(mu_);
+  // Set once `status_` becomes an error. Never cleared.
+  std::atomic<bool> aborted_{false};
+  mutex status_mu_;
+  Status status_ TF_GUARDED_BY(status_mu_);
+  Shard shards_[kNumShards];
 
   void PurgeTable(const Status& s, HookTable* table);
 };
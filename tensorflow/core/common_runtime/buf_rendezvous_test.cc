@@ -21,6 +21,8 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -216,6 +218,26 @@ TEST_F(BufRendezvousTest, AbortNonEmpty) {
   EXPECT_EQ(cons_status.message(), "Falling sky detected");
 }
 
+TEST_F(BufRendezvousTest, AbortPurgesManyKeys) {
+  // Enough keys to land in every shard of the hook table.
+  constexpr int kNumKeys = 100;
+  mutex mu;
+  int num_aborted = 0;
+  for (int i = 0; i < kNumKeys; ++i) {
+    br_->ConsumeBuf(
+        strings::StrCat("key", i), *kDefaultDeviceName, kDefaultIncarnation,
+        [&mu, &num_aborted](const Status& s, BufRendezvous::Hook* h) {
+          EXPECT_FALSE(s.ok());
+          mutex_lock l(mu);
+          ++num_aborted;
+        },
+        &cm_);
+  }
+  br_->StartAbort(errors::Internal("Falling sky detected"));
+  mutex_lock l(mu);
+  EXPECT_EQ(num_aborted, kNumKeys);
+}
+
 TEST_F(BufRendezvousTest, AbortEmpty) {
   br_->StartAbort(errors::Internal("Falling sky detected"));
 }
@@ -14,16 +14,22 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/collective_util.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_split.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace collective_util {
@@ -82,6 +88,97 @@ string SubdivPermDebugString(const CollectiveParams& col_params) {
   return buf;
 }
 
+const char* const kRackHintsEnvVar = "TF_COLLECTIVE_RACK_HINTS";
+
+Status ParseRackHints(absl::string_view hints,
+                      absl::flat_hash_map<string, string>* rack_by_task) {
+  rack_by_task->clear();
+  for (absl::string_view entry :
+       absl::StrSplit(hints, ',', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> parts =
+        absl::StrSplit(entry, absl::MaxSplits('=', 1));
+    absl::string_view task =
+        parts.empty() ? "" : absl::StripAsciiWhitespace(parts[0]);
+    absl::string_view rack =
+        parts.size() < 2 ? "" : absl::StripAsciiWhitespace(parts[1]);
+    if (task.empty() || rack.empty()) {
+      return errors::InvalidArgument("Invalid rack hint \"", entry,
+                                     "\"; expected <task>=<rack>");
+    }
+    (*rack_by_task)[task] = string(rack);
+  }
+  return absl::OkStatus();
+}
+
+absl::flat_hash_map<string, string> RackHintsFromEnv() {
+  absl::flat_hash_map<string, string> rack_by_task;
+  string hints;
+  Status s = ReadStringFromEnvVar(kRackHintsEnvVar, "", &hints);
+  if (s.ok()) s = ParseRackHints(hints, &rack_by_task);
+  if (!s.ok()) {
+    LOG_FIRST_N(WARNING, 1) << "Ignoring " << kRackHintsEnvVar << ": " << s;
+    rack_by_task.clear();
+  }
+  return rack_by_task;
+}
+
+int DeviceLinkScore(const DeviceAttributes& from, const DeviceAttributes& to) {
+  int strength = 0;
+  DeviceNameUtils::ParsedName to_name;
+  if (DeviceNameUtils::ParseFullName(to.name(), &to_name) && to_name.has_id) {
+    for (const InterconnectLink& link : from.locality().links().link()) {
+      if (link.device_id() == to_name.id) {
+        strength = std::max(strength, link.strength());
+      }
+    }
+  }
+  const bool same_numa_node =
+      from.locality().numa_node() == to.locality().numa_node();
+  const bool same_bus = from.locality().bus_id() != 0 &&
+                        from.locality().bus_id() == to.locality().bus_id();
+  return strength * 4 + (same_numa_node ? 2 : 0) + (same_bus ? 1 : 0);
+}
+
+std::vector<int> OrderForTreeBroadcast(const CollGroupParams& group,
+                                       const std::vector<int>& devices,
+                                       int root) {
+  bool has_topology = false;
+  for (int d : devices) {
+    const DeviceLocality& locality = group.members[d].device.locality();
+    if (locality.links().link_size() > 0 ||
+        locality.numa_node() !=
+            group.members[devices[0]].device.locality().numa_node()) {
+      has_topology = true;
+      break;
+    }
+  }
+  if (!has_topology) return devices;
+
+  std::vector<int> order = {root};
+  order.reserve(devices.size());
+  std::vector<bool> placed(devices.size(), false);
+  for (int i = 0; i < devices.size(); ++i) {
+    if (devices[i] == root) placed[i] = true;
+  }
+  while (order.size() < devices.size()) {
+    const DeviceAttributes& parent =
+        group.members[order[(order.size() - 1) / 2]].device;
+    int best = -1;
+    int best_score = -1;
+    for (int i = 0; i < devices.size(); ++i) {
+      if (placed[i]) continue;
+      int score = DeviceLinkScore(parent, group.members[devices[i]].device);
+      if (score > best_score) {
+        best = i;
+        best_score = score;
+      }
+    }
+    placed[best] = true;
+    order.push_back(devices[best]);
+  }
+  return order;
+}
+
 SubContext::SubContext(OpKernelContext* ctx, OpKernelContext::Params* params,
                        OpKernel* op, Tensor* output, Tensor* input)
     : sub_params_(*params),
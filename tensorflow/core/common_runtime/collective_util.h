@@ -16,7 +16,10 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_UTIL_H_
 
 #include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/framework/collective.h"
@@ -32,6 +35,37 @@ Status InitializeDeviceAndLocality(const DeviceMgr* dev_mgr,
                                    DeviceLocality* device_locality);
 string SubdivPermDebugString(const CollectiveParams& col_params);
 
+// Name of the environment variable that tells collectives which rack each
+// task runs in, as a comma-separated list of "<task>=<rack>" entries, e.g.
+// "/job:worker/replica:0/task:0=r0,/job:worker/replica:0/task:1=r1".  Tasks
+// that are not listed share one unnamed rack.  Every task of a group must see
+// the same hints, otherwise the tasks disagree on the collective's schedule.
+extern const char* const kRackHintsEnvVar;
+
+// Parses rack hints in the format of `kRackHintsEnvVar` into a map from task
+// name to rack name.
+Status ParseRackHints(absl::string_view hints,
+                      absl::flat_hash_map<string, string>* rack_by_task);
+
+// Returns the rack hints of `kRackHintsEnvVar`, or an empty map if it is unset
+// or invalid.
+absl::flat_hash_map<string, string> RackHintsFromEnv();
+
+// Returns how closely `from` is connected to `to` within a host; higher is
+// closer.  The strength of an interconnect link (e.g. NVLink) from `from` to
+// `to` dominates, followed by sharing a NUMA node, then sharing a bus.
+int DeviceLinkScore(const DeviceAttributes& from, const DeviceAttributes& to);
+
+// Orders `devices`, indices into `group.members` that include `root`, for a
+// binary tree broadcast from `root`: position 0 holds `root` and the device at
+// position p receives from the device at position (p - 1) / 2.  Positions are
+// filled greedily with the remaining device that has the highest
+// `DeviceLinkScore` from its parent.  If the devices report neither
+// interconnect links nor different NUMA nodes, returns `devices` unchanged.
+std::vector<int> OrderForTreeBroadcast(const CollGroupParams& group,
+                                       const std::vector<int>& devices,
+                                       int root);
+
 // Used for executing a sub-operation, e.g. a merge_op instance, with
 // an OpKernelContext based on the one passed into this Op.
 class SubContext {
@@ -0,0 +1,206 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_wire_format.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/ascii.h"
+#include "tensorflow/core/framework/numeric_types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+const char* const kRingReducerWireFormatEnvVar = "TF_RING_REDUCER_WIRE_FORMAT";
+
+namespace {
+
+template <typename T>
+void EncodeValues(const float* src, int64_t n, float* residual, T* dst) {
+  if (residual == nullptr) {
+    for (int64_t i = 0; i < n; ++i) {
+      dst[i] = static_cast<T>(src[i]);
+    }
+    return;
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    const float value = src[i] + residual[i];
+    const T rounded = static_cast<T>(value);
+    dst[i] = rounded;
+    residual[i] = value - static_cast<float>(rounded);
+  }
+}
+
+template <typename T>
+void DecodeValues(const T* src, int64_t n, float* dst) {
+  for (int64_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<float>(src[i]);
+  }
+}
+
+}  // namespace
+
+Status ParseCollectiveWireFormat(absl::string_view name,
+                                 CollectiveWireFormat* format) {
+  const std::string lower = absl::AsciiStrToLower(name);
+  if (lower.empty() || lower == "none") {
+    *format = CollectiveWireFormat::kNone;
+  } else if (lower == "bf16" || lower == "bfloat16") {
+    *format = CollectiveWireFormat::kBfloat16;
+  } else if (lower == "fp16" || lower == "half") {
+    *format = CollectiveWireFormat::kHalf;
+  } else {
+    return errors::InvalidArgument("Unknown collective wire format \"", name,
+                                   "\"; expected one of none, bf16, fp16");
+  }
+  return absl::OkStatus();
+}
+
+CollectiveWireFormat RingReducerWireFormatFromEnv() {
+  std::string name;
+  Status s = ReadStringFromEnvVar(kRingReducerWireFormatEnvVar, "", &name);
+  CollectiveWireFormat format = CollectiveWireFormat::kNone;
+  if (s.ok()) s = ParseCollectiveWireFormat(name, &format);
+  if (!s.ok()) {
+    LOG_FIRST_N(WARNING, 1) << "Ignoring " << kRingReducerWireFormatEnvVar
+                            << ": " << s;
+    return CollectiveWireFormat::kNone;
+  }
+  return format;
+}
+
+DataType CollectiveWireDataType(CollectiveWireFormat format) {
+  switch (format) {
+    case CollectiveWireFormat::kBfloat16:
+      return DT_BFLOAT16;
+    case CollectiveWireFormat::kHalf:
+      return DT_HALF;
+    case CollectiveWireFormat::kNone:
+      break;
+  }
+  LOG(FATAL) << "No wire dtype for CollectiveWireFormat::kNone";
+  return DT_INVALID;
+}
+
+Status EncodeForWire(CollectiveWireFormat format, const Tensor& src,
+                     float* residual, Tensor* dst) {
+  if (format == CollectiveWireFormat::kNone) {
+    return errors::InvalidArgument("EncodeForWire requires a lossy format");
+  }
+  if (src.dtype() != DT_FLOAT ||
+      dst->dtype() != CollectiveWireDataType(format)) {
+    return errors::InvalidArgument(
+        "Cannot encode ", DataTypeString(src.dtype()), " as ",
+        DataTypeString(dst->dtype()), " for the collective wire format");
+  }
+  if (src.NumElements() != dst->NumElements()) {
+    return errors::InvalidArgument("Wire tensor has ", dst->NumElements(),
+                                   " elements, expected ", src.NumElements());
+  }
+  const float* src_values = src.flat<float>().data();
+  const int64_t n = src.NumElements();
+  if (format == CollectiveWireFormat::kBfloat16) {
+    EncodeValues(src_values, n, residual, dst->flat<bfloat16>().data());
+  } else {
+    EncodeValues(src_values, n, residual, dst->flat<Eigen::half>().data());
+  }
+  return absl::OkStatus();
+}
+
+Status DecodeFromWire(const Tensor& src, Tensor* dst) {
+  if (dst->dtype() != DT_FLOAT) {
+    return errors::InvalidArgument("Cannot decode the collective wire format "
+                                   "into ",
+                                   DataTypeString(dst->dtype()));
+  }
+  if (src.NumElements() != dst->NumElements()) {
+    return errors::InvalidArgument("Wire tensor has ", src.NumElements(),
+                                   " elements, expected ", dst->NumElements());
+  }
+  float* dst_values = dst->flat<float>().data();
+  const int64_t n = src.NumElements();
+  switch (src.dtype()) {
+    case DT_BFLOAT16:
+      DecodeValues(src.flat<bfloat16>().data(), n, dst_values);
+      break;
+    case DT_HALF:
+      DecodeValues(src.flat<Eigen::half>().data(), n, dst_values);
+      break;
+    default:
+      return errors::InvalidArgument("Unexpected collective wire dtype ",
+                                     DataTypeString(src.dtype()));
+  }
+  return absl::OkStatus();
+}
+
+CollectiveWireResidualStore::CollectiveWireResidualStore(int64_t max_bytes)
+    : max_bytes_(max_bytes) {}
+
+CollectiveWireResidualStore* CollectiveWireResidualStore::Global() {
+  static CollectiveWireResidualStore* store = new CollectiveWireResidualStore;
+  return store;
+}
+
+std::shared_ptr<std::vector<float>> CollectiveWireResidualStore::Get(
+    const std::string& key, int64_t size) {
+  mutex_lock l(mu_);
+  auto it = residuals_.find(key);
+  if (it != residuals_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+    if (it->second.residual->size() == size) return it->second.residual;
+    num_bytes_ -= it->second.residual->size() * sizeof(float);
+  } else {
+    lru_.push_front(key);
+    it = residuals_.emplace(key, Entry{nullptr, lru_.begin()}).first;
+  }
+  // A residual that is still held by another caller is left to it.
+  it->second.residual = std::make_shared<std::vector<float>>(size, 0.0f);
+  num_bytes_ += size * sizeof(float);
+  std::shared_ptr<std::vector<float>> residual = it->second.residual;
+  EvictLocked();
+  return residual;
+}
+
+void CollectiveWireResidualStore::EvictLocked() {
+  while (num_bytes_ > max_bytes_ && !lru_.empty()) {
+    auto it = residuals_.find(lru_.back());
+    num_bytes_ -= it->second.residual->size() * sizeof(float);
+    residuals_.erase(it);
+    lru_.pop_back();
+  }
+}
+
+void CollectiveWireResidualStore::Clear() {
+  mutex_lock l(mu_);
+  residuals_.clear();
+  lru_.clear();
+  num_bytes_ = 0;
+}
+
+int64_t CollectiveWireResidualStore::num_residuals() {
+  mutex_lock l(mu_);
+  return residuals_.size();
+}
+
+int64_t CollectiveWireResidualStore::num_bytes() {
+  mutex_lock l(mu_);
+  return num_bytes_;
+}
+
+}  // namespace tensorflow
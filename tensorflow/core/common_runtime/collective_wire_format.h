@@ -0,0 +1,126 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_WIRE_FORMAT_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_WIRE_FORMAT_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Lossy encodings that a collective may use to move DT_FLOAT values between
+// tasks. Every task of a group must use the same format, otherwise the
+// exchanged buffers do not match in size and the collective fails.
+enum class CollectiveWireFormat {
+  kNone = 0,  // Full precision.
+  kBfloat16,  // Values are rounded to bfloat16 on the wire.
+  kHalf,      // Values are rounded to IEEE half on the wire. Values beyond
+              // the half range overflow to infinity.
+};
+
+// Name of the environment variable that selects the wire format used by
+// RingReducer for groups that span more than one task. Accepted values are
+// "none" (the default), "bf16" and "fp16".
+extern const char* const kRingReducerWireFormatEnvVar;
+
+// Parses a wire format name as accepted by `kRingReducerWireFormatEnvVar`.
+// The empty string parses as `kNone`.
+Status ParseCollectiveWireFormat(absl::string_view name,
+                                 CollectiveWireFormat* format);
+
+// Returns the wire format selected by `kRingReducerWireFormatEnvVar`, or
+// `kNone` if it is unset or invalid.
+CollectiveWireFormat RingReducerWireFormatFromEnv();
+
+// Returns the dtype of tensors holding values encoded with `format`.
+//
+// REQUIRES: format != CollectiveWireFormat::kNone
+DataType CollectiveWireDataType(CollectiveWireFormat format);
+
+// Encodes the DT_FLOAT tensor `src` into `dst`, which must have the dtype
+// `CollectiveWireDataType(format)` and the same number of elements.
+//
+// If `residual` is not null it must point to `src.NumElements()` floats and
+// is used for error feedback: the residual is added to `src` before rounding
+// and is then replaced by the rounding error, so that the error of one step is
+// carried into the next instead of being lost.
+Status EncodeForWire(CollectiveWireFormat format, const Tensor& src,
+                     float* residual, Tensor* dst);
+
+// Decodes the wire tensor `src` into the DT_FLOAT tensor `dst`, which must
+// have the same number of elements.
+Status DecodeFromWire(const Tensor& src, Tensor* dst);
+
+// Holds the error feedback residuals of collectives across steps. Residuals
+// are keyed by a caller-chosen string that identifies the instance, device
+// and field of the collective. Once the residuals exceed `max_bytes` in total,
+// the least recently used ones are dropped; their error is lost, which only
+// costs accuracy.
+//
+// This class is thread-safe, but a residual returned by `Get()` must only be
+// used by one thread at a time.
+class CollectiveWireResidualStore {
+ public:
+  static constexpr int64_t kDefaultMaxBytes = 256 << 20;
+
+  explicit CollectiveWireResidualStore(int64_t max_bytes = kDefaultMaxBytes);
+
+  static CollectiveWireResidualStore* Global();
+
+  // Returns the residual for `key`, holding `size` floats. The residual is
+  // zeroed when it is first created or when `size` changes. It stays alive as
+  // long as the caller holds it, even if it is dropped from the store.
+  std::shared_ptr<std::vector<float>> Get(const std::string& key,
+                                          int64_t size);
+
+  // Drops all residuals.
+  void Clear();
+
+  int64_t num_residuals();
+  int64_t num_bytes();
+
+ private:
+  struct Entry {
+    std::shared_ptr<std::vector<float>> residual;
+    // Position of the key in `lru_`.
+    std::list<std::string>::iterator lru_position;
+  };
+
+  // Drops the least recently used residuals until at most `max_bytes_` are
+  // held.
+  void EvictLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64_t max_bytes_;
+  mutex mu_;
+  absl::flat_hash_map<std::string, Entry> residuals_ TF_GUARDED_BY(mu_);
+  // Keys of `residuals_`, most recently used first.
+  std::list<std::string> lru_ TF_GUARDED_BY(mu_);
+  int64_t num_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_WIRE_FORMAT_H_
@@ -0,0 +1,121 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_wire_format.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(CollectiveWireFormatTest, Parse) {
+  CollectiveWireFormat format;
+  TF_EXPECT_OK(ParseCollectiveWireFormat("", &format));
+  EXPECT_EQ(format, CollectiveWireFormat::kNone);
+  TF_EXPECT_OK(ParseCollectiveWireFormat("BF16", &format));
+  EXPECT_EQ(format, CollectiveWireFormat::kBfloat16);
+  TF_EXPECT_OK(ParseCollectiveWireFormat("fp16", &format));
+  EXPECT_EQ(format, CollectiveWireFormat::kHalf);
+  EXPECT_FALSE(ParseCollectiveWireFormat("int8", &format).ok());
+}
+
+TEST(CollectiveWireFormatTest, RoundTripIsExactForRepresentableValues) {
+  for (CollectiveWireFormat format :
+       {CollectiveWireFormat::kBfloat16, CollectiveWireFormat::kHalf}) {
+    Tensor src = test::AsTensor<float>({0.0f, 1.0f, -2.5f, 0.375f, 96.0f});
+    Tensor wire(CollectiveWireDataType(format), src.shape());
+    TF_ASSERT_OK(EncodeForWire(format, src, /*residual=*/nullptr, &wire));
+    Tensor dst(DT_FLOAT, src.shape());
+    TF_ASSERT_OK(DecodeFromWire(wire, &dst));
+    test::ExpectTensorEqual<float>(dst, src);
+  }
+}
+
+TEST(CollectiveWireFormatTest, ErrorFeedbackCarriesRoundingError) {
+  // 1 + 2^-10 is not representable in bfloat16, which rounds it down to 1.
+  const float value = 1.0f + 1.0f / 1024;
+  Tensor src = test::AsTensor<float>({value});
+  Tensor wire(DT_BFLOAT16, src.shape());
+  Tensor dst(DT_FLOAT, src.shape());
+  constexpr int kSteps = 256;
+  float residual = 0.0f;
+  double plain_sum = 0;
+  double feedback_sum = 0;
+  for (int i = 0; i < kSteps; ++i) {
+    TF_ASSERT_OK(EncodeForWire(CollectiveWireFormat::kBfloat16, src,
+                               /*residual=*/nullptr, &wire));
+    TF_ASSERT_OK(DecodeFromWire(wire, &dst));
+    plain_sum += dst.flat<float>()(0);
+    TF_ASSERT_OK(
+        EncodeForWire(CollectiveWireFormat::kBfloat16, src, &residual, &wire));
+    TF_ASSERT_OK(DecodeFromWire(wire, &dst));
+    feedback_sum += dst.flat<float>()(0);
+  }
+  const double expected = static_cast<double>(value) * kSteps;
+  EXPECT_NEAR(plain_sum, kSteps, 1e-6);
+  EXPECT_LT(std::abs(feedback_sum - expected), 0.01);
+}
+
+TEST(CollectiveWireFormatTest, RejectsMismatchedTensors) {
+  Tensor src = test::AsTensor<float>({1.0f, 2.0f});
+  Tensor wrong_size(DT_BFLOAT16, TensorShape({3}));
+  EXPECT_FALSE(EncodeForWire(CollectiveWireFormat::kBfloat16, src, nullptr,
+                             &wrong_size)
+                   .ok());
+  Tensor wrong_dtype(DT_HALF, TensorShape({2}));
+  EXPECT_FALSE(EncodeForWire(CollectiveWireFormat::kBfloat16, src, nullptr,
+                             &wrong_dtype)
+                   .ok());
+  Tensor doubles(DT_DOUBLE, TensorShape({2}));
+  EXPECT_FALSE(DecodeFromWire(wrong_dtype, &doubles).ok());
+}
+
+TEST(CollectiveWireResidualStoreTest, ResetsWhenSizeChanges) {
+  CollectiveWireResidualStore store;
+  (*store.Get("a", 2))[0] = 1.0f;
+  EXPECT_EQ((*store.Get("a", 2))[0], 1.0f);
+  EXPECT_EQ((*store.Get("a", 3))[0], 0.0f);
+  store.Get("b", 1);
+  EXPECT_EQ(store.num_residuals(), 2);
+  EXPECT_EQ(store.num_bytes(), 4 * sizeof(float));
+  store.Clear();
+  EXPECT_EQ(store.num_residuals(), 0);
+  EXPECT_EQ(store.num_bytes(), 0);
+}
+
+TEST(CollectiveWireResidualStoreTest, EvictsLeastRecentlyUsed) {
+  CollectiveWireResidualStore store(/*max_bytes=*/2 * sizeof(float));
+  (*store.Get("a", 1))[0] = 1.0f;
+  std::shared_ptr<std::vector<float>> b = store.Get("b", 1);
+  (*b)[0] = 2.0f;
+  EXPECT_EQ((*store.Get("a", 1))[0], 1.0f);
+
+  store.Get("c", 1);
+  EXPECT_EQ(store.num_residuals(), 2);
+  EXPECT_EQ(store.num_bytes(), 2 * sizeof(float));
+  EXPECT_EQ((*store.Get("a", 1))[0], 1.0f);
+  // "b" was dropped, but stays valid for the caller still holding it.
+  EXPECT_EQ((*b)[0], 2.0f);
+  EXPECT_EQ((*store.Get("b", 1))[0], 0.0f);
+}
+
+}  // namespace
+}  // namespace tensorflow
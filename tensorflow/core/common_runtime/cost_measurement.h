@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COST_MEASUREMENT_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_COST_MEASUREMENT_H_
 
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 
@@ -38,6 +41,13 @@ class CostMeasurement {
   virtual absl::Duration GetTotalCost() = 0;
 
   virtual absl::string_view GetCostType() const = 0;
+
+  // Returns the breakdown of the total cost by op name, for measurements that
+  // can attribute it. The costs may not sum up to the total cost, e.g. if
+  // some of it was spent outside of ops.
+  virtual absl::flat_hash_map<std::string, absl::Duration> GetOpCosts() {
+    return {};
+  }
 };
 
 }  // namespace tensorflow
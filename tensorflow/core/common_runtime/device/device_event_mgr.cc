@@ -15,10 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -100,6 +105,8 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
       polling_active_delay_usecs_(gpu_options.polling_active_delay_usecs()
                                       ? gpu_options.polling_active_delay_usecs()
                                       : 10),
+      polling_spin_usecs_(
+          gpu_options.experimental().event_polling_spin_usecs()),
       threadpool_(Env::Default(), "Device_Event_Manager", kNumThreads) {
   device_event_mgr::InitThreadpoolLabels(&threadpool_);
   StartPollingLoop();
@@ -108,9 +115,14 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
 EventMgr::~EventMgr() {
   StopPollingLoop();
 
+  mutex_lock l(mu_);
+  // Host callbacks refer to this object.
+  while (!armed_streams_.empty()) {
+    host_callbacks_done_.wait(l);
+  }
   for (auto& [stream, stream_callbacks] : callbacks_) {
-    for (auto& [event, callback] : stream_callbacks) {
-      threadpool_.Schedule(std::move(callback));
+    for (PendingCallback& callback : stream_callbacks) {
+      threadpool_.Schedule(std::move(callback.func));
     }
   }
   // The threadpool's destructor will block waiting for all outstanding
@@ -143,10 +155,16 @@ void EventMgr::StopPollingLoop() {
 //
 // While one or more events is outstanding, poll for completed events.  When no
 // events are outstanding, we sleep until one is enqueued.
+//
+// If polling_spin_usecs_ > 0, polls without sleeping for that long after an
+// event was queued or completed. After that, waits until a host callback on a
+// stream with pending events runs, a new event is queued, or
+// polling_active_delay_usecs_ elapse.
 void EventMgr::PollLoop() {
   ToFreeVector to_free;
   while (true) {
     bool events_still_pending;
+    bool spinning = false;
     {
       mutex_lock l(mu_);
       if (stop_polling_) {
@@ -157,17 +175,56 @@ void EventMgr::PollLoop() {
       }
       PollEvents(nullptr, &to_free);  // poll all streams
       events_still_pending = !callbacks_.empty();
+      if (events_still_pending && polling_spin_usecs_ > 0) {
+        const uint64 now = Env::Default()->NowMicros();
+        if (!to_free.empty()) last_activity_usecs_ = now;
+        spinning = now - last_activity_usecs_ <
+                   static_cast<uint64>(polling_spin_usecs_);
+      }
     }
     FreeMemory(to_free);
-    to_free.clear();
 
-    if (events_still_pending) {
+    if (!events_still_pending || spinning) continue;
+    if (polling_spin_usecs_ == 0) {
       Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
+      continue;
     }
+    ArmHostCallbacks();
+    mutex_lock l(mu_);
+    if (!wake_poller_ && !stop_polling_) {
+      events_pending_.wait_for(
+          l, std::chrono::microseconds(polling_active_delay_usecs_));
+    }
+    wake_poller_ = false;
   }
   polling_stopped_->Notify();
 }
 
+void EventMgr::ArmHostCallbacks() {
+  std::vector<se::Stream*> streams;
+  {
+    mutex_lock l(mu_);
+    for (const auto& [stream, stream_callbacks] : callbacks_) {
+      if (armed_streams_.insert(stream).second) streams.push_back(stream);
+    }
+  }
+  // Enqueued without holding `mu_`, in case the callback runs right away.
+  for (se::Stream* stream : streams) {
+    auto wake_poller = [this, stream]() {
+      mutex_lock l(mu_);
+      armed_streams_.erase(stream);
+      wake_poller_ = true;
+      events_pending_.notify_all();
+      if (armed_streams_.empty()) host_callbacks_done_.notify_all();
+    };
+    absl::Status status = stream->DoHostCallback(wake_poller);
+    if (!status.ok()) {
+      VLOG(1) << "Failed to enqueue an EventMgr host callback: " << status;
+      wake_poller();
+    }
+  }
+}
+
 void EventMgr::EnqueueCallback(se::Stream* stream, std::function<void()> func) {
   VLOG(2) << "EnqueueCallback with one or more callbacks pending on "
           << callbacks_.size() << " streams and " << free_events_.size()
@@ -183,10 +240,16 @@ void EventMgr::EnqueueCallback(se::Stream* stream, std::function<void()> func) {
   stream->RecordEvent(e.get()).IgnoreError();
 
   bool was_empty = callbacks_.empty();
-  callbacks_[stream].push_back({std::move(e), std::move(func)});
+  const uint64 now = Env::Default()->NowMicros();
+  callbacks_[stream].push_back({std::move(e), std::move(func), now});
 
   // Wake up the polling thread if it was sleeping.
-  if (was_empty) {
+  if (polling_spin_usecs_ > 0) {
+    // Spins again for the new event.
+    last_activity_usecs_ = now;
+    wake_poller_ = true;
+    events_pending_.notify_all();
+  } else if (was_empty) {
     events_pending_.notify_all();
   }
 }
@@ -204,6 +267,9 @@ void EventMgr::PollEvents(se::Stream* stream,
           << callbacks_.size() << " streams and " << free_events_.size()
           << " unused event objects.";
 
+  // Read once something completed, for the completion latency metric.
+  uint64 now = 0;
+
   // Polls the events for one stream.
   //
   // `stream_it` should be an iterator into callbacks_.  Modifies stream_it so
@@ -214,7 +280,7 @@ void EventMgr::PollEvents(se::Stream* stream,
 
         auto it = stream_callbacks.begin();
         while (it != stream_callbacks.end()) {
-          auto& [event, callback] = *it;
+          auto& [event, callback, queued_usecs] = *it;
 
           se::Event::Status s = event->PollForStatus();
           bool keep_looping = true;
@@ -231,6 +297,9 @@ void EventMgr::PollEvents(se::Stream* stream,
               keep_looping = false;
               break;
             case se::Event::Status::kComplete:
+              if (now == 0) now = Env::Default()->NowMicros();
+              metrics::UpdateDeviceEventCompletionLatency(
+                  now > queued_usecs ? now - queued_usecs : 0);
               free_events_.push_back(std::move(event));
               to_free->push_back({nullptr, std::move(callback)});
               // std::deque::erase() does invalidate iterators, so we can't
@@ -23,6 +23,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -84,6 +85,9 @@ class EventMgr {
 
   se::StreamExecutor* const exec_;
   const int32 polling_active_delay_usecs_;
+  // If > 0, the polling loop busy-polls for this long after the last event
+  // was queued or completed. See GPUOptions.Experimental.
+  const int32 polling_spin_usecs_;
   mutex mu_;
   condition_variable events_pending_ TF_GUARDED_BY(mu_);
 
@@ -96,11 +100,20 @@ class EventMgr {
 
   EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options);
 
-  void FreeMemory(const ToFreeVector& to_free) {
-    for (const auto& iu : to_free) {
-      // The function must be called in another thread.
-      if (iu.func != nullptr) threadpool_.Schedule(iu.func);
+  // Runs the callbacks of `to_free`, which it leaves empty, in another thread.
+  // Callbacks that completed together run in order in one closure, to save
+  // the scheduling of each.
+  void FreeMemory(ToFreeVector& to_free) {
+    if (to_free.size() == 1) {
+      if (to_free[0].func != nullptr) threadpool_.Schedule(to_free[0].func);
+    } else if (!to_free.empty()) {
+      threadpool_.Schedule([to_free = std::move(to_free)]() {
+        for (const auto& iu : to_free) {
+          if (iu.func != nullptr) iu.func();
+        }
+      });
     }
+    to_free.clear();
   }
 
   // Set up `func` to be called once `stream` completes all its outstanding
@@ -124,16 +137,33 @@ class EventMgr {
   void StartPollingLoop();
   void StopPollingLoop();
 
+  // Enqueues a host callback that wakes up the polling loop on each stream
+  // with pending callbacks that does not have one yet.
+  void ArmHostCallbacks();
+
   // A stack of unused events
   std::vector<std::unique_ptr<se::Event>> free_events_ TF_GUARDED_BY(mu_);
 
+  struct PendingCallback {
+    std::unique_ptr<se::Event> event;
+    std::function<void()> func;
+    // When the callback was queued, for the completion latency metric.
+    uint64 queued_usecs;
+  };
+
   // Callbacks waiting on their events to complete.
-  absl::flat_hash_map<
-      se::Stream*,
-      std::deque<std::pair<std::unique_ptr<se::Event>, std::function<void()>>>>
-      callbacks_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<se::Stream*, std::deque<PendingCallback>> callbacks_
+      TF_GUARDED_BY(mu_);
 
   bool stop_polling_ TF_GUARDED_BY(mu_);
+
+  // With `polling_spin_usecs_` > 0: when an event was last queued or found
+  // completed, whether the polling loop should stop waiting, and the streams
+  // with a pending host callback to wake it up.
+  uint64 last_activity_usecs_ TF_GUARDED_BY(mu_) = 0;
+  bool wake_poller_ TF_GUARDED_BY(mu_) = false;
+  absl::flat_hash_set<se::Stream*> armed_streams_ TF_GUARDED_BY(mu_);
+  condition_variable host_callbacks_done_ TF_GUARDED_BY(mu_);
   std::unique_ptr<Notification> polling_stopped_;
 
   // The main PollLoop for the event manager runs in this threadpool.
@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
 
 #include <atomic>
+#include <vector>
 
 #include "xla/stream_executor/gpu/gpu_init.h"
 #include "xla/tsl/framework/device_id.h"
@@ -29,6 +30,9 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -138,6 +142,39 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+// Tests that callbacks run, in order, when the polling loop spins and then
+// waits for host callbacks.
+TEST(EventMgr, SpinThenWaitForHostCallbacks) {
+  auto stream_exec = se::GPUMachineManager()->ExecutorForDevice(0).value();
+  GPUOptions gpu_options;
+  gpu_options.mutable_experimental()->set_event_polling_spin_usecs(100);
+  // Long enough that the test times out if host callbacks do not wake up the
+  // polling loop.
+  gpu_options.set_polling_active_delay_usecs(1000000000);
+  TEST_EventMgr em(stream_exec, gpu_options);
+  TF_ASSERT_OK_AND_ASSIGN(auto stream, stream_exec->CreateStream());
+
+  for (int round = 0; round < 3; ++round) {
+    // Outlasts the spinning, so that the polling loop waits.
+    TF_ASSERT_OK(stream->DoHostCallback(
+        [] { Env::Default()->SleepForMicroseconds(10000); }));
+    mutex mu;
+    std::vector<int> order;
+    BlockingCounter done(10);
+    for (int i = 0; i < 10; ++i) {
+      em.ThenExecute(stream.get(), [&mu, &order, &done, i]() {
+        {
+          mutex_lock l(mu);
+          order.push_back(i);
+        }
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+    EXPECT_THAT(order, ::testing::ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+  }
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -39,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
+#include "tensorflow/core/common_runtime/sampled_step_stats_collector.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
@@ -63,6 +65,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/core/threadpool_options.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -510,7 +513,8 @@ Status DirectSession::RunInternal(
     int64_t step_id, const RunOptions& run_options,
     CallFrameInterface* call_frame, ExecutorsAndKeys* executors_and_keys,
     RunMetadata* run_metadata,
-    const thread::ThreadPoolOptions& threadpool_options) {
+    const thread::ThreadPoolOptions& threadpool_options,
+    CallState* call_state) {
   const uint64 start_time_usecs = options_.env->NowMicros();
   const int64_t executor_step_count =
       executors_and_keys->step_count.fetch_add(1);
@@ -696,6 +700,20 @@ Status DirectSession::RunInternal(
     args.stats_collector = run_state.collector.get();
   }
 
+  // Steps that are traced in full are not sampled. Each sampled step gets its
+  // own collector, so that concurrent steps do not mix their records.
+  std::unique_ptr<SampledStepStatsCollector> sampled_stats_collector;
+  if (args.stats_collector == nullptr &&
+      executors_and_keys->stats_publisher != nullptr &&
+      executor_step_count %
+              options_.config.experimental().sampled_trace_step_period() ==
+          0) {
+    sampled_stats_collector = std::make_unique<SampledStepStatsCollector>(
+        SampledStepStatsCollector::kDefaultCapacity,
+        options_.config.experimental().sampled_trace_node_period());
+    args.stats_collector = sampled_stats_collector.get();
+  }
+
   std::unique_ptr<DeviceProfilerSession> device_profiler_session;
   if (run_options.trace_level() >= RunOptions::HARDWARE_TRACE) {
     device_profiler_session = DeviceProfilerSession::Create();
@@ -736,12 +754,25 @@ Status DirectSession::RunInternal(
       };
 
   if (can_execute_synchronously) {
-    PrivateIntraProcessRendezvous rendezvous(device_mgr_.get());
-    args.rendezvous = &rendezvous;
+    std::optional<PrivateIntraProcessRendezvous> step_rendezvous;
+    if (call_state != nullptr) {
+      if (call_state->rendezvous == nullptr) {
+        call_state->rendezvous =
+            std::make_unique<PrivateIntraProcessRendezvous>(device_mgr_.get());
+      }
+      args.rendezvous = call_state->rendezvous.get();
+    } else {
+      step_rendezvous.emplace(device_mgr_.get());
+      args.rendezvous = &*step_rendezvous;
+    }
 
     const auto& item = executors_and_keys->items[0];
     set_threadpool_args_for_item(item, &args);
     run_status = item.executor->Run(args);
+    if (call_state != nullptr && !run_status.ok()) {
+      // A failed step may have aborted the rendezvous or left items in it.
+      call_state->rendezvous.reset();
+    }
   } else {
     core::RefCountPtr<RefCountedIntraProcessRendezvous> rendezvous(
         new RefCountedIntraProcessRendezvous(device_mgr_.get()));
@@ -795,6 +826,12 @@ Status DirectSession::RunInternal(
     run_state.collector->Finalize();
   }
 
+  if (sampled_stats_collector) {
+    StepStats step_stats;
+    sampled_stats_collector->Drain(&step_stats);
+    executors_and_keys->stats_publisher->PublishStatsProto(step_stats);
+  }
+
   // Build and return the cost model as instructed.
   if (update_cost_model) {
     // Build the cost model
@@ -1335,6 +1372,11 @@ Status DirectSession::CreateExecutors(
 
   ek->callable_options = callable_options;
 
+  if (options_.config.experimental().sampled_trace_step_period() > 0) {
+    ek->stats_publisher = StatsPublisherInterface::GetStatsPublisherFactory()(
+        session_handle_, options, options_);
+  }
+
   std::unordered_map<string, std::unique_ptr<Graph>> graphs;
   TF_RETURN_IF_ERROR(CreateGraphs(
       options, &graphs, &func_info->flib_def, run_state_args, &ek->input_types,
@@ -1926,6 +1968,28 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   std::vector<Tensor>* const fetch_tensors_;       // Not owned.
 };
 
+std::unique_ptr<DirectSession::CallState> DirectSession::AcquireCallState(
+    ExecutorsAndKeys* executors_and_keys) {
+  {
+    mutex_lock l(executors_and_keys->call_state_pool_mu);
+    if (!executors_and_keys->call_state_pool.empty()) {
+      std::unique_ptr<CallState> call_state =
+          std::move(executors_and_keys->call_state_pool.back());
+      executors_and_keys->call_state_pool.pop_back();
+      return call_state;
+    }
+  }
+  return std::make_unique<CallState>();
+}
+
+void DirectSession::ReleaseCallState(ExecutorsAndKeys* executors_and_keys,
+                                     std::unique_ptr<CallState> call_state) {
+  // Drop references to the feeds of the finished call, but keep the capacity.
+  call_state->converted_feed_tensors.clear();
+  mutex_lock l(executors_and_keys->call_state_pool_mu);
+  executors_and_keys->call_state_pool.push_back(std::move(call_state));
+}
+
 ::tensorflow::Status DirectSession::RunCallable(
     CallableHandle handle, const std::vector<Tensor>& feed_tensors,
     std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata) {
@@ -1986,11 +2050,27 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   }
   metrics::RecordGraphInputTensors(input_size);
 
-  std::unique_ptr<std::vector<Tensor>> converted_feed_tensors;
+  std::unique_ptr<CallState> call_state;
+  if (executors_and_keys->callable_options.reuse_call_state()) {
+    call_state = AcquireCallState(executors_and_keys.get());
+  }
+  auto release_call_state = gtl::MakeCleanup([&]() {
+    if (call_state != nullptr) {
+      ReleaseCallState(executors_and_keys.get(), std::move(call_state));
+    }
+  });
+
+  std::unique_ptr<std::vector<Tensor>> owned_converted_feed_tensors;
+  std::vector<Tensor>* converted_feed_tensors = nullptr;
   const std::vector<Tensor>* actual_feed_tensors;
 
   if (TF_PREDICT_FALSE(any_resource_feeds)) {
-    converted_feed_tensors = std::make_unique<std::vector<Tensor>>();
+    if (call_state != nullptr) {
+      converted_feed_tensors = &call_state->converted_feed_tensors;
+    } else {
+      owned_converted_feed_tensors = std::make_unique<std::vector<Tensor>>();
+      converted_feed_tensors = owned_converted_feed_tensors.get();
+    }
     converted_feed_tensors->reserve(feed_tensors.size());
     for (const Tensor& t : feed_tensors) {
       if (t.dtype() == DT_RESOURCE) {
@@ -2001,7 +2081,7 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
         converted_feed_tensors->emplace_back(t);
       }
     }
-    actual_feed_tensors = converted_feed_tensors.get();
+    actual_feed_tensors = converted_feed_tensors;
   } else {
     actual_feed_tensors = &feed_tensors;
   }
@@ -2017,7 +2097,8 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
 
   TF_RETURN_IF_ERROR(RunInternal(
       step_id, executors_and_keys->callable_options.run_options(), &call_frame,
-      executors_and_keys.get(), run_metadata, threadpool_options));
+      executors_and_keys.get(), run_metadata, threadpool_options,
+      call_state.get()));
 
   if (fetch_tensors != nullptr) {
     size_t output_size = 0;
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
+#include "tensorflow/core/common_runtime/stats_publisher_interface.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -150,6 +151,17 @@ class DirectSession : public Session {
     std::unique_ptr<Executor> executor;
   };
 
+  // Per-call objects that may be recycled across RunCallable() calls when
+  // `CallableOptions.reuse_call_state` is set.
+  struct CallState {
+    // Rendezvous for steps that run synchronously on a single executor. Only
+    // reused after a successful step, which leaves the rendezvous empty.
+    std::unique_ptr<PrivateIntraProcessRendezvous> rendezvous;
+    // Scratch storage for feeds that must be converted before running, e.g.
+    // DT_RESOURCE handles.
+    std::vector<Tensor> converted_feed_tensors;
+  };
+
   // An ExecutorsAndKeys is created for a given set of feeds/fetches.
   // 'step_count' is the number of times this graph is executed.
   // 'graph' is the entire graph being executed. 'name_to_node'
@@ -176,6 +188,16 @@ class DirectSession : public Session {
     CallableOptions callable_options;
 
     int64_t collective_graph_key = BuildGraphOptions::kNoCollectiveGraphKey;
+
+    // Idle `CallState`s, used when `callable_options.reuse_call_state()` is
+    // set.
+    mutex call_state_pool_mu;
+    std::vector<std::unique_ptr<CallState>> call_state_pool
+        TF_GUARDED_BY(call_state_pool_mu);
+
+    // Publishes the StepStats of sampled steps. Set when
+    // `ConfigProto.Experimental.sampled_trace_step_period` is positive.
+    std::unique_ptr<StatsPublisherInterface> stats_publisher;
   };
 
   // A FunctionInfo object is created for every unique set of feeds/fetches.
@@ -263,11 +285,22 @@ class DirectSession : public Session {
       RunStateArgs* run_state_args, DataTypeVector* input_types,
       DataTypeVector* output_types, int64_t* collective_graph_key);
 
+  // If `call_state` is not null, objects it holds are used in place of
+  // per-call allocations where possible.
   ::tensorflow::Status RunInternal(
       int64_t step_id, const RunOptions& run_options,
       CallFrameInterface* call_frame, ExecutorsAndKeys* executors_and_keys,
       RunMetadata* run_metadata,
-      const thread::ThreadPoolOptions& threadpool_options);
+      const thread::ThreadPoolOptions& threadpool_options,
+      CallState* call_state = nullptr);
+
+  // Takes an idle `CallState` from the pool of `executors_and_keys`, or
+  // creates one if the pool is empty.
+  std::unique_ptr<CallState> AcquireCallState(
+      ExecutorsAndKeys* executors_and_keys);
+  // Returns `call_state` to the pool of `executors_and_keys`.
+  void ReleaseCallState(ExecutorsAndKeys* executors_and_keys,
+                        std::unique_ptr<CallState> call_state);
 
   // Returns whether inter-op execution uses a global pool or the input
   // `run_options` requests being run on inter_op_thread_pool = 0 in case
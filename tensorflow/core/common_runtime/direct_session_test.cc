@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <random>
 #include <string>
 #include <thread>  // NOLINT
@@ -30,6 +31,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/function_testlib.h"
+#include "tensorflow/core/common_runtime/graph_execution_state.h"
+#include "tensorflow/core/common_runtime/process_state.h"
+#include "tensorflow/core/common_runtime/stats_publisher_interface.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/device_factory.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -46,7 +50,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/test.h"
@@ -68,6 +74,27 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
+// Sets an environment variable for the lifetime of the object and restores
+// its previous value (or unsets it) on destruction.
+class ScopedEnvVar {
+ public:
+  ScopedEnvVar(const char* name, const char* value) : name_(name) {
+    if (const char* old_value = getenv(name)) old_value_ = old_value;
+    setenv(name, value, /*overwrite=*/1);
+  }
+  ~ScopedEnvVar() {
+    if (old_value_.has_value()) {
+      setenv(name_.c_str(), old_value_->c_str(), /*overwrite=*/1);
+    } else {
+      unsetenv(name_.c_str());
+    }
+  }
+
+ private:
+  const std::string name_;
+  std::optional<std::string> old_value_;
+};
+
 CallableOptions MakeCallableOptions(absl::Span<const string> feeds,
                                     absl::Span<const string> fetches,
                                     absl::Span<const string> targets) {
@@ -201,6 +228,99 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_Callable) {
   }
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_CallableReuseCallState) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  CallableOptions callable_options =
+      MakeCallableOptions({}, {y_ + ":0"}, {y_neg_});
+  callable_options.set_reuse_call_state(true);
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  // Reuse the same output vector across calls.
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+    ASSERT_EQ(1, outputs.size());
+    ASSERT_TRUE(outputs[0].IsInitialized());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  }
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
+TEST(DirectSessionTest, RunCallableReuseCallStateSingleExecutor) {
+  Graph g(OpRegistry::Global());
+  Node* placeholder;
+  TF_ASSERT_OK(NodeBuilder("x", "Placeholder")
+                   .Attr("shape", TensorShape())
+                   .Attr("dtype", DT_FLOAT)
+                   .Device("/cpu:0")
+                   .Finalize(&g, &placeholder));
+  Node* identity;
+  TF_ASSERT_OK(NodeBuilder("y", "Identity")
+                   .Input(placeholder)
+                   .Attr("T", DT_FLOAT)
+                   .Device("/cpu:0")
+                   .Finalize(&g, &identity));
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(gd));
+
+  CallableOptions callable_options = MakeCallableOptions({"x:0"}, {"y:0"}, {});
+  callable_options.set_reuse_call_state(true);
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < 3; ++i) {
+    Tensor x(DT_FLOAT, TensorShape());
+    x.scalar<float>()() = i;
+    TF_ASSERT_OK(session->RunCallable(handle, {x}, &outputs, nullptr));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_EQ(i, outputs[0].scalar<float>()());
+  }
+
+  // A failed call must not poison the reused state of later calls.
+  Status s = session->RunCallable(handle, {}, &outputs, nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  Tensor x(DT_FLOAT, TensorShape());
+  x.scalar<float>()() = 42.0;
+  TF_ASSERT_OK(session->RunCallable(handle, {x}, &outputs, nullptr));
+  EXPECT_EQ(42.0, outputs[0].scalar<float>()());
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_ClientGraphCache) {
+  Initialize({3, 2, -1, 0});
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "client_graph_cache");
+  ScopedEnvVar cache_dir_env(kClientGraphCachingEnvVariableName,
+                             cache_dir.c_str());
+
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+  // The first session populates the cache and the second one restores the
+  // client graph from it.
+  for (int i = 0; i < 2; ++i) {
+    auto session = CreateSession();
+    ASSERT_TRUE(session != nullptr);
+    TF_ASSERT_OK(session->Create(def_));
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, output_names, target_nodes, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+
+    std::vector<string> cache_files;
+    TF_ASSERT_OK(Env::Default()->GetChildren(cache_dir, &cache_files));
+    EXPECT_EQ(1, cache_files.size());
+  }
+}
+
 TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_OptimizeForStaticGraph) {
   Initialize({3, 2, -1, 0});
   SessionOptions options(DefaultSessionOptions());
@@ -771,6 +891,73 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithOpts_Callable) {
   EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
 }
 
+// Records the StepStats published by sampled tracing.
+class RecordingStatsPublisher : public StatsPublisherInterface {
+ public:
+  static std::vector<StepStats>* published() {
+    static auto* published = new std::vector<StepStats>;
+    return published;
+  }
+
+  void PublishStatsProto(const StepStats& step_stats) override {
+    published()->push_back(step_stats);
+  }
+  void PublishGraphProto(
+      const std::vector<const GraphDef*>& graph_defs) override {}
+  void PublishGraphProto(std::vector<GraphDef> graph_defs) override {}
+  void PublishGraphProto(std::vector<core::RefCountPtr<FunctionRecord>>&&
+                             function_records) override {}
+  std::unique_ptr<ProfileHandler> GetProfileHandler(
+      uint64 step, int64_t execution_count, const RunOptions& ropts) override {
+    return nullptr;
+  }
+};
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_SampledTrace) {
+  Initialize({3, 2, -1, 0});
+  const StatsPublisherFactory previous_factory =
+      StatsPublisherInterface::GetStatsPublisherFactory();
+  auto restore_factory = gtl::MakeCleanup([&previous_factory]() {
+    StatsPublisherInterface::RegisterStatsPublisher(previous_factory);
+  });
+  StatsPublisherInterface::RegisterStatsPublisher(
+      [](const string&, const BuildGraphOptions&, const SessionOptions&) {
+        return std::make_unique<RecordingStatsPublisher>();
+      });
+  RecordingStatsPublisher::published()->clear();
+
+  SessionOptions options = DefaultSessionOptions();
+  options.config.mutable_experimental()->set_sampled_trace_step_period(2);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+  for (int i = 0; i < 4; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, output_names, target_nodes, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  }
+
+  // Steps 0 and 2 are sampled.
+  ASSERT_EQ(RecordingStatsPublisher::published()->size(), 2);
+  for (const StepStats& step_stats : *RecordingStatsPublisher::published()) {
+    EXPECT_EQ(step_stats.dev_stats_size(), 2);
+  }
+
+  // A step that is traced through RunOptions fills in RunMetadata instead.
+  RunOptions run_options;
+  run_options.set_trace_level(RunOptions::SOFTWARE_TRACE);
+  RunMetadata run_metadata;
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run(run_options, {}, output_names, target_nodes,
+                            &outputs, &run_metadata));
+  EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
+  EXPECT_EQ(RecordingStatsPublisher::published()->size(), 2);
+}
+
 TEST_F(DirectSessionMinusAXTest, UseRunHandlerPool) {
   Initialize({3, 2, -1, 0});
   auto session = CreateSession();
@@ -2686,7 +2873,8 @@ TEST(DirectSessionTest,
 // with varying numbers of feeds/fetches.
 void FeedFetchBenchmarkHelper(::testing::benchmark::State& state, int num_feeds,
                               bool use_make_callable, int inter_op_threads,
-                              bool use_single_threaded_executor) {
+                              bool use_single_threaded_executor,
+                              bool reuse_call_state = false) {
   Tensor value(DT_FLOAT, TensorShape());
   value.flat<float>()(0) = 37.0;
 
@@ -2736,8 +2924,33 @@ void FeedFetchBenchmarkHelper(::testing::benchmark::State& state, int num_feeds,
     for (const string& output : outputs) {
       callable_options.add_fetch(output);
     }
+    callable_options.set_reuse_call_state(reuse_call_state);
     TF_CHECK_OK(session->MakeCallable(callable_options, &handle));
 
+    if (reuse_call_state) {
+      // Reuse the output buffers, and warm up the pooled call state.
+      std::vector<Tensor> output_values;
+      TF_CHECK_OK(
+          session->RunCallable(handle, input_tensors, &output_values, nullptr));
+      // Count the tensor allocations of each step with the stats of the CPU
+      // device's allocator.
+      Allocator* allocator =
+          ProcessState::singleton()->GetCPUAllocator(port::kNUMANoAffinity);
+      EnableCPUAllocatorStats();
+      const bool has_stats = allocator->ClearStats();
+      for (auto s : state) {
+        TF_CHECK_OK(session->RunCallable(handle, input_tensors, &output_values,
+                                         nullptr));
+      }
+      const auto stats = allocator->GetStats();
+      DisableCPUAllocatorStats();
+      if (has_stats && stats.has_value()) {
+        state.counters["allocs_per_step"] =
+            static_cast<double>(stats->num_allocs) / state.iterations();
+      }
+      return;
+    }
+
     for (auto s : state) {
       std::vector<Tensor> output_values;
       TF_CHECK_OK(
@@ -2792,6 +3005,16 @@ void BM_FeedFetchCallableSingleThreadExecutor(
                            /* use_single_threaded_executor */ true);
 }
 
+void BM_FeedFetchCallableSingleThreadReuseCallState(
+    ::testing::benchmark::State& state) {
+  const int num_feeds = state.range(0);
+
+  FeedFetchBenchmarkHelper(state, num_feeds, /* use_make_callable */ true,
+                           /* inter_op_threads */ -1,
+                           /* use_single_threaded_executor */ false,
+                           /* reuse_call_state */ true);
+}
+
 BENCHMARK(BM_FeedFetch)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
 BENCHMARK(BM_FeedFetchCallable)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
 BENCHMARK(BM_FeedFetchCallableSingleThread)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
@@ -2800,6 +3023,11 @@ BENCHMARK(BM_FeedFetchCallableSingleThreadExecutor)
     ->Arg(2)
     ->Arg(5)
     ->Arg(10);
+BENCHMARK(BM_FeedFetchCallableSingleThreadReuseCallState)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(5)
+    ->Arg(10);
 
 }  // namespace
 
@@ -53,6 +53,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_resolver_local.h"
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/common_runtime/eager/small_constants_optimizer.h"
+#include "tensorflow/core/common_runtime/eager/small_tensor_buffer.h"
 #include "tensorflow/core/common_runtime/eager/summary_optimizer.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/framework/function.h"
@@ -233,7 +234,9 @@ AbstractTensorInterface* EagerContext::CreateBoolScalar(bool value) {
 
 AbstractTensorInterface* EagerContext::CreateTensor(
     DataType dtype, absl::Span<const int64_t> dim_sizes) {
-  return new TensorInterface(Tensor(dtype, TensorShape(dim_sizes)));
+  // Python creates many small shape and constant tensors through this method,
+  // so keep their data inline with the tensor buffer.
+  return new TensorInterface(NewHostTensor(dtype, TensorShape(dim_sizes)));
 }
 
 AbstractTensorInterface* EagerContext::CreateTensor(
@@ -472,7 +475,10 @@ void EagerContext::ClearCachesAndDefaultExecutor() {
     // during this time as well.
     mutex_lock ml(cache_mu_);
     default_executor_.WaitForAllPendingNodes().IgnoreError();
-    kernel_cache_.clear();
+    for (KernelCacheShard& shard : kernel_cache_shards_) {
+      mutex_lock sl(shard.mu);
+      shard.kernels.clear();
+    }
     for (auto& entry : registered_functions_) {
       entry.second->cached_kernel_keys->clear();
     }
@@ -1101,7 +1107,11 @@ EagerContext::GetCacheStats() {
   CacheStats stats;
   {
     mutex_lock l(cache_mu_);
-    stats.kernel_cache_size = kernel_cache_.size();
+    stats.kernel_cache_size = 0;
+    for (KernelCacheShard& shard : kernel_cache_shards_) {
+      tf_shared_lock sl(shard.mu);
+      stats.kernel_cache_size += shard.kernels.size();
+    }
     for (const auto& iter : registered_functions_) {
       stats.func_kernel_cache_entries[iter.first] =
           iter.second->cached_kernel_keys->size();
@@ -1132,7 +1142,9 @@ Status EagerContext::RemoveFunction(const string& func) {
     is_last_ref = registered_function->RefCountIsOne();
     if (is_last_ref) {
       for (auto& key : *registered_function->cached_kernel_keys) {
-        kernel_cache_.erase(key);
+        KernelCacheShard& shard = GetKernelCacheShard(key);
+        mutex_lock sl(shard.mu);
+        shard.kernels.erase(key);
       }
       registered_functions_.erase(func);
     }
@@ -1215,9 +1227,10 @@ Status EagerContext::SyncExecutors() {
 
 core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedKernel(
     Fprint128 cache_key) {
-  tf_shared_lock l(cache_mu_);
-  auto iter = kernel_cache_.find(cache_key);
-  if (iter == kernel_cache_.end()) {
+  KernelCacheShard& shard = GetKernelCacheShard(cache_key);
+  tf_shared_lock l(shard.mu);
+  auto iter = shard.kernels.find(cache_key);
+  if (iter == shard.kernels.end()) {
     return nullptr;
   }
   core::RefCountPtr<KernelAndDevice> new_ref(iter->second.get());
@@ -1235,15 +1248,19 @@ Device* EagerContext::GetCachedDevice(Fprint128 device_cache_key) {
 core::RefCountPtr<KernelAndDevice> EagerContext::AddKernelToCache(
     Fprint128 cache_key, core::RefCountPtr<KernelAndDevice> kernel) {
   mutex_lock ml(cache_mu_);
-  auto iter = kernel_cache_.find(cache_key);
-  if (iter != kernel_cache_.end()) {
-    core::RefCountPtr<KernelAndDevice> new_ref(iter->second.get());
+  {
+    KernelCacheShard& shard = GetKernelCacheShard(cache_key);
+    mutex_lock sl(shard.mu);
+    auto iter = shard.kernels.find(cache_key);
+    if (iter != shard.kernels.end()) {
+      core::RefCountPtr<KernelAndDevice> new_ref(iter->second.get());
+      new_ref->Ref();
+      return new_ref;
+    }
+    core::RefCountPtr<KernelAndDevice> new_ref(kernel.get());
     new_ref->Ref();
-    return new_ref;
+    shard.kernels[cache_key] = std::move(new_ref);
   }
-  core::RefCountPtr<KernelAndDevice> new_ref(kernel.get());
-  new_ref->Ref();
-  kernel_cache_[cache_key] = std::move(new_ref);
   auto* registered_function =
       gtl::FindPtrOrNull(registered_functions_, kernel->name());
 
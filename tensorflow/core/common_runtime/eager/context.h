@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_CONTEXT_H_
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -37,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 #include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
 #include "tensorflow/core/common_runtime/eager/rendezvous_cache.h"
+#include "tensorflow/core/common_runtime/eager/value_specialization_cache.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/example/example.pb.h"
@@ -287,6 +289,11 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
       Fprint128 cache_key, core::RefCountPtr<KernelAndDevice> kernel);
   void AddDeviceToCache(Fprint128 device_cache_key, Device* device);
 
+  // Functions specialized on the values of their small integer inputs.
+  ValueSpecializationCache& GetValueSpecializationCache() {
+    return value_specialization_cache_;
+  }
+
   bool LogDevicePlacement() const { return log_device_placement_; }
   void SetLogDevicePlacement(bool enable) override {
     log_device_placement_ = enable;
@@ -773,9 +780,22 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
 
     std::unique_ptr<std::vector<Fprint128>> cached_kernel_keys;
   };
-  std::unordered_map<Fprint128, core::RefCountPtr<KernelAndDevice>,
-                     Fprint128Hasher>
-      kernel_cache_ TF_GUARDED_BY(cache_mu_);
+  // The kernel cache is split into shards by cache key, so that concurrent
+  // dispatches of cached kernels do not all contend on one lock. A lookup only
+  // takes the shared lock of its shard. Insertions and removals additionally
+  // hold `cache_mu_`, which keeps them consistent with `registered_functions_`.
+  static constexpr int kNumKernelCacheShards = 16;
+  struct alignas(64) KernelCacheShard {
+    mutex mu;
+    std::unordered_map<Fprint128, core::RefCountPtr<KernelAndDevice>,
+                       Fprint128Hasher>
+        kernels TF_GUARDED_BY(mu);
+  };
+  KernelCacheShard& GetKernelCacheShard(Fprint128 cache_key) {
+    // `Fprint128Hasher` buckets by `low64`, so shard by `high64`.
+    return kernel_cache_shards_[cache_key.high64 % kNumKernelCacheShards];
+  }
+  std::array<KernelCacheShard, kNumKernelCacheShards> kernel_cache_shards_;
   std::unordered_map<string, RegisteredFunction*> registered_functions_
       TF_GUARDED_BY(cache_mu_);
 
@@ -783,6 +803,7 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
       component_function_libraries_ TF_GUARDED_BY(cache_mu_);
   absl::flat_hash_map<Fprint128, Device*, Fprint128Hasher> device_cache_
       TF_GUARDED_BY(device_cache_mu_);
+  ValueSpecializationCache value_specialization_cache_;
   std::unordered_map<std::string, std::vector<std::function<void()>>>
       remove_function_notifiers_ TF_GUARDED_BY(remove_function_notifiers_mu_);
 
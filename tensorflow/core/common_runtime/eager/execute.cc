@@ -121,6 +121,10 @@ auto* top_level_jit_compilation_counter = monitoring::Counter<1>::New(
     "/tensorflow/core/tf_top_level_jit_compilation",
     "The number of times a top-level JIT-compiled function is called.",
     "device");
+auto* value_specialization_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/eager_value_specialization",
+    "The number of value specialization cache lookups for TF function calls.",
+    "result");
 
 bool SendAsProtosWhenPossible() {
   static bool send_as_protos_when_possible = []() {
@@ -1082,6 +1086,92 @@ std::optional<bool> GetBoolArgumentValue(const EagerOperation& op,
   return std::nullopt;
 }
 
+// Redirects the function call `op` to a variant of the function in which its
+// small integer inputs are folded as constants, when value specialization is
+// enabled for the function and it was called with the same input values
+// before. Inputs that are not ready or not on host are not specialized, so this
+// never blocks on pending inputs.
+Status MaybeSpecializeOnInputValues(EagerOperation* op) {
+  if (!op->is_function()) return absl::OkStatus();
+  EagerContext& ctx = op->EagerContext();
+  const FunctionDef* fdef = ctx.GetFunctionDef(op->Name());
+  if (fdef == nullptr ||
+      !small_constants_optimizer::IsValueSpecializationEnabled(*fdef)) {
+    return absl::OkStatus();
+  }
+  const absl::InlinedVector<TensorHandle*, 4>* inputs;
+  if (!op->TensorHandleInputs(&inputs).ok()) return absl::OkStatus();
+  if (fdef->signature().input_arg_size() != inputs->size()) {
+    return absl::OkStatus();
+  }
+
+  std::vector<std::pair<std::string, Tensor>> values;
+  Fprint128 key = tsl::Fingerprint128(op->Name());
+  for (int32_t i = 0; i < fdef->signature().input_arg_size(); ++i) {
+    const auto& input_arg = fdef->signature().input_arg(i);
+    if (input_arg.type() != DT_INT32 && input_arg.type() != DT_INT64) continue;
+    const TensorHandle* handle = inputs->at(i);
+    if (handle->Type() != TensorHandle::LOCAL || !handle->IsReady()) continue;
+    Status s;
+    const char* input_device = handle->DeviceType(&s);
+    if (!s.ok() || !absl::StrContains(input_device, "CPU")) continue;
+    const Tensor* tensor;
+    if (!handle->Tensor(&tensor).ok()) continue;
+    if (!small_constants_optimizer::IsSpecializableValue(*tensor)) continue;
+    key = tsl::FingerprintCat128(key, i);
+    for (int d = 0; d < tensor->dims(); ++d) {
+      key = tsl::FingerprintCat128(key, tensor->dim_size(d));
+    }
+    key = tsl::FingerprintCat128(key,
+                                 tsl::Fingerprint128(tensor->tensor_data()));
+    values.emplace_back(input_arg.name(), *tensor);
+  }
+  if (values.empty()) return absl::OkStatus();
+
+  ValueSpecializationCache& cache = ctx.GetValueSpecializationCache();
+  bool should_specialize = false;
+  std::string specialized_name = cache.Lookup(key, &should_specialize);
+  if (!specialized_name.empty()) {
+    value_specialization_counter->GetCell("hit")->IncrementBy(1);
+    op->UpdateName(specialized_name);
+    return absl::OkStatus();
+  }
+  if (!should_specialize) {
+    value_specialization_counter->GetCell("miss")->IncrementBy(1);
+    return absl::OkStatus();
+  }
+
+  specialized_name = ValueSpecializationCache::NewFunctionName(op->Name());
+  Status s = ctx.AddFunctionDef(
+      small_constants_optimizer::SpecializeInputTensors(*fdef, specialized_name,
+                                                        values));
+  if (!s.ok()) {
+    // Fall back to the generic function.
+    VLOG(1) << "Failed to specialize " << op->Name() << ": " << s;
+    value_specialization_counter->GetCell("miss")->IncrementBy(1);
+    return absl::OkStatus();
+  }
+  // A concurrent call may have specialized the same values, in which case our
+  // duplicate registration is returned as evicted and `specialized_name` is
+  // switched to the cached function.
+  for (const std::string& evicted : cache.Insert(key, &specialized_name)) {
+    s = ctx.RemoveFunction(evicted);
+    if (!s.ok()) {
+      VLOG(1) << "Failed to remove specialized function " << evicted << ": "
+              << s;
+    }
+  }
+  value_specialization_counter->GetCell("specialize")->IncrementBy(1);
+  if (VLOG_IS_ON(2)) {
+    ValueSpecializationCache::Stats stats = cache.GetStats();
+    VLOG(2) << "Specialized " << op->Name() << " as " << specialized_name
+            << ". Cache hits: " << stats.hits << " misses: " << stats.misses
+            << " evictions: " << stats.evictions;
+  }
+  op->UpdateName(specialized_name);
+  return absl::OkStatus();
+}
+
 absl::StatusOr<Fprint128> GetKernelCacheKey(
     const EagerOperation& op, const Fprint128& op_cache_key,
     const std::vector<Device*>& input_device_ptrs,
@@ -1256,6 +1346,10 @@ Status GetOrCreateKernelAndDevice(
     op->UpdateName(folded_name);
   }
 
+  // Redirect the EagerOperation to a function specialized on the values of its
+  // small integer inputs, when value specialization is enabled.
+  TF_RETURN_IF_ERROR(MaybeSpecializeOnInputValues(op));
+
   // Update the EagerOperation with information about the boolean input
   // tensors when the summary_optimizer is enabled.
   auto is_summary_optimizer_enabled = [](const EagerOperation* op) -> bool {
@@ -1304,7 +1398,10 @@ Status GetOrCreateKernelAndDevice(
   std::unordered_map<int, DtypeAndPartialTensorShape>
       input_resource_variable_dtypes_and_shapes;
   const KernelDef* kernel_def = nullptr;
-  if (!op->is_function()) {
+  // The kernel def is only consulted when a primitive op is wrapped in a
+  // function, so skip building the NodeDef and looking up its kernel on the
+  // regular op-by-op dispatch path.
+  if (!op->is_function() && ctx.RunEagerOpAsFunction()) {
     const NodeDef& node_def = op->MutableAttrs()->BuildNodeDef();
     auto get_kernel_def = [](const EagerOperation& op, const NodeDef& node_def,
                              const Device* op_device) -> const KernelDef* {
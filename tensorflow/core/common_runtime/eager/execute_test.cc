@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace {
@@ -428,5 +429,83 @@ TEST(ExecuteTest, MultipleNestedCompiledFunction) {
   ctx->Unref();
 }
 
+// Executes "Mul" on the two scalar inputs, reusing `op`.
+Status ExecuteMul(EagerOperation* op, ImmediateExecutionTensorHandle* x,
+                  ImmediateExecutionTensorHandle* y) {
+  TF_RETURN_IF_ERROR(op->Reset(
+      /*op=*/"Mul",
+      /*raw_device_name=*/"/job:localhost/replica:0/task:0/device:CPU:0"));
+  TF_RETURN_IF_ERROR(op->AddInput(x));
+  TF_RETURN_IF_ERROR(op->AddInput(y));
+  std::vector<TensorHandle*> retvals(1);
+  int num_retvals = retvals.size();
+  TF_RETURN_IF_ERROR(EagerExecute(op, retvals.data(), &num_retvals));
+  retvals[0]->Unref();
+  return absl::OkStatus();
+}
+
+TEST(ExecuteTest, RepeatedOpReusesCachedKernel) {
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_EXPLICIT,
+      false, &device_mgr, false, nullptr, nullptr);
+
+  Tensor x_tensor = test::AsScalar<int64_t>(3);
+  auto x = core::RefCountPtr<ImmediateExecutionTensorHandle>(
+      ctx->CreateLocalHandleFromTFTensor(x_tensor, ctx->HostCPUName().c_str()));
+  auto op = std::make_unique<EagerOperation>(ctx);
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(ExecuteMul(op.get(), x.get(), x.get()));
+  }
+  EXPECT_EQ(ctx->GetCacheStats().kernel_cache_size, 1);
+
+  // A different attr value needs a different kernel.
+  Tensor y_tensor = test::AsScalar<float>(3);
+  auto y = core::RefCountPtr<ImmediateExecutionTensorHandle>(
+      ctx->CreateLocalHandleFromTFTensor(y_tensor, ctx->HostCPUName().c_str()));
+  TF_ASSERT_OK(ExecuteMul(op.get(), y.get(), y.get()));
+  EXPECT_EQ(ctx->GetCacheStats().kernel_cache_size, 2);
+
+  ctx->ClearCachesAndDefaultExecutor();
+  EXPECT_EQ(ctx->GetCacheStats().kernel_cache_size, 0);
+
+  op.reset();
+  x.reset();
+  y.reset();
+  ctx->Unref();
+}
+
+// Measures the dispatch overhead of a repeated, cached op. Runs the op as a
+// function when `state.range(0) == 1`.
+void BM_EagerExecuteCachedOp(::testing::benchmark::State& state) {
+  const bool run_eager_op_as_function = state.range(0) == 1;
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_EXPLICIT,
+      false, &device_mgr, /*device_mgr_owned=*/false, /*rendezvous=*/nullptr,
+      /*cluster_flr=*/nullptr, /*collective_executor_mgr=*/nullptr,
+      run_eager_op_as_function);
+
+  Tensor x_tensor = test::AsScalar<int64_t>(3);
+  auto x = core::RefCountPtr<ImmediateExecutionTensorHandle>(
+      ctx->CreateLocalHandleFromTFTensor(x_tensor, ctx->HostCPUName().c_str()));
+  auto op = std::make_unique<EagerOperation>(ctx);
+  // Populate the kernel cache.
+  TF_CHECK_OK(ExecuteMul(op.get(), x.get(), x.get()));
+  for (auto s : state) {
+    TF_CHECK_OK(ExecuteMul(op.get(), x.get(), x.get()));
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  op.reset();
+  x.reset();
+  ctx->Unref();
+}
+BENCHMARK(BM_EagerExecuteCachedOp)->Arg(0)->Arg(1);
+
 }  // namespace
 }  // namespace tensorflow
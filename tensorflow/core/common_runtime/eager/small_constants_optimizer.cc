@@ -36,6 +36,7 @@ namespace tensorflow::small_constants_optimizer {
 namespace {
 
 constexpr char kRuntimeConstantOptimization[] = "runtime_constant_optimization";
+constexpr char kRuntimeValueSpecialization[] = "runtime_value_specialization";
 constexpr char kIfOp[] = "If";
 constexpr char kStatelessIfOp[] = "StatelessIf";
 constexpr char kPartitionedCallOp[] = "PartitionedCall";
@@ -46,6 +47,9 @@ constexpr char kStatefulPartitionedCallOp[] = "StatefulPartitionedCall";
 // restriction later.
 constexpr int32_t kMaxBoolArguments = 1;
 
+// Only specialize on inputs that are at most this large, e.g. shapes.
+constexpr int64_t kMaxSpecializedElements = 8;
+
 // Returns a list of input arguments that have dtype tf.bool in a FunctionDef.
 // NOTE: This function requires that the FunctionDef outlive the returned
 // result.
@@ -281,4 +285,51 @@ std::vector<FunctionDef> FoldInputTensors(
   return result;
 }
 
+bool IsValueSpecializationEnabled(const FunctionDef& fdef) {
+  auto it = fdef.attr().find(kRuntimeValueSpecialization);
+  if (it == fdef.attr().end()) return false;
+  return it->second.b();
+}
+
+bool IsSpecializableValue(const Tensor& t) {
+  if (t.dtype() != DT_INT32 && t.dtype() != DT_INT64) return false;
+  return t.IsInitialized() && t.NumElements() <= kMaxSpecializedElements;
+}
+
+FunctionDef SpecializeInputTensors(
+    const FunctionDef& fdef, absl::string_view specialized_name,
+    absl::Span<const std::pair<std::string, Tensor>> values) {
+  FunctionDef result = fdef;
+  result.mutable_signature()->set_name(std::string(specialized_name));
+  // The specialized function must not be specialized again.
+  result.mutable_attr()->erase(kRuntimeValueSpecialization);
+
+  for (const auto& [input_name, value] : values) {
+    const std::string const_name = absl::StrCat(input_name, "_rt_value_spec");
+    const std::string const_output = absl::StrCat(const_name, ":output:0");
+
+    // Point all data references of the input to the constant tensor. Control
+    // dependencies on the input are left alone, since the input arg remains.
+    for (auto& node_def : *result.mutable_node_def()) {
+      for (auto& input : *node_def.mutable_input()) {
+        if (input == input_name) input = const_output;
+      }
+    }
+    for (auto& ret : *result.mutable_ret()) {
+      if (ret.second == input_name) ret.second = const_output;
+    }
+
+    auto* const_tensor = result.add_node_def();
+    const_tensor->set_name(const_name);
+    const_tensor->set_op("Const");
+    AttrValue dtype_value;
+    dtype_value.set_type(value.dtype());
+    const_tensor->mutable_attr()->insert({"dtype", dtype_value});
+    AttrValue tensor_value;
+    value.AsProtoTensorContent(tensor_value.mutable_tensor());
+    const_tensor->mutable_attr()->insert({"value", tensor_value});
+  }
+  return result;
+}
+
 }  // namespace tensorflow::small_constants_optimizer
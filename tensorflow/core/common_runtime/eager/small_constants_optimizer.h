@@ -17,11 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_SMALL_CONSTANTS_OPTIMIZER_H_
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 
 namespace tensorflow::small_constants_optimizer {
 
@@ -37,6 +40,22 @@ std::vector<FunctionDef> FoldInputTensors(
 std::string FoldedFunctionName(absl::string_view fname,
                                absl::string_view input_name, bool input_value);
 
+// Checks whether value specialization is enabled for a tf.function. When it is,
+// calls that repeatedly pass the same small integer inputs run a variant of the
+// function with those inputs folded as constants.
+bool IsValueSpecializationEnabled(const FunctionDef& fdef);
+
+// Checks whether a call may be specialized on the value of input `t`, i.e.
+// whether `t` is a small int32 or int64 tensor such as a shape.
+bool IsSpecializableValue(const Tensor& t);
+
+// Generates a FunctionDef named `specialized_name` in which the input args
+// named in `values` are replaced by constants holding the paired tensors. The
+// input args are kept in the signature so that call sites do not change.
+FunctionDef SpecializeInputTensors(
+    const FunctionDef& fdef, absl::string_view specialized_name,
+    absl::Span<const std::pair<std::string, Tensor>> values);
+
 }  // namespace tensorflow::small_constants_optimizer
 
 #endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_SMALL_CONSTANTS_OPTIMIZER_H_
@@ -0,0 +1,112 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/small_constants_optimizer.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using ::tensorflow::small_constants_optimizer::IsSpecializableValue;
+using ::tensorflow::small_constants_optimizer::IsValueSpecializationEnabled;
+using ::tensorflow::small_constants_optimizer::SpecializeInputTensors;
+using ::tsl::protobuf::TextFormat;
+
+FunctionDef ReshapeFunction() {
+  FunctionDef fdef;
+  CHECK(TextFormat::ParseFromString(
+      R"pb(
+        signature {
+          name: "reshape"
+          input_arg: { name: "x" type: DT_FLOAT }
+          input_arg: { name: "shape" type: DT_INT32 }
+          output_arg: { name: "y" type: DT_FLOAT }
+          output_arg: { name: "s" type: DT_INT32 }
+        }
+        node_def {
+          name: "r"
+          op: "Reshape"
+          input: "x"
+          input: "shape"
+          input: "^shape"
+          attr {
+            key: "T"
+            value { type: DT_FLOAT }
+          }
+        }
+        ret { key: "y" value: "r:output:0" }
+        ret { key: "s" value: "shape" }
+        attr {
+          key: "runtime_value_specialization"
+          value { b: true }
+        }
+      )pb",
+      &fdef));
+  return fdef;
+}
+
+TEST(SmallConstantsOptimizerTest, ValueSpecializationIsOptIn) {
+  FunctionDef fdef = ReshapeFunction();
+  EXPECT_TRUE(IsValueSpecializationEnabled(fdef));
+  fdef.mutable_attr()->clear();
+  EXPECT_FALSE(IsValueSpecializationEnabled(fdef));
+}
+
+TEST(SmallConstantsOptimizerTest, SpecializableValues) {
+  EXPECT_TRUE(IsSpecializableValue(test::AsTensor<int32>({2, 3})));
+  EXPECT_TRUE(IsSpecializableValue(test::AsScalar<int64_t>(7)));
+  EXPECT_FALSE(IsSpecializableValue(test::AsScalar<float>(1.0f)));
+  EXPECT_FALSE(IsSpecializableValue(Tensor(DT_INT32, TensorShape({64}))));
+}
+
+TEST(SmallConstantsOptimizerTest, SpecializesInputTensors) {
+  const std::vector<std::pair<std::string, Tensor>> values = {
+      {"shape", test::AsTensor<int32>({2, 3})}};
+  FunctionDef result =
+      SpecializeInputTensors(ReshapeFunction(), "reshape_spec", values);
+
+  EXPECT_EQ(result.signature().name(), "reshape_spec");
+  // Call sites keep passing the input, but it is no longer specialized again.
+  EXPECT_EQ(result.signature().input_arg_size(), 2);
+  EXPECT_FALSE(IsValueSpecializationEnabled(result));
+
+  ASSERT_EQ(result.node_def_size(), 2);
+  const NodeDef& reshape = result.node_def(0);
+  EXPECT_EQ(reshape.input(0), "x");
+  EXPECT_EQ(reshape.input(1), "shape_rt_value_spec:output:0");
+  EXPECT_EQ(reshape.input(2), "^shape");
+  EXPECT_EQ(result.ret().at("s"), "shape_rt_value_spec:output:0");
+
+  const NodeDef& constant = result.node_def(1);
+  EXPECT_EQ(constant.name(), "shape_rt_value_spec");
+  EXPECT_EQ(constant.op(), "Const");
+  EXPECT_EQ(constant.attr().at("dtype").type(), DT_INT32);
+  Tensor value;
+  ASSERT_TRUE(value.FromProto(constant.attr().at("value").tensor()));
+  test::ExpectTensorEqual<int32>(value, test::AsTensor<int32>({2, 3}));
+}
+
+}  // namespace
+}  // namespace tensorflow
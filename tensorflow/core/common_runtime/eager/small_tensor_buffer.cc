@@ -0,0 +1,107 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/small_tensor_buffer.h"
+
+#include <cstdint>
+#include <new>
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/mem.h"
+
+namespace tensorflow {
+
+namespace {
+
+constexpr char kInlineHostTensorBufferName[] = "InlineHostTensorBuffer";
+
+// A TensorBuffer that lives in the same aligned block as its data. The data
+// starts at the first `Allocator::kAllocatorAlignment` boundary after the
+// buffer object.
+class InlineHostTensorBuffer : public TensorBuffer {
+ public:
+  static InlineHostTensorBuffer* New(size_t num_bytes);
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+
+  bool GetAllocatedBytes(size_t* out_bytes) const override {
+    // Like the host scalar buffers, this buffer does not come from an
+    // allocator and does not report allocated bytes.
+    return false;
+  }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name(kInlineHostTensorBufferName);
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+  // The object is at the start of the block, so `delete this` in
+  // `core::RefCounted::Unref()` frees the whole block.
+  static void operator delete(void* ptr) { port::AlignedFree(ptr); }
+  static void operator delete(void*, void*) {
+    // Some compilers require an overridden class-specific deallocation
+    // function, which will be called if placement `new` throws an exception.
+  }
+
+ private:
+  InlineHostTensorBuffer(void* data, size_t size)
+      : TensorBuffer(data), size_(size) {}
+  ~InlineHostTensorBuffer() override = default;
+
+  const size_t size_;
+};
+
+constexpr size_t kInlineDataOffset =
+    (sizeof(InlineHostTensorBuffer) + Allocator::kAllocatorAlignment - 1) /
+    Allocator::kAllocatorAlignment * Allocator::kAllocatorAlignment;
+
+InlineHostTensorBuffer* InlineHostTensorBuffer::New(size_t num_bytes) {
+  void* block = port::AlignedMalloc(kInlineDataOffset + num_bytes,
+                                    Allocator::kAllocatorAlignment);
+  if (block == nullptr) return nullptr;
+  return new (block) InlineHostTensorBuffer(
+      static_cast<char*>(block) + kInlineDataOffset, num_bytes);
+}
+
+}  // namespace
+
+Tensor NewHostTensor(DataType dtype, const TensorShape& shape,
+                     size_t max_inline_bytes) {
+  if (DataTypeCanUseMemcpy(dtype)) {
+    const size_t num_bytes = shape.num_elements() * DataTypeSize(dtype);
+    if (num_bytes > 0 && num_bytes <= max_inline_bytes) {
+      InlineHostTensorBuffer* buf = InlineHostTensorBuffer::New(num_bytes);
+      if (buf != nullptr) {
+        return Tensor(dtype, shape, core::RefCountPtr<TensorBuffer>(buf));
+      }
+    }
+  }
+  return Tensor(dtype, shape);
+}
+
+bool IsInlineHostTensor(const Tensor& t) {
+  const TensorBuffer* buf = DMAHelper::buffer(&t);
+  if (buf == nullptr) return false;
+  AllocationDescription desc;
+  buf->FillAllocationDescription(&desc);
+  return desc.allocator_name() == kInlineHostTensorBufferName;
+}
+
+}  // namespace tensorflow
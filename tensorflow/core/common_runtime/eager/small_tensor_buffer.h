@@ -0,0 +1,47 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_SMALL_TENSOR_BUFFER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_SMALL_TENSOR_BUFFER_H_
+
+#include <cstddef>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+
+namespace tensorflow {
+
+// Largest tensor, in bytes, that `NewHostTensor()` stores inline.
+inline constexpr size_t kMaxInlineHostTensorBytes = 64;
+
+// Returns an uninitialized host tensor of `dtype` and `shape`.
+//
+// Eager code creates many tiny host tensors (shape vectors, small constants)
+// that are immediately wrapped in a TensorHandle. `Tensor(dtype, shape)` makes
+// two allocations for these: one for the refcounted TensorBuffer and one for
+// the data, obtained from the default CPU allocator. When `dtype` is
+// memcpy-able and the tensor is at most `max_inline_bytes` large, this
+// function instead places the data right after the TensorBuffer in a single
+// aligned block, like `Tensor(T scalar)` does for scalars. Any other tensor is
+// allocated with `Tensor(dtype, shape)`.
+Tensor NewHostTensor(DataType dtype, const TensorShape& shape,
+                     size_t max_inline_bytes = kMaxInlineHostTensorBytes);
+
+// Returns true if `t` was stored inline by `NewHostTensor()`.
+bool IsInlineHostTensor(const Tensor& t);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_SMALL_TENSOR_BUFFER_H_
@@ -0,0 +1,94 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/small_tensor_buffer.h"
+
+#include <cstdint>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(SmallTensorBufferTest, SmallTensorIsInline) {
+  Tensor t = NewHostTensor(DT_INT64, TensorShape({4}));
+  EXPECT_TRUE(IsInlineHostTensor(t));
+  EXPECT_EQ(t.dtype(), DT_INT64);
+  EXPECT_EQ(t.shape(), TensorShape({4}));
+  EXPECT_EQ(t.TotalBytes(), 4 * sizeof(int64_t));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(t.data()) %
+                Allocator::kAllocatorAlignment,
+            0);
+
+  auto flat = t.flat<int64_t>();
+  for (int i = 0; i < 4; ++i) flat(i) = i + 1;
+  test::ExpectTensorEqual<int64_t>(t, test::AsTensor<int64_t>({1, 2, 3, 4}));
+
+  // Copies share the inline buffer.
+  Tensor copy = t;
+  EXPECT_TRUE(IsInlineHostTensor(copy));
+  EXPECT_EQ(copy.data(), t.data());
+  EXPECT_TRUE(copy.SharesBufferWith(t));
+}
+
+TEST(SmallTensorBufferTest, SlicesKeepInlineBufferAlive) {
+  Tensor slice;
+  {
+    Tensor t = NewHostTensor(DT_FLOAT, TensorShape({4, 2}));
+    t.flat<float>().setConstant(3.0f);
+    slice = t.Slice(1, 3);
+  }
+  test::ExpectTensorEqual<float>(
+      slice, test::AsTensor<float>({3, 3, 3, 3}, TensorShape({2, 2})));
+}
+
+TEST(SmallTensorBufferTest, LargeTensorIsNotInline) {
+  const int64_t num_elements = kMaxInlineHostTensorBytes;
+  Tensor t = NewHostTensor(DT_FLOAT, TensorShape({num_elements}));
+  EXPECT_FALSE(IsInlineHostTensor(t));
+  EXPECT_EQ(t.NumElements(), num_elements);
+}
+
+TEST(SmallTensorBufferTest, NonMemcpyTypesAreNotInline) {
+  Tensor t = NewHostTensor(DT_STRING, TensorShape({2}));
+  EXPECT_FALSE(IsInlineHostTensor(t));
+  t.flat<tstring>()(0) = "a";
+  t.flat<tstring>()(1) = "b";
+  test::ExpectTensorEqual<tstring>(t, test::AsTensor<tstring>({"a", "b"}));
+}
+
+TEST(SmallTensorBufferTest, EmptyTensorIsNotInline) {
+  Tensor t = NewHostTensor(DT_INT32, TensorShape({0}));
+  EXPECT_FALSE(IsInlineHostTensor(t));
+  EXPECT_EQ(t.NumElements(), 0);
+}
+
+void BM_NewHostTensor(::testing::benchmark::State& state) {
+  const bool inline_data = state.range(0) == 1;
+  const TensorShape shape({4});
+  for (auto s : state) {
+    Tensor t = NewHostTensor(DT_INT32, shape,
+                             inline_data ? kMaxInlineHostTensorBytes : 0);
+    tensorflow::testing::DoNotOptimize(t);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NewHostTensor)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
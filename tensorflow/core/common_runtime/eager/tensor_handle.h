@@ -158,6 +158,10 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   // requesting the HostCPU.
   Status TensorValue(const Device* d, tensorflow::TensorValue* t);
 
+  // Returns true if the handle's data is available, i.e. reading it through
+  // `Tensor()` or `Shape()` does not block.
+  bool IsReady() const;
+
   Device* device() const { return device_; }
   Device* op_device() const { return op_device_; }
   Device* resource_device() const { return resource_device_; }
@@ -291,7 +295,6 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   // Further, it can be in a non-ready state. It would become ready with a call
   // to either SetTensor or SetRemoteShape which replaces the underlying data
   // with a ready version of the tensor handle data.
-  bool IsReady() const;
   Status WaitReady(const char* caller) const;
 
   tensorflow::Device* device_;
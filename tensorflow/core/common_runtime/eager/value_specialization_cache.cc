@@ -0,0 +1,122 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/value_specialization_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "xla/tsl/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Maximum number of unspecialized keys tracked per cache entry.
+constexpr int64_t kCandidatesPerEntry = 4;
+
+int64_t ReadValueSpecializationCacheSize() {
+  int64_t result;
+  TF_CHECK_OK(tsl::ReadInt64FromEnvVar(
+      "TF_EAGER_VALUE_SPECIALIZATION_CACHE_SIZE", 32, &result));
+  return result;
+}
+
+int64_t ReadValueSpecializationMinCalls() {
+  int64_t result;
+  TF_CHECK_OK(tsl::ReadInt64FromEnvVar(
+      "TF_EAGER_VALUE_SPECIALIZATION_MIN_CALLS", 2, &result));
+  return result;
+}
+
+}  // namespace
+
+ValueSpecializationCache::ValueSpecializationCache()
+    : ValueSpecializationCache(ReadValueSpecializationCacheSize(),
+                               ReadValueSpecializationMinCalls()) {}
+
+ValueSpecializationCache::ValueSpecializationCache(
+    int64_t capacity, int64_t min_calls_to_specialize)
+    : capacity_(std::max<int64_t>(capacity, 0)),
+      min_calls_to_specialize_(std::max<int64_t>(min_calls_to_specialize, 1)) {}
+
+std::string ValueSpecializationCache::Lookup(const Fprint128& key,
+                                             bool* should_specialize) {
+  *should_specialize = false;
+  mutex_lock l(mu_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    ++stats_.hits;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+  }
+  ++stats_.misses;
+  if (capacity_ == 0) return "";
+  if (static_cast<int64_t>(candidates_.size()) >=
+      capacity_ * kCandidatesPerEntry) {
+    candidates_.clear();
+  }
+  int64_t& num_calls = candidates_[key];
+  if (++num_calls >= min_calls_to_specialize_) {
+    candidates_.erase(key);
+    *should_specialize = true;
+  }
+  return "";
+}
+
+std::string ValueSpecializationCache::NewFunctionName(
+    absl::string_view function_name) {
+  static std::atomic<int64_t> next_id{0};
+  return absl::StrCat(function_name, "_rt_value_spec_",
+                      next_id.fetch_add(1, std::memory_order_relaxed));
+}
+
+std::vector<std::string> ValueSpecializationCache::Insert(
+    const Fprint128& key, std::string* function_name) {
+  std::vector<std::string> evicted;
+  DCHECK_GT(capacity_, 0);
+  mutex_lock l(mu_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    // Another caller specialized the same key concurrently. Keep the existing
+    // entry, and let the caller drop its duplicate registration.
+    evicted.push_back(*function_name);
+    *function_name = it->second->second;
+    return evicted;
+  }
+  lru_.emplace_front(key, *function_name);
+  entries_[key] = lru_.begin();
+  ++stats_.specializations;
+  while (static_cast<int64_t>(lru_.size()) > capacity_) {
+    VLOG(2) << "Evicting value specialized function " << lru_.back().second;
+    entries_.erase(lru_.back().first);
+    evicted.push_back(std::move(lru_.back().second));
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+  return evicted;
+}
+
+ValueSpecializationCache::Stats ValueSpecializationCache::GetStats() const {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+}  // namespace tensorflow
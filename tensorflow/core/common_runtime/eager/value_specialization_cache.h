@@ -0,0 +1,110 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_VALUE_SPECIALIZATION_CACHE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_VALUE_SPECIALIZATION_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Bounded LRU cache of the functions that were specialized on the values of
+// their small integer inputs (see
+// `small_constants_optimizer::SpecializeInputTensors()`).
+//
+// Entries are keyed by a fingerprint of the function name and of the
+// specialized input values. A key is only specialized once it has been seen
+// `min_calls_to_specialize` times, so that inputs whose values change on every
+// call keep using the generic function instead of instantiating a new variant
+// per call.
+//
+// This class is thread-safe.
+class ValueSpecializationCache {
+ public:
+  struct Stats {
+    // Calls redirected to a cached specialized function.
+    int64_t hits = 0;
+    // Calls that ran the generic function.
+    int64_t misses = 0;
+    // Specialized functions added to the cache.
+    int64_t specializations = 0;
+    // Specialized functions evicted from the cache.
+    int64_t evictions = 0;
+  };
+
+  // Reads the capacity from TF_EAGER_VALUE_SPECIALIZATION_CACHE_SIZE (default
+  // 32) and the number of calls to specialize after from
+  // TF_EAGER_VALUE_SPECIALIZATION_MIN_CALLS (default 2).
+  ValueSpecializationCache();
+  ValueSpecializationCache(int64_t capacity, int64_t min_calls_to_specialize);
+
+  ValueSpecializationCache(const ValueSpecializationCache&) = delete;
+  void operator=(const ValueSpecializationCache&) = delete;
+
+  // Records a call with `key`. Returns the name of the specialized function to
+  // run if one is cached. Otherwise returns an empty string and sets
+  // `*should_specialize` to true if the caller should create a specialized
+  // function and `Insert()` it.
+  std::string Lookup(const Fprint128& key, bool* should_specialize);
+
+  // Returns a name for a new specialization of `function_name`. Names are never
+  // reused within the process, so that a call or cached kernel that still
+  // refers to an evicted specialization cannot pick up a different one.
+  static std::string NewFunctionName(absl::string_view function_name);
+
+  // Adds the specialized function `*function_name` for `key`. Returns the names
+  // of the functions that were evicted from the cache; the caller is
+  // responsible for removing them from the function library. If `key` is
+  // already cached, the caller's function is returned as evicted and
+  // `*function_name` is set to the cached function.
+  //
+  // REQUIRES: `capacity() > 0`.
+  std::vector<std::string> Insert(const Fprint128& key,
+                                  std::string* function_name);
+
+  Stats GetStats() const;
+
+  int64_t capacity() const { return capacity_; }
+
+ private:
+  typedef std::list<std::pair<Fprint128, std::string>> LruList;
+
+  const int64_t capacity_;
+  const int64_t min_calls_to_specialize_;
+
+  mutable mutex mu_;
+  // Most recently used entries first.
+  LruList lru_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<Fprint128, LruList::iterator, Fprint128Hasher> entries_
+      TF_GUARDED_BY(mu_);
+  // Number of calls seen for keys that are not specialized yet. This map is
+  // reset when it grows too large, which only delays specialization.
+  absl::flat_hash_map<Fprint128, int64_t, Fprint128Hasher> candidates_
+      TF_GUARDED_BY(mu_);
+  Stats stats_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_VALUE_SPECIALIZATION_CACHE_H_
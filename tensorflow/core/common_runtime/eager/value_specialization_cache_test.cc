@@ -0,0 +1,103 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/value_specialization_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+Fprint128 Key(const std::string& s) { return Fingerprint128(s); }
+
+std::vector<std::string> Insert(ValueSpecializationCache& cache,
+                                const std::string& key,
+                                std::string function_name) {
+  return cache.Insert(Key(key), &function_name);
+}
+
+TEST(ValueSpecializationCacheTest, SpecializesAfterMinCalls) {
+  ValueSpecializationCache cache(/*capacity=*/4,
+                                 /*min_calls_to_specialize=*/2);
+  bool should_specialize = true;
+  EXPECT_EQ(cache.Lookup(Key("a"), &should_specialize), "");
+  EXPECT_FALSE(should_specialize);
+  EXPECT_EQ(cache.Lookup(Key("a"), &should_specialize), "");
+  EXPECT_TRUE(should_specialize);
+  EXPECT_TRUE(Insert(cache, "a", "f_a").empty());
+
+  EXPECT_EQ(cache.Lookup(Key("a"), &should_specialize), "f_a");
+  EXPECT_FALSE(should_specialize);
+
+  ValueSpecializationCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.specializations, 1);
+  EXPECT_EQ(stats.evictions, 0);
+}
+
+TEST(ValueSpecializationCacheTest, EvictsLeastRecentlyUsed) {
+  ValueSpecializationCache cache(/*capacity=*/2,
+                                 /*min_calls_to_specialize=*/1);
+  bool should_specialize;
+  EXPECT_TRUE(Insert(cache, "a", "f_a").empty());
+  EXPECT_TRUE(Insert(cache, "b", "f_b").empty());
+  // Touch "a" so that "b" is the least recently used entry.
+  EXPECT_EQ(cache.Lookup(Key("a"), &should_specialize), "f_a");
+  EXPECT_EQ(Insert(cache, "c", "f_c"), std::vector<std::string>({"f_b"}));
+
+  EXPECT_EQ(cache.Lookup(Key("b"), &should_specialize), "");
+  EXPECT_TRUE(should_specialize);
+  EXPECT_EQ(cache.Lookup(Key("c"), &should_specialize), "f_c");
+  EXPECT_EQ(cache.GetStats().evictions, 1);
+}
+
+TEST(ValueSpecializationCacheTest, DuplicateInsertIsReturned) {
+  ValueSpecializationCache cache(/*capacity=*/2,
+                                 /*min_calls_to_specialize=*/1);
+  EXPECT_TRUE(Insert(cache, "a", "f_a").empty());
+  std::string duplicate = "f_a_2";
+  EXPECT_EQ(cache.Insert(Key("a"), &duplicate),
+            std::vector<std::string>({"f_a_2"}));
+  // The caller is redirected to the function that is already cached.
+  EXPECT_EQ(duplicate, "f_a");
+  bool should_specialize;
+  EXPECT_EQ(cache.Lookup(Key("a"), &should_specialize), "f_a");
+  EXPECT_EQ(cache.GetStats().specializations, 1);
+}
+
+TEST(ValueSpecializationCacheTest, NewFunctionNamesAreNeverReused) {
+  const std::string first = ValueSpecializationCache::NewFunctionName("f");
+  const std::string second = ValueSpecializationCache::NewFunctionName("f");
+  EXPECT_NE(first, second);
+  EXPECT_EQ(first.rfind("f_rt_value_spec_", 0), 0);
+}
+
+TEST(ValueSpecializationCacheTest, ZeroCapacityNeverSpecializes) {
+  ValueSpecializationCache cache(/*capacity=*/0,
+                                 /*min_calls_to_specialize=*/1);
+  bool should_specialize;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(cache.Lookup(Key("a"), &should_specialize), "");
+    EXPECT_FALSE(should_specialize);
+  }
+  EXPECT_EQ(cache.GetStats().misses, 3);
+}
+
+}  // namespace
+}  // namespace tensorflow
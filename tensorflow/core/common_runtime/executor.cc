@@ -36,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_ready_queue.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
@@ -147,7 +148,16 @@ typedef absl::InlinedVector<AllocatorAttributes, 4UL> AllocatorAttributeVec;
 
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  explicit ExecutorImpl(const LocalExecutorParams& p,
+                        bool use_work_stealing_ready_queue = false)
+      : immutable_state_(p) {
+    if (use_work_stealing_ready_queue) {
+      // The inter-op threads that run the executor are not pinned to NUMA
+      // nodes, so all of them would map to the shards of node 0 anyway.
+      ready_queue_ =
+          std::make_unique<WorkStealingReadyQueue>(/*num_numa_nodes=*/1);
+    }
+  }
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
@@ -225,6 +235,10 @@ class ExecutorImpl : public Executor {
 
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
+  // If not null, ready nodes are dispatched through this queue rather than
+  // being handed directly to `Args::runner`. Shared by all steps of this
+  // executor so that a thread keeps its locality across steps.
+  std::unique_ptr<WorkStealingReadyQueue> ready_queue_;
 
   ExecutorImpl(const ExecutorImpl&) = delete;
   void operator=(const ExecutorImpl&) = delete;
@@ -284,7 +298,8 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                WorkStealingReadyQueue* ready_queue = nullptr);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -343,6 +358,10 @@ class ExecutorState {
   // A wrapper for runner_ to keep track of the pending queue length. Op
   // execution should dispatch work using this function instead of using runner_
   // directly.
+  //
+  // If `ready_queue_` is set, `c` is pushed to the queue shard of the calling
+  // thread and `runner_` only receives a thunk that pops the best available
+  // task from the queue when it runs.
   template <typename Closure>
   void RunTask(Closure&& c, int sample_rate = 0);
 
@@ -390,6 +409,7 @@ class ExecutorState {
   CallFrameInterface* call_frame_;
   const ImmutableExecutorState& immutable_state_;
   ExecutorImpl::KernelStats* const kernel_stats_;
+  WorkStealingReadyQueue* const ready_queue_;  // Not owned. May be null.
   CancellationManager* cancellation_manager_;
   tsl::CoordinationServiceAgent* coordination_service_agent_;
   absl::optional<ManagedStackTrace> stack_trace_ = absl::nullopt;
@@ -419,7 +439,8 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats,
+    WorkStealingReadyQueue* ready_queue)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -442,6 +463,7 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       call_frame_(args.call_frame),
       immutable_state_(immutable_state),
       kernel_stats_(kernel_stats),
+      ready_queue_(ready_queue),
       cancellation_manager_(args.cancellation_manager),
       coordination_service_agent_(args.coordination_service_agent),
       stack_trace_(args.stack_trace),
@@ -481,6 +503,18 @@ void ExecutorState<PropagatorStateType>::RunTask(Closure&& c, int sample_rate) {
     metrics::UpdateGraphPendingQueueLength(n_enqueues - n_dequeues);
   }
 
+  if (ready_queue_ != nullptr) {
+    ready_queue_->Push([c = std::forward<Closure>(c)]() mutable {
+      num_dequeue_ops.fetch_add(1, std::memory_order_relaxed);
+      std::forward<Closure>(c)();
+    });
+    // The thunk does not necessarily run the task pushed above: it runs
+    // whichever task is closest to the thread that picks it up.
+    WorkStealingReadyQueue* ready_queue = ready_queue_;
+    runner_([ready_queue]() { ready_queue->Pop()(); });
+    return;
+  }
+
   // mutable is needed because std::forward<Closure> in the lambda body may move
   // the Closure `c`.
   runner_([c = std::forward<Closure>(c)]() mutable {
@@ -913,6 +947,9 @@ void ExecutorState<PropagatorStateType>::ProcessInline(
 
       // Set up compute params.
       params->op_kernel = item.kernel;
+      params->op_device_context = item.device_context != nullptr
+                                      ? item.device_context
+                                      : device_context_;
       params->frame_iter = propagator_.GetFrameAndIter(tagged_node);
       params->is_input_dead = is_input_dead;
       params->output_attr_array = item.output_attrs();
@@ -1277,6 +1314,14 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
       tsl::profiler::GetTFTraceMeLevel(/*is_expensive=*/false));
   DCHECK(!ready->empty());
 
+  if (immutable_state_.has_scheduling_priorities() && ready->size() > 1) {
+    std::stable_sort(ready->begin(), ready->end(),
+                     [](const TaggedNode& a, const TaggedNode& b) {
+                       return a.node_item->scheduling_priority <
+                              b.node_item->scheduling_priority;
+                     });
+  }
+
   int64_t scheduled_nsec = 0;
   if (stats_collector_) {
     scheduled_nsec = nodestats::NowInNsec();
@@ -1517,11 +1562,12 @@ void ExecutorImpl::RunAsyncInternal(const Args& args, DoneCallback done) {
                                                &kernel_stats_))
         ->RunAsync(std::move(done));
   } else if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        ready_queue_.get()))
         ->RunAsync(std::move(done));
   } else {
-    (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+    (new ExecutorState<SimplePropagatorState>(
+         args, immutable_state_, &kernel_stats_, ready_queue_.get()))
         ->RunAsync(std::move(done));
   }
 }
@@ -1575,6 +1621,30 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Registers the "WORK_STEALING" executor, which is the default executor with
+// ready nodes dispatched through the per-thread shards of a
+// `WorkStealingReadyQueue`. Select it with
+// `ConfigProto.experimental.executor_type = "WORK_STEALING"`.
+class WorkStealingExecutorRegistrar {
+ public:
+  WorkStealingExecutorRegistrar() {
+    ExecutorFactory::Register("WORK_STEALING", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      auto impl = std::make_unique<ExecutorImpl>(
+          params, /*use_work_stealing_ready_queue=*/true);
+      TF_RETURN_IF_ERROR(impl->Initialize(graph));
+      *out_executor = std::move(impl);
+      return absl::OkStatus();
+    }
+  };
+};
+static WorkStealingExecutorRegistrar work_stealing_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -25,11 +25,13 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_ready_queue.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/local_rendezvous.h"
 #include "tensorflow/core/framework/op.h"
@@ -42,7 +44,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -77,7 +81,8 @@ class ExecutorTest : public ::testing::Test {
   }
 
   // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
+  void Create(std::unique_ptr<const Graph> graph,
+              const string& executor_type = "") {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_.get();
@@ -92,7 +97,13 @@ class ExecutorTest : public ::testing::Test {
     };
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    if (executor_type.empty()) {
+      TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    } else {
+      std::unique_ptr<Executor> exec;
+      TF_CHECK_OK(NewExecutor(executor_type, params, *graph, &exec));
+      exec_ = exec.release();
+    }
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -265,6 +276,21 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g), "WORK_STEALING");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -442,7 +468,8 @@ TEST_F(ExecutorTest, NoInputTensors) {
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
-static void BM_executor(::testing::benchmark::State& state) {
+static void BM_executor_helper(::testing::benchmark::State& state,
+                               const char* executor_type) {
   const int width = state.range(0);
   const int depth = state.range(1);
 
@@ -476,12 +503,19 @@ static void BM_executor(::testing::benchmark::State& state) {
   }
 
   FixupSourceAndSinkEdges(g);
-  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  test::Benchmark("cpu", g, /*options=*/nullptr, /*init=*/nullptr,
+                  /*rendez=*/nullptr, executor_type,
+                  /*old_benchmark_api=*/false)
+      .Run(state);
 
   state.SetLabel(strings::StrCat("Nodes = ", cur));
   state.SetItemsProcessed(cur * static_cast<int64_t>(state.iterations()));
 }
 
+static void BM_executor(::testing::benchmark::State& state) {
+  BM_executor_helper(state, "");
+}
+
 // Tall skinny graphs
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(16, 1024);
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(32, 8192);
@@ -493,6 +527,61 @@ BENCHMARK(BM_executor)->UseRealTime()->ArgPair(8192, 32);
 // Tall fat graph
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(1024, 1024);
 
+// Same graphs as BM_executor, dispatched through the WORK_STEALING executor.
+// Compare items_per_second against BM_executor for the per-node dispatch
+// overhead.
+static void BM_executor_work_stealing(::testing::benchmark::State& state) {
+  BM_executor_helper(state, "WORK_STEALING");
+}
+BENCHMARK(BM_executor_work_stealing)->UseRealTime()->ArgPair(16, 1024);
+BENCHMARK(BM_executor_work_stealing)->UseRealTime()->ArgPair(1024, 16);
+BENCHMARK(BM_executor_work_stealing)->UseRealTime()->ArgPair(1024, 1024);
+
+// Measures the per-task cost of dispatching through a WorkStealingReadyQueue
+// from `num_threads` producers that are spread round-robin across the NUMA
+// nodes, and reports how many tasks ended up being stolen across nodes.
+static void BM_WorkStealingReadyQueueDispatch(
+    ::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  constexpr int kTasksPerThread = 1024;
+  const int num_nodes = std::max(1, port::NUMANumNodes());
+  WorkStealingReadyQueue queue(num_nodes);
+  // One pool per node, whose threads are pinned to that node when they start.
+  std::vector<std::unique_ptr<thread::ThreadPool>> pools;
+  for (int n = 0; n < num_nodes; ++n) {
+    ThreadOptions thread_options;
+    if (port::NUMAEnabled()) thread_options.numa_node = n;
+    pools.push_back(std::make_unique<thread::ThreadPool>(
+        Env::Default(), thread_options, strings::StrCat("bm_work_stealing_", n),
+        std::max(1, num_threads / num_nodes)));
+  }
+  for (auto s : state) {
+    BlockingCounter done(num_threads * kTasksPerThread);
+    for (int t = 0; t < num_threads; ++t) {
+      thread::ThreadPool* pool = pools[t % num_nodes].get();
+      pool->Schedule([&, pool]() {
+        for (int i = 0; i < kTasksPerThread; ++i) {
+          queue.Push([&done]() { done.DecrementCount(); });
+          pool->Schedule([&queue]() { queue.Pop()(); });
+        }
+      });
+    }
+    done.Wait();
+  }
+  const WorkStealingReadyQueue::Stats stats = queue.GetStats();
+  const double total =
+      stats.local_pops + stats.same_node_steals + stats.remote_node_steals;
+  state.counters["local_fraction"] = stats.local_pops / total;
+  state.counters["cross_node_fraction"] = stats.remote_node_steals / total;
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_threads * kTasksPerThread);
+}
+BENCHMARK(BM_WorkStealingReadyQueueDispatch)
+    ->UseRealTime()
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(64);
+
 static void BM_const_identity(::testing::benchmark::State& state) {
   const int width = state.range(0);
   const int outputs_per_const = state.range(1);
@@ -751,6 +840,24 @@ BENCHMARK(BM_LoweredWhileLoop)
     ->ArgPair(100, 100)
     ->ArgPair(1000, 100);
 
+// Tight loops with many iterations, which stress the per-iteration frame
+// bookkeeping in PropagatorState rather than the loop body.
+static void BM_LoweredWhileLoopManyIterations(
+    ::testing::benchmark::State& state) {
+  const int loop_iters = state.range(0);
+  const int loop_vars = state.range(1);
+
+  BM_WhileLoopHelper(state, loop_iters, loop_vars, /* lower= */ true,
+                     /* transfer= */ false);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          loop_iters);
+}
+BENCHMARK(BM_LoweredWhileLoopManyIterations)
+    ->UseRealTime()
+    ->ArgPair(10000, 1)
+    ->ArgPair(10000, 8)
+    ->ArgPair(10000, 64);
+
 static void BM_LoweredWhileLoopWithTransfer(
     ::testing::benchmark::State& state) {
   const int loop_iters = state.range(0);
@@ -15,18 +15,49 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
 
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "xla/stream_executor/event.h"
+#include "xla/stream_executor/stream.h"
 #include "xla/tsl/framework/bfc_allocator.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tsl/platform/logging.h"
 
 namespace tensorflow {
 
 namespace {
+
+auto* fragmentation_gauge = monitoring::Gauge<double, 1>::New(
+    "/tensorflow/core/gpu_bfc_allocator/fragmentation",
+    "Fraction of the free memory of the allocator that is not part of its "
+    "largest free chunk.",
+    "allocator");
+
+auto* largest_free_chunk_gauge = monitoring::Gauge<int64_t, 1>::New(
+    "/tensorflow/core/gpu_bfc_allocator/largest_free_chunk_bytes",
+    "Size of the largest free chunk of the allocator.", "allocator");
+
+auto* bin_free_bytes_gauge = monitoring::Gauge<int64_t, 2>::New(
+    "/tensorflow/core/gpu_bfc_allocator/bin_free_bytes",
+    "Free bytes in each bin of the allocator. A bin is labelled with the "
+    "smallest size of its chunks.",
+    "allocator", "bin");
+
+auto* released_bytes_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/gpu_bfc_allocator/released_bytes",
+    "Bytes of free regions returned to the driver while the allocator was "
+    "idle.",
+    "allocator");
+
 bool GetAllowGrowthValue(bool orig_value) {
   const char* force_allow_growth_string =
       std::getenv("TF_FORCE_GPU_ALLOW_GROWTH");
@@ -96,6 +127,194 @@ GPUBFCAllocator::GPUBFCAllocator(
         }
         o.fragmentation_fraction = opts.fragmentation_fraction;
         return o;
-      }()) {}
+      }()) {
+  if (opts.telemetry_interval_secs > 0) {
+    telemetry_thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), absl::StrCat(name, "_telemetry"),
+        [this, interval_secs = opts.telemetry_interval_secs,
+         release_free_regions = opts.release_free_regions_when_idle]() {
+          TelemetryLoop(interval_secs, release_free_regions);
+        }));
+  }
+}
+
+GPUBFCAllocator::~GPUBFCAllocator() {
+  {
+    mutex_lock l(telemetry_mu_);
+    stop_telemetry_ = true;
+  }
+  telemetry_cv_.notify_all();
+  // Joins the thread.
+  telemetry_thread_.reset();
+}
+
+void GPUBFCAllocator::ExportFragmentationTelemetry() {
+  const std::string name = Name();
+  FragmentationStats stats = GetFragmentationStats();
+  fragmentation_gauge->GetCell(name)->Set(stats.fragmentation);
+  largest_free_chunk_gauge->GetCell(name)->Set(stats.largest_free_chunk);
+  for (size_t b = 0; b < stats.bin_free_bytes.size(); ++b) {
+    bin_free_bytes_gauge->GetCell(name, absl::StrCat(256LL << b))
+        ->Set(stats.bin_free_bytes[b]);
+  }
+}
+
+void GPUBFCAllocator::TelemetryLoop(int64_t interval_secs,
+                                    bool release_free_regions) {
+  int64_t last_num_allocs = -1;
+  int64_t last_bytes_in_use = -1;
+  mutex_lock l(telemetry_mu_);
+  while (!stop_telemetry_) {
+    telemetry_cv_.wait_for(l, std::chrono::seconds(interval_secs));
+    if (stop_telemetry_) break;
+
+    if (release_free_regions) {
+      std::optional<tsl::AllocatorStats> stats = GetStats();
+      if (stats.has_value()) {
+        // The allocator is idle if nothing was allocated or freed since the
+        // last round.
+        if (stats->num_allocs == last_num_allocs &&
+            stats->bytes_in_use == last_bytes_in_use) {
+          const size_t released = ReleaseFreeRegions();
+          if (released > 0) {
+            VLOG(1) << Name() << " released " << released
+                    << " bytes of free regions while idle";
+            released_bytes_counter->GetCell(Name())->IncrementBy(released);
+          }
+        }
+        last_num_allocs = stats->num_allocs;
+        last_bytes_in_use = stats->bytes_in_use;
+      }
+    }
+    ExportFragmentationTelemetry();
+  }
+}
+
+GPUStreamRegionPool::GPUStreamRegionPool(
+    std::unique_ptr<tsl::SubAllocator> sub_allocator,
+    stream_executor::StreamExecutor* executor)
+    : sub_allocator_(std::move(sub_allocator)), executor_(executor) {}
+
+GPUStreamRegionPool::~GPUStreamRegionPool() {
+  mutex_lock l(mu_);
+  FreeCachedRegions();
+}
+
+void* GPUStreamRegionPool::Alloc(size_t alignment, size_t num_bytes,
+                                 size_t* bytes_received,
+                                 stream_executor::Stream* stream) {
+  {
+    mutex_lock l(mu_);
+    void* ptr = TakeCachedRegion(alignment, num_bytes, stream);
+    if (ptr != nullptr) {
+      *bytes_received = num_bytes;
+      return ptr;
+    }
+  }
+  void* ptr = sub_allocator_->Alloc(alignment, num_bytes, bytes_received);
+  if (ptr != nullptr) return ptr;
+
+  // The cached regions of other streams may be what the device is short of.
+  // Freeing them synchronizes the device, so it is only done as a last
+  // resort.
+  {
+    mutex_lock l(mu_);
+    if (regions_.empty()) return nullptr;
+    VLOG(1) << "Freeing " << regions_.size()
+            << " cached GPU regions to allocate " << num_bytes << " bytes";
+    FreeCachedRegions();
+  }
+  return sub_allocator_->Alloc(alignment, num_bytes, bytes_received);
+}
+
+void GPUStreamRegionPool::Free(void* ptr, size_t num_bytes,
+                               stream_executor::Stream* stream) {
+  if (stream == nullptr) {
+    sub_allocator_->Free(ptr, num_bytes);
+    return;
+  }
+  std::unique_ptr<stream_executor::Event> released;
+  {
+    mutex_lock l(mu_);
+    if (!events_.empty()) {
+      released = std::move(events_.back());
+      events_.pop_back();
+    }
+  }
+  if (released == nullptr) {
+    auto event = executor_->CreateEvent();
+    if (!event.ok()) {
+      LOG(WARNING) << "Failed to create an event to cache a GPU region: "
+                   << event.status();
+      sub_allocator_->Free(ptr, num_bytes);
+      return;
+    }
+    released = std::move(*event);
+  }
+  absl::Status status = stream->RecordEvent(released.get());
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to record an event to cache a GPU region: "
+                 << status;
+    sub_allocator_->Free(ptr, num_bytes);
+    return;
+  }
+  mutex_lock l(mu_);
+  regions_.push_back({ptr, num_bytes, stream, std::move(released)});
+}
+
+size_t GPUStreamRegionPool::cached_bytes() const {
+  mutex_lock l(mu_);
+  size_t cached_bytes = 0;
+  for (const Region& region : regions_) cached_bytes += region.num_bytes;
+  return cached_bytes;
+}
+
+void* GPUStreamRegionPool::TakeCachedRegion(size_t alignment,
+                                            size_t num_bytes,
+                                            stream_executor::Stream* stream) {
+  // Prefers a region last used on `stream`, which needs no waiting.
+  auto usable = regions_.end();
+  for (auto it = regions_.begin(); it != regions_.end(); ++it) {
+    if (it->num_bytes != num_bytes ||
+        reinterpret_cast<uintptr_t>(it->ptr) % alignment != 0) {
+      continue;
+    }
+    if (it->stream == stream) {
+      usable = it;
+      break;
+    }
+    if (usable == regions_.end() &&
+        it->released->PollForStatus() ==
+            stream_executor::Event::Status::kComplete) {
+      usable = it;
+    }
+  }
+  if (usable == regions_.end()) return nullptr;
+  void* ptr = usable->ptr;
+  events_.push_back(std::move(usable->released));
+  regions_.erase(usable);
+  return ptr;
+}
+
+void GPUStreamRegionPool::FreeCachedRegions() {
+  for (Region& region : regions_) {
+    sub_allocator_->Free(region.ptr, region.num_bytes);
+    events_.push_back(std::move(region.released));
+  }
+  regions_.clear();
+}
+
+GPUStreamSubAllocator::GPUStreamSubAllocator(GPUStreamRegionPool* pool)
+    : tsl::SubAllocator(/*alloc_visitors=*/{}, /*free_visitors=*/{}),
+      pool_(pool) {}
+
+void* GPUStreamSubAllocator::Alloc(size_t alignment, size_t num_bytes,
+                                   size_t* bytes_received) {
+  return pool_->Alloc(alignment, num_bytes, bytes_received, stream_.load());
+}
+
+void GPUStreamSubAllocator::Free(void* ptr, size_t num_bytes) {
+  pool_->Free(ptr, num_bytes, stream_.load());
+}
 
 }  // namespace tensorflow
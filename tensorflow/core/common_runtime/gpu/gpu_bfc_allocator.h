@@ -16,12 +16,21 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_BFC_ALLOCATOR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_BFC_ALLOCATOR_H_
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
+#include "xla/stream_executor/event.h"
+#include "xla/stream_executor/stream.h"
+#include "xla/stream_executor/stream_executor.h"
 #include "xla/tsl/framework/allocator.h"
 #include "xla/tsl/framework/bfc_allocator.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tsl/platform/macros.h"
 
 namespace tensorflow {
@@ -46,16 +55,134 @@ class GPUBFCAllocator : public tsl::BFCAllocator {
 
     double fragmentation_fraction = 0;
     bool allow_retry_on_failure = true;
+
+    // If > 0, a background thread exports the fragmentation of the allocator
+    // to monitoring every `telemetry_interval_secs` seconds.
+    int64_t telemetry_interval_secs = 0;
+
+    // If true, the background thread also returns the regions without memory
+    // in use to the driver when no memory was allocated or freed during a
+    // whole telemetry interval.
+    bool release_free_regions_when_idle = false;
   };
 
   GPUBFCAllocator(std::unique_ptr<tsl::SubAllocator> sub_allocator,
                   size_t total_memory, const std::string& name,
                   const Options& opts);
 
-  ~GPUBFCAllocator() override {}
+  ~GPUBFCAllocator() override;
 
   GPUBFCAllocator(const GPUBFCAllocator&) = delete;
   void operator=(const GPUBFCAllocator&) = delete;
+
+  // Exports the fragmentation of the allocator to monitoring: the fraction of
+  // the free memory outside of the largest free chunk, the size of that chunk,
+  // and the free bytes of each bin.
+  void ExportFragmentationTelemetry();
+
+ private:
+  // Body of the background thread, which runs until the allocator is
+  // destroyed.
+  void TelemetryLoop(int64_t interval_secs, bool release_free_regions);
+
+  mutex telemetry_mu_;
+  condition_variable telemetry_cv_;
+  bool stop_telemetry_ TF_GUARDED_BY(telemetry_mu_) = false;
+  std::unique_ptr<Thread> telemetry_thread_;
+};
+
+// Caches the regions released by the GPUBFCAllocators of the compute streams
+// of one GPU, e.g. when they garbage collect, so that the allocators of other
+// streams reuse them instead of synchronizing the device to free and allocate
+// memory. A region released by a stream is reused by that stream right away,
+// as the stream's later work is ordered after its earlier uses of the region,
+// and by other streams once an event recorded on the releasing stream at
+// release time has completed.
+//
+// Regions are only handed out at exactly the requested size, so that the
+// allocators stay within their memory limits.
+//
+// Thread-safe.
+class GPUStreamRegionPool {
+ public:
+  GPUStreamRegionPool(std::unique_ptr<tsl::SubAllocator> sub_allocator,
+                      stream_executor::StreamExecutor* executor);
+
+  // Frees the cached regions.
+  ~GPUStreamRegionPool();
+
+  // Returns a region of at least `num_bytes` for use on `stream`: a cached
+  // one if one is safe to use on `stream`, else a new one. If the
+  // sub-allocator is out of memory, frees the cached regions and retries.
+  void* Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received,
+              stream_executor::Stream* stream);
+
+  // Caches the region at `ptr`, last used on `stream`. If `stream` is null,
+  // or recording the release event fails, frees the region instead.
+  void Free(void* ptr, size_t num_bytes, stream_executor::Stream* stream);
+
+  bool SupportsCoalescing() const {
+    return sub_allocator_->SupportsCoalescing();
+  }
+  tsl::AllocatorMemoryType GetMemoryType() const {
+    return sub_allocator_->GetMemoryType();
+  }
+
+  // Returns the total size of the cached regions.
+  size_t cached_bytes() const;
+
+ private:
+  struct Region {
+    void* ptr;
+    size_t num_bytes;
+    // The stream the region was last used on, and an event recorded on it
+    // when the region was released.
+    stream_executor::Stream* stream;
+    std::unique_ptr<stream_executor::Event> released;
+  };
+
+  // Removes and returns a cached region of `num_bytes` that is safe to use on
+  // `stream`, or nullptr if there is none.
+  void* TakeCachedRegion(size_t alignment, size_t num_bytes,
+                         stream_executor::Stream* stream)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void FreeCachedRegions() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::unique_ptr<tsl::SubAllocator> sub_allocator_;
+  stream_executor::StreamExecutor* const executor_;  // not owned
+
+  mutable mutex mu_;
+  std::vector<Region> regions_ TF_GUARDED_BY(mu_);
+  // Events of regions that were handed out, for reuse.
+  std::vector<std::unique_ptr<stream_executor::Event>> events_
+      TF_GUARDED_BY(mu_);
+};
+
+// The SubAllocator of the GPUBFCAllocator of one compute stream, which gets
+// its regions from a GPUStreamRegionPool shared with the other streams of the
+// GPU.
+class GPUStreamSubAllocator : public tsl::SubAllocator {
+ public:
+  explicit GPUStreamSubAllocator(GPUStreamRegionPool* pool);
+
+  // Sets the compute stream the allocated memory is used on. Until it is set,
+  // released regions are freed rather than cached.
+  void SetStream(stream_executor::Stream* stream) { stream_.store(stream); }
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override;
+  void Free(void* ptr, size_t num_bytes) override;
+  bool SupportsCoalescing() const override {
+    return pool_->SupportsCoalescing();
+  }
+  tsl::AllocatorMemoryType GetMemoryType() const override {
+    return pool_->GetMemoryType();
+  }
+
+ private:
+  GPUStreamRegionPool* const pool_;  // not owned
+  std::atomic<stream_executor::Stream*> stream_{nullptr};
 };
 
 }  // namespace tensorflow
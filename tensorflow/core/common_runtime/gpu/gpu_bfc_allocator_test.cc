@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 
 #include <algorithm>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -26,6 +27,7 @@ limitations under the License.
 #include "xla/stream_executor/gpu/gpu_init.h"
 #include "xla/stream_executor/stream_executor.h"
 #include "xla/tsl/framework/device_id.h"
+#include "xla/tsl/lib/core/status_test_util.h"
 #include "xla/tsl/lib/gtl/inlined_vector.h"
 #include "xla/tsl/lib/random/simple_philox.h"
 #include "tensorflow/core/common_runtime/device/device_mem_allocator.h"
@@ -42,10 +44,13 @@ limitations under the License.
 namespace tsl {
 namespace {
 using stream_executor::GPUMachineManager;
+using stream_executor::StreamExecutor;
 using tensorflow::BinSummary;
 using tensorflow::DeviceMemAllocator;
 using tensorflow::GPUBFCAllocator;
 using tensorflow::GPUOptions;
+using tensorflow::GPUStreamRegionPool;
+using tensorflow::GPUStreamSubAllocator;
 using tensorflow::TypedAllocator;
 
 void CheckStats(Allocator* a, int64_t num_allocs, int64_t bytes_in_use,
@@ -299,6 +304,37 @@ TEST_P(GPUBFCAllocatorTest, AllocationsAndDeallocationsWithGrowth) {
   }
 }
 
+TEST_P(GPUBFCAllocatorTest, ReleaseFreeRegions) {
+  GPUBFCAllocator::Options options;
+  options.allow_growth = true;
+  GPUBFCAllocator a(GetParam()(1ull << 32), 1LL << 31, "GPU_0_bfc", options);
+
+  void* in_use = a.AllocateRaw(1, 1 << 20);
+  ASSERT_NE(in_use, nullptr);
+  // The region holds memory in use.
+  EXPECT_EQ(a.ReleaseFreeRegions(), size_t{0});
+
+  GPUBFCAllocator::FragmentationStats stats = a.GetFragmentationStats();
+  EXPECT_EQ(stats.bin_free_bytes.size(), stats.bin_free_chunks.size());
+  int64_t free_bytes = 0;
+  for (int64_t bytes : stats.bin_free_bytes) free_bytes += bytes;
+  EXPECT_GE(free_bytes, stats.largest_free_chunk);
+  EXPECT_GE(stats.fragmentation, 0);
+  EXPECT_LE(stats.fragmentation, 1);
+
+  a.DeallocateRaw(in_use);
+  EXPECT_GT(a.ReleaseFreeRegions(), size_t{0});
+  std::optional<AllocatorStats> allocator_stats = a.GetStats();
+  ASSERT_TRUE(allocator_stats);
+  EXPECT_EQ(allocator_stats->pool_bytes, 0);
+  EXPECT_EQ(a.GetFragmentationStats().largest_free_chunk, 0);
+
+  // The allocator grows again on demand.
+  void* ptr = a.AllocateRaw(1, 1 << 20);
+  EXPECT_NE(ptr, nullptr);
+  a.DeallocateRaw(ptr);
+}
+
 TEST_P(GPUBFCAllocatorTest, DISABLED_AllocatorReceivesZeroMemory) {
   GPUBFCAllocator a(GetParam()(1ul << 62), 1UL << 60, "GPU_0_bfc", {});
   GPUBFCAllocator b(GetParam()(1ul << 62), 1UL << 60, "GPU_0_bfc", {});
@@ -587,6 +623,73 @@ TEST_F(GPUBFCAllocatorTest_SubAllocatorSpecific,
   EXPECT_EQ(big_alloc, nullptr);
 }
 
+TEST(GPUStreamRegionPoolTest, HandsRegionsToOtherStreamsWhenReleased) {
+  StreamExecutor* executor =
+      GPUMachineManager()->ExecutorForDevice(0).value();
+  GPUStreamRegionPool pool(CreateGPUMemAllocator(/*ignored*/ 0), executor);
+  auto stream_a = executor->CreateStream().value();
+  auto stream_b = executor->CreateStream().value();
+  GPUStreamSubAllocator a(&pool);
+  GPUStreamSubAllocator b(&pool);
+  a.SetStream(stream_a.get());
+  b.SetStream(stream_b.get());
+
+  constexpr size_t k1MiB = 1 << 20;
+  size_t bytes_received;
+  void* ptr = a.Alloc(256, k1MiB, &bytes_received);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_EQ(bytes_received, k1MiB);
+  a.Free(ptr, k1MiB);
+  EXPECT_EQ(pool.cached_bytes(), k1MiB);
+
+  // The releasing stream reuses the region right away.
+  EXPECT_EQ(a.Alloc(256, k1MiB, &bytes_received), ptr);
+  EXPECT_EQ(pool.cached_bytes(), 0);
+  a.Free(ptr, k1MiB);
+
+  // Other streams do once the releasing stream is done with it.
+  TF_ASSERT_OK(stream_a->BlockHostUntilDone());
+  EXPECT_EQ(b.Alloc(256, k1MiB, &bytes_received), ptr);
+  b.Free(ptr, k1MiB);
+
+  // Regions are only handed out at the requested size.
+  void* other_ptr = a.Alloc(256, 2 * k1MiB, &bytes_received);
+  ASSERT_NE(other_ptr, nullptr);
+  EXPECT_NE(other_ptr, ptr);
+  a.Free(other_ptr, 2 * k1MiB);
+  EXPECT_EQ(pool.cached_bytes(), 3 * k1MiB);
+}
+
+TEST(GPUStreamRegionPoolTest, BFCAllocatorsShareReleasedRegions) {
+  StreamExecutor* executor =
+      GPUMachineManager()->ExecutorForDevice(0).value();
+  GPUStreamRegionPool pool(CreateGPUMemAllocator(/*ignored*/ 0), executor);
+  auto stream = executor->CreateStream().value();
+  GPUBFCAllocator::Options options;
+  options.allow_growth = true;
+  options.garbage_collection = true;
+
+  void* ptr;
+  {
+    auto sub_allocator = std::make_unique<GPUStreamSubAllocator>(&pool);
+    sub_allocator->SetStream(stream.get());
+    GPUBFCAllocator a(std::move(sub_allocator), 1 << 30, "GPU_0_bfc",
+                      options);
+    ptr = a.AllocateRaw(1, 1 << 20);
+    ASSERT_NE(ptr, nullptr);
+    a.DeallocateRaw(ptr);
+  }
+  // The destroyed allocator's region is cached for the next allocator.
+  EXPECT_GT(pool.cached_bytes(), 0);
+  auto sub_allocator = std::make_unique<GPUStreamSubAllocator>(&pool);
+  sub_allocator->SetStream(stream.get());
+  GPUBFCAllocator b(std::move(sub_allocator), 1 << 30, "GPU_1_bfc", options);
+  void* other_ptr = b.AllocateRaw(1, 1 << 20);
+  EXPECT_EQ(other_ptr, ptr);
+  EXPECT_EQ(pool.cached_bytes(), 0);
+  b.DeallocateRaw(other_ptr);
+}
+
 // Tests that use private functions and cannot be trivially parameterized for
 // both suballocator types.
 class GPUBFCAllocatorPrivateMethodsTest_SubAllocatorSpecific
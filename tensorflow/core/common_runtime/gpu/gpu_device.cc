@@ -42,6 +42,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_split.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
@@ -55,11 +56,13 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_manager.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_assignment.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
@@ -353,6 +356,18 @@ class BaseGPUDevice::StreamGroupFactory {
                 << "] = " << group->device_to_device.back();
       }
     }
+    // Extra compute streams are created on demand, as a later session may ask
+    // for more of them than the first one.
+    const int num_compute_streams =
+        options.experimental().num_compute_streams();
+    while (static_cast<int>(group->extra_compute.size()) + 1 <
+           num_compute_streams) {
+      se::Stream* stream = GetInitializedStream(executor, group->priority);
+      if (stream == nullptr) break;
+      group->extra_compute.push_back(stream);
+      VLOG(2) << "Created compute_stream[" << stream_group_within_gpu << "]["
+              << group->extra_compute.size() << "] = " << stream;
+    }
     return group;
   }
 
@@ -408,13 +423,21 @@ class BaseGPUDevice::StreamGroupFactory {
         }
         stream.device_to_device.pop_back();
       }
+      while (!stream.extra_compute.empty()) {
+#ifndef TF_GPU_USE_PJRT  // When PJRT is used, streams are managed by
+                         // PjRtClient.
+        delete stream.extra_compute.back();
+#endif
+        stream.extra_compute.pop_back();
+      }
     }
     streams_.clear();
   }
 
   std::optional<tsl::TfDeviceId> FindTfDeviceId(se::Stream* compute) const {
     for (const auto& item : streams_) {
-      if (item.second.compute == compute) {
+      if (item.second.compute == compute ||
+          absl::c_linear_search(item.second.extra_compute, compute)) {
         return tsl::TfDeviceId(std::get<0>(item.first));
       }
     }
@@ -446,6 +469,160 @@ class BaseGPUDevice::StreamGroupFactory {
   void operator=(const StreamGroupFactory&) = delete;
 };
 
+namespace {
+
+// Wraps the allocator of a GPU that runs ops on several compute streams. With
+// a single stream, memory freed by an op can be handed out again right away,
+// as the kernels of later ops are queued behind the ones still reading it.
+// This no longer holds with several streams, so freed memory is only returned
+// to the wrapped allocator once every compute stream has passed the point
+// where it was freed. Frees are batched so that one round of events covers
+// all the memory freed in the meantime.
+class MultiStreamAllocator : public Allocator {
+ public:
+  MultiStreamAllocator(Allocator* allocator, std::vector<se::Stream*> streams,
+                       EventMgr* em)
+      : allocator_(allocator), streams_(std::move(streams)), em_(em) {}
+
+  std::string Name() override { return allocator_->Name(); }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    if (!HasPendingFrees()) {
+      return allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+    }
+    // Waiting for the streams is cheaper than the retries of the wrapped
+    // allocator, so try without them first.
+    AllocationAttributes no_retry(/*retry_on_failure=*/false,
+                                  allocation_attr.allocation_will_be_logged,
+                                  allocation_attr.freed_by_func);
+    void* ptr = allocator_->AllocateRaw(alignment, num_bytes, no_retry);
+    if (ptr != nullptr) return ptr;
+    FlushPendingFrees();
+    return allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    if (ptr == nullptr) return;
+    {
+      mutex_lock l(mu_);
+      if (in_flight_remaining_ > 0) {
+        pending_.push_back(ptr);
+        return;
+      }
+      in_flight_.push_back(ptr);
+      in_flight_remaining_ = streams_.size();
+    }
+    WaitForStreams();
+  }
+
+  bool TracksAllocationSizes() const override {
+    return allocator_->TracksAllocationSizes();
+  }
+  size_t RequestedSize(const void* ptr) const override {
+    return allocator_->RequestedSize(ptr);
+  }
+  size_t AllocatedSize(const void* ptr) const override {
+    return allocator_->AllocatedSize(ptr);
+  }
+  int64_t AllocationId(const void* ptr) const override {
+    return allocator_->AllocationId(ptr);
+  }
+  absl::optional<AllocatorStats> GetStats() override {
+    return allocator_->GetStats();
+  }
+  bool ClearStats() override { return allocator_->ClearStats(); }
+  void SetSafeFrontier(uint64 count) override {
+    allocator_->SetSafeFrontier(count);
+  }
+  AllocatorMemoryType GetMemoryType() const override {
+    return allocator_->GetMemoryType();
+  }
+
+ private:
+  bool HasPendingFrees() {
+    mutex_lock l(mu_);
+    return in_flight_remaining_ > 0;
+  }
+
+  // Frees the in flight batch once all streams are done with it.
+  void WaitForStreams() {
+    for (se::Stream* stream : streams_) {
+      em_->ThenExecute(stream, [this]() { StreamDone(); });
+    }
+  }
+
+  void StreamDone() {
+    std::vector<void*> freed;
+    bool pending = false;
+    {
+      mutex_lock l(mu_);
+      if (--in_flight_remaining_ > 0) return;
+      freed.swap(in_flight_);
+      if (!pending_.empty()) {
+        in_flight_.swap(pending_);
+        in_flight_remaining_ = streams_.size();
+        pending = true;
+      }
+    }
+    for (void* ptr : freed) allocator_->DeallocateRaw(ptr);
+    if (pending) WaitForStreams();
+  }
+
+  // Blocks until the streams are done with the memory freed so far that is not
+  // in flight yet, and frees it.
+  void FlushPendingFrees() {
+    for (se::Stream* stream : streams_) {
+      stream->BlockHostUntilDone().IgnoreError();
+    }
+    std::vector<void*> freed;
+    {
+      mutex_lock l(mu_);
+      freed.swap(pending_);
+    }
+    for (void* ptr : freed) allocator_->DeallocateRaw(ptr);
+  }
+
+  Allocator* const allocator_;  // not owned
+  const std::vector<se::Stream*> streams_;
+  EventMgr* const em_;  // not owned
+
+  mutex mu_;
+  // Memory waiting for the events queued on all streams.
+  std::vector<void*> in_flight_ TF_GUARDED_BY(mu_);
+  // Number of streams that did not pass their event yet. Memory is in flight
+  // as long as this is > 0.
+  int in_flight_remaining_ TF_GUARDED_BY(mu_) = 0;
+  // Memory freed while a batch was in flight.
+  std::vector<void*> pending_ TF_GUARDED_BY(mu_);
+};
+
+// Returns the MultiStreamAllocator of a GPU. Like the allocators of
+// GPUProcessState, it is never destroyed as freed memory may still be waiting
+// for the streams when the device goes away.
+Allocator* GetMultiStreamAllocator(tsl::TfDeviceId tf_device_id,
+                                   Allocator* allocator,
+                                   std::vector<se::Stream*> streams,
+                                   EventMgr* em) {
+  static mutex* mu = new mutex;
+  static auto* allocators =
+      new std::map<std::tuple<int, size_t>, MultiStreamAllocator*>;
+  mutex_lock l(*mu);
+  MultiStreamAllocator*& multi_stream_allocator =
+      (*allocators)[{tf_device_id.value(), streams.size()}];
+  if (multi_stream_allocator == nullptr) {
+    multi_stream_allocator =
+        new MultiStreamAllocator(allocator, std::move(streams), em);
+  }
+  return multi_stream_allocator;
+}
+
+}  // namespace
+
 BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
                              Bytes memory_limit, const DeviceLocality& locality,
                              tsl::TfDeviceId tf_device_id,
@@ -481,14 +658,22 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
 BaseGPUDevice::~BaseGPUDevice() {
   delete accelerator_device_info_;
   if (scratch_) gpu_allocator_->DeallocateRaw(scratch_);
+  for (char* scratch : extra_scratch_) gpu_allocator_->DeallocateRaw(scratch);
   device_context_->Unref();
+  for (GPUDeviceContext* dc : extra_device_contexts_) dc->Unref();
 }
 
 // This should be idempotent if already initialized.
 Status BaseGPUDevice::InitScratchBuffers() {
   mutex_lock l(scratch_init_mutex_);
-  if (!scratch_) {
-    DCHECK(stream_);
+  if (scratch_ &&
+      static_cast<int>(extra_scratch_.size()) + 1 == num_compute_streams_) {
+    return OkStatus();
+  }
+  DCHECK(stream_);
+  // Each compute stream gets its own buffer, as Eigen kernels use it as a
+  // semaphore.
+  auto init_scratch_buffer = [this](char** scratch) -> Status {
     size_t scratch_buffer_size = Eigen::kGpuScratchSize + sizeof(unsigned int);
     profiler::ScopedMemoryDebugAnnotation op_annotation("ScratchBuffer");
     void* scratch_buffer = gpu_allocator_->AllocateRaw(
@@ -502,7 +687,14 @@ Status BaseGPUDevice::InitScratchBuffers() {
         se::DeviceMemoryBase(scratch_buffer, scratch_buffer_size));
     TF_RETURN_IF_ERROR(executor_->SynchronousMemZero(
         &mem, Eigen::kGpuScratchSize + sizeof(unsigned int)));
-    scratch_ = static_cast<char*>(scratch_buffer);
+    *scratch = static_cast<char*>(scratch_buffer);
+    return OkStatus();
+  };
+  if (!scratch_) TF_RETURN_IF_ERROR(init_scratch_buffer(&scratch_));
+  while (static_cast<int>(extra_scratch_.size()) + 1 < num_compute_streams_) {
+    char* scratch = nullptr;
+    TF_RETURN_IF_ERROR(init_scratch_buffer(&scratch));
+    extra_scratch_.push_back(scratch);
   }
   return OkStatus();
 }
@@ -550,6 +742,8 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
   stream_ = StreamGroupFactory::Global().GetOrCreate(
       tf_device_id_, 0, executor_, options.config.gpu_options());
 #endif  // TF_GPU_USE_PJRT
+  GPUProcessState::singleton()->SetGPUAllocatorStream(tf_device_id_,
+                                                      stream_->compute);
 
   // Get an allocator that allocates pinned memory on host.
   AllocatorAttributes attr;
@@ -565,6 +759,27 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
                            stream_->host_to_device, stream_->device_to_host,
                            stream_->device_to_device, host_memory_allocator);
 
+  num_compute_streams_ = std::max(
+      1, options.config.gpu_options().experimental().num_compute_streams());
+  const int num_streams = stream_->extra_compute.size() + 1;
+  if (num_compute_streams_ > num_streams) {
+    LOG(WARNING) << "Using " << num_streams
+                 << " compute streams on GPU " << tf_device_id_.value()
+                 << " instead of the " << num_compute_streams_
+                 << " requested by "
+                 << "GPUOptions.experimental.num_compute_streams.";
+    num_compute_streams_ = num_streams;
+  }
+  for (int i = 1; i < num_compute_streams_; ++i) {
+    extra_device_contexts_.push_back(new GPUDeviceContext(
+        i, compute_stream(i),
+#if TENSORFLOW_USE_ROCM
+        stream_->nccl,
+#endif
+        stream_->host_to_device, stream_->device_to_host,
+        stream_->device_to_device, host_memory_allocator));
+  }
+
   em_ = EventMgrFactory::Singleton()->GetEventMgr(executor_,
                                                   options.config.gpu_options());
 
@@ -592,6 +807,14 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
         tracker_params, Env::Default(), stream_->compute, timing_counter,
         timestamped_allocator_ ? gpu_allocator_ : nullptr, em_));
   }
+  if (num_compute_streams_ > 1) {
+    std::vector<se::Stream*> streams;
+    for (int i = 0; i < num_compute_streams_; ++i) {
+      streams.push_back(compute_stream(i));
+    }
+    gpu_allocator_ = GetMultiStreamAllocator(tf_device_id_, gpu_allocator_,
+                                             std::move(streams), em_);
+  }
 
   accelerator_device_info_ = new DeviceBase::AcceleratorDeviceInfo;
   accelerator_device_info_->stream = stream_->compute;
@@ -674,6 +897,32 @@ string BaseGPUDevice::ComputeOpKernelDebugString(const OpKernel& op_kernel,
                          stream_id, "]");
 }
 
+Status BaseGPUDevice::WaitForInputStreams(const OpKernel& op_kernel,
+                                          int stream_id, se::Stream* stream) {
+  std::vector<int> waits;
+  if (!TryGetNodeAttr(op_kernel.def(), kGpuStreamWaitsAttr, &waits)) {
+    return OkStatus();
+  }
+  for (int wait : waits) {
+    const int wait_id = wait % num_compute_streams_;
+    if (wait_id == stream_id) continue;
+    TF_RETURN_IF_ERROR(stream->WaitFor(compute_stream(wait_id)));
+  }
+  return OkStatus();
+}
+
+void BaseGPUDevice::HoldInputsUntilDone(OpKernelContext* context,
+                                        se::Stream* stream) {
+  std::vector<Tensor> inputs;
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    if (context->has_input(i) && !context->input_is_ref(i)) {
+      inputs.push_back(context->input(i));
+    }
+  }
+  if (inputs.empty()) return;
+  em_->ThenExecute(stream, [inputs = std::move(inputs)]() {});
+}
+
 std::optional<tsl::TfDeviceId> BaseGPUDevice::FindTfDeviceId(
     se::Stream* compute) {
   return StreamGroupFactory::Global().FindTfDeviceId(compute);
@@ -799,8 +1048,18 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
     LogInputs(op_kernel, context);
   }
 
+  if (num_compute_streams_ > 1) {
+    Status s = WaitForInputStreams(*op_kernel, stream_id, stream);
+    if (!s.ok()) {
+      context->SetStatus(s);
+      return;
+    }
+  }
+
   op_kernel->Compute(context);
 
+  if (num_compute_streams_ > 1) HoldInputsUntilDone(context, stream);
+
   if (should_log_inputs_and_outputs) {
     LogOutputs(op_kernel, context);
   }
@@ -850,10 +1109,13 @@ Status BaseGPUDevice::Sync() {
 
   // Device::Sync is supposed to block until all operations queued on the device
   // at the time of the call have completed.  On GPUs, only operations enqueued
-  // on the compute stream can remain pending after the (Async)OpKernel that
+  // on the compute streams can remain pending after the (Async)OpKernel that
   // enqueued the operation has completed.  We do use other streams for copies
   // and collectives, but in those cases the (Async)OpKernels themselves block
   // until the queued operation has finished.
+  for (int i = 1; i < num_compute_streams_; ++i) {
+    TF_RETURN_IF_ERROR(compute_stream(i)->BlockHostUntilDone());
+  }
   return stream_->compute->BlockHostUntilDone();
 }
 
@@ -885,6 +1147,19 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
   }
 
   ScopedActivateContext scoped_activation{stream->parent()};
+  if (num_compute_streams_ > 1) {
+    Status s = WaitForInputStreams(*op_kernel, stream_id, stream);
+    if (!s.ok()) {
+      context->SetStatus(s);
+      done();
+      return;
+    }
+    AsyncOpKernel::DoneCallback parent_done = std::move(done);
+    done = [this, parent_done = std::move(parent_done), context, stream]() {
+      HoldInputsUntilDone(context, stream);
+      parent_done();
+    };
+  }
   op_kernel->ComputeAsync(context, std::move(done));
 }
 
@@ -1289,11 +1564,12 @@ void BaseGPUDevice::ReinitializeDevice(OpKernelContext* context,
   ConcretePerOpGpuDevice* concrete_device =
       static_cast<ConcretePerOpGpuDevice*>(device);
   DCHECK(concrete_device);
-  DCHECK_EQ(stream_id, 0);
+  DCHECK_LT(stream_id, num_compute_streams_);
   const gpuStream_t gpu_stream = reinterpret_cast<gpuStream_t>(
-      stream_->compute->platform_specific_handle().stream);
-  concrete_device->Reinitialize(context, gpu_stream, tf_device_id_, allocator,
-                                scratch_);
+      compute_stream(stream_id)->platform_specific_handle().stream);
+  concrete_device->Reinitialize(
+      context, gpu_stream, tf_device_id_, allocator,
+      stream_id == 0 ? scratch_ : extra_scratch_[stream_id - 1]);
 }
 
 PerOpGpuDevice* BaseGPUDevice::MakeGpuDevice() {
@@ -1310,7 +1586,6 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
     const int stream_id = gpu_dc->stream_id();
     VLOG(1) << "  eigen_gpu_device(" << dc << ") => stream[" << stream_id
             << "]";
-    CHECK_EQ(stream_id, 0);
     ReinitializeDevice(context, device, stream_id, allocator);
   } else {
     ReinitializeDevice(context, device, 0, allocator);
@@ -1318,6 +1593,21 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
   return OkStatus();
 }
 
+Status BaseGPUDevice::MaybeRewriteGraph(std::unique_ptr<Graph>* graph) {
+  AssignGpuStreams(num_compute_streams_, graph->get());
+  return OkStatus();
+}
+
+DeviceContext* BaseGPUDevice::GetNodeDeviceContext(const Node& node) {
+  if (num_compute_streams_ <= 1) return nullptr;
+  int stream_id = 0;
+  if (!TryGetNodeAttr(node.attrs(), kGpuStreamAttr, &stream_id)) {
+    return nullptr;
+  }
+  stream_id %= num_compute_streams_;
+  return stream_id == 0 ? nullptr : extra_device_contexts_[stream_id - 1];
+}
+
 Allocator* BaseGPUDevice::GetScopedAllocator(AllocatorAttributes attr,
                                              int64_t step_id) {
   if (attr.scope_id > 0) {
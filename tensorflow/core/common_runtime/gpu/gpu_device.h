@@ -106,6 +106,9 @@ class BaseGPUDevice : public LocalDevice {
     se::Stream* host_to_device = nullptr;
     se::Stream* device_to_host = nullptr;
     gtl::InlinedVector<se::Stream*, 4> device_to_device;
+    // Compute streams other than `compute`, used when
+    // GPUOptions.experimental.num_compute_streams > 1.
+    gtl::InlinedVector<se::Stream*, 4> extra_compute;
     int priority = 0;
   };
 
@@ -139,6 +142,14 @@ class BaseGPUDevice : public LocalDevice {
                                DeviceContext* dc,
                                Allocator* allocator) override;
 
+  // Assigns the ops of `graph` to the compute streams of the device when it
+  // has more than one.
+  Status MaybeRewriteGraph(std::unique_ptr<Graph>* graph) override;
+
+  // Returns the device context of the compute stream `node` was assigned to,
+  // or nullptr for the first stream.
+  DeviceContext* GetNodeDeviceContext(const Node& node) override;
+
   // Returns the platform GPU id of this device within the native driver system;
   // e.g., for CUDA and ROCm this is the ordinal of the GPU within the system.
   int gpu_id() const {
@@ -177,6 +188,12 @@ class BaseGPUDevice : public LocalDevice {
 
   se::Stream* compute_stream() { return stream_->compute; }
 
+  // Returns the compute stream `stream_id`, with 0 being compute_stream().
+  se::Stream* compute_stream(int stream_id) {
+    return stream_id == 0 ? stream_->compute
+                          : stream_->extra_compute[stream_id - 1];
+  }
+
   // Given the compute stream for a GPU or virtual GPU, return the TfDeviceId
   // for the GPU or vGPU.
   static std::optional<tsl::TfDeviceId> FindTfDeviceId(se::Stream* compute);
@@ -208,7 +225,13 @@ class BaseGPUDevice : public LocalDevice {
   StreamGroup* stream_;
   mutex scratch_init_mutex_;
   char* scratch_ = nullptr;
+  // Scratch buffers of the compute streams other than the first.
+  std::vector<char*> extra_scratch_;
   GPUDeviceContext* device_context_;
+  // Number of compute streams, and the device contexts of the streams other
+  // than the first one.
+  int num_compute_streams_ = 1;
+  std::vector<GPUDeviceContext*> extra_device_contexts_;
   DeviceBase::AcceleratorDeviceInfo* accelerator_device_info_ = nullptr;
   mutex trace_mu_;
   tsl::TfDeviceId tf_device_id_;
@@ -230,6 +253,15 @@ class BaseGPUDevice : public LocalDevice {
   std::string ComputeOpKernelDebugString(const OpKernel& op_kernel,
                                          const int& stream_id);
 
+  // Makes `stream` wait for the other compute streams that produce inputs of
+  // `op_kernel`.
+  Status WaitForInputStreams(const OpKernel& op_kernel, int stream_id,
+                             se::Stream* stream);
+
+  // Keeps the inputs of the op run by `context` alive until `stream` is done
+  // with the op, so that ops on other streams do not reuse their memory.
+  void HoldInputsUntilDone(OpKernelContext* context, se::Stream* stream);
+
   // This method returns an initialization status, in addition to
   // calling the "done" StatusCallback, if there is a failure to
   // allocate memory or if the tensor "from" is not DMA-copyable.
@@ -28,6 +28,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 #include "xla/stream_executor/gpu/gpu_init.h"
 #include "xla/stream_executor/integrations/device_mem_allocator.h"
 #include "xla/stream_executor/stream_executor.h"
@@ -46,6 +47,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/shared_counter.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tracking_allocator.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/mutex.h"
 #include "tsl/platform/strcat.h"
@@ -86,6 +89,164 @@ static bool UseCudaMallocAsyncAllocator() {
 #endif
 }
 
+// NOLINTNEXTLINE(clang-diagnostic-unused-function)
+static bool UseStreamRegionPool() {
+  bool use_stream_region_pool = false;
+  Status status = tsl::ReadBoolFromEnvVar("TF_GPU_BFC_STREAM_REGION_POOL",
+                                          false, &use_stream_region_pool);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetGPUAllocator: " << status.message();
+  }
+  return use_stream_region_pool;
+}
+
+namespace {
+
+auto* gpu_host_allocations = monitoring::Counter<2>::New(
+    "/tensorflow/core/gpu_host_allocator/allocations",
+    "Allocations of pinned host memory by NUMA node and result: 'hit' if "
+    "served from the pool, 'miss' if the pool had to grow, 'failed' otherwise.",
+    "numa_node", "result");
+
+auto* gpu_host_pool_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/gpu_host_allocator/pool_bytes",
+    "Bytes of pinned host memory added to the pool, by NUMA node.",
+    "numa_node");
+
+// Set by PinnedHostSubAllocator when an allocation grows the pool. The BFC
+// allocator grows its pool on the thread of the allocation that needs it.
+thread_local bool gpu_host_pool_grew = false;
+
+// Pins the host memory of the pool of one NUMA node. The memory is allocated
+// with the thread bound to that node so that its pages are placed there.
+class PinnedHostSubAllocator : public SubAllocator {
+ public:
+  PinnedHostSubAllocator(std::unique_ptr<SubAllocator> sub_allocator,
+                         int numa_node, bool bind_to_numa_node)
+      : SubAllocator({}, {}),
+        sub_allocator_(std::move(sub_allocator)),
+        numa_node_(numa_node),
+        bind_to_numa_node_(bind_to_numa_node),
+        pool_bytes_(gpu_host_pool_bytes->GetCell(absl::StrCat(numa_node))) {}
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override {
+    const int thread_numa_node = port::NUMAGetThreadNodeAffinity();
+    const bool rebind = bind_to_numa_node_ && thread_numa_node != numa_node_;
+    if (rebind) port::NUMASetThreadNodeAffinity(numa_node_);
+    void* ptr = sub_allocator_->Alloc(alignment, num_bytes, bytes_received);
+    if (rebind) port::NUMASetThreadNodeAffinity(thread_numa_node);
+    if (ptr != nullptr) {
+      gpu_host_pool_grew = true;
+      pool_bytes_->IncrementBy(*bytes_received);
+    }
+    return ptr;
+  }
+
+  void Free(void* ptr, size_t num_bytes) override {
+    sub_allocator_->Free(ptr, num_bytes);
+  }
+
+  bool SupportsCoalescing() const override {
+    return sub_allocator_->SupportsCoalescing();
+  }
+
+  AllocatorMemoryType GetMemoryType() const override {
+    return sub_allocator_->GetMemoryType();
+  }
+
+ private:
+  std::unique_ptr<SubAllocator> sub_allocator_;
+  const int numa_node_;
+  const bool bind_to_numa_node_;
+  monitoring::CounterCell* pool_bytes_;
+};
+
+// Counts the allocations of the pinned host memory pool of a NUMA node, from
+// which its hit rate is derived.
+class PinnedHostAllocator : public Allocator {
+ public:
+  PinnedHostAllocator(std::unique_ptr<Allocator> allocator, int numa_node)
+      : allocator_(std::move(allocator)),
+        hits_(gpu_host_allocations->GetCell(absl::StrCat(numa_node), "hit")),
+        misses_(
+            gpu_host_allocations->GetCell(absl::StrCat(numa_node), "miss")),
+        failures_(
+            gpu_host_allocations->GetCell(absl::StrCat(numa_node), "failed")) {}
+
+  std::string Name() override { return allocator_->Name(); }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    gpu_host_pool_grew = false;
+    void* ptr = allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+    if (ptr == nullptr) {
+      failures_->IncrementBy(1);
+    } else if (gpu_host_pool_grew) {
+      misses_->IncrementBy(1);
+    } else {
+      hits_->IncrementBy(1);
+    }
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override { allocator_->DeallocateRaw(ptr); }
+
+  bool TracksAllocationSizes() const override {
+    return allocator_->TracksAllocationSizes();
+  }
+  size_t RequestedSize(const void* ptr) const override {
+    return allocator_->RequestedSize(ptr);
+  }
+  size_t AllocatedSize(const void* ptr) const override {
+    return allocator_->AllocatedSize(ptr);
+  }
+  int64_t AllocationId(const void* ptr) const override {
+    return allocator_->AllocationId(ptr);
+  }
+  absl::optional<AllocatorStats> GetStats() override {
+    return allocator_->GetStats();
+  }
+  bool ClearStats() override { return allocator_->ClearStats(); }
+  AllocatorMemoryType GetMemoryType() const override {
+    return allocator_->GetMemoryType();
+  }
+
+ private:
+  std::unique_ptr<Allocator> allocator_;
+  monitoring::CounterCell* hits_;
+  monitoring::CounterCell* misses_;
+  monitoring::CounterCell* failures_;
+};
+
+}  // namespace
+
+// NOLINTNEXTLINE(clang-diagnostic-unused-function)
+static int64_t BfcTelemetryIntervalSecs() {
+  int64_t interval_secs = 60;
+  Status status = tsl::ReadInt64FromEnvVar("TF_GPU_BFC_TELEMETRY_INTERVAL_SECS",
+                                           60, &interval_secs);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetGPUAllocator: " << status.message();
+  }
+  return interval_secs;
+}
+
+// NOLINTNEXTLINE(clang-diagnostic-unused-function)
+static bool ReleaseIdleBfcRegions() {
+  bool release_idle_regions = false;
+  Status status = tsl::ReadBoolFromEnvVar("TF_GPU_BFC_RELEASE_IDLE_REGIONS",
+                                          false, &release_idle_regions);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetGPUAllocator: " << status.message();
+  }
+  return release_idle_regions;
+}
+
 /*static*/ GPUProcessState* GPUProcessState::singleton(GPUProcessState* ps) {
   static GPUProcessState* instance = ps ? ps : new GPUProcessState;
   DCHECK((!ps) || (ps == instance))
@@ -158,9 +319,32 @@ Allocator* GPUProcessState::GetGPUAllocator(
     while (bus_id >= gpu_visitors_.size()) {
       gpu_visitors_.push_back({});
     }
-    std::unique_ptr<SubAllocator> sub_allocator =
-        CreateSubAllocator(options, platform_device_id, gpu_visitors_[bus_id],
-                           total_bytes, peer_gpu_ids);
+    std::unique_ptr<SubAllocator> sub_allocator;
+    GPUStreamSubAllocator* stream_sub_allocator = nullptr;
+    if (UseStreamRegionPool()) {
+      if (platform_device_id.value() >= gpu_region_pools_.size()) {
+        gpu_region_pools_.resize(platform_device_id.value() + 1);
+      }
+      std::unique_ptr<GPUStreamRegionPool>& pool =
+          gpu_region_pools_[platform_device_id.value()];
+      if (pool == nullptr) {
+        pool = std::make_unique<GPUStreamRegionPool>(
+            CreateSubAllocator(options, platform_device_id,
+                               gpu_visitors_[bus_id], total_bytes,
+                               peer_gpu_ids),
+            se::GPUMachineManager()
+                ->ExecutorForDevice(platform_device_id.value())
+                .value());
+      }
+      auto pool_sub_allocator =
+          std::make_unique<GPUStreamSubAllocator>(pool.get());
+      stream_sub_allocator = pool_sub_allocator.get();
+      sub_allocator = std::move(pool_sub_allocator);
+    } else {
+      sub_allocator =
+          CreateSubAllocator(options, platform_device_id, gpu_visitors_[bus_id],
+                             total_bytes, peer_gpu_ids);
+    }
     SubAllocator* sub_allocator_ptr = sub_allocator.get();
 
     auto gpu_bfc_allocator = std::make_unique<GPUBFCAllocator>(
@@ -172,6 +356,8 @@ Allocator* GPUProcessState::GetGPUAllocator(
               !options.experimental().disallow_retry_on_allocation_failure();
           o.fragmentation_fraction =
               options.experimental().internal_fragmentation_fraction();
+          o.telemetry_interval_secs = BfcTelemetryIntervalSecs();
+          o.release_free_regions_when_idle = ReleaseIdleBfcRegions();
           return o;
         }());
     Allocator* gpu_allocator = gpu_bfc_allocator.get();
@@ -237,6 +423,10 @@ Allocator* GPUProcessState::GetGPUAllocator(
         std::unique_ptr<Allocator>(recording_allocator),
     };
 #endif  // TF_GPU_USE_PJRT
+    // The sub-allocator is gone if the BFC allocator was replaced above.
+    if (allocator_parts.bfc_allocator != nullptr) {
+      allocator_parts.stream_sub_allocator = stream_sub_allocator;
+    }
   }
   if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
     return allocator_parts.recording_allocator.get();
@@ -254,6 +444,19 @@ Allocator* GPUProcessState::GetGPUAllocator(
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 }
 
+void GPUProcessState::SetGPUAllocatorStream(tsl::TfDeviceId tf_device_id,
+                                             se::Stream* compute_stream) {
+  mutex_lock l(mu_);
+  if (tf_device_id.value() >= static_cast<int64_t>(gpu_allocators_.size())) {
+    return;
+  }
+  GPUStreamSubAllocator* stream_sub_allocator =
+      gpu_allocators_[tf_device_id.value()].stream_sub_allocator;
+  if (stream_sub_allocator != nullptr) {
+    stream_sub_allocator->SetStream(compute_stream);
+  }
+}
+
 SharedCounter* GPUProcessState::GPUAllocatorCounter(
     tsl::TfDeviceId tf_device_id) {
   DCHECK(process_state_);
@@ -290,7 +493,8 @@ Allocator* GPUProcessState::GetGpuHostAllocator(const GPUOptions& options,
       !process_state_->ProcessState::FLAGS_brain_mem_reg_gpu_dma) {
     return process_state_->GetCPUAllocator(numa_node);
   }
-  if (numa_node == port::kNUMANoAffinity) {
+  // Each NUMA node has a pool of its own if NUMA is enabled.
+  if (!process_state_->numa_enabled_ || numa_node == port::kNUMANoAffinity) {
     numa_node = 0;
   }
   {
@@ -301,15 +505,15 @@ Allocator* GPUProcessState::GetGpuHostAllocator(const GPUOptions& options,
     tf_shared_lock lock(mu_);
 
     if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types &&
-        !gpu_host_allocators_.empty() &&
-        gpu_host_allocators_[0].recording_allocator != nullptr) {
-      return gpu_host_allocators_[0].recording_allocator.get();
+        static_cast<int>(gpu_host_allocators_.size()) > numa_node &&
+        gpu_host_allocators_[numa_node].recording_allocator != nullptr) {
+      return gpu_host_allocators_[numa_node].recording_allocator.get();
     }
     if (static_cast<int>(gpu_host_allocators_.size()) > numa_node) {
 #ifdef TF_GPU_USE_PJRT
-      return gpu_host_allocators_[0].allocator_not_owned;
+      return gpu_host_allocators_[numa_node].allocator_not_owned;
 #else
-      return gpu_host_allocators_[0].allocator.get();
+      return gpu_host_allocators_[numa_node].allocator.get();
 #endif  // TF_GPU_USE_PJRT
     }
   }
@@ -338,6 +542,7 @@ Allocator* GPUProcessState::GetGpuHostAllocator(const GPUOptions& options,
 
   CHECK_NE(nullptr, se);
 
+  // The limit applies to the pool of each NUMA node.
   int64_t mem_limit_bytes =
       options.experimental().gpu_host_mem_limit_in_mb() * (1LL << 20);
   if (mem_limit_bytes <= 0) {
@@ -358,16 +563,21 @@ Allocator* GPUProcessState::GetGpuHostAllocator(const GPUOptions& options,
     while (gpu_host_free_visitors_.size() <= numa_node) {
       gpu_host_free_visitors_.push_back({});
     }
-    SubAllocator* sub_allocator = new DeviceHostAllocator(
-        se, numa_node, gpu_host_alloc_visitors_[numa_node],
-        gpu_host_free_visitors_[numa_node]);
+    const int node = gpu_host_allocators_.size();
+    SubAllocator* sub_allocator = new PinnedHostSubAllocator(
+        std::make_unique<DeviceHostAllocator>(se, node,
+                                              gpu_host_alloc_visitors_[node],
+                                              gpu_host_free_visitors_[node]),
+        node, /*bind_to_numa_node=*/process_state_->numa_enabled_);
 
     tsl::BFCAllocator::Options allocator_opts;
     allocator_opts.allow_growth =
         !options.experimental().gpu_host_mem_disallow_growth();
-    tsl::Allocator* allocator =
-        new tsl::BFCAllocator(absl::WrapUnique(sub_allocator), mem_limit_bytes,
-                              /*name=*/"gpu_host_bfc", allocator_opts);
+    tsl::Allocator* allocator = new PinnedHostAllocator(
+        std::make_unique<tsl::BFCAllocator>(
+            absl::WrapUnique(sub_allocator), mem_limit_bytes,
+            /*name=*/"gpu_host_bfc", allocator_opts),
+        node);
 
     if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
       // Wrap the allocator to track allocation ids for better logging
@@ -405,12 +615,12 @@ Allocator* GPUProcessState::GetGpuHostAllocator(const GPUOptions& options,
     }
   }
   if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
-    return gpu_host_allocators_[0].recording_allocator.get();
+    return gpu_host_allocators_[numa_node].recording_allocator.get();
   } else {
 #ifdef TF_GPU_USE_PJRT
-    return gpu_host_allocators_[0].allocator_not_owned;
+    return gpu_host_allocators_[numa_node].allocator_not_owned;
 #else
-    return gpu_host_allocators_[0].allocator.get();
+    return gpu_host_allocators_[numa_node].allocator.get();
 #endif  // TF_GPU_USE_PJRT
   }
 }
@@ -469,6 +679,7 @@ void GPUProcessState::TestOnlyReset() {
     mutex_lock lock(mu_);
     gpu_device_enabled_ = false;
     gpu_allocators_.clear();
+    gpu_region_pools_.clear();
     gpu_visitors_.clear();
     gpu_host_allocators_.clear();
     gpu_host_alloc_visitors_.clear();
@@ -28,7 +28,9 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "xla/stream_executor/stream.h"
 #include "xla/tsl/framework/device_id.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 #include "tensorflow/core/common_runtime/process_state.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -39,7 +41,6 @@ limitations under the License.
 
 namespace tensorflow {
 
-class GPUBFCAllocator;
 class PoolAllocator;
 
 // Singleton that manages per-process state when GPUs are present.
@@ -103,6 +104,10 @@ class GPUProcessState {
     return gpu_allocators_.size();
   }
 
+  // Returns the allocator of pinned host memory, a BFC allocator over a pool
+  // of pinned memory. If NUMA is enabled, each NUMA node has a pool of its own
+  // with pages placed on that node, and `numa_node` selects it.
+  //
   // `options` is read on the very first call to this function in the process,
   // e.g. to set the memory limit on this allocator.  After that if you pass in
   // a different set of options, they will be ignored.
@@ -134,6 +139,14 @@ class GPUProcessState {
   // Returns bus_id for the given GPU id.
   virtual int BusIdForGPU(tsl::TfDeviceId tf_device_id);
 
+  // Sets the compute stream that the memory of the GPU allocator for
+  // `tf_device_id` is used on. With TF_GPU_BFC_STREAM_REGION_POOL=true, the
+  // GPU allocators of the compute streams of one GPU then hand the regions
+  // they release to each other (see GPUStreamRegionPool); otherwise this is a
+  // no-op.
+  virtual void SetGPUAllocatorStream(tsl::TfDeviceId tf_device_id,
+                                     se::Stream* compute_stream);
+
   SharedCounter* GPUAllocatorCounter(tsl::TfDeviceId tf_device_id);
 
  protected:
@@ -164,6 +177,8 @@ class GPUProcessState {
     GPUBFCAllocator* bfc_allocator;
     SubAllocator* sub_allocator;  // owned by allocator
     std::unique_ptr<Allocator> recording_allocator;
+    // Set iff `sub_allocator` gets its regions from the GPU's region pool.
+    GPUStreamSubAllocator* stream_sub_allocator = nullptr;
 
 #ifdef TF_GPU_USE_PJRT
     // Not owning GPU allocator. The allocator is owned by PJRT. If
@@ -172,6 +187,11 @@ class GPUProcessState {
     Allocator* allocator_not_owned;
 #endif  // TF_GPU_USE_PJRT
   };
+  // Indexed by platform device id, as the compute streams of the virtual
+  // devices of one GPU share its pool. Declared before `gpu_allocators_` to
+  // outlive their sub-allocators.
+  std::vector<std::unique_ptr<GPUStreamRegionPool>> gpu_region_pools_
+      TF_GUARDED_BY(mu_);
   std::vector<AllocatorParts> gpu_allocators_ TF_GUARDED_BY(mu_);
   std::vector<std::vector<SubAllocator::Visitor>> gpu_visitors_
       TF_GUARDED_BY(mu_);
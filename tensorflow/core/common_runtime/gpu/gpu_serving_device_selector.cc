@@ -26,11 +26,137 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
+#include "absl/types/span.h"
 #include "xla/tsl/framework/serving_device_selector.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_scheduling_metrics_storage.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 
 namespace tensorflow {
 namespace gpu {
+namespace {
+
+auto* load_aware_selections = monitoring::Counter<1>::New(
+    "/tensorflow/core/gpu/serving_device_selector/selections",
+    "The number of devices selected by the load-aware GPU serving device "
+    "selector policy, by the criterion that decided the selection.",
+    "reason");
+
+// The criteria of GpuLoadAwarePolicy, in the order they are applied.
+enum class SelectionReason {
+  kLeastLoaded,
+  kShortestQueue,
+  kMostFreeMemory,
+  kRoundRobin,
+};
+
+const char* SelectionReasonName(SelectionReason reason) {
+  switch (reason) {
+    case SelectionReason::kLeastLoaded:
+      return "least_loaded";
+    case SelectionReason::kShortestQueue:
+      return "shortest_queue";
+    case SelectionReason::kMostFreeMemory:
+      return "most_free_memory";
+    case SelectionReason::kRoundRobin:
+      return "round_robin";
+  }
+  return "unknown";
+}
+
+int64_t QueueDepth(const tsl::ServingDeviceSelector::DeviceState& state) {
+  int64_t depth = 0;
+  for (const auto& programs : state.enqueued_programs) depth += programs.size();
+  for (const auto& programs : state.scheduled_programs) {
+    depth += programs.size();
+  }
+  return depth;
+}
+
+}  // namespace
+
+int GpuLoadAwarePolicy::SelectDevice(
+    absl::string_view program_fingerprint,
+    const tsl::ServingDeviceSelector::DeviceStates& device_states) {
+  const int num_devices = device_states.states.size();
+  auto time_till_idle_ns = [&](int i) -> int64_t {
+    return device_states.estimated_time_till_idle_ns.empty()
+               ? 0
+               : device_states.estimated_time_till_idle_ns[i];
+  };
+  auto free_memory_bytes = [&](int i) -> int64_t {
+    return device_states.free_memory_bytes.empty()
+               ? -1
+               : device_states.free_memory_bytes[i];
+  };
+  auto has_enough_memory = [&](int i) {
+    const int64_t free_bytes = free_memory_bytes(i);
+    return free_bytes < 0 || free_bytes >= min_free_memory_bytes_;
+  };
+  // Returns the first criterion on which devices `a` and `b` differ.
+  auto deciding_reason = [&](int a, int b) {
+    if (time_till_idle_ns(a) != time_till_idle_ns(b)) {
+      return SelectionReason::kLeastLoaded;
+    }
+    if (QueueDepth(device_states.states[a]) !=
+        QueueDepth(device_states.states[b])) {
+      return SelectionReason::kShortestQueue;
+    }
+    if (free_memory_bytes(a) != free_memory_bytes(b)) {
+      return SelectionReason::kMostFreeMemory;
+    }
+    return SelectionReason::kRoundRobin;
+  };
+  auto is_better = [&](int a, int b) {
+    switch (deciding_reason(a, b)) {
+      case SelectionReason::kLeastLoaded:
+        return time_till_idle_ns(a) < time_till_idle_ns(b);
+      case SelectionReason::kShortestQueue:
+        return QueueDepth(device_states.states[a]) <
+               QueueDepth(device_states.states[b]);
+      case SelectionReason::kMostFreeMemory:
+        return free_memory_bytes(a) > free_memory_bytes(b);
+      case SelectionReason::kRoundRobin:
+        return false;
+    }
+    return false;
+  };
+
+  // Scans from a rotating device, so that the first of several equally good
+  // devices changes between selections.
+  const int start = ordinal_.fetch_add(1, std::memory_order_relaxed) %
+                    num_devices;
+  int best = -1;
+  int most_free_memory = start;
+  for (int k = 0; k < num_devices; ++k) {
+    const int i = (start + k) % num_devices;
+    if (free_memory_bytes(i) > free_memory_bytes(most_free_memory)) {
+      most_free_memory = i;
+    }
+    if (has_enough_memory(i) && (best == -1 || is_better(i, best))) best = i;
+  }
+  if (best == -1) {
+    load_aware_selections->GetCell("memory_fallback")->IncrementBy(1);
+    return most_free_memory;
+  }
+
+  // The reason is the deepest criterion needed to prefer `best` over any other
+  // device, or the memory limit if it excluded a less loaded device.
+  SelectionReason reason = SelectionReason::kLeastLoaded;
+  bool memory_constrained = false;
+  for (int i = 0; i < num_devices; ++i) {
+    if (i == best) continue;
+    if (!has_enough_memory(i)) {
+      memory_constrained |= time_till_idle_ns(i) < time_till_idle_ns(best);
+      continue;
+    }
+    reason = std::max(reason, deciding_reason(best, i));
+  }
+  load_aware_selections
+      ->GetCell(memory_constrained ? "memory_constrained"
+                                   : SelectionReasonName(reason))
+      ->IncrementBy(1);
+  return best;
+}
 // A default estimate of execution time for an enqueued program that this host
 // has never finished executing. We currently set it to 1 ns (so that for all
 // empty queues it still affects the decision) until we have better way to
@@ -44,16 +170,37 @@ using DeviceStates = GpuServingDeviceSelector::DeviceStates;
 
 GpuServingDeviceSelector::GpuServingDeviceSelector(
     const int num_devices,
-    std::unique_ptr<ServingDeviceSelector::Policy> device_selector_policy)
-    : device_states_(num_devices),
+    std::unique_ptr<ServingDeviceSelector::Policy> device_selector_policy,
+    FreeMemoryFn free_memory_fn)
+    : num_devices_(num_devices),
+      device_states_(num_devices),
       device_selector_policy_(std::move(device_selector_policy)),
+      free_memory_fn_(std::move(free_memory_fn)),
       req_id_counter_(0) {}
 
 tsl::DeviceReservation GpuServingDeviceSelector::ReserveDevice(
     absl::string_view program_fingerprint) {
+  // Queried before locking, as it may wait on the locks of the allocators.
+  absl::FixedArray<int64_t, 8> free_memory_bytes(
+      free_memory_fn_ ? num_devices_ : 0);
+  if (free_memory_fn_) {
+    for (int i = 0; i < num_devices_; ++i) {
+      free_memory_bytes[i] = free_memory_fn_(i);
+    }
+  }
+
   absl::MutexLock lock(&mu_);
+  const int64_t now_ns = NowNs();
+  absl::FixedArray<int64_t, 8> time_till_idle_ns(num_devices_);
+  for (int i = 0; i < num_devices_; ++i) {
+    time_till_idle_ns[i] = ServingDeviceSelector::EstimateTimeTillIdleNs(
+        device_states_[i], 0, min_exec_time_.value_or(kDefaultEstimateNs),
+        now_ns);
+  }
   DeviceStates device_states;
   device_states.states = absl::Span<const DeviceState>(device_states_);
+  device_states.estimated_time_till_idle_ns = time_till_idle_ns;
+  device_states.free_memory_bytes = free_memory_bytes;
   auto [it, emplaced] =
       execution_info_.try_emplace(program_fingerprint, ExecutionInfo());
   const int device_index =
@@ -62,7 +209,7 @@ tsl::DeviceReservation GpuServingDeviceSelector::ReserveDevice(
   ServingDeviceSelector::EnqueueHelper(
       device_states_.at(device_index), device_index, it->second,
       program_fingerprint, /*priority=*/0, req_id_counter_++,
-      /*priority_queue_count=*/1, /*prefetch_results=*/0, NowNs());
+      /*priority_queue_count=*/1, /*prefetch_results=*/0, now_ns);
 
   return tsl::DeviceReservation(device_index, this);
 }
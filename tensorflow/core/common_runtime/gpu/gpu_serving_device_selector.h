@@ -15,8 +15,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_SERVING_DEVICE_SELECTOR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_SERVING_DEVICE_SELECTOR_H_
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "absl/base/thread_annotations.h"
@@ -51,11 +54,39 @@ class GpuServingDeviceSelectorResource : public ResourceBase {
   std::unique_ptr<GpuServingDeviceSelector> selector_;
 };
 
+// Selects the device on which a program is expected to start first. Among the
+// devices with at least `min_free_memory_bytes` free, picks the one with the
+// smallest estimated time till idle, then the one with the fewest queued
+// programs, then the one with the most free memory. Remaining ties are broken
+// round-robin. If no device has enough free memory, picks the one with the
+// most. The reason of each selection is counted in
+// /tensorflow/core/gpu/serving_device_selector/selections.
+class GpuLoadAwarePolicy : public tsl::ServingDeviceSelector::Policy {
+ public:
+  explicit GpuLoadAwarePolicy(int64_t min_free_memory_bytes = 0)
+      : min_free_memory_bytes_(min_free_memory_bytes), ordinal_(0) {}
+
+  int SelectDevice(
+      absl::string_view program_fingerprint,
+      const tsl::ServingDeviceSelector::DeviceStates& device_states) override;
+
+ private:
+  const int64_t min_free_memory_bytes_;
+  std::atomic<uint64_t> ordinal_;
+};
+
 class GpuServingDeviceSelector : public tsl::ServingDeviceSelector {
  public:
+  // Returns the free memory of the device at the given index in bytes, or -1
+  // if unknown.
+  using FreeMemoryFn = std::function<int64_t(int device_index)>;
+
+  // If `free_memory_fn` is set, the free memory of every device is passed to
+  // the policy when reserving a device.
   GpuServingDeviceSelector(
       int num_devices,
-      std::unique_ptr<ServingDeviceSelector::Policy> device_selector_policy);
+      std::unique_ptr<ServingDeviceSelector::Policy> device_selector_policy,
+      FreeMemoryFn free_memory_fn = nullptr);
 
   tsl::DeviceReservation ReserveDevice(
       absl::string_view program_fingerprint) override;
@@ -78,9 +109,11 @@ class GpuServingDeviceSelector : public tsl::ServingDeviceSelector {
   // Only for metrics reporting purposes.
   int64_t TotalEstimatedTimeTillIdleNs() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  const int num_devices_;
   absl::Mutex mu_;
   absl::FixedArray<DeviceState, 8> device_states_ ABSL_GUARDED_BY(mu_);
   std::unique_ptr<ServingDeviceSelector::Policy> device_selector_policy_;
+  const FreeMemoryFn free_memory_fn_;
   int64_t req_id_counter_ ABSL_GUARDED_BY(mu_);
   // Map from program fingerprint to execution info.
   absl::node_hash_map<std::string, ExecutionInfo> execution_info_
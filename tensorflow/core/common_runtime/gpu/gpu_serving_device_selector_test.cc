@@ -24,6 +24,7 @@ limitations under the License.
 #include "xla/tsl/framework/serving_device_selector.h"
 #include "xla/tsl/framework/serving_device_selector_policies.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_scheduling_metrics_storage.h"
+#include "tensorflow/core/lib/monitoring/cell_reader.h"
 
 namespace tensorflow {
 namespace gpu {
@@ -135,6 +136,59 @@ TEST(GpuServingDeviceSelector, DefaultPolicyOnlyEnqueueCall) {
       0e6);
 }
 
+TEST(GpuServingDeviceSelector, LoadAwarePolicyPicksLeastLoadedDevice) {
+  ServingDeviceSelectorTestHelper helper;
+  helper.ElapseNs(1);
+  GpuServingDeviceSelector selector(
+      /*num_devices=*/2, std::make_unique<GpuLoadAwarePolicy>());
+  // Learns the execution times of both programs.
+  selector.Enqueue(0, "10ms");
+  helper.ElapseNs(10e6);
+  selector.Completed(0, false);
+  selector.Enqueue(1, "1ms");
+  helper.ElapseNs(1e6);
+  selector.Completed(1, false);
+
+  // Both devices are idle; the first one is picked.
+  tsl::DeviceReservation long_program = selector.ReserveDevice("10ms");
+  EXPECT_EQ(long_program.device_index(), 0);
+  // Device 0 is busy for 10ms, so the following programs go to device 1, even
+  // when it has more programs queued.
+  tsl::DeviceReservation short_program = selector.ReserveDevice("1ms");
+  EXPECT_EQ(short_program.device_index(), 1);
+  tsl::DeviceReservation other_short_program = selector.ReserveDevice("1ms");
+  EXPECT_EQ(other_short_program.device_index(), 1);
+}
+
+TEST(GpuServingDeviceSelector, LoadAwarePolicyAvoidsDevicesLowOnMemory) {
+  monitoring::testing::CellReader<int64_t> selections(
+      "/tensorflow/core/gpu/serving_device_selector/selections");
+  ServingDeviceSelectorTestHelper helper;
+  helper.ElapseNs(1);
+  int64_t free_memory_bytes[] = {100, 10};
+  GpuServingDeviceSelector selector(
+      /*num_devices=*/2,
+      std::make_unique<GpuLoadAwarePolicy>(/*min_free_memory_bytes=*/50),
+      [&](int device_index) { return free_memory_bytes[device_index]; });
+  selector.Enqueue(0, "10ms");
+  helper.ElapseNs(10e6);
+  selector.Completed(0, false);
+
+  tsl::DeviceReservation first = selector.ReserveDevice("10ms");
+  EXPECT_EQ(first.device_index(), 0);
+  EXPECT_EQ(selections.Delta("least_loaded"), 1);
+  // Device 1 is idle, but does not have enough free memory.
+  tsl::DeviceReservation second = selector.ReserveDevice("10ms");
+  EXPECT_EQ(second.device_index(), 0);
+  EXPECT_EQ(selections.Delta("memory_constrained"), 1);
+
+  // Without enough free memory anywhere, the device with the most is picked.
+  free_memory_bytes[0] = 5;
+  tsl::DeviceReservation third = selector.ReserveDevice("10ms");
+  EXPECT_EQ(third.device_index(), 1);
+  EXPECT_EQ(selections.Delta("memory_fallback"), 1);
+}
+
 }  // namespace
 }  // namespace gpu
 }  // namespace tensorflow
@@ -0,0 +1,97 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_assignment.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace {
+
+bool IsGpuNode(const Node& node) {
+  DeviceNameUtils::ParsedName parsed_name;
+  return DeviceNameUtils::ParseFullName(node.assigned_device_name(),
+                                        &parsed_name) &&
+         parsed_name.type == DEVICE_GPU;
+}
+
+// Returns true if `node` must run on stream 0: nodes that have effects beyond
+// their outputs, or that other streams and devices synchronize with.
+bool RunsOnFirstStream(const Node& node) {
+  return node.op_def().is_stateful() || node.IsControlFlow() ||
+         node.IsSend() || node.IsRecv() || node.IsArg() || node.IsRetval() ||
+         node.IsFunctionCall() || node.IsIfNode() || node.IsWhileNode() ||
+         node.IsCaseNode() || node.IsCollective() ||
+         node.IsDistributedCommunication();
+}
+
+}  // namespace
+
+void AssignGpuStreams(int num_streams, Graph* graph) {
+  if (num_streams <= 1) return;
+
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph, &order, NodeComparatorName());
+  std::vector<int> streams(graph->num_node_ids(), 0);
+  // Whether a consumer already continued the stream of a node.
+  std::vector<bool> continued(graph->num_node_ids(), false);
+  int next_stream = 0;
+  for (Node* node : order) {
+    if (!node->IsOp() || !IsGpuNode(*node)) continue;
+
+    int stream = 0;
+    if (!RunsOnFirstStream(*node)) {
+      std::vector<const Edge*> inputs;
+      if (!node->input_edges(&inputs).ok()) inputs.clear();
+      const Edge* continued_input = nullptr;
+      for (const Edge* edge : inputs) {
+        const Node* src = edge->src();
+        if (src->IsOp() && IsGpuNode(*src) && !RunsOnFirstStream(*src) &&
+            !continued[src->id()]) {
+          continued_input = edge;
+          break;
+        }
+      }
+      if (continued_input != nullptr) {
+        continued[continued_input->src()->id()] = true;
+        stream = streams[continued_input->src()->id()];
+      } else {
+        stream = next_stream;
+        next_stream = (next_stream + 1) % num_streams;
+      }
+    }
+    streams[node->id()] = stream;
+
+    // Control dependencies are waited for too, as they may order effects.
+    std::vector<int> waits;
+    for (const Edge* edge : node->in_edges()) {
+      const Node* src = edge->src();
+      if (!src->IsOp() || !IsGpuNode(*src)) continue;
+      if (streams[src->id()] != stream) waits.push_back(streams[src->id()]);
+    }
+    std::sort(waits.begin(), waits.end());
+    waits.erase(std::unique(waits.begin(), waits.end()), waits.end());
+
+    if (stream != 0) node->AddAttr(kGpuStreamAttr, stream);
+    if (!waits.empty()) node->AddAttr(kGpuStreamWaitsAttr, waits);
+  }
+}
+
+}  // namespace tensorflow
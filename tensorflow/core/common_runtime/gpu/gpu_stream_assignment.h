@@ -0,0 +1,44 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_ASSIGNMENT_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_ASSIGNMENT_H_
+
+#include "tensorflow/core/graph/graph.h"
+
+namespace tensorflow {
+
+// Attribute holding the index of the compute stream a node runs on. Nodes
+// without it run on stream 0.
+inline constexpr char kGpuStreamAttr[] = "_gpu_stream";
+
+// Attribute holding the compute streams that a node waits for before its
+// kernel is launched, i.e. the streams of the nodes it depends on when they
+// differ from its own.
+inline constexpr char kGpuStreamWaitsAttr[] = "_gpu_stream_waits";
+
+// Assigns the GPU nodes of `graph` to `num_streams` compute streams so that
+// independent chains of ops can overlap, and records the assignment in the
+// attributes above. A node continues the stream of its first input that no
+// other node continued yet, and otherwise starts a new chain on the next
+// stream in round-robin order. Stateful ops, transfers, control flow,
+// function calls and collectives, which other streams and devices synchronize
+// with, stay on stream 0 and do not start chains. Does nothing if
+// `num_streams` <= 1.
+void AssignGpuStreams(int num_streams, Graph* graph);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_ASSIGNMENT_H_
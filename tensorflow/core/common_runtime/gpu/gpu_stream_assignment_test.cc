@@ -0,0 +1,122 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_assignment.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kGpu[] = "/job:localhost/replica:0/task:0/device:GPU:0";
+
+int StreamOf(const Node* node) {
+  int stream = 0;
+  TryGetNodeAttr(node->attrs(), kGpuStreamAttr, &stream);
+  return stream;
+}
+
+std::vector<int> WaitsOf(const Node* node) {
+  std::vector<int> waits;
+  TryGetNodeAttr(node->attrs(), kGpuStreamWaitsAttr, &waits);
+  return waits;
+}
+
+class GpuStreamAssignmentTest : public ::testing::Test {
+ protected:
+  GpuStreamAssignmentTest() : graph_(OpRegistry::Global()) {}
+
+  Node* OnGpu(Node* node) {
+    node->set_assigned_device_name(kGpu);
+    return node;
+  }
+
+  Graph graph_;
+};
+
+TEST_F(GpuStreamAssignmentTest, IndependentBranchesRunOnDifferentStreams) {
+  Node* x = OnGpu(test::graph::Constant(&graph_, Tensor(1.0f)));
+  Node* a1 = OnGpu(test::graph::Unary(&graph_, "Neg", x));
+  Node* a2 = OnGpu(test::graph::Unary(&graph_, "Neg", a1));
+  Node* b1 = OnGpu(test::graph::Unary(&graph_, "Neg", x));
+  Node* b2 = OnGpu(test::graph::Unary(&graph_, "Neg", b1));
+  Node* sum = OnGpu(test::graph::Binary(&graph_, "Add", a2, b2));
+
+  AssignGpuStreams(/*num_streams=*/2, &graph_);
+
+  // Each branch stays on one stream, and the two branches are on different
+  // ones.
+  EXPECT_EQ(StreamOf(a2), StreamOf(a1));
+  EXPECT_EQ(StreamOf(b2), StreamOf(b1));
+  EXPECT_NE(StreamOf(a1), StreamOf(b1));
+  // The join waits for the branch it does not continue.
+  const int other_branch =
+      StreamOf(sum) == StreamOf(a2) ? StreamOf(b2) : StreamOf(a2);
+  EXPECT_EQ(WaitsOf(sum), std::vector<int>({other_branch}));
+  // The first node of the branch on another stream than the input waits for
+  // it.
+  Node* moved = StreamOf(a1) == StreamOf(x) ? b1 : a1;
+  EXPECT_EQ(WaitsOf(moved), std::vector<int>({StreamOf(x)}));
+}
+
+TEST_F(GpuStreamAssignmentTest, StatefulOpsRunOnFirstStream) {
+  Node* shape = OnGpu(test::graph::Constant(&graph_, test::AsTensor({2})));
+  Node* x = OnGpu(test::graph::RandomUniform(&graph_, shape, DT_FLOAT));
+  Node* a = OnGpu(test::graph::Unary(&graph_, "Neg", x));
+  Node* b = OnGpu(test::graph::Unary(&graph_, "Neg", x));
+
+  AssignGpuStreams(/*num_streams=*/4, &graph_);
+
+  EXPECT_EQ(StreamOf(x), 0);
+  // Consumers of a node on stream 0 start chains of their own.
+  EXPECT_NE(StreamOf(a), StreamOf(b));
+}
+
+TEST_F(GpuStreamAssignmentTest, NothingToDoWithOneStream) {
+  Node* x = OnGpu(test::graph::Constant(&graph_, Tensor(1.0f)));
+  Node* a = OnGpu(test::graph::Unary(&graph_, "Neg", x));
+  Node* b = OnGpu(test::graph::Unary(&graph_, "Neg", x));
+
+  AssignGpuStreams(/*num_streams=*/1, &graph_);
+
+  for (const Node* node : {x, a, b}) {
+    EXPECT_FALSE(HasNodeAttr(node->def(), kGpuStreamAttr));
+    EXPECT_FALSE(HasNodeAttr(node->def(), kGpuStreamWaitsAttr));
+  }
+}
+
+TEST_F(GpuStreamAssignmentTest, IgnoresNodesOnOtherDevices) {
+  Node* x = test::graph::Constant(&graph_, Tensor(1.0f));
+  Node* a = test::graph::Unary(&graph_, "Neg", x);
+  Node* b = test::graph::Unary(&graph_, "Neg", x);
+
+  AssignGpuStreams(/*num_streams=*/2, &graph_);
+
+  for (const Node* node : {x, a, b}) {
+    EXPECT_FALSE(HasNodeAttr(node->def(), kGpuStreamAttr));
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
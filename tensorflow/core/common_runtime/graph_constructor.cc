@@ -45,11 +45,13 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_debug_info_builder.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
@@ -63,6 +65,14 @@ namespace {
 // can skip expensive duplicates check in 'AddControlEdge'.
 static constexpr const bool kDoNotCheckDuplicates = true;
 
+// Graphs with fewer nodes are prepared on the calling thread, as starting a
+// thread pool costs more than it saves.
+constexpr int kMinNodesToPrepareInParallel = 1024;
+
+// Rough number of cycles it takes to copy, add default attributes to and
+// validate a NodeDef.
+constexpr int64_t kPrepareNodeDefCost = 10000;
+
 inline bool IsMerge(const NodeDef& node_def) {
   return node_def.op() == "Merge" || node_def.op() == "RefMerge" ||
          node_def.op() == "_XlaMerge";
@@ -107,7 +117,8 @@ class GraphConstructor {
           importing(false),
           validate_nodes(in.validate_nodes),
           validate_colocation_constraints(false),
-          add_default_attributes(in.add_default_attributes) {}
+          add_default_attributes(in.add_default_attributes),
+          num_threads(in.num_threads) {}
     Options(const ImportGraphDefOptions& in)  // NOLINT(runtime/explicit)
         : allow_internal_ops(false),
           expect_device_spec(false),
@@ -161,6 +172,10 @@ class GraphConstructor {
     // value to the Node when they are missing from the NodeDef.
     bool add_default_attributes = true;
 
+    // Number of threads used to prepare the NodeDefs of large graphs when not
+    // importing.
+    int num_threads = 1;
+
     string default_device;
   };
 
@@ -244,6 +259,11 @@ class GraphConstructor {
   Status IsNodeFullyMapped(const NodeDef& node_def, bool* is_node_mapped);
   Status ValidateColocationConstraints(const NodeDef& node_def);
   Status MakeNode(NodeDef&& node_def, Node** node);
+  // Adds default attributes to and validates `node_def` when not importing.
+  Status PrepareNodeDef(NodeDef* node_def);
+  // Consumes and prepares all NodeDefs in parallel if opts_.num_threads > 1
+  // and the graph is large enough to benefit.
+  void PrepareNodeDefsInParallel();
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
   Status ModifyNodeDefForImport(NodeDef* node_def);
@@ -298,7 +318,7 @@ class GraphConstructor {
   virtual const NodeDef& get_node_def(int i) const = 0;
   // Destructively reads the i^th node in the graph, avoiding a copy if
   // possible. After calling this method, the result of get_node_def(i) is
-  // undefined.
+  // undefined. May be called concurrently for distinct nodes.
   virtual NodeDef consume_node_def(int i) = 0;
   // Returns the version information for the graph, or nullptr if none is
   // available.
@@ -406,6 +426,12 @@ class GraphConstructor {
   };
   std::vector<EdgeInfo> back_edges_;
 
+  // The NodeDefs consumed by PrepareNodeDefsInParallel(), and the results of
+  // preparing them, indexed like node_defs_. Empty if the NodeDefs are
+  // consumed one at a time by Convert().
+  std::vector<NodeDef> prepared_node_defs_;
+  std::vector<Status> prepared_statuses_;
+
   GraphConstructor(const GraphConstructor&) = delete;
   void operator=(const GraphConstructor&) = delete;
 };
@@ -486,7 +512,9 @@ class NodeDefMovingGraphConstructor : public GraphConstructor {
   }
 
   GraphDef graph_def_;
-  std::vector<bool> is_consumed_;
+  // Not std::vector<bool>, so that distinct NodeDefs can be consumed
+  // concurrently.
+  std::vector<uint8_t> is_consumed_;
 };
 
 bool ForwardCompatibilityWindowPassed(const VersionDef& versions) {
@@ -863,6 +891,41 @@ Status GraphConstructor::ValidateShape(Node* node) {
   return absl::OkStatus();
 }
 
+Status GraphConstructor::PrepareNodeDef(NodeDef* node_def) {
+  const OpDef* op_def;
+  TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(node_def->op(), &op_def));
+  if (opts_.add_default_attributes) {
+    AddDefaultsToNodeDef(*op_def, node_def);
+  }
+  if (opts_.validate_nodes) {
+    TF_RETURN_IF_ERROR(ValidateNodeDef(*node_def, *op_def));
+  }
+  return absl::OkStatus();
+}
+
+void GraphConstructor::PrepareNodeDefsInParallel() {
+  const int num_nodes = node_def_count();
+  if (opts_.importing || opts_.num_threads <= 1 ||
+      num_nodes < kMinNodesToPrepareInParallel) {
+    return;
+  }
+  prepared_node_defs_.resize(num_nodes);
+  prepared_statuses_.resize(num_nodes);
+  // Preparing a NodeDef depends only on the NodeDef and the op registry, so
+  // the nodes need not be visited in topological order. The statuses are
+  // checked by Convert() in that order.
+  thread::ThreadPool pool(Env::Default(), "graph_constructor",
+                          opts_.num_threads);
+  pool.ParallelFor(num_nodes, kPrepareNodeDefCost,
+                   [this](int64_t begin, int64_t end) {
+                     for (int64_t i = begin; i < end; ++i) {
+                       prepared_node_defs_[i] = consume_node_def(i);
+                       prepared_statuses_[i] =
+                           PrepareNodeDef(&prepared_node_defs_[i]);
+                     }
+                   });
+}
+
 Status GraphConstructor::ModifyNodeDefForImport(NodeDef* node_def) {
   const OpDef* op_def;
   TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(node_def->op(), &op_def));
@@ -1185,6 +1248,8 @@ Status GraphConstructor::Convert() {
         g_->AddFunctionLibrary(*std::move(library), library_traces));
   }
 
+  PrepareNodeDefsInParallel();
+
   std::vector<InputInfo> inputs;
   int processed = 0;
 
@@ -1201,7 +1266,9 @@ Status GraphConstructor::Convert() {
     inputs.clear();
     bool has_data_back_edge = false;
 
-    NodeDef node_def = consume_node_def(o);
+    NodeDef node_def = prepared_node_defs_.empty()
+                           ? consume_node_def(o)
+                           : std::move(prepared_node_defs_[o]);
 
     // input_already_exists[i] is true iff the i-th input of the node we're
     // importing refers to a preexisting node in g_ (i.e. input[i] existed prior
@@ -1297,16 +1364,10 @@ Status GraphConstructor::Convert() {
 
     if (opts_.importing) {
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&node_def));
+    } else if (!prepared_statuses_.empty()) {
+      TF_RETURN_IF_ERROR(prepared_statuses_[o]);
     } else {
-      const OpDef* op_def;
-      TF_RETURN_IF_ERROR(
-          g_->op_registry()->LookUpOpDef(node_def.op(), &op_def));
-      if (opts_.add_default_attributes) {
-        AddDefaultsToNodeDef(*op_def, &node_def);
-      }
-      if (opts_.validate_nodes) {
-        TF_RETURN_IF_ERROR(ValidateNodeDef(node_def, *op_def));
-      }
+      TF_RETURN_IF_ERROR(PrepareNodeDef(&node_def));
     }
 
     TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
@@ -1352,7 +1413,10 @@ Status GraphConstructor::Convert() {
                  << " NODES IN A CYCLE";
     for (int64_t i = 0; i < node_def_count(); i++) {
       if (pending_count_[i] != 0) {
-        LOG(WARNING) << "PENDING: " << SummarizeNodeDef(get_node_def(i))
+        const NodeDef& node_def = prepared_node_defs_.empty()
+                                      ? get_node_def(i)
+                                      : prepared_node_defs_[i];
+        LOG(WARNING) << "PENDING: " << SummarizeNodeDef(node_def)
                      << " WITH PENDING COUNT = " << pending_count_[i];
       }
     }
@@ -52,6 +52,12 @@ struct GraphConstructorOptions {
   // If true, GraphConstructor will add attributes with their default
   // value to the Node when they are missing from the NodeDef.
   bool add_default_attributes = true;
+
+  // If > 1, the NodeDefs of large graphs are copied (or moved), given their
+  // default attributes and validated on this many threads before they are
+  // added to the graph. Errors are still reported for the first failing node
+  // in topological order.
+  int num_threads = 1;
 };
 extern Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                                      const GraphDef& gdef, Graph* g);
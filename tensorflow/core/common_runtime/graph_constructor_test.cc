@@ -925,6 +925,57 @@ TEST_F(GraphConstructorTest, Error_ControlEdgeBeforeRealInput) {
       {"Node 't2': Control dependencies must come after regular dependencies"});
 }
 
+GraphDef ControlChainGraphDef(int num_nodes) {
+  GraphDef def;
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = def.add_node();
+    node->set_name(absl::StrCat("n", i));
+    node->set_op("TestDefaultAttr");
+    if (i > 0) {
+      node->add_input(absl::StrCat("^n", i - 1));
+    }
+  }
+  return def;
+}
+
+TEST_F(GraphConstructorTest, PrepareNodeDefsInParallel) {
+  GraphConstructorOptions opts;
+  opts.validate_nodes = true;
+  opts.num_threads = 4;
+  const GraphDef def = ControlChainGraphDef(2000);
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, def, &graph_));
+  EXPECT_EQ(graph_.num_op_nodes(), 2000);
+  for (Node* node : graph_.op_nodes()) {
+    int default_int;
+    TF_ASSERT_OK(GetNodeAttr(node->attrs(), "default_int", &default_int));
+    EXPECT_EQ(default_int, 31415);
+  }
+  EXPECT_TRUE(HasControlEdge("n0", "n1"));
+  EXPECT_TRUE(HasControlEdge("n1998", "n1999"));
+
+  Graph moved_graph(OpRegistry::Global());
+  GraphDef moved_def = def;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, std::move(moved_def), &moved_graph));
+  EXPECT_EQ(moved_graph.num_op_nodes(), 2000);
+}
+
+TEST_F(GraphConstructorTest, PrepareNodeDefsInParallel_FirstErrorInOrder) {
+  GraphDef def = ControlChainGraphDef(2000);
+  def.mutable_node(1700)->set_op("NotAnOp");
+  (*def.mutable_node(1500)->mutable_attr())["bogus"].set_i(1);
+
+  for (int num_threads : {1, 4}) {
+    GraphConstructorOptions opts;
+    opts.validate_nodes = true;
+    opts.num_threads = num_threads;
+    const string original_graph_description = GraphDebugString();
+    Status status = ConvertGraphDefToGraph(opts, def, &graph_);
+    EXPECT_TRUE(absl::StrContains(status.message(), "bogus")) << status;
+    EXPECT_FALSE(absl::StrContains(status.message(), "NotAnOp")) << status;
+    EXPECT_EQ(original_graph_description, GraphDebugString());
+  }
+}
+
 TEST_F(GraphConstructorTest, ImportGraphDef) {
   GraphDef def;
   ImportGraphDefOptions opts;
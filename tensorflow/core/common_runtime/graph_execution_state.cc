@@ -24,6 +24,7 @@ limitations under the License.
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
@@ -50,8 +51,14 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numbers.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/client_graph_cache.pb.h"
+#include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/util.h"
 
@@ -856,8 +863,154 @@ Status GraphExecutionState::OptimizeGraph(
 #endif  // IS_MOBILE_PLATFORM
 }
 
+namespace {
+
+string GetClientGraphCacheFileName(const string& dir_name, uint64 key) {
+  return absl::StrCat(dir_name, "/client_graph_", strings::FpToString(key),
+                      ".pb");
+}
+
+// Writes `entry` into `file_name`, going through a temporary file so that
+// concurrent readers never observe a partially written entry.
+Status WriteClientGraphToCache(const string& dir_name, const string& file_name,
+                               const ClientGraphCacheEntry& entry, Env* env) {
+  if (!env->FileExists(dir_name).ok()) {
+    TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(dir_name));
+  }
+  string temp_file_name = file_name;
+  if (!env->CreateUniqueFileName(&temp_file_name, ".tmp")) {
+    return errors::Unavailable("Could not create a unique file inside ",
+                               dir_name);
+  }
+  string serialized;
+  if (!SerializeToStringDeterministic(entry, &serialized)) {
+    return errors::Internal("Failed to serialize the client graph.");
+  }
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, temp_file_name, serialized));
+  return env->RenameFile(temp_file_name, file_name);
+}
+
+// Restores the ClientGraph stored in `file_name`, whose functions are
+// resolved against `default_registry`.
+Status ReadClientGraphFromCache(const string& file_name, uint64 key,
+                                const OpRegistryInterface* default_registry,
+                                Env* env, std::unique_ptr<ClientGraph>* out,
+                                uint64* build_time_usecs) {
+  ClientGraphCacheEntry entry;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, file_name, &entry));
+  if (entry.key() != key) {
+    return errors::NotFound("Client graph cache entry ", file_name,
+                            " was written for a different graph.");
+  }
+  GraphDef* graph_def = entry.mutable_graph();
+  auto flib = std::make_unique<FunctionLibraryDefinition>(
+      default_registry, graph_def->library());
+  graph_def->clear_library();
+  DataTypeVector feed_types;
+  for (int dt : entry.feed_types()) {
+    feed_types.push_back(static_cast<DataType>(dt));
+  }
+  DataTypeVector fetch_types;
+  for (int dt : entry.fetch_types()) {
+    fetch_types.push_back(static_cast<DataType>(dt));
+  }
+  auto client_graph = std::make_unique<ClientGraph>(
+      std::move(flib), std::move(feed_types), std::move(fetch_types),
+      entry.collective_graph_key());
+  GraphConstructorOptions opts;
+  opts.allow_internal_ops = true;
+  opts.expect_device_spec = true;
+  TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, std::move(*graph_def),
+                                            &client_graph->graph));
+  *build_time_usecs = entry.build_time_usecs();
+  *out = std::move(client_graph);
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+uint64 GraphExecutionState::ClientGraphCacheKey(
+    const BuildGraphOptions& options) const {
+  string serialized;
+  GraphDef graph_def;
+  graph_->ToGraphDef(&graph_def);
+  SerializeToStringDeterministic(graph_def, &serialized);
+  uint64 key = Fingerprint64(serialized);
+  // Entries written by a different TensorFlow build may have been rewritten by
+  // different passes, so they must not be reused.
+  key = FingerprintCat64(
+      key, Fingerprint64(absl::StrCat(TF_VERSION_STRING, "/",
+                                      TF_GRAPH_DEF_VERSION)));
+
+  for (const Device* device : device_set_->devices()) {
+    key = FingerprintCat64(key, Fingerprint64(device->name()));
+    key = FingerprintCat64(key, Fingerprint64(device->device_type()));
+  }
+  if (session_options_ != nullptr) {
+    SerializeToStringDeterministic(session_options_->config, &serialized);
+    key = FingerprintCat64(key, Fingerprint64(serialized));
+  }
+  SerializeToStringDeterministic(options.callable_options, &serialized);
+  key = FingerprintCat64(key, Fingerprint64(serialized));
+  key = FingerprintCat64(
+      key, Fingerprint64(absl::StrCat(options.DebugString(), "\n",
+                                      "use_function_convention: ",
+                                      options.use_function_convention)));
+  return key;
+}
+
 Status GraphExecutionState::BuildGraph(const BuildGraphOptions& options,
                                        std::unique_ptr<ClientGraph>* out) {
+  const string dir_name =
+      absl::StrCat(getenv(kClientGraphCachingEnvVariableName));
+  if (dir_name.empty() || !graph_) {
+    return BuildGraphUncached(options, out);
+  }
+
+  Env* env = Env::Default();
+  const uint64 key = ClientGraphCacheKey(options);
+  const string file_name = GetClientGraphCacheFileName(dir_name, key);
+  if (env->FileExists(file_name).ok()) {
+    uint64 build_time_usecs = 0;
+    Status s =
+        ReadClientGraphFromCache(file_name, key, flib_def_->default_registry(),
+                                 env, out, &build_time_usecs);
+    if (s.ok()) {
+      LOG(INFO) << "Restored the TensorFlow client graph from the cache file "
+                << file_name << ", saved build time: "
+                << build_time_usecs / 1000 << " msecs";
+      return absl::OkStatus();
+    }
+    LOG(ERROR) << "Reading from the TensorFlow client graph cache failed. "
+                  "Continue to build the client graph instead. Error: "
+               << s;
+  }
+
+  const uint64 start_time_usecs = env->NowMicros();
+  TF_RETURN_IF_ERROR(BuildGraphUncached(options, out));
+
+  ClientGraphCacheEntry entry;
+  entry.set_key(key);
+  (*out)->graph.ToGraphDef(entry.mutable_graph());
+  for (DataType dt : (*out)->feed_types) entry.add_feed_types(dt);
+  for (DataType dt : (*out)->fetch_types) entry.add_fetch_types(dt);
+  entry.set_collective_graph_key((*out)->collective_graph_key);
+  entry.set_build_time_usecs(env->NowMicros() - start_time_usecs);
+  Status s = WriteClientGraphToCache(dir_name, file_name, entry, env);
+  // Failing to populate the cache only costs a rebuild in the next process.
+  if (!s.ok()) {
+    LOG(ERROR) << "Caching the TensorFlow client graph failed; continue "
+                  "without caching. Error: "
+               << s;
+  } else {
+    VLOG(1) << "Wrote the TensorFlow client graph into the cache file "
+            << file_name;
+  }
+  return absl::OkStatus();
+}
+
+Status GraphExecutionState::BuildGraphUncached(
+    const BuildGraphOptions& options, std::unique_ptr<ClientGraph>* out) {
   VLOG(1) << "BuildGraph";
   const uint64 start_time_usecs = Env::Default()->NowMicros();
   if (!graph_) {
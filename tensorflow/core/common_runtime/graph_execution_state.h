@@ -35,6 +35,14 @@ limitations under the License.
 namespace tensorflow {
 struct SessionOptions;
 
+// Environment variable naming a directory in which `BuildGraph()` persists the
+// client graphs that it produces. When it is set, a later `BuildGraph()` call
+// (typically in a later process) for the same placed graph, device set,
+// session config and build options restores the client graph from the
+// directory instead of running grappler and the POST_REWRITE_FOR_EXEC passes.
+static const char kClientGraphCachingEnvVariableName[] =
+    "TF_CLIENT_GRAPH_CACHING";
+
 namespace subgraph {
 struct RewriteGraphMetadata;
 }
@@ -140,6 +148,9 @@ class GraphExecutionState {
   // the Node set specified in "options").  If successful, returns OK
   // and the caller takes the ownership of "*out". Otherwise, returns
   // an error.
+  //
+  // If `kClientGraphCachingEnvVariableName` is set, the result is read from,
+  // or written to, the on-disk client graph cache.
   Status BuildGraph(const BuildGraphOptions& options,
                     std::unique_ptr<ClientGraph>* out);
 
@@ -198,6 +209,15 @@ class GraphExecutionState {
   Status PruneGraph(const BuildGraphOptions& options, Graph* graph,
                     subgraph::RewriteGraphMetadata* out_rewrite_metadata);
 
+  // Builds the ClientGraph for `options` without consulting the on-disk
+  // client graph cache.
+  Status BuildGraphUncached(const BuildGraphOptions& options,
+                            std::unique_ptr<ClientGraph>* out);
+
+  // Returns the key under which the ClientGraph for `options` is stored in
+  // the on-disk client graph cache.
+  uint64 ClientGraphCacheKey(const BuildGraphOptions& options) const;
+
   // The GraphExecutionState must store a copy of the original GraphDef if
   // either of the following conditions holds:
   //
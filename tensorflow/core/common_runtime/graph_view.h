@@ -30,6 +30,7 @@ limitations under the License.
 namespace tensorflow {
 
 class Device;
+class DeviceContext;
 class Graph;
 class Node;
 class OpKernel;
@@ -60,6 +61,11 @@ struct NodeItem {
   // The index of this node's item in its GraphView.
   int node_id = -1;
 
+  // Nodes of lower priority run first when several nodes become ready at
+  // once. Set from the "_scheduling_priority" attribute that grappler's
+  // memory optimizer attaches to nodes; 0 if unset.
+  int32 scheduling_priority = 0;
+
   // Cached attributes of this node for fast lookup.
   bool kernel_is_async : 1;     // True iff kernel->AsAsync() != nullptr
   bool is_merge : 1;            // True iff IsMerge(node)
@@ -89,6 +95,11 @@ struct NodeItem {
   // The kernel for this node.
   OpKernel* kernel = nullptr;
 
+  // The DeviceContext the kernel runs with, if the device picked one for this
+  // node; otherwise the kernel runs with the executor's DeviceContext. Not
+  // owned.
+  DeviceContext* device_context = nullptr;
+
   // If the kernel is a Const op, this containts points to the constant tensor.
   const Tensor* const_tensor = nullptr;
 
@@ -18,7 +18,9 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
 #include "tensorflow/core/common_runtime/collective_util.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -107,75 +109,105 @@ Status HierarchicalTreeBroadcaster::InitializeCollectiveParams(
             << device_name << " source_rank=" << col_params->source_rank
             << " dev_per_task=" << dpt_buf;
   }
-  int num_tasks = col_params->group.num_tasks;
+  const int num_tasks = col_params->group.num_tasks;
+  std::vector<int> task_start(num_tasks, 0);
+  for (int ti = 1; ti < num_tasks; ti++) {
+    task_start[ti] = task_start[ti - 1] + dev_per_task[ti - 1];
+  }
+  const int source_task = GetDeviceTask(col_params->source_rank, dev_per_task);
+  // Each task receives the value on one device, the task leader: the source
+  // device for the source task and device 0 for every other task.
+  std::vector<int> task_leader(task_start);
+  task_leader[source_task] = col_params->source_rank;
+
+  // Group the tasks by rack, in order of first appearance.  The rack leader is
+  // the source task for the source rack and the first task of every other
+  // rack.
+  const absl::flat_hash_map<string, string> rack_hints =
+      collective_util::RackHintsFromEnv();
+  std::vector<std::vector<int>> tasks_per_rack;
+  std::vector<int> task_rack(num_tasks);
+  {
+    absl::flat_hash_map<string, int> rack_index;
+    for (int ti = 0; ti < num_tasks; ti++) {
+      const string& task = col_params->group.members[task_start[ti]].task;
+      auto hint = rack_hints.find(task);
+      const string rack = hint == rack_hints.end() ? "" : hint->second;
+      auto it = rack_index.emplace(rack, tasks_per_rack.size()).first;
+      if (it->second == tasks_per_rack.size()) tasks_per_rack.emplace_back();
+      task_rack[ti] = it->second;
+      tasks_per_rack[it->second].push_back(ti);
+    }
+  }
+  const int num_racks = tasks_per_rack.size();
+  // A rack level only helps if some rack holds more than one task.
+  const bool use_racks = num_racks > 1 && num_racks < num_tasks;
+
+  // Appends a subdiv over `perm`, in which the device at `source` holds the
+  // value first.  If this device does not participate in the subdiv, its
+  // subdiv_rank is -1.
+  auto add_subdiv = [col_params, &device_name](const std::vector<int>& perm,
+                                               int source) {
+    int rank = -1;
+    int source_rank = -1;
+    for (int i = 0; i < perm.size(); i++) {
+      if (col_params->group.members[perm[i]].device.name() == device_name) {
+        rank = i;
+      }
+      if (perm[i] == source) source_rank = i;
+    }
+    col_params->instance.impl_details.subdiv_permutations.push_back(perm);
+    col_params->subdiv_rank.push_back(rank);
+    col_params->instance.impl_details.subdiv_source_rank.push_back(
+        source_rank);
+  };
+
   // If there is just 1 task, then execute binary tree broadcast over all
   // devices.  Otherwise, the first subdiv is inter-task broadcast, and then
-  // there are N more subdivs, where N is #task.
-  int num_subdivs = num_tasks + (num_tasks > 1 ? 1 : 0);
-  int total_num_devices = 0;
-  for (int num_dev : dev_per_task) total_num_devices += num_dev;
-
-  col_params->instance.impl_details.subdiv_permutations.resize(num_subdivs);
-  col_params->subdiv_rank.reserve(num_subdivs);
-  col_params->instance.impl_details.subdiv_source_rank.reserve(num_subdivs);
-
-  // Inter-task subdiv.  Pick one device from each task - this is the source
-  // device if it belongs to that task, or device 0 for that task.  If a device
-  // does not participate in the subdiv, set subdiv_rank to -1.
-  if (num_tasks > 1) {
-    const int sdi = 0;
-    std::vector<int>& perm =
-        col_params->instance.impl_details.subdiv_permutations[sdi];
-    CHECK_EQ(perm.size(), 0);
-    int device_count = 0;
-    int source_task = GetDeviceTask(col_params->source_rank, dev_per_task);
-    for (int ti = 0; ti < col_params->group.num_tasks; ti++) {
-      bool participate = false;
-      if (source_task == ti) {
-        // Source device belongs to this task.
-        perm.push_back(col_params->source_rank);
-        participate =
-            col_params->group.members[col_params->source_rank].device.name() ==
-            device_name;
-      } else {
-        // Source does not belong to this task, choose dev 0.
-        perm.push_back(device_count);
-        participate = col_params->group.members[device_count].device.name() ==
-                      device_name;
-      }
-      if (participate) col_params->subdiv_rank.push_back(ti);
-      device_count += dev_per_task[ti];
+  // there are N more subdivs, where N is #task.  If the rack hints group the
+  // tasks into R racks, the first subdiv is instead an inter-rack broadcast
+  // between one task leader per rack, followed by R subdivs that broadcast
+  // between the task leaders of each rack, so that the value crosses each
+  // inter-rack link only once.
+  col_params->instance.impl_details.subdiv_permutations.clear();
+  col_params->subdiv_rank.clear();
+  col_params->instance.impl_details.subdiv_source_rank.clear();
+  if (use_racks) {
+    std::vector<int> perm;
+    for (int ri = 0; ri < num_racks; ri++) {
+      int leader_task = ri == task_rack[source_task] ? source_task
+                                                     : tasks_per_rack[ri][0];
+      perm.push_back(task_leader[leader_task]);
+    }
+    add_subdiv(perm, col_params->source_rank);
+    for (int ri = 0; ri < num_racks; ri++) {
+      perm.clear();
+      for (int ti : tasks_per_rack[ri]) perm.push_back(task_leader[ti]);
+      add_subdiv(perm, ri == task_rack[source_task]
+                           ? col_params->source_rank
+                           : task_leader[tasks_per_rack[ri][0]]);
     }
-    if (col_params->subdiv_rank.empty()) col_params->subdiv_rank.push_back(-1);
-    col_params->instance.impl_details.subdiv_source_rank.push_back(source_task);
+  } else if (num_tasks > 1) {
+    // Inter-task subdiv.  Pick the leader from each task.
+    add_subdiv(task_leader, col_params->source_rank);
   }
   VLOG(2) << collective_util::SubdivPermDebugString(*col_params);
 
-  // Intra-task subdivs.  Pick all devices in task ti for subdiv sdi.  Set
-  // source to dev 0 for that task if it does not contain original source, else
-  // set to rank of original source.  If a device does not participate in
-  // the subdiv, set subdiv_rank to -1;
-  int abs_di = 0;
-  for (int ti = 0; ti < col_params->group.num_tasks; ti++) {
-    const int sdi = ti + (num_tasks > 1 ? 1 : 0);
-    std::vector<int>& perm =
-        col_params->instance.impl_details.subdiv_permutations[sdi];
-    CHECK_EQ(perm.size(), 0);
-    bool participate = false;
-    int subdiv_source = 0;
+  // Intra-task subdivs.  Pick all devices in task ti for subdiv sdi, with the
+  // task leader as source.  If the devices report interconnect links or NUMA
+  // nodes, they are ordered so that each device receives from a closely
+  // connected one.
+  for (int ti = 0; ti < num_tasks; ti++) {
+    std::vector<int> perm(dev_per_task[ti]);
     for (int di = 0; di < dev_per_task[ti]; di++) {
-      perm.push_back(abs_di);
-      if (col_params->group.members[abs_di].device.name() == device_name) {
-        participate = true;
-        col_params->subdiv_rank.push_back(di);
-      }
-      if (abs_di == col_params->source_rank) subdiv_source = di;
-      abs_di++;
+      perm[di] = task_start[ti] + di;
     }
-    if (!participate) col_params->subdiv_rank.push_back(-1);
-    col_params->instance.impl_details.subdiv_source_rank.push_back(
-        subdiv_source);
+    add_subdiv(collective_util::OrderForTreeBroadcast(col_params->group, perm,
+                                                      task_leader[ti]),
+               task_leader[ti]);
   }
+  const int num_subdivs = static_cast<int>(
+      col_params->instance.impl_details.subdiv_permutations.size());
 
   for (int sri = 0; sri < num_subdivs; sri++) {
     CHECK_GE(col_params->instance.impl_details.subdiv_source_rank[sri], 0);
@@ -287,9 +319,15 @@ void HierarchicalTreeBroadcaster::TreeSendTo(const CollectiveParams& cp,
 // Each task receives a copy of the tensor on one device via this broadcast.
 // Subsequent subdivs correspond to intra-task broadcasts.  Subdiv i+1
 // corresponds to broadcast between all devices on task i.  Thus, each task
-// participates in at most 2 subdivs.
+// participates in at most 2 subdivs.  If rack hints add an inter-rack level,
+// the global subdiv is between racks and is followed by one subdiv per rack,
+// so a task participates in at most 3 subdivs.
 void HierarchicalTreeBroadcaster::RunTree() {
   int num_subdivs = static_cast<int>(col_params_->subdiv_rank.size());
+  int last_subdiv = -1;
+  for (int si = 0; si < num_subdivs; si++) {
+    if (col_params_->subdiv_rank[si] >= 0) last_subdiv = si;
+  }
   // TODO(b/78352018): this is easily improved when a node participates in both
   // first and second subdivision.  It would first send to its descendents in
   // the first subdiv, then wait until all pending ops are finished before
@@ -360,11 +398,11 @@ void HierarchicalTreeBroadcaster::RunTree() {
       // For the original source device, we copy input to output if they are
       // different.
       // If there is only 1 subdiv, we do this in that subdiv.  If there is more
-      // than 1 subdiv, then the original source device will participate in 2
-      // subdivs - the global inter-task broadcast and one local intra-task
-      // broadcast.  In this case, we perform the copy in the second subdiv for
-      // this device.
-      if (status_.ok() && is_source_ && (1 == num_subdivs || 0 != si)) {
+      // than 1 subdiv, then the original source device will participate in
+      // the global broadcast, possibly its rack broadcast, and one local
+      // intra-task broadcast.  In this case, we perform the copy in the last
+      // of these subdivs for this device.
+      if (status_.ok() && is_source_ && si == last_subdiv) {
         VLOG(2) << "copying input to output for device="
                 << col_ctx_->device_name << " subdiv=" << si;
         if (col_ctx_->input != col_ctx_->output &&
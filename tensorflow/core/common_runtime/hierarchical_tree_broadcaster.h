@@ -35,6 +35,11 @@ class HierarchicalTreeBroadcaster : public CollectiveImplementationInterface {
   // The first subdiv comprises one device per task which gets the tensor on
   // each task.  Subdiv i+1 corresponds to a task-local tree-broadcast for task
   // i.
+  // If `collective_util::kRackHintsEnvVar` places the tasks into r racks, some
+  // holding more than one task, there are instead 1+r+n subdivs: one device
+  // per rack, then one device per task for each rack, then one subdiv per task.
+  // Within a task, devices with interconnect links or NUMA locality are
+  // ordered so that each device receives from a closely connected one.
   Status InitializeCollectiveParams(CollectiveParams* col_params) override;
 
   // Initializes members of CollectiveContext not yet initialized, i.e. device
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/base_collective_executor.h"
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
 #include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/device_resolver_local.h"
 #include "tensorflow/core/common_runtime/process_util.h"
@@ -400,6 +401,80 @@ TEST_F(HierarchicalTreeBroadcasterInitParamsTest,
                      {-1, -1, 1, -1, -1}, {2, 0, 0, 1, 0});
 }
 
+TEST_F(HierarchicalTreeBroadcasterInitParamsTest,
+       InitializeParams4Tasks2RacksFromHints) {
+  auto* cp = new CollectiveParams();
+  core::ScopedUnref unref(cp);
+  cp->group.device_type = DeviceType("GPU");
+  cp->group.num_tasks = 4;
+  cp->group.group_size = 0;
+  cp->instance.type = BROADCAST_COLLECTIVE;
+  cp->instance.impl_details.collective_name = "HierarchicalTreeBroadcast";
+  for (int ti = 0; ti < cp->group.num_tasks; ti++) {
+    string task_name = strings::StrCat("/job:worker/replica:0/task:", ti);
+    for (int di = 0; di < 2; di++) {
+      CollGroupMember member;
+      member.device.set_name(strings::StrCat(task_name, "/device:GPU:", di));
+      member.task = task_name;
+      cp->group.members.push_back(member);
+      cp->group.group_size++;
+    }
+  }
+  setenv(collective_util::kRackHintsEnvVar,
+         "/job:worker/replica:0/task:0=a,/job:worker/replica:0/task:1=a,"
+         "/job:worker/replica:0/task:2=b,/job:worker/replica:0/task:3=b",
+         1);
+
+  // source 0 device 0
+  cp->source_rank = 0;
+  cp->default_rank = 0;
+  RunSubdivPermsTest(cp,
+                     {{0, 4}, {0, 2}, {4, 6}, {0, 1}, {2, 3}, {4, 5}, {6, 7}},
+                     {0, 0, -1, 0, -1, -1, -1}, {0, 0, 0, 0, 0, 0, 0});
+
+  // source 5 device 6
+  cp->source_rank = 5;
+  cp->default_rank = 6;
+  RunSubdivPermsTest(cp,
+                     {{0, 5}, {0, 2}, {5, 6}, {0, 1}, {2, 3}, {4, 5}, {6, 7}},
+                     {-1, -1, 1, -1, -1, -1, 0}, {1, 0, 0, 0, 0, 1, 0});
+  unsetenv(collective_util::kRackHintsEnvVar);
+}
+
+TEST_F(HierarchicalTreeBroadcasterInitParamsTest,
+       InitializeParamsOrdersDevicesByLinks) {
+  auto* cp = new CollectiveParams();
+  core::ScopedUnref unref(cp);
+  cp->group.device_type = DeviceType("GPU");
+  cp->group.num_tasks = 1;
+  cp->group.group_size = 4;
+  cp->instance.type = BROADCAST_COLLECTIVE;
+  cp->instance.impl_details.collective_name = "HierarchicalTreeBroadcast";
+  const string task_name = "/job:worker/replica:0/task:0";
+  for (int di = 0; di < cp->group.group_size; di++) {
+    CollGroupMember member;
+    member.device.set_name(strings::StrCat(task_name, "/device:GPU:", di));
+    member.task = task_name;
+    cp->group.members.push_back(member);
+  }
+  auto add_link = [cp](int from, int to, int strength) {
+    InterconnectLink* link = cp->group.members[from]
+                                 .device.mutable_locality()
+                                 ->mutable_links()
+                                 ->add_link();
+    link->set_device_id(to);
+    link->set_strength(strength);
+  };
+  // GPU:0 is strongly linked to GPU:2, which is strongly linked to GPU:3.
+  add_link(0, 2, 10);
+  add_link(0, 3, 1);
+  add_link(2, 3, 10);
+
+  cp->source_rank = 0;
+  cp->default_rank = 1;
+  RunSubdivPermsTest(cp, {{0, 2, 3, 1}}, {3}, {0});
+}
+
 // TODO(b/113171733): change to use TEST_P.
 // Tests of full broadcast algorithm, with different device and
 // data types.
@@ -455,6 +530,17 @@ DEF_TEST(INT64, CPU, 2, 4, 128, 0, false)
 // Failure cases
 DEF_TEST(FLOAT, CPU, 2, 4, 128, 1, true)
 DEF_TEST(FLOAT, CPU, 2, 4, 128, 5, false)
+
+TEST_F(HierarchicalTreeBroadcasterTest, BroadcastAcrossRacks) {
+  setenv(collective_util::kRackHintsEnvVar,
+         "/job:worker/replica:0/task:1=a,/job:worker/replica:0/task:2=b,"
+         "/job:worker/replica:0/task:3=b,/job:worker/replica:0/task:4=b",
+         1);
+  RunTest<float>(DT_FLOAT, DEVICE_CPU, /*num_workers=*/5, /*num_devices=*/2,
+                 /*tensor_len=*/1001, /*fail_after=*/0,
+                 /*forward_input=*/false);
+  unsetenv(collective_util::kRackHintsEnvVar);
+}
 #endif
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -137,6 +137,7 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
       return s;
     }
     CHECK(item->kernel);
+    item->device_context = params_.device->GetNodeDeviceContext(*n);
     item->kernel_is_async = (item->kernel->AsAsync() != nullptr);
     item->is_merge = IsMerge(n);
     item->is_any_consumer_merge_or_control_trigger = false;
@@ -196,6 +197,10 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
     item->is_recv_or_switch = IsRecv(n) || IsSwitch(n);
     item->is_next_iteration = IsNextIteration(n);
     item->is_distributed_communication = IsDistributedCommunication(n);
+    if (TryGetNodeAttr(n->attrs(), "_scheduling_priority",
+                       &item->scheduling_priority)) {
+      has_scheduling_priorities_ = true;
+    }
 
     // Compute the maximum values we'll store for this node in the
     // pending counts data structure, and allocate a handle in
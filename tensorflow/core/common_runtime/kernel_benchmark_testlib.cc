@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
@@ -40,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/reporter.h"
 
 namespace tensorflow {
 namespace test {
@@ -206,5 +208,30 @@ void Benchmark::RunWithRendezvousArgs(
   TF_CHECK_OK(device_->Sync());
 }
 
+void TestLogBenchmarkReporter::ReportRuns(const std::vector<Run>& runs) {
+  ::benchmark::ConsoleReporter::ReportRuns(runs);
+  for (const Run& run : runs) {
+    // Aggregates are derived from the runs, which are all reported.
+    if (run.error_occurred || run.run_type != Run::RT_Iteration) continue;
+    string name = run.benchmark_name();
+    if (run.repetitions > 1) {
+      strings::StrAppend(&name, "/repetition:", run.repetition_index);
+    }
+    double throughput = 0;
+    auto bytes_per_second = run.counters.find("bytes_per_second");
+    if (bytes_per_second != run.counters.end()) {
+      throughput = bytes_per_second->second.value / (1024.0 * 1024.0);
+    }
+    TestReporter reporter(name);
+    TF_CHECK_OK(reporter.Initialize());
+    TF_CHECK_OK(reporter.Benchmark(run.iterations, run.cpu_accumulated_time,
+                                   run.real_accumulated_time, throughput));
+    for (const auto& [counter, value] : run.counters) {
+      TF_CHECK_OK(reporter.SetProperty(counter, value.value));
+    }
+    TF_CHECK_OK(reporter.Close());
+  }
+}
+
 }  // end namespace test
 }  // end namespace tensorflow
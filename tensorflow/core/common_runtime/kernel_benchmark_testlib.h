@@ -80,6 +80,15 @@ class Benchmark {
 // Returns the rendezvous key associated with the given Send/Recv node.
 string GetRendezvousKey(const Node* node);
 
+// Reports benchmark runs to the console, and also writes each of them as a
+// BenchmarkEntry (test_log.proto) with TestReporter when the
+// TEST_REPORT_FILE_PREFIX environment variable is set, so that
+// tools/test:run_and_gather_logs can collect them.
+class TestLogBenchmarkReporter : public ::benchmark::ConsoleReporter {
+ public:
+  void ReportRuns(const std::vector<Run>& runs) override;
+};
+
 }  // end namespace test
 }  // end namespace tensorflow
 
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <iterator>
@@ -23,6 +24,7 @@ limitations under the License.
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
@@ -86,6 +88,19 @@ int64_t GetParallelSubgraphThreshold() {
   return parallel_subgraph_threshold;
 }
 
+// Returns the maximum number of component functions that are instantiated
+// concurrently on a thread pool with `num_threads` threads.
+int64_t GetMaxParallelInstantiations(int num_threads) {
+  static int64_t max_parallel_instantiations = []() {
+    int64_t result;
+    TF_CHECK_OK(tsl::ReadInt64FromEnvVar(
+        "TF_PFLR_PARALLEL_INSTANTIATE_MAX_IN_FLIGHT", 0, &result));
+    return result;
+  }();
+  return max_parallel_instantiations > 0 ? max_parallel_instantiations
+                                         : std::max(num_threads, 1);
+}
+
 }  // namespace
 
 const char ProcessFunctionLibraryRuntime::kDefaultFLRDevice[] = "null";
@@ -758,6 +773,27 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
 
   // Instantiate each component function (subgraph).
   //
+  // Component names are assigned up front, in partition order, so that the
+  // resulting function does not depend on the order in which the components
+  // finish instantiating. Remote components are instantiated asynchronously, so
+  // all registrations are issued before waiting for any of them.
+  struct PendingComponent {
+    const string* target;
+    std::unique_ptr<Graph>* subgraph;
+    ComponentFunctionData* comp_data;
+    Status* status;
+  };
+  std::vector<PendingComponent> components;
+  components.reserve(num_subgraphs);
+  for (auto& pair : *subgraphs) {
+    ComponentFunctionData* comp_data = &data->glue_[pair.first];
+    comp_data->name = name_generator.GetName();
+    components.push_back(
+        {&pair.first, &pair.second, comp_data, &instantiate_status[i]});
+    i += 1;
+  }
+  BlockingCounter counter(num_subgraphs);
+
   // NOTE: Only use thread pool to instantiate sub-function when there are
   // more than a threshold (default 8) of sub-functions. We want to avoid cost
   // of switching thread when there are only a few sub-functions. However, for
@@ -765,36 +801,48 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   // running out of memory.
   if (default_thread_pool_ != nullptr &&
       num_subgraphs > GetParallelSubgraphThreshold()) {
-    BlockingCounter counter(static_cast<int>(num_subgraphs));
-    for (auto& pair : *subgraphs) {
-      Status* status = &instantiate_status[i];
-      ComponentFunctionData* comp_data = &data->glue_[pair.first];
-      comp_data->name = name_generator.GetName();
-      default_thread_pool_->Schedule(
-          [&instantiate_component, &pair, comp_data, &counter, status]() {
-            instantiate_component(pair.first, std::move(pair.second), comp_data,
-                                  [&counter, status](Status s) {
-                                    status->Update(s);
-                                    counter.DecrementCount();
-                                  });
+    // At most `max_in_flight` components are being instantiated at any time,
+    // which bounds the memory used by the intermediate `FunctionDef`s. When a
+    // component finishes, its slot is handed to the next pending component, so
+    // that pool threads are not blocked waiting for remote instantiations.
+    const int max_in_flight = std::min<int64_t>(
+        num_subgraphs,
+        GetMaxParallelInstantiations(default_thread_pool_->NumThreads()));
+    std::atomic<int> next_component{max_in_flight};
+    std::function<void(int)> instantiate_at;
+    instantiate_at = [this, &instantiate_component, &components,
+                      &next_component, &instantiate_at, &counter,
+                      num_subgraphs](int index) {
+      PendingComponent& c = components[index];
+      instantiate_component(
+          *c.target, std::move(*c.subgraph), c.comp_data,
+          [this, &next_component, &instantiate_at, &counter, num_subgraphs,
+           status = c.status](Status s) {
+            status->Update(s);
+            // Claim the next component before releasing this one, so that
+            // `counter` cannot reach zero while it is still scheduled.
+            const int next = next_component.fetch_add(1);
+            if (next < num_subgraphs) {
+              default_thread_pool_->Schedule(
+                  [&instantiate_at, next]() { instantiate_at(next); });
+            }
+            counter.DecrementCount();
           });
-      i += 1;
+    };
+    for (int index = 0; index < max_in_flight; ++index) {
+      default_thread_pool_->Schedule(
+          [&instantiate_at, index]() { instantiate_at(index); });
     }
     counter.Wait();
   } else {
-    for (auto& pair : *subgraphs) {
-      Notification n;
-      Status* status = &instantiate_status[i];
-      ComponentFunctionData* comp_data = &data->glue_[pair.first];
-      comp_data->name = name_generator.GetName();
-      instantiate_component(pair.first, std::move(pair.second), comp_data,
-                            [&n, status](Status s) {
+    for (PendingComponent& c : components) {
+      instantiate_component(*c.target, std::move(*c.subgraph), c.comp_data,
+                            [&counter, status = c.status](Status s) {
                               status->Update(s);
-                              n.Notify();
+                              counter.DecrementCount();
                             });
-      n.WaitForNotification();
-      i += 1;
     }
+    counter.Wait();
   }
 
   StatusGroup group;
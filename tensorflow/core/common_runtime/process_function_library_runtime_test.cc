@@ -38,7 +38,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
@@ -1411,5 +1413,136 @@ TEST_F(ProcessFunctionLibraryRuntimeTest, RecordAotSavingTimeAndHitCount) {
             1);
 }
 
+// Returns a function that squares its input on each of `num_devices` CPU
+// devices, so that it is partitioned into `num_devices` component functions.
+FunctionDef DeviceFanOut(int num_devices) {
+  std::vector<string> ret_args;
+  std::vector<FunctionDefHelper::Node> nodes;
+  std::vector<std::pair<string, string>> ret_def;
+  for (int d = 0; d < num_devices; ++d) {
+    const string name = strings::StrCat("y", d);
+    ret_args.push_back(strings::StrCat(name, ": float"));
+    nodes.push_back({{name},
+                     "Mul",
+                     {"x", "x"},
+                     {{"T", DT_FLOAT}},
+                     {},
+                     strings::StrCat("/device:CPU:", d)});
+    ret_def.push_back({name, strings::StrCat(name, ":z:0")});
+  }
+  return FunctionDefHelper::Create("DeviceFanOut", {"x: float"}, ret_args, {},
+                                   nodes, ret_def);
+}
+
+// A process function library runtime over `num_devices` CPU devices, which
+// instantiates component functions on a thread pool when `num_threads > 0`.
+class DeviceFanOutRuntime {
+ public:
+  DeviceFanOutRuntime(int num_devices, int num_threads)
+      : rendezvous_cache_(new RendezvousCache<IntraProcessRendezvous>()) {
+    SessionOptions options;
+    (*options.config.mutable_device_count())["CPU"] = num_devices;
+    std::vector<std::unique_ptr<Device>> devices;
+    TF_CHECK_OK(DeviceFactory::AddDevices(options, "/job:a/replica:0/task:0",
+                                          &devices));
+    device_mgr_ = std::make_unique<StaticDeviceMgr>(std::move(devices));
+    FunctionDefLibrary proto;
+    *proto.add_function() = DeviceFanOut(num_devices);
+    lib_def_ = std::make_unique<FunctionLibraryDefinition>(OpRegistry::Global(),
+                                                           proto);
+    if (num_threads > 0) {
+      thread_pool_ = std::make_unique<thread::ThreadPool>(
+          Env::Default(), "pflr_instantiate", num_threads);
+    }
+    pflr_ = std::make_unique<ProcessFunctionLibraryRuntime>(
+        device_mgr_.get(), Env::Default(), /*config=*/nullptr,
+        TF_GRAPH_DEF_VERSION, lib_def_.get(), OptimizerOptions(),
+        thread_pool_.get(), /*parent=*/nullptr, /*session_metadata=*/nullptr,
+        Rendezvous::Factory{[this](const int64_t step_id,
+                                   const DeviceMgr* device_mgr,
+                                   tsl::core::RefCountPtr<Rendezvous>* r) {
+          *r = rendezvous_cache_->FindOrCreate(step_id, [device_mgr]() {
+            return tsl::core::RefCountPtr<IntraProcessRendezvous>(
+                new IntraProcessRendezvous(device_mgr));
+          });
+          return absl::OkStatus();
+        }});
+    std::vector<string> output_devices;
+    for (int d = 0; d < num_devices; ++d) {
+      output_devices.push_back(strings::StrCat("CPU:", d));
+    }
+    inst_opts_ = MakeOptions("CPU:0", {"CPU:0"}, output_devices);
+  }
+
+  Status Instantiate(FunctionLibraryRuntime::Handle* handle) {
+    return pflr_->Instantiate("DeviceFanOut", AttrSlice(), inst_opts_, handle);
+  }
+
+  ProcessFunctionLibraryRuntime* pflr() { return pflr_.get(); }
+
+ private:
+  std::unique_ptr<StaticDeviceMgr> device_mgr_;
+  std::unique_ptr<FunctionLibraryDefinition> lib_def_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  tsl::core::RefCountPtr<RendezvousCache<IntraProcessRendezvous>>
+      rendezvous_cache_;
+  std::unique_ptr<ProcessFunctionLibraryRuntime> pflr_;
+  FunctionLibraryRuntime::InstantiateOptions inst_opts_;
+};
+
+TEST(ProcessFunctionLibraryRuntimeParallelTest, ManyComponentsOnThreadPool) {
+  // More components than the default parallel instantiation threshold, and
+  // more components than threads, so that slots are reused.
+  constexpr int kNumDevices = 12;
+  DeviceFanOutRuntime runtime(kNumDevices, /*num_threads=*/3);
+  FunctionLibraryRuntime::Handle handle;
+  TF_ASSERT_OK(runtime.Instantiate(&handle));
+
+  std::function<void(std::function<void()>)> runner =
+      [](std::function<void()> fn) {
+        test::function::FunctionTestSchedClosure(fn);
+      };
+  FunctionLibraryRuntime::Options opts;
+  opts.runner = &runner;
+  std::vector<Tensor> out;
+  Notification done;
+  Status status;
+  runtime.pflr()->Run(opts, handle, {test::AsTensor<float>({1, 2, 3})}, &out,
+                      [&status, &done](const Status& s) {
+                        status = s;
+                        done.Notify();
+                      });
+  done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  ASSERT_EQ(out.size(), kNumDevices);
+  for (const Tensor& t : out) {
+    test::ExpectTensorEqual<float>(t, test::AsTensor<float>({1, 4, 9}));
+  }
+  TF_ASSERT_OK(runtime.pflr()->ReleaseHandle(handle));
+}
+
+// Measures the latency of instantiating a function with `state.range(0)`
+// component functions, on a thread pool with `state.range(1)` threads (or
+// inline if 0).
+void BM_InstantiateMultiDevice(::testing::benchmark::State& state) {
+  const int num_devices = state.range(0);
+  const int num_threads = state.range(1);
+  DeviceFanOutRuntime runtime(num_devices, num_threads);
+  for (auto s : state) {
+    FunctionLibraryRuntime::Handle handle;
+    TF_CHECK_OK(runtime.Instantiate(&handle));
+    // Releasing the handle drops the cached instantiation, so that the next
+    // iteration instantiates the function again.
+    TF_CHECK_OK(runtime.pflr()->ReleaseHandle(handle));
+  }
+  state.SetItemsProcessed(state.iterations() * num_devices);
+}
+BENCHMARK(BM_InstantiateMultiDevice)
+    ->ArgPair(4, 0)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 4)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 8);
+
 }  // anonymous namespace
 }  // namespace tensorflow
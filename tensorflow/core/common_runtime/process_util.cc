@@ -22,10 +22,16 @@ limitations under the License.
 #endif  // defined(ENABLE_MKL) && defined(ENABLE_ONEDNN_OPENMP)
 #include <string.h>
 
+#include <algorithm>
+
+#include "absl/container/inlined_vector.h"
+
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/util.h"
 #include "tsl/platform/tracing.h"
@@ -90,6 +96,40 @@ thread::ThreadPool* ComputePool(const SessionOptions& options) {
   return compute_pool;
 }
 
+thread::ThreadPool* NumaComputePool(const SessionOptions& options,
+                                    int numa_node) {
+  static mutex& mu = *new mutex;
+  static auto& pools TF_GUARDED_BY(mu) =
+      *new absl::InlinedVector<thread::ThreadPool*, 4UL>;
+
+  DCHECK_GE(numa_node, 0);
+  mutex_lock l(mu);
+  while (numa_node >= pools.size()) {
+    pools.push_back(nullptr);
+  }
+  if (pools[numa_node] == nullptr) {
+    int32_t num_threads = options.config.inter_op_parallelism_threads();
+    if (num_threads <= 0) {
+      num_threads = GetEnvNumInterOpThreads();
+    }
+    if (num_threads > 0) {
+      const int num_numa_nodes = std::max(1, port::NUMANumNodes());
+      num_threads = (num_threads + num_numa_nodes - 1) / num_numa_nodes;
+    } else {
+      num_threads = port::MaxParallelism(numa_node);
+    }
+    VLOG(1) << "NUMA node " << numa_node
+            << " inter op parallelism threads: " << num_threads;
+    ThreadOptions thread_opts;
+    thread_opts.numa_node = numa_node;
+    pools[numa_node] = new thread::ThreadPool(
+        options.env, thread_opts, strings::StrCat("numa_", numa_node, "_Compute"),
+        num_threads, !options.config.experimental().disable_thread_spinning(),
+        /*allocator=*/nullptr);
+  }
+  return pools[numa_node];
+}
+
 int32 NumInterOpThreadsFromEnvironment() {
   int32_t num;
   const char* val = std::getenv("TF_NUM_INTEROP_THREADS");
@@ -31,6 +31,14 @@ namespace tensorflow {
 // using 'options'.  Caller does not take ownership over threadpool.
 thread::ThreadPool* ComputePool(const SessionOptions& options);
 
+// Returns a process-wide ThreadPool for scheduling compute operations of the
+// devices on NUMA node `numa_node`, whose threads are pinned to that node.
+// The inter op threads specified in `options` are divided evenly among the
+// NUMA nodes; by default each pool has one thread per CPU of its node. Caller
+// does not take ownership over threadpool.
+thread::ThreadPool* NumaComputePool(const SessionOptions& options,
+                                    int numa_node);
+
 // Returns the TF_NUM_INTEROP_THREADS environment value, or 0 if not specified.
 int32 NumInterOpThreadsFromEnvironment();
 
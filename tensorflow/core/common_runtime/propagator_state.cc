@@ -617,22 +617,25 @@ int PropagatorState::FrameState::ActivateNodesSlowPathInternal(
 int PropagatorState::FrameState::ActivateNodesFastPathLocked(
     const NodeItem* item, const bool is_dead, IterationState* iter_state,
     EntryVector* outputs, TaggedNodeSeq* ready) {
-  return ActivateNodesFastPathInternal<false>(item, is_dead, iter_state,
-                                              outputs, ready);
+  // Holding `mu` exclusively does not exclude `ActivateNodesFastPathLockFree()`
+  // on the same iteration, so the pending counts must be updated atomically.
+  return ActivateNodesFastPathInternal<true>(item, is_dead, iter_state, outputs,
+                                             ready);
 }
 
-int PropagatorState::FrameState::ActivateNodesFastPathShared(
+int PropagatorState::FrameState::ActivateNodesSlowPathLocked(
     const NodeItem* item, const bool is_dead, IterationState* iter_state,
     EntryVector* outputs, TaggedNodeSeq* ready) {
-  return ActivateNodesFastPathInternal<true>(item, is_dead, iter_state, outputs,
+  // See the comment in `ActivateNodesFastPathLocked()`.
+  return ActivateNodesSlowPathInternal<true>(item, is_dead, iter_state, outputs,
                                              ready);
 }
 
-int PropagatorState::FrameState::ActivateNodesSlowPathLocked(
+int PropagatorState::FrameState::ActivateNodesFastPathLockFree(
     const NodeItem* item, const bool is_dead, IterationState* iter_state,
     EntryVector* outputs, TaggedNodeSeq* ready) {
-  return ActivateNodesSlowPathInternal<false>(item, is_dead, iter_state,
-                                              outputs, ready);
+  return ActivateNodesFastPathInternal<true>(item, is_dead, iter_state, outputs,
+                                             ready);
 }
 
 int PropagatorState::FrameState::ActivateNodesSlowPathShared(
@@ -653,12 +656,21 @@ bool PropagatorState::FrameState::ActivateNodesAndAdjustOutstanding(
         iter_state, activated - decrement_activation);
     if (!iter_done) return false;
   } else {
-    tf_shared_lock l(mu);
+    // None of the destinations is a merge or control trigger, so the pending
+    // counts can be updated without taking `mu`. `iter_state` cannot be
+    // deleted concurrently: either `item` is still outstanding in it
+    // (`decrement_activation > 0`), or it is the parent iteration of a live
+    // frame or the successor of a live iteration. We only need `mu` if the
+    // outstanding op count of `iter_state` drops to zero, in which case the
+    // iteration (and possibly the frame) must be cleaned up.
     int activated =
-        ActivateNodesFastPathShared(item, is_dead, iter_state, outputs, ready);
-    bool iter_done = AdjustOutstandingOpsFastPath(
-        iter_state, activated - decrement_activation);
-    if (!iter_done) return false;
+        ActivateNodesFastPathLockFree(item, is_dead, iter_state, outputs, ready);
+    const int delta = activated - decrement_activation;
+    if (delta == 0 || TryAdjustOutstandingOpsLockFree(iter_state, delta)) {
+      return false;
+    }
+    mutex_lock l(mu);
+    return AdjustOutstandingOpsLocked(iter_state, delta, ready);
   }
   if (decrement_activation > 0) {
     mutex_lock l(mu);
@@ -850,15 +862,11 @@ bool PropagatorState::FrameState::AdjustOutstandingOps(
   if (delta == 0) {
     return false;
   }
-  {
-    tf_shared_lock sl(mu);
-    if (TF_PREDICT_TRUE(!AdjustOutstandingOpsFastPath(iter_state, delta))) {
-      return false;
-    }
+  if (TF_PREDICT_TRUE(TryAdjustOutstandingOpsLockFree(iter_state, delta))) {
+    return false;
   }
   mutex_lock l(mu);
-  DCHECK(IsIterationDone(iter_state));
-  return CleanupIterations(iter_state, ready);
+  return AdjustOutstandingOpsLocked(iter_state, delta, ready);
 }
 
 bool PropagatorState::FrameState::AdjustOutstandingOpsFastPath(
@@ -867,6 +875,20 @@ bool PropagatorState::FrameState::AdjustOutstandingOpsFastPath(
   return (old_val + delta == 0) && IsIterationDone(iter_state);
 }
 
+bool PropagatorState::FrameState::TryAdjustOutstandingOpsLockFree(
+    IterationState* iter_state, int delta) {
+  // Only threads holding `mu` may take the count to zero, because that is the
+  // transition after which `CleanupIterations()` may delete `iter_state`.
+  auto old_val = iter_state->outstanding_ops.load(std::memory_order_relaxed);
+  while (old_val + delta != 0) {
+    if (iter_state->outstanding_ops.compare_exchange_weak(old_val,
+                                                          old_val + delta)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // Decrement the outstanding op count and clean up the iterations in the
 // frame. Return true iff the execution of the frame is done.
 bool PropagatorState::FrameState::DecrementOutstandingOpsLocked(
@@ -877,13 +899,13 @@ bool PropagatorState::FrameState::DecrementOutstandingOpsLocked(
 
 bool PropagatorState::FrameState::AdjustOutstandingOpsLocked(
     IterationState* iter_state, int delta, TaggedNodeSeq* ready) {
-  // We hold the lock, so we don't need to use an atomic modification.
-  auto cur_val = iter_state->outstanding_ops.load(std::memory_order_relaxed);
+  // Even though we hold the lock, `TryAdjustOutstandingOpsLockFree()` may be
+  // modifying the count concurrently, so the update must be atomic.
+  auto cur_val = iter_state->outstanding_ops.fetch_add(delta);
   DCHECK(delta >= 0 || cur_val >= -delta)
       << "cannot adjust outstanding_ops by " << delta
       << " when current value is " << cur_val;
   auto new_val = cur_val + delta;
-  iter_state->outstanding_ops.store(new_val, std::memory_order_relaxed);
   if (new_val != 0) {
     return false;
   }
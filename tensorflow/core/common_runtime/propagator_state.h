@@ -348,6 +348,15 @@ class PropagatorState {
     bool AdjustOutstandingOpsFastPath(IterationState* iter_state, int delta)
         TF_SHARED_LOCKS_REQUIRED(mu);
 
+    // Adjusts the outstanding op count by 'delta' without holding `mu`, unless
+    // doing so would bring the count to zero. Returns true iff the count was
+    // adjusted; otherwise the caller must acquire `mu` and use
+    // `AdjustOutstandingOpsLocked()`.
+    //
+    // REQUIRES: `iter_state` is kept alive by the caller, e.g. because the
+    // caller is processing a node that is outstanding in `iter_state`.
+    bool TryAdjustOutstandingOpsLockFree(IterationState* iter_state, int delta);
+
     // Convenience methods for the above 'Adjust' calls where delta takes the
     // common value of -1.
     bool DecrementOutstandingOps(IterationState* iter_state,
@@ -386,8 +395,9 @@ class PropagatorState {
     // indeterminate state after returning from this method.
     //
     // In the case that 'item' is a simple node (no merge/control outputs) this
-    // will acquire a shared lock and can run concurrently with other
-    // invocations.
+    // does not acquire `mu` unless the iteration completes, and can run
+    // concurrently with other invocations. Otherwise it acquires a shared
+    // lock.
     //
     // Return true if the frame is done after activation.
     bool ActivateNodesAndAdjustOutstanding(
@@ -423,19 +433,22 @@ class PropagatorState {
 
    private:
     // REQUIRES: `!item->is_any_consumer_merge_or_control_trigger`.
-    // This variant does not use atomic operations to modify the pending counts
-    // and thus must hold the exclusive lock.
+    // This variant holds the exclusive lock, but still uses atomic operations
+    // to modify the pending counts since `ActivateNodesFastPathLockFree()` may
+    // run concurrently on the same iteration.
     int ActivateNodesFastPathLocked(const NodeItem* item, bool is_dead,
                                     IterationState* iter_state,
                                     EntryVector* outputs, TaggedNodeSeq* ready)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu);
 
     // REQUIRES: `!item->is_any_consumer_merge_or_control_trigger`.
-    // This variant uses atomic operations to modify the pending counts.
-    int ActivateNodesFastPathShared(const NodeItem* item, bool is_dead,
-                                    IterationState* iter_state,
-                                    EntryVector* outputs, TaggedNodeSeq* ready)
-        TF_SHARED_LOCKS_REQUIRED(mu);
+    // This variant uses atomic operations to modify the pending counts and
+    // does not require `mu`. See `ActivateNodesAndAdjustOutstanding()` for the
+    // reason `iter_state` stays alive.
+    int ActivateNodesFastPathLockFree(const NodeItem* item, bool is_dead,
+                                      IterationState* iter_state,
+                                      EntryVector* outputs,
+                                      TaggedNodeSeq* ready);
 
     int ActivateNodesSlowPathLocked(const NodeItem* item, bool is_dead,
                                     IterationState* iter_state,
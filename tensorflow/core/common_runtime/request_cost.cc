@@ -39,6 +39,11 @@ void RequestCost::ScaleCosts(int scale_factor) {
   for (auto& [cost_type, cost] : cost_map_) {
     cost *= scale_factor;
   }
+  for (auto& [op_name, op_costs] : op_cost_map_) {
+    for (auto& [cost_type, cost] : op_costs) {
+      cost *= scale_factor;
+    }
+  }
 }
 
 absl::flat_hash_map<std::string, absl::Duration> RequestCost::GetCosts() const {
@@ -46,6 +51,34 @@ absl::flat_hash_map<std::string, absl::Duration> RequestCost::GetCosts() const {
   return cost_map_;
 }
 
+void RequestCost::set_record_op_costs(bool record_op_costs) {
+  absl::MutexLock lock(&mutex_);
+  record_op_costs_ = record_op_costs;
+}
+
+bool RequestCost::record_op_costs() const {
+  absl::MutexLock lock(&mutex_);
+  return record_op_costs_;
+}
+
+void RequestCost::RecordOpCost(
+    absl::string_view op_name,
+    const std::vector<std::pair<absl::string_view, absl::Duration>>& costs) {
+  absl::MutexLock lock(&mutex_);
+  if (!record_op_costs_) return;
+  auto& op_costs = op_cost_map_[op_name];
+  for (const auto& cost : costs) {
+    op_costs[cost.first] += cost.second;
+  }
+}
+
+absl::flat_hash_map<std::string,
+                    absl::flat_hash_map<std::string, absl::Duration>>
+RequestCost::GetOpCosts() const {
+  absl::MutexLock lock(&mutex_);
+  return op_cost_map_;
+}
+
 void RequestCost::RecordMetrics(
     const std::vector<std::pair<absl::string_view, double>>& metrics) {
   absl::MutexLock lock(&mutex_);
@@ -37,7 +37,8 @@ class RequestCost {
   void RecordCost(
       const std::vector<std::pair<absl::string_view, absl::Duration>>& costs);
 
-  // Scales all types of costs for processing an rpc request.
+  // Scales all types of costs, including the op costs, for processing an rpc
+  // request.
   // It's thread-safe. It's expected to be called at the end of processing an
   // rpc request, when all the costs have been collected.
   void ScaleCosts(int scale_factor);
@@ -47,6 +48,27 @@ class RequestCost {
   // rpc request, when all the costs have been collected.
   absl::flat_hash_map<std::string, absl::Duration> GetCosts() const;
 
+  // Whether the costs of this rpc request are broken down by op. Recording
+  // them is more expensive than the total costs, so rpc handlers are expected
+  // to enable it for a sample of the requests only. Disabled by default.
+  void set_record_op_costs(bool record_op_costs);
+  bool record_op_costs() const;
+
+  // Records the costs of an op, or of a batched function, if op costs are
+  // recorded. The inputs should be pairs of cost type and cost, which are
+  // summed up like in RecordCost. It's thread-safe, and can be called from
+  // different threads.
+  void RecordOpCost(
+      absl::string_view op_name,
+      const std::vector<std::pair<absl::string_view, absl::Duration>>& costs);
+
+  // Gets the costs of each op: a map from op name to cost type to cost.
+  // It's thread-safe. It's expected to be called at the end of processing an
+  // rpc request, when all the costs have been collected.
+  absl::flat_hash_map<std::string,
+                      absl::flat_hash_map<std::string, absl::Duration>>
+  GetOpCosts() const;
+
   // Records metrics. The inputs should be pairs of metric name and value.
   // It's thread-safe, and can be called from different threads. Unlike
   // RecordCosts where costs are summed up if recorded with the same key,
@@ -92,6 +114,11 @@ class RequestCost {
   // Query costs. Map from cost type to cost.
   absl::flat_hash_map<std::string, absl::Duration> cost_map_
       ABSL_GUARDED_BY(mutex_);
+  bool record_op_costs_ ABSL_GUARDED_BY(mutex_) = false;
+  // Op costs. Map from op name to cost type to cost.
+  absl::flat_hash_map<std::string,
+                      absl::flat_hash_map<std::string, absl::Duration>>
+      op_cost_map_ ABSL_GUARDED_BY(mutex_);
   // Query metrics. Map from metric name to value.
   absl::flat_hash_map<std::string, double> metric_map_ ABSL_GUARDED_BY(mutex_);
 
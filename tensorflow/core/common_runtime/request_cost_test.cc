@@ -58,6 +58,39 @@ TEST(RequestCostTest, RecordCost) {
                                    Pair("cpu_v2", absl::Milliseconds(88))));
 }
 
+TEST(RequestCostTest, RecordOpCost) {
+  RequestCost request_cost;
+
+  // Op costs are not recorded by default.
+  request_cost.RecordOpCost("MatMul", {{"cpu", absl::Milliseconds(1)}});
+  EXPECT_FALSE(request_cost.record_op_costs());
+  EXPECT_TRUE(request_cost.GetOpCosts().empty());
+
+  request_cost.set_record_op_costs(true);
+  request_cost.RecordOpCost(
+      "MatMul", {{"cpu", absl::Milliseconds(1)}, {"tpu", absl::Milliseconds(2)}});
+  request_cost.RecordOpCost("MatMul", {{"cpu", absl::Milliseconds(10)}});
+  request_cost.RecordOpCost("Relu", {{"cpu", absl::Milliseconds(3)}});
+  EXPECT_THAT(request_cost.GetOpCosts(),
+              UnorderedElementsAre(
+                  Pair("MatMul",
+                       UnorderedElementsAre(Pair("cpu", absl::Milliseconds(11)),
+                                            Pair("tpu", absl::Milliseconds(2)))),
+                  Pair("Relu", UnorderedElementsAre(
+                                   Pair("cpu", absl::Milliseconds(3))))));
+  // Op costs don't add up to the total costs.
+  EXPECT_TRUE(request_cost.GetCosts().empty());
+
+  request_cost.ScaleCosts(2);
+  EXPECT_THAT(request_cost.GetOpCosts(),
+              UnorderedElementsAre(
+                  Pair("MatMul",
+                       UnorderedElementsAre(Pair("cpu", absl::Milliseconds(22)),
+                                            Pair("tpu", absl::Milliseconds(4)))),
+                  Pair("Relu", UnorderedElementsAre(
+                                   Pair("cpu", absl::Milliseconds(6))))));
+}
+
 TEST(RequestCostTest, RecordMetrics) {
   RequestCost request_cost;
 
@@ -330,9 +330,12 @@ void RingAlg::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
   // chunk is the unit of data transferred in a time step.  However, if
   // a device can simultaneously send data by 2 or more independent
   // channels we can speed up the transfer by subdividing chunks and
-  // processing multiple subdivisions at once.  So the actual number
-  // of RingFields is group_size_ * num_subdivs_.
-  DCHECK_EQ(field_idx, (chunk_idx * num_subdivs_) + subdiv_idx);
+  // processing multiple subdivisions at once.  Each subdivision may in turn
+  // be split into num_segments_ segments that move through the ring
+  // independently, so that the reduction of one segment overlaps with the
+  // transfer of the next.  So the actual number of RingFields is
+  // group_size_ * num_subdivs_ * num_segments_.
+  DCHECK_EQ(field_idx / num_segments_, (chunk_idx * num_subdivs_) + subdiv_idx);
   rf->chunk_idx = chunk_idx;
   rf->subdiv_idx = subdiv_idx;
   rf->sc_idx = field_idx;
@@ -408,7 +411,8 @@ void RingAlg::DispatchSend(RingField* rf, const StatusCallback& done) {
       col_params_->group.members[send_to_dev_idx].device.name(),
       col_params_->group.members[send_to_dev_idx].task, send_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
-      col_ctx_->op_ctx->output_alloc_attr(0), &rf->chunk,
+      col_ctx_->op_ctx->output_alloc_attr(0),
+      rf->wire_chunk.IsInitialized() ? &rf->wire_chunk : &rf->chunk,
       col_ctx_->device_locality, col_ctx_->op_ctx->cancellation_manager(),
       done);
 }
@@ -424,6 +428,9 @@ void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
   Tensor* dst_tensor = (!rf->second_pass && (col_params_->merge_op != nullptr))
                            ? &rf->tmp_chunk
                            : &rf->chunk;
+  if (rf->wire_chunk.IsInitialized()) {
+    dst_tensor = &rf->wire_chunk;
+  }
   col_ctx_->col_exec->remote_access()->RecvFromPeer(
       col_params_->group.members[rf->recv_dev_idx].device.name(),
       col_params_->group.members[rf->recv_dev_idx].task,
@@ -75,6 +75,9 @@ class RingAlg : public CollectiveImplementationInterface {
     bool is_final = false;  // is the last field in the pass for this rank
     Tensor chunk;           // alias to field values
     Tensor tmp_chunk;
+    // If initialized, the field's values are sent and received in this
+    // (lower precision) form instead of `chunk`.
+    Tensor wire_chunk;
     Status status;
     string DebugString() const;
   };
@@ -108,6 +111,8 @@ class RingAlg : public CollectiveImplementationInterface {
   StatusCallback done_;
   int group_size_;
   int num_subdivs_;
+  // Number of independent fields each (chunk, subdiv) pair is split into.
+  int num_segments_ = 1;
   Tensor group_size_tensor_;
   Notification group_size_tensor_ready_;
   std::unique_ptr<CollectiveAdapter> ca_;
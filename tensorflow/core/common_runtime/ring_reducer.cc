@@ -16,12 +16,17 @@ limitations under the License.
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
 #include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/collective_wire_format.h"
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -42,6 +47,30 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 
 namespace tensorflow {
+namespace {
+
+// Chunks of a CPU reduction are split into segments of at least
+// kMinPipelineSegmentBytes, up to kMaxPipelineSegments per chunk.  Smaller
+// segments would be dominated by per-transfer overhead.
+constexpr int64_t kMinPipelineSegmentBytes = 512 * 1024;
+constexpr int kMaxPipelineSegments = 8;
+
+// Returns the number of segments each of `num_chunks` chunks of a
+// `total_bytes` tensor is split into.  The result only depends on values that
+// are the same on every device of the group.
+int NumPipelineSegments(int64_t total_bytes, int num_chunks) {
+  const int64_t chunk_bytes = total_bytes / num_chunks;
+  int num_segments = static_cast<int>(std::clamp<int64_t>(
+      chunk_bytes / kMinPipelineSegmentBytes, 1, kMaxPipelineSegments));
+  // RingField indices are int16.
+  while (num_segments > 1 && static_cast<int64_t>(num_chunks) * num_segments >
+                                 std::numeric_limits<int16>::max()) {
+    --num_segments;
+  }
+  return num_segments;
+}
+
+}  // namespace
 
 RingReducer::~RingReducer() { group_size_tensor_ready_.WaitForNotification(); }
 
@@ -64,6 +93,14 @@ void RingReducer::Run(StatusCallback done) {
   num_subdivs_ = static_cast<int>(
       col_params_->instance.impl_details.subdiv_permutations.size());
   CHECK_GT(num_subdivs_, 0);
+  wire_format_ = CollectiveWireFormat::kNone;
+  if (col_params_->group.num_tasks > 1 &&
+      col_params_->group.device_type == "CPU" &&
+      col_ctx_->output->dtype() == DT_FLOAT) {
+    // Every hop of the ring uses the same format, so that all devices round
+    // the final value in the same way.
+    wire_format_ = RingReducerWireFormatFromEnv();
+  }
 
   if (VLOG_IS_ON(1)) {
     string buf;
@@ -118,7 +155,16 @@ void RingReducer::Run(StatusCallback done) {
 // which cannot be blocked.
 void RingReducer::ContinueAfterInputCopy() {
   AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
-  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, group_size_ * num_subdivs_,
+  num_segments_ = 1;
+  // Segmenting changes how the tensor is split into fields, so like the wire
+  // format it is opted into by `kRingReducerWireFormatEnvVar`. The wire format
+  // is only set for CPU groups.
+  if (wire_format_ != CollectiveWireFormat::kNone) {
+    num_segments_ = NumPipelineSegments(col_ctx_->output->TotalBytes(),
+                                        group_size_ * num_subdivs_);
+  }
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output,
+                                  group_size_ * num_subdivs_ * num_segments_,
                                   col_ctx_->device->GetAllocator(attr)));
 
   if (col_params_->final_op) {
@@ -168,6 +214,40 @@ void RingReducer::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
   if (rf->do_recv) {
     rf->tmp_chunk = ca_->TempChunk(rf->sc_idx);
   }
+  if (wire_format_ != CollectiveWireFormat::kNone &&
+      rf->chunk.IsInitialized()) {
+    rf->wire_chunk = Tensor(
+        col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0)),
+        CollectiveWireDataType(wire_format_),
+        TensorShape({rf->chunk.NumElements()}));
+  }
+}
+
+Status RingReducer::DecodeRecvdField(RingField* rf) {
+  if (!rf->wire_chunk.IsInitialized()) return absl::OkStatus();
+  return DecodeFromWire(rf->wire_chunk,
+                        rf->second_pass ? &rf->chunk : &rf->tmp_chunk);
+}
+
+Status RingReducer::EncodeFieldForSend(RingField* rf) {
+  if (!rf->wire_chunk.IsInitialized()) return absl::OkStatus();
+  if (!rf->second_pass) {
+    std::shared_ptr<std::vector<float>> residual =
+        CollectiveWireResidualStore::Global()->Get(
+            strings::StrCat(col_params_->instance.instance_key, ":",
+                            col_ctx_->device_name, ":", rf->sc_idx),
+            rf->chunk.NumElements());
+    return EncodeForWire(wire_format_, rf->chunk, residual->data(),
+                         &rf->wire_chunk);
+  }
+  // In the second pass a field that was received still holds the encoded
+  // value in wire_chunk and simply forwards it.
+  if (rf->do_recv) return absl::OkStatus();
+  // This device holds the fully reduced value.  Round it in place as well, so
+  // that it matches the value every other device decodes.
+  TF_RETURN_IF_ERROR(
+      EncodeForWire(wire_format_, rf->chunk, nullptr, &rf->wire_chunk));
+  return DecodeFromWire(rf->wire_chunk, &rf->chunk);
 }
 
 // At the beginning of the algorithm initialize a RingField struct for
@@ -179,13 +259,17 @@ bool RingReducer::RunAsyncParts() {
   // complete. Hence function local variables are accessible only by that
   // one thread and do not require an explicit mutex.
   rfv_.clear();
-  rfv_.resize(group_size_ * num_subdivs_);
+  rfv_.resize(group_size_ * num_subdivs_ * num_segments_);
   PCQueue ready_queue;
   for (int chunk_idx = 0; chunk_idx < group_size_; ++chunk_idx) {
     for (int subdiv_idx = 0; subdiv_idx < num_subdivs_; ++subdiv_idx) {
-      int rf_index = (chunk_idx * num_subdivs_) + subdiv_idx;
-      InitRingField(&rfv_[rf_index], chunk_idx, subdiv_idx, rf_index);
-      ready_queue.Enqueue(&rfv_[rf_index]);
+      for (int segment_idx = 0; segment_idx < num_segments_; ++segment_idx) {
+        int rf_index =
+            ((chunk_idx * num_subdivs_) + subdiv_idx) * num_segments_ +
+            segment_idx;
+        InitRingField(&rfv_[rf_index], chunk_idx, subdiv_idx, rf_index);
+        ready_queue.Enqueue(&rfv_[rf_index]);
+      }
     }
   }
   const DeviceBase::AcceleratorDeviceInfo* gpu_info =
@@ -255,15 +339,23 @@ bool RingReducer::RunAsyncParts() {
             --recv_pending_count;
             if (!rf->second_pass) {
               rf->action = RF_REDUCE;
-              Status s = collective_util::ComputeBinOp(
-                  col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
-                  col_params_->merge_op, &rf->chunk, &rf->tmp_chunk);
+              Status s = DecodeRecvdField(rf);
+              if (s.ok()) {
+                s = collective_util::ComputeBinOp(
+                    col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+                    col_params_->merge_op, &rf->chunk, &rf->tmp_chunk);
+              }
               if (!s.ok()) {
                 aborted = true;
                 StartAbort(s);
               }
             } else {
               rf->action = RF_SEND_READY;
+              Status s = DecodeRecvdField(rf);
+              if (!s.ok()) {
+                aborted = true;
+                StartAbort(s);
+              }
             }
             break;
           case RF_REDUCE:
@@ -286,6 +378,12 @@ bool RingReducer::RunAsyncParts() {
             break;
           case RF_SEND_READY:
             if (rf->do_send) {
+              Status s = EncodeFieldForSend(rf);
+              if (!s.ok()) {
+                aborted = true;
+                StartAbort(s);
+                break;
+              }
               rf->action = RF_SEND;
               auto send_complete = [this, rf, &ready_queue,
                                     &aborted](Status s) {
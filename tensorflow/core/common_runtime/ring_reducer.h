@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/collective_wire_format.h"
 #include "tensorflow/core/common_runtime/ring_alg.h"
 #include "tensorflow/core/framework/collective.h"
 
@@ -28,6 +29,13 @@ namespace tensorflow {
 class Device;
 
 // Ring-algorithm implementation of collective all-reduce.
+//
+// For DT_FLOAT CPU groups that span more than one task the values may be sent
+// in a lossy wire format selected by `kRingReducerWireFormatEnvVar`; the
+// rounding error of the reduction pass is fed back into the next step of the
+// same instance. Such groups also split chunks that are large enough into
+// several segments that move through the ring independently, so that reducing
+// one segment overlaps with transferring the next.
 class RingReducer : public RingAlg {
  public:
   RingReducer() : RingAlg(REDUCTION_COLLECTIVE, "Reduce") {}
@@ -49,6 +57,12 @@ class RingReducer : public RingAlg {
   void ContinueAfterInputCopy();
   bool RunAsyncParts();
 
+  // Wire format helpers. Both are no-ops for fields without a `wire_chunk`.
+  Status DecodeRecvdField(RingField* rf);
+  Status EncodeFieldForSend(RingField* rf);
+
+  CollectiveWireFormat wire_format_ = CollectiveWireFormat::kNone;
+
   Tensor group_size_tensor_;
   Notification group_size_tensor_ready_;
 
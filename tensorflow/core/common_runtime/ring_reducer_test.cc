@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/base_collective_executor.h"
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
 #include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/common_runtime/collective_wire_format.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/device_resolver_local.h"
@@ -36,8 +37,10 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/unbounded_work_queue.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
@@ -427,6 +430,97 @@ DEF_TEST(INT64, CPU, 2, 8, 3, 4095, 0)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 1)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 7)
 DEF_TEST(FLOAT, CPU, 2, 8, 2, 9408, 11)
+
+TEST_F(RingReducerTest, Bfloat16WireFormatIsExactForRepresentableValues) {
+  setenv(kRingReducerWireFormatEnvVar, "bf16", 1);
+  CollectiveWireResidualStore::Global()->Clear();
+  constexpr int kNumWorkers = 2;
+  constexpr int kNumDevices = 2;
+  constexpr int kTensorLen = 1001;
+  Init(kNumWorkers, kNumDevices, DT_FLOAT, TensorShape({kTensorLen}),
+       DEVICE_CPU, /*num_subdivs=*/1, /*fail_after=*/0);
+  std::vector<float> expected(kTensorLen);
+  for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+    instances_[di]->InitTensor([&expected, di](Tensor* t) {
+      for (int i = 0; i < t->NumElements(); ++i) {
+        // Small integers, all partial sums and the mean are exact in bf16.
+        float value = di * 8 + (i % 16);
+        t->flat<float>()(i) = value;
+        expected[i] += value / (kNumWorkers * kNumDevices);
+      }
+    });
+  }
+  Reduce(/*fail_after=*/0);
+  unsetenv(kRingReducerWireFormatEnvVar);
+  for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+    TF_EXPECT_OK(instances_[di]->status_);
+    test::ExpectTensorEqual<float>(test::AsTensor<float>(expected),
+                                   instances_[di]->tensor());
+  }
+}
+
+TEST_F(RingReducerTest, WireFormatSplitsLargeChunksIntoSegments) {
+  setenv(kRingReducerWireFormatEnvVar, "bf16", 1);
+  CollectiveWireResidualStore::Global()->Clear();
+  constexpr int kNumWorkers = 2;
+  constexpr int kNumDevices = 1;
+  // Large enough for each chunk to be split into pipeline segments, and not a
+  // multiple of the number of fields.
+  constexpr int kTensorLen = 1048583;
+  Init(kNumWorkers, kNumDevices, DT_FLOAT, TensorShape({kTensorLen}),
+       DEVICE_CPU, /*num_subdivs=*/1, /*fail_after=*/0);
+  std::vector<float> expected(kTensorLen);
+  for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+    instances_[di]->InitTensor([&expected, di](Tensor* t) {
+      for (int i = 0; i < t->NumElements(); ++i) {
+        float value = di * 8 + (i % 16);
+        t->flat<float>()(i) = value;
+        expected[i] += value / (kNumWorkers * kNumDevices);
+      }
+    });
+  }
+  Reduce(/*fail_after=*/0);
+  unsetenv(kRingReducerWireFormatEnvVar);
+  // One residual per device and field sent in the reduction pass.
+  EXPECT_GT(CollectiveWireResidualStore::Global()->num_residuals(),
+            kNumWorkers * kNumDevices);
+  for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+    TF_EXPECT_OK(instances_[di]->status_);
+    test::ExpectTensorEqual<float>(test::AsTensor<float>(expected),
+                                   instances_[di]->tensor());
+  }
+}
+
+TEST_F(RingReducerTest, HalfWireFormatDevicesAgree) {
+  setenv(kRingReducerWireFormatEnvVar, "fp16", 1);
+  CollectiveWireResidualStore::Global()->Clear();
+  constexpr int kNumWorkers = 2;
+  constexpr int kNumDevices = 4;
+  constexpr int kTensorLen = 4095;
+  Init(kNumWorkers, kNumDevices, DT_FLOAT, TensorShape({kTensorLen}),
+       DEVICE_CPU, /*num_subdivs=*/2, /*fail_after=*/0);
+  std::vector<float> expected(kTensorLen);
+  for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+    instances_[di]->InitTensor([&expected, di](Tensor* t) {
+      for (int i = 0; i < t->NumElements(); ++i) {
+        float value = 1.0f + di + 1e-3f * i;
+        t->flat<float>()(i) = value;
+        expected[i] += value / (kNumWorkers * kNumDevices);
+      }
+    });
+  }
+  Reduce(/*fail_after=*/0);
+  unsetenv(kRingReducerWireFormatEnvVar);
+  EXPECT_GT(CollectiveWireResidualStore::Global()->num_residuals(), 0);
+  for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+    TF_EXPECT_OK(instances_[di]->status_);
+    // Every device must see the same rounded value.
+    test::ExpectTensorEqual<float>(instances_[0]->tensor(),
+                                   instances_[di]->tensor());
+    test::ExpectTensorNear<float>(test::AsTensor<float>(expected),
+                                  instances_[di]->tensor(), 0.05);
+  }
+}
 #endif
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -454,4 +548,52 @@ DEF_TEST(FLOAT, GPU, 1, 8, 1, 9408, 2)
 DEF_TEST(FLOAT, GPU, 1, 8, 2, 9408, 5)
 #endif
 
+// Reduces a tensor of `state.range(0)` floats over a group of
+// `state.range(1)` CPU devices.
+void BM_RingReduce(::testing::benchmark::State& state) {
+  const int tensor_len = state.range(0);
+  const int group_size = state.range(1);
+  std::unique_ptr<CollectiveTestEnv> test_env =
+      CreateCollectiveTestEnv(/*num_workers=*/1, group_size, DEVICE_CPU);
+  std::vector<core::RefCountPtr<CollectiveParams>> col_params(group_size);
+  std::vector<Device*> devices(group_size);
+  std::vector<Tensor> tensors;
+  std::vector<std::unique_ptr<OpKernel>> kernels;
+  for (int rank = 0; rank < group_size; ++rank) {
+    col_params[rank] =
+        CreateCollectiveParams(*test_env, rank, "RingReduce",
+                               REDUCTION_COLLECTIVE, DT_FLOAT,
+                               TensorShape({tensor_len}));
+    TF_CHECK_OK(test_env->device_mgr->LookupDevice(
+        col_params[rank]->group.members[rank].device.name(), &devices[rank]));
+    kernels.push_back(GetAdd(DT_FLOAT, DEVICE_CPU, devices[rank]));
+    col_params[rank]->merge_op = kernels.back().get();
+    kernels.push_back(GetDiv(DT_FLOAT, DEVICE_CPU, devices[rank]));
+    col_params[rank]->final_op = kernels.back().get();
+    tensors.emplace_back(DT_FLOAT, TensorShape({tensor_len}));
+    tensors.back().flat<float>().setConstant(1.0f);
+  }
+  for (auto s : state) {
+    BlockingCounter counter(group_size);
+    for (int rank = 0; rank < group_size; ++rank) {
+      SchedClosure([&, rank] {
+        TF_CHECK_OK(RunCollective(test_env.get(), col_params[rank].get(),
+                                  devices[rank], &tensors[rank],
+                                  &tensors[rank]));
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+  state.SetBytesProcessed(state.iterations() * tensor_len * sizeof(float));
+}
+BENCHMARK(BM_RingReduce)
+    ->ArgPair(1 << 10, 2)
+    ->ArgPair(1 << 10, 8)
+    ->ArgPair(1 << 18, 2)
+    ->ArgPair(1 << 18, 8)
+    ->ArgPair(1 << 22, 2)
+    ->ArgPair(1 << 22, 8)
+    ->ArgPair(1 << 24, 4);
+
 }  // namespace tensorflow
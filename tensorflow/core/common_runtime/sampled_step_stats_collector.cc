@@ -0,0 +1,206 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/sampled_step_stats_collector.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+// A ring buffer slot, which doubles as the `NodeExecStatsInterface` of the
+// node that it records.
+//
+// `seq_` implements a seqlock: it is `2 * index + 1` while the node with record
+// index `index` is running, and `2 * index + 2` once its record is complete.
+// The timestamps are atomics so that `Drain()` may read them while a slot is
+// being reused; `Drain()` discards what it read if `seq_` changed meanwhile.
+class SampledStepStatsCollector::Slot : public NodeExecStatsInterface {
+ public:
+  // Tries to claim this slot for record `index`. Fails if the slot still
+  // belongs to a running node.
+  bool Claim(int64_t index, const NodeDef* node) {
+    uint64 seq = seq_.load(std::memory_order_acquire);
+    if ((seq & 1) != 0 ||
+        !seq_.compare_exchange_strong(seq, 2 * index + 1,
+                                      std::memory_order_acq_rel)) {
+      return false;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    index_ = index;
+    node_.store(node, std::memory_order_relaxed);
+    device_.store(nullptr, std::memory_order_relaxed);
+    scheduled_nanos_.store(0, std::memory_order_relaxed);
+    all_start_nanos_.store(0, std::memory_order_relaxed);
+    op_start_nanos_.store(0, std::memory_order_relaxed);
+    op_end_nanos_.store(0, std::memory_order_relaxed);
+    all_end_nanos_.store(0, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Copies the completed record with index `index` into `stats`. Returns false
+  // if the slot does not hold that record.
+  bool Read(int64_t index, NodeExecStats* stats, const string** device) const {
+    const uint64 seq = seq_.load(std::memory_order_acquire);
+    if (seq != static_cast<uint64>(2 * index + 2)) return false;
+    const NodeDef* node = node_.load(std::memory_order_relaxed);
+    *device = device_.load(std::memory_order_relaxed);
+    const int64_t scheduled = scheduled_nanos_.load(std::memory_order_relaxed);
+    const int64_t all_start = all_start_nanos_.load(std::memory_order_relaxed);
+    const int64_t op_start = op_start_nanos_.load(std::memory_order_relaxed);
+    const int64_t op_end = op_end_nanos_.load(std::memory_order_relaxed);
+    const int64_t all_end = all_end_nanos_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) != seq) return false;
+
+    stats->set_node_name(node->name());
+    stats->set_timeline_label(node->op());
+    if (scheduled != 0) {
+      stats->set_scheduled_micros(scheduled / EnvTime::kMicrosToNanos);
+      stats->set_scheduled_nanos(scheduled);
+    }
+    stats->set_all_start_micros(all_start / EnvTime::kMicrosToNanos);
+    stats->set_all_start_nanos(all_start);
+    if (op_start != 0) {
+      stats->set_op_start_rel_micros((op_start - all_start) /
+                                     EnvTime::kMicrosToNanos);
+      stats->set_op_start_rel_nanos(op_start - all_start);
+    }
+    if (op_end != 0) {
+      stats->set_op_end_rel_micros((op_end - all_start) /
+                                   EnvTime::kMicrosToNanos);
+      stats->set_op_end_rel_nanos(op_end - all_start);
+    }
+    stats->set_all_end_rel_micros((all_end - all_start) /
+                                  EnvTime::kMicrosToNanos);
+    stats->set_all_end_rel_nanos(all_end - all_start);
+    return true;
+  }
+
+  uint64 seq() const { return seq_.load(std::memory_order_relaxed); }
+
+  void Done(const string& device) override {
+    device_.store(&device, std::memory_order_relaxed);
+    seq_.store(2 * index_ + 2, std::memory_order_release);
+  }
+
+  void RecordExecutorStarted() override {
+    all_start_nanos_.store(EnvTime::NowNanos(), std::memory_order_relaxed);
+  }
+
+  void RecordComputeStarted() override {
+    op_start_nanos_.store(EnvTime::NowNanos(), std::memory_order_relaxed);
+  }
+
+  void RecordComputeEnded() override {
+    op_end_nanos_.store(EnvTime::NowNanos(), std::memory_order_relaxed);
+  }
+
+  void RecordExecutorEnded() override {
+    all_end_nanos_.store(EnvTime::NowNanos(), std::memory_order_relaxed);
+  }
+
+  bool TrackAllocations() const override { return false; }
+
+  void SetMemory(OpKernelContext* ctx) override {}
+
+  void SetOutput(int slot, const Tensor* tensor) override {}
+
+  void SetScheduled(int64_t nanos) override {
+    scheduled_nanos_.store(nanos, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64> seq_{0};
+  // Only accessed by the owner of the slot.
+  int64_t index_ = 0;
+  std::atomic<const NodeDef*> node_{nullptr};
+  std::atomic<const string*> device_{nullptr};
+  std::atomic<int64_t> scheduled_nanos_{0};
+  std::atomic<int64_t> all_start_nanos_{0};
+  std::atomic<int64_t> op_start_nanos_{0};
+  std::atomic<int64_t> op_end_nanos_{0};
+  std::atomic<int64_t> all_end_nanos_{0};
+};
+
+SampledStepStatsCollector::SampledStepStatsCollector(int capacity,
+                                                     int node_sampling_period)
+    : capacity_(std::max(1, capacity)),
+      node_sampling_period_(std::max(1, node_sampling_period)),
+      slots_(new Slot[capacity_]) {}
+
+SampledStepStatsCollector::~SampledStepStatsCollector() {}
+
+bool SampledStepStatsCollector::IsSampled(const NodeDef* node) const {
+  if (node_sampling_period_ == 1) return true;
+  // Mix the address bits so that sampling does not follow the allocation
+  // pattern of the NodeDefs.
+  const uint64 hash =
+      static_cast<uint64>(reinterpret_cast<uintptr_t>(node)) *
+      0x9e3779b97f4a7c15ULL;
+  return (hash >> 32) % node_sampling_period_ == 0;
+}
+
+NodeExecStatsInterface* SampledStepStatsCollector::CreateNodeExecStats(
+    const NodeDef* node) {
+  if (!IsSampled(node)) return nullptr;
+  const int64_t index = next_index_.fetch_add(1, std::memory_order_relaxed);
+  Slot* slot = &slots_[index % capacity_];
+  if (!slot->Claim(index, node)) {
+    num_dropped_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  return slot;
+}
+
+void SampledStepStatsCollector::Drain(StepStats* step_stats) {
+  mutex_lock l(drain_mu_);
+  const int64_t end_index = next_index_.load(std::memory_order_acquire);
+  if (end_index - drain_index_ > capacity_) {
+    // The oldest records have been overwritten.
+    num_dropped_.fetch_add(end_index - capacity_ - drain_index_,
+                           std::memory_order_relaxed);
+    drain_index_ = end_index - capacity_;
+  }
+
+  std::unordered_map<const string*, DeviceStepStats*> device_stats;
+  NodeExecStats stats;
+  for (int64_t index = drain_index_; index < end_index; ++index) {
+    const Slot& slot = slots_[index % capacity_];
+    const string* device = nullptr;
+    stats.Clear();
+    if (!slot.Read(index, &stats, &device)) {
+      // The node is still running, or its record has been overwritten. A
+      // record that was never claimed because its slot was busy has already
+      // been counted.
+      if (slot.seq() >= static_cast<uint64>(2 * index + 1)) {
+        num_dropped_.fetch_add(1, std::memory_order_relaxed);
+      }
+      continue;
+    }
+    DeviceStepStats*& dss = device_stats[device];
+    if (dss == nullptr) {
+      dss = step_stats->add_dev_stats();
+      dss->set_device(*device);
+    }
+    dss->add_node_stats()->Swap(&stats);
+  }
+  drain_index_ = end_index;
+}
+
+}  // namespace tensorflow
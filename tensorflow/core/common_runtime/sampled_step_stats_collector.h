@@ -0,0 +1,101 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_STEP_STATS_COLLECTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_STEP_STATS_COLLECTOR_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// SampledStepStatsCollector is a low-overhead alternative to
+// `StepStatsCollector` that records only node timings (no memory or output
+// information) into a fixed-size ring buffer that is allocated up front.
+//
+// Recording a node claims a ring buffer slot with a single atomic increment
+// and a compare-and-swap; it never allocates and never takes a lock. Only one
+// in `node_sampling_period` nodes are recorded: the choice is a function of
+// the node, so the same nodes are sampled in every step.
+//
+// `Drain()` copies the completed records out of the ring buffer. When more
+// nodes are recorded between two calls to `Drain()` than the ring buffer can
+// hold, the oldest records are lost; records are also lost for nodes that are
+// still running when `Drain()` is called, or whose slot is still in use by a
+// running node when they start. Lost records are counted in `num_dropped()`.
+//
+// The collector keeps pointers to the `NodeDef`s of the recorded nodes, so
+// `Drain()` must be called while the executors that ran them are alive.
+//
+// This class is thread-safe.
+class SampledStepStatsCollector : public StepStatsCollectorInterface {
+ public:
+  static constexpr int kDefaultCapacity = 1 << 14;
+
+  // `capacity` is the number of records that the ring buffer holds.
+  // `node_sampling_period <= 1` records all nodes.
+  explicit SampledStepStatsCollector(int capacity = kDefaultCapacity,
+                                     int node_sampling_period = 1);
+  ~SampledStepStatsCollector() override;
+
+  SampledStepStatsCollector(const SampledStepStatsCollector&) = delete;
+  void operator=(const SampledStepStatsCollector&) = delete;
+
+  // Returns a ring buffer slot for `node`, or `nullptr` if `node` is not
+  // sampled or no slot is available.
+  NodeExecStatsInterface* CreateNodeExecStats(const NodeDef* node) override;
+
+  string ReportAllocsOnResourceExhausted(absl::string_view err) override {
+    return "";
+  }
+
+  // Appends the records completed since the previous call to `step_stats`,
+  // grouped into one `DeviceStepStats` per device.
+  void Drain(StepStats* step_stats);
+
+  // Returns the number of records that have been lost so far.
+  int64_t num_dropped() const {
+    return num_dropped_.load(std::memory_order_relaxed);
+  }
+
+  int capacity() const { return capacity_; }
+
+ private:
+  class Slot;
+
+  bool IsSampled(const NodeDef* node) const;
+
+  const int capacity_;
+  const uint64 node_sampling_period_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Index of the next record to claim.
+  std::atomic<int64_t> next_index_{0};
+  std::atomic<int64_t> num_dropped_{0};
+
+  mutex drain_mu_;
+  // Index of the first record that has not been drained yet.
+  int64_t drain_index_ TF_GUARDED_BY(drain_mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_STEP_STATS_COLLECTOR_H_
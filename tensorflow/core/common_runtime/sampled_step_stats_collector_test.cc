@@ -0,0 +1,185 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/sampled_step_stats_collector.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+std::vector<NodeDef> MakeNodes(int num_nodes) {
+  std::vector<NodeDef> nodes(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    nodes[i].set_name(strings::StrCat("node", i));
+    nodes[i].set_op("NoOp");
+  }
+  return nodes;
+}
+
+// Runs `node` through the same sequence of calls as the executor does.
+void RunNode(StepStatsCollectorInterface* collector, const NodeDef& node,
+             const string& device) {
+  NodeExecStatsInterface* stats = collector->CreateNodeExecStats(&node);
+  if (stats == nullptr) return;
+  stats->SetScheduled(EnvTime::NowNanos());
+  stats->RecordExecutorStarted();
+  stats->RecordComputeStarted();
+  stats->RecordComputeEnded();
+  stats->RecordExecutorEnded();
+  stats->Done(device);
+}
+
+int NumNodeStats(const StepStats& step_stats) {
+  int num_node_stats = 0;
+  for (const auto& dev_stats : step_stats.dev_stats()) {
+    num_node_stats += dev_stats.node_stats_size();
+  }
+  return num_node_stats;
+}
+
+TEST(SampledStepStatsCollectorTest, RecordsAllNodesByDevice) {
+  SampledStepStatsCollector collector(/*capacity=*/64);
+  std::vector<NodeDef> nodes = MakeNodes(10);
+  const string cpu0 = "/device:CPU:0";
+  const string cpu1 = "/device:CPU:1";
+  for (int i = 0; i < nodes.size(); ++i) {
+    RunNode(&collector, nodes[i], i % 2 == 0 ? cpu0 : cpu1);
+  }
+
+  StepStats step_stats;
+  collector.Drain(&step_stats);
+  ASSERT_EQ(step_stats.dev_stats_size(), 2);
+  EXPECT_EQ(step_stats.dev_stats(0).device(), cpu0);
+  EXPECT_EQ(step_stats.dev_stats(1).device(), cpu1);
+  EXPECT_EQ(NumNodeStats(step_stats), 10);
+  const NodeExecStats& first = step_stats.dev_stats(0).node_stats(0);
+  EXPECT_EQ(first.node_name(), "node0");
+  EXPECT_GT(first.all_start_nanos(), 0);
+  EXPECT_GE(first.op_end_rel_nanos(), first.op_start_rel_nanos());
+  EXPECT_GE(first.all_end_rel_nanos(), first.op_end_rel_nanos());
+  EXPECT_EQ(collector.num_dropped(), 0);
+
+  // Records are only drained once.
+  StepStats empty;
+  collector.Drain(&empty);
+  EXPECT_EQ(NumNodeStats(empty), 0);
+}
+
+TEST(SampledStepStatsCollectorTest, SamplesTheSameNodesInEveryStep) {
+  SampledStepStatsCollector collector(/*capacity=*/1024,
+                                      /*node_sampling_period=*/4);
+  std::vector<NodeDef> nodes = MakeNodes(400);
+  std::set<string> sampled[2];
+  for (int step = 0; step < 2; ++step) {
+    for (const NodeDef& node : nodes) {
+      RunNode(&collector, node, "/device:CPU:0");
+    }
+    StepStats step_stats;
+    collector.Drain(&step_stats);
+    for (const auto& dev_stats : step_stats.dev_stats()) {
+      for (const auto& node_stats : dev_stats.node_stats()) {
+        sampled[step].insert(node_stats.node_name());
+      }
+    }
+  }
+  EXPECT_GT(sampled[0].size(), 0);
+  EXPECT_LT(sampled[0].size(), nodes.size());
+  EXPECT_EQ(sampled[0], sampled[1]);
+}
+
+TEST(SampledStepStatsCollectorTest, DropsOldestRecordsOnOverflow) {
+  SampledStepStatsCollector collector(/*capacity=*/8);
+  std::vector<NodeDef> nodes = MakeNodes(20);
+  for (const NodeDef& node : nodes) {
+    RunNode(&collector, node, "/device:CPU:0");
+  }
+  StepStats step_stats;
+  collector.Drain(&step_stats);
+  ASSERT_EQ(step_stats.dev_stats_size(), 1);
+  ASSERT_EQ(step_stats.dev_stats(0).node_stats_size(), 8);
+  EXPECT_EQ(step_stats.dev_stats(0).node_stats(0).node_name(), "node12");
+  EXPECT_EQ(collector.num_dropped(), 12);
+}
+
+TEST(SampledStepStatsCollectorTest, DropsRecordsOfRunningNodes) {
+  SampledStepStatsCollector collector(/*capacity=*/1);
+  std::vector<NodeDef> nodes = MakeNodes(2);
+  NodeExecStatsInterface* running = collector.CreateNodeExecStats(&nodes[0]);
+  ASSERT_NE(running, nullptr);
+  running->RecordExecutorStarted();
+  // The only slot is busy.
+  EXPECT_EQ(collector.CreateNodeExecStats(&nodes[1]), nullptr);
+  EXPECT_EQ(collector.num_dropped(), 1);
+
+  StepStats step_stats;
+  collector.Drain(&step_stats);
+  EXPECT_EQ(NumNodeStats(step_stats), 0);
+  EXPECT_EQ(collector.num_dropped(), 2);
+
+  running->RecordExecutorEnded();
+  running->Done("/device:CPU:0");
+  RunNode(&collector, nodes[1], "/device:CPU:0");
+  step_stats.Clear();
+  collector.Drain(&step_stats);
+  EXPECT_EQ(NumNodeStats(step_stats), 1);
+}
+
+TEST(SampledStepStatsCollectorTest, ConcurrentRecording) {
+  constexpr int kNumThreads = 8;
+  constexpr int kNumNodesPerThread = 1000;
+  SampledStepStatsCollector collector(kNumThreads * kNumNodesPerThread);
+  std::vector<NodeDef> nodes = MakeNodes(kNumNodesPerThread);
+  const string device = "/device:CPU:0";
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&]() {
+        for (const NodeDef& node : nodes) RunNode(&collector, node, device);
+      });
+    }
+  }
+  StepStats step_stats;
+  collector.Drain(&step_stats);
+  EXPECT_EQ(NumNodeStats(step_stats), kNumThreads * kNumNodesPerThread);
+  EXPECT_EQ(collector.num_dropped(), 0);
+}
+
+void BM_SampledStepStatsCollector(::testing::benchmark::State& state) {
+  const int node_sampling_period = state.range(0);
+  SampledStepStatsCollector collector(
+      SampledStepStatsCollector::kDefaultCapacity, node_sampling_period);
+  std::vector<NodeDef> nodes = MakeNodes(1000);
+  const string device = "/device:CPU:0";
+  for (auto s : state) {
+    for (const NodeDef& node : nodes) RunNode(&collector, node, device);
+    StepStats step_stats;
+    collector.Drain(&step_stats);
+  }
+  state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+BENCHMARK(BM_SampledStepStatsCollector)->Arg(1)->Arg(16);
+
+}  // namespace
+}  // namespace tensorflow
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 
+#include <algorithm>
 #include <deque>
 #include <limits>
 #include <memory>
@@ -22,6 +23,8 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/eval_const_tensor.h"
 #include "tensorflow/core/common_runtime/function_utils.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
@@ -34,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tsl/platform/statusor.h"
 
 namespace tensorflow {
@@ -64,6 +68,60 @@ namespace {
 constexpr char kArgOp[] = "_Arg";
 constexpr char kRetvalOp[] = "_Retval";
 
+// Appends `value` to `key`, prefixed with its length so that the key can't be
+// produced by other combinations of values.
+void AppendToKey(absl::string_view value, string* key) {
+  absl::StrAppend(key, value.size(), ":", value);
+}
+
+// Returns the key under which the output shapes of a call to function `fname`
+// with `attributes` and the input shapes of `c` are cached.
+string FunctionShapesKey(const string& fname, AttrSlice attributes,
+                         InferenceContext* c) {
+  string key;
+  AppendToKey(fname, &key);
+
+  // The attributes are sorted by name, as their map has no defined order.
+  std::vector<std::pair<string, const AttrValue*>> attrs;
+  for (const auto& attr : attributes) {
+    attrs.emplace_back(attr.first, &attr.second);
+  }
+  std::sort(attrs.begin(), attrs.end());
+  string serialized;
+  for (const auto& attr : attrs) {
+    AppendToKey(attr.first, &key);
+    SerializeToStringDeterministic(*attr.second, &serialized);
+    AppendToKey(serialized, &key);
+  }
+
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    // Undefined input shapes are treated as unknown, as in
+    // InferShapesForFunctionSubNode.
+    TensorShapeProto proto;
+    c->ShapeHandleToProto(c->input(i), &proto);
+    SerializeToStringDeterministic(proto, &serialized);
+    AppendToKey(serialized, &key);
+
+    const std::vector<ShapeAndType>* handle_data =
+        c->input_handle_shapes_and_types(i);
+    if (handle_data == nullptr) {
+      AppendToKey("", &key);
+      continue;
+    }
+    AppendToKey(absl::StrCat(handle_data->size()), &key);
+    for (const ShapeAndType& shape_and_type : *handle_data) {
+      TensorShapeProto handle_proto;
+      c->ShapeHandleToProto(shape_and_type.shape, &handle_proto);
+      SerializeToStringDeterministic(handle_proto, &serialized);
+      AppendToKey(serialized, &key);
+      AppendToKey(absl::StrCat(shape_and_type.dtype), &key);
+      SerializeToStringDeterministic(shape_and_type.type, &serialized);
+      AppendToKey(serialized, &key);
+    }
+  }
+  return key;
+}
+
 }  // namespace
 
 // Runs shape inference for the given node using the given ShapeRefiner.
@@ -161,6 +219,91 @@ Status ShapeRefiner::InferShapesForFunctionSubNode(
 Status ShapeRefiner::InferShapesForFunction(const FunctionDef* function_def,
                                             AttrSlice attributes,
                                             InferenceContext* outer_context) {
+  // The function body may have used the values of constant inputs, which are
+  // not part of the cache key.
+  for (int i = 0; i < outer_context->num_inputs(); ++i) {
+    if (outer_context->input_tensor(i) != nullptr) {
+      return InferShapesForFunctionBody(function_def, attributes,
+                                        outer_context);
+    }
+  }
+
+  const string key = FunctionShapesKey(function_def->signature().name(),
+                                       attributes, outer_context);
+  auto it = function_shapes_.find(key);
+  if (it == function_shapes_.end()) {
+    TF_RETURN_IF_ERROR(
+        InferShapesForFunctionBody(function_def, attributes, outer_context));
+
+    FunctionShapes shapes;
+    shapes.outputs.resize(outer_context->num_outputs());
+    for (int i = 0; i < outer_context->num_outputs(); ++i) {
+      FunctionShapes::Output& output = shapes.outputs[i];
+      ShapeHandle shape = outer_context->output(i);
+      if (!shape.SameHandle(ShapeHandle())) {
+        output.has_shape = true;
+        outer_context->ShapeHandleToProto(shape, &output.shape);
+      }
+      const std::vector<ShapeAndType>* handle_data =
+          outer_context->output_handle_shapes_and_types(i);
+      if (handle_data != nullptr) {
+        output.has_handle_data = true;
+        for (const ShapeAndType& shape_and_type : *handle_data) {
+          FunctionShapes::HandleData& data = output.handle_data.emplace_back();
+          outer_context->ShapeHandleToProto(shape_and_type.shape, &data.shape);
+          data.dtype = shape_and_type.dtype;
+          data.type = shape_and_type.type;
+        }
+      }
+    }
+    for (int i = 0; i < outer_context->num_inputs(); ++i) {
+      if (outer_context->requested_input_tensor(i)) {
+        shapes.requested_input_tensors.push_back(i);
+      }
+    }
+    function_shapes_.emplace(key, std::move(shapes));
+    return absl::OkStatus();
+  }
+
+  VLOG(4) << "Using cached shapes for function \""
+          << function_def->signature().name() << "\".";
+  const FunctionShapes& shapes = it->second;
+  if (shapes.outputs.size() != outer_context->num_outputs()) {
+    return errors::Internal("Cached shapes for function ",
+                            function_def->signature().name(), " have ",
+                            shapes.outputs.size(), " outputs, expected ",
+                            outer_context->num_outputs(), ".");
+  }
+  for (int i = 0; i < outer_context->num_outputs(); ++i) {
+    const FunctionShapes::Output& output = shapes.outputs[i];
+    if (output.has_shape) {
+      ShapeHandle handle;
+      TF_RETURN_IF_ERROR(
+          outer_context->MakeShapeFromShapeProto(output.shape, &handle));
+      outer_context->set_output(i, handle);
+    }
+    if (output.has_handle_data) {
+      std::vector<ShapeAndType> shapes_and_types;
+      for (const FunctionShapes::HandleData& data : output.handle_data) {
+        ShapeHandle handle;
+        TF_RETURN_IF_ERROR(
+            outer_context->MakeShapeFromShapeProto(data.shape, &handle));
+        shapes_and_types.push_back(ShapeAndType(handle, data.dtype, data.type));
+      }
+      outer_context->set_output_handle_shapes_and_types(i, shapes_and_types);
+    }
+  }
+  // Let the caller materialize the inputs that the function body asked for,
+  // in which case inference reruns on the body with their values.
+  for (int index : shapes.requested_input_tensors) {
+    outer_context->request_input_tensor(index);
+  }
+  return absl::OkStatus();
+}
+
+Status ShapeRefiner::InferShapesForFunctionBody(
+    const FunctionDef* function_def, AttrSlice attributes,
+    InferenceContext* outer_context) {
   const Graph* graph;
   const string& fname = function_def->signature().name();
   auto it = functions_.find(fname);
@@ -22,8 +22,11 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/graph_runner.h"
+#include "tensorflow/core/framework/full_type.pb.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
@@ -100,8 +103,9 @@ class ShapeRefiner {
   // Set function library to enable function shape inference.
   // Without function library, function inference always yields unknown shapes.
   // With this enabled, shape inference can take more time since it descends
-  // into all function calls. It doesn't do inference once for each function
-  // definition, but once for each function call.
+  // into all function calls. Inference runs once for each distinct combination
+  // of function, attributes and input shapes; later calls with the same
+  // combination reuse the cached output shapes.
   // The function library must outlive the shape refiner.
   void set_function_library_for_shape_inference(
       const tensorflow::FunctionLibraryDefinition* lib) {
@@ -139,10 +143,20 @@ class ShapeRefiner {
   //
   // On success:
   // - outer_context will contain output shapes inferred from input shapes
+  //
+  // Results are cached in function_shapes_ unless outer_context holds constant
+  // input tensors, which the function body may have used.
   Status InferShapesForFunction(
       const FunctionDef* function_def, AttrSlice attributes,
       shape_inference::InferenceContext* outer_context);
 
+  // Instantiates and runs shape inference on the body of function_def,
+  // setting the outputs of outer_context. Called by InferShapesForFunction on
+  // a cache miss.
+  Status InferShapesForFunctionBody(
+      const FunctionDef* function_def, AttrSlice attributes,
+      shape_inference::InferenceContext* outer_context);
+
   // Performs shape inference for a node inside a function.
   //
   // 'outer_context' is the 'InferenceContext' for the function's call op.
@@ -283,6 +297,31 @@ class ShapeRefiner {
   // are refined.
   absl::flat_hash_map<std::string, std::unique_ptr<const Graph>> functions_;
 
+  // The output shapes inferred for a function call, stored as protos since the
+  // shape handles are owned by the InferenceContext of the call.
+  struct FunctionShapes {
+    struct HandleData {
+      TensorShapeProto shape;
+      DataType dtype = DT_INVALID;
+      FullTypeDef type;
+    };
+    struct Output {
+      bool has_shape = false;
+      TensorShapeProto shape;
+      bool has_handle_data = false;
+      std::vector<HandleData> handle_data;
+    };
+    std::vector<Output> outputs;
+    // The inputs whose constant values the function body asked for.
+    std::vector<int> requested_input_tensors;
+  };
+
+  // Cache of function output shapes, keyed by the function name, attributes
+  // and input shapes of the call. Large graphs often call the same function
+  // many times with the same shapes, and each call would otherwise run
+  // inference on the whole function body again.
+  absl::flat_hash_map<std::string, FunctionShapes> function_shapes_;
+
   ShapeRefiner(const ShapeRefiner&) = delete;
   void operator=(const ShapeRefiner&) = delete;
 };
@@ -59,6 +59,10 @@ class ShapeRefinerTest : public ::testing::Test {
     return ShapeRefiner::IsUpdatedShapesOrTypes(c, existing, updated);
   }
 
+  int NumCachedFunctionShapes(const ShapeRefiner& m) {
+    return m.function_shapes_.size();
+  }
+
   static constexpr int64_t kMaxTensorSize = ShapeRefiner::kMaxTensorSize;
 
   void TestStridedSlice(const PartialTensorShape& input_shape, int begin,
@@ -1559,5 +1563,54 @@ TEST_F(ShapeRefinerTest, FunctionShapeInferenceWorksForResourceHandles) {
   EXPECT_RESOURCE_SINGLE_TYPE(DataType::DT_FLOAT, m, swap, 1);
 }
 
+TEST_F(ShapeRefinerTest, FunctionShapeInferenceIsCached) {
+  FunctionDefLibrary f_lib_proto;
+  *(f_lib_proto.add_function()) = test::function::XTimesTwo();
+  *(f_lib_proto.add_function()) = test::function::Swap();
+  FunctionLibraryDefinition f_lib(OpRegistry::Global(), f_lib_proto);
+
+  Scope root = Scope::NewRootScope().ExitOnError();
+  TF_ASSERT_OK(root.graph()->AddFunctionLibrary(f_lib_proto));
+  auto x = ops::Const(root, {{1.0f, 2.0f}});
+  auto y = ops::Const(root, {{1.0f, 2.0f}});
+  auto z = ops::Const(root, {1.0f, 2.0f, 3.0f});
+  auto x2 = test::function::Call(&root, "x2", "XTimesTwo", {x});
+  auto y2 = test::function::Call(&root, "y2", "XTimesTwo", {y});
+  auto z2 = test::function::Call(&root, "z2", "XTimesTwo", {z});
+  auto v1 = ops::VarHandleOp(root, DataType::DT_FLOAT, TensorShape({128, 256}));
+  auto v2 = ops::VarHandleOp(root, DataType::DT_DOUBLE, TensorShape({1024}));
+  auto swap = test::function::Call(&root, "swap", "Swap", {v1, v2});
+  auto swap2 = test::function::Call(&root, "swap2", "Swap", {v1, v2});
+
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, &f_lib);
+  m.set_function_library_for_shape_inference(&f_lib);
+
+  TF_ASSERT_OK(m.AddNode(x.node()));
+  TF_ASSERT_OK(m.AddNode(y.node()));
+  TF_ASSERT_OK(m.AddNode(z.node()));
+  TF_ASSERT_OK(m.AddNode(x2.node()));
+  EXPECT_EQ(NumCachedFunctionShapes(m), 1);
+  // Same function and input shapes: the cached output shapes are used.
+  TF_ASSERT_OK(m.AddNode(y2.node()));
+  EXPECT_EQ(NumCachedFunctionShapes(m), 1);
+  TF_ASSERT_OK(m.AddNode(z2.node()));
+  EXPECT_EQ(NumCachedFunctionShapes(m), 2);
+
+  EXPECT_SHAPE("[1,2]", m, x2, 0);
+  EXPECT_SHAPE("[1,2]", m, y2, 0);
+  EXPECT_SHAPE("[3]", m, z2, 0);
+
+  TF_ASSERT_OK(m.AddNode(v1.node()));
+  TF_ASSERT_OK(m.AddNode(v2.node()));
+  TF_ASSERT_OK(m.AddNode(swap.node()));
+  TF_ASSERT_OK(m.AddNode(swap2.node()));
+  EXPECT_EQ(NumCachedFunctionShapes(m), 3);
+
+  EXPECT_RESOURCE_SINGLE_SHAPE("[1024]", m, swap2, 0);
+  EXPECT_RESOURCE_SINGLE_SHAPE("[128,256]", m, swap2, 1);
+  EXPECT_RESOURCE_SINGLE_TYPE(DataType::DT_DOUBLE, m, swap2, 0);
+  EXPECT_RESOURCE_SINGLE_TYPE(DataType::DT_FLOAT, m, swap2, 1);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -16,7 +16,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/single_threaded_executor.h"
 
 #include <utility>
+#include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/entry.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
@@ -62,9 +64,6 @@ Status ValidateOpIsSafeForSyncExecution(
 
 namespace {
 
-typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
-typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
-
 static const string& kSingleThreadedExecutor =
     *new string("SINGLE_THREADED_EXECUTOR");
 
@@ -205,18 +204,29 @@ class SingleThreadedExecutorImpl : public Executor {
     }
 
     // Build the mapping from each node output to the input slot for the
-    // corresponding destination node.
+    // corresponding destination node, flattened into `output_locations_` in
+    // kernel order.
+    output_location_offsets_.reserve(kernels_.size() + 1);
+    output_location_offsets_.push_back(0);
+    std::vector<std::vector<size_t>> node_output_locations;
     for (size_t i = 0; i < kernels_.size(); ++i) {
       Node* n = nodes_with_kernels[i];
       KernelState& kernel_state = kernels_[i];
-      kernel_state.output_locations.resize(kernel_state.num_outputs);
+      node_output_locations.clear();
+      node_output_locations.resize(kernel_state.num_outputs);
       for (const Edge* e : n->out_edges()) {
         if (!e->IsControlEdge()) {
-          kernel_state.output_locations[e->src_output()].push_back(
+          node_output_locations[e->src_output()].push_back(
               kernels_[node_to_index_map[e->dst()]].input_start_index +
               e->dst_input());
         }
       }
+      kernel_state.output_offsets_index = output_location_offsets_.size() - 1;
+      for (const std::vector<size_t>& locations : node_output_locations) {
+        output_locations_.insert(output_locations_.end(), locations.begin(),
+                                 locations.end());
+        output_location_offsets_.push_back(output_locations_.size());
+      }
 
       // Compute allocator attributes for each node output, and corresponding
       // node input.
@@ -241,9 +251,11 @@ class SingleThreadedExecutorImpl : public Executor {
           last_kernel_state.input_start_index + last_kernel_state.num_inputs;
       input_alloc_attrs_.resize(total_num_inputs_);
       for (size_t i = 0; i < kernels_.size(); ++i) {
-        for (size_t j = 0; j < kernels_[i].output_locations.size(); ++j) {
-          for (size_t output_location : kernels_[i].output_locations[j]) {
-            input_alloc_attrs_[output_location] =
+        for (size_t j = 0; j < kernels_[i].num_outputs; ++j) {
+          const size_t offsets_index = kernels_[i].output_offsets_index + j;
+          for (size_t k = output_location_offsets_[offsets_index];
+               k < output_location_offsets_[offsets_index + 1]; ++k) {
+            input_alloc_attrs_[output_locations_[k]] =
                 kernels_[i].output_alloc_attrs[j];
           }
         }
@@ -285,15 +297,16 @@ class SingleThreadedExecutorImpl : public Executor {
     //   propagated to the inputs of kernels that depend on them.
     // * The elements corresponding to the inputs for kernel `i` are destroyed
     //   after kernel `i` executes.
-    // * In an error case (see below), we use the connectivity information in
-    //   `KernelState::output_locations` to determine which locations have been
-    //   initialized, and manually destroy them.
+    // * In an error case, the `Entry` destructor destroys any elements that
+    //   are still initialized.
     std::vector<Entry> inputs(total_num_inputs_);
 
-    // TODO(mrry): Can we avoid copying into these vectors? Consider modifying
-    // OpKernelContext to take the TensorValueVec as a pointer into `inputs`.
-    TensorValueVec node_inputs;
-    AllocatorAttributeVec input_alloc_attrs;
+    // `input_values[i]` points at the tensor held by `inputs[i]`, and is set
+    // whenever `inputs[i]` is initialized. Since both vectors have the same
+    // layout, each kernel reads its inputs (and their allocator attributes,
+    // from `input_alloc_attrs_`) as a contiguous slice, without copying them
+    // into per-kernel vectors.
+    std::vector<TensorValue> input_values(total_num_inputs_);
 
     // Override intra op thread pool if requested.
     Device* device = params_.device;
@@ -365,6 +378,8 @@ class SingleThreadedExecutorImpl : public Executor {
           first_input.state = Entry::State::HAS_VALUE;
           first_input.val.Init();
           args.call_frame->ConsumeArg(i, first_input.val.get());
+          input_values[arg_output_locations_[i][0]].tensor =
+              first_input.val.get();
           // All subsequent destination inputs get a shallow copy of the first
           // destination input.
           //
@@ -375,6 +390,7 @@ class SingleThreadedExecutorImpl : public Executor {
             Entry& input = inputs[arg_output_locations_[i][j]];
             input.state = Entry::State::HAS_VALUE;
             input.val.Init(*first_input.val);
+            input_values[arg_output_locations_[i][j]].tensor = input.val.get();
           }
         } else {
           const Tensor* arg;
@@ -388,6 +404,7 @@ class SingleThreadedExecutorImpl : public Executor {
             // for each consuming kernel.
             input.state = Entry::State::HAS_VALUE;
             input.val.Init(*arg);
+            input_values[arg_output_locations_[i][j]].tensor = input.val.get();
           }
         }
       }
@@ -402,6 +419,12 @@ class SingleThreadedExecutorImpl : public Executor {
         Entry& input = inputs[kernel_state.output_locations[i]];
         input.state = Entry::State::HAS_CONST_TENSOR;
         input.const_tensor = &kernel_state.const_tensor;
+        // NOTE(mrry): This `const_cast` is necessary because `TensorValue`
+        // stores a non-const `Tensor*`, and relies on the `OpKernelContext`
+        // accessors making dynamic checks that prevent using an immutable
+        // tensor as a mutable tensor.
+        input_values[kernel_state.output_locations[i]].tensor =
+            const_cast<Tensor*>(&kernel_state.const_tensor);
       }
     }
 
@@ -414,30 +437,16 @@ class SingleThreadedExecutorImpl : public Executor {
       const size_t num_inputs = kernel_state.num_inputs;
       const size_t num_outputs = kernel_state.num_outputs;
 
-      node_inputs.clear();
-      node_inputs.resize(num_inputs);
-      input_alloc_attrs.clear();
-      input_alloc_attrs.resize(num_inputs);
+#ifndef NDEBUG
       for (size_t j = 0; j < num_inputs; ++j) {
-        Entry& input = inputs[input_start_index + j];
-        switch (input.state) {
-          case Entry::State::HAS_CONST_TENSOR:
-            // NOTE(mrry): This `const_cast` is necessary because `TensorValue`
-            // stores a non-const `Tensor*`, and relies on the `OpKernelContext`
-            // accessors making dynamic checks that prevent using an immutable
-            // tensor as a mutable tensor.
-            node_inputs[j].tensor = const_cast<Tensor*>(input.const_tensor);
-            break;
-          case Entry::State::HAS_VALUE:
-            node_inputs[j].tensor = input.val.get();
-            break;
-          default:
-            DCHECK(false) << "Input did not have a valid value.";
-        }
-        input_alloc_attrs[j] = input_alloc_attrs_[input_start_index + j];
+        DCHECK(inputs[input_start_index + j].state != Entry::State::NO_VALUE)
+            << "Input did not have a valid value.";
       }
-      params.inputs = node_inputs;
-      params.input_alloc_attrs = input_alloc_attrs;
+#endif  // NDEBUG
+      params.inputs = absl::MakeConstSpan(
+          input_values.data() + input_start_index, num_inputs);
+      params.input_alloc_attrs = absl::MakeConstSpan(
+          input_alloc_attrs_.data() + input_start_index, num_inputs);
       params.op_kernel = kernel_state.kernel;
       params.output_attr_array = kernel_state.output_alloc_attrs.data();
       OpKernelContext ctx(&params, num_outputs);
@@ -452,32 +461,36 @@ class SingleThreadedExecutorImpl : public Executor {
       }
 
       // Forward the outputs of the kernel to the inputs of subsequent kernels.
+      const size_t* output_offsets =
+          output_location_offsets_.data() + kernel_state.output_offsets_index;
       for (size_t j = 0; j < num_outputs; ++j) {
         TensorValue val = ctx.release_output(j);
-        const size_t num_destinations = kernel_state.output_locations[j].size();
+        const size_t* locations = output_locations_.data() + output_offsets[j];
+        const size_t num_destinations =
+            output_offsets[j + 1] - output_offsets[j];
         if (num_destinations > 0) {
-          // TODO(mrry): Consider flattening the `output_locations` vector
-          // to improve the cache-friendliness of this loop.
           for (size_t k = 0; k < num_destinations - 1; ++k) {
             // TODO(mrry): Validate that the types match the expected values or
             // ensure that the necessary validation has already happened.
-            Entry& input = inputs[kernel_state.output_locations[j][k]];
+            Entry& input = inputs[locations[k]];
             input.state = Entry::State::HAS_VALUE;
             if (val.tensor != nullptr) {
               input.val.Init(*val.tensor);
             } else {
               input.val.Init(Tensor(kernel_state.kernel->output_type(j)));
             }
+            input_values[locations[k]].tensor = input.val.get();
           }
           // Move `arg` to the last consumer to avoid the cost of copying it.
-          Entry& input =
-              inputs[kernel_state.output_locations[j][num_destinations - 1]];
+          Entry& input = inputs[locations[num_destinations - 1]];
           input.state = Entry::State::HAS_VALUE;
           if (val.tensor != nullptr) {
             input.val.Init(std::move(*val.tensor));
           } else {
             input.val.Init(Tensor(kernel_state.kernel->output_type(j)));
           }
+          input_values[locations[num_destinations - 1]].tensor =
+              input.val.get();
         }
         delete val.tensor;
       }
@@ -519,11 +532,12 @@ class SingleThreadedExecutorImpl : public Executor {
 
     size_t num_outputs;
 
-    // For the `j`th output of `kernel`, `output_locations[j]` contains the
-    // locations in the flat `inputs` vector to which that output must be
-    // copied. See comment at the beginning of `Run()` for details.
-    std::vector<std::vector<size_t>>
-        output_locations;  // Length = `num_outputs`.
+    // For the `j`th output of `kernel`, the locations in the flat `inputs`
+    // vector to which that output must be copied are the elements of
+    // `output_locations_` in the range [`output_location_offsets_[o]`,
+    // `output_location_offsets_[o + 1]`), where `o = output_offsets_index + j`.
+    // See comment at the beginning of `Run()` for details.
+    size_t output_offsets_index;
 
     // Memory space information for each output of `kernel`.
     std::vector<AllocatorAttributes>
@@ -531,6 +545,15 @@ class SingleThreadedExecutorImpl : public Executor {
   };
   std::vector<KernelState> kernels_;
 
+  // The destination input slots of every kernel output, concatenated in kernel
+  // and output order. Keeping these in one array, rather than one vector per
+  // output, keeps output forwarding in `Run()` cache-friendly.
+  std::vector<size_t> output_locations_;
+
+  // `output_locations_` offsets delimiting the destinations of each kernel
+  // output. Length = (total number of kernel outputs) + 1.
+  std::vector<size_t> output_location_offsets_;
+
   // For the `i`th argument, `arg_output_locations_[i]` contains the locations
   // in the flat `inputs` vector to which that argument must be copied.
   std::vector<std::vector<size_t>>
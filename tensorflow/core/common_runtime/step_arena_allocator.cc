@@ -0,0 +1,264 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+struct StepArenaAllocator::AllocationHeader {
+  // The chunk holding the allocation, or nullptr if it was forwarded.
+  Chunk* chunk;
+  // The pointer returned by the base allocator for a forwarded allocation.
+  void* base_ptr;
+  // The requested size, and the thread arena whose `bytes_in_use` counts it.
+  size_t num_bytes;
+  ThreadArena* arena;
+};
+
+namespace {
+
+uintptr_t AlignUp(uintptr_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Returns an index that is distinct for each thread.
+int ThreadIndex() {
+  static std::atomic<int> next_index{0};
+  thread_local const int index =
+      next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+}  // namespace
+
+StepArenaAllocator::StepArenaAllocator(Allocator* base_allocator,
+                                       const Options& options)
+    : base_allocator_(base_allocator),
+      options_(options),
+      thread_arenas_(new ThreadArena[std::max(1, options.num_thread_arenas)]) {
+  CHECK(base_allocator_ != nullptr);
+  CHECK_GT(options_.chunk_size_bytes, Allocator::kAllocatorAlignment);
+  CHECK_GT(options_.num_thread_arenas, 0);
+  stats_.bytes_limit = static_cast<int64_t>(options_.memory_limit_bytes);
+  stats_.pool_bytes = 0;
+  stats_.peak_pool_bytes = 0;
+}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  for (int i = 0; i < options_.num_thread_arenas; ++i) {
+    ThreadArena& arena = thread_arenas_[i];
+    mutex_lock l(arena.mu);
+    if (arena.current != nullptr) {
+      arena.current->refs.fetch_sub(1, std::memory_order_relaxed);
+      arena.current = nullptr;
+    }
+  }
+  mutex_lock l(mu_);
+  for (auto& entry : chunks_) {
+    const int64_t live_allocations = entry.second->refs.load();
+    if (live_allocations != 0) {
+      LOG(ERROR) << "StepArenaAllocator destroyed with " << live_allocations
+                 << " live allocations in a chunk";
+    }
+    base_allocator_->DeallocateRaw(entry.second->base);
+  }
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+}
+
+void* StepArenaAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  // A fresh chunk fits any allocation up to this size after its header.
+  const size_t max_arena_allocation_bytes =
+      std::min(options_.max_arena_allocation_bytes,
+               options_.chunk_size_bytes - Allocator::kAllocatorAlignment);
+  ThreadArena* arena = GetThreadArena();
+  if (num_bytes > 0 && num_bytes <= max_arena_allocation_bytes &&
+      alignment <= Allocator::kAllocatorAlignment) {
+    mutex_lock l(arena->mu);
+    void* ptr = AllocateFromArena(arena, alignment, num_bytes);
+    if (ptr != nullptr) return ptr;
+    ++arena->num_forwarded_allocations;
+  } else {
+    mutex_lock l(arena->mu);
+    ++arena->num_forwarded_allocations;
+  }
+  return AllocateForwarded(arena, alignment, num_bytes, allocation_attr);
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  const AllocationHeader& header =
+      reinterpret_cast<const AllocationHeader*>(ptr)[-1];
+  header.arena->bytes_in_use.fetch_sub(header.num_bytes,
+                                       std::memory_order_relaxed);
+  if (header.chunk != nullptr) {
+    Unref(header.chunk);
+  } else {
+    base_allocator_->DeallocateRaw(header.base_ptr);
+  }
+}
+
+StepArenaAllocator::ThreadArena* StepArenaAllocator::GetThreadArena() {
+  return &thread_arenas_[ThreadIndex() % options_.num_thread_arenas];
+}
+
+void* StepArenaAllocator::AllocateFromArena(ThreadArena* arena,
+                                            size_t alignment,
+                                            size_t num_bytes) {
+  alignment = std::max(alignment, alignof(AllocationHeader));
+  while (true) {
+    Chunk* chunk = arena->current;
+    if (chunk == nullptr) {
+      chunk = GetChunk();
+      if (chunk == nullptr) return nullptr;
+      arena->current = chunk;
+    } else if (chunk->refs.load(std::memory_order_acquire) == 1) {
+      // Everything bumped from the chunk is dead; rewind it.
+      chunk->offset = 0;
+    }
+    const uintptr_t base = reinterpret_cast<uintptr_t>(chunk->base);
+    const size_t offset =
+        AlignUp(base + chunk->offset + sizeof(AllocationHeader), alignment) -
+        base;
+    if (offset + num_bytes <= options_.chunk_size_bytes) {
+      chunk->offset = offset + num_bytes;
+      chunk->refs.fetch_add(1, std::memory_order_relaxed);
+      ++arena->num_allocs;
+      arena->largest_alloc_size = std::max<int64_t>(
+          arena->largest_alloc_size, static_cast<int64_t>(num_bytes));
+      arena->bytes_in_use.fetch_add(num_bytes, std::memory_order_relaxed);
+      char* ptr = chunk->base + offset;
+      reinterpret_cast<AllocationHeader*>(ptr)[-1] = {chunk, nullptr,
+                                                      num_bytes, arena};
+      return ptr;
+    }
+    // The chunk is exhausted. It is reclaimed when its last live allocation
+    // is freed.
+    arena->current = nullptr;
+    Unref(chunk);
+  }
+}
+
+void* StepArenaAllocator::AllocateForwarded(
+    ThreadArena* arena, size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  alignment = std::max(alignment, alignof(AllocationHeader));
+  const size_t header_bytes = AlignUp(sizeof(AllocationHeader), alignment);
+  char* base_ptr = static_cast<char*>(base_allocator_->AllocateRaw(
+      alignment, header_bytes + num_bytes, allocation_attr));
+  if (base_ptr == nullptr) return nullptr;
+  arena->bytes_in_use.fetch_add(num_bytes, std::memory_order_relaxed);
+  char* ptr = base_ptr + header_bytes;
+  reinterpret_cast<AllocationHeader*>(ptr)[-1] = {nullptr, base_ptr, num_bytes,
+                                                  arena};
+  return ptr;
+}
+
+StepArenaAllocator::Chunk* StepArenaAllocator::GetChunk() {
+  mutex_lock l(mu_);
+  Chunk* chunk = nullptr;
+  if (!free_chunks_.empty()) {
+    chunk = free_chunks_.back();
+    free_chunks_.pop_back();
+  } else {
+    const size_t reserved_bytes = chunks_.size() * options_.chunk_size_bytes;
+    if (reserved_bytes + options_.chunk_size_bytes >
+        options_.memory_limit_bytes) {
+      return nullptr;
+    }
+    void* base = base_allocator_->AllocateRaw(Allocator::kAllocatorAlignment,
+                                              options_.chunk_size_bytes);
+    if (base == nullptr) return nullptr;
+    auto new_chunk = std::make_unique<Chunk>();
+    new_chunk->base = static_cast<char*>(base);
+    chunk = new_chunk.get();
+    chunks_.emplace(reinterpret_cast<uintptr_t>(base), std::move(new_chunk));
+    stats_.pool_bytes = chunks_.size() * options_.chunk_size_bytes;
+    stats_.peak_pool_bytes =
+        std::max(*stats_.peak_pool_bytes, *stats_.pool_bytes);
+  }
+  chunk->refs.store(1, std::memory_order_relaxed);
+  return chunk;
+}
+
+void StepArenaAllocator::Unref(Chunk* chunk) {
+  if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+  // No thread arena bumps through the chunk any more, and it holds no live
+  // allocations.
+  mutex_lock l(mu_);
+  chunk->offset = 0;
+  if (free_chunks_.size() < static_cast<size_t>(options_.max_free_chunks)) {
+    free_chunks_.push_back(chunk);
+    return;
+  }
+  base_allocator_->DeallocateRaw(chunk->base);
+  chunks_.erase(reinterpret_cast<uintptr_t>(chunk->base));
+  stats_.pool_bytes = chunks_.size() * options_.chunk_size_bytes;
+}
+
+absl::optional<AllocatorStats> StepArenaAllocator::GetStats() {
+  AllocatorStats stats;
+  {
+    mutex_lock l(mu_);
+    stats = stats_;
+  }
+  for (int i = 0; i < options_.num_thread_arenas; ++i) {
+    ThreadArena& arena = thread_arenas_[i];
+    mutex_lock l(arena.mu);
+    stats.num_allocs += arena.num_allocs;
+    stats.largest_alloc_size =
+        std::max(stats.largest_alloc_size, arena.largest_alloc_size);
+    stats.bytes_in_use += arena.bytes_in_use.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+bool StepArenaAllocator::ClearStats() {
+  for (int i = 0; i < options_.num_thread_arenas; ++i) {
+    ThreadArena& arena = thread_arenas_[i];
+    mutex_lock l(arena.mu);
+    arena.num_allocs = 0;
+    arena.largest_alloc_size = 0;
+  }
+  mutex_lock l(mu_);
+  stats_.peak_pool_bytes = stats_.pool_bytes;
+  return true;
+}
+
+int64_t StepArenaAllocator::num_chunks() const {
+  mutex_lock l(mu_);
+  return chunks_.size();
+}
+
+int64_t StepArenaAllocator::num_forwarded_allocations() const {
+  int64_t num_forwarded_allocations = 0;
+  for (int i = 0; i < options_.num_thread_arenas; ++i) {
+    ThreadArena& arena = thread_arenas_[i];
+    mutex_lock l(arena.mu);
+    num_forwarded_allocations += arena.num_forwarded_allocations;
+  }
+  return num_forwarded_allocations;
+}
+
+}  // namespace tensorflow
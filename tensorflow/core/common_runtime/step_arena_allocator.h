@@ -0,0 +1,158 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// StepArenaAllocator serves small and medium sized allocations by bumping a
+// pointer through large chunks obtained from a base allocator.
+//
+// Threads are spread over a fixed number of arenas, each with its own lock and
+// the chunk it currently bumps through, so threads do not contend with each
+// other when allocating. Frees take no lock: every allocation is preceded by a
+// small header naming its chunk, whose count of live allocations is atomic.
+//
+// When the last allocation in a chunk is freed the whole chunk is reclaimed
+// at once: it is rewound if an arena is still bumping through it, and
+// otherwise returned to a small free list for reuse. Intermediate tensors of a
+// step all die by the end of the step, so in steady state each arena is
+// rewound once per step and the base allocator is not involved at all.
+//
+// A tensor that outlives the step (e.g., a fetched output or the value of a
+// variable) keeps its chunk alive, but never becomes invalid. Callers should
+// route allocations that are known to escape the device (e.g., tensors that
+// are sent over the network or DMA'd to an accelerator) to the base allocator
+// directly. Allocations larger than `max_arena_allocation_bytes`, and all
+// allocations made once the arena holds `memory_limit_bytes`, are forwarded to
+// the base allocator.
+//
+// This class is thread-safe.
+class StepArenaAllocator : public Allocator {
+ public:
+  struct Options {
+    // Size of each chunk obtained from the base allocator.
+    size_t chunk_size_bytes = 1 << 20;
+    // Allocations larger than this are forwarded to the base allocator.
+    // Clamped to what fits in a chunk after its allocation header.
+    size_t max_arena_allocation_bytes = 256 << 10;
+    // Upper bound on the number of bytes that the arena keeps in chunks.
+    size_t memory_limit_bytes = size_t{1} << 30;
+    // Number of fully freed chunks that are kept for reuse instead of being
+    // returned to the base allocator.
+    int max_free_chunks = 4;
+    // Number of arenas that threads are spread over. Each one holds a chunk
+    // while it is in use.
+    int num_thread_arenas = 16;
+  };
+
+  // `base_allocator` is not owned and must outlive this object.
+  StepArenaAllocator(Allocator* base_allocator, const Options& options);
+  ~StepArenaAllocator() override;
+
+  StepArenaAllocator(const StepArenaAllocator&) = delete;
+  void operator=(const StepArenaAllocator&) = delete;
+
+  std::string Name() override { return "step_arena"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+
+  absl::optional<AllocatorStats> GetStats() override;
+  bool ClearStats() override;
+
+  AllocatorMemoryType GetMemoryType() const override {
+    return base_allocator_->GetMemoryType();
+  }
+
+  // Returns the number of chunks, live or free, that the arena holds.
+  int64_t num_chunks() const;
+
+  // Returns the number of allocations that were forwarded to the base
+  // allocator.
+  int64_t num_forwarded_allocations() const;
+
+ private:
+  struct Chunk {
+    char* base = nullptr;
+    // Only accessed by the thread arena bumping through the chunk.
+    size_t offset = 0;
+    // Number of live allocations in the chunk, plus one while a thread arena
+    // bumps through it. The chunk is released when this drops to zero.
+    std::atomic<int64_t> refs{0};
+  };
+
+  // Precedes every allocation returned by this allocator.
+  struct AllocationHeader;
+
+  // The chunk that the threads mapped to an arena bump through.
+  struct alignas(64) ThreadArena {
+    mutex mu;
+    Chunk* current TF_GUARDED_BY(mu) = nullptr;
+    int64_t num_allocs TF_GUARDED_BY(mu) = 0;
+    int64_t largest_alloc_size TF_GUARDED_BY(mu) = 0;
+    int64_t num_forwarded_allocations TF_GUARDED_BY(mu) = 0;
+    // Bytes requested by the live allocations made through this arena. Frees
+    // from other threads update it without taking `mu`.
+    std::atomic<int64_t> bytes_in_use{0};
+  };
+
+  // Returns the thread arena of the calling thread.
+  ThreadArena* GetThreadArena();
+
+  // Bumps `num_bytes` from the chunks of `arena`, or returns nullptr if the
+  // arena is full.
+  void* AllocateFromArena(ThreadArena* arena, size_t alignment,
+                          size_t num_bytes)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(arena->mu);
+  // Allocates from the base allocator, on behalf of `arena`.
+  void* AllocateForwarded(ThreadArena* arena, size_t alignment,
+                          size_t num_bytes,
+                          const AllocationAttributes& allocation_attr);
+
+  // Returns a chunk holding a reference for the calling thread arena, or
+  // nullptr if the arena is full.
+  Chunk* GetChunk() TF_LOCKS_EXCLUDED(mu_);
+  // Drops a reference to `chunk`, and releases it if it was the last one.
+  void Unref(Chunk* chunk) TF_LOCKS_EXCLUDED(mu_);
+
+  Allocator* const base_allocator_;  // Not owned.
+  const Options options_;
+  std::unique_ptr<ThreadArena[]> thread_arenas_;
+
+  mutable mutex mu_;
+  // All chunks, keyed by their base address.
+  std::map<uintptr_t, std::unique_ptr<Chunk>> chunks_ TF_GUARDED_BY(mu_);
+  std::vector<Chunk*> free_chunks_ TF_GUARDED_BY(mu_);
+  AllocatorStats stats_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
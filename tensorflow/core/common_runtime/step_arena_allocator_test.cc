@@ -0,0 +1,235 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+StepArenaAllocator::Options SmallChunkOptions() {
+  StepArenaAllocator::Options options;
+  options.chunk_size_bytes = 4096;
+  options.max_arena_allocation_bytes = 1024;
+  options.memory_limit_bytes = 4 * 4096;
+  options.max_free_chunks = 1;
+  return options;
+}
+
+// Four allocations of this size, each preceded by its header, fill a chunk of
+// SmallChunkOptions.
+constexpr size_t kQuarterChunkBytes = 1024 - Allocator::kAllocatorAlignment;
+
+TEST(StepArenaAllocatorTest, RewindsWhenAllAllocationsAreFreed) {
+  StepArenaAllocator arena(cpu_allocator(), SmallChunkOptions());
+  for (int step = 0; step < 3; ++step) {
+    void* a = arena.AllocateRaw(Allocator::kAllocatorAlignment, 100);
+    void* b = arena.AllocateRaw(Allocator::kAllocatorAlignment, 100);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % Allocator::kAllocatorAlignment,
+              0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % Allocator::kAllocatorAlignment,
+              0);
+    EXPECT_GE(static_cast<char*>(b) - static_cast<char*>(a), 100);
+    arena.DeallocateRaw(a);
+    arena.DeallocateRaw(b);
+  }
+  EXPECT_EQ(arena.num_chunks(), 1);
+  EXPECT_EQ(arena.num_forwarded_allocations(), 0);
+  EXPECT_EQ(arena.GetStats()->num_allocs, 6);
+}
+
+TEST(StepArenaAllocatorTest, ForwardsLargeAllocations) {
+  StepArenaAllocator arena(cpu_allocator(), SmallChunkOptions());
+  void* large = arena.AllocateRaw(Allocator::kAllocatorAlignment, 2048);
+  ASSERT_NE(large, nullptr);
+  memset(large, 0, 2048);
+  EXPECT_EQ(arena.num_chunks(), 0);
+  EXPECT_EQ(arena.num_forwarded_allocations(), 1);
+  arena.DeallocateRaw(large);
+}
+
+TEST(StepArenaAllocatorTest, TracksBytesInUse) {
+  StepArenaAllocator arena(cpu_allocator(), SmallChunkOptions());
+  void* small = arena.AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  void* large = arena.AllocateRaw(Allocator::kAllocatorAlignment, 2048);
+  EXPECT_EQ(arena.GetStats()->bytes_in_use, 2148);
+  // Frees from another thread are accounted to the allocating arena.
+  std::unique_ptr<Thread> thread(
+      Env::Default()->StartThread(ThreadOptions(), "free", [&arena, small]() {
+        arena.DeallocateRaw(small);
+      }));
+  thread.reset();
+  EXPECT_EQ(arena.GetStats()->bytes_in_use, 2048);
+  arena.DeallocateRaw(large);
+  EXPECT_EQ(arena.GetStats()->bytes_in_use, 0);
+}
+
+TEST(StepArenaAllocatorTest, EscapingAllocationPinsOnlyItsChunk) {
+  StepArenaAllocator arena(cpu_allocator(), SmallChunkOptions());
+  // The first allocation outlives the "step"; the rest fill up the first
+  // chunk and spill into a second one.
+  void* escaping =
+      arena.AllocateRaw(Allocator::kAllocatorAlignment, kQuarterChunkBytes);
+  std::vector<void*> intermediates;
+  for (int i = 0; i < 6; ++i) {
+    intermediates.push_back(
+        arena.AllocateRaw(Allocator::kAllocatorAlignment, kQuarterChunkBytes));
+  }
+  EXPECT_EQ(arena.num_chunks(), 2);
+  for (void* ptr : intermediates) arena.DeallocateRaw(ptr);
+
+  // The value of the escaping allocation is preserved.
+  memset(escaping, 0x5a, kQuarterChunkBytes);
+  intermediates.clear();
+  for (int i = 0; i < 3; ++i) {
+    intermediates.push_back(
+        arena.AllocateRaw(Allocator::kAllocatorAlignment, kQuarterChunkBytes));
+  }
+  for (void* ptr : intermediates) arena.DeallocateRaw(ptr);
+  EXPECT_EQ(static_cast<unsigned char*>(escaping)[kQuarterChunkBytes - 1],
+            0x5a);
+  EXPECT_EQ(arena.num_chunks(), 2);
+
+  arena.DeallocateRaw(escaping);
+  EXPECT_EQ(arena.num_forwarded_allocations(), 0);
+}
+
+TEST(StepArenaAllocatorTest, ForwardsAllocationsOverMemoryLimit) {
+  StepArenaAllocator arena(cpu_allocator(), SmallChunkOptions());
+  std::vector<void*> ptrs;
+  // 4 chunks of 4 allocations each fit under the memory limit.
+  for (int i = 0; i < 20; ++i) {
+    ptrs.push_back(
+        arena.AllocateRaw(Allocator::kAllocatorAlignment, kQuarterChunkBytes));
+    ASSERT_NE(ptrs.back(), nullptr);
+  }
+  EXPECT_EQ(arena.num_chunks(), 4);
+  EXPECT_EQ(arena.num_forwarded_allocations(), 4);
+  for (void* ptr : ptrs) arena.DeallocateRaw(ptr);
+  // Only one fully freed chunk is kept for reuse.
+  EXPECT_EQ(arena.num_chunks(), 1);
+}
+
+TEST(StepArenaAllocatorTest, WorksWithTensors) {
+  StepArenaAllocator arena(cpu_allocator(), StepArenaAllocator::Options());
+  Tensor escaping;
+  for (int step = 0; step < 4; ++step) {
+    Tensor a(&arena, DT_FLOAT, TensorShape({16, 16}));
+    Tensor b(&arena, DT_FLOAT, TensorShape({16, 16}));
+    a.flat<float>().setConstant(step);
+    b.flat<float>() = a.flat<float>() * 2.0f;
+    if (step == 0) escaping = b;
+  }
+  EXPECT_EQ(escaping.flat<float>()(0), 0.0f);
+  EXPECT_EQ(arena.num_forwarded_allocations(), 0);
+}
+
+TEST(StepArenaAllocatorTest, ConcurrentAllocations) {
+  constexpr int kNumThreads = 8;
+  constexpr int kNumAllocationsPerThread = 1000;
+  StepArenaAllocator arena(cpu_allocator(), SmallChunkOptions());
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&arena, t]() {
+        for (int i = 0; i < kNumAllocationsPerThread; ++i) {
+          const size_t num_bytes = 1 + (i * 37 + t) % 2048;
+          char* ptr = static_cast<char*>(
+              arena.AllocateRaw(Allocator::kAllocatorAlignment, num_bytes));
+          ASSERT_NE(ptr, nullptr);
+          memset(ptr, t, num_bytes);
+          EXPECT_EQ(ptr[num_bytes - 1], static_cast<char>(t));
+          arena.DeallocateRaw(ptr);
+        }
+      });
+    }
+  }
+  EXPECT_LE(arena.num_chunks(), 4);
+}
+
+TEST(StepArenaAllocatorTest, FreesFromOtherThreads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumSteps = 50;
+  constexpr int kNumAllocationsPerStep = 200;
+  StepArenaAllocator arena(cpu_allocator(), StepArenaAllocator::Options());
+  // Each thread frees the allocations that the previous thread made in the
+  // previous step.
+  std::vector<std::vector<char*>> allocations(kNumThreads);
+  for (int step = 0; step < kNumSteps; ++step) {
+    std::vector<std::vector<char*>> next_allocations(kNumThreads);
+    {
+      thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+      for (int t = 0; t < kNumThreads; ++t) {
+        pool.Schedule([&, t]() {
+          for (char* ptr : allocations[(t + 1) % kNumThreads]) {
+            EXPECT_EQ(*ptr, static_cast<char>((t + 1) % kNumThreads));
+            arena.DeallocateRaw(ptr);
+          }
+          for (int i = 0; i < kNumAllocationsPerStep; ++i) {
+            const size_t num_bytes = 64 * (1 + i % 64);
+            char* ptr = static_cast<char*>(
+                arena.AllocateRaw(Allocator::kAllocatorAlignment, num_bytes));
+            ASSERT_NE(ptr, nullptr);
+            memset(ptr, t, num_bytes);
+            next_allocations[t].push_back(ptr);
+          }
+        });
+      }
+    }
+    allocations.swap(next_allocations);
+  }
+  for (const std::vector<char*>& ptrs : allocations) {
+    for (char* ptr : ptrs) arena.DeallocateRaw(ptr);
+  }
+  EXPECT_EQ(arena.num_forwarded_allocations(), 0);
+}
+
+void BM_StepArenaAllocator(::testing::benchmark::State& state) {
+  const bool use_arena = state.range(0);
+  const int num_tensors = state.range(1);
+  StepArenaAllocator arena(cpu_allocator(), StepArenaAllocator::Options());
+  Allocator* allocator = use_arena ? static_cast<Allocator*>(&arena)
+                                   : cpu_allocator();
+  std::vector<void*> ptrs(num_tensors);
+  for (auto s : state) {
+    for (int i = 0; i < num_tensors; ++i) {
+      ptrs[i] = allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                       64 * (1 + i % 64));
+    }
+    for (int i = 0; i < num_tensors; ++i) {
+      allocator->DeallocateRaw(ptrs[i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_tensors);
+}
+BENCHMARK(BM_StepArenaAllocator)
+    ->ArgPair(0, 16)
+    ->ArgPair(1, 16)
+    ->ArgPair(0, 256)
+    ->ArgPair(1, 256);
+
+}  // namespace
+}  // namespace tensorflow
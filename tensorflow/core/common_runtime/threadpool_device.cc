@@ -27,8 +27,10 @@ info. It does not have any negative impact on performance. */
 #endif  // ENABLE_ONEDNN_OPENMP && ENABLE_MKL &&_OPENMP
 
 #include "absl/base/call_once.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/scoped_allocator.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
@@ -41,8 +43,10 @@ info. It does not have any negative impact on performance. */
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/port.h"
 #include "tensorflow/core/util/util.h"
 
@@ -53,6 +57,78 @@ info. It does not have any negative impact on performance. */
 
 namespace tensorflow {
 
+namespace {
+// Returns the process-wide StepArenaAllocator layered on top of `allocator`,
+// or nullptr if the step arena is disabled. Like the allocators owned by
+// ProcessState, these are never destroyed.
+StepArenaAllocator* MaybeGetStepArenaAllocator(Allocator* allocator) {
+  bool use_step_arena = false;
+  Status status = ReadBoolFromEnvVar("TF_CPU_USE_STEP_ARENA_ALLOCATOR",
+                                     false, &use_step_arena);
+  if (!status.ok()) {
+    LOG(ERROR) << "ThreadPoolDevice: " << status.message();
+  }
+  if (!use_step_arena) return nullptr;
+
+  StepArenaAllocator::Options options;
+  int64_t mem_limit_in_mb = 0;
+  status = ReadInt64FromEnvVar("TF_CPU_STEP_ARENA_MEM_LIMIT_IN_MB",
+                               options.memory_limit_bytes >> 20,
+                               &mem_limit_in_mb);
+  if (!status.ok()) {
+    LOG(ERROR) << "ThreadPoolDevice: " << status.message();
+  } else {
+    options.memory_limit_bytes = static_cast<size_t>(mem_limit_in_mb) << 20;
+  }
+
+  static mutex* mu = new mutex;
+  static auto* arenas =
+      new absl::flat_hash_map<Allocator*, StepArenaAllocator*>;
+  mutex_lock l(*mu);
+  StepArenaAllocator*& arena = (*arenas)[allocator];
+  if (arena == nullptr) {
+    VLOG(1) << "Using StepArenaAllocator with memory limit of "
+            << (options.memory_limit_bytes >> 20) << " MB on top of "
+            << allocator->Name();
+    arena = new StepArenaAllocator(allocator, options);
+  }
+  return arena;
+}
+
+// Set while a kernel whose allocations may come from the step arena runs on
+// this thread. Everything else, e.g. constants allocated when a kernel is
+// created, eager ops and kernels that access state, uses the base allocator,
+// since its tensors are likely to outlive the step.
+thread_local bool step_arena_enabled = false;
+
+class ScopedStepArena {
+ public:
+  explicit ScopedStepArena(bool enabled) : previous_(step_arena_enabled) {
+    step_arena_enabled = enabled;
+  }
+  ~ScopedStepArena() { step_arena_enabled = previous_; }
+
+ private:
+  const bool previous_;
+};
+
+// Returns true if `op_kernel` runs as part of a graph step and does not touch
+// state that outlives the step, such as variables (including their
+// initializers), tables or queues.
+bool MayUseStepArena(const OpKernel& op_kernel,
+                     const OpKernelContext& context) {
+  // Eager ops run outside of any step, with a step id of zero.
+  if (context.step_id() == 0) return false;
+  for (DataType dtype : op_kernel.input_types()) {
+    if (IsRefType(dtype) || dtype == DT_RESOURCE) return false;
+  }
+  for (DataType dtype : op_kernel.output_types()) {
+    if (IsRefType(dtype) || dtype == DT_RESOURCE) return false;
+  }
+  return true;
+}
+}  // namespace
+
 ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
                                    const string& name, Bytes memory_limit,
                                    const DeviceLocality& locality,
@@ -60,7 +136,13 @@ ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
     : LocalDevice(options, Device::BuildDeviceAttributes(
                                name, DEVICE_CPU, memory_limit, locality)),
       allocator_(allocator),
+      step_arena_allocator_(MaybeGetStepArenaAllocator(allocator)),
       scoped_allocator_mgr_(new ScopedAllocatorMgr(name)) {
+  if (options.config.experimental().use_numa_affinity() &&
+      options.config.experimental().use_numa_inter_op_thread_pools()) {
+    set_tensorflow_device_thread_pool(
+        NumaComputePool(options, locality.numa_node()));
+  }
   auto s = NodeFileWriter::GetNodeFileWriterIfEnabled(name, env());
   if (!s.ok()) {
     LOG(ERROR) << s.status();
@@ -104,6 +186,12 @@ ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
 ThreadPoolDevice::~ThreadPoolDevice() {}
 
 Allocator* ThreadPoolDevice::GetAllocator(AllocatorAttributes attr) {
+  // Tensors that leave the device are likely to outlive the step, and could
+  // pin an arena chunk long after the step has finished.
+  if (step_arena_allocator_ != nullptr && step_arena_enabled &&
+      !attr.on_host() && !attr.nic_compatible() && !attr.gpu_compatible()) {
+    return step_arena_allocator_;
+  }
   return allocator_;
 }
 
@@ -181,7 +269,11 @@ void ThreadPoolDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
     LogInputs(op_kernel, context);
   }
 
-  op_kernel->Compute(context);
+  {
+    ScopedStepArena step_arena(step_arena_allocator_ != nullptr &&
+                               MayUseStepArena(*op_kernel, *context));
+    op_kernel->Compute(context);
+  }
 
   if (context->status().ok() && node_file_writer_) {
     Status s = node_file_writer_->RecordNodeExecution(op_kernel, context);
@@ -210,6 +302,10 @@ void ThreadPoolDevice::ComputeAsync(AsyncOpKernel* op_kernel,
     };
   }
 
+  // Allocations made by `done` or by other threads later on use the base
+  // allocator.
+  ScopedStepArena step_arena(step_arena_allocator_ != nullptr &&
+                             MayUseStepArena(*op_kernel, *context));
   op_kernel->ComputeAsync(context, done);
 }
 
@@ -19,10 +19,16 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/common_runtime/node_file_writer.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 
 namespace tensorflow {
 
 // CPU device implementation.
+//
+// If the environment variable TF_CPU_USE_STEP_ARENA_ALLOCATOR is true, tensors
+// that stay on this device are allocated from a StepArenaAllocator layered on
+// top of `allocator`, and tensors that are sent to another device or over the
+// network are allocated from `allocator` directly.
 class ThreadPoolDevice : public LocalDevice {
  public:
   ThreadPoolDevice(const SessionOptions& options, const string& name,
@@ -54,6 +60,9 @@ class ThreadPoolDevice : public LocalDevice {
   void LogOutputs(OpKernel* op_kernel, OpKernelContext* context);
 
   Allocator* allocator_;  // Not owned
+  // Null unless TF_CPU_USE_STEP_ARENA_ALLOCATOR is set. Not owned: tensors
+  // allocated from the arena may outlive this device.
+  StepArenaAllocator* step_arena_allocator_;
   std::unique_ptr<ScopedAllocatorMgr> scoped_allocator_mgr_;
   NodeFileWriter* node_file_writer_ = nullptr;  // not owned
 };
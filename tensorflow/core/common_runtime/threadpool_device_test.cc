@@ -68,5 +68,53 @@ TEST(ThreadPoolDeviceTest, CopyTensor) {
   device_context->Unref();
 }
 
+TEST(ThreadPoolDeviceTest, StepArenaIsNotUsedOutsideKernels) {
+  setenv("TF_CPU_USE_STEP_ARENA_ALLOCATOR", "1", /*overwrite=*/1);
+  ThreadPoolDevice device(SessionOptions(), "/device:CPU:0", Bytes(256),
+                          DeviceLocality(), cpu_allocator());
+  unsetenv("TF_CPU_USE_STEP_ARENA_ALLOCATOR");
+
+  // Constants and other tensors allocated when kernels are created outlive
+  // any single step.
+  EXPECT_EQ(device.GetAllocator(AllocatorAttributes()), cpu_allocator());
+  AllocatorAttributes on_host;
+  on_host.set_on_host(true);
+  EXPECT_EQ(device.GetAllocator(on_host), cpu_allocator());
+}
+
+TEST(ThreadPoolDeviceTest, NumaInterOpThreadPools) {
+  SessionOptions options;
+  ThreadPoolDevice default_device(options, "/device:CPU:0", Bytes(256),
+                                  DeviceLocality(), cpu_allocator());
+  EXPECT_EQ(default_device.tensorflow_device_thread_pool(), nullptr);
+
+  options.config.mutable_experimental()->set_use_numa_affinity(true);
+  options.config.mutable_experimental()->set_use_numa_inter_op_thread_pools(
+      true);
+  DeviceLocality node0;
+  node0.set_numa_node(0);
+  DeviceLocality node1;
+  node1.set_numa_node(1);
+  ThreadPoolDevice device0(options, "/device:CPU:1", Bytes(256), node0,
+                           cpu_allocator());
+  ThreadPoolDevice other_device0(options, "/device:CPU:2", Bytes(256), node0,
+                                 cpu_allocator());
+  ThreadPoolDevice device1(options, "/device:CPU:3", Bytes(256), node1,
+                           cpu_allocator());
+  // Devices on the same NUMA node share their inter op thread pool.
+  ASSERT_NE(device0.tensorflow_device_thread_pool(), nullptr);
+  EXPECT_EQ(device0.tensorflow_device_thread_pool(),
+            other_device0.tensorflow_device_thread_pool());
+  ASSERT_NE(device1.tensorflow_device_thread_pool(), nullptr);
+  EXPECT_NE(device0.tensorflow_device_thread_pool(),
+            device1.tensorflow_device_thread_pool());
+
+  Notification note;
+  device1.tensorflow_device_thread_pool()->Schedule([&note]() {
+    note.Notify();
+  });
+  note.WaitForNotification();
+}
+
 }  // namespace
 }  // namespace tensorflow
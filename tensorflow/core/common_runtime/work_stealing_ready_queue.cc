@@ -0,0 +1,153 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/work_stealing_ready_queue.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Number of scans over all shards that `Pop()` makes before it blocks.
+constexpr int kMaxScansBeforeWait = 16;
+
+// Each thread that touches a WorkStealingReadyQueue is given a small integer
+// slot, which is used to spread unrelated threads across the shards of a node.
+int ThreadSlot() {
+  static std::atomic<int> next_slot{0};
+  thread_local int slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+  return slot;
+}
+
+// The NUMA node the calling thread is pinned to, or -1. Looked up once per
+// thread, since querying the affinity is a system call.
+int ThreadNumaNode() {
+  thread_local int node = port::NUMAGetThreadNodeAffinity();
+  return node;
+}
+
+}  // namespace
+
+WorkStealingReadyQueue::WorkStealingReadyQueue(int num_numa_nodes,
+                                               int shards_per_node)
+    : num_numa_nodes_(num_numa_nodes > 0 ? num_numa_nodes
+                                         : std::max(1, port::NUMANumNodes())),
+      shards_per_node_(std::max(1, shards_per_node)) {
+  shards_.reserve(num_numa_nodes_ * shards_per_node_);
+  for (int i = 0; i < num_numa_nodes_ * shards_per_node_; ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+}
+
+int WorkStealingReadyQueue::LocalShard() const {
+  int node = ThreadNumaNode();
+  if (node < 0 || node >= num_numa_nodes_) node = 0;
+  return node * shards_per_node_ + ThreadSlot() % shards_per_node_;
+}
+
+void WorkStealingReadyQueue::Push(Task task) {
+  Shard* shard = shards_[LocalShard()].get();
+  {
+    mutex_lock l(shard->mu);
+    shard->tasks.push_back(std::move(task));
+  }
+  // Pairs with `Pop()`, which registers as a waiter before it checks
+  // `num_tasks_`: either the waiter sees this task, or we see the waiter.
+  num_tasks_.fetch_add(1, std::memory_order_seq_cst);
+  if (num_waiters_.load(std::memory_order_seq_cst) > 0) {
+    mutex_lock l(wait_mu_);
+    wait_cv_.notify_one();
+  }
+}
+
+bool WorkStealingReadyQueue::TryPopFrom(int shard_index, bool from_back,
+                                        Task* task) {
+  Shard* shard = shards_[shard_index].get();
+  mutex_lock l(shard->mu);
+  if (shard->tasks.empty()) return false;
+  if (from_back) {
+    *task = std::move(shard->tasks.back());
+    shard->tasks.pop_back();
+  } else {
+    *task = std::move(shard->tasks.front());
+    shard->tasks.pop_front();
+  }
+  num_tasks_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool WorkStealingReadyQueue::TryPop(int local, Task* task) {
+  const int local_node = NodeForShard(local);
+  const int num_shards = shards_.size();
+  // The most recently pushed local task is the one whose inputs are most
+  // likely to still be in this thread's cache.
+  if (TryPopFrom(local, /*from_back=*/true, task)) {
+    local_pops_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  // Steal the oldest task from the other shards of this node first, then
+  // from the shards on remote nodes.
+  for (int i = 1; i < num_shards; ++i) {
+    const int victim = (local + i) % num_shards;
+    if (NodeForShard(victim) != local_node) continue;
+    if (TryPopFrom(victim, /*from_back=*/false, task)) {
+      same_node_steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  for (int i = 1; i < num_shards; ++i) {
+    const int victim = (local + i) % num_shards;
+    if (NodeForShard(victim) == local_node) continue;
+    if (TryPopFrom(victim, /*from_back=*/false, task)) {
+      remote_node_steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+WorkStealingReadyQueue::Task WorkStealingReadyQueue::Pop() {
+  const int local = LocalShard();
+  Task task;
+  while (true) {
+    // Another popper may have taken the task we were matched with while we
+    // were scanning, in which case its own task is queued or about to be.
+    // Retry a few times, then wait for a push.
+    for (int i = 0; i < kMaxScansBeforeWait; ++i) {
+      if (TryPop(local, &task)) return task;
+    }
+    mutex_lock l(wait_mu_);
+    num_waiters_.fetch_add(1, std::memory_order_seq_cst);
+    while (num_tasks_.load(std::memory_order_seq_cst) <= 0) {
+      wait_cv_.wait(l);
+    }
+    num_waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+WorkStealingReadyQueue::Stats WorkStealingReadyQueue::GetStats() const {
+  Stats stats;
+  stats.local_pops = local_pops_.load(std::memory_order_relaxed);
+  stats.same_node_steals = same_node_steals_.load(std::memory_order_relaxed);
+  stats.remote_node_steals =
+      remote_node_steals_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace tensorflow
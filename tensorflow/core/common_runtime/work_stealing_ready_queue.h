@@ -0,0 +1,121 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// WorkStealingReadyQueue holds closures for ready nodes on behalf of the
+// "WORK_STEALING" executor. Instead of handing every expensive node straight to
+// `Executor::Args::runner`, the executor pushes the node into the shard that
+// belongs to the producing thread and then asks the runner to run a thunk that
+// pops *some* task from the queue. The thunk prefers the shard of the thread it
+// happens to run on (most recently pushed first, so the consumer is likely to
+// find its inputs in cache), then steals from other shards on the same NUMA
+// node, and only then from shards on remote NUMA nodes.
+//
+// Shards are grouped by NUMA node: there are `shards_per_node` shards for each
+// of `num_numa_nodes` nodes. A thread that is pinned to a NUMA node (e.g. a
+// thread started with `ThreadOptions::numa_node`) maps to a shard on that node;
+// unpinned threads are treated as living on node 0. A thread's node is looked
+// up the first time it uses a queue, so pinning a thread afterwards has no
+// effect.
+//
+// Every `Push()` must be matched by exactly one `Pop()`. Under that contract
+// `Pop()` never fails, because at least one task is available for every caller
+// waiting to pop. A `Pop()` that finds no task after a few scans blocks until
+// the next `Push()`.
+//
+// This class is thread-safe.
+class WorkStealingReadyQueue {
+ public:
+  typedef std::function<void()> Task;
+
+  struct Stats {
+    // Tasks popped from the calling thread's own shard.
+    int64_t local_pops = 0;
+    // Tasks stolen from another shard on the same NUMA node.
+    int64_t same_node_steals = 0;
+    // Tasks stolen from a shard on another NUMA node. On multi-socket machines
+    // this approximates cross-socket dispatch traffic.
+    int64_t remote_node_steals = 0;
+  };
+
+  // `num_numa_nodes <= 0` uses the value of `port::NUMANumNodes()`.
+  explicit WorkStealingReadyQueue(int num_numa_nodes = 0,
+                                  int shards_per_node = kDefaultShardsPerNode);
+
+  WorkStealingReadyQueue(const WorkStealingReadyQueue&) = delete;
+  void operator=(const WorkStealingReadyQueue&) = delete;
+
+  // Adds `task` to the shard local to the calling thread.
+  void Push(Task task);
+
+  // Removes and returns one task, preferring the shard local to the calling
+  // thread.
+  //
+  // REQUIRES: A `Push()` for which no `Pop()` has been issued yet.
+  Task Pop();
+
+  // Returns the shard the calling thread pushes to and pops from first.
+  int LocalShard() const;
+
+  int num_shards() const { return static_cast<int>(shards_.size()); }
+  int num_numa_nodes() const { return num_numa_nodes_; }
+
+  Stats GetStats() const;
+
+  static constexpr int kDefaultShardsPerNode = 4;
+
+ private:
+  struct alignas(64) Shard {
+    mutex mu;
+    std::deque<Task> tasks TF_GUARDED_BY(mu);
+  };
+
+  int NodeForShard(int shard) const { return shard / shards_per_node_; }
+  bool TryPopFrom(int shard, bool from_back, Task* task);
+  // Scans the shards once, starting with `local`.
+  bool TryPop(int local, Task* task);
+
+  const int num_numa_nodes_;
+  const int shards_per_node_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  // Number of tasks in all shards.
+  alignas(64) std::atomic<int64_t> num_tasks_{0};
+  // Number of `Pop()` callers blocked on `wait_cv_`.
+  std::atomic<int> num_waiters_{0};
+  mutex wait_mu_;
+  condition_variable wait_cv_;
+
+  alignas(64) std::atomic<int64_t> local_pops_{0};
+  std::atomic<int64_t> same_node_steals_{0};
+  std::atomic<int64_t> remote_node_steals_{0};
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUE_H_
@@ -0,0 +1,94 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/work_stealing_ready_queue.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingReadyQueueTest, LocalShardIsLastInFirstOut) {
+  WorkStealingReadyQueue queue(/*num_numa_nodes=*/1, /*shards_per_node=*/1);
+  std::vector<int> order;
+  for (int i = 0; i < 3; ++i) {
+    queue.Push([&order, i]() { order.push_back(i); });
+  }
+  for (int i = 0; i < 3; ++i) {
+    queue.Pop()();
+  }
+  EXPECT_EQ(order, std::vector<int>({2, 1, 0}));
+
+  WorkStealingReadyQueue::Stats stats = queue.GetStats();
+  EXPECT_EQ(stats.local_pops, 3);
+  EXPECT_EQ(stats.same_node_steals, 0);
+  EXPECT_EQ(stats.remote_node_steals, 0);
+}
+
+TEST(WorkStealingReadyQueueTest, ShardLayout) {
+  WorkStealingReadyQueue queue(/*num_numa_nodes=*/2, /*shards_per_node=*/3);
+  EXPECT_EQ(queue.num_numa_nodes(), 2);
+  EXPECT_EQ(queue.num_shards(), 6);
+  const int local = queue.LocalShard();
+  EXPECT_GE(local, 0);
+  EXPECT_LT(local, queue.num_shards());
+}
+
+TEST(WorkStealingReadyQueueTest, EveryTaskRunsOnceUnderContention) {
+  constexpr int kNumThreads = 8;
+  constexpr int kNumTasks = 10000;
+  WorkStealingReadyQueue queue(/*num_numa_nodes=*/2, /*shards_per_node=*/2);
+  thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+  std::vector<std::atomic<int>> runs(kNumTasks);
+  BlockingCounter done(kNumTasks);
+  for (int i = 0; i < kNumTasks; ++i) {
+    pool.Schedule([&, i]() {
+      queue.Push([&runs, &done, i]() {
+        runs[i].fetch_add(1);
+        done.DecrementCount();
+      });
+      pool.Schedule([&queue]() { queue.Pop()(); });
+    });
+  }
+  done.Wait();
+  for (int i = 0; i < kNumTasks; ++i) {
+    EXPECT_EQ(runs[i].load(), 1) << "task " << i;
+  }
+  WorkStealingReadyQueue::Stats stats = queue.GetStats();
+  EXPECT_EQ(stats.local_pops + stats.same_node_steals + stats.remote_node_steals,
+            kNumTasks);
+}
+
+TEST(WorkStealingReadyQueueTest, PopWaitsForPush) {
+  WorkStealingReadyQueue queue(/*num_numa_nodes=*/1, /*shards_per_node=*/2);
+  std::atomic<bool> ran{false};
+  std::unique_ptr<Thread> popper(Env::Default()->StartThread(
+      ThreadOptions(), "popper", [&queue]() { queue.Pop()(); }));
+  // Give the popper time to exhaust its scans and block.
+  Env::Default()->SleepForMicroseconds(10 * 1000);
+  EXPECT_FALSE(ran.load());
+  queue.Push([&ran]() { ran = true; });
+  popper.reset();
+  EXPECT_TRUE(ran.load());
+}
+
+}  // namespace
+}  // namespace tensorflow
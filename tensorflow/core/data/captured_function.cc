@@ -278,11 +278,21 @@ class CallFrameBase : public CallFrameInterface {
 
   size_t num_retvals() const override { return retvals_.size(); }
 
+  // Forwards the return values to `sink` instead of storing them. The values
+  // returned by `ConsumeRetvals()` are then empty.
+  void set_retval_sink(InstantiatedCapturedFunction::RetvalSink sink) {
+    retval_sink_ = std::move(sink);
+  }
+
   // Callee methods.
   Status SetRetval(int index, const Tensor& val) override {
     const int retvals_size = retvals_.size();
     if (index < retvals_size && val.dtype() == ret_types_[index] &&
         !retvals_[index]) {
+      if (retval_sink_) {
+        retvals_[index] = Tensor();
+        return retval_sink_(index, val);
+      }
       retvals_[index] = val;
       return absl::OkStatus();
     } else if (index >= retvals_size) {
@@ -302,6 +312,7 @@ class CallFrameBase : public CallFrameInterface {
  private:
   DataTypeSlice ret_types_;
   std::vector<std::optional<Tensor>> retvals_;
+  InstantiatedCapturedFunction::RetvalSink retval_sink_;
   CallFrameBase(const CallFrameBase&) = delete;
   void operator=(const CallFrameBase&) = delete;
 };
@@ -948,12 +959,34 @@ void InstantiatedCapturedFunction::RunAsync(
     CollectiveExecutor* collective_executor, std::vector<Tensor>&& args,
     std::vector<Tensor>* rets, FunctionLibraryRuntime::DoneCallback done,
     const std::shared_ptr<model::Node>& node) const {
+  RunAsyncInternal(std::move(runner), parent_cancellation_manager,
+                   collective_executor, std::move(args), rets,
+                   /*retval_sink=*/nullptr, std::move(done), node);
+}
+
+void InstantiatedCapturedFunction::RunAsyncInternal(
+    std::function<void(std::function<void()>)> runner,
+    CancellationManager* parent_cancellation_manager,
+    CollectiveExecutor* collective_executor, std::vector<Tensor>&& args,
+    std::vector<Tensor>* rets, RetvalSink retval_sink,
+    FunctionLibraryRuntime::DoneCallback done,
+    const std::shared_ptr<model::Node>& node) const {
   auto& info = captured_func_->short_circuit_info();
   if (!info.indices.empty()) {
     // Run the `done` callback on a threadpool thread, because it will
     // potentially do a non-trivial amount of (e.g. copying) work, and we may
     // want to run that concurrently with the next invocation.
-    Status s = RunShortCircuit(info, std::move(args), captured_func_, rets);
+    Status s;
+    if (retval_sink) {
+      std::vector<Tensor> short_circuit_rets;
+      s = RunShortCircuit(info, std::move(args), captured_func_,
+                          &short_circuit_rets);
+      for (int i = 0; s.ok() && i < short_circuit_rets.size(); ++i) {
+        s = retval_sink(i, short_circuit_rets[i]);
+      }
+    } else {
+      s = RunShortCircuit(info, std::move(args), captured_func_, rets);
+    }
     runner(
         std::bind([s](FunctionLibraryRuntime::DoneCallback& done) { done(s); },
                   std::move(done)));
@@ -965,6 +998,9 @@ void InstantiatedCapturedFunction::RunAsync(
   // code that may execute asynchronously in this function.
   OwnedArgsCallFrame* frame = new OwnedArgsCallFrame(
       std::move(args), &captured_func_->captured_inputs(), ret_types_);
+  if (retval_sink) {
+    frame->set_retval_sink(std::move(retval_sink));
+  }
 
   FunctionLibraryRuntime::Options f_opts;
   ResourceMgr* resource_mgr = lib_->device()->resource_manager();
@@ -999,8 +1035,13 @@ void InstantiatedCapturedFunction::RunAsync(
           Status s) {
         delete step_container;
         delete raw_cancellation_manager;
-        if (s.ok()) {
+        if (s.ok() && rets != nullptr) {
           s = frame->ConsumeRetvals(rets);
+        } else if (s.ok()) {
+          // The values were passed to the sink. This checks that all of them
+          // were set.
+          std::vector<Tensor> unused_rets;
+          s = frame->ConsumeRetvals(&unused_rets);
         }
         delete frame;
         if (node) {
@@ -302,11 +302,42 @@ class InstantiatedCapturedFunction {
                 FunctionLibraryRuntime::DoneCallback done,
                 const std::shared_ptr<model::Node>& node) const;
 
+  // Receives the return value at `index` of a function invocation. It may be
+  // called concurrently for different indices.
+  using RetvalSink = std::function<Status(int index, const Tensor& value)>;
+
+  // Like `RunAsync()`, but rather than storing the results, passes each of
+  // them to `retval_sink` as soon as the function produces it, and before
+  // `done` is called. This lets the caller copy a result into its final
+  // location (e.g. the slice of a preallocated batch) while the result is
+  // still cache-resident, without holding on to the result tensors until the
+  // whole function has returned. An error returned by `retval_sink` fails the
+  // invocation.
+  void RunAsyncWithRetvalSink(IteratorContext* ctx, std::vector<Tensor>&& args,
+                              RetvalSink retval_sink,
+                              FunctionLibraryRuntime::DoneCallback done,
+                              const std::shared_ptr<model::Node>& node) const {
+    RunAsyncInternal(*(ctx->runner()), ctx->cancellation_manager(),
+                     ctx->collective_executor(), std::move(args),
+                     /*rets=*/nullptr, std::move(retval_sink), std::move(done),
+                     node);
+  }
+
   std::string func_name() const { return captured_func_->func().name(); }
 
  private:
   friend class CapturedFunction;
 
+  // Implements `RunAsync()` and `RunAsyncWithRetvalSink()`. Exactly one of
+  // `rets` and `retval_sink` is set.
+  void RunAsyncInternal(std::function<void(std::function<void()>)> runner,
+                        CancellationManager* parent_cancellation_manager,
+                        CollectiveExecutor* collective_executor,
+                        std::vector<Tensor>&& args, std::vector<Tensor>* rets,
+                        RetvalSink retval_sink,
+                        FunctionLibraryRuntime::DoneCallback done,
+                        const std::shared_ptr<model::Node>& node) const;
+
   InstantiatedCapturedFunction(
       FunctionLibraryRuntime* lib, FunctionLibraryRuntime::Handle f_handle,
       DataTypeVector ret_types,
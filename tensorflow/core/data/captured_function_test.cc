@@ -0,0 +1,233 @@
+/* Copyright 2026 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/captured_function.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::tensorflow::test::function::NDef;
+
+// Creates the metadata of the function in its `f` attribute, which is how
+// dataset kernels set up their captured functions.
+class FunctionMetadataOp : public OpKernel {
+ public:
+  explicit FunctionMetadataOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, FunctionMetadata::Create(ctx, "f", /*params=*/{},
+                                                 &metadata_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {}
+
+  const std::shared_ptr<FunctionMetadata>& metadata() const {
+    return metadata_;
+  }
+
+ private:
+  std::shared_ptr<FunctionMetadata> metadata_;
+};
+
+REGISTER_OP("CapturedFunctionTestMetadata")
+    .Attr("f: func")
+    .SetShapeFn(shape_inference::NoOutputs);
+REGISTER_KERNEL_BUILDER(
+    Name("CapturedFunctionTestMetadata").Device(DEVICE_CPU),
+    FunctionMetadataOp);
+
+// Returns `x * 2` and `x * 4`.
+FunctionDef XTimesTwoAndFour() {
+  return FunctionDefHelper::Define(
+      // Name
+      "XTimesTwoAndFour",
+      // Args
+      {"x: int64"},
+      // Return values
+      {"y: int64", "z: int64"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"two"},
+        "Const",
+        {},
+        {{"value", test::AsScalar<int64_t>(2)}, {"dtype", DT_INT64}}},
+       {{"four"},
+        "Const",
+        {},
+        {{"value", test::AsScalar<int64_t>(4)}, {"dtype", DT_INT64}}},
+       {{"y"}, "Mul", {"x", "two"}, {{"T", DT_INT64}}},
+       {{"z"}, "Mul", {"x", "four"}, {{"T", DT_INT64}}}});
+}
+
+class CapturedFunctionTest : public DatasetOpsTestBase {
+ protected:
+  // Instantiates the function `func` of the library `func_lib`.
+  Status Instantiate(const FunctionDefHelper::AttrValueWrapper& func,
+                     const std::vector<FunctionDef>& func_lib,
+                     std::unique_ptr<InstantiatedCapturedFunction>* result) {
+    TF_RETURN_IF_ERROR(InitThreadPool(thread_num_));
+    TF_RETURN_IF_ERROR(InitFunctionLibraryRuntime(func_lib, cpu_num_));
+    TF_RETURN_IF_ERROR(CreateOpKernel(
+        NDef("metadata", "CapturedFunctionTestMetadata", {}, {{"f", func}}),
+        &metadata_kernel_));
+    TF_RETURN_IF_ERROR(
+        CreateOpKernelContext(metadata_kernel_.get(), &inputs_, &op_ctx_));
+    TF_RETURN_IF_ERROR(CapturedFunction::Create(
+        op_ctx_.get(),
+        static_cast<FunctionMetadataOp*>(metadata_kernel_.get())->metadata(),
+        /*captured_inputs=*/std::vector<Tensor>(), &captured_func_));
+    TF_RETURN_IF_ERROR(CreateIteratorContext(op_ctx_.get(), &iterator_ctx_));
+    return captured_func_->Instantiate(iterator_ctx_.get(), result);
+  }
+
+  // Runs `func` on `args`, passing its results to `retval_sink`, and returns
+  // the status of the invocation.
+  Status RunWithRetvalSink(
+      const InstantiatedCapturedFunction& func, std::vector<Tensor> args,
+      InstantiatedCapturedFunction::RetvalSink retval_sink) {
+    Notification done;
+    Status status;
+    func.RunAsyncWithRetvalSink(
+        iterator_ctx_.get(), std::move(args), std::move(retval_sink),
+        [&](const Status& s) {
+          status = s;
+          done.Notify();
+        },
+        /*node=*/nullptr);
+    done.WaitForNotification();
+    return status;
+  }
+
+  // Runs `func` on `args` with a sink that records every return value in
+  // `retvals`, and checks that no return value is passed twice.
+  Status RunWithRecordingSink(const InstantiatedCapturedFunction& func,
+                              std::vector<Tensor> args,
+                              absl::flat_hash_map<int, Tensor>* retvals) {
+    mutex mu;
+    return RunWithRetvalSink(
+        func, std::move(args), [&](int index, const Tensor& value) -> Status {
+          mutex_lock l(mu);
+          if (!retvals->emplace(index, value).second) {
+            return errors::Internal("Return value ", index,
+                                    " was passed to the sink twice.");
+          }
+          return absl::OkStatus();
+        });
+  }
+
+  std::unique_ptr<OpKernel> metadata_kernel_;
+  absl::InlinedVector<TensorValue, 4> inputs_;
+  std::unique_ptr<OpKernelContext> op_ctx_;
+  std::unique_ptr<CapturedFunction> captured_func_;
+  std::unique_ptr<IteratorContext> iterator_ctx_;
+};
+
+TEST_F(CapturedFunctionTest, SinkReceivesEveryRetval) {
+  std::unique_ptr<InstantiatedCapturedFunction> func;
+  TF_ASSERT_OK(Instantiate(FunctionDefHelper::FunctionRef("XTimesTwoAndFour"),
+                           {XTimesTwoAndFour()}, &func));
+  absl::flat_hash_map<int, Tensor> retvals;
+  TF_ASSERT_OK(RunWithRecordingSink(
+      *func, {test::AsScalar<int64_t>(3)}, &retvals));
+  ASSERT_EQ(retvals.size(), 2);
+  test::ExpectEqual(retvals[0], test::AsScalar<int64_t>(6));
+  test::ExpectEqual(retvals[1], test::AsScalar<int64_t>(12));
+}
+
+TEST_F(CapturedFunctionTest, SinkReceivesEveryRetvalOfShortCircuit) {
+  std::unique_ptr<InstantiatedCapturedFunction> func;
+  TF_ASSERT_OK(Instantiate(
+      FunctionDefHelper::FunctionRef("Swap", {{"T", DT_FLOAT}}),
+      {test::function::Swap()}, &func));
+  absl::flat_hash_map<int, Tensor> retvals;
+  TF_ASSERT_OK(RunWithRecordingSink(
+      *func, {test::AsScalar<float>(1.0), test::AsScalar<float>(2.0)},
+      &retvals));
+  ASSERT_EQ(retvals.size(), 2);
+  test::ExpectEqual(retvals[0], test::AsScalar<float>(2.0));
+  test::ExpectEqual(retvals[1], test::AsScalar<float>(1.0));
+}
+
+TEST_F(CapturedFunctionTest, SinkErrorFailsInvocation) {
+  std::unique_ptr<InstantiatedCapturedFunction> func;
+  TF_ASSERT_OK(Instantiate(FunctionDefHelper::FunctionRef("XTimesTwoAndFour"),
+                           {XTimesTwoAndFour()}, &func));
+  Status status = RunWithRetvalSink(
+      *func, {test::AsScalar<int64_t>(3)},
+      [](int index, const Tensor& value) -> Status {
+        if (index == 1) {
+          return errors::Aborted("Cannot store return value ", index);
+        }
+        return absl::OkStatus();
+      });
+  EXPECT_EQ(status.code(), absl::StatusCode::kAborted);
+}
+
+TEST_F(CapturedFunctionTest, SinkErrorFailsShortCircuit) {
+  std::unique_ptr<InstantiatedCapturedFunction> func;
+  TF_ASSERT_OK(Instantiate(
+      FunctionDefHelper::FunctionRef("Swap", {{"T", DT_FLOAT}}),
+      {test::function::Swap()}, &func));
+  int num_calls = 0;
+  Status status = RunWithRetvalSink(
+      *func, {test::AsScalar<float>(1.0), test::AsScalar<float>(2.0)},
+      [&num_calls](int index, const Tensor& value) -> Status {
+        ++num_calls;
+        return errors::Aborted("Cannot store return value ", index);
+      });
+  EXPECT_EQ(status.code(), absl::StatusCode::kAborted);
+  // The short circuit stops at the first failure.
+  EXPECT_EQ(num_calls, 1);
+}
+
+TEST_F(CapturedFunctionTest, RunAsyncStillStoresRetvals) {
+  std::unique_ptr<InstantiatedCapturedFunction> func;
+  TF_ASSERT_OK(Instantiate(FunctionDefHelper::FunctionRef("XTimesTwoAndFour"),
+                           {XTimesTwoAndFour()}, &func));
+  std::vector<Tensor> rets;
+  Notification done;
+  Status status;
+  func->RunAsync(
+      iterator_ctx_.get(), {test::AsScalar<int64_t>(3)}, &rets,
+      [&](const Status& s) {
+        status = s;
+        done.Notify();
+      },
+      /*node=*/nullptr);
+  done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  ASSERT_EQ(rets.size(), 2);
+  test::ExpectEqual(rets[0], test::AsScalar<int64_t>(6));
+  test::ExpectEqual(rets[1], test::AsScalar<int64_t>(12));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
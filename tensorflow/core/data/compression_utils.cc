@@ -14,18 +14,28 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/compression_utils.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
+#include "zstd.h"
 
 namespace tensorflow {
 namespace data {
@@ -34,7 +44,234 @@ namespace {
 // Increment this when making changes to the `CompressedElement` proto. The
 // `UncompressElement` function will determine what to read according to the
 // version.
-constexpr int kCompressedElementVersion = 0;
+//
+// Version 1 adds the codec and the chunks. Elements that do not use them are
+// still written as version 0, so that older readers can read them.
+constexpr int kCompressedElementVersion = 1;
+
+// A range of the uncompressed bytes of an element.
+struct Chunk {
+  size_t offset;
+  size_t num_bytes;
+};
+
+// Splits `num_bytes` bytes into chunks of `chunk_bytes` bytes, the last of
+// which may be smaller. Returns a single chunk if `chunk_bytes` is zero.
+std::vector<Chunk> SplitIntoChunks(size_t num_bytes, size_t chunk_bytes) {
+  if (chunk_bytes == 0 || num_bytes <= chunk_bytes) {
+    return {{0, num_bytes}};
+  }
+  std::vector<Chunk> chunks;
+  chunks.reserve((num_bytes + chunk_bytes - 1) / chunk_bytes);
+  for (size_t offset = 0; offset < num_bytes; offset += chunk_bytes) {
+    chunks.push_back({offset, std::min(chunk_bytes, num_bytes - offset)});
+  }
+  return chunks;
+}
+
+// Returns the iovecs that cover `chunk` of the bytes pointed to by `iov`.
+std::vector<iovec> SliceIov(const iovec* iov, size_t num_pieces,
+                            const Chunk& chunk) {
+  std::vector<iovec> slice;
+  size_t piece_offset = 0;
+  const size_t chunk_end = chunk.offset + chunk.num_bytes;
+  for (size_t i = 0; i < num_pieces && piece_offset < chunk_end; ++i) {
+    const size_t piece_end = piece_offset + iov[i].iov_len;
+    const size_t begin = std::max(piece_offset, chunk.offset);
+    const size_t end = std::min(piece_end, chunk_end);
+    if (begin < end) {
+      iovec piece;
+      piece.iov_base =
+          static_cast<char*>(iov[i].iov_base) + (begin - piece_offset);
+      piece.iov_len = end - begin;
+      slice.push_back(piece);
+    }
+    piece_offset = piece_end;
+  }
+  return slice;
+}
+
+thread::ThreadPool* CompressionThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "tf_data_compression", port::MaxParallelism());
+  return pool;
+}
+
+// Runs `fn` on each of the `num_chunks` chunks in parallel, and returns the
+// first error it encounters.
+Status ForEachChunk(size_t num_chunks,
+                    const std::function<Status(size_t)>& fn) {
+  if (num_chunks == 1) {
+    return fn(0);
+  }
+  std::vector<Status> statuses(num_chunks);
+  BlockingCounter counter(num_chunks - 1);
+  for (size_t i = 1; i < num_chunks; ++i) {
+    CompressionThreadPool()->Schedule([&fn, &statuses, &counter, i]() {
+      statuses[i] = fn(i);
+      counter.DecrementCount();
+    });
+  }
+  statuses[0] = fn(0);
+  counter.Wait();
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
+Status ZstdCompress(const std::vector<iovec>& iov, size_t num_bytes, int level,
+                    std::string* out) {
+  std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx(ZSTD_createCCtx(),
+                                                            ZSTD_freeCCtx);
+  if (cctx == nullptr) {
+    return errors::ResourceExhausted(
+        "Failed to create zstd compression context.");
+  }
+  size_t result =
+      ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, level);
+  if (ZSTD_isError(result)) {
+    return errors::InvalidArgument("Invalid zstd compression level ", level,
+                                   ": ", ZSTD_getErrorName(result));
+  }
+  result = ZSTD_CCtx_setPledgedSrcSize(cctx.get(), num_bytes);
+  if (ZSTD_isError(result)) {
+    return errors::Internal("Failed to compress using zstd: ",
+                            ZSTD_getErrorName(result));
+  }
+  out->resize(ZSTD_compressBound(num_bytes));
+  ZSTD_outBuffer output = {out->data(), out->size(), 0};
+  for (const iovec& piece : iov) {
+    ZSTD_inBuffer input = {piece.iov_base, piece.iov_len, 0};
+    while (input.pos < input.size) {
+      result =
+          ZSTD_compressStream2(cctx.get(), &output, &input, ZSTD_e_continue);
+      if (ZSTD_isError(result)) {
+        return errors::Internal("Failed to compress using zstd: ",
+                                ZSTD_getErrorName(result));
+      }
+      if (input.pos < input.size && output.pos == output.size) {
+        return errors::Internal("Exceeded the zstd compression bound.");
+      }
+    }
+  }
+  ZSTD_inBuffer end = {nullptr, 0, 0};
+  do {
+    result = ZSTD_compressStream2(cctx.get(), &output, &end, ZSTD_e_end);
+    if (ZSTD_isError(result)) {
+      return errors::Internal("Failed to compress using zstd: ",
+                              ZSTD_getErrorName(result));
+    }
+    if (result != 0 && output.pos == output.size) {
+      return errors::Internal("Exceeded the zstd compression bound.");
+    }
+  } while (result != 0);
+  out->resize(output.pos);
+  return absl::OkStatus();
+}
+
+Status ZstdUncompress(absl::string_view compressed,
+                      const std::vector<iovec>& iov) {
+  std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx(ZSTD_createDCtx(),
+                                                            ZSTD_freeDCtx);
+  if (dctx == nullptr) {
+    return errors::ResourceExhausted(
+        "Failed to create zstd decompression context.");
+  }
+  ZSTD_inBuffer input = {compressed.data(), compressed.size(), 0};
+  // `ZSTD_decompressStream` returns 0 once it has decoded the whole frame.
+  size_t result = 1;
+  for (const iovec& piece : iov) {
+    ZSTD_outBuffer output = {piece.iov_base, piece.iov_len, 0};
+    while (output.pos < output.size) {
+      const size_t input_pos = input.pos;
+      const size_t output_pos = output.pos;
+      result = ZSTD_decompressStream(dctx.get(), &output, &input);
+      if (ZSTD_isError(result)) {
+        return errors::Internal("Failed to perform zstd decompression: ",
+                                ZSTD_getErrorName(result));
+      }
+      if (output.pos < output.size &&
+          (result == 0 ||
+           (input.pos == input_pos && output.pos == output_pos))) {
+        return errors::Internal(
+            "Uncompressed size mismatch. The zstd data is shorter than the "
+            "tensor metadata suggests.");
+      }
+    }
+  }
+  // Consume the end of the frame, which must not hold more data.
+  while (result != 0) {
+    const size_t input_pos = input.pos;
+    ZSTD_outBuffer output = {nullptr, 0, 0};
+    result = ZSTD_decompressStream(dctx.get(), &output, &input);
+    if (ZSTD_isError(result)) {
+      return errors::Internal("Failed to perform zstd decompression: ",
+                              ZSTD_getErrorName(result));
+    }
+    if (result != 0 && input.pos == input_pos) {
+      return errors::Internal(
+          "Uncompressed size mismatch. The zstd data is longer than the "
+          "tensor metadata suggests.");
+    }
+  }
+  if (input.pos != input.size) {
+    return errors::Internal("Found ", input.size - input.pos,
+                            " unexpected bytes after the zstd frame.");
+  }
+  return absl::OkStatus();
+}
+
+Status CompressChunk(const std::vector<iovec>& iov, size_t num_bytes,
+                     const CompressionOptions& options, std::string* out) {
+  switch (options.codec) {
+    case CompressedElement::CODEC_SNAPPY:
+      if (num_bytes > kuint32max) {
+        return errors::OutOfRange("Encountered dataset element of size ",
+                                  num_bytes,
+                                  ", exceeding the 4GB Snappy limit.");
+      }
+      if (!port::Snappy_CompressFromIOVec(iov.data(), num_bytes, out)) {
+        return errors::Internal("Failed to compress using snappy.");
+      }
+      return absl::OkStatus();
+    case CompressedElement::CODEC_ZSTD:
+      return ZstdCompress(iov, num_bytes, options.zstd_level, out);
+    default:
+      return errors::InvalidArgument("Unsupported compression codec: ",
+                                     options.codec);
+  }
+}
+
+Status UncompressChunk(CompressedElement::Codec codec,
+                       absl::string_view compressed,
+                       const std::vector<iovec>& iov, size_t num_bytes) {
+  switch (codec) {
+    case CompressedElement::CODEC_SNAPPY: {
+      size_t uncompressed_size;
+      if (!port::Snappy_GetUncompressedLength(
+              compressed.data(), compressed.size(), &uncompressed_size)) {
+        return errors::Internal(
+            "Could not get snappy uncompressed length. Compressed data size: ",
+            compressed.size());
+      }
+      if (uncompressed_size != num_bytes) {
+        return errors::Internal(
+            "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
+            " whereas the tensor metadata suggests ", num_bytes);
+      }
+      if (!port::Snappy_UncompressToIOVec(compressed.data(), compressed.size(),
+                                          iov.data(), iov.size())) {
+        return errors::Internal("Failed to perform snappy decompression.");
+      }
+      return absl::OkStatus();
+    }
+    case CompressedElement::CODEC_ZSTD:
+      return ZstdUncompress(compressed, iov);
+    default:
+      return errors::Internal("Unsupported compression codec: ", codec);
+  }
+}
 
 }  // namespace
 
@@ -63,6 +300,12 @@ class Iov {
 
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out) {
+  return CompressElement(element, CompressionOptions(), out);
+}
+
+Status CompressElement(const std::vector<Tensor>& element,
+                       const CompressionOptions& options,
+                       CompressedElement* out) {
   // First pass: preprocess the non`memcpy`able tensors.
   size_t num_string_tensors = 0;
   size_t num_string_tensor_strings = 0;
@@ -120,16 +363,35 @@ Status CompressElement(const std::vector<Tensor>& element,
     }
   }
 
-  if (iov.NumBytes() > kuint32max) {
-    return errors::OutOfRange("Encountered dataset element of size ",
-                              iov.NumBytes(),
-                              ", exceeding the 4GB Snappy limit.");
-  }
-  if (!port::Snappy_CompressFromIOVec(iov.Data(), iov.NumBytes(),
-                                      out->mutable_data())) {
-    return errors::Internal("Failed to compress using snappy.");
+  const std::vector<Chunk> chunks = SplitIntoChunks(
+      iov.NumBytes(), std::max<int64_t>(options.chunk_bytes, 0));
+  if (chunks.size() == 1) {
+    TF_RETURN_IF_ERROR(CompressChunk(
+        SliceIov(iov.Data(), iov.NumPieces(), chunks[0]), iov.NumBytes(),
+        options, out->mutable_data()));
+  } else {
+    std::vector<std::string> compressed_chunks(chunks.size());
+    TF_RETURN_IF_ERROR(ForEachChunk(chunks.size(), [&](size_t i) {
+      return CompressChunk(SliceIov(iov.Data(), iov.NumPieces(), chunks[i]),
+                           chunks[i].num_bytes, options,
+                           &compressed_chunks[i]);
+    }));
+    size_t compressed_bytes = 0;
+    for (const std::string& compressed_chunk : compressed_chunks) {
+      compressed_bytes += compressed_chunk.size();
+    }
+    std::string* data = out->mutable_data();
+    data->reserve(compressed_bytes);
+    for (const std::string& compressed_chunk : compressed_chunks) {
+      data->append(compressed_chunk);
+      out->add_chunk_compressed_bytes(compressed_chunk.size());
+    }
+    out->set_chunk_uncompressed_bytes(chunks[0].num_bytes);
   }
-  out->set_version(kCompressedElementVersion);
+  out->set_codec(options.codec);
+  const bool uses_version_1_fields =
+      options.codec != CompressedElement::CODEC_SNAPPY || chunks.size() > 1;
+  out->set_version(uses_version_1_fields ? kCompressedElementVersion : 0);
   VLOG(3) << "Compressed element from " << iov.NumBytes() << " bytes to "
           << out->data().size() << " bytes";
   return absl::OkStatus();
@@ -137,7 +399,8 @@ Status CompressElement(const std::vector<Tensor>& element,
 
 Status UncompressElement(const CompressedElement& compressed,
                          std::vector<Tensor>* out) {
-  if (compressed.version() != kCompressedElementVersion) {
+  if (compressed.version() < 0 ||
+      compressed.version() > kCompressedElementVersion) {
     return errors::Internal("Unsupported compressed element version: ",
                             compressed.version());
   }
@@ -189,25 +452,43 @@ Status UncompressElement(const CompressedElement& compressed,
     }
   }
 
-  // Step 2: Uncompress into the iovec.
+  // Step 2: Uncompress into the iovec, one chunk at a time.
   const std::string& compressed_data = compressed.data();
-  size_t uncompressed_size;
-  if (!port::Snappy_GetUncompressedLength(
-          compressed_data.data(), compressed_data.size(), &uncompressed_size)) {
-    return errors::Internal(
-        "Could not get snappy uncompressed length. Compressed data size: ",
-        compressed_data.size());
-  }
-  if (uncompressed_size != static_cast<size_t>(iov.NumBytes())) {
-    return errors::Internal(
-        "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
-        " whereas the tensor metadata suggests ", iov.NumBytes());
-  }
-  if (!port::Snappy_UncompressToIOVec(compressed_data.data(),
-                                      compressed_data.size(), iov.Data(),
-                                      iov.NumPieces())) {
-    return errors::Internal("Failed to perform snappy decompression.");
+  std::vector<Chunk> chunks;
+  std::vector<absl::string_view> compressed_chunks;
+  if (compressed.chunk_compressed_bytes().empty()) {
+    chunks.push_back({0, iov.NumBytes()});
+    compressed_chunks.push_back(compressed_data);
+  } else {
+    const uint64_t chunk_bytes = compressed.chunk_uncompressed_bytes();
+    const uint64_t num_chunks =
+        chunk_bytes == 0 ? 0 : (iov.NumBytes() + chunk_bytes - 1) / chunk_bytes;
+    if (num_chunks !=
+        static_cast<uint64_t>(compressed.chunk_compressed_bytes_size())) {
+      return errors::Internal(
+          "Chunk count mismatch. The compressed element has ",
+          compressed.chunk_compressed_bytes_size(),
+          " chunks whereas the tensor metadata suggests ", num_chunks);
+    }
+    chunks = SplitIntoChunks(iov.NumBytes(), chunk_bytes);
+    size_t offset = 0;
+    for (uint64_t chunk_compressed_bytes :
+         compressed.chunk_compressed_bytes()) {
+      if (chunk_compressed_bytes > compressed_data.size() - offset) {
+        return errors::Internal(
+            "Compressed chunks exceed the compressed data size of ",
+            compressed_data.size());
+      }
+      compressed_chunks.push_back(absl::string_view(compressed_data)
+                                      .substr(offset, chunk_compressed_bytes));
+      offset += chunk_compressed_bytes;
+    }
   }
+  TF_RETURN_IF_ERROR(ForEachChunk(chunks.size(), [&](size_t i) {
+    return UncompressChunk(compressed.codec(), compressed_chunks[i],
+                           SliceIov(iov.Data(), iov.NumPieces(), chunks[i]),
+                           chunks[i].num_bytes);
+  }));
 
   // Third pass: deserialize nonstring, non`memcpy`able tensors.
   nonmemcpyable_pos = nonmemcpyable.mdata();
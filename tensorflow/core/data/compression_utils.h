@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_COMPRESSION_UTILS_H_
 #define TENSORFLOW_CORE_DATA_COMPRESSION_UTILS_H_
 
+#include <cstdint>
 #include <vector>
 
 #include "tensorflow/core/framework/dataset.pb.h"
@@ -24,13 +25,28 @@ limitations under the License.
 namespace tensorflow {
 namespace data {
 
+struct CompressionOptions {
+  // Codec used to compress the element.
+  CompressedElement::Codec codec = CompressedElement::CODEC_SNAPPY;
+  // Compression level used by the zstd codec.
+  int zstd_level = 3;
+  // If positive, elements with more than this many uncompressed bytes are
+  // split into chunks of this size, which are compressed and uncompressed in
+  // parallel.
+  int64_t chunk_bytes = 0;
+};
+
 // Compresses the components of `element` into the `CompressedElement` proto.
 //
 // In addition to writing the actual compressed bytes, `Compress` fills
 // out the per-component metadata for the `CompressedElement`.
 //
-// Returns an error if the uncompressed size of the element exceeds 4GB.
+// Returns an error if snappy is used and the uncompressed size of the element,
+// or of one of its chunks, exceeds 4GB.
+Status CompressElement(const std::vector<Tensor>& element,
+                       CompressedElement* out);
 Status CompressElement(const std::vector<Tensor>& element,
+                       const CompressionOptions& options,
                        CompressedElement* out);
 
 // Uncompresses a `CompressedElement` into a vector of tensor components.
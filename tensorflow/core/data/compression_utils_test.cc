@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/compression_utils.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -39,6 +40,42 @@ TEST(CompressionUtilsTest, Exceeds4GB) {
                        HasSubstr("exceeding the 4GB Snappy limit")));
 }
 
+TEST(CompressionUtilsTest, SplitsIntoChunks) {
+  std::vector<Tensor> element = {CreateTensor<int64_t>(TensorShape{100})};
+  CompressionOptions options;
+  options.codec = CompressedElement::CODEC_ZSTD;
+  options.chunk_bytes = 300;
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, options, &compressed));
+  EXPECT_EQ(compressed.chunk_compressed_bytes_size(), 3);
+  EXPECT_EQ(compressed.chunk_uncompressed_bytes(), 300);
+  EXPECT_EQ(1, compressed.version());
+}
+
+TEST(CompressionUtilsTest, ChunkCountMismatch) {
+  std::vector<Tensor> element = {CreateTensor<int64_t>(TensorShape{100})};
+  CompressionOptions options;
+  options.chunk_bytes = 300;
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, options, &compressed));
+  compressed.set_chunk_uncompressed_bytes(200);
+  std::vector<Tensor> round_trip_element;
+  EXPECT_THAT(UncompressElement(compressed, &round_trip_element),
+              StatusIs(error::INTERNAL, HasSubstr("Chunk count mismatch")));
+}
+
+TEST(CompressionUtilsTest, TruncatedZstdData) {
+  std::vector<Tensor> element = {CreateTensor<int64_t>(TensorShape{100})};
+  CompressionOptions options;
+  options.codec = CompressedElement::CODEC_ZSTD;
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, options, &compressed));
+  compressed.mutable_data()->resize(compressed.data().size() / 2);
+  std::vector<Tensor> round_trip_element;
+  EXPECT_THAT(UncompressElement(compressed, &round_trip_element),
+              StatusIs(error::INTERNAL));
+}
+
 std::vector<std::vector<Tensor>> TestCases() {
   return {
       // Single int64.
@@ -98,12 +135,43 @@ TEST_P(ParameterizedCompressionUtilsTest, VersionMismatch) {
   CompressedElement compressed;
   TF_ASSERT_OK(CompressElement(element, &compressed));
 
-  compressed.set_version(1);
+  compressed.set_version(2);
   std::vector<Tensor> round_trip_element;
   EXPECT_THAT(UncompressElement(compressed, &round_trip_element),
               StatusIs(error::INTERNAL));
 }
 
+TEST_P(ParameterizedCompressionUtilsTest, ZstdRoundTrip) {
+  std::vector<Tensor> element = GetParam();
+  CompressionOptions options;
+  options.codec = CompressedElement::CODEC_ZSTD;
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, options, &compressed));
+  EXPECT_EQ(1, compressed.version());
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  TF_EXPECT_OK(
+      ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+}
+
+TEST_P(ParameterizedCompressionUtilsTest, ChunkedRoundTrip) {
+  std::vector<Tensor> element = GetParam();
+  for (auto codec :
+       {CompressedElement::CODEC_SNAPPY, CompressedElement::CODEC_ZSTD}) {
+    for (int64_t chunk_bytes : {5, 4096}) {
+      CompressionOptions options;
+      options.codec = codec;
+      options.chunk_bytes = chunk_bytes;
+      CompressedElement compressed;
+      TF_ASSERT_OK(CompressElement(element, options, &compressed));
+      std::vector<Tensor> round_trip_element;
+      TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+      TF_EXPECT_OK(
+          ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+    }
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(Instantiation, ParameterizedCompressionUtilsTest,
                          ::testing::ValuesIn(TestCases()));
 
@@ -0,0 +1,49 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Writes the sidecar record index of each uncompressed TFRecord file given on
+// the command line, which allows TFRecordDataset to read the file in any order
+// (e.g. under `tf.data.experimental.global_shuffle`).
+//
+// Usage: generate_tfrecord_index <file>...
+
+#include <string>
+
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+
+int main(int argc, char** argv) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  if (argc < 2) {
+    LOG(ERROR) << "Usage: " << argv[0] << " <file>...";
+    return 1;
+  }
+  int exit_code = 0;
+  for (int i = 1; i < argc; ++i) {
+    const std::string filename = argv[i];
+    absl::Status s = tensorflow::io::WriteRecordIndexFile(
+        tensorflow::Env::Default(), filename);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to index " << filename << ": " << s;
+      exit_code = 1;
+      continue;
+    }
+    LOG(INFO) << "Wrote "
+              << tensorflow::io::RecordIndex::IndexFileName(filename);
+  }
+  return exit_code;
+}
@@ -0,0 +1,344 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/indexed_cache_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kFileSuffix[] = ".icache";
+constexpr char kMagic[] = "TFDCACHE";
+constexpr size_t kMagicSize = 8;
+constexpr uint32_t kVersion = 1;
+// Magic, version, reserved, number of components.
+constexpr uint64_t kHeaderSize = kMagicSize + 4 + 4 + 8;
+// Index offset, number of elements, magic.
+constexpr uint64_t kFooterSize = 8 + 8 + kMagicSize;
+
+// How the payload of a component is encoded.
+enum Encoding : uint32_t {
+  // The bytes of a memcpy-able tensor.
+  kRaw = 0,
+  // A serialized `TensorProto`.
+  kTensorProto = 1,
+};
+
+uint64_t AlignUp(uint64_t offset) {
+  const uint64_t alignment = IndexedCacheFileWriter::kAlignment;
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// A tensor buffer that aliases part of a memory region. It keeps the region
+// alive, and reports that it does not own its memory so that kernels never
+// forward it to an output and write to the (read-only) mapping.
+class RegionTensorBuffer : public TensorBuffer {
+ public:
+  RegionTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("IndexedCacheFile");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
+// Holds the contents of a file that could not be memory-mapped.
+class StringMemoryRegion : public ReadOnlyMemoryRegion {
+ public:
+  explicit StringMemoryRegion(std::string data) : data_(std::move(data)) {}
+
+  const void* data() override { return data_.data(); }
+  uint64 length() override { return data_.size(); }
+
+ private:
+  const std::string data_;
+};
+
+}  // namespace
+
+std::string IndexedCacheFilename(absl::string_view prefix) {
+  return absl::StrCat(prefix, kFileSuffix);
+}
+
+IndexedCacheFileWriter::IndexedCacheFileWriter(Env* env, std::string filename,
+                                               int64_t num_components)
+    : env_(env),
+      filename_(std::move(filename)),
+      num_components_(num_components) {
+  status_ = Initialize();
+}
+
+absl::Status IndexedCacheFileWriter::Initialize() {
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(filename_, &file_));
+  std::string header(kMagic, kMagicSize);
+  core::PutFixed32(&header, kVersion);
+  core::PutFixed32(&header, 0);
+  core::PutFixed64(&header, num_components_);
+  TF_RETURN_IF_ERROR(Append(header));
+  return Pad();
+}
+
+absl::Status IndexedCacheFileWriter::Add(const std::vector<Tensor>& element) {
+  TF_RETURN_IF_ERROR(status_);
+  if (element.size() != num_components_) {
+    return errors::InvalidArgument("Expected an element with ", num_components_,
+                                   " components, got ", element.size());
+  }
+  const uint64_t offset = offset_;
+  for (const Tensor& tensor : element) {
+    status_ = AddComponent(tensor);
+    TF_RETURN_IF_ERROR(status_);
+  }
+  offsets_.push_back(offset);
+  return absl::OkStatus();
+}
+
+absl::Status IndexedCacheFileWriter::AddComponent(const Tensor& tensor) {
+  const bool raw = DataTypeCanUseMemcpy(tensor.dtype());
+  std::string payload;
+  if (!raw) {
+    TensorProto proto;
+    tensor.AsProtoTensorContent(&proto);
+    if (!proto.SerializeToString(&payload)) {
+      return errors::Internal("Failed to serialize tensor of type ",
+                              DataTypeString(tensor.dtype()));
+    }
+  }
+  const absl::string_view data = raw ? tensor.tensor_data() : payload;
+  std::string header;
+  core::PutFixed32(&header, tensor.dtype());
+  core::PutFixed32(&header, raw ? kRaw : kTensorProto);
+  core::PutFixed32(&header, tensor.dims());
+  core::PutFixed32(&header, 0);
+  for (int i = 0; i < tensor.dims(); ++i) {
+    core::PutFixed64(&header, tensor.dim_size(i));
+  }
+  core::PutFixed64(&header, data.size());
+  TF_RETURN_IF_ERROR(Append(header));
+  TF_RETURN_IF_ERROR(Pad());
+  TF_RETURN_IF_ERROR(Append(data));
+  return Pad();
+}
+
+absl::Status IndexedCacheFileWriter::Finish() {
+  TF_RETURN_IF_ERROR(status_);
+  std::string index;
+  index.reserve(offsets_.size() * 8 + kFooterSize);
+  const uint64_t index_offset = offset_;
+  for (uint64_t offset : offsets_) {
+    core::PutFixed64(&index, offset);
+  }
+  core::PutFixed64(&index, index_offset);
+  core::PutFixed64(&index, offsets_.size());
+  index.append(kMagic, kMagicSize);
+  status_ = Append(index);
+  TF_RETURN_IF_ERROR(status_);
+  status_ = file_->Close();
+  TF_RETURN_IF_ERROR(status_);
+  // Later calls fail instead of writing to a closed file.
+  status_ = errors::FailedPrecondition("Cache file ", filename_,
+                                       " has already been finished.");
+  return absl::OkStatus();
+}
+
+absl::Status IndexedCacheFileWriter::Append(absl::string_view data) {
+  TF_RETURN_IF_ERROR(file_->Append(data));
+  offset_ += data.size();
+  return absl::OkStatus();
+}
+
+absl::Status IndexedCacheFileWriter::Pad() {
+  static constexpr char kZeros[kAlignment] = {0};
+  return Append(absl::string_view(kZeros, AlignUp(offset_) - offset_));
+}
+
+absl::StatusOr<std::unique_ptr<IndexedCacheFileReader>>
+IndexedCacheFileReader::Open(Env* env, const std::string& filename) {
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  absl::Status s = env->NewReadOnlyMemoryRegionFromFile(filename, &region);
+  if (absl::IsUnimplemented(s)) {
+    std::string contents;
+    TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &contents));
+    region = std::make_unique<StringMemoryRegion>(std::move(contents));
+  } else {
+    TF_RETURN_IF_ERROR(s);
+  }
+  std::unique_ptr<IndexedCacheFileReader> reader(
+      new IndexedCacheFileReader(filename, std::move(region)));
+  TF_RETURN_IF_ERROR(reader->ReadFooter());
+  return reader;
+}
+
+IndexedCacheFileReader::IndexedCacheFileReader(
+    std::string filename, std::shared_ptr<ReadOnlyMemoryRegion> region)
+    : filename_(std::move(filename)),
+      region_(std::move(region)),
+      data_(static_cast<const char*>(region_->data())),
+      size_(region_->length()) {}
+
+absl::Status IndexedCacheFileReader::ReadFooter() {
+  if (size_ < kHeaderSize + kFooterSize ||
+      memcmp(data_, kMagic, kMagicSize) != 0 ||
+      memcmp(data_ + size_ - kMagicSize, kMagic, kMagicSize) != 0) {
+    return errors::DataLoss(filename_, " is not a complete cache file.");
+  }
+  const uint32_t version = core::DecodeFixed32(data_ + kMagicSize);
+  if (version != kVersion) {
+    return errors::DataLoss("Unsupported version ", version, " of cache file ",
+                            filename_);
+  }
+  num_components_ = core::DecodeFixed64(data_ + kMagicSize + 8);
+  const char* footer = data_ + size_ - kFooterSize;
+  index_offset_ = core::DecodeFixed64(footer);
+  num_elements_ = core::DecodeFixed64(footer + 8);
+  if (index_offset_ > size_ - kFooterSize ||
+      (size_ - kFooterSize - index_offset_) / 8 != num_elements_) {
+    return errors::DataLoss("Corrupted index in cache file ", filename_);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status IndexedCacheFileReader::Get(int64_t index,
+                                         std::vector<Tensor>* element) const {
+  if (index < 0 || index >= num_elements_) {
+    return errors::OutOfRange("Index out of range [0, ", num_elements_,
+                              "): ", index);
+  }
+  uint64_t offset = core::DecodeFixed64(data_ + index_offset_ + index * 8);
+  element->clear();
+  element->resize(num_components_);
+  for (Tensor& tensor : *element) {
+    TF_RETURN_IF_ERROR(ReadComponent(&offset, &tensor));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status IndexedCacheFileReader::ReadComponent(uint64_t* offset,
+                                                   Tensor* tensor) const {
+  auto corrupted = [this, offset]() {
+    return errors::DataLoss("Corrupted element at offset ", *offset,
+                            " of cache file ", filename_);
+  };
+  if (*offset + 16 > index_offset_) return corrupted();
+  const char* header = data_ + *offset;
+  const DataType dtype = static_cast<DataType>(core::DecodeFixed32(header));
+  const uint32_t encoding = core::DecodeFixed32(header + 4);
+  const uint32_t dims = core::DecodeFixed32(header + 8);
+  const uint64_t header_size = 16 + dims * 8 + 8;
+  if (*offset + header_size > index_offset_) return corrupted();
+  std::vector<int64_t> dim_sizes(dims);
+  for (uint32_t i = 0; i < dims; ++i) {
+    dim_sizes[i] = core::DecodeFixed64(header + 16 + i * 8);
+  }
+  const uint64_t payload_size = core::DecodeFixed64(header + 16 + dims * 8);
+  const uint64_t payload_offset = AlignUp(*offset + header_size);
+  if (payload_offset + payload_size > index_offset_) return corrupted();
+  const char* payload = data_ + payload_offset;
+
+  if (encoding == kTensorProto) {
+    TensorProto proto;
+    if (!proto.ParseFromArray(payload, payload_size) ||
+        !tensor->FromProto(proto)) {
+      return corrupted();
+    }
+  } else if (encoding == kRaw && DataTypeCanUseMemcpy(dtype)) {
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(TensorShape::BuildTensorShape(dim_sizes, &shape));
+    if (shape.num_elements() * DataTypeSize(dtype) != payload_size) {
+      return corrupted();
+    }
+    if (payload_size == 0 ||
+        reinterpret_cast<uintptr_t>(payload) % EIGEN_MAX_ALIGN_BYTES != 0) {
+      // Only tensors that satisfy the alignment of allocated tensors alias the
+      // region, which is not guaranteed if it is not memory-mapped.
+      *tensor = Tensor(dtype, shape);
+      memcpy(const_cast<char*>(tensor->tensor_data().data()), payload,
+             payload_size);
+    } else {
+      auto* buffer = new RegionTensorBuffer(region_, payload, payload_size);
+      *tensor = Tensor(dtype, shape, buffer);
+      buffer->Unref();
+    }
+  } else {
+    return corrupted();
+  }
+  *offset = AlignUp(payload_offset + payload_size);
+  return absl::OkStatus();
+}
+
+absl::Status MergeIndexedCacheFiles(Env* env,
+                                    const std::vector<std::string>& inputs,
+                                    const std::string& output) {
+  if (inputs.empty()) {
+    return errors::InvalidArgument("No cache files to merge into ", output);
+  }
+  if (inputs.size() == 1) {
+    return env->RenameFile(inputs[0], output);
+  }
+  std::unique_ptr<IndexedCacheFileWriter> writer;
+  std::vector<Tensor> element;
+  for (const std::string& input : inputs) {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<IndexedCacheFileReader> reader,
+                        IndexedCacheFileReader::Open(env, input));
+    if (writer == nullptr) {
+      writer = std::make_unique<IndexedCacheFileWriter>(
+          env, output, reader->num_components());
+    }
+    for (int64_t i = 0; i < reader->num_elements(); ++i) {
+      TF_RETURN_IF_ERROR(reader->Get(i, &element));
+      TF_RETURN_IF_ERROR(writer->Add(element));
+    }
+  }
+  element.clear();
+  TF_RETURN_IF_ERROR(writer->Finish());
+  for (const std::string& input : inputs) {
+    TF_RETURN_IF_ERROR(env->DeleteFile(input));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace data
+}  // namespace tensorflow
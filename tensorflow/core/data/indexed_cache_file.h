@@ -0,0 +1,141 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_INDEXED_CACHE_FILE_H_
+#define TENSORFLOW_CORE_DATA_INDEXED_CACHE_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+namespace data {
+
+// An on-disk format for `CacheDataset` that supports random access.
+//
+// A file consists of a header, the elements in order of arrival, an index with
+// the offset of every element, and a fixed-size footer pointing at the index:
+//
+//   header | element 0 | ... | element n-1 | index | footer
+//
+// Every component of an element is stored as a small header describing its
+// dtype and shape, followed by its payload. Headers and payloads start at
+// multiples of `kAlignment`, so that once the file is memory-mapped (the
+// mapping itself is page-aligned) the payload of a memcpy-able component can
+// back a `Tensor` directly. Components of other dtypes, e.g. strings, are
+// stored as serialized `TensorProto`s and are decoded on read.
+
+// Returns the name of the indexed cache file for the cache `prefix`.
+std::string IndexedCacheFilename(absl::string_view prefix);
+
+// Writes an indexed cache file. Elements are appended sequentially; the index
+// is written by `Finish()`, before which the file is not readable.
+//
+// This class is not thread-safe.
+class IndexedCacheFileWriter {
+ public:
+  static constexpr uint64_t kAlignment = 64;
+
+  IndexedCacheFileWriter(Env* env, std::string filename,
+                         int64_t num_components);
+
+  IndexedCacheFileWriter(const IndexedCacheFileWriter&) = delete;
+  IndexedCacheFileWriter& operator=(const IndexedCacheFileWriter&) = delete;
+
+  // Appends `element`, which must have `num_components` components.
+  absl::Status Add(const std::vector<Tensor>& element);
+
+  // Writes the index and the footer and closes the file.
+  absl::Status Finish();
+
+  // Returns the first error encountered by `Add()` or `Finish()`.
+  absl::Status status() const { return status_; }
+
+  int64_t num_elements() const { return offsets_.size(); }
+
+ private:
+  absl::Status Initialize();
+  absl::Status AddComponent(const Tensor& tensor);
+  absl::Status Append(absl::string_view data);
+  absl::Status Pad();
+
+  Env* const env_;
+  const std::string filename_;
+  const int64_t num_components_;
+
+  absl::Status status_;
+  std::unique_ptr<WritableFile> file_;
+  uint64_t offset_ = 0;
+  // Offsets of the elements written so far.
+  std::vector<uint64_t> offsets_;
+};
+
+// Reads an indexed cache file written by `IndexedCacheFileWriter`.
+//
+// The file is memory-mapped when the file system supports it, and is read into
+// memory otherwise. `Get()` does not copy the payloads of memcpy-able
+// components: the returned tensors alias the mapping and keep it alive, and
+// they are never forwarded to the outputs of kernels since they do not own
+// their memory.
+//
+// This class is thread-safe.
+class IndexedCacheFileReader {
+ public:
+  static absl::StatusOr<std::unique_ptr<IndexedCacheFileReader>> Open(
+      Env* env, const std::string& filename);
+
+  IndexedCacheFileReader(const IndexedCacheFileReader&) = delete;
+  IndexedCacheFileReader& operator=(const IndexedCacheFileReader&) = delete;
+
+  // Stores the element at `index` in `element`.
+  absl::Status Get(int64_t index, std::vector<Tensor>* element) const;
+
+  int64_t num_elements() const { return num_elements_; }
+  int64_t num_components() const { return num_components_; }
+
+ private:
+  IndexedCacheFileReader(std::string filename,
+                         std::shared_ptr<ReadOnlyMemoryRegion> region);
+
+  absl::Status ReadFooter();
+  absl::Status ReadComponent(uint64_t* offset, Tensor* tensor) const;
+
+  const std::string filename_;
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const char* const data_;
+  const uint64_t size_;
+  int64_t num_components_ = 0;
+  int64_t num_elements_ = 0;
+  // Start of the index, an array of `num_elements_` little-endian offsets.
+  uint64_t index_offset_ = 0;
+};
+
+// Merges the indexed cache files `inputs` into `output`, in order, and deletes
+// the inputs. A single input is renamed.
+absl::Status MergeIndexedCacheFiles(Env* env,
+                                    const std::vector<std::string>& inputs,
+                                    const std::string& output);
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_INDEXED_CACHE_FILE_H_
@@ -0,0 +1,170 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/indexed_cache_file.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::string TestFilename(const std::string& name) {
+  return io::JoinPath(
+      ::testing::TempDir(),
+      absl::StrCat(
+          ::testing::UnitTest::GetInstance()->current_test_info()->name(), "_",
+          name));
+}
+
+std::vector<Tensor> Element(int64_t value) {
+  return {test::AsScalar<int64_t>(value),
+          test::AsTensor<float>({1.0f * value, 2.0f * value}),
+          test::AsTensor<tstring>({absl::StrCat("element_", value)})};
+}
+
+void ExpectElement(const std::vector<Tensor>& element, int64_t value) {
+  std::vector<Tensor> expected = Element(value);
+  ASSERT_EQ(element.size(), expected.size());
+  test::ExpectTensorEqual<int64_t>(element[0], expected[0]);
+  test::ExpectTensorEqual<float>(element[1], expected[1]);
+  test::ExpectTensorEqual<tstring>(element[2], expected[2]);
+}
+
+void WriteFile(const std::string& filename, int64_t begin, int64_t end) {
+  IndexedCacheFileWriter writer(Env::Default(), filename,
+                                /*num_components=*/3);
+  for (int64_t i = begin; i < end; ++i) {
+    TF_ASSERT_OK(writer.Add(Element(i)));
+  }
+  TF_ASSERT_OK(writer.Finish());
+}
+
+TEST(IndexedCacheFileTest, RandomAccess) {
+  const std::string filename = TestFilename("cache");
+  WriteFile(filename, 0, 100);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<IndexedCacheFileReader> reader,
+      IndexedCacheFileReader::Open(Env::Default(), filename));
+  EXPECT_EQ(reader->num_elements(), 100);
+  EXPECT_EQ(reader->num_components(), 3);
+  for (int64_t i : {42, 0, 99, 7, 42}) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(reader->Get(i, &element));
+    ExpectElement(element, i);
+  }
+  std::vector<Tensor> element;
+  EXPECT_TRUE(absl::IsOutOfRange(reader->Get(100, &element)));
+}
+
+TEST(IndexedCacheFileTest, TensorsOutliveReader) {
+  const std::string filename = TestFilename("cache");
+  WriteFile(filename, 0, 10);
+  std::vector<Tensor> element;
+  {
+    TF_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<IndexedCacheFileReader> reader,
+        IndexedCacheFileReader::Open(Env::Default(), filename));
+    TF_ASSERT_OK(reader->Get(3, &element));
+  }
+  ExpectElement(element, 3);
+  // Memcpy-able components do not own their memory, so they are never
+  // forwarded to (and written through by) kernels.
+  EXPECT_FALSE(DMAHelper::buffer(&element[1])->OwnsMemory());
+  EXPECT_TRUE(element[1].IsAligned());
+}
+
+TEST(IndexedCacheFileTest, ParallelReads) {
+  const std::string filename = TestFilename("cache");
+  WriteFile(filename, 0, 1000);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<IndexedCacheFileReader> reader,
+      IndexedCacheFileReader::Open(Env::Default(), filename));
+  {
+    thread::ThreadPool pool(Env::Default(), "readers", 8);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&reader, t]() {
+        for (int64_t i = t; i < reader->num_elements(); i += 8) {
+          std::vector<Tensor> element;
+          TF_ASSERT_OK(reader->Get(i, &element));
+          ExpectElement(element, i);
+        }
+      });
+    }
+  }
+}
+
+TEST(IndexedCacheFileTest, Empty) {
+  const std::string filename = TestFilename("cache");
+  WriteFile(filename, 0, 0);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<IndexedCacheFileReader> reader,
+      IndexedCacheFileReader::Open(Env::Default(), filename));
+  EXPECT_EQ(reader->num_elements(), 0);
+}
+
+TEST(IndexedCacheFileTest, UnfinishedFileIsRejected) {
+  const std::string filename = TestFilename("cache");
+  IndexedCacheFileWriter writer(Env::Default(), filename,
+                                /*num_components=*/3);
+  TF_ASSERT_OK(writer.Add(Element(0)));
+  EXPECT_TRUE(absl::IsDataLoss(
+      IndexedCacheFileReader::Open(Env::Default(), filename).status()));
+}
+
+TEST(IndexedCacheFileTest, WrongNumberOfComponents) {
+  IndexedCacheFileWriter writer(Env::Default(), TestFilename("cache"),
+                                /*num_components=*/2);
+  EXPECT_TRUE(absl::IsInvalidArgument(writer.Add(Element(0))));
+}
+
+TEST(IndexedCacheFileTest, Merge) {
+  const std::vector<std::string> inputs = {TestFilename("0"), TestFilename("1"),
+                                           TestFilename("2")};
+  WriteFile(inputs[0], 0, 10);
+  WriteFile(inputs[1], 10, 10);
+  WriteFile(inputs[2], 10, 25);
+  const std::string output = TestFilename("merged");
+  TF_ASSERT_OK(MergeIndexedCacheFiles(Env::Default(), inputs, output));
+  for (const std::string& input : inputs) {
+    EXPECT_TRUE(absl::IsNotFound(Env::Default()->FileExists(input)));
+  }
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<IndexedCacheFileReader> reader,
+                          IndexedCacheFileReader::Open(Env::Default(), output));
+  ASSERT_EQ(reader->num_elements(), 25);
+  for (int64_t i = 0; i < 25; ++i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(reader->Get(i, &element));
+    ExpectElement(element, i);
+  }
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,149 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/length_bucketing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Bounds the cost of `DesignBucketBoundaries`, which is quadratic in the number
+// of distinct lengths. Histograms with more distinct lengths are coarsened by
+// merging runs of adjacent lengths.
+constexpr int64_t kMaxDesignPoints = 512;
+
+// A run of adjacent observed lengths that is never split across buckets.
+struct DesignPoint {
+  // The longest length of the run.
+  int64_t max_length = 0;
+  // The number of sequences in the run.
+  int64_t count = 0;
+  // The sum of the lengths of the sequences in the run.
+  int64_t total_length = 0;
+};
+
+std::vector<DesignPoint> MakeDesignPoints(
+    const absl::btree_map<int64_t, int64_t>& histogram) {
+  const int64_t run_size =
+      (static_cast<int64_t>(histogram.size()) + kMaxDesignPoints - 1) /
+      kMaxDesignPoints;
+  std::vector<DesignPoint> points;
+  points.reserve(std::min<int64_t>(histogram.size(), kMaxDesignPoints));
+  int64_t run_length = 0;
+  for (const auto& [length, count] : histogram) {
+    if (run_length == 0) points.emplace_back();
+    DesignPoint& point = points.back();
+    point.max_length = length;
+    point.count += count;
+    point.total_length += length * count;
+    if (++run_length == run_size) run_length = 0;
+  }
+  return points;
+}
+
+}  // namespace
+
+std::vector<int64_t> DesignBucketBoundaries(
+    const absl::btree_map<int64_t, int64_t>& histogram, int64_t num_buckets) {
+  const std::vector<DesignPoint> points = MakeDesignPoints(histogram);
+  const int64_t n = points.size();
+  const int64_t k = std::min(num_buckets, n);
+  if (k <= 1) return {};
+
+  // `count[i]` and `total[i]` are the number and total length of the
+  // sequences in the first `i` points, so that padding the points `[i, j)` to
+  // the longest of them costs `Waste(i, j)` values.
+  std::vector<int64_t> count(n + 1, 0);
+  std::vector<int64_t> total(n + 1, 0);
+  for (int64_t i = 0; i < n; ++i) {
+    count[i + 1] = count[i] + points[i].count;
+    total[i + 1] = total[i] + points[i].total_length;
+  }
+  auto waste = [&](int64_t i, int64_t j) {
+    return points[j - 1].max_length * (count[j] - count[i]) -
+           (total[j] - total[i]);
+  };
+
+  // `cost[b][j]` is the least waste of splitting the first `j` points into
+  // `b + 1` buckets, and `split[b][j]` the first point of the last of them.
+  constexpr int64_t kInfinity = std::numeric_limits<int64_t>::max();
+  std::vector<std::vector<int64_t>> cost(k, std::vector<int64_t>(n + 1));
+  std::vector<std::vector<int64_t>> split(k, std::vector<int64_t>(n + 1, 0));
+  for (int64_t j = 1; j <= n; ++j) cost[0][j] = waste(0, j);
+  for (int64_t b = 1; b < k; ++b) {
+    for (int64_t j = b + 1; j <= n; ++j) {
+      cost[b][j] = kInfinity;
+      for (int64_t i = b; i < j; ++i) {
+        const int64_t c = cost[b - 1][i] + waste(i, j);
+        if (c < cost[b][j]) {
+          cost[b][j] = c;
+          split[b][j] = i;
+        }
+      }
+    }
+  }
+
+  std::vector<int64_t> boundaries(k - 1);
+  int64_t end = n;
+  for (int64_t b = k - 1; b > 0; --b) {
+    end = split[b][end];
+    boundaries[b - 1] = points[end - 1].max_length;
+  }
+  return boundaries;
+}
+
+int64_t BucketForLength(const std::vector<int64_t>& boundaries,
+                        int64_t length) {
+  return std::lower_bound(boundaries.begin(), boundaries.end(), length) -
+         boundaries.begin();
+}
+
+LengthBucketer::LengthBucketer(int64_t num_buckets)
+    : num_buckets_(std::max<int64_t>(num_buckets, 1)) {}
+
+int64_t LengthBucketer::Observe(int64_t length) {
+  ++histogram_[length];
+  if (++num_observed_ >= next_redesign_) {
+    boundaries_ = DesignBucketBoundaries(histogram_, num_buckets_);
+    next_redesign_ = NextRedesign(next_redesign_);
+  }
+  return BucketForLength(boundaries_, length);
+}
+
+void LengthBucketer::Restore(absl::btree_map<int64_t, int64_t> histogram,
+                             std::vector<int64_t> boundaries) {
+  histogram_ = std::move(histogram);
+  boundaries_ = std::move(boundaries);
+  num_observed_ = 0;
+  for (const auto& [length, count] : histogram_) num_observed_ += count;
+  next_redesign_ = kFirstRedesign;
+  while (next_redesign_ <= num_observed_) {
+    next_redesign_ = NextRedesign(next_redesign_);
+  }
+}
+
+int64_t LengthBucketer::NextRedesign(int64_t redesign) {
+  return redesign + std::min(redesign, kMaxRedesignInterval);
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,98 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_LENGTH_BUCKETING_H_
+#define TENSORFLOW_CORE_DATA_LENGTH_BUCKETING_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+
+namespace tensorflow {
+namespace data {
+
+// Designs the boundaries of at most `num_buckets` sequence length buckets, so
+// that padding every sequence to the longest sequence of its bucket wastes as
+// few values as possible for sequences distributed like `histogram`, which
+// maps each observed length to the number of times it was observed.
+//
+// Returns the inclusive upper bounds of all but the last bucket, in increasing
+// order. The last bucket holds all sequences longer than the last boundary.
+// Fewer than `num_buckets - 1` boundaries are returned when `histogram` has
+// fewer than `num_buckets` distinct lengths.
+std::vector<int64_t> DesignBucketBoundaries(
+    const absl::btree_map<int64_t, int64_t>& histogram, int64_t num_buckets);
+
+// Returns the index of the bucket that holds sequences of `length`, given the
+// bucket `boundaries` returned by `DesignBucketBoundaries`.
+int64_t BucketForLength(const std::vector<int64_t>& boundaries,
+                        int64_t length);
+
+// Returns the fraction of values that are not padding when sequences with a
+// total of `num_values` values are padded to `padded_values` values.
+inline double PaddingEfficiency(int64_t num_values, int64_t padded_values) {
+  return padded_values > 0 ? static_cast<double>(num_values) / padded_values
+                           : 1.0;
+}
+
+// Assigns sequences to length buckets whose boundaries adapt to the observed
+// distribution of lengths.
+//
+// Every observed length is added to a histogram. The boundaries are redesigned
+// from the histogram with `DesignBucketBoundaries` whenever the number of
+// observed lengths doubles, starting at `kFirstRedesign` lengths and at least
+// every `kMaxRedesignInterval` lengths. Until the first redesign all sequences
+// share a single bucket.
+//
+// This class is not thread-safe.
+class LengthBucketer {
+ public:
+  static constexpr int64_t kFirstRedesign = 128;
+  static constexpr int64_t kMaxRedesignInterval = 1 << 16;
+
+  explicit LengthBucketer(int64_t num_buckets);
+
+  // Records a sequence of `length` and returns the index of its bucket, which
+  // is smaller than `num_buckets()`.
+  int64_t Observe(int64_t length);
+
+  // Replaces the state of the bucketer with a previously saved `histogram`
+  // and `boundaries`.
+  void Restore(absl::btree_map<int64_t, int64_t> histogram,
+               std::vector<int64_t> boundaries);
+
+  const absl::btree_map<int64_t, int64_t>& histogram() const {
+    return histogram_;
+  }
+  const std::vector<int64_t>& boundaries() const { return boundaries_; }
+  int64_t num_buckets() const { return num_buckets_; }
+  int64_t num_observed() const { return num_observed_; }
+
+ private:
+  // Returns the number of observed lengths at which the boundaries are
+  // redesigned next, after a redesign at `redesign` lengths.
+  static int64_t NextRedesign(int64_t redesign);
+
+  const int64_t num_buckets_;
+  absl::btree_map<int64_t, int64_t> histogram_;
+  std::vector<int64_t> boundaries_;
+  int64_t num_observed_ = 0;
+  int64_t next_redesign_ = kFirstRedesign;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_LENGTH_BUCKETING_H_
@@ -0,0 +1,102 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/length_bucketing.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(DesignBucketBoundariesTest, SeparatesClusters) {
+  absl::btree_map<int64_t, int64_t> histogram = {
+      {10, 100}, {11, 100}, {50, 100}, {52, 100}, {200, 10}};
+  EXPECT_THAT(DesignBucketBoundaries(histogram, 3), ElementsAre(11, 52));
+}
+
+TEST(DesignBucketBoundariesTest, OneBucketPerDistinctLength) {
+  absl::btree_map<int64_t, int64_t> histogram = {{3, 1}, {5, 1}, {8, 1}};
+  EXPECT_THAT(DesignBucketBoundaries(histogram, 10), ElementsAre(3, 5));
+}
+
+TEST(DesignBucketBoundariesTest, SingleBucket) {
+  absl::btree_map<int64_t, int64_t> histogram = {{3, 1}, {5, 1}};
+  EXPECT_THAT(DesignBucketBoundaries(histogram, 1), IsEmpty());
+  EXPECT_THAT(DesignBucketBoundaries({}, 4), IsEmpty());
+}
+
+TEST(DesignBucketBoundariesTest, ManyDistinctLengths) {
+  absl::btree_map<int64_t, int64_t> histogram;
+  for (int64_t length = 1; length <= 10000; ++length) histogram[length] = 1;
+  std::vector<int64_t> boundaries = DesignBucketBoundaries(histogram, 4);
+  ASSERT_EQ(boundaries.size(), 3);
+  // Uniformly distributed lengths are split into near equal ranges.
+  EXPECT_NEAR(boundaries[0], 2500, 50);
+  EXPECT_NEAR(boundaries[1], 5000, 50);
+  EXPECT_NEAR(boundaries[2], 7500, 50);
+}
+
+TEST(BucketForLengthTest, Boundaries) {
+  std::vector<int64_t> boundaries = {11, 52};
+  EXPECT_EQ(BucketForLength(boundaries, 1), 0);
+  EXPECT_EQ(BucketForLength(boundaries, 11), 0);
+  EXPECT_EQ(BucketForLength(boundaries, 12), 1);
+  EXPECT_EQ(BucketForLength(boundaries, 52), 1);
+  EXPECT_EQ(BucketForLength(boundaries, 1000), 2);
+  EXPECT_EQ(BucketForLength({}, 1000), 0);
+}
+
+TEST(PaddingEfficiencyTest, Ratio) {
+  EXPECT_DOUBLE_EQ(PaddingEfficiency(3, 4), 0.75);
+  EXPECT_DOUBLE_EQ(PaddingEfficiency(0, 0), 1.0);
+}
+
+TEST(LengthBucketerTest, AdaptsToObservedLengths) {
+  LengthBucketer bucketer(/*num_buckets=*/2);
+  for (int64_t i = 0; i < LengthBucketer::kFirstRedesign - 1; ++i) {
+    EXPECT_EQ(bucketer.Observe(i % 2 == 0 ? 10 : 100), 0);
+  }
+  EXPECT_THAT(bucketer.boundaries(), IsEmpty());
+  EXPECT_EQ(bucketer.Observe(100), 1);
+  EXPECT_THAT(bucketer.boundaries(), ElementsAre(10));
+  EXPECT_EQ(bucketer.Observe(10), 0);
+  EXPECT_EQ(bucketer.num_observed(), LengthBucketer::kFirstRedesign + 1);
+}
+
+TEST(LengthBucketerTest, Restore) {
+  LengthBucketer bucketer(/*num_buckets=*/2);
+  for (int64_t i = 0; i < 200; ++i) bucketer.Observe(i % 2 == 0 ? 10 : 100);
+
+  LengthBucketer restored(/*num_buckets=*/2);
+  restored.Restore(bucketer.histogram(), bucketer.boundaries());
+  EXPECT_EQ(restored.num_observed(), bucketer.num_observed());
+  EXPECT_EQ(restored.boundaries(), bucketer.boundaries());
+  // Both redesign their boundaries after the same number of lengths.
+  for (int64_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(restored.Observe(50), bucketer.Observe(50));
+    EXPECT_EQ(restored.boundaries(), bucketer.boundaries());
+  }
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
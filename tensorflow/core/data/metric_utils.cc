@@ -16,13 +16,19 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
+#include "tensorflow/core/data/tfdataz_metrics.h"
 #include "tensorflow/core/data/utils.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/env.h"
@@ -35,6 +41,15 @@ namespace {
 // Safely subtracts `x` from `y` avoiding underflow.
 uint64_t safe_sub(uint64_t x, uint64_t y) { return x >= y ? x - y : 0; }
 
+// Returns the `bucket` label of latency bucket `bucket` of
+// /tensorflow/data/transformation_latency.
+std::string LatencyBucketLabel(int bucket) {
+  if (bucket >= model::kNumLatencyBuckets - 1) {
+    return "inf";
+  }
+  return absl::StrCat(model::Node::LatencyBucketLimitMicros(bucket));
+}
+
 }  // namespace
 
 IteratorMetricsCollector::IteratorMetricsCollector(
@@ -86,6 +101,54 @@ void IteratorMetricsCollector::RecordStop(absl::Time start_time,
   }
 }
 
+void IteratorMetricsCollector::RecordTransformationLatencies(
+    TfDatazMetricsCollector& tfdataz_metrics_collector) {
+  if (!ShouldCollectMetrics()) {
+    return;
+  }
+
+  const uint64_t now_us = env_.NowMicros();
+  {
+    mutex_lock l(mu_);
+    if (latency_export_time_us_.has_value() &&
+        safe_sub(now_us, *latency_export_time_us_) <
+            kTransformationLatencyExportIntervalUs) {
+      return;
+    }
+    latency_export_time_us_ = now_us;
+  }
+
+  // Walking the model does not need `mu_`.
+  std::vector<TfDatazMetricsCollector::TransformationLatency> latencies =
+      tfdataz_metrics_collector.GetTransformationLatencies();
+  absl::flat_hash_map<int64_t, std::vector<int64_t>> exported_latency_buckets;
+  exported_latency_buckets.reserve(latencies.size());
+  mutex_lock l(mu_);
+  std::shared_ptr<model::Model> model = tfdataz_metrics_collector.GetModel();
+  if (latency_export_model_.lock() != model) {
+    exported_latency_buckets_.clear();
+    latency_export_model_ = model;
+  }
+  for (auto& latency : latencies) {
+    auto it = exported_latency_buckets_.find(latency.id);
+    for (int i = 0; i < latency.bucket_counts.size(); ++i) {
+      int64_t delta = latency.bucket_counts[i];
+      if (it != exported_latency_buckets_.end()) {
+        delta -= it->second[i];
+      }
+      if (delta > 0) {
+        metrics::GetTFDataTransformationLatencyCounter(latency.name,
+                                                       LatencyBucketLabel(i))
+            ->IncrementBy(delta);
+      }
+    }
+    exported_latency_buckets[latency.id] = std::move(latency.bucket_counts);
+  }
+  // Nodes that no longer exist, e.g. those of finished interleave inputs, are
+  // dropped.
+  exported_latency_buckets_ = std::move(exported_latency_buckets);
+}
+
 bool IteratorMetricsCollector::ShouldCollectMetrics() const {
   return device_type_ == DEVICE_CPU;
 }
@@ -16,11 +16,15 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_METRIC_UTILS_H_
 
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/time/time.h"
 #include "tensorflow/core/data/tfdataz_metrics.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -58,6 +62,18 @@ class IteratorMetricsCollector {
   // returned by `RecordStart`. `output` is the output of the `GetNext` call.
   void RecordStop(absl::Time start_time, const std::vector<Tensor>& output);
 
+  // Exports the `GetNext` latency histograms of the iterators of the input
+  // pipeline collected by `tfdataz_metrics_collector` to
+  // /tensorflow/data/transformation_latency. Only the calls recorded since the
+  // previous export are added, and exports happen at most once every
+  // `kTransformationLatencyExportIntervalUs`, so that this can be called after
+  // every `GetNext` call.
+  void RecordTransformationLatencies(
+      TfDatazMetricsCollector& tfdataz_metrics_collector);
+
+  static constexpr uint64_t kTransformationLatencyExportIntervalUs =
+      10 * 1000 * 1000;
+
  private:
   // We only collect metrics for CPU devices.
   bool ShouldCollectMetrics() const;
@@ -79,6 +95,14 @@ class IteratorMetricsCollector {
   // Records the end time (in microseconds) of the most recent `RecordStop()`
   // call.
   uint64_t end_time_us_ TF_GUARDED_BY(mu_) = 0;
+
+  // The time (in microseconds) of the most recent transformation latency
+  // export, the model it exported from, and the bucket counts it exported,
+  // keyed by model node ID. Node IDs are only unique within a model.
+  std::optional<uint64_t> latency_export_time_us_ TF_GUARDED_BY(mu_);
+  std::weak_ptr<model::Model> latency_export_model_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<int64_t, std::vector<int64_t>> exported_latency_buckets_
+      TF_GUARDED_BY(mu_);
 };
 
 }  // namespace data
@@ -15,15 +15,20 @@ limitations under the License.
 #include "tensorflow/core/data/metric_utils.h"
 
 #include <cstdint>
+#include <memory>
 
 #include "absl/memory/memory.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "tensorflow/core/data/tfdataz_metrics.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/lib/monitoring/test_utils.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/fake_clock_env.h"
 
 namespace tensorflow {
 namespace data {
@@ -148,6 +153,36 @@ TEST(MetricUtilsTest, OverlappingThreads) {
             absl::ToInt64Microseconds(absl::Seconds(2.9)));
 }
 
+TEST(MetricUtilsTest, RecordTransformationLatencies) {
+  CellReader<int64_t> latency_counter(
+      "/tensorflow/data/transformation_latency");
+  auto model = std::make_shared<model::Model>();
+  std::shared_ptr<model::Node> root;
+  model->AddNode(model::MakeSourceNode, "LatencyTestSource",
+                 /*parent=*/nullptr, &root);
+  std::unique_ptr<DatasetBaseIterator> iterator;
+  FakeClockEnv env(Env::Default());
+  TfDatazMetricsCollector tfdataz_metrics_collector(env, iterator.get(), model);
+  IteratorMetricsCollector metrics_collector(DEVICE_CPU, env);
+
+  root->record_get_next_latency(/*latency_nanos=*/3000);
+  metrics_collector.RecordTransformationLatencies(tfdataz_metrics_collector);
+  EXPECT_EQ(latency_counter.Delta("LatencyTestSource", "4"), 1);
+
+  // Calls within the export interval do not export.
+  root->record_get_next_latency(/*latency_nanos=*/3000);
+  root->record_get_next_latency(/*latency_nanos=*/500);
+  metrics_collector.RecordTransformationLatencies(tfdataz_metrics_collector);
+  EXPECT_EQ(latency_counter.Delta("LatencyTestSource", "4"), 0);
+
+  // Only the calls since the previous export are exported.
+  env.AdvanceByMicroseconds(
+      IteratorMetricsCollector::kTransformationLatencyExportIntervalUs);
+  metrics_collector.RecordTransformationLatencies(tfdataz_metrics_collector);
+  EXPECT_EQ(latency_counter.Delta("LatencyTestSource", "4"), 1);
+  EXPECT_EQ(latency_counter.Delta("LatencyTestSource", "1"), 1);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
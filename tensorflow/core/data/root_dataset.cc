@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/rewrite_utils.h"
+#include "tensorflow/core/data/shared_thread_pool.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/dataset_options.pb.h"
 #include "tensorflow/core/framework/metrics.h"
@@ -79,6 +80,17 @@ void SetRootDatasetParams(const Options& options, RootDataset::Params* params) {
       experiments.contains("stage_based_autotune_v2")) {
     params->autotune_algorithm = model::AutotuneAlgorithm::STAGE_BASED;
   }
+  // An explicitly requested private threadpool takes precedence over the
+  // shared threadpool.
+  if (!ShouldUsePrivateThreadPool(options) &&
+      experiments.contains("shared_threadpool")) {
+    params->use_shared_threadpool = true;
+    if (options.threading_options().optional_shared_threadpool_weight_case() ==
+        ThreadingOptions::kSharedThreadpoolWeight) {
+      params->shared_threadpool_weight =
+          options.threading_options().shared_threadpool_weight();
+    }
+  }
   if (options.autotune_options().optional_autotune_algorithm_case() ==
       AutotuneOptions::kAutotuneAlgorithm) {
     params->autotune_algorithm =
@@ -179,7 +191,12 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
           value_or_default(dataset()->params_.max_intra_op_parallelism, 0,
                            port::MaxParallelism());
     }
-    if (dataset()->params_.private_threadpool_size >= 0) {
+    if (dataset()->params_.use_shared_threadpool) {
+      SharedThreadPool* shared_pool = SharedThreadPool::Get();
+      shared_pool_registration_ =
+          shared_pool->Register(dataset()->params_.shared_threadpool_weight);
+      threadpool_size_ = shared_pool->NumThreads();
+    } else if (dataset()->params_.private_threadpool_size >= 0) {
       threadpool_size_ =
           value_or_default(dataset()->params_.private_threadpool_size, 0,
                            port::MaxParallelism());
@@ -326,7 +343,13 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
     // been set to a valid model in `Initialize()` if autotuning is on. We
     // should simply set `params.model` to `model_` here.
     params.model = model_;
-    if (dataset()->params_.private_threadpool_size >= 0) {
+    if (shared_pool_registration_) {
+      params.runner = [registration = shared_pool_registration_.get()](
+                          std::function<void()> c) {
+        registration->Schedule(std::move(c));
+      };
+      params.runner_threadpool_size = threadpool_size_;
+    } else if (dataset()->params_.private_threadpool_size >= 0) {
       params.runner = [pool = thread_pool_.get()](std::function<void()> c) {
         pool->Schedule(std::move(c));
       };
@@ -346,6 +369,15 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
       RunMode run_mode = ctx->run_mode();
       model_thread_ = ctx->StartThread("tf_data_model", [this, run_mode]() {
         RootDataset::Params params = dataset()->params_;
+        if (shared_pool_registration_) {
+          // Pipelines sharing the threadpool split the CPU budget according
+          // to their weights.
+          params.autotune_cpu_budget_func =
+              [budget_func = std::move(params.autotune_cpu_budget_func),
+               registration = shared_pool_registration_]() {
+                return registration->ScaleCpuBudget(budget_func());
+              };
+        }
         std::function<int64_t(int64_t)> ram_budget_func;
         std::optional<int64_t> raw_ram_budget;
         if (params.autotune_ram_budget_from_options > 0) {
@@ -373,6 +405,9 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
   // Controls cancellation of `model_thread_`. Must be ordered before
   // `model_thread_` so that `model_thread_` is destroyed first.
   std::unique_ptr<CancellationManager> cancellation_manager_;
+  // Set if the iterator runs on the shared threadpool. Must be ordered before
+  // `model_thread_`, whose CPU budget depends on it.
+  std::shared_ptr<SharedThreadPool::Registration> shared_pool_registration_;
   mutex mu_;
   std::unique_ptr<Thread> model_thread_ TF_GUARDED_BY(mu_);
   int64_t max_intra_op_parallelism_;
@@ -40,6 +40,10 @@ class RootDataset : public DatasetBase {
     int64_t autotune_ram_budget_from_options;
     int64_t max_intra_op_parallelism = 1;
     int64_t private_threadpool_size = 0;
+    // If true, the iterator schedules its work on the process-wide
+    // `SharedThreadPool` instead of creating a private threadpool.
+    bool use_shared_threadpool = false;
+    int64_t shared_threadpool_weight = 1;
 
     int64_t ComputeInitialAutotuneRamBudget() const {
       if (autotune_ram_budget_from_options > 0) {
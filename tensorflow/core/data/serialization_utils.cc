@@ -41,6 +41,7 @@ namespace {
 
 constexpr char kDelimiter[] = "@@";
 constexpr char kComponent[] = "component";
+constexpr char kCompressedElement[] = "compressed_element";
 constexpr char kNumComponents[] = "num_components";
 constexpr char kNumElements[] = "num_elements";
 constexpr char kIsDataset[] = ".is_dataset";
@@ -93,6 +94,32 @@ Status FindStatefulOps(const GraphDef& graph_def,
   return absl::OkStatus();
 }
 
+// Uncompresses an element written by `CheckpointElementCache`.
+Status UncompressCheckpointElement(const Tensor& compressed,
+                                   std::vector<Tensor>* element) {
+  if (compressed.dtype() != DT_VARIANT ||
+      !TensorShapeUtils::IsScalar(compressed.shape()) ||
+      compressed.scalar<Variant>()().get<CompressedElement>() == nullptr) {
+    return errors::DataLoss("Expected a compressed dataset element, got ",
+                            compressed.DebugString());
+  }
+  return UncompressElement(
+      *compressed.scalar<Variant>()().get<CompressedElement>(), element);
+}
+
+// Returns whether `a` and `b` are the same element, i.e. whether their tensors
+// share their buffers.
+bool IsSameElement(const std::vector<Tensor>& a, const std::vector<Tensor>& b) {
+  if (a.size() != b.size()) return false;
+  for (int i = 0; i < a.size(); ++i) {
+    if (a[i].dtype() != b[i].dtype() || a[i].shape() != b[i].shape()) {
+      return false;
+    }
+    if (a[i].NumElements() > 0 && !a[i].SharesBufferWith(b[i])) return false;
+  }
+  return true;
+}
+
 }  // namespace
 
 Status ReadElementsFromCheckpoint(IteratorContext* ctx,
@@ -106,6 +133,15 @@ Status ReadElementsFromCheckpoint(IteratorContext* ctx,
   elements->reserve(num_elements);
   for (int i = 0; i < num_elements; ++i) {
     std::string element_prefix = absl::StrCat(key_prefix, "::", i);
+    if (reader->Contains(element_prefix, kCompressedElement)) {
+      Tensor compressed;
+      TF_RETURN_IF_ERROR(
+          reader->ReadTensor(element_prefix, kCompressedElement, &compressed));
+      elements->emplace_back();
+      TF_RETURN_IF_ERROR(
+          UncompressCheckpointElement(compressed, &elements->back()));
+      continue;
+    }
     int64_t num_components;
     TF_RETURN_IF_ERROR(
         reader->ReadScalar(element_prefix, kNumComponents, &num_components));
@@ -159,6 +195,56 @@ Status UpdateCheckpointElements(
   return absl::OkStatus();
 }
 
+Status CheckpointElementCache::WriteElements(
+    IteratorStateWriter* writer, StringPiece key_prefix,
+    const std::vector<std::vector<Tensor>>& elements) {
+  mutex_lock l(mu_);
+  stats_ = Stats();
+  TF_RETURN_IF_ERROR(
+      writer->WriteScalar(key_prefix, kNumElements, elements.size()));
+  absl::flat_hash_map<std::vector<const void*>, Entry> new_entries;
+  for (int i = 0; i < elements.size(); ++i) {
+    Tensor compressed;
+    TF_RETURN_IF_ERROR(GetCompressed(elements[i], &new_entries, &compressed));
+    TF_RETURN_IF_ERROR(writer->WriteTensor(absl::StrCat(key_prefix, "::", i),
+                                           kCompressedElement, compressed));
+  }
+  // Drops the elements that have left the buffer since the last checkpoint.
+  entries_ = std::move(new_entries);
+  return absl::OkStatus();
+}
+
+CheckpointElementCache::Stats CheckpointElementCache::GetStats() const {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+Status CheckpointElementCache::GetCompressed(
+    const std::vector<Tensor>& element,
+    absl::flat_hash_map<std::vector<const void*>, Entry>* new_entries,
+    Tensor* compressed) {
+  std::vector<const void*> key;
+  key.reserve(element.size());
+  for (const Tensor& component : element) {
+    key.push_back(component.data());
+  }
+  auto it = entries_.find(key);
+  if (it != entries_.end() && IsSameElement(it->second.element, element)) {
+    *compressed = it->second.compressed;
+    ++stats_.num_reused;
+  } else {
+    CompressedElement compressed_element;
+    TF_RETURN_IF_ERROR(CompressElement(element, &compressed_element));
+    *compressed = Tensor(DT_VARIANT, TensorShape({}));
+    compressed->scalar<Variant>()() = std::move(compressed_element);
+    ++stats_.num_compressed;
+  }
+  Entry& entry = (*new_entries)[key];
+  entry.element = element;
+  entry.compressed = *compressed;
+  return absl::OkStatus();
+}
+
 VariantTensorDataReader::VariantTensorDataReader(
     const std::vector<const tensorflow::VariantTensorData*>& data) {
   for (const auto& d : data) {
@@ -29,6 +29,8 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.pb.h"
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tsl/platform/statusor.h"
 
 namespace tensorflow {
@@ -59,6 +61,63 @@ Status UpdateCheckpointElements(
     const std::vector<std::vector<Tensor>>& elements,
     const absl::flat_hash_set<int64_t>& checkpoint_indices);
 
+// Writes buffered dataset elements to consecutive checkpoints of an iterator,
+// storing each element as a single compressed tensor. The compressed form of
+// every element is kept until the next checkpoint, so that checkpointing a
+// large buffer that has mostly not changed since the previous checkpoint (e.g.
+// a shuffle buffer) only compresses the elements that entered the buffer in
+// between. The elements can be read back with ReadElementsFromCheckpoint.
+//
+// Since the elements of a dataset are immutable, an element is identified by
+// the buffers of its tensors. The cache holds references to the tensors of the
+// elements of the last checkpoint, which therefore stay alive (and cannot be
+// mistaken for other elements) until the next checkpoint.
+//
+// Cached compressed elements cost memory in addition to the checkpointed
+// buffer, so iterators should only use this class when opted in.
+//
+// This class is thread-safe.
+class CheckpointElementCache {
+ public:
+  struct Stats {
+    // The number of elements compressed by the last `WriteElements` call.
+    int64_t num_compressed = 0;
+    // The number of elements of the last `WriteElements` call whose compressed
+    // form was reused from the previous call.
+    int64_t num_reused = 0;
+  };
+
+  CheckpointElementCache() = default;
+  CheckpointElementCache(const CheckpointElementCache&) = delete;
+  CheckpointElementCache& operator=(const CheckpointElementCache&) = delete;
+
+  // Writes `elements` to `writer` using the given key prefix. Only the
+  // elements of the last call are cached, so the same cache should not be used
+  // for several key prefixes.
+  Status WriteElements(IteratorStateWriter* writer, StringPiece key_prefix,
+                       const std::vector<std::vector<Tensor>>& elements);
+
+  Stats GetStats() const;
+
+ private:
+  struct Entry {
+    std::vector<Tensor> element;
+    Tensor compressed;
+  };
+
+  // Returns the scalar variant tensor holding the compressed `element`, reusing
+  // the compressed element of the previous call if there is one.
+  Status GetCompressed(const std::vector<Tensor>& element,
+                       absl::flat_hash_map<std::vector<const void*>, Entry>*
+                           new_entries,
+                       Tensor* compressed) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable mutex mu_;
+  absl::flat_hash_map<std::vector<const void*>, Entry> entries_
+      TF_GUARDED_BY(mu_);
+  Stats stats_ TF_GUARDED_BY(mu_);
+};
+
 // Helper class for reading data from a vector of VariantTensorData objects.
 class VariantTensorDataReader : public IteratorStateReader {
  public:
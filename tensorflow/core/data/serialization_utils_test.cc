@@ -82,6 +82,80 @@ TEST(SerializationUtilsTest, CheckpointElementsRoundTrip) {
   }
 }
 
+TEST(SerializationUtilsTest, CheckpointElementCacheRoundTrip) {
+  std::vector<std::vector<Tensor>> elements;
+  elements.push_back(CreateTensors<int32>(TensorShape({3}), {{1, 2, 3}}));
+  elements.push_back(
+      {CreateTensor<tstring>(TensorShape({2}), {"a", "b"}),
+       CreateTensor<int64_t>(TensorShape({}), {4})});
+  elements.push_back({});
+  CheckpointElementCache cache;
+  VariantTensorDataWriter writer;
+  tstring test_prefix = full_name("test_prefix");
+  TF_ASSERT_OK(cache.WriteElements(&writer, test_prefix, elements));
+  EXPECT_EQ(cache.GetStats().num_compressed, 3);
+  EXPECT_EQ(cache.GetStats().num_reused, 0);
+
+  // Round trip through an encoded iterator state, like a checkpoint does.
+  std::vector<std::unique_ptr<VariantTensorData>> variants;
+  writer.ReleaseData(&variants);
+  ASSERT_EQ(variants.size(), 1);
+  IteratorStateVariant state;
+  TF_ASSERT_OK(state.InitializeFromVariantData(std::move(variants[0])));
+  VariantTensorData encoded;
+  state.Encode(&encoded);
+  IteratorStateVariant decoded;
+  ASSERT_TRUE(decoded.Decode(std::move(encoded)));
+
+  VariantTensorDataReader reader({decoded.GetData()});
+  std::vector<std::vector<Tensor>> read_elements;
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TestContext> ctx,
+                          TestContext::Create());
+  TF_ASSERT_OK(ReadElementsFromCheckpoint(ctx->iter_ctx(), &reader, test_prefix,
+                                          &read_elements));
+  ASSERT_EQ(read_elements.size(), elements.size());
+  test::ExpectEqual(read_elements[0][0], elements[0][0]);
+  test::ExpectEqual(read_elements[1][0], elements[1][0]);
+  test::ExpectEqual(read_elements[1][1], elements[1][1]);
+  EXPECT_TRUE(read_elements[2].empty());
+}
+
+TEST(SerializationUtilsTest, CheckpointElementCacheOnlyCompressesNewElements) {
+  std::vector<std::vector<Tensor>> elements;
+  for (int i = 0; i < 10; ++i) {
+    elements.push_back(CreateTensors<int64_t>(TensorShape({}), {{i}}));
+  }
+  CheckpointElementCache cache;
+  tstring test_prefix = full_name("test_prefix");
+  {
+    VariantTensorDataWriter writer;
+    TF_ASSERT_OK(cache.WriteElements(&writer, test_prefix, elements));
+    EXPECT_EQ(cache.GetStats().num_compressed, 10);
+  }
+
+  // Replace two elements, and move another one within the buffer.
+  elements[3] = CreateTensors<int64_t>(TensorShape({}), {{30}});
+  elements[7] = CreateTensors<int64_t>(TensorShape({}), {{70}});
+  std::swap(elements[0], elements[9]);
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(cache.WriteElements(&writer, test_prefix, elements));
+  EXPECT_EQ(cache.GetStats().num_compressed, 2);
+  EXPECT_EQ(cache.GetStats().num_reused, 8);
+
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  std::vector<std::vector<Tensor>> read_elements;
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TestContext> ctx,
+                          TestContext::Create());
+  TF_ASSERT_OK(ReadElementsFromCheckpoint(ctx->iter_ctx(), &reader, test_prefix,
+                                          &read_elements));
+  ASSERT_EQ(read_elements.size(), elements.size());
+  for (int i = 0; i < elements.size(); ++i) {
+    test::ExpectEqual(read_elements[i][0], elements[i][0]);
+  }
+}
+
 TEST(SerializationUtilsTest, VariantTensorDataRoundtrip) {
   VariantTensorDataWriter writer;
   TF_ASSERT_OK(writer.WriteScalar(full_name("Int64"), 24));
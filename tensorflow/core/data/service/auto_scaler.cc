@@ -27,9 +27,11 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
 #include "tensorflow/core/framework/metrics.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/mutex.h"
 #include "tsl/platform/thread_annotations.h"
 
@@ -37,6 +39,37 @@ namespace tensorflow {
 namespace data {
 
 constexpr double kAutoScalerOutlierSigmas = 1.0;
+// Consumption rates older than this are not used to forecast demand.
+constexpr absl::Duration kDemandHistoryWindow = absl::Seconds(60);
+// Maximum number of consumption-rate samples kept to forecast demand.
+constexpr size_t kMaxDemandHistorySamples = 256;
+// Reports closer than this to the latest sample replace it instead of adding a
+// new one, so that consumers heartbeating at about the same time do not look
+// like a steep trend.
+constexpr absl::Duration kDemandSampleInterval = absl::Seconds(1);
+// Demand is not extrapolated until the history covers at least this long.
+constexpr absl::Duration kMinDemandHistorySpan = absl::Seconds(5);
+// Below this buffer occupancy, a consumer is considered to be about to stall.
+constexpr double kLowBufferOccupancy = 0.25;
+// Scaling down is only recommended if every consumer's buffer occupancy is
+// above this value.
+constexpr double kHighBufferOccupancy = 0.75;
+// Maximum fraction of the current workers that may be removed by a single
+// scale-down recommendation.
+constexpr double kMaxScaleDownFraction = 0.1;
+
+// Limits the estimate to wait for target processing times to converge to a
+// feasible value. First, start increasing exponentially by 4x. Once increases
+// are greater than 500, scale linearly. The result is at most 100k workers.
+int64_t BoundNumberOfWorkers(int64_t number_of_workers,
+                             int64_t current_number_of_workers) {
+  if (number_of_workers > current_number_of_workers * 4 ||
+      number_of_workers > current_number_of_workers + 500) {
+    number_of_workers = std::min(current_number_of_workers * 4,
+                                 current_number_of_workers + 500);
+  }
+  return std::min(number_of_workers, int64_t{100000});
+}
 
 template <typename T>
 double GetMedian(const absl::flat_hash_map<T, double>& rates) {
@@ -97,13 +130,8 @@ void ReplaceOutliers(const absl::flat_hash_map<T, double>& rates,
   }
 }
 
-std::optional<int64_t> AutoScaler::GetOptimalNumberOfWorkers() const
-    TF_LOCKS_EXCLUDED(mu_) {
-  tsl::mutex_lock l(mu_);
-
-  if (worker_throughputs_.empty() || consumption_rates_.empty())
-    return std::nullopt;
-
+double AutoScaler::GetConsumptionRatesSum() const
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   std::vector<double> consumption_rates_without_outliers;
   // TODO(armandouv): Discard outlier replacement when we ensure reported time
   // values are correct.
@@ -111,26 +139,132 @@ std::optional<int64_t> AutoScaler::GetOptimalNumberOfWorkers() const
   // low).
   ReplaceOutliers(consumption_rates_, consumption_rates_without_outliers,
                   kAutoScalerOutlierSigmas);
-  double consumption_rates_sum_ =
-      std::accumulate(consumption_rates_without_outliers.begin(),
-                      consumption_rates_without_outliers.end(), 0.0);
+  return std::accumulate(consumption_rates_without_outliers.begin(),
+                         consumption_rates_without_outliers.end(), 0.0);
+}
 
+double AutoScaler::GetAverageWorkerThroughput() const
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   std::vector<double> worker_throughputs_without_outliers;
   ReplaceOutliers(worker_throughputs_, worker_throughputs_without_outliers,
                   kAutoScalerOutlierSigmas);
-  double worker_throughputs_sum_ =
+  double worker_throughputs_sum =
       std::accumulate(worker_throughputs_without_outliers.begin(),
                       worker_throughputs_without_outliers.end(), 0.0);
+  return worker_throughputs_sum /
+         static_cast<double>(worker_throughputs_.size());
+}
+
+void AutoScaler::RecordConsumptionRatesSum() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const int64_t now_micros = env_->NowMicros();
+  const double consumption_rates_sum = GetConsumptionRatesSum();
+  if (!consumption_rates_sum_history_.empty() &&
+      now_micros - consumption_rates_sum_history_.back().first <
+          absl::ToInt64Microseconds(kDemandSampleInterval)) {
+    consumption_rates_sum_history_.back().second = consumption_rates_sum;
+    return;
+  }
+  consumption_rates_sum_history_.emplace_back(now_micros,
+                                              consumption_rates_sum);
+  const int64_t window_micros = absl::ToInt64Microseconds(kDemandHistoryWindow);
+  while (consumption_rates_sum_history_.size() > kMaxDemandHistorySamples ||
+         consumption_rates_sum_history_.front().first <
+             now_micros - window_micros) {
+    consumption_rates_sum_history_.pop_front();
+  }
+}
 
-  double average_worker_throughput =
-      worker_throughputs_sum_ / static_cast<double>(worker_throughputs_.size());
+double AutoScaler::ForecastConsumptionRatesSum(absl::Duration horizon) const
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const double current = GetConsumptionRatesSum();
+  if (consumption_rates_sum_history_.size() < 2 ||
+      consumption_rates_sum_history_.back().first -
+              consumption_rates_sum_history_.front().first <
+          absl::ToInt64Microseconds(kMinDemandHistorySpan)) {
+    return current;
+  }
+
+  // Least-squares fit of the sum of consumption rates against time, in seconds
+  // relative to the oldest sample to keep the sums well-conditioned.
+  const int64_t origin_micros = consumption_rates_sum_history_.front().first;
+  const double n = consumption_rates_sum_history_.size();
+  double sum_t = 0.0, sum_y = 0.0, sum_tt = 0.0, sum_ty = 0.0;
+  for (const auto& [time_micros, rates_sum] : consumption_rates_sum_history_) {
+    const double t = (time_micros - origin_micros) / 1e6;
+    sum_t += t;
+    sum_y += rates_sum;
+    sum_tt += t * t;
+    sum_ty += t * rates_sum;
+  }
+  const double denominator = n * sum_tt - sum_t * sum_t;
+  if (denominator <= 0.0) return current;
+  const double slope = (n * sum_ty - sum_t * sum_y) / denominator;
+
+  const double seconds_since_last_sample =
+      (env_->NowMicros() - consumption_rates_sum_history_.back().first) / 1e6;
+  const double forecast =
+      current +
+      slope * (seconds_since_last_sample + absl::ToDoubleSeconds(horizon));
+  return std::max(current, forecast);
+}
+
+std::optional<int64_t> AutoScaler::GetOptimalNumberOfWorkers() const
+    TF_LOCKS_EXCLUDED(mu_) {
+  tsl::mutex_lock l(mu_);
+
+  if (worker_throughputs_.empty() || consumption_rates_.empty())
+    return std::nullopt;
 
   int64_t optimal_number_of_workers =
-      ceil(consumption_rates_sum_ / average_worker_throughput);
+      ceil(GetConsumptionRatesSum() / GetAverageWorkerThroughput());
 
   return std::max(int64_t{1}, optimal_number_of_workers);
 }
 
+std::optional<int64_t> AutoScaler::GetForecastedNumberOfWorkersLocked(
+    absl::Duration horizon) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (worker_throughputs_.empty() || consumption_rates_.empty())
+    return std::nullopt;
+
+  int64_t forecasted_number_of_workers =
+      ceil(ForecastConsumptionRatesSum(horizon) / GetAverageWorkerThroughput());
+
+  return std::max(int64_t{1}, forecasted_number_of_workers);
+}
+
+std::optional<int64_t> AutoScaler::GetForecastedNumberOfWorkers(
+    absl::Duration horizon) const TF_LOCKS_EXCLUDED(mu_) {
+  tsl::mutex_lock l(mu_);
+  return GetForecastedNumberOfWorkersLocked(horizon);
+}
+
+std::optional<int64_t> AutoScaler::GetRecommendedNumberOfWorkers(
+    int64_t current_number_of_workers, absl::Duration horizon) const
+    TF_LOCKS_EXCLUDED(mu_) {
+  tsl::mutex_lock l(mu_);
+  std::optional<int64_t> forecasted_number_of_workers =
+      GetForecastedNumberOfWorkersLocked(horizon);
+  if (!forecasted_number_of_workers.has_value()) return std::nullopt;
+  if (buffer_occupancies_.empty()) return forecasted_number_of_workers;
+
+  double min_buffer_occupancy = 1.0;
+  for (const auto& [consumer_id, buffer_occupancy] : buffer_occupancies_) {
+    min_buffer_occupancy = std::min(min_buffer_occupancy, buffer_occupancy);
+  }
+
+  if (min_buffer_occupancy < kLowBufferOccupancy) {
+    return std::max(*forecasted_number_of_workers,
+                    current_number_of_workers + 1);
+  }
+  if (min_buffer_occupancy < kHighBufferOccupancy) {
+    return std::max(*forecasted_number_of_workers, current_number_of_workers);
+  }
+  const int64_t max_scale_down = std::max<int64_t>(
+      1, current_number_of_workers * kMaxScaleDownFraction);
+  return std::max({*forecasted_number_of_workers,
+                   current_number_of_workers - max_scale_down, int64_t{1}});
+}
+
 absl::Status AutoScaler::ReportProcessingTime(const std::string& worker_address,
                                               absl::Duration processing_time)
     TF_LOCKS_EXCLUDED(mu_) {
@@ -160,6 +294,21 @@ absl::Status AutoScaler::ReportTargetProcessingTime(
   double consumption_rate = 1.0 / absl::ToDoubleSeconds(target_processing_time);
   tsl::mutex_lock l(mu_);
   consumption_rates_[consumer_id] = consumption_rate;
+  RecordConsumptionRatesSum();
+
+  return absl::OkStatus();
+}
+
+absl::Status AutoScaler::ReportBufferOccupancy(int64_t consumer_id,
+                                               double buffer_occupancy)
+    TF_LOCKS_EXCLUDED(mu_) {
+  if (!(buffer_occupancy >= 0.0 && buffer_occupancy <= 1.0)) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Buffer occupancy must be in [0, 1], got ", buffer_occupancy));
+  }
+
+  tsl::mutex_lock l(mu_);
+  buffer_occupancies_[consumer_id] = buffer_occupancy;
 
   return absl::OkStatus();
 }
@@ -184,6 +333,7 @@ absl::Status AutoScaler::RemoveConsumer(int64_t consumer_id)
         absl::StrCat("Consumer with ID ", consumer_id, " not found"));
 
   consumption_rates_.erase(consumer_id);
+  buffer_occupancies_.erase(consumer_id);
 
   return absl::OkStatus();
 }
@@ -191,7 +341,7 @@ absl::Status AutoScaler::RemoveConsumer(int64_t consumer_id)
 void MultipleIterationsAutoScaler::EnsureIterationIsRegistered(
     int64_t iteration_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   if (!auto_scalers_.contains(iteration_id)) {
-    auto_scalers_[iteration_id] = std::make_unique<AutoScaler>();
+    auto_scalers_[iteration_id] = std::make_unique<AutoScaler>(env_);
   }
 }
 
@@ -222,18 +372,8 @@ absl::Status MultipleIterationsAutoScaler::UpdateOptimalNumberOfWorkersMetric(
   VLOG(3) << "Estimated optimal number of workers: "
           << optimal_number_of_workers.value();
 
-  // Limit the estimate to wait for target processing times to converge to a
-  // feasible value. First, start increasing exponentially by 4x. Once
-  // increases are greater than 500, scale linearly.
-  int64_t bound_optimal_number_of_workers = optimal_number_of_workers.value();
-  if (bound_optimal_number_of_workers > current_number_of_workers * 4 ||
-      bound_optimal_number_of_workers > current_number_of_workers + 500) {
-    bound_optimal_number_of_workers = std::min(current_number_of_workers * 4,
-                                               current_number_of_workers + 500);
-  }
-  // Limit the estimate to at most 100k workers.
-  bound_optimal_number_of_workers =
-      std::min(bound_optimal_number_of_workers, int64_t{100000});
+  int64_t bound_optimal_number_of_workers = BoundNumberOfWorkers(
+      optimal_number_of_workers.value(), current_number_of_workers);
   VLOG(3) << "Bound optimal number of workers: "
           << bound_optimal_number_of_workers;
 
@@ -264,6 +404,46 @@ std::optional<int64_t> MultipleIterationsAutoScaler::GetOptimalNumberOfWorkers()
     return optimal_number_of_workers;
 }
 
+absl::StatusOr<ScalingRecommendation>
+MultipleIterationsAutoScaler::GetScalingRecommendation(
+    int64_t current_number_of_workers, absl::Duration horizon) const
+    TF_LOCKS_EXCLUDED(mu_) {
+  if (current_number_of_workers <= 0)
+    return absl::InvalidArgumentError(
+        "The current number of workers must be positive");
+
+  int64_t recommended_number_of_workers = 0;
+  {
+    tsl::tf_shared_lock l(mu_);
+    for (const auto& [iteration_id, auto_scaler] : auto_scalers_) {
+      std::optional<int64_t> current_recommended_number_of_workers =
+          auto_scaler->GetRecommendedNumberOfWorkers(current_number_of_workers,
+                                                     horizon);
+      if (!current_recommended_number_of_workers.has_value()) continue;
+
+      recommended_number_of_workers =
+          std::max(recommended_number_of_workers,
+                   current_recommended_number_of_workers.value());
+    }
+  }
+  if (recommended_number_of_workers == 0)
+    return absl::UnavailableError(
+        "Cannot recommend a number of workers because there are no reported "
+        "processing and target processing times for at least one iteration");
+
+  ScalingRecommendation recommendation;
+  recommendation.number_of_workers = BoundNumberOfWorkers(
+      recommended_number_of_workers, current_number_of_workers);
+  if (recommendation.number_of_workers > current_number_of_workers) {
+    recommendation.action = ScalingRecommendation::Action::kScaleUp;
+  } else if (recommendation.number_of_workers < current_number_of_workers) {
+    recommendation.action = ScalingRecommendation::Action::kScaleDown;
+  }
+  VLOG(3) << "Recommended number of workers: "
+          << recommendation.number_of_workers;
+  return recommendation;
+}
+
 absl::Status MultipleIterationsAutoScaler::ReportProcessingTime(
     int64_t iteration_id, const std::string& worker_address,
     absl::Duration processing_time) TF_LOCKS_EXCLUDED(mu_) {
@@ -286,6 +466,17 @@ absl::Status MultipleIterationsAutoScaler::ReportTargetProcessingTime(
   return status;
 }
 
+absl::Status MultipleIterationsAutoScaler::ReportBufferOccupancy(
+    int64_t iteration_id, int64_t consumer_id, double buffer_occupancy)
+    TF_LOCKS_EXCLUDED(mu_) {
+  tsl::mutex_lock l(mu_);
+  EnsureIterationIsRegistered(iteration_id);
+
+  absl::Status status = auto_scalers_[iteration_id]->ReportBufferOccupancy(
+      consumer_id, buffer_occupancy);
+  return status;
+}
+
 absl::Status MultipleIterationsAutoScaler::RemoveWorker(
     int64_t iteration_id, const std::string& worker_address)
     TF_LOCKS_EXCLUDED(mu_) {
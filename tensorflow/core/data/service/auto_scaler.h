@@ -17,13 +17,17 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_SERVICE_AUTO_SCALER_H_
 
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/time/time.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/mutex.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/thread_annotations.h"
@@ -53,6 +57,9 @@ namespace data {
 // * Consumption rate (CR): It is the multiplicative inverse of target
 // processing time (1 / TPT). This refers to the number of elements requested by
 // a consumer per second.
+// * Buffer occupancy (BO): The fraction of a consumer's element buffer that
+// holds elements ready to be consumed. A consumer whose buffer is close to
+// empty is about to stall waiting for input.
 //
 // **AutoScaler overview**
 //
@@ -64,16 +71,44 @@ namespace data {
 // follows:
 //  N = (Sum of CRs reported by all consumers) /
 //      (Average of WTs reported by all workers)
+// 3. To add workers ahead of load, it keeps a short history of the sum of CRs
+// and extrapolates its linear trend over a forecast horizon. Combined with the
+// BOs reported by consumers, this yields a recommended number of workers (see
+// `GetRecommendedNumberOfWorkers`).
 //
 // AutoScaler is thread-safe.
 class AutoScaler {
  public:
-  AutoScaler() = default;
+  AutoScaler() : AutoScaler(tsl::Env::Default()) {}
+  // `env` is used to timestamp the consumption-rate history, and must outlive
+  // the AutoScaler.
+  explicit AutoScaler(tsl::Env* env) : env_(env) {}
   // Returns the estimated optimal number of workers according to the current
   // observed workload. If there are no previously reported processing and
   // target processing times, returns nullopt.
   std::optional<int64_t> GetOptimalNumberOfWorkers() const
       TF_LOCKS_EXCLUDED(mu_);
+  // Returns the estimated number of workers needed to keep up with the sum of
+  // consumption rates forecasted `horizon` from now. The forecast never goes
+  // below the current demand. Returns nullopt under the same conditions as
+  // `GetOptimalNumberOfWorkers`.
+  std::optional<int64_t> GetForecastedNumberOfWorkers(
+      absl::Duration horizon) const TF_LOCKS_EXCLUDED(mu_);
+  // Returns the number of workers this Iteration should run with, given that
+  // `current_number_of_workers` are running:
+  // * If a consumer's buffer is below the low watermark, it is about to stall,
+  //   so at least one more worker is recommended.
+  // * Scaling down is only recommended when every consumer reported a buffer
+  //   above the high watermark, and by at most 10% of the current workers at a
+  //   time, so that buffers can absorb the lost throughput.
+  // * Otherwise, the current number of workers is kept unless the forecasted
+  //   demand calls for more.
+  // If no consumer has reported its buffer occupancy, the forecasted number of
+  // workers is returned. Returns nullopt under the same conditions as
+  // `GetOptimalNumberOfWorkers`.
+  std::optional<int64_t> GetRecommendedNumberOfWorkers(
+      int64_t current_number_of_workers, absl::Duration horizon) const
+      TF_LOCKS_EXCLUDED(mu_);
   // Reports the latest observed processing time from the worker with
   // `worker_address`. Returns an error if `processing_time` is ZeroDuration or
   // negative.
@@ -86,23 +121,60 @@ class AutoScaler {
   absl::Status ReportTargetProcessingTime(int64_t consumer_id,
                                           absl::Duration target_processing_time)
       TF_LOCKS_EXCLUDED(mu_);
+  // Reports the latest observed buffer occupancy from the consumer identified
+  // by `consumer_id`. Returns an error if `buffer_occupancy` is not in
+  // [0, 1].
+  absl::Status ReportBufferOccupancy(int64_t consumer_id,
+                                     double buffer_occupancy)
+      TF_LOCKS_EXCLUDED(mu_);
   // Unregisters the worker with `worker_address`, removing its reported
   // processing time from consideration of the current workload estimation.
   // Returns an error if the specified worker does not exist.
   absl::Status RemoveWorker(const std::string& worker_address)
       TF_LOCKS_EXCLUDED(mu_);
   // Unregisters the consumer identified by `consumer_id`, removing its reported
-  // target processing time from consideration of the current workload
-  // estimation. Returns an error if the specified consumer does not exist.
+  // target processing time and buffer occupancy from consideration of the
+  // current workload estimation. Returns an error if the specified consumer
+  // does not exist.
   absl::Status RemoveConsumer(int64_t consumer_id) TF_LOCKS_EXCLUDED(mu_);
 
  private:
+  // Returns the sum of consumption rates, with outliers replaced by the median.
+  double GetConsumptionRatesSum() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns the average worker throughput, with outliers replaced by the
+  // median.
+  double GetAverageWorkerThroughput() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns the sum of consumption rates extrapolated `horizon` from now,
+  // clamped below by the current sum.
+  double ForecastConsumptionRatesSum(absl::Duration horizon) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Appends the current sum of consumption rates to
+  // `consumption_rates_sum_history_`, discarding samples that are too old.
+  void RecordConsumptionRatesSum() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  std::optional<int64_t> GetForecastedNumberOfWorkersLocked(
+      absl::Duration horizon) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  tsl::Env* const env_;
   mutable tsl::mutex mu_;
   // Map from worker address to worker throughput.
   absl::flat_hash_map<std::string, double> worker_throughputs_
       TF_GUARDED_BY(mu_);
   // Map from consumer id to consumption rate.
   absl::flat_hash_map<int64_t, double> consumption_rates_ TF_GUARDED_BY(mu_);
+  // Map from consumer id to buffer occupancy.
+  absl::flat_hash_map<int64_t, double> buffer_occupancies_ TF_GUARDED_BY(mu_);
+  // Recent (time in microseconds, sum of consumption rates) samples, oldest
+  // first.
+  std::deque<std::pair<int64_t, double>> consumption_rates_sum_history_
+      TF_GUARDED_BY(mu_);
+};
+
+// A recommendation on how many tf.data service workers the cluster should run.
+struct ScalingRecommendation {
+  enum class Action { kKeep, kScaleUp, kScaleDown };
+  Action action = Action::kKeep;
+  // The recommended total number of workers.
+  int64_t number_of_workers = 0;
 };
 
 // Exports a metric (/tensorflow/data/service/optimal_number_of_workers) with
@@ -115,7 +187,14 @@ class AutoScaler {
 // MultipleIterationsAutoScaler is thread-safe.
 class MultipleIterationsAutoScaler {
  public:
-  MultipleIterationsAutoScaler() = default;
+  // How far ahead `GetScalingRecommendation` forecasts demand. Roughly the
+  // time it takes for a newly requested worker to start serving elements.
+  static constexpr absl::Duration kDefaultForecastHorizon = absl::Seconds(30);
+
+  MultipleIterationsAutoScaler()
+      : MultipleIterationsAutoScaler(tsl::Env::Default()) {}
+  // `env` must outlive the MultipleIterationsAutoScaler.
+  explicit MultipleIterationsAutoScaler(tsl::Env* env) : env_(env) {}
   // Unregisters iteration with `iteration_id`, removing its reported
   // times from consideration of the current workload estimation.
   // Returns an error if the specified iteration does not exist.
@@ -132,6 +211,16 @@ class MultipleIterationsAutoScaler {
   // target processing times for at least one iteration, returns nullopt.
   std::optional<int64_t> GetOptimalNumberOfWorkers() const
       TF_LOCKS_EXCLUDED(mu_);
+  // Returns whether the cluster running `current_number_of_workers` should
+  // scale up or down, and to how many workers. The recommendation is the
+  // maximum of `AutoScaler::GetRecommendedNumberOfWorkers` over all
+  // Iterations, limited in the same way as
+  // `UpdateOptimalNumberOfWorkersMetric`. Returns an error under the same
+  // conditions as `UpdateOptimalNumberOfWorkersMetric`.
+  absl::StatusOr<ScalingRecommendation> GetScalingRecommendation(
+      int64_t current_number_of_workers,
+      absl::Duration horizon = kDefaultForecastHorizon) const
+      TF_LOCKS_EXCLUDED(mu_);
   // Reports the latest observed processing time from the worker with
   // `worker_address` for iteration with `iteration_id`. Returns an error if
   // `processing_time` is ZeroDuration or negative.
@@ -146,6 +235,12 @@ class MultipleIterationsAutoScaler {
                                           int64_t consumer_id,
                                           absl::Duration target_processing_time)
       TF_LOCKS_EXCLUDED(mu_);
+  // Reports the latest observed buffer occupancy from the consumer identified
+  // by `consumer_id` for iteration with `iteration_id`. Returns an error if
+  // `buffer_occupancy` is not in [0, 1].
+  absl::Status ReportBufferOccupancy(int64_t iteration_id, int64_t consumer_id,
+                                     double buffer_occupancy)
+      TF_LOCKS_EXCLUDED(mu_);
   // Unregisters the worker with `worker_address` for iteration with
   // `iteration_id`, removing its reported processing time from consideration of
   // the current workload estimation. Returns an error if there are no
@@ -168,6 +263,7 @@ class MultipleIterationsAutoScaler {
   // workload estimation.
   void EnsureIterationIsRegistered(int64_t iteration_id)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  tsl::Env* const env_;
   mutable tsl::mutex mu_;
   // Map from iteration id to AutoScaler.
   absl::flat_hash_map<int64_t, std::unique_ptr<AutoScaler>> auto_scalers_
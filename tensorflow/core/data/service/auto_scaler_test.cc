@@ -24,7 +24,10 @@ limitations under the License.
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/fake_clock_env.h"
 #include "tsl/platform/status_matchers.h"
+#include "tsl/platform/statusor.h"
 
 namespace tensorflow {
 namespace data {
@@ -311,6 +314,129 @@ TEST(AutoScalerTest, RemoveConsumerAfterNewTPTReported) {
   TF_ASSERT_OK(auto_scaler.RemoveConsumer(0));
 }
 
+TEST(AutoScalerTest, ForecastAddsWorkersAheadOfRisingDemand) {
+  FakeClockEnv env(Env::Default());
+  AutoScaler auto_scaler(&env);
+  // Worker throughput = 10 elements/s.
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  // Consumption rate grows from 10 to 20 elements/s over 10 seconds.
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.1)));
+  env.AdvanceByMicroseconds(absl::ToInt64Microseconds(absl::Seconds(10)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.05)));
+
+  EXPECT_EQ(auto_scaler.GetOptimalNumberOfWorkers(), 2);
+  // Forecasted consumption rate = 20 + 1 * 10 = 30 elements/s.
+  EXPECT_EQ(auto_scaler.GetForecastedNumberOfWorkers(absl::Seconds(10)), 3);
+}
+
+TEST(AutoScalerTest, ForecastIsNotBelowCurrentDemand) {
+  FakeClockEnv env(Env::Default());
+  AutoScaler auto_scaler(&env);
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.025)));
+  env.AdvanceByMicroseconds(absl::ToInt64Microseconds(absl::Seconds(10)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.05)));
+
+  EXPECT_EQ(auto_scaler.GetForecastedNumberOfWorkers(absl::Seconds(10)), 2);
+}
+
+TEST(AutoScalerTest, ForecastIgnoresShortHistory) {
+  FakeClockEnv env(Env::Default());
+  AutoScaler auto_scaler(&env);
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.1)));
+  env.AdvanceByMicroseconds(absl::ToInt64Microseconds(absl::Seconds(2)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.05)));
+
+  EXPECT_EQ(auto_scaler.GetForecastedNumberOfWorkers(absl::Seconds(10)), 2);
+}
+
+TEST(AutoScalerTest, RecommendedNumberOfWorkersInitialState) {
+  AutoScaler auto_scaler;
+  EXPECT_EQ(auto_scaler.GetRecommendedNumberOfWorkers(
+                /*current_number_of_workers=*/4, absl::Seconds(10)),
+            std::nullopt);
+}
+
+TEST(AutoScalerTest, RecommendedNumberOfWorkersWithoutBufferOccupancy) {
+  AutoScaler auto_scaler;
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.05)));
+  EXPECT_EQ(auto_scaler.GetRecommendedNumberOfWorkers(
+                /*current_number_of_workers=*/4, absl::Seconds(10)),
+            2);
+}
+
+TEST(AutoScalerTest, RecommendedNumberOfWorkersLowBufferOccupancy) {
+  AutoScaler auto_scaler;
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(1, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.ReportBufferOccupancy(0, 0.9));
+  TF_ASSERT_OK(auto_scaler.ReportBufferOccupancy(1, 0.1));
+  // Consumer 1 is about to stall, so a worker is added even though 4 workers
+  // keep up with the reported rates.
+  EXPECT_EQ(auto_scaler.GetRecommendedNumberOfWorkers(
+                /*current_number_of_workers=*/4, absl::Seconds(10)),
+            5);
+}
+
+TEST(AutoScalerTest, RecommendedNumberOfWorkersPartiallyFullBuffers) {
+  AutoScaler auto_scaler;
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.ReportBufferOccupancy(0, 0.5));
+  EXPECT_EQ(auto_scaler.GetRecommendedNumberOfWorkers(
+                /*current_number_of_workers=*/4, absl::Seconds(10)),
+            4);
+  // Rates that need more workers than are running still scale up.
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.01)));
+  EXPECT_EQ(auto_scaler.GetRecommendedNumberOfWorkers(
+                /*current_number_of_workers=*/4, absl::Seconds(10)),
+            10);
+}
+
+TEST(AutoScalerTest, RecommendedNumberOfWorkersFullBuffersScaleDownGradually) {
+  AutoScaler auto_scaler;
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.ReportBufferOccupancy(0, 0.9));
+  EXPECT_EQ(auto_scaler.GetRecommendedNumberOfWorkers(
+                /*current_number_of_workers=*/50, absl::Seconds(10)),
+            45);
+  EXPECT_EQ(auto_scaler.GetRecommendedNumberOfWorkers(
+                /*current_number_of_workers=*/3, absl::Seconds(10)),
+            2);
+}
+
+TEST(AutoScalerTest, ReportBufferOccupancyOutOfRange) {
+  AutoScaler auto_scaler;
+  EXPECT_THAT(auto_scaler.ReportBufferOccupancy(0, -0.1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(auto_scaler.ReportBufferOccupancy(0, 1.5),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(AutoScalerTest, RemoveConsumerRemovesBufferOccupancy) {
+  AutoScaler auto_scaler;
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(0, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.ReportBufferOccupancy(0, 0.1));
+  TF_ASSERT_OK(auto_scaler.ReportTargetProcessingTime(1, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.RemoveConsumer(0));
+  EXPECT_EQ(auto_scaler.GetRecommendedNumberOfWorkers(
+                /*current_number_of_workers=*/4, absl::Seconds(10)),
+            2);
+}
+
 TEST(MultipleIterationsAutoScalerTest, UnregisterExistingIteration) {
   MultipleIterationsAutoScaler auto_scaler;
   TF_ASSERT_OK(
@@ -746,6 +872,91 @@ TEST(MultipleIterationsAutoScalerTest, RemoveConsumerAfterNewTPTReported) {
   TF_ASSERT_OK(auto_scaler.RemoveConsumer(0, 0));
 }
 
+TEST(MultipleIterationsAutoScalerTest, GetScalingRecommendationInitialState) {
+  MultipleIterationsAutoScaler auto_scaler;
+  EXPECT_THAT(auto_scaler.GetScalingRecommendation(1),
+              StatusIs(absl::StatusCode::kUnavailable));
+}
+
+TEST(MultipleIterationsAutoScalerTest,
+     GetScalingRecommendationInvalidCurrentNumberOfWorkers) {
+  MultipleIterationsAutoScaler auto_scaler;
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime(0, "/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(
+      auto_scaler.ReportTargetProcessingTime(0, 0, absl::Seconds(0.05)));
+  EXPECT_THAT(auto_scaler.GetScalingRecommendation(0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MultipleIterationsAutoScalerTest, GetScalingRecommendationScaleUp) {
+  MultipleIterationsAutoScaler auto_scaler;
+  // Iteration 0 keeps up with 4 workers, but its consumer is about to stall.
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime(0, "/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(
+      auto_scaler.ReportTargetProcessingTime(0, 0, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.ReportBufferOccupancy(0, 0, 0.1));
+  // Iteration 1 has full buffers.
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime(1, "/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(
+      auto_scaler.ReportTargetProcessingTime(1, 0, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.ReportBufferOccupancy(1, 0, 1.0));
+
+  TF_ASSERT_OK_AND_ASSIGN(ScalingRecommendation recommendation,
+                          auto_scaler.GetScalingRecommendation(4));
+  EXPECT_EQ(recommendation.action, ScalingRecommendation::Action::kScaleUp);
+  EXPECT_EQ(recommendation.number_of_workers, 5);
+}
+
+TEST(MultipleIterationsAutoScalerTest, GetScalingRecommendationScaleDown) {
+  MultipleIterationsAutoScaler auto_scaler;
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime(0, "/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(
+      auto_scaler.ReportTargetProcessingTime(0, 0, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.ReportBufferOccupancy(0, 0, 0.8));
+
+  TF_ASSERT_OK_AND_ASSIGN(ScalingRecommendation recommendation,
+                          auto_scaler.GetScalingRecommendation(20));
+  EXPECT_EQ(recommendation.action, ScalingRecommendation::Action::kScaleDown);
+  EXPECT_EQ(recommendation.number_of_workers, 18);
+}
+
+TEST(MultipleIterationsAutoScalerTest, GetScalingRecommendationKeep) {
+  MultipleIterationsAutoScaler auto_scaler;
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime(0, "/worker/task/0:20000",
+                                                absl::Seconds(0.1)));
+  TF_ASSERT_OK(
+      auto_scaler.ReportTargetProcessingTime(0, 0, absl::Seconds(0.05)));
+  TF_ASSERT_OK(auto_scaler.ReportBufferOccupancy(0, 0, 0.5));
+
+  TF_ASSERT_OK_AND_ASSIGN(ScalingRecommendation recommendation,
+                          auto_scaler.GetScalingRecommendation(4));
+  EXPECT_EQ(recommendation.action, ScalingRecommendation::Action::kKeep);
+  EXPECT_EQ(recommendation.number_of_workers, 4);
+}
+
+TEST(MultipleIterationsAutoScalerTest, GetScalingRecommendationIsBounded) {
+  MultipleIterationsAutoScaler auto_scaler;
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime(0, "/worker/task/0:20000",
+                                                absl::Seconds(1)));
+  TF_ASSERT_OK(
+      auto_scaler.ReportTargetProcessingTime(0, 0, absl::Seconds(0.01)));
+
+  TF_ASSERT_OK_AND_ASSIGN(ScalingRecommendation recommendation,
+                          auto_scaler.GetScalingRecommendation(10));
+  EXPECT_EQ(recommendation.action, ScalingRecommendation::Action::kScaleUp);
+  EXPECT_EQ(recommendation.number_of_workers, 40);
+}
+
+TEST(MultipleIterationsAutoScalerTest, ReportBufferOccupancyOutOfRange) {
+  MultipleIterationsAutoScaler auto_scaler;
+  EXPECT_THAT(auto_scaler.ReportBufferOccupancy(0, 0, 2.0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 }  // namespace
 
 }  // namespace data
@@ -42,6 +42,11 @@ struct DataServiceParams final {
   TargetWorkers target_workers = TargetWorkers::TARGET_WORKERS_UNSPECIFIED;
   DataServiceMetadata metadata;
   std::optional<CrossTrainerCacheOptions> cross_trainer_cache_options;
+  // Whether to hedge against slow workers when reads are not coordinated: a
+  // `GetElement` request that has been outstanding for longer than the recent
+  // tail latency stops counting towards `max_outstanding_requests`, so that
+  // another request is issued to a different worker in the meantime.
+  bool hedge_requests = false;
 };
 
 }  // namespace data
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/client/data_service_client.h"
 
 #include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <functional>
 #include <limits>
 #include <memory>
@@ -60,6 +61,21 @@ namespace tensorflow {
 namespace data {
 namespace {
 
+// Percentile of the recent `GetElement` latencies after which an in-progress
+// request is considered a straggler.
+constexpr double kHedgePercentile = 95.0;
+// Number of latency samples needed before requests are hedged.
+constexpr int64_t kMinHedgeLatencySamples = 20;
+// The latency histogram is reset after this many samples so that the hedging
+// threshold follows changes in worker load.
+constexpr int64_t kMaxHedgeLatencySamples = 10000;
+// Requests are never hedged before they have been outstanding this long.
+constexpr int64_t kMinHedgeDelayMicros = 2000;
+// Maximum number of in-progress requests that may be hedged at the same time.
+constexpr int64_t kMaxHedgedRequests = 4;
+// How often idle worker threads look for straggling requests.
+constexpr std::chrono::microseconds kHedgeCheckInterval(kMinHedgeDelayMicros);
+
 bool IsColocatedTask(const TaskInfo& task) {
   return absl::c_any_of(task.worker_tags(), [](std::string_view worker_tag) {
     return absl::AsciiStrToUpper(worker_tag) == kColocatedWorkerTag;
@@ -456,6 +472,13 @@ void DataServiceClient::Heartbeat() TF_LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
     double target_processing_time_nsec = ctx_->GetTargetProcessingTimeNsec();
     req.set_target_processing_time_nsec(target_processing_time_nsec);
+    // Round-robin reads enqueue placeholder results before their data
+    // arrives, so `results_` does not reflect the ready elements.
+    if (!IsCoordinatedRead() && max_outstanding_requests_ > 0) {
+      req.set_buffer_occupancy(
+          std::min(1.0, static_cast<double>(results_.size()) /
+                            max_outstanding_requests_));
+    }
   }
   ClientHeartbeatResponse resp;
   Status s = dispatcher_->ClientHeartbeat(req, resp);
@@ -589,8 +612,11 @@ void DataServiceClient::UpdateBufferSize() TF_LOCKS_EXCLUDED(mu_) {
 
 void DataServiceClient::UpdateWorkerThreads() TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
-  const int64_t max_num_threads =
-      std::min<int64_t>(tasks_.size(), max_outstanding_requests_);
+  // Hedged requests don't count towards `max_outstanding_requests_`, so extra
+  // threads are needed to issue requests while stragglers are in progress.
+  const int64_t max_num_threads = std::min<int64_t>(
+      tasks_.size(),
+      max_outstanding_requests_ + (ShouldHedge() ? kMaxHedgedRequests : 0));
   while (num_running_worker_threads_ < max_num_threads && !cancelled_ &&
          status_.ok()) {
     num_running_worker_threads_++;
@@ -623,8 +649,7 @@ void DataServiceClient::RunWorkerThread(std::function<void()> done)
     {
       mutex_lock l(mu_);
       if (task_to_process) {
-        task_to_process->in_use = false;
-        --outstanding_requests_;
+        ReleaseTask(*task_to_process);
         task_to_process = nullptr;
         worker_thread_cv_.notify_one();
       }
@@ -632,16 +657,25 @@ void DataServiceClient::RunWorkerThread(std::function<void()> done)
         if (cancelled_ || !ShouldWaitForNext()) {
           return;
         }
+        if (ShouldHedge()) {
+          HedgeStragglers();
+        }
         task_to_process = GetTaskToProcess();
         if (task_to_process) {
           VLOG(3) << "Selected a task to process: "
                   << task_to_process->info.ShortDebugString();
           break;
         }
-        worker_thread_cv_.wait(l);
+        if (ShouldHedge()) {
+          // Wake up periodically to check for requests that became stragglers.
+          worker_thread_cv_.wait_for(l, kHedgeCheckInterval);
+        } else {
+          worker_thread_cv_.wait(l);
+        }
       }
       DCHECK(task_to_process != nullptr);
       task_to_process->in_use = true;
+      task_to_process->request_start_micros = Env::Default()->NowMicros();
       ++outstanding_requests_;
       if (IsCoordinatedRead()) {
         // Reserve a spot in the results_ queue.
@@ -662,8 +696,7 @@ void DataServiceClient::RunWorkerThread(std::function<void()> done)
       mutex_lock l(mu_);
       VLOG(1) << "Failed to get element from worker "
               << task_to_process->info.worker_address() << ": " << s;
-      task_to_process->in_use = false;
-      --outstanding_requests_;
+      ReleaseTask(*task_to_process);
       status_ = errors::CreateWithUpdatedMessage(
           s, absl::StrCat("Failed to get element from worker ",
                           task_to_process->info.worker_address(), ": ",
@@ -672,6 +705,14 @@ void DataServiceClient::RunWorkerThread(std::function<void()> done)
       return;
     }
 
+    {
+      mutex_lock l(mu_);
+      if (!result->skip && !result->end_of_sequence) {
+        RecordGetElementLatency(*task_to_process,
+                                Env::Default()->NowMicros() -
+                                    task_to_process->request_start_micros);
+      }
+    }
     if (!IsCoordinatedRead()) {
       if (mutex_lock l(mu_); result->skip) {
         num_consecutive_skipped++;
@@ -702,8 +743,9 @@ bool DataServiceClient::ShouldProcessTask() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   }
   // Otherwise, results aren't added to `results_` until the data has been
   // successfully retrieved. We need to count requests already added to
-  // `results_` as well as in-progress requests.
-  return results_.size() + outstanding_requests_ < max_outstanding_requests_;
+  // `results_` as well as in-progress requests, except for hedged ones.
+  return results_.size() + outstanding_requests_ - hedged_requests_ <
+         max_outstanding_requests_;
 }
 
 // Searches for a task to process, visiting tasks in-order and giving every
@@ -754,6 +796,82 @@ void DataServiceClient::AdvanceTaskIndex() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   }
 }
 
+void DataServiceClient::ReleaseTask(Task& task)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  task.in_use = false;
+  --outstanding_requests_;
+  if (!task.hedged) {
+    return;
+  }
+  task.hedged = false;
+  --hedged_requests_;
+  const int64_t threshold_micros = HedgeThresholdMicros();
+  if (threshold_micros < 0) {
+    return;
+  }
+  const int64_t latency_micros =
+      Env::Default()->NowMicros() - task.request_start_micros;
+  // A straggler that kept going long after it was hedged shows that hedging
+  // pays off; one that finished soon after only added memory pressure.
+  if (latency_micros >= 2 * threshold_micros) {
+    hedge_budget_ = std::min(hedge_budget_ + 1, kMaxHedgedRequests);
+  } else {
+    hedge_budget_ = std::max<int64_t>(1, hedge_budget_ / 2);
+  }
+}
+
+bool DataServiceClient::ShouldHedge() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // Coordinated reads need a result from every task in each round, so
+  // reading from another task can't make up for a slow one.
+  return params_.hedge_requests && !IsCoordinatedRead() && tasks_.size() > 1;
+}
+
+int64_t DataServiceClient::HedgeThresholdMicros() const
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (num_get_element_latency_samples_ < kMinHedgeLatencySamples) {
+    return -1;
+  }
+  return std::max<int64_t>(
+      kMinHedgeDelayMicros,
+      get_element_latency_usecs_.Percentile(kHedgePercentile));
+}
+
+void DataServiceClient::HedgeStragglers() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const int64_t threshold_micros = HedgeThresholdMicros();
+  if (threshold_micros < 0) {
+    return;
+  }
+  const int64_t now_micros = Env::Default()->NowMicros();
+  for (const std::shared_ptr<Task>& task : tasks_) {
+    if (hedged_requests_ >= hedge_budget_) {
+      return;
+    }
+    if (!task->in_use || task->hedged ||
+        now_micros - task->request_start_micros < threshold_micros) {
+      continue;
+    }
+    VLOG(2) << "Hedging request to worker " << task->info.worker_address()
+            << " which has been outstanding for "
+            << now_micros - task->request_start_micros << " microseconds.";
+    task->hedged = true;
+    ++hedged_requests_;
+    metrics::RecordTFDataServiceClientHedgedRequest();
+  }
+}
+
+void DataServiceClient::RecordGetElementLatency(const Task& task,
+                                                int64_t latency_micros)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  metrics::RecordTFDataServiceClientGetElementLatency(
+      task.info.worker_address(), latency_micros);
+  if (num_get_element_latency_samples_ >= kMaxHedgeLatencySamples) {
+    get_element_latency_usecs_.Clear();
+    num_get_element_latency_samples_ = 0;
+  }
+  get_element_latency_usecs_.Add(latency_micros);
+  ++num_get_element_latency_samples_;
+}
+
 Status DataServiceClient::TryGetElement(const Task& task, bool allow_skip,
                                         GetElementResult& result) {
   GetElementRequest req;
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/worker_client.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
@@ -110,6 +111,11 @@ class DataServiceClient {
     bool skipped_previous_round = false;
     // Indicates whether a worker thread is currently processing the task.
     bool in_use TF_GUARDED_BY(&DataServiceClient::mu_) = false;
+    // The time at which the in-progress request to the task was issued.
+    int64_t request_start_micros TF_GUARDED_BY(&DataServiceClient::mu_) = 0;
+    // Whether the in-progress request to the task is a straggler which no
+    // longer counts towards `max_outstanding_requests_`.
+    bool hedged TF_GUARDED_BY(&DataServiceClient::mu_) = false;
     // Indicates whether the worker has returned end_of_sequence for the task.
     bool end_of_sequence TF_GUARDED_BY(&DataServiceClient::mu_) = false;
     // Number of retries. The more it is retried, the longer it should wait
@@ -176,6 +182,18 @@ class DataServiceClient {
   // task a chance to proceed.
   std::shared_ptr<Task> GetTaskToProcess();
   void AdvanceTaskIndex();
+  // Marks the in-progress request to `task` as done.
+  void ReleaseTask(Task& task) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Whether straggling requests should be hedged.
+  bool ShouldHedge() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns the latency after which an in-progress request is considered a
+  // straggler, or -1 if there are not enough latency samples yet.
+  int64_t HedgeThresholdMicros() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Stops counting straggling requests towards `max_outstanding_requests_`,
+  // up to `hedge_budget_` requests at a time.
+  void HedgeStragglers() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void RecordGetElementLatency(const Task& task, int64_t latency_micros)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   Status TryGetElement(const Task& task, bool allow_skip,
                        GetElementResult& result);
   void ProcessGetElementResponse(bool enqueue_result,
@@ -209,6 +227,18 @@ class DataServiceClient {
   // elements as well as completed requests which haven't yet been produced.
   int64_t max_outstanding_requests_ TF_GUARDED_BY(mu_);
 
+  // The number of in-progress requests which have been hedged, and the maximum
+  // number of requests which may be hedged at the same time. The budget grows
+  // while hedged requests turn out to be long stragglers and shrinks when they
+  // complete shortly after being hedged.
+  int64_t hedged_requests_ TF_GUARDED_BY(mu_) = 0;
+  int64_t hedge_budget_ TF_GUARDED_BY(mu_) = 1;
+
+  // Recent latencies of successful `GetElement` requests across all tasks, and
+  // the number of samples in the histogram.
+  histogram::Histogram get_element_latency_usecs_ TF_GUARDED_BY(mu_);
+  int64_t num_get_element_latency_samples_ TF_GUARDED_BY(mu_) = 0;
+
   // The number of threads in `worker_threads_` which are still running.
   int64_t num_running_worker_threads_ TF_GUARDED_BY(mu_) = 0;
 
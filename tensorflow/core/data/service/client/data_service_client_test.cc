@@ -176,6 +176,25 @@ TEST(DataServiceClientTest, StaticSharding) {
   client.Cancel();
 }
 
+TEST(DataServiceClientTest, HedgedRequests) {
+  TestCluster test_cluster(/*num_workers=*/3);
+  TF_ASSERT_OK(test_cluster.Initialize());
+  DatasetClient<int64_t> test_dataset(test_cluster);
+  TF_ASSERT_OK_AND_ASSIGN(std::string dataset_id,
+                          test_dataset.RegisterDataset(RangeDataset(1000)));
+
+  DataServiceParams params = GetDataServiceParams(
+      dataset_id, test_cluster.DispatcherAddress(), ProcessingModeDef::DYNAMIC);
+  params.max_outstanding_requests = 2;
+  params.hedge_requests = true;
+  DataServiceClient client(params);
+  TF_ASSERT_OK(client.Initialize(/*accelerator_device_info=*/nullptr,
+                                 /*allocator=*/nullptr));
+  EXPECT_THAT(GetResults<int64_t>(client),
+              IsOkAndHolds(UnorderedElementsAreArray(Range(1000))));
+  client.Cancel();
+}
+
 TEST(DataServiceClientTest, RecordBufferEvents) {
   TestCluster test_cluster(/*num_workers=*/1);
   TF_ASSERT_OK(test_cluster.Initialize());
@@ -19,18 +19,27 @@ limitations under the License.
 #include <deque>
 #include <functional>
 #include <limits>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/data/service/byte_size.h"
 #include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace data {
@@ -46,6 +55,11 @@ namespace data {
 // collected when the cache becomes full. Consequently, trainers read from a
 // sliding window through the dataset and may not read the full dataset.
 //
+// Optionally, the cache has a second tier on local disk (see
+// `CrossTrainerCacheDiskOptions`). Elements evicted from memory are spilled to
+// disk asynchronously, and trainers that fall behind the in-memory window read
+// them from disk, ahead of their position, instead of skipping them.
+//
 // The `CrossTrainerCache` class is thread-safe.
 //
 // Example usage:
@@ -89,6 +103,35 @@ class CachableSequence {
 
   // Returns the estimated size of the element in bytes.
   virtual size_t GetElementSizeBytes(const ElementType&) const = 0;
+
+  // Serializes the element to spill it to disk. Only used if the cache has a
+  // disk tier.
+  virtual StatusOr<std::string> Serialize(const ElementType&) const {
+    return errors::Unimplemented(
+        "This sequence does not support spilling elements to disk.");
+  }
+
+  // Parses an element serialized by `Serialize`.
+  virtual StatusOr<ElementType> Deserialize(absl::string_view) const {
+    return errors::Unimplemented(
+        "This sequence does not support spilling elements to disk.");
+  }
+};
+
+// Options for the disk tier of a `CrossTrainerCache`.
+struct CrossTrainerCacheDiskOptions {
+  // The directory to spill elements evicted from memory to. If empty, the disk
+  // tier is disabled.
+  std::string directory;
+  // Maximum size of the spilled elements in bytes. The oldest spilled elements
+  // are deleted when the disk tier becomes full.
+  size_t max_size_bytes = 0;
+  // Number of spilled elements each trainer reads ahead of its position.
+  size_t prefetch_elements = 8;
+  // Maximum in-memory size of the evicted elements waiting to be written. If
+  // the disk cannot keep up, further evicted elements are dropped instead of
+  // spilled. If 0, this is a quarter of the memory budget of the cache.
+  size_t max_pending_spill_bytes = 0;
 };
 
 // Sliding-window cache shared across concurrent trainers.
@@ -98,10 +141,14 @@ class CrossTrainerCache {
   // Creates a `CrossTrainerCache` with `max_cache_size_bytes` of memory budget.
   // The cache should be able to hold at least one element, i.e.:
   // REQUIRES: `max_cache_size_bytes >= max(GetElementSizeBytes(*))`
+  //
+  // If `disk_options.directory` is set, `cachable_sequence` must implement
+  // `Serialize` and `Deserialize`.
   explicit CrossTrainerCache(
       size_t max_cache_size_bytes,
-      std::unique_ptr<CachableSequence<ElementType>> cachable_sequence);
-  virtual ~CrossTrainerCache() = default;
+      std::unique_ptr<CachableSequence<ElementType>> cachable_sequence,
+      const CrossTrainerCacheDiskOptions& disk_options = {});
+  virtual ~CrossTrainerCache();
   CrossTrainerCache(const CrossTrainerCache&) = delete;
   CrossTrainerCache& operator=(const CrossTrainerCache&) = delete;
 
@@ -124,6 +171,23 @@ class CrossTrainerCache {
   struct CacheQueryResult {
     std::shared_ptr<const ElementType> element;
     bool cache_hit;
+    // Whether the element was read from the disk tier.
+    bool from_disk = false;
+  };
+
+  // An element evicted from memory into the disk tier.
+  struct SpilledElement {
+    // The element while it is being written to disk.
+    std::shared_ptr<const ElementType> pending;
+    // The size of the element in bytes. This is the in-memory size until the
+    // element has been written, and the size of its file afterwards.
+    size_t size_bytes = 0;
+  };
+
+  // Spilled elements read ahead of the position of one trainer.
+  struct TrainerPrefetch {
+    std::map<size_t, std::shared_ptr<const ElementType>> elements;
+    absl::flat_hash_set<size_t> in_flight;
   };
 
   // Returns the next element and metrics about this query.
@@ -149,6 +213,47 @@ class CrossTrainerCache {
   // `new_element_size_bytes` is the size of the new element being inserted.
   void FreeSpace(size_t new_element_size_bytes);
 
+  bool HasDiskTier() const { return disk_thread_pool_ != nullptr; }
+
+  // Returns true if the next element of `trainer_id` was evicted from memory
+  // and is in the disk tier.
+  bool IsElementSpilled(const std::string& trainer_id);
+
+  // Advances `trainer_id` to its next spilled element, whose index is stored in
+  // `element_index`, and prefetches the elements after it. Returns the element
+  // if it is available in memory, or nullptr if it must be read from disk.
+  std::shared_ptr<const ElementType> GetSpilledElement(
+      const std::string& trainer_id, size_t& element_index);
+
+  // Starts reading the `disk_options_.prefetch_elements` spilled elements from
+  // `it` for `trainer_id`.
+  void Prefetch(const std::string& trainer_id,
+                typename std::map<size_t, SpilledElement>::iterator it);
+
+  // Adds an element evicted from memory to the disk tier, and starts writing
+  // it to disk.
+  void SpillElement(size_t element_index,
+                    std::shared_ptr<const ElementType> element,
+                    size_t size_bytes);
+
+  // Writes a spilled element to disk.
+  void WriteSpilledElement(size_t element_index,
+                           std::shared_ptr<const ElementType> element,
+                           size_t size_bytes);
+
+  // Reads a spilled element from disk.
+  StatusOr<std::shared_ptr<const ElementType>> ReadSpilledElement(
+      size_t element_index) const;
+
+  // Deletes the oldest spilled elements to keep the disk tier size below
+  // `disk_options_.max_size_bytes`.
+  void FreeDiskSpace();
+
+  // Deletes the files of the elements removed from the disk tier.
+  void DeleteExpiredSpillFiles();
+
+  std::string SpillFilename(size_t element_index) const;
+
   // Records the cache hit rate and cache size.
   void RecordMetrics(const CacheQueryResult& result);
 
@@ -178,18 +283,74 @@ class CrossTrainerCache {
   // `trainer_to_element_index_map_[trainer_id] - cache_start_index_`.
   absl::flat_hash_map<std::string, size_t> trainer_to_element_index_map_
       TF_GUARDED_BY(mu_);
+
+  const CrossTrainerCacheDiskOptions disk_options_;
+  // The prefix of the files of spilled elements, which is unique to this cache.
+  std::string spill_file_prefix_;
+
+  // Elements in the disk tier, keyed by their absolute element index. All of
+  // them have been evicted from `cache_`.
+  std::map<size_t, SpilledElement> spilled_elements_ TF_GUARDED_BY(mu_);
+  size_t disk_size_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // The in-memory size of the elements that are being written to disk.
+  size_t pending_spill_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // Files of elements removed from the disk tier, to be deleted outside `mu_`.
+  std::vector<std::string> expired_spill_files_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string, TrainerPrefetch> trainer_prefetches_
+      TF_GUARDED_BY(mu_);
+
+  // Runs disk writes and prefetches. Null if the disk tier is disabled.
+  std::unique_ptr<thread::ThreadPool> disk_thread_pool_;
 };
 
 template <class ElementType>
 CrossTrainerCache<ElementType>::CrossTrainerCache(
     size_t max_cache_size_bytes,
-    std::unique_ptr<CachableSequence<ElementType>> cachable_sequence)
+    std::unique_ptr<CachableSequence<ElementType>> cachable_sequence,
+    const CrossTrainerCacheDiskOptions& disk_options)
     : max_cache_size_bytes_(max_cache_size_bytes),
-      cachable_sequence_(std::move(cachable_sequence)) {
+      cachable_sequence_(std::move(cachable_sequence)),
+      disk_options_(disk_options) {
   DCHECK_GT(max_cache_size_bytes, 0)
       << "CrossTrainerCache size must be greater than 0.";
   VLOG(2) << "Initialized tf.data service cross-trainer cache with "
           << ByteSize::Bytes(max_cache_size_bytes) << " of memory.";
+  if (disk_options_.directory.empty() || disk_options_.max_size_bytes == 0) {
+    return;
+  }
+  Status s = Env::Default()->RecursivelyCreateDir(disk_options_.directory);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to create tf.data service cross-trainer cache "
+                 << "directory " << disk_options_.directory
+                 << "; the cache will only use memory: " << s;
+    return;
+  }
+  spill_file_prefix_ = io::JoinPath(
+      disk_options_.directory,
+      absl::StrCat("cross_trainer_cache_", random::New64(), "_"));
+  disk_thread_pool_ = std::make_unique<thread::ThreadPool>(
+      Env::Default(), "tf_data_service_cross_trainer_cache_disk",
+      /*num_threads=*/4);
+  VLOG(2) << "Initialized tf.data service cross-trainer cache disk tier with "
+          << ByteSize::Bytes(disk_options_.max_size_bytes) << " in "
+          << disk_options_.directory << ".";
+}
+
+template <class ElementType>
+CrossTrainerCache<ElementType>::~CrossTrainerCache() {
+  if (!HasDiskTier()) {
+    return;
+  }
+  // Waits for the pending disk writes and prefetches.
+  disk_thread_pool_.reset();
+  {
+    mutex_lock l(mu_);
+    for (const auto& [element_index, unused] : spilled_elements_) {
+      expired_spill_files_.push_back(SpillFilename(element_index));
+    }
+    spilled_elements_.clear();
+  }
+  DeleteExpiredSpillFiles();
 }
 
 template <class ElementType>
@@ -212,20 +373,28 @@ CrossTrainerCache<ElementType>::GetCacheQueryResult(
     const std::string& trainer_id) {
   bool should_extend_cache = false;
   while (true) {
+    bool should_read_from_disk = false;
+    size_t spilled_element_index = 0;
     {
       mutex_lock l(mu_);
       TF_RETURN_IF_ERROR(status_);
-      if (IsElementReady(trainer_id)) {
+      if (IsElementSpilled(trainer_id)) {
+        std::shared_ptr<const ElementType> element =
+            GetSpilledElement(trainer_id, spilled_element_index);
+        if (element != nullptr) {
+          return CacheQueryResult{element, /*is_cache_hit=*/true,
+                                  /*from_disk=*/true};
+        }
+        should_read_from_disk = true;
+      } else if (IsElementReady(trainer_id)) {
         TF_ASSIGN_OR_RETURN(std::shared_ptr<const ElementType> element,
                             GetElement(trainer_id));
         return CacheQueryResult{element,
                                 /*is_cache_hit=*/!should_extend_cache};
-      }
-
-      // Extends the cache or waits for another thread to extend the cache. When
-      // concurrent trainers wait for the next element, only one of them should
-      // extend the cache.
-      if (extending_cache_) {
+      } else if (extending_cache_) {
+        // Waits for another thread to extend the cache. When concurrent
+        // trainers wait for the next element, only one of them should extend
+        // the cache.
         should_extend_cache = false;
         cv_.wait(l);
       } else {
@@ -234,6 +403,21 @@ CrossTrainerCache<ElementType>::GetCacheQueryResult(
       }
     }
 
+    if (should_read_from_disk) {
+      StatusOr<std::shared_ptr<const ElementType>> element =
+          ReadSpilledElement(spilled_element_index);
+      if (element.ok()) {
+        return CacheQueryResult{*std::move(element), /*is_cache_hit=*/true,
+                                /*from_disk=*/true};
+      }
+      // The element may have been deleted from the disk tier since. Like
+      // elements evicted from memory, the trainer skips it.
+      VLOG(2) << "Failed to read element " << spilled_element_index
+              << " from the tf.data service cross-trainer cache disk tier: "
+              << element.status();
+      continue;
+    }
+
     if (should_extend_cache) {
       Status s = ExtendCache();
       mutex_lock l(mu_);
@@ -289,11 +473,14 @@ Status CrossTrainerCache<ElementType>::ExtendCache() TF_LOCKS_EXCLUDED(mu_) {
         " and cache size: ", max_cache_size_bytes_);
   }
 
-  mutex_lock l(mu_);
-  TF_RETURN_IF_ERROR(status_);
-  FreeSpace(new_element_size_bytes);
-  cache_.push_back(std::make_shared<ElementType>(std::move(element)));
-  cache_size_bytes_ += new_element_size_bytes;
+  {
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(status_);
+    FreeSpace(new_element_size_bytes);
+    cache_.push_back(std::make_shared<ElementType>(std::move(element)));
+    cache_size_bytes_ += new_element_size_bytes;
+  }
+  DeleteExpiredSpillFiles();
   return absl::OkStatus();
 }
 
@@ -305,6 +492,9 @@ void CrossTrainerCache<ElementType>::FreeSpace(size_t new_element_size_bytes)
          cache_size_bytes_ + new_element_size_bytes > max_cache_size_bytes_) {
     size_t free_bytes =
         cachable_sequence_->GetElementSizeBytes(*cache_.front());
+    if (HasDiskTier()) {
+      SpillElement(cache_start_index_, std::move(cache_.front()), free_bytes);
+    }
     cache_.pop_front();
     cache_size_bytes_ -= free_bytes;
     ++cache_start_index_;
@@ -316,6 +506,181 @@ void CrossTrainerCache<ElementType>::FreeSpace(size_t new_element_size_bytes)
           << ByteSize::Bytes(cache_size_bytes_) << ".";
 }
 
+template <class ElementType>
+bool CrossTrainerCache<ElementType>::IsElementSpilled(
+    const std::string& trainer_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (!HasDiskTier()) {
+    return false;
+  }
+  const size_t element_index = trainer_to_element_index_map_[trainer_id];
+  return element_index < cache_start_index_ &&
+         spilled_elements_.lower_bound(element_index) !=
+             spilled_elements_.end();
+}
+
+template <class ElementType>
+std::shared_ptr<const ElementType>
+CrossTrainerCache<ElementType>::GetSpilledElement(
+    const std::string& trainer_id, size_t& element_index)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // Elements that were dropped from the disk tier are skipped.
+  auto it =
+      spilled_elements_.lower_bound(trainer_to_element_index_map_[trainer_id]);
+  element_index = it->first;
+  trainer_to_element_index_map_[trainer_id] = element_index + 1;
+
+  std::shared_ptr<const ElementType> element = it->second.pending;
+  TrainerPrefetch& prefetch = trainer_prefetches_[trainer_id];
+  prefetch.elements.erase(prefetch.elements.begin(),
+                          prefetch.elements.lower_bound(element_index));
+  if (!prefetch.elements.empty() &&
+      prefetch.elements.begin()->first == element_index) {
+    element = std::move(prefetch.elements.begin()->second);
+    prefetch.elements.erase(prefetch.elements.begin());
+  }
+  Prefetch(trainer_id, std::next(it));
+  return element;
+}
+
+template <class ElementType>
+void CrossTrainerCache<ElementType>::Prefetch(
+    const std::string& trainer_id,
+    typename std::map<size_t, SpilledElement>::iterator it)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  TrainerPrefetch& prefetch = trainer_prefetches_[trainer_id];
+  for (size_t i = 0;
+       i < disk_options_.prefetch_elements && it != spilled_elements_.end();
+       ++i, ++it) {
+    const size_t element_index = it->first;
+    if (it->second.pending != nullptr ||
+        prefetch.elements.count(element_index) > 0 ||
+        !prefetch.in_flight.insert(element_index).second) {
+      continue;
+    }
+    disk_thread_pool_->Schedule([this, trainer_id, element_index]() {
+      StatusOr<std::shared_ptr<const ElementType>> element =
+          ReadSpilledElement(element_index);
+      mutex_lock l(mu_);
+      TrainerPrefetch& prefetch = trainer_prefetches_[trainer_id];
+      prefetch.in_flight.erase(element_index);
+      if (element.ok() &&
+          element_index >= trainer_to_element_index_map_[trainer_id]) {
+        prefetch.elements[element_index] = *std::move(element);
+      }
+    });
+  }
+}
+
+template <class ElementType>
+void CrossTrainerCache<ElementType>::SpillElement(
+    size_t element_index, std::shared_ptr<const ElementType> element,
+    size_t size_bytes) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const size_t max_pending_spill_bytes =
+      disk_options_.max_pending_spill_bytes > 0
+          ? disk_options_.max_pending_spill_bytes
+          : max_cache_size_bytes_ / 4;
+  // If the disk cannot keep up, evicted elements are dropped rather than
+  // queued, which bounds the memory used by pending writes.
+  if (size_bytes > disk_options_.max_size_bytes ||
+      (pending_spill_bytes_ > 0 &&
+       pending_spill_bytes_ + size_bytes > max_pending_spill_bytes)) {
+    VLOG(3) << "Dropped element " << element_index << " instead of spilling "
+            << "it to the tf.data service cross-trainer cache disk tier.";
+    return;
+  }
+  pending_spill_bytes_ += size_bytes;
+  disk_size_bytes_ += size_bytes;
+  spilled_elements_[element_index] = SpilledElement{element, size_bytes};
+  FreeDiskSpace();
+  disk_thread_pool_->Schedule(
+      [this, element_index, element = std::move(element), size_bytes]() {
+        WriteSpilledElement(element_index, std::move(element), size_bytes);
+      });
+}
+
+template <class ElementType>
+void CrossTrainerCache<ElementType>::WriteSpilledElement(
+    size_t element_index, std::shared_ptr<const ElementType> element,
+    size_t size_bytes) TF_LOCKS_EXCLUDED(mu_) {
+  const std::string filename = SpillFilename(element_index);
+  size_t file_size_bytes = 0;
+  StatusOr<std::string> data = cachable_sequence_->Serialize(*element);
+  Status s = data.status();
+  if (s.ok()) {
+    file_size_bytes = data->size();
+    s = WriteStringToFile(Env::Default(), filename, *data);
+  }
+  {
+    mutex_lock l(mu_);
+    pending_spill_bytes_ -= size_bytes;
+    auto it = spilled_elements_.find(element_index);
+    if (it == spilled_elements_.end()) {
+      // The element was deleted from the disk tier while it was written.
+      expired_spill_files_.push_back(filename);
+    } else if (!s.ok()) {
+      LOG_EVERY_N_SEC(WARNING, 60)
+          << "Failed to spill element to the tf.data service cross-trainer "
+          << "cache disk tier: " << s;
+      disk_size_bytes_ -= it->second.size_bytes;
+      spilled_elements_.erase(it);
+      expired_spill_files_.push_back(filename);
+    } else {
+      it->second.pending = nullptr;
+      disk_size_bytes_ = disk_size_bytes_ - it->second.size_bytes +
+                         file_size_bytes;
+      it->second.size_bytes = file_size_bytes;
+      FreeDiskSpace();
+    }
+  }
+  DeleteExpiredSpillFiles();
+}
+
+template <class ElementType>
+StatusOr<std::shared_ptr<const ElementType>>
+CrossTrainerCache<ElementType>::ReadSpilledElement(size_t element_index) const
+    TF_LOCKS_EXCLUDED(mu_) {
+  std::string data;
+  TF_RETURN_IF_ERROR(
+      ReadFileToString(Env::Default(), SpillFilename(element_index), &data));
+  TF_ASSIGN_OR_RETURN(ElementType element,
+                      cachable_sequence_->Deserialize(data));
+  return std::make_shared<const ElementType>(std::move(element));
+}
+
+template <class ElementType>
+void CrossTrainerCache<ElementType>::FreeDiskSpace()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  while (!spilled_elements_.empty() &&
+         disk_size_bytes_ > disk_options_.max_size_bytes) {
+    auto it = spilled_elements_.begin();
+    disk_size_bytes_ -= it->second.size_bytes;
+    // Elements that are still being written are deleted by the writer.
+    if (it->second.pending == nullptr) {
+      expired_spill_files_.push_back(SpillFilename(it->first));
+    }
+    spilled_elements_.erase(it);
+  }
+}
+
+template <class ElementType>
+void CrossTrainerCache<ElementType>::DeleteExpiredSpillFiles()
+    TF_LOCKS_EXCLUDED(mu_) {
+  std::vector<std::string> expired_spill_files;
+  {
+    mutex_lock l(mu_);
+    expired_spill_files.swap(expired_spill_files_);
+  }
+  for (const std::string& filename : expired_spill_files) {
+    Env::Default()->DeleteFile(filename).IgnoreError();
+  }
+}
+
+template <class ElementType>
+std::string CrossTrainerCache<ElementType>::SpillFilename(
+    size_t element_index) const {
+  return absl::StrCat(spill_file_prefix_, element_index);
+}
+
 template <class ElementType>
 void CrossTrainerCache<ElementType>::Cancel(Status status)
     TF_LOCKS_EXCLUDED(mu_) {
@@ -340,6 +705,8 @@ template <class ElementType>
 void CrossTrainerCache<ElementType>::RecordMetrics(
     const CacheQueryResult& result) {
   metrics::RecordTFDataServiceCrossTrainerCacheQuery(result.cache_hit);
+  metrics::RecordTFDataServiceCrossTrainerCacheTierQuery(
+      result.from_disk ? "disk" : (result.cache_hit ? "memory" : "miss"));
   size_t cache_size_bytes = 0;
   {
     mutex_lock l(mu_);
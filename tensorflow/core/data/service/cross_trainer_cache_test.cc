@@ -22,14 +22,18 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/status_matchers.h"
@@ -61,6 +65,31 @@ class InfiniteRange : public CachableSequence<int64_t> {
   int64_t next_ = 0;
 };
 
+// An `InfiniteRange` whose elements can be spilled to disk.
+class SpillableInfiniteRange : public InfiniteRange {
+ public:
+  absl::StatusOr<std::string> Serialize(const int64_t& element) const override {
+    return absl::StrCat(element);
+  }
+  absl::StatusOr<int64_t> Deserialize(absl::string_view data) const override {
+    int64_t element = 0;
+    if (!absl::SimpleAtoi(data, &element)) {
+      return errors::DataLoss("Invalid element ", data);
+    }
+    return element;
+  }
+};
+
+CrossTrainerCacheDiskOptions TestDiskOptions(size_t max_size_bytes) {
+  CrossTrainerCacheDiskOptions disk_options;
+  disk_options.directory = io::JoinPath(
+      testing::TmpDir(), absl::StrCat("cross_trainer_cache_", random::New64()));
+  disk_options.max_size_bytes = max_size_bytes;
+  // Spills all evicted elements, however slow the disk is.
+  disk_options.max_pending_spill_bytes = 1 << 20;
+  return disk_options;
+}
+
 class TensorDataset : public CachableSequence<Tensor> {
  public:
   absl::StatusOr<Tensor> GetNext() override { return Tensor("Test Tensor"); }
@@ -285,6 +314,65 @@ TEST(CrossTrainerCacheTest, CacheSizeMetrics) {
   }
 }
 
+TEST(CrossTrainerCacheTest, SlowTrainersReadFromDisk) {
+  CellReader<int64_t> cell_reader(
+      "/tensorflow/data/service/cross_trainer_cache_tier_queries");
+  CrossTrainerCache<int64_t> cache(
+      /*max_cache_size_bytes=*/5 * sizeof(int64_t),
+      std::make_unique<SpillableInfiniteRange>(),
+      TestDiskOptions(/*max_size_bytes=*/1 << 20));
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_THAT(cache.Get("Fast trainer"), IsOkAndHolds(Pointee(i)));
+  }
+  EXPECT_EQ(cell_reader.Delta("miss"), 20);
+
+  // The slow trainer reads the 15 evicted elements from disk, and the last 5
+  // from memory.
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_THAT(cache.Get("Slow trainer"), IsOkAndHolds(Pointee(i)));
+  }
+  EXPECT_EQ(cell_reader.Delta("disk"), 15);
+  EXPECT_EQ(cell_reader.Delta("memory"), 5);
+  EXPECT_EQ(cell_reader.Delta("miss"), 0);
+}
+
+TEST(CrossTrainerCacheTest, DiskTierIsBounded) {
+  CrossTrainerCache<int64_t> cache(
+      /*max_cache_size_bytes=*/5 * sizeof(int64_t),
+      std::make_unique<SpillableInfiniteRange>(),
+      TestDiskOptions(/*max_size_bytes=*/5 * sizeof(int64_t)));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_THAT(cache.Get("Fast trainer"), IsOkAndHolds(Pointee(i)));
+  }
+
+  // The oldest spilled elements have been deleted, so the slow trainer skips
+  // them.
+  std::vector<int64_t> elements;
+  for (int i = 0; i < 5; ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const int64_t> element,
+                            cache.Get("Slow trainer"));
+    elements.push_back(*element);
+  }
+  EXPECT_GT(elements.front(), 0);
+  EXPECT_TRUE(SequenceIsIncreasing(elements));
+}
+
+TEST(CrossTrainerCacheTest, DeletesSpilledElements) {
+  CrossTrainerCacheDiskOptions disk_options =
+      TestDiskOptions(/*max_size_bytes=*/1 << 20);
+  {
+    CrossTrainerCache<int64_t> cache(
+        /*max_cache_size_bytes=*/sizeof(int64_t),
+        std::make_unique<SpillableInfiniteRange>(), disk_options);
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_THAT(cache.Get("Trainer"), IsOkAndHolds(Pointee(i)));
+    }
+  }
+  std::vector<std::string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(disk_options.directory, &children));
+  EXPECT_TRUE(children.empty());
+}
+
 TEST(CrossTrainerCacheTest, ConcurrentReaders) {
   size_t num_trainers = 10;
   size_t num_elements_to_read = 200;
@@ -152,6 +152,43 @@ Status DataServiceDispatcherClient::GetSplit(int64_t iteration_id,
   return absl::OkStatus();
 }
 
+Status DataServiceDispatcherClient::GetSplits(
+    int64_t iteration_id, int64_t repetition, int64_t split_provider_index,
+    int64_t max_splits, int64_t requester_id, int64_t request_index,
+    std::vector<Tensor>& splits, bool& end_of_splits) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  GetSplitRequest req;
+  req.set_iteration_id(iteration_id);
+  req.set_repetition(repetition);
+  req.set_split_provider_index(split_provider_index);
+  req.set_max_splits(max_splits);
+  req.set_requester_id(requester_id);
+  req.set_request_index(request_index);
+  GetSplitResponse resp;
+  grpc::ClientContext client_ctx;
+  grpc::Status status = stub_->GetSplit(&client_ctx, req, &resp);
+  if (!status.ok()) {
+    return grpc_util::WrapError("Failed to get splits", status);
+  }
+  end_of_splits = resp.end_of_splits();
+  for (const TensorProto& split_proto : resp.splits()) {
+    Tensor split;
+    if (!split.FromProto(split_proto)) {
+      return errors::Internal("Failed to parse split tensor proto");
+    }
+    splits.push_back(std::move(split));
+  }
+  // Dispatchers that predate batched split fetching only fill `split`.
+  if (resp.splits().empty() && resp.has_split()) {
+    Tensor split;
+    if (!split.FromProto(resp.split())) {
+      return errors::Internal("Failed to parse split tensor proto");
+    }
+    splits.push_back(std::move(split));
+  }
+  return absl::OkStatus();
+}
+
 Status DataServiceDispatcherClient::Snapshot(
     const DatasetDef& dataset, const std::string& path,
     const experimental::DistributedSnapshotMetadata& metadata) {
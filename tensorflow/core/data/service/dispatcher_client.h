@@ -67,6 +67,16 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
                   int64_t split_provider_index, Tensor& split,
                   bool& end_of_splits);
 
+  // Gets up to `max_splits` splits for the specified iteration id, repetition,
+  // and split provider index, appending them to `splits`. `requester_id` and
+  // `request_index` identify the request so that the dispatcher can return the
+  // same splits if the request is retried. `end_of_splits` is set once the
+  // split provider is exhausted; `splits` may be non-empty in that case.
+  Status GetSplits(int64_t iteration_id, int64_t repetition,
+                   int64_t split_provider_index, int64_t max_splits,
+                   int64_t requester_id, int64_t request_index,
+                   std::vector<Tensor>& splits, bool& end_of_splits);
+
   // Gets the next split for the specified source of a stream of the snapshot in
   // `base_path`. If `end_of_splits` returns true, then there are no more splits
   // to be processed for the specified stream source.
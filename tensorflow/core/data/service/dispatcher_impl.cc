@@ -65,6 +65,7 @@ limitations under the License.
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -231,23 +232,21 @@ Status DataServiceDispatcherImpl::Start() {
     started_ = true;
     return absl::OkStatus();
   }
-  journal_writer_ =
-      std::make_unique<FileJournalWriter>(env_, JournalDir(config_.work_dir()));
+  const std::string journal_dir = JournalDir(config_.work_dir());
+  journal_writer_ = std::make_unique<GroupCommitJournalWriter>(
+      env_, std::make_unique<FileJournalWriter>(env_, journal_dir));
   LOG(INFO) << "Attempting to restore dispatcher state from journal in "
-            << JournalDir(config_.work_dir());
-  Update update;
-  bool end_of_journal = false;
-  FileJournalReader reader(env_, JournalDir(config_.work_dir()));
-  Status s = reader.Read(update, end_of_journal);
-  if (errors::IsNotFound(s)) {
+            << journal_dir;
+  int64_t start = env_->NowMicros();
+  absl::StatusOr<std::vector<Update>> updates =
+      ReadJournal(env_, journal_dir, port::MaxParallelism());
+  if (errors::IsNotFound(updates.status())) {
     LOG(INFO) << "No journal found. Starting dispatcher from new state.";
-  } else if (!s.ok()) {
-    return s;
+  } else if (!updates.ok()) {
+    return updates.status();
   } else {
-    int64_t start = env_->NowMicros();
-    while (!end_of_journal) {
+    for (const Update& update : *updates) {
       TF_RETURN_IF_ERROR(ApplyWithoutJournaling(update));
-      TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
     }
     absl::Duration duration = absl::Microseconds(env_->NowMicros() - start);
     LOG(INFO) << "Restored from journal in " << duration << ".";
@@ -538,6 +537,22 @@ Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
           << ", repetition " << repetition << ", split provider index "
           << provider_index;
   mutex_lock l(get_split_mu_);
+  if (request->requester_id() != 0) {
+    mutex_lock cache_lock(split_cache_mu_);
+    auto iteration_it = cached_split_responses_.find(iteration_id);
+    if (iteration_it != cached_split_responses_.end()) {
+      auto it = iteration_it->second.find(
+          {provider_index, request->requester_id()});
+      if (it != iteration_it->second.end() &&
+          it->second.request_index == request->request_index()) {
+        VLOG(3) << "Returning cached splits for retried GetSplit request "
+                << request->request_index() << " from requester "
+                << request->requester_id();
+        *response = it->second.response;
+        return absl::OkStatus();
+      }
+    }
+  }
   int64_t current_repetition = 0;
   SplitProvider* split_provider = nullptr;
   {
@@ -567,6 +582,9 @@ Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
     // repetition.
     TF_RETURN_IF_ERROR(split_provider->Reset());
   }
+  if (request->max_splits() > 1) {
+    return GetSplits(*request, *split_provider, *response);
+  }
   Tensor split;
   bool end_of_splits = false;
   TF_RETURN_IF_ERROR(split_provider->GetNext(&split, &end_of_splits));
@@ -584,6 +602,45 @@ Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
   return absl::OkStatus();
 }
 
+Status DataServiceDispatcherImpl::GetSplits(const GetSplitRequest& request,
+                                            SplitProvider& split_provider,
+                                            GetSplitResponse& response)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(get_split_mu_) {
+  bool end_of_splits = false;
+  while (!end_of_splits && response.splits_size() < request.max_splits()) {
+    Tensor split;
+    TF_RETURN_IF_ERROR(split_provider.GetNext(&split, &end_of_splits));
+    if (!end_of_splits) {
+      split.AsProtoTensorContent(response.add_splits());
+    }
+  }
+  if (response.splits_size() > 0) {
+    TF_RETURN_IF_ERROR(RecordSplitProduced(
+        request.iteration_id(), request.repetition(),
+        request.split_provider_index(), /*finished=*/false,
+        response.splits_size()));
+  }
+  if (end_of_splits) {
+    TF_RETURN_IF_ERROR(RecordSplitProduced(
+        request.iteration_id(), request.repetition(),
+        request.split_provider_index(), /*finished=*/true));
+    // Reset the split provider to prepare for the next iteration.
+    TF_RETURN_IF_ERROR(split_provider.Reset());
+  }
+  response.set_end_of_splits(end_of_splits);
+  if (request.requester_id() != 0) {
+    mutex_lock cache_lock(split_cache_mu_);
+    CachedSplitResponse& cached =
+        cached_split_responses_[request.iteration_id()][{
+            request.split_provider_index(), request.requester_id()}];
+    cached.request_index = request.request_index();
+    cached.response = response;
+  }
+  VLOG(3) << "Returning from GetSplit, num_splits=" << response.splits_size()
+          << ", end_of_splits=" << end_of_splits;
+  return absl::OkStatus();
+}
+
 Status DataServiceDispatcherImpl::MakeSplitProviders(
     const std::string& dataset_id,
     std::vector<std::unique_ptr<SplitProvider>>& split_providers)
@@ -1146,6 +1203,18 @@ Status DataServiceDispatcherImpl::ClientHeartbeat(
             << request->iteration_client_id()
             << " to tf.data service AutoScaler: " << auto_scaler_status;
   }
+  if (request->optional_buffer_occupancy_case() ==
+      ClientHeartbeatRequest::kBufferOccupancy) {
+    auto_scaler_status = auto_scaler_.ReportBufferOccupancy(
+        iteration->iteration_id, request->iteration_client_id(),
+        request->buffer_occupancy());
+    if (!auto_scaler_status.ok()) {
+      VLOG(1) << "Failed to report buffer occupancy for Iteration "
+              << iteration->iteration_id << " and consumer ID "
+              << request->iteration_client_id()
+              << " to tf.data service AutoScaler: " << auto_scaler_status;
+    }
+  }
 
   std::vector<std::shared_ptr<const Task>> tasks;
   TF_RETURN_IF_ERROR(state_.TasksForIteration(iteration->iteration_id, tasks));
@@ -1358,7 +1427,7 @@ Status DataServiceDispatcherImpl::CheckStarted() TF_LOCKS_EXCLUDED(mu_) {
 
 Status DataServiceDispatcherImpl::RecordSplitProduced(
     int64_t iteration_id, int64_t repetition, int64_t split_provider_index,
-    bool finished) TF_LOCKS_EXCLUDED(mu_) {
+    bool finished, int64_t num_splits) TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
   Update update;
   ProduceSplitUpdate* produce_split = update.mutable_produce_split();
@@ -1366,6 +1435,9 @@ Status DataServiceDispatcherImpl::RecordSplitProduced(
   produce_split->set_repetition(repetition);
   produce_split->set_split_provider_index(split_provider_index);
   produce_split->set_finished(finished);
+  if (num_splits > 1) {
+    produce_split->set_num_splits(num_splits);
+  }
   return Apply(update);
 }
 
@@ -1377,11 +1449,25 @@ Status DataServiceDispatcherImpl::ApplyWithoutJournaling(const Update& update)
 Status DataServiceDispatcherImpl::Apply(const Update& update)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   if (journal_writer_.has_value()) {
-    TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
+    // The update is committed to the journal in the background. RPCs wait for
+    // it in `SyncJournal` after releasing `mu_`.
+    TF_RETURN_IF_ERROR(journal_writer_.value()->Append(update).status());
   }
   return state_.Apply(update);
 }
 
+Status DataServiceDispatcherImpl::SyncJournal() TF_LOCKS_EXCLUDED(mu_) {
+  GroupCommitJournalWriter* journal_writer = nullptr;
+  {
+    tf_shared_lock l(mu_);
+    if (!journal_writer_.has_value()) {
+      return absl::OkStatus();
+    }
+    journal_writer = journal_writer_.value().get();
+  }
+  return journal_writer->Sync();
+}
+
 void DataServiceDispatcherImpl::MaintenanceThread() {
   int64_t next_check_micros = 0;
   while (true) {
@@ -1408,6 +1494,17 @@ void DataServiceDispatcherImpl::MaintenanceThread() {
                    "in tf.data service AutoScaler: "
                 << s;
       }
+      absl::StatusOr<ScalingRecommendation> recommendation =
+          auto_scaler_.GetScalingRecommendation(
+              state_.GetNumberOfRegisteredWorkers());
+      if (recommendation.ok()) {
+        metrics::RecordTFDataServiceRecommendedNumberOfWorkers(
+            recommendation->number_of_workers);
+      } else {
+        VLOG(1) << "Error computing a scaling recommendation in tf.data "
+                   "service AutoScaler: "
+                << recommendation.status();
+      }
     }
     {
       Status s = GcOldIterations();
@@ -1415,6 +1512,7 @@ void DataServiceDispatcherImpl::MaintenanceThread() {
         LOG(WARNING) << "Error garbage collecting old iterations: " << s;
       }
     }
+    GcCachedSplitResponses();
     DetectMissingWorkers();
     next_check_micros =
         env_->NowMicros() + (config_.job_gc_check_interval_ms() * 1000);
@@ -1523,6 +1621,22 @@ Status DataServiceDispatcherImpl::GcOldIterations()
   return absl::OkStatus();
 }
 
+void DataServiceDispatcherImpl::GcCachedSplitResponses()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  mutex_lock l(split_cache_mu_);
+  for (auto it = cached_split_responses_.begin();
+       it != cached_split_responses_.end();) {
+    std::shared_ptr<const Iteration> iteration;
+    Status s = state_.IterationFromId(it->first, iteration);
+    if (!s.ok() || iteration->finished || iteration->garbage_collected) {
+      VLOG(3) << "Dropping cached splits of iteration " << it->first;
+      cached_split_responses_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
 bool DataServiceDispatcherImpl::ShouldGcIteration(const Iteration& iteration,
                                                   int64_t now_us) const {
   if (iteration.job->processing_mode.sharding_policy() ==
@@ -20,6 +20,7 @@ limitations under the License.
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -192,6 +193,11 @@ class DataServiceDispatcherImpl {
   // Exports the dispatcher state for debugging.
   DispatcherStateExport ExportState() const;
 
+  // Blocks until the state updates made so far are durable in the journal.
+  // The updates are journaled in group commits, so RPCs that update the state
+  // need to call this before responding.
+  Status SyncJournal();
+
  private:
   // A thread which periodically checks for iterations to clean up, clients to
   // release, workers to consider missing, and snapshot streams to reassign.
@@ -203,6 +209,11 @@ class DataServiceDispatcherImpl {
       const DispatcherState::Iteration& iteration,
       std::vector<std::unique_ptr<SplitProvider>>& restored)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Fills `response` with up to `request.max_splits()` splits from
+  // `split_provider` for a batched `GetSplit` request.
+  Status GetSplits(const GetSplitRequest& request,
+                   SplitProvider& split_provider, GetSplitResponse& response)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(get_split_mu_);
   // Makes split providers for the specified `dataset_id`, and stores them in
   // `split_providers`.
   Status MakeSplitProviders(
@@ -310,10 +321,10 @@ class DataServiceDispatcherImpl {
   Status CheckStarted() TF_LOCKS_EXCLUDED(mu_);
   // Restores ongoing tf.data snapshots.
   absl::Status RestoreSnapshots();
-  // Records that a split was produced by a call to `GetSplit`.
+  // Records that `num_splits` splits were produced by a call to `GetSplit`.
   Status RecordSplitProduced(int64_t iteration_id, int64_t repetition,
-                             int64_t split_provider_index, bool finished)
-      TF_LOCKS_EXCLUDED(mu_);
+                             int64_t split_provider_index, bool finished,
+                             int64_t num_splits = 1) TF_LOCKS_EXCLUDED(mu_);
   // Applies a state update, updating both the journal and the in-memory state.
   Status Apply(const Update& update) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Applies a state update, but doesn't update the journal. Only meant to be
@@ -334,6 +345,9 @@ class DataServiceDispatcherImpl {
   void DetectMissingWorkers() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Scans for old iterations and marks them as finished.
   Status GcOldIterations() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Drops the cached `GetSplit` responses of iterations that are finished or
+  // garbage collected.
+  void GcCachedSplitResponses() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Returns true if an iteration should be garbage collected.
   bool ShouldGcIteration(const DispatcherState::Iteration& iteration,
                          int64_t now_us) const;
@@ -355,6 +369,23 @@ class DataServiceDispatcherImpl {
   // Uses a separate mutex for `GetSplit` requests. `GetSplit` may be blocking.
   // Locking `mu_` in `GetSplit` could block all other RPCs.
   mutable mutex get_split_mu_;
+  // The last batched `GetSplit` response sent to each requester, so that a
+  // retried request gets the same splits instead of consuming new ones.
+  struct CachedSplitResponse {
+    int64_t request_index = 0;
+    GetSplitResponse response;
+  };
+  // Guards `cached_split_responses_`. No other lock is acquired while holding
+  // it, so it may be acquired while holding either `mu_` or `get_split_mu_`.
+  mutable mutex split_cache_mu_;
+  // Maps an iteration id to the cached responses of its requesters, keyed by
+  // (split provider index, requester id). Each requester only has its latest
+  // response cached. The entries of an iteration are removed once it is
+  // finished or garbage collected.
+  absl::flat_hash_map<
+      int64_t,
+      absl::flat_hash_map<std::pair<int64_t, int64_t>, CachedSplitResponse>>
+      cached_split_responses_ TF_GUARDED_BY(split_cache_mu_);
   bool started_ TF_GUARDED_BY(mu_) = false;
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
 
@@ -389,7 +420,7 @@ class DataServiceDispatcherImpl {
   // A single stream assignment manager shared by all managers in `snapshots_`.
   SnapshotAssignmentManager snapshot_assignment_manager_;
 
-  std::optional<std::unique_ptr<JournalWriter>> journal_writer_
+  std::optional<std::unique_ptr<GroupCommitJournalWriter>> journal_writer_
       TF_GUARDED_BY(mu_);
   DispatcherState state_ TF_GUARDED_BY(mu_);
   // Condition variable for waking up the gc thread.
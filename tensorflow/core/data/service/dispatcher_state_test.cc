@@ -338,6 +338,45 @@ TEST(DispatcherState, JobData) {
   EXPECT_EQ(job->use_cross_trainer_cache, use_cross_trainer_cache);
 }
 
+TEST(DispatcherState, ProduceSplits) {
+  DispatcherState state;
+  std::string dataset_id = state.NextAvailableDatasetId();
+  int64_t job_id = state.NextAvailableJobId();
+  int64_t iteration_id = state.NextAvailableIterationId();
+  TF_ASSERT_OK(RegisterDataset(dataset_id, state));
+  Update update;
+  CreateJobUpdate* create_job = update.mutable_create_job();
+  create_job->set_job_id(job_id);
+  create_job->set_dataset_id(dataset_id);
+  create_job->mutable_processing_mode_def()->set_sharding_policy(
+      ProcessingModeDef::DYNAMIC);
+  TF_ASSERT_OK(state.Apply(update));
+  update.Clear();
+  CreateIterationUpdate* create_iteration = update.mutable_create_iteration();
+  create_iteration->set_job_id(job_id);
+  create_iteration->set_iteration_id(iteration_id);
+  create_iteration->set_num_split_providers(1);
+  TF_ASSERT_OK(state.Apply(update));
+
+  update.Clear();
+  ProduceSplitUpdate* produce_split = update.mutable_produce_split();
+  produce_split->set_iteration_id(iteration_id);
+  TF_ASSERT_OK(state.Apply(update));
+  produce_split->set_num_splits(5);
+  TF_ASSERT_OK(state.Apply(update));
+  std::shared_ptr<const Iteration> iteration;
+  TF_ASSERT_OK(state.IterationFromId(iteration_id, iteration));
+  ASSERT_TRUE(iteration->distributed_epoch_state.has_value());
+  EXPECT_EQ(iteration->distributed_epoch_state->indices[0], 6);
+  EXPECT_EQ(iteration->distributed_epoch_state->repetitions[0], 0);
+
+  produce_split->set_finished(true);
+  produce_split->set_num_splits(0);
+  TF_ASSERT_OK(state.Apply(update));
+  EXPECT_EQ(iteration->distributed_epoch_state->indices[0], 0);
+  EXPECT_EQ(iteration->distributed_epoch_state->repetitions[0], 1);
+}
+
 TEST(DispatcherState, CrossTrainerCacheTask) {
   DispatcherState state;
   std::string dataset_id = state.NextAvailableDatasetId();
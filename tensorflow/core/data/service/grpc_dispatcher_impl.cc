@@ -45,11 +45,14 @@ DispatcherStateExport GrpcDispatcherImpl::ExportState() const {
   return impl_.ExportState();
 }
 
+// Responds once the state updates made by the RPC are durable.
 #define HANDLER(method)                                                   \
   grpc::Status GrpcDispatcherImpl::method(ServerContext* context,         \
                                           const method##Request* request, \
                                           method##Response* response) {   \
-    return ToGrpcStatus(impl_.method(request, response));                 \
+    Status s = impl_.method(request, response);                           \
+    Status journal_status = impl_.SyncJournal();                          \
+    return ToGrpcStatus(s.ok() ? journal_status : s);                     \
   }
 HANDLER(WorkerHeartbeat);
 HANDLER(WorkerUpdate);
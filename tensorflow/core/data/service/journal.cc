@@ -16,19 +16,27 @@ limitations under the License.
 #include "tensorflow/core/data/service/journal.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/regexp.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace data {
@@ -44,8 +52,34 @@ Status ParseSequenceNumber(const std::string& journal_file,
   }
   return absl::OkStatus();
 }
+
+// Reads the records of the journal file `filename`.
+Status ReadRecords(Env* env, const std::string& filename,
+                   std::vector<tstring>& records) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+  io::RecordReaderOptions opts;
+  opts.buffer_size = 2 << 20;  // 2MB
+  io::SequentialRecordReader reader(file.get(), opts);
+  while (true) {
+    tstring record;
+    Status s = reader.ReadRecord(&record);
+    if (absl::IsOutOfRange(s)) {
+      return absl::OkStatus();
+    }
+    TF_RETURN_IF_ERROR(s);
+    records.push_back(std::move(record));
+  }
+}
 }  // namespace
 
+Status JournalWriter::WriteBatch(absl::Span<const Update> updates) {
+  for (const Update& update : updates) {
+    TF_RETURN_IF_ERROR(Write(update));
+  }
+  return absl::OkStatus();
+}
+
 std::string DataServiceJournalFile(const std::string& journal_dir,
                                    int64_t sequence_number) {
   return io::JoinPath(journal_dir,
@@ -77,21 +111,121 @@ Status FileJournalWriter::EnsureInitialized() {
 }
 
 Status FileJournalWriter::Write(const Update& update) {
+  return WriteBatch(absl::MakeConstSpan(&update, 1));
+}
+
+Status FileJournalWriter::WriteBatch(absl::Span<const Update> updates) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
+  for (const Update& update : updates) {
+    TF_RETURN_IF_ERROR(WriteRecord(update));
+  }
+  TF_RETURN_IF_ERROR(writer_->Flush());
+  TF_RETURN_IF_ERROR(file_->Sync());
+  VLOG(4) << "Synced " << updates.size() << " journal entries.";
+  return absl::OkStatus();
+}
+
+Status FileJournalWriter::WriteRecord(const Update& update) {
   std::string s = update.SerializeAsString();
   if (s.empty()) {
     return errors::Internal("Failed to serialize update ", update.DebugString(),
                             " to string");
   }
   TF_RETURN_IF_ERROR(writer_->WriteRecord(s));
-  TF_RETURN_IF_ERROR(writer_->Flush());
-  TF_RETURN_IF_ERROR(file_->Sync());
   if (VLOG_IS_ON(4)) {
     VLOG(4) << "Wrote journal entry: " << update.DebugString();
   }
   return absl::OkStatus();
 }
 
+GroupCommitJournalWriter::GroupCommitJournalWriter(
+    Env* env, std::unique_ptr<JournalWriter> writer)
+    : env_(env), writer_(std::move(writer)) {
+  commit_thread_ = absl::WrapUnique(env_->StartThread(
+      /*thread_options=*/{}, "tf_data_service_journal_commit",
+      [this]() { CommitThread(); }));
+}
+
+GroupCommitJournalWriter::~GroupCommitJournalWriter() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cv_.notify_all();
+  }
+  commit_thread_.reset();
+}
+
+Status GroupCommitJournalWriter::Write(const Update& update) {
+  TF_ASSIGN_OR_RETURN(int64_t sequence_number, Append(update));
+  return WaitForCommit(sequence_number);
+}
+
+Status GroupCommitJournalWriter::EnsureInitialized() {
+  mutex_lock l(writer_mu_);
+  return writer_->EnsureInitialized();
+}
+
+absl::StatusOr<int64_t> GroupCommitJournalWriter::Append(
+    const Update& update) {
+  mutex_lock l(mu_);
+  TF_RETURN_IF_ERROR(status_);
+  pending_.push_back(update);
+  cv_.notify_all();
+  return ++last_appended_;
+}
+
+Status GroupCommitJournalWriter::WaitForCommit(int64_t sequence_number) {
+  mutex_lock l(mu_);
+  while (last_committed_ < sequence_number && status_.ok()) {
+    cv_.wait(l);
+  }
+  if (last_committed_ >= sequence_number) {
+    return absl::OkStatus();
+  }
+  return status_;
+}
+
+Status GroupCommitJournalWriter::Sync() {
+  int64_t sequence_number = 0;
+  {
+    mutex_lock l(mu_);
+    sequence_number = last_appended_;
+  }
+  return WaitForCommit(sequence_number);
+}
+
+void GroupCommitJournalWriter::CommitThread() {
+  while (true) {
+    std::vector<Update> batch;
+    int64_t batch_end = 0;
+    {
+      mutex_lock l(mu_);
+      while (pending_.empty() && !cancelled_) {
+        cv_.wait(l);
+      }
+      if (pending_.empty() || !status_.ok()) {
+        return;
+      }
+      batch.swap(pending_);
+      batch_end = last_appended_;
+    }
+    Status s;
+    {
+      mutex_lock l(writer_mu_);
+      s = writer_->WriteBatch(batch);
+    }
+    mutex_lock l(mu_);
+    if (s.ok()) {
+      last_committed_ = batch_end;
+    } else {
+      LOG(ERROR) << "Failed to write " << batch.size()
+                 << " tf.data service journal entries: " << s;
+      status_ = s;
+    }
+    cv_.notify_all();
+  }
+}
+
 FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir)
     : env_(env), journal_dir_(journal_dir) {}
 
@@ -132,6 +266,91 @@ Status FileJournalReader::Read(Update& update, bool& end_of_journal) {
   }
 }
 
+absl::StatusOr<std::vector<Update>> ReadJournal(Env* env,
+                                                const std::string& journal_dir,
+                                                int num_threads) {
+  // Like `FileJournalReader`, reads the journal files with consecutive
+  // sequence numbers from 0.
+  int64_t num_files = 0;
+  while (env->FileExists(DataServiceJournalFile(journal_dir, num_files)).ok()) {
+    ++num_files;
+  }
+  if (num_files == 0) {
+    return errors::NotFound("No journal found in ", journal_dir);
+  }
+
+  thread::ThreadPool thread_pool(env, "tf_data_service_journal_reader",
+                                 std::max(1, num_threads));
+  std::vector<std::vector<tstring>> records(num_files);
+  std::vector<Status> statuses(num_files);
+  thread_pool.ParallelFor(
+      num_files, /*cost_per_unit=*/1 << 20, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          statuses[i] = ReadRecords(
+              env, DataServiceJournalFile(journal_dir, i), records[i]);
+        }
+      });
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+
+  std::vector<const tstring*> all_records;
+  for (const std::vector<tstring>& file_records : records) {
+    for (const tstring& record : file_records) {
+      all_records.push_back(&record);
+    }
+  }
+  std::vector<Update> updates(all_records.size());
+  std::vector<char> parsed(all_records.size(), false);
+  thread_pool.ParallelFor(
+      all_records.size(), /*cost_per_unit=*/1000,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          parsed[i] = updates[i].ParseFromArray(all_records[i]->data(),
+                                                all_records[i]->size());
+        }
+      });
+  if (std::find(parsed.begin(), parsed.end(), false) != parsed.end()) {
+    return errors::DataLoss("Failed to parse journal record.");
+  }
+  VLOG(1) << "Read " << updates.size() << " updates from " << num_files
+          << " journal files in " << journal_dir;
+  return DropSupersededUpdates(std::move(updates));
+}
+
+std::vector<Update> DropSupersededUpdates(std::vector<Update> updates) {
+  // Maps (iteration ID, split provider index) to the position of the update
+  // that last finished a repetition of that split provider.
+  absl::flat_hash_map<std::pair<int64_t, int64_t>, size_t> last_finished;
+  for (size_t i = 0; i < updates.size(); ++i) {
+    if (updates[i].has_produce_split() &&
+        updates[i].produce_split().finished()) {
+      const ProduceSplitUpdate& produce_split = updates[i].produce_split();
+      last_finished[{produce_split.iteration_id(),
+                     produce_split.split_provider_index()}] = i;
+    }
+  }
+  if (last_finished.empty()) {
+    return updates;
+  }
+  std::vector<Update> result;
+  result.reserve(updates.size());
+  for (size_t i = 0; i < updates.size(); ++i) {
+    if (updates[i].has_produce_split()) {
+      const ProduceSplitUpdate& produce_split = updates[i].produce_split();
+      auto it = last_finished.find(
+          {produce_split.iteration_id(), produce_split.split_provider_index()});
+      if (it != last_finished.end() && i < it->second) {
+        continue;
+      }
+    }
+    result.push_back(std::move(updates[i]));
+  }
+  VLOG(1) << "Dropped " << updates.size() - result.size()
+          << " superseded journal updates.";
+  return result;
+}
+
 Status FileJournalReader::UpdateFile(const std::string& filename) {
   VLOG(1) << "Reading from journal file " << filename;
   TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(filename, &file_));
@@ -15,14 +15,20 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace data {
@@ -37,6 +43,9 @@ class JournalWriter {
   virtual ~JournalWriter() = default;
   // Writes and syncs an update to the journal.
   virtual Status Write(const Update& update) = 0;
+  // Writes a batch of updates to the journal. Writers that support it sync the
+  // batch once, rather than once per update.
+  virtual Status WriteBatch(absl::Span<const Update> updates);
   // Initializes the writer if it is not yet initialized.
   virtual Status EnsureInitialized() = 0;
 };
@@ -67,15 +76,76 @@ class FileJournalWriter : public JournalWriter {
   FileJournalWriter& operator=(const FileJournalWriter&) = delete;
 
   Status Write(const Update& update) override;
+  Status WriteBatch(absl::Span<const Update> updates) override;
   Status EnsureInitialized() override;
 
  private:
+  // Appends `update` to the journal file, without flushing it.
+  Status WriteRecord(const Update& update);
+
   Env* env_;
   const std::string journal_dir_;
   std::unique_ptr<WritableFile> file_;
   std::unique_ptr<io::RecordWriter> writer_;
 };
 
+// GroupCommitJournalWriter batches concurrent updates into group commits.
+// `Append` buffers an update and returns immediately, so that callers can
+// append while holding their own locks. A background thread writes all the
+// buffered updates with a single sync, while new updates accumulate for the
+// next batch. `WaitForCommit` blocks until an update is durable.
+//
+// If a batch fails to be written, the writer stops writing, and all later
+// `Append` and `WaitForCommit` calls return the error.
+//
+// GroupCommitJournalWriter is thread-safe.
+class GroupCommitJournalWriter : public JournalWriter {
+ public:
+  // Creates a writer that commits the appended updates to `writer`.
+  GroupCommitJournalWriter(Env* env, std::unique_ptr<JournalWriter> writer);
+  // Commits the remaining updates before returning.
+  ~GroupCommitJournalWriter() override;
+  GroupCommitJournalWriter(const GroupCommitJournalWriter&) = delete;
+  GroupCommitJournalWriter& operator=(const GroupCommitJournalWriter&) = delete;
+
+  // Appends `update`, and waits for it to be committed.
+  Status Write(const Update& update) override;
+  Status EnsureInitialized() override;
+
+  // Buffers `update` to be written by the next group commit. Returns its
+  // sequence number, to be passed to `WaitForCommit`.
+  absl::StatusOr<int64_t> Append(const Update& update);
+
+  // Blocks until the update with `sequence_number`, and all updates appended
+  // before it, are durable.
+  Status WaitForCommit(int64_t sequence_number);
+
+  // Blocks until all updates appended before the call are durable.
+  Status Sync();
+
+ private:
+  // Writes the buffered updates until the writer is destroyed.
+  void CommitThread();
+
+  Env* const env_;
+
+  // Guards `writer_`, which is not thread-safe.
+  mutex writer_mu_;
+  const std::unique_ptr<JournalWriter> writer_ TF_PT_GUARDED_BY(writer_mu_);
+
+  mutex mu_;
+  condition_variable cv_;
+  // Updates appended since the last group commit started.
+  std::vector<Update> pending_ TF_GUARDED_BY(mu_);
+  // Sequence number of the last appended update. Updates are numbered from 1.
+  int64_t last_appended_ TF_GUARDED_BY(mu_) = 0;
+  // Sequence number of the last durable update.
+  int64_t last_committed_ TF_GUARDED_BY(mu_) = 0;
+  Status status_ TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> commit_thread_;
+};
+
 // Interface for reading from a journal.
 class JournalReader {
  public:
@@ -112,6 +182,22 @@ class FileJournalReader : public JournalReader {
   std::unique_ptr<io::SequentialRecordReader> reader_;
 };
 
+// Reads all the updates in `journal_dir`, in the order `FileJournalReader`
+// would read them. Journal files are read concurrently, and records are parsed
+// on up to `num_threads` threads. Returns NotFound if there is no journal.
+//
+// Updates that are superseded by later updates are dropped from the result
+// (see `DropSupersededUpdates`).
+absl::StatusOr<std::vector<Update>> ReadJournal(Env* env,
+                                                const std::string& journal_dir,
+                                                int num_threads);
+
+// Drops the updates that do not affect the state produced by applying
+// `updates` in order. Currently, these are the `ProduceSplitUpdate`s for a
+// split provider that are followed by a `ProduceSplitUpdate` marking the end of
+// the same split provider's repetition, which resets its split index.
+std::vector<Update> DropSupersededUpdates(std::vector<Update> updates);
+
 }  // namespace data
 }  // namespace tensorflow
 
@@ -23,8 +23,10 @@ limitations under the License.
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/data_service.pb.h"
 
@@ -32,7 +34,9 @@ namespace tensorflow {
 namespace data {
 
 namespace {
+using ::tensorflow::testing::StatusIs;
 using ::testing::HasSubstr;
+using ::testing::SizeIs;
 
 bool NewJournalDir(std::string& journal_dir) {
   std::string filename = testing::TmpDir();
@@ -67,6 +71,31 @@ Update MakeRegisterDatasetUpdate() {
   return update;
 }
 
+Update MakeProduceSplitUpdate(int64_t repetition, bool finished) {
+  Update update;
+  ProduceSplitUpdate* produce_split = update.mutable_produce_split();
+  produce_split->set_iteration_id(8);
+  produce_split->set_repetition(repetition);
+  produce_split->set_finished(finished);
+  return update;
+}
+
+class FailingJournalWriter : public JournalWriter {
+ public:
+  Status Write(const Update& update) override {
+    return errors::Unavailable("Failed to write");
+  }
+  Status EnsureInitialized() override { return absl::OkStatus(); }
+};
+
+void ExpectUpdatesEqual(const std::vector<Update>& updates,
+                        const std::vector<Update>& expected) {
+  ASSERT_EQ(updates.size(), expected.size());
+  for (int i = 0; i < updates.size(); ++i) {
+    EXPECT_EQ(updates[i].SerializeAsString(), expected[i].SerializeAsString());
+  }
+}
+
 Status CheckJournalContent(StringPiece journal_dir,
                            const std::vector<Update>& expected) {
   FileJournalReader reader(Env::Default(), journal_dir);
@@ -165,5 +194,101 @@ TEST(Journal, InvalidRecordData) {
   EXPECT_THAT(s.message(), HasSubstr("Failed to parse journal record"));
   EXPECT_EQ(s.code(), error::DATA_LOSS);
 }
+
+TEST(Journal, GroupCommit) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  std::vector<Update> updates = {MakeCreateIterationUpdate(),
+                                 MakeRegisterDatasetUpdate(),
+                                 MakeFinishTaskUpdate()};
+  GroupCommitJournalWriter writer(
+      Env::Default(),
+      std::make_unique<FileJournalWriter>(Env::Default(), journal_dir));
+  TF_ASSERT_OK(writer.EnsureInitialized());
+  for (const auto& update : updates) {
+    TF_ASSERT_OK(writer.Append(update).status());
+  }
+  TF_ASSERT_OK(writer.Sync());
+
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, updates));
+}
+
+TEST(Journal, ConcurrentGroupCommits) {
+  constexpr int kNumThreads = 8;
+  constexpr int kNumUpdatesPerThread = 50;
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  {
+    GroupCommitJournalWriter writer(
+        Env::Default(),
+        std::make_unique<FileJournalWriter>(Env::Default(), journal_dir));
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int i = 0; i < kNumThreads; ++i) {
+      pool.Schedule([&writer]() {
+        for (int j = 0; j < kNumUpdatesPerThread; ++j) {
+          TF_EXPECT_OK(writer.Write(MakeFinishTaskUpdate()));
+        }
+      });
+    }
+  }
+
+  absl::StatusOr<std::vector<Update>> updates =
+      ReadJournal(Env::Default(), journal_dir, /*num_threads=*/4);
+  TF_ASSERT_OK(updates.status());
+  EXPECT_THAT(*updates, SizeIs(kNumThreads * kNumUpdatesPerThread));
+}
+
+TEST(Journal, GroupCommitErrorsAreSticky) {
+  GroupCommitJournalWriter writer(Env::Default(),
+                                  std::make_unique<FailingJournalWriter>());
+  EXPECT_THAT(writer.Write(MakeFinishTaskUpdate()),
+              StatusIs(error::UNAVAILABLE));
+  EXPECT_THAT(writer.Append(MakeFinishTaskUpdate()),
+              StatusIs(error::UNAVAILABLE));
+  EXPECT_THAT(writer.Sync(), StatusIs(error::UNAVAILABLE));
+}
+
+TEST(Journal, ReadJournal) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  std::vector<Update> updates = {MakeCreateIterationUpdate(),
+                                 MakeRegisterDatasetUpdate(),
+                                 MakeFinishTaskUpdate()};
+  // Writes each update to a separate journal file.
+  for (const auto& update : updates) {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_EXPECT_OK(writer.Write(update));
+  }
+
+  absl::StatusOr<std::vector<Update>> result =
+      ReadJournal(Env::Default(), journal_dir, /*num_threads=*/2);
+  TF_ASSERT_OK(result.status());
+  ExpectUpdatesEqual(*result, updates);
+}
+
+TEST(Journal, ReadMissingJournal) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  EXPECT_THAT(ReadJournal(Env::Default(), journal_dir, /*num_threads=*/2),
+              StatusIs(error::NOT_FOUND));
+}
+
+TEST(Journal, DropSupersededUpdates) {
+  std::vector<Update> updates = {
+      MakeCreateIterationUpdate(),
+      MakeProduceSplitUpdate(/*repetition=*/0, /*finished=*/false),
+      MakeProduceSplitUpdate(/*repetition=*/0, /*finished=*/false),
+      MakeProduceSplitUpdate(/*repetition=*/0, /*finished=*/true),
+      MakeProduceSplitUpdate(/*repetition=*/1, /*finished=*/false),
+      MakeProduceSplitUpdate(/*repetition=*/1, /*finished=*/true),
+      MakeFinishTaskUpdate(),
+      MakeProduceSplitUpdate(/*repetition=*/2, /*finished=*/false)};
+  ExpectUpdatesEqual(
+      DropSupersededUpdates(updates),
+      {MakeCreateIterationUpdate(),
+       MakeProduceSplitUpdate(/*repetition=*/1, /*finished=*/true),
+       MakeFinishTaskUpdate(),
+       MakeProduceSplitUpdate(/*repetition=*/2, /*finished=*/false)});
+}
 }  // namespace data
 }  // namespace tensorflow
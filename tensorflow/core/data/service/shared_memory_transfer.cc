@@ -0,0 +1,800 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shared_memory_transfer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/shared_memory_transfer.pb.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/dataset.pb.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
+namespace tensorflow {
+namespace data {
+
+std::optional<SharedMemoryRingAllocator::Region>
+SharedMemoryRingAllocator::Allocate(uint64_t size, uint64_t released) {
+  if (size > capacity_) {
+    return std::nullopt;
+  }
+  const uint64_t offset = allocated_ % capacity_;
+  const uint64_t padding = offset + size > capacity_ ? capacity_ - offset : 0;
+  if (allocated_ + padding + size - released > capacity_) {
+    return std::nullopt;
+  }
+  Region region{allocated_, allocated_ + padding + size,
+                (allocated_ + padding) % capacity_};
+  allocated_ = region.end;
+  return region;
+}
+
+uint64_t SharedMemoryReleaseTracker::Release(uint64_t begin, uint64_t end) {
+  mutex_lock l(mu_);
+  pending_[begin] = end;
+  while (!pending_.empty() && pending_.begin()->first == released_) {
+    released_ = pending_.begin()->second;
+    pending_.erase(pending_.begin());
+  }
+  return released_;
+}
+
+#if defined(__linux__)
+namespace {
+
+constexpr char kSocketNamePrefix[] = "tf_data_service_shared_memory_";
+// The ring starts with a header holding the released position, written by the
+// client and read by the server.
+constexpr uint64_t kRingHeaderSize = 4096;
+constexpr uint64_t kRingCapacity = 64 << 20;  // 64MB
+constexpr uint64_t kAlignment = Allocator::kAllocatorAlignment;
+// Guards against reading corrupted message lengths.
+constexpr uint64_t kMaxMessageSize = 1ULL << 36;
+constexpr int kMaxBindAttempts = 16;
+
+static_assert(kRingCapacity % kAlignment == 0,
+              "Ring positions must stay aligned.");
+
+uint64_t RoundUp(uint64_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Fills `address` with the abstract socket address for `port`, and returns
+// its length.
+socklen_t SocketAddress(int port, sockaddr_un* address) {
+  std::memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  const std::string name = absl::StrCat(kSocketNamePrefix, port);
+  // Abstract socket names start with a null byte and are not backed by files.
+  std::memcpy(address->sun_path + 1, name.data(), name.size());
+  return offsetof(sockaddr_un, sun_path) + 1 + name.size();
+}
+
+Status WriteFully(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return errors::IOError("Failed to write to shared memory socket", errno);
+    }
+    data += written;
+    size -= written;
+  }
+  return absl::OkStatus();
+}
+
+Status ReadFully(int fd, char* data, size_t size) {
+  while (size > 0) {
+    ssize_t read = recv(fd, data, size, 0);
+    if (read < 0) {
+      if (errno == EINTR) continue;
+      return errors::IOError("Failed to read from shared memory socket", errno);
+    }
+    if (read == 0) {
+      return errors::Unavailable("Shared memory socket was closed.");
+    }
+    data += read;
+    size -= read;
+  }
+  return absl::OkStatus();
+}
+
+// Messages are sent as their length, as a fixed64, followed by their bytes.
+Status WriteMessage(int fd, const protobuf::MessageLite& message) {
+  std::string bytes;
+  if (!message.SerializeToString(&bytes)) {
+    return errors::Internal("Failed to serialize ", message.GetTypeName());
+  }
+  char length[sizeof(uint64_t)];
+  core::EncodeFixed64(length, bytes.size());
+  TF_RETURN_IF_ERROR(WriteFully(fd, length, sizeof(length)));
+  return WriteFully(fd, bytes.data(), bytes.size());
+}
+
+Status ReadMessage(int fd, protobuf::MessageLite* message) {
+  char length_bytes[sizeof(uint64_t)];
+  TF_RETURN_IF_ERROR(ReadFully(fd, length_bytes, sizeof(length_bytes)));
+  const uint64_t length = core::DecodeFixed64(length_bytes);
+  if (length > kMaxMessageSize) {
+    return errors::DataLoss("Invalid shared memory message length ", length);
+  }
+  std::string bytes(length, '\0');
+  TF_RETURN_IF_ERROR(ReadFully(fd, bytes.data(), bytes.size()));
+  if (!message->ParseFromString(bytes)) {
+    return errors::DataLoss("Failed to parse ", message->GetTypeName());
+  }
+  return absl::OkStatus();
+}
+
+int MemfdCreate(const char* name) {
+#if defined(__NR_memfd_create)
+  return syscall(__NR_memfd_create, name, /*MFD_CLOEXEC=*/1U);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+// A mapping of the shared memory ring of one connection.
+class SharedRing {
+ public:
+  // Creates a ring with `capacity` bytes of data.
+  static absl::StatusOr<std::shared_ptr<SharedRing>> Create(
+      uint64_t capacity) {
+    int fd = MemfdCreate("tf_data_service_ring");
+    if (fd < 0) {
+      return errors::IOError("Failed to create shared memory", errno);
+    }
+    if (ftruncate(fd, kRingHeaderSize + capacity) != 0) {
+      Status s = errors::IOError("Failed to size shared memory", errno);
+      close(fd);
+      return s;
+    }
+    return Map(fd);
+  }
+
+  // Maps the ring of the shared memory file `fd`, taking ownership of `fd`.
+  static absl::StatusOr<std::shared_ptr<SharedRing>> Map(int fd) {
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 ||
+        static_cast<uint64_t>(file_stat.st_size) <= kRingHeaderSize) {
+      close(fd);
+      return errors::InvalidArgument("Invalid shared memory ring.");
+    }
+    const uint64_t size = file_stat.st_size;
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                      /*offset=*/0);
+    if (base == MAP_FAILED) {
+      Status s = errors::IOError("Failed to map shared memory", errno);
+      close(fd);
+      return s;
+    }
+    return std::shared_ptr<SharedRing>(
+        new SharedRing(fd, static_cast<char*>(base), size));
+  }
+
+  ~SharedRing() {
+    munmap(base_, size_);
+    close(fd_);
+  }
+
+  int fd() const { return fd_; }
+  uint64_t capacity() const { return size_ - kRingHeaderSize; }
+  char* data() const { return base_ + kRingHeaderSize; }
+
+  // Returns the position before which the client released the ring.
+  uint64_t released() const {
+    return released_position()->load(std::memory_order_acquire);
+  }
+
+  // Releases the positions [begin, end) on the client side.
+  void Release(uint64_t begin, uint64_t end) {
+    const uint64_t released = release_tracker_.Release(begin, end);
+    // Concurrent releases publish their results in any order, so only ever
+    // move the position forward; a stale smaller value would make the server
+    // wait for space that is already free.
+    std::atomic<uint64_t>* position = released_position();
+    uint64_t current = position->load(std::memory_order_relaxed);
+    while (current < released &&
+           !position->compare_exchange_weak(current, released,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+  }
+
+ private:
+  SharedRing(int fd, char* base, uint64_t size)
+      : fd_(fd), base_(base), size_(size) {}
+
+  std::atomic<uint64_t>* released_position() const {
+    return reinterpret_cast<std::atomic<uint64_t>*>(base_);
+  }
+
+  const int fd_;
+  char* const base_;
+  const uint64_t size_;
+  SharedMemoryReleaseTracker release_tracker_;
+};
+
+// Sends `ring_fd` and the ring capacity over `socket_fd`.
+Status SendRing(int socket_fd, const SharedRing& ring) {
+  char payload[sizeof(uint64_t)];
+  core::EncodeFixed64(payload, ring.capacity());
+  iovec iov{payload, sizeof(payload)};
+  char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr message = {};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  const int ring_fd = ring.fd();
+  std::memcpy(CMSG_DATA(cmsg), &ring_fd, sizeof(int));
+  while (sendmsg(socket_fd, &message, MSG_NOSIGNAL) < 0) {
+    if (errno != EINTR) {
+      return errors::IOError("Failed to send shared memory ring", errno);
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Receives the ring sent by `SendRing` and maps it.
+absl::StatusOr<std::shared_ptr<SharedRing>> ReceiveRing(int socket_fd) {
+  char payload[sizeof(uint64_t)];
+  iovec iov{payload, sizeof(payload)};
+  char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr message = {};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  ssize_t received;
+  do {
+    received = recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC);
+  } while (received < 0 && errno == EINTR);
+  if (received < 0) {
+    return errors::IOError("Failed to receive shared memory ring", errno);
+  }
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  if (received != sizeof(payload) || cmsg == nullptr ||
+      cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+    return errors::Unavailable(
+        "The shared memory transfer server did not send its ring.");
+  }
+  int ring_fd;
+  std::memcpy(&ring_fd, CMSG_DATA(cmsg), sizeof(int));
+  TF_ASSIGN_OR_RETURN(std::shared_ptr<SharedRing> ring,
+                      SharedRing::Map(ring_fd));
+  if (ring->capacity() != core::DecodeFixed64(payload)) {
+    return errors::DataLoss("Unexpected shared memory ring size.");
+  }
+  return ring;
+}
+
+class SharedMemoryDataTransferServer : public DataTransferServer {
+ public:
+  explicit SharedMemoryDataTransferServer(GetElementT get_element)
+      : get_element_(std::move(get_element)) {}
+
+  ~SharedMemoryDataTransferServer() override {
+    std::vector<std::unique_ptr<Thread>> connection_threads;
+    {
+      mutex_lock l(mu_);
+      cancelled_ = true;
+      if (listen_fd_ >= 0) {
+        // Makes `accept` return.
+        shutdown(listen_fd_, SHUT_RDWR);
+      }
+      for (int fd : connection_fds_) {
+        shutdown(fd, SHUT_RDWR);
+      }
+    }
+    accept_thread_.reset();
+    {
+      mutex_lock l(mu_);
+      connection_threads = std::move(connection_threads_);
+    }
+    connection_threads.clear();
+    if (listen_fd_ >= 0) {
+      close(listen_fd_);
+    }
+  }
+
+  Status Start(const experimental::WorkerConfig& config) override {
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+      return errors::IOError("Failed to create shared memory socket", errno);
+    }
+    // Ports only name the sockets, so unless one is configured, we pick one
+    // at random.
+    const bool random_port = config.data_transfer_port() <= 0;
+    for (int attempt = 0;; ++attempt) {
+      port_ = random_port ? 1 + random::New64() % (1 << 30)
+                          : config.data_transfer_port();
+      sockaddr_un address;
+      socklen_t length = SocketAddress(port_, &address);
+      if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), length) ==
+          0) {
+        break;
+      }
+      if (!random_port || errno != EADDRINUSE ||
+          attempt + 1 == kMaxBindAttempts) {
+        return errors::IOError(
+            absl::StrCat("Failed to bind shared memory socket for port ",
+                         port_),
+            errno);
+      }
+    }
+    if (listen(listen_fd_, SOMAXCONN) != 0) {
+      return errors::IOError("Failed to listen on shared memory socket",
+                             errno);
+    }
+    accept_thread_ = absl::WrapUnique(Env::Default()->StartThread(
+        {}, "tf_data_service_shared_memory_server", [this]() { Accept(); }));
+    return absl::OkStatus();
+  }
+
+  int Port() const override { return port_; }
+
+  absl::StatusOr<std::string> GetCompatibilityInfo() const override {
+    SharedMemoryTransferServerInfo info;
+    info.set_hostname(port::Hostname());
+    return info.SerializeAsString();
+  }
+
+ private:
+  void Accept() {
+    while (true) {
+      int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        if (fd >= 0) close(fd);
+        return;
+      }
+      if (fd < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+        LOG(ERROR) << "Shared memory transfer server stopped accepting "
+                   << "connections: " << strerror(errno);
+        return;
+      }
+      connection_fds_.insert(fd);
+      connection_threads_.push_back(
+          absl::WrapUnique(Env::Default()->StartThread(
+              {}, "tf_data_service_shared_memory_connection",
+              [this, fd]() { Serve(fd); })));
+    }
+  }
+
+  // Serves the requests sent over connection `fd` until it is closed.
+  void Serve(int fd) {
+    Status s = ServeConnection(fd);
+    VLOG(2) << "Shared memory transfer connection closed: " << s;
+    mutex_lock l(mu_);
+    connection_fds_.erase(fd);
+    close(fd);
+  }
+
+  Status ServeConnection(int fd) {
+    TF_ASSIGN_OR_RETURN(std::shared_ptr<SharedRing> ring,
+                        SharedRing::Create(kRingCapacity));
+    TF_RETURN_IF_ERROR(SendRing(fd, *ring));
+    SharedMemoryRingAllocator allocator(ring->capacity());
+    while (true) {
+      GetElementRequest request;
+      TF_RETURN_IF_ERROR(ReadMessage(fd, &request));
+      GetElementResult result;
+      SharedMemoryGetElementResponse response;
+      Status s = get_element_(&request, &result);
+      if (s.ok()) {
+        TF_RETURN_IF_ERROR(FillResponse(result, *ring, allocator, response));
+      } else {
+        response.set_error_code(s.raw_code());
+        response.set_error_message(std::string(s.message()));
+      }
+      TF_RETURN_IF_ERROR(WriteMessage(fd, response));
+    }
+  }
+
+  // Copies the components of `result` into the ring if possible, and
+  // serializes them into `response` otherwise.
+  static Status FillResponse(const GetElementResult& result, SharedRing& ring,
+                             SharedMemoryRingAllocator& allocator,
+                             SharedMemoryGetElementResponse& response) {
+    response.set_element_index(result.element_index);
+    response.set_end_of_sequence(result.end_of_sequence);
+    response.set_skip_task(result.skip);
+    if (result.components.size() == 1 &&
+        result.components[0].dtype() == DT_VARIANT &&
+        TensorShapeUtils::IsScalar(result.components[0].shape())) {
+      const CompressedElement* compressed =
+          result.components[0].scalar<Variant>()().get<CompressedElement>();
+      if (compressed != nullptr) {
+        *response.mutable_compressed() = *compressed;
+        return absl::OkStatus();
+      }
+    }
+
+    std::vector<uint64_t> offsets;
+    uint64_t size = 0;
+    bool use_ring = true;
+    for (const Tensor& component : result.components) {
+      if (!DataTypeCanUseMemcpy(component.dtype())) {
+        use_ring = false;
+        break;
+      }
+      offsets.push_back(size);
+      size += RoundUp(component.TotalBytes());
+    }
+    std::optional<SharedMemoryRingAllocator::Region> region;
+    if (use_ring && size > 0) {
+      region = allocator.Allocate(size, ring.released());
+    }
+    if (region.has_value()) {
+      response.set_ring_begin(region->begin);
+      response.set_ring_end(region->end);
+    }
+    for (int i = 0; i < result.components.size(); ++i) {
+      const Tensor& component = result.components[i];
+      SharedMemoryTensor* tensor = response.add_components();
+      if (!region.has_value()) {
+        component.AsProtoTensorContent(tensor->mutable_tensor());
+        continue;
+      }
+      const uint64_t offset = region->data_offset + offsets[i];
+      tensor->set_dtype(component.dtype());
+      component.shape().AsProto(tensor->mutable_shape());
+      tensor->set_ring_offset(offset);
+      const absl::string_view data = component.tensor_data();
+      std::memcpy(ring.data() + offset, data.data(), data.size());
+    }
+    return absl::OkStatus();
+  }
+
+  const GetElementT get_element_;
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::unique_ptr<Thread> accept_thread_;
+
+  mutex mu_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  absl::flat_hash_set<int> connection_fds_ TF_GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<Thread>> connection_threads_ TF_GUARDED_BY(mu_);
+};
+
+// The tensors of an element received through the ring. The ring positions of
+// the element are released once all of its tensors are destroyed.
+class RingRegion {
+ public:
+  RingRegion(std::shared_ptr<SharedRing> ring, uint64_t begin, uint64_t end)
+      : ring_(std::move(ring)), begin_(begin), end_(end) {}
+  ~RingRegion() { ring_->Release(begin_, end_); }
+
+  RingRegion(const RingRegion&) = delete;
+  RingRegion& operator=(const RingRegion&) = delete;
+
+  char* data() const { return ring_->data(); }
+
+ private:
+  const std::shared_ptr<SharedRing> ring_;
+  const uint64_t begin_;
+  const uint64_t end_;
+};
+
+// A tensor buffer that aliases memory of the ring.
+class RingTensorBuffer : public TensorBuffer {
+ public:
+  RingTensorBuffer(std::shared_ptr<RingRegion> region, uint64_t offset,
+                   size_t size)
+      : TensorBuffer(region->data() + offset),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("tf_data_service_shared_memory");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<RingRegion> region_;
+  const size_t size_;
+};
+
+// A connection to a shared memory transfer server, which handles one request
+// at a time.
+class SharedMemoryConnection {
+ public:
+  static absl::StatusOr<std::unique_ptr<SharedMemoryConnection>> Connect(
+      int port) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      return errors::IOError("Failed to create shared memory socket", errno);
+    }
+    sockaddr_un address;
+    socklen_t length = SocketAddress(port, &address);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), length) != 0) {
+      Status s = errors::Unavailable(
+          "Failed to connect to the shared memory transfer server for port ",
+          port, ": ", strerror(errno));
+      close(fd);
+      return s;
+    }
+    absl::StatusOr<std::shared_ptr<SharedRing>> ring = ReceiveRing(fd);
+    if (!ring.ok()) {
+      close(fd);
+      return ring.status();
+    }
+    return absl::WrapUnique(new SharedMemoryConnection(fd, *std::move(ring)));
+  }
+
+  ~SharedMemoryConnection() { close(fd_); }
+
+  int fd() const { return fd_; }
+
+  // Whether the connection failed and can no longer be used.
+  bool broken() const { return broken_; }
+
+  Status GetElement(const GetElementRequest& request,
+                    GetElementResult& result) {
+    SharedMemoryGetElementResponse response;
+    Status s = WriteMessage(fd_, request);
+    if (s.ok()) {
+      s = ReadMessage(fd_, &response);
+    }
+    if (!s.ok()) {
+      broken_ = true;
+      return s;
+    }
+    if (response.error_code() != 0) {
+      return Status(static_cast<absl::StatusCode>(response.error_code()),
+                    response.error_message());
+    }
+    result.element_index = response.element_index();
+    result.end_of_sequence = response.end_of_sequence();
+    result.skip = response.skip_task();
+    if (response.has_compressed()) {
+      Tensor tensor(DT_VARIANT, TensorShape{});
+      tensor.scalar<Variant>()() = std::move(*response.mutable_compressed());
+      result.components.push_back(std::move(tensor));
+      return absl::OkStatus();
+    }
+    std::shared_ptr<RingRegion> region;
+    if (response.ring_end() > response.ring_begin()) {
+      region = std::make_shared<RingRegion>(ring_, response.ring_begin(),
+                                            response.ring_end());
+    }
+    for (const SharedMemoryTensor& component : response.components()) {
+      if (region == nullptr) {
+        result.components.emplace_back();
+        if (!result.components.back().FromProto(component.tensor())) {
+          return errors::Internal("Failed to parse tensor.");
+        }
+        continue;
+      }
+      TensorShape shape;
+      TF_RETURN_IF_ERROR(
+          TensorShape::BuildTensorShape(component.shape(), &shape));
+      const uint64_t size =
+          shape.num_elements() * DataTypeSize(component.dtype());
+      if (!DataTypeCanUseMemcpy(component.dtype()) ||
+          component.ring_offset() + size > ring_->capacity()) {
+        broken_ = true;
+        return errors::DataLoss("Invalid shared memory tensor.");
+      }
+      result.components.emplace_back(
+          component.dtype(), shape,
+          core::RefCountPtr<TensorBuffer>(
+              new RingTensorBuffer(region, component.ring_offset(), size)));
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  SharedMemoryConnection(int fd, std::shared_ptr<SharedRing> ring)
+      : fd_(fd), ring_(std::move(ring)) {}
+
+  const int fd_;
+  const std::shared_ptr<SharedRing> ring_;
+  bool broken_ = false;
+};
+
+class SharedMemoryDataTransferClient : public DataTransferClient {
+ public:
+  explicit SharedMemoryDataTransferClient(int port) : port_(port) {
+    VLOG(2) << "Create SharedMemoryDataTransferClient for port " << port_
+            << ".";
+  }
+
+  // Opens the first connection, so that clients that cannot reach the server
+  // fail at creation and fall back to another protocol.
+  Status Initialize() {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<SharedMemoryConnection> connection,
+                        TakeConnection());
+    ReturnConnection(std::move(connection));
+    return absl::OkStatus();
+  }
+
+  Status GetElement(const GetElementRequest& req,
+                    GetElementResult& result) override {
+    VLOG(3) << "GetElement for task " << req.task_id() << " from shared "
+            << "memory worker server.";
+    // Concurrent requests use separate connections, each with their own ring.
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<SharedMemoryConnection> connection,
+                        TakeConnection());
+    int64_t start_time_us = env_->NowMicros();
+    Status s = connection->GetElement(req, result);
+    int64_t end_time_us = env_->NowMicros();
+    ReturnConnection(std::move(connection));
+    TF_RETURN_IF_ERROR(s);
+    metrics::RecordTFDataServiceGetElementDuration(
+        kSharedMemoryTransferProtocol, end_time_us - start_time_us);
+    return absl::OkStatus();
+  }
+
+  void TryCancel() override {
+    VLOG(2) << "Cancel SharedMemoryDataTransferClient.";
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (int fd : connection_fds_) {
+      shutdown(fd, SHUT_RDWR);
+    }
+  }
+
+  Status CheckCompatibility(
+      const std::string& server_compatibility_info) const override {
+    SharedMemoryTransferServerInfo server_info;
+    if (!server_info.ParseFromString(server_compatibility_info)) {
+      return errors::Internal(
+          "Failed to parse shared memory transfer server info.");
+    }
+    if (server_info.hostname() != port::Hostname()) {
+      return errors::FailedPrecondition(
+          "The shared memory transfer server runs on host ",
+          server_info.hostname(), ", but the client runs on host ",
+          port::Hostname(), ".");
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::StatusOr<std::unique_ptr<SharedMemoryConnection>> TakeConnection() {
+    {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("Client was cancelled.");
+      }
+      if (!idle_connections_.empty()) {
+        std::unique_ptr<SharedMemoryConnection> connection =
+            std::move(idle_connections_.back());
+        idle_connections_.pop_back();
+        return connection;
+      }
+    }
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<SharedMemoryConnection> connection,
+                        SharedMemoryConnection::Connect(port_));
+    mutex_lock l(mu_);
+    if (cancelled_) {
+      return errors::Cancelled("Client was cancelled.");
+    }
+    connection_fds_.insert(connection->fd());
+    return connection;
+  }
+
+  void ReturnConnection(std::unique_ptr<SharedMemoryConnection> connection) {
+    mutex_lock l(mu_);
+    if (connection->broken() || cancelled_) {
+      connection_fds_.erase(connection->fd());
+      return;
+    }
+    idle_connections_.push_back(std::move(connection));
+  }
+
+  const int port_;
+  mutex mu_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::vector<std::unique_ptr<SharedMemoryConnection>> idle_connections_
+      TF_GUARDED_BY(mu_);
+  // The sockets of all open connections, used to support cancellation.
+  absl::flat_hash_set<int> connection_fds_ TF_GUARDED_BY(mu_);
+};
+
+// Returns the port of `address`, which is of the form "host:port".
+absl::StatusOr<int> ParsePort(absl::string_view address) {
+  int port;
+  const size_t colon = address.rfind(':');
+  if (colon == absl::string_view::npos ||
+      !absl::SimpleAtoi(address.substr(colon + 1), &port)) {
+    return errors::InvalidArgument(
+        "Invalid shared memory transfer server address ", address);
+  }
+  return port;
+}
+
+class SharedMemoryTransferRegistrar {
+ public:
+  SharedMemoryTransferRegistrar() {
+    DataTransferServer::Register(
+        kSharedMemoryTransferProtocol,
+        [](DataTransferServer::GetElementT get_element,
+           std::shared_ptr<DataTransferServer>* out) {
+          *out = std::make_shared<SharedMemoryDataTransferServer>(
+              std::move(get_element));
+          return absl::OkStatus();
+        });
+    DataTransferClient::Register(
+        kSharedMemoryTransferProtocol,
+        [](DataTransferClient::Config config,
+           std::unique_ptr<DataTransferClient>* out) {
+          TF_ASSIGN_OR_RETURN(int port, ParsePort(config.address));
+          auto client = std::make_unique<SharedMemoryDataTransferClient>(port);
+          TF_RETURN_IF_ERROR(client->Initialize());
+          *out = std::move(client);
+          return absl::OkStatus();
+        });
+  }
+};
+static SharedMemoryTransferRegistrar shared_memory_transfer_registrar;
+
+}  // namespace
+#endif  // defined(__linux__)
+
+}  // namespace data
+}  // namespace tensorflow
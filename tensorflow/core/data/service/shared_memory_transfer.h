@@ -0,0 +1,96 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SHARED_MEMORY_TRANSFER_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SHARED_MEMORY_TRANSFER_H_
+
+#include <cstdint>
+#include <map>
+#include <optional>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// The "shared_memory" data transfer protocol lets a client read elements from
+// a tf.data service worker on the same host without copying or deserializing
+// the tensors it receives.
+//
+// The client connects to an abstract Unix domain socket named after the port
+// of the worker's transfer server. For each connection, the server creates a
+// shared memory ring and passes its file descriptor to the client, which maps
+// it. The server copies the components of each element into the ring and
+// sends their locations over the socket; the client wraps the mapped memory in
+// tensors, and releases the memory back to the server once the tensors are
+// destroyed. Elements that cannot be placed in the ring (compressed elements,
+// elements with non-POD components, or elements that do not fit in the free
+// part of the ring) are sent over the socket instead.
+//
+// The protocol is only available on Linux. Clients whose connection fails,
+// e.g. because they run on another host, fall back to gRPC.
+constexpr const char kSharedMemoryTransferProtocol[] = "shared_memory";
+
+// Allocates regions of a ring of `capacity` bytes on the server side.
+// Positions in the ring are monotonically increasing byte counts, whose offset
+// in the ring is the position modulo `capacity`.
+//
+// This class is not thread-safe.
+class SharedMemoryRingAllocator {
+ public:
+  struct Region {
+    // The positions [begin, end) occupied by the region, including any padding
+    // skipped at the end of the ring so that the region is contiguous.
+    uint64_t begin;
+    uint64_t end;
+    // The offset of the contiguous data of the region within the ring.
+    uint64_t data_offset;
+  };
+
+  explicit SharedMemoryRingAllocator(uint64_t capacity) : capacity_(capacity) {}
+
+  // Allocates `size` contiguous bytes, given that all positions before
+  // `released` were released by the client. Returns `std::nullopt` if the
+  // region would overwrite memory that has not been released yet.
+  std::optional<Region> Allocate(uint64_t size, uint64_t released);
+
+ private:
+  const uint64_t capacity_;
+  // The position up to which the ring has been allocated.
+  uint64_t allocated_ = 0;
+};
+
+// Tracks the regions of a ring that the client released. Regions may be
+// released in any order, but the server can only reuse the ring up to the
+// first position that has not been released yet.
+//
+// This class is thread-safe.
+class SharedMemoryReleaseTracker {
+ public:
+  // Releases the positions [begin, end), and returns the position before
+  // which all positions have been released.
+  uint64_t Release(uint64_t begin, uint64_t end);
+
+ private:
+  mutex mu_;
+  uint64_t released_ TF_GUARDED_BY(mu_) = 0;
+  // Released regions after `released_`, mapping their begin to their end.
+  std::map<uint64_t, uint64_t> pending_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SHARED_MEMORY_TRANSFER_H_
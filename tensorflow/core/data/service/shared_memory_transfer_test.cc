@@ -0,0 +1,155 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shared_memory_transfer.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/service_config.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+TEST(SharedMemoryRingAllocatorTest, AllocatesContiguousRegions) {
+  SharedMemoryRingAllocator allocator(/*capacity=*/100);
+  std::optional<SharedMemoryRingAllocator::Region> region =
+      allocator.Allocate(40, /*released=*/0);
+  ASSERT_TRUE(region.has_value());
+  EXPECT_EQ(region->begin, 0);
+  EXPECT_EQ(region->end, 40);
+  EXPECT_EQ(region->data_offset, 0);
+
+  region = allocator.Allocate(40, /*released=*/0);
+  ASSERT_TRUE(region.has_value());
+  EXPECT_EQ(region->begin, 40);
+  EXPECT_EQ(region->end, 80);
+  EXPECT_EQ(region->data_offset, 40);
+}
+
+TEST(SharedMemoryRingAllocatorTest, WrapsAroundTheEnd) {
+  SharedMemoryRingAllocator allocator(/*capacity=*/100);
+  ASSERT_TRUE(allocator.Allocate(80, /*released=*/0).has_value());
+  // The remaining 20 bytes at the end are too small, and are still in use.
+  EXPECT_FALSE(allocator.Allocate(30, /*released=*/0).has_value());
+  EXPECT_FALSE(allocator.Allocate(30, /*released=*/10).has_value());
+
+  std::optional<SharedMemoryRingAllocator::Region> region =
+      allocator.Allocate(30, /*released=*/80);
+  ASSERT_TRUE(region.has_value());
+  EXPECT_EQ(region->begin, 80);
+  EXPECT_EQ(region->end, 130);
+  EXPECT_EQ(region->data_offset, 0);
+}
+
+TEST(SharedMemoryRingAllocatorTest, RejectsRegionsLargerThanTheRing) {
+  SharedMemoryRingAllocator allocator(/*capacity=*/100);
+  EXPECT_FALSE(allocator.Allocate(101, /*released=*/0).has_value());
+  EXPECT_TRUE(allocator.Allocate(100, /*released=*/0).has_value());
+  EXPECT_FALSE(allocator.Allocate(1, /*released=*/0).has_value());
+}
+
+TEST(SharedMemoryReleaseTrackerTest, ReleasesOutOfOrder) {
+  SharedMemoryReleaseTracker tracker;
+  EXPECT_EQ(tracker.Release(10, 20), 0);
+  EXPECT_EQ(tracker.Release(20, 30), 0);
+  EXPECT_EQ(tracker.Release(0, 10), 30);
+  EXPECT_EQ(tracker.Release(30, 40), 40);
+}
+
+#if defined(__linux__)
+class SharedMemoryDataTransferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK(DataTransferServer::Build(
+        kSharedMemoryTransferProtocol,
+        [this](const GetElementRequest* request, GetElementResult* result) {
+          *result = element_.Copy();
+          return absl::OkStatus();
+        },
+        &server_));
+    TF_ASSERT_OK(server_->Start(experimental::WorkerConfig()));
+    TF_ASSERT_OK_AND_ASSIGN(std::string compatibility_info,
+                            server_->GetCompatibilityInfo());
+    TF_ASSERT_OK(DataTransferClient::Build(
+        kSharedMemoryTransferProtocol,
+        {kSharedMemoryTransferProtocol,
+         absl::StrCat("localhost:", server_->Port())},
+        &client_));
+    TF_ASSERT_OK(client_->CheckCompatibility(compatibility_info));
+  }
+
+  GetElementResult element_;
+  std::shared_ptr<DataTransferServer> server_;
+  std::unique_ptr<DataTransferClient> client_;
+};
+
+TEST_F(SharedMemoryDataTransferTest, TransfersTensorsThroughTheRing) {
+  element_.components = {test::AsTensor<float>({1, 2, 3}),
+                         test::AsScalar<int64_t>(4)};
+  element_.element_index = 7;
+  for (int i = 0; i < 3; ++i) {
+    GetElementResult result;
+    TF_ASSERT_OK(client_->GetElement(GetElementRequest(), result));
+    EXPECT_EQ(result.element_index, 7);
+    EXPECT_FALSE(result.end_of_sequence);
+    ASSERT_EQ(result.components.size(), 2);
+    test::ExpectTensorEqual<float>(result.components[0],
+                                   element_.components[0]);
+    test::ExpectTensorEqual<int64_t>(result.components[1],
+                                     element_.components[1]);
+  }
+}
+
+TEST_F(SharedMemoryDataTransferTest, SerializesStringTensors) {
+  element_.components = {test::AsTensor<tstring>({"a", "bc"})};
+  GetElementResult result;
+  TF_ASSERT_OK(client_->GetElement(GetElementRequest(), result));
+  ASSERT_EQ(result.components.size(), 1);
+  test::ExpectTensorEqual<tstring>(result.components[0],
+                                   element_.components[0]);
+}
+
+TEST_F(SharedMemoryDataTransferTest, EndOfSequence) {
+  element_.end_of_sequence = true;
+  GetElementResult result;
+  TF_ASSERT_OK(client_->GetElement(GetElementRequest(), result));
+  EXPECT_TRUE(result.end_of_sequence);
+  EXPECT_TRUE(result.components.empty());
+}
+
+TEST(SharedMemoryDataTransferClientTest, FailsWithoutServer) {
+  std::unique_ptr<DataTransferClient> client;
+  EXPECT_FALSE(DataTransferClient::Build(kSharedMemoryTransferProtocol,
+                                         {kSharedMemoryTransferProtocol,
+                                          "localhost:0"},
+                                         &client)
+                   .ok());
+}
+#endif  // defined(__linux__)
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
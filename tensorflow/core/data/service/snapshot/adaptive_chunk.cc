@@ -0,0 +1,354 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/snapshot/adaptive_chunk.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "xla/tsl/lib/io/record_reader.h"
+#include "xla/tsl/lib/io/record_writer.h"
+#include "tensorflow/core/data/service/snapshot/direct_io_file.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/snappy.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/tstring.h"
+#include "zstd.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kMagic[] = "TFDADAPT";
+constexpr size_t kMagicSize = 8;
+
+// Codecs predicted to keep writer threads busier than this are not chosen.
+constexpr double kMaxBusyFraction = 0.8;
+// A more expensive codec is only chosen if it stores at most this fraction of
+// the bytes of the cheaper one.
+constexpr double kMinRatioGain = 0.95;
+// How often a more expensive codec than the chosen one is tried again.
+constexpr int64_t kReprobeInterval = 32;
+// Weight of the latest chunk in the measured ratios, costs, and input rate.
+constexpr double kSmoothingFactor = 0.3;
+
+double Smooth(double average, double sample, int64_t num_samples) {
+  if (num_samples == 0) return sample;
+  return average + kSmoothingFactor * (sample - average);
+}
+
+int ZstdLevel(ChunkCodec codec) {
+  switch (codec) {
+    case ChunkCodec::kZstdFast:
+      return 1;
+    case ChunkCodec::kZstdHigh:
+      return 9;
+    default:
+      return 3;
+  }
+}
+
+absl::Status DataLoss(absl::string_view filename, absl::string_view what) {
+  return absl::DataLossError(
+      absl::StrCat("Corrupted adaptive snapshot chunk ", filename, ": ", what));
+}
+
+absl::Status Compress(ChunkCodec codec, absl::string_view input,
+                      std::string& output) {
+  switch (codec) {
+    case ChunkCodec::kNone:
+      output.assign(input.data(), input.size());
+      return absl::OkStatus();
+    case ChunkCodec::kSnappy:
+      if (!tsl::port::Snappy_Compress(input.data(), input.size(), &output)) {
+        return absl::UnimplementedError(
+            "Snappy compression is not supported on this platform.");
+      }
+      return absl::OkStatus();
+    case ChunkCodec::kZstdFast:
+    case ChunkCodec::kZstd:
+    case ChunkCodec::kZstdHigh: {
+      output.resize(ZSTD_compressBound(input.size()));
+      size_t size = ZSTD_compress(output.data(), output.size(), input.data(),
+                                  input.size(), ZstdLevel(codec));
+      if (ZSTD_isError(size)) {
+        return absl::InternalError(
+            absl::StrCat("zstd compression failed: ", ZSTD_getErrorName(size)));
+      }
+      output.resize(size);
+      return absl::OkStatus();
+    }
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unknown chunk codec ", static_cast<int>(codec)));
+}
+
+absl::Status Uncompress(absl::string_view filename, ChunkCodec codec,
+                        absl::string_view input, std::string& output) {
+  switch (codec) {
+    case ChunkCodec::kNone:
+      output.assign(input.data(), input.size());
+      return absl::OkStatus();
+    case ChunkCodec::kSnappy: {
+      size_t size = 0;
+      if (!tsl::port::Snappy_GetUncompressedLength(input.data(), input.size(),
+                                                   &size)) {
+        return DataLoss(filename, "invalid snappy record");
+      }
+      output.resize(size);
+      if (!tsl::port::Snappy_Uncompress(input.data(), input.size(),
+                                        output.data())) {
+        return DataLoss(filename, "invalid snappy record");
+      }
+      return absl::OkStatus();
+    }
+    case ChunkCodec::kZstdFast:
+    case ChunkCodec::kZstd:
+    case ChunkCodec::kZstdHigh: {
+      unsigned long long size =  // NOLINT(runtime/int)
+          ZSTD_getFrameContentSize(input.data(), input.size());
+      if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR) {
+        return DataLoss(filename, "invalid zstd record");
+      }
+      output.resize(size);
+      size_t result = ZSTD_decompress(output.data(), output.size(),
+                                      input.data(), input.size());
+      if (ZSTD_isError(result) || result != size) {
+        return DataLoss(filename, "invalid zstd record");
+      }
+      return absl::OkStatus();
+    }
+  }
+  return DataLoss(filename, "unknown codec");
+}
+
+}  // namespace
+
+absl::string_view ChunkCodecName(ChunkCodec codec) {
+  switch (codec) {
+    case ChunkCodec::kNone:
+      return "none";
+    case ChunkCodec::kSnappy:
+      return "snappy";
+    case ChunkCodec::kZstdFast:
+      return "zstd_1";
+    case ChunkCodec::kZstd:
+      return "zstd_3";
+    case ChunkCodec::kZstdHigh:
+      return "zstd_9";
+  }
+  return "unknown";
+}
+
+ChunkCodec AdaptiveCodecSelector::NextCodec() {
+  absl::MutexLock l(&mu_);
+  ++num_chunks_;
+  for (int i = 0; i < kNumChunkCodecs; ++i) {
+    ChunkCodec codec = static_cast<ChunkCodec>(i);
+    if (stats_[i].num_chunks == 0) {
+      return codec;
+    }
+    // More expensive codecs would be even busier.
+    if (PredictedBusyFraction(codec) > kMaxBusyFraction) {
+      break;
+    }
+  }
+  ChunkCodec best = BestCodec();
+  int next = static_cast<int>(best) + 1;
+  if (num_chunks_ % kReprobeInterval == 0 && next < kNumChunkCodecs) {
+    return static_cast<ChunkCodec>(next);
+  }
+  return best;
+}
+
+void AdaptiveCodecSelector::RecordChunk(ChunkCodec codec, int64_t raw_bytes,
+                                        int64_t stored_bytes,
+                                        absl::Duration busy,
+                                        absl::Duration idle) {
+  if (raw_bytes <= 0) {
+    return;
+  }
+  absl::MutexLock l(&mu_);
+  CodecStats& stats = stats_[static_cast<int>(codec)];
+  stats.ratio = Smooth(stats.ratio,
+                       static_cast<double>(stored_bytes) / raw_bytes,
+                       stats.num_chunks);
+  stats.cost = Smooth(stats.cost, absl::ToDoubleSeconds(busy) / raw_bytes,
+                      stats.num_chunks);
+
+  int64_t num_rate_samples = 0;
+  for (const CodecStats& codec_stats : stats_) {
+    num_rate_samples += codec_stats.num_chunks;
+  }
+  double seconds = absl::ToDoubleSeconds(busy + idle);
+  if (seconds > 0) {
+    input_rate_ = Smooth(input_rate_, raw_bytes / seconds, num_rate_samples);
+  }
+  ++stats.num_chunks;
+  VLOG(2) << "Wrote adaptive snapshot chunk with codec "
+          << ChunkCodecName(codec) << ": ratio " << stats.ratio
+          << ", predicted busy fraction " << PredictedBusyFraction(codec);
+}
+
+double AdaptiveCodecSelector::PredictedBusyFraction(ChunkCodec codec) const {
+  return input_rate_ * stats_[static_cast<int>(codec)].cost;
+}
+
+ChunkCodec AdaptiveCodecSelector::BestCodec() const {
+  ChunkCodec best = ChunkCodec::kNone;
+  for (int i = 1; i < kNumChunkCodecs; ++i) {
+    ChunkCodec codec = static_cast<ChunkCodec>(i);
+    if (stats_[i].num_chunks == 0 ||
+        PredictedBusyFraction(codec) > kMaxBusyFraction) {
+      continue;
+    }
+    const double best_ratio = stats_[static_cast<int>(best)].ratio;
+    if (stats_[i].ratio < best_ratio * kMinRatioGain) {
+      best = codec;
+    }
+  }
+  return best;
+}
+
+AdaptiveChunkWriter::AdaptiveChunkWriter(const std::string& filename,
+                                         ChunkCodec codec, bool direct_io)
+    : filename_(filename), codec_(codec), direct_io_(direct_io) {}
+
+absl::Status AdaptiveChunkWriter::Initialize(tsl::Env* env) {
+  if (direct_io_) {
+    TF_ASSIGN_OR_RETURN(dest_, NewDirectIoWritableFile(env, filename_));
+  } else {
+    TF_RETURN_IF_ERROR(env->NewWritableFile(filename_, &dest_));
+  }
+  record_writer_ = std::make_unique<tsl::io::RecordWriter>(dest_.get());
+  std::string header(kMagic, kMagicSize);
+  header.push_back(static_cast<char>(codec_));
+  return record_writer_->WriteRecord(header);
+}
+
+absl::Status AdaptiveChunkWriter::WriteTensors(
+    const std::vector<Tensor>& tensors) {
+  if (record_writer_ == nullptr) {
+    return absl::FailedPreconditionError(absl::StrCat(
+        "Adaptive chunk writer for ", filename_, " is not initialized."));
+  }
+  std::string serialized, compressed;
+  for (const Tensor& tensor : tensors) {
+    TensorProto proto;
+    tensor.AsProtoTensorContent(&proto);
+    if (!proto.SerializeToString(&serialized)) {
+      return absl::DataLossError(absl::StrCat(
+          "Failed to serialize tensor proto for ", filename_, "."));
+    }
+    TF_RETURN_IF_ERROR(Compress(codec_, serialized, compressed));
+    TF_RETURN_IF_ERROR(record_writer_->WriteRecord(compressed));
+    raw_bytes_ += serialized.size();
+    stored_bytes_ += compressed.size();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status AdaptiveChunkWriter::Sync() {
+  if (record_writer_ == nullptr) {
+    return absl::OkStatus();
+  }
+  TF_RETURN_IF_ERROR(record_writer_->Flush());
+  return dest_->Sync();
+}
+
+absl::Status AdaptiveChunkWriter::Close() {
+  if (record_writer_ == nullptr) {
+    return absl::OkStatus();
+  }
+  TF_RETURN_IF_ERROR(record_writer_->Close());
+  TF_RETURN_IF_ERROR(dest_->Close());
+  record_writer_ = nullptr;
+  dest_ = nullptr;
+  return absl::OkStatus();
+}
+
+AdaptiveChunkWriter::~AdaptiveChunkWriter() {
+  absl::Status status = Close();
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to close adaptive snapshot chunk " << filename_
+               << ": " << status;
+  }
+}
+
+AdaptiveChunkReader::AdaptiveChunkReader(const std::string& filename,
+                                         const DataTypeVector& dtypes)
+    : filename_(filename), dtypes_(dtypes) {}
+
+absl::Status AdaptiveChunkReader::Initialize(tsl::Env* env) {
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file_));
+  record_reader_ =
+      std::make_unique<tsl::io::SequentialRecordReader>(file_.get());
+  tstring header;
+  TF_RETURN_IF_ERROR(record_reader_->ReadRecord(&header));
+  if (header.size() != kMagicSize + 1 ||
+      absl::string_view(header.data(), kMagicSize) !=
+          absl::string_view(kMagic, kMagicSize)) {
+    return DataLoss(filename_, "invalid header");
+  }
+  const int codec = static_cast<uint8_t>(header[kMagicSize]);
+  if (codec >= kNumChunkCodecs) {
+    return DataLoss(filename_, absl::StrCat("unknown codec ", codec));
+  }
+  codec_ = static_cast<ChunkCodec>(codec);
+  bytes_read_ += header.size();
+  return absl::OkStatus();
+}
+
+absl::Status AdaptiveChunkReader::ReadTensors(
+    std::vector<Tensor>* read_tensors) {
+  read_tensors->clear();
+  read_tensors->reserve(dtypes_.size());
+  for (int i = 0; i < dtypes_.size(); ++i) {
+    TF_ASSIGN_OR_RETURN(Tensor tensor, ReadTensor());
+    read_tensors->push_back(std::move(tensor));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Tensor> AdaptiveChunkReader::ReadTensor() {
+  tstring record;
+  TF_RETURN_IF_ERROR(record_reader_->ReadRecord(&record));
+  bytes_read_ += record.size();
+  std::string serialized;
+  TF_RETURN_IF_ERROR(Uncompress(filename_, codec_, record, serialized));
+  TensorProto proto;
+  Tensor tensor;
+  if (!proto.ParseFromString(serialized) || !tensor.FromProto(proto)) {
+    return DataLoss(filename_, "invalid tensor proto");
+  }
+  return tensor;
+}
+
+}  // namespace data
+}  // namespace tensorflow
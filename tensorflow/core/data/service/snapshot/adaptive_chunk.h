@@ -0,0 +1,176 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SNAPSHOT_ADAPTIVE_CHUNK_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SNAPSHOT_ADAPTIVE_CHUNK_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "xla/tsl/lib/io/record_reader.h"
+#include "xla/tsl/lib/io/record_writer.h"
+#include "tensorflow/core/data/snapshot_utils.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/file_system.h"
+
+namespace tensorflow {
+namespace data {
+
+// The `compression` of a distributed snapshot whose chunks are written by
+// `AdaptiveChunkWriter`, with a codec chosen for every chunk.
+inline constexpr absl::string_view kAdaptiveCompression = "ADAPTIVE";
+
+// Codecs of adaptive chunks, from the cheapest to the most expensive to
+// compress.
+enum class ChunkCodec : uint8_t {
+  kNone = 0,
+  kSnappy = 1,
+  kZstdFast = 2,  // zstd level 1.
+  kZstd = 3,      // zstd level 3.
+  kZstdHigh = 4,  // zstd level 9.
+};
+inline constexpr int kNumChunkCodecs = 5;
+
+// Returns a human-readable name for `codec`, e.g. for metrics labels.
+absl::string_view ChunkCodecName(ChunkCodec codec);
+
+// Chooses the codec of every chunk a `ParallelTFRecordWriter` writes, from the
+// compression ratio and cost measured on the previous chunks and the CPU
+// headroom of the writer threads:
+//
+// - The headroom is the fraction of time writer threads wait for input. With
+//   the measured input rate and the measured cost of every codec, this
+//   predicts the fraction of time the threads would be busy with each codec.
+// - Among codecs predicted to keep the threads at most 80% busy, it prefers
+//   the most expensive one that shrinks chunks by at least 5% more than the
+//   next cheaper candidate. Otherwise, it uses the cheapest codec.
+// - Codecs that have not been measured are tried once, cheapest first. Every
+//   32 chunks, the next more expensive codec is tried again, so that the
+//   choice follows changes in the data.
+//
+// This class is thread-safe.
+class AdaptiveCodecSelector {
+ public:
+  // Returns the codec for the next chunk.
+  ChunkCodec NextCodec();
+
+  // Records that a chunk of `raw_bytes` was stored in `stored_bytes` with
+  // `codec`, and that its writer thread spent `busy` encoding and writing it
+  // and `idle` waiting for input.
+  void RecordChunk(ChunkCodec codec, int64_t raw_bytes, int64_t stored_bytes,
+                   absl::Duration busy, absl::Duration idle);
+
+ private:
+  struct CodecStats {
+    int64_t num_chunks = 0;
+    // Stored bytes per raw byte.
+    double ratio = 1.0;
+    // Busy seconds per raw byte.
+    double cost = 0.0;
+  };
+
+  // Predicted fraction of time writer threads are busy with `codec`.
+  double PredictedBusyFraction(ChunkCodec codec) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  ChunkCodec BestCodec() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable absl::Mutex mu_;
+  std::array<CodecStats, kNumChunkCodecs> stats_ ABSL_GUARDED_BY(mu_);
+  // Raw bytes arriving per second of writer thread time.
+  double input_rate_ ABSL_GUARDED_BY(mu_) = 0.0;
+  int64_t num_chunks_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+// Writes a snapshot chunk as an uncompressed TFRecord file whose first record
+// is a header naming the codec of the chunk. Every other record is one tensor,
+// serialized as a `TensorProto` and compressed with that codec, so that the
+// codec can change from one chunk to the next without changing the snapshot
+// metadata.
+//
+// If `direct_io` is true, the file is written with `NewDirectIoWritableFile`.
+class AdaptiveChunkWriter : public snapshot_util::Writer {
+ public:
+  AdaptiveChunkWriter(const std::string& filename, ChunkCodec codec,
+                      bool direct_io = false);
+
+  absl::Status Initialize(tsl::Env* env) override;
+
+  absl::Status WriteTensors(const std::vector<Tensor>& tensors) override;
+
+  absl::Status Sync() override;
+
+  absl::Status Close() override;
+
+  ~AdaptiveChunkWriter() override;
+
+  // Number of serialized bytes before compression, and stored in the file.
+  int64_t RawBytes() const { return raw_bytes_; }
+  int64_t StoredBytes() const { return stored_bytes_; }
+
+ private:
+  const std::string filename_;
+  const ChunkCodec codec_;
+  const bool direct_io_;
+
+  std::unique_ptr<tsl::WritableFile> dest_;
+  std::unique_ptr<tsl::io::RecordWriter> record_writer_;
+  int64_t raw_bytes_ = 0;
+  int64_t stored_bytes_ = 0;
+};
+
+// Reads chunks written by `AdaptiveChunkWriter`.
+class AdaptiveChunkReader : public snapshot_util::Reader {
+ public:
+  AdaptiveChunkReader(const std::string& filename,
+                      const DataTypeVector& dtypes);
+
+  absl::Status Initialize(tsl::Env* env) override;
+
+  // Reads the next element into `read_tensors`. Returns OutOfRange at the end
+  // of the file.
+  absl::Status ReadTensors(std::vector<Tensor>* read_tensors) override;
+
+  // Returns the codec of the chunk. Only valid after `Initialize`.
+  ChunkCodec codec() const { return codec_; }
+
+  // Returns the number of bytes read from the file.
+  uint64_t BytesRead() const { return bytes_read_; }
+
+ private:
+  absl::StatusOr<Tensor> ReadTensor();
+
+  const std::string filename_;
+  const DataTypeVector dtypes_;
+
+  std::unique_ptr<tsl::RandomAccessFile> file_;
+  std::unique_ptr<tsl::io::SequentialRecordReader> record_reader_;
+  ChunkCodec codec_ = ChunkCodec::kNone;
+  uint64_t bytes_read_ = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SNAPSHOT_ADAPTIVE_CHUNK_H_
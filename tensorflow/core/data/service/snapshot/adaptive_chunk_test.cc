@@ -0,0 +1,208 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/snapshot/adaptive_chunk.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/status_matchers.h"
+#include "tsl/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::tsl::testing::StatusIs;
+
+std::string TestFile() {
+  std::string filename;
+  EXPECT_TRUE(tsl::Env::Default()->LocalTempFilename(&filename));
+  return filename;
+}
+
+// Element `i` has a scalar int64 and a repetitive string vector of length
+// `i % 4`.
+std::vector<Tensor> MakeElement(int64_t i) {
+  Tensor strings(DT_STRING, TensorShape({i % 4}));
+  for (int64_t j = 0; j < i % 4; ++j) {
+    strings.vec<tstring>()(j) =
+        absl::StrCat(std::string(100, 'a' + j), " element ", i);
+  }
+  return {Tensor(i), strings};
+}
+
+class AdaptiveChunkTest : public ::testing::TestWithParam<ChunkCodec> {};
+
+TEST_P(AdaptiveChunkTest, ReadWrite) {
+  const std::string filename = TestFile();
+  AdaptiveChunkWriter writer(filename, GetParam());
+  TF_ASSERT_OK(writer.Initialize(tsl::Env::Default()));
+  for (int64_t i = 0; i < 100; ++i) {
+    TF_ASSERT_OK(writer.WriteTensors(MakeElement(i)));
+  }
+  TF_ASSERT_OK(writer.Close());
+  if (GetParam() == ChunkCodec::kNone) {
+    EXPECT_EQ(writer.StoredBytes(), writer.RawBytes());
+  } else {
+    EXPECT_LT(writer.StoredBytes(), writer.RawBytes());
+  }
+
+  AdaptiveChunkReader reader(filename, {DT_INT64, DT_STRING});
+  TF_ASSERT_OK(reader.Initialize(tsl::Env::Default()));
+  EXPECT_EQ(reader.codec(), GetParam());
+  for (int64_t i = 0; i < 100; ++i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(reader.ReadTensors(&element));
+    std::vector<Tensor> expected = MakeElement(i);
+    ASSERT_EQ(element.size(), expected.size());
+    for (int j = 0; j < element.size(); ++j) {
+      test::ExpectEqual(element[j], expected[j]);
+    }
+  }
+  std::vector<Tensor> element;
+  EXPECT_THAT(reader.ReadTensors(&element),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+INSTANTIATE_TEST_SUITE_P(Codecs, AdaptiveChunkTest,
+                         ::testing::Values(ChunkCodec::kNone,
+                                           ChunkCodec::kSnappy,
+                                           ChunkCodec::kZstdFast,
+                                           ChunkCodec::kZstd,
+                                           ChunkCodec::kZstdHigh));
+
+TEST(AdaptiveChunkTest, DirectIo) {
+  const std::string filename = TestFile();
+  AdaptiveChunkWriter writer(filename, ChunkCodec::kZstd, /*direct_io=*/true);
+  TF_ASSERT_OK(writer.Initialize(tsl::Env::Default()));
+  for (int64_t i = 0; i < 1000; ++i) {
+    TF_ASSERT_OK(writer.WriteTensors(MakeElement(i)));
+  }
+  TF_ASSERT_OK(writer.Close());
+
+  AdaptiveChunkReader reader(filename, {DT_INT64, DT_STRING});
+  TF_ASSERT_OK(reader.Initialize(tsl::Env::Default()));
+  for (int64_t i = 0; i < 1000; ++i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(reader.ReadTensors(&element));
+    test::ExpectEqual(element[0], Tensor(i));
+  }
+}
+
+TEST(AdaptiveChunkTest, NotAnAdaptiveChunk) {
+  const std::string filename = TestFile();
+  snapshot_util::TFRecordWriter writer(filename, "");
+  TF_ASSERT_OK(writer.Initialize(tsl::Env::Default()));
+  TF_ASSERT_OK(writer.WriteTensors(MakeElement(1)));
+  TF_ASSERT_OK(writer.Close());
+
+  AdaptiveChunkReader reader(filename, {DT_INT64, DT_STRING});
+  EXPECT_THAT(reader.Initialize(tsl::Env::Default()),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+// Records a 1MB chunk written by a thread that is busy for `busy_seconds` out
+// of every 0.1 seconds.
+void RecordChunk(AdaptiveCodecSelector& selector, ChunkCodec codec,
+                 double ratio, double busy_seconds) {
+  constexpr int64_t kRawBytes = 1 << 20;
+  selector.RecordChunk(codec, kRawBytes,
+                       /*stored_bytes=*/static_cast<int64_t>(ratio * kRawBytes),
+                       absl::Seconds(busy_seconds),
+                       absl::Seconds(0.1 - busy_seconds));
+}
+
+TEST(AdaptiveCodecSelectorTest, TriesCodecsCheapestFirst) {
+  AdaptiveCodecSelector selector;
+  EXPECT_EQ(selector.NextCodec(), ChunkCodec::kNone);
+  RecordChunk(selector, ChunkCodec::kNone, 1.0, 0.001);
+  EXPECT_EQ(selector.NextCodec(), ChunkCodec::kSnappy);
+  RecordChunk(selector, ChunkCodec::kSnappy, 0.5, 0.002);
+  EXPECT_EQ(selector.NextCodec(), ChunkCodec::kZstdFast);
+  RecordChunk(selector, ChunkCodec::kZstdFast, 0.4, 0.005);
+  EXPECT_EQ(selector.NextCodec(), ChunkCodec::kZstd);
+  RecordChunk(selector, ChunkCodec::kZstd, 0.35, 0.01);
+  EXPECT_EQ(selector.NextCodec(), ChunkCodec::kZstdHigh);
+}
+
+TEST(AdaptiveCodecSelectorTest, PrefersSmallerChunksWithHeadroom) {
+  AdaptiveCodecSelector selector;
+  RecordChunk(selector, ChunkCodec::kNone, 1.0, 0.001);
+  RecordChunk(selector, ChunkCodec::kSnappy, 0.5, 0.002);
+  RecordChunk(selector, ChunkCodec::kZstdFast, 0.4, 0.005);
+  RecordChunk(selector, ChunkCodec::kZstd, 0.35, 0.01);
+  // Level 9 is not worth it: it saves less than 5% over level 3.
+  RecordChunk(selector, ChunkCodec::kZstdHigh, 0.34, 0.05);
+  EXPECT_EQ(selector.NextCodec(), ChunkCodec::kZstd);
+}
+
+TEST(AdaptiveCodecSelectorTest, AvoidsExpensiveCodecsWithoutHeadroom) {
+  AdaptiveCodecSelector selector;
+  RecordChunk(selector, ChunkCodec::kNone, 1.0, 0.001);
+  RecordChunk(selector, ChunkCodec::kSnappy, 0.5, 0.002);
+  RecordChunk(selector, ChunkCodec::kZstdFast, 0.4, 0.09);
+  // More expensive zstd levels are not tried.
+  EXPECT_EQ(selector.NextCodec(), ChunkCodec::kSnappy);
+  EXPECT_EQ(selector.NextCodec(), ChunkCodec::kSnappy);
+}
+
+TEST(AdaptiveCodecSelectorTest, IncompressibleData) {
+  AdaptiveCodecSelector selector;
+  RecordChunk(selector, ChunkCodec::kNone, 1.0, 0.001);
+  RecordChunk(selector, ChunkCodec::kSnappy, 0.99, 0.002);
+  RecordChunk(selector, ChunkCodec::kZstdFast, 0.98, 0.005);
+  RecordChunk(selector, ChunkCodec::kZstd, 0.97, 0.01);
+  RecordChunk(selector, ChunkCodec::kZstdHigh, 0.97, 0.05);
+  EXPECT_EQ(selector.NextCodec(), ChunkCodec::kNone);
+}
+
+TEST(AdaptiveCodecSelectorTest, RetriesMoreExpensiveCodec) {
+  AdaptiveCodecSelector selector;
+  RecordChunk(selector, ChunkCodec::kNone, 1.0, 0.001);
+  RecordChunk(selector, ChunkCodec::kSnappy, 0.5, 0.002);
+  RecordChunk(selector, ChunkCodec::kZstdFast, 0.49, 0.005);
+  RecordChunk(selector, ChunkCodec::kZstd, 0.49, 0.01);
+  RecordChunk(selector, ChunkCodec::kZstdHigh, 0.49, 0.05);
+  int num_retries = 0;
+  for (int i = 0; i < 64; ++i) {
+    ChunkCodec codec = selector.NextCodec();
+    if (codec == ChunkCodec::kZstdFast) {
+      ++num_retries;
+    } else {
+      EXPECT_EQ(codec, ChunkCodec::kSnappy);
+    }
+  }
+  EXPECT_EQ(num_retries, 2);
+}
+
+TEST(AdaptiveChunkTest, ChunkCodecName) {
+  EXPECT_EQ(ChunkCodecName(ChunkCodec::kNone), "none");
+  EXPECT_EQ(ChunkCodecName(ChunkCodec::kSnappy), "snappy");
+  EXPECT_EQ(ChunkCodecName(ChunkCodec::kZstdHigh), "zstd_9");
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,496 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/snapshot/columnar_chunk.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "xla/tsl/lib/io/compression.h"
+#include "tensorflow/core/data/service/snapshot/adaptive_chunk.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/snappy.h"
+#include "tsl/platform/tstring.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kMagic[] = "TFDCOLCK";
+constexpr size_t kMagicSize = 8;
+constexpr uint64_t kVersion = 1;
+// Footer size, magic.
+constexpr uint64_t kTrailerSize = 8 + kMagicSize;
+
+// How a column is stored in the file.
+enum Codec : uint64_t {
+  kUncompressed = 0,
+  kSnappy = 1,
+};
+
+absl::Status DataLoss(absl::string_view filename, absl::string_view what) {
+  return absl::DataLossError(
+      absl::StrCat("Corrupted columnar snapshot chunk ", filename, ": ", what));
+}
+
+// Encodes `tensors`, which all have `dtype`, as the payload of a column.
+absl::Status EncodeColumn(DataType dtype, const std::vector<Tensor>& tensors,
+                          std::string* column) {
+  std::string shapes;
+  for (const Tensor& t : tensors) {
+    core::PutVarint64(&shapes, t.dims());
+    for (int64_t dim : t.shape().dim_sizes()) core::PutVarint64(&shapes, dim);
+  }
+  column->clear();
+  core::PutVarint64(column, shapes.size());
+  column->append(shapes);
+  if (DataTypeCanUseMemcpy(dtype)) {
+    for (const Tensor& t : tensors) {
+      absl::string_view data = t.tensor_data();
+      column->append(data.data(), data.size());
+    }
+  } else if (dtype == DT_STRING) {
+    std::string lengths;
+    for (const Tensor& t : tensors) {
+      auto strings = t.unaligned_flat<tstring>();
+      for (int64_t i = 0; i < strings.size(); ++i) {
+        core::PutVarint64(&lengths, strings(i).size());
+      }
+    }
+    core::PutVarint64(column, lengths.size());
+    column->append(lengths);
+    for (const Tensor& t : tensors) {
+      auto strings = t.unaligned_flat<tstring>();
+      for (int64_t i = 0; i < strings.size(); ++i) {
+        column->append(strings(i).data(), strings(i).size());
+      }
+    }
+  } else {
+    for (const Tensor& t : tensors) {
+      TensorProto proto;
+      t.AsProtoTensorContent(&proto);
+      std::string serialized;
+      if (!proto.SerializeToString(&serialized)) {
+        return absl::InternalError(absl::StrCat(
+            "Failed to serialize tensor of type ", DataTypeString(dtype),
+            " for a columnar snapshot chunk."));
+      }
+      core::PutVarint64(column, serialized.size());
+      column->append(serialized);
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Decodes a column of `num_elements` tensors of `dtype` from `column`.
+absl::Status DecodeColumn(absl::string_view filename, DataType dtype,
+                          uint64_t num_elements, absl::string_view column,
+                          std::vector<Tensor>* tensors) {
+  uint64_t shapes_size;
+  if (!core::GetVarint64(&column, &shapes_size) ||
+      shapes_size > column.size()) {
+    return DataLoss(filename, "invalid column shapes");
+  }
+  absl::string_view shapes = column.substr(0, shapes_size);
+  column.remove_prefix(shapes_size);
+  tensors->clear();
+  tensors->reserve(num_elements);
+  for (uint64_t i = 0; i < num_elements; ++i) {
+    uint64_t rank;
+    if (!core::GetVarint64(&shapes, &rank)) {
+      return DataLoss(filename, "invalid tensor rank");
+    }
+    TensorShape shape;
+    for (uint64_t d = 0; d < rank; ++d) {
+      uint64_t dim;
+      if (!core::GetVarint64(&shapes, &dim)) {
+        return DataLoss(filename, "invalid tensor shape");
+      }
+      TF_RETURN_IF_ERROR(shape.AddDimWithStatus(dim));
+    }
+    if (DataTypeCanUseMemcpy(dtype)) {
+      tensors->emplace_back(dtype, shape);
+    } else if (dtype == DT_STRING) {
+      tensors->emplace_back(DT_STRING, shape);
+    } else {
+      uint64_t size;
+      if (!core::GetVarint64(&column, &size) || size > column.size()) {
+        return DataLoss(filename, "invalid tensor proto");
+      }
+      TensorProto proto;
+      Tensor t;
+      if (!proto.ParseFromArray(column.data(), size) || !t.FromProto(proto) ||
+          t.shape() != shape) {
+        return DataLoss(filename, "invalid tensor proto");
+      }
+      column.remove_prefix(size);
+      tensors->push_back(std::move(t));
+    }
+  }
+  if (DataTypeCanUseMemcpy(dtype)) {
+    for (Tensor& t : *tensors) {
+      const size_t size = t.TotalBytes();
+      if (size > column.size()) {
+        return DataLoss(filename, "truncated tensor data");
+      }
+      if (size > 0) std::memcpy(t.data(), column.data(), size);
+      column.remove_prefix(size);
+    }
+  } else if (dtype == DT_STRING) {
+    uint64_t lengths_size;
+    if (!core::GetVarint64(&column, &lengths_size) ||
+        lengths_size > column.size()) {
+      return DataLoss(filename, "invalid string lengths");
+    }
+    absl::string_view lengths = column.substr(0, lengths_size);
+    column.remove_prefix(lengths_size);
+    for (Tensor& t : *tensors) {
+      auto strings = t.unaligned_flat<tstring>();
+      for (int64_t i = 0; i < strings.size(); ++i) {
+        uint64_t length;
+        if (!core::GetVarint64(&lengths, &length) || length > column.size()) {
+          return DataLoss(filename, "truncated string data");
+        }
+        strings(i).assign(column.data(), length);
+        column.remove_prefix(length);
+      }
+    }
+  }
+  if (!column.empty()) {
+    return DataLoss(filename, "unexpected data at the end of a column");
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+std::string TFRecordCompression(absl::string_view compression) {
+  if (compression == kColumnarCompression ||
+      compression == kAdaptiveCompression) {
+    return tsl::io::compression::kSnappy;
+  }
+  return std::string(compression);
+}
+
+ColumnarChunkWriter::ColumnarChunkWriter(const std::string& filename,
+                                         int64_t block_size)
+    : filename_(filename), block_size_(block_size) {}
+
+absl::Status ColumnarChunkWriter::Initialize(tsl::Env* env) {
+  return env->NewWritableFile(filename_, &dest_);
+}
+
+absl::Status ColumnarChunkWriter::WriteTensors(
+    const std::vector<Tensor>& tensors) {
+  if (dest_ == nullptr) {
+    return absl::FailedPreconditionError(absl::StrCat(
+        "Trying to write to a closed columnar snapshot chunk ", filename_));
+  }
+  if (columns_.empty()) {
+    for (const Tensor& t : tensors) dtypes_.push_back(t.dtype());
+    columns_.resize(tensors.size());
+  }
+  if (tensors.size() != dtypes_.size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "All elements of a columnar snapshot chunk must have the same number "
+        "of components. Expected ",
+        dtypes_.size(), ", got ", tensors.size()));
+  }
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    if (tensors[i].dtype() != dtypes_[i]) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Component ", i, " of the elements of a columnar snapshot chunk must "
+          "have type ",
+          DataTypeString(dtypes_[i]), ", got ",
+          DataTypeString(tensors[i].dtype())));
+    }
+    columns_[i].push_back(tensors[i]);
+    buffered_bytes_ += tensors[i].TotalBytes();
+  }
+  if (buffered_bytes_ >= block_size_) {
+    return FlushBlock();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarChunkWriter::FlushBlock() {
+  if (columns_.empty() || columns_[0].empty()) {
+    return absl::OkStatus();
+  }
+  ColumnarBlockLocation block;
+  block.num_elements = columns_[0].size();
+  std::string raw, compressed;
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    TF_RETURN_IF_ERROR(EncodeColumn(dtypes_[i], columns_[i], &raw));
+    columns_[i].clear();
+    ColumnarBlockLocation::Column column;
+    column.offset = offset_;
+    column.raw_size = raw.size();
+    absl::string_view stored = raw;
+    // Snappy_Compress fails if TensorFlow is built without Snappy, in which
+    // case the column is stored uncompressed.
+    if (tsl::port::Snappy_Compress(raw.data(), raw.size(), &compressed) &&
+        compressed.size() < raw.size()) {
+      column.codec = kSnappy;
+      stored = compressed;
+    }
+    column.stored_size = stored.size();
+    TF_RETURN_IF_ERROR(dest_->Append(stored));
+    offset_ += stored.size();
+    block.columns.push_back(column);
+  }
+  blocks_.push_back(std::move(block));
+  buffered_bytes_ = 0;
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarChunkWriter::Sync() {
+  if (dest_ == nullptr) {
+    return absl::OkStatus();
+  }
+  TF_RETURN_IF_ERROR(FlushBlock());
+  return dest_->Sync();
+}
+
+absl::Status ColumnarChunkWriter::Close() {
+  if (dest_ == nullptr) {
+    return absl::OkStatus();
+  }
+  TF_RETURN_IF_ERROR(FlushBlock());
+  std::string footer;
+  core::PutVarint64(&footer, kVersion);
+  core::PutVarint64(&footer, dtypes_.size());
+  for (DataType dtype : dtypes_) core::PutVarint64(&footer, dtype);
+  core::PutVarint64(&footer, blocks_.size());
+  for (const ColumnarBlockLocation& block : blocks_) {
+    core::PutVarint64(&footer, block.num_elements);
+    for (const ColumnarBlockLocation::Column& column : block.columns) {
+      core::PutVarint64(&footer, column.offset);
+      core::PutVarint64(&footer, column.stored_size);
+      core::PutVarint64(&footer, column.raw_size);
+      core::PutVarint64(&footer, column.codec);
+    }
+  }
+  core::PutFixed64(&footer, footer.size());
+  footer.append(kMagic, kMagicSize);
+  TF_RETURN_IF_ERROR(dest_->Append(footer));
+  TF_RETURN_IF_ERROR(dest_->Close());
+  dest_ = nullptr;
+  return absl::OkStatus();
+}
+
+ColumnarChunkWriter::~ColumnarChunkWriter() {
+  absl::Status s = Close();
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to close snapshot file " << filename_ << ": " << s;
+  }
+}
+
+ColumnarChunkReader::ColumnarChunkReader(const std::string& filename,
+                                         const DataTypeVector& dtypes,
+                                         std::vector<int64_t> components)
+    : filename_(filename),
+      dtypes_(dtypes),
+      components_(std::move(components)) {}
+
+absl::Status ColumnarChunkReader::Initialize(tsl::Env* env) {
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file_));
+  TF_RETURN_IF_ERROR(ReadFooter(env));
+  if (components_.empty()) {
+    for (int64_t i = 0; i < file_dtypes_.size(); ++i) components_.push_back(i);
+  }
+  if (blocks_.empty()) {
+    return absl::OkStatus();
+  }
+  if (components_.size() != dtypes_.size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Reading ", components_.size(), " components of columnar snapshot "
+        "chunk ",
+        filename_, ", but ", dtypes_.size(), " dtypes were given."));
+  }
+  for (size_t i = 0; i < components_.size(); ++i) {
+    const int64_t component = components_[i];
+    if (component < 0 || component >= file_dtypes_.size()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Columnar snapshot chunk ", filename_, " has ", file_dtypes_.size(),
+          " components, cannot read component ", component));
+    }
+    if (file_dtypes_[component] != dtypes_[i]) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Component ", component, " of columnar snapshot chunk ", filename_,
+          " has type ", DataTypeString(file_dtypes_[component]),
+          ", expected ", DataTypeString(dtypes_[i])));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarChunkReader::ReadFooter(tsl::Env* env) {
+  uint64_t file_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename_, &file_size));
+  if (file_size < kTrailerSize) {
+    return DataLoss(filename_, "file is too small");
+  }
+  std::string trailer(kTrailerSize, '\0');
+  absl::string_view result;
+  TF_RETURN_IF_ERROR(file_->Read(file_size - kTrailerSize, kTrailerSize,
+                                 &result, trailer.data()));
+  if (result.size() != kTrailerSize ||
+      result.substr(8) != absl::string_view(kMagic, kMagicSize)) {
+    return DataLoss(filename_, "invalid magic number");
+  }
+  const uint64_t footer_size = core::DecodeFixed64(result.data());
+  if (footer_size > file_size - kTrailerSize) {
+    return DataLoss(filename_, "invalid footer size");
+  }
+  std::string footer_buffer(footer_size, '\0');
+  TF_RETURN_IF_ERROR(file_->Read(file_size - kTrailerSize - footer_size,
+                                 footer_size, &result, footer_buffer.data()));
+  bytes_read_ += kTrailerSize + result.size();
+  absl::string_view footer = result;
+  uint64_t version, num_components, num_blocks;
+  if (!core::GetVarint64(&footer, &version) || version != kVersion) {
+    return DataLoss(filename_, "unsupported version");
+  }
+  if (!core::GetVarint64(&footer, &num_components)) {
+    return DataLoss(filename_, "invalid number of components");
+  }
+  for (uint64_t i = 0; i < num_components; ++i) {
+    uint64_t dtype;
+    if (!core::GetVarint64(&footer, &dtype) || !DataType_IsValid(dtype)) {
+      return DataLoss(filename_, "invalid dtype");
+    }
+    file_dtypes_.push_back(static_cast<DataType>(dtype));
+  }
+  if (!core::GetVarint64(&footer, &num_blocks)) {
+    return DataLoss(filename_, "invalid number of blocks");
+  }
+  for (uint64_t b = 0; b < num_blocks; ++b) {
+    ColumnarBlockLocation block;
+    if (!core::GetVarint64(&footer, &block.num_elements)) {
+      return DataLoss(filename_, "invalid block");
+    }
+    block.columns.resize(num_components);
+    for (ColumnarBlockLocation::Column& column : block.columns) {
+      if (!core::GetVarint64(&footer, &column.offset) ||
+          !core::GetVarint64(&footer, &column.stored_size) ||
+          !core::GetVarint64(&footer, &column.raw_size) ||
+          !core::GetVarint64(&footer, &column.codec) ||
+          column.offset + column.stored_size > file_size) {
+        return DataLoss(filename_, "invalid column location");
+      }
+    }
+    blocks_.push_back(std::move(block));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarChunkReader::ReadBlock() {
+  const ColumnarBlockLocation& block = blocks_[next_block_];
+  columns_.resize(components_.size());
+  std::string stored, raw;
+  for (size_t i = 0; i < components_.size(); ++i) {
+    const ColumnarBlockLocation::Column& column =
+        block.columns[components_[i]];
+    stored.resize(column.stored_size);
+    absl::string_view result;
+    TF_RETURN_IF_ERROR(file_->Read(column.offset, column.stored_size, &result,
+                                   stored.data()));
+    if (result.size() != column.stored_size) {
+      return DataLoss(filename_, "truncated column");
+    }
+    bytes_read_ += result.size();
+    absl::string_view data = result;
+    if (column.codec == kSnappy) {
+      raw.resize(column.raw_size);
+      if (!tsl::port::Snappy_Uncompress(result.data(), result.size(),
+                                        raw.data())) {
+        return DataLoss(filename_, "failed to uncompress a column");
+      }
+      data = raw;
+    } else if (column.codec != kUncompressed) {
+      return DataLoss(filename_, "unknown codec");
+    }
+    TF_RETURN_IF_ERROR(DecodeColumn(filename_, dtypes_[i], block.num_elements,
+                                    data, &columns_[i]));
+  }
+  ++next_block_;
+  current_block_size_ = block.num_elements;
+  next_element_ = 0;
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarChunkReader::ReadTensors(
+    std::vector<Tensor>* read_tensors) {
+  while (next_element_ >= current_block_size_) {
+    if (next_block_ >= blocks_.size()) {
+      return absl::OutOfRangeError("End of columnar snapshot chunk.");
+    }
+    TF_RETURN_IF_ERROR(ReadBlock());
+  }
+  read_tensors->clear();
+  read_tensors->reserve(columns_.size());
+  for (std::vector<Tensor>& column : columns_) {
+    read_tensors->push_back(std::move(column[next_element_]));
+  }
+  ++next_element_;
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarChunkReader::SkipRecords(int64_t num_records) {
+  const int64_t in_current_block =
+      std::min(num_records, current_block_size_ - next_element_);
+  next_element_ += in_current_block;
+  num_records -= in_current_block;
+  while (num_records > 0 && next_block_ < blocks_.size() &&
+         blocks_[next_block_].num_elements <= num_records) {
+    num_records -= blocks_[next_block_].num_elements;
+    ++next_block_;
+  }
+  if (num_records == 0) {
+    return absl::OkStatus();
+  }
+  if (next_block_ >= blocks_.size()) {
+    return absl::OutOfRangeError("End of columnar snapshot chunk.");
+  }
+  TF_RETURN_IF_ERROR(ReadBlock());
+  next_element_ = num_records;
+  return absl::OkStatus();
+}
+
+int64_t ColumnarChunkReader::NumRecords() const {
+  int64_t num_records = 0;
+  for (const ColumnarBlockLocation& block : blocks_) {
+    num_records += block.num_elements;
+  }
+  return num_records;
+}
+
+}  // namespace data
+}  // namespace tensorflow
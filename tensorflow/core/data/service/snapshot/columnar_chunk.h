@@ -0,0 +1,158 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SNAPSHOT_COLUMNAR_CHUNK_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SNAPSHOT_COLUMNAR_CHUNK_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/data/snapshot_utils.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/file_system.h"
+
+namespace tensorflow {
+namespace data {
+
+// The `compression` of a distributed snapshot whose chunks are written by
+// `ColumnarChunkWriter` instead of as TFRecords.
+inline constexpr absl::string_view kColumnarCompression = "COLUMNAR";
+
+// Returns the compression of the TFRecord files (e.g. checkpoints) written for
+// a snapshot with `compression`. Columnar and adaptive snapshots use Snappy.
+std::string TFRecordCompression(absl::string_view compression);
+
+// Where a block of a columnar chunk is stored in the file.
+struct ColumnarBlockLocation {
+  struct Column {
+    uint64_t offset = 0;
+    // The number of bytes in the file, and after decompression.
+    uint64_t stored_size = 0;
+    uint64_t raw_size = 0;
+    uint64_t codec = 0;
+  };
+
+  uint64_t num_elements = 0;
+  std::vector<Column> columns;
+};
+
+// Writes a snapshot chunk in a columnar format, in which every component of
+// the elements is stored and compressed separately, so that readers can read
+// and decode only the components they need.
+//
+// Elements are buffered into blocks of about `block_size` bytes. A block holds
+// one column per component, which contains the shapes and then the values of
+// that component of every element of the block:
+//
+// - Memcpy-able tensors are stored as their raw bytes, and strings as their
+//   lengths followed by their bytes, so that a column is decoded with one
+//   memcpy per tensor rather than by parsing protos.
+// - Other tensors are stored as serialized `TensorProto`s.
+//
+// Every column picks its own codec: it is compressed with Snappy unless that
+// does not make it smaller. The file ends with a footer that holds the dtypes
+// and, for every block, the number of elements and the location and codec of
+// every column.
+class ColumnarChunkWriter : public snapshot_util::Writer {
+ public:
+  static constexpr int64_t kDefaultBlockSize = 4 << 20;  // 4MB
+
+  explicit ColumnarChunkWriter(const std::string& filename,
+                               int64_t block_size = kDefaultBlockSize);
+
+  absl::Status Initialize(tsl::Env* env) override;
+
+  absl::Status WriteTensors(const std::vector<Tensor>& tensors) override;
+
+  absl::Status Sync() override;
+
+  absl::Status Close() override;
+
+  ~ColumnarChunkWriter() override;
+
+ private:
+  // Encodes, compresses, and appends the buffered elements as one block.
+  absl::Status FlushBlock();
+
+  const std::string filename_;
+  const int64_t block_size_;
+
+  std::unique_ptr<tsl::WritableFile> dest_;
+  uint64_t offset_ = 0;
+  DataTypeVector dtypes_;
+  // The buffered tensors of every component.
+  std::vector<std::vector<Tensor>> columns_;
+  int64_t buffered_bytes_ = 0;
+  std::vector<ColumnarBlockLocation> blocks_;
+};
+
+// Reads chunks written by `ColumnarChunkWriter`.
+//
+// Only the columns of the projected `components` are read from the file and
+// decoded. Elements are returned with only those components, in the order of
+// `components`. An empty `components` reads all of them.
+class ColumnarChunkReader : public snapshot_util::Reader {
+ public:
+  // `dtypes` are the dtypes of the returned (i.e. projected) components.
+  ColumnarChunkReader(const std::string& filename, const DataTypeVector& dtypes,
+                      std::vector<int64_t> components = {});
+
+  absl::Status Initialize(tsl::Env* env) override;
+
+  // Reads the next element into `read_tensors`. Returns OutOfRange at the end
+  // of the file.
+  absl::Status ReadTensors(std::vector<Tensor>* read_tensors) override;
+
+  // Skips `num_records` elements, without reading the blocks that are skipped
+  // entirely.
+  absl::Status SkipRecords(int64_t num_records) override;
+
+  // Returns the number of elements in the chunk.
+  int64_t NumRecords() const;
+
+  // Returns the number of bytes read from the file.
+  uint64_t BytesRead() const { return bytes_read_; }
+
+ private:
+  absl::Status ReadFooter(tsl::Env* env);
+
+  // Reads and decodes the projected columns of block `next_block_`.
+  absl::Status ReadBlock();
+
+  const std::string filename_;
+  const DataTypeVector dtypes_;
+  std::vector<int64_t> components_;
+
+  std::unique_ptr<tsl::RandomAccessFile> file_;
+  uint64_t bytes_read_ = 0;
+  DataTypeVector file_dtypes_;
+  std::vector<ColumnarBlockLocation> blocks_;
+  int64_t next_block_ = 0;
+  // The decoded projected columns of the current block, and the index of the
+  // next element in them.
+  std::vector<std::vector<Tensor>> columns_;
+  int64_t current_block_size_ = 0;
+  int64_t next_element_ = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SNAPSHOT_COLUMNAR_CHUNK_H_
@@ -0,0 +1,179 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/snapshot/columnar_chunk.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/status_matchers.h"
+#include "tsl/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::tsl::testing::StatusIs;
+
+std::string TestFile() {
+  std::string filename;
+  EXPECT_TRUE(tsl::Env::Default()->LocalTempFilename(&filename));
+  return filename;
+}
+
+// Element `i` has a scalar int64, a float vector of length `i % 5`, and a
+// string matrix of shape [2, i % 3].
+std::vector<Tensor> MakeElement(int64_t i) {
+  Tensor floats(DT_FLOAT, TensorShape({i % 5}));
+  for (int64_t j = 0; j < i % 5; ++j) floats.vec<float>()(j) = i + j / 10.0f;
+  Tensor strings(DT_STRING, TensorShape({2, i % 3}));
+  for (int64_t j = 0; j < strings.NumElements(); ++j) {
+    strings.flat<tstring>()(j) = absl::StrCat("element ", i, " string ", j);
+  }
+  return {Tensor(i), floats, strings};
+}
+
+const DataTypeVector& AllDtypes() {
+  static const auto* dtypes =
+      new DataTypeVector{DT_INT64, DT_FLOAT, DT_STRING};
+  return *dtypes;
+}
+
+void WriteChunk(const std::string& filename, int64_t num_elements,
+                int64_t block_size) {
+  ColumnarChunkWriter writer(filename, block_size);
+  TF_ASSERT_OK(writer.Initialize(tsl::Env::Default()));
+  for (int64_t i = 0; i < num_elements; ++i) {
+    TF_ASSERT_OK(writer.WriteTensors(MakeElement(i)));
+  }
+  TF_ASSERT_OK(writer.Close());
+}
+
+TEST(ColumnarChunkTest, ReadAllComponents) {
+  const std::string filename = TestFile();
+  WriteChunk(filename, /*num_elements=*/100, /*block_size=*/256);
+
+  ColumnarChunkReader reader(filename, AllDtypes());
+  TF_ASSERT_OK(reader.Initialize(tsl::Env::Default()));
+  EXPECT_EQ(reader.NumRecords(), 100);
+  for (int64_t i = 0; i < 100; ++i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(reader.ReadTensors(&element));
+    std::vector<Tensor> expected = MakeElement(i);
+    ASSERT_EQ(element.size(), expected.size());
+    test::ExpectEqual(element[0], expected[0]);
+    test::ExpectEqual(element[1], expected[1]);
+    test::ExpectEqual(element[2], expected[2]);
+  }
+  std::vector<Tensor> element;
+  EXPECT_THAT(reader.ReadTensors(&element),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(ColumnarChunkTest, ProjectedComponentsReadFewerBytes) {
+  const std::string filename = TestFile();
+  WriteChunk(filename, /*num_elements=*/100, /*block_size=*/1024);
+
+  ColumnarChunkReader all(filename, AllDtypes());
+  TF_ASSERT_OK(all.Initialize(tsl::Env::Default()));
+  ColumnarChunkReader projected(filename, {DT_STRING, DT_INT64},
+                                /*components=*/{2, 0});
+  TF_ASSERT_OK(projected.Initialize(tsl::Env::Default()));
+  for (int64_t i = 0; i < 100; ++i) {
+    std::vector<Tensor> unused, element;
+    TF_ASSERT_OK(all.ReadTensors(&unused));
+    TF_ASSERT_OK(projected.ReadTensors(&element));
+    std::vector<Tensor> expected = MakeElement(i);
+    ASSERT_EQ(element.size(), 2);
+    test::ExpectEqual(element[0], expected[2]);
+    test::ExpectEqual(element[1], expected[0]);
+  }
+  EXPECT_LT(projected.BytesRead(), all.BytesRead());
+}
+
+TEST(ColumnarChunkTest, SkipRecords) {
+  const std::string filename = TestFile();
+  WriteChunk(filename, /*num_elements=*/100, /*block_size=*/256);
+
+  ColumnarChunkReader reader(filename, AllDtypes());
+  TF_ASSERT_OK(reader.Initialize(tsl::Env::Default()));
+  TF_ASSERT_OK(reader.SkipRecords(37));
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(reader.ReadTensors(&element));
+  test::ExpectEqual(element[0], Tensor(int64_t{37}));
+  TF_ASSERT_OK(reader.SkipRecords(2));
+  TF_ASSERT_OK(reader.ReadTensors(&element));
+  test::ExpectEqual(element[0], Tensor(int64_t{40}));
+  EXPECT_THAT(reader.SkipRecords(100),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(ColumnarChunkTest, EmptyChunk) {
+  const std::string filename = TestFile();
+  WriteChunk(filename, /*num_elements=*/0, /*block_size=*/256);
+
+  ColumnarChunkReader reader(filename, AllDtypes());
+  TF_ASSERT_OK(reader.Initialize(tsl::Env::Default()));
+  EXPECT_EQ(reader.NumRecords(), 0);
+  std::vector<Tensor> element;
+  EXPECT_THAT(reader.ReadTensors(&element),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(ColumnarChunkTest, MismatchedDtypes) {
+  const std::string filename = TestFile();
+  WriteChunk(filename, /*num_elements=*/10, /*block_size=*/256);
+
+  ColumnarChunkReader reader(filename, {DT_INT32}, /*components=*/{0});
+  EXPECT_THAT(reader.Initialize(tsl::Env::Default()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ColumnarChunkTest, MismatchedElements) {
+  ColumnarChunkWriter writer(TestFile());
+  TF_ASSERT_OK(writer.Initialize(tsl::Env::Default()));
+  TF_ASSERT_OK(writer.WriteTensors({Tensor(int64_t{1})}));
+  EXPECT_THAT(writer.WriteTensors({Tensor(1.0f)}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(writer.WriteTensors({Tensor(int64_t{1}), Tensor(int64_t{2})}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ColumnarChunkTest, NotAColumnarChunk) {
+  const std::string filename = TestFile();
+  TF_ASSERT_OK(tsl::WriteStringToFile(tsl::Env::Default(), filename,
+                                      "not a columnar snapshot chunk"));
+  ColumnarChunkReader reader(filename, AllDtypes());
+  EXPECT_THAT(reader.Initialize(tsl::Env::Default()),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(ColumnarChunkTest, TFRecordCompression) {
+  EXPECT_EQ(TFRecordCompression(kColumnarCompression), "SNAPPY");
+  EXPECT_EQ(TFRecordCompression("GZIP"), "GZIP");
+  EXPECT_EQ(TFRecordCompression(""), "");
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,241 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/snapshot/direct_io_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/file_system.h"
+#include "tsl/platform/mem.h"
+#include "tsl/platform/path.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+#if defined(__linux__)
+
+int64_t RoundUpToAlignment(int64_t size) {
+  return (size + kDirectIoAlignment - 1) / kDirectIoAlignment *
+         kDirectIoAlignment;
+}
+
+struct AlignedFreeDeleter {
+  void operator()(char* buffer) const { tsl::port::AlignedFree(buffer); }
+};
+
+class DirectIoWritableFile : public tsl::WritableFile {
+ public:
+  DirectIoWritableFile(const std::string& filename, int fd, int64_t buffer_size)
+      : filename_(filename),
+        fd_(fd),
+        capacity_(RoundUpToAlignment(std::max<int64_t>(buffer_size, 1))),
+        buffer_(static_cast<char*>(
+            tsl::port::AlignedMalloc(capacity_, kDirectIoAlignment))) {}
+
+  ~DirectIoWritableFile() override {
+    absl::Status status = Close();
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to close " << filename_ << ": " << status;
+    }
+  }
+
+  absl::Status Append(absl::string_view data) override {
+    TF_RETURN_IF_ERROR(CheckOpen());
+    while (!data.empty()) {
+      const int64_t n =
+          std::min<int64_t>(capacity_ - buffered_, data.size());
+      memcpy(buffer_.get() + buffered_, data.data(), n);
+      buffered_ += n;
+      data.remove_prefix(n);
+      if (buffered_ == capacity_) {
+        TF_RETURN_IF_ERROR(WriteBuffer(capacity_));
+        buffered_ = 0;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Close() override {
+    if (fd_ < 0) {
+      return absl::OkStatus();
+    }
+    absl::Status status = WriteTail();
+    if (status.ok() && ftruncate(fd_, file_offset_) != 0) {
+      status = tsl::errors::IOError(
+          absl::StrCat("Failed to truncate ", filename_), errno);
+    }
+    if (close(fd_) != 0 && status.ok()) {
+      status = tsl::errors::IOError(absl::StrCat("Failed to close ", filename_),
+                                    errno);
+    }
+    fd_ = -1;
+    return status;
+  }
+
+  // Direct I/O cannot write a partial block, so the buffered bytes are written
+  // by `Sync` and `Close`.
+  absl::Status Flush() override { return CheckOpen(); }
+
+  absl::Status Name(absl::string_view* result) const override {
+    *result = filename_;
+    return absl::OkStatus();
+  }
+
+  absl::Status Sync() override {
+    TF_RETURN_IF_ERROR(CheckOpen());
+    const int64_t full_blocks =
+        buffered_ / kDirectIoAlignment * kDirectIoAlignment;
+    if (full_blocks > 0) {
+      TF_RETURN_IF_ERROR(WriteBuffer(full_blocks));
+      memmove(buffer_.get(), buffer_.get() + full_blocks,
+              buffered_ - full_blocks);
+      buffered_ -= full_blocks;
+    }
+    if (buffered_ > 0) {
+      // Writes the partial last block padded with zeros, the same way `Close`
+      // does. The block stays buffered, so the next write of the buffer
+      // rewrites it at the same offset.
+      const int64_t padded = RoundUpToAlignment(buffered_);
+      memset(buffer_.get() + buffered_, 0, padded - buffered_);
+      TF_RETURN_IF_ERROR(PwriteBuffer(padded));
+    }
+    // Drops the padding, and any padding left by an earlier `Sync`.
+    if (ftruncate(fd_, file_offset_ + buffered_) != 0) {
+      return tsl::errors::IOError(
+          absl::StrCat("Failed to truncate ", filename_), errno);
+    }
+    if (fdatasync(fd_) != 0) {
+      return tsl::errors::IOError(absl::StrCat("Failed to sync ", filename_),
+                                  errno);
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Tell(int64_t* position) override {
+    *position = file_offset_ + buffered_;
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::Status CheckOpen() const {
+    if (fd_ < 0) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("File ", filename_, " is closed."));
+    }
+    return absl::OkStatus();
+  }
+
+  // Writes the first `size` bytes of the buffer at `file_offset_`, and
+  // advances `file_offset_` past them. `size` must be a multiple of
+  // `kDirectIoAlignment`.
+  absl::Status WriteBuffer(int64_t size) {
+    TF_RETURN_IF_ERROR(PwriteBuffer(size));
+    file_offset_ += size;
+    return absl::OkStatus();
+  }
+
+  // Writes the first `size` bytes of the buffer at `file_offset_`. `size`
+  // must be a multiple of `kDirectIoAlignment`.
+  absl::Status PwriteBuffer(int64_t size) {
+    int64_t written = 0;
+    while (written < size) {
+      ssize_t n = pwrite(fd_, buffer_.get() + written, size - written,
+                         file_offset_ + written);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return tsl::errors::IOError(
+            absl::StrCat("Failed to write to ", filename_), errno);
+      }
+      written += n;
+    }
+    return absl::OkStatus();
+  }
+
+  // Writes the buffered bytes, padded with zeros to the alignment, and leaves
+  // `file_offset_` at the end of the appended bytes.
+  absl::Status WriteTail() {
+    if (buffered_ == 0) {
+      return absl::OkStatus();
+    }
+    const int64_t padded = RoundUpToAlignment(buffered_);
+    memset(buffer_.get() + buffered_, 0, padded - buffered_);
+    const int64_t end = file_offset_ + buffered_;
+    TF_RETURN_IF_ERROR(WriteBuffer(padded));
+    file_offset_ = end;
+    buffered_ = 0;
+    return absl::OkStatus();
+  }
+
+  const std::string filename_;
+  int fd_;
+  const int64_t capacity_;
+  std::unique_ptr<char, AlignedFreeDeleter> buffer_;
+  int64_t buffered_ = 0;
+  // The offset of the first buffered byte in the file.
+  int64_t file_offset_ = 0;
+};
+
+#endif  // defined(__linux__)
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<tsl::WritableFile>> NewDirectIoWritableFile(
+    tsl::Env* env, const std::string& filename, int64_t buffer_size) {
+#if defined(__linux__)
+  absl::string_view scheme, host, path;
+  tsl::io::ParseURI(filename, &scheme, &host, &path);
+  if (scheme.empty() || scheme == "file") {
+    const std::string local_path(path);
+    int fd = open(local_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT,
+                  0644);
+    if (fd >= 0) {
+      return std::make_unique<DirectIoWritableFile>(local_path, fd,
+                                                    buffer_size);
+    }
+    // Some file systems (e.g. tmpfs) do not support O_DIRECT.
+    if (errno != EINVAL) {
+      return tsl::errors::IOError(
+          absl::StrCat("Failed to open ", filename, " for direct I/O"), errno);
+    }
+    VLOG(1) << "Direct I/O is not supported for " << filename
+            << "; falling back to buffered writes.";
+  }
+#endif  // defined(__linux__)
+  std::unique_ptr<tsl::WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  return file;
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,55 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SNAPSHOT_DIRECT_IO_FILE_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SNAPSHOT_DIRECT_IO_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/file_system.h"
+
+namespace tensorflow {
+namespace data {
+
+// Alignment of the buffers, offsets, and sizes of direct I/O writes.
+inline constexpr int64_t kDirectIoAlignment = 4096;
+
+// Size of the aligned buffer of direct I/O files.
+inline constexpr int64_t kDefaultDirectIoBufferSize = 8 << 20;  // 8MB
+
+// Opens `filename` for writing with `O_DIRECT`, so that writes bypass the page
+// cache. Appends are gathered in an aligned buffer of `buffer_size` bytes
+// (rounded up to `kDirectIoAlignment`), which is written out whenever it is
+// full. `Close` pads the last block to the alignment for the write and then
+// truncates the file to the bytes that were appended.
+//
+// `Flush` is a no-op, since direct I/O cannot write a partial block. `Sync`
+// writes all buffered bytes, padding the last block like `Close` does, then
+// truncates the file to the appended bytes and syncs it. The padded block is
+// rewritten by the next write.
+//
+// Direct I/O is only used for local files on Linux. Otherwise, or if the file
+// system does not support `O_DIRECT`, returns `env->NewWritableFile`.
+absl::StatusOr<std::unique_ptr<tsl::WritableFile>> NewDirectIoWritableFile(
+    tsl::Env* env, const std::string& filename,
+    int64_t buffer_size = kDefaultDirectIoBufferSize);
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SNAPSHOT_DIRECT_IO_FILE_H_
@@ -0,0 +1,116 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/snapshot/direct_io_file.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/file_system.h"
+#include "tsl/platform/status_matchers.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::tsl::testing::StatusIs;
+
+std::string TestFile() {
+  std::string filename;
+  EXPECT_TRUE(tsl::Env::Default()->LocalTempFilename(&filename));
+  return filename;
+}
+
+std::string Contents(int64_t size) {
+  std::string contents;
+  for (int64_t i = 0; contents.size() < size; ++i) {
+    absl::StrAppend(&contents, i, ",");
+  }
+  contents.resize(size);
+  return contents;
+}
+
+class DirectIoFileTest : public ::testing::TestWithParam<int64_t> {};
+
+TEST_P(DirectIoFileTest, WriteFile) {
+  const std::string filename = TestFile();
+  const std::string contents = Contents(GetParam());
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<tsl::WritableFile> file,
+                          NewDirectIoWritableFile(tsl::Env::Default(), filename,
+                                                  /*buffer_size=*/8192));
+  // Appends pieces that are not aligned, syncing in the middle.
+  for (int64_t offset = 0; offset < contents.size(); offset += 1000) {
+    TF_ASSERT_OK(file->Append(contents.substr(offset, 1000)));
+    if (offset == 5000) {
+      TF_ASSERT_OK(file->Sync());
+    }
+  }
+  int64_t position = 0;
+  TF_ASSERT_OK(file->Tell(&position));
+  EXPECT_EQ(position, contents.size());
+  TF_ASSERT_OK(file->Close());
+
+  std::string read_contents;
+  TF_ASSERT_OK(
+      tsl::ReadFileToString(tsl::Env::Default(), filename, &read_contents));
+  EXPECT_EQ(read_contents, contents);
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, DirectIoFileTest,
+                         ::testing::Values(0, 1, 4095, 4096, 8192, 20000));
+
+TEST(DirectIoFileTest, SyncPersistsPartialBlock) {
+  const std::string filename = TestFile();
+  const std::string contents = Contents(10000);
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<tsl::WritableFile> file,
+                          NewDirectIoWritableFile(tsl::Env::Default(), filename,
+                                                  /*buffer_size=*/8192));
+  std::string read_contents;
+  TF_ASSERT_OK(file->Append(contents.substr(0, 5000)));
+  TF_ASSERT_OK(file->Sync());
+  TF_ASSERT_OK(
+      tsl::ReadFileToString(tsl::Env::Default(), filename, &read_contents));
+  EXPECT_EQ(read_contents, contents.substr(0, 5000));
+
+  // Syncing twice within the same block rewrites it in place.
+  TF_ASSERT_OK(file->Append(contents.substr(5000, 100)));
+  TF_ASSERT_OK(file->Sync());
+  TF_ASSERT_OK(
+      tsl::ReadFileToString(tsl::Env::Default(), filename, &read_contents));
+  EXPECT_EQ(read_contents, contents.substr(0, 5100));
+
+  TF_ASSERT_OK(file->Append(contents.substr(5100)));
+  TF_ASSERT_OK(file->Close());
+  TF_ASSERT_OK(
+      tsl::ReadFileToString(tsl::Env::Default(), filename, &read_contents));
+  EXPECT_EQ(read_contents, contents);
+}
+
+TEST(DirectIoFileTest, DirectoryDoesNotExist) {
+  EXPECT_THAT(NewDirectIoWritableFile(tsl::Env::Default(),
+                                      "/directory/does/not/exist")
+                  .status(),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
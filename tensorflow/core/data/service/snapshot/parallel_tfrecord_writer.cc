@@ -28,9 +28,13 @@ limitations under the License.
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "tensorflow/core/data/service/byte_size.h"
+#include "tensorflow/core/data/service/snapshot/adaptive_chunk.h"
+#include "tensorflow/core/data/service/snapshot/columnar_chunk.h"
 #include "tensorflow/core/data/service/snapshot/utils.h"
 #include "tensorflow/core/data/snapshot_utils.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
@@ -48,16 +52,19 @@ ParallelTFRecordWriter::ParallelTFRecordWriter(const std::string& file_prefix,
                                                tsl::Env* env,
                                                ByteSize max_file_size,
                                                int64_t num_write_threads,
-                                               int64_t buffer_size)
+                                               int64_t buffer_size,
+                                               bool direct_io)
     : env_(env),
       file_prefix_(file_prefix),
       compression_(compression),
       max_file_size_(max_file_size),
-      buffer_size_(buffer_size) {
+      buffer_size_(buffer_size),
+      direct_io_(direct_io),
+      thread_stats_(num_write_threads) {
   thread_pool_ = std::make_unique<tsl::thread::ThreadPool>(
       env_, tsl::ThreadOptions{}, "write_tfrecord_thread", num_write_threads);
   for (int64_t i = 0; i < num_write_threads; ++i) {
-    thread_pool_->Schedule([this]() { WriteFiles(); });
+    thread_pool_->Schedule([this, i]() { WriteFiles(i); });
   }
 }
 
@@ -100,9 +107,15 @@ ParallelTFRecordWriter::Finalize() ABSL_LOCKS_EXCLUDED(mu_) {
   return file_stats_;
 }
 
-void ParallelTFRecordWriter::WriteFiles() {
+std::vector<ParallelTFRecordWriter::ThreadStats>
+ParallelTFRecordWriter::GetThreadStats() const ABSL_LOCKS_EXCLUDED(mu_) {
+  absl::MutexLock l(&mu_);
+  return thread_stats_;
+}
+
+void ParallelTFRecordWriter::WriteFiles(int64_t thread_index) {
   while (HasNext()) {
-    UpdateStatus(WriteFile());
+    UpdateStatus(WriteFile(thread_index));
   }
 }
 
@@ -114,17 +127,75 @@ bool ParallelTFRecordWriter::HasNext() const ABSL_LOCKS_EXCLUDED(mu_) {
   return !finalized_ || !buffer_.empty();
 }
 
-absl::Status ParallelTFRecordWriter::WriteFile() ABSL_LOCKS_EXCLUDED(mu_) {
+absl::Status ParallelTFRecordWriter::WriteFile(int64_t thread_index)
+    ABSL_LOCKS_EXCLUDED(mu_) {
   TF_ASSIGN_OR_RETURN(const std::string filename, GetUniqueFile());
-  snapshot_util::TFRecordWriter writer(filename, compression_);
-  TF_RETURN_IF_ERROR(writer.Initialize(env_));
+  const bool adaptive = compression_ == kAdaptiveCompression;
+  const ChunkCodec codec =
+      adaptive ? codec_selector_.NextCodec() : ChunkCodec::kNone;
+  ThreadStats stats_before;
+  {
+    absl::MutexLock l(&mu_);
+    stats_before = thread_stats_[thread_index];
+  }
+
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<snapshot_util::Writer> writer,
+                      CreateWriter(filename, codec));
   while (ShouldWriteFile(filename)) {
-    TF_RETURN_IF_ERROR(WriteRecord(filename, writer));
+    TF_RETURN_IF_ERROR(WriteRecord(filename, thread_index, *writer));
   }
-  TF_RETURN_IF_ERROR(writer.Close());
+  const int64_t close_start_micros = env_->NowMicros();
+  TF_RETURN_IF_ERROR(writer->Close());
+  const absl::Duration close_time =
+      absl::Microseconds(env_->NowMicros() - close_start_micros);
+  uint64_t file_size = 0;
+  TF_RETURN_IF_ERROR(env_->GetFileSize(filename, &file_size));
+
+  ThreadStats stats_delta;
+  {
+    absl::MutexLock l(&mu_);
+    ThreadStats& stats = thread_stats_[thread_index];
+    stats.busy_time += close_time;
+    stats.stored_size += ByteSize::Bytes(file_size);
+    stats_delta.raw_size = stats.raw_size - stats_before.raw_size;
+    stats_delta.busy_time = stats.busy_time - stats_before.busy_time;
+    stats_delta.idle_time = stats.idle_time - stats_before.idle_time;
+  }
+  if (adaptive) {
+    codec_selector_.RecordChunk(
+        codec, stats_delta.raw_size.ToUnsignedBytes(), file_size,
+        stats_delta.busy_time, stats_delta.idle_time);
+  }
+  metrics::RecordTFDataServiceSnapshotWriterThreadBytes(
+      thread_index,
+      adaptive ? std::string(ChunkCodecName(codec))
+               : (compression_.empty() ? "none" : compression_),
+      file_size, absl::ToInt64Microseconds(stats_delta.busy_time));
   return DeleteEmptyFile(filename);
 }
 
+absl::StatusOr<std::unique_ptr<snapshot_util::Writer>>
+ParallelTFRecordWriter::CreateWriter(const std::string& filename,
+                                     ChunkCodec codec) const {
+  std::unique_ptr<snapshot_util::Writer> writer;
+  if (compression_ == kColumnarCompression) {
+    auto columnar_writer = std::make_unique<ColumnarChunkWriter>(filename);
+    TF_RETURN_IF_ERROR(columnar_writer->Initialize(env_));
+    writer = std::move(columnar_writer);
+  } else if (compression_ == kAdaptiveCompression) {
+    auto adaptive_writer =
+        std::make_unique<AdaptiveChunkWriter>(filename, codec, direct_io_);
+    TF_RETURN_IF_ERROR(adaptive_writer->Initialize(env_));
+    writer = std::move(adaptive_writer);
+  } else {
+    auto tfrecord_writer =
+        std::make_unique<snapshot_util::TFRecordWriter>(filename, compression_);
+    TF_RETURN_IF_ERROR(tfrecord_writer->Initialize(env_));
+    writer = std::move(tfrecord_writer);
+  }
+  return writer;
+}
+
 bool ParallelTFRecordWriter::ShouldWriteFile(const std::string& filename) const
     ABSL_LOCKS_EXCLUDED(mu_) {
   if (!HasNext()) {
@@ -137,26 +208,37 @@ bool ParallelTFRecordWriter::ShouldWriteFile(const std::string& filename) const
 }
 
 absl::Status ParallelTFRecordWriter::WriteRecord(
-    const std::string& filename, snapshot_util::TFRecordWriter& writer) {
+    const std::string& filename, int64_t thread_index,
+    snapshot_util::Writer& writer) {
   TF_ASSIGN_OR_RETURN(std::optional<std::vector<Tensor>> record,
-                      GetNextRecord(filename));
+                      GetNextRecord(filename, thread_index));
   if (!record.has_value()) {
     return absl::OkStatus();
   }
 
   tsl::profiler::TraceMe activity("WriteTFRecord",
                                   tsl::profiler::TraceMeLevel::kInfo);
+  const int64_t start_micros = env_->NowMicros();
   TF_RETURN_IF_ERROR(writer.WriteTensors(*std::move(record)));
+  const absl::Duration write_time =
+      absl::Microseconds(env_->NowMicros() - start_micros);
+  absl::MutexLock l(&mu_);
+  thread_stats_[thread_index].busy_time += write_time;
   return absl::OkStatus();
 }
 
 absl::StatusOr<std::optional<std::vector<Tensor>>>
-ParallelTFRecordWriter::GetNextRecord(const std::string& filename)
+ParallelTFRecordWriter::GetNextRecord(const std::string& filename,
+                                      int64_t thread_index)
     ABSL_LOCKS_EXCLUDED(mu_) {
   absl::MutexLock l(&mu_);
+  const int64_t wait_start_micros = env_->NowMicros();
   while (status_.ok() && !finalized_ && buffer_.empty()) {
     ready_to_pop_.Wait(&mu_);
   }
+  ThreadStats& thread_stats = thread_stats_[thread_index];
+  thread_stats.idle_time +=
+      absl::Microseconds(env_->NowMicros() - wait_start_micros);
   TF_RETURN_IF_ERROR(status_);
   if (buffer_.empty()) {
     return std::nullopt;
@@ -168,6 +250,8 @@ ParallelTFRecordWriter::GetNextRecord(const std::string& filename)
                            << " to file " << filename << "*.";
   ++file_stats_[filename].num_records;
   file_stats_[filename].estimated_size += estimated_size;
+  ++thread_stats.num_records;
+  thread_stats.raw_size += estimated_size;
   buffer_.pop_front();
   ready_to_push_.SignalAll();
   return record;
@@ -27,7 +27,9 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "tensorflow/core/data/service/byte_size.h"
+#include "tensorflow/core/data/service/snapshot/adaptive_chunk.h"
 #include "tensorflow/core/data/snapshot_utils.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tsl/platform/env.h"
@@ -40,6 +42,12 @@ namespace data {
 // waiting for the file writes, and it writes one shard of file per thread.
 // Returns the file names when writes are finished. This class is thread-safe.
 //
+// If `compression` is `kColumnarCompression`, the files are written by a
+// `ColumnarChunkWriter` instead. If it is `kAdaptiveCompression`, they are
+// written by an `AdaptiveChunkWriter`, with a codec chosen for every file by an
+// `AdaptiveCodecSelector`. If `direct_io` is true, adaptive chunks are written
+// with direct I/O, bypassing the page cache.
+//
 // Usage example:
 //
 // ParallelTFRecordWriter writer(
@@ -60,7 +68,8 @@ class ParallelTFRecordWriter {
                                   const std::string& compression, tsl::Env* env,
                                   ByteSize max_file_size = ByteSize::GB(6),
                                   int64_t num_write_threads = 2,
-                                  int64_t buffer_size = 1);
+                                  int64_t buffer_size = 1,
+                                  bool direct_io = false);
   virtual ~ParallelTFRecordWriter();
   ParallelTFRecordWriter(const ParallelTFRecordWriter&) = delete;
   ParallelTFRecordWriter& operator=(const ParallelTFRecordWriter&) = delete;
@@ -84,27 +93,48 @@ class ParallelTFRecordWriter {
   // finalized or an error occurs.
   absl::StatusOr<FileToStatsMap> Finalize();
 
+  // Throughput of one writer thread.
+  struct ThreadStats {
+    // Estimated size of the records written.
+    ByteSize raw_size;
+    // Size of the files written.
+    ByteSize stored_size;
+    int64_t num_records = 0;
+    // Time spent encoding and writing records.
+    absl::Duration busy_time;
+    // Time spent waiting for records to write.
+    absl::Duration idle_time;
+  };
+
+  // Returns the stats of every writer thread, including the files that are
+  // being written.
+  std::vector<ThreadStats> GetThreadStats() const;
+
  private:
-  // Run by a thread to write buffered records to sharded files.
-  void WriteFiles();
+  // Run by thread `thread_index` to write buffered records to sharded files.
+  void WriteFiles(int64_t thread_index);
 
   // Whether there are more records to be written.
   bool HasNext() const;
 
   // Writes a new file.
-  absl::Status WriteFile();
+  absl::Status WriteFile(int64_t thread_index);
+
+  // Creates a writer for `filename`, using `codec` for adaptive chunks.
+  absl::StatusOr<std::unique_ptr<snapshot_util::Writer>> CreateWriter(
+      const std::string& filename, ChunkCodec codec) const;
 
   // Whether the file can hold more records without exceeding `max_file_size_`.
   bool ShouldWriteFile(const std::string& filename) const;
 
-  // Writes one record to file.
-  absl::Status WriteRecord(const std::string& filename,
-                           snapshot_util::TFRecordWriter& writer);
+  // Writes one record to file, accounting for it in `thread_index`'s stats.
+  absl::Status WriteRecord(const std::string& filename, int64_t thread_index,
+                           snapshot_util::Writer& writer);
 
   // Gets the next record from the buffer to write. Returns `std::nullopt` if
   // there are no more records to write.
   absl::StatusOr<std::optional<std::vector<Tensor>>> GetNextRecord(
-      const std::string& filename);
+      const std::string& filename, int64_t thread_index);
 
   // Deletes the file if it's empty.
   absl::Status DeleteEmptyFile(const std::string& filename);
@@ -120,6 +150,8 @@ class ParallelTFRecordWriter {
   const std::string compression_;
   const ByteSize max_file_size_;
   const int64_t buffer_size_;
+  const bool direct_io_;
+  AdaptiveCodecSelector codec_selector_;
 
   mutable absl::Mutex mu_;
   mutable absl::CondVar ready_to_push_;
@@ -135,6 +167,9 @@ class ParallelTFRecordWriter {
   // `buffer_size_`.
   std::deque<std::vector<Tensor>> buffer_ ABSL_GUARDED_BY(mu_);
 
+  // Indexed by writer thread.
+  std::vector<ThreadStats> thread_stats_ ABSL_GUARDED_BY(mu_);
+
   std::unique_ptr<tsl::thread::ThreadPool> thread_pool_;
 };
 
@@ -33,6 +33,8 @@ limitations under the License.
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "xla/tsl/lib/io/compression.h"
 #include "tensorflow/core/data/service/byte_size.h"
+#include "tensorflow/core/data/service/snapshot/adaptive_chunk.h"
+#include "tensorflow/core/data/service/snapshot/columnar_chunk.h"
 #include "tensorflow/core/data/snapshot_utils.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tsl/platform/env.h"
@@ -104,14 +106,28 @@ absl::StatusOr<ParallelTFRecordWriter::FileToStatsMap> WriteRecords(
 template <class T>
 absl::StatusOr<std::vector<T>> ReadRecords(const std::string& filename,
                                            const std::string& compression) {
-  snapshot_util::TFRecordReader reader(filename, compression,
-                                       DataTypeVector{DT_INT64});
-  TF_RETURN_IF_ERROR(reader.Initialize(tsl::Env::Default()));
+  std::unique_ptr<snapshot_util::Reader> reader;
+  if (compression == kColumnarCompression) {
+    auto columnar_reader = std::make_unique<ColumnarChunkReader>(
+        filename, DataTypeVector{DT_INT64});
+    TF_RETURN_IF_ERROR(columnar_reader->Initialize(tsl::Env::Default()));
+    reader = std::move(columnar_reader);
+  } else if (compression == kAdaptiveCompression) {
+    auto adaptive_reader = std::make_unique<AdaptiveChunkReader>(
+        filename, DataTypeVector{DT_INT64});
+    TF_RETURN_IF_ERROR(adaptive_reader->Initialize(tsl::Env::Default()));
+    reader = std::move(adaptive_reader);
+  } else {
+    auto tfrecord_reader = std::make_unique<snapshot_util::TFRecordReader>(
+        filename, compression, DataTypeVector{DT_INT64});
+    TF_RETURN_IF_ERROR(tfrecord_reader->Initialize(tsl::Env::Default()));
+    reader = std::move(tfrecord_reader);
+  }
 
   std::vector<T> result;
   while (true) {
     std::vector<Tensor> record;
-    absl::Status status = reader.ReadTensors(&record);
+    absl::Status status = reader->ReadTensors(&record);
     if (absl::IsOutOfRange(status)) {
       break;
     }
@@ -267,9 +283,12 @@ INSTANTIATE_TEST_SUITE_P(ParallelTFRecordWriterParams,
                              /*NumWriteThreads*/ ::testing::Values(1, 5),
                              /*BufferSize*/ ::testing::Values(1, 10000),
                              /*Compression*/
-                             ::testing::Values(tsl::io::compression::kNone,
-                                               tsl::io::compression::kSnappy,
-                                               tsl::io::compression::kZlib)));
+                             ::testing::Values(
+                                 tsl::io::compression::kNone,
+                                 tsl::io::compression::kSnappy,
+                                 tsl::io::compression::kZlib,
+                                 std::string(kColumnarCompression),
+                                 std::string(kAdaptiveCompression))));
 
 TEST(ParallelTFRecordWriterTest, WriteNoRecord) {
   TF_ASSERT_OK_AND_ASSIGN(std::string test_dir, TestDir());
@@ -302,6 +321,45 @@ TEST(ParallelTFRecordWriterTest, CannotWriteFinalizedWriter) {
   client_thread.reset();
 }
 
+TEST(ParallelTFRecordWriterTest, AdaptiveCompressionWithDirectIo) {
+  TF_ASSERT_OK_AND_ASSIGN(std::string test_dir, TestDir());
+  ParallelTFRecordWriter parallel_tfrecord_writer(
+      test_dir, std::string(kAdaptiveCompression), tsl::Env::Default(),
+      /*max_file_size=*/ByteSize::Bytes(100), /*num_write_threads=*/2,
+      /*buffer_size=*/10, /*direct_io=*/true);
+
+  RangeIterator range_iterator(1000);
+  TF_ASSERT_OK_AND_ASSIGN(
+      ParallelTFRecordWriter::FileToStatsMap file_stats,
+      WriteRecords(parallel_tfrecord_writer, range_iterator));
+  const auto [files, stats] = Unzip(file_stats);
+  EXPECT_THAT(ReadRecords<int64_t>(files, std::string(kAdaptiveCompression)),
+              IsOkAndHolds(UnorderedElementsAreArray(Range(1000))));
+}
+
+TEST(ParallelTFRecordWriterTest, ThreadStats) {
+  TF_ASSERT_OK_AND_ASSIGN(std::string test_dir, TestDir());
+  ParallelTFRecordWriter parallel_tfrecord_writer(
+      test_dir, tsl::io::compression::kSnappy, tsl::Env::Default(),
+      /*max_file_size=*/ByteSize::Bytes(100), /*num_write_threads=*/3);
+
+  RangeIterator range_iterator(100);
+  TF_ASSERT_OK(WriteRecords(parallel_tfrecord_writer, range_iterator).status());
+  std::vector<ParallelTFRecordWriter::ThreadStats> thread_stats =
+      parallel_tfrecord_writer.GetThreadStats();
+  ASSERT_THAT(thread_stats, SizeIs(3));
+  int64_t num_records = 0;
+  ByteSize raw_size, stored_size;
+  for (const ParallelTFRecordWriter::ThreadStats& stats : thread_stats) {
+    num_records += stats.num_records;
+    raw_size += stats.raw_size;
+    stored_size += stats.stored_size;
+  }
+  EXPECT_EQ(num_records, 100);
+  EXPECT_GT(raw_size, ByteSize::Bytes(0));
+  EXPECT_GT(stored_size, ByteSize::Bytes(0));
+}
+
 TEST(ParallelTFRecordWriterTest, DirectoryDoesNotExist) {
   ParallelTFRecordWriter parallel_tfrecord_writer("/directory/does/not/exists",
                                                   tsl::io::compression::kNone,
@@ -35,6 +35,7 @@ namespace {
 constexpr const char kDoneFileName[] = "DONE";
 constexpr const char kErrorFileName[] = "ERROR";
 constexpr const char kWorkerFileName[] = "owner_worker";
+constexpr const char kSplitsManifestFileName[] = "splits_manifest.pb";
 constexpr const char kSnapshotMetadataFileName[] = "snapshot.metadata";
 constexpr const char kDatasetDefFileName[] = "dataset_def.proto";
 constexpr const char kDatasetSpecFileName[] = "dataset_spec.pb";
@@ -210,6 +211,12 @@ std::string StreamWorkerFilePath(absl::string_view stream_path) {
   return tsl::io::JoinPath(stream_path, kWorkerFileName);
 }
 
+std::string StreamSplitsManifestFilePath(absl::string_view snapshot_path,
+                                         int64_t stream_index) {
+  return tsl::io::JoinPath(StreamDirectory(snapshot_path, stream_index),
+                           kSplitsManifestFileName);
+}
+
 std::string SnapshotDoneFilePath(absl::string_view snapshot_path) {
   return tsl::io::JoinPath(snapshot_path, kDoneFileName);
 }
@@ -101,6 +101,11 @@ std::string StreamWorkerFilePath(absl::string_view snapshot_path,
 // Returns the path of the owner_worker file of a snapshot stream.
 std::string StreamWorkerFilePath(absl::string_view stream_path);
 
+// Returns the path of the manifest of the splits assigned to a finished
+// snapshot stream.
+std::string StreamSplitsManifestFilePath(absl::string_view snapshot_path,
+                                         int64_t stream_index);
+
 // Returns the path of the DONE file of a snapshot.
 std::string SnapshotDoneFilePath(absl::string_view snapshot_path);
 
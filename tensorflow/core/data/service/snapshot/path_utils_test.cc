@@ -219,6 +219,12 @@ TEST(PathUtilsTest, StreamWorkerFilePath) {
               MatchesRegex("/path/to/snapshot.streams.stream_0.owner_worker"));
 }
 
+TEST(PathUtilsTest, StreamSplitsManifestFilePath) {
+  EXPECT_THAT(
+      StreamSplitsManifestFilePath("/path/to/snapshot", /*stream_index=*/0),
+      MatchesRegex("/path/to/snapshot.streams.stream_0.splits_manifest.pb"));
+}
+
 TEST(PathUtilsTest, SnapshotDoneFilePath) {
   EXPECT_THAT(SnapshotDoneFilePath("/path/to/snapshot"),
               MatchesRegex("/path/to/snapshot.DONE"));
@@ -21,6 +21,8 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/service/snapshot/adaptive_chunk.h"
+#include "tensorflow/core/data/service/snapshot/columnar_chunk.h"
 #include "tensorflow/core/data/snapshot_utils.h"
 #include "tensorflow/core/data/utils.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -128,6 +130,16 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
     ~Iterator() override { RecordBytesRead(); }
 
     absl::Status Initialize(IteratorContext* ctx) override {
+      if (dataset()->compression_ == kColumnarCompression) {
+        columnar_reader_ = std::make_unique<ColumnarChunkReader>(
+            TranslateFileName(dataset()->chunk_file_), dataset()->dtypes_);
+        return columnar_reader_->Initialize(ctx->env());
+      }
+      if (dataset()->compression_ == kAdaptiveCompression) {
+        adaptive_reader_ = std::make_unique<AdaptiveChunkReader>(
+            TranslateFileName(dataset()->chunk_file_), dataset()->dtypes_);
+        return adaptive_reader_->Initialize(ctx->env());
+      }
       reader_ = std::make_unique<snapshot_util::TFRecordReader>(
           TranslateFileName(dataset()->chunk_file_), dataset()->compression_,
           dataset()->dtypes_, kTFRecordReaderOutputBufferSize);
@@ -139,7 +151,7 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
                                  std::vector<Tensor>* out_tensors,
                                  bool* end_of_sequence) override {
       *end_of_sequence = false;
-      absl::Status status = reader_->ReadTensors(out_tensors);
+      absl::Status status = ReadTensors(out_tensors);
       if (absl::IsOutOfRange(status)) {
         *end_of_sequence = true;
         return absl::OkStatus();
@@ -171,20 +183,38 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
     // may consider switching the data format to ArrayRecords so we can use the
     // index to jump straight to the starting record.
     absl::Status AdvanceToStartIndex(IteratorContext* ctx) {
+      if (columnar_reader_) {
+        // Columnar chunks skip whole blocks without reading them.
+        return columnar_reader_->SkipRecords(start_index_);
+      }
       for (int64_t i = 0; i < start_index_; ++i) {
         std::vector<Tensor> unused;
-        TF_RETURN_IF_ERROR(reader_->ReadTensors(&unused));
+        TF_RETURN_IF_ERROR(ReadTensors(&unused));
       }
       return absl::OkStatus();
     }
 
+    absl::Status ReadTensors(std::vector<Tensor>* out_tensors) {
+      if (columnar_reader_) {
+        return columnar_reader_->ReadTensors(out_tensors);
+      }
+      if (adaptive_reader_) {
+        return adaptive_reader_->ReadTensors(out_tensors);
+      }
+      return reader_->ReadTensors(out_tensors);
+    }
+
     void RecordBytesRead() {
-      uint64_t bytes_read = reader_->BytesRead();
+      uint64_t bytes_read = columnar_reader_   ? columnar_reader_->BytesRead()
+                            : adaptive_reader_ ? adaptive_reader_->BytesRead()
+                                               : reader_->BytesRead();
       metrics::GetTFDataBytesReadCounter(kSnapshotChunkDataset)
           ->IncrementBy(bytes_read);
     }
 
     std::unique_ptr<snapshot_util::TFRecordReader> reader_;
+    std::unique_ptr<ColumnarChunkReader> columnar_reader_;
+    std::unique_ptr<AdaptiveChunkReader> adaptive_reader_;
     int64_t start_index_ = 0;
   };
 
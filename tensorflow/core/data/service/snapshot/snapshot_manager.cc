@@ -44,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/snapshot.pb.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/mutex.h"
@@ -60,6 +61,10 @@ namespace {
 
 const absl::Duration kProgressLoggingInterval = absl::Minutes(1);
 
+// Restoring a stream mostly waits on file system requests, so streams are
+// restored with more threads than there are cores.
+constexpr size_t kMaxStreamRestoreThreads = 64;
+
 absl::StatusOr<int64_t> CountSplits(SplitProvider& split_provider) {
   if (split_provider.Cardinality() != kUnknownCardinality) {
     return split_provider.Cardinality();
@@ -88,6 +93,42 @@ absl::Status SkipSplit(SplitProvider& split_provider,
   return absl::OkStatus();
 }
 
+// Counts the splits of `split_provider` and skips the first
+// `num_assigned_splits` splits, which have been previously assigned to streams.
+absl::Status RestoreSplitProvider(SplitProvider& split_provider,
+                                  int64_t num_assigned_splits,
+                                  int64_t& cardinality,
+                                  int64_t& repetition_index) {
+  TF_ASSIGN_OR_RETURN(cardinality, CountSplits(split_provider));
+  for (int64_t i = 0; i < num_assigned_splits; ++i) {
+    TF_RETURN_IF_ERROR(SkipSplit(split_provider, repetition_index));
+  }
+  return absl::OkStatus();
+}
+
+// Writes the manifest of the splits assigned to a finished stream. Failing to
+// write it is not an error, since the splits can still be restored by listing
+// the split files.
+void WriteStreamManifest(absl::string_view snapshot_path,
+                         int64_t stream_index,
+                         const std::vector<int64_t>& num_assigned_splits,
+                         const std::vector<int64_t>& global_split_indices,
+                         tsl::Env* env) {
+  experimental::DistributedSnapshotStreamManifest manifest;
+  manifest.mutable_num_assigned_splits_per_source()->Add(
+      num_assigned_splits.begin(), num_assigned_splits.end());
+  manifest.mutable_global_split_indices()->Add(global_split_indices.begin(),
+                                               global_split_indices.end());
+  absl::Status status = AtomicallyWriteBinaryProto(
+      StreamSplitsManifestFilePath(snapshot_path, stream_index), manifest,
+      env);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write the splits manifest of stream "
+                 << stream_index << " of tf.data snapshot " << snapshot_path
+                 << ": " << status;
+  }
+}
+
 std::string PrefetchedSplitDir(const std::string& snapshot_path,
                                int64_t source_index) {
   return tsl::io::JoinPath(snapshot_path, "prefetched_splits",
@@ -302,19 +343,14 @@ absl::Status SnapshotManager::ReadOnDiskStreams()
       tsl::ReadBinaryProto(env_, DatasetDefFilePath(path_), &dataset_def));
   std::vector<std::unique_ptr<SplitProvider>> split_providers;
   TF_RETURN_IF_ERROR(CreateSplitProviders(dataset_def, split_providers));
-  std::vector<int64_t> repetition_indices(split_providers.size(), 0);
-  std::vector<int64_t> cardinalities;
-  for (size_t i = 0; i < split_providers.size(); ++i) {
-    TF_ASSIGN_OR_RETURN(int64_t cardinality, CountSplits(*split_providers[i]));
-    cardinalities.push_back(cardinality);
-  }
 
   tsl::mutex mu;  // Protects `resume_status` and `global_split_indices`.
   absl::Status resume_status;
   absl::flat_hash_set<int64_t> global_split_indices;
   auto thread_pool = std::make_unique<tsl::thread::ThreadPool>(
       env_, tsl::ThreadOptions{}, "restore_snapshot_stream_thread",
-      std::max(size_t{1}, stream_directories.size()));
+      std::clamp<size_t>(stream_directories.size(), 1,
+                         kMaxStreamRestoreThreads));
   for (const auto& stream_directory : stream_directories) {
     std::string stream_path = tsl::io::JoinPath(streams_path, stream_directory);
 
@@ -328,8 +364,7 @@ absl::Status SnapshotManager::ReadOnDiskStreams()
           ": filename must have the format stream_<stream_index>."));
     }
 
-    thread_pool->Schedule([this, &stream_directories, stream_index,
-                           &split_providers, &repetition_indices,
+    thread_pool->Schedule([this, stream_index, &split_providers,
                            &global_split_indices, &resume_status,
                            &mu]() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       StreamRestorer stream_restorer(env_, path_, stream_index,
@@ -338,14 +373,40 @@ absl::Status SnapshotManager::ReadOnDiskStreams()
       absl::Status s = stream_restorer.ReadOnDiskStream();
       tsl::mutex_lock l(mu);
       resume_status.Update(s);
-      resume_status.Update(RestoreFrom(stream_restorer, stream_directories,
-                                       split_providers, repetition_indices,
-                                       global_split_indices));
+      resume_status.Update(RestoreFrom(stream_restorer, global_split_indices));
     });
   }
   thread_pool.reset();
   TF_RETURN_IF_ERROR(resume_status);
 
+  // To account for the splits having been assigned, skips the splits in the
+  // respective split providers. The sources are independent, so they are
+  // counted and skipped in parallel.
+  const size_t num_sources = split_providers.size();
+  std::vector<int64_t> num_assigned_splits(num_sources, 0);
+  for (const auto& [stream_index, stream] : streams_) {
+    for (size_t i = 0; i < num_sources; ++i) {
+      num_assigned_splits[i] += stream.num_assigned_splits_per_source[i];
+    }
+  }
+  std::vector<int64_t> repetition_indices(num_sources, 0);
+  std::vector<int64_t> cardinalities(num_sources, 0);
+  std::vector<absl::Status> source_statuses(num_sources);
+  thread_pool = std::make_unique<tsl::thread::ThreadPool>(
+      env_, tsl::ThreadOptions{}, "restore_snapshot_source_thread",
+      std::max(size_t{1}, num_sources));
+  for (size_t i = 0; i < num_sources; ++i) {
+    thread_pool->Schedule([&, i]() {
+      source_statuses[i] = RestoreSplitProvider(
+          *split_providers[i], num_assigned_splits[i], cardinalities[i],
+          repetition_indices[i]);
+    });
+  }
+  thread_pool.reset();
+  for (const absl::Status& status : source_statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+
   for (int64_t i = 0; i < split_providers.size(); ++i) {
     sources_.emplace_back(
         std::make_unique<PrefetchedSplitProvider>(
@@ -395,10 +456,80 @@ absl::Status SnapshotManager::StreamRestorer::ReadOnDiskStream() {
 
   worker_address_ = *worker_address;
   restored_stream_.emplace(num_sources_);
+  const bool done =
+      env_->FileExists(StreamDoneFilePath(path_, stream_index_)).ok();
+  bool restored_from_manifest = false;
+  if (done) {
+    TF_ASSIGN_OR_RETURN(restored_from_manifest, ReadOnDiskManifest());
+  }
+  if (!restored_from_manifest) {
+    TF_RETURN_IF_ERROR(ReadOnDiskSplits());
+  }
+
+  if (done) {
+    if (!restored_from_manifest) {
+      WriteStreamManifest(path_, stream_index_,
+                          restored_stream_->num_assigned_splits_per_source,
+                          restored_stream_->global_split_indices, env_);
+    }
+    restored_stream_->global_split_indices.clear();
+    restored_stream_->global_split_indices.shrink_to_fit();
+    restored_stream_->state = Stream::State::kDone;
+    return absl::OkStatus();
+  }
+  TF_ASSIGN_OR_RETURN(bool assignment_added,
+                      assignment_manager_.TryAddAssignment(
+                          path_, *worker_address, stream_index_));
+  if (!assignment_added) {
+    return absl::InternalError(absl::StrCat(
+        "Failed to recover tf.data snapshot dispatcher: Worker ",
+        *worker_address, " was assigned too many streams. At most ",
+        assignment_manager_.worker_max_concurrent_snapshots(),
+        " streams are allowed."));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<bool> SnapshotManager::StreamRestorer::ReadOnDiskManifest() {
+  const std::string manifest_path =
+      StreamSplitsManifestFilePath(path_, stream_index_);
+  if (!env_->FileExists(manifest_path).ok()) {
+    // The dispatcher may get preempted before it writes the manifest of a
+    // finished stream. If that happens, the splits are listed instead.
+    return false;
+  }
+  experimental::DistributedSnapshotStreamManifest manifest;
+  TF_RETURN_IF_ERROR(tsl::ReadBinaryProto(env_, manifest_path, &manifest));
+  if (manifest.num_assigned_splits_per_source_size() != num_sources_) {
+    return absl::InternalError(absl::StrCat(
+        "Failed to restore tf.data snapshot at ", path_, ": The manifest ",
+        manifest_path, " has ", manifest.num_assigned_splits_per_source_size(),
+        " sources, but the dataset has ", num_sources_, " sources."));
+  }
+  for (int64_t i = 0; i < num_sources_; ++i) {
+    restored_stream_->num_assigned_splits_per_source[i] =
+        manifest.num_assigned_splits_per_source(i);
+  }
+  if (restored_stream_->num_assigned_splits() !=
+      manifest.global_split_indices_size()) {
+    return absl::InternalError(absl::StrCat(
+        "Failed to restore tf.data snapshot at ", path_, ": The manifest ",
+        manifest_path, " has ", manifest.global_split_indices_size(),
+        " global split indices, but ", restored_stream_->num_assigned_splits(),
+        " assigned splits."));
+  }
+  for (int64_t global_split_index : manifest.global_split_indices()) {
+    TF_RETURN_IF_ERROR(AddGlobalSplitIndex(global_split_index, manifest_path));
+  }
+  return true;
+}
+
+absl::Status SnapshotManager::StreamRestorer::ReadOnDiskSplits() {
   std::string splits_path = SplitsDirectory(path_, stream_index_);
   TF_ASSIGN_OR_RETURN(std::vector<std::string> source_directories,
                       GetChildren(splits_path, env_));
 
+  absl::flat_hash_map<std::string, int64_t> source_indices;
   for (const auto& source_directory : source_directories) {
     std::string source_path = tsl::io::JoinPath(splits_path, source_directory);
 
@@ -416,70 +547,60 @@ absl::Status SnapshotManager::StreamRestorer::ReadOnDiskStream() {
           absl::StrCat("Found conflict between the number of sources, ",
                        num_sources_, ", and the filename of ", source_path));
     }
-    TF_RETURN_IF_ERROR(ReadOnDiskSource(source_index));
+    source_indices[source_path] = source_index;
   }
-
-  if (env_->FileExists(StreamDoneFilePath(path_, stream_index_)).ok()) {
-    restored_stream_->state = Stream::State::kDone;
+  if (source_indices.empty()) {
     return absl::OkStatus();
   }
-  TF_ASSIGN_OR_RETURN(bool assignment_added,
-                      assignment_manager_.TryAddAssignment(
-                          path_, *worker_address, stream_index_));
-  if (!assignment_added) {
-    return absl::InternalError(absl::StrCat(
-        "Failed to recover tf.data snapshot dispatcher: Worker ",
-        *worker_address, " was assigned too many streams. At most ",
-        assignment_manager_.worker_max_concurrent_snapshots(),
-        " streams are allowed."));
-  }
-  return absl::OkStatus();
-}
 
-absl::Status SnapshotManager::StreamRestorer::ReadOnDiskSource(
-    int64_t source_index) {
-  std::string source_directory =
-      SourceDirectory(path_, stream_index_, source_index);
-  TF_ASSIGN_OR_RETURN(std::vector<std::string> repetition_directories,
-                      GetChildren(source_directory, env_));
-
-  for (const std::string& repetition : repetition_directories) {
-    std::string repetition_dir =
-        tsl::io::JoinPath(source_directory, repetition);
-    TF_ASSIGN_OR_RETURN(std::vector<std::string> split_files,
-                        GetChildren(repetition_dir, env_));
-    for (const std::string& split_file : split_files) {
-      std::string split_path = tsl::io::JoinPath(repetition_dir, split_file);
-      TF_RETURN_IF_ERROR(
-          ReadOnDiskSplit(source_index, split_files, split_path));
+  // Lists the split files of all sources and repetitions at once. This is a
+  // single listing on file systems that list by prefix, instead of one per
+  // repetition directory.
+  std::vector<std::string> split_paths;
+  TF_RETURN_IF_ERROR(env_->GetMatchingPaths(
+      tsl::io::JoinPath(splits_path, "*", "*", "*"), &split_paths));
+  for (const std::string& split_path : split_paths) {
+    if (IsTemporaryFile(split_path)) {
+      continue;
     }
-    restored_stream_->num_assigned_splits_per_source[source_index] +=
-        split_files.size();
+    std::string source_path(tsl::io::Dirname(tsl::io::Dirname(split_path)));
+    auto it = source_indices.find(source_path);
+    if (it == source_indices.end()) {
+      return absl::InternalError(
+          absl::StrCat("Failed to restore tf.data snapshot at ", path_,
+                       ": Found split ", split_path,
+                       " outside of a source directory."));
+    }
+    TF_RETURN_IF_ERROR(ReadOnDiskSplit(it->second, split_path));
   }
   return absl::OkStatus();
 }
 
 absl::Status SnapshotManager::StreamRestorer::ReadOnDiskSplit(
-    int64_t source_index, const std::vector<std::string>& split_files,
-    const std::string& split_file) {
+    int64_t source_index, const std::string& split_file) {
   // `split_file` must have this format:
   // "split_<local_split_index>_<global_split_index>".
   TF_ASSIGN_OR_RETURN(auto split_indices, ParseSplitFilename(split_file));
   auto [local_split_index, global_split_index] = split_indices;
+  TF_RETURN_IF_ERROR(AddGlobalSplitIndex(global_split_index, split_file));
+  ++restored_stream_->num_assigned_splits_per_source[source_index];
+  return absl::OkStatus();
+}
+
+absl::Status SnapshotManager::StreamRestorer::AddGlobalSplitIndex(
+    int64_t global_split_index, absl::string_view split_file) {
   if (global_split_indices_.contains(global_split_index)) {
     return absl::InternalError(absl::StrCat(
         "Failed to restore tf.data snapshot at ", path_,
         ": Found duplicate global split index in split ", split_file, "."));
   }
   global_split_indices_.insert(global_split_index);
+  restored_stream_->global_split_indices.push_back(global_split_index);
   return absl::OkStatus();
 }
 
 absl::Status SnapshotManager::RestoreFrom(
     const StreamRestorer& stream_restorer,
-    const std::vector<std::string>& stream_directories,
-    std::vector<std::unique_ptr<SplitProvider>>& split_providers,
-    std::vector<std::int64_t>& repetition_indices,
     absl::flat_hash_set<int64_t>& global_split_indices)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   if (!stream_restorer.GetStream().has_value()) {
@@ -499,17 +620,6 @@ absl::Status SnapshotManager::RestoreFrom(
         stream_restorer.WorkerAddress(),
         ": The worker is already assigned stream ", it->second, "."));
   }
-  for (int64_t source_index = 0; source_index < repetition_indices.size();
-       ++source_index) {
-    // To account for the splits having been assigned, skips the splits in the
-    // respective split providers.
-    int64_t skip_splits = GetStream(stream_restorer.StreamIndex())
-                              .num_assigned_splits_per_source[source_index];
-    for (int64_t i = 0; i < skip_splits; ++i) {
-      TF_RETURN_IF_ERROR(SkipSplit(*split_providers[source_index],
-                                   repetition_indices[source_index]));
-    }
-  }
   for (int64_t global_split_index : stream_restorer.GlobalSplitIndices()) {
     if (global_split_indices.contains(global_split_index)) {
       return absl::InternalError(
@@ -531,7 +641,13 @@ SnapshotManager::Stream& SnapshotManager::GetStream(int64_t stream_index)
 absl::Status SnapshotManager::HandleStreamCompletion(
     int64_t stream_index, absl::string_view worker_address)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-  GetStream(stream_index).state = Stream::State::kDone;
+  Stream& stream = GetStream(stream_index);
+  stream.state = Stream::State::kDone;
+  WriteStreamManifest(path_, stream_index,
+                      stream.num_assigned_splits_per_source,
+                      stream.global_split_indices, env_);
+  stream.global_split_indices.clear();
+  stream.global_split_indices.shrink_to_fit();
   assignment_manager_.RemoveAssignment(path_, worker_address, stream_index);
   ++num_completed_streams_;
   if (absl::c_all_of(streams_, [](const auto& stream) {
@@ -762,8 +878,9 @@ absl::Status SnapshotManager::GetSnapshotSplit(
   split->AsProtoTensorContent(response.mutable_split());
 
   tsl::mutex_lock l(mu_);
-  ++GetStream(request.stream_index())
-        .num_assigned_splits_per_source[request.source_index()];
+  Stream& stream = GetStream(request.stream_index());
+  ++stream.num_assigned_splits_per_source[request.source_index()];
+  stream.global_split_indices.push_back(global_split_index);
   ++num_assigned_splits_;
   return absl::OkStatus();
 }
@@ -240,6 +240,9 @@ class SnapshotManager {
 
     // A counter of assigned splits for each source.
     std::vector<int64_t> num_assigned_splits_per_source;
+    // The global indices of the splits assigned to the stream. Released once
+    // the stream is done and its manifest has been written.
+    std::vector<int64_t> global_split_indices;
 
     int64_t num_assigned_splits() const {
       return absl::c_accumulate(num_assigned_splits_per_source, 0);
@@ -291,11 +294,15 @@ class SnapshotManager {
 
    private:
     absl::StatusOr<std::string> OwnerWorkerAddress() const;
-    absl::Status ReadOnDiskSource(int64_t source_index);
+    // Restores the splits from the manifest of a finished stream. Returns false
+    // if the stream has no manifest.
+    absl::StatusOr<bool> ReadOnDiskManifest();
+    // Restores the splits by listing the split files of all sources.
+    absl::Status ReadOnDiskSplits();
     absl::Status ReadOnDiskSplit(int64_t source_index,
-                                 const std::vector<std::string>& split_files,
                                  const std::string& split_file);
-    absl::Status SkipSplit(SplitProvider& split_provider);
+    absl::Status AddGlobalSplitIndex(int64_t global_split_index,
+                                     absl::string_view split_file);
 
     tsl::Env* const env_;
     const std::string path_;
@@ -310,12 +317,8 @@ class SnapshotManager {
 
   // Applies the data collected by `stream_restorer` to actually restore the
   // snapshot manager.
-  absl::Status RestoreFrom(
-      const StreamRestorer& stream_restorer,
-      const std::vector<std::string>& stream_directories,
-      std::vector<std::unique_ptr<SplitProvider>>& split_providers,
-      std::vector<int64_t>& repetition_indices,
-      absl::flat_hash_set<int64_t>& global_split_indices);
+  absl::Status RestoreFrom(const StreamRestorer& stream_restorer,
+                           absl::flat_hash_set<int64_t>& global_split_indices);
 
   // Gets the snapshot stream.
   Stream& GetStream(int64_t stream_index);
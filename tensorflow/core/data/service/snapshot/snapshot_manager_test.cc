@@ -20,10 +20,12 @@ limitations under the License.
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/dispatcher.pb.h"
+#include "tensorflow/core/data/service/snapshot/file_utils.h"
 #include "tensorflow/core/data/service/snapshot/path_utils.h"
 #include "tensorflow/core/data/service/test_util.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/protobuf/snapshot.pb.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/status_matchers.h"
@@ -200,6 +202,100 @@ TEST(SnapshotManagerTest, Resume) {
   EXPECT_THAT(heartbeat_response.snapshot_tasks(), SizeIs(1));
 }
 
+TEST(SnapshotManagerTest, ResumeFromStreamManifest) {
+  std::string snapshot_path = testing::LocalTempFilename();
+  SnapshotRequest request;
+  *request.mutable_dataset() = testing::RangeDataset(10);
+  request.set_path(snapshot_path);
+  *request.mutable_metadata() =
+      testing::CreateDummyDistributedSnapshotMetadata();
+
+  SnapshotAssignmentManager snapshot_assignment_manager_1(
+      /*worker_max_concurrent_snapshots=*/2);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<SnapshotManager> snapshot_manager,
+      SnapshotManager::Start(request, snapshot_assignment_manager_1,
+                             Env::Default()));
+  WorkerHeartbeatRequest heartbeat_request;
+  WorkerHeartbeatResponse heartbeat_response;
+  heartbeat_request.set_worker_address("localhost:1");
+  TF_ASSERT_OK(
+      snapshot_manager->WorkerHeartbeat(heartbeat_request, heartbeat_response));
+  ASSERT_EQ(heartbeat_response.snapshot_tasks().size(), 1);
+  const SnapshotTaskDef snapshot_task = heartbeat_response.snapshot_tasks(0);
+  // Creates a second stream, so the snapshot is not done when the first
+  // stream is.
+  heartbeat_request.set_worker_address("localhost:2");
+  heartbeat_response.Clear();
+  TF_ASSERT_OK(
+      snapshot_manager->WorkerHeartbeat(heartbeat_request, heartbeat_response));
+  ASSERT_EQ(heartbeat_response.snapshot_tasks().size(), 1);
+
+  GetSnapshotSplitRequest get_split_request;
+  GetSnapshotSplitResponse get_split_response;
+  get_split_request.set_worker_address("localhost:1");
+  get_split_request.set_base_path(snapshot_path);
+  get_split_request.set_stream_index(snapshot_task.stream_index());
+  get_split_request.set_source_index(0);
+  for (int64_t i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(snapshot_manager->GetSnapshotSplit(get_split_request,
+                                                    get_split_response));
+  }
+
+  // Reports stream completion, which writes the stream manifest.
+  TF_ASSERT_OK(AtomicallyWriteStringToFile(
+      StreamDoneFilePath(snapshot_path, snapshot_task.stream_index()),
+      std::string(), Env::Default()));
+  heartbeat_request.Clear();
+  heartbeat_response.Clear();
+  heartbeat_request.set_worker_address("localhost:1");
+  SnapshotTaskProgress progress;
+  *progress.mutable_snapshot_task() = snapshot_task;
+  progress.set_completed(true);
+  (*heartbeat_request.mutable_snapshot_task_progress())[snapshot_path] =
+      progress;
+  TF_ASSERT_OK(
+      snapshot_manager->WorkerHeartbeat(heartbeat_request, heartbeat_response));
+
+  experimental::DistributedSnapshotStreamManifest manifest;
+  TF_ASSERT_OK(tsl::ReadBinaryProto(
+      Env::Default(),
+      StreamSplitsManifestFilePath(snapshot_path, snapshot_task.stream_index()),
+      &manifest));
+  EXPECT_THAT(manifest.num_assigned_splits_per_source(), ElementsAre(3));
+  EXPECT_THAT(manifest.global_split_indices(), ElementsAre(0, 1, 2));
+
+  // Removes the split files to check that the resumed manager only relies on
+  // the manifest.
+  int64_t undeleted_files = 0, undeleted_dirs = 0;
+  TF_ASSERT_OK(Env::Default()->DeleteRecursively(
+      SplitsDirectory(snapshot_path, snapshot_task.stream_index()),
+      &undeleted_files, &undeleted_dirs));
+
+  // The other stream continues from the fourth split.
+  SnapshotAssignmentManager snapshot_assignment_manager_2(
+      /*worker_max_concurrent_snapshots=*/2);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<SnapshotManager> resumed_manager,
+      SnapshotManager::Resume(snapshot_path, snapshot_assignment_manager_2,
+                              Env::Default()));
+  heartbeat_request.Clear();
+  heartbeat_response.Clear();
+  heartbeat_request.set_worker_address("localhost:2");
+  TF_ASSERT_OK(
+      resumed_manager->WorkerHeartbeat(heartbeat_request, heartbeat_response));
+  ASSERT_EQ(heartbeat_response.snapshot_tasks().size(), 1);
+  get_split_request.set_worker_address("localhost:2");
+  get_split_request.set_stream_index(
+      heartbeat_response.snapshot_tasks(0).stream_index());
+  TF_ASSERT_OK(
+      resumed_manager->GetSnapshotSplit(get_split_request, get_split_response));
+  Tensor tensor;
+  ASSERT_TRUE(tensor.FromProto(get_split_response.split()));
+  EXPECT_EQ(GetValue<int64_t>(tensor), 3);
+  EXPECT_EQ(get_split_response.local_split_index(), 0);
+}
+
 TEST(SnapshotManagerTest, SnapshotStreamError) {
   std::string snapshot_path = testing::LocalTempFilename();
   SnapshotRequest snapshot_request;
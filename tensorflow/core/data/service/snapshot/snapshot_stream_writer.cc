@@ -32,6 +32,7 @@ limitations under the License.
 #include "absl/time/time.h"
 #include "tensorflow/core/data/service/byte_size.h"
 #include "tensorflow/core/data/service/common.h"
+#include "tensorflow/core/data/service/snapshot/columnar_chunk.h"
 #include "tensorflow/core/data/service/snapshot/file_utils.h"
 #include "tensorflow/core/data/service/snapshot/parallel_tfrecord_writer.h"
 #include "tensorflow/core/data/service/snapshot/path_utils.h"
@@ -176,9 +177,10 @@ absl::Status SnapshotStreamWriter::WriteChunks() {
   std::string chunks_prefix = tsl::io::JoinPath(
       params_.UncommittedChunksDirectory(),
       absl::StrCat("chunk_", chunk_index_, kFileShardDelimiter));
-  ParallelTFRecordWriter writer(TranslateFileName(chunks_prefix),
-                                params_.compression, params_.env,
-                                params_.max_chunk_size);
+  ParallelTFRecordWriter writer(
+      TranslateFileName(chunks_prefix), params_.compression, params_.env,
+      params_.max_chunk_size, /*num_write_threads=*/2, /*buffer_size=*/1,
+      params_.direct_io);
   do {
     TF_RETURN_IF_ERROR(WriteRecord(writer));
   } while (ShouldWriteRecord());
@@ -301,7 +303,8 @@ absl::Status SnapshotStreamWriter::Save(
   TF_ASSIGN_OR_RETURN(std::vector<Tensor> serialized_iterator,
                       iterator_->Save());
   TF_RETURN_IF_ERROR(AtomicallyWriteTFRecords(
-      checkpoint_path, serialized_iterator, params_.compression, params_.env));
+      checkpoint_path, serialized_iterator,
+      TFRecordCompression(params_.compression), params_.env));
   absl::Time end_time = absl::FromUnixMicros(params_.env->NowMicros());
   LOG(INFO) << "Wrote checkpoint file " << checkpoint_path << ". "
             << "Checkpointing distributed tf.data snapshot writer took "
@@ -360,7 +363,8 @@ absl::Status SnapshotStreamWriter::Restore() {
   }
   TF_RETURN_IF_ERROR(checkpoint_name.status());
   snapshot_util::TFRecordReaderImpl reader(
-      CheckpointPath(*checkpoint_name), params_.compression,
+      CheckpointPath(*checkpoint_name),
+      TFRecordCompression(params_.compression),
       kTFRecordReaderOutputBufferSize.ToUnsignedBytes());
   TF_RETURN_IF_ERROR(reader.Initialize(params_.env));
   TF_ASSIGN_OR_RETURN(std::vector<Tensor> serialized_tensors,
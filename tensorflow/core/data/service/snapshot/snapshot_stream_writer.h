@@ -55,7 +55,9 @@ struct SnapshotWriterParams {
   // processed by a worker.
   int64_t stream_index = 0;
 
-  // Compression method as defined in tsl/lib/io/compression.h.
+  // Compression method as defined in tsl/lib/io/compression.h,
+  // `kColumnarCompression` to write chunks in a columnar format, or
+  // `kAdaptiveCompression` to choose a codec for every chunk.
   std::string compression;
 
   // The Tensorflow environment.
@@ -69,6 +71,10 @@ struct SnapshotWriterParams {
   // avoid starving training jobs during startup.
   absl::Duration checkpoint_interval = kDefaultCheckpointInterval;
 
+  // If true, adaptive chunks are written with direct I/O, bypassing the page
+  // cache.
+  bool direct_io = false;
+
   // If true, keep temporary files (e.g., checkpoints) after completing the
   // snapshot. Used only for unit testing.
   bool test_only_keep_temp_files = false;
@@ -18,6 +18,7 @@ limitations under the License.
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/data/service/common.pb.h"
@@ -41,6 +42,22 @@ Status DataServiceSplitProvider::GetNext(Tensor* split, bool* end_of_splits)
     dispatcher_ =
         std::make_unique<DataServiceDispatcherClient>(address_, protocol_);
   }
+  if (max_prefetched_splits_ > 1) {
+    if (buffered_splits_.empty() && !buffered_end_of_splits_) {
+      TF_RETURN_IF_ERROR(FetchSplits());
+    }
+    if (buffered_splits_.empty()) {
+      *end_of_splits = true;
+      buffered_end_of_splits_ = false;
+      VLOG(1) << "Reached end of splits for iteration_id=" << iteration_id_
+              << ", repetition=" << repetition_;
+      return absl::OkStatus();
+    }
+    *split = std::move(buffered_splits_.front());
+    buffered_splits_.pop_front();
+    *end_of_splits = false;
+    return absl::OkStatus();
+  }
   TF_RETURN_IF_ERROR(grpc_util::Retry(
       [this, split, end_of_splits]() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         return dispatcher_->GetSplit(iteration_id_, repetition_,
@@ -61,9 +78,39 @@ Status DataServiceSplitProvider::GetNext(Tensor* split, bool* end_of_splits)
   return absl::OkStatus();
 }
 
+Status DataServiceSplitProvider::FetchSplits()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  std::vector<Tensor> splits;
+  bool end_of_splits = false;
+  // Retries reuse `request_index_`, so that the dispatcher returns the splits
+  // it already produced for a request whose response was lost.
+  TF_RETURN_IF_ERROR(grpc_util::Retry(
+      [this, &splits, &end_of_splits]() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        splits.clear();
+        return dispatcher_->GetSplits(iteration_id_, repetition_,
+                                      split_provider_index_,
+                                      max_prefetched_splits_, requester_id_,
+                                      request_index_, splits, end_of_splits);
+      },
+      "get next splits",
+      /*deadline_micros=*/Env::Default()->NowMicros() +
+          (timeout_ms_ * EnvTime::kMillisToMicros)));
+  ++request_index_;
+  VLOG(1) << "Requested " << splits.size()
+          << " splits with iteration_id=" << iteration_id_
+          << ", repetition=" << repetition_;
+  for (Tensor& split : splits) {
+    buffered_splits_.push_back(std::move(split));
+  }
+  buffered_end_of_splits_ = end_of_splits;
+  return absl::OkStatus();
+}
+
 Status DataServiceSplitProvider::Reset() TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
   repetition_++;
+  buffered_splits_.clear();
+  buffered_end_of_splits_ = false;
   return absl::OkStatus();
 }
 
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_SPLIT_PROVIDER_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_SPLIT_PROVIDER_H_
 
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <string>
@@ -26,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 
@@ -33,16 +36,24 @@ namespace tensorflow {
 namespace data {
 
 // SplitProvider which reads splits from a tf.data service dispatcher over RPC.
+//
+// If `max_prefetched_splits` is greater than 1, splits are fetched from the
+// dispatcher in batches of up to that many splits and buffered locally, which
+// saves a dispatcher round trip for most `GetNext` calls. Buffered splits are
+// lost if the worker fails.
 class DataServiceSplitProvider : public SplitProvider {
  public:
   DataServiceSplitProvider(const std::string& address,
                            const std::string& protocol, int64_t iteration_id,
-                           int64_t split_provider_index, int64_t timeout_ms)
+                           int64_t split_provider_index, int64_t timeout_ms,
+                           int64_t max_prefetched_splits = 1)
       : address_(address),
         protocol_(protocol),
         iteration_id_(iteration_id),
         split_provider_index_(split_provider_index),
-        timeout_ms_(timeout_ms) {}
+        timeout_ms_(timeout_ms),
+        max_prefetched_splits_(max_prefetched_splits),
+        requester_id_(random::New64()) {}
 
   Status GetNext(Tensor* split, bool* end_of_splits) override;
   Status Reset() override;
@@ -57,9 +68,22 @@ class DataServiceSplitProvider : public SplitProvider {
   const int64_t iteration_id_;
   const int64_t split_provider_index_;
   const int64_t timeout_ms_;
+  const int64_t max_prefetched_splits_;
+  // Identifies this split provider to the dispatcher, so that retried batched
+  // requests return the same splits.
+  const int64_t requester_id_;
+
+  // Fetches the next batch of splits into `buffered_splits_`.
+  Status FetchSplits() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   mutex mu_;
   int64_t repetition_ TF_GUARDED_BY(mu_) = 0;
+  // Index of the next batched request, used to de-duplicate retries.
+  int64_t request_index_ TF_GUARDED_BY(mu_) = 0;
+  std::deque<Tensor> buffered_splits_ TF_GUARDED_BY(mu_);
+  // Whether the dispatcher reported end of splits for the current repetition.
+  // It is returned once `buffered_splits_` is drained.
+  bool buffered_end_of_splits_ TF_GUARDED_BY(mu_) = false;
   std::unique_ptr<DataServiceDispatcherClient> dispatcher_ TF_GUARDED_BY(mu_);
 };
 
@@ -15,11 +15,15 @@ limitations under the License.
 #include "tensorflow/core/data/service/task_runner.h"
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
+
 #include "tensorflow/core/data/service/byte_size.h"
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/cross_trainer_cache.h"
@@ -29,9 +33,13 @@ limitations under the License.
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/dataset.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
@@ -48,6 +56,10 @@ namespace {
 constexpr int64_t kWaitBeforeSkipUs = 100 * 1000;  // 100ms.
 constexpr size_t kDefaultCrossTrainerCacheSizeBytes =
     10 * (size_t{1} << 30);  // 10GB
+// Limits on the prefetch buffer of the FCFS task runner, which starts at one
+// element and grows while consumers find it empty.
+constexpr size_t kMaxFcfsPrefetchBufferSize = 16;
+constexpr size_t kMaxFcfsPrefetchBufferBytes = 64 * (size_t{1} << 20);  // 64MB
 
 }  // namespace
 
@@ -100,8 +112,14 @@ Status TaskRunner::Create(const experimental::WorkerConfig& worker_config,
         worker_config.cross_trainer_cache_size_bytes() > 0
             ? worker_config.cross_trainer_cache_size_bytes()
             : kDefaultCrossTrainerCacheSizeBytes;
-    out = std::make_unique<CachingTaskRunner>(std::move(iterator),
-                                              max_cache_size_bytes);
+    CrossTrainerCacheDiskOptions disk_options;
+    disk_options.directory = worker_config.cross_trainer_cache_disk_directory();
+    disk_options.max_size_bytes =
+        worker_config.cross_trainer_cache_disk_size_bytes() > 0
+            ? worker_config.cross_trainer_cache_disk_size_bytes()
+            : 0;
+    out = std::make_unique<CachingTaskRunner>(
+        std::move(iterator), max_cache_size_bytes, disk_options);
   } else {
     out = std::make_unique<FirstComeFirstServedTaskRunner>(std::move(iterator));
   }
@@ -118,13 +136,33 @@ FirstComeFirstServedTaskRunner::~FirstComeFirstServedTaskRunner() { Cancel(); }
 
 Status FirstComeFirstServedTaskRunner::GetNext(const GetElementRequest& req,
                                                GetElementResult& result) {
-  if (req.allow_skip() && buffer_.Empty()) {
+  const bool buffer_hit = !buffer_.Empty();
+  metrics::RecordTFDataServiceTaskRunnerBufferQuery("fcfs", buffer_hit);
+  if (!buffer_hit) {
+    GrowPrefetchBuffer();
+  }
+  if (req.allow_skip() && !buffer_hit) {
     result.skip = true;
     return absl::OkStatus();
   }
   return GetNext(result);
 }
 
+void FirstComeFirstServedTaskRunner::GrowPrefetchBuffer() {
+  const size_t element_size_bytes =
+      std::max<size_t>(element_size_bytes_.load(std::memory_order_relaxed), 1);
+  const size_t max_buffer_size =
+      std::clamp<size_t>(kMaxFcfsPrefetchBufferBytes / element_size_bytes, 1,
+                         kMaxFcfsPrefetchBufferSize);
+  const size_t buffer_size =
+      std::min(2 * buffer_.BufferSize(), max_buffer_size);
+  if (buffer_size != buffer_.BufferSize()) {
+    VLOG(3) << "Resizing tf.data service FCFS prefetch buffer to "
+            << buffer_size << " elements.";
+    buffer_.SetBufferSize(buffer_size);
+  }
+}
+
 Status FirstComeFirstServedTaskRunner::GetNext(GetElementResult& result) {
   TF_ASSIGN_OR_RETURN(result, buffer_.Pop());
   return absl::OkStatus();
@@ -165,6 +203,8 @@ FirstComeFirstServedTaskRunner::GetNextFromInputIterator()
   if (!end_of_task) {
     result.components = std::move(element);
   }
+  element_size_bytes_.store(result.EstimatedMemoryUsageBytes(),
+                            std::memory_order_relaxed);
   return result;
 }
 
@@ -177,11 +217,13 @@ std::shared_ptr<model::Model> FirstComeFirstServedTaskRunner::model() const {
   return model_;
 }
 
-CachingTaskRunner::CachingTaskRunner(std::unique_ptr<TaskIterator> iterator,
-                                     size_t max_cache_size_bytes)
+CachingTaskRunner::CachingTaskRunner(
+    std::unique_ptr<TaskIterator> iterator, size_t max_cache_size_bytes,
+    const CrossTrainerCacheDiskOptions& disk_options)
     : fcfs_task_runner_(std::move(iterator)),
       cache_(max_cache_size_bytes,
-             std::make_unique<GetElementResultSequence>(fcfs_task_runner_)) {
+             std::make_unique<GetElementResultSequence>(fcfs_task_runner_),
+             disk_options) {
   LOG(INFO) << "Initialized tf.data service cross-trainer cache with "
             << ByteSize::Bytes(max_cache_size_bytes) << " of memory.";
 }
@@ -217,6 +259,60 @@ size_t CachingTaskRunner::GetElementResultSequence::GetElementSizeBytes(
   return element.EstimatedMemoryUsageBytes();
 }
 
+absl::StatusOr<std::string>
+CachingTaskRunner::GetElementResultSequence::Serialize(
+    const GetElementResult& element) const {
+  GetElementResponse response;
+  response.set_element_index(element.element_index);
+  response.set_end_of_sequence(element.end_of_sequence);
+  response.set_skip_task(element.skip);
+  if (element.components.size() == 1 &&
+      element.components[0].dtype() == DT_VARIANT &&
+      TensorShapeUtils::IsScalar(element.components[0].shape())) {
+    const CompressedElement* compressed =
+        element.components[0].scalar<Variant>()().get<CompressedElement>();
+    if (compressed != nullptr) {
+      *response.mutable_compressed() = *compressed;
+      return response.SerializeAsString();
+    }
+  }
+  UncompressedElement* uncompressed = response.mutable_uncompressed();
+  for (const Tensor& component : element.components) {
+    component.AsProtoTensorContent(uncompressed->add_components());
+  }
+  return response.SerializeAsString();
+}
+
+absl::StatusOr<GetElementResult>
+CachingTaskRunner::GetElementResultSequence::Deserialize(
+    absl::string_view data) const {
+  GetElementResponse response;
+  if (!response.ParseFromArray(data.data(), data.size())) {
+    return errors::DataLoss(
+        "Failed to parse a cross-trainer cache element spilled to disk.");
+  }
+  GetElementResult result;
+  result.element_index = response.element_index();
+  result.end_of_sequence = response.end_of_sequence();
+  result.skip = response.skip_task();
+  if (response.has_compressed()) {
+    Tensor tensor(DT_VARIANT, TensorShape{});
+    tensor.scalar<Variant>()() = std::move(*response.mutable_compressed());
+    result.components.push_back(std::move(tensor));
+    return result;
+  }
+  for (const TensorProto& proto : response.uncompressed().components()) {
+    Tensor tensor;
+    if (!tensor.FromProto(proto)) {
+      return errors::DataLoss(
+          "Failed to parse a tensor of a cross-trainer cache element spilled "
+          "to disk.");
+    }
+    result.components.push_back(std::move(tensor));
+  }
+  return result;
+}
+
 void CachingTaskRunner::Cancel() {
   VLOG(2) << "Cancelling tf.data service cross-trainer cache task.";
   if (!cache_.IsCancelled()) {
@@ -15,10 +15,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_TASK_RUNNER_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_TASK_RUNNER_H_
 
+#include <atomic>
 #include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/cross_trainer_cache.h"
 #include "tensorflow/core/data/service/data_transfer.h"
@@ -133,10 +136,17 @@ class FirstComeFirstServedTaskRunner : public TaskRunner {
   absl::StatusOr<GetElementResult> GetNextFromInputIterator()
       TF_LOCKS_EXCLUDED(mu_);
 
+  // Called when a request finds no prefetched element. Doubles the prefetch
+  // buffer, up to a limit on the number of elements and on their estimated
+  // memory usage.
+  void GrowPrefetchBuffer();
+
   const std::shared_ptr<model::Model> model_;
   mutex mu_;
   std::unique_ptr<TaskIterator> iterator_ TF_GUARDED_BY(mu_);
   int64_t element_index_ TF_GUARDED_BY(mu_) = 0;
+  // Estimated memory usage of the most recently prefetched element.
+  std::atomic<size_t> element_size_bytes_ = 0;
 
   ThreadSafeBuffer<GetElementResult> buffer_;
   std::unique_ptr<Thread> prefetch_thread_;
@@ -153,8 +163,9 @@ class FirstComeFirstServedTaskRunner : public TaskRunner {
 // read the full dataset.
 class CachingTaskRunner : public TaskRunner {
  public:
-  explicit CachingTaskRunner(std::unique_ptr<TaskIterator> iterator,
-                             size_t max_cache_size_bytes);
+  explicit CachingTaskRunner(
+      std::unique_ptr<TaskIterator> iterator, size_t max_cache_size_bytes,
+      const CrossTrainerCacheDiskOptions& disk_options = {});
   ~CachingTaskRunner() override;
 
   // Gets the next element from the cross-trainer cache, blocking if the data is
@@ -180,6 +191,10 @@ class CachingTaskRunner : public TaskRunner {
         FirstComeFirstServedTaskRunner& fcfs_task_runner);
     absl::StatusOr<GetElementResult> GetNext() override;
     size_t GetElementSizeBytes(const GetElementResult& element) const override;
+    absl::StatusOr<std::string> Serialize(
+        const GetElementResult& element) const override;
+    absl::StatusOr<GetElementResult> Deserialize(
+        absl::string_view data) const override;
 
    private:
     FirstComeFirstServedTaskRunner& fcfs_task_runner_;
@@ -50,10 +50,17 @@ class ThreadSafeBuffer final {
   // Returns whether the buffer is empty.
   bool Empty() const;
 
- private:
-  const size_t buffer_size_;
+  // Changes the buffer size to `buffer_size`. Elements already in the buffer
+  // are kept even if there are more than `buffer_size` of them.
+  // REQUIRES: buffer_size > 0
+  void SetBufferSize(size_t buffer_size);
 
+  // Returns the current buffer size.
+  size_t BufferSize() const;
+
+ private:
   mutable mutex mu_;
+  size_t buffer_size_ TF_GUARDED_BY(mu_);
   condition_variable ready_to_pop_;
   condition_variable ready_to_push_;
   std::deque<StatusOr<T>> results_ TF_GUARDED_BY(mu_);
@@ -77,6 +84,22 @@ bool ThreadSafeBuffer<T>::Empty() const {
   return results_.empty();
 }
 
+template <class T>
+void ThreadSafeBuffer<T>::SetBufferSize(size_t buffer_size) {
+  DCHECK_GT(buffer_size, 0)
+      << "ThreadSafeBuffer must have a positive buffer size. Got "
+      << buffer_size << ".";
+  mutex_lock l(mu_);
+  buffer_size_ = buffer_size;
+  ready_to_push_.notify_all();
+}
+
+template <class T>
+size_t ThreadSafeBuffer<T>::BufferSize() const {
+  tf_shared_lock l(mu_);
+  return buffer_size_;
+}
+
 template <class T>
 StatusOr<T> ThreadSafeBuffer<T>::Pop() {
   mutex_lock l(mu_);
@@ -180,6 +180,33 @@ TEST_P(ThreadSafeBufferTest, BlockWriterWhenBufferIsFull) {
   EXPECT_LE(pop_time, push_time);
 }
 
+TEST_P(ThreadSafeBufferTest, GrowingBufferUnblocksWriter) {
+  ThreadSafeBuffer<Tensor> buffer(GetBufferSize());
+  // Fills the buffer to block the next `Push` call.
+  for (int i = 0; i < GetBufferSize(); ++i) {
+    ASSERT_THAT(buffer.Push(Tensor("Test tensor")), IsOk());
+  }
+
+  uint64 push_time = 0;
+  auto thread = absl::WrapUnique(Env::Default()->StartThread(
+      /*thread_options=*/{}, /*name=*/"writer_thread", [&buffer, &push_time]() {
+        ASSERT_THAT(buffer.Push(Tensor("Test tensor")), IsOk());
+        push_time = Env::Default()->NowMicros();
+      }));
+
+  // Growing the buffer unblocks the `Push` call without any `Pop`.
+  Env::Default()->SleepForMicroseconds(10000);
+  uint64 resize_time = Env::Default()->NowMicros();
+  buffer.SetBufferSize(GetBufferSize() + 1);
+  thread.reset();
+  EXPECT_LE(resize_time, push_time);
+  EXPECT_EQ(buffer.BufferSize(), GetBufferSize() + 1);
+  for (int i = 0; i < GetBufferSize() + 1; ++i) {
+    ASSERT_THAT(buffer.Pop(), IsOk());
+  }
+  EXPECT_TRUE(buffer.Empty());
+}
+
 TEST_P(ThreadSafeBufferTest, CancelReaders) {
   ThreadSafeBuffer<int> buffer(GetBufferSize());
   std::vector<std::unique_ptr<Thread>> threads;
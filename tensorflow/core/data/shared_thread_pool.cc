@@ -0,0 +1,104 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/shared_thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace data {
+
+SharedThreadPool::Registration::~Registration() {
+  {
+    mutex_lock l(mu_);
+    while (num_pending_ > 0) {
+      cond_var_.wait(l);
+    }
+  }
+  pool_->Unregister(weight_);
+}
+
+void SharedThreadPool::Registration::Schedule(std::function<void()> fn) {
+  {
+    mutex_lock l(mu_);
+    ++num_pending_;
+  }
+  pool_->thread_pool_.Schedule([this, fn = std::move(fn)]() {
+    fn();
+    mutex_lock l(mu_);
+    if (--num_pending_ == 0) {
+      cond_var_.notify_all();
+    }
+  });
+}
+
+int64_t SharedThreadPool::Registration::ScaleCpuBudget(
+    int64_t cpu_budget) const {
+  const int64_t total_weight = std::max(weight_, pool_->TotalWeight());
+  return std::max<int64_t>(1, cpu_budget * weight_ / total_weight);
+}
+
+SharedThreadPool::SharedThreadPool(int num_threads)
+    : thread_pool_(Env::Default(), ThreadOptions{}, "data_shared_threadpool",
+                   std::max(1, num_threads)) {}
+
+// static
+SharedThreadPool* SharedThreadPool::Get() {
+  static SharedThreadPool* pool = [] {
+    int64_t num_threads;
+    Status s = ReadInt64FromEnvVar("TF_DATA_SHARED_THREADPOOL_SIZE",
+                                   port::MaxParallelism(), &num_threads);
+    if (!s.ok() || num_threads <= 0) {
+      LOG(WARNING) << "Invalid TF_DATA_SHARED_THREADPOOL_SIZE, using "
+                   << port::MaxParallelism() << " threads: " << s;
+      num_threads = port::MaxParallelism();
+    }
+    return new SharedThreadPool(static_cast<int>(num_threads));
+  }();
+  return pool;
+}
+
+std::shared_ptr<SharedThreadPool::Registration> SharedThreadPool::Register(
+    int64_t weight) {
+  weight = std::max<int64_t>(1, weight);
+  {
+    mutex_lock l(mu_);
+    total_weight_ += weight;
+  }
+  return std::shared_ptr<Registration>(new Registration(this, weight));
+}
+
+int64_t SharedThreadPool::TotalWeight() const {
+  tf_shared_lock l(mu_);
+  return total_weight_;
+}
+
+void SharedThreadPool::Unregister(int64_t weight) {
+  mutex_lock l(mu_);
+  total_weight_ -= weight;
+}
+
+}  // namespace data
+}  // namespace tensorflow
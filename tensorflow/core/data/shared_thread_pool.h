@@ -0,0 +1,109 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SHARED_THREAD_POOL_H_
+#define TENSORFLOW_CORE_DATA_SHARED_THREAD_POOL_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace data {
+
+// A `SharedThreadPool` is a bounded, work-stealing thread pool that is shared
+// by all the tf.data pipelines that opt into it, instead of each pipeline
+// creating a private pool of `port::MaxParallelism()` threads. Sharing one
+// pool keeps the total number of compute threads of a process constant no
+// matter how many input pipelines are live.
+//
+// Each pipeline registers with a weight. The weight does not cap the number of
+// threads a pipeline may use at any instant (so that idle capacity can be
+// stolen by busy pipelines), but it determines the pipeline's share of the
+// autotuning CPU budget: a pipeline is budgeted
+// `budget * weight / total_weight` CPUs, where `total_weight` is the sum of
+// the weights of all live registrations. This keeps the sum of the
+// parallelism picked by the autotuners of concurrent pipelines within the
+// budget of the process.
+class SharedThreadPool {
+ public:
+  // A pipeline's handle on the shared pool. The pipeline is accounted for in
+  // the pool's total weight until the registration is destroyed.
+  class Registration {
+   public:
+    ~Registration();
+
+    Registration(const Registration&) = delete;
+    Registration& operator=(const Registration&) = delete;
+
+    // Schedules `fn` on the shared pool.
+    void Schedule(std::function<void()> fn);
+
+    // Returns this pipeline's share of `cpu_budget`, which is at least 1.
+    int64_t ScaleCpuBudget(int64_t cpu_budget) const;
+
+    int64_t weight() const { return weight_; }
+
+   private:
+    friend class SharedThreadPool;
+
+    Registration(SharedThreadPool* pool, int64_t weight)
+        : pool_(pool), weight_(weight) {}
+
+    SharedThreadPool* const pool_;
+    const int64_t weight_;
+
+    mutex mu_;
+    condition_variable cond_var_;
+    // The number of closures scheduled through this registration that have
+    // not finished yet. The destructor waits for it to drop to zero, matching
+    // the semantics of destroying a private thread pool.
+    int64_t num_pending_ TF_GUARDED_BY(mu_) = 0;
+  };
+
+  explicit SharedThreadPool(int num_threads);
+
+  SharedThreadPool(const SharedThreadPool&) = delete;
+  SharedThreadPool& operator=(const SharedThreadPool&) = delete;
+
+  // Returns the process-wide pool. Its size is read from the
+  // `TF_DATA_SHARED_THREADPOOL_SIZE` environment variable and defaults to
+  // `port::MaxParallelism()`.
+  static SharedThreadPool* Get();
+
+  // Registers a pipeline with the given weight. Weights smaller than 1 are
+  // treated as 1.
+  std::shared_ptr<Registration> Register(int64_t weight);
+
+  int NumThreads() const { return thread_pool_.NumThreads(); }
+
+  // Returns the sum of the weights of the live registrations.
+  int64_t TotalWeight() const;
+
+ private:
+  void Unregister(int64_t weight);
+
+  thread::ThreadPool thread_pool_;
+  mutable mutex mu_;
+  int64_t total_weight_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SHARED_THREAD_POOL_H_
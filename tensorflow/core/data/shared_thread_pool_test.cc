@@ -0,0 +1,91 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/shared_thread_pool.h"
+
+#include <atomic>
+#include <memory>
+
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+TEST(SharedThreadPoolTest, RunsScheduledClosures) {
+  SharedThreadPool pool(/*num_threads=*/4);
+  EXPECT_EQ(pool.NumThreads(), 4);
+  std::shared_ptr<SharedThreadPool::Registration> registration =
+      pool.Register(/*weight=*/1);
+  constexpr int kNumClosures = 100;
+  std::atomic<int> num_runs(0);
+  BlockingCounter counter(kNumClosures);
+  for (int i = 0; i < kNumClosures; ++i) {
+    registration->Schedule([&num_runs, &counter]() {
+      num_runs.fetch_add(1);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  EXPECT_EQ(num_runs.load(), kNumClosures);
+}
+
+TEST(SharedThreadPoolTest, DestroyingRegistrationWaitsForClosures) {
+  SharedThreadPool pool(/*num_threads=*/2);
+  std::atomic<int> num_runs(0);
+  {
+    std::shared_ptr<SharedThreadPool::Registration> registration =
+        pool.Register(/*weight=*/1);
+    for (int i = 0; i < 10; ++i) {
+      registration->Schedule([&num_runs]() {
+        Env::Default()->SleepForMicroseconds(1000);
+        num_runs.fetch_add(1);
+      });
+    }
+  }
+  EXPECT_EQ(num_runs.load(), 10);
+  EXPECT_EQ(pool.TotalWeight(), 0);
+}
+
+TEST(SharedThreadPoolTest, CpuBudgetIsSplitByWeight) {
+  SharedThreadPool pool(/*num_threads=*/1);
+  std::shared_ptr<SharedThreadPool::Registration> heavy =
+      pool.Register(/*weight=*/3);
+  EXPECT_EQ(heavy->ScaleCpuBudget(16), 16);
+  {
+    std::shared_ptr<SharedThreadPool::Registration> light =
+        pool.Register(/*weight=*/1);
+    EXPECT_EQ(pool.TotalWeight(), 4);
+    EXPECT_EQ(heavy->ScaleCpuBudget(16), 12);
+    EXPECT_EQ(light->ScaleCpuBudget(16), 4);
+    // Every pipeline is budgeted at least one CPU.
+    EXPECT_EQ(light->ScaleCpuBudget(2), 1);
+  }
+  EXPECT_EQ(pool.TotalWeight(), 3);
+  EXPECT_EQ(heavy->ScaleCpuBudget(16), 16);
+}
+
+TEST(SharedThreadPoolTest, NonPositiveWeightIsTreatedAsOne) {
+  SharedThreadPool pool(/*num_threads=*/1);
+  std::shared_ptr<SharedThreadPool::Registration> registration =
+      pool.Register(/*weight=*/0);
+  EXPECT_EQ(registration->weight(), 1);
+  EXPECT_EQ(pool.TotalWeight(), 1);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
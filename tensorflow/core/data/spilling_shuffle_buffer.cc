@@ -0,0 +1,298 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/spilling_shuffle_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/data/compression_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/dataset.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/random_index_shuffle.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr int32_t kIndexShuffleRounds = 8;
+
+constexpr char kPosition[] = "position";
+constexpr char kKey[] = "key";
+constexpr char kNextSegmentId[] = "next_segment_id";
+constexpr char kServing[] = "serving";
+constexpr char kFilling[] = "filling";
+constexpr char kNumSegments[] = "num_segments";
+constexpr char kSegment[] = "segment";
+constexpr char kIndex[] = "index";
+
+}  // namespace
+
+SpillingShuffleBuffer::SpillingShuffleBuffer(Env* env, Options options)
+    : env_(env), options_(std::move(options)) {}
+
+SpillingShuffleBuffer::~SpillingShuffleBuffer() {
+  absl::Status s = CloseWriter();
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to close shuffle buffer segment: " << s;
+  }
+  readers_.clear();
+  for (const Window* window : {&serving_, &filling_}) {
+    s = ReleaseSegments(window->segments);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete shuffle buffer segments: " << s;
+    }
+  }
+}
+
+absl::Status SpillingShuffleBuffer::Append(const std::vector<Tensor>& element) {
+  if (writer_ == nullptr || writer_offset_ >= options_.max_segment_bytes) {
+    TF_RETURN_IF_ERROR(CloseWriter());
+    std::string path = io::JoinPath(
+        options_.directory,
+        absl::StrCat(options_.file_prefix, "_", next_segment_id_++));
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(path, &writer_));
+    filling_.segments.push_back(std::move(path));
+    writer_offset_ = 0;
+  }
+  CompressedElement compressed;
+  TF_RETURN_IF_ERROR(CompressElement(element, &compressed));
+  std::string serialized = compressed.SerializeAsString();
+  TF_RETURN_IF_ERROR(writer_->Append(serialized));
+  filling_.index.push_back(
+      {static_cast<int64_t>(filling_.segments.size()) - 1, writer_offset_,
+       serialized.size()});
+  writer_offset_ += serialized.size();
+  return absl::OkStatus();
+}
+
+absl::Status SpillingShuffleBuffer::StartNextWindow(
+    const std::array<uint32_t, 3>& key) {
+  TF_RETURN_IF_ERROR(CloseWriter());
+  readers_.clear();
+  TF_RETURN_IF_ERROR(ReleaseSegments(serving_.segments));
+  serving_ = std::move(filling_);
+  filling_ = Window();
+  key_ = key;
+  position_ = 0;
+  return absl::OkStatus();
+}
+
+absl::Status SpillingShuffleBuffer::GetNext(std::vector<Tensor>* element) {
+  if (ServingRemaining() <= 0) {
+    return errors::FailedPrecondition(
+        "The serving window of the shuffle buffer is exhausted.");
+  }
+  const uint64_t max_index = serving_.index.size() - 1;
+  const uint64_t position = position_++;
+  const uint64_t i =
+      max_index == 0 ? 0
+                     : random::index_shuffle(position, key_, max_index,
+                                             kIndexShuffleRounds);
+  const Entry& entry = serving_.index[i];
+  std::unique_ptr<RandomAccessFile>& reader = readers_[entry.segment];
+  if (reader == nullptr) {
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        serving_.segments[entry.segment], &reader));
+  }
+  std::string scratch(entry.length, '\0');
+  absl::string_view data;
+  TF_RETURN_IF_ERROR(
+      reader->Read(entry.offset, entry.length, &data, scratch.data()));
+  CompressedElement compressed;
+  if (data.size() != entry.length ||
+      !compressed.ParseFromArray(data.data(), data.size())) {
+    return errors::DataLoss("Failed to read shuffle buffer element from ",
+                            serving_.segments[entry.segment], " at offset ",
+                            entry.offset);
+  }
+  element->clear();
+  return UncompressElement(compressed, element);
+}
+
+absl::Status SpillingShuffleBuffer::Save(const std::string& prefix,
+                                         IteratorStateWriter* writer) {
+  // Make sure that everything the index refers to is on disk. Elements
+  // appended after this point go to a new segment.
+  TF_RETURN_IF_ERROR(CloseWriter());
+  TF_RETURN_IF_ERROR(writer->WriteScalar(prefix, kPosition, position_));
+  for (int i = 0; i < key_.size(); ++i) {
+    TF_RETURN_IF_ERROR(writer->WriteScalar(prefix, absl::StrCat(kKey, "_", i),
+                                           static_cast<int64_t>(key_[i])));
+  }
+  TF_RETURN_IF_ERROR(
+      writer->WriteScalar(prefix, kNextSegmentId, next_segment_id_));
+  TF_RETURN_IF_ERROR(SaveWindow(prefix, kServing, serving_, writer));
+  TF_RETURN_IF_ERROR(SaveWindow(prefix, kFilling, filling_, writer));
+  // This checkpoint supersedes the previous one.
+  checkpointed_segments_.clear();
+  for (const Window* window : {&serving_, &filling_}) {
+    checkpointed_segments_.insert(window->segments.begin(),
+                                  window->segments.end());
+  }
+  return DeleteUnreferencedRetainedSegments();
+}
+
+absl::Status SpillingShuffleBuffer::Restore(const std::string& prefix,
+                                            IteratorStateReader* reader) {
+  TF_RETURN_IF_ERROR(CloseWriter());
+  readers_.clear();
+  TF_RETURN_IF_ERROR(reader->ReadScalar(prefix, kPosition, &position_));
+  for (int i = 0; i < key_.size(); ++i) {
+    int64_t key;
+    TF_RETURN_IF_ERROR(
+        reader->ReadScalar(prefix, absl::StrCat(kKey, "_", i), &key));
+    key_[i] = static_cast<uint32_t>(key);
+  }
+  // Segment ids only need to be unique, and restoring a checkpoint of this
+  // buffer must not reuse the ids of segments written since.
+  int64_t next_segment_id;
+  TF_RETURN_IF_ERROR(
+      reader->ReadScalar(prefix, kNextSegmentId, &next_segment_id));
+  next_segment_id_ = std::max(next_segment_id_, next_segment_id);
+  Window serving;
+  Window filling;
+  TF_RETURN_IF_ERROR(RestoreWindow(prefix, kServing, reader, &serving));
+  TF_RETURN_IF_ERROR(RestoreWindow(prefix, kFilling, reader, &filling));
+  // The restored checkpoint may be restored again, so its segments are kept
+  // like those of the last saved one.
+  for (const Window* window : {&serving, &filling}) {
+    checkpointed_segments_.insert(window->segments.begin(),
+                                  window->segments.end());
+  }
+  for (const Window* window : {&serving_, &filling_}) {
+    TF_RETURN_IF_ERROR(ReleaseSegments(window->segments));
+  }
+  serving_ = std::move(serving);
+  filling_ = std::move(filling);
+  return absl::OkStatus();
+}
+
+absl::Status SpillingShuffleBuffer::CloseWriter() {
+  if (writer_ == nullptr) {
+    return absl::OkStatus();
+  }
+  std::unique_ptr<WritableFile> writer = std::move(writer_);
+  return writer->Close();
+}
+
+absl::Status SpillingShuffleBuffer::ReleaseSegments(
+    const std::vector<std::string>& segments) {
+  for (const std::string& segment : segments) {
+    if (checkpointed_segments_.contains(segment)) {
+      retained_segments_.push_back(segment);
+      continue;
+    }
+    absl::Status s = env_->DeleteFile(segment);
+    if (!s.ok() && !absl::IsNotFound(s)) {
+      return s;
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status SpillingShuffleBuffer::DeleteUnreferencedRetainedSegments() {
+  absl::Status status;
+  std::vector<std::string> retained_segments;
+  for (std::string& segment : retained_segments_) {
+    if (!checkpointed_segments_.contains(segment)) {
+      absl::Status s = env_->DeleteFile(segment);
+      if (s.ok() || absl::IsNotFound(s)) continue;
+      status.Update(s);
+    }
+    retained_segments.push_back(std::move(segment));
+  }
+  retained_segments_ = std::move(retained_segments);
+  return status;
+}
+
+absl::Status SpillingShuffleBuffer::SaveWindow(const std::string& prefix,
+                                               const std::string& name,
+                                               const Window& window,
+                                               IteratorStateWriter* writer) {
+  TF_RETURN_IF_ERROR(
+      writer->WriteScalar(prefix, absl::StrCat(name, "_", kNumSegments),
+                          static_cast<int64_t>(window.segments.size())));
+  for (int64_t i = 0; i < window.segments.size(); ++i) {
+    TF_RETURN_IF_ERROR(writer->WriteScalar(
+        prefix, absl::StrCat(name, "_", kSegment, "_", i), window.segments[i]));
+  }
+  Tensor index(DT_INT64,
+               TensorShape({static_cast<int64_t>(window.index.size()), 3}));
+  auto index_matrix = index.matrix<int64_t>();
+  for (int64_t i = 0; i < window.index.size(); ++i) {
+    index_matrix(i, 0) = window.index[i].segment;
+    index_matrix(i, 1) = static_cast<int64_t>(window.index[i].offset);
+    index_matrix(i, 2) = static_cast<int64_t>(window.index[i].length);
+  }
+  return writer->WriteTensor(prefix, absl::StrCat(name, "_", kIndex), index);
+}
+
+absl::Status SpillingShuffleBuffer::RestoreWindow(const std::string& prefix,
+                                                  const std::string& name,
+                                                  IteratorStateReader* reader,
+                                                  Window* window) {
+  int64_t num_segments;
+  TF_RETURN_IF_ERROR(reader->ReadScalar(
+      prefix, absl::StrCat(name, "_", kNumSegments), &num_segments));
+  window->segments.clear();
+  for (int64_t i = 0; i < num_segments; ++i) {
+    tstring segment;
+    TF_RETURN_IF_ERROR(reader->ReadScalar(
+        prefix, absl::StrCat(name, "_", kSegment, "_", i), &segment));
+    absl::Status s = env_->FileExists(segment);
+    if (!s.ok()) {
+      return errors::DataLoss(
+          "Shuffle buffer segment ", std::string(segment),
+          " referenced by the checkpoint is not available: ", s.message());
+    }
+    window->segments.push_back(std::string(segment));
+  }
+  Tensor index;
+  TF_RETURN_IF_ERROR(
+      reader->ReadTensor(prefix, absl::StrCat(name, "_", kIndex), &index));
+  if (index.dims() != 2 || index.dim_size(1) != 3) {
+    return errors::DataLoss("Invalid shuffle buffer index shape: ",
+                            index.shape().DebugString());
+  }
+  auto index_matrix = index.matrix<int64_t>();
+  window->index.clear();
+  window->index.reserve(index.dim_size(0));
+  for (int64_t i = 0; i < index.dim_size(0); ++i) {
+    if (index_matrix(i, 0) < 0 || index_matrix(i, 0) >= num_segments) {
+      return errors::DataLoss("Invalid shuffle buffer segment index: ",
+                              index_matrix(i, 0));
+    }
+    window->index.push_back({index_matrix(i, 0),
+                             static_cast<uint64_t>(index_matrix(i, 1)),
+                             static_cast<uint64_t>(index_matrix(i, 2))});
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,163 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SPILLING_SHUFFLE_BUFFER_H_
+#define TENSORFLOW_CORE_DATA_SPILLING_SHUFFLE_BUFFER_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+namespace data {
+
+class IteratorStateReader;
+class IteratorStateWriter;
+
+// A shuffle buffer whose elements live on local disk rather than in memory.
+//
+// Elements are serialized as `CompressedElement` protos and appended to
+// append-only segment files, so the only writes are sequential. In memory the
+// buffer only holds an index of (segment, offset, length) triples, i.e. 24
+// bytes per buffered element regardless of the element size.
+//
+// The buffer is organized in two windows. Elements are appended to the
+// _filling_ window while the elements of the _serving_ window are read back in
+// the order of the `random::index_shuffle` permutation of its index. Once the
+// serving window is exhausted, `StartNextWindow()` deletes its segments and
+// promotes the filling window. With a window size of `n`, resident memory is
+// therefore bounded by the index of at most `2 * n` elements and disk usage
+// by the serialized size of at most `2 * n` elements, plus the segments kept
+// for the last checkpoint.
+//
+// `Save()` records only the index and the permutation state. Segments are
+// flushed and never modified once written, so a saved buffer can be restored
+// as long as the segment files of its two windows are still present. The
+// segments referenced by the last `Save()` (or `Restore()`) are therefore
+// kept, also past the end of their window and the destruction of the buffer,
+// until a later `Save()` no longer references them.
+//
+// This class is not thread-safe.
+class SpillingShuffleBuffer {
+ public:
+  struct Options {
+    // Directory that the segment files are written to.
+    std::string directory;
+    // Prefix of the segment file names. It must be unique among the buffers
+    // sharing `directory`.
+    std::string file_prefix;
+    // A new segment is started once the current one grows beyond this size.
+    int64_t max_segment_bytes = kDefaultMaxSegmentBytes;
+  };
+
+  static constexpr int64_t kDefaultMaxSegmentBytes = 256 << 20;
+
+  SpillingShuffleBuffer(Env* env, Options options);
+  // Deletes the segment files that the last checkpoint does not reference.
+  ~SpillingShuffleBuffer();
+
+  SpillingShuffleBuffer(const SpillingShuffleBuffer&) = delete;
+  SpillingShuffleBuffer& operator=(const SpillingShuffleBuffer&) = delete;
+
+  // Appends `element` to the filling window.
+  absl::Status Append(const std::vector<Tensor>& element);
+
+  // Releases the segments of the serving window and replaces it with the
+  // filling window, whose elements are served in the order of the
+  // permutation defined by `key`. A new, empty filling window is started.
+  absl::Status StartNextWindow(const std::array<uint32_t, 3>& key);
+
+  // Reads the next element of the serving window.
+  //
+  // REQUIRES: `ServingRemaining() > 0`.
+  absl::Status GetNext(std::vector<Tensor>* element);
+
+  // Number of elements of the serving window that have not been read yet.
+  int64_t ServingRemaining() const {
+    return static_cast<int64_t>(serving_.index.size()) - position_;
+  }
+  // Number of elements appended to the filling window.
+  int64_t FillingSize() const {
+    return static_cast<int64_t>(filling_.index.size());
+  }
+
+  absl::Status Save(const std::string& prefix, IteratorStateWriter* writer);
+  absl::Status Restore(const std::string& prefix,
+                       IteratorStateReader* reader);
+
+ private:
+  // The location of a serialized element.
+  struct Entry {
+    int64_t segment;
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  struct Window {
+    // Paths of the segment files, indexed by `Entry::segment`.
+    std::vector<std::string> segments;
+    // Index of the window, in order of arrival.
+    std::vector<Entry> index;
+  };
+
+  // Closes the segment currently being written, if any.
+  absl::Status CloseWriter();
+  // Deletes the `segments` that the last checkpoint does not reference and
+  // retains the others until a later `Save()`.
+  absl::Status ReleaseSegments(const std::vector<std::string>& segments);
+  // Deletes the retained segments that the last checkpoint does not
+  // reference.
+  absl::Status DeleteUnreferencedRetainedSegments();
+  absl::Status SaveWindow(const std::string& prefix, const std::string& name,
+                          const Window& window, IteratorStateWriter* writer);
+  absl::Status RestoreWindow(const std::string& prefix,
+                             const std::string& name,
+                             IteratorStateReader* reader, Window* window);
+
+  Env* const env_;
+  const Options options_;
+
+  Window serving_;
+  Window filling_;
+  // Key of the permutation of `serving_`.
+  std::array<uint32_t, 3> key_ = {0, 0, 0};
+  // Number of elements of `serving_` read so far.
+  int64_t position_ = 0;
+  // Sequence number of the next segment file.
+  int64_t next_segment_id_ = 0;
+  // Segments referenced by the last checkpoint saved or restored.
+  absl::flat_hash_set<std::string> checkpointed_segments_;
+  // Segments that are no longer part of a window but are still referenced by
+  // the last checkpoint.
+  std::vector<std::string> retained_segments_;
+
+  std::unique_ptr<WritableFile> writer_;
+  uint64_t writer_offset_ = 0;
+  // Readers for the segments of `serving_`, opened on first use.
+  absl::flat_hash_map<int64_t, std::unique_ptr<RandomAccessFile>> readers_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SPILLING_SHUFFLE_BUFFER_H_
@@ -0,0 +1,223 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/spilling_shuffle_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr std::array<uint32_t, 3> kKey = {1, 2, 3};
+
+std::string full_name(const std::string& key) {
+  return FullName("Iterator:", key);
+}
+
+class SpillingShuffleBufferTest : public ::testing::Test {
+ protected:
+  SpillingShuffleBufferTest()
+      : directory_(io::JoinPath(
+            ::testing::TempDir(),
+            ::testing::UnitTest::GetInstance()->current_test_info()->name())) {
+    TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(directory_));
+  }
+
+  std::unique_ptr<SpillingShuffleBuffer> MakeBuffer(
+      const std::string& file_prefix,
+      int64_t max_segment_bytes =
+          SpillingShuffleBuffer::kDefaultMaxSegmentBytes) {
+    SpillingShuffleBuffer::Options options;
+    options.directory = directory_;
+    options.file_prefix = file_prefix;
+    options.max_segment_bytes = max_segment_bytes;
+    return std::make_unique<SpillingShuffleBuffer>(Env::Default(), options);
+  }
+
+  int NumFiles() {
+    std::vector<std::string> children;
+    TF_CHECK_OK(Env::Default()->GetChildren(directory_, &children));
+    return children.size();
+  }
+
+  std::string directory_;
+};
+
+std::vector<Tensor> Element(int64_t value) {
+  return {test::AsScalar<int64_t>(value), test::AsTensor<tstring>({"x"})};
+}
+
+std::vector<int64_t> ReadAll(SpillingShuffleBuffer* buffer) {
+  std::vector<int64_t> values;
+  while (buffer->ServingRemaining() > 0) {
+    std::vector<Tensor> element;
+    TF_CHECK_OK(buffer->GetNext(&element));
+    CHECK_EQ(element.size(), 2);
+    values.push_back(element[0].scalar<int64_t>()());
+  }
+  return values;
+}
+
+TEST_F(SpillingShuffleBufferTest, ServesEveryElementOnceInShuffledOrder) {
+  std::unique_ptr<SpillingShuffleBuffer> buffer = MakeBuffer("buffer");
+  constexpr int kNumElements = 100;
+  for (int i = 0; i < kNumElements; ++i) {
+    TF_ASSERT_OK(buffer->Append(Element(i)));
+  }
+  EXPECT_EQ(buffer->FillingSize(), kNumElements);
+  EXPECT_EQ(buffer->ServingRemaining(), 0);
+  TF_ASSERT_OK(buffer->StartNextWindow(kKey));
+  EXPECT_EQ(buffer->FillingSize(), 0);
+  EXPECT_EQ(buffer->ServingRemaining(), kNumElements);
+
+  std::vector<int64_t> values = ReadAll(buffer.get());
+  std::vector<int64_t> sorted = values;
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<int64_t> expected(kNumElements);
+  for (int i = 0; i < kNumElements; ++i) expected[i] = i;
+  EXPECT_EQ(sorted, expected);
+  EXPECT_NE(values, expected);
+
+  std::vector<Tensor> element;
+  EXPECT_TRUE(absl::IsFailedPrecondition(buffer->GetNext(&element)));
+}
+
+TEST_F(SpillingShuffleBufferTest, ExhaustedWindowSegmentsAreDeleted) {
+  std::unique_ptr<SpillingShuffleBuffer> buffer =
+      MakeBuffer("buffer", /*max_segment_bytes=*/1);
+  for (int i = 0; i < 5; ++i) {
+    TF_ASSERT_OK(buffer->Append(Element(i)));
+  }
+  // Every element goes to its own segment.
+  EXPECT_EQ(NumFiles(), 5);
+  TF_ASSERT_OK(buffer->StartNextWindow(kKey));
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(buffer->Append(Element(i)));
+  }
+  EXPECT_EQ(NumFiles(), 8);
+  EXPECT_EQ(ReadAll(buffer.get()).size(), 5);
+  TF_ASSERT_OK(buffer->StartNextWindow(kKey));
+  EXPECT_EQ(NumFiles(), 3);
+  buffer.reset();
+  EXPECT_EQ(NumFiles(), 0);
+}
+
+TEST_F(SpillingShuffleBufferTest, SaveAndRestore) {
+  std::unique_ptr<SpillingShuffleBuffer> buffer = MakeBuffer("original");
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(buffer->Append(Element(i)));
+  }
+  TF_ASSERT_OK(buffer->StartNextWindow(kKey));
+  for (int i = 0; i < 3; ++i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(buffer->GetNext(&element));
+  }
+  for (int i = 10; i < 15; ++i) {
+    TF_ASSERT_OK(buffer->Append(Element(i)));
+  }
+
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(buffer->Save(full_name("buffer"), &writer));
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  std::unique_ptr<SpillingShuffleBuffer> restored = MakeBuffer("restored");
+  TF_ASSERT_OK(restored->Restore(full_name("buffer"), &reader));
+
+  EXPECT_EQ(restored->ServingRemaining(), 7);
+  EXPECT_EQ(restored->FillingSize(), 5);
+  // Elements appended after the checkpoint go to a new segment.
+  TF_ASSERT_OK(buffer->Append(Element(15)));
+  TF_ASSERT_OK(restored->Append(Element(15)));
+
+  EXPECT_EQ(ReadAll(restored.get()), ReadAll(buffer.get()));
+  TF_ASSERT_OK(buffer->StartNextWindow(kKey));
+  TF_ASSERT_OK(restored->StartNextWindow(kKey));
+  EXPECT_EQ(ReadAll(restored.get()), ReadAll(buffer.get()));
+}
+
+TEST_F(SpillingShuffleBufferTest, RestoreFailsWithoutSegments) {
+  std::unique_ptr<SpillingShuffleBuffer> buffer = MakeBuffer("original");
+  TF_ASSERT_OK(buffer->Append(Element(0)));
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(buffer->Save(full_name("buffer"), &writer));
+  buffer.reset();
+  TF_ASSERT_OK(
+      Env::Default()->DeleteFile(io::JoinPath(directory_, "original_0")));
+
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  std::unique_ptr<SpillingShuffleBuffer> restored = MakeBuffer("restored");
+  EXPECT_TRUE(
+      absl::IsDataLoss(restored->Restore(full_name("buffer"), &reader)));
+}
+
+TEST_F(SpillingShuffleBufferTest, KeepsSegmentsOfLastCheckpoint) {
+  std::unique_ptr<SpillingShuffleBuffer> buffer =
+      MakeBuffer("buffer", /*max_segment_bytes=*/1);
+  for (int i = 0; i < 2; ++i) {
+    TF_ASSERT_OK(buffer->Append(Element(i)));
+  }
+  TF_ASSERT_OK(buffer->StartNextWindow(kKey));
+  TF_ASSERT_OK(buffer->Append(Element(2)));
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(buffer->Save(full_name("buffer"), &writer));
+
+  // The serving window of the checkpoint is kept past its end.
+  EXPECT_EQ(ReadAll(buffer.get()).size(), 2);
+  TF_ASSERT_OK(buffer->StartNextWindow(kKey));
+  TF_ASSERT_OK(buffer->Append(Element(3)));
+  EXPECT_EQ(NumFiles(), 4);
+
+  {
+    std::vector<const VariantTensorData*> data;
+    writer.GetData(&data);
+    VariantTensorDataReader reader(data);
+    std::unique_ptr<SpillingShuffleBuffer> restored = MakeBuffer("restored");
+    TF_ASSERT_OK(restored->Restore(full_name("buffer"), &reader));
+    EXPECT_EQ(ReadAll(restored.get()).size(), 2);
+  }
+
+  // A newer checkpoint supersedes the old one, whose serving window is gone.
+  VariantTensorDataWriter newer_writer;
+  TF_ASSERT_OK(buffer->Save(full_name("buffer"), &newer_writer));
+  EXPECT_EQ(NumFiles(), 2);
+
+  // Only the segments of the last checkpoint outlive the buffer.
+  EXPECT_EQ(ReadAll(buffer.get()).size(), 1);
+  TF_ASSERT_OK(buffer->StartNextWindow(kKey));
+  buffer.reset();
+  EXPECT_EQ(NumFiles(), 2);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/time/time.h"
@@ -138,6 +139,28 @@ std::shared_ptr<model::Model> TfDatazMetricsCollector::GetModel() {
   return model_;
 }
 
+std::vector<TfDatazMetricsCollector::TransformationLatency>
+TfDatazMetricsCollector::GetTransformationLatencies() {
+  std::vector<TransformationLatency> latencies;
+  if (model_ == nullptr) {
+    return latencies;
+  }
+  std::shared_ptr<model::Node> root = model_->output();
+  if (root == nullptr) {
+    return latencies;
+  }
+  model::Node::NodeVector nodes = root->CollectNodes(
+      model::TraversalOrder::BFS,
+      [](const std::shared_ptr<model::Node>) { return true; });
+  nodes.insert(nodes.begin(), root);
+  latencies.reserve(nodes.size());
+  for (const std::shared_ptr<model::Node>& node : nodes) {
+    latencies.push_back(TransformationLatency{
+        node->id(), node->name(), node->get_next_latency_histogram()});
+  }
+  return latencies;
+}
+
 namespace {
 static mutex* get_tfdataz_metrics_registry_lock() {
   static mutex tfdataz_metrics_registry_lock(LINKER_INITIALIZED);
@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/time/time.h"
@@ -91,6 +92,16 @@ class ApproximateLatencyEstimator {
 // Collects and exports the tf.data performance metrics to /tfdataz.
 class TfDatazMetricsCollector {
  public:
+  // The `GetNext` latency histogram of one iterator of the input pipeline.
+  struct TransformationLatency {
+    // The ID and name of the `model::Node` of the iterator.
+    int64_t id;
+    std::string name;
+    // The number of `GetNext` calls in each bucket, as described for
+    // `model::kNumLatencyBuckets`.
+    std::vector<int64_t> bucket_counts;
+  };
+
   // Constructs a `TfDatazMetricsCollector`.
   // We only collect metrics for CPU devices. This is a heuristic to avoid
   // collecting metrics for device-side iterators created by the multi-device
@@ -120,6 +131,12 @@ class TfDatazMetricsCollector {
 
   std::shared_ptr<model::Model> GetModel();
 
+  // Returns the `GetNext` latency histograms of the iterators of the input
+  // pipeline in breadth-first order, starting with the root. The histograms
+  // are only recorded when the iterators are modeled, i.e. when autotuning is
+  // enabled.
+  std::vector<TransformationLatency> GetTransformationLatencies();
+
  private:
   DatasetBaseIterator* iterator_;  // not owned
   std::shared_ptr<model::Model> model_;
@@ -16,9 +16,11 @@ limitations under the License.
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/time/time.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/util/fake_clock_env.h"
@@ -197,6 +199,35 @@ class ScopedTfDataMetricsRegistration {
   std::shared_ptr<TfDatazMetricsCollector> collector_;
 };
 
+TEST(TfDatazMetricsCollectorTest, GetTransformationLatencies) {
+  auto model = std::make_shared<model::Model>();
+  std::shared_ptr<model::Node> root;
+  model->AddNode(model::MakeUnknownNode, "root", /*parent=*/nullptr, &root);
+  std::shared_ptr<model::Node> source;
+  model->AddNode(model::MakeSourceNode, "source", root, &source);
+  root->record_get_next_latency(/*latency_nanos=*/3000);
+  source->record_get_next_latency(/*latency_nanos=*/500);
+  source->record_get_next_latency(/*latency_nanos=*/700);
+
+  std::unique_ptr<DatasetBaseIterator> iterator;
+  TfDatazMetricsCollector collector(*Env::Default(), iterator.get(), model);
+  std::vector<TfDatazMetricsCollector::TransformationLatency> latencies =
+      collector.GetTransformationLatencies();
+  ASSERT_EQ(latencies.size(), 2);
+  EXPECT_EQ(latencies[0].name, "root");
+  EXPECT_EQ(latencies[0].id, root->id());
+  EXPECT_EQ(latencies[0].bucket_counts[2], 1);
+  EXPECT_EQ(latencies[1].name, "source");
+  EXPECT_EQ(latencies[1].bucket_counts[0], 2);
+}
+
+TEST(TfDatazMetricsCollectorTest, GetTransformationLatenciesWithoutModel) {
+  std::unique_ptr<DatasetBaseIterator> iterator;
+  TfDatazMetricsCollector collector(*Env::Default(), iterator.get(),
+                                    /*model=*/nullptr);
+  EXPECT_TRUE(collector.GetTransformationLatencies().empty());
+}
+
 TEST(TfDatazMetricsRegistryTest, Register) {
   std::unique_ptr<DatasetBaseIterator> iterator;
   auto collector_one = std::make_shared<TfDatazMetricsCollector>(
@@ -0,0 +1,172 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/eager/remote_enqueue_batcher.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace eager {
+
+RemoteEnqueueBatcher::RemoteEnqueueBatcher(SendFn send, int64_t max_batch_size,
+                                           int64_t flush_window_us, Env* env)
+    : send_(std::move(send)),
+      max_batch_size_(std::max<int64_t>(max_batch_size, 1)),
+      flush_window_us_(std::max<int64_t>(flush_window_us, 0)),
+      env_(env) {}
+
+int64_t RemoteEnqueueBatcher::MaxBatchSizeFromEnv() {
+  static const int64_t max_batch_size = []() {
+    int64_t result;
+    TF_CHECK_OK(
+        ReadInt64FromEnvVar("TF_EAGER_REMOTE_ENQUEUE_BATCH_SIZE", 1, &result));
+    return result;
+  }();
+  return max_batch_size;
+}
+
+int64_t RemoteEnqueueBatcher::FlushWindowFromEnv() {
+  static const int64_t flush_window_us = []() {
+    int64_t result;
+    TF_CHECK_OK(ReadInt64FromEnvVar(
+        "TF_EAGER_REMOTE_ENQUEUE_FLUSH_WINDOW_USECS", 100, &result));
+    return result;
+  }();
+  return flush_window_us;
+}
+
+void RemoteEnqueueBatcher::Enqueue(const EnqueueRequest& request,
+                                   EnqueueResponse* response,
+                                   StatusCallback done) {
+  bool schedule_flush = false;
+  int64_t batch_id = 0;
+  {
+    mutex_lock l(mu_);
+    if (current_ != nullptr &&
+        current_->request.context_id() != request.context_id()) {
+      CloseBatchLocked();
+    }
+    if (current_ == nullptr) {
+      current_ = std::make_unique<Batch>();
+      current_->id = next_batch_id_++;
+      current_->request.set_context_id(request.context_id());
+      schedule_flush = true;
+      batch_id = current_->id;
+    }
+    PendingRequest pending;
+    pending.response = response;
+    pending.done = std::move(done);
+    pending.first_item = current_->request.queue_size();
+    pending.num_items = request.queue_size();
+    current_->request.mutable_queue()->MergeFrom(request.queue());
+    current_->pending.push_back(std::move(pending));
+    if (current_->request.queue_size() >= max_batch_size_) {
+      CloseBatchLocked();
+      schedule_flush = false;
+    }
+  }
+  if (schedule_flush && flush_window_us_ > 0) {
+    std::weak_ptr<RemoteEnqueueBatcher> weak_this = weak_from_this();
+    env_->SchedClosureAfter(flush_window_us_, [weak_this, batch_id]() {
+      if (auto batcher = weak_this.lock()) batcher->FlushBatch(batch_id);
+    });
+  } else if (schedule_flush) {
+    Flush();
+    return;
+  }
+  SendReadyBatches();
+}
+
+void RemoteEnqueueBatcher::Flush() {
+  {
+    mutex_lock l(mu_);
+    CloseBatchLocked();
+  }
+  SendReadyBatches();
+}
+
+void RemoteEnqueueBatcher::FlushBatch(int64_t batch_id) {
+  {
+    mutex_lock l(mu_);
+    // The batch the timer was armed for has already been sent; a later batch
+    // has its own timer.
+    if (current_ == nullptr || current_->id != batch_id) return;
+    CloseBatchLocked();
+  }
+  SendReadyBatches();
+}
+
+void RemoteEnqueueBatcher::CloseBatchLocked() {
+  if (current_ == nullptr) return;
+  ready_.push_back(std::move(current_));
+}
+
+void RemoteEnqueueBatcher::SendReadyBatches() {
+  std::unique_ptr<Batch> batch;
+  {
+    mutex_lock l(mu_);
+    // The thread that is already sending will pick up the new batches, in
+    // order. This also covers a `done` callback that enqueues more requests
+    // while a batch is being sent.
+    if (sending_ || ready_.empty()) return;
+    sending_ = true;
+    batch = std::move(ready_.front());
+    ready_.pop_front();
+  }
+  while (batch != nullptr) {
+    SendBatch(std::move(batch));
+    mutex_lock l(mu_);
+    if (ready_.empty()) {
+      sending_ = false;
+      return;
+    }
+    batch = std::move(ready_.front());
+    ready_.pop_front();
+  }
+}
+
+void RemoteEnqueueBatcher::SendBatch(std::unique_ptr<Batch> batch) {
+  VLOG(3) << "Sending batched EnqueueRequest with "
+          << batch->request.queue_size() << " items for "
+          << batch->pending.size() << " requests";
+  if (batch->pending.size() == 1) {
+    // Nothing to split, so send the caller's response directly.
+    PendingRequest& pending = batch->pending.front();
+    send_(&batch->request, pending.response, std::move(pending.done));
+    return;
+  }
+  auto response = std::make_shared<EnqueueResponse>();
+  auto pending = std::make_shared<std::vector<PendingRequest>>(
+      std::move(batch->pending));
+  send_(&batch->request, response.get(),
+        [response, pending](const Status& status) {
+          for (PendingRequest& p : *pending) {
+            const int end = std::min(p.first_item + p.num_items,
+                                     response->queue_response_size());
+            for (int i = p.first_item; i < end; ++i) {
+              p.response->add_queue_response()->Swap(
+                  response->mutable_queue_response(i));
+            }
+            p.done(status);
+          }
+        });
+}
+
+}  // namespace eager
+}  // namespace tensorflow
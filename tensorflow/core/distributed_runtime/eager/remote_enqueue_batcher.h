@@ -0,0 +1,117 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_REMOTE_ENQUEUE_BATCHER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_REMOTE_ENQUEUE_BATCHER_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/eager_service.pb.h"
+
+namespace tensorflow {
+namespace eager {
+
+// RemoteEnqueueBatcher coalesces consecutive EnqueueRequests sent to one
+// remote eager context into a single EnqueueRequest, so that a burst of small
+// remote ops pays for one round trip instead of one per op.
+//
+// A batch is sent once it holds `max_batch_size` queue items, or
+// `flush_window_us` microseconds after its first request was added, whichever
+// comes first. The server handles the items of a request in order and returns
+// one QueueResponse per item, so each caller's response is carved out of the
+// batch response. The status of the batch is reported to every request in it.
+// Batches are sent in the order in which they were filled, which preserves the
+// order of the requests.
+//
+// Instances must be owned by a `std::shared_ptr`, since pending flushes only
+// hold a weak reference to the batcher.
+//
+// This class is thread-safe.
+class RemoteEnqueueBatcher
+    : public std::enable_shared_from_this<RemoteEnqueueBatcher> {
+ public:
+  // Sends `request`, and invokes `done` once `response` is filled. `request`
+  // may be deleted as soon as the function returns.
+  using SendFn = std::function<void(const EnqueueRequest* request,
+                                    EnqueueResponse* response,
+                                    StatusCallback done)>;
+
+  RemoteEnqueueBatcher(SendFn send, int64_t max_batch_size,
+                       int64_t flush_window_us, Env* env = Env::Default());
+
+  RemoteEnqueueBatcher(const RemoteEnqueueBatcher&) = delete;
+  void operator=(const RemoteEnqueueBatcher&) = delete;
+
+  // Adds the queue items of `request` to the current batch. `response` must
+  // stay alive until `done` is called.
+  void Enqueue(const EnqueueRequest& request, EnqueueResponse* response,
+               StatusCallback done);
+
+  // Sends the current batch, if any, without waiting for it to fill up.
+  void Flush();
+
+  // Reads the maximum batch size from TF_EAGER_REMOTE_ENQUEUE_BATCH_SIZE
+  // (default 1, which disables batching).
+  static int64_t MaxBatchSizeFromEnv();
+  // Reads the flush window from TF_EAGER_REMOTE_ENQUEUE_FLUSH_WINDOW_USECS
+  // (default 100).
+  static int64_t FlushWindowFromEnv();
+
+ private:
+  struct PendingRequest {
+    EnqueueResponse* response;
+    StatusCallback done;
+    int first_item;
+    int num_items;
+  };
+
+  struct Batch {
+    int64_t id;
+    EnqueueRequest request;
+    std::vector<PendingRequest> pending;
+  };
+
+  // Sends the current batch if it is the batch `batch_id`. Called when the
+  // flush window of that batch expires.
+  void FlushBatch(int64_t batch_id) TF_LOCKS_EXCLUDED(mu_);
+  // Moves the current batch to `ready_`.
+  void CloseBatchLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Sends the batches in `ready_` unless another thread is sending already.
+  void SendReadyBatches() TF_LOCKS_EXCLUDED(mu_);
+  void SendBatch(std::unique_ptr<Batch> batch);
+
+  const SendFn send_;
+  const int64_t max_batch_size_;
+  const int64_t flush_window_us_;
+  Env* const env_;
+
+  mutex mu_;
+  std::unique_ptr<Batch> current_ TF_GUARDED_BY(mu_);
+  int64_t next_batch_id_ TF_GUARDED_BY(mu_) = 0;
+  std::deque<std::unique_ptr<Batch>> ready_ TF_GUARDED_BY(mu_);
+  bool sending_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace eager
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_REMOTE_ENQUEUE_BATCHER_H_
@@ -0,0 +1,208 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/eager/remote_enqueue_batcher.h"
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+// Records the requests it is asked to send, and answers each queue item with a
+// QueueResponse whose shape has the item's operation id as its only dimension.
+class FakeTransport {
+ public:
+  void Send(const EnqueueRequest* request, EnqueueResponse* response,
+            StatusCallback done) {
+    {
+      mutex_lock l(mu_);
+      sent_.push_back(*request);
+    }
+    for (const QueueItem& item : request->queue()) {
+      response->add_queue_response()->add_shape()->add_dim()->set_size(
+          item.operation().id());
+    }
+    done(status_);
+  }
+
+  std::vector<EnqueueRequest> sent() {
+    mutex_lock l(mu_);
+    return sent_;
+  }
+
+  void set_status(Status status) { status_ = status; }
+
+ private:
+  mutex mu_;
+  std::vector<EnqueueRequest> sent_ TF_GUARDED_BY(mu_);
+  Status status_;
+};
+
+// Holds the closures scheduled with SchedClosureAfter until the test runs
+// them.
+class ManualTimerEnv : public EnvWrapper {
+ public:
+  ManualTimerEnv() : EnvWrapper(Env::Default()) {}
+
+  void SchedClosureAfter(int64_t micros,
+                         absl::AnyInvocable<void()> closure) override {
+    timers_.push_back(std::move(closure));
+  }
+
+  // Runs the `i`-th scheduled closure.
+  void RunTimer(int i) { timers_[i](); }
+  int num_timers() const { return timers_.size(); }
+
+ private:
+  std::vector<absl::AnyInvocable<void()>> timers_;
+};
+
+EnqueueRequest OpRequest(int64_t op_id) {
+  EnqueueRequest request;
+  request.set_context_id(7);
+  request.add_queue()->mutable_operation()->set_id(op_id);
+  return request;
+}
+
+std::shared_ptr<RemoteEnqueueBatcher> NewBatcher(FakeTransport* transport,
+                                                 int64_t max_batch_size,
+                                                 int64_t flush_window_us,
+                                                 Env* env = Env::Default()) {
+  return std::make_shared<RemoteEnqueueBatcher>(
+      [transport](const EnqueueRequest* request, EnqueueResponse* response,
+                  StatusCallback done) {
+        transport->Send(request, response, std::move(done));
+      },
+      max_batch_size, flush_window_us, env);
+}
+
+TEST(RemoteEnqueueBatcherTest, FullBatchIsSentAsOneRequest) {
+  FakeTransport transport;
+  // A long flush window, so that only a full batch triggers a send.
+  auto batcher = NewBatcher(&transport, /*max_batch_size=*/3,
+                            /*flush_window_us=*/60 * 1000 * 1000);
+  std::vector<EnqueueResponse> responses(3);
+  std::vector<Status> statuses(3, errors::Unknown("not done"));
+  for (int i = 0; i < 3; ++i) {
+    batcher->Enqueue(OpRequest(i), &responses[i],
+                     [&statuses, i](const Status& s) { statuses[i] = s; });
+    EXPECT_EQ(transport.sent().size(), i < 2 ? 0u : 1u);
+  }
+
+  std::vector<EnqueueRequest> sent = transport.sent();
+  ASSERT_EQ(sent.size(), 1);
+  EXPECT_EQ(sent[0].context_id(), 7);
+  ASSERT_EQ(sent[0].queue_size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(sent[0].queue(i).operation().id(), i);
+    TF_EXPECT_OK(statuses[i]);
+    // Each caller gets the response for its own item.
+    ASSERT_EQ(responses[i].queue_response_size(), 1);
+    EXPECT_EQ(responses[i].queue_response(0).shape(0).dim(0).size(), i);
+  }
+}
+
+TEST(RemoteEnqueueBatcherTest, FlushWindowSendsPartialBatch) {
+  FakeTransport transport;
+  auto batcher = NewBatcher(&transport, /*max_batch_size=*/100,
+                            /*flush_window_us=*/1000);
+  std::vector<EnqueueResponse> responses(2);
+  Notification done;
+  batcher->Enqueue(OpRequest(0), &responses[0], [](const Status& s) {});
+  batcher->Enqueue(OpRequest(1), &responses[1],
+                   [&done](const Status& s) { done.Notify(); });
+  done.WaitForNotification();
+  std::vector<EnqueueRequest> sent = transport.sent();
+  ASSERT_EQ(sent.size(), 1);
+  EXPECT_EQ(sent[0].queue_size(), 2);
+  EXPECT_EQ(responses[1].queue_response(0).shape(0).dim(0).size(), 1);
+}
+
+TEST(RemoteEnqueueBatcherTest, ExplicitFlushAndErrors) {
+  FakeTransport transport;
+  transport.set_status(errors::Internal("remote failure"));
+  auto batcher = NewBatcher(&transport, /*max_batch_size=*/100,
+                            /*flush_window_us=*/60 * 1000 * 1000);
+  EnqueueResponse response0, response1;
+  Status status0, status1;
+  batcher->Enqueue(OpRequest(0), &response0,
+                   [&status0](const Status& s) { status0 = s; });
+  batcher->Enqueue(OpRequest(1), &response1,
+                   [&status1](const Status& s) { status1 = s; });
+  EXPECT_TRUE(transport.sent().empty());
+  batcher->Flush();
+  EXPECT_EQ(transport.sent().size(), 1);
+  // The status of the batch is reported to every request in it.
+  EXPECT_EQ(status0.code(), error::INTERNAL);
+  EXPECT_EQ(status1.code(), error::INTERNAL);
+
+  // Flushing an empty batch sends nothing.
+  batcher->Flush();
+  EXPECT_EQ(transport.sent().size(), 1);
+}
+
+TEST(RemoteEnqueueBatcherTest, StaleFlushTimerDoesNotCutLaterBatch) {
+  FakeTransport transport;
+  ManualTimerEnv env;
+  auto batcher = NewBatcher(&transport, /*max_batch_size=*/100,
+                            /*flush_window_us=*/1000, &env);
+  EnqueueResponse response0, response1, response2;
+  batcher->Enqueue(OpRequest(0), &response0, [](const Status& s) {});
+  batcher->Flush();
+  ASSERT_EQ(transport.sent().size(), 1);
+
+  batcher->Enqueue(OpRequest(1), &response1, [](const Status& s) {});
+  ASSERT_EQ(env.num_timers(), 2);
+  // The timer armed for the first batch fires after that batch was sent, and
+  // must leave the second batch to fill up during its own window.
+  env.RunTimer(0);
+  EXPECT_EQ(transport.sent().size(), 1);
+  batcher->Enqueue(OpRequest(2), &response2, [](const Status& s) {});
+
+  env.RunTimer(1);
+  std::vector<EnqueueRequest> sent = transport.sent();
+  ASSERT_EQ(sent.size(), 2);
+  EXPECT_EQ(sent[1].queue_size(), 2);
+}
+
+TEST(RemoteEnqueueBatcherTest, RequestsEnqueuedFromCallbacksKeepOrder) {
+  FakeTransport transport;
+  std::shared_ptr<RemoteEnqueueBatcher> batcher =
+      NewBatcher(&transport, /*max_batch_size=*/1, /*flush_window_us=*/0);
+  EnqueueResponse response0, response1;
+  batcher->Enqueue(OpRequest(0), &response0,
+                   [&batcher, &response1](const Status& s) {
+                     batcher->Enqueue(OpRequest(1), &response1,
+                                      [](const Status& s) {});
+                   });
+  std::vector<EnqueueRequest> sent = transport.sent();
+  ASSERT_EQ(sent.size(), 2);
+  EXPECT_EQ(sent[0].queue(0).operation().id(), 0);
+  EXPECT_EQ(sent[1].queue(0).operation().id(), 1);
+}
+
+}  // namespace
+}  // namespace eager
+}  // namespace tensorflow
@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/rendezvous_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/message_wrappers.h"
+#include "tensorflow/core/distributed_runtime/partition_graph_cache.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -53,6 +54,8 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
@@ -138,18 +141,51 @@ Status GraphMgr::DecorateAndPublishGraphForDebug(
 //
 // "executors" are filled with one executor per device if success and
 // the caller takes the ownership of returned executors.
+string GraphMgr::PartitionsCacheKey(const string& graph_fingerprint,
+                                    const GraphOptions& graph_options,
+                                    const ConfigProto& config_proto) const {
+  // The passes below depend on the options and on the devices, including the
+  // incarnations that partitioning bakes into _Send and _Recv nodes.
+  string serialized;
+  string key = graph_fingerprint;
+  SerializeToStringDeterministic(graph_options, &serialized);
+  strings::StrAppend(&key, ":", Fingerprint64(serialized));
+  SerializeToStringDeterministic(config_proto, &serialized);
+  strings::StrAppend(&key, ":", Fingerprint64(serialized));
+  string devices;
+  for (const Device* device : device_mgr_->ListDevices()) {
+    strings::StrAppend(&devices, device->name(), "#",
+                       device->attributes().incarnation(), ";");
+  }
+  strings::StrAppend(&key, ":", Fingerprint64(devices));
+  return key;
+}
+
 Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
                           const GraphOptions& graph_options,
                           const DebugOptions& debug_options,
                           const ConfigProto& config_proto,
                           int64_t collective_graph_key, WorkerSession* session,
                           DistributedFunctionLibraryRuntime* cluster_flr,
-                          Item* item) {
+                          const string& graph_fingerprint, Item* item) {
   item->session = handle;
   item->session_config = config_proto;
   item->collective_graph_key = collective_graph_key;
+
+  // Graphs instrumented by tfdbg are published per registration, so they are
+  // never cached.
+  PartitionGraphCache* cache = worker_env_->partition_graph_cache;
+  string cache_key;
+  std::shared_ptr<const PartitionGraphCache::Partitions> cached;
+  if (cache != nullptr && !graph_fingerprint.empty() &&
+      debug_options.debug_tensor_watch_opts().empty()) {
+    cache_key = PartitionsCacheKey(graph_fingerprint, graph_options,
+                                   config_proto);
+    cached = cache->LookupPartitions(cache_key);
+  }
   item->lib_def = std::make_unique<FunctionLibraryDefinition>(
-      OpRegistry::Global(), gdef.library());
+      OpRegistry::Global(),
+      cached != nullptr ? cached->library : gdef.library());
 
   TF_RETURN_IF_ERROR(ValidateGraphDefForDevices(gdef));
 
@@ -170,60 +206,31 @@ Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
             return absl::OkStatus();
           }});
 
-  // Constructs the graph out of "gdef".
-  Graph graph(OpRegistry::Global());
-  GraphConstructorOptions opts;
-  opts.allow_internal_ops = true;
-  opts.expect_device_spec = true;
-  opts.validate_nodes = true;
-  TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, gdef, &graph));
-
-  // Splits "graph" into multiple subgraphs by device names.
-  std::unordered_map<string, GraphDef> partitions;
-  PartitionOptions popts;
-  popts.node_to_loc = SplitByDevice;
-  popts.new_name = [this](const string& prefix) {
-    mutex_lock l(mu_);
-    return strings::StrCat(prefix, "_G", next_id_++);
-  };
-  popts.get_incarnation = [this](const string& name) -> int64 {
-    Device* device = nullptr;
-    Status s = device_mgr_->LookupDevice(name, &device);
-    if (s.ok()) {
-      return device->attributes().incarnation();
-    } else {
-      return PartitionOptions::kIllegalIncarnation;
+  std::unordered_map<string, std::unique_ptr<Graph>> partition_graphs;
+  if (cached != nullptr) {
+    for (const auto& device_graph : cached->device_graphs) {
+      std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+      GraphConstructorOptions device_opts;
+      device_opts.allow_internal_ops = true;
+      device_opts.expect_device_spec = true;
+      TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(
+          device_opts, device_graph.second, graph.get()));
+      partition_graphs.emplace(device_graph.first, std::move(graph));
     }
-  };
-  popts.flib_def = item->lib_def.get();
-  popts.control_flow_added = true;
-  popts.scheduling_for_recvs = graph_options.enable_recv_scheduling();
-  TF_RETURN_IF_ERROR(Partition(popts, &graph, &partitions));
-  if (popts.scheduling_for_recvs) {
-    TF_RETURN_IF_ERROR(AddControlEdges(popts, &partitions));
+  } else {
+    TF_RETURN_IF_ERROR(PartitionAndOptimizeGraph(
+        gdef, graph_options, graph_fingerprint, item, &partition_graphs));
   }
-
-  std::unordered_map<string, std::unique_ptr<Graph>> partition_graphs;
-  for (auto& partition : partitions) {
-    std::unique_ptr<Graph> device_graph(new Graph(OpRegistry::Global()));
-    GraphConstructorOptions device_opts;
-    // There are internal operations (e.g., send/recv) that we now allow.
-    device_opts.allow_internal_ops = true;
-    device_opts.expect_device_spec = true;
-    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(
-        device_opts, std::move(partition.second), device_graph.get()));
-    partition_graphs.emplace(partition.first, std::move(device_graph));
+  // Partitions are only added to the cache once every device graph has been
+  // rewritten and optimized below.
+  std::shared_ptr<PartitionGraphCache::Partitions> to_cache;
+  if (cached == nullptr && !cache_key.empty()) {
+    to_cache = std::make_shared<PartitionGraphCache::Partitions>();
   }
 
-  GraphOptimizationPassOptions optimization_options;
-  optimization_options.flib_def = item->lib_def.get();
-  optimization_options.partition_graphs = &partition_graphs;
-  TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
-      OptimizationPassRegistry::POST_PARTITIONING, optimization_options));
-
   LocalExecutorParams params;
 
-  item->units.reserve(partitions.size());
+  item->units.reserve(partition_graphs.size());
   item->graph_mgr = this;
   const auto& optimizer_opts = graph_options.optimizer_options();
   GraphOptimizer optimizer(optimizer_opts);
@@ -243,7 +250,9 @@ Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
     }
 
     // Give the device an opportunity to rewrite its subgraph.
-    TF_RETURN_IF_ERROR(unit->device->MaybeRewriteGraph(&subgraph));
+    if (cached == nullptr) {
+      TF_RETURN_IF_ERROR(unit->device->MaybeRewriteGraph(&subgraph));
+    }
 
     // Top-level nodes in the graph uses the op segment to cache
     // kernels. Therefore, as long as the executor is alive, we need
@@ -286,18 +295,23 @@ Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
       }
     };
 
-    optimizer.Optimize(lib, worker_env_->env, params.device, &subgraph,
-                       GraphOptimizer::Options());
+    if (cached == nullptr) {
+      optimizer.Optimize(lib, worker_env_->env, params.device, &subgraph,
+                         GraphOptimizer::Options());
 
-    // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
-    if (!debug_options.debug_tensor_watch_opts().empty()) {
-      TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
-          debug_options, subgraph.get(), params.device));
-    }
+      // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
+      if (!debug_options.debug_tensor_watch_opts().empty()) {
+        TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
+            debug_options, subgraph.get(), params.device));
+      }
 
-    TF_RETURN_IF_ERROR(
-        EnsureMemoryTypes(DeviceType(unit->device->device_type()),
-                          unit->device->name(), subgraph.get()));
+      TF_RETURN_IF_ERROR(
+          EnsureMemoryTypes(DeviceType(unit->device->device_type()),
+                            unit->device->name(), subgraph.get()));
+      if (to_cache != nullptr) {
+        subgraph->ToGraphDef(&to_cache->device_graphs[device_name]);
+      }
+    }
     unit->graph = std::move(subgraph);
     unit->build_cost_model = graph_options.build_cost_model();
     if (unit->build_cost_model > 0) {
@@ -305,6 +319,77 @@ Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
     }
     TF_RETURN_IF_ERROR(NewLocalExecutor(params, *unit->graph, &unit->root));
   }
+  if (to_cache != nullptr) {
+    // The passes above may have added functions to the library.
+    to_cache->library = item->lib_def->ToProto();
+    cache->InsertPartitions(cache_key, std::move(to_cache));
+  }
+  return absl::OkStatus();
+}
+
+Status GraphMgr::PartitionAndOptimizeGraph(
+    const GraphDef& gdef, const GraphOptions& graph_options,
+    const string& graph_fingerprint, Item* item,
+    std::unordered_map<string, std::unique_ptr<Graph>>* partition_graphs) {
+  // Constructs the graph out of "gdef".
+  Graph graph(OpRegistry::Global());
+  GraphConstructorOptions opts;
+  opts.allow_internal_ops = true;
+  opts.expect_device_spec = true;
+  opts.validate_nodes = true;
+  TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, gdef, &graph));
+
+  // Splits "graph" into multiple subgraphs by device names.
+  std::unordered_map<string, GraphDef> partitions;
+  PartitionOptions popts;
+  popts.node_to_loc = SplitByDevice;
+  // Names of the nodes added by partitioning must be the same whenever a
+  // cacheable graph is partitioned, yet differ between graphs, because
+  // stateful kernels are shared by node name within a session.
+  int64_t next_cacheable_id = 0;
+  popts.new_name = [this, &graph_fingerprint,
+                    &next_cacheable_id](const string& prefix) {
+    if (!graph_fingerprint.empty()) {
+      return strings::StrCat(prefix, "_G", graph_fingerprint.substr(0, 16), "_",
+                             next_cacheable_id++);
+    }
+    mutex_lock l(mu_);
+    return strings::StrCat(prefix, "_G", next_id_++);
+  };
+  popts.get_incarnation = [this](const string& name) -> int64 {
+    Device* device = nullptr;
+    Status s = device_mgr_->LookupDevice(name, &device);
+    if (s.ok()) {
+      return device->attributes().incarnation();
+    } else {
+      return PartitionOptions::kIllegalIncarnation;
+    }
+  };
+  popts.flib_def = item->lib_def.get();
+  popts.control_flow_added = true;
+  popts.scheduling_for_recvs = graph_options.enable_recv_scheduling();
+  TF_RETURN_IF_ERROR(Partition(popts, &graph, &partitions));
+  if (popts.scheduling_for_recvs) {
+    TF_RETURN_IF_ERROR(AddControlEdges(popts, &partitions));
+  }
+
+  for (auto& partition : partitions) {
+    std::unique_ptr<Graph> device_graph(new Graph(OpRegistry::Global()));
+    GraphConstructorOptions device_opts;
+    // There are internal operations (e.g., send/recv) that we now allow.
+    device_opts.allow_internal_ops = true;
+    device_opts.expect_device_spec = true;
+    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(
+        device_opts, std::move(partition.second), device_graph.get()));
+    partition_graphs->emplace(partition.first, std::move(device_graph));
+  }
+
+  GraphOptimizationPassOptions optimization_options;
+  optimization_options.flib_def = item->lib_def.get();
+  optimization_options.partition_graphs = partition_graphs;
+  TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
+      OptimizationPassRegistry::POST_PARTITIONING, optimization_options));
+
   return absl::OkStatus();
 }
 
@@ -314,10 +399,12 @@ Status GraphMgr::Register(const string& handle, const GraphDef& gdef,
                           const ConfigProto& config_proto,
                           int64_t collective_graph_key, WorkerSession* session,
                           DistributedFunctionLibraryRuntime* cluster_flr,
+                          const string& graph_fingerprint,
                           string* graph_handle) {
   Item* item = new Item;
   Status s = InitItem(handle, gdef, graph_options, debug_options, config_proto,
-                      collective_graph_key, session, cluster_flr, item);
+                      collective_graph_key, session, cluster_flr,
+                      graph_fingerprint, item);
   if (!s.ok()) {
     item->Unref();
     return s;
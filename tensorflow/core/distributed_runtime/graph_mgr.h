@@ -80,13 +80,19 @@ class GraphMgr {
 
   // Registers a graph. Fills in "handle". The registered graph retains a
   // reference to cluster_flr to do cross process function calls.
+  //
+  // If "graph_fingerprint" is not empty it must be the fingerprint of "gdef"
+  // (see `PartitionGraphCache::Fingerprint()`). The device partitions derived
+  // from "gdef" are then looked up in, or added to,
+  // `WorkerEnv::partition_graph_cache`, so that registering the same graph
+  // again, e.g. from a new session, skips partitioning and optimization.
   Status Register(const string& handle, const GraphDef& gdef,
                   const GraphOptions& graph_options,
                   const DebugOptions& debug_options,
                   const ConfigProto& config_proto, int64_t collective_graph_key,
                   WorkerSession* session,
                   DistributedFunctionLibraryRuntime* cluster_flr,
-                  string* graph_handle);
+                  const string& graph_fingerprint, string* graph_handle);
 
   // Executes one step of a registered graph "handle".
   //
@@ -194,7 +200,21 @@ class GraphMgr {
                   const DebugOptions& debug_options,
                   const ConfigProto& config_proto, int64_t collective_graph_key,
                   WorkerSession* session,
-                  DistributedFunctionLibraryRuntime* cluster_flr, Item* item);
+                  DistributedFunctionLibraryRuntime* cluster_flr,
+                  const string& graph_fingerprint, Item* item);
+
+  // Partitions "gdef" by device and runs the POST_PARTITIONING passes on the
+  // device graphs.
+  Status PartitionAndOptimizeGraph(
+      const GraphDef& gdef, const GraphOptions& graph_options,
+      const string& graph_fingerprint, Item* item,
+      std::unordered_map<string, std::unique_ptr<Graph>>* partition_graphs);
+
+  // Returns the key under which the partitions of the graph with
+  // "graph_fingerprint" are cached.
+  string PartitionsCacheKey(const string& graph_fingerprint,
+                            const GraphOptions& graph_options,
+                            const ConfigProto& config_proto) const;
 
   Status DecorateAndPublishGraphForDebug(const DebugOptions& debug_options,
                                          Graph* graph, Device* device);
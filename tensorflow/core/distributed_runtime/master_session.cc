@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/profile_handler.h"
 #include "tensorflow/core/common_runtime/stats_publisher_interface.h"
 #include "tensorflow/core/debug/debug_graph_utils.h"
+#include "tensorflow/core/distributed_runtime/partition_graph_cache.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/scheduler.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
@@ -63,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tsl/platform/tracing.h"
 #include "tsl/protobuf/coordination_config.pb.h"
 
@@ -472,10 +474,23 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     RegisterGraphRequest req;
     RegisterGraphResponse resp;
     Status status;
+    // The full graph, while the request only carries its fingerprint.
+    GraphDef graph_def;
   };
+  // Workers that have seen a graph before, e.g. from an earlier session,
+  // keep it in their `PartitionGraphCache`. Registering by fingerprint
+  // first saves sending and parsing large graphs again, but costs an extra
+  // round trip for every graph a worker has not cached, so it is only worth
+  // it for jobs that keep registering the same graphs. It requires every
+  // worker to understand `graph_def_omitted`.
+  static const bool register_by_fingerprint = [] {
+    bool value;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_REGISTER_GRAPH_BY_FINGERPRINT",
+                                   /*default_val=*/false, &value));
+    return value;
+  }();
   const int num = partitions_.size();
   absl::InlinedVector<Call, 4UL> calls(num);
-  BlockingCounter done(num);
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
     Call* c = &calls[i];
@@ -490,13 +505,48 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
         callable_opts_.run_options().debug_options();
     c->req.set_collective_graph_key(collective_graph_key_);
     VLOG(2) << "Register " << c->req.graph_def().DebugString();
-    auto cb = [c, &done](const Status& s) {
-      c->status = s;
-      done.DecrementCount();
-    };
-    part.worker->RegisterGraphAsync(&c->req, &c->resp, cb);
+    c->req.set_graph_fingerprint(
+        PartitionGraphCache::Fingerprint(c->req.graph_def()));
+    if (register_by_fingerprint) {
+      c->graph_def.Swap(c->req.mutable_graph_def());
+      // Workers that predate `graph_def_omitted` reject the placeholder graph
+      // instead of registering an empty one.
+      c->req.mutable_graph_def()->mutable_versions()->set_min_consumer(
+          kint32max);
+      c->req.set_graph_def_omitted(true);
+    }
+  }
+  auto register_calls = [this, &calls](const std::vector<int>& indices) {
+    BlockingCounter done(indices.size());
+    for (int i : indices) {
+      Call* c = &calls[i];
+      auto cb = [c, &done](const Status& s) {
+        c->status = s;
+        done.DecrementCount();
+      };
+      partitions_[i].worker->RegisterGraphAsync(&c->req, &c->resp, cb);
+    }
+    done.Wait();
+  };
+  std::vector<int> indices(num);
+  for (int i = 0; i < num; ++i) indices[i] = i;
+  register_calls(indices);
+  if (register_by_fingerprint) {
+    // Send the full graph to the workers that did not have it cached. Any
+    // other error is reported as is.
+    indices.clear();
+    for (int i = 0; i < num; ++i) {
+      Call* c = &calls[i];
+      if (!errors::IsNotFound(c->status)) continue;
+      VLOG(1) << "Registering full graph with " << partitions_[i].name
+              << " after: " << c->status;
+      c->req.mutable_graph_def()->Swap(&c->graph_def);
+      c->req.set_graph_def_omitted(false);
+      c->resp.Clear();
+      indices.push_back(i);
+    }
+    if (!indices.empty()) register_calls(indices);
   }
-  done.Wait();
   for (int i = 0; i < num; ++i) {
     Call* c = &calls[i];
     s.Update(c->status);
@@ -0,0 +1,100 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/memory_region_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+MemoryRegionCache::MemoryRegionCache(std::unique_ptr<Registrar> registrar)
+    : registrar_(std::move(registrar)) {}
+
+MemoryRegionCache::~MemoryRegionCache() {
+  mutex_lock l(mu_);
+  for (const auto& [base, region] : regions_) {
+    registrar_->Deregister(region.handle);
+  }
+}
+
+void MemoryRegionCache::AddRegion(void* base, size_t size) {
+  absl::StatusOr<void*> handle = registrar_->Register(base, size);
+  if (!handle.ok()) {
+    LOG(WARNING) << "Failed to register memory region of " << size
+                 << " bytes at " << base << ": " << handle.status();
+    return;
+  }
+  mutex_lock l(mu_);
+  auto [it, inserted] = regions_.emplace(reinterpret_cast<uintptr_t>(base),
+                                         Region{size, *handle});
+  if (!inserted) {
+    // The allocator reused the address of a region whose removal we missed.
+    registrar_->Deregister(it->second.handle);
+    it->second = Region{size, *handle};
+  }
+}
+
+void MemoryRegionCache::RemoveRegion(void* base) {
+  void* handle = nullptr;
+  {
+    mutex_lock l(mu_);
+    auto it = regions_.find(reinterpret_cast<uintptr_t>(base));
+    if (it == regions_.end()) return;
+    handle = it->second.handle;
+    regions_.erase(it);
+  }
+  registrar_->Deregister(handle);
+}
+
+absl::StatusOr<void*> MemoryRegionCache::Lookup(const void* ptr,
+                                                size_t size) const {
+  const uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+  tf_shared_lock l(mu_);
+  // Find the last region starting at or before `addr`.
+  auto it = regions_.upper_bound(addr);
+  if (it != regions_.begin()) {
+    --it;
+    if (addr + size <= it->first + it->second.size) {
+      return it->second.handle;
+    }
+  }
+  return errors::NotFound("No registered memory region contains ", size,
+                          " bytes at ", ptr);
+}
+
+SubAllocator::Visitor MemoryRegionCache::AllocVisitor() {
+  return [this](void* ptr, int index, size_t num_bytes) {
+    AddRegion(ptr, num_bytes);
+  };
+}
+
+SubAllocator::Visitor MemoryRegionCache::FreeVisitor() {
+  return [this](void* ptr, int index, size_t num_bytes) { RemoveRegion(ptr); };
+}
+
+int64_t MemoryRegionCache::num_regions() const {
+  tf_shared_lock l(mu_);
+  return regions_.size();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,100 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_MEMORY_REGION_CACHE_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_MEMORY_REGION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// MemoryRegionCache keeps memory registered with a network device (e.g. an
+// RDMA memory region) for every region that an allocator obtains from its
+// SubAllocator, so that tensors allocated from those regions can be sent or
+// received without registering memory on the critical path.
+//
+// Regions are added and removed by SubAllocator visitors (see `AllocVisitor`
+// and `FreeVisitor`), which are called when a (typically BFC) allocator grows
+// or shrinks. This matches the granularity at which registration is cheap to
+// cache: allocator regions are large and long-lived, while individual tensors
+// are not.
+//
+// This class is thread-safe.
+class MemoryRegionCache {
+ public:
+  // Registers and deregisters memory with the network device.
+  class Registrar {
+   public:
+    virtual ~Registrar() = default;
+
+    // Registers `size` bytes at `base`, returning an opaque handle (e.g. an
+    // `ibv_mr*`).
+    virtual absl::StatusOr<void*> Register(void* base, size_t size) = 0;
+
+    // Releases a handle returned by `Register`.
+    virtual void Deregister(void* handle) = 0;
+  };
+
+  explicit MemoryRegionCache(std::unique_ptr<Registrar> registrar);
+  ~MemoryRegionCache();
+
+  MemoryRegionCache(const MemoryRegionCache&) = delete;
+  void operator=(const MemoryRegionCache&) = delete;
+
+  // Registers the region of `size` bytes at `base`. Logs and ignores
+  // registration failures; tensors in such a region are sent over gRPC.
+  void AddRegion(void* base, size_t size);
+
+  // Deregisters the region at `base`, if it is registered.
+  void RemoveRegion(void* base);
+
+  // Returns the handle of the registered region containing the `size` bytes
+  // at `ptr`, or NOT_FOUND if no registered region contains them.
+  absl::StatusOr<void*> Lookup(const void* ptr, size_t size) const;
+
+  // Visitors that add and remove the regions of a SubAllocator, e.g. for
+  // `ProcessState::AddCPUAllocVisitor()` and
+  // `ProcessState::AddCPUFreeVisitor()`. They must be installed before the
+  // allocators they observe are created, and the cache must outlive those
+  // allocators.
+  SubAllocator::Visitor AllocVisitor();
+  SubAllocator::Visitor FreeVisitor();
+
+  int64_t num_regions() const;
+
+ private:
+  struct Region {
+    size_t size;
+    void* handle;
+  };
+
+  const std::unique_ptr<Registrar> registrar_;
+
+  mutable mutex mu_;
+  // Keyed by the start address of the region.
+  std::map<uintptr_t, Region> regions_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_MEMORY_REGION_CACHE_H_
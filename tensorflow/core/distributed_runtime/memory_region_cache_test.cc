@@ -0,0 +1,105 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/memory_region_cache.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/status_matchers.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+// Hands out the region base as the handle, and records live registrations.
+class FakeRegistrar : public MemoryRegionCache::Registrar {
+ public:
+  explicit FakeRegistrar(std::vector<void*>* live) : live_(live) {}
+
+  absl::StatusOr<void*> Register(void* base, size_t size) override {
+    if (size == 0) return errors::InvalidArgument("Empty region");
+    live_->push_back(base);
+    return base;
+  }
+
+  void Deregister(void* handle) override {
+    for (auto it = live_->begin(); it != live_->end(); ++it) {
+      if (*it == handle) {
+        live_->erase(it);
+        return;
+      }
+    }
+    ADD_FAILURE() << "Deregistered unknown handle " << handle;
+  }
+
+ private:
+  std::vector<void*>* live_;
+};
+
+TEST(MemoryRegionCacheTest, LookupFindsContainingRegion) {
+  std::vector<void*> live;
+  MemoryRegionCache cache(std::make_unique<FakeRegistrar>(&live));
+  std::vector<char> a(1024), b(1024);
+  cache.AddRegion(a.data(), a.size());
+  cache.AddRegion(b.data(), b.size());
+  EXPECT_EQ(cache.num_regions(), 2);
+
+  TF_ASSERT_OK_AND_ASSIGN(void* handle, cache.Lookup(a.data() + 100, 924));
+  EXPECT_EQ(handle, a.data());
+  TF_ASSERT_OK_AND_ASSIGN(handle, cache.Lookup(b.data(), b.size()));
+  EXPECT_EQ(handle, b.data());
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup(a.data() + 100, 925).status()));
+}
+
+TEST(MemoryRegionCacheTest, UnregisteredMemory) {
+  std::vector<void*> live;
+  MemoryRegionCache cache(std::make_unique<FakeRegistrar>(&live));
+  std::vector<char> a(1024);
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup(a.data(), 1).status()));
+  // Failed registrations are not cached.
+  cache.AddRegion(a.data(), 0);
+  EXPECT_EQ(cache.num_regions(), 0);
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup(a.data(), 1).status()));
+}
+
+TEST(MemoryRegionCacheTest, VisitorsTrackAllocatorRegions) {
+  std::vector<void*> live;
+  std::vector<char> a(1024), b(1024);
+  {
+    MemoryRegionCache cache(std::make_unique<FakeRegistrar>(&live));
+    SubAllocator::Visitor alloc_visitor = cache.AllocVisitor();
+    SubAllocator::Visitor free_visitor = cache.FreeVisitor();
+    alloc_visitor(a.data(), /*index=*/0, a.size());
+    alloc_visitor(b.data(), /*index=*/0, b.size());
+    EXPECT_THAT(live, UnorderedElementsAre(a.data(), b.data()));
+
+    free_visitor(a.data(), /*index=*/0, a.size());
+    EXPECT_THAT(live, UnorderedElementsAre(b.data()));
+    EXPECT_TRUE(errors::IsNotFound(cache.Lookup(a.data(), 1).status()));
+    TF_EXPECT_OK(cache.Lookup(b.data(), 1).status());
+  }
+  // The remaining regions are deregistered when the cache is destroyed.
+  EXPECT_THAT(live, IsEmpty());
+}
+
+}  // namespace
+}  // namespace tensorflow
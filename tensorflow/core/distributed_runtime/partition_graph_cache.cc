@@ -0,0 +1,128 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/partition_graph_cache.h"
+
+#include <utility>
+
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Keys of the two kinds of entries share one map and one LRU list.
+constexpr char kGraphKeyPrefix[] = "graph:";
+constexpr char kPartitionsKeyPrefix[] = "partitions:";
+
+}  // namespace
+
+PartitionGraphCache::PartitionGraphCache(int64_t capacity_bytes)
+    : capacity_bytes_(capacity_bytes) {}
+
+/* static */
+string PartitionGraphCache::Fingerprint(const GraphDef& graph) {
+  string serialized;
+  CHECK(SerializeToStringDeterministic(graph, &serialized));
+  const Fprint128 fingerprint = Fingerprint128(serialized);
+  return strings::Printf("%016llx%016llx",
+                         static_cast<unsigned long long>(fingerprint.high64),
+                         static_cast<unsigned long long>(fingerprint.low64));
+}
+
+void PartitionGraphCache::InsertGraph(const string& fingerprint,
+                                      std::shared_ptr<const GraphDef> graph) {
+  Entry entry;
+  entry.bytes = graph->ByteSizeLong();
+  entry.graph = std::move(graph);
+  mutex_lock l(mu_);
+  Insert(strings::StrCat(kGraphKeyPrefix, fingerprint), std::move(entry));
+}
+
+std::shared_ptr<const GraphDef> PartitionGraphCache::LookupGraph(
+    const string& fingerprint) {
+  mutex_lock l(mu_);
+  Entry* entry = Find(strings::StrCat(kGraphKeyPrefix, fingerprint));
+  return entry == nullptr ? nullptr : entry->graph;
+}
+
+void PartitionGraphCache::InsertPartitions(
+    const string& key, std::shared_ptr<const Partitions> partitions) {
+  Entry entry;
+  entry.bytes = partitions->library.ByteSizeLong();
+  for (const auto& device_graph : partitions->device_graphs) {
+    entry.bytes += device_graph.second.ByteSizeLong();
+  }
+  entry.partitions = std::move(partitions);
+  mutex_lock l(mu_);
+  Insert(strings::StrCat(kPartitionsKeyPrefix, key), std::move(entry));
+}
+
+std::shared_ptr<const PartitionGraphCache::Partitions>
+PartitionGraphCache::LookupPartitions(const string& key) {
+  mutex_lock l(mu_);
+  Entry* entry = Find(strings::StrCat(kPartitionsKeyPrefix, key));
+  return entry == nullptr ? nullptr : entry->partitions;
+}
+
+PartitionGraphCache::Stats PartitionGraphCache::GetStats() {
+  mutex_lock l(mu_);
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.num_entries = entries_.size();
+  stats.bytes = bytes_;
+  return stats;
+}
+
+PartitionGraphCache::Entry* PartitionGraphCache::Find(const string& key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+  return &it->second;
+}
+
+void PartitionGraphCache::Insert(const string& key, Entry entry) {
+  if (entry.bytes > capacity_bytes_) {
+    VLOG(1) << "Not caching " << key << " of " << entry.bytes
+            << " bytes, which exceeds the capacity of " << capacity_bytes_;
+    return;
+  }
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    bytes_ -= it->second.bytes;
+    lru_.erase(it->second.lru_pos);
+    entries_.erase(it);
+  }
+  while (!lru_.empty() && bytes_ + entry.bytes > capacity_bytes_) {
+    auto victim = entries_.find(lru_.back());
+    bytes_ -= victim->second.bytes;
+    entries_.erase(victim);
+    lru_.pop_back();
+  }
+  lru_.push_front(key);
+  entry.lru_pos = lru_.begin();
+  bytes_ += entry.bytes;
+  entries_.emplace(key, std::move(entry));
+}
+
+}  // namespace tensorflow
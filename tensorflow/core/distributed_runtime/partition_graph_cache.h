@@ -0,0 +1,113 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PARTITION_GRAPH_CACHE_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PARTITION_GRAPH_CACHE_H_
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// PartitionGraphCache keeps the graphs registered with a worker, and the
+// device partitions that GraphMgr derives from them, across worker sessions.
+// A master that reconnects after a restart can then register a graph by its
+// fingerprint alone, and the worker skips partitioning and optimizing the
+// graph again.
+//
+// Entries are content-addressed, so they never go stale; the least recently
+// used entries are evicted once the cache holds more than `capacity_bytes`.
+//
+// This class is thread-safe.
+class PartitionGraphCache {
+ public:
+  static constexpr int64_t kDefaultCapacityBytes = 256LL << 20;
+
+  // The device graphs GraphMgr derived from a registered graph, after all
+  // partitioning and optimization passes, together with the function library
+  // they refer to.
+  struct Partitions {
+    FunctionDefLibrary library;
+    std::map<string, GraphDef> device_graphs;
+  };
+
+  struct Stats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t num_entries = 0;
+    int64_t bytes = 0;
+  };
+
+  explicit PartitionGraphCache(int64_t capacity_bytes = kDefaultCapacityBytes);
+
+  PartitionGraphCache(const PartitionGraphCache&) = delete;
+  void operator=(const PartitionGraphCache&) = delete;
+
+  // Returns the fingerprint under which a master registers `graph`. Masters
+  // and workers must agree on it, so it is computed from the deterministic
+  // serialization of `graph`.
+  static string Fingerprint(const GraphDef& graph);
+
+  // Caches the graph registered under `fingerprint`.
+  void InsertGraph(const string& fingerprint,
+                   std::shared_ptr<const GraphDef> graph);
+
+  // Returns the graph registered under `fingerprint`, or null.
+  std::shared_ptr<const GraphDef> LookupGraph(const string& fingerprint);
+
+  // Caches the partitions of a graph under `key`, which identifies the graph
+  // together with everything else GraphMgr's passes depend on.
+  void InsertPartitions(const string& key,
+                        std::shared_ptr<const Partitions> partitions);
+
+  // Returns the partitions cached under `key`, or null.
+  std::shared_ptr<const Partitions> LookupPartitions(const string& key);
+
+  Stats GetStats();
+
+ private:
+  struct Entry {
+    std::shared_ptr<const GraphDef> graph;
+    std::shared_ptr<const Partitions> partitions;
+    int64_t bytes = 0;
+    std::list<string>::iterator lru_pos;
+  };
+
+  // Looks up `key`, marking it as most recently used.
+  Entry* Find(const string& key) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void Insert(const string& key, Entry entry) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64_t capacity_bytes_;
+
+  mutex mu_;
+  absl::flat_hash_map<string, Entry> entries_ TF_GUARDED_BY(mu_);
+  // Keys of `entries_`, most recently used first.
+  std::list<string> lru_ TF_GUARDED_BY(mu_);
+  int64_t bytes_ TF_GUARDED_BY(mu_) = 0;
+  int64_t hits_ TF_GUARDED_BY(mu_) = 0;
+  int64_t misses_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PARTITION_GRAPH_CACHE_H_
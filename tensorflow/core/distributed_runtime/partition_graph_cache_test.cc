@@ -0,0 +1,127 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/partition_graph_cache.h"
+
+#include <memory>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns a graph with `num_nodes` NoOp nodes.
+std::shared_ptr<GraphDef> MakeGraph(int num_nodes) {
+  auto graph = std::make_shared<GraphDef>();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = graph->add_node();
+    node->set_name(strings::StrCat("node_", i));
+    node->set_op("NoOp");
+    node->set_device("/job:worker/replica:0/task:0/device:CPU:0");
+  }
+  return graph;
+}
+
+TEST(PartitionGraphCacheTest, FingerprintIsDeterministic) {
+  std::shared_ptr<GraphDef> a = MakeGraph(3);
+  std::shared_ptr<GraphDef> b = MakeGraph(3);
+  EXPECT_EQ(PartitionGraphCache::Fingerprint(*a),
+            PartitionGraphCache::Fingerprint(*b));
+  EXPECT_EQ(PartitionGraphCache::Fingerprint(*a).size(), 32);
+
+  b->mutable_node(1)->set_op("Identity");
+  EXPECT_NE(PartitionGraphCache::Fingerprint(*a),
+            PartitionGraphCache::Fingerprint(*b));
+}
+
+TEST(PartitionGraphCacheTest, InsertAndLookupGraph) {
+  PartitionGraphCache cache;
+  std::shared_ptr<GraphDef> graph = MakeGraph(2);
+  const string fingerprint = PartitionGraphCache::Fingerprint(*graph);
+  EXPECT_EQ(cache.LookupGraph(fingerprint), nullptr);
+
+  cache.InsertGraph(fingerprint, graph);
+  std::shared_ptr<const GraphDef> cached = cache.LookupGraph(fingerprint);
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->node_size(), 2);
+  // Graphs and partitions do not share keys.
+  EXPECT_EQ(cache.LookupPartitions(fingerprint), nullptr);
+
+  PartitionGraphCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.num_entries, 1);
+  EXPECT_EQ(stats.bytes, graph->ByteSizeLong());
+}
+
+TEST(PartitionGraphCacheTest, InsertAndLookupPartitions) {
+  PartitionGraphCache cache;
+  auto partitions = std::make_shared<PartitionGraphCache::Partitions>();
+  partitions->device_graphs["/device:CPU:0"] = *MakeGraph(2);
+  partitions->device_graphs["/device:CPU:1"] = *MakeGraph(1);
+  partitions->library.add_function()->mutable_signature()->set_name("f");
+  cache.InsertPartitions("key", partitions);
+
+  std::shared_ptr<const PartitionGraphCache::Partitions> cached =
+      cache.LookupPartitions("key");
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->device_graphs.size(), 2);
+  EXPECT_EQ(cached->library.function_size(), 1);
+  EXPECT_EQ(cache.LookupPartitions("other_key"), nullptr);
+}
+
+TEST(PartitionGraphCacheTest, EvictsLeastRecentlyUsed) {
+  std::shared_ptr<GraphDef> graph = MakeGraph(4);
+  const int64_t graph_bytes = graph->ByteSizeLong();
+  PartitionGraphCache cache(/*capacity_bytes=*/2 * graph_bytes);
+  cache.InsertGraph("a", graph);
+  cache.InsertGraph("b", graph);
+  // Using "a" makes "b" the next entry to evict.
+  EXPECT_NE(cache.LookupGraph("a"), nullptr);
+  cache.InsertGraph("c", graph);
+
+  EXPECT_NE(cache.LookupGraph("a"), nullptr);
+  EXPECT_EQ(cache.LookupGraph("b"), nullptr);
+  EXPECT_NE(cache.LookupGraph("c"), nullptr);
+  PartitionGraphCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.num_entries, 2);
+  EXPECT_EQ(stats.bytes, 2 * graph_bytes);
+}
+
+TEST(PartitionGraphCacheTest, ReplacesExistingEntry) {
+  PartitionGraphCache cache;
+  cache.InsertGraph("a", MakeGraph(1));
+  std::shared_ptr<GraphDef> larger = MakeGraph(3);
+  cache.InsertGraph("a", larger);
+  PartitionGraphCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.num_entries, 1);
+  EXPECT_EQ(stats.bytes, larger->ByteSizeLong());
+  EXPECT_EQ(cache.LookupGraph("a")->node_size(), 3);
+}
+
+TEST(PartitionGraphCacheTest, DoesNotCacheEntriesLargerThanCapacity) {
+  std::shared_ptr<GraphDef> small = MakeGraph(1);
+  PartitionGraphCache cache(/*capacity_bytes=*/small->ByteSizeLong());
+  cache.InsertGraph("small", small);
+  cache.InsertGraph("large", MakeGraph(10));
+  EXPECT_EQ(cache.LookupGraph("large"), nullptr);
+  // The oversized entry did not evict anything.
+  EXPECT_NE(cache.LookupGraph("small"), nullptr);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,86 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/remote_tensor_transport.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kTransportEnvVar[] = "TF_REMOTE_TENSOR_TRANSPORT";
+
+struct Registry {
+  mutex mu;
+  absl::flat_hash_map<std::string, RemoteTensorTransportRegistry::Factory>
+      factories TF_GUARDED_BY(mu);
+};
+
+Registry* GlobalRegistry() {
+  static Registry* registry = new Registry;
+  return registry;
+}
+
+}  // namespace
+
+void RemoteTensorTransportRegistry::Register(const std::string& name,
+                                             Factory factory) {
+  Registry* registry = GlobalRegistry();
+  mutex_lock l(registry->mu);
+  CHECK(registry->factories.emplace(name, std::move(factory)).second)
+      << "Remote tensor transport " << name << " registered twice.";
+}
+
+Status RemoteTensorTransportRegistry::Create(
+    const std::string& name, const WorkerEnv* env,
+    std::unique_ptr<RemoteTensorTransport>* transport) {
+  Factory factory;
+  {
+    Registry* registry = GlobalRegistry();
+    mutex_lock l(registry->mu);
+    auto it = registry->factories.find(name);
+    if (it == registry->factories.end()) {
+      return errors::NotFound("No remote tensor transport registered as ",
+                              name);
+    }
+    factory = it->second;
+  }
+  *transport = factory(env);
+  if (*transport == nullptr) {
+    return errors::Internal("Failed to create remote tensor transport ", name);
+  }
+  LOG(INFO) << "Using remote tensor transport " << name;
+  return absl::OkStatus();
+}
+
+Status RemoteTensorTransportRegistry::CreateFromEnv(
+    const WorkerEnv* env, std::unique_ptr<RemoteTensorTransport>* transport) {
+  transport->reset();
+  std::string name;
+  TF_RETURN_IF_ERROR(ReadStringFromEnvVar(kTransportEnvVar, "", &name));
+  if (name.empty()) {
+    return absl::OkStatus();
+  }
+  return Create(name, env, transport);
+}
+
+}  // namespace tensorflow
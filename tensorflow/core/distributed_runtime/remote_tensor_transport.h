@@ -0,0 +1,138 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_REMOTE_TENSOR_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_REMOTE_TENSOR_TRANSPORT_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+class Device;
+struct WorkerEnv;
+
+// RemoteTensorTransport lets a data plane other than gRPC (e.g. RDMA over
+// ibverbs or UCX) move the contents of tensors exchanged through the remote
+// rendezvous, while the RecvTensor RPC remains the control plane.
+//
+// A transfer proceeds as follows:
+//
+// 1. The receiver calls `PrepareRecv`, which may reserve a registered landing
+//    buffer and describe it in `RecvTensorRequest.transport_options`.
+// 2. The RecvTensor RPC is sent to the sender. If the request carries
+//    `transport_options`, the sender calls `SendAsync` once the tensor is
+//    produced. The transport may write the tensor contents directly into the
+//    receiver's landing buffer (e.g. with a one-sided RDMA write) and describe
+//    the result in `RecvTensorResponse.transport_options`; otherwise the
+//    tensor is sent inline in the RPC response as usual.
+// 3. The receiver calls `FinishRecv` with the RPC response, which produces the
+//    tensor if it was delivered out of band and releases the reservation.
+//
+// Implementations must be thread-safe.
+class RemoteTensorTransport {
+ public:
+  virtual ~RemoteTensorTransport() = default;
+
+  virtual std::string name() const = 0;
+
+  // Receiver side.
+
+  // Called before the RecvTensor RPC for `parsed` is issued. Returns true if
+  // `request->transport_options` was set, in which case `FinishRecv` must be
+  // called exactly once for `request`.
+  virtual bool PrepareRecv(const Rendezvous::ParsedKey& parsed,
+                           Device* dst_device,
+                           const AllocatorAttributes& alloc_attrs,
+                           RecvTensorRequest* request) = 0;
+
+  // Called when the RecvTensor RPC for a prepared `request` completes with
+  // status `rpc_status`. If the sender delivered the tensor out of band, sets
+  // `*tensor` and sets `*delivered` to true. Otherwise sets `*delivered` to
+  // false, and the tensor in `response` (if any) is used.
+  virtual Status FinishRecv(const Status& rpc_status,
+                            const RecvTensorRequest& request,
+                            const RecvTensorResponse& response,
+                            Device* dst_device,
+                            const AllocatorAttributes& alloc_attrs,
+                            Tensor* tensor, bool* delivered) = 0;
+
+  // Sender side.
+
+  // Called with the status of the out-of-band send. If `delivered` is false,
+  // the tensor is sent inline in the RPC response instead.
+  using SendDoneCallback = std::function<void(const Status&, bool delivered)>;
+
+  // Delivers `tensor` to the receiver that issued `request`, which carries
+  // `transport_options` set by the receiver's `PrepareRecv`. When `done` is
+  // called with `delivered == true`, `response` holds the metadata (without
+  // tensor contents) to return to the receiver over the RPC.
+  virtual void SendAsync(const RecvTensorRequest& request, const Tensor& tensor,
+                         RecvTensorResponse* response,
+                         SendDoneCallback done) = 0;
+};
+
+// Registry of RemoteTensorTransport implementations. A transport is selected
+// by setting the TF_REMOTE_TENSOR_TRANSPORT environment variable to its
+// registered name; by default tensors are only moved over gRPC.
+class RemoteTensorTransportRegistry {
+ public:
+  using Factory =
+      std::function<std::unique_ptr<RemoteTensorTransport>(const WorkerEnv*)>;
+
+  static void Register(const std::string& name, Factory factory);
+
+  // Creates the transport registered under `name`.
+  static Status Create(const std::string& name, const WorkerEnv* env,
+                       std::unique_ptr<RemoteTensorTransport>* transport);
+
+  // Creates the transport named by TF_REMOTE_TENSOR_TRANSPORT, or sets
+  // `*transport` to nullptr if the variable is unset. Returns NOT_FOUND if no
+  // transport with that name is registered.
+  static Status CreateFromEnv(
+      const WorkerEnv* env, std::unique_ptr<RemoteTensorTransport>* transport);
+};
+
+namespace remote_tensor_transport_registration {
+
+class RemoteTensorTransportRegistration {
+ public:
+  RemoteTensorTransportRegistration(
+      const std::string& name, RemoteTensorTransportRegistry::Factory factory) {
+    RemoteTensorTransportRegistry::Register(name, std::move(factory));
+  }
+};
+
+}  // namespace remote_tensor_transport_registration
+
+#define REGISTER_REMOTE_TENSOR_TRANSPORT(name, factory) \
+  REGISTER_REMOTE_TENSOR_TRANSPORT_UNIQ_HELPER(__COUNTER__, name, factory)
+#define REGISTER_REMOTE_TENSOR_TRANSPORT_UNIQ_HELPER(ctr, name, factory) \
+  REGISTER_REMOTE_TENSOR_TRANSPORT_UNIQ(ctr, name, factory)
+#define REGISTER_REMOTE_TENSOR_TRANSPORT_UNIQ(ctr, name, factory) \
+  static ::tensorflow::remote_tensor_transport_registration::     \
+      RemoteTensorTransportRegistration                           \
+          remote_tensor_transport_registration_##ctr(name, factory)
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_REMOTE_TENSOR_TRANSPORT_H_
@@ -16,11 +16,14 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 
 #include "grpcpp/generic/generic_stub.h"
 #include "xla/tsl/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/call_options.h"
+#include "tensorflow/core/distributed_runtime/eager/remote_enqueue_batcher.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
@@ -196,6 +199,19 @@ class GrpcEagerClient : public EagerClient {
   void CloseContextAsync(const CloseContextRequest* request,
                          CloseContextResponse* response,
                          StatusCallback done) override {
+    // Send the ops that are still waiting in a batch before the context is
+    // closed.
+    std::shared_ptr<RemoteEnqueueBatcher> batcher;
+    {
+      mutex_lock l(mu_);
+      auto batcher_it = enqueue_batchers_.find(request->context_id());
+      if (batcher_it != enqueue_batchers_.end()) {
+        batcher = std::move(batcher_it->second);
+        enqueue_batchers_.erase(batcher_it);
+      }
+    }
+    if (batcher != nullptr) batcher->Flush();
+
     StatusCallback done_wrapped = callback_wrapper(std::move(done));
     new RPCState<protobuf::Message>(
         &stub_, cq_, "/tensorflow.eager.EagerService/CloseContext", *request,
@@ -228,19 +244,14 @@ class GrpcEagerClient : public EagerClient {
     // 2. The flag set in the eager executor.
     // Streaming enqueue is allowed only when the both are enabled.
     if (EnableStreaming() && enable_streaming_enqueue) {
-      mutex_lock l(mu_);
-      auto it = enqueue_dispatchers_.find(request->context_id());
-      if (it == enqueue_dispatchers_.end()) {
-        auto it_and_bool = enqueue_dispatchers_.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(request->context_id()),
-            std::forward_as_tuple(
-                &stub_, cq_,
-                "/tensorflow.eager.EagerService/StreamingEnqueue"));
-        it = it_and_bool.first;
+      // Coalesce consecutive requests into batched requests on the stream when
+      // TF_EAGER_REMOTE_ENQUEUE_BATCH_SIZE > 1.
+      if (RemoteEnqueueBatcher::MaxBatchSizeFromEnv() > 1) {
+        GetOrCreateBatcher(request->context_id())
+            ->Enqueue(*request, response, std::move(done_wrapped));
+        return;
       }
-      // TODO(haoyuzhang): Consider supporting cancellation for streaming RPC?
-      it->second.SendNextRequest(*request, response, std::move(done_wrapped));
+      SendStreamingRequest(request, response, std::move(done_wrapped));
     } else {
       Notification n;
       Status status;
@@ -265,6 +276,43 @@ class GrpcEagerClient : public EagerClient {
 
   std::unordered_map<uint64, StreamingRPCDispatcher<EnqueueResponse>>
       enqueue_dispatchers_ TF_GUARDED_BY(mu_);
+  // Declared after `enqueue_dispatchers_`, which they send to.
+  std::unordered_map<uint64, std::shared_ptr<RemoteEnqueueBatcher>>
+      enqueue_batchers_ TF_GUARDED_BY(mu_);
+
+  void SendStreamingRequest(const EnqueueRequest* request,
+                            EnqueueResponse* response, StatusCallback done) {
+    mutex_lock l(mu_);
+    auto it = enqueue_dispatchers_.find(request->context_id());
+    if (it == enqueue_dispatchers_.end()) {
+      auto it_and_bool = enqueue_dispatchers_.emplace(
+          std::piecewise_construct,
+          std::forward_as_tuple(request->context_id()),
+          std::forward_as_tuple(
+              &stub_, cq_, "/tensorflow.eager.EagerService/StreamingEnqueue"));
+      it = it_and_bool.first;
+    }
+    // TODO(haoyuzhang): Consider supporting cancellation for streaming RPC?
+    it->second.SendNextRequest(*request, response, std::move(done));
+  }
+
+  std::shared_ptr<RemoteEnqueueBatcher> GetOrCreateBatcher(uint64 context_id) {
+    mutex_lock l(mu_);
+    std::shared_ptr<RemoteEnqueueBatcher>& batcher =
+        enqueue_batchers_[context_id];
+    if (batcher == nullptr) {
+      // Every batched request holds a reference to this client through its
+      // wrapped callback, so the client outlives the batches it sends.
+      batcher = std::make_shared<RemoteEnqueueBatcher>(
+          [this](const EnqueueRequest* request, EnqueueResponse* response,
+                 StatusCallback done) {
+            SendStreamingRequest(request, response, std::move(done));
+          },
+          RemoteEnqueueBatcher::MaxBatchSizeFromEnv(),
+          RemoteEnqueueBatcher::FlushWindowFromEnv());
+    }
+    return batcher;
+  }
 
   StatusCallback callback_wrapper(StatusCallback done) {
     Ref();
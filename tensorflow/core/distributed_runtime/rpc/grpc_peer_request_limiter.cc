@@ -0,0 +1,72 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/rpc/grpc_peer_request_limiter.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+GrpcPeerRequestLimiter::GrpcPeerRequestLimiter(int64_t max_in_flight)
+    : max_in_flight_(max_in_flight) {}
+
+GrpcPeerRequestLimiter::~GrpcPeerRequestLimiter() {
+  mutex_lock l(mu_);
+  if (!queued_.empty()) {
+    LOG(WARNING) << "Dropping " << queued_.size()
+                 << " queued requests to a peer.";
+  }
+}
+
+void GrpcPeerRequestLimiter::Acquire(std::function<void()> start) {
+  {
+    mutex_lock l(mu_);
+    if (max_in_flight_ > 0 && num_in_flight_ >= max_in_flight_) {
+      queued_.push_back(std::move(start));
+      return;
+    }
+    ++num_in_flight_;
+  }
+  start();
+}
+
+void GrpcPeerRequestLimiter::Release() {
+  std::function<void()> next;
+  {
+    mutex_lock l(mu_);
+    DCHECK_GT(num_in_flight_, 0);
+    if (queued_.empty()) {
+      --num_in_flight_;
+      return;
+    }
+    // The slot of the completed request passes directly to the next one.
+    next = std::move(queued_.front());
+    queued_.pop_front();
+  }
+  next();
+}
+
+int64_t GrpcPeerRequestLimiter::num_in_flight() {
+  mutex_lock l(mu_);
+  return num_in_flight_;
+}
+
+int64_t GrpcPeerRequestLimiter::num_queued() {
+  mutex_lock l(mu_);
+  return queued_.size();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,66 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_PEER_REQUEST_LIMITER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_PEER_REQUEST_LIMITER_H_
+
+#include <deque>
+#include <functional>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Bounds the number of requests that are outstanding to a single peer.
+//
+// Requests beyond the bound are queued in arrival order and started as earlier
+// requests complete, so that a burst of large transfers to one peer does not
+// saturate its connection at the expense of latency-sensitive calls.
+//
+// This class is thread-safe.
+class GrpcPeerRequestLimiter {
+ public:
+  // A `max_in_flight` of zero or less disables the bound.
+  explicit GrpcPeerRequestLimiter(int64_t max_in_flight);
+
+  ~GrpcPeerRequestLimiter();
+
+  // Calls `start` once the request it issues may be sent. `start` runs either
+  // inline or from within a later call to `Release()`. Every admitted request
+  // must be matched by exactly one call to `Release()` when it completes.
+  void Acquire(std::function<void()> start);
+
+  // Marks one admitted request as complete, and starts the oldest queued one.
+  void Release();
+
+  int64_t max_in_flight() const { return max_in_flight_; }
+  int64_t num_in_flight();
+  int64_t num_queued();
+
+ private:
+  const int64_t max_in_flight_;
+
+  mutex mu_;
+  int64_t num_in_flight_ TF_GUARDED_BY(mu_) = 0;
+  std::deque<std::function<void()>> queued_ TF_GUARDED_BY(mu_);
+
+  GrpcPeerRequestLimiter(const GrpcPeerRequestLimiter&) = delete;
+  void operator=(const GrpcPeerRequestLimiter&) = delete;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_PEER_REQUEST_LIMITER_H_
@@ -0,0 +1,61 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/rpc/grpc_peer_request_limiter.h"
+
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(GrpcPeerRequestLimiterTest, QueuesRequestsBeyondTheBound) {
+  GrpcPeerRequestLimiter limiter(/*max_in_flight=*/2);
+  std::vector<int> started;
+  for (int i = 0; i < 4; ++i) {
+    limiter.Acquire([&started, i]() { started.push_back(i); });
+  }
+  EXPECT_EQ(started, std::vector<int>({0, 1}));
+  EXPECT_EQ(limiter.num_in_flight(), 2);
+  EXPECT_EQ(limiter.num_queued(), 2);
+
+  limiter.Release();
+  EXPECT_EQ(started, std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(limiter.num_in_flight(), 2);
+  EXPECT_EQ(limiter.num_queued(), 1);
+
+  limiter.Release();
+  limiter.Release();
+  EXPECT_EQ(started, std::vector<int>({0, 1, 2, 3}));
+  EXPECT_EQ(limiter.num_in_flight(), 1);
+  EXPECT_EQ(limiter.num_queued(), 0);
+
+  limiter.Release();
+  EXPECT_EQ(limiter.num_in_flight(), 0);
+}
+
+TEST(GrpcPeerRequestLimiterTest, Unbounded) {
+  GrpcPeerRequestLimiter limiter(/*max_in_flight=*/0);
+  int started = 0;
+  for (int i = 0; i < 100; ++i) {
+    limiter.Acquire([&started]() { ++started; });
+  }
+  EXPECT_EQ(started, 100);
+  EXPECT_EQ(limiter.num_in_flight(), 100);
+  EXPECT_EQ(limiter.num_queued(), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
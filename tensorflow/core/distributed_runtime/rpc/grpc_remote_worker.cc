@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 
+#include <atomic>
+#include <memory>
 #include <utility>
 
 #include "grpcpp/generic/generic_stub.h"
@@ -22,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_peer_request_limiter.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
@@ -44,7 +47,8 @@ class GrpcRemoteWorker : public WorkerInterface {
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
                             ::grpc::CompletionQueue* completion_queue,
                             thread::ThreadPool* callback_threadpool,
-                            WorkerCacheLogger* logger, const string& target)
+                            WorkerCacheLogger* logger, const string& target,
+                            GrpcPeerRequestLimiter* limiter)
       : channel_(std::move(channel)),
         stub_(channel_),
         cq_(completion_queue),
@@ -66,7 +70,8 @@ class GrpcRemoteWorker : public WorkerInterface {
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
         logger_(logger),
-        target_(target) {}
+        target_(target),
+        limiter_(limiter) {}
 
   ~GrpcRemoteWorker() override {}
 
@@ -171,7 +176,7 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvbuf_, callback, call_opts);
+    IssueBulkRequest(request, response, recvbuf_, callback, call_opts);
   }
 
   void CompleteGroupAsync(CallOptions* call_opts,
@@ -254,7 +259,7 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvtensor_, callback, call_opts);
+    IssueBulkRequest(request, response, recvtensor_, callback, call_opts);
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -275,21 +280,64 @@ class GrpcRemoteWorker : public WorkerInterface {
                     StatusCallback done, CallOptions* call_opts = nullptr,
                     bool fail_fast = true) {
     new RPCState<protobuf::Message>(
-        &stub_, cq_, method, *request, response, std::move(done), call_opts,
-        callback_threadpool_, MaxRetries(), fail_fast, &target_);
+        &stub_, cq_, method, *request, response, TrackLatency(std::move(done)),
+        call_opts, callback_threadpool_, MaxRetries(), fail_fast, &target_);
   }
 
   void IssueRequest(const protobuf::Message* request, TensorResponse* response,
                     const ::grpc::string& method, StatusCallback done,
                     CallOptions* call_opts = nullptr) {
     new RPCState<TensorResponse>(
-        &stub_, cq_, method, *request, response, std::move(done), call_opts,
-        callback_threadpool_, MaxRetries(),
+        &stub_, cq_, method, *request, response, TrackLatency(std::move(done)),
+        call_opts, callback_threadpool_, MaxRetries(),
         /*fail_fast=*/true, &target_,
         // Use optimized proto parse function that avoids a copy.
         GrpcMaybeParseTensorResponse);
   }
 
+  // Issues a request that transfers tensor data. Such requests count against
+  // the in-flight bound of the peer, if any, and wait for a free slot.
+  template <typename Response>
+  void IssueBulkRequest(const protobuf::Message* request, Response* response,
+                        const ::grpc::string& method, StatusCallback done,
+                        CallOptions* call_opts) {
+    if (limiter_ == nullptr) {
+      IssueRequest(request, response, method, std::move(done), call_opts);
+      return;
+    }
+    // A queued request has not yet installed the cancellation callback of its
+    // RPCState, so remember any cancellation that arrives in the meantime.
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    if (call_opts != nullptr) {
+      call_opts->SetCancelCallback([cancelled]() { *cancelled = true; });
+    }
+    limiter_->Acquire([this, request, response, &method, done = std::move(done),
+                       call_opts, cancelled]() mutable {
+      GrpcPeerRequestLimiter* limiter = limiter_;
+      if (*cancelled) {
+        limiter->Release();
+        done(errors::Cancelled("Request was cancelled before it was sent"));
+        return;
+      }
+      IssueRequest(request, response, method,
+                   [limiter, done = std::move(done)](const Status& s) {
+                     limiter->Release();
+                     done(s);
+                   },
+                   call_opts);
+    });
+  }
+
+  // Wraps `done` so that the latency of the call is recorded in `logger_`.
+  StatusCallback TrackLatency(StatusCallback done) {
+    const int64_t start_usecs = Env::Default()->NowMicros();
+    return [this, start_usecs, done = std::move(done)](const Status& s) {
+      logger_->RecordRpcLatency(
+          target_, Env::Default()->NowMicros() - start_usecs, s.ok());
+      done(s);
+    };
+  }
+
   void IssueMarkRecvFinishedRequest(int64_t request_id) {
     VLOG(2) << "Send MarkRecvFinishedRequest for request " << request_id;
     MarkRecvFinishedRequest request;
@@ -337,6 +385,10 @@ class GrpcRemoteWorker : public WorkerInterface {
   WorkerCacheLogger* logger_;
   const string target_;
 
+  // Bounds the bulk requests that are outstanding to `target_`. May be null.
+  // Not owned; shared by all workers for `target_`.
+  GrpcPeerRequestLimiter* const limiter_;
+
   GrpcRemoteWorker(const GrpcRemoteWorker&) = delete;
   void operator=(const GrpcRemoteWorker&) = delete;
 };
@@ -345,9 +397,10 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
                                      thread::ThreadPool* callback_threadpool,
                                      WorkerCacheLogger* logger,
-                                     const string& target) {
+                                     const string& target,
+                                     GrpcPeerRequestLimiter* limiter) {
   return new GrpcRemoteWorker(std::move(channel), completion_queue,
-                              callback_threadpool, logger, target);
+                              callback_threadpool, logger, target, limiter);
 }
 
 }  // namespace tensorflow
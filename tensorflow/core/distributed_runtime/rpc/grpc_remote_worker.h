@@ -23,14 +23,19 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 
 namespace tensorflow {
+class GrpcPeerRequestLimiter;
 class WorkerCacheLogger;
 class WorkerInterface;
 
+// If `limiter` is not null, the RecvTensor and RecvBuf requests of the
+// returned worker are admitted through it. `limiter` and `logger` must
+// outlive the worker and its outstanding requests.
 WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
                                      thread::ThreadPool* callback_threadpool,
                                      WorkerCacheLogger* logger,
-                                     const string& target);
+                                     const string& target,
+                                     GrpcPeerRequestLimiter* limiter = nullptr);
 
 }  // namespace tensorflow
 
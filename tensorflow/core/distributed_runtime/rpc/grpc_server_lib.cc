@@ -229,6 +229,19 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
   master_env_.experimental_num_shards = std::max(1, num_tasks);
   worker_env_.experimental_num_shards = master_env_.experimental_num_shards;
 
+  TF_RETURN_IF_ERROR(RemoteTensorTransportRegistry::CreateFromEnv(
+      &worker_env_, &remote_tensor_transport_));
+  worker_env_.remote_tensor_transport = remote_tensor_transport_.get();
+  int64_t partition_graph_cache_bytes;
+  TF_RETURN_IF_ERROR(
+      ReadInt64FromEnvVar("TF_PARTITION_GRAPH_CACHE_BYTES",
+                          PartitionGraphCache::kDefaultCapacityBytes,
+                          &partition_graph_cache_bytes));
+  if (partition_graph_cache_bytes > 0) {
+    partition_graph_cache_ =
+        std::make_unique<PartitionGraphCache>(partition_graph_cache_bytes);
+    worker_env_.partition_graph_cache = partition_graph_cache_.get();
+  }
   worker_env_.rendezvous_mgr = opts.rendezvous_mgr_func == nullptr
                                    ? new RpcRendezvousMgr(&worker_env_)
                                    : opts.rendezvous_mgr_func(&worker_env_);
@@ -29,6 +29,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/stats_publisher_interface.h"
 #include "tensorflow/core/distributed_runtime/master_env.h"
+#include "tensorflow/core/distributed_runtime/partition_graph_cache.h"
+#include "tensorflow/core/distributed_runtime/remote_tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
@@ -210,6 +212,16 @@ class GrpcServer : public ServerInterface {
   std::vector<std::unique_ptr<Thread>> extra_service_threads_
       TF_GUARDED_BY(mu_);
 
+  // Optional data plane for the remote rendezvous, selected with
+  // TF_REMOTE_TENSOR_TRANSPORT. Declared before `worker_env_` so that it
+  // outlives the worker and its rendezvous.
+  std::unique_ptr<RemoteTensorTransport> remote_tensor_transport_;
+
+  // Graphs and partitions registered with the worker, kept for later
+  // sessions. Its capacity is set with TF_PARTITION_GRAPH_CACHE_BYTES, and a
+  // capacity of 0 disables it.
+  std::unique_ptr<PartitionGraphCache> partition_graph_cache_;
+
   // Implementation of a TensorFlow worker, and RPC polling thread.
   WorkerEnv worker_env_;
   std::unique_ptr<const DeviceMgr> owned_device_manager_;
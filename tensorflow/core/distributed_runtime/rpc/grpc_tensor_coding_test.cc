@@ -17,15 +17,39 @@ limitations under the License.
 
 #include "grpcpp/support/byte_buffer.h"
 #include "grpcpp/support/slice.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
 namespace tensorflow {
 
+class CpuDevice : public DeviceBase {
+ public:
+  explicit CpuDevice(Env* env) : DeviceBase(env) {
+    attr_.set_device_type("CPU");
+  }
+
+  const DeviceAttributes& attributes() const override { return attr_; }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    return cpu_allocator();
+  }
+
+ private:
+  DeviceAttributes attr_;
+};
+
 class GrpcTensorCodingTest : public ::testing::Test {
  public:
   void Validate(const Tensor& t, bool is_dead) {
@@ -100,4 +124,67 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, LargeTensorAliasesByteBuffer) {
+  Tensor t(DT_FLOAT, TensorShape({1 << 16}));
+  t.flat<float>().setRandom();
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(/*is_dead=*/false, t, false, &buf);
+
+  CpuDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  ASSERT_TRUE(GrpcMaybeParseTensorResponse(&buf, &response));
+  test::ExpectTensorEqual<float>(response.tensor(), t);
+  // The encoder puts large tensor contents in their own slice, which the
+  // parsed tensor references instead of copying.
+  EXPECT_EQ(response.tensor().tensor_data().data(), t.tensor_data().data());
+
+  // The parsed tensor keeps the aliased slice alive.
+  Tensor expected = tensor::DeepCopy(t);
+  Tensor parsed = response.tensor();
+  response.Clear();
+  buf.Clear();
+  t = Tensor();
+  test::ExpectTensorEqual<float>(parsed, expected);
+}
+
+TEST_F(GrpcTensorCodingTest, GpuCompatibleTensorIsCopied) {
+  Tensor t(DT_FLOAT, TensorShape({1 << 16}));
+  t.flat<float>().setRandom();
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(/*is_dead=*/false, t, false, &buf);
+
+  CpuDevice cpu_device(Env::Default());
+  TensorResponse response;
+  AllocatorAttributes attrs;
+  attrs.set_gpu_compatible(true);
+  response.InitAlloc(&cpu_device, attrs);
+  ASSERT_TRUE(GrpcMaybeParseTensorResponse(&buf, &response));
+  test::ExpectTensorEqual<float>(response.tensor(), t);
+  EXPECT_NE(response.tensor().tensor_data().data(), t.tensor_data().data());
+}
+
+// Decodes a RecvTensorResponse holding `state.range(0)` bytes of tensor
+// content. Reports the decoding bandwidth.
+static void BM_DecodeTensorResponse(::testing::benchmark::State& state) {
+  const int num_bytes = state.range(0);
+  Tensor t(DT_INT8, TensorShape({num_bytes}));
+  t.flat<int8>().setConstant(1);
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(/*is_dead=*/false, t, false, &buf);
+  CpuDevice cpu_device(Env::Default());
+  for (auto s : state) {
+    TensorResponse response;
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    CHECK(GrpcMaybeParseTensorResponse(&buf, &response));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_bytes);
+}
+BENCHMARK(BM_DecodeTensorResponse)
+    ->Arg(1 << 10)
+    ->Arg(1 << 20)
+    ->Arg(64 << 20)
+    ->Arg(512 << 20);
+
 }  // namespace tensorflow
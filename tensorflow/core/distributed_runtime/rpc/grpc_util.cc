@@ -15,10 +15,56 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 
+#include <cstddef>
+#include <utility>
+
+#include "grpcpp/support/slice.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 
 namespace tensorflow {
 
+namespace {
+
+// A TensorBuffer that aliases part of a gRPC slice, keeping the slice alive
+// for as long as the buffer is referenced.
+class GrpcSliceTensorBuffer : public TensorBuffer {
+ public:
+  GrpcSliceTensorBuffer(::grpc::Slice slice, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        slice_(std::move(slice)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("GrpcSlice");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const ::grpc::Slice slice_;
+  const size_t size_;
+};
+
+}  // namespace
+
+TensorBuffer* GrpcByteSource::AliasContents(const char* data, size_t size) {
+  if (slices_.empty() && !buffer_->Dump(&slices_).ok()) {
+    slices_.clear();
+    return nullptr;
+  }
+  for (const ::grpc::Slice& slice : slices_) {
+    const char* begin = reinterpret_cast<const char*>(slice.begin());
+    if (data >= begin && data + size <= begin + slice.size()) {
+      return new GrpcSliceTensorBuffer(slice, data, size);
+    }
+  }
+  return nullptr;
+}
+
 bool GrpcMaybeParseTensorResponse(::grpc::ByteBuffer* src,
                                   TensorResponse* dst) {
   ::tensorflow::GrpcByteSource byte_source(src);
@@ -18,12 +18,15 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "grpcpp/grpcpp.h"
 #include "grpcpp/impl/codegen/proto_utils.h"
 #include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
 #include "xla/tsl/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -50,6 +53,10 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Aliases `data` if it lies within a single slice of the byte buffer. The
+  // returned buffer holds a reference to that slice.
+  TensorBuffer* AliasContents(const char* data, size_t size) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
@@ -58,6 +65,8 @@ class GrpcByteSource : public TensorResponse::Source {
   }
 
   ::grpc::ByteBuffer* buffer_;  // Not owned
+  // Slices of `buffer_`, populated on the first call to AliasContents.
+  std::vector<::grpc::Slice> slices_;
   Reader* stream_ = nullptr;    // Points into space_ if non-nullptr
   char space_[sizeof(Reader)];
 };
@@ -15,8 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
 
+#include <algorithm>
+#include <memory>
+
 #include "tensorflow/core/distributed_runtime/rpc/coordination/grpc_coordination_client.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_peer_request_limiter.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
@@ -40,7 +44,27 @@ class GrpcWorkerCache : public WorkerCachePartial {
         local_worker_(local_worker),
         channel_cache_(channel_cache),
         worker_env_(worker_env),
-        next_round_robin_assignment_(0) {}
+        next_round_robin_assignment_(0) {
+    Status status = ReadInt64FromEnvVar("TF_GRPC_WORKER_MAX_IN_FLIGHT_PER_PEER",
+                                        0, &max_in_flight_per_peer_);
+    if (!status.ok()) {
+      LOG(ERROR) << "Error parsing TF_GRPC_WORKER_MAX_IN_FLIGHT_PER_PEER: "
+                 << status;
+      max_in_flight_per_peer_ = 0;
+    }
+  }
+
+  ~GrpcWorkerCache() override {
+    if (VLOG_IS_ON(1)) {
+      for (const auto& it : logger_.GetPeerRpcStats()) {
+        const WorkerCacheLogger::PeerRpcStats& stats = it.second;
+        VLOG(1) << "RPCs to " << it.first << ": " << stats.num_calls
+                << " calls, " << stats.num_errors << " errors, mean "
+                << stats.total_usecs / std::max<int64_t>(stats.num_calls, 1)
+                << "us, max " << stats.max_usecs << "us";
+      }
+    }
+  }
 
   void ListWorkers(std::vector<string>* workers) const override {
     channel_cache_->ListWorkers(workers);
@@ -62,7 +86,8 @@ class GrpcWorkerCache : public WorkerCachePartial {
       size_t index = AssignWorkerToThread(target);
       return NewGrpcRemoteWorker(
           channel, worker_env_->GetCompletionQueue(index),
-          worker_env_->GetThreadPool(), &logger_, target);
+          worker_env_->GetThreadPool(), &logger_, target,
+          GetPeerRequestLimiter(target));
     }
   }
 
@@ -112,6 +137,19 @@ class GrpcWorkerCache : public WorkerCachePartial {
     return it->second;
   }
 
+  // Returns the limiter shared by all workers for `target`, or nullptr if
+  // requests to peers are not bounded.
+  GrpcPeerRequestLimiter* GetPeerRequestLimiter(const string& target) {
+    if (max_in_flight_per_peer_ <= 0) return nullptr;
+    mutex_lock lock(assignment_mu_);
+    std::unique_ptr<GrpcPeerRequestLimiter>& limiter = limiters_[target];
+    if (limiter == nullptr) {
+      limiter =
+          std::make_unique<GrpcPeerRequestLimiter>(max_in_flight_per_peer_);
+    }
+    return limiter.get();
+  }
+
   const string local_target_;
   WorkerInterface* const local_worker_;  // Not owned.
   std::shared_ptr<GrpcChannelCache> channel_cache_;
@@ -122,6 +160,12 @@ class GrpcWorkerCache : public WorkerCachePartial {
   std::unordered_map<std::string, size_t> target_assignments_
       TF_GUARDED_BY(assignment_mu_);
   size_t next_round_robin_assignment_ TF_GUARDED_BY(assignment_mu_);
+
+  // Bound on the RecvTensor and RecvBuf requests that are outstanding to each
+  // peer, set by TF_GRPC_WORKER_MAX_IN_FLIGHT_PER_PEER. Zero disables it.
+  int64_t max_in_flight_per_peer_;
+  std::unordered_map<std::string, std::unique_ptr<GrpcPeerRequestLimiter>>
+      limiters_ TF_GUARDED_BY(assignment_mu_);
 };
 
 }  // namespace
@@ -153,8 +197,14 @@ GrpcWorkerEnv::GrpcWorkerCacheThread::~GrpcWorkerCacheThread() {
 
 GrpcWorkerEnv* CreateGrpcWorkerEnv() {
   int num_cpus = port::NumSchedulableCPUs();
+  // Each completion queue is polled by its own thread. Keep the historical
+  // default of 64 on small hosts, but give large hosts one queue per core so
+  // that many peers do not share a poller.
+  const int64_t default_num_completion_queues =
+      std::clamp<int64_t>(num_cpus, 64, 256);
   int64_t num_completion_queues;
-  Status status = ReadInt64FromEnvVar("TF_GRPC_WORKER_CACHE_QUEUES", 64,
+  Status status = ReadInt64FromEnvVar("TF_GRPC_WORKER_CACHE_QUEUES",
+                                      default_num_completion_queues,
                                       &num_completion_queues);
   if (!status.ok()) {
     LOG(ERROR) << "Error parsing TF_GRPC_WORKER_CACHE_QUEUES: " << status;
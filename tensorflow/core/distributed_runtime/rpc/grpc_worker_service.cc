@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
+#include "tensorflow/core/distributed_runtime/remote_tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
@@ -447,13 +448,40 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
 
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
-    if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+  RemoteTensorTransport* transport =
+      request->has_transport_options() ? env_->remote_tensor_transport
+                                       : nullptr;
+  auto do_response = [request, response, done, cache_enabled, transport](
+                         const Tensor& tensor, bool is_dead,
+                         const Status& status) {
+    if (!status.ok() || transport == nullptr || is_dead) {
+      if (status.ok()) {
+        grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled,
+                                       response);
+      }
+      done(status);
+      return;
     }
-    done(status);
+    // Let the transport write the tensor contents directly to the receiver,
+    // and only send the metadata it returns over gRPC.
+    auto metadata = std::make_shared<RecvTensorResponse>();
+    transport->SendAsync(
+        *request, tensor, metadata.get(),
+        [response, done, cache_enabled, tensor, metadata](const Status& s,
+                                                          bool delivered) {
+          if (!s.ok()) {
+            done(s);
+            return;
+          }
+          if (delivered) {
+            done(FromGrpcStatus(
+                tsl::GrpcMaybeUnparseProto(*metadata, response)));
+          } else {
+            grpc::EncodeTensorToByteBuffer(/*is_dead=*/false, tensor,
+                                           cache_enabled, response);
+            done(absl::OkStatus());
+          }
+        });
   };
 
   // If response cache is enabled and the response cache already contains the
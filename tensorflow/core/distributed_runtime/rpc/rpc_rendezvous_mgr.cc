@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/remote_tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
@@ -71,6 +72,28 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     req_.set_request_id(GetUniqueRequestId());
   }
 
+  // Lets `transport` deliver the tensor contents out of band, if it accepts
+  // this recv.
+  void MaybePrepareTransport(RemoteTensorTransport* transport,
+                             const Rendezvous::ParsedKey& parsed) {
+    if (transport != nullptr &&
+        transport->PrepareRecv(parsed, dst_device_, alloc_attrs_, &req_)) {
+      transport_ = transport;
+    }
+  }
+
+  // Releases what the transport reserved for a call that is aborted before
+  // its RPC is sent.
+  void AbortTransport(const Status& s) {
+    if (transport_ == nullptr) return;
+    bool delivered = false;
+    transport_
+        ->FinishRecv(s, req_, RecvTensorResponse(), dst_device_, alloc_attrs_,
+                     &transport_tensor_, &delivered)
+        .IgnoreError();
+    transport_ = nullptr;
+  }
+
   void Reset() {
     // The RpcRemoteRendezvous using this object is responsible for calling
     // ReleaseWorker() before Reset().
@@ -79,6 +102,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
 
     alloc_attrs_ = AllocatorAttributes();
     dst_device_ = nullptr;
+    transport_ = nullptr;
+    transport_tensor_ = Tensor();
+    delivered_by_transport_ = false;
     // We don't clear opts_ and assume that Init will set up the state for
     // opts_ appropriately.
     req_.Clear();
@@ -122,7 +148,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     wi_ = nullptr;
   }
 
-  const Tensor& tensor() const { return resp_.tensor(); }
+  const Tensor& tensor() const {
+    return delivered_by_transport_ ? transport_tensor_ : resp_.tensor();
+  }
 
   bool is_dead() const { return resp_.metadata().is_dead(); }
 
@@ -142,9 +170,15 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
       // Make sure the Rendezvous abort checking is finished before running the
       // callback, which might destroy the current call object.
       abort_checked->WaitForNotification();
-      if (!s.ok()) {
+      Status status = s;
+      if (transport_ != nullptr) {
+        status.Update(transport_->FinishRecv(
+            s, req_, resp_.metadata(), dst_device_, alloc_attrs_,
+            &transport_tensor_, &delivered_by_transport_));
+      }
+      if (!status.ok()) {
         mutex_lock l(mu_);
-        status_.Update(s);
+        status_.Update(status);
       }
       recv_done();
     };
@@ -172,6 +206,10 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   WorkerInterface* wi_;  // Not owned.
   AllocatorAttributes alloc_attrs_;
   Device* dst_device_;
+  // Set if `transport_` accepted this recv in `MaybePrepareTransport`.
+  RemoteTensorTransport* transport_ = nullptr;  // Not owned.
+  Tensor transport_tensor_;
+  bool delivered_by_transport_ = false;
   CallOptions opts_;
   RecvTensorRequest req_;
   TensorResponse resp_;
@@ -271,6 +309,7 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
              recv_args, std::move(done));
+  call->MaybePrepareTransport(env_->remote_tensor_transport, parsed);
 
   // Record "call" in calls_ so that it can be aborted cleanly.
   RegisterCall(call, recv_args);
@@ -278,6 +317,7 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   // RendezvousMgr already aborted, shouldn't send RPC call any more
   if (!call->status().ok()) {
     DeregisterCall(call, recv_args);
+    call->AbortTransport(call->status());
     // NOTE: `*sess` can potentially be deleted before we return from
     // `call->done()(...)`, so we must release the worker before calling the
     // callback.
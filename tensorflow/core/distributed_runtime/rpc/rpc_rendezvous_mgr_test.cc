@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/remote_tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/test_utils.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/control_flow.h"
@@ -342,4 +343,139 @@ TEST_F(RpcRendezvousMgrTest, RemoteRecvAsyncMany) {
   rmgr_.Cleanup(step_id);
 }
 
+namespace {
+// A transport that delivers every tensor it accepts out of band as the string
+// "out of band", or fails with `finish_status` if it is set.
+class FakeRemoteTensorTransport : public RemoteTensorTransport {
+ public:
+  std::string name() const override { return "fake"; }
+
+  bool PrepareRecv(const Rendezvous::ParsedKey& parsed, Device* dst_device,
+                   const AllocatorAttributes& alloc_attrs,
+                   RecvTensorRequest* request) override {
+    request->mutable_transport_options()->set_type_url("fake");
+    mutex_lock l(mu_);
+    ++num_prepared_;
+    return true;
+  }
+
+  Status FinishRecv(const Status& rpc_status, const RecvTensorRequest& request,
+                    const RecvTensorResponse& response, Device* dst_device,
+                    const AllocatorAttributes& alloc_attrs, Tensor* tensor,
+                    bool* delivered) override {
+    mutex_lock l(mu_);
+    ++num_finished_;
+    last_rpc_status_ = rpc_status;
+    *delivered = false;
+    if (!rpc_status.ok()) return absl::OkStatus();
+    if (!finish_status_.ok()) return finish_status_;
+    *tensor = V("out of band");
+    *delivered = true;
+    return absl::OkStatus();
+  }
+
+  void SendAsync(const RecvTensorRequest& request, const Tensor& tensor,
+                 RecvTensorResponse* response,
+                 SendDoneCallback done) override {
+    done(absl::OkStatus(), /*delivered=*/false);
+  }
+
+  void set_finish_status(const Status& s) {
+    mutex_lock l(mu_);
+    finish_status_ = s;
+  }
+  int num_prepared() {
+    mutex_lock l(mu_);
+    return num_prepared_;
+  }
+  int num_finished() {
+    mutex_lock l(mu_);
+    return num_finished_;
+  }
+  Status last_rpc_status() {
+    mutex_lock l(mu_);
+    return last_rpc_status_;
+  }
+
+ private:
+  mutex mu_;
+  Status finish_status_ TF_GUARDED_BY(mu_);
+  Status last_rpc_status_ TF_GUARDED_BY(mu_);
+  int num_prepared_ TF_GUARDED_BY(mu_) = 0;
+  int num_finished_ TF_GUARDED_BY(mu_) = 0;
+};
+}  // namespace
+
+TEST_F(RpcRendezvousMgrTest, RemoteRecvThroughTransport) {
+  FakeRemoteTensorTransport transport;
+  env.remote_tensor_transport = &transport;
+  const int64_t step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:worker/replica:1/task:2/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:1", "foo", FrameAndIter(0, 0)));
+  {
+    tsl::core::RefCountPtr<RemoteRendezvous> rendez = rmgr_.Find(step_id);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+    Tensor val(DT_STRING);
+    bool val_dead = false;
+    TF_ASSERT_OK(rendez->Recv(key, Rendezvous::Args(), &val, &val_dead));
+    EXPECT_EQ(V(val), "out of band");
+    EXPECT_FALSE(val_dead);
+  }
+  rmgr_.Cleanup(step_id);
+  EXPECT_EQ(transport.num_prepared(), 1);
+  EXPECT_EQ(transport.num_finished(), 1);
+  TF_EXPECT_OK(transport.last_rpc_status());
+  env.remote_tensor_transport = nullptr;
+}
+
+TEST_F(RpcRendezvousMgrTest, RemoteRecvThroughTransportFails) {
+  FakeRemoteTensorTransport transport;
+  transport.set_finish_status(errors::Internal("transport failed"));
+  env.remote_tensor_transport = &transport;
+  const int64_t step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:worker/replica:1/task:2/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:1", "foo", FrameAndIter(0, 0)));
+  {
+    tsl::core::RefCountPtr<RemoteRendezvous> rendez = rmgr_.Find(step_id);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+    Tensor val(DT_STRING);
+    bool val_dead = false;
+    Status s = rendez->Recv(key, Rendezvous::Args(), &val, &val_dead);
+    EXPECT_TRUE(errors::IsInternal(s)) << s;
+  }
+  rmgr_.Cleanup(step_id);
+  EXPECT_EQ(transport.num_prepared(), 1);
+  EXPECT_EQ(transport.num_finished(), 1);
+  env.remote_tensor_transport = nullptr;
+}
+
+TEST_F(RpcRendezvousMgrTest, AbortedRemoteRecvReleasesTransport) {
+  FakeRemoteTensorTransport transport;
+  env.remote_tensor_transport = &transport;
+  const int64_t step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:worker/replica:1/task:2/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:1", "foo", FrameAndIter(0, 0)));
+  {
+    tsl::core::RefCountPtr<RemoteRendezvous> rendez = rmgr_.Find(step_id);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+    // The call is aborted when it is registered, before its RPC is sent.
+    CancellationManager cm;
+    cm.StartCancel();
+    Rendezvous::Args args;
+    args.cancellation_manager = &cm;
+    Tensor val(DT_STRING);
+    bool val_dead = false;
+    Status s = rendez->Recv(key, args, &val, &val_dead);
+    EXPECT_TRUE(errors::IsCancelled(s)) << s;
+  }
+  rmgr_.Cleanup(step_id);
+  EXPECT_EQ(transport.num_prepared(), 1);
+  EXPECT_EQ(transport.num_finished(), 1);
+  EXPECT_TRUE(errors::IsCancelled(transport.last_rpc_status()));
+  env.remote_tensor_transport = nullptr;
+}
+
 }  // namespace tensorflow
@@ -17,11 +17,13 @@ limitations under the License.
 
 #include <algorithm>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "xla/tsl/distributed_runtime/coordination/coordination_service.h"
+#include "xla/tsl/distributed_runtime/coordination/coordination_service_aggregator.h"
 #include "xla/tsl/distributed_runtime/coordination/coordination_service_agent.h"
 #include "tensorflow/core/activity_watcher/activity.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -304,6 +306,28 @@ Status SessionMgr::CreateSession(
         agent_cache->GetOwnedClient(coordination_config.service_leader()),
         std::move(coordination_error_callback)));
 
+    // In hierarchical mode, route the requests that the parent task
+    // aggregates through it, and aggregate those of our own subtree.
+    CoordinatedTask task;
+    task.set_job_name(server_def.job_name());
+    task.set_task_id(server_def.task_index());
+    std::optional<CoordinatedTask> parent =
+        tsl::GetCoordinationParent(coordination_config, task);
+    if (parent.has_value()) {
+      const std::string parent_name = strings::StrCat(
+          "/job:", parent->job_name(), "/replica:0/task:", parent->task_id());
+      TF_RETURN_IF_ERROR(coordination_service_agent_->SetParentClient(
+          agent_cache->GetOwnedClient(parent_name)));
+      if (coordination_handler_ != nullptr &&
+          !tsl::GetCoordinationSubtree(coordination_config, task).empty()) {
+        coordination_aggregator_ = tsl::CoordinationServiceAggregator::Create(
+            worker_env_->env, coordination_config, task,
+            agent_cache->GetOwnedClient(parent_name));
+        coordination_handler_->SetAggregatorInstance(
+            coordination_aggregator_.get());
+      }
+    }
+
     activity_watcher::MaybeEnableMultiWorkersWatching(
         coordination_service_agent_.get());
   }
@@ -515,6 +539,10 @@ void SessionMgr::TeardownCoordinationService() {
 }
 
 void SessionMgr::TeardownCoordinationServiceAgent() {
+  if (coordination_aggregator_ != nullptr && coordination_handler_ != nullptr) {
+    coordination_handler_->SetAggregatorInstance(nullptr);
+  }
+  coordination_aggregator_ = nullptr;
   coordination_service_agent_ = nullptr;
 }
 }  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include <string>
 
 #include "xla/tsl/distributed_runtime/coordination/coordination_service.h"
+#include "xla/tsl/distributed_runtime/coordination/coordination_service_aggregator.h"
 #include "xla/tsl/distributed_runtime/coordination/coordination_service_agent.h"
 #include "xla/tsl/distributed_runtime/coordination/coordination_service_rpc_handler.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
@@ -134,6 +135,8 @@ class SessionMgr {
   std::shared_ptr<WorkerSession> legacy_session_;
   std::unique_ptr<tsl::CoordinationServiceInterface> coordination_service_;
   std::unique_ptr<tsl::CoordinationServiceAgent> coordination_service_agent_;
+  // Set on inner tasks of the tree in hierarchical coordination mode.
+  std::shared_ptr<tsl::CoordinationServiceAggregator> coordination_aggregator_;
 
   bool is_logging_active_ = false;
 
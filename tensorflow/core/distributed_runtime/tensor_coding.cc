@@ -30,6 +30,7 @@ void TensorResponse::Clear() {
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
+  host_allocator_ = nullptr;
   already_used_ = false;
   ClearTensor();
 }
@@ -48,6 +49,12 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
     on_host_ = true;
   }
   allocator_ = device_->GetAllocator(alloc_attrs_);
+  if (!on_host_) {
+    AllocatorAttributes host_attrs;
+    host_attrs.set_on_host(true);
+    host_attrs.set_gpu_compatible(true);
+    host_allocator_ = device_->GetAllocator(host_attrs);
+  }
 }
 
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
@@ -81,6 +88,8 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response,
 
 Status TensorResponse::ParseFrom(Source* source) {
   if (!on_host_) {
+    if (ParseFastToDevice(source).ok()) return absl::OkStatus();
+    meta_.Clear();
     protobuf::io::CodedInputStream input(source->contents());
 
     // Pre-parse into local storage, then delegate to device.
@@ -101,7 +110,7 @@ Status TensorResponse::ParseFrom(Source* source) {
     ClearTensor();
   }
   already_used_ = true;
-  if (ParseFast(source)) return absl::OkStatus();
+  if (ParseFast(source, allocator_)) return absl::OkStatus();
   meta_.Clear();
   if (ParseSlow(source)) return absl::OkStatus();
   return errors::InvalidArgument("Cannot parse tensor from response");
@@ -144,7 +153,8 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    protobuf::io::CodedInputStream* input, Source* source,
+    Allocator* allocator, TensorProto* tensor_meta) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -155,7 +165,7 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         tensor_ = std::move(t);
       }
       return ok;
@@ -195,12 +205,17 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        if (shape.num_elements() * DataTypeSize(tensor_meta->dtype()) !=
+            num_bytes) {
+          return false;
+        }
+        if (MaybeAliasTensorContent(input, source, allocator, num_bytes,
+                                    *tensor_meta)) {
+          break;
+        }
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -215,7 +230,37 @@ bool TensorResponse::ParseTensorSubmessage(
   }
 }
 
-bool TensorResponse::ParseFast(Source* source) {
+bool TensorResponse::MaybeAliasTensorContent(
+    protobuf::io::CodedInputStream* input, Source* source,
+    Allocator* allocator, int num_bytes, const TensorProto& tensor_meta) {
+  // Aliasing hands out memory that did not come from `allocator_`, which is
+  // only acceptable for plain host memory.
+  if (!on_host_ || allocator != allocator_ || alloc_attrs_.gpu_compatible() ||
+      alloc_attrs_.nic_compatible() ||
+      static_cast<size_t>(num_bytes) < kMinAliasedBytes) {
+    return false;
+  }
+  const void* data;
+  int size;
+  if (!input->GetDirectBufferPointer(&data, &size) || size < num_bytes) {
+    return false;
+  }
+  const char* content = static_cast<const char*>(data);
+#if EIGEN_MAX_ALIGN_BYTES > 0
+  if (reinterpret_cast<intptr_t>(content) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return false;
+  }
+#endif
+  core::RefCountPtr<TensorBuffer> buf(
+      source->AliasContents(content, num_bytes));
+  if (!buf) return false;
+  if (!input->Skip(num_bytes)) return false;
+  tensor_ = Tensor(tensor_meta.dtype(), TensorShape(tensor_meta.tensor_shape()),
+                   std::move(buf));
+  return true;
+}
+
+bool TensorResponse::ParseFast(Source* source, Allocator* allocator) {
   protobuf::io::CodedInputStream input(source->contents());
   while (true) {
     auto p = input.ReadTagWithCutoff(127);
@@ -232,8 +277,8 @@ bool TensorResponse::ParseFast(Source* source) {
         if (!ReadVarintSizeAsInt(&input, &length)) return false;
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
-        if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+        if (p.second < 0 || !ParseTensorSubmessage(&input, source, allocator,
+                                                   meta_.mutable_tensor())) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -275,6 +320,30 @@ bool TensorResponse::ParseFast(Source* source) {
   return false;
 }
 
+Status TensorResponse::ParseFastToDevice(Source* source) {
+  const DeviceBase::AcceleratorDeviceInfo* device_info =
+      device_->tensorflow_accelerator_device_info();
+  if (device_info == nullptr || device_info->default_context == nullptr ||
+      host_allocator_ == nullptr) {
+    return errors::Unimplemented("Device does not support host staging");
+  }
+  ClearTensor();
+  if (!ParseFast(source, host_allocator_)) {
+    return errors::InvalidArgument("Cannot parse tensor from response");
+  }
+  if (!meta_.has_tensor()) return absl::OkStatus();
+  Tensor host_tensor = std::move(tensor_);
+  Tensor device_tensor(allocator_, host_tensor.dtype(), host_tensor.shape());
+  if (host_tensor.NumElements() > 0) {
+    // `device_` is the `Device` passed to `InitAlloc` by the rendezvous.
+    TF_RETURN_IF_ERROR(device_info->default_context->CopyCPUTensorToDeviceSync(
+        &host_tensor, static_cast<Device*>(device_), &device_tensor));
+  }
+  tensor_ = std::move(device_tensor);
+  meta_.clear_tensor();
+  return absl::OkStatus();
+}
+
 bool TensorResponse::ParseSlow(Source* source) {
   if (!meta_.ParseFromZeroCopyStream(source->contents())) {
     return false;
@@ -63,6 +63,17 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // Returns a buffer that aliases the `size` bytes at `data` and keeps them
+    // alive, or nullptr if that is not possible. `data` must point into a
+    // buffer returned by the stream from the latest call to contents(). The
+    // caller takes ownership of a reference to the returned buffer.
+    //
+    // The default implementation returns nullptr, in which case tensor
+    // contents are copied out of the stream.
+    virtual TensorBuffer* AliasContents(const char* data, size_t size) {
+      return nullptr;
+    }
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -91,15 +102,31 @@ class TensorResponse {
   DeviceBase* device() const { return device_; }
 
  private:
+  // Tensor contents of at least this many bytes are aliased instead of copied
+  // when the source allows it.
+  static constexpr size_t kMinAliasedBytes = 64 << 10;
+
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
+                             Source* source, Allocator* allocator,
                              TensorProto* tensor_meta);
-  bool ParseFast(Source* source);
+  // Points `tensor_` at the next `num_bytes` of `input` without copying them,
+  // if `source` allows it and the data is suitably aligned.
+  bool MaybeAliasTensorContent(protobuf::io::CodedInputStream* input,
+                               Source* source, Allocator* allocator,
+                               int num_bytes, const TensorProto& tensor_meta);
+  bool ParseFast(Source* source, Allocator* allocator);
   bool ParseSlow(Source* source);
+  // Parses into a host tensor allocated with `host_allocator_`, then copies it
+  // to the device. This avoids the intermediate serialized TensorProto that
+  // `DeviceBase::MakeTensorFromProto` needs.
+  Status ParseFastToDevice(Source* source);
 
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
+  // Allocator for host staging tensors, when the device is not the host.
+  Allocator* host_allocator_ = nullptr;
   bool already_used_ = false;
   Tensor tensor_;
   RecvTensorResponse meta_;
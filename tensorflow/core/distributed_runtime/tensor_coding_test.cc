@@ -187,8 +187,13 @@ static void BM_TensorResponse(::testing::benchmark::State& state) {
     bytes = response.tensor().TotalBytes();
   }
   state.SetLabel(strings::StrCat("Bytes: ", bytes));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * bytes);
 }
-BENCHMARK(BM_TensorResponse)->Arg(0)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_TensorResponse)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(64 << 20);
 
 static void BM_TensorViaTensorProto(::testing::benchmark::State& state) {
   const int arg = state.range(0);
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/error_payloads.h"
+#include "tensorflow/core/distributed_runtime/partition_graph_cache.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
@@ -85,12 +86,35 @@ void Worker::RegisterGraphAsync(const RegisterGraphRequest* request,
   } else {
     session = env_->session_mgr->LegacySession();
   }
+  PartitionGraphCache* cache = env_->partition_graph_cache;
+  const GraphDef* graph_def = &request->graph_def();
+  std::shared_ptr<const GraphDef> cached_graph_def;
+  if (s.ok() && request->graph_def_omitted()) {
+    // The master sends the graph by fingerprint only when it expects us to
+    // have seen it before. On a miss it retries with the full graph.
+    if (cache != nullptr) {
+      cached_graph_def = cache->LookupGraph(request->graph_fingerprint());
+    }
+    if (cached_graph_def == nullptr) {
+      s = errors::NotFound("Graph with fingerprint ",
+                           request->graph_fingerprint(),
+                           " is not cached on this worker");
+    } else {
+      graph_def = cached_graph_def.get();
+    }
+  }
+  const string graph_fingerprint =
+      cache != nullptr ? request->graph_fingerprint() : "";
   if (s.ok()) {
     s = session->graph_mgr()->Register(
-        request->session_handle(), request->graph_def(),
-        request->graph_options(), request->debug_options(),
-        request->config_proto(), request->collective_graph_key(), session.get(),
-        session->cluster_flr(), response->mutable_graph_handle());
+        request->session_handle(), *graph_def, request->graph_options(),
+        request->debug_options(), request->config_proto(),
+        request->collective_graph_key(), session.get(), session->cluster_flr(),
+        graph_fingerprint, response->mutable_graph_handle());
+  }
+  if (s.ok() && cached_graph_def == nullptr && !graph_fingerprint.empty()) {
+    cache->InsertGraph(graph_fingerprint,
+                       std::make_shared<const GraphDef>(request->graph_def()));
   }
   done(s);
 }
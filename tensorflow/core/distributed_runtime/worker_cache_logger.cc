@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor_description.pb.h"
@@ -130,4 +132,20 @@ void WorkerCacheLogger::RecordDataTransfer(int64_t step_id, int64_t start_usecs,
   Save(dst_device, step_id, ns);
 }
 
+void WorkerCacheLogger::RecordRpcLatency(const string& target, int64_t usecs,
+                                         bool ok) {
+  mutex_lock l(peer_stats_mu_);
+  PeerRpcStats& stats = peer_stats_[target];
+  ++stats.num_calls;
+  if (!ok) ++stats.num_errors;
+  stats.total_usecs += usecs;
+  stats.max_usecs = std::max(stats.max_usecs, usecs);
+}
+
+std::unordered_map<string, WorkerCacheLogger::PeerRpcStats>
+WorkerCacheLogger::GetPeerRpcStats() {
+  mutex_lock l(peer_stats_mu_);
+  return peer_stats_;
+}
+
 }  // namespace tensorflow
@@ -68,6 +68,21 @@ class WorkerCacheLogger {
                           int64_t bytes, const string& details,
                           const string& transfer_method_name);
 
+  // Latency statistics of the RPCs issued to one peer.
+  struct PeerRpcStats {
+    int64_t num_calls = 0;
+    int64_t num_errors = 0;
+    int64_t total_usecs = 0;
+    int64_t max_usecs = 0;
+  };
+
+  // Records an RPC to `target` that took `usecs` and completed with
+  // `ok`. Unlike the step logs, these statistics are always collected.
+  void RecordRpcLatency(const string& target, int64_t usecs, bool ok);
+
+  // Returns the statistics of all RPCs recorded so far, keyed by peer.
+  std::unordered_map<string, PeerRpcStats> GetPeerRpcStats();
+
  private:
   mutex count_mu_;
   int32 want_logging_count_ TF_GUARDED_BY(count_mu_) = 0;
@@ -80,6 +95,10 @@ class WorkerCacheLogger {
   mutex mu_;
   LogMap log_map_ TF_GUARDED_BY(mu_);
 
+  mutex peer_stats_mu_;
+  std::unordered_map<string, PeerRpcStats> peer_stats_
+      TF_GUARDED_BY(peer_stats_mu_);
+
   // Records "ns" in log_map_ under the given device and step.
   void Save(const string& device, int64_t step_id, NodeExecStats* ns);
 
@@ -36,6 +36,8 @@ using tsl::thread::ThreadPool;
 class CollectiveExecutorMgrInterface;
 class Device;
 class DeviceMgr;
+class PartitionGraphCache;
+class RemoteTensorTransport;
 class RendezvousMgrInterface;
 class SessionMgr;
 
@@ -66,6 +68,15 @@ struct WorkerEnv {
   // A set of rendezvous keyed by step ids.
   RendezvousMgrInterface* rendezvous_mgr = nullptr;
 
+  // Optional data plane for tensors exchanged by the remote rendezvous. If
+  // null, tensors are sent inline in RecvTensor RPCs.
+  RemoteTensorTransport* remote_tensor_transport = nullptr;
+
+  // Optional cache of registered graphs and their partitions, shared by all
+  // sessions of this worker. If null, graphs are always partitioned anew and
+  // the master must send the full graph in every RegisterGraph call.
+  PartitionGraphCache* partition_graph_cache = nullptr;
+
   // Generates per-step CollectiveExecutors and has access to utilities
   // supporting collective operations.
   std::unique_ptr<CollectiveExecutorMgrInterface> collective_executor_mgr;
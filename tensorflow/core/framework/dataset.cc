@@ -1144,12 +1144,14 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
   auto model = ctx->model();
   bool output_was_recording =
       node_ && node_->output() && node_->output()->is_recording();
+  int64_t start_nanos = 0;
   if (collect_resource_usage(ctx)) {
     int64_t now_nanos = EnvTime::NowNanos();
     if (output_was_recording) {
       node_->output()->record_stop(now_nanos);
     }
     node_->record_start(now_nanos);
+    start_nanos = now_nanos;
   }
   out_tensors->clear();
   Status s = GetNextInternal(ctx, out_tensors, end_of_sequence);
@@ -1176,6 +1178,7 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
   if (collect_resource_usage(ctx)) {
     int64_t now_nanos = EnvTime::NowNanos();
     node_->record_stop(now_nanos);
+    node_->record_get_next_latency(now_nanos - start_nanos);
     if (output_was_recording) {
       node_->output()->record_start(now_nanos);
     }
@@ -156,6 +156,14 @@ class Device : public DeviceBase {
     return absl::OkStatus();
   }
 
+  // Returns the DeviceContext that the kernel of `node` runs with, or nullptr
+  // to run it with the context returned by TryGetDeviceContext(). Called once
+  // per node when an executor is created. The device keeps ownership of the
+  // returned context, which must outlive the executor.
+  virtual DeviceContext* GetNodeDeviceContext(const Node& node) {
+    return nullptr;
+  }
+
   // Returns the op segment of this device.  The caller can reuse op
   // kernels registered for the same session running on this device.
   OpSegment* op_segment() { return &op_seg_; }
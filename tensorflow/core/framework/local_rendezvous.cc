@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/local_rendezvous.h"
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <utility>
@@ -401,6 +402,7 @@ void LocalRendezvous::DoAbort(const Status& status) {
   {
     mutex_lock l(mu_);
     status_.Update(status);
+    aborted_.store(true, std::memory_order_release);
   }
   LOG_EVERY_POW_2(INFO) << "Local rendezvous is aborting with status: "
                         << status;
@@ -437,6 +439,11 @@ void LocalRendezvous::DoAbort(const Status& status) {
 }
 
 Status LocalRendezvous::status() {
+  // Every Send and RecvAsync checks the status, so avoid touching `mu_`, which
+  // is shared by all buckets, until the rendezvous has been aborted.
+  if (TF_PREDICT_TRUE(!aborted_.load(std::memory_order_acquire))) {
+    return absl::OkStatus();
+  }
   tf_shared_lock ml(mu_);
   return status_;
 }
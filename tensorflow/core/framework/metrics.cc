@@ -63,6 +63,14 @@ auto* graph_pending_queue_length_histogram = tsl::monitoring::Sampler<0>::New(
     // Power of 1.5 with bucket count 30 (> 191k)
     {tsl::monitoring::Buckets::Exponential(1, 1.5, 30)});
 
+auto* device_event_completion_latency_usecs_histogram =
+    tsl::monitoring::Sampler<0>::New(
+        {"/tensorflow/core/device_event_completion_latency_usecs",
+         "The time from queueing a callback on a device stream to the "
+         "EventMgr detecting that the stream reached it, in microseconds."},
+        // Power of 2 with bucket count 24 (> 16 seconds)
+        {tsl::monitoring::Buckets::Exponential(1, 2, 24)});
+
 auto* graph_run_input_tensor_bytes = tsl::monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_run_input_tensor_bytes",
      "The size of input tensors in bytes."},
@@ -107,6 +115,14 @@ auto* tf_data_bytes_fetched_counter = tsl::monitoring::Counter<0>::New(
 auto* tf_data_elements_counter = tsl::monitoring::Counter<1>::New(
     "/tensorflow/data/elements", "tf.data elements", "name");
 
+auto* tf_data_transformation_latency_counter =
+    tsl::monitoring::Counter<2>::New(
+        "/tensorflow/data/transformation_latency",
+        "The number of `GetNext` calls of tf.data iterators by transformation "
+        "and latency bucket. The bucket is identified by its exclusive upper "
+        "bound in microseconds, or \"inf\" for the last bucket.",
+        "name", "bucket");
+
 auto* tf_data_experiment_counter = tsl::monitoring::Counter<1>::New(
     "/tensorflow/data/experiment",
     "The number of times a tf.data experiment was applied.", "name");
@@ -168,6 +184,15 @@ auto* tf_data_used_vs_budget_ratio_histogram = tsl::monitoring::Sampler<0>::New(
     {tsl::monitoring::Buckets::Explicit(
         {0.0, 0.2, 0.4, 0.6, 0.8, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0})});
 
+auto* tf_data_padding_efficiency_histogram = tsl::monitoring::Sampler<1>::New(
+    {"/tensorflow/data/padding_efficiency",
+     "Ratio of real over padded elements in the batches produced by a tf.data "
+     "padded batching transformation.",
+     "name"},
+    // Uniform linear buckets with count 10 from 0 to 1
+    {tsl::monitoring::Buckets::Explicit(
+        {0.0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0})});
+
 auto* tf_data_buffered_vs_budget_ratio_histogram =
     tsl::monitoring::Sampler<0>::New(
         {"/tensorflow/data/buffered_vs_budget_ratio",
@@ -213,6 +238,21 @@ auto* tf_data_service_client_iterators_counter =
         "Number of tf.data service client iterators created.", "worker_uid",
         "deployment_mode", "processing_mode", "is_coordinated_read");
 
+auto* tf_data_service_client_get_element_latency =
+    tsl::monitoring::Sampler<1>::New(
+        {"/tensorflow/data/service/client_get_element_latency_usecs",
+         "Microseconds spent by tf.data service clients on successful "
+         "`GetElement` requests, by worker.",
+         "worker_address"},
+        // Power of 2 with bucket count 24 (100 microseconds to > 27 minutes).
+        {tsl::monitoring::Buckets::Exponential(100, 2, 24)});
+
+auto* tf_data_service_client_hedged_requests_counter =
+    tsl::monitoring::Counter<0>::New(
+        "/tensorflow/data/service/client_hedged_requests",
+        "Number of straggling `GetElement` requests for which tf.data service "
+        "clients issued a request to another worker.");
+
 auto* tf_data_service_cross_trainer_cache_queries_counter =
     tsl::monitoring::Counter<1>::New(
         "/tensorflow/data/service/cross_trainer_cache_queries",
@@ -220,16 +260,44 @@ auto* tf_data_service_cross_trainer_cache_queries_counter =
         "be hit or miss.",
         "cache_hit");
 
+auto* tf_data_service_cross_trainer_cache_tier_queries_counter =
+    tsl::monitoring::Counter<1>::New(
+        "/tensorflow/data/service/cross_trainer_cache_tier_queries",
+        "tf.data service cross-trainer cache queries counter, by the tier that "
+        "served the query. The tier can be memory, disk, or miss.",
+        "tier");
+
 auto* tf_data_service_cross_trainer_cache_size_bytes =
     tsl::monitoring::Gauge<int64_t, 0>::New(
         "/tensorflow/data/service/cross_trainer_cache_size_bytes",
         "tf.data service cross-trainer cache memory usage in bytes.");
 
+auto* tf_data_service_task_runner_buffer_queries_counter =
+    tsl::monitoring::Counter<2>::New(
+        "/tensorflow/data/service/task_runner_buffer_queries",
+        "tf.data service `GetElement` requests, by task runner and whether "
+        "they were served from prefetched elements.",
+        "task_runner", "buffer_hit");
+
 auto* tf_data_service_snapshot_bytes_committed =
     tsl::monitoring::Counter<0>::New(
         "/tensorflow/data/service/snapshot_bytes_committed",
         "tf.data service distributed snapshot committed bytes.");
 
+auto* tf_data_service_snapshot_writer_thread_bytes =
+    tsl::monitoring::Counter<2>::New(
+        "/tensorflow/data/service/snapshot_writer_thread_bytes",
+        "tf.data service distributed snapshot bytes stored by each writer "
+        "thread.",
+        "thread", "codec");
+
+auto* tf_data_service_snapshot_writer_thread_busy_usecs =
+    tsl::monitoring::Counter<1>::New(
+        "/tensorflow/data/service/snapshot_writer_thread_busy_usecs",
+        "Microseconds each tf.data service distributed snapshot writer thread "
+        "spent encoding and writing chunks.",
+        "thread");
+
 auto* tf_data_service_snapshot_ops_counter = tsl::monitoring::Counter<2>::New(
     "/tensorflow/data/service/snapshot_ops",
     "Number times a tf.data snapshot is saved/loaded.", "path", "op");
@@ -269,6 +337,12 @@ auto* tf_data_service_optimal_number_of_workers =
         "Estimated optimal number of tf.data service workers based on the "
         "current workload.");
 
+auto* tf_data_service_recommended_number_of_workers =
+    monitoring::Gauge<int64_t, 0>::New(
+        "/tensorflow/data/service/recommended_number_of_workers",
+        "Number of tf.data service workers recommended based on the "
+        "forecasted workload and client buffer occupancy.");
+
 auto* tf_data_filename_counter = tsl::monitoring::Counter<2>::New(
     "/tensorflow/data/filename", "The file name read by a tf.data Dataset.",
     "name", "filename");
@@ -418,6 +492,13 @@ auto* xla_compilation_time_usecs = tsl::monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilation_time_usecs",
     "The total time spent on compiling XLA graphs in microseconds.");
 
+auto* xla_resource_update_bytes = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/xla_resource_update_bytes",
+    "The number of bytes of resource variables updated by XLA computations, "
+    "in place in the buffer of the variable (aliased) or in a new buffer "
+    "(copied).",
+    "kind");
+
 auto* xla_tpu_spmd_cores_per_replica = tsl::monitoring::Counter<1>::New(
     "/tensorflow/tpu/xla_spmd_cores_per_replica",
     "The number of cores used by XLA SPMD-replicated models.", "cores");
@@ -516,6 +597,11 @@ tsl::monitoring::CounterCell* GetTFDataElementsCounter(const string& name) {
   return tf_data_elements_counter->GetCell(name);
 }
 
+tsl::monitoring::CounterCell* GetTFDataTransformationLatencyCounter(
+    const string& name, const string& bucket) {
+  return tf_data_transformation_latency_counter->GetCell(name, bucket);
+}
+
 tsl::monitoring::GaugeCell<std::function<std::string()>>* GetTFDataModelGauge(
     const string& id) {
   return tf_data_model_gauge->GetCell(id);
@@ -580,6 +666,10 @@ void RecordTFDataAutotuneUsedRamBudgetRatio(const double ratio) {
   tf_data_used_vs_budget_ratio_histogram_cell->Add(ratio);
 }
 
+void RecordTFDataPaddingEfficiency(const string& name, double efficiency) {
+  tf_data_padding_efficiency_histogram->GetCell(name)->Add(efficiency);
+}
+
 void RecordTFDataAutotuneMaxBufferBudgetRatio(const double ratio) {
   static auto* tf_data_buffered_vs_budget_ratio_histogram_cell =
       tf_data_buffered_vs_budget_ratio_histogram->GetCell();
@@ -640,6 +730,16 @@ void RecordTFDataServiceClientIterators(
       ->IncrementBy(1);
 }
 
+void RecordTFDataServiceClientGetElementLatency(const string& worker_address,
+                                                int64_t latency_usecs) {
+  tf_data_service_client_get_element_latency->GetCell(worker_address)
+      ->Add(latency_usecs);
+}
+
+void RecordTFDataServiceClientHedgedRequest() {
+  tf_data_service_client_hedged_requests_counter->GetCell()->IncrementBy(1);
+}
+
 void RecordTFDataServiceDataTransferProtocolUsed(
     const string& data_transfer_protocol, bool user_specified) {
   std::string nature = user_specified ? "specified" : "default";
@@ -670,15 +770,39 @@ void RecordTFDataServiceCrossTrainerCacheQuery(bool cache_hit) {
       ->IncrementBy(1);
 }
 
+void RecordTFDataServiceCrossTrainerCacheTierQuery(const string& tier) {
+  tf_data_service_cross_trainer_cache_tier_queries_counter->GetCell(tier)
+      ->IncrementBy(1);
+}
+
 void RecordTFDataServiceCrossTrainerCacheSizeBytes(size_t bytes) {
   tf_data_service_cross_trainer_cache_size_bytes->GetCell()->Set(
       static_cast<int64_t>(bytes));
 }
 
+void RecordTFDataServiceTaskRunnerBufferQuery(const string& task_runner,
+                                              bool buffer_hit) {
+  std::string buffer_hit_str = buffer_hit ? "true" : "false";
+  tf_data_service_task_runner_buffer_queries_counter
+      ->GetCell(task_runner, buffer_hit_str)
+      ->IncrementBy(1);
+}
+
 void RecordTFDataServiceSnapshotBytesCommitted(int64_t bytes) {
   tf_data_service_snapshot_bytes_committed->GetCell()->IncrementBy(bytes);
 }
 
+void RecordTFDataServiceSnapshotWriterThreadBytes(int64_t thread_index,
+                                                  const string& codec,
+                                                  int64_t bytes,
+                                                  int64_t busy_usecs) {
+  const std::string thread = absl::StrCat(thread_index);
+  tf_data_service_snapshot_writer_thread_bytes->GetCell(thread, codec)
+      ->IncrementBy(bytes);
+  tf_data_service_snapshot_writer_thread_busy_usecs->GetCell(thread)
+      ->IncrementBy(busy_usecs);
+}
+
 void RecordTFDataServiceSnapshotOp(const std::string& path,
                                    const std::string& op) {
   tf_data_service_snapshot_ops_counter->GetCell(path, op)->IncrementBy(1);
@@ -688,6 +812,11 @@ void RecordTFDataServiceOptimalNumberOfWorkers(int64_t number_of_workers) {
   tf_data_service_optimal_number_of_workers->GetCell()->Set(number_of_workers);
 }
 
+void RecordTFDataServiceRecommendedNumberOfWorkers(int64_t number_of_workers) {
+  tf_data_service_recommended_number_of_workers->GetCell()->Set(
+      number_of_workers);
+}
+
 void RecordTFDataFilename(const string& name, const string& filename) {
   tf_data_filename_counter->GetCell(name, filename)->IncrementBy(1);
 }
@@ -815,6 +944,12 @@ void UpdateGraphPendingQueueLength(uint64 len) {
   graph_pending_queue_length_cell->Add(len);
 }
 
+void UpdateDeviceEventCompletionLatency(uint64 latency_usecs) {
+  static auto* device_event_completion_latency_cell =
+      device_event_completion_latency_usecs_histogram->GetCell();
+  device_event_completion_latency_cell->Add(latency_usecs);
+}
+
 void UpdateGraphBuildTime(const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
     static auto* build_graph_calls_cell = build_graph_calls->GetCell();
@@ -921,6 +1056,12 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs) {
   }
 }
 
+void UpdateXlaResourceUpdateBytes(bool aliased, int64_t bytes) {
+  static auto* aliased_cell = xla_resource_update_bytes->GetCell("aliased");
+  static auto* copied_cell = xla_resource_update_bytes->GetCell("copied");
+  (aliased ? aliased_cell : copied_cell)->IncrementBy(bytes);
+}
+
 void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
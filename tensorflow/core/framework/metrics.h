@@ -72,6 +72,15 @@ monitoring::CounterCell* GetTFDataBytesReadCounter(const string& name);
 // The `name` argument identifies the Dataset type (e.g. "Batch" or "Map").
 monitoring::CounterCell* GetTFDataElementsCounter(const string& name);
 
+// Returns a counter that can be used to record the number of `GetNext` calls
+// of the iterators of a tf.data.Dataset type that fell into a latency bucket.
+//
+// The `name` argument identifies the Dataset type (e.g. "Batch" or "Map") and
+// the `bucket` argument the exclusive upper bound of the latency bucket in
+// microseconds (or "inf" for the last bucket).
+monitoring::CounterCell* GetTFDataTransformationLatencyCounter(
+    const string& name, const string& bucket);
+
 // Returns a gauge than can be used to record the performance model information.
 //
 // The `id` argument represents the (unique) model ID.
@@ -106,6 +115,11 @@ void RecordTFDataGetNextDuration(uint64 duration_us);
 // the ram budget.
 void RecordTFDataAutotuneUsedRamBudgetRatio(const double ratio);
 
+// Records the padding efficiency of a batch produced by the tf.data padded
+// batching transformation `name`, i.e. the number of real (non-padding) values
+// in the batch divided by the total number of values in the batch.
+void RecordTFDataPaddingEfficiency(const string& name, double efficiency);
+
 // Records the histogram of ratios of tf.data autotune algorithm max buffer
 // bytes over the ram budget.
 void RecordTFDataAutotuneMaxBufferBudgetRatio(const double ratio);
@@ -156,6 +170,15 @@ void RecordTFDataServiceClientIterators(
     int64_t worker_uid, data::DeploymentMode deployment_mode,
     const data::ProcessingModeDef& processing_mode, bool is_coordinated_read);
 
+// Records the latency of a successful `GetElement` request from a tf.data
+// service client to the worker at `worker_address`.
+void RecordTFDataServiceClientGetElementLatency(const string& worker_address,
+                                                int64_t latency_usecs);
+
+// Records that a tf.data service client hedged a straggling `GetElement`
+// request by issuing a request to another worker.
+void RecordTFDataServiceClientHedgedRequest();
+
 // Records that a tf.data service worker client has been created that will use
 // `data_transfer_protocol` to get data from the worker server and whether or
 // not the user explicitly specified the protocol.
@@ -179,12 +202,30 @@ void RecordTFDataServiceDataTransferProtocolError(
 // Records tf.data service cross-trainer cache queries.
 void RecordTFDataServiceCrossTrainerCacheQuery(bool cache_hit);
 
+// Records a tf.data service cross-trainer cache query by the `tier` that served
+// it: "memory", "disk", or "miss".
+void RecordTFDataServiceCrossTrainerCacheTierQuery(const string& tier);
+
 // Records tf.data service cross-trainer cache memory usage in bytes.
 void RecordTFDataServiceCrossTrainerCacheSizeBytes(size_t bytes);
 
+// Records whether a tf.data service `GetElement` request was served from
+// elements the task runner had already prefetched. `task_runner` names the
+// task runner, e.g. "fcfs".
+void RecordTFDataServiceTaskRunnerBufferQuery(const string& task_runner,
+                                              bool buffer_hit);
+
 // Records tf.data distributed snapshot bytes committed.
 void RecordTFDataServiceSnapshotBytesCommitted(int64_t bytes);
 
+// Records that distributed snapshot writer thread `thread_index` stored `bytes`
+// with `codec` (e.g. "snappy"), and spent `busy_usecs` encoding and writing
+// them.
+void RecordTFDataServiceSnapshotWriterThreadBytes(int64_t thread_index,
+                                                  const string& codec,
+                                                  int64_t bytes,
+                                                  int64_t busy_usecs);
+
 // Records tf.data distributed snapshot save/load ops.
 void RecordTFDataServiceSnapshotOp(const std::string& path,
                                    const std::string& op);
@@ -192,6 +233,10 @@ void RecordTFDataServiceSnapshotOp(const std::string& path,
 // Records the current estimated optimal number of tf.data service workers.
 void RecordTFDataServiceOptimalNumberOfWorkers(int64_t number_of_workers);
 
+// Records the number of tf.data service workers the auto scaler recommends
+// running, taking forecasted demand and client buffer occupancy into account.
+void RecordTFDataServiceRecommendedNumberOfWorkers(int64_t number_of_workers);
+
 // Records the file name read by a tf.data Dataset.
 //
 // The `name` argument identifies the Dataset type (e.g. "TFRecordDataset").
@@ -269,6 +314,10 @@ void RecordTPUXlaSpmdCoresPerReplica(int64_t cores_per_replica);
 void UpdateGraphExecTime(const uint64 running_time_usecs);
 void UpdateGraphPendingQueueLength(uint64 len);
 
+// Records the time between queueing a callback with EventMgr::ThenExecute()
+// and detecting that its stream reached it.
+void UpdateDeviceEventCompletionLatency(uint64 latency_usecs);
+
 // Records that one output of an op of type `op_name` was unused.
 void RecordUnusedOutput(const string& op_name);
 
@@ -522,6 +571,10 @@ void UpdateTpuVariableDistributionTime(const uint64 distribution_time_usecs);
 // Updates the metrics stored about time XLA spents compiling graphs.
 void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 
+// Records `bytes` of resource variables updated by an XLA computation, either
+// in place in the buffer of the variable if `aliased`, or in a new buffer.
+void UpdateXlaResourceUpdateBytes(bool aliased, int64_t bytes);
+
 // Increments (by 1) a simple integer counter that is exposed for testing.
 void IncrementTestCounter(const string& name, const string& label);
 
@@ -2403,6 +2403,10 @@ void Model::Optimize(AutotuneAlgorithm algorithm,
       OptimizeStageBased(snapshot, optimization_params, cancellation_manager,
                          ram_budget_manager);
       break;
+    case AutotuneAlgorithm::BOTTLENECK:
+      OptimizeBottleneck(snapshot, optimization_params, cancellation_manager,
+                         ram_budget_manager);
+      break;
     default:
       VLOG(2) << "Autotuning algorithm was not recognized. Aborting "
                  "optimization.";
@@ -2473,6 +2477,9 @@ Model::ModelParameters Model::CollectTunableParameters(
 void Model::MaybeSyncStateValuesToValues(std::shared_ptr<Node> snapshot) {
   auto subtree_nodes = snapshot->CollectNodes(TraversalOrder::BFS, IsAnyNode);
   for (const auto& node : subtree_nodes) {
+    // Interleave nodes with an adaptive cycle publish the number of inputs
+    // they currently have in flight through their cycle length state.
+    node->SyncStateValuesToParameterValues(kCycleLength);
     if (!absl::StartsWith(node->name(), kDataService)) {
       continue;
     }
@@ -2576,8 +2583,10 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm,
     // Model input time is set to 0 for all optimization algorithms except for
     // stage-based optimization algorithm for historical reason. In stage-based
     // optimization algorithm, the model input time is used as a target
-    // optimization time of all stages in the pipeline.
-    if (algorithm == AutotuneAlgorithm::STAGE_BASED) {
+    // optimization time of all stages in the pipeline. The bottleneck
+    // optimization algorithm uses it the same way.
+    if (algorithm == AutotuneAlgorithm::STAGE_BASED ||
+        algorithm == AutotuneAlgorithm::BOTTLENECK) {
       model_input_time = ComputeTargetTimeNsec();
     }
     Optimize(algorithm, cpu_budget_func, ram_budget_share, fixed_ram_budget,
@@ -3020,6 +3029,121 @@ void Model::OptimizeStageBasedNonAsyncInterleaveManyNodes(
   }
 }
 
+void Model::OptimizeBottleneck(std::shared_ptr<Node> snapshot,
+                               const OptimizationParams& optimization_params,
+                               CancellationManager* cancellation_manager,
+                               RamBudgetManager& ram_budget_manager) {
+  VLOG(2) << "Starting optimization of tunable parameters with Bottleneck "
+             "optimization with a target time of "
+          << optimization_params.model_input_time() << " nanoseconds.";
+  // Start from the values the input pipeline is currently using rather than
+  // from the values of the last snapshot.
+  Node::NodeVector all_nodes =
+      snapshot->CollectNodes(TraversalOrder::BFS, IsAnyNode);
+  all_nodes.push_back(snapshot);
+  for (const auto& node : all_nodes) {
+    node->SyncStateValuesToParameterValues(kParallelism);
+    node->SyncStateValuesToParameterValues(kBufferSize);
+  }
+  ModelTiming model_timing(snapshot);
+  ModelTimingPriorityQueue priority_queue(model_timing);
+  absl::StatusOr<std::pair<double, Node*>> critical_root_status =
+      priority_queue.PopSlowestStageRoot();
+  if (!critical_root_status.ok()) {
+    metrics::RecordTFDataAutotuneStoppingCriteria("empty_critical_queue");
+    return;
+  }
+  auto [critical_time, critical_root] = critical_root_status.value();
+  const double target_time_nsec = optimization_params.model_input_time();
+  if (critical_time <= target_time_nsec) {
+    metrics::RecordTFDataAutotuneStoppingCriteria("target_time_reached");
+    return;
+  }
+  // Once the critical stage is faster than the runner-up, the runner-up is the
+  // bottleneck and is tuned in the next optimization cycle.
+  double stop_time_nsec = target_time_nsec;
+  absl::StatusOr<std::pair<double, Node*>> runner_up_status =
+      priority_queue.PopSlowestStageRoot();
+  if (runner_up_status.ok()) {
+    stop_time_nsec = std::max(stop_time_nsec, runner_up_status->first);
+  }
+  Node::ModelParameters tunable_parameters =
+      critical_root->CollectNodeTunableParameters();
+  NodeParallelismParameters node_parallelism;
+  Parameter* parallelism_parameter = node_parallelism.Get(critical_root);
+  const double max_parallelism =
+      parallelism_parameter == nullptr
+          ? 0
+          : std::min(parallelism_parameter->max,
+                     static_cast<double>(optimization_params.cpu_budget()));
+  if (parallelism_parameter != nullptr &&
+      parallelism_parameter->value < max_parallelism) {
+    while (critical_time > stop_time_nsec &&
+           parallelism_parameter->value < max_parallelism) {
+      if (cancellation_manager->IsCancelled()) {
+        return;
+      }
+      parallelism_parameter->value += 1.0;
+      if (TotalMaximumBufferedBytes(snapshot) >
+          optimization_params.ram_budget()) {
+        parallelism_parameter->value -= 1.0;
+        // Removes the `<index>` of `[<index>]` to reduce the number of labels.
+        metrics::RecordTFDataAutotuneStoppingCriteria(strings::StrCat(
+            "ram_budget_exceeded:",
+            RemoveArrayIndices(critical_root->long_name())));
+        break;
+      }
+      model_timing.ComputeNodeTotalTime(*critical_root);
+      const ModelTiming::NodeTiming* root_timing =
+          model_timing.GetTiming(critical_root);
+      const double new_time =
+          root_timing->total_time_nsec * root_timing->pipeline_ratio;
+      if (new_time >= critical_time) {
+        parallelism_parameter->value -= 1.0;
+        // Removes the `<index>` of `[<index>]` to reduce the number of labels.
+        metrics::RecordTFDataAutotuneStoppingCriteria(strings::StrCat(
+            "total_time_not_improved:",
+            RemoveArrayIndices(critical_root->long_name())));
+        break;
+      }
+      critical_time = new_time;
+    }
+  } else if (!experiments_.contains("autotune_buffer_optimization")) {
+    // The critical stage cannot be made faster, so deepen its buffer instead
+    // to absorb the variance of its producer.
+    auto buffer_size_parameter = std::find_if(
+        tunable_parameters.begin(), tunable_parameters.end(),
+        [](const std::pair<std::string, std::shared_ptr<Parameter>>&
+               parameter) { return parameter.second->name == kBufferSize; });
+    if (buffer_size_parameter == tunable_parameters.end() ||
+        buffer_size_parameter->second->value >=
+            buffer_size_parameter->second->max) {
+      // Removes the `<index>` of `[<index>]` to reduce the number of labels.
+      metrics::RecordTFDataAutotuneStoppingCriteria(strings::StrCat(
+          "no_optimizable_parameter:",
+          RemoveArrayIndices(critical_root->long_name())));
+      return;
+    }
+    Parameter* parameter = buffer_size_parameter->second.get();
+    const double old_value = parameter->value;
+    parameter->value =
+        std::min(parameter->max, std::max(old_value + 1.0, old_value * 2.0));
+    if (TotalMaximumBufferedBytes(snapshot) >
+        optimization_params.ram_budget()) {
+      parameter->value = old_value;
+      // Removes the `<index>` of `[<index>]` to reduce the number of labels.
+      metrics::RecordTFDataAutotuneStoppingCriteria(strings::StrCat(
+          "ram_budget_exceeded:",
+          RemoveArrayIndices(critical_root->long_name())));
+      return;
+    }
+  }
+  if (ram_budget_manager.RequestModelAllocation(
+          TotalMaximumBufferedBytes(snapshot))) {
+    UpdateStateValues(&tunable_parameters);
+  }
+}
+
 void Model::OptimizeBuffers(std::shared_ptr<Node> snapshot,
                             int64_t ram_budget) {
   VLOG(2) << "Starting optimization of buffer_size parameters.";
@@ -16,6 +16,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <functional>
@@ -36,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/model.pb.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/histogram/histogram.h"
@@ -73,6 +76,12 @@ constexpr double kRamBudgetShare = 0.5;
 // average of processing time per element.
 constexpr double kProcessingTimeEmaWeight = 0.1;
 
+// Number of buckets of the `GetNext` latency histogram of a node. Bucket 0
+// counts calls that took less than 1 microsecond and bucket `i > 0` counts
+// calls that took [2^(i-1), 2^i) microseconds, except that the last bucket
+// also counts all longer calls.
+constexpr int kNumLatencyBuckets = 24;
+
 enum class TraversalOrder {
   BFS = 0,
   REVERSE_BFS = 1,
@@ -489,6 +498,34 @@ class Node {
     }
   }
 
+  // Records the latency of one `GetNext` call of the iterator that the node
+  // represents, including the time spent in its inputs.
+  void record_get_next_latency(int64_t latency_nanos) TF_LOCKS_EXCLUDED(mu_) {
+    get_next_latency_buckets_[LatencyBucket(latency_nanos)].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  // Returns the number of `GetNext` calls recorded in each latency bucket.
+  std::vector<int64_t> get_next_latency_histogram() const
+      TF_LOCKS_EXCLUDED(mu_) {
+    std::vector<int64_t> histogram(kNumLatencyBuckets);
+    for (int i = 0; i < kNumLatencyBuckets; ++i) {
+      histogram[i] =
+          get_next_latency_buckets_[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+  }
+
+  // Returns the exclusive upper bound of latency bucket `bucket`, in
+  // microseconds. The last bucket has no upper bound and returns the maximum
+  // `int64_t` value.
+  static int64_t LatencyBucketLimitMicros(int bucket) {
+    if (bucket >= kNumLatencyBuckets - 1) {
+      return std::numeric_limits<int64_t>::max();
+    }
+    return int64_t{1} << bucket;
+  }
+
   // Returns whether work is currently being recorded, i.e. whether we are
   // currently between a `record_start` and a `record_stop`.
   bool is_recording() TF_LOCKS_EXCLUDED(mu_) { return work_start_ > 0; }
@@ -771,6 +808,15 @@ class Node {
                                          NodeValues* total_processing_times)
       TF_SHARED_LOCKS_REQUIRED(mu_) = 0;
 
+  // Returns the bucket of the `GetNext` latency histogram for `latency_nanos`.
+  static int LatencyBucket(int64_t latency_nanos) {
+    const int64_t latency_micros = latency_nanos / 1000;
+    if (latency_micros <= 0) {
+      return 0;
+    }
+    return std::min(Log2Floor64(latency_micros) + 1, kNumLatencyBuckets - 1);
+  }
+
   // This is the locked version of the public `CollectNodes`.
   NodeVector CollectNodesLocked(TraversalOrder order,
                                 bool collect_node(const std::shared_ptr<Node>))
@@ -842,6 +888,8 @@ class Node {
   std::atomic<int64_t> bytes_produced_;
   std::atomic<int64_t> num_elements_;
   std::atomic<int64_t> processing_time_;
+  std::array<std::atomic<int64_t>, kNumLatencyBuckets>
+      get_next_latency_buckets_ = {};
   std::atomic<bool> record_metrics_;
   Metrics metrics_;
   absl::flat_hash_map<string, std::shared_ptr<Parameter>> parameters_
@@ -1025,9 +1073,9 @@ class Model {
   // Records gap time between consecutive `GetNext()` calls.
   void RecordIteratorGapTime(uint64_t duration_usec);
 
-  // Computes the target time in nsecs to use for `STAGE_BASED` autotune
-  // algorithm. Returns 0 if there if there are not sufficient recorded iterator
-  // gap times to produce a good estimate.
+  // Computes the target time in nsecs to use for `STAGE_BASED` and `BOTTLENECK`
+  // autotune algorithm. Returns 0 if there are not sufficient recorded
+  // iterator gap times to produce a good estimate.
   double ComputeTargetTimeNsec();
 
   // Computes the target time in nsecs to use for estimating input bottlenecks.
@@ -1131,6 +1179,19 @@ class Model {
                           CancellationManager* cancellation_manager,
                           RamBudgetManager& ram_budget_manager);
 
+  // Unlike the other algorithms, this optimization does not re-fit the whole
+  // model in every cycle. It starts from the parameter values currently in use
+  // and only adjusts the stage that is the bottleneck of the pipeline, as
+  // determined by `ModelTiming`: the parallelism of that stage is increased
+  // until the stage is no longer the slowest one, reaches the target time, or
+  // stops improving, without exceeding the CPU or RAM budgets. If the stage has
+  // no parallelism left to increase, its buffer is grown instead, within the
+  // limits of `ram_budget_manager`.
+  void OptimizeBottleneck(std::shared_ptr<Node> snapshot,
+                          const OptimizationParams& optimization_params,
+                          CancellationManager* cancellation_manager,
+                          RamBudgetManager& ram_budget_manager);
+
   // This is the first part of the stage-based optimization that optimizes
   // tunable parallelism parameters for async interleave many nodes only. We
   // separately optimize async interleave many nodes more aggressively because
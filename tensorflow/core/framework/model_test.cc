@@ -36,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace data {
@@ -3158,6 +3159,217 @@ TEST_F(ModelTimingTest, OptimizeStageBased_PipelineRatioLessThanOne) {
   EXPECT_EQ(14, GetNode(/*node_id=*/1)->parameter_value("parallelism"));
 }
 
+TEST_F(ModelTimingTest, OptimizeBottleneck_OnlyCriticalStageIsTuned) {
+  BuildModelFromProto(R"pb(
+    nodes: {
+      key: 1
+      value: {
+        id: 1
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 25000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 2
+        parameters: {
+          name: "parallelism"
+          value: 4
+          state_value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 2
+      value: {
+        id: 2
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 20000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 3
+        parameters: {
+          name: "parallelism"
+          value: 4
+          state_value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 3
+      value: {
+        id: 3
+        name: "SSTable"
+        autotune: true
+        num_elements: 100
+        processing_time: 1000
+        node_class: KNOWN_RATIO
+        ratio: 2
+      }
+    }
+    output: 1
+  )pb");
+
+  CancellationManager cancellation_manager;
+  RamBudgetManager ram_budget_manager(0);
+  model_->Optimize(AutotuneAlgorithm::BOTTLENECK, CpuBudgetFunc(20),
+                   /*ram_budget_share=*/1.0,
+                   /*fixed_ram_budget=*/1000,
+                   /*model_input_time=*/50, ram_budget_manager,
+                   &cancellation_manager);
+
+  // The first stage is the bottleneck. It is tuned until it is faster than the
+  // second stage, which is left untouched.
+  EXPECT_EQ(5, GetNode(/*node_id=*/1)->parameter_value("parallelism"));
+  EXPECT_EQ(4, GetNode(/*node_id=*/2)->parameter_value("parallelism"));
+
+  // The next cycle starts from the current values and tunes the second stage.
+  model_->Optimize(AutotuneAlgorithm::BOTTLENECK, CpuBudgetFunc(20),
+                   /*ram_budget_share=*/1.0,
+                   /*fixed_ram_budget=*/1000,
+                   /*model_input_time=*/50, ram_budget_manager,
+                   &cancellation_manager);
+
+  EXPECT_EQ(5, GetNode(/*node_id=*/1)->parameter_value("parallelism"));
+  EXPECT_EQ(5, GetNode(/*node_id=*/2)->parameter_value("parallelism"));
+}
+
+TEST_F(ModelTimingTest, OptimizeBottleneck_TargetTimeReached) {
+  BuildModelFromProto(R"pb(
+    nodes: {
+      key: 1
+      value: {
+        id: 1
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 25000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 2
+        parameters: {
+          name: "parallelism"
+          value: 4
+          state_value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 2
+      value: {
+        id: 2
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 20000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 3
+        parameters: {
+          name: "parallelism"
+          value: 4
+          state_value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 3
+      value: {
+        id: 3
+        name: "SSTable"
+        autotune: true
+        num_elements: 100
+        processing_time: 1000
+        node_class: KNOWN_RATIO
+        ratio: 2
+      }
+    }
+    output: 1
+  )pb");
+
+  CellReader<int64_t> cell_reader(
+      "/tensorflow/data/autotune_stopping_criteria");
+  CancellationManager cancellation_manager;
+  RamBudgetManager ram_budget_manager(0);
+  model_->Optimize(AutotuneAlgorithm::BOTTLENECK, CpuBudgetFunc(20),
+                   /*ram_budget_share=*/1.0,
+                   /*fixed_ram_budget=*/1000,
+                   /*model_input_time=*/100, ram_budget_manager,
+                   &cancellation_manager);
+
+  EXPECT_EQ(4, GetNode(/*node_id=*/1)->parameter_value("parallelism"));
+  EXPECT_EQ(4, GetNode(/*node_id=*/2)->parameter_value("parallelism"));
+  EXPECT_EQ(cell_reader.Read("target_time_reached"), 1);
+}
+
+TEST_F(ModelTimingTest, OptimizeBottleneck_CappedByCpuBudget) {
+  BuildModelFromProto(R"pb(
+    nodes: {
+      key: 1
+      value: {
+        id: 1
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 100000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 2
+        parameters: {
+          name: "parallelism"
+          value: 1
+          state_value: 1
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 2
+      value: {
+        id: 2
+        name: "SSTable"
+        autotune: true
+        num_elements: 100
+        processing_time: 1000
+        node_class: KNOWN_RATIO
+        ratio: 1
+      }
+    }
+    output: 1
+  )pb");
+
+  CancellationManager cancellation_manager;
+  RamBudgetManager ram_budget_manager(0);
+  model_->Optimize(AutotuneAlgorithm::BOTTLENECK, CpuBudgetFunc(3),
+                   /*ram_budget_share=*/1.0,
+                   /*fixed_ram_budget=*/1000,
+                   /*model_input_time=*/50, ram_budget_manager,
+                   &cancellation_manager);
+
+  EXPECT_EQ(3, GetNode(/*node_id=*/1)->parameter_value("parallelism"));
+}
+
 TEST_F(ModelTimingTest, ComputeTargetTime) {
   model_ = std::make_unique<Model>();
 
@@ -3695,6 +3907,101 @@ TEST(NodeTest, TotalMaximumBufferedBytesNoValueWhenElementSizeNotProvided) {
   EXPECT_EQ(root->TotalMaximumBufferedBytes(), 0.);
 }
 
+TEST(NodeTest, GetNextLatencyHistogram) {
+  std::shared_ptr<Node> node = model::MakeSourceNode({0, "source", nullptr});
+  node->record_get_next_latency(/*latency_nanos=*/500);
+  node->record_get_next_latency(/*latency_nanos=*/1000);
+  node->record_get_next_latency(/*latency_nanos=*/3000);
+  node->record_get_next_latency(/*latency_nanos=*/3999);
+  node->record_get_next_latency(/*latency_nanos=*/1000LL * 1000 * 1000 * 1000);
+
+  std::vector<int64_t> histogram = node->get_next_latency_histogram();
+  ASSERT_EQ(histogram.size(), kNumLatencyBuckets);
+  EXPECT_EQ(histogram[0], 1);
+  EXPECT_EQ(histogram[1], 1);
+  EXPECT_EQ(histogram[2], 2);
+  EXPECT_EQ(histogram[kNumLatencyBuckets - 1], 1);
+  EXPECT_EQ(Node::LatencyBucketLimitMicros(0), 1);
+  EXPECT_EQ(Node::LatencyBucketLimitMicros(2), 4);
+  EXPECT_EQ(Node::LatencyBucketLimitMicros(kNumLatencyBuckets - 1),
+            std::numeric_limits<int64_t>::max());
+}
+
+// Builds a synthetic pipeline of `num_stages` chained parallel maps with
+// uneven per-element processing times, all starting at parallelism 1.
+ModelProto SyntheticPipeline(int num_stages) {
+  ModelProto model_proto;
+  for (int i = 1; i <= num_stages; ++i) {
+    ModelProto::Node& node = (*model_proto.mutable_nodes())[i];
+    node.set_id(i);
+    node.set_name("ParallelMapV2");
+    node.set_autotune(true);
+    node.set_num_elements(100);
+    node.set_processing_time(100 * 1000 * (i % 7 + 1));
+    node.set_bytes_produced(10000);
+    node.set_node_class(NodeClass::ASYNC_KNOWN_RATIO);
+    node.set_ratio(1);
+    if (i < num_stages) node.add_inputs(i + 1);
+    ModelProto::Node::Parameter* parameter = node.add_parameters();
+    parameter->set_name(kParallelism);
+    parameter->set_value(1);
+    parameter->set_state_value(1);
+    parameter->set_min(1);
+    parameter->set_max(64);
+    parameter->set_tunable(true);
+  }
+  model_proto.set_output(1);
+  return model_proto;
+}
+
+// Measures the time it takes `algorithm` to converge, i.e. to run
+// optimization cycles until a cycle no longer changes any parameter, on a
+// synthetic pipeline with `state.range(1)` stages. The number of cycles is
+// reported in the "cycles" counter.
+void BM_AutotuneConvergence(::testing::benchmark::State& state) {
+  const auto algorithm = static_cast<AutotuneAlgorithm>(state.range(0));
+  const ModelProto model_proto = SyntheticPipeline(state.range(1));
+  constexpr int kMaxCycles = 1000;
+  int64_t total_cycles = 0;
+  for (auto s : state) {
+    state.PauseTiming();
+    std::unique_ptr<Model> model;
+    TF_CHECK_OK(Model::FromProto(model_proto, &model));
+    Node::NodeVector nodes = model->output()->CollectNodes(
+        TraversalOrder::BFS, [](const std::shared_ptr<Node>) { return true; });
+    nodes.push_back(model->output());
+    CancellationManager cancellation_manager;
+    RamBudgetManager ram_budget_manager(0);
+    state.ResumeTiming();
+    for (int cycle = 0; cycle < kMaxCycles; ++cycle) {
+      std::vector<double> before;
+      for (const auto& node : nodes) {
+        before.push_back(node->parameter_value(kParallelism));
+      }
+      model->Optimize(algorithm, CpuBudgetFunc(64),
+                      /*ram_budget_share=*/1.0,
+                      /*fixed_ram_budget=*/int64_t{1} << 30,
+                      /*model_input_time=*/50, ram_budget_manager,
+                      &cancellation_manager);
+      ++total_cycles;
+      bool changed = false;
+      for (int i = 0; i < nodes.size(); ++i) {
+        changed |= nodes[i]->parameter_value(kParallelism) != before[i];
+      }
+      if (!changed) break;
+    }
+  }
+  state.counters["cycles"] =
+      static_cast<double>(total_cycles) / state.iterations();
+}
+BENCHMARK(BM_AutotuneConvergence)
+    ->ArgPair(AutotuneAlgorithm::HILL_CLIMB, 10)
+    ->ArgPair(AutotuneAlgorithm::HILL_CLIMB, 50)
+    ->ArgPair(AutotuneAlgorithm::STAGE_BASED, 10)
+    ->ArgPair(AutotuneAlgorithm::STAGE_BASED, 50)
+    ->ArgPair(AutotuneAlgorithm::BOTTLENECK, 10)
+    ->ArgPair(AutotuneAlgorithm::BOTTLENECK, 50);
+
 }  // namespace
 }  // namespace model
 }  // namespace data
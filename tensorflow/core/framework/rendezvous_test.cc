@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -519,5 +520,54 @@ void BM_PingPong(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_PingPong)->Arg(100)->Arg(200)->Arg(300);
 
+// Measures lock contention: each of `state.range(0)` threads sends and then
+// receives its own set of keys through one rendezvous with `state.range(1)`
+// shards.
+void BM_ConcurrentSendRecv(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const int num_shards = state.range(1);
+  constexpr int kKeysPerThread = 64;
+  constexpr int kRounds = 16;
+  std::vector<std::vector<Rendezvous::ParsedKey>> keys(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    for (int i = 0; i < kKeysPerThread; ++i) {
+      keys[t].push_back(MakeKey(strings::StrCat("t", t, "_k", i)));
+    }
+  }
+  thread::ThreadPool pool(Env::Default(), "test", num_threads);
+  const Tensor orig = V("val");
+
+  for (auto s : state) {
+    Rendezvous* rendez = NewLocalRendezvous(num_shards);
+    BlockingCounter done(num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+      pool.Schedule([rendez, &keys, &orig, &done, t]() {
+        Rendezvous::Args args;
+        Tensor val;
+        bool is_dead = false;
+        for (int r = 0; r < kRounds; ++r) {
+          for (const Rendezvous::ParsedKey& key : keys[t]) {
+            TF_CHECK_OK(rendez->Send(key, args, orig, is_dead));
+          }
+          for (const Rendezvous::ParsedKey& key : keys[t]) {
+            TF_CHECK_OK(rendez->Recv(key, args, &val, &is_dead));
+          }
+        }
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+    rendez->Unref();
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads * kKeysPerThread *
+                          kRounds);
+}
+BENCHMARK(BM_ConcurrentSendRecv)
+    ->ArgPair(1, 1)
+    ->ArgPair(8, 1)
+    ->ArgPair(8, 16)
+    ->ArgPair(32, 1)
+    ->ArgPair(32, 32);
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,92 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/measured_cost_store.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace grappler {
+
+MeasuredCostStore::MeasuredCostStore(int64_t max_entries)
+    : max_entries_(max_entries) {}
+
+MeasuredCostStore& MeasuredCostStore::Global() {
+  static auto* store = new MeasuredCostStore();
+  return *store;
+}
+
+void MeasuredCostStore::RecordCost(absl::string_view model_name,
+                                   absl::string_view node_name,
+                                   absl::Duration cost) {
+  if (max_entries_ <= 0) return;
+  Key key{std::string(model_name), std::string(node_name)};
+  mutex_lock l(mu_);
+  auto it = costs_.find(key);
+  if (it == costs_.end()) {
+    if (costs_.size() >= max_entries_) {
+      costs_.erase(lru_.back());
+      lru_.pop_back();
+    }
+    lru_.push_front(key);
+    it = costs_.emplace(std::move(key), Entry{}).first;
+    it->second.lru_position = lru_.begin();
+  } else {
+    lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+  }
+  it->second.sum += cost;
+  ++it->second.count;
+}
+
+std::optional<absl::Duration> MeasuredCostStore::GetCost(
+    absl::string_view model_name, absl::string_view node_name) const {
+  tf_shared_lock l(mu_);
+  auto it = costs_.find(Key{std::string(model_name), std::string(node_name)});
+  if (it == costs_.end()) return std::nullopt;
+  return it->second.sum / it->second.count;
+}
+
+void MeasuredCostStore::ClearModel(absl::string_view model_name) {
+  mutex_lock l(mu_);
+  for (auto it = lru_.begin(); it != lru_.end();) {
+    if (it->first == model_name) {
+      costs_.erase(*it);
+      it = lru_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void MeasuredCostStore::Clear() {
+  mutex_lock l(mu_);
+  costs_.clear();
+  lru_.clear();
+}
+
+size_t MeasuredCostStore::size() const {
+  tf_shared_lock l(mu_);
+  return costs_.size();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
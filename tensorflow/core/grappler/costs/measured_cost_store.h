@@ -0,0 +1,88 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_COST_STORE_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_COST_STORE_H_
+
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Thread-safe.
+// Keeps the mean execution cost of nodes as measured at runtime, keyed by
+// model name and node name, so that cost estimators can prefer it over their
+// analytical estimates the next time the same model is optimized, e.g. on a
+// reload. Holds at most `max_entries` nodes; once full, recording a new node
+// evicts the least recently recorded one.
+class MeasuredCostStore {
+ public:
+  static constexpr int64_t kDefaultMaxEntries = 10000;
+
+  explicit MeasuredCostStore(int64_t max_entries = kDefaultMaxEntries);
+
+  // The process-wide store, fed by runtime components such as the batching
+  // ops. Cost estimators only read it when it is passed to them explicitly.
+  static MeasuredCostStore& Global();
+
+  // Records one execution of the node named `node_name` of model `model_name`
+  // that took `cost`.
+  void RecordCost(absl::string_view model_name, absl::string_view node_name,
+                  absl::Duration cost);
+
+  // Returns the mean recorded cost of the node named `node_name` of model
+  // `model_name`, or nullopt if none was recorded.
+  std::optional<absl::Duration> GetCost(absl::string_view model_name,
+                                        absl::string_view node_name) const;
+
+  // Drops the costs recorded for model `model_name`, e.g. when it is
+  // unloaded.
+  void ClearModel(absl::string_view model_name);
+
+  void Clear();
+
+  size_t size() const;
+
+ private:
+  using Key = std::pair<std::string, std::string>;
+  struct Entry {
+    absl::Duration sum;
+    int64_t count = 0;
+    // Position of the key in `lru_`.
+    std::list<Key>::iterator lru_position;
+  };
+
+  const int64_t max_entries_;
+  mutable mutex mu_;
+  // Maps {model name, node name} to the costs recorded for the node.
+  absl::flat_hash_map<Key, Entry> costs_ TF_GUARDED_BY(mu_);
+  // Keys of `costs_`, most recently recorded first.
+  std::list<Key> lru_ TF_GUARDED_BY(mu_);
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_COST_STORE_H_
@@ -0,0 +1,71 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/measured_cost_store.h"
+
+#include "absl/time/time.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+TEST(MeasuredCostStoreTest, ReturnsMeanCost) {
+  MeasuredCostStore store;
+  EXPECT_FALSE(store.GetCost("model", "node").has_value());
+
+  store.RecordCost("model", "node", absl::Microseconds(10));
+  store.RecordCost("model", "node", absl::Microseconds(30));
+  store.RecordCost("model", "other", absl::Microseconds(5));
+
+  EXPECT_EQ(store.size(), 2);
+  EXPECT_EQ(store.GetCost("model", "node"), absl::Microseconds(20));
+  EXPECT_EQ(store.GetCost("model", "other"), absl::Microseconds(5));
+
+  store.Clear();
+  EXPECT_EQ(store.size(), 0);
+  EXPECT_FALSE(store.GetCost("model", "node").has_value());
+}
+
+TEST(MeasuredCostStoreTest, KeysCostsByModel) {
+  MeasuredCostStore store;
+  store.RecordCost("model", "node", absl::Microseconds(10));
+  store.RecordCost("other_model", "node", absl::Microseconds(30));
+
+  EXPECT_EQ(store.GetCost("model", "node"), absl::Microseconds(10));
+  EXPECT_EQ(store.GetCost("other_model", "node"), absl::Microseconds(30));
+
+  store.ClearModel("model");
+  EXPECT_EQ(store.size(), 1);
+  EXPECT_FALSE(store.GetCost("model", "node").has_value());
+  EXPECT_EQ(store.GetCost("other_model", "node"), absl::Microseconds(30));
+}
+
+TEST(MeasuredCostStoreTest, EvictsLeastRecentlyRecorded) {
+  MeasuredCostStore store(/*max_entries=*/2);
+  store.RecordCost("model", "a", absl::Microseconds(1));
+  store.RecordCost("model", "b", absl::Microseconds(2));
+  store.RecordCost("model", "a", absl::Microseconds(3));
+  store.RecordCost("model", "c", absl::Microseconds(4));
+
+  EXPECT_EQ(store.size(), 2);
+  EXPECT_EQ(store.GetCost("model", "a"), absl::Microseconds(2));
+  EXPECT_FALSE(store.GetCost("model", "b").has_value());
+  EXPECT_EQ(store.GetCost("model", "c"), absl::Microseconds(4));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
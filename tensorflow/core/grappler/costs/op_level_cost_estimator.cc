@@ -32,6 +32,7 @@ limitations under the License.
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "Eigen/Core"  // from @eigen_archive
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -42,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/measured_cost_store.h"
 #include "tensorflow/core/grappler/costs/op_context.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
 #include "tensorflow/core/grappler/costs/utils.h"
@@ -658,6 +660,29 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
 }
 
 Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
+  Costs costs = PredictAnalyticalCosts(op_context);
+  if (measured_costs_ == nullptr || op_context.name.empty()) return costs;
+  const std::optional<absl::Duration> measured_cost =
+      measured_costs_->GetCost(model_name_, op_context.name);
+  if (!measured_cost.has_value()) return costs;
+  // The measurement covers both compute and memory accesses; the memory
+  // estimates, e.g. of peak usage, are kept.
+  const Costs::Duration measured_time(absl::ToInt64Nanoseconds(*measured_cost));
+  VLOG(1) << "Operation " << op_context.name << " measured at "
+          << measured_time.count() << " ns, estimated at "
+          << costs.execution_time.count() << " ns.";
+  costs.compute_time = measured_time;
+  costs.execution_time = measured_time;
+  costs.memory_time = 0;
+  costs.intermediate_memory_time = 0;
+  costs.intermediate_memory_read_time = 0;
+  costs.intermediate_memory_write_time = 0;
+  costs.inaccurate = false;
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictAnalyticalCosts(
+    const OpContext& op_context) const {
   Costs costs;
   NodeCosts node_costs;
   if (PredictNodeCosts(op_context, &node_costs).ok()) {
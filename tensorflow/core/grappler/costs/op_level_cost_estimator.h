@@ -21,11 +21,14 @@ limitations under the License.
 #include <map>
 #include <numeric>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/measured_cost_store.h"
 #include "tensorflow/core/grappler/costs/op_context.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
 #include "tensorflow/core/platform/types.h"
@@ -101,11 +104,23 @@ class OpLevelCostEstimator {
   OpLevelCostEstimator();
   virtual ~OpLevelCostEstimator() {}
 
+  // Prefers the cost measured at runtime for the node, if one was recorded in
+  // the measured cost store set with `set_measured_costs()`, to the analytical
+  // estimate.
   virtual Costs PredictCosts(const OpContext& op_context) const;
 
   // Returns basic device performance info.
   virtual DeviceInfo GetDeviceInfo(const DeviceProperties& device) const;
 
+  // Sets the store of runtime-measured node costs to consult for the nodes of
+  // model `model_name`. `measured_costs` is not owned and must outlive the
+  // estimator. Null, the default, disables measured costs.
+  void set_measured_costs(const MeasuredCostStore* measured_costs,
+                          absl::string_view model_name) {
+    measured_costs_ = measured_costs;
+    model_name_ = std::string(model_name);
+  }
+
  protected:
   // TODO(dyoon): Consider to remove PredictOpCountBasedCosts() with OpInfo.
   // Naive cost estimate based on the given operations count and total
@@ -337,6 +352,12 @@ class OpLevelCostEstimator {
   std::set<string> persistent_ops_;
 
  private:
+  // Estimates the costs of the op from its type, shapes and the device.
+  Costs PredictAnalyticalCosts(const OpContext& op_context) const;
+
+  const MeasuredCostStore* measured_costs_ = nullptr;
+  std::string model_name_;
+
   friend class OpLevelCostEstimatorTest;
 };
 
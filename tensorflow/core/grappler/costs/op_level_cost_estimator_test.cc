@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <unordered_set>
 
+#include "absl/time/time.h"
+
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -24,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/measured_cost_store.h"
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/device_properties.pb.h"
@@ -752,6 +755,35 @@ TEST_F(OpLevelCostEstimatorTest, TestSliceCosts) {
   EXPECT_EQ(cost.persistent_memory, 0);
 }
 
+TEST_F(OpLevelCostEstimatorTest, PrefersMeasuredCosts) {
+  OpContext op_context = DescribeMatMul(2, 4, 8, 4);
+  op_context.name = "matmul";
+  const Costs estimated = PredictCosts(op_context);
+
+  MeasuredCostStore measured_costs;
+  measured_costs.RecordCost("model", "matmul", absl::Microseconds(3));
+  measured_costs.RecordCost("model", "matmul", absl::Microseconds(5));
+  // Measured costs are only used when the store is passed in explicitly.
+  EXPECT_EQ(estimated.execution_time, PredictCosts(op_context).execution_time);
+
+  estimator_.set_measured_costs(&measured_costs, "model");
+  measured_costs.RecordCost("model", "other", absl::Microseconds(5));
+  measured_costs.RecordCost("other_model", "matmul", absl::Microseconds(7));
+  const Costs measured = PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(4000), measured.execution_time);
+  EXPECT_EQ(Costs::Duration(4000), measured.compute_time);
+  EXPECT_EQ(Costs::Duration(0), measured.memory_time);
+  EXPECT_FALSE(measured.inaccurate);
+  EXPECT_EQ(estimated.num_ops_total, measured.num_ops_total);
+
+  // Nodes of another model with the same name do not share costs.
+  estimator_.set_measured_costs(&measured_costs, "unknown_model");
+  EXPECT_EQ(estimated.execution_time, PredictCosts(op_context).execution_time);
+
+  estimator_.set_measured_costs(nullptr, "");
+  EXPECT_EQ(estimated.execution_time, PredictCosts(op_context).execution_time);
+}
+
 TEST_F(OpLevelCostEstimatorTest, TestStridedSliceCosts) {
   OpContext op_context;
   SetCpuDevice(&op_context.op_info);
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
@@ -457,6 +458,7 @@ NodeDef* MutableGraphView::AddNode(NodeDef&& node) {
   *node_in_graph = std::move(node);
 
   AddUniqueNodeOrDie(node_in_graph);
+  node_positions_[node_in_graph] = graph()->node_size() - 1;
 
   AddAndDedupFanouts(node_in_graph);
   return node_in_graph;
@@ -497,6 +499,7 @@ Status MutableGraphView::AddSubgraph(GraphDef&& subgraph) {
   for (NodeDef& node : *subgraph.mutable_node()) {
     auto* node_in_graph = graph()->add_node();
     node_in_graph->Swap(&node);
+    node_positions_[node_in_graph] = graph()->node_size() - 1;
     TF_RETURN_IF_ERROR(AddUniqueNode(node_in_graph));
   }
 
@@ -1570,37 +1573,67 @@ Status MutableGraphView::DeleteNodes(
   TF_RETURN_IF_ERROR(CheckNodesCanBeDeleted(nodes_to_delete));
 
   // Find nodes in internal state and delete.
+  std::vector<NodeDef*> deleted_nodes;
+  deleted_nodes.reserve(nodes_to_delete.size());
   for (const string& node_name_to_delete : nodes_to_delete) {
     NodeDef* node = GetNode(node_name_to_delete);
     if (node != nullptr) {
       RemoveFaninsInternal(node, /*keep_controlling_fanins=*/false);
       RemoveFanoutsInternal(node);
+      deleted_nodes.push_back(node);
     }
   }
   for (const string& node_name_to_delete : nodes_to_delete) {
     nodes().erase(node_name_to_delete);
   }
+  if (deleted_nodes.empty()) return absl::OkStatus();
+
+  // Delete nodes from the graph by moving the last nodes to retain into the
+  // positions of the deleted nodes that come before them, and then deleting
+  // the tail of the graph.
+  const std::vector<int> deleted_positions = NodePositions(deleted_nodes);
+  const absl::flat_hash_set<int> deleted_positions_set(
+      deleted_positions.begin(), deleted_positions.end());
+  const int num_deleted = deleted_positions.size();
+  const int num_retained = graph()->node_size() - num_deleted;
+  int last_pos = graph()->node_size() - 1;
+  for (int pos : deleted_positions) {
+    if (pos >= num_retained) break;
+    while (deleted_positions_set.contains(last_pos)) --last_pos;
+    graph()->mutable_node()->SwapElements(pos, last_pos);
+    node_positions_[graph()->mutable_node(pos)] = pos;
+    --last_pos;
+  }
+  for (const NodeDef* node : deleted_nodes) {
+    node_positions_.erase(node);
+  }
+  graph()->mutable_node()->DeleteSubrange(num_retained, num_deleted);
 
-  // Find nodes in graph and delete by partitioning into nodes to retain and
-  // nodes to delete based on input set of nodes to delete by name.
-  // TODO(lyandy): Use a node name->idx hashmap if this is a performance
-  // bottleneck.
-  int pos = 0;
-  const int last_idx = graph()->node_size() - 1;
-  int last_pos = last_idx;
-  while (pos <= last_pos) {
-    if (nodes_to_delete.contains(graph()->node(pos).name())) {
-      graph()->mutable_node()->SwapElements(pos, last_pos);
-      --last_pos;
-    } else {
-      ++pos;
+  return absl::OkStatus();
+}
+
+std::vector<int> MutableGraphView::NodePositions(
+    const std::vector<NodeDef*>& nodes) const {
+  std::vector<int> positions;
+  positions.reserve(nodes.size());
+  for (const NodeDef* node : nodes) {
+    const auto it = node_positions_.find(node);
+    if (it == node_positions_.end() || it->second >= graph()->node_size() ||
+        &graph()->node(it->second) != node) {
+      VLOG(1) << "Graph was modified outside of MutableGraphView, looking up "
+              << "node positions by scanning it.";
+      const absl::flat_hash_set<const NodeDef*> nodes_set(nodes.begin(),
+                                                          nodes.end());
+      positions.clear();
+      for (int i = 0; i < graph()->node_size(); ++i) {
+        if (nodes_set.contains(&graph()->node(i))) positions.push_back(i);
+      }
+      return positions;
     }
+    positions.push_back(it->second);
   }
-  if (last_pos < last_idx) {
-    graph()->mutable_node()->DeleteSubrange(last_pos + 1, last_idx - last_pos);
-  }
-
-  return absl::OkStatus();
+  std::sort(positions.begin(), positions.end());
+  return positions;
 }
 
 void MutableGraphView::RemoveFaninsInternal(NodeDef* deleted_node,
@@ -18,7 +18,9 @@ limitations under the License.
 
 #include <set>
 #include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
@@ -43,7 +45,12 @@ const char kMutableGraphViewCtrl[] = "ConstantFoldingCtrl";
 class MutableGraphView : public internal::GraphViewInternal<GraphDef, NodeDef> {
  public:
   explicit MutableGraphView(GraphDef* graph) : GraphViewInternal(graph) {
-    for (NodeDef& node : *graph->mutable_node()) AddUniqueNodeOrDie(&node);
+    node_positions_.reserve(graph->node_size());
+    for (int i = 0; i < graph->node_size(); ++i) {
+      NodeDef* node = graph->mutable_node(i);
+      AddUniqueNodeOrDie(node);
+      node_positions_[node] = i;
+    }
     for (NodeDef& node : *graph->mutable_node()) AddAndDedupFanouts(&node);
   }
 
@@ -245,7 +252,9 @@ class MutableGraphView : public internal::GraphViewInternal<GraphDef, NodeDef> {
 
   // Deletes nodes from the graph. If a node can't be safely removed,
   // specifically if a node still has fanouts, an error will be returned. Nodes
-  // that can't be found are ignored.
+  // that can't be found are ignored. Takes time proportional to the number of
+  // nodes deleted rather than to the size of the graph, so deleting nodes in
+  // many small batches scales to large graphs.
   Status DeleteNodes(const absl::flat_hash_set<string>& nodes_to_delete);
 
  private:
@@ -323,6 +332,15 @@ class MutableGraphView : public internal::GraphViewInternal<GraphDef, NodeDef> {
 
   // Removes fanouts of the deleted node from internal state.
   void RemoveFanoutsInternal(NodeDef* deleted_node);
+
+  // Returns the positions in graph()->node() of `nodes`, sorted. Falls back to
+  // scanning the graph if the positions of some nodes are not known, i.e. if
+  // the graph was modified without going through the view.
+  std::vector<int> NodePositions(const std::vector<NodeDef*>& nodes) const;
+
+  // Position of each node in graph()->node(), maintained as nodes are added
+  // and deleted.
+  absl::flat_hash_map<const NodeDef*, int> node_positions_;
 };
 
 }  // end namespace grappler
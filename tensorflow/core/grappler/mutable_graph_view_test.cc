@@ -14,6 +14,12 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/grappler/mutable_graph_view.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "absl/types/span.h"
 #include "tensorflow/cc/ops/standard_ops.h"
@@ -25,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -2930,6 +2937,44 @@ TEST(MutableGraphViewTest, DeleteMissingNodesAndNodesWithFanoutsBeingDeleted) {
   CheckGraph(graph);
 }
 
+TEST(MutableGraphViewTest, DeleteNodesInBatches) {
+  GraphDef graph_def;
+  for (int i = 0; i < 10; ++i) {
+    *graph_def.add_node() = NDef(absl::StrCat("n", i), "NotImportant", {}, {});
+  }
+  MutableGraphView graph(&graph_def);
+  graph.AddNode(NDef("added", "NotImportant", {"n9"}, {}));
+
+  // Deleted nodes are replaced by the last nodes retained, as the view keeps
+  // track of where the nodes are in the graph across deletions.
+  TF_EXPECT_OK(graph.DeleteNodes({"n1", "n3"}));
+  TF_EXPECT_OK(graph.DeleteNodes({"n0", "added", "n8"}));
+  TF_EXPECT_OK(graph.DeleteNodes({"n9", "n7"}));
+
+  std::vector<string> node_names;
+  for (const NodeDef& node : graph.graph()->node()) {
+    node_names.push_back(node.name());
+  }
+  EXPECT_EQ(node_names, (std::vector<string>{"n5", "n6", "n2", "n4"}));
+  CheckGraph(graph);
+}
+
+TEST(MutableGraphViewTest, DeleteNodesAfterGraphReordered) {
+  GraphDef graph_def = SimpleDeleteNodeGraph();
+  MutableGraphView graph(&graph_def);
+
+  // Reorder the graph without going through the view.
+  graph.graph()->mutable_node()->SwapElements(0, 5);
+  TF_EXPECT_OK(graph.DeleteNodes({"e", "f"}));
+
+  EXPECT_EQ(graph.graph()->node_size(), 4);
+  EXPECT_EQ(graph.GetNode("e"), nullptr);
+  EXPECT_EQ(graph.GetNode("f"), nullptr);
+  CheckNode(graph, "a", "NotImportant", "", {}, {}, {"b", "c"});
+  CheckNode(graph, "d", "NotImportant", "", {}, {}, {});
+  CheckGraph(graph);
+}
+
 TEST(MutableGraphViewTest, DeleteNodesWithError) {
   GraphDef graph_def = SimpleDeleteNodeGraph();
 
@@ -2996,6 +3041,65 @@ TEST(MutableGraphViewTest, DeleteNodesWithLargeError) {
   CheckGraph(graph);
 }
 
+// Deletes all nodes of a graph of `num_nodes` nodes, `batch_size` nodes at a
+// time.
+static void BM_DeleteNodesInBatches(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const int batch_size = state.range(1);
+  std::vector<absl::flat_hash_set<string>> batches;
+  for (int i = 0; i < num_nodes; i += batch_size) {
+    absl::flat_hash_set<string>& batch = batches.emplace_back();
+    for (int j = i; j < std::min(i + batch_size, num_nodes); ++j) {
+      batch.insert(absl::StrCat("node", j));
+    }
+  }
+  GraphDef original_graph_def;
+  for (int i = 0; i < num_nodes; ++i) {
+    *original_graph_def.add_node() =
+        NDef(absl::StrCat("node", i), "NotImportant", {}, {});
+  }
+
+  for (auto s : state) {
+    state.PauseTiming();
+    GraphDef graph_def = original_graph_def;
+    MutableGraphView graph(&graph_def);
+    state.ResumeTiming();
+    for (const auto& batch : batches) {
+      TF_CHECK_OK(graph.DeleteNodes(batch));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_nodes);
+}
+BENCHMARK(BM_DeleteNodesInBatches)
+    ->ArgPair(1000, 10)
+    ->ArgPair(10000, 10)
+    ->ArgPair(100000, 10)
+    ->ArgPair(100000, 1000);
+
+// Builds a graph of `num_nodes` nodes in a chain, with every node also
+// consuming the first node, and reroutes all the fanouts of the first node.
+static void BM_UpdateFanouts(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  GraphDef original_graph_def;
+  *original_graph_def.add_node() = NDef("node0", "NotImportant", {}, {});
+  *original_graph_def.add_node() = NDef("other", "NotImportant", {}, {});
+  for (int i = 1; i < num_nodes; ++i) {
+    *original_graph_def.add_node() =
+        NDef(absl::StrCat("node", i), "NotImportant",
+             {absl::StrCat("node", i - 1), "node0:1"}, {});
+  }
+
+  for (auto s : state) {
+    state.PauseTiming();
+    GraphDef graph_def = original_graph_def;
+    MutableGraphView graph(&graph_def);
+    state.ResumeTiming();
+    TF_CHECK_OK(graph.UpdateFanouts("node0", "other"));
+  }
+  state.SetItemsProcessed(state.iterations() * num_nodes);
+}
+BENCHMARK(BM_UpdateFanouts)->Arg(1000)->Arg(10000)->Arg(100000);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -4231,6 +4231,101 @@ class SimplifyEmbeddingLookupStage : public ArithmeticOptimizerStage {
   }
 };
 
+// Fuses a gather of rows into the segment reduction that consumes them.
+//
+// Embedding bags are often written as
+//
+//     gathered_rows = tf.gather(params, ids)
+//     result = tf.math.segment_<combiner>(gathered_rows, segment_ids)
+//
+// which materializes the [nnz, dim] `gathered_rows`. The sparse segment
+// reductions take the `ids` and read the rows of `params` directly, so this is
+// rewritten as
+//
+//     result = tf.sparse.segment_<combiner>(params, ids, segment_ids)
+class FuseGatherIntoSegmentReductionStage : public ArithmeticOptimizerStage {
+ public:
+  explicit FuseGatherIntoSegmentReductionStage(
+      const GraphOptimizerContext& ctx,
+      const ArithmeticOptimizerContext& ctx_ext)
+      : ArithmeticOptimizerStage("FuseGatherIntoSegmentReductionStage", ctx,
+                                 ctx_ext) {}
+  ~FuseGatherIntoSegmentReductionStage() override = default;
+
+  bool IsSupported(const NodeDef* node) const override {
+    return node->op() == "SegmentSum" || node->op() == "SegmentMean";
+  }
+
+  Status TrySimplify(NodeDef* reduction_node,
+                     string* simplified_node_name) override {
+    if (IsInPreserveSet(*reduction_node)) return absl::OkStatus();
+
+    DataType type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*reduction_node, "T", &type));
+    if (type != DT_FLOAT && type != DT_BFLOAT16 && type != DT_HALF &&
+        type != DT_DOUBLE)
+      return absl::OkStatus();
+
+    // Input 0 (data) of the reduction node must be a gather on the 0th axis
+    // whose only consumer is the reduction node.
+    NodeDef* gather_node = nullptr;
+    TF_RETURN_IF_ERROR(GetInputNode(reduction_node->input(0), &gather_node));
+    if ((gather_node->op() != "Gather" && gather_node->op() != "GatherV2") ||
+        IsInPreserveSet(*gather_node) || HasControlInputs(*gather_node) ||
+        gather_node->device() != reduction_node->device() ||
+        NumNonControlOutputs(*gather_node, *ctx().node_map) != 1)
+      return absl::OkStatus();
+    if (gather_node->op() == "GatherV2") {
+      int batch_dims = 0;
+      if (TryGetNodeAttr(*gather_node, "batch_dims", &batch_dims) &&
+          batch_dims != 0)
+        return absl::OkStatus();
+      if (!IsConstantZero(gather_node->input(2))) return absl::OkStatus();
+    }
+    DataType ids_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*gather_node, "Tindices", &ids_type));
+    if (ids_type != DT_INT32 && ids_type != DT_INT64) return absl::OkStatus();
+
+    DataType segment_ids_type;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(*reduction_node, "Tindices", &segment_ids_type));
+
+    const string params = gather_node->input(0);
+    const string ids = gather_node->input(1);
+    const string segment_ids = reduction_node->input(1);
+    reduction_node->set_op(reduction_node->op() == "SegmentSum"
+                               ? "SparseSegmentSum"
+                               : "SparseSegmentMean");
+    reduction_node->mutable_attr()->erase("Tindices");
+    SetDataTypeToAttr(ids_type, "Tidx", reduction_node);
+    SetDataTypeToAttr(segment_ids_type, "Tsegmentids", reduction_node);
+
+    reduction_node->set_input(0, params);
+    ctx().node_map->UpdateInput(reduction_node->name(), gather_node->name(),
+                                params);
+    reduction_node->set_input(1, ids);
+    ctx().node_map->AddOutput(NodeName(ids), reduction_node->name());
+    reduction_node->add_input(segment_ids);
+    // Control inputs follow the data inputs.
+    for (int i = reduction_node->input_size() - 1;
+         i > 2 && IsControlInput(reduction_node->input(i - 1)); --i) {
+      reduction_node->mutable_input()->SwapElements(i, i - 1);
+    }
+    *simplified_node_name = reduction_node->name();
+    return absl::OkStatus();
+  }
+
+ private:
+  bool IsConstantZero(const string& input) {
+    Tensor tensor;
+    if (!GetTensorFromConstNode(input, &tensor)) return false;
+    if (tensor.NumElements() != 1) return false;
+    if (tensor.dtype() == DT_INT32) return tensor.flat<int32>()(0) == 0;
+    if (tensor.dtype() == DT_INT64) return tensor.flat<int64_t>()(0) == 0;
+    return false;
+  }
+};
+
 // Eliminates unnecessary casts before sparse segment reduction operations.
 //
 // Existing graphs and library code would often insert a cast from DT_INT64 to
@@ -4370,6 +4465,8 @@ Status ArithmeticOptimizer::SimplifyArithmeticOps(bool can_use_shapes) {
     pipeline.AddStage<RemoveStackSliceSameAxis>(ctx, ctx_ext);
   if (options_.simplify_embedding_lookup)
     pipeline.AddStage<SimplifyEmbeddingLookupStage>(ctx, ctx_ext);
+  if (options_.fuse_gather_into_segment_reduction)
+    pipeline.AddStage<FuseGatherIntoSegmentReductionStage>(ctx, ctx_ext);
   if (options_.remove_cast_into_segment_reduction)
     pipeline.AddStage<RemoveCastIntoSegmentReductionStage>(ctx, ctx_ext);
   if (options_.fuse_squared_diff)
@@ -87,6 +87,7 @@ class ArithmeticOptimizer : public GraphOptimizer {
     bool remove_stack_slice_same_axis = true;
     bool simplify_aggregation = true;
     bool simplify_embedding_lookup = true;
+    bool fuse_gather_into_segment_reduction = true;
     bool remove_cast_into_segment_reduction = true;
 
     // Choose which arithmetic optimizer stages will be enabled for a given
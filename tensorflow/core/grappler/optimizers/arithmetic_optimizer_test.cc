@@ -4789,6 +4789,95 @@ TEST_F(ArithmeticOptimizerTest, SimplifyResourceEmbeddingLookup) {
   }
 }
 
+TEST_F(ArithmeticOptimizerTest, FuseGatherIntoSegmentReduction) {
+  for (bool mean : {false, true}) {
+    for (DataType ids_type : {DT_INT32, DT_INT64}) {
+      tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+      Output params = ops::Const(s.WithOpName("params"),
+                                 {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f}, {3, 2});
+      Output ids = ops::Cast(s.WithOpName("ids"),
+                             ops::Const(s.WithOpName("ids_int32"),
+                                        {2, 0, 1, 2, 2, 0, 1}),
+                             ids_type);
+      Output segment_ids =
+          ops::Const(s.WithOpName("segment_ids"), {0, 1, 1, 3, 3, 3, 3});
+      Output axis = ops::Const(s.WithOpName("axis"), 0);
+      Output gathered_rows =
+          ops::GatherV2(s.WithOpName("gathered_rows"), params, ids, axis);
+      Output result =
+          mean ? ops::SegmentMean(s.WithOpName("result"), gathered_rows,
+                                  segment_ids)
+                     .output
+               : ops::SegmentSum(s.WithOpName("result"), gathered_rows,
+                                 segment_ids)
+                     .output;
+      Output id = ops::Identity(s.WithOpName("id"), result);
+
+      GrapplerItem item;
+      TF_CHECK_OK(s.ToGraphDef(&item.graph));
+      item.fetch = {"id"};
+      auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+      ASSERT_EQ(tensors_expected.size(), 1);
+
+      GraphDef output;
+      ArithmeticOptimizer optimizer;
+      EnableOnlyFuseGatherIntoSegmentReduction(&optimizer);
+      OptimizeAndPrune(&optimizer, &item, &output);
+
+      bool found = false;
+      for (const auto& node : output.node()) {
+        if (node.name() == "result") {
+          found = true;
+          EXPECT_EQ(node.op(), mean ? "SparseSegmentMean" : "SparseSegmentSum");
+          ASSERT_EQ(node.input_size(), 3);
+          EXPECT_EQ(node.input(0), "params");
+          EXPECT_EQ(node.input(1), "ids");
+          EXPECT_EQ(node.input(2), "segment_ids");
+          EXPECT_EQ(node.attr().at("Tidx").type(), ids_type);
+          EXPECT_EQ(node.attr().at("Tsegmentids").type(), DT_INT32);
+        }
+        EXPECT_NE(node.op(), "GatherV2");
+      }
+      EXPECT_TRUE(found);
+
+      auto tensors = EvaluateNodes(output, item.fetch);
+      ASSERT_EQ(tensors.size(), 1);
+      test::ExpectTensorEqual<float>(tensors[0], tensors_expected[0]);
+    }
+  }
+}
+
+TEST_F(ArithmeticOptimizerTest, FuseGatherIntoSegmentReductionSharedGather) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output params =
+      ops::Const(s.WithOpName("params"), {1.0f, 2.0f, 3.0f, 4.0f}, {2, 2});
+  Output ids = ops::Const(s.WithOpName("ids"), {1, 0, 1});
+  Output segment_ids = ops::Const(s.WithOpName("segment_ids"), {0, 0, 1});
+  Output gathered_rows =
+      ops::Gather(s.WithOpName("gathered_rows"), params, ids);
+  Output result =
+      ops::SegmentSum(s.WithOpName("result"), gathered_rows, segment_ids);
+  Output id = ops::Identity(s.WithOpName("id"), result);
+  Output other = ops::Identity(s.WithOpName("other"), gathered_rows);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"id", "other"};
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer;
+  EnableOnlyFuseGatherIntoSegmentReduction(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+
+  // The gathered rows are needed anyway, so the graph is left as it is.
+  for (const auto& node : output.node()) {
+    if (node.name() == "result") {
+      EXPECT_EQ(node.op(), "SegmentSum");
+      EXPECT_EQ(node.input(0), "gathered_rows");
+    }
+  }
+}
+
 TEST_F(ArithmeticOptimizerTest, RemoveCastIntoSegmentReduction) {
   for (DataType indices_type : {DT_INT32, DT_INT64}) {
     for (DataType segment_ids_type : {DT_INT32, DT_INT64}) {
@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 
+#include <algorithm>
 #include <fstream>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -31,6 +34,10 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -1039,7 +1046,8 @@ class AutoMixedPrecisionImpl {
   AutoMixedPrecisionImpl(Cluster* cluster,
                          const std::unordered_set<string>& nodes_to_preserve,
                          GraphDef* graph, string id,
-                         AutoMixedPrecisionMode mode)
+                         AutoMixedPrecisionMode mode,
+                         const GraphProperties* graph_properties = nullptr)
       : devices_(GetDevices(cluster)),
         virtual_placer_(devices_),
         nodes_to_preserve_(nodes_to_preserve),
@@ -1050,6 +1058,7 @@ class AutoMixedPrecisionImpl {
         cuda_version_(GetCudaVersion(devices_)),
         cudnn_version_(GetCudnnVersion(devices_)),
         num_nonvar_casts_to_f16_(0),
+        graph_properties_(graph_properties),
         mode_(mode),
         target_dtype_((mode_ == AutoMixedPrecisionMode::CUDA ||
                        mode_ == AutoMixedPrecisionMode::CPU ||
@@ -1077,6 +1086,8 @@ class AutoMixedPrecisionImpl {
       case AutoMixedPrecisionMode::FP16_CPU:
         return std::make_unique<AutoMixedPrecisionListsFp16>(
             0, 0, AutoMixedPrecisionMode::FP16_CPU);
+      case AutoMixedPrecisionMode::AMX_BF16:
+        return std::make_unique<AutoMixedPrecisionListsAmx>();
     }
   }
   Status PrintDebugLogs(bool preop, size_t timestamp);
@@ -1101,6 +1112,13 @@ class AutoMixedPrecisionImpl {
       std::vector<NodeTypeIdEdge>* implicit_fp32_edges) const;
   void AddAllowlistOps(absl::flat_hash_set<int>* allow_set) const;
   void RemoveAllowsetWithFp32(absl::flat_hash_set<int>* allow_set) const;
+  double EstimateFp32TimeNs(
+      const NodeDef& node,
+      const std::unordered_map<string, const NodeDef*>& name_to_node) const;
+  double EstimateCastTimeNs(const NodeTypeId& node_type) const;
+  void RemoveUnprofitableAllowClusters(
+      absl::flat_hash_set<int>* allow_set) const;
+  void LogExpectedSpeedups(const absl::flat_hash_set<int>& allow_set) const;
   void PropagateDenyFwdThroughClearAndInfer(
       absl::flat_hash_set<int>* deny_set) const;
   void ForceColorMatchBetweenTensorListOps(
@@ -1142,6 +1160,10 @@ class AutoMixedPrecisionImpl {
   int num_nonvar_casts_to_f16_;
   NodeTypeAttrMap node_type_map_;
   GraphTypeTopologyView graph_type_view_;
+  // Only set in AMX_BF16 mode, for the cost model.
+  const GraphProperties* graph_properties_;
+  OpLevelCostEstimator cost_estimator_;
+  gtl::FlatMap<string, float> expected_speedups_;
   bool force_all_fp16_;
   bool treat_infer_as_deny_;
   AutoMixedPrecisionMode mode_;
@@ -1389,7 +1411,8 @@ Status AutoMixedPrecisionImpl::Optimize() {
   optimization_level = absl::AsciiStrToUpper(optimization_level);
   force_all_fp16_ = optimization_level == "UNSAFE_FORCE_ALL";
   if (force_all_fp16_ && (mode_ == AutoMixedPrecisionMode::BF16 ||
-                          mode_ == AutoMixedPrecisionMode::FP16_CPU)) {
+                          mode_ == AutoMixedPrecisionMode::FP16_CPU ||
+                          mode_ == AutoMixedPrecisionMode::AMX_BF16)) {
     // Many ops do not support bfloat16/fp16 on the CPU. So, disallowing
     // forcing to bfloat16/fp16.
     return errors::InvalidArgument(
@@ -1414,6 +1437,9 @@ Status AutoMixedPrecisionImpl::Optimize() {
   }
 
   f16_clearlist_ = mp_lists->ClearList();
+  if (mode_ == AutoMixedPrecisionMode::AMX_BF16) {
+    expected_speedups_ = AutoMixedPrecisionListsAmx::ExpectedSpeedups();
+  }
   TF_RETURN_IF_ERROR(ValidateLists(f16_allowlist_, f16_denylist_,
                                    f16_inferlist_, f16_clearlist_));
 
@@ -1434,6 +1460,7 @@ Status AutoMixedPrecisionImpl::Optimize() {
       case AutoMixedPrecisionMode::BF16:
       case AutoMixedPrecisionMode::CPU:
       case AutoMixedPrecisionMode::FP16_CPU:
+      case AutoMixedPrecisionMode::AMX_BF16:
         device_type = DEVICE_CPU;
         should_process = !MustPreserve(node) && IsOnDevice(node, device_type);
         break;
@@ -1498,6 +1525,9 @@ Status AutoMixedPrecisionImpl::Optimize() {
   //    connected to a node in the allow_set via other clearlist nodes.
   //    This is done to increase the number of ops in the allow_set without
   //    affecting numerical stability.
+  // 6) In AMX_BF16 mode, remove the clusters of connected allow nodes that
+  //    are not expected to be faster in bfloat16 once the casts at their
+  //    boundary are paid for.
 
   absl::flat_hash_set<int> allow_set;
   VLOG(2) << "Beginning pass 1 to add allowlist ops";
@@ -1540,6 +1570,13 @@ Status AutoMixedPrecisionImpl::Optimize() {
   RemoveAllowsetWithFp32(&allow_set);
   VLOG(2) << "Finished pass 6";
 
+  if (mode_ == AutoMixedPrecisionMode::AMX_BF16) {
+    VLOG(2) << "Beginning pass 7 to remove allow clusters that are not "
+               "expected to be faster in bfloat16";
+    RemoveUnprofitableAllowClusters(&allow_set);
+    VLOG(2) << "Finished pass 7";
+  }
+
   VLOG(2) << "Forcing color match between data structure ops";
   for (const auto& cluster : tensor_list_clusters) {
     ForceColorMatchBetweenTensorListOps(cluster, &allow_set, &deny_set);
@@ -1556,6 +1593,10 @@ Status AutoMixedPrecisionImpl::Optimize() {
   TF_RETURN_IF_ERROR(ChangeTypeAttrsAndAddCasts(allow_set));
   VLOG(2) << "Finished final pass";
 
+  if (mode_ == AutoMixedPrecisionMode::AMX_BF16) {
+    LogExpectedSpeedups(allow_set);
+  }
+
   TF_RETURN_IF_ERROR(PrintDebugLogs(/* preop = */ false, timestamp));
 
   return absl::OkStatus();
@@ -1698,6 +1739,14 @@ void AutoMixedPrecisionImpl::AddAllowlistOps(
     if (!ShouldProcess(*root.node)) continue;
     bool force_allow = force_all_fp16_ && CanForceFP16(*root.node);
     if (f16_allowlist_.count(root.node->op()) || force_allow) {
+      // On AMX, only the nodes with a bfloat16 kernel registered are known
+      // to be faster.
+      if (mode_ == AutoMixedPrecisionMode::AMX_BF16 && !SupportsF16(root)) {
+        VLOG(2) << "Not painting " << root.node->op() << " node "
+                << root.node->name()
+                << " ALLOW because it has no bfloat16 kernel";
+        continue;
+      }
       bool inserted = allow_set->insert(root_idx).second;
       if (VLOG_IS_ON(2) && inserted) {
         VLOG(2) << "Painting type " << root.type_attr.DebugString()
@@ -1863,7 +1912,8 @@ void AutoMixedPrecisionImpl::AddInferToAllowIfFollowAllow(
     const absl::flat_hash_set<int>& deny_set,
     absl::flat_hash_set<int>* allow_set) const {
   // Currently only target for oneDNN
-  if (mode_ != AutoMixedPrecisionMode::BF16) {
+  if (mode_ != AutoMixedPrecisionMode::BF16 &&
+      mode_ != AutoMixedPrecisionMode::AMX_BF16) {
     return;
   }
   for (int item_idx = 0; item_idx < graph_type_view_.num_nodes(); ++item_idx) {
@@ -1914,6 +1964,178 @@ void AutoMixedPrecisionImpl::RemoveAllowsetWithFp32(
   }
 }
 
+// Returns the time, in nanoseconds, that the op-level cost model expects
+// `node` to take in float32.
+double AutoMixedPrecisionImpl::EstimateFp32TimeNs(
+    const NodeDef& node,
+    const std::unordered_map<string, const NodeDef*>& name_to_node) const {
+  OpContext op_context;
+  op_context.name = node.name();
+  op_context.op_info = BuildOpInfoWithoutDevice(
+      node, name_to_node, graph_properties_->GetInputProperties(node.name()));
+  *op_context.op_info.mutable_device() = virtual_placer_.get_device(node);
+  return cost_estimator_.PredictCosts(op_context).execution_time.count();
+}
+
+// Returns the time, in nanoseconds, that the op-level cost model expects a
+// Cast of the output of `node_type` between float32 and the target type to
+// take.
+double AutoMixedPrecisionImpl::EstimateCastTimeNs(
+    const NodeTypeId& node_type) const {
+  const absl::flat_hash_set<int>& ports =
+      node_type_map_.GetOutputPorts(*node_type.node, node_type.type_attr);
+  const std::vector<OpInfo::TensorProperties>& outputs =
+      graph_properties_->GetOutputProperties(node_type.node->name());
+  if (ports.empty()) return 0;
+  const int port_id = *std::min_element(ports.begin(), ports.end());
+  if (port_id >= outputs.size()) return 0;
+
+  OpContext op_context;
+  op_context.name = node_type.node->name();
+  op_context.op_info.set_op("Cast");
+  *op_context.op_info.add_inputs() = outputs[port_id];
+  OpInfo::TensorProperties* output = op_context.op_info.add_outputs();
+  *output = outputs[port_id];
+  output->set_dtype(target_dtype_);
+  *op_context.op_info.mutable_device() =
+      virtual_placer_.get_device(*node_type.node);
+  return cost_estimator_.PredictCosts(op_context).execution_time.count();
+}
+
+// Removes from allow_set the clusters of connected allow nodes that are not
+// expected to be faster in the target type. A cluster saves the float32 time
+// of its nodes scaled by their expected speedups, and pays for a Cast at each
+// float32 tensor crossing its boundary. Casts of constants are free, since
+// constant folding removes them.
+void AutoMixedPrecisionImpl::RemoveUnprofitableAllowClusters(
+    absl::flat_hash_set<int>* allow_set) const {
+  if (graph_properties_ == nullptr) return;
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : graph_->node()) {
+    name_to_node[node.name()] = &node;
+  }
+
+  absl::flat_hash_set<int> visited;
+  for (int root_idx = 0; root_idx < graph_type_view_.num_nodes(); ++root_idx) {
+    if (!allow_set->count(root_idx) || !visited.insert(root_idx).second) {
+      continue;
+    }
+    std::vector<int> cluster;
+    std::vector<int> to_visit = {root_idx};
+    while (!to_visit.empty()) {
+      const int idx = to_visit.back();
+      to_visit.pop_back();
+      cluster.push_back(idx);
+      for (const int fanin : graph_type_view_.GetFanin(idx)) {
+        if (allow_set->count(fanin) && visited.insert(fanin).second) {
+          to_visit.push_back(fanin);
+        }
+      }
+      for (const int fanout : graph_type_view_.GetFanout(idx)) {
+        if (allow_set->count(fanout) && visited.insert(fanout).second) {
+          to_visit.push_back(fanout);
+        }
+      }
+    }
+
+    double saved_ns = 0;
+    double cast_ns = 0;
+    absl::flat_hash_set<const NodeDef*> estimated_nodes;
+    absl::flat_hash_set<int> cast_sources;
+    for (const int idx : cluster) {
+      const NodeTypeId& item = *graph_type_view_.GetNode(idx);
+      auto it = expected_speedups_.find(item.node->op());
+      if (it != expected_speedups_.end() &&
+          estimated_nodes.insert(item.node).second) {
+        saved_ns += EstimateFp32TimeNs(*item.node, name_to_node) *
+                    (1.0 - 1.0 / it->second);
+      }
+      for (const int fanin : graph_type_view_.GetFanin(idx)) {
+        const NodeTypeId& src = *graph_type_view_.GetNode(fanin);
+        if (!allow_set->count(fanin) && IsFloat32(src) &&
+            !IsConstant(*src.node) && cast_sources.insert(fanin).second) {
+          cast_ns += EstimateCastTimeNs(src);
+        }
+      }
+      for (const int fanout : graph_type_view_.GetFanout(idx)) {
+        if (!allow_set->count(fanout) &&
+            IsFloat32(*graph_type_view_.GetNode(fanout)) &&
+            cast_sources.insert(idx).second) {
+          cast_ns += EstimateCastTimeNs(item);
+        }
+      }
+    }
+
+    if (saved_ns > cast_ns) continue;
+    VLOG(1) << "Not converting the cluster of " << cluster.size()
+            << " node type(s) around node "
+            << graph_type_view_.GetNode(root_idx)->node->name()
+            << ": it saves " << saved_ns << "ns but its casts take "
+            << cast_ns << "ns";
+    for (const int idx : cluster) {
+      allow_set->erase(idx);
+      if (VLOG_IS_ON(2)) {
+        const NodeTypeId& item = *graph_type_view_.GetNode(idx);
+        VLOG(2) << "UnPainting type " << item.type_attr.DebugString()
+                << " of " << item.node->op() << " node " << item.node->name()
+                << " ALLOW because converting its cluster is not profitable";
+      }
+    }
+  }
+}
+
+// Logs, for each op with an expected speedup, how many of its nodes are
+// converted and the speedup expected from converting them.
+void AutoMixedPrecisionImpl::LogExpectedSpeedups(
+    const absl::flat_hash_set<int>& allow_set) const {
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  if (graph_properties_ != nullptr) {
+    for (const NodeDef& node : graph_->node()) {
+      name_to_node[node.name()] = &node;
+    }
+  }
+  struct OpReport {
+    int num_nodes = 0;
+    int num_converted = 0;
+    double fp32_ns = 0;
+    double converted_ns = 0;
+  };
+  std::map<string, OpReport> reports;
+  absl::flat_hash_set<const NodeDef*> reported_nodes;
+  for (int idx = 0; idx < graph_type_view_.num_nodes(); ++idx) {
+    const NodeTypeId& item = *graph_type_view_.GetNode(idx);
+    auto it = expected_speedups_.find(item.node->op());
+    if (it == expected_speedups_.end() || !ShouldProcess(*item.node) ||
+        !reported_nodes.insert(item.node).second) {
+      continue;
+    }
+    const bool converted = allow_set.count(idx);
+    const double fp32_ns = graph_properties_ != nullptr
+                               ? EstimateFp32TimeNs(*item.node, name_to_node)
+                               : 0;
+    OpReport& report = reports[item.node->op()];
+    ++report.num_nodes;
+    report.fp32_ns += fp32_ns;
+    if (converted) {
+      ++report.num_converted;
+      report.converted_ns += fp32_ns / it->second;
+    } else {
+      report.converted_ns += fp32_ns;
+    }
+    VLOG(1) << (converted ? "Converted " : "Did not convert ")
+            << item.node->op() << " node " << item.node->name()
+            << ", expected speedup " << (converted ? it->second : 1.0f);
+  }
+  for (const auto& [op, report] : reports) {
+    LOG(INFO) << op << ": converted " << report.num_converted << "/"
+              << report.num_nodes << " nodes to bfloat16, expected speedup "
+              << (report.converted_ns > 0
+                      ? absl::StrFormat("%.2fx",
+                                        report.fp32_ns / report.converted_ns)
+                      : "unknown");
+  }
+}
+
 // Forces NextIteration nodes and their output Merge node(s) to have the same
 // color. Specifically, it removes them all from allow_set if any of the Merge
 // nodes is not in allow_set, otherwise it adds the NextIteration node to
@@ -2289,9 +2511,11 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
 
 #if !defined(INTEL_MKL)
-  if (mode_ == AutoMixedPrecisionMode::BF16) {
+  if (mode_ == AutoMixedPrecisionMode::BF16 ||
+      mode_ == AutoMixedPrecisionMode::AMX_BF16) {
     return errors::Unimplemented(
-        "The auto_mixed_precision_onednn_bfloat16 optimizer cannot be used "
+        "The ", name(),
+        " optimizer cannot be used "
         "since this build of TensorFlow is not compiled with oneDNN support "
         "for bfloat16. "
         "For information on oneDNN builds, see: "
@@ -2316,15 +2540,34 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
     VLOG(1) << "No support for " << name() << " graph optimizer on CPU";
     return absl::OkStatus();
   }
+  if (mode_ == AutoMixedPrecisionMode::AMX_BF16 &&
+      !IsAMXDataTypeSupportedByOneDNNOnThisCPU(DT_BFLOAT16)) {
+    VLOG(1) << "No AMX support for " << name() << " graph optimizer on CPU";
+    return absl::OkStatus();
+  }
 
   if (num_gpus >= 1 && mode_ == AutoMixedPrecisionMode::BF16) {
     LOG(WARNING) << "Note: GPUs detected. Using " << name()
                  << " graph optimizer configured for BFloat16 on CPUs";
   }
 
+  // The AMX_BF16 cost model needs the shapes of the tensors.
+  std::unique_ptr<GraphProperties> graph_properties;
+  if (mode_ == AutoMixedPrecisionMode::AMX_BF16) {
+    graph_properties = std::make_unique<GraphProperties>(item);
+    Status status =
+        graph_properties->InferStatically(/*assume_valid_feeds=*/false);
+    if (!status.ok()) {
+      VLOG(1) << "Converting all eligible nodes since shape inference "
+                 "failed: "
+              << status;
+      graph_properties.reset();
+    }
+  }
+
   // Optimize the output graph in-place.
   AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
-                                   item.id, mode_);
+                                   item.id, mode_, graph_properties.get());
   if (item.id == "tf_graph") {
     LOG(INFO) << "Running " << name() << " graph optimizer";
   } else {
@@ -27,7 +27,9 @@ namespace grappler {
 // BF16: convert to bfloat16 on CPU
 // CPU: emulate float16 on CPU without changing operator kernel
 // FP16_CPU : convert to float16 on CPU
-enum class AutoMixedPrecisionMode { CUDA, BF16, CPU, FP16_CPU };
+// AMX_BF16: convert to bfloat16 on CPUs with AMX, where a cost model finds it
+//           faster
+enum class AutoMixedPrecisionMode { CUDA, BF16, CPU, FP16_CPU, AMX_BF16 };
 
 // Convert data types to float16 or bfloat16 where appropriate to improve
 // performance on GPUs or CPUs.
@@ -35,7 +37,9 @@ class AutoMixedPrecision : public GraphOptimizer {
  public:
   // If 'mode' is CUDA, converts nodes to float16 on Nvidia GPUs. If BF16 or
   // FP16_CPU, converts nodes to bfloat16/fp16 on CPUs in order to take
-  // advantage of oneDNN performance improvements with bfloat16/fp16.
+  // advantage of oneDNN performance improvements with bfloat16/fp16. If
+  // AMX_BF16, only converts the nodes expected to run faster in bfloat16 on
+  // AMX, casts included.
   explicit AutoMixedPrecision(
       AutoMixedPrecisionMode mode = AutoMixedPrecisionMode::CUDA)
       : mode_(mode) {}
@@ -53,6 +57,8 @@ class AutoMixedPrecision : public GraphOptimizer {
       case AutoMixedPrecisionMode::FP16_CPU:
         // Note: using different name than GPU for ease of debugging.
         return "auto_mixed_precision_onednn_float16";
+      case AutoMixedPrecisionMode::AMX_BF16:
+        return "auto_mixed_precision_amx_bfloat16";
       default:
         LOG(FATAL) << "Invalid value for AutoMixedPrecisionMode: "  // Crash Ok
                    << static_cast<int>(mode_);
@@ -17,10 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_LISTS_H_
 
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
@@ -593,6 +597,60 @@ class AutoMixedPrecisionListsMkl : public AutoMixedPrecisionLists {
   }
 };
 
+// Lists for CPUs with AMX. The allowlist is made of the ops whose bfloat16
+// kernels are expected to be faster than their float32 ones, and only the
+// nodes that have a bfloat16 kernel registered are converted.
+class AutoMixedPrecisionListsAmx : public AutoMixedPrecisionListsMkl {
+ public:
+  AutoMixedPrecisionListsAmx() {}
+
+  gtl::FlatSet<string> AllowList() override {
+    gtl::FlatSet<string> list;
+    for (const auto& op_and_speedup : ExpectedSpeedups()) {
+      if (op_and_speedup.second > 1.0f) list.insert(op_and_speedup.first);
+    }
+    UpdateList("ALLOWLIST", &list);
+    return list;
+  }
+
+  // Returns the expected speedup of ops when run in bfloat16 on AMX rather
+  // than in float32. Ops that are not listed are not expected to be faster.
+  // The defaults are conservative; speedups measured on the target machine
+  // can be given as "op:speedup,..." in
+  // TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_AMX_SPEEDUPS, and an op with a
+  // speedup of at most 1 is not converted.
+  static gtl::FlatMap<string, float> ExpectedSpeedups() {
+    gtl::FlatMap<string, float> speedups = {
+        {"BatchMatMul", 3.0f},
+        {"BatchMatMulV2", 3.0f},
+        {"Conv2D", 3.0f},
+        {"Conv2DBackpropFilter", 2.5f},
+        {"Conv2DBackpropInput", 2.5f},
+        {"Conv3D", 2.5f},
+        {"Conv3DBackpropFilterV2", 2.0f},
+        {"Conv3DBackpropInputV2", 2.0f},
+        {"Einsum", 2.5f},
+        {"FusedPadConv2D", 3.0f},
+        {"MatMul", 3.0f},
+    };
+    string measured;
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_AMX_SPEEDUPS", "", &measured));
+    for (const auto& entry :
+         str_util::Split(measured, ",", str_util::SkipEmpty())) {
+      const std::vector<string> op_and_speedup = str_util::Split(entry, ":");
+      float speedup;
+      if (op_and_speedup.size() != 2 ||
+          !strings::safe_strtof(op_and_speedup[1], &speedup)) {
+        LOG(WARNING) << "Ignoring invalid AMX speedup entry: " << entry;
+        continue;
+      }
+      speedups[op_and_speedup[0]] = speedup;
+    }
+    return speedups;
+  }
+};
+
 }  // end namespace grappler
 }  // end namespace tensorflow
 
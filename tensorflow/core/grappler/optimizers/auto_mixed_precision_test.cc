@@ -1761,6 +1761,73 @@ TEST_F(AutoMixedPrecisionMklTest, InferFollowUpStreamDeny) {
     test::ExpectClose(tensors_expected[i], tensors[i]);
   }
 }
+
+TEST_F(AutoMixedPrecisionMklTest, AmxConvertsLargeMatMul) {
+  if (!IsMKLEnabled() || !IsAMXDataTypeSupportedByOneDNNOnThisCPU(DT_BFLOAT16))
+    GTEST_SKIP() << "Test only applicable to CPUs with AMX.";
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/device:CPU:0");
+  Output input = ops::Const(s.WithOpName("input"), 1.f / 512, {512, 512});
+  Output deny1 = ops::Exp(s.WithOpName("deny1"), input);
+  Output allow1 = ops::MatMul(s.WithOpName("allow1"), deny1, deny1);
+  Output clr1 = ops::Relu(s.WithOpName("clr1"), allow1);
+  Output fetch = ops::Identity(s.WithOpName("fetch"), clr1);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+
+  AutoMixedPrecision optimizer{AutoMixedPrecisionMode::AMX_BF16};
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+
+  VLOG(1) << output.DebugString();
+
+  GraphView output_view(&output);
+  EXPECT_EQ(output.node_size(), item.graph.node_size() + 2);
+  EXPECT_EQ(output_view.GetNode("deny1")->attr().at("T").type(), DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("allow1")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("clr1")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("fetch")->attr().at("T").type(), DT_FLOAT);
+
+  auto tensors = EvaluateNodes(output, item.fetch);
+  EXPECT_EQ(tensors.size(), tensors_expected.size());
+  EXPECT_EQ(tensors.size(), item.fetch.size());
+  for (int i = 0; i < item.fetch.size(); ++i) {
+    test::ExpectClose(tensors_expected[i], tensors[i], -1, 1e-2);
+  }
+}
+
+TEST_F(AutoMixedPrecisionMklTest, AmxSkipsMatMulNotWorthItsCasts) {
+  if (!IsMKLEnabled() || !IsAMXDataTypeSupportedByOneDNNOnThisCPU(DT_BFLOAT16))
+    GTEST_SKIP() << "Test only applicable to CPUs with AMX.";
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/device:CPU:0");
+  // An outer product does little work per element of its output, so casting
+  // the output back to float32 costs more than bfloat16 saves.
+  Output input1 = ops::Const(s.WithOpName("input1"), 1.f, {1024, 1});
+  Output input2 = ops::Const(s.WithOpName("input2"), 1.f, {1, 1024});
+  Output deny1 = ops::Exp(s.WithOpName("deny1"), input1);
+  Output deny2 = ops::Exp(s.WithOpName("deny2"), input2);
+  Output allow1 = ops::MatMul(s.WithOpName("allow1"), deny1, deny2);
+  Output deny3 = ops::Exp(s.WithOpName("deny3"), allow1);
+  Output fetch = ops::Identity(s.WithOpName("fetch"), deny3);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoMixedPrecision optimizer{AutoMixedPrecisionMode::AMX_BF16};
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+
+  VLOG(1) << output.DebugString();
+
+  GraphView output_view(&output);
+  EXPECT_EQ(output.node_size(), item.graph.node_size());
+  EXPECT_EQ(output_view.GetNode("allow1")->attr().at("T").type(), DT_FLOAT);
+}
 #endif  // INTEL_MKL
 
 }  // namespace
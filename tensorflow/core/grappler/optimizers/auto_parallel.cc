@@ -15,16 +15,25 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/transitive_fanin.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 
@@ -271,5 +280,165 @@ Status AutoParallel::Optimize(Cluster* cluster, const GrapplerItem& item,
   return absl::OkStatus();
 }
 
+namespace {
+
+// Splits the nodes with the given costs into stages of consecutive nodes,
+// starting a new stage whenever the next node would take the current one over
+// `max_cost` or `max_memory`. Returns the number of stages, or -1 if a single
+// node exceeds the limits. Fills `node_stage` if it is not null.
+int AssignPipelineStages(const std::vector<double>& costs,
+                         const std::vector<int64_t>& memory, double max_cost,
+                         int64_t max_memory, std::vector<int>* node_stage) {
+  int num_stages = 0;
+  double stage_cost = 0.0;
+  int64_t stage_memory = 0;
+  for (size_t i = 0; i < costs.size(); ++i) {
+    if (costs[i] > max_cost || memory[i] > max_memory) {
+      return -1;
+    }
+    if (num_stages == 0 || stage_cost + costs[i] > max_cost ||
+        stage_memory + memory[i] > max_memory) {
+      ++num_stages;
+      stage_cost = 0.0;
+      stage_memory = 0;
+    }
+    stage_cost += costs[i];
+    stage_memory += memory[i];
+    if (node_stage != nullptr) {
+      node_stage->push_back(num_stages - 1);
+    }
+  }
+  return num_stages;
+}
+
+}  // namespace
+
+string PipelinePartition::DebugString() const {
+  string report = strings::StrCat(
+      "Pipeline partition with ", stage_costs.size(), " stages, ",
+      node_stage.size(), " nodes, estimated bubble fraction ",
+      bubble_fraction, "\n");
+  std::vector<int> num_nodes(stage_costs.size(), 0);
+  for (const auto& node : node_stage) {
+    ++num_nodes[node.second];
+  }
+  for (size_t i = 0; i < stage_costs.size(); ++i) {
+    strings::StrAppend(&report, "  stage ", i, ": ", num_nodes[i],
+                       " nodes, compute ", stage_costs[i], "ns, memory ",
+                       stage_memory[i], " bytes\n");
+  }
+  return report;
+}
+
+double EstimatePipelineBubble(const std::vector<double>& stage_costs,
+                              int num_micro_batches) {
+  if (stage_costs.empty() || num_micro_batches <= 0) {
+    return 0.0;
+  }
+  double total_cost = 0.0;
+  double max_cost = 0.0;
+  for (double cost : stage_costs) {
+    total_cost += cost;
+    max_cost = std::max(max_cost, cost);
+  }
+  // The first micro-batch goes through every stage, after which the slowest
+  // stage paces the remaining ones.
+  const double makespan = total_cost + (num_micro_batches - 1) * max_cost;
+  if (makespan <= 0.0) {
+    return 0.0;
+  }
+  const double busy = num_micro_batches * total_cost;
+  return 1.0 - busy / (stage_costs.size() * makespan);
+}
+
+Status PartitionIntoPipelineStages(const GrapplerItem& item, int num_stages,
+                                   int num_micro_batches,
+                                   int64_t max_stage_memory,
+                                   PipelinePartition* partition) {
+  if (num_stages < 1 || num_micro_batches < 1) {
+    return errors::InvalidArgument(
+        "Pipeline partitioning needs at least one stage and micro-batch, got ",
+        num_stages, " stages and ", num_micro_batches, " micro-batches");
+  }
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(item.graph, &topo_order));
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(false));
+
+  OpLevelCostEstimator estimator;
+  const DeviceProperties local_cpu = GetLocalCPUInfo();
+  std::vector<double> costs;
+  std::vector<int64_t> memory;
+  costs.reserve(topo_order.size());
+  memory.reserve(topo_order.size());
+  double total_cost = 0.0;
+  double max_cost = 0.0;
+  for (const NodeDef* node : topo_order) {
+    OpContext op_context;
+    op_context.name = node->name();
+    op_context.op_info.set_op(node->op());
+    *op_context.op_info.mutable_attr() = node->attr();
+    for (const auto& input : properties.GetInputProperties(node->name())) {
+      *op_context.op_info.add_inputs() = input;
+    }
+    for (const auto& output : properties.GetOutputProperties(node->name())) {
+      *op_context.op_info.add_outputs() = output;
+    }
+    DeviceProperties device = GetDeviceInfo(node->device());
+    if (device.type() != "CPU" && device.type() != "GPU") {
+      device = local_cpu;
+    }
+    *op_context.op_info.mutable_device() = device;
+    const Costs node_costs = estimator.PredictCosts(op_context);
+    costs.push_back(node_costs.execution_time.count());
+    memory.push_back(node_costs.persistent_memory +
+                     node_costs.temporary_memory);
+    total_cost += costs.back();
+    max_cost = std::max(max_cost, costs.back());
+  }
+
+  // The smallest feasible stage cost lies between the most expensive node and
+  // the whole graph; the number of stages needed decreases with it.
+  const int64_t memory_limit = max_stage_memory > 0
+                                   ? max_stage_memory
+                                   : std::numeric_limits<int64_t>::max();
+  const int num_needed =
+      AssignPipelineStages(costs, memory, total_cost, memory_limit, nullptr);
+  if (num_needed < 0 || num_needed > num_stages) {
+    return errors::InvalidArgument("The graph of ", item.id,
+                                   " does not fit in ", num_stages,
+                                   " stages of ", max_stage_memory, " bytes");
+  }
+  double lo = max_cost;
+  double hi = total_cost;
+  for (int i = 0; i < 64 && lo < hi; ++i) {
+    const double mid = lo + (hi - lo) / 2;
+    const int needed =
+        AssignPipelineStages(costs, memory, mid, memory_limit, nullptr);
+    if (needed >= 0 && needed <= num_stages) {
+      hi = mid;
+    } else {
+      lo = mid;
+    }
+  }
+
+  std::vector<int> node_stage;
+  node_stage.reserve(topo_order.size());
+  const int num_used =
+      AssignPipelineStages(costs, memory, hi, memory_limit, &node_stage);
+  partition->node_stage.clear();
+  partition->stage_costs.assign(std::max(num_used, 1), 0.0);
+  partition->stage_memory.assign(std::max(num_used, 1), 0);
+  for (size_t i = 0; i < topo_order.size(); ++i) {
+    partition->node_stage[topo_order[i]->name()] = node_stage[i];
+    partition->stage_costs[node_stage[i]] += costs[i];
+    partition->stage_memory[node_stage[i]] += memory[i];
+  }
+  partition->bubble_fraction =
+      EstimatePipelineBubble(partition->stage_costs, num_micro_batches);
+  VLOG(1) << partition->DebugString();
+  return absl::OkStatus();
+}
+
 }  // end namespace grappler
 }  // end namespace tensorflow
@@ -16,7 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_AUTO_PARALLEL_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_AUTO_PARALLEL_H_
 
+#include <cstdint>
+#include <map>
+#include <vector>
+
 #include "tensorflow/core/framework/variable.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -59,6 +64,42 @@ class AutoParallel : public GraphOptimizer {
   void BuildGraph(GraphDef* graph);
 };
 
+// A split of a graph into pipeline stages. Every stage is a contiguous range of
+// the nodes in topological order, so data only flows from a stage to the
+// following ones.
+struct PipelinePartition {
+  // Stage of every node of the graph, keyed by node name.
+  std::map<string, int> node_stage;
+  // Estimated compute time of each stage for one micro-batch, in nanoseconds.
+  std::vector<double> stage_costs;
+  // Estimated memory of each stage, in bytes.
+  std::vector<int64_t> stage_memory;
+  // Estimated fraction of the device time spent idle while the pipeline fills
+  // and drains.
+  double bubble_fraction = 0.0;
+
+  // Returns a human readable report of the partition.
+  string DebugString() const;
+};
+
+// Returns the fraction of device time lost to pipeline bubbles when running
+// `num_micro_batches` micro-batches through stages with the given costs with a
+// GPipe-style schedule. For balanced stages this is (S - 1) / (M + S - 1); an
+// imbalance between stages adds to it.
+double EstimatePipelineBubble(const std::vector<double>& stage_costs,
+                              int num_micro_batches);
+
+// Splits the graph of `item` into at most `num_stages` pipeline stages,
+// minimizing the compute time of the most expensive stage. Node costs are
+// estimated with OpLevelCostEstimator on statically inferred shapes. If
+// `max_stage_memory` is positive, no stage gets more than that many bytes of
+// estimated memory. The graph itself is not modified: placing the stages and
+// scheduling the micro-batches between them is left to the caller.
+Status PartitionIntoPipelineStages(const GrapplerItem& item, int num_stages,
+                                   int num_micro_batches,
+                                   int64_t max_stage_memory,
+                                   PipelinePartition* partition);
+
 }  // end namespace grappler
 }  // end namespace tensorflow
 
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -150,6 +151,55 @@ TEST_F(AutoParallelTest, SimpleParallelNoDequeue) {
   TF_EXPECT_OK(status);
 }
 
+TEST_F(AutoParallelTest, PipelineBubble) {
+  // Balanced stages lose (S - 1) / (M + S - 1) of the device time.
+  EXPECT_NEAR(3.0 / 11.0, EstimatePipelineBubble({1.0, 1.0, 1.0, 1.0}, 8),
+              1e-9);
+  EXPECT_NEAR(0.0, EstimatePipelineBubble({5.0}, 4), 1e-9);
+  // The slow stage paces the pipeline, so an imbalance adds to the bubble.
+  EXPECT_GT(EstimatePipelineBubble({1.0, 3.0}, 8),
+            EstimatePipelineBubble({2.0, 2.0}, 8));
+}
+
+TEST_F(AutoParallelTest, PipelinePartition) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), 1.0f, {256, 256});
+  Output w = ops::Const(s.WithOpName("w"), 1.0f, {256, 256});
+  Output y = x;
+  for (int i = 0; i < 8; ++i) {
+    y = ops::MatMul(s.WithOpName(strings::StrCat("matmul_", i)), y, w);
+  }
+  GrapplerItem item;
+  item.fetch.push_back("matmul_7");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  PipelinePartition partition;
+  TF_EXPECT_OK(PartitionIntoPipelineStages(item, /*num_stages=*/2,
+                                           /*num_micro_batches=*/4,
+                                           /*max_stage_memory=*/0, &partition));
+  ASSERT_EQ(2, partition.stage_costs.size());
+  EXPECT_EQ(item.graph.node_size(), partition.node_stage.size());
+  // The matmuls have the same cost, so they are split evenly.
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(i < 4 ? 0 : 1,
+              partition.node_stage[strings::StrCat("matmul_", i)]);
+  }
+  EXPECT_NEAR(1.0 / 5.0, partition.bubble_fraction, 0.05);
+
+  // Every node has to be in a stage after the stages of its inputs.
+  for (const NodeDef& node : item.graph.node()) {
+    for (const string& input : node.input()) {
+      EXPECT_LE(partition.node_stage[NodeName(input)],
+                partition.node_stage[node.name()]);
+    }
+  }
+
+  EXPECT_FALSE(PartitionIntoPipelineStages(item, /*num_stages=*/2,
+                                           /*num_micro_batches=*/4,
+                                           /*max_stage_memory=*/1, &partition)
+                   .ok());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
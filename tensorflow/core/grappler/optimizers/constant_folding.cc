@@ -47,11 +47,13 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/setround.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/public/version.h"
@@ -193,21 +195,24 @@ float QuantizedTypeMaxAsFloat(DataType data_type) {
 ConstantFolding::ConstantFolding(RewriterConfig::Toggle opt_level,
                                  DeviceBase* cpu_device,
                                  bool disable_compressed_tensor_optimization,
-                                 bool fold_quantization_emulation)
+                                 bool fold_quantization_emulation,
+                                 const string& memmapped_constants_directory)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
       disable_compressed_tensor_optimization_(
           disable_compressed_tensor_optimization),
-      fold_quantization_emulation_(fold_quantization_emulation) {
+      fold_quantization_emulation_(fold_quantization_emulation),
+      memmapped_constants_directory_(memmapped_constants_directory) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
 ConstantFolding::ConstantFolding(DeviceBase* cpu_device,
                                  bool disable_compressed_tensor_optimization,
-                                 bool fold_quantization_ops)
+                                 bool fold_quantization_ops,
+                                 const string& memmapped_constants_directory)
     : ConstantFolding(RewriterConfig::ON, cpu_device,
                       disable_compressed_tensor_optimization,
-                      fold_quantization_ops) {}
+                      fold_quantization_ops, memmapped_constants_directory) {}
 
 // static
 string ConstantFolding::AddControlDependency(const string& input_name,
@@ -1037,8 +1042,10 @@ bool ConstantFolding::IsFoldableUncached(
         if (num_bytes < 0) {  // Overflown
           return false;
         }
-        if (num_bytes > input_size_bytes && num_bytes > kMaxConstantSize) {
-          // Do not fold nodes if the in-memory size of output is too large.
+        if (num_bytes > input_size_bytes && num_bytes > kMaxConstantSize &&
+            !ShouldMemmapConstant(node, output_prop.dtype(), num_bytes)) {
+          // Do not fold nodes if the in-memory size of output is too large,
+          // unless the output is memory-mapped from a file.
           // Notice that this is not exactly the same check used in
           // CreateNodeDef() where the actual encoded size is checked.
           return false;
@@ -1341,6 +1348,63 @@ Status ConstantFolding::EvaluateNode(const NodeDef& node,
                                               resource_mgr_.get(), output);
 }
 
+bool ConstantFolding::ShouldMemmapConstant(const NodeDef& node, DataType dtype,
+                                           int64_t num_bytes) const {
+  if (memmapped_constants_directory_.empty() || num_bytes < kMaxConstantSize) {
+    return false;
+  }
+  // ImmutableConst only has a CPU kernel, and can't hold types that need to
+  // be constructed in place.
+  if (!node.device().empty() && !NodeIsOnCpu(&node)) return false;
+  return DataTypeCanUseMemcpy(dtype);
+}
+
+Status ConstantFolding::CreateMemmappedNodeDef(const string& name,
+                                               const TensorValue& tensor,
+                                               NodeDef* node) const {
+  const StringPiece data = tensor->tensor_data();
+  const Fprint128 fingerprint = FingerprintCat128(
+      Fingerprint128(strings::StrCat(DataTypeString(tensor->dtype()), ";",
+                                     tensor->shape().DebugString())),
+      Fingerprint128(data));
+  const string file_name = io::JoinPath(
+      memmapped_constants_directory_,
+      absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                   absl::Hex(fingerprint.low64, absl::kZeroPad16),
+                   ".tensor"));
+  Env* env = Env::Default();
+  if (!env->FileExists(file_name).ok()) {
+    TF_RETURN_IF_ERROR(
+        env->RecursivelyCreateDir(memmapped_constants_directory_));
+    // Write to a file of a unique name first, so that graphs optimized
+    // concurrently never map a partially written file.
+    string temp_file_name = file_name;
+    if (!env->CreateUniqueFileName(&temp_file_name, ".tmp")) {
+      return errors::Internal("Could not create a unique file name for ",
+                              file_name);
+    }
+    TF_RETURN_IF_ERROR(WriteStringToFile(env, temp_file_name, data));
+    Status s = env->RenameFile(temp_file_name, file_name);
+    if (!s.ok()) {
+      env->DeleteFile(temp_file_name).IgnoreError();
+      return s;
+    }
+  }
+
+  node->set_name(name);
+  node->set_op("ImmutableConst");
+  AttrValue attr_type;
+  attr_type.set_type(tensor->dtype());
+  node->mutable_attr()->insert({"dtype", attr_type});
+  AttrValue attr_shape;
+  tensor->shape().AsProto(attr_shape.mutable_shape());
+  node->mutable_attr()->insert({"shape", attr_shape});
+  AttrValue attr_region;
+  attr_region.set_s(file_name);
+  node->mutable_attr()->insert({"memory_region_name", attr_region});
+  return absl::OkStatus();
+}
+
 Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
                                             std::vector<NodeDef>* outputs,
                                             bool* result_too_large) {
@@ -1408,8 +1472,18 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
       node_name = strings::StrCat(node_name, "-", i);
     }
     if (output_tensors[i].tensor) {
-      Status s = CreateNodeDef(node_name, output_tensors[i], &outputs->at(i),
+      NodeDef* output = &outputs->at(i);
+      Status s = CreateNodeDef(node_name, output_tensors[i], output,
                                total_inputs_size);
+      // Outputs that remain large once encoded are memory-mapped from a file
+      // rather than inlined in the graph.
+      if (ShouldMemmapConstant(node, output_tensors[i]->dtype(),
+                               output_tensors[i]->TotalBytes()) &&
+          (!s.ok() || output->attr().at("value").tensor().ByteSizeLong() >=
+                          kMaxConstantSize)) {
+        *output = NodeDef();
+        s = CreateMemmappedNodeDef(node_name, output_tensors[i], output);
+      }
       if (!s.ok()) {
         *result_too_large = true;
         return s;
@@ -1568,7 +1642,7 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
     // We rewrite the existing node if it only has a single output, and
     // create new nodes otherwise.
     if (const_nodes.size() == 1) {
-      node->set_op("Const");
+      node->set_op(const_node->op());
       // Note we need to clear the inputs in NodeMap before we clear the inputs
       // in the node, otherwise NodeMap would see empty inputs and effectively
       // does nothing.
@@ -47,10 +47,12 @@ class ConstantFolding : public GraphOptimizer {
 
   explicit ConstantFolding(DeviceBase* cpu_device,
                            bool disable_compressed_tensor_optimization = false,
-                           bool fold_quantization_emulation = true);
+                           bool fold_quantization_emulation = true,
+                           const string& memmapped_constants_directory = "");
   ConstantFolding(RewriterConfig::Toggle opt_level, DeviceBase* cpu_device,
                   bool disable_compressed_tensor_optimization = false,
-                  bool fold_quantization_emulation = true);
+                  bool fold_quantization_emulation = true,
+                  const string& memmapped_constants_directory = "");
 
   ~ConstantFolding() override {}
 
@@ -92,6 +94,16 @@ class ConstantFolding : public GraphOptimizer {
                       const gtl::InlinedVector<TensorValue, 4>& inputs,
                       gtl::InlinedVector<TensorValue, 4>* output) const;
 
+  // Returns true if a folded output of `node` with the given type and size is
+  // written to a file in memmapped_constants_directory_ rather than inlined.
+  bool ShouldMemmapConstant(const NodeDef& node, DataType dtype,
+                            int64_t num_bytes) const;
+  // Creates an ImmutableConst node that memory-maps the contents of `tensor`
+  // from a file in memmapped_constants_directory_, writing the file unless a
+  // constant with the same contents was written before.
+  Status CreateMemmappedNodeDef(const string& name, const TensorValue& tensor,
+                                NodeDef* node) const;
+
   Status EvaluateOneFoldable(const NodeDef& node, std::vector<NodeDef>* outputs,
                              bool* result_too_large);
 
@@ -340,6 +352,7 @@ class ConstantFolding : public GraphOptimizer {
   bool graph_contains_assign_or_inplace_op_;
   bool disable_compressed_tensor_optimization_;
   bool fold_quantization_emulation_;
+  string memmapped_constants_directory_;
 };
 
 }  // end namespace grappler
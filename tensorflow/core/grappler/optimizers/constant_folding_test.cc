@@ -31,8 +31,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 
 namespace tensorflow {
@@ -3246,6 +3248,61 @@ TEST_F(ConstantFoldingTest, LargeConstant) {
   test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
 }
 
+TEST_F(ConstantFoldingTest, LargeConstantMemmapped) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  // Two identical 512 by 512 constant, non-compressible matrices.
+  Output diag1 =
+      ops::Const(scope.WithOpName("diag1"), 3.14f, TensorShape({512}));
+  Output diag2 =
+      ops::Const(scope.WithOpName("diag2"), 3.14f, TensorShape({512}));
+  Output mat1 = ops::Diag(scope.WithOpName("mat1"), diag1);
+  Output mat2 = ops::Diag(scope.WithOpName("mat2"), diag2);
+  Output out1 = ops::Identity(scope.WithOpName("out1"), mat1);
+  Output out2 = ops::Identity(scope.WithOpName("out2"), mat2);
+
+  GrapplerItem item;
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+  item.fetch = {"out1", "out2"};
+
+  const string directory =
+      io::JoinPath(testing::TmpDir(), "memmapped_constants");
+  int64_t undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(directory, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  ConstantFolding optimizer(/*cpu_device=*/nullptr,
+                            /*disable_compressed_tensor_optimization=*/false,
+                            /*fold_quantization_emulation=*/true, directory);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+
+  // Both matrices are folded into constants mapped from the same file.
+  string region;
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "mat1" || node.name() == "mat2") {
+      EXPECT_EQ(node.op(), "ImmutableConst");
+      EXPECT_EQ(node.input_size(), 0);
+      const string& node_region = node.attr().at("memory_region_name").s();
+      if (region.empty()) region = node_region;
+      EXPECT_EQ(node_region, region);
+      ++found;
+    }
+  }
+  EXPECT_EQ(found, 2);
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(directory, &children));
+  EXPECT_EQ(children.size(), 1);
+  EXPECT_LT(output.ByteSizeLong(), 2 * sizeof(float) * 512 + 1000);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 2);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors.size(), 2);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+  test::ExpectTensorEqual<float>(tensors_expected[1], tensors[1]);
+}
+
 TEST_F(ConstantFoldingTest, SwitchIdenticalInputs) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output x = ops::Placeholder(s.WithOpName("x"), DT_BOOL,
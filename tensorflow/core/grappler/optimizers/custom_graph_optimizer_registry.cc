@@ -66,6 +66,7 @@ const ConfigList& DefaultPluginConfigs() {
        {"shape_optimization", RewriterConfig::ON},
        {"auto_mixed_precision", RewriterConfig::ON},
        {"auto_mixed_precision_onednn_bfloat16", RewriterConfig::ON},
+       {"auto_mixed_precision_amx_bfloat16", RewriterConfig::ON},
        {"auto_mixed_precision_mkl", RewriterConfig::ON},
        {"auto_mixed_precision_cpu", RewriterConfig::ON},
        {"pin_to_host_optimization", RewriterConfig::ON},
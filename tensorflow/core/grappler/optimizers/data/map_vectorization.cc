@@ -0,0 +1,478 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/function_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kMapDataset[] = "MapDataset";
+constexpr char kParallelMapDataset[] = "ParallelMapDataset";
+constexpr char kParallelMapDatasetV2[] = "ParallelMapDatasetV2";
+constexpr char kBatchDataset[] = "BatchDataset";
+constexpr char kBatchDatasetV2[] = "BatchDatasetV2";
+constexpr char kMapDefun[] = "MapDefun";
+constexpr char kConst[] = "Const";
+constexpr char kOutputShapes[] = "output_shapes";
+constexpr char kOutputTypes[] = "output_types";
+
+// Ops that compute each element of their output from the matching element of
+// their input, and can thus be applied to a batch of inputs as is.
+bool IsUnaryElementwise(const string& op) {
+  static const auto* const kOps = new absl::flat_hash_set<string>(
+      {"Abs",
+       "AsString",
+       "Cast",
+       "Ceil",
+       "Cos",
+       "Exp",
+       "Expm1",
+       "Floor",
+       "Identity",
+       "IsFinite",
+       "IsInf",
+       "IsNan",
+       "Log",
+       "Log1p",
+       "LogicalNot",
+       "Neg",
+       "Reciprocal",
+       "Relu",
+       "Relu6",
+       "Round",
+       "Rsqrt",
+       "Sigmoid",
+       "Sign",
+       "Sin",
+       "Sqrt",
+       "Square",
+       "StringLower",
+       "StringStrip",
+       "StringToHashBucketFast",
+       "StringToNumber",
+       "StringUpper",
+       "Tanh"});
+  return kOps->contains(op);
+}
+
+// Element-wise ops whose two inputs are broadcast against each other.
+bool IsBinaryElementwise(const string& op) {
+  static const auto* const kOps = new absl::flat_hash_set<string>(
+      {"Add",          "AddV2",        "BitwiseAnd",
+       "BitwiseOr",    "BitwiseXor",   "Div",
+       "DivNoNan",     "Equal",        "FloorDiv",
+       "FloorMod",     "Greater",      "GreaterEqual",
+       "Less",         "LessEqual",    "LogicalAnd",
+       "LogicalOr",    "Maximum",      "Minimum",
+       "Mod",          "Mul",          "NotEqual",
+       "Pow",          "RealDiv",      "SquaredDifference",
+       "Sub",          "TruncateDiv",  "TruncateMod"});
+  return kOps->contains(op);
+}
+
+// What is known about a tensor of the map function.
+struct TensorInfo {
+  // Whether the tensor depends on the input element. Such tensors have an
+  // additional leading batch dimension in the vectorized function.
+  bool batched = false;
+  // The rank of the tensor in the map function, or -1 if unknown.
+  int rank = -1;
+  DataType dtype = DT_INVALID;
+};
+
+// Returns whether `node` can be applied to batched inputs as is, given what is
+// known about the tensors of the map function so far. If so, sets `*output`
+// and `*output_info` to the name of and what is known about its output.
+bool CanVectorize(const NodeDef& node,
+                  const absl::flat_hash_map<string, TensorInfo>& tensors,
+                  string* output, TensorInfo* output_info) {
+  const bool unary = IsUnaryElementwise(node.op());
+  if (!unary && !IsBinaryElementwise(node.op())) return false;
+  if (node.input_size() != (unary ? 1 : 2)) return false;
+  std::vector<const TensorInfo*> inputs;
+  for (const string& input : node.input()) {
+    auto it = tensors.find(input);
+    if (it == tensors.end()) return false;
+    inputs.push_back(&it->second);
+  }
+  const OpDef* op_def;
+  DataTypeVector input_types, output_types;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      !InOutTypesForNode(node, *op_def, &input_types, &output_types).ok() ||
+      output_types.size() != 1) {
+    return false;
+  }
+  if (unary) {
+    if (!inputs[0]->batched) return false;
+    output_info->rank = inputs[0]->rank;
+  } else if (inputs[0]->batched && inputs[1]->batched) {
+    // Broadcasting aligns the batch dimensions only if the ranks match.
+    if (inputs[0]->rank < 0 || inputs[0]->rank != inputs[1]->rank) {
+      return false;
+    }
+    output_info->rank = inputs[0]->rank;
+  } else {
+    const TensorInfo& batched = inputs[0]->batched ? *inputs[0] : *inputs[1];
+    const TensorInfo& invariant = inputs[0]->batched ? *inputs[1] : *inputs[0];
+    if (!batched.batched || invariant.rank < 0) return false;
+    // The invariant input must not be broadcast into the batch dimension.
+    if (invariant.rank > 0 &&
+        (batched.rank < 0 || invariant.rank > batched.rank)) {
+      return false;
+    }
+    output_info->rank = batched.rank;
+  }
+  output_info->batched = true;
+  output_info->dtype = output_types[0];
+  *output = absl::StrCat(node.name(), ":", op_def->output_arg(0).name(), ":0");
+  return true;
+}
+
+// Builds `vectorized`, which computes `func` for a batch of elements whose
+// `num_components` components have shapes `component_shapes`. Ops that cannot
+// be applied to the batch as is are moved into `map_defun_func`, which
+// `vectorized` applies to each element of the batch with `MapDefun`; sets
+// `*uses_map_defun` accordingly. Returns false if `func` cannot be vectorized,
+// or if vectorizing it would not apply any op to batched tensors.
+bool VectorizeFunction(const FunctionDef& func, int num_components,
+                       const std::vector<PartialTensorShape>& component_shapes,
+                       const std::vector<PartialTensorShape>& output_shapes,
+                       const FunctionDefLibrary& library,
+                       FunctionDef* vectorized, FunctionDef* map_defun_func,
+                       bool* uses_map_defun) {
+  const OpDef& signature = func.signature();
+  if (!func.control_ret().empty() ||
+      output_shapes.size() != signature.output_arg_size()) {
+    return false;
+  }
+  for (const NodeDef& node : func.node_def()) {
+    for (const string& input : node.input()) {
+      if (absl::StartsWith(input, "^")) return false;
+    }
+  }
+
+  absl::flat_hash_map<string, TensorInfo> tensors;
+  for (int i = 0; i < num_components; ++i) {
+    TensorInfo& info = tensors[signature.input_arg(i).name()];
+    info.batched = true;
+    info.rank = component_shapes[i].dims();
+    info.dtype = signature.input_arg(i).type();
+  }
+  for (const NodeDef& node : func.node_def()) {
+    auto value = node.attr().find("value");
+    if (node.op() != kConst || value == node.attr().end()) continue;
+    TensorInfo& info = tensors[absl::StrCat(node.name(), ":output:0")];
+    info.rank = value->second.tensor().tensor_shape().dim_size();
+    info.dtype = value->second.tensor().dtype();
+  }
+
+  // Find the nodes that only (transitively) depend on the input element
+  // through vectorizable nodes.
+  absl::flat_hash_set<string> vectorized_nodes;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const NodeDef& node : func.node_def()) {
+      if (vectorized_nodes.contains(node.name())) continue;
+      string output;
+      TensorInfo output_info;
+      if (!CanVectorize(node, tensors, &output, &output_info)) continue;
+      tensors[output] = output_info;
+      vectorized_nodes.insert(node.name());
+      changed = true;
+    }
+  }
+  if (vectorized_nodes.empty()) return false;
+
+  // Outputs that are not batched are computed per element by `MapDefun`.
+  std::vector<int> map_defun_outputs;
+  for (int i = 0; i < signature.output_arg_size(); ++i) {
+    auto ret = func.ret().find(signature.output_arg(i).name());
+    if (ret == func.ret().end()) return false;
+    auto info = tensors.find(ret->second);
+    if (info == tensors.end() || !info->second.batched) {
+      map_defun_outputs.push_back(i);
+    }
+  }
+  *uses_map_defun = !map_defun_outputs.empty();
+
+  // The batched tensors consumed by `map_defun_func`, in argument order.
+  std::vector<string> map_defun_args;
+  if (*uses_map_defun) {
+    map_defun_func->Clear();
+    absl::flat_hash_map<string, string> arg_names;
+    auto to_map_defun_tensor = [&](const string& tensor) {
+      auto info = tensors.find(tensor);
+      if (info == tensors.end() || !info->second.batched) return tensor;
+      auto [it, inserted] = arg_names.try_emplace(
+          tensor, absl::StrCat("vectorized_arg_", map_defun_args.size()));
+      if (inserted) map_defun_args.push_back(tensor);
+      return it->second;
+    };
+    for (const NodeDef& node : func.node_def()) {
+      if (vectorized_nodes.contains(node.name())) continue;
+      NodeDef* copy = map_defun_func->add_node_def();
+      *copy = node;
+      for (string& input : *copy->mutable_input()) {
+        input = to_map_defun_tensor(input);
+      }
+    }
+    // `MapDefun` needs at least one batched argument.
+    if (map_defun_args.empty()) {
+      to_map_defun_tensor(signature.input_arg(0).name());
+    }
+    OpDef* map_defun_signature = map_defun_func->mutable_signature();
+    for (const string& tensor : map_defun_args) {
+      OpDef::ArgDef* arg = map_defun_signature->add_input_arg();
+      arg->set_name(arg_names[tensor]);
+      arg->set_type(tensors[tensor].dtype);
+    }
+    for (int i = num_components; i < signature.input_arg_size(); ++i) {
+      if (absl::StartsWith(signature.input_arg(i).name(), "vectorized_arg_")) {
+        return false;
+      }
+      *map_defun_signature->add_input_arg() = signature.input_arg(i);
+    }
+    for (int i : map_defun_outputs) {
+      const string& name = signature.output_arg(i).name();
+      *map_defun_signature->add_output_arg() = signature.output_arg(i);
+      (*map_defun_func->mutable_ret())[name] = func.ret().at(name);
+    }
+    graph_utils::SetUniqueGraphFunctionName(
+        absl::StrCat(signature.name(), "_map_defun"), &library,
+        map_defun_func);
+  }
+
+  vectorized->Clear();
+  *vectorized->mutable_signature() = signature;
+  *vectorized->mutable_attr() = func.attr();
+  *vectorized->mutable_arg_attr() = func.arg_attr();
+  graph_utils::SetUniqueGraphFunctionName(
+      absl::StrCat("vectorized_", signature.name()), &library, vectorized);
+  for (const NodeDef& node : func.node_def()) {
+    if (vectorized_nodes.contains(node.name()) || node.op() == kConst) {
+      *vectorized->add_node_def() = node;
+    }
+  }
+  string map_defun_name;
+  if (*uses_map_defun) {
+    NodeDef* map_defun = vectorized->add_node_def();
+    function_utils::SetUniqueFunctionNodeName(kMapDefun, vectorized,
+                                              map_defun);
+    map_defun->set_op(kMapDefun);
+    map_defun_name = map_defun->name();
+    DataTypeVector arg_types, captured_types, output_types;
+    for (const string& tensor : map_defun_args) {
+      map_defun->add_input(tensor);
+      arg_types.push_back(tensors[tensor].dtype);
+    }
+    for (int i = num_components; i < signature.input_arg_size(); ++i) {
+      map_defun->add_input(signature.input_arg(i).name());
+      captured_types.push_back(signature.input_arg(i).type());
+    }
+    std::vector<PartialTensorShape> map_defun_output_shapes;
+    for (int i : map_defun_outputs) {
+      output_types.push_back(signature.output_arg(i).type());
+      map_defun_output_shapes.push_back(output_shapes[i]);
+    }
+    NameAttrList f;
+    f.set_name(map_defun_func->signature().name());
+    AddNodeAttr("Targuments", arg_types, map_defun);
+    AddNodeAttr("Tcaptured", captured_types, map_defun);
+    AddNodeAttr(kOutputTypes, output_types, map_defun);
+    AddNodeAttr(kOutputShapes, map_defun_output_shapes, map_defun);
+    AddNodeAttr("f", f, map_defun);
+    AddNodeAttr("max_intra_op_parallelism", 1, map_defun);
+  }
+  for (int i = 0, k = 0; i < signature.output_arg_size(); ++i) {
+    const string& name = signature.output_arg(i).name();
+    if (k < map_defun_outputs.size() && map_defun_outputs[k] == i) {
+      (*vectorized->mutable_ret())[name] =
+          absl::StrCat(map_defun_name, ":output:", k++);
+    } else {
+      (*vectorized->mutable_ret())[name] = func.ret().at(name);
+    }
+  }
+  return true;
+}
+
+bool IsMap(const NodeDef& node) {
+  return node.op() == kMapDataset || node.op() == kParallelMapDataset ||
+         node.op() == kParallelMapDatasetV2;
+}
+
+// Returns the batched `shapes`, with the leading dimension taken from
+// `batched_shape`.
+PartialTensorShape BatchedShape(const PartialTensorShape& shape,
+                                const PartialTensorShape& batched_shape) {
+  if (shape.unknown_rank()) return shape;
+  const int64_t batch_size =
+      batched_shape.unknown_rank() ? -1 : batched_shape.dim_size(0);
+  return PartialTensorShape({batch_size}).Concatenate(shape);
+}
+
+}  // namespace
+
+Status MapVectorization::OptimizeAndCollectStats(Cluster* cluster,
+                                                 const GrapplerItem& item,
+                                                 GraphDef* output,
+                                                 OptimizationStats* stats) {
+  GraphDef sorted_old_graph = item.graph;
+  TF_RETURN_IF_ERROR(TopologicalSort(&sorted_old_graph));
+  *output = sorted_old_graph;
+  MutableGraphView graph(output);
+  absl::flat_hash_set<string> nodes_to_delete;
+  FunctionLibraryDefinition function_library(OpRegistry::Global(),
+                                             item.graph.library());
+
+  for (const NodeDef& batch_node : sorted_old_graph.node()) {
+    if (batch_node.op() != kBatchDataset &&
+        batch_node.op() != kBatchDatasetV2) {
+      continue;
+    }
+    const NodeDef* map_node = graph_utils::GetInputNode(batch_node, graph);
+    if (map_node == nullptr || !IsMap(*map_node) ||
+        nodes_to_delete.contains(map_node->name())) {
+      continue;
+    }
+    // Do not rewrite a ParallelMap node that uses the unbounded thread pool.
+    if (map_node->attr().contains("use_unbounded_threadpool") &&
+        map_node->attr().at("use_unbounded_threadpool").b()) {
+      continue;
+    }
+    // The elements of the map must not be consumed by anything else.
+    if (graph.GetFanouts(*map_node, /*include_controlled_nodes=*/true).size() !=
+        1) {
+      continue;
+    }
+    const NodeDef* input_node = graph_utils::GetInputNode(*map_node, graph);
+    if (input_node == nullptr || !input_node->attr().contains(kOutputShapes) ||
+        !map_node->attr().contains(kOutputShapes) ||
+        !batch_node.attr().contains(kOutputShapes)) {
+      continue;
+    }
+    const FunctionDef* func =
+        function_library.Find(map_node->attr().at("f").func().name());
+    if (func == nullptr ||
+        function_utils::IsFunctionStateful(function_library, *func)) {
+      continue;
+    }
+
+    std::vector<PartialTensorShape> component_shapes, output_shapes,
+        batched_shapes;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(*input_node, kOutputShapes, &component_shapes));
+    TF_RETURN_IF_ERROR(GetNodeAttr(*map_node, kOutputShapes, &output_shapes));
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(batch_node, kOutputShapes, &batched_shapes));
+    // Batching the inputs of the map can only succeed for any input if their
+    // shapes are fully defined.
+    if (component_shapes.empty() ||
+        !absl::c_all_of(component_shapes, [](const PartialTensorShape& shape) {
+          return shape.IsFullyDefined();
+        })) {
+      continue;
+    }
+    const int num_captured =
+        map_node->attr().at("Targuments").list().type_size();
+    if (func->signature().input_arg_size() !=
+            component_shapes.size() + num_captured ||
+        batched_shapes.empty()) {
+      continue;
+    }
+
+    FunctionDef vectorized, map_defun_func;
+    bool uses_map_defun = false;
+    if (!VectorizeFunction(*func, component_shapes.size(), component_shapes,
+                           output_shapes, output->library(), &vectorized,
+                           &map_defun_func, &uses_map_defun)) {
+      VLOG(1) << "Could not vectorize map function "
+              << func->signature().name();
+      continue;
+    }
+    if (uses_map_defun) {
+      *output->mutable_library()->add_function() = map_defun_func;
+      TF_RETURN_IF_ERROR(function_library.AddFunctionDef(map_defun_func));
+    }
+    *output->mutable_library()->add_function() = vectorized;
+    TF_RETURN_IF_ERROR(function_library.AddFunctionDef(vectorized));
+
+    // Batch the inputs of the map instead of its outputs.
+    NodeDef new_batch_node = batch_node;
+    graph_utils::SetUniqueGraphNodeName(batch_node.op(), graph.graph(),
+                                        &new_batch_node);
+    new_batch_node.set_input(0, map_node->input(0));
+    DataTypeVector component_types;
+    TF_RETURN_IF_ERROR(
+        graph_utils::GetDatasetOutputTypesAttr(*input_node, &component_types));
+    std::vector<PartialTensorShape> batched_component_shapes;
+    for (const PartialTensorShape& shape : component_shapes) {
+      batched_component_shapes.push_back(
+          BatchedShape(shape, batched_shapes[0]));
+    }
+    SetAttrValue(component_types,
+                 &(*new_batch_node.mutable_attr())[kOutputTypes]);
+    SetAttrValue(batched_component_shapes,
+                 &(*new_batch_node.mutable_attr())[kOutputShapes]);
+    const NodeDef* new_batch = graph.AddNode(std::move(new_batch_node));
+
+    NodeDef new_map_node = *map_node;
+    graph_utils::SetUniqueGraphNodeName(map_node->op(), graph.graph(),
+                                        &new_map_node);
+    new_map_node.set_input(0, new_batch->name());
+    (*new_map_node.mutable_attr())["f"].mutable_func()->set_name(
+        vectorized.signature().name());
+    graph_utils::CopyShapesAndTypesAttrs(batch_node, &new_map_node);
+    const NodeDef* new_map = graph.AddNode(std::move(new_map_node));
+
+    TF_RETURN_IF_ERROR(graph.UpdateFanouts(batch_node.name(), new_map->name()));
+    nodes_to_delete.insert(map_node->name());
+    nodes_to_delete.insert(batch_node.name());
+    stats->num_changes++;
+  }
+
+  TF_RETURN_IF_ERROR(graph.DeleteNodes(nodes_to_delete));
+  return absl::OkStatus();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(MapVectorization, "map_vectorization");
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,220 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+using FDH = FunctionDefHelper;
+
+// Returns `x * 2` for a scalar int64 `x`.
+FunctionDef Int64TimesTwo() {
+  return FDH::Define(
+      "Int64TimesTwo", {"x: int64"}, {"y: int64"}, {},
+      {{{"two"}, "Const", {}, {{"value", int64_t{2}}, {"dtype", DT_INT64}}},
+       {{"y"}, "Mul", {"x", "two"}, {{"T", DT_INT64}}}});
+}
+
+// Returns `ZerosLike(Cast(x))`; `ZerosLike` is not vectorized.
+FunctionDef CastThenZerosLike() {
+  return FDH::Define(
+      "CastThenZerosLike", {"x: int64"}, {"y: float"}, {},
+      {{{"cast"}, "Cast", {"x"}, {{"SrcT", DT_INT64}, {"DstT", DT_FLOAT}}},
+       {{"y"}, "ZerosLike", {"cast"}, {{"T", DT_FLOAT}}}});
+}
+
+// Returns `x + [1, 2, 3]`, which broadcasts the scalar `x` into a vector.
+FunctionDef AddVector() {
+  return FDH::Define(
+      "AddVector", {"x: int64"}, {"y: int64"}, {},
+      {{{"c"},
+        "Const",
+        {},
+        {{"value", test::AsTensor<int64_t>({1, 2, 3})}, {"dtype", DT_INT64}}},
+       {{"y"}, "AddV2", {"x", "c"}, {{"T", DT_INT64}}}});
+}
+
+// Returns `x + RandomUniform()`.
+FunctionDef AddRandom() {
+  return FDH::Define(
+      "AddRandom", {"x: float"}, {"y: float"}, {},
+      {{{"shape"},
+        "Const",
+        {},
+        {{"value", test::AsTensor<int32>({})}, {"dtype", DT_INT32}}},
+       {{"random"},
+        "RandomUniform",
+        {"shape"},
+        {{"T", DT_INT32}, {"dtype", DT_FLOAT}, {"seed", 0}, {"seed2", 0}}},
+       {{"y"}, "AddV2", {"x", "random"}, {{"T", DT_FLOAT}}}});
+}
+
+// Builds `input.map(func).batch(10)`, where the elements of `input` are
+// scalars of type `input_type` with shape `input_shape`.
+GrapplerItem MakeMapAndBatchItem(const FunctionDef& func, DataType input_type,
+                                 const PartialTensorShape& input_shape) {
+  const DataType output_type = func.signature().output_arg(0).type();
+  PartialTensorShape batched_shape =
+      PartialTensorShape({10}).Concatenate(input_shape);
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT32}}),
+       NDef("input", "InputDataset", {"start"},
+            {{"output_shapes", std::vector<PartialTensorShape>{input_shape}},
+             {"output_types", std::vector<DataType>{input_type}}}),
+       NDef("map", "MapDataset", {"input"},
+            {{"f", FDH::FunctionRef(func.signature().name())},
+             {"Targuments", std::vector<DataType>{}},
+             {"output_shapes", std::vector<PartialTensorShape>{input_shape}},
+             {"output_types", std::vector<DataType>{output_type}}}),
+       NDef("batch_size", "Const", {}, {{"value", 10}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", true}, {"dtype", DT_BOOL}}),
+       NDef("batch", "BatchDatasetV2", {"map", "batch_size", "drop_remainder"},
+            {{"parallel_copy", false},
+             {"output_shapes", std::vector<PartialTensorShape>{batched_shape}},
+             {"output_types", std::vector<DataType>{output_type}}}),
+       NDef("Sink", "Identity", {"batch"}, {})},
+      {func});
+  return item;
+}
+
+const FunctionDef* FindFunction(const GraphDef& graph,
+                                const std::string& name) {
+  for (const FunctionDef& func : graph.library().function()) {
+    if (func.signature().name() == name) return &func;
+  }
+  return nullptr;
+}
+
+bool ContainsOp(const FunctionDef& func, const std::string& op) {
+  for (const NodeDef& node : func.node_def()) {
+    if (node.op() == op) return true;
+  }
+  return false;
+}
+
+TEST(MapVectorizationTest, VectorizesElementwiseFunction) {
+  GrapplerItem item =
+      MakeMapAndBatchItem(Int64TimesTwo(), DT_INT64, PartialTensorShape({}));
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("batch", output));
+  const NodeDef& batch =
+      output.node(graph_utils::FindGraphNodeWithOp("BatchDatasetV2", output));
+  const NodeDef& map =
+      output.node(graph_utils::FindGraphNodeWithOp("MapDataset", output));
+  EXPECT_EQ(batch.input(0), "input");
+  EXPECT_EQ(map.input(0), batch.name());
+  EXPECT_EQ(output.node(graph_utils::FindGraphNodeWithName("Sink", output))
+                .input(0),
+            map.name());
+
+  std::vector<PartialTensorShape> batched_shapes;
+  TF_ASSERT_OK(GetNodeAttr(batch, "output_shapes", &batched_shapes));
+  ASSERT_EQ(batched_shapes.size(), 1);
+  EXPECT_TRUE(batched_shapes[0].IsIdenticalTo(PartialTensorShape({10})));
+
+  const FunctionDef* vectorized =
+      FindFunction(output, map.attr().at("f").func().name());
+  ASSERT_NE(vectorized, nullptr);
+  EXPECT_TRUE(ContainsOp(*vectorized, "Mul"));
+  EXPECT_FALSE(ContainsOp(*vectorized, "MapDefun"));
+}
+
+TEST(MapVectorizationTest, FallsBackToMapDefun) {
+  GrapplerItem item = MakeMapAndBatchItem(CastThenZerosLike(), DT_INT64,
+                                          PartialTensorShape({}));
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  const NodeDef& map =
+      output.node(graph_utils::FindGraphNodeWithOp("MapDataset", output));
+  const FunctionDef* vectorized =
+      FindFunction(output, map.attr().at("f").func().name());
+  ASSERT_NE(vectorized, nullptr);
+  EXPECT_TRUE(ContainsOp(*vectorized, "Cast"));
+  EXPECT_FALSE(ContainsOp(*vectorized, "ZerosLike"));
+
+  const NodeDef* map_defun = nullptr;
+  for (const NodeDef& node : vectorized->node_def()) {
+    if (node.op() == "MapDefun") map_defun = &node;
+  }
+  ASSERT_NE(map_defun, nullptr);
+  ASSERT_EQ(map_defun->input_size(), 1);
+  EXPECT_EQ(map_defun->input(0), "cast:y:0");
+  const FunctionDef* per_element =
+      FindFunction(output, map_defun->attr().at("f").func().name());
+  ASSERT_NE(per_element, nullptr);
+  EXPECT_TRUE(ContainsOp(*per_element, "ZerosLike"));
+  EXPECT_FALSE(ContainsOp(*per_element, "Cast"));
+}
+
+TEST(MapVectorizationTest, DoesNotBroadcastIntoBatchDimension) {
+  GrapplerItem item =
+      MakeMapAndBatchItem(AddVector(), DT_INT64, PartialTensorShape({}));
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+TEST(MapVectorizationTest, DoesNotVectorizeStatefulFunction) {
+  GrapplerItem item =
+      MakeMapAndBatchItem(AddRandom(), DT_FLOAT, PartialTensorShape({}));
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+TEST(MapVectorizationTest, RequiresFullyDefinedInputShapes) {
+  GrapplerItem item =
+      MakeMapAndBatchItem(Int64TimesTwo(), DT_INT64, PartialTensorShape({-1}));
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
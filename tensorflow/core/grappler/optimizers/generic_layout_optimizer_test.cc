@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/tensor_float_32_utils.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -385,6 +386,49 @@ TEST_F(GenericLayoutOptimizerTest, CPUDevice) {
 #endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
 }
 
+TEST_F(GenericLayoutOptimizerTest, CPUNHWCToNCHWRequiresOneDnn) {
+#if (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  GTEST_SKIP() << "Clusters with GPUs take the GPU conversion path.";
+#endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto input = ops::RandomUniform(s.WithOpName("Input"), {8, 4, 4, 3},
+                                  DT_FLOAT);
+  auto filter = ops::RandomUniform(s.WithOpName("Filter"), {2, 2, 3, 2},
+                                   DT_FLOAT);
+  auto conv = ops::Conv2D(s.WithOpName("Conv2D").WithDevice("/CPU:0"), input,
+                          filter, {1, 1, 1, 1}, "VALID",
+                          ops::Conv2D::Attrs().DataFormat("NHWC"));
+  auto relu = ops::Relu(s.WithOpName("Relu").WithDevice("/CPU:0"), conv);
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {relu});
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   RewriterConfig::NHWC_TO_NCHW);
+  GraphDef output;
+  Status status = optimizer.Optimize(virtual_cluster_.get(), item, &output);
+  if (!IsMKLEnabled()) {
+    EXPECT_TRUE(absl::IsAborted(status));
+    return;
+  }
+  TF_ASSERT_OK(status);
+
+  utils::GraphView graph_view(&output, &status);
+  TF_ASSERT_OK(status);
+  auto* conv_node = graph_view.GetNode("Conv2D");
+  ASSERT_NE(conv_node, nullptr);
+  VerifyDataFormatAttributeMatch(conv_node, "NCHW");
+  // The layout agnostic Relu stays in NCHW, so the only transpose back to
+  // NHWC is in front of the fetch node.
+  auto* fetch_node = graph_view.GetNode("Fetch");
+  ASSERT_NE(fetch_node, nullptr);
+  ASSERT_EQ(fetch_node->NumRegularFanins(), 1);
+  const auto& fanin = fetch_node->GetRegularFanin(0);
+  EXPECT_EQ(fanin.node_view()->GetOp(), "Transpose");
+  EXPECT_EQ(fanin.node_view()->GetRegularFanin(0).node_view()->GetName(),
+            "Relu");
+}
+
 TEST_F(GenericLayoutOptimizerTest, NoOptimizeIntegerConvolution) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   auto conv = SimpleConv2D<int32>(&s, 4, 2, "VALID", "");
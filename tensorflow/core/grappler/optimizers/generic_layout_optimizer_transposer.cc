@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
@@ -40,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/protobuf/device_properties.pb.h"
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -184,6 +186,26 @@ std::vector<int> GetDimensionIndicesFromLabel(
   return indices;
 }
 
+// Returns true if `node` runs in `context.dst_format` on the target device.
+// On CPU only the oneDNN kernels, which replace the default ones when oneDNN is
+// enabled, support channels-first data formats.
+bool SupportsDstFormat(const TransposeContext& context, const NodeDef& node) {
+  if (context.target_device != "CPU" ||
+      (context.dst_format != "NCHW" && context.dst_format != "NCDHW")) {
+    return true;
+  }
+  static const absl::flat_hash_set<string>* one_dnn_channels_first_ops =
+      new absl::flat_hash_set<string>(
+          {"AvgPool", "AvgPoolGrad", "AvgPool3D", "AvgPool3DGrad", "BiasAdd",
+           "BiasAddGrad", "Conv2D", "Conv2DBackpropFilter",
+           "Conv2DBackpropInput", "Conv3D", "Conv3DBackpropFilterV2",
+           "Conv3DBackpropInputV2", "FusedBatchNorm", "FusedBatchNormGrad",
+           "FusedBatchNormGradV2", "FusedBatchNormGradV3", "FusedBatchNormV2",
+           "FusedBatchNormV3", "MaxPool", "MaxPoolGrad", "MaxPool3D",
+           "MaxPool3DGrad"});
+  return IsMKLEnabled() && one_dnn_channels_first_ops->contains(node.op());
+}
+
 // RAII-styled object for keeping track of 4D to 5D data format
 // upgrade/conversion. Currently only NHWC -> NDHWC and NCHW -> NCDHW are
 // supported.
@@ -286,8 +308,10 @@ bool Transposer::ShouldProcess(const TransposeContext& context,
                         absl::AsciiStrToLower(context.target_device));
 
   // Only checks data format for layout sensitive op.
-  const bool data_format_match = !IsLayoutSensitiveOp(*node_def) ||
-                                 AttrDataFormatMatch(node, context.src_format);
+  const bool data_format_match =
+      !IsLayoutSensitiveOp(*node_def) ||
+      (AttrDataFormatMatch(node, context.src_format) &&
+       SupportsDstFormat(context, *node_def));
 
   // Only transposes floating point nodes.
   const bool is_integer_conv2d = IsNonFloatingConv2D(node);
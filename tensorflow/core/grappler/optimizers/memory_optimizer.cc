@@ -30,6 +30,8 @@ limitations under the License.
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -440,9 +442,156 @@ void RecomputeSubgraph(
   }
 }
 
+// Chooses nodes to recompute for the target nodes instead of keeping their
+// outputs alive, until the estimated peak memory usage of each device of
+// `cluster` fits `peak_memory_budget_bytes` (80% of the device memory if not
+// positive). Nodes whose outputs are live at the peak are chosen greedily by
+// the bytes they free per nanosecond of recomputation, as estimated by
+// OpLevelCostEstimator. Recomputing a node keeps its inputs alive, so only
+// nodes whose inputs are live at the peak anyway are chosen, and never a node
+// together with one of its inputs.
+std::unordered_set<string> ChooseNodesToRecompute(
+    Cluster* cluster, const GrapplerItem& item,
+    int64_t peak_memory_budget_bytes,
+    const std::function<bool(const NodeDef&)>& should_recompute,
+    const std::function<bool(const NodeDef&)>& is_target) {
+  std::unordered_set<string> nodes_to_recompute;
+  if (cluster == nullptr || item.fetch.empty()) {
+    return nodes_to_recompute;
+  }
+  GraphMemory memory(item);
+  Status s = memory.InferStatically(cluster->GetDevices());
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s.message();
+    return nodes_to_recompute;
+  }
+  GraphProperties properties(item);
+  s = properties.InferStatically(/*assume_valid_feeds=*/false,
+                                 /*aggressive_shape_inference=*/false,
+                                 /*include_tensor_values=*/false);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer shapes: " << s.message();
+    return nodes_to_recompute;
+  }
+
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item.graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+  std::unordered_set<const NodeDef*> feeds_target;
+  for (const NodeDef& node : item.graph.node()) {
+    if (!is_target(node)) continue;
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) continue;
+      auto it = name_to_node.find(NodeName(input));
+      if (it != name_to_node.end()) feeds_target.insert(it->second);
+    }
+  }
+
+  OpLevelCostEstimator cost_estimator;
+  for (const auto& device : cluster->GetDevices()) {
+    const string& name = device.first;
+    const DeviceProperties& prop = device.second;
+    const int64_t budget = peak_memory_budget_bytes > 0
+                               ? peak_memory_budget_bytes
+                               : prop.memory_size() * 0.8;
+    if (budget <= 0) {
+      VLOG(1) << "Available memory unknown for device " << name;
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory <= budget) {
+      continue;
+    }
+
+    std::unordered_map<const NodeDef*, int64_t> live_bytes;
+    for (const auto& live : mem_usage.live_tensors) {
+      auto it = name_to_node.find(live.node);
+      if (it != name_to_node.end()) live_bytes[it->second] += live.memory_used;
+    }
+    const auto is_available = [&live_bytes](const NodeDef& node) {
+      return live_bytes.count(&node) > 0 || IsConstant(node) ||
+             IsVariable(node);
+    };
+
+    struct Candidate {
+      const NodeDef* node;
+      int64_t bytes;
+      int64_t cost_ns;
+    };
+    std::vector<Candidate> candidates;
+    for (const auto& [node, bytes] : live_bytes) {
+      if (feeds_target.count(node) == 0 || !should_recompute(*node) ||
+          node->input_size() == 0 || IsControlFlow(*node) ||
+          IsStateful(*node)) {
+        continue;
+      }
+      bool inputs_available = true;
+      for (const string& input : node->input()) {
+        auto it = name_to_node.find(NodeName(input));
+        if (it == name_to_node.end() ||
+            (!IsControlInput(input) && !is_available(*it->second))) {
+          inputs_available = false;
+          break;
+        }
+      }
+      if (!inputs_available) continue;
+
+      OpContext op_context;
+      op_context.name = node->name();
+      op_context.device_name = name;
+      op_context.op_info = BuildOpInfoWithoutDevice(
+          *node, name_to_node, properties.GetInputProperties(node->name()));
+      *op_context.op_info.mutable_device() = prop;
+      const Costs costs = cost_estimator.PredictCosts(op_context);
+      candidates.push_back(
+          {node, bytes, std::max<int64_t>(1, costs.execution_time.count())});
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) {
+                // Compare bytes per nanosecond without dividing.
+                const double a_score = static_cast<double>(a.bytes) * b.cost_ns;
+                const double b_score = static_cast<double>(b.bytes) * a.cost_ns;
+                return a_score > b_score ||
+                       (a_score == b_score && a.node->name() < b.node->name());
+              });
+
+    int64_t excess = mem_usage.used_memory - budget;
+    std::unordered_set<const NodeDef*> kept_inputs;
+    for (const Candidate& candidate : candidates) {
+      if (excess <= 0) break;
+      if (kept_inputs.count(candidate.node) > 0) continue;
+      bool input_recomputed = false;
+      for (const string& input : candidate.node->input()) {
+        if (nodes_to_recompute.count(NodeName(input)) > 0) {
+          input_recomputed = true;
+          break;
+        }
+      }
+      if (input_recomputed) continue;
+      VLOG(2) << "Recomputing " << candidate.node->name() << " on " << name
+              << " frees " << candidate.bytes << " bytes for an estimated "
+              << candidate.cost_ns << "ns";
+      nodes_to_recompute.insert(candidate.node->name());
+      excess -= candidate.bytes;
+      for (const string& input : candidate.node->input()) {
+        kept_inputs.insert(name_to_node[NodeName(input)]);
+      }
+    }
+    if (excess > 0) {
+      VLOG(1) << "Recomputation cannot bring the peak memory usage of " << name
+              << " under " << budget << " bytes, " << excess
+              << " bytes over";
+    }
+  }
+  return nodes_to_recompute;
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
-                                GraphDef* graph, const GrapplerItem& item) {
+                                int64_t peak_memory_budget_bytes,
+                                Cluster* cluster, GraphDef* graph,
+                                const GrapplerItem& item) {
   // The topological numberings and NodeMap will be stale as soon as we start
   // modifying the graph in RecomputeSubgraph. However, RecomputeSubgraph only
   // looks up nodes which were in the original graph, and preserves the graph
@@ -488,6 +637,22 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                   node.attr().count(kRecomputeHint) > 0);
         },
         is_target);
+  } else if (optimization_level == RewriterConfig::COST_BASED_RECOMPUTATION) {
+    // Memory usage is inferred on a copy, which does not disturb `node_map`.
+    const GrapplerItem current_item = item.WithGraph(GraphDef(*graph));
+    const std::unordered_set<string> nodes_to_recompute =
+        ChooseNodesToRecompute(
+            cluster, current_item, peak_memory_budget_bytes,
+            [&feeds, &is_target](const NodeDef& node) {
+              return !is_target(node) && feeds.count(node.name()) == 0;
+            },
+            is_target);
+    recomputed_subgraphs = GetOpGroupsToRecompute(
+        graph, node_map,
+        [&nodes_to_recompute](const NodeDef& node) {
+          return nodes_to_recompute.count(node.name()) > 0;
+        },
+        is_target);
   } else if (optimization_level == RewriterConfig::MANUAL) {
     recomputed_subgraphs = GetOpGroupsToRecompute(
         graph, node_map,
@@ -1376,6 +1541,42 @@ Status FindAssignNodesToRelax(const GraphDef& graph,
   return absl::OkStatus();
 }
 
+// Sets the "_scheduling_priority" attribute of the nodes of `item` to their
+// position in a schedule estimated to lower peak memory usage. When several
+// nodes are ready to run, the executor runs those of lowest priority first.
+// Leaves the graph unchanged if the schedule does not lower the estimate.
+void AssignSchedulingPriorities(Cluster* cluster, GrapplerItem* item) {
+  std::vector<const NodeDef*> schedule;
+  int64_t peak_memory_usage;
+  int64_t default_peak_memory_usage;
+  Status s = EstimateMemoryAwareSchedule(*item, cluster, &schedule,
+                                         &peak_memory_usage,
+                                         &default_peak_memory_usage);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to estimate a memory-aware schedule: " << s.message();
+    return;
+  }
+  if (peak_memory_usage >= default_peak_memory_usage) {
+    VLOG(1) << "Memory-aware schedule does not lower the estimated peak "
+            << "memory usage of " << default_peak_memory_usage << " bytes";
+    return;
+  }
+  VLOG(1) << "Memory-aware schedule lowers the estimated peak memory usage "
+          << "from " << default_peak_memory_usage << " to "
+          << peak_memory_usage << " bytes";
+
+  std::unordered_map<const NodeDef*, int> priorities;
+  for (int i = 0; i < schedule.size(); ++i) {
+    priorities[schedule[i]] = i;
+  }
+  for (NodeDef& node : *item->graph.mutable_node()) {
+    auto it = priorities.find(&node);
+    if (it != priorities.end()) {
+      (*node.mutable_attr())["_scheduling_priority"].set_i(it->second);
+    }
+  }
+}
+
 }  // namespace
 
 Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
@@ -1386,7 +1587,8 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   bool run_recomputation_pass =
       (optimization_level_ == RewriterConfig::RECOMPUTATION_HEURISTICS ||
        optimization_level_ == RewriterConfig::HEURISTICS ||
-       optimization_level_ == RewriterConfig::MANUAL);
+       optimization_level_ == RewriterConfig::MANUAL ||
+       optimization_level_ == RewriterConfig::COST_BASED_RECOMPUTATION);
   if (!run_recomputation_pass && nodes_to_relax.empty() && item.fetch.empty()) {
     return errors::Aborted("Nothing to do.");
   }
@@ -1395,9 +1597,9 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   RelaxAssignNodes(nodes_to_relax, &optimized_item.graph);
 
   if (run_recomputation_pass) {
-    RecomputationRewritingPass(optimization_level_,
-                               recomputation_targets_name_scope_,
-                               &optimized_item.graph, item);
+    RecomputationRewritingPass(
+        optimization_level_, recomputation_targets_name_scope_,
+        peak_memory_budget_bytes_, cluster, &optimized_item.graph, item);
   }
 
   std::unordered_set<string> skip_list;
@@ -1438,6 +1640,11 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     }
   }
 
+  if (scheduling_priorities_ && !item.fetch.empty() && cluster != nullptr) {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    AssignSchedulingPriorities(cluster, &optimized_item);
+  }
+
   optimized_graph->Swap(&optimized_item.graph);
   return absl::OkStatus();
 }
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MEMORY_OPTIMIZER_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MEMORY_OPTIMIZER_H_
 
+#include <cstdint>
 #include <string>
+
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
@@ -33,11 +35,20 @@ class MemoryOptimizer : public GraphOptimizer {
   // recomputation_targets_name_scope: Name scope for potential outputs of
   //   recomputations. See
   //   RewriterConfig::memory_optimizer_target_node_name_scope.
+  // peak_memory_budget_bytes: Target peak memory usage per device for
+  //   COST_BASED_RECOMPUTATION. See
+  //   RewriterConfig::memory_optimizer_peak_memory_budget_bytes.
+  // scheduling_priorities: Whether to annotate the nodes with the order in
+  //   which the executor should run them to lower peak memory usage. See
+  //   RewriterConfig::memory_optimizer_scheduling_priorities.
   explicit MemoryOptimizer(
       RewriterConfig::MemOptType optimization_level,
-      const string& recomputation_targets_name_scope = "gradients/")
+      const string& recomputation_targets_name_scope = "gradients/",
+      int64_t peak_memory_budget_bytes = 0, bool scheduling_priorities = false)
       : optimization_level_(optimization_level),
-        recomputation_targets_name_scope_(recomputation_targets_name_scope) {}
+        recomputation_targets_name_scope_(recomputation_targets_name_scope),
+        peak_memory_budget_bytes_(peak_memory_budget_bytes),
+        scheduling_priorities_(scheduling_priorities) {}
   ~MemoryOptimizer() override {}
 
   string name() const override { return "memory_optimizer"; };
@@ -50,6 +61,8 @@ class MemoryOptimizer : public GraphOptimizer {
  private:
   RewriterConfig::MemOptType optimization_level_;
   string recomputation_targets_name_scope_;
+  int64_t peak_memory_budget_bytes_;
+  bool scheduling_priorities_;
 };
 
 }  // end namespace grappler
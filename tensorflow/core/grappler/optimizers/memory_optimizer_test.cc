@@ -20,6 +20,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -448,6 +449,101 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, CostBasedRecomputation) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Variable(s.WithOpName("x").WithDevice("/cpu:0"), {128, 128},
+                           DT_FLOAT);
+  // `a` is only used again at the very end of the backward pass, so it is
+  // live at the peak. `b` is not.
+  Output a = ops::Square(s.WithOpName("a").WithDevice("/cpu:0"), x);
+  Output b = ops::Sqrt(s.WithOpName("b").WithDevice("/cpu:0"), x);
+  Output c = ops::Exp(s.WithOpName("gradients/c").WithDevice("/cpu:0"), b);
+  Output d = ops::Mul(s.WithOpName("gradients/d").WithDevice("/cpu:0"), c, c);
+  Output e = ops::Add(s.WithOpName("gradients/e").WithDevice("/cpu:0"), d, c);
+  Output f =
+      ops::AddN(s.WithOpName("gradients/f").WithDevice("/cpu:0"), {e, a});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/f"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  // The peak usage fits in 80% of the device memory by default.
+  MemoryOptimizer default_budget_optimizer(
+      RewriterConfig::COST_BASED_RECOMPUTATION);
+  GraphDef output;
+  TF_EXPECT_OK(default_budget_optimizer.Optimize(cluster.get(), item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+
+  MemoryOptimizer optimizer(RewriterConfig::COST_BASED_RECOMPUTATION,
+                            "gradients/",
+                            /*peak_memory_budget_bytes=*/100 * 1024);
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* new_f = node_map.GetNode("gradients/f");
+  ASSERT_NE(new_f, nullptr);
+  ASSERT_EQ(2, new_f->input_size());
+  EXPECT_EQ("gradients/e", new_f->input(0));
+  EXPECT_EQ("Recomputed/a", new_f->input(1));
+  const NodeDef* recomputed_a = node_map.GetNode("Recomputed/a");
+  ASSERT_NE(recomputed_a, nullptr);
+  EXPECT_EQ("Square", recomputed_a->op());
+  ASSERT_EQ(2, recomputed_a->input_size());
+  EXPECT_EQ("x", recomputed_a->input(0));
+  EXPECT_EQ("^RecomputeTrigger/a", recomputed_a->input(1));
+  EXPECT_EQ(nullptr, node_map.GetNode("Recomputed/b"));
+}
+
+TEST_F(MemoryOptimizerTest, SchedulingPriorities) {
+  // Each branch computes a large tensor and reduces it to a scalar; reducing
+  // each branch right after it keeps a single large tensor alive at a time.
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output x = ops::Const(s.WithOpName("x"), 1.0f, {128, 128});
+  Output axes = ops::Const(s.WithOpName("axes"), {0, 1});
+  std::vector<Output> sums;
+  for (int i = 0; i < 4; ++i) {
+    Output square = ops::Square(s.WithOpName(absl::StrCat("square", i)), x);
+    sums.push_back(
+        ops::Sum(s.WithOpName(absl::StrCat("sum", i)), square, axes));
+  }
+  Output total = ops::AddN(s.WithOpName("total"), sums);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"total"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::MANUAL, "gradients/",
+                            /*peak_memory_budget_bytes=*/0,
+                            /*scheduling_priorities=*/true);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  std::unordered_map<string, int64_t> priorities;
+  for (const NodeDef& node : output.node()) {
+    ASSERT_EQ(node.attr().count("_scheduling_priority"), 1) << node.name();
+    priorities[node.name()] = node.attr().at("_scheduling_priority").i();
+  }
+  for (const NodeDef& node : output.node()) {
+    for (const string& input : node.input()) {
+      EXPECT_LT(priorities[NodeName(input)], priorities[node.name()]);
+    }
+  }
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(priorities[absl::StrCat("sum", i)],
+              priorities[absl::StrCat("square", i)] + 1);
+  }
+
+  // The executor follows the priorities without changing the result.
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
@@ -21,6 +21,7 @@ limitations under the License.
 #include <type_traits>
 #include <utility>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -61,7 +62,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/tpu.h"
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/util.h"
@@ -80,6 +84,7 @@ namespace {
 
 constexpr int kDefaultNumberOfIterations = 2;
 constexpr int kDefaultMinGraphNodes = 4;
+constexpr int kDefaultMaxFunctionThreads = 8;
 constexpr char kGrapplerCategory[] = "Grappler";
 
 int64_t NumEdges(const GraphDef& graph) {
@@ -103,6 +108,12 @@ int NumIterations(const RewriterConfig& cfg) {
              : cfg.meta_optimizer_iterations();
 }
 
+int NumFunctionThreads(const RewriterConfig& cfg) {
+  return cfg.meta_optimizer_function_threads() > 0
+             ? cfg.meta_optimizer_function_threads()
+             : std::min(port::MaxParallelism(), kDefaultMaxFunctionThreads);
+}
+
 // Check if optimizer is allowed to run only once.
 bool IsRunOnceOptimizer(const string& name) {
   return name == "layout" || name == "memory_optimizer" ||
@@ -218,7 +229,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
          new ConstantFolding(
              cpu_device_,
              cfg_.experimental_disable_compressed_tensor_optimization(),
-             !cfg_.experimental_disable_folding_quantization_emulation()));
+             !cfg_.experimental_disable_folding_quantization_emulation(),
+             cfg_.constant_folding_memmapped_constants_directory()));
   MK_OPT("shape", "shape_optimization", new ShapeOptimizer());
   MK_OPT("remap", "remapping",
          new Remapper(cfg_.remapping(), cfg_.cpu_layout_conversion(),
@@ -238,6 +250,9 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
     MK_OPT("auto_mixed_precision_onednn_bfloat16",
            "auto_mixed_precision_onednn_bfloat16",
            new AutoMixedPrecision(AutoMixedPrecisionMode::BF16));
+    MK_OPT("auto_mixed_precision_amx_bfloat16",
+           "auto_mixed_precision_amx_bfloat16",
+           new AutoMixedPrecision(AutoMixedPrecisionMode::AMX_BF16));
   }
 #endif
   MK_OPT("auto_mixed_precision_cpu", "auto_mixed_precision_cpu",
@@ -269,7 +284,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
 MetaOptimizer::MetaOptimizer(DeviceBase* cpu_device, const ConfigProto& cfg)
     : cpu_device_(cpu_device),
       config_proto_(cfg),
-      cfg_(*config_proto_.mutable_graph_options()->mutable_rewrite_options()) {
+      cfg_(*config_proto_.mutable_graph_options()->mutable_rewrite_options()),
+      optimized_graph_cache_(OptimizedGraphCache::Global()) {
   DCHECK(cpu_device_ == nullptr ||
          cpu_device_->attributes().device_type() == "CPU");
   auto global_jit_level =
@@ -363,7 +379,8 @@ Status MetaOptimizer::InitializeOptimizers(
       optimizers->push_back(std::make_unique<ConstantFolding>(
           cfg_.constant_folding(), cpu_device_,
           cfg_.experimental_disable_compressed_tensor_optimization(),
-          !cfg_.experimental_disable_folding_quantization_emulation()));
+          !cfg_.experimental_disable_folding_quantization_emulation(),
+          cfg_.constant_folding_memmapped_constants_directory()));
     }
   }
   if (BOTH_NOT_OFF(shape_optimization)) {
@@ -390,6 +407,13 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         std::make_unique<AutoMixedPrecision>(AutoMixedPrecisionMode::BF16));
   }
+  if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_amx_bfloat16()) &&
+      AutoMixedPrecisionEnabled(
+          plugin_configs.toggle_config["auto_mixed_precision_amx_bfloat16"]) &&
+      IsMKLEnabled()) {
+    optimizers->push_back(
+        std::make_unique<AutoMixedPrecision>(AutoMixedPrecisionMode::AMX_BF16));
+  }
   if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_mkl()) &&
       AutoMixedPrecisionEnabled(
           plugin_configs.toggle_config["auto_mixed_precision_mkl"]) &&
@@ -472,15 +496,15 @@ Status MetaOptimizer::InitializeOptimizers(
   if (MemoryOptimizerEnabled(cfg_.memory_optimization(),
                              xla_auto_clustering_on_) &&
       PLUGIN_NOT_OFF(memory_optimization)) {
-    if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
-      optimizers->push_back(
-          // Use the default target node name prefix "gradients/"
-          std::make_unique<MemoryOptimizer>(cfg_.memory_optimization()));
-    } else {
-      optimizers->push_back(std::make_unique<MemoryOptimizer>(
-          cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
-    }
+    // Use the default target node name prefix "gradients/" unless set.
+    const string target_node_name_scope =
+        cfg_.memory_optimizer_target_node_name_scope().empty()
+            ? "gradients/"
+            : cfg_.memory_optimizer_target_node_name_scope();
+    optimizers->push_back(std::make_unique<MemoryOptimizer>(
+        cfg_.memory_optimization(), target_node_name_scope,
+        cfg_.memory_optimizer_peak_memory_budget_bytes(),
+        cfg_.memory_optimizer_scheduling_priorities()));
   }
   if (cfg_.auto_parallel().enable() && PLUGIN_IS_ON(auto_parallel)) {
     optimizers->push_back(
@@ -650,6 +674,10 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
         AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_onednn_bfloat16())
             ? RewriterConfig::ON
             : RewriterConfig::OFF;
+    user_cfg.toggle_config["auto_mixed_precision_amx_bfloat16"] =
+        AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_amx_bfloat16())
+            ? RewriterConfig::ON
+            : RewriterConfig::OFF;
     user_cfg.toggle_config["auto_mixed_precision_mkl"] =
         AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_mkl())
             ? RewriterConfig::ON
@@ -686,6 +714,8 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
       PRINT_CFG("auto_mixed_precision", "auto_mixed_precision")
       PRINT_CFG("auto_mixed_precision_onednn_bfloat16",
                 "auto_mixed_precision_onednn_bfloat16")
+      PRINT_CFG("auto_mixed_precision_amx_bfloat16",
+                "auto_mixed_precision_amx_bfloat16")
       PRINT_CFG("auto_mixed_precision_mkl", "auto_mixed_precision_mkl")
       PRINT_CFG("auto_mixed_precision_cpu", "auto_mixed_precision_cpu")
       PRINT_CFG("pin_to_host", "pin_to_host_optimization")
@@ -727,6 +757,7 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
     if (pair.first == "debug_stripper" ||
         pair.first == "auto_mixed_precision" ||
         pair.first == "auto_mixed_precision_onednn_bfloat16" ||
+        pair.first == "auto_mixed_precision_amx_bfloat16" ||
         pair.first == "auto_mixed_precision_mkl" ||
         pair.first == "auto_mixed_precision_cpu" ||
         pair.first == "pin_to_host_optimization" ||
@@ -888,7 +919,10 @@ Status MetaOptimizer::OptimizeGraph(
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  {
+    mutex_lock lock(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -1079,6 +1113,19 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       "Deleted $0 unreachable functions from the graph (library size = $1)",
       old_library_size - new_library_size, new_library_size);
 
+  // Graphs that were optimized before with the same configuration and devices,
+  // possibly by another process sharing the cache, are not optimized again.
+  string cache_key;
+  if (optimized_graph_cache_ != nullptr) {
+    cache_key = OptimizedGraphCache::Key(
+        "graph", item, config_proto_.graph_options(), cluster);
+    if (optimized_graph_cache_->Lookup(cache_key, optimized_graph)) {
+      VLOG(1) << "Found optimized graph for grappler item " << item.id
+              << " in the cache";
+      return absl::OkStatus();
+    }
+  }
+
   // Save a few small fields from item before we move it.
   bool optimize_function_library =
       item.optimization_options().optimize_function_library;
@@ -1164,11 +1211,75 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   // True if this is a TPU graph using the old bridge.
   bool is_tpu_graph = IsLegacyTPUBridgeGraphDef(*optimized_graph);
 
+  // Function bodies are optimized independently of each other, so each pass
+  // over the library optimizes the bodies concurrently, and then updates the
+  // library with the results in library order.
+  struct FunctionToOptimize {
+    string name;
+    GrapplerFunctionItem item;
+    GraphDef optimized_graph;
+    Status status;
+  };
+  const auto optimize_function_body =
+      [&](FunctionToOptimize* function) -> Status {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    GrapplerFunctionItem& func_item = function->item;
+    GraphDef& optimized_func_graph = function->optimized_graph;
+    if (is_tpu_graph) {
+      // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+      // passes do not handle TPU functions correctly in a variety of ways
+      // (Note that due to the pre-placement TPU graph rewriting passes, the
+      // TPU-related ops are encapsulated away into functions). For example,
+      // TPU graphs contain TPUReplicateMetadata node that carries relevant
+      // TPU metadata and Grappler passes could prune that away. Grappler
+      // passes could also cause issues around shape inference. Since the
+      // desired and existing behavior is to not optimize TPU functions with
+      // Grappler, this check preserves that. The only exception is
+      // implementation selector what is required to swap in some TPU specific
+      // lowering code and is verified the work correctly on TPUs.
+      ImplementationSelector implementation_selector;
+
+      // Implementation selector needs to have access to valid function
+      // signature and attributes, and it doesn't need actual function body.
+      std::unique_ptr<FunctionDefLibrary> func_item_function_library(
+          func_item.graph.release_library());
+      *func_item.graph.mutable_library() =
+          GetFunctionDefLibraryStub(*func_item_function_library);
+
+      return implementation_selector.Optimize(cluster, func_item,
+                                              &optimized_func_graph);
+    }
+    // The function item holds the library reachable from the function, so
+    // the key also covers the functions it calls.
+    string func_cache_key;
+    if (optimized_graph_cache_ != nullptr) {
+      func_cache_key = OptimizedGraphCache::Key(
+          "function", func_item, config_proto_.graph_options(), cluster);
+      if (optimized_graph_cache_->Lookup(func_cache_key,
+                                         &optimized_func_graph)) {
+        return absl::OkStatus();
+      }
+    }
+    GrapplerFunctionItem func_item_copy = func_item;
+    TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
+                                     &optimized_func_graph));
+    if (!func_cache_key.empty()) {
+      Status status =
+          optimized_graph_cache_->Insert(func_cache_key, optimized_func_graph);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to cache optimized function " << function->name
+                     << ": " << status;
+      }
+    }
+    return absl::OkStatus();
+  };
+
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
   while (optimize_function_library) {
     optimize_function_library = false;
 
+    std::vector<FunctionToOptimize> functions;
     int function_idx = 0;
     for (const FunctionDef& func : optimized_graph->library().function()) {
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
@@ -1202,7 +1313,9 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       optimized_funcs.insert(func_name);
 
       // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
+      FunctionToOptimize& function = functions.emplace_back();
+      function.name = func_name;
+      GrapplerFunctionItem& func_item = function.item;
       TF_RETURN_IF_ERROR(
           MakeGrapplerFunctionItem(func, flib, producer, &func_item));
 
@@ -1225,42 +1338,53 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       // function_optimizer.cc).
       func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
           false;
+    }
 
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (is_tpu_graph) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        std::unique_ptr<FunctionDefLibrary> func_item_function_library(
-            func_item.graph.release_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(*func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
+    // Optimize function bodies.
+    const int num_threads =
+        std::min<int>(NumFunctionThreads(cfg_), functions.size());
+    if (num_threads <= 1) {
+      for (FunctionToOptimize& function : functions) {
+        TF_RETURN_IF_ERROR(optimize_function_body(&function));
+      }
+    } else {
+      const size_t num_results = optimization_results_.size();
+      {
+        thread::ThreadPool pool(Env::Default(), "grappler_functions",
+                                num_threads);
+        BlockingCounter counter(functions.size());
+        for (FunctionToOptimize& function : functions) {
+          pool.Schedule([&, to_optimize = &function]() {
+            to_optimize->status = optimize_function_body(to_optimize);
+            counter.DecrementCount();
+          });
+        }
+        counter.Wait();
+      }
+      for (const FunctionToOptimize& function : functions) {
+        TF_RETURN_IF_ERROR(function.status);
       }
+      // Record the results in library order, as if the functions had been
+      // optimized one at a time.
+      absl::flat_hash_map<string, int> positions;
+      for (int i = 0; i < functions.size(); ++i) {
+        positions[functions[i].name] = i;
+      }
+      std::stable_sort(
+          optimization_results_.begin() + num_results,
+          optimization_results_.end(),
+          [&](const GraphOptimizationResult& a,
+              const GraphOptimizationResult& b) {
+            return gtl::FindWithDefault(positions, a.id, 0) <
+                   gtl::FindWithDefault(positions, b.id, 0);
+          });
+    }
 
+    for (FunctionToOptimize& function : functions) {
       // Function body optimization might have created new specialized
       // functions for each instantiation context. Add them to the library.
       for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
+           function.optimized_graph.library().function()) {
         if (flib.Find(func_def.signature().name()) == nullptr) {
           TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
         }
@@ -1268,11 +1392,11 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
       // Convert optimized graph back to FunctionDef.
       FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+      function.item.SwapFunctionBody(std::move(function.optimized_graph));
+      TF_RETURN_IF_ERROR(MakeFunctionDef(function.item, flib, &optimized_func));
 
       // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+      TF_RETURN_IF_ERROR(flib.ReplaceFunction(function.name, optimized_func));
     }
 
     // If optimized at least one function, update the graph library.
@@ -1306,6 +1430,14 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   }
 #endif
 
+  if (!cache_key.empty()) {
+    Status status = optimized_graph_cache_->Insert(cache_key, *optimized_graph);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to cache optimized graph for grappler item "
+                   << item.id << ": " << status;
+    }
+  }
+
   VLOG(1) << "Optimized " << optimized_funcs.size()
           << " functions: " << absl::StrJoin(optimized_funcs, ", ");
   VLOG(3) << "Optimized graph =\n" << optimized_graph->DebugString();
@@ -1360,6 +1492,8 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
          AutoMixedPrecisionEnabled(
              rewrite_cfg.auto_mixed_precision_onednn_bfloat16()) ||
+         AutoMixedPrecisionEnabled(
+             rewrite_cfg.auto_mixed_precision_amx_bfloat16()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_mkl()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_cpu()) ||
          !rewrite_cfg.optimizers().empty() ||
@@ -22,8 +22,10 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
 #include "tensorflow/core/grappler/verifiers/graph_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/protobuf/verifier_config.pb.h"
@@ -54,6 +56,13 @@ class MetaOptimizer : public GraphOptimizer {
 
   void PrintResult();
 
+  // Sets the cache that optimized graphs and function bodies are looked up in
+  // and stored to. Defaults to `OptimizedGraphCache::Global()`; null disables
+  // caching.
+  void set_optimized_graph_cache(const OptimizedGraphCache* cache) {
+    optimized_graph_cache_ = cache;
+  }
+
  private:
   std::unique_ptr<GraphOptimizer> MakeNewOptimizer(
       const string& optimizer, const std::set<string>& device_types) const;
@@ -101,6 +110,7 @@ class MetaOptimizer : public GraphOptimizer {
   ConfigProto config_proto_;
   RewriterConfig& cfg_;
   bool xla_auto_clustering_on_;
+  const OptimizedGraphCache* optimized_graph_cache_;
 
   struct OptimizerResult {
     string optimizer_name;
@@ -118,6 +128,9 @@ class MetaOptimizer : public GraphOptimizer {
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
                       GraphOptimizationResult* optimization_result);
 
+  // Guards optimization_results_ while library functions are optimized
+  // concurrently.
+  mutex optimization_results_mu_;
   std::vector<GraphOptimizationResult> optimization_results_;
 };
 
@@ -32,8 +32,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
@@ -113,6 +116,8 @@ class GrapplerItemPropertiesAccumulator : public CustomGraphOptimizer {
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* optimized_graph) override {
     *optimized_graph = item.graph;
+    // Library functions are optimized concurrently.
+    mutex_lock lock(mu_);
     if (optimization_options_) {
       optimization_options_->insert({item.id, item.optimization_options()});
     }
@@ -120,10 +125,13 @@ class GrapplerItemPropertiesAccumulator : public CustomGraphOptimizer {
   }
 
  private:
+  static mutex mu_;
   static gtl::FlatMap<string, GrapplerItem::OptimizationOptions>*
       optimization_options_;
 };
 
+mutex GrapplerItemPropertiesAccumulator::mu_(LINKER_INITIALIZED);
+
 gtl::FlatMap<string, GrapplerItem::OptimizationOptions>*
     GrapplerItemPropertiesAccumulator::optimization_options_;
 
@@ -218,6 +226,49 @@ TEST_F(MetaOptimizerTest, RunsPluginOptimizer) {
   EXPECT_TRUE(TestOptimizer::IsOptimized());
 }
 
+TEST_F(MetaOptimizerTest, ReusesCachedOptimizedGraph) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "meta_optimizer_graph_cache");
+  int64_t undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  const OptimizedGraphCache cache(Env::Default(), cache_dir);
+
+  TestOptimizer::SetOptimized(false);
+  MetaOptimizer optimizer(nullptr, config_proto);
+  optimizer.set_optimized_graph_cache(&cache);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+
+  // A second optimizer, as in another process, finds the graph in the cache.
+  TestOptimizer::SetOptimized(false);
+  MetaOptimizer cached_optimizer(nullptr, config_proto);
+  cached_optimizer.set_optimized_graph_cache(&cache);
+  GraphDef cached_output;
+  TF_EXPECT_OK(cached_optimizer.Optimize(nullptr, item, &cached_output));
+  EXPECT_FALSE(TestOptimizer::IsOptimized());
+  CompareGraphs(output, cached_output);
+
+  // A different configuration is optimized again.
+  rewriter_config.set_constant_folding(RewriterConfig::OFF);
+  MetaOptimizer reconfigured_optimizer(nullptr, config_proto);
+  reconfigured_optimizer.set_optimized_graph_cache(&cache);
+  TF_EXPECT_OK(reconfigured_optimizer.Optimize(nullptr, item, &cached_output));
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+}
+
 TEST_F(MetaOptimizerTest, RunOptimizersTwice) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
   GrapplerItem item;
@@ -420,6 +471,82 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibrary) {
   test::ExpectTensorEqual<int>(tensors_expected[1], tensors[1]);
 }
 
+// Returns a graph that calls `num_functions` independent, non-inlinable
+// functions.
+GrapplerItem MakeItemWithIndependentFunctions(int num_functions) {
+  using test::function::NDef;
+
+  std::vector<NodeDef> nodes = {
+      NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  std::vector<FunctionDef> functions;
+  GrapplerItem item;
+  item.id = "tf_graph";
+  for (int i = 0; i < num_functions; ++i) {
+    const string func_name = absl::StrCat("MyFunc", i);
+    FunctionDef func = FunctionDefHelper::Create(
+        func_name, {"x:T"}, {"z:T"}, {"T: {float, double}"},
+        {{{"add"}, "Add", {"x", "x"}, {{"T", "$T"}}},
+         {{"mul"}, "Mul", {"add:z:0", "add:z:0"}, {{"T", "$T"}}},
+         {{"neg"}, "Neg", {"mul:z:0"}, {{"T", "$T"}}},
+         {{"neg_neg"}, "Neg", {"neg:y:0"}, {{"T", "$T"}}}},
+        /*ret_def=*/
+        {{"z", "neg_neg:y:0"}});
+    (*func.mutable_attr())["_noinline"].set_b(true);
+    functions.push_back(std::move(func));
+
+    const string call = absl::StrCat("call", i);
+    nodes.push_back(NDef(call, func_name, {"x"}, {{"T", DT_FLOAT}}, kDevice));
+    nodes.push_back(NDef(absl::StrCat("out", i), "Identity", {call},
+                         {{"T", DT_FLOAT}}, kDevice));
+    item.fetch.push_back(absl::StrCat("out", i));
+  }
+  item.graph = test::function::GDef(nodes, functions);
+  return item;
+}
+
+GraphDef OptimizeWithFunctionThreads(const GrapplerItem& item,
+                                     int num_threads) {
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_min_graph_nodes(-1);
+  rewriter_config.set_meta_optimizer_function_threads(num_threads);
+
+  MetaOptimizer optimizer(nullptr, config_proto);
+  optimizer.set_optimized_graph_cache(nullptr);
+  GraphDef output;
+  TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  return output;
+}
+
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryConcurrently) {
+  const GrapplerItem item = MakeItemWithIndependentFunctions(32);
+  const GraphDef sequential = OptimizeWithFunctionThreads(item, 1);
+  const GraphDef concurrent = OptimizeWithFunctionThreads(item, 8);
+
+  CompareGraphs(sequential, concurrent);
+  ASSERT_EQ(sequential.library().function_size(),
+            concurrent.library().function_size());
+  for (int i = 0; i < sequential.library().function_size(); ++i) {
+    const FunctionDef& expected = sequential.library().function(i);
+    const FunctionDef& actual = concurrent.library().function(i);
+    EXPECT_EQ(expected.signature().name(), actual.signature().name());
+    EXPECT_TRUE(FunctionDefsEqual(expected, actual))
+        << expected.signature().name();
+  }
+
+  GrapplerItem optimized = item.WithGraph(GraphDef(concurrent));
+  optimized.feed.emplace_back("x", test::AsScalar<float>(3.0f));
+  GrapplerItem original = item;
+  original.feed.emplace_back("x", test::AsScalar<float>(3.0f));
+  auto tensors_expected = EvaluateFetchNodes(original);
+  auto tensors = EvaluateFetchNodes(optimized);
+  ASSERT_EQ(tensors.size(), tensors_expected.size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    test::ExpectTensorEqual<float>(tensors_expected[i], tensors[i]);
+  }
+}
+
 TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryPruneUnusedOutputs) {
   using test::function::NDef;
 
@@ -1412,6 +1539,21 @@ INSTANTIATE_TEST_SUITE_P(
       return test_name;
     });
 
+static void BM_OptimizeFunctionLibrary(::testing::benchmark::State& state) {
+  const int num_functions = state.range(0);
+  const int num_threads = state.range(1);
+  const GrapplerItem item = MakeItemWithIndependentFunctions(num_functions);
+  for (auto s : state) {
+    OptimizeWithFunctionThreads(item, num_threads);
+  }
+}
+BENCHMARK(BM_OptimizeFunctionLibrary)
+    ->ArgPair(256, 1)
+    ->ArgPair(256, 4)
+    ->ArgPair(256, 8)
+    ->ArgPair(2048, 1)
+    ->ArgPair(2048, 8);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
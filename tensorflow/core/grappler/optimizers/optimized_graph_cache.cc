@@ -0,0 +1,160 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Bump when the meaning of cached entries changes without the TensorFlow
+// version changing, to invalidate existing entries.
+constexpr int kCacheFormatVersion = 1;
+
+void AppendProto(const protobuf::MessageLite& proto, std::string* out) {
+  std::string serialized;
+  SerializeToStringDeterministic(proto, &serialized);
+  absl::StrAppend(out, serialized.size(), ":", serialized);
+}
+
+template <typename Strings>
+void AppendSorted(const Strings& strings, std::string* out) {
+  std::vector<std::string> sorted(strings.begin(), strings.end());
+  std::sort(sorted.begin(), sorted.end());
+  absl::StrAppend(out, sorted.size(), ":");
+  for (const std::string& s : sorted) absl::StrAppend(out, s.size(), ":", s);
+}
+
+}  // namespace
+
+OptimizedGraphCache::OptimizedGraphCache(Env* env, std::string directory)
+    : env_(env), directory_(std::move(directory)) {}
+
+const OptimizedGraphCache* OptimizedGraphCache::Global() {
+  static const OptimizedGraphCache* cache = []() -> OptimizedGraphCache* {
+    std::string directory;
+    TF_CHECK_OK(ReadStringFromEnvVar("TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_DIR",
+                                     "", &directory));
+    if (directory.empty()) return nullptr;
+    LOG(INFO) << "Caching optimized graphs in " << directory;
+    return new OptimizedGraphCache(Env::Default(), directory);
+  }();
+  return cache;
+}
+
+std::string OptimizedGraphCache::Key(absl::string_view scope,
+                                     const GrapplerItem& item,
+                                     const GraphOptions& graph_options,
+                                     const Cluster* cluster) {
+  // Everything that the optimized graph depends on: the code that optimizes
+  // it, the configuration, the devices and the item itself.
+  std::string data =
+      absl::StrCat(kCacheFormatVersion, ";", TF_VERSION_STRING, ";",
+                   TF_GRAPH_DEF_VERSION, ";", scope, ";");
+  AppendProto(graph_options, &data);
+
+  if (cluster != nullptr) {
+    const std::map<std::string, DeviceProperties> devices(
+        cluster->GetDevices().begin(), cluster->GetDevices().end());
+    absl::StrAppend(&data, devices.size(), ":");
+    for (const auto& [name, properties] : devices) {
+      absl::StrAppend(&data, name.size(), ":", name);
+      AppendProto(properties, &data);
+    }
+  }
+  AppendSorted(item.devices(), &data);
+
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  absl::StrAppend(&data, options.allow_non_differentiable_rewrites, ",",
+                  options.allow_pruning_stateful_and_dataset_ops, ",",
+                  options.optimize_function_library, ",",
+                  options.is_eager_mode, ",",
+                  options.intra_op_parallelism_threads, ";");
+
+  // Feeds are identified by their name, type and shape; optimizers do not
+  // depend on the fed values.
+  absl::StrAppend(&data, item.feed.size(), ":");
+  for (const auto& [name, tensor] : item.feed) {
+    absl::StrAppend(&data, name.size(), ":", name, ",",
+                    DataTypeString(tensor.dtype()), ",",
+                    tensor.shape().DebugString(), ";");
+  }
+  AppendSorted(item.fetch, &data);
+  AppendSorted(item.keep_ops, &data);
+  AppendSorted(item.init_ops, &data);
+  absl::StrAppend(&data, item.save_op, ";", item.restore_op, ";",
+                  item.save_restore_loc_tensor, ";");
+  AppendProto(item.graph, &data);
+
+  const Fprint128 fingerprint = Fingerprint128(data);
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+std::string OptimizedGraphCache::FileName(const std::string& key) const {
+  return io::JoinPath(directory_, absl::StrCat(key, ".pb"));
+}
+
+bool OptimizedGraphCache::Lookup(const std::string& key,
+                                 GraphDef* graph) const {
+  const std::string file_name = FileName(key);
+  if (!env_->FileExists(file_name).ok()) return false;
+  Status status = ReadBinaryProto(env_, file_name, graph);
+  if (!status.ok()) {
+    LOG(WARNING) << "Ignoring unreadable optimized graph cache entry "
+                 << file_name << ": " << status;
+    graph->Clear();
+    return false;
+  }
+  return true;
+}
+
+Status OptimizedGraphCache::Insert(const std::string& key,
+                                   const GraphDef& graph) const {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(directory_));
+  // Write to a file of a unique name first, so that concurrent readers never
+  // see a partially written entry.
+  std::string temp_file_name = FileName(key);
+  if (!env_->CreateUniqueFileName(&temp_file_name, ".tmp")) {
+    return errors::Internal("Could not create a unique file name for ",
+                            FileName(key));
+  }
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env_, temp_file_name, graph));
+  Status status = env_->RenameFile(temp_file_name, FileName(key));
+  if (!status.ok()) {
+    env_->DeleteFile(temp_file_name).IgnoreError();
+  }
+  return status;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
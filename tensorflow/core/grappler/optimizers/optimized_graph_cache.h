@@ -0,0 +1,75 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Stores graphs optimized by the MetaOptimizer as files in a directory, keyed
+// by everything the optimization result depends on, so that processes loading
+// the same model reuse the result of the first one to optimize it. The
+// directory may be on a filesystem shared by many processes: entries are
+// written to a temporary file and renamed into place, and an unreadable entry
+// is treated as a miss.
+//
+// Thread-safe.
+class OptimizedGraphCache {
+ public:
+  OptimizedGraphCache(Env* env, std::string directory);
+
+  // Returns the cache in the directory named by the
+  // TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_DIR environment variable, or nullptr if
+  // it is unset.
+  static const OptimizedGraphCache* Global();
+
+  // Returns the key of the result of optimizing `item` with `graph_options`
+  // on the devices of `cluster`, which may be null. `scope` tells apart
+  // results that are not interchangeable for the same item, such as a whole
+  // graph and a single function body.
+  static std::string Key(absl::string_view scope, const GrapplerItem& item,
+                         const GraphOptions& graph_options,
+                         const Cluster* cluster);
+
+  // Returns true and sets `graph` if there is an entry for `key`.
+  bool Lookup(const std::string& key, GraphDef* graph) const;
+
+  // Stores `graph` under `key`, replacing any existing entry.
+  Status Insert(const std::string& key, const GraphDef& graph) const;
+
+  const std::string& directory() const { return directory_; }
+
+ private:
+  std::string FileName(const std::string& key) const;
+
+  Env* const env_;
+  const std::string directory_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
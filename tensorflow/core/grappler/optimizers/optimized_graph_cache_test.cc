@@ -0,0 +1,116 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <cstdint>
+#include <string>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class OptimizedGraphCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = io::JoinPath(testing::TmpDir(), "optimized_graph_cache");
+    int64_t undeleted_files, undeleted_dirs;
+    Env::Default()
+        ->DeleteRecursively(directory_, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+  }
+
+  static GrapplerItem MakeItem(const std::string& node_name) {
+    GrapplerItem item;
+    NodeDef* node = item.graph.add_node();
+    node->set_name(node_name);
+    node->set_op("NoOp");
+    item.fetch.push_back(node_name);
+    return item;
+  }
+
+  std::string directory_;
+};
+
+TEST_F(OptimizedGraphCacheTest, KeyDependsOnItemAndOptions) {
+  const GrapplerItem item = MakeItem("a");
+  GraphOptions options;
+  const std::string key = OptimizedGraphCache::Key("graph", item, options,
+                                                   /*cluster=*/nullptr);
+  EXPECT_EQ(key, OptimizedGraphCache::Key("graph", MakeItem("a"), options,
+                                          /*cluster=*/nullptr));
+
+  EXPECT_NE(key, OptimizedGraphCache::Key("function", item, options,
+                                          /*cluster=*/nullptr));
+  EXPECT_NE(key, OptimizedGraphCache::Key("graph", MakeItem("b"), options,
+                                          /*cluster=*/nullptr));
+
+  GrapplerItem restricted_item = item;
+  restricted_item.optimization_options().allow_non_differentiable_rewrites =
+      false;
+  EXPECT_NE(key, OptimizedGraphCache::Key("graph", restricted_item, options,
+                                          /*cluster=*/nullptr));
+
+  GraphOptions other_options;
+  other_options.mutable_rewrite_options()->set_constant_folding(
+      RewriterConfig::OFF);
+  EXPECT_NE(key, OptimizedGraphCache::Key("graph", item, other_options,
+                                          /*cluster=*/nullptr));
+}
+
+TEST_F(OptimizedGraphCacheTest, InsertAndLookup) {
+  const OptimizedGraphCache cache(Env::Default(), directory_);
+  const GrapplerItem item = MakeItem("a");
+  const std::string key = OptimizedGraphCache::Key("graph", item,
+                                                   GraphOptions(), nullptr);
+
+  GraphDef graph;
+  EXPECT_FALSE(cache.Lookup(key, &graph));
+
+  TF_ASSERT_OK(cache.Insert(key, item.graph));
+  ASSERT_TRUE(cache.Lookup(key, &graph));
+  ASSERT_EQ(graph.node_size(), 1);
+  EXPECT_EQ(graph.node(0).name(), "a");
+
+  // Another cache on the same directory, as in another process, sees the
+  // entry too.
+  const OptimizedGraphCache other_cache(Env::Default(), directory_);
+  GraphDef other_graph;
+  EXPECT_TRUE(other_cache.Lookup(key, &other_graph));
+}
+
+TEST_F(OptimizedGraphCacheTest, IgnoresUnreadableEntries) {
+  const OptimizedGraphCache cache(Env::Default(), directory_);
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(directory_));
+  TF_ASSERT_OK(WriteStringToFile(
+      Env::Default(), io::JoinPath(directory_, "0123.pb"), "not a GraphDef"));
+
+  GraphDef graph;
+  EXPECT_FALSE(cache.Lookup("0123", &graph));
+  EXPECT_EQ(graph.node_size(), 0);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
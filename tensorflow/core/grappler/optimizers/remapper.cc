@@ -92,6 +92,8 @@ constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormGradEx";
 constexpr char kTensorToHashBucket[] = "_TensorToHashBucketFast";
+constexpr char kFusedScaledDotProductAttention[] =
+    "_FusedScaledDotProductAttention";
 constexpr char kLeakyRelu[] = "LeakyRelu";
 constexpr char kMklFusedMish[] = "_MklFusedMish";
 constexpr char kRelu[] = "Relu";
@@ -762,6 +764,49 @@ void AddInputShapesAttr(const RemapperContext& ctx, int node_index) {
   }
 }
 
+// Returns whether MatMuls reading resource variables should reuse the packed
+// variable as if it were a constant. This is only correct for graphs that
+// never assign to those variables, such as serving graphs.
+bool PackReadOnlyVariableRhsEnabled() {
+  static bool is_enabled = [] {
+    bool is_enabled = false;
+    TF_CHECK_OK(tensorflow::ReadBoolFromEnvVar(
+        "TF_MATMUL_PACK_READ_ONLY_VARIABLE_RHS", /*default_val=*/false,
+        &is_enabled));
+    return is_enabled;
+  }();
+  return is_enabled;
+}
+
+// Marks a CPU MatMul or BatchMatMul whose right-hand side is a constant with
+// "_rhs_is_constant", which lets the kernel reuse the right-hand side packed by
+// an earlier step. Resource variable reads are only marked when
+// PackReadOnlyVariableRhsEnabled(), since the kernel would miss an in-place
+// update of the variable.
+void AddRhsIsConstantAttr(const RemapperContext& ctx, int node_index) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsMatMul(*node_def) && node_def->op() != "BatchMatMul" &&
+      node_def->op() != "BatchMatMulV2" && node_def->op() != "BatchMatMulV3") {
+    return;
+  }
+  if (IsMKLEnabled() || !NodeIsOnCpu(node_def) ||
+      node_view->NumRegularFanins() < 2) {
+    return;
+  }
+  const DataType dtype = GetDataTypeFromAttr(
+      *node_def, node_def->op() == "BatchMatMulV3" ? "Ta" : "T");
+  if (dtype != DT_FLOAT && dtype != DT_BFLOAT16 && dtype != DT_HALF) return;
+  const NodeDef* rhs = node_view->GetRegularFanin(1).node_view()->node();
+  if (!IsConstant(*rhs) && !IsHostConstant(*rhs) &&
+      rhs->op() != "ImmutableConst" &&
+      !(IsReadVariableOp(*rhs) && PackReadOnlyVariableRhsEnabled())) {
+    return;
+  }
+  auto* mutable_node = ctx.graph_view.graph()->mutable_node(node_index);
+  (*mutable_node->mutable_attr())["_rhs_is_constant"].set_b(true);
+}
+
 bool FindContractionWithBias(const RemapperContext& ctx, int node_index,
                              ContractionWithBiasAdd* matched,
                              bool check_device_compatible = true) {
@@ -2646,6 +2691,187 @@ bool FindFusedBatchNormGradEx(const RemapperContext& ctx, int node_index,
   return false;
 }
 
+// Returns true if shape inference proved the dimensions to be equal. Unknown
+// dimensions are only equal if they share a symbolic size.
+bool DimsKnownEqual(const TensorShapeProto::Dim& a,
+                    const TensorShapeProto::Dim& b) {
+  return a.size() == b.size() && a.size() != -1;
+}
+
+// clang-format off
+// Scaled dot-product attention pattern, as built by matmul-based attention
+// layers:
+//
+//   query    key
+//       \    /
+//    BatchMatMul (adj_y)    scale
+//               \          /
+//                    Mul        mask
+//                      \       /
+//                     Add or AddV2   (optional)
+//                          |
+//                       Softmax    value
+//                             \   /
+//                          BatchMatMul
+// clang-format on
+bool FindScaledDotProductAttention(RemapperContext* ctx, int node_index,
+                                   std::map<string, int>* matched_nodes_map,
+                                   std::set<int>* remove_node_indices,
+                                   std::vector<string>* input_node_names) {
+  const auto* node_def = ctx->graph_view.GetNode(node_index)->node();
+  if (!IsAnyBatchMatMul(*node_def) || !NodeIsOnCpu(node_def) ||
+      !HasDataType(node_def, DT_FLOAT) || ctx->xla_cpu_jit_disable_fusion) {
+    return false;
+  }
+
+  using utils::MatchingDirection;
+  using utils::NodeStatus;
+  // clang-format off
+  utils::OpTypePattern scaled_scores =
+    {"Mul", "mul", NodeStatus::kRemove,
+      {
+        {"BatchMatMul|BatchMatMulV2", "scores", NodeStatus::kRemove},
+        {"*", "scale", NodeStatus::kRemain}
+      }
+    };
+  utils::OpTypePattern masked_pattern =
+    {"BatchMatMul|BatchMatMulV2", "output", NodeStatus::kReplace,
+      {
+        {"Softmax", "softmax", NodeStatus::kRemove,
+          {
+            {"Add|AddV2", "add", NodeStatus::kRemove,
+              {
+                scaled_scores,
+                {"*", "mask", NodeStatus::kRemain}
+              }
+            }
+          }
+        },
+        {"*", "value", NodeStatus::kRemain}
+      }
+    };
+  utils::OpTypePattern unmasked_pattern =
+    {"BatchMatMul|BatchMatMulV2", "output", NodeStatus::kReplace,
+      {
+        {"Softmax", "softmax", NodeStatus::kRemove, {scaled_scores}},
+        {"*", "value", NodeStatus::kRemain}
+      }
+    };
+  // clang-format on
+
+  utils::SubGraphMatcher<MatchingDirection::kFollowInputs> graph_matcher(
+      &(ctx->graph_view));
+  matched_nodes_map->clear();
+  remove_node_indices->clear();
+  bool has_mask = graph_matcher.GetMatchedNodes(
+      masked_pattern, ctx->nodes_to_preserve,
+      ctx->graph_view.GetNode(node_index), matched_nodes_map,
+      remove_node_indices);
+  if (!has_mask) {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    if (!graph_matcher.GetMatchedNodes(unmasked_pattern, ctx->nodes_to_preserve,
+                                       ctx->graph_view.GetNode(node_index),
+                                       matched_nodes_map,
+                                       remove_node_indices)) {
+      return false;
+    }
+  }
+
+  // The kernel takes the keys untransposed, i.e. as the second operand of
+  // the scores product with adj_y, and the probabilities and values as is.
+  const auto* scores_node_def =
+      ctx->graph_view.GetNode(matched_nodes_map->at("scores"))->node();
+  bool adj_x = false;
+  bool adj_y = false;
+  if (!TryGetNodeAttr(*scores_node_def, "adj_x", &adj_x) || adj_x ||
+      !TryGetNodeAttr(*scores_node_def, "adj_y", &adj_y) || !adj_y) {
+    return false;
+  }
+  if (!TryGetNodeAttr(*node_def, "adj_x", &adj_x) || adj_x ||
+      !TryGetNodeAttr(*node_def, "adj_y", &adj_y) || adj_y) {
+    return false;
+  }
+
+  // Returns the input port of `node` fed by the node matched as `operand`.
+  const auto operand_port = [&](const string& node, const string& operand) {
+    const auto* node_view =
+        ctx->graph_view.GetNode(matched_nodes_map->at(node));
+    return node_view->GetRegularFanin(0).node_index() ==
+                   matched_nodes_map->at(operand)
+               ? 0
+               : 1;
+  };
+  const int scale_port = operand_port("mul", "scale");
+  const int mask_port = has_mask ? operand_port("add", "mask") : 0;
+
+  // BatchMatMul broadcasts its batch dimensions, and the kernel does not, so
+  // query, key and value must be known to share them.
+  if (!ctx->inferred_graph_properties) {
+    Status s = ctx->graph_properties.InferStatically(
+        /*assume_valid_feeds=*/false,
+        /*aggressive_shape_inference=*/false,
+        /*include_input_tensor_values=*/true,
+        /*include_output_tensor_values=*/false);
+    if (!s.ok()) return false;
+    ctx->inferred_graph_properties = true;
+  }
+  const auto* mul_node_def =
+      ctx->graph_view.GetNode(matched_nodes_map->at("mul"))->node();
+  const auto& scores_inputs =
+      ctx->graph_properties.GetInputProperties(scores_node_def->name());
+  const auto& output_inputs =
+      ctx->graph_properties.GetInputProperties(node_def->name());
+  const auto& mul_inputs =
+      ctx->graph_properties.GetInputProperties(mul_node_def->name());
+  const auto& scores_outputs =
+      ctx->graph_properties.GetOutputProperties(scores_node_def->name());
+  if (scores_inputs.size() != 2 || output_inputs.size() != 2 ||
+      mul_inputs.size() != 2 || scores_outputs.empty()) {
+    return false;
+  }
+  if (NumCoefficients(mul_inputs[scale_port].shape()) != 1) return false;
+
+  const TensorShapeProto& query_shape = scores_inputs[0].shape();
+  const TensorShapeProto& key_shape = scores_inputs[1].shape();
+  const TensorShapeProto& value_shape = output_inputs[1].shape();
+  const TensorShapeProto& scores_shape = scores_outputs[0].shape();
+  const int rank = Rank(query_shape);
+  if (rank < 3 || Rank(key_shape) != rank || Rank(value_shape) != rank ||
+      Rank(scores_shape) != rank) {
+    return false;
+  }
+  for (int i = 0; i < rank - 2; ++i) {
+    if (!DimsKnownEqual(query_shape.dim(i), key_shape.dim(i)) ||
+        !DimsKnownEqual(query_shape.dim(i), value_shape.dim(i))) {
+      return false;
+    }
+  }
+
+  input_node_names->clear();
+  input_node_names->push_back(scores_node_def->input(0));
+  input_node_names->push_back(scores_node_def->input(1));
+  input_node_names->push_back(node_def->input(1));
+  input_node_names->push_back(mul_node_def->input(scale_port));
+  if (has_mask) {
+    const auto* add_node_def =
+        ctx->graph_view.GetNode(matched_nodes_map->at("add"))->node();
+    const auto& add_inputs =
+        ctx->graph_properties.GetInputProperties(add_node_def->name());
+    if (add_inputs.size() != 2) return false;
+    const TensorShapeProto& mask_shape = add_inputs[mask_port].shape();
+    if (Rank(mask_shape) != rank) return false;
+    for (int i = 0; i < rank; ++i) {
+      if (mask_shape.dim(i).size() != 1 &&
+          !DimsKnownEqual(mask_shape.dim(i), scores_shape.dim(i))) {
+        return false;
+      }
+    }
+    input_node_names->push_back(add_node_def->input(mask_port));
+  }
+  return true;
+}
+
 bool FindTensorToHashBucket(const RemapperContext& ctx, int node_index,
                             TensorToHashBucket* matched) {
   // Root of the pattern must be a StringToHashBucketFast.
@@ -4336,6 +4562,39 @@ Status AddTensorToHashBucketNode(RemapperContext* ctx,
   return absl::OkStatus();
 }
 
+Status AddFusedScaledDotProductAttention(
+    RemapperContext* ctx, const std::map<string, int>& matched_nodes_map,
+    const std::set<int>& remove_node_indices,
+    const std::vector<string>& input_node_names,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  auto* output_node =
+      ctx->graph_view.GetNode(matched_nodes_map.at("output"))->node();
+  VLOG(2) << "Fuse scaled dot-product attention into " << output_node->name()
+          << " on device=" << output_node->device();
+
+  NodeDef fused_node;
+  fused_node.set_name(output_node->name());
+  fused_node.set_op(kFusedScaledDotProductAttention);
+  fused_node.set_device(output_node->device());
+  for (const auto& name : input_node_names) fused_node.add_input(name);
+  auto* attr = fused_node.mutable_attr();
+  (*attr)["T"] = output_node->attr().at("T");
+  SetAttrValue(static_cast<int>(input_node_names.size()) - 4,
+               &(*attr)["num_masks"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched_nodes_map.at("output")] = true;
+
+  for (const auto& node_idx : remove_node_indices) {
+    (*nodes_to_delete)[node_idx] = true;
+  }
+  return absl::OkStatus();
+}
+
 Status AddFusedBatchMatMul(RemapperContext* ctx,
                            const std::map<string, int>& matched_nodes_map,
                            const std::set<int>& remove_node_indices,
@@ -4878,6 +5137,24 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       ctx.inferred_graph_properties = true;
     }
 
+    // Remap BatchMatMul+Mul+[Add]+Softmax+BatchMatMul into the
+    // _FusedScaledDotProductAttention. Its root is visited first, so the
+    // smaller fusions below do not break up the attention subgraph.
+    {
+      std::map<string, int> matched_nodes_map;
+      std::set<int> remove_node_indices;
+      std::vector<string> input_node_names;
+      if (allow_non_differentiable_rewrites &&
+          FindScaledDotProductAttention(&ctx, i, &matched_nodes_map,
+                                        &remove_node_indices,
+                                        &input_node_names)) {
+        TF_RETURN_IF_ERROR(AddFusedScaledDotProductAttention(
+            &ctx, matched_nodes_map, remove_node_indices, input_node_names,
+            &invalidated_nodes, &nodes_to_delete));
+        continue;
+      }
+    }
+
     ContractionWithBiasAddAndAdd contract_with_bias_and_add;
     ContractionWithActivation contract_with_activation;
     ContractionWithBiasAndAddActivation contract_with_bias_and_add_activation;
@@ -4893,6 +5170,7 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
         IsMatMul(ctx.graph_view.graph()->node(i))) {
       AddInputShapesAttr(ctx, i);
     }
+    AddRhsIsConstantAttr(ctx, i);
 
     if (IsMKLEnabled() && !ctx.xla_cpu_jit_disable_fusion) {
       const auto* node_view = ctx.graph_view.GetNode(i);
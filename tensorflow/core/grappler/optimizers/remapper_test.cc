@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
 #include "tensorflow/cc/ops/nn_ops_internal.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
@@ -1428,6 +1429,54 @@ TEST_F(RemapperTest, FuseConv2DWithAdd) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(RemapperTest, MarkMatMulWithConstantRhs) {
+  if (IsMKLEnabled()) GTEST_SKIP() << "oneDNN kernels cache weights instead.";
+
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT,
+                         ops::Placeholder::Shape({8, 32}));
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT,
+                         ops::Placeholder::Shape({32, 64}));
+  auto weights = ops::Const(s.WithOpName("weights"), 1.0f, {32, 64});
+  auto with_const = ops::MatMul(s.WithOpName("with_const"), lhs, weights);
+  auto with_placeholder =
+      ops::MatMul(s.WithOpName("with_placeholder"), lhs, rhs);
+  auto batch_with_const =
+      ops::BatchMatMulV2(s.WithOpName("batch_with_const"), lhs, weights);
+  // Variables may be updated in place, so their reads are not marked.
+  auto var = ops::VarHandleOp(s.WithOpName("var"), DT_FLOAT, {32, 64});
+  auto read = ops::ReadVariableOp(s.WithOpName("read"), var, DT_FLOAT);
+  auto with_variable = ops::MatMul(s.WithOpName("with_variable"), lhs, read);
+
+  GrapplerItem item;
+  item.fetch = {"with_const", "with_placeholder", "batch_with_const",
+                "with_variable"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "with_const" || node.name() == "batch_with_const") {
+      ASSERT_EQ(node.attr().count("_rhs_is_constant"), 1);
+      EXPECT_TRUE(node.attr().at("_rhs_is_constant").b());
+      found++;
+    } else if (node.name() == "with_placeholder" ||
+               node.name() == "with_variable") {
+      EXPECT_EQ(node.attr().count("_rhs_is_constant"), 0);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 4);
+}
+
 // Fuse  matmul + add {1,C}
 TEST_F(RemapperTest, FuseMatmulWithAdd) {
   if (!IsMKLEnabled()) GTEST_SKIP() << "Test only applicable to MKL.";
@@ -1767,6 +1816,73 @@ TEST_F(RemapperTensorToHashBucketTest, I32) { RunTest<DT_INT32>(); }
 
 TEST_F(RemapperTensorToHashBucketTest, I64) { RunTest<DT_INT64>(); }
 
+TEST_F(RemapperTest, FuseScaledDotProductAttention) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto qk_shape = ops::Placeholder::Shape({2, 3, 16, 8});
+  auto mask_shape = ops::Placeholder::Shape({2, 1, 1, 16});
+  auto query = Placeholder(s.WithOpName("query"), DT_FLOAT, qk_shape);
+  auto key = Placeholder(s.WithOpName("key"), DT_FLOAT, qk_shape);
+  auto value = Placeholder(s.WithOpName("value"), DT_FLOAT, qk_shape);
+  auto mask = Placeholder(s.WithOpName("mask"), DT_FLOAT, mask_shape);
+  auto scale = ops::Const(s.WithOpName("scale"), 0.35f, {});
+
+  auto scores = ops::BatchMatMulV2(s.WithOpName("scores"), query, key,
+                                   ops::BatchMatMulV2::AdjY(true));
+  auto scaled = ops::Mul(s.WithOpName("scaled"), scores, scale);
+  auto masked = ops::AddV2(s.WithOpName("masked"), scaled, mask);
+  auto probs = ops::Softmax(s.WithOpName("probs"), masked);
+  auto attention = ops::BatchMatMulV2(s.WithOpName("attention"), probs, value);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), attention);
+
+  auto query_t = GenerateRandomTensor<DT_FLOAT>({2, 3, 16, 8});
+  auto key_t = GenerateRandomTensor<DT_FLOAT>({2, 3, 16, 8});
+  auto value_t = GenerateRandomTensor<DT_FLOAT>({2, 3, 16, 8});
+  auto mask_t = GenerateRandomTensor<DT_FLOAT>({2, 1, 1, 16});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"query", query_t},
+               {"key", key_t},
+               {"value", value_t},
+               {"mask", mask_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "attention") {
+      EXPECT_EQ(node.op(), "_FusedScaledDotProductAttention");
+      ASSERT_EQ(node.input_size(), 5);
+      EXPECT_EQ(node.input(0), "query");
+      EXPECT_EQ(node.input(1), "key");
+      EXPECT_EQ(node.input(2), "value");
+      EXPECT_EQ(node.input(3), "scale");
+      EXPECT_EQ(node.input(4), "mask");
+      EXPECT_EQ(node.attr().at("num_masks").i(), 1);
+      found++;
+    }
+    EXPECT_NE(node.op(), "Softmax");
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-4);
+}
+
 class RemapperFuseMatMulWithBiasTest : public RemapperTest {
  public:
   template <DataType DTYPE>
@@ -15,12 +15,22 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/static_schedule.h"
 
+#include <algorithm>
 #include <deque>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <unordered_set>
+#include <utility>
 
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
+#include "tensorflow/core/grappler/costs/virtual_scheduler.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -199,5 +209,151 @@ Status EstimateRequiredTimes(
   return absl::OkStatus();
 }
 
+namespace {
+
+// Picks the ready node whose execution reduces the memory used by temporary
+// tensors the most. The ready nodes are scanned on every pick, since the
+// memory a node frees changes as the other consumers of its inputs run.
+class MemoryAwareReadyManager : public ReadyNodeManager {
+ public:
+  explicit MemoryAwareReadyManager(const GraphDef& graph) {
+    for (int i = 0; i < graph.node_size(); ++i) {
+      positions_[&graph.node(i)] = i;
+    }
+  }
+  ~MemoryAwareReadyManager() override {}
+
+  Status Init(const std::unordered_map<const NodeDef*, NodeState>* node_map)
+      override {
+    node_map_ = node_map;
+    nodes_.clear();
+    curr_node_ = nullptr;
+    return absl::OkStatus();
+  }
+  void AddNode(const NodeDef* node) override { nodes_.push_back(node); }
+  const NodeDef* GetCurrNode() override {
+    if (curr_node_ != nullptr) return curr_node_;
+    CHECK(!nodes_.empty()) << "GetCurrNode(), but there's no ready node";
+    auto best = nodes_.begin();
+    int64_t best_delta = MemoryDelta(**best);
+    for (auto it = std::next(nodes_.begin()); it != nodes_.end(); ++it) {
+      const int64_t delta = MemoryDelta(**it);
+      if (delta < best_delta ||
+          (delta == best_delta && Position(*it) < Position(*best))) {
+        best = it;
+        best_delta = delta;
+      }
+    }
+    // Remove the node from the ready nodes right away, since the nodes it
+    // makes ready are added before RemoveCurrNode() is called.
+    curr_node_ = *best;
+    nodes_.erase(best);
+    return curr_node_;
+  }
+  void RemoveCurrNode() override { curr_node_ = nullptr; }
+  bool Empty() const override {
+    return nodes_.empty() && curr_node_ == nullptr;
+  }
+
+ private:
+  // Returns the number of bytes that running `node` allocates for its outputs
+  // minus the number of bytes of the inputs it is the last consumer of.
+  int64_t MemoryDelta(const NodeDef& node) const {
+    const NodeState& state = node_map_->at(&node);
+    int64_t delta = 0;
+    if (!IsPersistent(node)) {
+      for (const auto& [port, consumers] : state.outputs) {
+        if (port >= 0 && !consumers.empty()) {
+          delta += CalculateOutputSize(state.output_properties, port);
+        }
+      }
+    }
+    std::map<std::pair<const NodeDef*, int>, int> input_uses;
+    for (const auto& input_port : state.inputs) {
+      ++input_uses[input_port];
+    }
+    for (const auto& [input_port, uses] : input_uses) {
+      const NodeDef* input = input_port.first;
+      const int port = input_port.second;
+      if (port < 0 || IsPersistent(*input)) continue;
+      const NodeState& input_state = node_map_->at(input);
+      const auto consumers = input_state.outputs.find(port);
+      const auto executed = input_state.num_outputs_executed.find(port);
+      if (consumers == input_state.outputs.end() ||
+          executed == input_state.num_outputs_executed.end()) {
+        continue;
+      }
+      if (executed->second + uses ==
+          static_cast<int>(consumers->second.size())) {
+        delta -= CalculateOutputSize(input_state.output_properties, port);
+      }
+    }
+    return delta;
+  }
+
+  // Nodes added by the VirtualScheduler, such as _Send and _Recv nodes, come
+  // after the nodes of the graph.
+  int Position(const NodeDef* node) const {
+    auto it = positions_.find(node);
+    return it == positions_.end() ? std::numeric_limits<int>::max()
+                                  : it->second;
+  }
+
+  std::unordered_map<const NodeDef*, int> positions_;
+  const std::unordered_map<const NodeDef*, NodeState>* node_map_ = nullptr;
+  std::list<const NodeDef*> nodes_;
+  const NodeDef* curr_node_ = nullptr;
+};
+
+// Simulates the execution of `item`, running the ready nodes in the order
+// `ready_nodes` picks them. Appends the nodes of the graph that are run to
+// `schedule` if it is not null, and sets `peak_memory_usage` to the peak
+// temporary memory usage of the busiest device.
+Status SimulateSchedule(const GrapplerItem& item, Cluster* cluster,
+                        ReadyNodeManager* ready_nodes,
+                        std::vector<const NodeDef*>* schedule,
+                        int64_t* peak_memory_usage) {
+  VirtualScheduler scheduler(
+      /*use_static_shapes=*/true, /*use_aggressive_shape_inference=*/false,
+      cluster, ready_nodes,
+      std::make_unique<VirtualPlacer>(cluster->GetDevices()));
+  TF_RETURN_IF_ERROR(scheduler.Init(&item));
+
+  std::unordered_set<const NodeDef*> graph_nodes;
+  for (const NodeDef& node : item.graph.node()) graph_nodes.insert(&node);
+  OpLevelCostEstimator estimator;
+  Costs node_costs;
+  do {
+    const OpContext op_context = scheduler.GetCurrNode();
+    const NodeDef* node = ready_nodes->GetCurrNode();
+    if (schedule != nullptr && graph_nodes.count(node) > 0) {
+      schedule->push_back(node);
+    }
+    node_costs = estimator.PredictCosts(op_context);
+  } while (scheduler.MarkCurrNodeExecuted(node_costs));
+
+  *peak_memory_usage = 0;
+  for (const auto& device_usage : scheduler.GetPeakMemoryUsage()) {
+    *peak_memory_usage = std::max(*peak_memory_usage, device_usage.second);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+Status EstimateMemoryAwareSchedule(const GrapplerItem& item, Cluster* cluster,
+                                   std::vector<const NodeDef*>* schedule,
+                                   int64_t* peak_memory_usage,
+                                   int64_t* default_peak_memory_usage) {
+  schedule->clear();
+  MemoryAwareReadyManager memory_aware_ready_nodes(item.graph);
+  TF_RETURN_IF_ERROR(SimulateSchedule(item, cluster, &memory_aware_ready_nodes,
+                                      schedule, peak_memory_usage));
+  std::unique_ptr<ReadyNodeManager> default_ready_nodes =
+      ReadyNodeManagerFactory("FirstReady");
+  return SimulateSchedule(item, cluster, default_ready_nodes.get(),
+                          /*schedule=*/nullptr, default_peak_memory_usage);
+}
+
 }  // end namespace grappler
 }  // end namespace tensorflow
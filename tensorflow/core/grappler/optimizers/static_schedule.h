@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_STATIC_SCHEDULE_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_STATIC_SCHEDULE_H_
 
+#include <cstdint>
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
@@ -44,6 +46,21 @@ Status EstimateRequiredTimes(
         execution_times,
     std::unordered_map<const NodeDef*, Costs::NanoSeconds>* required_times);
 
+// Compute an order in which to run the nodes needed to compute the fetches of
+// `item` that keeps the estimated peak memory usage low. The order is found by
+// simulating the execution of the graph with a VirtualScheduler that always
+// runs the ready node that frees the most memory, or allocates the least: the
+// size of the inputs it is the last consumer of minus the size of its outputs.
+// Ties are broken by the position of the nodes in the graph.
+// `peak_memory_usage` is set to the estimated peak temporary memory usage of
+// the busiest device when running the nodes in that order, and
+// `default_peak_memory_usage` to the same estimate for the order in which the
+// VirtualScheduler runs the nodes by default.
+Status EstimateMemoryAwareSchedule(const GrapplerItem& item, Cluster* cluster,
+                                   std::vector<const NodeDef*>* schedule,
+                                   int64_t* peak_memory_usage,
+                                   int64_t* default_peak_memory_usage);
+
 }  // namespace grappler
 }  // end namespace tensorflow
 
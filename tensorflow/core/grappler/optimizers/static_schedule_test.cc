@@ -15,6 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/static_schedule.h"
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
@@ -196,6 +201,45 @@ TEST_F(StaticScheduleTest, RequiredTimes) {
                                       "Sign_2", "Sign_3", "y"}));
 }
 
+TEST_F(StaticScheduleTest, MemoryAwareSchedule) {
+  // Each branch computes a large tensor and reduces it to a scalar. Running
+  // the reduction of each branch right after it keeps a single large tensor
+  // alive at a time, while running the ready nodes in order of readiness
+  // computes all the large tensors first.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), 1.0f, {128, 128});
+  Output axes = ops::Const(s.WithOpName("axes"), {0, 1});
+  std::vector<Output> sums;
+  for (int i = 0; i < 4; ++i) {
+    Output square = ops::Square(s.WithOpName(absl::StrCat("square", i)), x);
+    sums.push_back(
+        ops::Sum(s.WithOpName(absl::StrCat("sum", i)), square, axes));
+  }
+  Output total = ops::AddN(s.WithOpName("total"), sums);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"total"};
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  std::vector<const NodeDef*> schedule;
+  int64_t peak_memory_usage;
+  int64_t default_peak_memory_usage;
+  TF_ASSERT_OK(EstimateMemoryAwareSchedule(item, cluster.get(), &schedule,
+                                           &peak_memory_usage,
+                                           &default_peak_memory_usage));
+  const int64_t square_size = 128 * 128 * sizeof(float);
+  EXPECT_LT(peak_memory_usage, 2 * square_size);
+  EXPECT_GE(default_peak_memory_usage, 4 * square_size);
+
+  std::vector<std::string> scheduled_names;
+  for (const NodeDef* node : schedule) scheduled_names.push_back(node->name());
+  EXPECT_EQ(scheduled_names,
+            (std::vector<std::string>{"x", "axes", "square0", "sum0",
+                                      "square1", "sum1", "square2", "sum2",
+                                      "square3", "sum3", "total"}));
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
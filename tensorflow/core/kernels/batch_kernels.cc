@@ -65,6 +65,8 @@ constexpr char kMaxInflightBatchesAttr[] = "_max_inflight_batches";
 constexpr char kBatchesToAverageOverAttr[] = "_batches_to_average_over";
 constexpr char kFullBatchSchedulingBoostMicros[] =
     "_full_batch_scheduling_boost_micros";
+constexpr char kRaggedBatchingAttr[] = "_ragged_batching";
+constexpr char kSequenceLengthBucketsAttr[] = "_sequence_length_buckets";
 
 // Default thread count in the per-process batching thread pool.
 constexpr int64_t kBatchThreadPoolSize = 128;
@@ -317,6 +319,15 @@ BatchFunctionKernel::BatchFunctionKernel(OpKernelConstruction* c)
     has_attribute_enable_large_batch_splitting_ = true;
   }
 
+  if (c->HasAttr(kRaggedBatchingAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kRaggedBatchingAttr, &ragged_batching_));
+  }
+  if (c->HasAttr(kSequenceLengthBucketsAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kSequenceLengthBucketsAttr,
+                                 &sequence_length_buckets_));
+  }
+  OP_REQUIRES_OK(c, ValidateSequenceLengthBuckets());
+
   // Helper function `SetAdaptiveBatchSchedulerOptions` calls
   // `OP_REQUIRES_OK`, which exits the current function upon error.
   // So validate status of `op-kernel-construction`.
@@ -423,6 +434,7 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      new_resource->set_ragged_batching(ragged_batching_);
       *r = new_resource.release();
       return absl::OkStatus();
     };
@@ -445,11 +457,15 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      new_resource->set_ragged_batching(ragged_batching_);
       *r = new_resource.release();
       return absl::OkStatus();
     };
   }
 
+  string batcher_queue;
+  OP_REQUIRES_OK_ASYNC(c, GetBatcherQueue(c, &batcher_queue), done);
+
   BatchResource* br;
   OP_REQUIRES_OK_ASYNC(c,
                        c->resource_manager()->LookupOrCreate(
@@ -463,11 +479,11 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
   };
   Status status;
   if (serving::ShouldWarmupAllBatchSizes(c)) {
-    status = br->RegisterWarmupInputs(guid, c, batcher_queue_,
+    status = br->RegisterWarmupInputs(guid, c, batcher_queue,
                                       create_batch_task_fn, done);
   } else {
     status =
-        br->RegisterInput(guid, c, batcher_queue_, create_batch_task_fn, done);
+        br->RegisterInput(guid, c, batcher_queue, create_batch_task_fn, done);
   }
   br->Unref();
   OP_REQUIRES_OK_ASYNC(c, status, done);
@@ -575,6 +591,55 @@ Status BatchFunctionKernel::ValidateAllowedBatchSizes() const {
   return absl::OkStatus();
 }
 
+// Validates 'sequence_length_buckets_'. The entries must be positive and
+// increase monotonically, and need ragged batching.
+Status BatchFunctionKernel::ValidateSequenceLengthBuckets() const {
+  if (sequence_length_buckets_.empty()) {
+    return absl::OkStatus();
+  }
+  if (!ragged_batching_) {
+    return errors::InvalidArgument(kSequenceLengthBucketsAttr, " requires ",
+                                   kRaggedBatchingAttr);
+  }
+  int32_t last_length = 0;
+  for (const int32_t length : sequence_length_buckets_) {
+    if (length <= last_length) {
+      return errors::InvalidArgument(
+          kSequenceLengthBucketsAttr,
+          " entries must be positive and monotonically increasing");
+    }
+    last_length = length;
+  }
+  return absl::OkStatus();
+}
+
+// Without sequence length buckets, all requests share 'batcher_queue_'.
+// Otherwise each bucket has a queue of its own, and a request goes to the
+// first bucket that is at least as long as the longest dimension 1 of its
+// batched inputs, or to one past the last bucket if none is.
+Status BatchFunctionKernel::GetBatcherQueue(OpKernelContext* c,
+                                            string* batcher_queue) const {
+  if (sequence_length_buckets_.empty()) {
+    *batcher_queue = batcher_queue_;
+    return absl::OkStatus();
+  }
+  OpInputList tensors;
+  TF_RETURN_IF_ERROR(c->input_list("in_tensors", &tensors));
+  int64_t sequence_length = 0;
+  for (const Tensor& tensor : tensors) {
+    if (tensor.dims() >= 2) {
+      sequence_length = std::max(sequence_length, tensor.dim_size(1));
+    }
+  }
+  const int bucket =
+      std::lower_bound(sequence_length_buckets_.begin(),
+                       sequence_length_buckets_.end(), sequence_length) -
+      sequence_length_buckets_.begin();
+  *batcher_queue =
+      absl::StrCat(batcher_queue_, "/sequence_length_bucket_", bucket);
+  return absl::OkStatus();
+}
+
 // Initialize vars by reading from op-kernel-construction.
 // Vars
 // - enable_adaptive_batch_threads_
@@ -80,6 +80,13 @@ class BatchFunctionKernel : public AsyncOpKernel {
   // to `max_batch_size_`.
   Status ValidateAllowedBatchSizes() const;
 
+  // Validates 'sequence_length_buckets_'.
+  Status ValidateSequenceLengthBuckets() const;
+
+  // Returns in 'batcher_queue' the name of the queue that batches the inputs
+  // of 'c', which depends on their sequence length bucket if there are any.
+  Status GetBatcherQueue(OpKernelContext* c, string* batcher_queue) const;
+
   // Creates the function handle if it isn't initialized yet; and re-use it
   // afterwards.
   Status GetOrCreateFunctionHandle(OpKernelContext* c,
@@ -117,6 +124,11 @@ class BatchFunctionKernel : public AsyncOpKernel {
   bool enable_large_batch_splitting_ = false;
   bool has_attribute_enable_large_batch_splitting_ = false;
   bool enable_adaptive_batch_threads_ = false;
+  // Batched inputs of rank 2 or more are batched as ragged tensors; see
+  // `BatchResourceBase::set_ragged_batching`.
+  bool ragged_batching_ = false;
+  // Increasing upper bounds of the sequence lengths that share a queue.
+  std::vector<int32> sequence_length_buckets_;
 
   mutex mu_;
 
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/batch_kernels.h"
 #include "tensorflow/core/kernels/batching_util/warmup.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/test.h"
@@ -276,6 +277,38 @@ TEST_P(BatchFunctionKernelParallelWarmupTest, AutoBatchWorks) {
   }
 }
 
+TEST_P(BatchFunctionKernelParallelWarmupTest, RecordsWarmupBatchLatencies) {
+  SessionMetadata session_metadata;
+  session_metadata.set_name("test_model_warmup_latency");
+  session_metadata.set_version(1);
+  serving::WarmupStateRegistry::Key key(session_metadata.name(),
+                                        session_metadata.version());
+  monitoring::testing::CellReader<int64_t> warmup_latency_reader(
+      "/tensorflow/serving/batching/warmup_batch_latency_us");
+
+  auto per_model_data = std::make_unique<PerModelData>();
+  per_model_data->warmup_all_batch_sizes = true;
+  auto handle = serving::GetGlobalWarmupStateRegistry().Register(
+      key, std::move(per_model_data));
+
+  BatchFunctionKernelParallelWarmupTestState test;
+  test.set_session_metadata(session_metadata);
+  TF_ASSERT_OK(test.Init(GetParam(), /*check_output_shape=*/false));
+  test.AddInputFromList<int64_t>(TensorShape({2}), {123, 456});
+  TF_ASSERT_OK(test.RunOpKernel());
+  test::ExpectTensorEqual<int64_t>(*test.GetOutput(0),
+                                   test::AsTensor<int64_t>({123, 456}));
+
+  // The real request only completes after the warmup batch of every allowed
+  // batch size did.
+  for (const char* batch_size : {"2", "4", "8"}) {
+    EXPECT_GT(warmup_latency_reader.Read(session_metadata.name(),
+                                         "BatchTPUInput", batch_size),
+              0)
+        << batch_size;
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(BatchFunctionKernelParallelWarmupTestSuite,
                          BatchFunctionKernelParallelWarmupTest,
                          ::testing::Bool());
@@ -746,5 +746,101 @@ INSTANTIATE_TEST_SUITE_P(BatchFunctionKernelPaddingTestSuite,
                          ::testing::Values("PAD_UP", "BATCH_DOWN",
                                            "MINIMIZE_TPU_COST_PER_REQUEST"));
 
+class BatchFunctionKernelRaggedTestState
+    : public SharedBatchFunctionTestState {
+ public:
+  // Init test fixture with a ragged batch kernel instance, whose function
+  // checks that it gets `expected_num_values` values and returns the length
+  // of each of 4 rows.
+  absl::Status Init(int64_t expected_num_values) {
+    static auto *const cpu_device = []() {
+      auto device =
+          DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:0");
+      return device.release();
+    }();
+    device_ = cpu_device;
+
+    NameAttrList f;
+    f.set_name("RowLengthsFunction");
+    FunctionDef func = FunctionDefHelper::Create(
+        // function_name
+        f.name(),
+        // in_def
+        {"values:int64", "row_splits:int64"},
+        // out_def
+        {"lengths:int64"},
+        // attr_def
+        {},
+        // node_def
+        {FunctionDefHelper::Const<int32>("zero", std::vector<int32>{0}),
+         FunctionDefHelper::Const<int32>("one", std::vector<int32>{1}),
+         FunctionDefHelper::Const<int32>("four", std::vector<int32>{4}),
+         {{"checked_values"},
+          "EnsureShape",
+          {"values"},
+          {{"T", DataType::DT_INT64},
+           {"shape", TensorShape({expected_num_values})}}},
+         {{"starts"},
+          "Slice",
+          {"row_splits", "zero:output:0", "four:output:0"},
+          {{"T", DataType::DT_INT64}, {"Index", DataType::DT_INT32}}},
+         {{"ends"},
+          "Slice",
+          {"row_splits", "one:output:0", "four:output:0"},
+          {{"T", DataType::DT_INT64}, {"Index", DataType::DT_INT32}}},
+         {{"lengths"},
+          "Sub",
+          {"ends:output:0", "starts:output:0", "^checked_values"},
+          {{"T", DataType::DT_INT64}}}},
+        // ret_def
+        {{"lengths", "lengths:z:0"}});
+    TF_RETURN_IF_ERROR(flib_def_->AddFunctionDef(func));
+    SharedBatchFunctionTestState::CreateFunctionLibraryRuntime();
+
+    std::vector<NodeDefBuilder::NodeOut> inputs(
+        {NodeDefBuilder::NodeOut({"n1", 0, DataType::DT_INT64})});
+    TF_RETURN_IF_ERROR(NodeDefBuilder("BatchRaggedInput", "BatchFunction")
+                           .Attr("max_batch_size", 8)
+                           .Attr("num_batch_threads", 8)
+                           .Attr("allowed_batch_sizes", {4, 8})
+                           .Attr("batch_timeout_micros", 1000000)
+                           .Attr("max_enqueued_batches", 10)
+                           .Attr("enable_large_batch_splitting", true)
+                           .Attr("_ragged_batching", true)
+                           .Attr("Tin", {DataType::DT_INT64})
+                           .Input(inputs)
+                           .Attr("Tcaptured", std::vector<DataType>{})
+                           .Input(std::vector<NodeDefBuilder::NodeOut>{})
+                           .Attr("Tout", std::vector<DataType>{DT_INT64})
+                           .Attr("f", f)
+                           .Finalize(node_def()));
+    return OpsTestBase::InitOp();
+  }
+
+  void TestBody() override {}
+};
+
+TEST(BatchFunctionKernelRaggedTest, PassesRowSplitsInsteadOfPadding) {
+  // Two requests with rows of lengths 2 and 3 are batched and padded to 4
+  // rows. The function gets their 5 values, and row splits that make the 2
+  // padding rows empty.
+  tsl::BlockingCounter blocking_counter(2);
+  for (const int64_t length : {2, 3}) {
+    Env::Default()->SchedClosure([&blocking_counter, length]() {
+      BatchFunctionKernelRaggedTestState test_state;
+      TF_CHECK_OK(test_state.Init(/*expected_num_values=*/5));
+      test_state.AddInputFromArray<int64_t>(TensorShape({1, length}),
+                                            std::vector<int64_t>(length, 7));
+      TF_EXPECT_OK(test_state.RunOpKernel());
+
+      test::ExpectTensorEqual<int64_t>(
+          *test_state.GetOutput(0),
+          test::AsTensor<int64_t>({length}, TensorShape({1})));
+      blocking_counter.DecrementCount();
+    });
+  }
+  blocking_counter.Wait();
+}
+
 }  // namespace
 }  // namespace tensorflow
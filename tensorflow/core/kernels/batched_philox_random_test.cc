@@ -0,0 +1,87 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/batched_philox_random.h"
+
+#include <cstdint>
+
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace random {
+namespace {
+
+TEST(BatchedPhiloxRandomTest, MatchesPhiloxRandom) {
+  // Starts before counters whose low words wrap around, and one whose whole
+  // 128 bits do.
+  for (uint64_t skip : {uint64_t{0}, uint64_t{0xFFFFFFF0}, uint64_t{0xFFFFFFFF},
+                        ~uint64_t{10}}) {
+    PhiloxRandom gen(301, 17);
+    gen.Skip(skip);
+    BatchedPhiloxRandom batched_gen(gen);
+    for (int i = 0; i < 100; ++i) {
+      const PhiloxRandom::ResultType expected = gen();
+      const PhiloxRandom::ResultType actual = batched_gen();
+      for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+        EXPECT_EQ(actual[j], expected[j]) << "skip " << skip << " sample " << i;
+      }
+    }
+  }
+}
+
+template <template <class, typename> class Distribution, typename T>
+void ExpectSameSamples() {
+  PhiloxRandom gen(42, 7);
+  BatchedPhiloxRandom batched_gen(gen);
+  Distribution<PhiloxRandom, T> dist;
+  Distribution<BatchedPhiloxRandom, T> batched_dist;
+  for (int i = 0; i < 100; ++i) {
+    const auto expected = dist(&gen);
+    const auto actual = batched_dist(&batched_gen);
+    for (int j = 0; j < expected.size(); ++j) {
+      EXPECT_EQ(actual[j], expected[j]) << "sample " << i;
+    }
+  }
+}
+
+TEST(BatchedPhiloxRandomTest, MatchesDistributions) {
+  ExpectSameSamples<UniformDistribution, float>();
+  ExpectSameSamples<UniformDistribution, double>();
+  ExpectSameSamples<UniformDistribution, Eigen::half>();
+  ExpectSameSamples<NormalDistribution, float>();
+  ExpectSameSamples<NormalDistribution, double>();
+  ExpectSameSamples<UniformFullIntDistribution, int64_t>();
+}
+
+template <class Generator>
+void BM_UniformFloat(::testing::benchmark::State& state) {
+  Generator gen(PhiloxRandom(301, 17));
+  UniformDistribution<Generator, float> dist;
+  float sum = 0;
+  for (auto s : state) {
+    const auto samples = dist(&gen);
+    sum += samples[0] + samples[1] + samples[2] + samples[3];
+  }
+  testing::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_UniformFloat<PhiloxRandom>);
+BENCHMARK(BM_UniformFloat<BatchedPhiloxRandom>);
+
+}  // namespace
+}  // namespace random
+}  // namespace tensorflow
@@ -20,16 +20,20 @@ limitations under the License.
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <random>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/batch_stats.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
@@ -132,6 +136,18 @@ class AdaptiveSharedBatchScheduler
     // full_batch_scheduling_boost_micros==zero) for backward compatibility of
     // API.
     bool fifo_scheduling = false;
+
+    // If positive, the scheduler aims for the highest throughput that keeps
+    // the p99 batch latency (from batch creation to the end of processing)
+    // at or below this target, instead of the lowest average latency:
+    //  - every `batches_to_average_over` batches, in_flight_batches_limit_
+    //    grows while the p99 of those batches meets the target and shrinks
+    //    while it doesn't;
+    //  - queues with a `model_batch_stats` close their batches at the batch
+    //    size with the highest throughput whose predicted latency fits the
+    //    target (see QueueOptions::model_batch_stats).
+    // Both decisions are exported under /tensorflow/serving/batching/asbs/.
+    int64_t p99_latency_target_micros = 0;
   };
 
   // Ownership is shared between the caller of Create() and any queues created
@@ -171,6 +187,16 @@ class AdaptiveSharedBatchScheduler
 
     // If true, the padding will not be appended.
     bool disable_padding = false;
+
+    // Per-batch-size costs of the model served by this queue. Only used when
+    // the scheduler has a `p99_latency_target_micros`: batches are then closed
+    // at the recorded batch size `b` with the highest throughput `b / cost(b)`
+    // among those with `cost(b) + batch_timeout_micros` within the target,
+    // rather than at `max_batch_size`. Must outlive the queue.
+    ModelBatchStats* model_batch_stats = nullptr;
+
+    // Identifies the queue in the exported target batch size metric.
+    string name;
   };
 
   using BatchProcessor = std::function<void(std::unique_ptr<Batch<TaskType>>)>;
@@ -214,6 +240,10 @@ class AdaptiveSharedBatchScheduler
 
   void MaybeAdjustInflightLimit() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Adjusts in_flight_batches_limit_ and the target batch size of each queue
+  // against `p99_latency_target_micros`.
+  void AdjustForLatencyTarget() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Notifies scheduler of non-empty batch which is eligible for processing.
   void AddBatch(const internal::ASBSBatch<TaskType>* batch);
 
@@ -277,6 +307,10 @@ class AdaptiveSharedBatchScheduler
   // batch.
   DelayStats batch_delay_stats_ TF_GUARDED_BY(mu_);
 
+  // Latencies of the batches counted by batch_count_. Only recorded with a
+  // `p99_latency_target_micros`.
+  std::vector<int64_t> batch_latencies_micros_ TF_GUARDED_BY(mu_);
+
   // Max adjustment size (as a fraction of in_flight_batches_limit_).
   constexpr static double kMaxStepSizeMultiplier = 0.125;  // 1/8;
   // Min adjustment size (as a fraction of in_flight_batches_limit_).
@@ -322,6 +356,15 @@ class ASBSQueue : public BatchScheduler<TaskType> {
 
   size_t max_task_size() const override { return options_.max_batch_size; }
 
+  // Picks the size at which batches are closed from `model_batch_stats`, given
+  // the latency a batch may take. Keeps `max_batch_size` without stats.
+  void UpdateTargetBatchSize(int64_t latency_target_micros);
+
+  // Returns the size at which batches are closed.
+  int target_batch_size() const;
+
+  const string& name() const { return options_.name; }
+
  private:
   // Number of size 1 tasks which could currently be scheduled without failing.
   size_t SchedulingCapacityLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
@@ -336,6 +379,7 @@ class ASBSQueue : public BatchScheduler<TaskType> {
   ASBSBatch<TaskType>* current_batch_ TF_GUARDED_BY(mu_) = nullptr;
   int64_t num_enqueued_batches_ TF_GUARDED_BY(mu_) = 0;
   int64_t num_enqueued_tasks_ TF_GUARDED_BY(mu_) = 0;
+  int target_batch_size_ TF_GUARDED_BY(mu_);
   mutable mutex mu_;
   ASBSQueue(const ASBSQueue&) = delete;
   void operator=(const ASBSQueue&) = delete;
@@ -370,6 +414,37 @@ class ASBSBatch : public Batch<TaskType> {
   ASBSBatch(const ASBSBatch&) = delete;
   void operator=(const ASBSBatch&) = delete;
 };
+
+inline void RecordInFlightBatchesLimit(double limit,
+                                       const string& thread_pool_name) {
+  static auto* cell = monitoring::Gauge<double, 1>::New(
+      "/tensorflow/serving/batching/asbs/in_flight_batches_limit",
+      "Tracks the limit on concurrently processed batches chosen by an "
+      "adaptive shared batch scheduler with a latency target.",
+      "thread_pool_name");
+  cell->GetCell(thread_pool_name)->Set(limit);
+}
+
+inline void RecordBatchLatencyP99(int64_t latency_micros,
+                                  const string& thread_pool_name) {
+  static auto* cell = monitoring::Gauge<int64_t, 1>::New(
+      "/tensorflow/serving/batching/asbs/batch_latency_p99_micros",
+      "Tracks the p99 batch latency that an adaptive shared batch scheduler "
+      "with a latency target last observed.",
+      "thread_pool_name");
+  cell->GetCell(thread_pool_name)->Set(latency_micros);
+}
+
+inline void RecordTargetBatchSize(int64_t batch_size,
+                                  const string& thread_pool_name,
+                                  const string& queue_name) {
+  static auto* cell = monitoring::Gauge<int64_t, 2>::New(
+      "/tensorflow/serving/batching/asbs/target_batch_size",
+      "Tracks the batch size chosen for a queue of an adaptive shared batch "
+      "scheduler with a latency target.",
+      "thread_pool_name", "queue_name");
+  cell->GetCell(thread_pool_name, queue_name)->Set(batch_size);
+}
 }  // namespace internal
 
 // ---------------- AdaptiveSharedBatchScheduler ----------------
@@ -423,6 +498,11 @@ Status AdaptiveSharedBatchScheduler<TaskType>::Create(
         "greater than or equal to 1; was ",
         options.batches_to_average_over);
   }
+  if (options.p99_latency_target_micros < 0) {
+    return errors::InvalidArgument(
+        "p99_latency_target_micros can't be negative; was ",
+        options.p99_latency_target_micros);
+  }
   scheduler->reset(new AdaptiveSharedBatchScheduler<TaskType>(options));
   return absl::OkStatus();
 }
@@ -654,6 +734,9 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
   in_flight_batches_--;
   batch_count_++;
   batch_delay_stats_.batch_latency_sum += end_time - start_time;
+  if (options_.p99_latency_target_micros > 0) {
+    batch_latencies_micros_.push_back(end_time - start_time);
+  }
 
   MaybeAdjustInflightLimit();
 
@@ -666,6 +749,11 @@ void AdaptiveSharedBatchScheduler<TaskType>::MaybeAdjustInflightLimit() {
   // Although the optimal value may depend on the workload, the latency should
   // be a simple convex function of in_flight_batches_limit_, allowing us to
   // locate the global minimum relatively quickly.
+  if (batch_count_ == options_.batches_to_average_over &&
+      options_.p99_latency_target_micros > 0) {
+    AdjustForLatencyTarget();
+    return;
+  }
   if (batch_count_ == options_.batches_to_average_over) {
     double current_avg_latency_ms =
         (batch_delay_stats_.batch_latency_sum / 1000.) / batch_count_;
@@ -703,6 +791,45 @@ void AdaptiveSharedBatchScheduler<TaskType>::MaybeAdjustInflightLimit() {
   }
 }
 
+template <typename TaskType>
+void AdaptiveSharedBatchScheduler<TaskType>::AdjustForLatencyTarget() {
+  // Throughput grows with the number of concurrently processed batches until
+  // they start queueing for the same resources, which shows up in the tail
+  // latency. So the limit is raised while the p99 meets the target, and
+  // lowered once it doesn't.
+  const int64_t p99_index = (batch_latencies_micros_.size() - 1) * 99 / 100;
+  std::nth_element(batch_latencies_micros_.begin(),
+                   batch_latencies_micros_.begin() + p99_index,
+                   batch_latencies_micros_.end());
+  const int64_t p99_latency_micros = batch_latencies_micros_[p99_index];
+  const int step_direction =
+      p99_latency_micros <= options_.p99_latency_target_micros ? 1 : -1;
+  in_flight_batches_limit_ +=
+      step_direction * in_flight_batches_limit_ * kMaxStepSizeMultiplier;
+  in_flight_batches_limit_ =
+      std::min(in_flight_batches_limit_,
+               static_cast<double>(options_.num_batch_threads));
+  in_flight_batches_limit_ =
+      std::max(in_flight_batches_limit_,
+               static_cast<double>(options_.min_in_flight_batches_limit));
+  batch_count_ = 0;
+  batch_delay_stats_.batch_latency_sum = 0;
+  batch_latencies_micros_.clear();
+
+  internal::RecordBatchLatencyP99(p99_latency_micros,
+                                  options_.thread_pool_name);
+  internal::RecordInFlightBatchesLimit(in_flight_batches_limit_,
+                                       options_.thread_pool_name);
+  for (auto& [queue, callback] : queues_and_callbacks_) {
+    // Lock order is scheduler first, then queue, as in ReleaseBatch.
+    auto* mutable_queue = const_cast<internal::ASBSQueue<TaskType>*>(queue);
+    mutable_queue->UpdateTargetBatchSize(options_.p99_latency_target_micros);
+    internal::RecordTargetBatchSize(mutable_queue->target_batch_size(),
+                                    options_.thread_pool_name,
+                                    mutable_queue->name());
+  }
+}
+
 // ---------------- ASBSQueue ----------------
 
 namespace internal {
@@ -710,7 +837,9 @@ template <typename TaskType>
 ASBSQueue<TaskType>::ASBSQueue(
     std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler,
     const QueueOptions& options)
-    : scheduler_(scheduler), options_(options) {}
+    : scheduler_(scheduler),
+      options_(options),
+      target_batch_size_(options.max_batch_size) {}
 
 template <typename TaskType>
 ASBSQueue<TaskType>::~ASBSQueue() {
@@ -806,8 +935,7 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       bool reached_max_tasks =
           (options_.max_tasks_per_batch.has_value() &&
            current_batch_->num_tasks() >= options_.max_tasks_per_batch.value());
-      if (current_batch_->size() == options_.max_batch_size ||
-          reached_max_tasks) {
+      if (current_batch_->size() >= target_batch_size_ || reached_max_tasks) {
         current_batch_->Close();
         closed_batch = true;
         current_batch_ = nullptr;
@@ -836,6 +964,46 @@ void ASBSQueue<TaskType>::ReleaseBatch(const ASBSBatch<TaskType>* batch) {
   }
 }
 
+template <typename TaskType>
+void ASBSQueue<TaskType>::UpdateTargetBatchSize(int64_t latency_target_micros) {
+  if (options_.model_batch_stats == nullptr) return;
+  // A request waits up to `batch_timeout_micros` for its batch to fill up
+  // before the batch is processed, so that is taken off the budget.
+  const int64_t cost_budget_micros =
+      latency_target_micros - options_.batch_timeout_micros;
+  std::optional<int> best_batch_size;
+  double best_throughput = 0;
+  // Used when no batch size fits the budget.
+  std::optional<int> cheapest_batch_size;
+  absl::Duration cheapest_cost = absl::InfiniteDuration();
+  for (int32 batch_size : options_.model_batch_stats->BatchSizes()) {
+    if (batch_size <= 0 || batch_size > options_.max_batch_size) continue;
+    std::optional<absl::Duration> cost =
+        options_.model_batch_stats->batch_size(batch_size).tpu_cost().mean();
+    if (!cost.has_value() || *cost <= absl::ZeroDuration()) continue;
+    if (*cost < cheapest_cost) {
+      cheapest_cost = *cost;
+      cheapest_batch_size = batch_size;
+    }
+    if (absl::ToInt64Microseconds(*cost) > cost_budget_micros) continue;
+    const double throughput = batch_size / absl::ToDoubleMicroseconds(*cost);
+    if (!best_batch_size.has_value() || throughput > best_throughput) {
+      best_throughput = throughput;
+      best_batch_size = batch_size;
+    }
+  }
+  if (!best_batch_size.has_value()) best_batch_size = cheapest_batch_size;
+  if (!best_batch_size.has_value()) return;
+  mutex_lock l(mu_);
+  target_batch_size_ = *best_batch_size;
+}
+
+template <typename TaskType>
+int ASBSQueue<TaskType>::target_batch_size() const {
+  mutex_lock l(mu_);
+  return target_batch_size_;
+}
+
 template <typename TaskType>
 size_t ASBSQueue<TaskType>::NumEnqueuedTasks() const {
   mutex_lock l(mu_);
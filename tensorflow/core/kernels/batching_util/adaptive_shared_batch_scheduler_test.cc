@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/adaptive_shared_batch_scheduler.h"
 
+#include "absl/time/time.h"
+#include "tensorflow/core/kernels/batching_util/batch_stats.h"
 #include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -96,6 +99,9 @@ TEST(AdaptiveSharedBatchSchedulerTest, BadOptions) {
   options.min_in_flight_batches_limit = 2;
   options.num_batch_threads = 3;
   EXPECT_FALSE(Scheduler::Create(options, &scheduler).ok());
+  options = Scheduler::Options();
+  options.p99_latency_target_micros = -1;
+  EXPECT_FALSE(Scheduler::Create(options, &scheduler).ok());
 }
 
 TEST(AdaptiveSharedBatchSchedulerTest, InFlightBatchesLimit) {
@@ -200,6 +206,68 @@ TEST(AdaptiveSharedBatchSchedulerTest, InFlightBatchesLimitTuning) {
   stop_teardown.Notify();
 }
 
+TEST(AdaptiveSharedBatchSchedulerTest, LatencyTargetTuning) {
+  monitoring::testing::CellReader<int64_t> target_batch_size_reader(
+      "/tensorflow/serving/batching/asbs/target_batch_size");
+  monitoring::testing::CellReader<int64_t> batch_latency_p99_reader(
+      "/tensorflow/serving/batching/asbs/batch_latency_p99_micros");
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+  {
+    AdaptiveSharedBatchScheduler<FakeTask>::Options options;
+    options.thread_pool_name = "latency_target_test";
+    options.env = &env;
+    options.num_batch_threads = 4;
+    options.initial_in_flight_batches_limit = 2;
+    options.batches_to_average_over = 1;
+    options.p99_latency_target_micros = 100;
+    auto queue_callback = [&env](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      env.AdvanceByMicroseconds(batch->size() == 100 ? 150 : 50);
+    };
+    std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(
+        AdaptiveSharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+
+    // Batches of 50 have the highest throughput among those that fit in the
+    // latency target.
+    ModelBatchStats model_batch_stats;
+    model_batch_stats.batch_size(10).tpu_cost().Register(
+        absl::Microseconds(20));
+    model_batch_stats.batch_size(50).tpu_cost().Register(
+        absl::Microseconds(60));
+    model_batch_stats.batch_size(100).tpu_cost().Register(
+        absl::Microseconds(150));
+    AdaptiveSharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 100;
+    queue_options.model_batch_stats = &model_batch_stats;
+    queue_options.name = "queue";
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, queue_callback, &queue));
+
+    TF_ASSERT_OK(ScheduleTask(100, queue.get()));
+    double in_flight_batches_limit = 2;
+    while (scheduler->in_flight_batches_limit() == in_flight_batches_limit) {
+    }
+    // The p99 latency missed the target -> fewer batches in flight.
+    EXPECT_LT(scheduler->in_flight_batches_limit(), in_flight_batches_limit);
+    in_flight_batches_limit = scheduler->in_flight_batches_limit();
+    EXPECT_EQ(batch_latency_p99_reader.Read("latency_target_test"), 150);
+    EXPECT_EQ(target_batch_size_reader.Read("latency_target_test", "queue"),
+              50);
+
+    TF_ASSERT_OK(ScheduleTask(50, queue.get()));
+    while (scheduler->in_flight_batches_limit() == in_flight_batches_limit) {
+    }
+    // The p99 latency met the target -> more batches in flight.
+    EXPECT_GT(scheduler->in_flight_batches_limit(), in_flight_batches_limit);
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 TEST(AdaptiveSharedBatchSchedulerTest, FullBatchSchedulingBoostMicros) {
   test_util::FakeClockEnv env(Env::Default());
   Notification start_teardown, stop_teardown;
@@ -37,6 +37,7 @@ limitations under the License.
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/cost_constants.h"
 #include "tensorflow/core/common_runtime/cost_measurement.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
@@ -51,6 +52,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/grappler/costs/measured_cost_store.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
 #include "tensorflow/core/kernels/batching_util/batch_stats.h"
@@ -69,6 +71,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
@@ -280,6 +283,19 @@ void RecordBatchCosts(const std::string& model_name,
       ->Add(absl::ToDoubleMicroseconds(total_cost));
 }
 
+// Tracks how long it took to run the warmup batch of each allowed batch size,
+// which for a freshly loaded model is dominated by its compilation.
+void RecordWarmupBatchLatencyUs(int64_t latency_us, const string& model_name,
+                                const string& op_name, int32_t batch_size) {
+  static auto* cell = monitoring::Gauge<int64_t, 3>::New(
+      "/tensorflow/serving/batching/warmup_batch_latency_us",
+      "Tracks the latency (in microseconds) of the warmup batch of each "
+      "allowed batch size by model_name (if available).",
+      "model_name", "op_name", "batch_size");
+  cell->GetCell(model_name, op_name, std::to_string(batch_size))
+      ->Set(latency_us);
+}
+
 const string& GetModelName(OpKernelContext* ctx) {
   static string* kModelNameUnset = new string("model_name_unset");
   if (!ctx->session_metadata()) return *kModelNameUnset;
@@ -298,6 +314,65 @@ int GetTotalTaskSize(
   return tasks_size;
 }
 
+// Flattens the first two dimensions of each of `tensors`, whose rows have the
+// length in dimension 1, and concatenates them into `values`. Sets
+// `row_splits` to the offsets of `num_rows` rows in `values`, where the rows
+// after those of `tensors` are empty padding. `prototype` gives the type and
+// the shape of the rows, and need not be in `tensors`.
+Status ConcatRaggedTensors(OpKernelContext* context,
+                           absl::Span<const Tensor> tensors,
+                           const Tensor& prototype, int64_t num_rows,
+                           Tensor* values, Tensor* row_splits) {
+  AllocatorAttributes host_attr;
+  host_attr.set_on_host(true);
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DT_INT64, TensorShape({num_rows + 1}), row_splits, host_attr));
+  auto splits = row_splits->vec<int64_t>();
+  splits(0) = 0;
+  int64_t row = 0;
+
+  std::vector<Tensor> flattened;
+  flattened.reserve(tensors.size());
+  for (const Tensor& tensor : tensors) {
+    if (tensor.dims() != prototype.dims()) {
+      return errors::InvalidArgument(
+          "Ragged batching inputs must have equal ranks, got ",
+          prototype.shape().DebugString(), " and ",
+          tensor.shape().DebugString());
+    }
+    const int64_t rows = tensor.dim_size(0);
+    const int64_t length = tensor.dim_size(1);
+    if (row + rows > num_rows) {
+      return errors::Internal("Ragged batch has more than ", num_rows,
+                              " rows");
+    }
+    for (int64_t i = 0; i < rows; ++i, ++row) {
+      splits(row + 1) = splits(row) + length;
+    }
+    TensorShape shape = tensor.shape();
+    shape.RemoveDim(0);
+    shape.set_dim(0, rows * length);
+    Tensor flat;
+    if (!flat.CopyFrom(tensor, shape)) {
+      return errors::Internal("Could not flatten ",
+                              tensor.shape().DebugString(), " to ",
+                              shape.DebugString());
+    }
+    flattened.push_back(std::move(flat));
+  }
+  for (; row < num_rows; ++row) {
+    splits(row + 1) = splits(row);
+  }
+
+  if (flattened.empty()) {
+    TensorShape shape = prototype.shape();
+    shape.RemoveDim(0);
+    shape.set_dim(0, 0);
+    return context->allocate_temp(prototype.dtype(), shape, values, host_attr);
+  }
+  return concat_split_util::Concat(context, flattened, values);
+}
+
 }  // namespace
 
 std::unique_ptr<BatchResourceBase::BatchTask>
@@ -353,15 +428,42 @@ Status BatchResourceBase::RegisterWarmupInputs(
   };
   auto warmup_counter =
       std::make_shared<absl::BlockingCounter>(allowed_batch_sizes_.size());
+  const string& model_name = GetModelName(context);
+  const string& op_name = context->op_kernel().name();
   // Enqueue warmup batches.
   for (int i = 0; i < allowed_batch_sizes_.size(); ++i) {
-    Status status = RegisterInput(
-        guid, context, batcher_queue_name, create_batch_task_fn_share_status,
-        [warmup_counter = warmup_counter.get()]() {
+    const int batch_size = allowed_batch_sizes_[i];
+    if (!has_process_batch_function_) {
+      Status status = RegisterInput(
+          guid, context, batcher_queue_name, create_batch_task_fn_share_status,
+          [warmup_counter = warmup_counter.get()]() {
+            warmup_counter->DecrementCount();
+          },
+          batch_size);
+      if (!status.ok()) return status;
+      continue;
+    }
+    // While the model is warming up the batcher queue admits one request at a
+    // time, so the warmup batches are run directly instead, all at once.
+    std::unique_ptr<BatchTask> task;
+    TF_RETURN_IF_ERROR(CreateBatchTask(
+        guid, context, create_batch_task_fn_share_status,
+        [warmup_counter = warmup_counter.get(), model_name, op_name,
+         batch_size, start_time_micros = EnvTime::NowMicros()]() {
+          RecordWarmupBatchLatencyUs(EnvTime::NowMicros() - start_time_micros,
+                                     model_name, op_name, batch_size);
           warmup_counter->DecrementCount();
         },
-        allowed_batch_sizes_[i]);
-    if (!status.ok()) return status;
+        batch_size, &task));
+    if (task == nullptr) continue;
+    auto batch = std::make_unique<BatchT>();
+    batch->AddTask(std::move(task));
+    batch->Close();
+    // `Schedule` takes a copyable closure, so the batch is passed unowned.
+    context->device()->tensorflow_cpu_worker_threads()->workers->Schedule(
+        [this, batch = batch.release()]() {
+          ProcessFuncBatch(std::unique_ptr<BatchT>(batch));
+        });
   }
   // Enqueue real batch if the other batches were enqueued successfully.
   return RegisterInput(
@@ -377,6 +479,42 @@ Status BatchResourceBase::RegisterInput(
     int64_t guid, OpKernelContext* context, const string& batcher_queue_name,
     const CreateBatchTaskFn& create_batch_task_fn,
     AsyncOpKernel::DoneCallback done_callback, int forced_warmup_batch_size) {
+  std::unique_ptr<BatchTask> batch_components;
+  TF_RETURN_IF_ERROR(CreateBatchTask(guid, context, create_batch_task_fn,
+                                     std::move(done_callback),
+                                     forced_warmup_batch_size,
+                                     &batch_components));
+  if (batch_components == nullptr) {
+    return absl::OkStatus();
+  }
+
+  BatcherQueueT* batcher_queue;
+  TF_RETURN_IF_ERROR(LookupOrCreateBatcherQueue(
+      /* queue_name= */ batcher_queue_name,
+      /* model_name= */ GetModelName(context),
+      /* op_name= */ context->op_kernel().name(), /* queue= */ &batcher_queue));
+
+  if (!session_metadata().name().empty()) {
+    absl::MutexLock lock(&outstanding_batch_mu_);
+    WarmupStateRegistry::Key key(session_metadata().name(),
+                                 session_metadata().version());
+    if (GetGlobalWarmupStateRegistry().Lookup(key)) {
+      outstanding_batch_mu_.Await({+[](int* num_outstanding_batched_items) {
+                                     return *num_outstanding_batched_items == 0;
+                                   },
+                                   &num_outstanding_batched_items_});
+    }
+    num_outstanding_batched_items_ += batch_components->size();
+  }
+
+  return batcher_queue->Schedule(&batch_components);
+}
+
+Status BatchResourceBase::CreateBatchTask(
+    int64_t guid, OpKernelContext* context,
+    const CreateBatchTaskFn& create_batch_task_fn,
+    AsyncOpKernel::DoneCallback done_callback, int forced_warmup_batch_size,
+    std::unique_ptr<BatchTask>* task) const {
   TF_ASSIGN_OR_RETURN(std::unique_ptr<BatchTask> batch_components,
                       create_batch_task_fn());
   batch_components->start_time = EnvTime::NowNanos();
@@ -484,26 +622,8 @@ Status BatchResourceBase::RegisterInput(
     batch_components->request_cost = request_cost_accessor->GetRequestCost();
   }
 
-  BatcherQueueT* batcher_queue;
-  TF_RETURN_IF_ERROR(LookupOrCreateBatcherQueue(
-      /* queue_name= */ batcher_queue_name,
-      /* model_name= */ GetModelName(context),
-      /* op_name= */ context->op_kernel().name(), /* queue= */ &batcher_queue));
-
-  if (!session_metadata().name().empty()) {
-    absl::MutexLock lock(&outstanding_batch_mu_);
-    WarmupStateRegistry::Key key(session_metadata().name(),
-                                 session_metadata().version());
-    if (GetGlobalWarmupStateRegistry().Lookup(key)) {
-      outstanding_batch_mu_.Await({+[](int* num_outstanding_batched_items) {
-                                     return *num_outstanding_batched_items == 0;
-                                   },
-                                   &num_outstanding_batched_items_});
-    }
-    num_outstanding_batched_items_ += batch_components->size();
-  }
-
-  return batcher_queue->Schedule(&batch_components);
+  *task = std::move(batch_components);
+  return absl::OkStatus();
 }
 
 /*static*/ BatchResourceBase::BatcherT::QueueOptions
@@ -709,6 +829,7 @@ Status BatchResourceBase::ConcatInputTensors(
   // All tasks should have the same number of input edges.
   const int num_inputs = batch.task(0).inputs.size();
   concatenated_tensors->reserve(num_inputs);
+  std::vector<Tensor> row_splits;
 
   // Process each input one at a time (the typical case has just one). When
   // `just_for_warmup` is true, the real data is not added. Otherwise, the real
@@ -729,6 +850,20 @@ Status BatchResourceBase::ConcatInputTensors(
       }
     }
 
+    // Ragged inputs are padded with empty rows, which add no values.
+    const Tensor& prototype = batch.task(0).inputs.at(i);
+    if (ragged_batching_ && has_process_batch_function_ &&
+        prototype.dims() >= 2) {
+      Tensor values;
+      Tensor splits;
+      TF_RETURN_IF_ERROR(ConcatRaggedTensors(context, to_concatenate,
+                                             prototype, padded_batch_size,
+                                             &values, &splits));
+      concatenated_tensors->push_back(std::move(values));
+      row_splits.push_back(std::move(splits));
+      continue;
+    }
+
     // Add padding as needed if padding is allowed. Use the first row of the
     // first task's tensor as the data for padding.
     if (padding_amount != 0) {
@@ -756,6 +891,8 @@ Status BatchResourceBase::ConcatInputTensors(
     TF_RETURN_IF_ERROR(concat_status);
     concatenated_tensors->push_back(concatenated_tensor);
   }
+  concatenated_tensors->insert(concatenated_tensors->end(), row_splits.begin(),
+                               row_splits.end());
   return absl::OkStatus();
 }
 
@@ -1254,14 +1391,17 @@ void BatchResourceBase::SplitBatchCostsAndRecordMetrics(
     const absl::string_view cost_type = batch_cost_measurement->GetCostType();
     const absl::Duration total_cost = batch_cost_measurement->GetTotalCost();
     batch_costs[cost_type] = total_cost;
+    const std::string cost_type_with_smear =
+        absl::StrCat(cost_type, kWithSmearSuffix);
+    const std::string cost_type_no_smear =
+        absl::StrCat(cost_type, kNoSmearSuffix);
 
     // Smeared batch cost: cost for processing this batch.
-    RecordBatchCosts(model_name, processed_size,
-                     absl::StrCat(cost_type, kWithSmearSuffix), total_cost);
+    RecordBatchCosts(model_name, processed_size, cost_type_with_smear,
+                     total_cost);
     // Non-smeared batch cost: cost for processing inputs in this batch, i.e.
     // cost for processing paddings is excluded.
-    RecordBatchCosts(model_name, processed_size,
-                     absl::StrCat(cost_type, kNoSmearSuffix),
+    RecordBatchCosts(model_name, processed_size, cost_type_no_smear,
                      total_cost / processed_size * batch.size());
 
     // Register batch stats for in-process use.
@@ -1271,8 +1411,15 @@ void BatchResourceBase::SplitBatchCostsAndRecordMetrics(
       model_stats.batch_size(processed_size).tpu_cost().Register(total_cost);
       // batch.size() is the size of the original batch before padding.
       model_stats.RegisterProcessedSize(batch.size());
+      // Feed grappler's cost estimates for the next optimization of the
+      // graph with the cost of one invocation of the batch op.
+      grappler::MeasuredCostStore::Global().RecordCost(
+          model_name, op_name, total_cost / batch.num_tasks());
     }
 
+    // The breakdown of the cost by op, computed for the first task that
+    // records op costs.
+    std::optional<absl::flat_hash_map<std::string, absl::Duration>> op_costs;
     for (int i = 0; i < batch.num_tasks(); i++) {
       RequestCost* request_cost = batch.task(i).request_cost;
       // Skip recording the cost if the request_cost is null.
@@ -1286,9 +1433,26 @@ void BatchResourceBase::SplitBatchCostsAndRecordMetrics(
       const auto cost_no_smear =
           total_cost / processed_size * batch.task(i).size();
 
-      request_cost->RecordCost(
-          {{absl::StrCat(cost_type, kWithSmearSuffix), cost_with_smear},
-           {absl::StrCat(cost_type, kNoSmearSuffix), cost_no_smear}});
+      request_cost->RecordCost({{cost_type_with_smear, cost_with_smear},
+                                {cost_type_no_smear, cost_no_smear}});
+
+      // Op costs, for the requests they are sampled for, are split the same
+      // way. The batched function is attributed the whole cost.
+      if (!request_cost->record_op_costs()) continue;
+      if (!op_costs.has_value()) {
+        op_costs = batch_cost_measurement->GetOpCosts();
+      }
+      request_cost->RecordOpCost(op_name,
+                                 {{cost_type_with_smear, cost_with_smear},
+                                  {cost_type_no_smear, cost_no_smear}});
+      for (const auto& [cost_op_name, op_cost] : *op_costs) {
+        request_cost->RecordOpCost(
+            cost_op_name,
+            {{cost_type_with_smear,
+              op_cost / batch.size() * batch.task(i).size()},
+             {cost_type_no_smear,
+              op_cost / processed_size * batch.task(i).size()}});
+      }
     }
   }
 
@@ -186,11 +186,23 @@ class BatchResourceBase : public ResourceBase {
 
   const SessionMetadata& session_metadata() const { return session_metadata_; }
 
+  // With ragged batching, the batched inputs of rank 2 or more may differ in
+  // dimension 1, which holds the length of each of their rows. The rows of
+  // each such input are flattened and concatenated into values with shape
+  // [total_length, ...], and the function is passed, after all the batched
+  // inputs, one int64 tensor of row splits with shape [batch_size + 1] for
+  // each of them. Padding rows are empty, so they add no values.
+  void set_ragged_batching(bool ragged_batching) {
+    ragged_batching_ = ragged_batching;
+  }
+
   using CreateBatchTaskFn =
       std::function<StatusOr<std::unique_ptr<BatchTask>>()>;
 
   // Like `RegisterInput`, but extra "dummy" batches are processed for each
   // batch size. Only the real request's outputs are propagated to the caller.
+  // When a batch function is set, the dummy batches bypass the batcher queue
+  // and are run concurrently, so that all batch sizes are compiled at once.
   Status RegisterWarmupInputs(int64_t guid, OpKernelContext* context,
                               const string& batcher_queue_name,
                               const CreateBatchTaskFn& create_batch_task_fn,
@@ -263,6 +275,10 @@ class BatchResourceBase : public ResourceBase {
   //      and paddings do not share any cost;
   //   2) non-smeared cost: batch cost is split proportionally to each task or
   //      padding's size. Here padding's cost is not assigned to any tasks.
+  // - For the tasks whose request_cost records op costs, both costs are also
+  //   recorded as the cost of the batch op, i.e. of the batched function, and
+  //   the per-op breakdown of the batch costs, if the measurements provide
+  //   one, is split the same way.
   // - This function will also record the metrics of this batch in each task,
   //   including:
   //   1) the batch size;
@@ -301,7 +317,8 @@ class BatchResourceBase : public ResourceBase {
 
   // Concatenates the input tensors of the tasks from the batch and the
   // unbatched task vector. When padding is enabled in the batcher queue, they
-  // are padded with garbage value up to the nearest allowed batch size.
+  // are padded with garbage value up to the nearest allowed batch size. With
+  // ragged batching, ragged inputs are followed by their row splits instead.
   Status ConcatInputTensors(
       const BatchT& batch,
       const std::vector<std::unique_ptr<BatchTask>>& unbatched_tasks,
@@ -316,6 +333,15 @@ class BatchResourceBase : public ResourceBase {
       std::unique_ptr<BatchT> batch,
       std::vector<std::unique_ptr<BatchTask>> unbatched_tasks = {}) const;
 
+  // Builds the task for one invocation of the batch op from `context`'s
+  // inputs. For an empty input the outputs are emitted right away,
+  // `done_callback` is called and `*task` is set to null.
+  Status CreateBatchTask(int64_t guid, OpKernelContext* context,
+                         const CreateBatchTaskFn& create_batch_task_fn,
+                         AsyncOpKernel::DoneCallback done_callback,
+                         int forced_warmup_batch_size,
+                         std::unique_ptr<BatchTask>* task) const;
+
   // Processes a batch of one or more BatchTask entries.
   void ProcessBatch(std::unique_ptr<BatchT> batch) const;
 
@@ -353,6 +379,9 @@ class BatchResourceBase : public ResourceBase {
 
   // True if user specified a batch processing function for this resource.
   const bool has_process_batch_function_;
+  // True if inputs of the batch processing function are batched as ragged
+  // tensors; see `set_ragged_batching`.
+  bool ragged_batching_ = false;
   // A batch scheduler, and options for creating queues.
   std::shared_ptr<BatcherT> batcher_;
   BatcherT::QueueOptions batcher_queue_options_;
@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/costs/measured_cost_store.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
 #include "tensorflow/core/kernels/batching_util/batch_stats.h"
@@ -128,6 +129,19 @@ class TestGcuCostMeasurement : public CostMeasurement {
 };
 REGISTER_COST_MEASUREMENT("test_gcu", TestGcuCostMeasurement);
 
+class TestCpuOpsCostMeasurement : public CostMeasurement {
+ public:
+  using CostMeasurement::CostMeasurement;
+
+  absl::Duration GetTotalCost() override { return absl::Milliseconds(100); }
+  absl::string_view GetCostType() const override { return "test_cpu"; }
+  absl::flat_hash_map<std::string, absl::Duration> GetOpCosts() override {
+    return {{"MatMul", absl::Milliseconds(60)},
+            {"Relu", absl::Milliseconds(20)}};
+  }
+};
+REGISTER_COST_MEASUREMENT("test_cpu_ops", TestCpuOpsCostMeasurement);
+
 std::unique_ptr<BatchResourceBase::BatchTask> MakeBatchTask(
     const int64_t task_size, RequestCost* request_cost) {
   auto task = std::make_unique<BatchResourceBase::BatchTask>();
@@ -321,6 +335,49 @@ TEST(SplitBatchCostsAndRecordMetricsTest, SplitOnlyNonZeroCostTypes) {
           UnorderedElementsAre(Pair("test_tpu", absl::Milliseconds(100))))));
 }
 
+TEST(SplitBatchCostsAndRecordMetricsTest, SplitOpCostsOfSampledRequests) {
+  BatchResourceBase::BatchT batch;
+  RequestCost cost1, cost2;
+  cost2.set_record_op_costs(true);
+  batch.AddTask(MakeBatchTask(/*task_size=*/1, &cost1));
+  batch.AddTask(MakeBatchTask(/*task_size=*/9, &cost2));
+  batch.Close();
+
+  CostMeasurement::Context context{/*is_per_query=*/false};
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements;
+  batch_cost_measurements.push_back(
+      CostMeasurementRegistry::CreateByNameOrNull("test_cpu_ops", context));
+  BatchResourceBase::SplitBatchCostsAndRecordMetrics(
+      "model_name", "op_name", batch_cost_measurements, /*processed_size=*/20,
+      batch);
+
+  EXPECT_THAT(
+      batch.task(0).request_cost->GetCosts(),
+      UnorderedElementsAre(Pair("test_cpu_with_smear", absl::Milliseconds(10)),
+                           Pair("test_cpu_no_smear", absl::Milliseconds(5))));
+  EXPECT_TRUE(batch.task(0).request_cost->GetOpCosts().empty());
+
+  EXPECT_THAT(
+      batch.task(1).request_cost->GetCosts(),
+      UnorderedElementsAre(Pair("test_cpu_with_smear", absl::Milliseconds(90)),
+                           Pair("test_cpu_no_smear", absl::Milliseconds(45))));
+  EXPECT_THAT(
+      batch.task(1).request_cost->GetOpCosts(),
+      UnorderedElementsAre(
+          Pair("op_name",
+               UnorderedElementsAre(
+                   Pair("test_cpu_with_smear", absl::Milliseconds(90)),
+                   Pair("test_cpu_no_smear", absl::Milliseconds(45)))),
+          Pair("MatMul",
+               UnorderedElementsAre(
+                   Pair("test_cpu_with_smear", absl::Milliseconds(54)),
+                   Pair("test_cpu_no_smear", absl::Milliseconds(27)))),
+          Pair("Relu",
+               UnorderedElementsAre(
+                   Pair("test_cpu_with_smear", absl::Milliseconds(18)),
+                   Pair("test_cpu_no_smear", absl::Milliseconds(9))))));
+}
+
 TEST(SplitBatchCostsAndRecordMetricsTest, UpdatesGlobalBatchStats) {
   // Create batch_cost_measurements with one TPU cost.
   class FakeTpuCostMeasurement : public CostMeasurement {
@@ -357,6 +414,36 @@ TEST(SplitBatchCostsAndRecordMetricsTest, UpdatesGlobalBatchStats) {
             absl::Hours(555));
 }
 
+TEST(SplitBatchCostsAndRecordMetricsTest, UpdatesMeasuredCostStore) {
+  class FakeTpuCostMeasurement : public CostMeasurement {
+   public:
+    using CostMeasurement::CostMeasurement;
+    absl::Duration GetTotalCost() override { return absl::Milliseconds(30); }
+    absl::string_view GetCostType() const override { return kTpuCostName; }
+  };
+  CostMeasurement::Context context{/* is_per_query= */ false};
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements;
+  batch_cost_measurements.push_back(
+      std::make_unique<FakeTpuCostMeasurement>(context));
+
+  BatchResourceBase::BatchT batch;
+  batch.AddTask(MakeBatchTask(/* task_size= */ 1, nullptr));
+  batch.AddTask(MakeBatchTask(/* task_size= */ 2, nullptr));
+  batch.Close();
+
+  // Pick an op name that no other test would pick.
+  const char kOpName[] = "test_updates_measured_cost_store";
+
+  BatchResourceBase::SplitBatchCostsAndRecordMetrics(
+      /* model_name= */ "model_name", /* op_name= */ kOpName,
+      batch_cost_measurements, /* processed_size= */ 4, batch);
+
+  // The batch cost is split over the two invocations of the op.
+  EXPECT_EQ(
+      grappler::MeasuredCostStore::Global().GetCost("model_name", kOpName),
+      absl::Milliseconds(15));
+}
+
 TEST(SplitBatchCostsAndRecordMetricsTest, GlobalBatchStatsProcessedSize) {
   // Create batch_cost_measurements with one TPU cost.
   class FakeTpuCostMeasurement : public CostMeasurement {
@@ -91,6 +91,11 @@ class BatchTask {
   virtual tsl::criticality::Criticality criticality() const {
     return tsl::criticality::Criticality::kCritical;
   }
+
+  // Returns the time, in microseconds of the scheduler's Env clock, by which
+  // the task should finish executing. A scheduler may close a batch early to
+  // meet it. Defaults to no deadline.
+  virtual std::optional<uint64> deadline_micros() const { return std::nullopt; }
 };
 
 // A thread-safe collection of BatchTasks. Tasks can be either added or removed
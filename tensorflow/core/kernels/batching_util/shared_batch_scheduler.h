@@ -25,6 +25,7 @@ limitations under the License.
 #include <functional>
 #include <list>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -32,6 +33,7 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "tensorflow/core/kernels/batching_util/batch_input_task.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
@@ -266,6 +268,13 @@ class SharedBatchScheduler
     // effective only when enable_priority_queue is true.
     MixedPriorityBatchingPolicy mixed_priority_batching_policy =
         MixedPriorityBatchingPolicy::kLowPriorityPaddingWithMaxBatchSize;
+
+    // If true, the open batch is also closed, ahead of `batch_timeout_micros`,
+    // once the earliest deadline among its tasks (see
+    // BatchTask::deadline_micros()) leaves less slack than the batch is
+    // predicted to take to execute. The prediction is the mean cost recorded
+    // in `model_batch_stats` for the padded batch size, or zero without one.
+    bool enable_deadline_aware_batch_closing = false;
   };
   // This method is marked virtual for testing purposes only.
   virtual Status AddQueue(const QueueOptions& options,
@@ -456,6 +465,14 @@ class Queue {
   // 'high_priority_batches_' is currently schedulable.
   bool IsOpenBatchSchedulable() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Determines whether the open batch has to be closed now for its earliest
+  // task deadline to be met. Always false unless
+  // `enable_deadline_aware_batch_closing` is set.
+  bool IsOpenBatchNearDeadline() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the deadline of the task, if it has one.
+  static std::optional<uint64> TaskDeadlineMicros(const TaskType& task);
+
   // Determines whether the low priority tasks in `low_priority_tasks_` can form
   // a batch on their own. If yes, returns a batch that is ready to be
   // processed. Otherwise, returns an empty unique_ptr.
@@ -560,6 +577,13 @@ class Queue {
   // might contain an approximate value.
   uint64 open_batch_start_time_micros_ TF_GUARDED_BY(mu_);
 
+  // The earliest deadline among the tasks in the open batch, if any has one.
+  //
+  // After a batch is trimmed by a padding policy, the tasks left in the open
+  // batch keep the deadline of the original batch, which is never later than
+  // their own.
+  std::optional<uint64> open_batch_deadline_micros_ TF_GUARDED_BY(mu_);
+
   // Whether this queue contains a batch that is eligible to be scheduled.
   // Used to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ TF_GUARDED_BY(mu_) = false;
@@ -869,6 +893,7 @@ Status Queue<TaskType>::ScheduleWithoutOrEagerSplitImpl(
       max_execution_batch_size() - batches.back()->size();
 
   const int64_t input_task_size = (*task)->size();
+  const std::optional<uint64> deadline_micros = TaskDeadlineMicros(**task);
 
   std::vector<std::unique_ptr<TaskType>> output_tasks;
 
@@ -887,6 +912,12 @@ Status Queue<TaskType>::ScheduleWithoutOrEagerSplitImpl(
     }
     if (batches.back()->empty()) {
       open_batch_start_time_micros_ = env_->NowMicros();
+      open_batch_deadline_micros_.reset();
+    }
+    if (deadline_micros.has_value() &&
+        (!open_batch_deadline_micros_.has_value() ||
+         *deadline_micros < *open_batch_deadline_micros_)) {
+      open_batch_deadline_micros_ = deadline_micros;
     }
     tsl::profiler::TraceMeProducer trace_me(
         [&output_tasks, i] {
@@ -1255,7 +1286,42 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   }
   return closed_ || open_batch->size() >= max_execution_batch_size() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + options_.batch_timeout_micros ||
+         IsOpenBatchNearDeadline();
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsOpenBatchNearDeadline() const {
+  if (!options_.enable_deadline_aware_batch_closing ||
+      !open_batch_deadline_micros_.has_value()) {
+    return false;
+  }
+  int64_t predicted_cost_micros = 0;
+  if (options_.model_batch_stats != nullptr) {
+    const int padded_batch_size = GetNextAllowedBatchSize(
+        GetBatches().back()->size(), options_.allowed_batch_sizes,
+        options_.disable_padding);
+    std::optional<absl::Duration> cost = options_.model_batch_stats
+                                             ->batch_size(padded_batch_size)
+                                             .tpu_cost()
+                                             .mean();
+    if (cost.has_value()) {
+      predicted_cost_micros = absl::ToInt64Microseconds(*cost);
+    }
+  }
+  return env_->NowMicros() + predicted_cost_micros >=
+         *open_batch_deadline_micros_;
+}
+
+template <typename TaskType>
+std::optional<uint64> Queue<TaskType>::TaskDeadlineMicros(
+    const TaskType& task) {
+  // The deadline is defined only when the task is a derived class of
+  // BatchTask.
+  if constexpr (std::is_base_of_v<BatchTask, TaskType>) {
+    return task.deadline_micros();
+  }
+  return std::nullopt;
 }
 
 template <typename TaskType>
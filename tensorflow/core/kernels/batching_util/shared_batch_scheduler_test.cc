@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <tuple>
@@ -31,6 +32,7 @@ limitations under the License.
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
+#include "tensorflow/core/kernels/batching_util/batch_stats.h"
 #include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -53,9 +55,13 @@ using ::testing::HasSubstr;
 
 class FakeTask : public BatchTask {
  public:
-  explicit FakeTask(size_t size, tsl::criticality::Criticality criticality =
-                                     tsl::criticality::Criticality::kCritical)
-      : size_(size), criticality_(criticality) {}
+  explicit FakeTask(size_t size,
+                    tsl::criticality::Criticality criticality =
+                        tsl::criticality::Criticality::kCritical,
+                    std::optional<uint64> deadline_micros = std::nullopt)
+      : size_(size),
+        criticality_(criticality),
+        deadline_micros_(deadline_micros) {}
 
   ~FakeTask() override = default;
 
@@ -65,9 +71,14 @@ class FakeTask : public BatchTask {
     return criticality_;
   }
 
+  std::optional<uint64> deadline_micros() const override {
+    return deadline_micros_;
+  }
+
  private:
   const size_t size_;
   const tsl::criticality::Criticality criticality_;
+  const std::optional<uint64> deadline_micros_;
 
   FakeTask(const FakeTask&) = delete;
   void operator=(const FakeTask&) = delete;
@@ -1089,6 +1100,57 @@ TEST_P(SharedBatchSchedulerTest, BatchPaddingPolicyBatchDown) {
   stop_teardown.Notify();
 }
 
+TEST_P(SharedBatchSchedulerTest, ClosesBatchAheadOfTaskDeadline) {
+  // Set up a fake clock, which only advances when we explicitly tell it to.
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification batch_processed;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      EXPECT_EQ(batch->size(), 2);
+      batch_processed.Notify();
+    };
+
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+
+    QueueOptions options =
+        CreateQueueOptions(/* max_execution_batch_size= */ 10,
+                           /* input_batch_size_limit= */ 10,
+                           /* batch_timeout_micros= */ 1000,
+                           /* max_enqueued_batches= */ 10);
+    options.allowed_batch_sizes = {1, 2, 4, 8};
+    options.enable_deadline_aware_batch_closing = true;
+    // A padded batch of 2 is predicted to take 5 microseconds.
+    ModelBatchStats model_batch_stats;
+    model_batch_stats.batch_size(2).tpu_cost().Register(absl::Microseconds(5));
+    options.model_batch_stats = &model_batch_stats;
+
+    auto queue = CreateQueue(scheduler, options, callback);
+
+    // The second task's deadline, not the first one's, is the earliest, so it
+    // decides when the batch closes: 5 microseconds before the deadline.
+    const uint64 now_micros = env.NowMicros();
+    std::unique_ptr<FakeTask> task = std::make_unique<FakeTask>(
+        1, tsl::criticality::Criticality::kCritical, now_micros + 100);
+    TF_ASSERT_OK(queue->Schedule(&task));
+    task = std::make_unique<FakeTask>(
+        1, tsl::criticality::Criticality::kCritical, now_micros + 20);
+    TF_ASSERT_OK(queue->Schedule(&task));
+
+    env.AdvanceByMicroseconds(14);
+    EXPECT_FALSE(
+        batch_processed.WaitForNotificationWithTimeout(absl::Milliseconds(10)));
+    env.AdvanceByMicroseconds(1);
+    batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 // TODO(b/161857471):
 // Add test coverage when input-split and no-split returns differently.
 INSTANTIATE_TEST_SUITE_P(Parameter, SharedBatchSchedulerTest,
@@ -0,0 +1,159 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_CAST_OP_FLOAT8_H_
+#define TENSORFLOW_CORE_KERNELS_CAST_OP_FLOAT8_H_
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#define EIGEN_USE_THREADS
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/cast_op.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Casts to and from float8 on the CPU can look their results up in tables,
+// which are filled once with the scalar casts of Eigen and so give exactly
+// the same results, including the rounding and the handling of overflows,
+// NaNs and subnormals.
+//
+// A one-byte input indexes a table of all its 256 results. A float input is
+// looked up by its upper 16 bits, which leave at least 4 more mantissa bits
+// than float8 has, and by whether its lower 16 bits are zero. Every value
+// strictly between two such upper halves rounds the same way, since the
+// values that decide the rounding all have zero lower halves.
+
+template <typename T>
+constexpr bool IsFloat8() {
+  return std::is_same<T, float8_e5m2>::value ||
+         std::is_same<T, float8_e4m3fn>::value;
+}
+
+// Returns the results of casting each of the 256 values of the one-byte type
+// `Tin` to `Tout`.
+template <typename Tout, typename Tin>
+const std::array<Tout, 256>& ByteCastTable() {
+  static_assert(sizeof(Tin) == 1, "The input type must be one byte");
+  static const auto* table = []() {
+    auto* table = new std::array<Tout, 256>;
+    for (int i = 0; i < 256; ++i) {
+      (*table)[i] = Eigen::internal::scalar_cast_op<Tin, Tout>()(
+          Eigen::numext::bit_cast<Tin>(static_cast<uint8_t>(i)));
+    }
+    return table;
+  }();
+  return *table;
+}
+
+// Returns the bits of the results of casting floats to the float8 type
+// `Tout`, at the index that `FloatCastTableIndex()` gives. There are 3 bytes
+// of padding at the end, so that the table can be gathered 4 bytes at a time.
+template <typename Tout>
+const uint8_t* FloatCastTable() {
+  static const uint8_t* table = []() {
+    auto* table = new uint8_t[(2 << 16) + 3]();
+    for (uint32_t upper = 0; upper < (1 << 16); ++upper) {
+      for (uint32_t lower : {0, 1}) {
+        const float value = Eigen::numext::bit_cast<float>(
+            upper << 16 | (lower == 0 ? 0 : 0x8000));
+        table[2 * upper + lower] = Eigen::numext::bit_cast<uint8_t>(
+            Eigen::internal::scalar_cast_op<float, Tout>()(value));
+      }
+    }
+    return table;
+  }();
+  return table;
+}
+
+inline uint32_t FloatCastTableIndex(uint32_t bits) {
+  return (bits >> 15 & ~uint32_t{1}) | ((bits & 0xFFFF) != 0);
+}
+
+// Casts `in[begin, end)` from float to the float8 type whose table is
+// `table`.
+inline void CastFloatWithTable(const uint8_t* table, const float* in,
+                               uint8_t* out, int64_t begin, int64_t end) {
+  int64_t i = begin;
+#ifdef EIGEN_VECTORIZE_AVX2
+  const __m256i lower_mask = _mm256_set1_epi32(0xFFFF);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+  for (; i + 8 <= end; i += 8) {
+    const __m256i bits =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    const __m256i upper = _mm256_srli_epi32(bits, 16);
+    const __m256i lower_is_zero = _mm256_cmpeq_epi32(
+        _mm256_and_si256(bits, lower_mask), _mm256_setzero_si256());
+    const __m256i index =
+        _mm256_or_si256(_mm256_add_epi32(upper, upper),
+                        _mm256_andnot_si256(lower_is_zero, one));
+    const __m256i results = _mm256_and_si256(
+        _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), index, 1),
+        byte_mask);
+    const __m128i words =
+        _mm_packus_epi32(_mm256_castsi256_si128(results),
+                         _mm256_extracti128_si256(results, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packus_epi16(words, words));
+  }
+#endif
+  for (; i < end; ++i) {
+    out[i] =
+        table[FloatCastTableIndex(Eigen::numext::bit_cast<uint32_t>(in[i]))];
+  }
+}
+
+// Casts `in` to `out` with the tables above. Either `Tin` is one byte, or it
+// is float or bfloat16 and `Tout` is a float8 type.
+template <typename Tout, typename Tin>
+void CastWithTable(const Eigen::ThreadPoolDevice& d,
+                   typename TTypes<Tout>::Flat out,
+                   typename TTypes<Tin>::ConstFlat in) {
+  const Eigen::TensorOpCost cost(sizeof(Tin), sizeof(Tout), 1);
+  if constexpr (sizeof(Tin) == 1) {
+    const std::array<Tout, 256>& table = ByteCastTable<Tout, Tin>();
+    d.parallelFor(in.size(), cost, [&](Eigen::Index begin, Eigen::Index end) {
+      for (Eigen::Index i = begin; i < end; ++i) {
+        out(i) = table[Eigen::numext::bit_cast<uint8_t>(in(i))];
+      }
+    });
+  } else {
+    static_assert(IsFloat8<Tout>(), "The output type must be float8");
+    const uint8_t* table = FloatCastTable<Tout>();
+    uint8_t* out_bits = reinterpret_cast<uint8_t*>(out.data());
+    d.parallelFor(in.size(), cost, [&](Eigen::Index begin, Eigen::Index end) {
+      if constexpr (std::is_same<Tin, float>::value) {
+        CastFloatWithTable(table, in.data(), out_bits, begin, end);
+      } else {
+        static_assert(std::is_same<Tin, bfloat16>::value,
+                      "The input type must be float or bfloat16");
+        // A bfloat16 is the upper half of a float whose lower half is zero.
+        for (Eigen::Index i = begin; i < end; ++i) {
+          out_bits[i] = table[2 * Eigen::numext::bit_cast<uint16_t>(in(i))];
+        }
+      }
+    });
+  }
+}
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CAST_OP_FLOAT8_H_
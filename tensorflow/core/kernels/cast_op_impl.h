@@ -26,6 +26,7 @@ limitations under the License.
 #include "tsl/platform/status.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/cast_op.h"
+#include "tensorflow/core/kernels/cast_op_float8.h"
 
 namespace tensorflow {
 
@@ -99,6 +100,23 @@ CAST_FUNCTORS(Eigen::ThreadPoolDevice);
     };                                                                    \
   }
 
+// Like CAST_CASE, for the float8 casts that CastWithTable() makes on the CPU.
+// Casts that truncate their input first still use the CastFunctor.
+#define CPU_TABLE_CAST_CASE(DEVICE, IN, OUT)                                \
+  if (DataTypeToEnum<OUT>::value == dst_dtype) {                           \
+    return [](OpKernelContext* ctx, const Tensor& inp, Tensor* out,        \
+              bool truncate) {                                             \
+      if (truncate) {                                                      \
+        functor::CastFunctor<DEVICE, OUT, IN> func;                        \
+        func(ctx->eigen_device<DEVICE>(), out->flat<OUT>(), inp.flat<IN>(), \
+             truncate);                                                    \
+      } else {                                                             \
+        functor::CastWithTable<OUT, IN>(ctx->eigen_device<DEVICE>(),       \
+                                        out->flat<OUT>(), inp.flat<IN>()); \
+      }                                                                    \
+    };                                                                     \
+  }
+
 // The functions below are implemented in the cast_op_impl_*.cc files.
 CastFunctorType GetCpuCastFromBool(DataType dst_dtype);
 
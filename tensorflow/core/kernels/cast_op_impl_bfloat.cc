@@ -24,8 +24,8 @@ typedef Eigen::GpuDevice GPUDevice;
 
 CastFunctorType GetCpuCastFromBfloat(DataType dst_dtype) {
   CURRY_TYPES3(CAST_CASE, CPUDevice, bfloat16);
-  CAST_CASE(CPUDevice, bfloat16, float8_e5m2);
-  CAST_CASE(CPUDevice, bfloat16, float8_e4m3fn);
+  CPU_TABLE_CAST_CASE(CPUDevice, bfloat16, float8_e5m2);
+  CPU_TABLE_CAST_CASE(CPUDevice, bfloat16, float8_e4m3fn);
   return nullptr;
 }
 
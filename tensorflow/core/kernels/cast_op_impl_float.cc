@@ -24,8 +24,8 @@ typedef Eigen::GpuDevice GPUDevice;
 
 CastFunctorType GetCpuCastFromFloat(DataType dst_dtype) {
   CURRY_TYPES3(CAST_CASE, CPUDevice, float);
-  CAST_CASE(CPUDevice, float, float8_e5m2);
-  CAST_CASE(CPUDevice, float, float8_e4m3fn);
+  CPU_TABLE_CAST_CASE(CPUDevice, float, float8_e5m2);
+  CPU_TABLE_CAST_CASE(CPUDevice, float, float8_e4m3fn);
   return nullptr;
 }
 
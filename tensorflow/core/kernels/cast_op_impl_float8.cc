@@ -23,15 +23,15 @@ typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
 CastFunctorType GetCpuCastFromFloat8e5m2(DataType dst_dtype) {
-  CURRY_TYPES3(CAST_CASE, CPUDevice, float8_e5m2);
+  CURRY_TYPES3(CPU_TABLE_CAST_CASE, CPUDevice, float8_e5m2);
   CAST_CASE(CPUDevice, float8_e5m2, float8_e5m2);
-  CAST_CASE(CPUDevice, float8_e5m2, float8_e4m3fn);
+  CPU_TABLE_CAST_CASE(CPUDevice, float8_e5m2, float8_e4m3fn);
   return nullptr;
 }
 
 CastFunctorType GetCpuCastFromFloat8e4m3fn(DataType dst_dtype) {
-  CURRY_TYPES3(CAST_CASE, CPUDevice, float8_e4m3fn);
-  CAST_CASE(CPUDevice, float8_e4m3fn, float8_e5m2);
+  CURRY_TYPES3(CPU_TABLE_CAST_CASE, CPUDevice, float8_e4m3fn);
+  CPU_TABLE_CAST_CASE(CPUDevice, float8_e4m3fn, float8_e5m2);
   CAST_CASE(CPUDevice, float8_e4m3fn, float8_e4m3fn);
   return nullptr;
 }
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 #include <cstdint>
+#include <type_traits>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -38,7 +40,19 @@ static Graph* Cast(int num) {
   Graph* g = new Graph(OpRegistry::Global());
   Tensor data(DataTypeToEnum<Src>::value,
               TensorShape({64, 64, num / (64 * 64)}));
-  data.flat<Src>().setRandom();
+  if constexpr (std::is_same<Src, int4>::value ||
+                std::is_same<Src, uint4>::value) {
+    Tensor bytes(DT_INT8, data.shape());
+    bytes.flat<int8>().setRandom();
+    data.flat<Src>() = bytes.flat<int8>().template cast<Src>();
+  } else if constexpr (std::is_same<Src, float8_e5m2>::value ||
+                       std::is_same<Src, float8_e4m3fn>::value) {
+    Tensor floats(DT_FLOAT, data.shape());
+    floats.flat<float>().setRandom();
+    data.flat<Src>() = floats.flat<float>().template cast<Src>();
+  } else {
+    data.flat<Src>().setRandom();
+  }
   test::graph::Cast(g, test::graph::Constant(g, data),
                     DataTypeToEnum<Dst>::value);
   return g;
@@ -78,8 +92,67 @@ class CastOpTest : public OpsTestBase {
                              {OUTPUT(1), OUTPUT(2), OUTPUT(3), OUTPUT(4)});
     test::ExpectTensorEqual<OUTPUT>(expected, *GetOutput(0));
   }
+
+  // Checks that the kernel casts `inputs` to the same bits as Eigen.
+  template <typename INPUT, typename OUTPUT>
+  void CheckCastMatchesEigen(const std::vector<INPUT>& inputs) {
+    MakeOp(DataTypeToEnum<INPUT>::v(), DataTypeToEnum<OUTPUT>::v(), false);
+    AddInputFromArray<INPUT>(TensorShape({static_cast<int64_t>(inputs.size())}),
+                             inputs);
+    TF_ASSERT_OK(RunOpKernel());
+    Tensor expected(allocator(), DataTypeToEnum<OUTPUT>::v(),
+                    TensorShape({static_cast<int64_t>(inputs.size())}));
+    expected.flat<OUTPUT>() =
+        GetInput(0).flat<INPUT>().template cast<OUTPUT>();
+    EXPECT_EQ(GetOutput(0)->tensor_data(), expected.tensor_data());
+  }
 };
 
+// Returns every value of a one- or two-byte type, and for floats every upper
+// half with lower halves around the rounding points of float8.
+template <typename T>
+std::vector<T> Float8CastInputs() {
+  std::vector<T> inputs;
+  if constexpr (std::is_same<T, float>::value) {
+    for (uint32_t upper = 0; upper < (1 << 16); ++upper) {
+      for (uint32_t lower : {0x0, 0x1, 0x7FFF, 0x8000, 0x8001, 0xFFFF}) {
+        inputs.push_back(
+            Eigen::numext::bit_cast<float>(upper << 16 | lower));
+      }
+    }
+  } else {
+    using Bits = std::conditional_t<sizeof(T) == 1, uint8_t, uint16_t>;
+    for (uint32_t bits = 0; bits < (1 << (8 * sizeof(T))); ++bits) {
+      inputs.push_back(Eigen::numext::bit_cast<T>(static_cast<Bits>(bits)));
+    }
+  }
+  return inputs;
+}
+
+#define TEST_FLOAT8_CAST(in, out)                           \
+  TEST_F(CastOpTest, TestFloat8Cast##_##in##_##out) {       \
+    CheckCastMatchesEigen<in, out>(Float8CastInputs<in>()); \
+  }
+
+TEST_FLOAT8_CAST(float, float8_e5m2)
+TEST_FLOAT8_CAST(float, float8_e4m3fn)
+TEST_FLOAT8_CAST(bfloat16, float8_e5m2)
+TEST_FLOAT8_CAST(bfloat16, float8_e4m3fn)
+TEST_FLOAT8_CAST(float8_e5m2, float)
+TEST_FLOAT8_CAST(float8_e5m2, double)
+TEST_FLOAT8_CAST(float8_e5m2, half)
+TEST_FLOAT8_CAST(float8_e5m2, bfloat16)
+TEST_FLOAT8_CAST(float8_e5m2, int32)
+TEST_FLOAT8_CAST(float8_e5m2, float8_e4m3fn)
+TEST_FLOAT8_CAST(float8_e4m3fn, float)
+TEST_FLOAT8_CAST(float8_e4m3fn, double)
+TEST_FLOAT8_CAST(float8_e4m3fn, half)
+TEST_FLOAT8_CAST(float8_e4m3fn, bfloat16)
+TEST_FLOAT8_CAST(float8_e4m3fn, int32)
+TEST_FLOAT8_CAST(float8_e4m3fn, float8_e5m2)
+
+#undef TEST_FLOAT8_CAST
+
 #define TEST_CAST(in, out)                                                   \
   TEST_F(CastOpTest, TestCast##_##in##_##out) { CheckCast<in, out>(false); } \
   TEST_F(CastOpTest, TestCastTruncate_##_##in##_##out) {                     \
@@ -281,4 +354,31 @@ static void BM_gpu_half_float(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_gpu_half_float)->UseRealTime()->Arg(64 << 10)->Arg(32 << 20);
 
+#define BM_CPU_CAST(src, dst)                                                 \
+  static void BM_cpu_##src##_##dst(::testing::benchmark::State& state) {      \
+    const int num = state.range(0);                                           \
+    test::Benchmark("cpu", Cast<src, dst>(num), /*old_benchmark_api=*/false)  \
+        .Run(state);                                                          \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * num);  \
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * num *  \
+                            (sizeof(src) + sizeof(dst)));                     \
+  }                                                                           \
+  BENCHMARK(BM_cpu_##src##_##dst)->UseRealTime()->Arg(64 << 10)->Arg(32 << 20);
+
+BM_CPU_CAST(float, float8_e5m2);
+BM_CPU_CAST(float, float8_e4m3fn);
+BM_CPU_CAST(bfloat16, float8_e5m2);
+BM_CPU_CAST(bfloat16, float8_e4m3fn);
+BM_CPU_CAST(float8_e5m2, float);
+BM_CPU_CAST(float8_e4m3fn, float);
+BM_CPU_CAST(float8_e4m3fn, bfloat16);
+BM_CPU_CAST(float8_e4m3fn, half);
+BM_CPU_CAST(float8_e4m3fn, float8_e5m2);
+BM_CPU_CAST(int4, int8);
+BM_CPU_CAST(int4, int32);
+BM_CPU_CAST(int8, int4);
+BM_CPU_CAST(int32, int4);
+
+#undef BM_CPU_CAST
+
 }  // end namespace tensorflow
@@ -18,10 +18,13 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <vector>
+
+#include "absl/types/optional.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/concat_lib.h"
-#include "tensorflow/core/util/work_sharder.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -75,59 +78,55 @@ void ConcatCPUImpl(
     return;
   }
 
-  // Sharded mode.
-  auto work = [&row_size, &sizes, &inputs, &output, &copier, &num_inputs](
-                  int64_t start, int64_t end) {
-    int64_t skipped_rows = start / row_size;
-    T* out = output->data() + skipped_rows * row_size;
-    T* out_start = output->data() + start;
-    T* out_end = output->data() + end;
-
-    // Handle partial row at start
-    if (out < out_start) {
-      for (size_t j = 0; j < num_inputs; ++j) {
-        ptrdiff_t size = sizes[j];
-        ptrdiff_t offset = out_start - out;
-        if (size <= offset) {
-          out += size;
-          continue;
-        }
-        const T* inp = &(*inputs[j])(skipped_rows, 0);
-        if (offset > 0) {
-          out += offset;
-          inp += offset;
-          size -= offset;
-        }
-        size = std::min(size, out_end - out);
-        if (size <= 0) break;
-        copier.Copy(out, inp, j, size);
-        out += size;
-      }
-      ++skipped_rows;
-    }
-    if (out == out_end) return;
-    CHECK(out >= out_start);
-    CHECK(out < out_end);
+  // Sharded mode. Each shard copies a contiguous range of the output whose
+  // boundaries are aligned to cache lines, so no two threads write to the same
+  // line. 64 elements of any type span a whole number of cache lines.
+  constexpr int64_t kShardAlignment = 64;
+  const int64_t total = output->size();
+  const int64_t num_shards = std::max<int64_t>(
+      1, std::min<int64_t>(worker_threads->num_threads,
+                           estimated_total_cost / 16384));
+  const int64_t block_size =
+      Eigen::divup(Eigen::divup(total, num_shards), kShardAlignment) *
+      kShardAlignment;
+
+  // offsets[j] is the column of the output rows at which input j starts.
+  std::vector<ptrdiff_t> offsets(num_inputs + 1, 0);
+  for (size_t j = 0; j < num_inputs; ++j) {
+    offsets[j + 1] = offsets[j] + sizes[j];
+  }
 
-    // Copy remaining data.
-    std::vector<const T*> inp;
-    inp.reserve(num_inputs);
-    for (const auto& input : inputs) {
-      inp.push_back(&(*input)(skipped_rows, 0));
-    }
-    const int64_t dim0 = output->dimension(0);
-    for (int64_t i = skipped_rows; i < dim0; ++i) {
-      for (int64_t j = 0; j < num_inputs; ++j) {
-        ptrdiff_t size = std::min(sizes[j], out_end - out);
-        copier.Copy(out, inp[j], j, size);
+  auto work = [&row_size, &sizes, &offsets, &inputs, &output, &copier,
+               &num_inputs](int64_t start, int64_t end) {
+    int64_t row = start / row_size;
+    ptrdiff_t col = start % row_size;
+    // Find the input that holds column `col` with a binary search, rather than
+    // walking over the inputs, which matters when there are many of them.
+    size_t j = std::upper_bound(offsets.begin(), offsets.end(), col) -
+               offsets.begin() - 1;
+    T* out = output->data() + start;
+    T* const out_end = output->data() + end;
+    while (out < out_end) {
+      const ptrdiff_t input_col = col - offsets[j];
+      const ptrdiff_t size = std::min(sizes[j] - input_col, out_end - out);
+      if (size > 0) {
+        copier.Copy(out, &(*inputs[j])(row, input_col), j, size);
         out += size;
-        inp[j] += size;
-        if (out == out_end) return;
+      }
+      col = offsets[++j];
+      if (j == num_inputs) {
+        j = 0;
+        col = 0;
+        ++row;
       }
     }
   };
-  Shard(worker_threads->num_threads, worker_threads->workers, output->size(),
-        cost_per_unit, work);
+  worker_threads->workers->ParallelFor(
+      total,
+      thread::ThreadPool::SchedulingParams(
+          thread::ThreadPool::SchedulingStrategy::kFixedBlockSize,
+          absl::nullopt /* cost_per_unit */, block_size),
+      work);
 }
 
 }  // namespace tensorflow
@@ -192,6 +192,41 @@ void BM_ConcatManyDim1bfloat16(::testing::benchmark::State& state) {
 
 BENCHMARK(BM_ConcatManyDim1bfloat16)->UseRealTime()->Arg(18)->Arg(34)->Arg(60);
 
+// Concatenates `num_inputs` small [kDim1, 8] float tensors along dimension 1,
+// as when assembling many embedding features.
+void BM_ConcatManySmallDim1Float(::testing::benchmark::State& state) {
+  const int num_inputs = state.range(0);
+  const int kDim1 = 256;
+  const int kDim2 = 8;
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor concat_dim(DT_INT32, TensorShape({}));
+  concat_dim.scalar<int32>()() = 1;
+  std::vector<NodeBuilder::NodeOut> inputs;
+  inputs.reserve(num_inputs);
+  for (int i = 0; i < num_inputs; ++i) {
+    Tensor in(DT_FLOAT, TensorShape({kDim1, kDim2}));
+    in.flat<float>().setRandom();
+    inputs.push_back(test::graph::Constant(g, in));
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Concat")
+                  .Input(test::graph::Constant(g, concat_dim))
+                  .Input(inputs)
+                  .Attr("N", num_inputs)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * kDim1 *
+                          kDim2 * num_inputs * sizeof(float));
+}
+
+BENCHMARK(BM_ConcatManySmallDim1Float)
+    ->UseRealTime()
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(4000);
+
 void MemcpyAlternativeHelper(::testing::benchmark::State& state, int dim2) {
   const int kDim1 = 100;
   std::vector<float> data1(kDim1 * dim2, 1.0f);
@@ -32,7 +32,9 @@ class LaunchDeepConvOp<CPUDevice, float> {
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int dilation_rows,
                   int dilation_cols, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
+                  Tensor* output, TensorFormat data_format,
+                  DeepConv2DKernelCache* cache,
+                  const std::function<void()>& launch_default) {
     if (data_format != FORMAT_NHWC || dilation_rows != 1 ||
         dilation_cols != 1 ||
         !CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
@@ -56,9 +58,37 @@ class LaunchDeepConvOp<CPUDevice, float> {
     auto input_ptr = input.template flat<float>().data();
     auto filter_ptr = filter.template flat<float>().data();
     auto output_ptr = output->template flat<float>().data();
-
-    functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
-                                            output_ptr);
+    auto launch_deep_conv = [&]() {
+      functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
+                                              output_ptr, cache);
+    };
+
+    bool use_deep_conv = true;
+    if (DeepConv2DAutotuneEnabled() &&
+        !cache->LookupAutotuneResult(args, &use_deep_conv)) {
+      // The first run transforms and caches the filters. It is not measured,
+      // as that cost is amortized for constant filters.
+      launch_deep_conv();
+      if (!ctx->status().ok()) return true;
+      Env* env = ctx->env();
+      uint64 start_micros = env->NowMicros();
+      launch_deep_conv();
+      const uint64 deep_conv_micros = env->NowMicros() - start_micros;
+      start_micros = env->NowMicros();
+      launch_default();
+      const uint64 default_micros = env->NowMicros() - start_micros;
+      use_deep_conv = deep_conv_micros < default_micros;
+      VLOG(1) << "DeepConv2D autotune: deep_conv_micros: " << deep_conv_micros
+              << " default_micros: " << default_micros
+              << " use_deep_conv: " << use_deep_conv;
+      cache->InsertAutotuneResult(args, use_deep_conv);
+      // 'output' holds the result of the default implementation.
+      return true;
+    }
+    if (!use_deep_conv) {
+      return false;
+    }
+    launch_deep_conv();
     return true;
   }
 };
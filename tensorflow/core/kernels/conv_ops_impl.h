@@ -639,7 +639,9 @@ class LaunchDeepConvOp {
                   int /*out_cols*/, int /*out_depth*/, int /*dilation_rows*/,
                   int /*dilation_cols*/, int /*stride_rows*/,
                   int /*stride_cols*/, Tensor* /*output*/,
-                  TensorFormat /*data_format*/) {
+                  TensorFormat /*data_format*/,
+                  DeepConv2DKernelCache* /*cache*/,
+                  const std::function<void()>& /*launch_default*/) {
     return false;
   }
 };
@@ -704,6 +706,13 @@ class Conv2DOp : public BinaryOp<T> {
       return;
     }
 
+    auto launch_default = [&]() {
+      launcher_(context, use_cudnn_, cudnn_use_autotune_, input, filter,
+                dimensions.dilation_rows, dimensions.dilation_cols,
+                dimensions.stride_rows, dimensions.stride_cols, params_.padding,
+                params_.explicit_paddings, output, params_.data_format);
+    };
+
     if (params_.padding != EXPLICIT &&
         LaunchDeepConvOp<Device, T>::Run(
             context, input, filter, dimensions.batch, dimensions.input_rows,
@@ -712,14 +721,12 @@ class Conv2DOp : public BinaryOp<T> {
             dimensions.pad_cols_before, dimensions.out_rows,
             dimensions.out_cols, dimensions.out_depth, dimensions.dilation_rows,
             dimensions.dilation_cols, dimensions.stride_rows,
-            dimensions.stride_cols, output, params_.data_format)) {
+            dimensions.stride_cols, output, params_.data_format,
+            &deep_conv_cache_, launch_default)) {
       return;
     }
 
-    launcher_(context, use_cudnn_, cudnn_use_autotune_, input, filter,
-              dimensions.dilation_rows, dimensions.dilation_cols,
-              dimensions.stride_rows, dimensions.stride_cols, params_.padding,
-              params_.explicit_paddings, output, params_.data_format);
+    launch_default();
   }
 
  private:
@@ -728,6 +735,8 @@ class Conv2DOp : public BinaryOp<T> {
   bool cudnn_use_autotune_;
 
   LaunchConv2DOp<Device, T> launcher_;
+  // Transformed filters and autotune results of DeepConv2D.
+  DeepConv2DKernelCache deep_conv_cache_;
 
   Conv2DOp(const Conv2DOp&) = delete;
   void operator=(const Conv2DOp&) = delete;
@@ -0,0 +1,324 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/csv_parsing.h"
+
+#include <cstring>
+#include <system_error>  // NOLINT(build/c++11)
+
+#include "absl/numeric/bits.h"
+#include "absl/strings/charconv.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/byte_order.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr uint64_t kLowBits = 0x0101010101010101ULL;
+constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+
+// Returns a word with the high bit set in the first byte of `word` that is
+// zero, and possibly in bytes after it, or 0 if no byte is zero.
+inline uint64_t ZeroBytes(uint64_t word) {
+  return (word - kLowBits) & ~word & kHighBits;
+}
+
+// Returns true if `field` is an optionally negative decimal number with
+// digits on both sides of an optional decimal point and an optional
+// exponent, which every `strings::safe_strto*` floating point parser accepts.
+bool IsPlainDecimal(StringPiece field) {
+  const char* p = field.data();
+  const char* end = p + field.size();
+  const auto consume_digits = [&p, end]() {
+    const char* start = p;
+    while (p < end && static_cast<unsigned char>(*p - '0') < 10) ++p;
+    return p > start;
+  };
+  if (p < end && *p == '-') ++p;
+  if (!consume_digits()) return false;
+  if (p < end && *p == '.') {
+    ++p;
+    if (!consume_digits()) return false;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    if (p < end && (*p == '-' || *p == '+')) ++p;
+    if (!consume_digits()) return false;
+  }
+  return p == end;
+}
+
+// Parses up to `kMaxDigits` decimal digits, optionally negative, which
+// cannot overflow `T`. Returns false for anything else.
+template <typename T, int kMaxDigits>
+bool ParseShortInteger(StringPiece field, T* value) {
+  const char* p = field.data();
+  const char* end = p + field.size();
+  const bool negative = p < end && *p == '-';
+  if (negative) ++p;
+  if (p == end || end - p > kMaxDigits) return false;
+  T result = 0;
+  for (; p < end; ++p) {
+    const unsigned char digit = *p - '0';
+    if (digit >= 10) return false;
+    result = result * 10 + digit;
+  }
+  *value = negative ? -result : result;
+  return true;
+}
+
+// Limits within which a decimal converts exactly: the mantissa and the power
+// of ten are both exactly representable in `T`, so one rounded multiplication
+// or division produces the correctly rounded value (Clinger's fast path).
+template <typename T>
+struct ExactDecimalLimits;
+template <>
+struct ExactDecimalLimits<float> {
+  static constexpr uint64_t kMaxMantissa = uint64_t{1} << 24;
+  static constexpr int kMaxExponent = 10;
+};
+template <>
+struct ExactDecimalLimits<double> {
+  static constexpr uint64_t kMaxMantissa = uint64_t{1} << 53;
+  static constexpr int kMaxExponent = 22;
+};
+
+template <typename T>
+T PowerOfTen(int exponent) {
+  static constexpr T kPowers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                  1e18, 1e19, 1e20, 1e21, 1e22};
+  return kPowers[exponent];
+}
+
+// Converts a plain decimal, as accepted by `IsPlainDecimal()`, if it is
+// within `ExactDecimalLimits<T>`. Returns false otherwise.
+template <typename T>
+bool ParseExactDecimal(StringPiece field, T* value) {
+  using Limits = ExactDecimalLimits<T>;
+  const char* p = field.data();
+  const char* end = p + field.size();
+  const bool negative = *p == '-';
+  if (negative) ++p;
+  uint64_t mantissa = 0;
+  int num_digits = 0;
+  int exponent = 0;
+  bool fraction = false;
+  for (; p < end && *p != 'e' && *p != 'E'; ++p) {
+    if (*p == '.') {
+      fraction = true;
+      continue;
+    }
+    mantissa = mantissa * 10 + (*p - '0');
+    if (mantissa != 0 && ++num_digits > 19) return false;
+    if (fraction) --exponent;
+  }
+  if (p < end) {
+    ++p;
+    const bool negative_exponent = *p == '-';
+    if (*p == '-' || *p == '+') ++p;
+    if (end - p > 3) return false;
+    int explicit_exponent = 0;
+    for (; p < end; ++p) explicit_exponent = explicit_exponent * 10 + *p - '0';
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+  // Trailing zeros of the fraction, as printed by "%f", do not count against
+  // the mantissa.
+  while (exponent < 0 && mantissa != 0 && mantissa % 10 == 0) {
+    mantissa /= 10;
+    ++exponent;
+  }
+  if (mantissa > Limits::kMaxMantissa) return false;
+  T result = static_cast<T>(mantissa);
+  if (mantissa != 0) {
+    if (exponent > Limits::kMaxExponent || exponent < -Limits::kMaxExponent) {
+      return false;
+    }
+    result = exponent >= 0 ? result * PowerOfTen<T>(exponent)
+                           : result / PowerOfTen<T>(-exponent);
+  }
+  *value = negative ? -result : result;
+  return true;
+}
+
+template <typename T>
+bool ParsePlainDecimal(StringPiece field, T* value) {
+  if (!IsPlainDecimal(field)) return false;
+  if (ParseExactDecimal(field, value)) return true;
+  T result;
+  const absl::from_chars_result parsed =
+      absl::from_chars(field.data(), field.data() + field.size(), result);
+  // Values that overflow or underflow are left to the slow path, which
+  // defines their result.
+  if (parsed.ec != std::errc() || parsed.ptr != field.data() + field.size()) {
+    return false;
+  }
+  *value = result;
+  return true;
+}
+
+}  // namespace
+
+size_t FindFirstOfFour(StringPiece text, char a, char b, char c, char d) {
+  const char* data = text.data();
+  const size_t size = text.size();
+  size_t i = 0;
+  if (port::kLittleEndian) {
+    const uint64_t wa = kLowBits * static_cast<unsigned char>(a);
+    const uint64_t wb = kLowBits * static_cast<unsigned char>(b);
+    const uint64_t wc = kLowBits * static_cast<unsigned char>(c);
+    const uint64_t wd = kLowBits * static_cast<unsigned char>(d);
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, data + i, sizeof(word));
+      // Bytes after the first match may be flagged spuriously, but the lowest
+      // flagged byte is always the first match.
+      const uint64_t matches = ZeroBytes(word ^ wa) | ZeroBytes(word ^ wb) |
+                               ZeroBytes(word ^ wc) | ZeroBytes(word ^ wd);
+      if (matches != 0) return i + absl::countr_zero(matches) / 8;
+    }
+  }
+  for (; i < size; ++i) {
+    const char ch = data[i];
+    if (ch == a || ch == b || ch == c || ch == d) return i;
+  }
+  return size;
+}
+
+bool ParseCsvInt32(StringPiece field, int32_t* value) {
+  return ParseShortInteger<int32_t, 9>(field, value) ||
+         strings::safe_strto32(field, value);
+}
+
+bool ParseCsvInt64(StringPiece field, int64_t* value) {
+  return ParseShortInteger<int64_t, 18>(field, value) ||
+         strings::safe_strto64(field, value);
+}
+
+bool ParseCsvFloat(StringPiece field, float* value) {
+  return ParsePlainDecimal(field, value) || strings::safe_strtof(field, value);
+}
+
+bool ParseCsvDouble(StringPiece field, double* value) {
+  return ParsePlainDecimal(field, value) || strings::safe_strtod(field, value);
+}
+
+CsvRecordSplitter::CsvRecordSplitter(char delim, bool use_quote_delim,
+                                     absl::Span<const int64_t> select_cols)
+    : delim_(delim),
+      use_quote_delim_(use_quote_delim),
+      select_cols_(select_cols) {}
+
+Status CsvRecordSplitter::Split(StringPiece record,
+                                std::vector<StringPiece>* fields) {
+  fields->clear();
+  unescaped_.clear();
+  unescaped_fields_.clear();
+  TF_RETURN_IF_ERROR(SplitFields(record, fields));
+  // `unescaped_` no longer grows, so pieces of it stay valid.
+  for (const UnescapedField& field : unescaped_fields_) {
+    (*fields)[field.index] =
+        StringPiece(unescaped_.data() + field.offset, field.size);
+  }
+  return absl::OkStatus();
+}
+
+Status CsvRecordSplitter::SplitFields(StringPiece record,
+                                      std::vector<StringPiece>* fields) {
+  if (record.empty()) return absl::OkStatus();
+  const bool select_all = select_cols_.empty();
+  // Without quote delimiting, a quote is an ordinary character, so searching
+  // for the delimiter a second time stands in for it.
+  const char quote = use_quote_delim_ ? '"' : delim_;
+  size_t pos = 0;
+  int64_t num_parsed = 0;
+  size_t num_selected = 0;
+  while (pos < record.size()) {
+    if (record[pos] == '\n' || record[pos] == '\r') {
+      ++pos;
+      continue;
+    }
+    const bool include =
+        select_all || select_cols_[num_selected] == num_parsed;
+    StringPiece field;
+    if (use_quote_delim_ && record[pos] == '"') {
+      ++pos;
+      TF_RETURN_IF_ERROR(
+          SplitQuotedField(record, include, fields->size(), &pos, &field));
+    } else {
+      const size_t end = pos + FindFirstOfFour(record.substr(pos), delim_,
+                                               quote, '\n', '\r');
+      if (end < record.size() && record[end] != delim_) {
+        return errors::InvalidArgument(
+            "Unquoted fields cannot have quotes/CRLFs inside");
+      }
+      field = record.substr(pos, end - pos);
+      pos = end + 1;
+    }
+    ++num_parsed;
+    if (include) {
+      fields->push_back(field);
+      if (++num_selected == select_cols_.size()) return absl::OkStatus();
+    }
+  }
+  // Check if the last field is missing.
+  if ((select_all || select_cols_[num_selected] == num_parsed) &&
+      record.back() == delim_) {
+    fields->emplace_back();
+  }
+  return absl::OkStatus();
+}
+
+Status CsvRecordSplitter::SplitQuotedField(StringPiece record, bool include,
+                                           size_t field_index, size_t* pos,
+                                           StringPiece* field) {
+  const size_t start = *pos;
+  size_t from = start;
+  bool escaped = false;
+  while (true) {
+    const size_t quote = record.find('"', from);
+    if (quote == StringPiece::npos) {
+      return errors::InvalidArgument(
+          "Quoted field has to end with quote followed by delim or end");
+    }
+    if (quote + 1 == record.size() || record[quote + 1] == delim_) {
+      if (include && escaped) {
+        unescaped_.append(record.data() + from, quote - from);
+        unescaped_fields_.back().size =
+            unescaped_.size() - unescaped_fields_.back().offset;
+      } else if (include) {
+        *field = record.substr(start, quote - start);
+      }
+      *pos = quote + 2;
+      return absl::OkStatus();
+    }
+    if (record[quote + 1] != '"') {
+      return errors::InvalidArgument(
+          "Quote inside a string has to be escaped by another quote");
+    }
+    if (include) {
+      if (!escaped) {
+        escaped = true;
+        unescaped_fields_.push_back({field_index, unescaped_.size(), 0});
+      }
+      // Keep the first quote of the pair.
+      unescaped_.append(record.data() + from, quote + 1 - from);
+    }
+    from = quote + 2;
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,94 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_CSV_PARSING_H_
+#define TENSORFLOW_CORE_KERNELS_CSV_PARSING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Helpers shared by the CSV parsing kernels, DecodeCSV and CSVDataset.
+
+// Returns the offset of the first occurrence of any of `a`, `b`, `c` or `d` in
+// `text`, or `text.size()` if there is none. Scans a word at a time.
+size_t FindFirstOfFour(StringPiece text, char a, char b, char c, char d);
+
+// Convert a CSV field to a number. They accept exactly the same strings as, and
+// produce the same values as, the `strings::safe_strto*` function of the same
+// type, but have a fast path for the plain decimal numbers that make up most
+// CSV files.
+bool ParseCsvInt32(StringPiece field, int32_t* value);
+bool ParseCsvInt64(StringPiece field, int64_t* value);
+bool ParseCsvFloat(StringPiece field, float* value);
+bool ParseCsvDouble(StringPiece field, double* value);
+
+// Splits a single CSV record into fields, as DecodeCSV does.
+//
+// A field is either unquoted, in which case it must not contain quotes (if
+// `use_quote_delim`) or line breaks, or it is enclosed in double quotes, in
+// which case a quote inside it must be escaped by another quote. Line breaks
+// at the start of a field are skipped.
+//
+// This class is not thread-safe. Concurrent callers should use one instance
+// each.
+class CsvRecordSplitter {
+ public:
+  // If `select_cols` is not empty, only the fields at those strictly
+  // increasing indices are returned. `select_cols` must outlive the splitter.
+  CsvRecordSplitter(char delim, bool use_quote_delim,
+                    absl::Span<const int64_t> select_cols);
+
+  // Replaces the contents of `fields` with the selected fields of `record`.
+  // The returned pieces point into `record`, or into storage owned by the
+  // splitter for quoted fields that contain escaped quotes, and are valid
+  // until the next call to `Split()`.
+  Status Split(StringPiece record, std::vector<StringPiece>* fields);
+
+ private:
+  Status SplitFields(StringPiece record, std::vector<StringPiece>* fields);
+
+  // Parses the quoted field whose body starts at `*pos`, just after the
+  // opening quote, and advances `*pos` past the closing quote and the
+  // delimiter that follows it. If `include`, the field is returned in `*field`,
+  // or, if it contains escaped quotes, unescaped into `unescaped_` and
+  // recorded as the field at `field_index`.
+  Status SplitQuotedField(StringPiece record, bool include, size_t field_index,
+                          size_t* pos, StringPiece* field);
+
+  const char delim_;
+  const bool use_quote_delim_;
+  const absl::Span<const int64_t> select_cols_;
+
+  // The unescaped quoted fields of the current record.
+  struct UnescapedField {
+    size_t index;   // Index of the field in the record.
+    size_t offset;  // Offset of the field in `unescaped_`.
+    size_t size;
+  };
+  std::string unescaped_;
+  std::vector<UnescapedField> unescaped_fields_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CSV_PARSING_H_
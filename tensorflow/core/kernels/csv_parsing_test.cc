@@ -0,0 +1,164 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/csv_parsing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+std::vector<std::string> Split(StringPiece record, bool use_quote_delim = true,
+                               std::vector<int64_t> select_cols = {}) {
+  CsvRecordSplitter splitter(',', use_quote_delim, select_cols);
+  std::vector<StringPiece> fields;
+  TF_CHECK_OK(splitter.Split(record, &fields));
+  return std::vector<std::string>(fields.begin(), fields.end());
+}
+
+std::string SplitError(StringPiece record) {
+  CsvRecordSplitter splitter(',', true, {});
+  std::vector<StringPiece> fields;
+  Status s = splitter.Split(record, &fields);
+  EXPECT_FALSE(s.ok());
+  return std::string(s.message());
+}
+
+TEST(CsvRecordSplitterTest, UnquotedFields) {
+  EXPECT_EQ(Split("a,bc,,def"),
+            std::vector<std::string>({"a", "bc", "", "def"}));
+  EXPECT_EQ(Split("a,"), std::vector<std::string>({"a", ""}));
+  EXPECT_EQ(Split(""), std::vector<std::string>());
+  EXPECT_EQ(Split("a long field that spans words,x"),
+            std::vector<std::string>({"a long field that spans words", "x"}));
+}
+
+TEST(CsvRecordSplitterTest, QuotedFields) {
+  EXPECT_EQ(Split("\"a,b\",c"), std::vector<std::string>({"a,b", "c"}));
+  EXPECT_EQ(Split("\"say \"\"hi\"\"\",\"\"\"\",x"),
+            std::vector<std::string>({"say \"hi\"", "\"", "x"}));
+  EXPECT_EQ(Split("\"line\nbreak\""),
+            std::vector<std::string>({"line\nbreak"}));
+  // Without quote delimiting, quotes are ordinary characters.
+  EXPECT_EQ(Split("\"a\",b\"", /*use_quote_delim=*/false),
+            std::vector<std::string>({"\"a\"", "b\""}));
+}
+
+TEST(CsvRecordSplitterTest, SelectedColumns) {
+  EXPECT_EQ(Split("a,\"b\"\"\",c,d", true, {1, 3}),
+            std::vector<std::string>({"b\"", "d"}));
+  // Columns after the last selected one are not parsed.
+  EXPECT_EQ(Split("a,b,\"unterminated", true, {0}),
+            std::vector<std::string>({"a"}));
+  EXPECT_EQ(Split("a,b,", true, {2}), std::vector<std::string>({""}));
+}
+
+TEST(CsvRecordSplitterTest, InvalidRecords) {
+  EXPECT_EQ(SplitError("a\"b,c"),
+            "Unquoted fields cannot have quotes/CRLFs inside");
+  EXPECT_EQ(SplitError("a\r,c"),
+            "Unquoted fields cannot have quotes/CRLFs inside");
+  EXPECT_EQ(SplitError("\"a\"b,c"),
+            "Quote inside a string has to be escaped by another quote");
+  EXPECT_EQ(SplitError("\"abc"),
+            "Quoted field has to end with quote followed by delim or end");
+  EXPECT_EQ(SplitError("\"abc\"\""),
+            "Quoted field has to end with quote followed by delim or end");
+}
+
+TEST(FindFirstOfFourTest, MatchesFindFirstOf) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  const std::string targets = ",\"\n\r";
+  for (int i = 0; i < 10000; ++i) {
+    std::string text(rnd.Uniform(40), ' ');
+    for (char& c : text) c = rnd.OneIn(10) ? targets[rnd.Uniform(4)] : 'x';
+    const size_t expected = std::min(text.find_first_of(targets), text.size());
+    EXPECT_EQ(FindFirstOfFour(text, ',', '"', '\n', '\r'), expected) << text;
+  }
+}
+
+template <typename T>
+void ExpectSameAsSafeStrto(bool (*parse)(StringPiece, T*),
+                           bool (*safe_strto)(absl::string_view, T*),
+                           StringPiece field) {
+  T expected = 0, actual = 0;
+  const bool expected_ok = safe_strto(field, &expected);
+  EXPECT_EQ(parse(field, &actual), expected_ok) << field;
+  if (expected_ok) {
+    EXPECT_EQ(std::memcmp(&actual, &expected, sizeof(T)), 0) << field;
+  }
+}
+
+TEST(ParseCsvNumberTest, SameAsSafeStrto) {
+  std::vector<std::string> fields = {
+      "0", "-0", "7", "-12", "00012", "+5", " 5", "5 ", "-", "", "1.5",
+      "-0.25", ".5", "5.", "1e5", "1E-5", "1e+5", "2.5e300", "1e400",
+      "1e-400", "inf", "-nan", "0x1A", "1.2.3", "12a", "1e", "0.1",
+      "3.4028235e38", "3.4028236e38", "1.17549435e-38", "4.9e-324",
+      "2147483647", "2147483648", "-2147483648", "-2147483649",
+      "999999999999999999", "123456789012345678", "9223372036854775807",
+      "9223372036854775808", "-9223372036854775808",
+  };
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  for (int i = 0; i < 10000; ++i) {
+    std::string field = rnd.OneIn(2) ? "-" : "";
+    strings::StrAppend(&field, rnd.Uniform64(1000000000000));
+    if (rnd.OneIn(2)) strings::StrAppend(&field, ".", rnd.Uniform(100000));
+    if (rnd.OneIn(3)) strings::StrAppend(&field, "e-", rnd.Uniform(30));
+    fields.push_back(field);
+  }
+  for (const std::string& field : fields) {
+    ExpectSameAsSafeStrto<int32_t>(ParseCsvInt32, strings::safe_strto32, field);
+    ExpectSameAsSafeStrto<int64_t>(ParseCsvInt64, strings::safe_strto64, field);
+    ExpectSameAsSafeStrto<float>(ParseCsvFloat, strings::safe_strtof, field);
+    ExpectSameAsSafeStrto<double>(ParseCsvDouble, strings::safe_strtod, field);
+  }
+}
+
+// Splits records of `state.range(0)` fields and parses them as floats.
+void BM_SplitAndParseFloats(::testing::benchmark::State& state) {
+  const int num_fields = state.range(0);
+  std::string record;
+  for (int i = 0; i < num_fields; ++i) {
+    strings::StrAppend(&record, i == 0 ? "" : ",", i * 37 % 1000, ".",
+                       i * 7919 % 10000);
+  }
+  CsvRecordSplitter splitter(',', true, {});
+  std::vector<StringPiece> fields;
+  for (auto s : state) {
+    TF_CHECK_OK(splitter.Split(record, &fields));
+    for (StringPiece field : fields) {
+      float value;
+      CHECK(ParseCsvFloat(field, &value));
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * record.size());
+}
+BENCHMARK(BM_SplitAndParseFloats)->Arg(10)->Arg(100);
+
+}  // namespace
+}  // namespace tensorflow
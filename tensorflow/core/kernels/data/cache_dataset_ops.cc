@@ -23,7 +23,10 @@ limitations under the License.
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/global_shuffle_utils.h"
+#include "tensorflow/core/data/indexed_cache_file.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -70,6 +73,7 @@ constexpr char kCacheCompleted[] = "cache_completed";
 constexpr char kIndex[] = "index";
 constexpr char kImpl[] = "Impl";
 constexpr char kCacheDataset[] = "CacheDataset";
+constexpr char kIndexedFileCacheExperiment[] = "indexed_file_cache";
 constexpr char kIncompleteCacheErrorMessage[] =
     "The calling iterator did not fully read the dataset being cached. In "
     "order to avoid unexpected truncation of the dataset, the partially cached "
@@ -178,9 +182,19 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         item_index_padding_size_(StringPaddingSize(kMaxItems)),
         tensor_format_string_(strings::Printf(kKeyStrFormat,
                                               item_index_padding_size_,
-                                              tensor_index_padding_size_)) {
+                                              tensor_index_padding_size_)),
+        use_indexed_format_(
+            GetExperiments().contains(kIndexedFileCacheExperiment)) {
     input_->Ref();
     DCHECK_EQ(item_index_padding_size_, 7);
+    if (env_->FileExists(IndexedCacheFilename(filename_)).ok()) {
+      random_indexing_compatible_ = absl::OkStatus();
+    } else if (use_indexed_format_) {
+      // Until the cache is complete, random access is served by the input.
+      random_indexing_compatible_ = input_->RandomIndexingCompatible();
+    } else {
+      random_indexing_compatible_ = DatasetBase::RandomIndexingCompatible();
+    }
   }
 
   ~FileDatasetBase() override { input_->Unref(); }
@@ -220,11 +234,39 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     return input_->CheckExternalState();
   }
 
+  Status Get(AnyContext ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    TF_ASSIGN_OR_RETURN(std::shared_ptr<const IndexedCacheFileReader> reader,
+                        GetIndexedReader());
+    if (reader == nullptr) {
+      return input_->Get(ctx, index, out_tensors);
+    }
+    return reader->Get(index, out_tensors);
+  }
+
+  absl::Status RandomIndexingCompatible() const override {
+    return random_indexing_compatible_;
+  }
+
  protected:
   const DatasetBase* const input_;
   const tstring filename_;
 
  private:
+  // Returns the reader of the indexed cache file, which is shared by all
+  // iterators, or nullptr if the file has not been completely written yet.
+  absl::StatusOr<std::shared_ptr<const IndexedCacheFileReader>>
+  GetIndexedReader() const {
+    mutex_lock l(mu_);
+    if (indexed_reader_ == nullptr &&
+        env_->FileExists(IndexedCacheFilename(filename_)).ok()) {
+      TF_ASSIGN_OR_RETURN(
+          indexed_reader_,
+          IndexedCacheFileReader::Open(env_, IndexedCacheFilename(filename_)));
+    }
+    return indexed_reader_;
+  }
+
   static size_t StringPaddingSize(size_t num_tensors) {
     return strings::Printf(kPaddingSizeStrFormat, num_tensors - 1).size();
   }
@@ -237,10 +279,15 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
   class FileIterator : public DatasetIterator<FileDatasetBase> {
    public:
     explicit FileIterator(const Params& params)
-        : DatasetIterator<FileDatasetBase>(params) {
+        : DatasetIterator<FileDatasetBase>(params),
+          global_shuffle_iterator_(dataset()) {
       if (params.dataset->env_
-              ->FileExists(MetaFilename(params.dataset->filename_))
+              ->FileExists(IndexedCacheFilename(params.dataset->filename_))
               .ok()) {
+        mode_ = Mode::indexed_read;
+      } else if (params.dataset->env_
+                     ->FileExists(MetaFilename(params.dataset->filename_))
+                     .ok()) {
         mode_ = Mode::read;
       } else {
         mode_ = Mode::write;
@@ -255,6 +302,10 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (ctx->index_mapper() != nullptr) {
+        return global_shuffle_iterator_.GetNext(ctx, out_tensors,
+                                                end_of_sequence);
+      }
       mutex_lock l(mu_);
       return iterator_->GetNext(ctx, out_tensors, end_of_sequence);
     }
@@ -270,10 +321,14 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
                         IteratorStateWriter* writer) override {
       mutex_lock l(mu_);
       TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kMode, mode_));
+      TF_RETURN_IF_ERROR(global_shuffle_iterator_.Save(prefix(), ctx, writer));
       return SaveInput(ctx, writer, iterator_);
     }
     Status RestoreInternal(IteratorContext* ctx,
                            IteratorStateReader* reader) override {
+      if (ctx->restored_element_count().has_value()) {
+        return global_shuffle_iterator_.Restore(prefix(), ctx, reader);
+      }
       mutex_lock l(mu_);
       {
         int64_t temp;
@@ -294,6 +349,14 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
             << "mistake, please remove the above file and try running again.";
         mode_ = Mode::read;
       }
+      if (mode_ != Mode::indexed_read &&
+          dataset()
+              ->env_->FileExists(IndexedCacheFilename(dataset()->filename_))
+              .ok()) {
+        // The cache was written in the indexed format since the checkpoint
+        // was saved. All readers use the same `cur_index` key.
+        mode_ = Mode::indexed_read;
+      }
       TF_RETURN_IF_ERROR(InitializeIterator(ctx));
       return RestoreInput(ctx, reader, iterator_);
     }
@@ -315,6 +378,10 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     // partial cache gets flushed to disk in files with prefix
     // <filename>_<shard_id> where shard_id is unique for each checkpoint.
     // When all elements have been produced, these shards get coalesced.
+    //
+    // With the "indexed_file_cache" experiment, the shards are written with
+    // `IndexedCacheFileWriter` instead, and coalesced into a single indexed
+    // cache file that later epochs read with `IndexedFileReaderIterator`.
     class FileWriterIterator : public DatasetIterator<FileDatasetBase> {
      public:
       explicit FileWriterIterator(const Params& params)
@@ -328,7 +395,11 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
             iteration_completed_(false) {}
 
       ~FileWriterIterator() override {
-        if (!dataset()->env_->FileExists(MetaFilename(filename_)).ok()) {
+        const string completed_filename =
+            dataset()->use_indexed_format_
+                ? IndexedCacheFilename(dataset()->filename_)
+                : MetaFilename(filename_);
+        if (!dataset()->env_->FileExists(completed_filename).ok()) {
           LOG(WARNING) << kIncompleteCacheErrorMessage;
           std::vector<string> cache_files;
           Status s = dataset()->env_->GetMatchingPaths(
@@ -361,7 +432,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         if (*end_of_sequence) {
           return absl::OkStatus();
         }
-        TF_RETURN_IF_ERROR(writer_->status());
+        TF_RETURN_IF_ERROR(WriterStatus());
         if (cur_index_ >= kMaxItems) {
           // As a courtesy, close the [truncated] cache file.
           Status s = Finish();
@@ -386,11 +457,15 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
               "Expected ",
               dataset()->num_tensors_, " got: ", out_tensors->size());
         }
-        size_t tensor_index = 0;
-        for (const Tensor& t : *out_tensors) {
-          DCHECK_LT(tensor_index, dataset()->num_tensors_);
-          string key = dataset()->FormatName(cur_index_, tensor_index++);
-          TF_RETURN_IF_ERROR(writer_->Add(key, t));
+        if (dataset()->use_indexed_format_) {
+          TF_RETURN_IF_ERROR(indexed_writer_->Add(*out_tensors));
+        } else {
+          size_t tensor_index = 0;
+          for (const Tensor& t : *out_tensors) {
+            DCHECK_LT(tensor_index, dataset()->num_tensors_);
+            string key = dataset()->FormatName(cur_index_, tensor_index++);
+            TF_RETURN_IF_ERROR(writer_->Add(key, t));
+          }
         }
         if (*end_of_sequence) {
           TF_RETURN_IF_ERROR(Finish());
@@ -425,7 +500,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // empty shards.
         if (lockfile_created_) {
           // Flush the current bundle.
-          TF_RETURN_IF_ERROR(writer_->Finish());
+          TF_RETURN_IF_ERROR(FinishShard());
 
           // Note: We do not delete the lockfile here. We keep lockfiles of
           // all shards around until the entire cache has been written to
@@ -474,11 +549,23 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         }
         filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
         lockfile_ = strings::StrCat(filename_, kLockFileSuffix);
-        writer_ = std::make_unique<BundleWriter>(dataset()->env_, filename_);
+        if (!dataset()->use_indexed_format_) {
+          writer_ = std::make_unique<BundleWriter>(dataset()->env_, filename_);
+        }
         return absl::OkStatus();
       }
 
      private:
+      Status WriterStatus() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return dataset()->use_indexed_format_ ? indexed_writer_->status()
+                                               : writer_->status();
+      }
+
+      Status FinishShard() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return dataset()->use_indexed_format_ ? indexed_writer_->Finish()
+                                               : writer_->Finish();
+      }
+
       Status EnsureLockFileExists(bool* end_of_sequence)
           TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (iteration_completed_) {
@@ -494,6 +581,12 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
 
         // 1. Check that a checkpoint for the shard has not already been
         // written.
+        if (dataset()->use_indexed_format_ &&
+            dataset()->env_->FileExists(IndexedCacheFilename(filename_)).ok()) {
+          return errors::AlreadyExists(
+              "Existing cache file found: \n", IndexedCacheFilename(filename_),
+              "\n", "To continue delete the above file.");
+        }
         if (dataset()->env_->FileExists(MetaFilename(filename_)).ok()) {
           return errors::AlreadyExists("Existing cache files found: \n",
                                        MetaFilename(filename_), "\n",
@@ -536,7 +629,13 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // conditions are not met since BundleWriter's constructor creates
         // new temp files which can delete the temp files created by a
         // BundleWriter in another Session.
-        writer_ = std::make_unique<BundleWriter>(dataset()->env_, filename_);
+        if (dataset()->use_indexed_format_) {
+          indexed_writer_ = std::make_unique<IndexedCacheFileWriter>(
+              dataset()->env_, IndexedCacheFilename(filename_),
+              dataset()->num_tensors_);
+        } else {
+          writer_ = std::make_unique<BundleWriter>(dataset()->env_, filename_);
+        }
         lockfile_created_ = true;
         return absl::OkStatus();
       }
@@ -544,7 +643,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       Status Finish() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         iteration_completed_ = true;
         // Flush the current bundle.
-        TF_RETURN_IF_ERROR(writer_->Finish());
+        TF_RETURN_IF_ERROR(FinishShard());
         // Merge all the bundles.
         // Currently there are `shard_id_ + 1` bundles, one for each
         // checkpoint. Each bundle has prefix <filename>_<id> where `id` is an
@@ -552,7 +651,17 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // We merge all these bundles into a bundle with prefix <filename> so
         // that the next call to `MakeIterator` can build a
         // `FileReaderIterator`.
-        {
+        if (dataset()->use_indexed_format_) {
+          std::vector<string> shards;
+          shards.reserve(shard_id_ + 1);
+          for (size_t i = 0; i <= shard_id_; ++i) {
+            shards.push_back(IndexedCacheFilename(
+                strings::StrCat(dataset()->filename_, "_", i)));
+          }
+          TF_RETURN_IF_ERROR(MergeIndexedCacheFiles(
+              dataset()->env_, shards,
+              IndexedCacheFilename(dataset()->filename_)));
+        } else {
           std::vector<tstring> prefixes;
           prefixes.reserve(shard_id_ + 1);
           for (size_t i = 0; i <= shard_id_; ++i) {
@@ -580,6 +689,9 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       // `StrCat(dataset()->filename_, "_", shard_id_)`.
       string filename_;
       std::unique_ptr<BundleWriter> writer_ TF_GUARDED_BY(mu_);
+      // Used instead of `writer_` with the indexed format.
+      std::unique_ptr<IndexedCacheFileWriter> indexed_writer_
+          TF_GUARDED_BY(mu_);
       string lockfile_ TF_GUARDED_BY(mu_);
       bool lockfile_created_ TF_GUARDED_BY(mu_);
       bool iteration_completed_ TF_GUARDED_BY(mu_);
@@ -674,6 +786,63 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       bool iterator_restored_ TF_GUARDED_BY(mu_);
     };  // FileReaderIterator
 
+    // IndexedFileReaderIterator reads a cache written in the indexed format.
+    // The file is memory-mapped once per dataset and shared by all of its
+    // iterators, and the tensors it produces alias the mapping.
+    class IndexedFileReaderIterator
+        : public DatasetIterator<FileDatasetBase> {
+     public:
+      explicit IndexedFileReaderIterator(const Params& params)
+          : DatasetIterator<FileDatasetBase>(params) {}
+
+      Status Initialize(IteratorContext* ctx) override {
+        mutex_lock l(mu_);
+        TF_ASSIGN_OR_RETURN(reader_, dataset()->GetIndexedReader());
+        if (reader_ == nullptr) {
+          return errors::NotFound("Cache file ",
+                                  IndexedCacheFilename(dataset()->filename_),
+                                  " does not exist.");
+        }
+        return absl::OkStatus();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (cur_index_ >= reader_->num_elements()) {
+          *end_of_sequence = true;
+          return absl::OkStatus();
+        }
+        *end_of_sequence = false;
+        return reader_->Get(cur_index_++, out_tensors);
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeKnownRatioNode(std::move(args),
+                                         /*ratio=*/1);
+      }
+
+      Status SaveInternal(SerializationContext* ctx,
+                          IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar(prefix(), kCurIndex, cur_index_);
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return reader->ReadScalar(prefix(), kCurIndex, &cur_index_);
+      }
+
+     private:
+      mutex mu_;
+      int64_t cur_index_ TF_GUARDED_BY(mu_) = 0;
+      std::shared_ptr<const IndexedCacheFileReader> reader_ TF_GUARDED_BY(mu_);
+    };  // IndexedFileReaderIterator
+
     Status InitializeIterator(IteratorContext* ctx)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       // We intentionally use the same prefix for both `FileReaderIterator` and
@@ -685,6 +854,11 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       // case we simply build a `FileReaderIterator` and seek to the
       // `cur_index`.
       switch (mode_) {
+        case Mode::indexed_read:
+          iterator_ = std::make_unique<IndexedFileReaderIterator>(
+              IndexedFileReaderIterator::Params{
+                  dataset(), strings::StrCat(prefix(), kImpl)});
+          break;
         case Mode::read:
           iterator_ =
               std::make_unique<FileReaderIterator>(FileReaderIterator::Params{
@@ -700,9 +874,11 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     }
 
     mutex mu_;
-    enum Mode { read, write };
+    // The values are saved in checkpoints, so new modes are added at the end.
+    enum Mode { read, write, indexed_read };
     Mode mode_ TF_GUARDED_BY(mu_);
     std::unique_ptr<IteratorBase> iterator_ TF_GUARDED_BY(mu_);
+    GlobalShuffleIterator global_shuffle_iterator_;
   };  // FileIterator
 
   Env* const env_;
@@ -711,6 +887,12 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
   static constexpr size_t kMaxItems = 10000000;  // 10 million
   const size_t item_index_padding_size_;
   const string tensor_format_string_;
+  // Whether the cache is written in the format of `IndexedCacheFileWriter`.
+  const bool use_indexed_format_;
+  absl::Status random_indexing_compatible_;
+  mutable mutex mu_;
+  mutable std::shared_ptr<const IndexedCacheFileReader> indexed_reader_
+      TF_GUARDED_BY(mu_);
 };  // FileDatasetBase
 
 class CacheDatasetOp::FileDataset : public CacheDatasetOp::FileDatasetBase {
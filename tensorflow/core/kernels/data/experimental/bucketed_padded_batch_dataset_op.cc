@@ -0,0 +1,507 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/length_bucketing.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/op_requires.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/batch_util.h"
+#include "tsl/platform/errors.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr const char kDatasetType[] = "BucketedPaddedBatch";
+constexpr const char kBucketedPaddedBatchDataset[] =
+    "BucketedPaddedBatchDataset";
+constexpr const char kTokenBudget[] = "token_budget";
+constexpr const char kMaxBatchSize[] = "max_batch_size";
+constexpr const char kNumBuckets[] = "num_buckets";
+constexpr const char kPaddingValues[] = "padding_values";
+constexpr const char kLengthComponent[] = "length_component";
+constexpr const char kInputImplEmpty[] = "input_impl_empty";
+constexpr const char kHistogramLengths[] = "histogram_lengths";
+constexpr const char kHistogramCounts[] = "histogram_counts";
+constexpr const char kBoundaries[] = "boundaries";
+constexpr const char kBucket[] = "bucket";
+
+// Batches sequences of similar length, padding every component of a batch to
+// the largest shape of that component in the batch.
+//
+// The length of an element is the size of the first dimension of its
+// `length_component` component. Elements are distributed over `num_buckets`
+// buckets by a `LengthBucketer`, whose bucket boundaries adapt to the observed
+// lengths so as to minimize padding. A bucket is emitted as a batch before it
+// would exceed `token_budget` padded values of the length component, i.e.
+// before the number of elements times the longest length in the bucket would
+// exceed the budget, or `max_batch_size` elements if that is positive. Once the
+// input is exhausted, the remaining buckets are emitted in order.
+//
+// The padding efficiency of every batch, i.e. the fraction of the values of the
+// length component that are not padding, is recorded in the
+// `/tensorflow/data/padding_efficiency` metric.
+class BucketedPaddedBatchDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit BucketedPaddedBatchDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kLengthComponent, &length_component_));
+  }
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override;
+
+ private:
+  class Dataset;
+
+  int64_t length_component_;
+};
+
+class BucketedPaddedBatchDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input, int64_t token_budget,
+          int64_t max_batch_size, int64_t num_buckets,
+          std::vector<Tensor> padding_values, int64_t length_component)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        token_budget_(token_budget),
+        max_batch_size_(max_batch_size),
+        num_buckets_(num_buckets),
+        padding_values_(std::move(padding_values)),
+        length_component_(length_component) {
+    input_->Ref();
+    output_shapes_.reserve(input_->output_shapes().size());
+    for (const PartialTensorShape& shape : input_->output_shapes()) {
+      output_shapes_.push_back(
+          PartialTensorShape({-1}).Concatenate(shape));
+    }
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  std::string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64_t CardinalityInternal(CardinalityOptions options) const override {
+    const int64_t n = input_->Cardinality(options);
+    return n == 0 || n == kInfiniteCardinality ? n : kUnknownCardinality;
+  }
+
+  absl::Status InputDatasets(
+      std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return absl::OkStatus();
+  }
+
+  absl::Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const std::string& prefix) const override;
+
+  absl::Status AsGraphDefInternal(SerializationContext* ctx,
+                                  DatasetGraphDefBuilder* b,
+                                  Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* token_budget_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(token_budget_, &token_budget_node));
+    Node* max_batch_size_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(max_batch_size_, &max_batch_size_node));
+    Node* num_buckets_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(num_buckets_, &num_buckets_node));
+    std::vector<Node*> padding_values;
+    padding_values.reserve(padding_values_.size());
+    for (const Tensor& t : padding_values_) {
+      Node* node;
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padding_values.emplace_back(node);
+    }
+    AttrValue output_types;
+    b->BuildAttrValue(output_dtypes(), &output_types);
+    AttrValue length_component;
+    b->BuildAttrValue(length_component_, &length_component);
+    return b->AddDataset(
+        this,
+        {{0, input_graph_node},
+         {1, token_budget_node},
+         {2, max_batch_size_node},
+         {3, num_buckets_node}},
+        {{4, padding_values}},
+        {{kLengthComponent, length_component},
+         {"Toutput_types", output_types}},
+        output);
+  }
+
+ private:
+  class Iterator;
+
+  const DatasetBase* const input_;
+  const int64_t token_budget_;
+  const int64_t max_batch_size_;
+  const int64_t num_buckets_;
+  const std::vector<Tensor> padding_values_;
+  const int64_t length_component_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+class BucketedPaddedBatchDatasetOp::Dataset::Iterator
+    : public DatasetIterator<Dataset> {
+ public:
+  explicit Iterator(const Params& params)
+      : DatasetIterator<Dataset>(params),
+        bucketer_(params.dataset->num_buckets_),
+        buckets_(params.dataset->num_buckets_) {}
+
+  absl::Status Initialize(IteratorContext* ctx) override {
+    return dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_);
+  }
+
+  absl::Status GetNextInternal(IteratorContext* ctx,
+                               std::vector<Tensor>* out_tensors,
+                               bool* end_of_sequence) override {
+    Bucket batch;
+    {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(NextBatch(ctx, &batch));
+    }
+    if (batch.elements.empty()) {
+      *end_of_sequence = true;
+      return absl::OkStatus();
+    }
+    metrics::RecordTFDataPaddingEfficiency(
+        kDatasetType,
+        PaddingEfficiency(batch.total_length,
+                          batch.elements.size() * batch.max_length));
+    *end_of_sequence = false;
+    return CopyBatch(ctx, batch.elements, out_tensors);
+  }
+
+ protected:
+  std::shared_ptr<model::Node> CreateNode(
+      IteratorContext* ctx, model::Node::Args args) const override {
+    return model::MakeUnknownRatioNode(std::move(args));
+  }
+
+  absl::Status SaveInternal(SerializationContext* ctx,
+                            IteratorStateWriter* writer) override {
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(writer->WriteScalar(
+        prefix(), kInputImplEmpty, static_cast<int64_t>(!input_impl_)));
+    if (input_impl_) {
+      TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+    }
+    const absl::btree_map<int64_t, int64_t>& histogram = bucketer_.histogram();
+    Tensor lengths(DT_INT64, TensorShape({static_cast<int64_t>(
+                                 histogram.size())}));
+    Tensor counts(DT_INT64, lengths.shape());
+    int64_t i = 0;
+    for (const auto& [length, count] : histogram) {
+      lengths.vec<int64_t>()(i) = length;
+      counts.vec<int64_t>()(i) = count;
+      ++i;
+    }
+    TF_RETURN_IF_ERROR(writer->WriteTensor(prefix(), kHistogramLengths,
+                                           lengths));
+    TF_RETURN_IF_ERROR(writer->WriteTensor(prefix(), kHistogramCounts, counts));
+    const std::vector<int64_t>& boundaries = bucketer_.boundaries();
+    Tensor boundaries_t(DT_INT64, TensorShape({static_cast<int64_t>(
+                                      boundaries.size())}));
+    std::copy(boundaries.begin(), boundaries.end(),
+              boundaries_t.vec<int64_t>().data());
+    TF_RETURN_IF_ERROR(
+        writer->WriteTensor(prefix(), kBoundaries, boundaries_t));
+    for (int64_t b = 0; b < buckets_.size(); ++b) {
+      TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(
+          writer, BucketPrefix(b), buckets_[b].elements));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status RestoreInternal(IteratorContext* ctx,
+                               IteratorStateReader* reader) override {
+    mutex_lock l(mu_);
+    int64_t input_empty;
+    TF_RETURN_IF_ERROR(
+        reader->ReadScalar(prefix(), kInputImplEmpty, &input_empty));
+    if (static_cast<bool>(input_empty)) {
+      input_impl_.reset();
+    } else {
+      TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+    }
+    Tensor lengths, counts, boundaries_t;
+    TF_RETURN_IF_ERROR(reader->ReadTensor(prefix(), kHistogramLengths,
+                                          &lengths));
+    TF_RETURN_IF_ERROR(reader->ReadTensor(prefix(), kHistogramCounts, &counts));
+    TF_RETURN_IF_ERROR(
+        reader->ReadTensor(prefix(), kBoundaries, &boundaries_t));
+    absl::btree_map<int64_t, int64_t> histogram;
+    for (int64_t i = 0; i < lengths.NumElements(); ++i) {
+      histogram[lengths.vec<int64_t>()(i)] = counts.vec<int64_t>()(i);
+    }
+    auto boundaries = boundaries_t.vec<int64_t>();
+    bucketer_.Restore(std::move(histogram),
+                      std::vector<int64_t>(boundaries.data(),
+                                           boundaries.data() +
+                                               boundaries.size()));
+    for (int64_t b = 0; b < buckets_.size(); ++b) {
+      Bucket& bucket = buckets_[b];
+      bucket = Bucket();
+      std::vector<std::vector<Tensor>> elements;
+      TF_RETURN_IF_ERROR(
+          ReadElementsFromCheckpoint(ctx, reader, BucketPrefix(b), &elements));
+      for (std::vector<Tensor>& element : elements) {
+        int64_t length;
+        TF_RETURN_IF_ERROR(SequenceLength(element, &length));
+        bucket.Add(std::move(element), length);
+      }
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  // The buffered elements of a bucket, or the elements of a batch.
+  struct Bucket {
+    void Add(std::vector<Tensor> element, int64_t length) {
+      elements.push_back(std::move(element));
+      max_length = std::max(max_length, length);
+      total_length += length;
+    }
+
+    std::vector<std::vector<Tensor>> elements;
+    // The longest and total length of `elements`.
+    int64_t max_length = 0;
+    int64_t total_length = 0;
+  };
+
+  std::string BucketPrefix(int64_t bucket) const {
+    return absl::StrCat(prefix(), "_", kBucket, "_", bucket);
+  }
+
+  // Returns in `*length` the length of the sequence `element`.
+  absl::Status SequenceLength(const std::vector<Tensor>& element,
+                              int64_t* length) const {
+    const Tensor& t = element[dataset()->length_component_];
+    if (t.dims() < 1) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Component ", dataset()->length_component_,
+          " of the elements of ", kBucketedPaddedBatchDataset,
+          " must have rank of at least 1 to determine their length."));
+    }
+    *length = t.dim_size(0);
+    return absl::OkStatus();
+  }
+
+  // Returns whether a sequence of `length` may be added to `bucket` without
+  // exceeding the batch limits.
+  bool Fits(const Bucket& bucket, int64_t length) const {
+    const int64_t size = bucket.elements.size();
+    if (dataset()->max_batch_size_ > 0 && size >= dataset()->max_batch_size_) {
+      return false;
+    }
+    return (size + 1) * std::max(bucket.max_length, length) <=
+           dataset()->token_budget_;
+  }
+
+  // Moves the next batch to `*batch`, which is left empty at the end of the
+  // sequence.
+  absl::Status NextBatch(IteratorContext* ctx, Bucket* batch)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    while (input_impl_) {
+      std::vector<Tensor> element;
+      bool end_of_input = false;
+      TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &element, &end_of_input));
+      if (end_of_input) {
+        input_impl_.reset();
+        break;
+      }
+      int64_t length;
+      TF_RETURN_IF_ERROR(SequenceLength(element, &length));
+      Bucket& bucket = buckets_[bucketer_.Observe(length)];
+      const bool full = !bucket.elements.empty() && !Fits(bucket, length);
+      if (full) std::swap(*batch, bucket);
+      bucket.Add(std::move(element), length);
+      if (full) return absl::OkStatus();
+    }
+    for (Bucket& bucket : buckets_) {
+      if (!bucket.elements.empty()) {
+        std::swap(*batch, bucket);
+        return absl::OkStatus();
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Copies `elements` into one output tensor per component, padding each
+  // component to the largest shape of that component in the batch.
+  absl::Status CopyBatch(IteratorContext* ctx,
+                         const std::vector<std::vector<Tensor>>& elements,
+                         std::vector<Tensor>* out_tensors) {
+    const int64_t num_elements = elements.size();
+    const size_t num_components = elements[0].size();
+    out_tensors->reserve(num_components);
+    for (size_t component = 0; component < num_components; ++component) {
+      TensorShape element_shape = elements[0][component].shape();
+      bool needs_padding = false;
+      for (int64_t i = 1; i < num_elements; ++i) {
+        const TensorShape& shape = elements[i][component].shape();
+        if (shape.dims() != element_shape.dims()) {
+          return absl::InvalidArgumentError(absl::StrCat(
+              "All elements in a batch must have the same rank for component ",
+              component, ": expected rank ", element_shape.dims(),
+              " but got element with rank ", shape.dims()));
+        }
+        for (int dim = 0; dim < shape.dims(); ++dim) {
+          if (shape.dim_size(dim) != element_shape.dim_size(dim)) {
+            needs_padding = true;
+            element_shape.set_dim(dim, std::max(shape.dim_size(dim),
+                                                element_shape.dim_size(dim)));
+          }
+        }
+      }
+      TensorShape batch_shape({num_elements});
+      batch_shape.AppendShape(element_shape);
+      out_tensors->emplace_back(ctx->allocator({}), output_dtypes()[component],
+                                batch_shape);
+      Tensor& batch_component = out_tensors->back();
+      if (needs_padding) {
+        TF_RETURN_IF_ERROR(batch_util::SetElementZero(
+            &batch_component, dataset()->padding_values_[component]));
+      }
+      for (int64_t i = 0; i < num_elements; ++i) {
+        const Tensor& t = elements[i][component];
+        if (t.shape() == element_shape) {
+          TF_RETURN_IF_ERROR(
+              batch_util::CopyElementToSlice(t, &batch_component, i));
+        } else {
+          TF_RETURN_IF_ERROR(
+              batch_util::CopyElementToLargerSlice(t, &batch_component, i));
+        }
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  mutex mu_;
+  std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+  LengthBucketer bucketer_ TF_GUARDED_BY(mu_);
+  std::vector<Bucket> buckets_ TF_GUARDED_BY(mu_);
+};
+
+std::unique_ptr<IteratorBase>
+BucketedPaddedBatchDatasetOp::Dataset::MakeIteratorInternal(
+    const std::string& prefix) const {
+  return std::make_unique<Iterator>(
+      Iterator::Params{this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+}
+
+void BucketedPaddedBatchDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                               DatasetBase* input,
+                                               DatasetBase** output) {
+  int64_t token_budget;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<int64_t>(ctx, kTokenBudget, &token_budget));
+  OP_REQUIRES(ctx, token_budget > 0,
+              absl::InvalidArgumentError(absl::StrCat(
+                  "`token_budget` must be greater than zero. Got ",
+                  token_budget)));
+  int64_t max_batch_size;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<int64_t>(ctx, kMaxBatchSize, &max_batch_size));
+  int64_t num_buckets;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<int64_t>(ctx, kNumBuckets, &num_buckets));
+  OP_REQUIRES(ctx, num_buckets > 0,
+              absl::InvalidArgumentError(absl::StrCat(
+                  "`num_buckets` must be greater than zero. Got ",
+                  num_buckets)));
+  OP_REQUIRES(ctx,
+              length_component_ >= 0 &&
+                  length_component_ < input->output_dtypes().size(),
+              absl::InvalidArgumentError(absl::StrCat(
+                  "`length_component` must be the index of a component of "
+                  "the input elements. Got ",
+                  length_component_)));
+
+  OpInputList padding_values_list;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kPaddingValues, &padding_values_list));
+  OP_REQUIRES(ctx, padding_values_list.size() == input->output_dtypes().size(),
+              absl::InvalidArgumentError(absl::StrCat(
+                  "Number of padding values (", padding_values_list.size(),
+                  ") must match the number of components in the input "
+                  "dataset's elements (",
+                  input->output_dtypes().size(), ")")));
+  std::vector<Tensor> padding_values;
+  padding_values.reserve(padding_values_list.size());
+  for (int i = 0; i < padding_values_list.size(); ++i) {
+    const Tensor& padding_value_t = padding_values_list[i];
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+                absl::InvalidArgumentError(absl::StrCat(
+                    "All padding values must be scalars; found a padding "
+                    "value of shape ",
+                    padding_value_t.shape().DebugString())));
+    OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i],
+                absl::InvalidArgumentError(absl::StrCat(
+                    "Mismatched type between padding value ", i,
+                    " and input dataset's component ", i, ": ",
+                    DataTypeString(padding_value_t.dtype()), " vs. ",
+                    DataTypeString(input->output_dtypes()[i]))));
+    padding_values.push_back(tensor::DeepCopy(padding_value_t));
+  }
+
+  *output = new Dataset(ctx, input, token_budget, max_batch_size, num_buckets,
+                        std::move(padding_values), length_component_);
+}
+
+REGISTER_KERNEL_BUILDER(Name(kBucketedPaddedBatchDataset).Device(DEVICE_CPU),
+                        BucketedPaddedBatchDatasetOp);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -24,8 +24,23 @@ namespace tensorflow {
 namespace data {
 namespace experimental {
 
+namespace {
+
+// Elements compressed with zstd are split into chunks of this many bytes, which
+// are compressed and uncompressed in parallel.
+constexpr int64_t kZstdChunkBytes = 4 << 20;
+
+}  // namespace
+
 CompressElementOp::CompressElementOp(OpKernelConstruction* ctx)
-    : OpKernel(ctx) {}
+    : OpKernel(ctx) {
+  std::string compression;
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kCompression, &compression));
+  if (compression == "ZSTD") {
+    options_.codec = CompressedElement::CODEC_ZSTD;
+    options_.chunk_bytes = kZstdChunkBytes;
+  }
+}
 
 void CompressElementOp::Compute(OpKernelContext* ctx) {
   std::vector<Tensor> components;
@@ -34,7 +49,7 @@ void CompressElementOp::Compute(OpKernelContext* ctx) {
     components.push_back(ctx->input(i));
   }
   CompressedElement compressed;
-  OP_REQUIRES_OK(ctx, CompressElement(components, &compressed));
+  OP_REQUIRES_OK(ctx, CompressElement(components, options_, &compressed));
 
   Tensor* output;
   OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/kernels/csv_parsing.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
@@ -520,6 +521,15 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          // Skip ahead to the next quote, which is the only character that
+          // can end the field.
+          const size_t quote = StringPiece(buffer_).find('"', pos_);
+          if (quote == StringPiece::npos) {
+            pos_ = buffer_.size();
+            continue;
+          }
+          pos_ = quote;
+
           char ch = buffer_[pos_];
           if (ch == '"') {
             // When we encounter a quote, we look ahead to the next character to
@@ -657,6 +667,15 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          // Skip ahead to the next character that ends the field or is a
+          // quote. Without quote delimiting, quotes are ordinary characters,
+          // and searching for the delimiter twice stands in for them.
+          const char quote =
+              dataset()->use_quote_delim_ ? '"' : dataset()->delim_;
+          pos_ += FindFirstOfFour(StringPiece(buffer_).substr(pos_),
+                                  dataset()->delim_, quote, '\n', '\r');
+          if (pos_ >= buffer_.size()) continue;
+
           char ch = buffer_[pos_];
 
           if (ch == dataset()->delim_) {
@@ -730,7 +749,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<int32>()(0);
             } else {
               int32_t value;
-              if (!strings::safe_strto32(field, &value)) {
+              if (!ParseCsvInt32(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid int32: ", field);
@@ -745,7 +764,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<int64_t>()(0);
             } else {
               int64_t value;
-              if (!strings::safe_strto64(field, &value)) {
+              if (!ParseCsvInt64(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid int64: ", field);
@@ -760,7 +779,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<float>()(0);
             } else {
               float value;
-              if (!strings::safe_strtof(field, &value)) {
+              if (!ParseCsvFloat(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid float: ", field);
@@ -775,7 +794,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<double>()(0);
             } else {
               double value;
-              if (!strings::safe_strtod(field, &value)) {
+              if (!ParseCsvDouble(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid double: ", field);
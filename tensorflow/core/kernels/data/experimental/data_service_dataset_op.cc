@@ -163,16 +163,18 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
 
   std::unique_ptr<IteratorBase> MakeIteratorInternal(
       const string& prefix) const override {
+    DataServiceParams params{
+        dataset_id_, processing_mode_, address_, protocol_,
+        data_transfer_protocol_, job_name_,
+        /*repetition=*/iteration_counter_->GetAndIncrement(), num_consumers_,
+        consumer_index_, max_outstanding_requests_, task_refresh_interval_,
+        target_workers_, metadata_, cross_trainer_cache_options_};
+    params.hedge_requests =
+        GetExperiments().contains("data_service_hedged_requests");
     return std::make_unique<Iterator>(
         Iterator::Params{this,
                          name_utils::IteratorPrefix(kDatasetType, prefix)},
-        DataServiceParams{dataset_id_, processing_mode_, address_, protocol_,
-                          data_transfer_protocol_, job_name_,
-                          /*repetition=*/iteration_counter_->GetAndIncrement(),
-                          num_consumers_, consumer_index_,
-                          max_outstanding_requests_, task_refresh_interval_,
-                          target_workers_, metadata_,
-                          cross_trainer_cache_options_});
+        params);
   }
 
   const DataTypeVector& output_dtypes() const override { return output_types_; }
@@ -700,7 +702,8 @@ void DataServiceDatasetOp::MakeDataset(OpKernelContext* ctx,
     OP_REQUIRES_OK(ctx, compression.status());
     should_uncompress =
         should_uncompress &&
-        (*compression == DataServiceMetadata::COMPRESSION_SNAPPY);
+        (*compression == DataServiceMetadata::COMPRESSION_SNAPPY ||
+         *compression == DataServiceMetadata::COMPRESSION_ZSTD);
   }
   if (should_uncompress) {
     absl::StatusOr<bool> disable_compression_at_runtime =
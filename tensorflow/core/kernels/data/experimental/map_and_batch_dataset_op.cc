@@ -16,7 +16,9 @@ limitations under the License.
 
 #include <atomic>
 #include <functional>
+#include <optional>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/input_colocation_exemption_registry.h"
@@ -95,6 +97,7 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
         drop_remainder_(drop_remainder),
         output_types_(output_types),
         output_shapes_(output_shapes),
+        static_element_shapes_(ComputeStaticElementShapes(output_shapes)),
         captured_func_(std::move(captured_func)),
         preserve_cardinality_(preserve_cardinality),
         traceme_metadata_(
@@ -116,6 +119,26 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
 
   const DataTypeVector& output_dtypes() const override { return output_types_; }
 
+  // Returns the shapes of the components of a batch element if they are all
+  // fully defined, and nullopt otherwise.
+  static std::optional<std::vector<TensorShape>> ComputeStaticElementShapes(
+      const std::vector<PartialTensorShape>& batch_shapes) {
+    std::vector<TensorShape> element_shapes;
+    element_shapes.reserve(batch_shapes.size());
+    for (const PartialTensorShape& batch_shape : batch_shapes) {
+      if (batch_shape.unknown_rank() || batch_shape.dims() < 1) {
+        return std::nullopt;
+      }
+      TensorShape element_shape;
+      for (int i = 1; i < batch_shape.dims(); ++i) {
+        if (batch_shape.dim_size(i) < 0) return std::nullopt;
+        element_shape.AddDim(batch_shape.dim_size(i));
+      }
+      element_shapes.push_back(std::move(element_shape));
+    }
+    return element_shapes;
+  }
+
   const std::vector<PartialTensorShape>& output_shapes() const override {
     return output_shapes_;
   }
@@ -446,45 +469,31 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
         return;
       }
 
+      if (dataset()->static_element_shapes_.has_value()) {
+        CallFunctionWithStaticShapes(std::move(ctx), result, offset,
+                                     std::move(input_element));
+        return;
+      }
+
       std::shared_ptr<std::vector<Tensor>> return_values =
           std::make_shared<std::vector<Tensor>>();
       auto done = [this, ctx, result, return_values, offset](Status status) {
-        if (dataset()->preserve_cardinality_ && errors::IsOutOfRange(status)) {
-          // To guarantee that the transformation preserves the cardinality of
-          // the dataset, we convert `OutOfRange` to `InvalidArgument` as the
-          // former may be interpreted by a caller as the end of sequence.
-          status = errors::InvalidArgument(
-              "Function invocation produced OutOfRangeError: ",
-              status.message());
-        }
+        status = MaybeConvertOutOfRange(std::move(status));
         result->UpdateStatus(status, offset);
         if (status.ok()) {
+          std::vector<TensorShape> element_shapes;
+          element_shapes.reserve(return_values->size());
+          for (const Tensor& tensor : *return_values) {
+            element_shapes.push_back(tensor.shape());
+          }
           Status allocate_status =
-              EnsureOutputAllocated(ctx, result, return_values);
+              EnsureOutputAllocated(ctx, result, element_shapes);
           if (!allocate_status.ok()) {
             result->UpdateStatus(allocate_status, offset);
           } else {
             for (size_t i = 0; i < return_values->size(); ++i) {
-              Tensor& tensor = return_values->at(i);
-              Tensor* batch = &(result->output)[i];
-              if (tensor.NumElements() !=
-                  (batch->NumElements() / batch->dim_size(0))) {
-                TensorShape batch_shape = batch->shape();
-                batch_shape.RemoveDim(0);
-                result->UpdateStatus(
-                    errors::InvalidArgument(
-                        "Cannot add tensor to the batch: number of elements "
-                        "does not match. Shapes are: [tensor]: ",
-                        tensor.shape().DebugString(),
-                        ", [batch]: ", batch_shape.DebugString()),
-                    offset);
-                break;
-              }
-              // TODO(mrry): Add a version of DoParallelConcat that allows us
-              // to move `tensor` where possible, to speed up string tensor
-              // batching.
-              Status copy_status = batch_util::CopyElementToSlice(
-                  std::move(tensor), batch, offset);
+              Status copy_status = CopyToBatch(std::move(return_values->at(i)),
+                                               &(result->output)[i], offset);
               if (!copy_status.ok()) {
                 result->UpdateStatus(copy_status, offset);
                 break;
@@ -506,6 +515,68 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
                                             std::move(done), model_node());
     }
 
+    // When the shapes of the function outputs are known up front, the batch
+    // is allocated before the function runs, and each output is copied into
+    // its slice of the batch as soon as the function produces it, rather
+    // than after the whole function has returned.
+    void CallFunctionWithStaticShapes(
+        std::shared_ptr<IteratorContext> ctx,
+        const std::shared_ptr<BatchResult>& result, int64_t offset,
+        std::vector<Tensor> input_element) TF_LOCKS_EXCLUDED(*mu_) {
+      Status allocate_status = EnsureOutputAllocated(
+          ctx, result, *dataset()->static_element_shapes_);
+      if (!allocate_status.ok()) {
+        result->UpdateStatus(allocate_status, offset);
+        CallCompleted(ctx, result);
+        return;
+      }
+      // The batch tensors are not reallocated once allocated, and each
+      // invocation only writes to its own slice.
+      std::vector<Tensor>* batch = &result->output;
+      auto retval_sink = [batch, offset](int index,
+                                         const Tensor& value) -> Status {
+        return CopyToBatch(value, &(*batch)[index], offset);
+      };
+      auto done = [this, ctx, result, offset](Status status) {
+        status = MaybeConvertOutOfRange(std::move(status));
+        result->UpdateStatus(status, offset);
+        if (status.ok()) {
+          mutex_lock l(result->mu);
+          result->num_elements++;
+        }
+        CallCompleted(ctx, result);
+      };
+      instantiated_captured_func_->RunAsyncWithRetvalSink(
+          ctx.get(), std::move(input_element), std::move(retval_sink),
+          std::move(done), model_node());
+    }
+
+    Status MaybeConvertOutOfRange(Status status) const {
+      if (dataset()->preserve_cardinality_ && errors::IsOutOfRange(status)) {
+        // To guarantee that the transformation preserves the cardinality of
+        // the dataset, we convert `OutOfRange` to `InvalidArgument` as the
+        // former may be interpreted by a caller as the end of sequence.
+        return errors::InvalidArgument(
+            "Function invocation produced OutOfRangeError: ", status.message());
+      }
+      return status;
+    }
+
+    static Status CopyToBatch(Tensor tensor, Tensor* batch, int64_t offset) {
+      if (tensor.NumElements() != (batch->NumElements() / batch->dim_size(0))) {
+        TensorShape batch_shape = batch->shape();
+        batch_shape.RemoveDim(0);
+        return errors::InvalidArgument(
+            "Cannot add tensor to the batch: number of elements does not "
+            "match. Shapes are: [tensor]: ",
+            tensor.shape().DebugString(), ", [batch]: ",
+            batch_shape.DebugString());
+      }
+      // TODO(mrry): Add a version of DoParallelConcat that allows us to move
+      // `tensor` where possible, to speed up string tensor batching.
+      return batch_util::CopyElementToSlice(std::move(tensor), batch, offset);
+    }
+
     void CancelThreads(bool wait) TF_LOCKS_EXCLUDED(mu_) {
       cancellation_manager_->StartCancel();
       mutex_lock l(*mu_);
@@ -530,20 +601,20 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
     Status EnsureOutputAllocated(
         const std::shared_ptr<IteratorContext>& ctx,
         const std::shared_ptr<BatchResult>& result,
-        const std::shared_ptr<std::vector<Tensor>>& return_values) {
+        const std::vector<TensorShape>& element_shapes) {
       mutex_lock l(result->mu);
       if (result->output_allocated) {
         return absl::OkStatus();
       }
-      const size_t num_components = return_values->size();
+      const size_t num_components = element_shapes.size();
       result->output.reserve(num_components);
       for (size_t i = 0; i < num_components; ++i) {
         TensorShape component_shape({dataset()->batch_size_});
-        component_shape.AppendShape(return_values->at(i).shape());
+        component_shape.AppendShape(element_shapes[i]);
         AllocatorAttributes attr;
         attr.set_gpu_compatible(true);
         result->output.emplace_back(ctx->allocator(attr),
-                                    return_values->at(i).dtype(),
+                                    dataset()->output_types_[i],
                                     component_shape);
         if (!result->output.back().IsInitialized()) {
           return errors::ResourceExhausted(
@@ -731,6 +802,8 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
   const bool drop_remainder_;
   const DataTypeVector output_types_;
   const std::vector<PartialTensorShape> output_shapes_;
+  // Set if the shapes of the function outputs are fully defined.
+  const std::optional<std::vector<TensorShape>> static_element_shapes_;
   const std::unique_ptr<CapturedFunction> captured_func_;
   const bool preserve_cardinality_;
   const TraceMeMetadata traceme_metadata_;
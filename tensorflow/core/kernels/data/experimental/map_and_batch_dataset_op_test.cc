@@ -241,6 +241,83 @@ MapAndBatchDatasetParams InvalidBatchSizeMapAndBatchDatasetParams() {
       /*node_name=*/kNodeName);
 }
 
+// Returns `x * 2` and `x * 4`.
+FunctionDef XTimesTwoAndFour() {
+  return FunctionDefHelper::Define(
+      // Name
+      "XTimesTwoAndFour",
+      // Args
+      {"x: int64"},
+      // Return values
+      {"y: int64", "z: int64"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"two"},
+        "Const",
+        {},
+        {{"value", test::AsScalar<int64_t>(2)}, {"dtype", DT_INT64}}},
+       {{"four"},
+        "Const",
+        {},
+        {{"value", test::AsScalar<int64_t>(4)}, {"dtype", DT_INT64}}},
+       {{"y"}, "Mul", {"x", "two"}, {{"T", DT_INT64}}},
+       {{"z"}, "Mul", {"x", "four"}, {{"T", DT_INT64}}}});
+}
+
+// The function has two outputs with static shapes, each of which is written
+// into its own preallocated batch.
+MapAndBatchDatasetParams MultipleOutputsMapAndBatchDatasetParams() {
+  return MapAndBatchDatasetParams(
+      RangeDatasetParams(0, 6, 1),
+      /*other_arguments=*/{},
+      /*batch_size=*/3,
+      /*num_parallel_calls=*/2,
+      /*drop_remainder=*/false,
+      /*func=*/FunctionDefHelper::FunctionRef("XTimesTwoAndFour"),
+      /*func_lib=*/{XTimesTwoAndFour()},
+      /*type_arguments*/ {},
+      /*preserve_cardinality=*/true,
+      /*output_dtypes=*/{DT_INT64, DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({3}), PartialTensorShape({3})},
+      /*node_name=*/kNodeName);
+}
+
+// The output shape is unknown, so the batch is allocated from the shapes that
+// the function returns.
+MapAndBatchDatasetParams DynamicShapeMapAndBatchDatasetParams() {
+  return MapAndBatchDatasetParams(RangeDatasetParams(0, 10, 2),
+                                  /*other_arguments=*/{},
+                                  /*batch_size=*/2,
+                                  /*num_parallel_calls=*/2,
+                                  /*drop_remainder=*/true,
+                                  /*func=*/MapFunc("XTimesTwo", DT_INT64),
+                                  /*func_lib=*/{test::function::XTimesTwo()},
+                                  /*type_arguments*/ {},
+                                  /*preserve_cardinality=*/true,
+                                  /*output_dtypes=*/{DT_INT64},
+                                  /*output_shapes=*/{PartialTensorShape()},
+                                  /*node_name=*/kNodeName);
+}
+
+// The output shape declares vectors of three elements, but the function
+// returns scalars.
+MapAndBatchDatasetParams StaticShapeMismatchMapAndBatchDatasetParams() {
+  return MapAndBatchDatasetParams(
+      RangeDatasetParams(0, 10, 2),
+      /*other_arguments=*/{},
+      /*batch_size=*/2,
+      /*num_parallel_calls=*/2,
+      /*drop_remainder=*/true,
+      /*func=*/MapFunc("XTimesTwo", DT_INT64),
+      /*func_lib=*/{test::function::XTimesTwo()},
+      /*type_arguments*/ {},
+      /*preserve_cardinality=*/true,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({2, 3})},
+      /*node_name=*/kNodeName);
+}
+
 std::vector<GetNextTestCase<MapAndBatchDatasetParams>> GetNextTestCases() {
   return {{/*dataset_params=*/MapAndBatchDatasetParams1(),
            /*expected_outputs=*/
@@ -419,6 +496,40 @@ TEST_F(MapAndBatchDatasetOpTest, InvalidNumParallel) {
             absl::StatusCode::kInvalidArgument);
 }
 
+
+TEST_F(MapAndBatchDatasetOpTest, MultipleOutputsWithStaticShapes) {
+  auto dataset_params = MultipleOutputsMapAndBatchDatasetParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      /*expected_outputs=*/
+      {CreateTensor<int64_t>(TensorShape({3}), {0, 2, 4}),
+       CreateTensor<int64_t>(TensorShape({3}), {0, 4, 8}),
+       CreateTensor<int64_t>(TensorShape({3}), {6, 8, 10}),
+       CreateTensor<int64_t>(TensorShape({3}), {12, 16, 20})},
+      /*compare_order=*/true));
+}
+
+TEST_F(MapAndBatchDatasetOpTest, DynamicShape) {
+  auto dataset_params = DynamicShapeMapAndBatchDatasetParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      /*expected_outputs=*/CreateTensors<int64_t>(TensorShape({2}),
+                                                  {{0, 4}, {8, 12}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(MapAndBatchDatasetOpTest, StaticShapeMismatch) {
+  auto dataset_params = StaticShapeMismatchMapAndBatchDatasetParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  Status status =
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(),
+              ::testing::HasSubstr("number of elements does not match"));
+}
+
 }  // namespace
 }  // namespace experimental
 }  // namespace data
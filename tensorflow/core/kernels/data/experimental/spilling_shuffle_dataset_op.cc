@@ -0,0 +1,292 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/spilling_shuffle_buffer.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/op_requires.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/data/random_seed_ops.h"
+#include "tensorflow/core/platform/random.h"
+#include "tsl/platform/errors.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr const char kDatasetType[] = "SpillingShuffle";
+constexpr const char kSpillingShuffleDataset[] = "SpillingShuffleDataset";
+constexpr const char kBufferSize[] = "buffer_size";
+constexpr const char kSeed[] = "seed";
+constexpr const char kSeed2[] = "seed2";
+constexpr const char kSpillDirectory[] = "spill_directory";
+constexpr const char kBuffer[] = "buffer";
+constexpr const char kNumWindows[] = "num_windows";
+constexpr const char kInputImplEmpty[] = "input_impl_empty";
+
+// Folds a 64-bit seed into 32 bits for `random::index_shuffle`.
+uint32_t FoldSeed(int64_t seed) {
+  return static_cast<uint32_t>(seed) ^ static_cast<uint32_t>(seed >> 32);
+}
+
+// Shuffles its input with a `SpillingShuffleBuffer`, so that the buffer may be
+// much larger than the available memory.
+//
+// The input is consumed in windows of `buffer_size` elements. While the
+// elements of one window are produced in the order of a random permutation,
+// the next window is filled, one input element per output element. Every
+// iterator uses the same seeds, i.e. the order does not change between epochs.
+class SpillingShuffleDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit SpillingShuffleDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {}
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override;
+
+ private:
+  class Dataset;
+};
+
+class SpillingShuffleDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input, int64_t buffer_size,
+          RandomSeeds&& seeds, std::string spill_directory)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        buffer_size_(buffer_size),
+        seeds_(std::move(seeds)),
+        spill_directory_(std::move(spill_directory)) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  std::string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64_t CardinalityInternal(CardinalityOptions options) const override {
+    return input_->Cardinality(options);
+  }
+
+  absl::Status InputDatasets(
+      std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return absl::OkStatus();
+  }
+
+  absl::Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const std::string& prefix) const override;
+
+  absl::Status AsGraphDefInternal(SerializationContext* ctx,
+                                  DatasetGraphDefBuilder* b,
+                                  Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* buffer_size_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size_node));
+    Node* seed_node = nullptr;
+    Node* seed2_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.input_seed(), &seed_node));
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.input_seed2(), &seed2_node));
+    Node* spill_directory_node = nullptr;
+    TF_RETURN_IF_ERROR(
+        b->AddScalar(tstring(spill_directory_), &spill_directory_node));
+    return b->AddDataset(this,
+                         {input_graph_node, buffer_size_node, seed_node,
+                          seed2_node, spill_directory_node},
+                         output);
+  }
+
+ private:
+  class Iterator;
+
+  const DatasetBase* const input_;
+  const int64_t buffer_size_;
+  const RandomSeeds seeds_;
+  const std::string spill_directory_;
+};
+
+class SpillingShuffleDatasetOp::Dataset::Iterator
+    : public DatasetIterator<Dataset> {
+ public:
+  explicit Iterator(const Params& params) : DatasetIterator<Dataset>(params) {}
+
+  absl::Status Initialize(IteratorContext* ctx) override
+      ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    TF_RETURN_IF_ERROR(
+        ctx->env()->RecursivelyCreateDir(dataset()->spill_directory_));
+    SpillingShuffleBuffer::Options options;
+    options.directory = dataset()->spill_directory_;
+    options.file_prefix =
+        absl::StrCat("spilling_shuffle_", absl::Hex(random::New64()));
+    buffer_ = std::make_unique<SpillingShuffleBuffer>(ctx->env(),
+                                                      std::move(options));
+    return dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_);
+  }
+
+  absl::Status GetNextInternal(IteratorContext* ctx,
+                               std::vector<Tensor>* out_tensors,
+                               bool* end_of_sequence) override
+      ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    if (buffer_->ServingRemaining() == 0) {
+      // Top up the filling window (this only reads more than one element for
+      // the first window) and start serving it.
+      while (input_impl_ && buffer_->FillingSize() < dataset()->buffer_size_) {
+        TF_RETURN_IF_ERROR(FillOne(ctx));
+      }
+      if (buffer_->FillingSize() == 0) {
+        *end_of_sequence = true;
+        return absl::OkStatus();
+      }
+      const int64_t window = num_windows_++;
+      TF_RETURN_IF_ERROR(buffer_->StartNextWindow(
+          {FoldSeed(dataset()->seeds_.seed()),
+           FoldSeed(dataset()->seeds_.seed2()), FoldSeed(window)}));
+    }
+    TF_RETURN_IF_ERROR(buffer_->GetNext(out_tensors));
+    if (input_impl_ && buffer_->FillingSize() < dataset()->buffer_size_) {
+      TF_RETURN_IF_ERROR(FillOne(ctx));
+    }
+    *end_of_sequence = false;
+    return absl::OkStatus();
+  }
+
+ protected:
+  std::shared_ptr<model::Node> CreateNode(
+      IteratorContext* ctx, model::Node::Args args) const override {
+    return model::MakeKnownRatioNode(std::move(args),
+                                     /*ratio=*/1);
+  }
+
+  absl::Status SaveInternal(SerializationContext* ctx,
+                            IteratorStateWriter* writer) override
+      ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    TF_RETURN_IF_ERROR(
+        writer->WriteScalar(prefix(), kNumWindows, num_windows_));
+    TF_RETURN_IF_ERROR(writer->WriteScalar(
+        prefix(), kInputImplEmpty, static_cast<int64_t>(!input_impl_)));
+    if (input_impl_) {
+      TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+    }
+    // Only the index of the buffer is checkpointed. The buffer keeps the
+    // segments it references, also past this iterator, until the next save.
+    return buffer_->Save(absl::StrCat(prefix(), "_", kBuffer), writer);
+  }
+
+  absl::Status RestoreInternal(IteratorContext* ctx,
+                               IteratorStateReader* reader) override
+      ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    TF_RETURN_IF_ERROR(
+        reader->ReadScalar(prefix(), kNumWindows, &num_windows_));
+    int64_t input_empty;
+    TF_RETURN_IF_ERROR(
+        reader->ReadScalar(prefix(), kInputImplEmpty, &input_empty));
+    if (static_cast<bool>(input_empty)) {
+      input_impl_.reset();
+    } else {
+      TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+    }
+    return buffer_->Restore(absl::StrCat(prefix(), "_", kBuffer), reader);
+  }
+
+ private:
+  // Reads one element of the input into the filling window.
+  absl::Status FillOne(IteratorContext* ctx)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    std::vector<Tensor> element;
+    bool end_of_input = false;
+    TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &element, &end_of_input));
+    if (end_of_input) {
+      input_impl_.reset();
+      return absl::OkStatus();
+    }
+    return buffer_->Append(element);
+  }
+
+  absl::Mutex mu_;
+  std::unique_ptr<IteratorBase> input_impl_ ABSL_GUARDED_BY(mu_);
+  std::unique_ptr<SpillingShuffleBuffer> buffer_ ABSL_GUARDED_BY(mu_);
+  // Number of windows served so far.
+  int64_t num_windows_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+std::unique_ptr<IteratorBase>
+SpillingShuffleDatasetOp::Dataset::MakeIteratorInternal(
+    const std::string& prefix) const {
+  return std::make_unique<Iterator>(
+      Iterator::Params{this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+}
+
+void SpillingShuffleDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                           DatasetBase* input,
+                                           DatasetBase** output) {
+  int64_t buffer_size;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<int64_t>(ctx, kBufferSize, &buffer_size));
+  OP_REQUIRES(ctx, buffer_size > 0,
+              absl::InvalidArgumentError(absl::StrCat(
+                  "`buffer_size` must be greater than zero. Got ",
+                  buffer_size)));
+  int64_t seed, seed2;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed, &seed));
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed2, &seed2));
+  tstring spill_directory;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<tstring>(ctx, kSpillDirectory,
+                                                   &spill_directory));
+  OP_REQUIRES(ctx, !spill_directory.empty(),
+              absl::InvalidArgumentError("`spill_directory` must be set."));
+  *output = new Dataset(ctx, input, buffer_size, RandomSeeds(seed, seed2),
+                        std::string(spill_directory));
+}
+
+REGISTER_KERNEL_BUILDER(Name(kSpillingShuffleDataset).Device(DEVICE_CPU),
+                        SpillingShuffleDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
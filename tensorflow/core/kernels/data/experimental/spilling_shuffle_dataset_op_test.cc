@@ -0,0 +1,168 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "spilling_shuffle_dataset";
+constexpr char kDatasetType[] = "SpillingShuffle";
+
+class SpillingShuffleDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  SpillingShuffleDatasetParams(T input_dataset_params, int64_t buffer_size,
+                               int64_t seed, int64_t seed2,
+                               std::string spill_directory,
+                               DataTypeVector output_dtypes,
+                               std::vector<PartialTensorShape> output_shapes,
+                               string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        buffer_size_(buffer_size),
+        seed_(seed),
+        seed2_(seed2),
+        spill_directory_(std::move(spill_directory)) {
+    input_dataset_params_.push_back(std::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<int64_t>(TensorShape({}), {buffer_size_}),
+            CreateTensor<int64_t>(TensorShape({}), {seed_}),
+            CreateTensor<int64_t>(TensorShape({}), {seed2_}),
+            CreateTensor<tstring>(TensorShape({}), {spill_directory_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {"input_dataset", "buffer_size", "seed", "seed2",
+                    "spill_directory"};
+    return absl::OkStatus();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{"output_types", output_dtypes_},
+                    {"output_shapes", output_shapes_},
+                    {"metadata", ""}};
+    return absl::OkStatus();
+  }
+
+  string dataset_type() const override { return kDatasetType; }
+
+ private:
+  int64_t buffer_size_;
+  int64_t seed_;
+  int64_t seed2_;
+  std::string spill_directory_;
+};
+
+class SpillingShuffleDatasetOpTest : public DatasetOpsTestBase {
+ protected:
+  // Reads up to `num_elements` elements of `iterator` into `outputs`.
+  Status Read(IteratorBase* iterator, int num_elements,
+              std::vector<Tensor>* outputs) {
+    bool end_of_sequence = false;
+    for (int i = 0; i < num_elements && !end_of_sequence; ++i) {
+      std::vector<Tensor> next;
+      TF_RETURN_IF_ERROR(
+          iterator->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+      outputs->insert(outputs->end(), next.begin(), next.end());
+    }
+    return absl::OkStatus();
+  }
+};
+
+// Shuffles 10 elements in windows of 4 elements.
+SpillingShuffleDatasetParams TenElementsInWindowsOfFour() {
+  return SpillingShuffleDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*buffer_size=*/4,
+      /*seed=*/42,
+      /*seed2=*/7,
+      /*spill_directory=*/
+      io::JoinPath(::testing::TempDir(), "spilling_shuffle_dataset_op_test"),
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+TEST_F(SpillingShuffleDatasetOpTest, ProducesEveryElementOnce) {
+  auto dataset_params = TenElementsInWindowsOfFour();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(Read(iterator_.get(), /*num_elements=*/11, &outputs));
+  TF_EXPECT_OK(ExpectEqual(
+      outputs,
+      CreateTensors<int64_t>(TensorShape({}), {{0}, {1}, {2}, {3}, {4}, {5},
+                                               {6}, {7}, {8}, {9}}),
+      /*compare_order=*/false));
+}
+
+TEST_F(SpillingShuffleDatasetOpTest, RestoreAfterCrossingWindowBoundary) {
+  auto dataset_params = TenElementsInWindowsOfFour();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  // Every iterator produces the same order.
+  std::vector<Tensor> expected_outputs;
+  TF_ASSERT_OK(Read(iterator_.get(), /*num_elements=*/11, &expected_outputs));
+
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(dataset_->MakeIterator(iterator_ctx_.get(), /*parent=*/nullptr,
+                                      dataset_params.iterator_prefix(),
+                                      &iterator));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(Read(iterator.get(), /*num_elements=*/2, &outputs));
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(iterator->Save(serialization_ctx.get(), &writer));
+
+  // The first window ends after 4 elements. Its segments are still needed by
+  // the checkpoint.
+  std::vector<Tensor> discarded_outputs;
+  TF_ASSERT_OK(Read(iterator.get(), /*num_elements=*/4, &discarded_outputs));
+
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  TF_ASSERT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                               dataset_params.iterator_prefix(), *dataset_,
+                               &iterator));
+  TF_ASSERT_OK(Read(iterator.get(), /*num_elements=*/9, &outputs));
+  TF_EXPECT_OK(
+      ExpectEqual(outputs, expected_outputs, /*compare_order=*/true));
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -147,6 +147,8 @@ Status IteratorResource::GetNext(OpKernelContext* ctx,
   const int64_t get_next_latency_micros =
       env_.NowMicros() - absl::ToUnixMicros(start_time);
   tf_dataz_metrics_collector_->RecordGetNextLatency(get_next_latency_micros);
+  metrics_collector_.RecordTransformationLatencies(
+      *tf_dataz_metrics_collector_);
   captured_state->MergeCheckpoint(iter_ctx.checkpoint());
   return status;
 }
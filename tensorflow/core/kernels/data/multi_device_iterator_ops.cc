@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/resource_op_kernel.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/data/iterator_ops.h"
+#include "tensorflow/core/kernels/data/pinned_staging_ring.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
@@ -53,6 +54,7 @@ const char kAnonymousMultiDeviceIteratorV3[] = "AnonymousMultiDeviceIteratorV3";
 const char kDevices[] = "devices";
 const char kOutputShapes[] = "output_shapes";
 const char kOutputTypes[] = "output_types";
+const char kPinnedStagingRingExperiment[] = "pinned_staging_ring";
 
 struct HostBufferElement {
   Status status;
@@ -63,6 +65,20 @@ struct HostBufferElement {
 using MultiDeviceIteratorCallback =
     std::function<void(const HostBufferElement&)>;
 
+// Returns true if elements bound for `devices` should be staged in pinned host
+// memory, which is only worthwhile when some of them are not CPU devices.
+bool ShouldStageInPinnedMemory(const std::vector<string>& devices) {
+  if (!GetExperiments().contains(kPinnedStagingRingExperiment)) return false;
+  for (const string& device : devices) {
+    DeviceNameUtils::ParsedName parsed;
+    if (DeviceNameUtils::ParseFullName(device, &parsed) && parsed.has_type &&
+        parsed.type != DEVICE_CPU) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // MultiDeviceIterator provides the ability for multiple devices to fetch from
 // one iterator in a roundrobin sequence, which is deterministic. This means
 // that, for exmaple, starting from the beginning GetNextFromShard(0) always
@@ -91,6 +107,7 @@ class MultiDeviceIterator : public ResourceBase {
         output_types_(output_types),
         output_shapes_(output_shapes),
         devices_(devices),
+        stage_in_pinned_memory_(ShouldStageInPinnedMemory(devices)),
         flib_def_(std::move(flib_def)),
         flr_(flr),
         pflr_(std::move(pflr)),
@@ -129,7 +146,7 @@ class MultiDeviceIterator : public ResourceBase {
 
     multi_device_buffer_ = std::make_unique<MultiDeviceBuffer>(
         devices_.size(), max_buffer_size, incarnation_id_, std::move(iterator),
-        this);
+        stage_in_pinned_memory_, this);
     return absl::OkStatus();
   }
 
@@ -184,12 +201,13 @@ class MultiDeviceIterator : public ResourceBase {
     MultiDeviceBuffer(size_t size, int64_t max_buffer_size,
                       int64_t incarnation_id,
                       std::unique_ptr<IteratorBase> host_iterator,
-                      MultiDeviceIterator* parent)
+                      bool stage_in_pinned_memory, MultiDeviceIterator* parent)
         : buffer_(size),
           size_(size),
           max_buffer_size_(max_buffer_size),
           incarnation_id_(incarnation_id),
           host_iterator_(std::move(host_iterator)),
+          stage_in_pinned_memory_(stage_in_pinned_memory),
           parent_(parent) {}
 
     ~MultiDeviceBuffer() {
@@ -379,6 +397,8 @@ class MultiDeviceIterator : public ResourceBase {
 
         if (elem.status.ok() && elem.end_of_sequence) {
           end_of_iterator = true;
+        } else if (elem.status.ok() && stage_in_pinned_memory_) {
+          StageInPinnedMemory(ctx.get(), &elem.value);
         }
 
         std::shared_ptr<HostBuffer::CallbackContainer> callback_container;
@@ -429,6 +449,24 @@ class MultiDeviceIterator : public ResourceBase {
       }
     }
 
+    // Copies the tensors of `element` into a slot of `staging_ring_`, so that
+    // their copy to the device can be issued asynchronously from pinned
+    // memory. The ring is sized from the first element: one slot for every
+    // element the per-device buffers can hold, plus one for the element being
+    // copied to a device and one for the element being produced.
+    void StageInPinnedMemory(IteratorContext* ctx,
+                             std::vector<Tensor>* element) {
+      if (!staging_ring_) {
+        AllocatorAttributes attrs;
+        attrs.set_on_host(true);
+        attrs.set_gpu_compatible(true);
+        staging_ring_.reset(new PinnedStagingRing(
+            ctx->allocator(attrs), size_ * max_buffer_size_ + 2,
+            PinnedStagingRing::StagedBytes(*element)));
+      }
+      staging_ring_->Stage(element);
+    }
+
     struct HostBuffer {
       condition_variable cond_var;
       std::deque<HostBufferElement> data;
@@ -458,6 +496,9 @@ class MultiDeviceIterator : public ResourceBase {
     const int64_t incarnation_id_;
     CancellationManager cancellation_manager_;
     const std::unique_ptr<IteratorBase> host_iterator_;
+    const bool stage_in_pinned_memory_;
+    // Only accessed by the background thread.
+    core::RefCountPtr<PinnedStagingRing> staging_ring_;
     MultiDeviceIterator* const parent_;  // Not owned.
     std::unique_ptr<Thread> background_thread_ TF_GUARDED_BY(mu_);
   };
@@ -469,6 +510,7 @@ class MultiDeviceIterator : public ResourceBase {
   const DataTypeVector output_types_;
   const std::vector<PartialTensorShape> output_shapes_;
   const std::vector<string> devices_;
+  const bool stage_in_pinned_memory_;
   const std::unique_ptr<FunctionLibraryDefinition> flib_def_;
   FunctionLibraryRuntime* const flr_ = nullptr;  // not owned.
   const std::unique_ptr<ProcessFunctionLibraryRuntime> pflr_;
@@ -22,6 +22,7 @@ limitations under the License.
 #include <deque>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/strings/str_format.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -45,6 +46,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -123,6 +125,19 @@ constexpr double kDefaultPerIteratorPrefetchFactor = 2.0L;
 // Period between reporting dataset statistics.
 constexpr int kStatsReportingPeriodMillis = 1000;
 
+// Experiment that lets a nondeterministic parallel interleave demote stragglers
+// from its cycle, see `ParallelInterleaveIterator::DemoteStraggler()`.
+constexpr char kAdaptiveCycleExperiment[] = "adaptive_interleave_cycle";
+
+// A current element is a straggler when its pending `GetNext` call has been
+// running for `kStragglerLatencyFactor` times the median per-result latency of
+// the cycle, and for at least `kMinStragglerLatencyNanos`.
+constexpr double kStragglerLatencyFactor = 4.0;
+constexpr int64_t kMinStragglerLatencyNanos = 1000 * 1000;
+
+// Weight of the most recent result in an element's moving average latency.
+constexpr double kLatencyAverageWeight = 0.25;
+
 inline int64_t CeilDiv(int64_t numerator, int64_t denominator) {
   return (numerator + denominator - 1) / denominator;
 }
@@ -365,6 +380,11 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
               params.dataset->num_parallel_calls_, mu_,
               num_parallel_calls_cond_var_)),
           deterministic_(deterministic),
+          adaptive_cycle_(!deterministic &&
+                          GetExperiments().contains(kAdaptiveCycleExperiment)),
+          effective_cycle_length_(std::make_shared<model::SharedState>(
+              params.dataset->cycle_length_, mu_,
+              num_parallel_calls_cond_var_)),
           current_elements_(params.dataset->cycle_length_) {}
 
     ~ParallelInterleaveIterator() override { CancelThreads(/*wait=*/true); }
@@ -475,12 +495,22 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                     static_cast<double>(dataset()->cycle_length_),
                     std::ceil(std::pow(27 * dataset()->cycle_length_, 0.5)))
               : 1;
+      // With an adaptive cycle, the cycle length parameter tracks the number
+      // of inputs in flight, which grows as stragglers are demoted. It is not
+      // tunable, but the model reads its current value before optimizing.
+      std::shared_ptr<model::Parameter> cycle_length =
+          adaptive_cycle_
+              ? model::MakeParameter(
+                    kCycleLength, effective_cycle_length_,
+                    /*min=*/dataset()->cycle_length_,
+                    /*max=*/2 * dataset()->cycle_length_)
+              : model::MakeNonTunableParameter(kCycleLength,
+                                               dataset()->cycle_length_);
       return model::MakeAsyncInterleaveManyNode(
           std::move(args),
           {model::MakeParameter(kParallelism, num_parallel_calls_, /*min=*/min,
                                 /*max=*/dataset()->cycle_length_),
-           model::MakeNonTunableParameter(kCycleLength,
-                                          dataset()->cycle_length_),
+           std::move(cycle_length),
            model::MakeNonTunableParameter(kDeterministic,
                                           deterministic_ ? 1.0 : 0.0),
            model::MakeNonTunableParameter(
@@ -568,6 +598,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       for (const auto& element : future_elements_) {
         element->initialized = true;
       }
+      SetNumDemotedElements(0);
       last_valid_current_element_ = current_elements_.size() - 1;
       while (last_valid_current_element_ >= 0 &&
              !current_elements_[last_valid_current_element_]) {
@@ -668,6 +699,15 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // Whether we tried to initialize the element, but the input iterator
       // was exhausted so we could produce no inputs.
       bool no_input TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) = false;
+      // Whether the element was moved from the current cycle back to
+      // `future_elements_` because it was a straggler.
+      bool demoted TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) = false;
+      // Moving average of the time in nanoseconds that `iterator` takes to
+      // produce a result. Only maintained with an adaptive cycle.
+      double latency_ns TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) = 0;
+      // Start time in nanoseconds of the pending `GetNext` call on `iterator`,
+      // or 0 if there is none. Only maintained with an adaptive cycle.
+      std::atomic<int64_t> get_next_start_ns{0};
       // Condition variable for communicating between current worker threads
       // and GetNext.
       condition_variable cond_var;
@@ -764,16 +804,113 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       }
       // If we are allowed to be nondeterministic (i.e. return results out of
       // order), try to find an element in the cycle that has a result
-      // available.
-      for (int i = 0; i < dataset()->cycle_length_; ++i) {
-        if (ConsumeHelper(ctx, result)) {
-          return true;
+      // available. With an adaptive cycle, retry once after swapping a
+      // straggler for a future element that has results ready.
+      do {
+        for (int i = 0; i < dataset()->cycle_length_; ++i) {
+          if (ConsumeHelper(ctx, result)) {
+            return true;
+          }
+          AdvanceToNextInCycle();
         }
-        AdvanceToNextInCycle();
-      }
+      } while (adaptive_cycle_ && DemoteStraggler(ctx));
       return false;
     }
 
+    // Replaces the slowest straggler in the current cycle with the first future
+    // element, if that element already has results. The straggler moves to the
+    // back of `future_elements_`, where it keeps filling its results buffer in
+    // the background until it is promoted again, so that a slow input (e.g. a
+    // file on a slow storage shard) stops blocking the consumer. Every demoted
+    // element widens the set of inputs in flight by one, up to twice the cycle
+    // length. Returns whether an element was demoted.
+    bool DemoteStraggler(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (future_elements_.empty() ||
+          future_elements_.front()->results.empty() ||
+          num_demoted_elements_ >= dataset()->cycle_length_ ||
+          last_valid_current_element_ == -1) {
+        return false;
+      }
+      std::vector<double> latencies;
+      for (int64_t i = 0; i <= last_valid_current_element_; ++i) {
+        const std::shared_ptr<Element>& element = current_elements_[i];
+        if (element && element->latency_ns > 0) {
+          latencies.push_back(element->latency_ns);
+        }
+      }
+      if (latencies.empty()) {
+        return false;
+      }
+      std::nth_element(latencies.begin(),
+                       latencies.begin() + latencies.size() / 2,
+                       latencies.end());
+      const double threshold_ns =
+          std::max(kStragglerLatencyFactor * latencies[latencies.size() / 2],
+                   static_cast<double>(kMinStragglerLatencyNanos));
+      const int64_t now_ns = EnvTime::NowNanos();
+      int64_t straggler_index = -1;
+      int64_t max_wait_ns = 0;
+      for (int64_t i = 0; i <= last_valid_current_element_; ++i) {
+        const std::shared_ptr<Element>& element = current_elements_[i];
+        if (!element || !element->active || !element->iterator ||
+            !element->results.empty()) {
+          continue;
+        }
+        const int64_t start_ns = element->get_next_start_ns.load();
+        if (start_ns == 0 || now_ns - start_ns < threshold_ns) {
+          continue;
+        }
+        if (now_ns - start_ns > max_wait_ns) {
+          max_wait_ns = now_ns - start_ns;
+          straggler_index = i;
+        }
+      }
+      if (straggler_index == -1) {
+        return false;
+      }
+      std::shared_ptr<Element> straggler =
+          std::move(current_elements_[straggler_index]);
+      VLOG(2) << "Demoting straggler " << straggler->id << " after "
+              << max_wait_ns / 1000 << "us, median result latency is "
+              << latencies[latencies.size() / 2] / 1000 << "us";
+      DisableAutotune(ctx, straggler->iterator.get());
+      straggler->cycle_index = -1;
+      straggler->demoted = true;
+      PromoteFutureElement(ctx, straggler_index);
+      future_elements_.push_back(std::move(straggler));
+      SetNumDemotedElements(num_demoted_elements_ + 1);
+      return true;
+    }
+
+    // Moves the first future element into slot `index` of the current cycle.
+    void PromoteFutureElement(IteratorContext* ctx, int64_t index)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::shared_ptr<Element> future_element =
+          std::move(future_elements_.front());
+      future_elements_.pop_front();
+      if (future_element->iterator) {
+        EnableAutotune(ctx, future_element->iterator.get());
+      }
+      if (future_element->demoted) {
+        future_element->demoted = false;
+        SetNumDemotedElements(num_demoted_elements_ - 1);
+      }
+      future_element->cycle_index = index;
+      current_elements_[index] = std::move(future_element);
+      future_workers_cond_var_.notify_one();
+      if (!current_elements_[index]->active) {
+        current_workers_cond_var_.notify_one();
+      }
+    }
+
+    void SetNumDemotedElements(int64_t num_demoted_elements)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      num_demoted_elements_ = num_demoted_elements;
+      effective_cycle_length_->value =
+          dataset()->cycle_length_ + num_demoted_elements_;
+    }
+
     // Consumes a result (if available), returning an indication of whether
     // a result is available. If `true` is returned, `result` either
     // points to a valid result or is null if end of input has been reached.
@@ -816,18 +953,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         // future_elements, or create a new element if no future elements are
         // available.
         if (!future_elements_.empty()) {
-          std::shared_ptr<Element> future_element =
-              std::move(future_elements_.front());
-          future_elements_.pop_front();
-          if (future_element->iterator) {
-            EnableAutotune(ctx, future_element->iterator.get());
-          }
-          future_element->cycle_index = cycle_index_;
-          current_elements_[cycle_index_] = std::move(future_element);
-          future_workers_cond_var_.notify_one();
-          if (!current_elements_[cycle_index_]->active) {
-            current_workers_cond_var_.notify_one();
-          }
+          PromoteFutureElement(ctx, cycle_index_);
         } else {
           current_elements_[cycle_index_] = MakeElement(ctx);
           if (current_elements_[cycle_index_]) {
@@ -1091,8 +1217,11 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         });
         bool end_of_input = false;
         IteratorContext nested_ctx = MakeNestedIteratorContext(ctx);
+        const int64_t start_ns = adaptive_cycle_ ? EnvTime::NowNanos() : 0;
+        element->get_next_start_ns.store(start_ns);
         result->status = iterator->GetNext(&nested_ctx, &result->return_values,
                                            &end_of_input);
+        element->get_next_start_ns.store(0);
         result->checkpoint.Merge(nested_ctx.checkpoint());
         if (result->status.ok() && end_of_input) {
           mutex_lock l(*mu_);
@@ -1107,6 +1236,14 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         }
         RecordBufferEnqueue(ctx, result->return_values);
         mutex_lock l(*mu_);
+        if (adaptive_cycle_) {
+          const double latency_ns = EnvTime::NowNanos() - start_ns;
+          element->latency_ns =
+              element->latency_ns == 0
+                  ? latency_ns
+                  : kLatencyAverageWeight * latency_ns +
+                        (1 - kLatencyAverageWeight) * element->latency_ns;
+        }
         element->results.push_back(std::move(result));
         NotifyElementUpdate(*element);
         if (element->results.size() == dataset()->buffer_output_elements_) {
@@ -1672,6 +1809,19 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // Determines whether outputs can be produced in deterministic order.
     const bool deterministic_;
 
+    // Whether stragglers may be demoted from the cycle. Only possible when
+    // outputs need not be produced in deterministic order.
+    const bool adaptive_cycle_;
+
+    // The cycle length plus the number of demoted elements, which are still
+    // being prefetched. Shared with the model so that autotuning sees how many
+    // inputs are in flight.
+    const std::shared_ptr<model::SharedState> effective_cycle_length_;
+
+    // Number of elements in `future_elements_` that were demoted from the
+    // current cycle.
+    int64_t num_demoted_elements_ TF_GUARDED_BY(mu_) = 0;
+
     // Controls cancellation of `input_impl_`. Must be ordered before
     // `input_impl_` so that `input_impl_` is destroyed first.
     std::unique_ptr<CancellationManager> cancellation_manager_;
@@ -13,8 +13,11 @@ limitations under the License.
 
 #include <algorithm>
 #include <memory>
+#include <numeric>
+#include <vector>
 
 #include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 
 namespace tensorflow {
@@ -25,6 +28,13 @@ constexpr char kNodeName[] = "parallel_interleave_dataset";
 constexpr int kOpVersion = 4;
 constexpr char kParallelInterleaveDatasetV4[] = "ParallelInterleaveDatasetV4";
 
+// Number of inputs of `StragglerParams()`, each of which has two elements.
+constexpr int kNumSleepingInputs = 8;
+// Sleep before each element of the first input of `StragglerParams()`, which
+// makes it a straggler, and of the other inputs.
+constexpr int64_t kStragglerSleepMicros = 300 * 1000;
+constexpr int64_t kInputSleepMicros = 10 * 1000;
+
 class ParallelInterleaveDatasetParams : public DatasetParams {
  public:
   template <typename T>
@@ -120,6 +130,58 @@ class ParallelInterleaveDatasetParams : public DatasetParams {
 
 class ParallelInterleaveDatasetOpTest : public DatasetOpsTestBase {};
 
+// Runs with the `adaptive_interleave_cycle` experiment, which lets a
+// nondeterministic interleave demote stragglers from its cycle.
+class ParallelInterleaveAdaptiveCycleTest
+    : public ParallelInterleaveDatasetOpTest {
+ protected:
+  void SetUp() override {
+    setenv("TF_JOB_NAME", "test_job", /*overwrite=*/1);
+    setenv("TF_TASK_ID", "0", /*overwrite=*/1);
+    setenv("TF_DATA_EXPERIMENT_OPT_IN", "adaptive_interleave_cycle",
+           /*overwrite=*/1);
+  }
+
+  void TearDown() override {
+    unsetenv("TF_JOB_NAME");
+    unsetenv("TF_TASK_ID");
+    unsetenv("TF_DATA_EXPERIMENT_OPT_IN");
+  }
+
+  // Returns a copy of `ctx` that adds the nodes of new iterators to `model`.
+  static std::unique_ptr<IteratorContext> WithModel(
+      IteratorContext* ctx, std::shared_ptr<model::Model> model) {
+    IteratorContext::Params params(ctx);
+    params.model = std::move(model);
+    return std::make_unique<IteratorContext>(std::move(params));
+  }
+
+  // Reads the cycle length that the interleave node of `model` reports, which
+  // counts the demoted stragglers on top of the configured cycle length.
+  static double CycleLength(const model::Model& model) {
+    return model.output()->parameter_value(
+        ParallelInterleaveDatasetOp::kCycleLength);
+  }
+
+  // Checks that `outputs` holds every element of the inputs of
+  // `StragglerParams()` once, with the elements of each input in order.
+  static void ExpectEveryElementOnceInInputOrder(
+      const std::vector<int64_t>& outputs) {
+    std::vector<int> positions(2 * kNumSleepingInputs, -1);
+    ASSERT_EQ(outputs.size(), positions.size());
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      ASSERT_GE(outputs[i], 0);
+      ASSERT_LT(outputs[i], positions.size());
+      EXPECT_EQ(positions[outputs[i]], -1)
+          << "Element " << outputs[i] << " was produced twice";
+      positions[outputs[i]] = i;
+    }
+    for (int input = 0; input < kNumSleepingInputs; ++input) {
+      EXPECT_LT(positions[2 * input], positions[2 * input + 1]);
+    }
+  }
+};
+
 FunctionDefHelper::AttrValueWrapper MakeTensorSliceDatasetFunc(
     const DataTypeVector& output_types,
     const std::vector<PartialTensorShape>& output_shapes) {
@@ -429,6 +491,77 @@ ParallelInterleaveDatasetParams LongCycleDeterministicParams() {
       /*node_name=*/kNodeName);
 }
 
+// Makes a dataset of the slices of `values` that sleeps for
+// `sleep_microseconds` before producing each of them.
+FunctionDef MakeSleepingTensorSliceDataset() {
+  return FunctionDefHelper::Define(
+      // Name
+      "MakeSleepingTensorSliceDataset",
+      // Args
+      {"values: int64", "sleep_microseconds: int64"},
+      // Return values
+      {"y: variant"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"slices"},
+        "TensorSliceDataset",
+        {"values"},
+        {{"Toutput_types", DataTypeVector({DT_INT64})},
+         {"output_shapes",
+          std::vector<PartialTensorShape>({PartialTensorShape({})})}}},
+       {{"y"},
+        "SleepDataset",
+        {"slices", "sleep_microseconds"},
+        {{"output_types", DataTypeVector({DT_INT64})},
+         {"output_shapes",
+          std::vector<PartialTensorShape>({PartialTensorShape({})})}}}});
+}
+
+// Nondeterministic interleave of `kNumSleepingInputs` inputs, where input `i`
+// produces the elements `2 * i` and `2 * i + 1`, and the first input is much
+// slower than the others.
+ParallelInterleaveDatasetParams StragglerParams() {
+  std::vector<int64_t> values(2 * kNumSleepingInputs);
+  std::iota(values.begin(), values.end(), 0);
+  std::vector<int64_t> sleep_microseconds(kNumSleepingInputs,
+                                          kInputSleepMicros);
+  sleep_microseconds[0] = kStragglerSleepMicros;
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64_t>(
+                          TensorShape{kNumSleepingInputs, 2}, values),
+                      CreateTensor<int64_t>(TensorShape{kNumSleepingInputs},
+                                            sleep_microseconds)},
+      /*node_name=*/"tensor_slice");
+  return ParallelInterleaveDatasetParams(
+      tensor_slice_dataset_params,
+      /*other_arguments=*/{},
+      /*cycle_length=*/2,
+      /*block_length=*/1,
+      /*buffer_output_elements=*/2,
+      /*prefetch_input_elements=*/2,
+      /*num_parallel_calls=*/2,
+      /*func=*/
+      FunctionDefHelper::FunctionRef(
+          /*name=*/"MakeSleepingTensorSliceDataset", /*attrs=*/{}),
+      /*func_lib=*/{MakeSleepingTensorSliceDataset()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*deterministic=*/DeterminismPolicy::kNondeterministic,
+      /*node_name=*/kNodeName);
+}
+
+// Wraps `StragglerParams()` in a take of all its elements, so that the
+// interleave iterator has a parent and adds its node to the model.
+TakeDatasetParams TakeAllStragglerParams() {
+  return TakeDatasetParams(StragglerParams(),
+                           /*count=*/-1,
+                           /*output_dtypes=*/{DT_INT64},
+                           /*output_shapes=*/{PartialTensorShape({})},
+                           /*node_name=*/"take");
+}
+
 ParallelInterleaveDatasetParams
 ParallelInterleaveDatasetParamsWithInvalidCycleLength() {
   auto tensor_slice_dataset_params = TensorSliceDatasetParams(
@@ -899,6 +1032,101 @@ TEST_F(ParallelInterleaveDatasetOpTest, InvalidArguments) {
   }
 }
 
+
+TEST_F(ParallelInterleaveAdaptiveCycleTest, DemotesAndPromotesStraggler) {
+  ASSERT_TRUE(GetExperiments().contains("adaptive_interleave_cycle"));
+  auto dataset_params = TakeAllStragglerParams();
+  TF_ASSERT_OK(InitializeRuntime(StragglerParams()));
+  std::unique_ptr<TestDataset> dataset;
+  TF_ASSERT_OK(MakeDataset(dataset_params, &dataset));
+  std::unique_ptr<IteratorContext> base_ctx;
+  TF_ASSERT_OK(CreateIteratorContext(dataset->op_kernel_context(), &base_ctx));
+  auto pipeline_model = std::make_shared<model::Model>();
+  std::unique_ptr<IteratorContext> ctx =
+      WithModel(base_ctx.get(), pipeline_model);
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(dataset->dataset()->MakeIterator(
+      ctx.get(), /*parent=*/nullptr, dataset_params.iterator_prefix(),
+      &iterator));
+  ASSERT_NE(pipeline_model->output(), nullptr);
+  EXPECT_EQ(CycleLength(*pipeline_model), 2);
+
+  std::vector<int64_t> outputs;
+  double max_cycle_length = 0;
+  bool end_of_sequence = false;
+  while (true) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(iterator->GetNext(ctx.get(), &next, &end_of_sequence));
+    if (end_of_sequence) {
+      break;
+    }
+    outputs.push_back(next[0].scalar<int64_t>()());
+    max_cycle_length = std::max(max_cycle_length, CycleLength(*pipeline_model));
+  }
+  // The straggler widened the cycle while it was demoted, and promoting it
+  // again shrank the cycle back to its configured length.
+  EXPECT_GT(max_cycle_length, 2);
+  EXPECT_LE(max_cycle_length, 4);
+  EXPECT_EQ(CycleLength(*pipeline_model), 2);
+  ExpectEveryElementOnceInInputOrder(outputs);
+}
+
+TEST_F(ParallelInterleaveAdaptiveCycleTest, SaveAndRestoreWhileDemoted) {
+  ASSERT_TRUE(GetExperiments().contains("adaptive_interleave_cycle"));
+  auto dataset_params = TakeAllStragglerParams();
+  TF_ASSERT_OK(InitializeRuntime(StragglerParams()));
+  std::unique_ptr<TestDataset> dataset;
+  TF_ASSERT_OK(MakeDataset(dataset_params, &dataset));
+  std::unique_ptr<IteratorContext> base_ctx;
+  TF_ASSERT_OK(CreateIteratorContext(dataset->op_kernel_context(), &base_ctx));
+  auto pipeline_model = std::make_shared<model::Model>();
+  std::unique_ptr<IteratorContext> ctx =
+      WithModel(base_ctx.get(), pipeline_model);
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(dataset->dataset()->MakeIterator(
+      ctx.get(), /*parent=*/nullptr, dataset_params.iterator_prefix(),
+      &iterator));
+
+  // Reads until the straggler has been demoted.
+  std::vector<int64_t> outputs;
+  bool end_of_sequence = false;
+  while (CycleLength(*pipeline_model) == 2) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(iterator->GetNext(ctx.get(), &next, &end_of_sequence));
+    ASSERT_FALSE(end_of_sequence) << "The straggler was never demoted";
+    outputs.push_back(next[0].scalar<int64_t>()());
+  }
+
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(iterator->Save(serialization_ctx.get(), &writer));
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  auto restored_model = std::make_shared<model::Model>();
+  std::unique_ptr<IteratorContext> restored_ctx =
+      WithModel(base_ctx.get(), restored_model);
+  TF_ASSERT_OK(RestoreIterator(restored_ctx.get(), &reader,
+                               dataset_params.iterator_prefix(),
+                               *dataset->dataset(), &iterator));
+  // The demoted straggler is restored as a future element, so the restored
+  // cycle starts from its configured length.
+  EXPECT_EQ(CycleLength(*restored_model), 2);
+
+  while (true) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator->GetNext(restored_ctx.get(), &next, &end_of_sequence));
+    if (end_of_sequence) {
+      break;
+    }
+    outputs.push_back(next[0].scalar<int64_t>()());
+  }
+  EXPECT_EQ(CycleLength(*restored_model), 2);
+  ExpectEveryElementOnceInInputOrder(outputs);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
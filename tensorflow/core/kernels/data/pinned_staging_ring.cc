@@ -0,0 +1,189 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/pinned_staging_ring.h"
+
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+int64_t AlignUp(int64_t bytes) {
+  constexpr int64_t kAlignment = Allocator::kAllocatorAlignment;
+  return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+bool ShouldStage(const Tensor& t) {
+  return DataTypeCanUseMemcpy(t.dtype()) && t.TotalBytes() > 0;
+}
+
+// A buffer that aliases `[offset, offset + size)` of a slot, and keeps the
+// slot alive.
+class SlotSubBuffer : public TensorBuffer {
+ public:
+  SlotSubBuffer(TensorBuffer* slot, int64_t offset, int64_t size)
+      : TensorBuffer(slot->base<char>() + offset), root_(slot), size_(size) {
+    DCHECK_LE(offset + size, slot->size());
+    root_->Ref();
+  }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return root_; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    root_->FillAllocationDescription(proto);
+  }
+
+ private:
+  ~SlotSubBuffer() override { root_->Unref(); }
+
+  TensorBuffer* const root_;
+  const int64_t size_;
+
+  SlotSubBuffer(const SlotSubBuffer&) = delete;
+  void operator=(const SlotSubBuffer&) = delete;
+};
+
+}  // namespace
+
+// The root buffer of one slot. It holds a reference to the ring, and hands
+// the slot back when the last tensor aliasing it is destroyed.
+class PinnedStagingRing::SlotBuffer : public TensorBuffer {
+ public:
+  SlotBuffer(PinnedStagingRing* ring, int64_t slot)
+      : TensorBuffer(ring->base_ + slot * ring->slot_bytes_),
+        ring_(ring),
+        slot_(slot) {
+    ring_->Ref();
+  }
+
+  size_t size() const override { return ring_->slot_bytes_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(ring_->slot_bytes_);
+    proto->set_allocator_name(ring_->allocator_->Name());
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+ private:
+  ~SlotBuffer() override {
+    ring_->Release(slot_);
+    ring_->Unref();
+  }
+
+  PinnedStagingRing* const ring_;
+  const int64_t slot_;
+
+  SlotBuffer(const SlotBuffer&) = delete;
+  void operator=(const SlotBuffer&) = delete;
+};
+
+PinnedStagingRing::PinnedStagingRing(Allocator* allocator, int64_t num_slots,
+                                     int64_t slot_bytes)
+    : allocator_(allocator),
+      num_slots_(num_slots),
+      slot_bytes_(AlignUp(slot_bytes)),
+      base_(num_slots_ > 0 && slot_bytes_ > 0
+                ? static_cast<char*>(allocator_->AllocateRaw(
+                      Allocator::kAllocatorAlignment, num_slots_ * slot_bytes_))
+                : nullptr) {
+  if (base_ == nullptr) {
+    LOG(WARNING) << "Failed to allocate " << num_slots_ << " staging slots of "
+                 << slot_bytes_ << " bytes; every element will be copied into "
+                 << "a separate allocation.";
+    return;
+  }
+  mutex_lock l(mu_);
+  for (int64_t i = 0; i < num_slots_; ++i) {
+    free_slots_.push_back(i);
+  }
+}
+
+PinnedStagingRing::~PinnedStagingRing() {
+  if (base_ != nullptr) {
+    allocator_->DeallocateRaw(base_);
+  }
+}
+
+// static
+int64_t PinnedStagingRing::StagedBytes(const std::vector<Tensor>& element) {
+  int64_t bytes = 0;
+  for (const Tensor& t : element) {
+    if (ShouldStage(t)) bytes += AlignUp(t.TotalBytes());
+  }
+  return bytes;
+}
+
+void PinnedStagingRing::Stage(std::vector<Tensor>* element) {
+  const int64_t bytes = StagedBytes(*element);
+  if (bytes == 0) return;
+  int64_t slot = -1;
+  {
+    mutex_lock l(mu_);
+    if (bytes <= slot_bytes_ && !free_slots_.empty()) {
+      // Reuse the least recently released slot, so that a slot is not
+      // overwritten while a DMA that was issued from it may still be queued.
+      slot = free_slots_.front();
+      free_slots_.pop_front();
+      ++stats_.staged;
+    } else {
+      ++stats_.fallbacks;
+    }
+  }
+  if (slot < 0) {
+    for (Tensor& t : *element) {
+      if (!ShouldStage(t)) continue;
+      Tensor copy(allocator_, t.dtype(), t.shape());
+      memcpy(const_cast<char*>(copy.tensor_data().data()),
+             t.tensor_data().data(), t.TotalBytes());
+      t = std::move(copy);
+    }
+    return;
+  }
+  SlotBuffer* slot_buffer = new SlotBuffer(this, slot);
+  int64_t offset = 0;
+  for (Tensor& t : *element) {
+    if (!ShouldStage(t)) continue;
+    const int64_t size = t.TotalBytes();
+    TensorBuffer* sub_buffer = new SlotSubBuffer(slot_buffer, offset, size);
+    memcpy(sub_buffer->data(), t.tensor_data().data(), size);
+    t = Tensor(t.dtype(), t.shape(), sub_buffer);
+    sub_buffer->Unref();
+    offset += AlignUp(size);
+  }
+  slot_buffer->Unref();
+}
+
+void PinnedStagingRing::Release(int64_t slot) {
+  mutex_lock l(mu_);
+  free_slots_.push_back(slot);
+}
+
+int64_t PinnedStagingRing::NumFreeSlots() const {
+  mutex_lock l(mu_);
+  return free_slots_.size();
+}
+
+PinnedStagingRing::Stats PinnedStagingRing::GetStats() const {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+}  // namespace data
+}  // namespace tensorflow
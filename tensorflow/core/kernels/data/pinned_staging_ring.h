@@ -0,0 +1,98 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_PINNED_STAGING_RING_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_PINNED_STAGING_RING_H_
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// A fixed ring of host staging slots carved out of a single allocation from
+// `allocator`, which is expected to return page-locked ("pinned") memory, e.g.
+// the allocator obtained with `AllocatorAttributes::set_gpu_compatible(true)`
+// on a GPU host. Copying an element into a slot before it is handed to a
+// device lets the device's host-to-device stream DMA the element
+// asynchronously, instead of first bouncing it through a freshly allocated
+// pinned buffer on every copy.
+//
+// `Stage()` packs the memcpy-able tensors of one element into one slot.
+// The staged tensors alias the slot, which returns to the ring once the last
+// of them is destroyed. When no slot is free, or the element does not fit in
+// a slot, `Stage()` falls back to a plain copy into memory from `allocator`.
+// It never blocks, because consumers may hold on to staged tensors for an
+// unbounded amount of time.
+//
+// This class is thread-safe.
+class PinnedStagingRing : public core::RefCounted {
+ public:
+  struct Stats {
+    // Elements copied into a ring slot.
+    int64_t staged = 0;
+    // Elements copied into a separate allocation.
+    int64_t fallbacks = 0;
+  };
+
+  // Allocates `num_slots` slots of `slot_bytes` bytes each from `allocator`,
+  // which must outlive the ring and every tensor staged in it.
+  PinnedStagingRing(Allocator* allocator, int64_t num_slots,
+                    int64_t slot_bytes);
+
+  PinnedStagingRing(const PinnedStagingRing&) = delete;
+  void operator=(const PinnedStagingRing&) = delete;
+
+  // Replaces the memcpy-able tensors of `element` with copies in pinned host
+  // memory. Other tensors (e.g. strings and variants) are left untouched.
+  void Stage(std::vector<Tensor>* element);
+
+  // Returns the number of bytes a slot needs to hold `element`.
+  static int64_t StagedBytes(const std::vector<Tensor>& element);
+
+  int64_t num_slots() const { return num_slots_; }
+  int64_t slot_bytes() const { return slot_bytes_; }
+  int64_t NumFreeSlots() const;
+  Stats GetStats() const;
+
+ private:
+  class SlotBuffer;
+
+  ~PinnedStagingRing() override;
+
+  // Returns `slot` to the ring. Called when the last staged tensor that
+  // aliases the slot is destroyed.
+  void Release(int64_t slot);
+
+  Allocator* const allocator_;
+  const int64_t num_slots_;
+  const int64_t slot_bytes_;
+  char* const base_;
+
+  mutable mutex mu_;
+  std::deque<int64_t> free_slots_ TF_GUARDED_BY(mu_);
+  Stats stats_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_PINNED_STAGING_RING_H_
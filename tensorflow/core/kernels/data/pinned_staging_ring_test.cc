@@ -0,0 +1,140 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/pinned_staging_ring.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+bool InRing(const Tensor& t, const PinnedStagingRing* ring,
+            const std::vector<Tensor>& first_slot) {
+  return t.tensor_data().data() >= first_slot[0].tensor_data().data() &&
+         t.tensor_data().data() < first_slot[0].tensor_data().data() +
+                                      ring->num_slots() * ring->slot_bytes();
+}
+
+TEST(PinnedStagingRingTest, StagedTensorsShareOneSlot) {
+  core::RefCountPtr<PinnedStagingRing> ring(new PinnedStagingRing(
+      cpu_allocator(), /*num_slots=*/2, /*slot_bytes=*/1024));
+  std::vector<Tensor> element = {test::AsTensor<float>({1, 2, 3}),
+                                 test::AsTensor<int64_t>({4, 5}),
+                                 test::AsTensor<tstring>({"a", "b"})};
+  const std::vector<Tensor> original = element;
+  ring->Stage(&element);
+  ASSERT_EQ(element.size(), 3);
+  test::ExpectTensorEqual<float>(element[0], original[0]);
+  test::ExpectTensorEqual<int64_t>(element[1], original[1]);
+  test::ExpectTensorEqual<tstring>(element[2], original[2]);
+  EXPECT_NE(element[0].tensor_data().data(), original[0].tensor_data().data());
+  // Strings are not staged.
+  EXPECT_EQ(element[2].tensor_data().data(), original[2].tensor_data().data());
+  EXPECT_EQ(ring->NumFreeSlots(), 1);
+  EXPECT_EQ(ring->GetStats().staged, 1);
+  EXPECT_EQ(ring->GetStats().fallbacks, 0);
+
+  // The slot is returned once every staged tensor is gone.
+  Tensor keep = element[1];
+  element.clear();
+  EXPECT_EQ(ring->NumFreeSlots(), 1);
+  keep = Tensor();
+  EXPECT_EQ(ring->NumFreeSlots(), 2);
+}
+
+TEST(PinnedStagingRingTest, FallsBackWhenFull) {
+  core::RefCountPtr<PinnedStagingRing> ring(new PinnedStagingRing(
+      cpu_allocator(), /*num_slots=*/1, /*slot_bytes=*/64));
+  std::vector<Tensor> first = {test::AsTensor<int32>({1, 2})};
+  ring->Stage(&first);
+  std::vector<Tensor> second = {test::AsTensor<int32>({3, 4})};
+  ring->Stage(&second);
+  test::ExpectTensorEqual<int32>(second[0], test::AsTensor<int32>({3, 4}));
+  EXPECT_FALSE(InRing(second[0], ring.get(), first));
+  EXPECT_EQ(ring->GetStats().staged, 1);
+  EXPECT_EQ(ring->GetStats().fallbacks, 1);
+}
+
+TEST(PinnedStagingRingTest, FallsBackWhenElementDoesNotFit) {
+  core::RefCountPtr<PinnedStagingRing> ring(new PinnedStagingRing(
+      cpu_allocator(), /*num_slots=*/1, /*slot_bytes=*/64));
+  Tensor big(DT_FLOAT, TensorShape({64}));
+  big.flat<float>().setConstant(7);
+  std::vector<Tensor> element = {big};
+  ring->Stage(&element);
+  test::ExpectTensorEqual<float>(element[0], big);
+  EXPECT_EQ(ring->NumFreeSlots(), 1);
+  EXPECT_EQ(ring->GetStats().fallbacks, 1);
+}
+
+TEST(PinnedStagingRingTest, StagedTensorsOutliveRing) {
+  std::vector<Tensor> element = {test::AsTensor<double>({1, 2})};
+  {
+    core::RefCountPtr<PinnedStagingRing> ring(new PinnedStagingRing(
+        cpu_allocator(), /*num_slots=*/1, /*slot_bytes=*/64));
+    ring->Stage(&element);
+  }
+  test::ExpectTensorEqual<double>(element[0], test::AsTensor<double>({1, 2}));
+}
+
+TEST(PinnedStagingRingTest, StagedBytesAreAligned) {
+  std::vector<Tensor> element = {test::AsTensor<int8>({1}),
+                                 test::AsTensor<int8>({2})};
+  EXPECT_EQ(PinnedStagingRing::StagedBytes(element),
+            2 * Allocator::kAllocatorAlignment);
+}
+
+// Stages elements of `state.range(0)` tensors of `state.range(1)` floats
+// each, while keeping `state.range(2)` elements alive as a prefetch buffer
+// would.
+void BM_PinnedStagingRing(::testing::benchmark::State& state) {
+  const int num_tensors = state.range(0);
+  const int num_elements = state.range(1);
+  const int in_flight = state.range(2);
+  std::vector<Tensor> element;
+  for (int i = 0; i < num_tensors; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({num_elements}));
+    t.flat<float>().setConstant(i);
+    element.push_back(t);
+  }
+  core::RefCountPtr<PinnedStagingRing> ring(
+      new PinnedStagingRing(cpu_allocator(), in_flight + 1,
+                            PinnedStagingRing::StagedBytes(element)));
+  std::vector<std::vector<Tensor>> buffer(in_flight);
+  int64_t i = 0;
+  for (auto s : state) {
+    std::vector<Tensor> staged = element;
+    ring->Stage(&staged);
+    buffer[i++ % in_flight] = std::move(staged);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          PinnedStagingRing::StagedBytes(element));
+  state.counters["fallbacks"] = ring->GetStats().fallbacks;
+}
+BENCHMARK(BM_PinnedStagingRing)
+    ->Args({1, 1 << 20, 2})
+    ->Args({16, 1 << 14, 2})
+    ->Args({16, 1 << 14, 8});
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
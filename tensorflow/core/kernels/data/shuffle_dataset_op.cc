@@ -75,6 +75,7 @@ constexpr char kSlicesEnd[] = "slices_end";
 constexpr char kSlicesReachedEndOfSequence[] = "slices_reached_end_of_sequence";
 constexpr char kSeedGenerator[] = "SeedGenerator";
 constexpr char kEpochNumRandomSamples[] = "epoch_num_random_samples";
+constexpr char kIncrementalCheckpointExperiment[] = "incremental_checkpoint";
 constexpr char kShuffleDatasetV1[] = "ShuffleDataset";
 constexpr char kShuffleDatasetV2[] = "ShuffleDatasetV2";
 constexpr char kShuffleDatasetV3[] = "ShuffleDatasetV3";
@@ -189,6 +190,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
     explicit Iterator(const Params& params, SeedGenerator* seed_generator)
         : DatasetIterator<ShuffleDatasetBase>(params),
           seed_generator_(seed_generator),
+          incremental_checkpoint_(
+              GetExperiments().contains(kIncrementalCheckpointExperiment)),
           parent_generator_(seed_generator->seed(), seed_generator->seed2()),
           generator_(&parent_generator_) {
       if (params.dataset->buffer_size_ == kUnknownCardinality) {
@@ -261,61 +264,73 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
 
     Status SaveInternal(SerializationContext* ctx,
                         IteratorStateWriter* writer) override {
-      mutex_lock l(mu_);
-      // Save state needed to restore the random number generators.
-      TF_RETURN_IF_ERROR(
-          writer->WriteScalar(prefix(), kEpochNumRandomSamples,
-                              seed_generator_->num_random_samples()));
-      TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kNumRandomSamples,
-                                             num_random_samples_));
-      TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kSeed, seed_));
-      TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kSeed2, seed2_));
-
-      // Save input iterator if it hasn't been exhausted else write
-      // "end_of_input_sequence".
-      TF_RETURN_IF_ERROR(writer->WriteScalar(
-          prefix(), kEndOfInputSequence, static_cast<int64_t>(!input_impl_)));
-      if (input_impl_) {
-        TF_RETURN_IF_ERROR(this->SaveInput(ctx, writer, input_impl_));
-      }
-
-      // Save the epoch counter, buffer, and buffer slices.
-      TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kEpoch, epoch_));
-      TF_RETURN_IF_ERROR(
-          writer->WriteScalar(prefix(), kNumElements, num_elements_));
       const std::string key_prefix = absl::StrCat(prefix(), kColon, "buffer");
-      if (ctx->symbolic_checkpoint()) {
-        // When symbolic checkpointing is turned on, `writer`
-        // already contains checkpoint of the shuffle buffer created by the
-        // previous invocation of this instance and the indices that need to be
-        // updated are stored in `checkpoint_indices`.
-        TF_RETURN_IF_ERROR(UpdateCheckpointElements(
-            writer, key_prefix, *buffer_, checkpoint_indices_));
-        checkpoint_indices_.clear();
-      } else {
+      std::vector<std::vector<Tensor>> buffer_snapshot;
+      {
+        mutex_lock l(mu_);
+        // Save state needed to restore the random number generators.
         TF_RETURN_IF_ERROR(
-            WriteElementsToCheckpoint(writer, key_prefix, *buffer_));
-      }
-
-      TF_RETURN_IF_ERROR(
-          writer->WriteScalar(prefix(), kSlicesSize, slices_.size()));
-      for (size_t i = 0; i < slices_.size(); ++i) {
-        TF_RETURN_IF_ERROR(writer->WriteScalar(
-            prefix(), absl::StrJoin(std::make_tuple(kSlicesStart, i), "_"),
-            slices_[i]->start));
-        TF_RETURN_IF_ERROR(writer->WriteScalar(
-            prefix(), absl::StrJoin(std::make_tuple(kSlicesEnd, i), "_"),
-            slices_[i]->end));
+            writer->WriteScalar(prefix(), kEpochNumRandomSamples,
+                                seed_generator_->num_random_samples()));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kNumRandomSamples,
+                                               num_random_samples_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kSeed, seed_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kSeed2, seed2_));
+
+        // Save input iterator if it hasn't been exhausted else write
+        // "end_of_input_sequence".
         TF_RETURN_IF_ERROR(writer->WriteScalar(
-            prefix(),
-            absl::StrJoin(std::make_tuple(kSlicesReachedEndOfSequence, i), "_"),
-            static_cast<int64_t>(slices_[i]->reached_end_of_sequence)));
-      }
-      if (data_produced_) {
+            prefix(), kEndOfInputSequence, static_cast<int64_t>(!input_impl_)));
+        if (input_impl_) {
+          TF_RETURN_IF_ERROR(this->SaveInput(ctx, writer, input_impl_));
+        }
+
+        // Save the epoch counter, buffer, and buffer slices.
+        TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kEpoch, epoch_));
         TF_RETURN_IF_ERROR(
-            writer->WriteScalar(this->prefix(), kDataProduced, ""));
-      }
+            writer->WriteScalar(prefix(), kNumElements, num_elements_));
+        if (ctx->symbolic_checkpoint()) {
+          // When symbolic checkpointing is turned on, `writer`
+          // already contains checkpoint of the shuffle buffer created by the
+          // previous invocation of this instance and the indices that need
+          // to be updated are stored in `checkpoint_indices`.
+          TF_RETURN_IF_ERROR(UpdateCheckpointElements(
+              writer, key_prefix, *buffer_, checkpoint_indices_));
+          checkpoint_indices_.clear();
+        } else if (incremental_checkpoint_) {
+          // Copying the buffer only copies references to the (immutable)
+          // tensors of its elements. The elements are compressed and written
+          // below, without blocking `GetNext()`.
+          buffer_snapshot = *buffer_;
+        } else {
+          TF_RETURN_IF_ERROR(
+              WriteElementsToCheckpoint(writer, key_prefix, *buffer_));
+        }
 
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(prefix(), kSlicesSize, slices_.size()));
+        for (size_t i = 0; i < slices_.size(); ++i) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              prefix(), absl::StrJoin(std::make_tuple(kSlicesStart, i), "_"),
+              slices_[i]->start));
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              prefix(), absl::StrJoin(std::make_tuple(kSlicesEnd, i), "_"),
+              slices_[i]->end));
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              prefix(),
+              absl::StrJoin(std::make_tuple(kSlicesReachedEndOfSequence, i),
+                            "_"),
+              static_cast<int64_t>(slices_[i]->reached_end_of_sequence)));
+        }
+        if (data_produced_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(this->prefix(), kDataProduced, ""));
+        }
+      }
+      if (incremental_checkpoint_ && !ctx->symbolic_checkpoint()) {
+        TF_RETURN_IF_ERROR(checkpoint_element_cache_.WriteElements(
+            writer, key_prefix, buffer_snapshot));
+      }
       return absl::OkStatus();
     }
 
@@ -564,6 +579,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
     // `SaveInternal()` and need to be updated in the MemoryCheckpoint
     // (if symbolic checkpointing is used) in the next `SaveInternal()`.
     absl::flat_hash_set<int64_t> checkpoint_indices_ TF_GUARDED_BY(mu_);
+    // Whether (non-symbolic) checkpoints write the buffer through
+    // `checkpoint_element_cache_`, outside of `mu_`.
+    const bool incremental_checkpoint_;
+    CheckpointElementCache checkpoint_element_cache_;
     std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_) = nullptr;
     int64_t epoch_ TF_GUARDED_BY(mu_) = 0;
     int64_t num_elements_ TF_GUARDED_BY(mu_) = 0;
@@ -14,8 +14,17 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/tf_record_dataset_op.h"
 
+#include <algorithm>
 #include <cstdint>
-
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/global_shuffle_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/utils.h"
 #include "tensorflow/core/framework/metrics.h"
@@ -50,6 +59,8 @@ constexpr int64_t kUnspecifiedBufferSize = -1;
 constexpr int64_t kDefaultBufferSize = 256LL << 10;  // 256KB
 constexpr int64_t kCloudTpuBlockSize = 127LL << 20;  // 127MB.
 constexpr int64_t kS3BlockSize = kCloudTpuBlockSize;
+constexpr int64_t kMinReadaheadBufferSize = 4LL << 20;  // 4MB
+constexpr char kReadaheadExperiment[] = "tfrecord_readahead";
 
 bool is_cloud_tpu_gcs_fs() {
 #if (defined(PLATFORM_CLOUD_TPU) && defined(TPU_GCS_FS)) || \
@@ -73,6 +84,12 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         op_version_(op_version) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
+      if (GetExperiments().contains(kReadaheadExperiment)) {
+        // Keep several reads in flight per file instead of refilling the
+        // buffer with one blocking read at a time.
+        options_.readahead_buffer_size =
+            std::max(buffer_size, kMinReadaheadBufferSize);
+      }
     }
   }
 
@@ -107,6 +124,76 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 
   Status CheckExternalState() const override { return absl::OkStatus(); }
 
+  // The cardinality is only known once the record indices of all files are
+  // loaded, which requires reading their sidecar index files.
+  int64_t CardinalityInternal(CardinalityOptions options) const override {
+    if (!RandomIndexingCompatible().ok()) {
+      return kUnknownCardinality;
+    }
+    mutex_lock l(index_mu_);
+    if (options.compute_level() <
+            CardinalityOptions::CARDINALITY_COMPUTE_MODERATE &&
+        !indices_loaded_) {
+      return kUnknownCardinality;
+    }
+    if (!LoadIndicesLocked().ok()) {
+      return kUnknownCardinality;
+    }
+    return cumulative_num_records_.back();
+  }
+
+  absl::Status RandomIndexingCompatible() const override {
+    if (options_.compression_type != io::RecordReaderOptions::NONE) {
+      return absl::FailedPreconditionError(absl::StrCat(
+          "Random access is not supported for TFRecord files compressed with ",
+          absl::string_view(compression_type_), "."));
+    }
+    if (!byte_offsets_.empty()) {
+      return absl::FailedPreconditionError(
+          "Random access is not supported for TFRecordDataset with "
+          "`byte_offsets`.");
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Get(OpKernelContext* ctx, int64 index,
+                   std::vector<Tensor>* out_tensors) const override {
+    return Get(AnyContext(ctx), index, out_tensors);
+  }
+
+  absl::Status Get(AnyContext ctx, int64 index,
+                   std::vector<Tensor>* out_tensors) const override {
+    TF_RETURN_IF_ERROR(RandomIndexingCompatible());
+    {
+      // Surfaces a missing or corrupted index file to the caller, rather than
+      // the unknown cardinality that results from it.
+      mutex_lock l(index_mu_);
+      TF_RETURN_IF_ERROR(LoadIndicesLocked());
+    }
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    IndexedFile* file;
+    int64_t record_index;
+    {
+      mutex_lock l(index_mu_);
+      // File `i` holds the records in
+      // [cumulative_num_records_[i], cumulative_num_records_[i + 1]).
+      auto it = std::upper_bound(cumulative_num_records_.begin(),
+                                 cumulative_num_records_.end(), index);
+      const size_t file_index = it - cumulative_num_records_.begin() - 1;
+      file = indexed_files_[file_index].get();
+      record_index = index - cumulative_num_records_[file_index];
+    }
+    out_tensors->clear();
+    out_tensors->emplace_back(ctx.allocator, DT_STRING, TensorShape({}));
+    TF_RETURN_IF_ERROR(file->reader->ReadRecordAt(
+        file->index.offset(record_index), file->index.record_size(record_index),
+        &out_tensors->back().scalar<tstring>()()));
+    static monitoring::CounterCell* bytes_counter =
+        metrics::GetTFDataBytesReadCounter(kDatasetType);
+    bytes_counter->IncrementBy(out_tensors->back().scalar<tstring>()().size());
+    return absl::OkStatus();
+  }
+
  protected:
   Status AsGraphDefInternal(SerializationContext* ctx,
                             DatasetGraphDefBuilder* b,
@@ -128,13 +215,18 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
   class Iterator : public DatasetIterator<Dataset> {
    public:
     explicit Iterator(const Params& params)
-        : DatasetIterator<Dataset>(params) {}
+        : DatasetIterator<Dataset>(params),
+          global_shuffle_iterator_(dataset()) {}
 
     bool SymbolicCheckpointCompatible() const override { return true; }
 
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (ctx->index_mapper() != nullptr) {
+        return global_shuffle_iterator_.GetNext(ctx, out_tensors,
+                                                end_of_sequence);
+      }
       out_tensors->reserve(1);
       mutex_lock l(mu_);
       do {
@@ -235,11 +327,15 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         TF_RETURN_IF_ERROR(
             writer->WriteScalar(prefix(), kOffset, reader_->TellOffset()));
       }
+      TF_RETURN_IF_ERROR(global_shuffle_iterator_.Save(prefix(), ctx, writer));
       return absl::OkStatus();
     }
 
     Status RestoreInternal(IteratorContext* ctx,
                            IteratorStateReader* reader) override {
+      if (ctx->restored_element_count().has_value()) {
+        return global_shuffle_iterator_.Restore(prefix(), ctx, reader);
+      }
       mutex_lock l(mu_);
       ResetStreamsLocked();
       int64_t current_file_index;
@@ -290,13 +386,81 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     // we must destroy `reader_` before `file_`.
     std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+
+    GlobalShuffleIterator global_shuffle_iterator_;
   };
 
+  // A record file opened for random access, together with its index.
+  struct IndexedFile {
+    std::unique_ptr<RandomAccessFile> file;
+    // Borrows `file`, so it is declared after it.
+    std::unique_ptr<io::RecordReader> reader;
+    io::RecordIndex index;
+  };
+
+  // Opens all files and reads their sidecar index files, unless this has been
+  // done already. Failures are sticky, so that repeated cardinality queries do
+  // not repeatedly hit the file system.
+  absl::Status LoadIndicesLocked() const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(index_mu_) {
+    if (indices_loaded_) {
+      return index_status_;
+    }
+    indices_loaded_ = true;
+    index_status_ = LoadIndices();
+    if (!index_status_.ok()) {
+      indexed_files_.clear();
+      cumulative_num_records_ = {0};
+    }
+    return index_status_;
+  }
+
+  absl::Status LoadIndices() const TF_EXCLUSIVE_LOCKS_REQUIRED(index_mu_) {
+    Env* env = Env::Default();
+    for (const string& filename : filenames_) {
+      const string translated_filename = TranslateFileName(filename);
+      const std::string index_filename =
+          io::RecordIndex::IndexFileName(translated_filename);
+      std::unique_ptr<RandomAccessFile> index_file;
+      absl::Status s = env->NewRandomAccessFile(index_filename, &index_file);
+      if (absl::IsNotFound(s)) {
+        return absl::FailedPreconditionError(absl::StrCat(
+            "Random access to TFRecord file ", filename,
+            " requires its record index at ", index_filename,
+            ", which does not exist. Generate it with "
+            "`generate_tfrecord_index`."));
+      }
+      TF_RETURN_IF_ERROR(s);
+      auto indexed_file = std::make_unique<IndexedFile>();
+      TF_RETURN_IF_ERROR(
+          io::RecordIndex::Read(index_file.get(), &indexed_file->index));
+      TF_RETURN_IF_ERROR(
+          env->NewRandomAccessFile(translated_filename, &indexed_file->file));
+      indexed_file->reader = std::make_unique<io::RecordReader>(
+          indexed_file->file.get(), options_);
+      cumulative_num_records_.push_back(cumulative_num_records_.back() +
+                                        indexed_file->index.num_records());
+      indexed_files_.push_back(std::move(indexed_file));
+    }
+    return absl::OkStatus();
+  }
+
   const std::vector<string> filenames_;
   const tstring compression_type_;
   io::RecordReaderOptions options_;
   const std::vector<int64_t> byte_offsets_;
   const int op_version_;
+
+  // State for random access, which is loaded on first use.
+  mutable mutex index_mu_;
+  mutable bool indices_loaded_ TF_GUARDED_BY(index_mu_) = false;
+  mutable absl::Status index_status_ TF_GUARDED_BY(index_mu_);
+  mutable std::vector<std::unique_ptr<IndexedFile>> indexed_files_
+      TF_GUARDED_BY(index_mu_);
+  // The number of records in the files before each file, followed by the
+  // total number of records.
+  mutable std::vector<int64_t> cumulative_num_records_ TF_GUARDED_BY(
+      index_mu_) = {0};
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
@@ -352,6 +352,62 @@ TEST_F(TFRecordDatasetOpTest, InvalidByteOffsetsToSeek) {
       absl::StatusCode::kDataLoss);
 }
 
+TEST_F(TFRecordDatasetOpTest, RandomAccessWithRecordIndex) {
+  std::vector<tstring> filenames = {
+      absl::StrCat(testing::TmpDir(), "/tf_record_RANDOM_ACCESS_1"),
+      absl::StrCat(testing::TmpDir(), "/tf_record_RANDOM_ACCESS_2")};
+  TF_ASSERT_OK(CreateTestFiles(filenames, {{"1", "22", "333"}, {"a", "bb"}},
+                               CompressionType::UNCOMPRESSED));
+  for (const tstring& filename : filenames) {
+    TF_ASSERT_OK(io::WriteRecordIndexFile(Env::Default(), filename));
+  }
+  TFRecordDatasetParams dataset_params(filenames,
+                                       CompressionType::UNCOMPRESSED,
+                                       /*buffer_size=*/10,
+                                       /*byte_offsets=*/{}, kNodeName);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(dataset_->RandomIndexingCompatible());
+  CardinalityOptions options;
+  options.set_compute_level(CardinalityOptions::CARDINALITY_COMPUTE_MODERATE);
+  EXPECT_EQ(dataset_->Cardinality(options), 5);
+
+  const std::vector<tstring> expected = {"1", "22", "333", "a", "bb"};
+  for (int64_t i = expected.size() - 1; i >= 0; --i) {
+    std::vector<Tensor> out_tensors;
+    TF_ASSERT_OK(dataset_->Get(dataset_ctx_.get(), i, &out_tensors));
+    ASSERT_EQ(out_tensors.size(), 1);
+    EXPECT_EQ(out_tensors[0].scalar<tstring>()(), expected[i]);
+  }
+  std::vector<Tensor> out_tensors;
+  EXPECT_EQ(dataset_->Get(dataset_ctx_.get(), 5, &out_tensors).code(),
+            absl::StatusCode::kOutOfRange);
+}
+
+TEST_F(TFRecordDatasetOpTest, RandomAccessWithoutRecordIndex) {
+  std::vector<tstring> filenames = {
+      absl::StrCat(testing::TmpDir(), "/tf_record_RANDOM_ACCESS_NO_INDEX")};
+  TF_ASSERT_OK(CreateTestFiles(filenames, {{"1", "22", "333"}},
+                               CompressionType::UNCOMPRESSED));
+  TFRecordDatasetParams dataset_params(filenames,
+                                       CompressionType::UNCOMPRESSED,
+                                       /*buffer_size=*/10,
+                                       /*byte_offsets=*/{}, kNodeName);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  CardinalityOptions options;
+  options.set_compute_level(CardinalityOptions::CARDINALITY_COMPUTE_MODERATE);
+  EXPECT_EQ(dataset_->Cardinality(options), kUnknownCardinality);
+  std::vector<Tensor> out_tensors;
+  EXPECT_EQ(dataset_->Get(dataset_ctx_.get(), 0, &out_tensors).code(),
+            absl::StatusCode::kFailedPrecondition);
+}
+
+TEST_F(TFRecordDatasetOpTest, RandomAccessCompressed) {
+  auto dataset_params = TFRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  EXPECT_EQ(dataset_->RandomIndexingCompatible().code(),
+            absl::StatusCode::kFailedPrecondition);
+}
+
 std::vector<IteratorSaveAndRestoreTestCase<TFRecordDatasetParams>>
 IteratorSaveAndRestoreTestCases() {
   return {
@@ -466,10 +466,19 @@ class DebugIdentityV2Op : public OpKernel {
     if (context->HasAttr("tfdbg_run_id")) {
       OP_REQUIRES_OK(context, context->GetAttr("tfdbg_run_id", &tfdbg_run_id_));
     }
+    tfdbg::GraphExecutionTraceSampler::Options sampler_options;
+    OP_REQUIRES_OK(context, tfdbg::GraphExecutionTraceSampler::OptionsFromEnv(
+                                &sampler_options));
+    sampler_ = std::make_unique<tfdbg::GraphExecutionTraceSampler>(
+        sampler_options, op_name_);
   }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& tensor = context->input(0);
+    context->set_output(0, tensor);
+    if (!sampler_->ShouldWrite(tensor_debug_mode_, tensor)) {
+      return;
+    }
     for (const string& dump_root : dump_roots_) {
       tfdbg::DebugEventsWriter* debug_events_writer =
           tfdbg::DebugEventsWriter::GetDebugEventsWriter(
@@ -478,7 +487,6 @@ class DebugIdentityV2Op : public OpKernel {
                                   tfdbg_context_id_, device_name_, op_name_,
                                   output_slot_, tensor_debug_mode_, tensor));
     }
-    context->set_output(0, tensor);
   }
 
  private:
@@ -490,6 +498,7 @@ class DebugIdentityV2Op : public OpKernel {
   int32 tensor_debug_mode_;
   int64_t circular_buffer_size_;
   string tfdbg_run_id_;
+  std::unique_ptr<tfdbg::GraphExecutionTraceSampler> sampler_;
 };
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
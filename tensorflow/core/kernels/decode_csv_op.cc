@@ -14,13 +14,18 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/parsing_ops.cc.
+#include <algorithm>
+#include <utility>
 #include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/csv_parsing.h"
 #include "tensorflow/core/lib/core/errors.h"
-#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -38,7 +43,6 @@ class DecodeCSVOp : public OpKernel {
     OP_REQUIRES(
         ctx, out_type_.size() == select_cols_.size() || select_cols_.empty(),
         errors::InvalidArgument("select_cols should match output size"));
-    select_all_cols_ = select_cols_.empty();
     for (int i = 1; i < select_cols_.size(); i++) {
       OP_REQUIRES(ctx, select_cols_[i - 1] < select_cols_[i],
                   errors::InvalidArgument(
@@ -76,126 +80,39 @@ class DecodeCSVOp : public OpKernel {
     OpOutputList output;
     OP_REQUIRES_OK(ctx, ctx->output_list("output", &output));
 
+    std::vector<Tensor*> outputs(out_type_.size());
     for (int i = 0; i < static_cast<int>(out_type_.size()); ++i) {
-      Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
+      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &outputs[i]));
     }
 
-    for (int64_t i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
-
-      // Check each field in the record
-      for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32_t value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int32: ", fields[f]));
-              output[f]->flat<int32>()(i) = value;
-            }
-            break;
-          }
-          case DT_INT64: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int64_t>()(i) =
-                  record_defaults[f].flat<int64_t>()(0);
-            } else {
-              int64_t value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int64: ", fields[f]));
-              output[f]->flat<int64_t>()(i) = value;
-            }
-            break;
-          }
-          case DT_FLOAT: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid float: ", fields[f]));
-              output[f]->flat<float>()(i) = value;
-            }
-            break;
-          }
-          case DT_DOUBLE: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<double>()(i) =
-                  record_defaults[f].flat<double>()(0);
-            } else {
-              double value;
-              OP_REQUIRES(ctx, strings::safe_strtod(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid double: ", fields[f]));
-              output[f]->flat<double>()(i) = value;
-            }
-            break;
+    // Records are parsed in parallel. Each shard stops at its first invalid
+    // record, and the error of the earliest invalid record is reported, as if
+    // the records had been parsed in order.
+    mutex mu;
+    int64_t first_error_record = records_size;
+    Status first_error;
+    auto parse_records = [&](int64_t start, int64_t limit) {
+      CsvRecordSplitter splitter(delim_, use_quote_delim_, select_cols_);
+      std::vector<StringPiece> fields;
+      for (int64_t i = start; i < limit; ++i) {
+        Status s = ParseRecord(records_t(i), i, record_defaults, &splitter,
+                               &fields, outputs);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < first_error_record) {
+            first_error_record = i;
+            first_error = std::move(s);
           }
-          case DT_STRING: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<tstring>()(i) =
-                  record_defaults[f].flat<tstring>()(0);
-            } else {
-              output[f]->flat<tstring>()(i) = std::move(fields[f]);
-            }
-            break;
-          }
-          default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+          return;
         }
       }
-    }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, records_size,
+          kCostPerField * std::max<int64_t>(out_type_.size(), 1),
+          parse_records);
+    OP_REQUIRES_OK(ctx, first_error);
   }
 
  private:
@@ -203,94 +120,103 @@ class DecodeCSVOp : public OpKernel {
   std::vector<int64_t> select_cols_;
   char delim_;
   bool use_quote_delim_;
-  bool select_all_cols_;
   string na_value_;
 
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
-    int64_t current_idx = 0;
-    int64_t num_fields_parsed = 0;
-    int64_t selector_idx = 0;  // Keep track of index into select_cols
-
-    if (!input.empty()) {
-      while (static_cast<size_t>(current_idx) < input.size()) {
-        if (input[current_idx] == '\n' || input[current_idx] == '\r') {
-          current_idx++;
-          continue;
-        }
-
-        bool quoted = false;
-        bool include =
-            (select_all_cols_ || select_cols_[selector_idx] ==
-                                     static_cast<size_t>(num_fields_parsed));
-
-        if (use_quote_delim_ && input[current_idx] == '"') {
-          quoted = true;
-          current_idx++;
-        }
-
-        // This is the body of the field;
-        string field;
-        if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx,
-                        (!use_quote_delim_ || input[current_idx] != '"') &&
-                            input[current_idx] != '\n' &&
-                            input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            if (include) field += input[current_idx];
-            current_idx++;
-          }
+  // Approximate number of cycles it takes to parse one field of a record.
+  static constexpr int64_t kCostPerField = 100;
+
+  // Parses record `i` into element `i` of each of `outputs`.
+  Status ParseRecord(StringPiece record, int64_t i,
+                     const OpInputList& record_defaults,
+                     CsvRecordSplitter* splitter,
+                     std::vector<StringPiece>* fields,
+                     const std::vector<Tensor*>& outputs) const {
+    TF_RETURN_IF_ERROR(splitter->Split(record, fields));
+    if (fields->size() != out_type_.size()) {
+      return errors::InvalidArgument("Expect ", out_type_.size(),
+                                     " fields but have ", fields->size(),
+                                     " in record ", i);
+    }
 
-          // Go to next field or the end
-          current_idx++;
-        } else if (use_quote_delim_) {
-          // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              if (include) field += input[current_idx];
-              current_idx++;
-            } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              if (include) field += '"';
-              current_idx += 2;
-            }
+    // Check each field in the record
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      const StringPiece field = (*fields)[f];
+      const DataType& dtype = out_type_[f];
+      switch (dtype) {
+        case DT_INT32:
+          TF_RETURN_IF_ERROR(ConvertField<int32>(field, f, i,
+                                                 record_defaults[f],
+                                                 ParseCsvInt32, "int32",
+                                                 outputs[f]));
+          break;
+        case DT_INT64:
+          TF_RETURN_IF_ERROR(ConvertField<int64_t>(field, f, i,
+                                                   record_defaults[f],
+                                                   ParseCsvInt64, "int64",
+                                                   outputs[f]));
+          break;
+        case DT_FLOAT:
+          TF_RETURN_IF_ERROR(ConvertField<float>(field, f, i,
+                                                 record_defaults[f],
+                                                 ParseCsvFloat, "float",
+                                                 outputs[f]));
+          break;
+        case DT_DOUBLE:
+          TF_RETURN_IF_ERROR(ConvertField<double>(field, f, i,
+                                                  record_defaults[f],
+                                                  ParseCsvDouble, "double",
+                                                  outputs[f]));
+          break;
+        case DT_STRING:
+          if (IsMissing(field)) {
+            TF_RETURN_IF_ERROR(CheckDefault(f, i, record_defaults[f]));
+            outputs[f]->flat<tstring>()(i) =
+                record_defaults[f].flat<tstring>()(0);
+          } else {
+            outputs[f]->flat<tstring>()(i) = field;
           }
+          break;
+        default:
+          return errors::InvalidArgument("csv: data type ", dtype,
+                                         " not supported in field ", f);
+      }
+    }
+    return absl::OkStatus();
+  }
 
-          OP_REQUIRES(
-              ctx,
-              (static_cast<size_t>(current_idx) < input.size() &&
-               input[current_idx] == '"' &&
-               (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
-
-          current_idx += 2;
-        }
+  // Returns true if the field is empty or the NA value, in which case the
+  // default of the field is used.
+  bool IsMissing(StringPiece field) const {
+    return field.empty() || field == na_value_;
+  }
 
-        num_fields_parsed++;
-        if (include) {
-          result->push_back(field);
-          selector_idx++;
-          if (selector_idx == select_cols_.size()) return;
-        }
-      }
+  Status CheckDefault(int f, int64_t i, const Tensor& record_default) const {
+    if (record_default.NumElements() != 1) {
+      return errors::InvalidArgument("Field ", f,
+                                     " is required but missing in record ", i,
+                                     "!");
+    }
+    return absl::OkStatus();
+  }
 
-      bool include =
-          (select_all_cols_ || select_cols_[selector_idx] ==
-                                   static_cast<size_t>(num_fields_parsed));
-      // Check if the last field is missing
-      if (include && input[input.size() - 1] == delim_)
-        result->push_back(string());
+  // Converts field `f` of record `i` into element `i` of `output` with
+  // `parse`, or with its default if it is missing.
+  template <typename T>
+  Status ConvertField(StringPiece field, int f, int64_t i,
+                      const Tensor& record_default,
+                      bool (*parse)(StringPiece, T*), const char* type_name,
+                      Tensor* output) const {
+    if (IsMissing(field)) {
+      TF_RETURN_IF_ERROR(CheckDefault(f, i, record_default));
+      output->flat<T>()(i) = record_default.flat<T>()(0);
+      return absl::OkStatus();
+    }
+    if (!parse(field, &output->flat<T>()(i))) {
+      return errors::InvalidArgument("Field ", f, " in record ", i,
+                                     " is not a valid ", type_name, ": ",
+                                     field);
     }
+    return absl::OkStatus();
   }
 };
 
@@ -20,8 +20,11 @@ limitations under the License.
 
 #include <stdlib.h>
 
+#include <memory>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/winograd_transform.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -91,10 +94,42 @@ static bool ReadBoolFromEnvVar(const char* env_var_name, bool default_val) {
   return default_val;
 }
 
+static int64_t GetDeepConvCost(const DeepConv2DTransform<float>& t,
+                               int in_depth, int out_depth, int out_rows,
+                               int out_cols) {
+  return GetDeepConvCost(t.input_shape().rows, t.input_shape().cols,
+                         t.output_shape().rows, t.output_shape().cols,
+                         in_depth, out_depth, out_rows, out_cols);
+}
+
+// Returns the Winograd transform with the lowest cost for a 3x3 convolution:
+// F(2x2, 3x3) or F(4x4, 3x3). The latter computes more outputs per tile,
+// which pays off for large depths and outputs that are not too small.
+template <typename T>
+static std::unique_ptr<DeepConv2DTransform<T>> NewDeepConv2DTransform(
+    int in_depth, int out_depth, int out_rows, int out_cols) {
+  const int64_t cost_2x2 = GetDeepConvCost(WinogradTransform<float>(), in_depth,
+                                           out_depth, out_rows, out_cols);
+  const int64_t cost_4x4 = GetDeepConvCost(Winograd4x4Transform<float>(),
+                                           in_depth, out_depth, out_rows,
+                                           out_cols);
+  if (cost_4x4 < cost_2x2) {
+    return std::make_unique<Winograd4x4Transform<T>>();
+  }
+  return std::make_unique<WinogradTransform<T>>();
+}
+
+// NOTE: IF this environment variable name changes, update conv_ops_test.py.
+static const char* const kUseDeepConv2DEnvVar = "TF_USE_DEEP_CONV2D";
+
+bool DeepConv2DAutotuneEnabled() {
+  const char* value = getenv(kUseDeepConv2DEnvVar);
+  return value != nullptr && StringPiece(value) == "autotune";
+}
+
 // Returns true if convolution can be computed efficiently by DeepConv2D,
 // returns false otherwise.
 // TODO(andydavis) Add support for other filter sizes and strides.
-// TODO(andydavis) Add support for autotuning.
 bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
                       int out_rows, int out_cols) {
@@ -106,16 +141,19 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
   }
 
   // Check if deep convolution is enabled by environment variable.
-  // NOTE: IF this environment variable name changes, update conv_ops_test.py.
-  if (!ReadBoolFromEnvVar("TF_USE_DEEP_CONV2D", false)) {
+  if (!ReadBoolFromEnvVar(kUseDeepConv2DEnvVar, false)) {
     return false;
   }
+  // In autotune mode, the caller measures whether deep convolution is faster.
+  if (DeepConv2DAutotuneEnabled()) {
+    return true;
+  }
 
   // Check if flop cost of deep convolution is less than direct convolution.
-  WinogradTransform<float> t;
-  const int64_t deep_conv_cost = GetDeepConvCost(
-      t.input_shape().rows, t.input_shape().cols, t.output_shape().rows,
-      t.output_shape().cols, in_depth, out_depth, out_rows, out_cols);
+  std::unique_ptr<DeepConv2DTransform<float>> t =
+      NewDeepConv2DTransform<float>(in_depth, out_depth, out_rows, out_cols);
+  const int64_t deep_conv_cost =
+      GetDeepConvCost(*t, in_depth, out_depth, out_rows, out_cols);
   const int64_t direct_conv_cost = GetDirectConvCost(
       filter_rows, filter_cols, in_depth, out_depth, out_rows, out_cols);
 
@@ -128,6 +166,49 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
   return deep_conv_cost < direct_conv_cost;
 }
 
+bool DeepConv2DKernelCache::LookupPackedFilters(
+    uint64 key, std::vector<Tensor>* packed_filters) {
+  mutex_lock l(mu_);
+  if (!has_packed_filters_ || packed_filters_key_ != key) {
+    return false;
+  }
+  *packed_filters = packed_filters_;
+  return true;
+}
+
+void DeepConv2DKernelCache::InsertPackedFilters(
+    uint64 key, const std::vector<Tensor>& packed_filters) {
+  mutex_lock l(mu_);
+  has_packed_filters_ = true;
+  packed_filters_key_ = key;
+  packed_filters_ = packed_filters;
+}
+
+bool DeepConv2DKernelCache::LookupAutotuneResult(const Conv2DArgs& args,
+                                                 bool* use_deep_conv) {
+  mutex_lock l(mu_);
+  auto it = autotune_results_.find(MakeArgsKey(args));
+  if (it == autotune_results_.end()) {
+    return false;
+  }
+  *use_deep_conv = it->second;
+  return true;
+}
+
+void DeepConv2DKernelCache::InsertAutotuneResult(const Conv2DArgs& args,
+                                                 bool use_deep_conv) {
+  mutex_lock l(mu_);
+  autotune_results_[MakeArgsKey(args)] = use_deep_conv;
+}
+
+// static
+DeepConv2DKernelCache::ArgsKey DeepConv2DKernelCache::MakeArgsKey(
+    const Conv2DArgs& args) {
+  return {args.batch,       args.in_rows,     args.in_cols,  args.in_depth,
+          args.filter_rows, args.filter_cols, args.pad_rows, args.pad_cols,
+          args.out_rows,    args.out_cols,    args.out_depth};
+}
+
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
 // Copies data from 'filter_in' to 'filter_buf' along 'in_depth' dimension.
@@ -950,9 +1031,10 @@ namespace functor {
 template <typename T>
 struct DeepConv2D<CPUDevice, T> {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
-                  const T* filter, T* output) {
-    // TODO(andydavis) Add function to select transform based on conv params.
-    std::unique_ptr<DeepConv2DTransform<T>> transform(new WinogradTransform<T>);
+                  const T* filter, T* output, DeepConv2DKernelCache* cache) {
+    std::unique_ptr<DeepConv2DTransform<T>> transform =
+        NewDeepConv2DTransform<T>(args.in_depth, args.out_depth, args.out_rows,
+                                  args.out_cols);
 
     const int64_t in_depth = args.in_depth;
     const int64_t out_depth = args.out_depth;
@@ -975,24 +1057,47 @@ struct DeepConv2D<CPUDevice, T> {
         std::max(int64_t{0}, args.filter_cols - base_filter_rows);
     const int64_t filter_shards_col = 1 + (filter_residual_col + 2 - 1) / 2;
 
-    // Allocate buffer for transformed filters.
-    Tensor filter_transform;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_temp(
-                 DataTypeToEnum<T>::value,
-                 TensorShape({tile_rows, tile_cols, out_depth,
-                              filter_shards_row, filter_shards_col, in_depth}),
-                 &filter_transform));
-    T* filter_transform_data = filter_transform.template flat<T>().data();
-
-    // Transform filters.
-    TransformFilters<T>()(ctx, args, transform.get(), filter_shards_row,
-                          filter_shards_col, filter, filter_transform_data);
-
-    // Pack filters.
-    std::vector<Tensor> packed_filters(tile_spatial_size);
-    PackFilters<T>()(ctx, args, tile_spatial_size, filter_shards_row,
-                     filter_shards_col, filter_transform_data, &packed_filters);
+    // The transformed filters depend on the filter values and shape, and on
+    // the transform (identified by its tile size).
+    uint64 filter_key = 0;
+    std::vector<Tensor> packed_filters;
+    if (cache != nullptr) {
+      const int64_t filter_size =
+          args.filter_rows * args.filter_cols * in_depth * out_depth;
+      filter_key = Fingerprint64(StringPiece(
+          reinterpret_cast<const char*>(filter), filter_size * sizeof(T)));
+      for (const int64_t dim :
+           {args.filter_rows, args.filter_cols, args.in_depth, args.out_depth,
+            static_cast<int>(tile_rows)}) {
+        filter_key = FingerprintCat64(filter_key, dim);
+      }
+    }
+    if (cache == nullptr ||
+        !cache->LookupPackedFilters(filter_key, &packed_filters)) {
+      // Allocate buffer for transformed filters.
+      Tensor filter_transform;
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                              DataTypeToEnum<T>::value,
+                              TensorShape({tile_rows, tile_cols, out_depth,
+                                           filter_shards_row, filter_shards_col,
+                                           in_depth}),
+                              &filter_transform));
+      T* filter_transform_data = filter_transform.template flat<T>().data();
+
+      // Transform filters.
+      TransformFilters<T>()(ctx, args, transform.get(), filter_shards_row,
+                            filter_shards_col, filter, filter_transform_data);
+
+      // Pack filters.
+      packed_filters.resize(tile_spatial_size);
+      PackFilters<T>()(ctx, args, tile_spatial_size, filter_shards_row,
+                       filter_shards_col, filter_transform_data,
+                       &packed_filters);
+      if (!ctx->status().ok()) return;
+      if (cache != nullptr) {
+        cache->InsertPackedFilters(filter_key, packed_filters);
+      }
+    }
 
     // Allocate buffer for tile transform matrix.
     Tensor tile_transform_matrix_tensor;
@@ -16,7 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DEEP_CONV2D_H_
 #define TENSORFLOW_CORE_KERNELS_DEEP_CONV2D_H_
 
+#include <array>
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -101,13 +108,50 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
                       int out_rows, int out_cols);
 
+// Returns true if DeepConv2D is enabled in autotune mode, in which the
+// choice between DeepConv2D and the default Conv2D implementation is made
+// by timing both for each convolution shape.
+bool DeepConv2DAutotuneEnabled();
+
+// Per-kernel state of DeepConv2D.
+//
+// Caches the transformed and packed filters of the last call, so that
+// constant filters (e.g. of frozen inference graphs) are transformed once
+// rather than on every call. Also records which of DeepConv2D and the default
+// Conv2D implementation was measured to be faster for each convolution shape.
+// Thread-safe.
+class DeepConv2DKernelCache {
+ public:
+  // Returns true and sets 'packed_filters' if the cached filters have 'key'.
+  bool LookupPackedFilters(uint64 key, std::vector<Tensor>* packed_filters);
+  void InsertPackedFilters(uint64 key,
+                           const std::vector<Tensor>& packed_filters);
+
+  // Returns true and sets 'use_deep_conv' if 'args' have been autotuned.
+  bool LookupAutotuneResult(const Conv2DArgs& args, bool* use_deep_conv);
+  void InsertAutotuneResult(const Conv2DArgs& args, bool use_deep_conv);
+
+ private:
+  typedef std::array<int, 11> ArgsKey;
+  static ArgsKey MakeArgsKey(const Conv2DArgs& args);
+
+  mutex mu_;
+  bool has_packed_filters_ TF_GUARDED_BY(mu_) = false;
+  uint64 packed_filters_key_ TF_GUARDED_BY(mu_) = 0;
+  std::vector<Tensor> packed_filters_ TF_GUARDED_BY(mu_);
+  std::map<ArgsKey, bool> autotune_results_ TF_GUARDED_BY(mu_);
+};
+
 namespace functor {
 
 // Calls DeepConv2D implementation (see deep_conv2d.cc for details).
+// If 'cache' is not null, the transformed filters are looked up in and
+// stored to it.
 template <typename Device, typename T>
 struct DeepConv2D {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
-                  const T* filter, T* output);
+                  const T* filter, T* output,
+                  DeepConv2DKernelCache* cache = nullptr);
 };
 
 }  // namespace functor
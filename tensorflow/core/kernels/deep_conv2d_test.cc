@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <vector>
+
 #include "tensorflow/core/kernels/winograd_transform.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -155,5 +157,73 @@ TEST(DeepConv2DTransformTest, WingradOutputTransformMatrix) {
   }
 }
 
+// Checks that 'transform' computes the correlation of an input tile with a
+// filter as 'C[Ad * Bg]' (see deep_conv2d.h).
+static void TestTileCorrelation(const DeepConv2DTransform<float>& transform) {
+  const int filter_rows = transform.filter_shape().rows;
+  const int filter_cols = transform.filter_shape().cols;
+  const int tile_rows = transform.input_shape().rows;
+  const int tile_cols = transform.input_shape().cols;
+  const int out_rows = transform.output_shape().rows;
+  const int out_cols = transform.output_shape().cols;
+  const int filter_size = filter_rows * filter_cols;
+  const int tile_size = tile_rows * tile_cols;
+  const int out_size = out_rows * out_cols;
+
+  std::vector<float> filter_matrix(tile_size * filter_size);
+  std::vector<float> input_matrix(tile_size * tile_size);
+  std::vector<float> output_matrix(out_size * tile_size);
+  transform.GetFilterTransformMatrix(tile_size, filter_size,
+                                     filter_matrix.data());
+  transform.GetInputTransformMatrix(tile_size, tile_size, input_matrix.data());
+  transform.GetOutputTransformMatrix(out_size, tile_size,
+                                     output_matrix.data());
+
+  std::vector<float> tile(tile_size);
+  std::vector<float> filter(filter_size);
+  for (int i = 0; i < tile_size; ++i) tile[i] = 0.1f * ((i * 7) % 11) - 0.5f;
+  for (int i = 0; i < filter_size; ++i) filter[i] = 0.2f * ((i * 5) % 7) - 0.6f;
+
+  // Element-wise product of the transformed tile and filter.
+  std::vector<float> product(tile_size);
+  for (int i = 0; i < tile_size; ++i) {
+    float transformed_tile = 0;
+    for (int j = 0; j < tile_size; ++j) {
+      transformed_tile += input_matrix[i * tile_size + j] * tile[j];
+    }
+    float transformed_filter = 0;
+    for (int j = 0; j < filter_size; ++j) {
+      transformed_filter += filter_matrix[i * filter_size + j] * filter[j];
+    }
+    product[i] = transformed_tile * transformed_filter;
+  }
+
+  for (int r = 0; r < out_rows; ++r) {
+    for (int c = 0; c < out_cols; ++c) {
+      float output = 0;
+      for (int i = 0; i < tile_size; ++i) {
+        output +=
+            output_matrix[(r * out_cols + c) * tile_size + i] * product[i];
+      }
+      float expected = 0;
+      for (int fr = 0; fr < filter_rows; ++fr) {
+        for (int fc = 0; fc < filter_cols; ++fc) {
+          expected += tile[(r + fr) * tile_cols + c + fc] *
+                      filter[fr * filter_cols + fc];
+        }
+      }
+      EXPECT_NEAR(output, expected, 1e-4) << "r=" << r << " c=" << c;
+    }
+  }
+}
+
+TEST(DeepConv2DTransformTest, WinogradTileCorrelation) {
+  TestTileCorrelation(WinogradTransform<float>());
+}
+
+TEST(DeepConv2DTransformTest, Winograd4x4TileCorrelation) {
+  TestTileCorrelation(Winograd4x4Transform<float>());
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -48,6 +48,23 @@ void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
   }
 }
 
+Status FIFOQueue::DequeueManyLocked(int64_t num_elements, int64_t index,
+                                    Tuple* batch) {
+  DCHECK_GE(queues_[0].size(), static_cast<size_t>(num_elements));
+  Status status;
+  for (int i = 0; i < num_components(); ++i) {
+    std::deque<Tensor>& queue = queues_[i];
+    for (int64_t j = 0; j < num_elements && status.ok(); ++j) {
+      status = batch_util::CopyElementToSlice(std::move(queue[j]),
+                                              &(*batch)[i], index + j);
+    }
+    // The elements are removed even if a copy failed, so that the components
+    // stay aligned.
+    queue.erase(queue.begin(), queue.begin() + num_elements);
+  }
+  return status;
+}
+
 void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                            DoneCallback callback) {
   CancellationManager* cm = ctx->cancellation_manager();
@@ -306,44 +323,40 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
               }
             }
 
-            RunResult result = kNoProgress;
-            for (; queue_size > 0; --queue_size) {
-              if (attempt->tuple.empty()) {
-                // Only allocate tuple when we have something to dequeue
-                // so we don't use excessive memory when there are many
-                // blocked dequeue attempts waiting.
-                attempt->tuple.reserve(num_components());
-                for (int i = 0; i < num_components(); ++i) {
-                  const TensorShape shape =
-                      ManyOutShape(i, attempt->elements_requested);
-                  Tensor element;
-                  attempt->context->SetStatus(attempt->context->allocate_temp(
-                      component_dtypes_[i], shape, &element));
-                  if (!attempt->context->status().ok()) return kComplete;
-                  attempt->tuple.emplace_back(element);
-                }
-              }
-              result = kProgress;
-              Tuple tuple;
-              DequeueLocked(attempt->context, &tuple);
-              const int64_t index =
-                  attempt->tuple[0].dim_size(0) - attempt->elements_requested;
+            if (queue_size == 0) return kNoProgress;
+            if (attempt->tuple.empty()) {
+              // Only allocate tuple when we have something to dequeue
+              // so we don't use excessive memory when there are many
+              // blocked dequeue attempts waiting.
+              attempt->tuple.reserve(num_components());
               for (int i = 0; i < num_components(); ++i) {
-                attempt->context->SetStatus(batch_util::CopyElementToSlice(
-                    std::move(tuple[i]), &attempt->tuple[i], index));
+                const TensorShape shape =
+                    ManyOutShape(i, attempt->elements_requested);
+                Tensor element;
+                attempt->context->SetStatus(attempt->context->allocate_temp(
+                    component_dtypes_[i], shape, &element));
                 if (!attempt->context->status().ok()) return kComplete;
-              }
-              tuple.clear();
-              --attempt->elements_requested;
-              if (attempt->elements_requested == 0) {
-                tuple = attempt->tuple;
-                attempt->done_callback = [callback, tuple]() {
-                  callback(tuple);
-                };
-                return kComplete;
+                attempt->tuple.emplace_back(element);
               }
             }
-            return result;
+            // Take as many of the requested elements as are available in one
+            // go, rather than one element at a time.
+            const int64_t num_to_dequeue = std::min<int64_t>(
+                queue_size, attempt->elements_requested);
+            const int64_t index =
+                attempt->tuple[0].dim_size(0) - attempt->elements_requested;
+            attempt->context->SetStatus(
+                DequeueManyLocked(num_to_dequeue, index, &attempt->tuple));
+            if (!attempt->context->status().ok()) return kComplete;
+            attempt->elements_requested -= num_to_dequeue;
+            if (attempt->elements_requested == 0) {
+              Tuple tuple = attempt->tuple;
+              attempt->done_callback = [callback, tuple]() {
+                callback(tuple);
+              };
+              return kComplete;
+            }
+            return kProgress;
           });
     }
   }
@@ -61,6 +61,11 @@ class FIFOQueue : public TypedQueue<std::deque<Tensor> > {
   void DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Helper for dequeuing the first `num_elements` elements of queues_ into
+  // slices [index, index + num_elements) of the components of `batch`.
+  Status DequeueManyLocked(int64_t num_elements, int64_t index, Tuple* batch)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   static Status GetElementComponentFromBatch(const Tuple& tuple, int64_t index,
                                              int component,
                                              OpKernelContext* ctx,
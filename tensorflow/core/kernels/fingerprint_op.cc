@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/string_fingerprint.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/fingerprint.h"
@@ -52,15 +53,15 @@ void FarmhashFingerprint64(TTypes<uint8, 2>::ConstTensor input,
   }
 }
 
-void FarmhashFingerprint64(TTypes<tstring>::ConstFlat input,
+void FarmhashFingerprint64(OpKernelContext* context,
+                           TTypes<tstring>::ConstFlat input,
                            TTypes<uint8, 2>::Matrix output) {
   DCHECK_EQ(output.dimension(0), input.dimension(0));
   DCHECK_EQ(output.dimension(1), sizeof(uint64));
-  for (int64_t i = 0; i < input.dimension(0); ++i) {
-    const uint64 fingerprint =
-        Fingerprint64({input(i).data(), input(i).size()});
-    CopyToBuffer(fingerprint, &output(i, 0));
-  }
+  BatchHashStrings<Fingerprint64>(
+      context, input, [&output](int64_t i, uint64 fingerprint) {
+        CopyToBuffer(fingerprint, &output(i, 0));
+      });
 }
 
 class FingerprintOp : public OpKernel {
@@ -115,14 +116,16 @@ class FingerprintOp : public OpKernel {
         // and each row contains the fingerprint value of corresponding string.
         // To compute fingerprints of multiple strings, this op fingerprints the
         // buffer containing the string fingerprints.
-        FarmhashFingerprint64(input.flat<tstring>(), temp.tensor<uint8, 2>());
+        FarmhashFingerprint64(context, input.flat<tstring>(),
+                              temp.tensor<uint8, 2>());
         FarmhashFingerprint64(static_cast<const Tensor&>(temp).shaped<uint8, 2>(
                                   {dim0, dim1 * kFingerprintSize}),
                               output->matrix<uint8>());
       } else {
         // In case dim1 == 1, each string computes into its own fingerprint
         // value. There is no need to fingerprint twice.
-        FarmhashFingerprint64(input.flat<tstring>(), output->matrix<uint8>());
+        FarmhashFingerprint64(context, input.flat<tstring>(),
+                              output->matrix<uint8>());
       }
     } else {
       auto data = input.bit_casted_shaped<uint8, 2>(
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -191,6 +192,29 @@ TEST_F(FingerprintOpTest, CompareBytesAndString) {
             strings_fingerprints.tensor_data());
 }
 
+// Fingerprints enough strings of mixed lengths for them to be hashed in
+// groups, in several shards, and with both inline and out-of-line storage.
+TEST_F(FingerprintOpTest, ManyStrings) {
+  constexpr int64_t kNumStrings = 10007;
+  Tensor strings_tensor(DT_STRING, {kNumStrings});
+  auto strings = strings_tensor.vec<tstring>();
+  for (int64_t i = 0; i < kNumStrings; ++i) {
+    strings(i) = string(i % 97, static_cast<char>('a' + i % 26));
+  }
+
+  TF_ASSERT_OK(MakeFingerprintOp(&strings_tensor));
+  TF_ASSERT_OK(RunOpKernel());
+  auto fingerprints = GetOutput(0)->matrix<uint8>();
+  ASSERT_EQ(fingerprints.dimension(0), kNumStrings);
+  for (int64_t i = 0; i < kNumStrings; ++i) {
+    const uint64 expected = Fingerprint64(strings(i));
+    for (size_t byte = 0; byte < sizeof(uint64); ++byte) {
+      EXPECT_EQ(fingerprints(i, byte), (expected >> (8 * byte)) & 0xff)
+          << "string " << i << ", byte " << byte;
+    }
+  }
+}
+
 TEST_F(FingerprintOpTest, SupportedMethods) {
   Tensor tensor(DT_STRING, TensorShape{1});
   TF_ASSERT_OK(MakeFingerprintOp(&tensor, "unsupported_method"));
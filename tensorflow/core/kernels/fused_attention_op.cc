@@ -0,0 +1,245 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// CPU kernel for _FusedScaledDotProductAttention, which the remapper creates
+// from BatchMatMul -> Mul -> [Add] -> Softmax -> BatchMatMul subgraphs.
+//
+// The attention scores are computed one block of keys at a time, and the
+// softmax is folded into the product with the values by keeping a running
+// maximum and sum for each query ("online softmax"). Memory use therefore
+// grows with the block sizes rather than with seq_q * seq_k.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Eigen/Core"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+using RowMajorMatrix =
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+using ConstMatrixMap = Eigen::Map<const RowMajorMatrix>;
+
+// Number of queries and keys in the blocks the scores are computed in. A
+// block of scores, and the queries, keys and values it is computed from, fit
+// in L2 for the head sizes in common use.
+constexpr int64_t kQueryBlockSize = 64;
+constexpr int64_t kKeyBlockSize = 128;
+
+class FusedScaledDotProductAttentionOp : public OpKernel {
+ public:
+  explicit FusedScaledDotProductAttentionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    int num_masks;
+    OP_REQUIRES_OK(context, context->GetAttr("num_masks", &num_masks));
+    OP_REQUIRES(context, num_masks <= 1,
+                errors::InvalidArgument("At most one mask is supported, got ",
+                                        num_masks));
+    has_mask_ = num_masks == 1;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+    const Tensor& scale = context->input(3);
+
+    const int rank = query.dims();
+    OP_REQUIRES(context, rank >= 3,
+                errors::InvalidArgument("query must have rank >= 3, got ",
+                                        query.shape().DebugString()));
+    OP_REQUIRES(context, key.dims() == rank && value.dims() == rank,
+                errors::InvalidArgument(
+                    "query, key and value must have the same rank: ",
+                    query.shape().DebugString(), " vs ",
+                    key.shape().DebugString(), " vs ",
+                    value.shape().DebugString()));
+    int64_t batch_size = 1;
+    for (int i = 0; i < rank - 2; ++i) {
+      OP_REQUIRES(context,
+                  key.dim_size(i) == query.dim_size(i) &&
+                      value.dim_size(i) == query.dim_size(i),
+                  errors::InvalidArgument(
+                      "query, key and value must have the same batch "
+                      "dimensions: ",
+                      query.shape().DebugString(), " vs ",
+                      key.shape().DebugString(), " vs ",
+                      value.shape().DebugString()));
+      batch_size *= query.dim_size(i);
+    }
+    const int64_t seq_q = query.dim_size(rank - 2);
+    const int64_t depth = query.dim_size(rank - 1);
+    const int64_t seq_k = key.dim_size(rank - 2);
+    const int64_t depth_v = value.dim_size(rank - 1);
+    OP_REQUIRES(context, key.dim_size(rank - 1) == depth,
+                errors::InvalidArgument(
+                    "query and key must have the same depth: ",
+                    query.shape().DebugString(), " vs ",
+                    key.shape().DebugString()));
+    OP_REQUIRES(context, value.dim_size(rank - 2) == seq_k,
+                errors::InvalidArgument(
+                    "key and value must have the same sequence length: ",
+                    key.shape().DebugString(), " vs ",
+                    value.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(scale.shape()),
+                errors::InvalidArgument("scale must be a scalar, got ",
+                                        scale.shape().DebugString()));
+
+    // The mask is added to the scores, of shape [batch..., seq_q, seq_k], and
+    // may broadcast along any of their dimensions.
+    TensorShape scores_shape = query.shape();
+    scores_shape.set_dim(rank - 1, seq_k);
+    std::vector<int64_t> mask_batch_offsets;
+    int64_t mask_query_stride = 0;
+    int64_t mask_key_stride = 0;
+    const float* mask_data = nullptr;
+    if (has_mask_) {
+      const Tensor& mask = context->input(4);
+      OP_REQUIRES(context, mask.dims() == rank,
+                  errors::InvalidArgument(
+                      "mask must have the rank of query, got ",
+                      mask.shape().DebugString()));
+      std::vector<int64_t> strides(rank, 0);
+      int64_t stride = 1;
+      for (int i = rank - 1; i >= 0; --i) {
+        OP_REQUIRES(context,
+                    mask.dim_size(i) == 1 ||
+                        mask.dim_size(i) == scores_shape.dim_size(i),
+                    errors::InvalidArgument(
+                        "mask of shape ", mask.shape().DebugString(),
+                        " does not broadcast to the scores of shape ",
+                        scores_shape.DebugString()));
+        if (mask.dim_size(i) != 1) strides[i] = stride;
+        stride *= mask.dim_size(i);
+      }
+      mask_query_stride = strides[rank - 2];
+      mask_key_stride = strides[rank - 1];
+      mask_batch_offsets.resize(batch_size);
+      for (int64_t b = 0; b < batch_size; ++b) {
+        int64_t remainder = b;
+        int64_t offset = 0;
+        for (int i = rank - 3; i >= 0; --i) {
+          offset += (remainder % query.dim_size(i)) * strides[i];
+          remainder /= query.dim_size(i);
+        }
+        mask_batch_offsets[b] = offset;
+      }
+      mask_data = mask.flat<float>().data();
+    }
+
+    TensorShape output_shape = query.shape();
+    output_shape.set_dim(rank - 1, depth_v);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    const float* query_data = query.flat<float>().data();
+    const float* key_data = key.flat<float>().data();
+    const float* value_data = value.flat<float>().data();
+    float* output_data = output->flat<float>().data();
+    const float scale_value = scale.scalar<float>()();
+
+    const int64_t num_query_blocks =
+        (seq_q + kQueryBlockSize - 1) / kQueryBlockSize;
+    auto work = [&](int64_t begin, int64_t end) {
+      RowMajorMatrix scores(kQueryBlockSize, kKeyBlockSize);
+      RowMajorMatrix accumulator(kQueryBlockSize, depth_v);
+      Eigen::VectorXf row_max(kQueryBlockSize);
+      Eigen::VectorXf row_sum(kQueryBlockSize);
+      for (int64_t unit = begin; unit < end; ++unit) {
+        const int64_t b = unit / num_query_blocks;
+        const int64_t q_begin = (unit % num_query_blocks) * kQueryBlockSize;
+        const int64_t q_size = std::min(kQueryBlockSize, seq_q - q_begin);
+        const ConstMatrixMap q(query_data + (b * seq_q + q_begin) * depth,
+                               q_size, depth);
+        const ConstMatrixMap k(key_data + b * seq_k * depth, seq_k, depth);
+        const ConstMatrixMap v(value_data + b * seq_k * depth_v, seq_k,
+                               depth_v);
+        auto acc = accumulator.topRows(q_size);
+        acc.setZero();
+        row_max.head(q_size).setConstant(
+            -std::numeric_limits<float>::infinity());
+        row_sum.head(q_size).setZero();
+
+        for (int64_t k_begin = 0; k_begin < seq_k; k_begin += kKeyBlockSize) {
+          const int64_t k_size = std::min(kKeyBlockSize, seq_k - k_begin);
+          auto s = scores.topLeftCorner(q_size, k_size);
+          s.noalias() = q * k.middleRows(k_begin, k_size).transpose();
+          s *= scale_value;
+          if (mask_data != nullptr) {
+            const float* mask_block = mask_data + mask_batch_offsets[b] +
+                                      q_begin * mask_query_stride +
+                                      k_begin * mask_key_stride;
+            for (int64_t i = 0; i < q_size; ++i) {
+              const float* mask_row = mask_block + i * mask_query_stride;
+              for (int64_t j = 0; j < k_size; ++j) {
+                s(i, j) += mask_row[j * mask_key_stride];
+              }
+            }
+          }
+          // Rescale what was accumulated so far to the new row maximum, and
+          // turn the scores of this block into unnormalized probabilities.
+          for (int64_t i = 0; i < q_size; ++i) {
+            const float block_max = s.row(i).maxCoeff();
+            const float new_max = std::max(row_max(i), block_max);
+            if (new_max == -std::numeric_limits<float>::infinity()) {
+              // Every key so far is masked out; nothing to accumulate yet.
+              s.row(i).setZero();
+              continue;
+            }
+            const float correction = std::exp(row_max(i) - new_max);
+            s.row(i) = (s.row(i).array() - new_max).exp();
+            row_sum(i) = row_sum(i) * correction + s.row(i).sum();
+            acc.row(i) *= correction;
+            row_max(i) = new_max;
+          }
+          acc.noalias() += s * v.middleRows(k_begin, k_size);
+        }
+
+        Eigen::Map<RowMajorMatrix> out(
+            output_data + (b * seq_q + q_begin) * depth_v, q_size, depth_v);
+        out = row_sum.head(q_size).cwiseInverse().asDiagonal() * acc;
+      }
+    };
+
+    const int64_t cost_per_unit =
+        kQueryBlockSize * seq_k * (2 * depth + 2 * depth_v + 10);
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          batch_size * num_query_blocks, cost_per_unit, work);
+  }
+
+ private:
+  bool has_mask_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("_FusedScaledDotProductAttention")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T"),
+                        FusedScaledDotProductAttentionOp);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,158 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedScaledDotProductAttentionTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_masks) {
+    TF_ASSERT_OK(NodeDefBuilder("attention", "_FusedScaledDotProductAttention")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(num_masks, DT_FLOAT))
+                     .Attr("num_masks", num_masks)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  static std::vector<float> Iota(int64_t size, float scale) {
+    std::vector<float> values(size);
+    for (int64_t i = 0; i < size; ++i) {
+      values[i] = ((i * 37) % 23 - 11) * scale;
+    }
+    return values;
+  }
+
+  // Computes the attention of one batch entry with a materialized score
+  // matrix, with the mask given per [seq_q, seq_k] entry.
+  static std::vector<float> Reference(const float* q, const float* k,
+                                      const float* v, const float* mask,
+                                      int64_t seq_q, int64_t seq_k,
+                                      int64_t depth, int64_t depth_v,
+                                      float scale) {
+    std::vector<float> output(seq_q * depth_v, 0.0f);
+    std::vector<double> probs(seq_k);
+    for (int64_t i = 0; i < seq_q; ++i) {
+      double max_score = -INFINITY;
+      for (int64_t j = 0; j < seq_k; ++j) {
+        double score = 0;
+        for (int64_t d = 0; d < depth; ++d) {
+          score += q[i * depth + d] * k[j * depth + d];
+        }
+        probs[j] = score * scale + (mask ? mask[i * seq_k + j] : 0.0f);
+        max_score = std::max(max_score, probs[j]);
+      }
+      double sum = 0;
+      for (double& p : probs) {
+        p = std::exp(p - max_score);
+        sum += p;
+      }
+      for (int64_t d = 0; d < depth_v; ++d) {
+        double acc = 0;
+        for (int64_t j = 0; j < seq_k; ++j) {
+          acc += probs[j] * v[j * depth_v + d];
+        }
+        output[i * depth_v + d] = acc / sum;
+      }
+    }
+    return output;
+  }
+};
+
+TEST_F(FusedScaledDotProductAttentionTest, Small) {
+  MakeOp(/*num_masks=*/0);
+  // With equal scores the output is the mean of the values.
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), {1, 0, 0, 1});
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), {1, 1, 1, 1});
+  AddInputFromArray<float>(TensorShape({1, 2, 1}), {2, 4});
+  AddInputFromArray<float>(TensorShape({}), {0.5f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2, 1}));
+  test::FillValues<float>(&expected, {3, 3});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+// Spans several query and key blocks, with a mask that broadcasts along the
+// heads and queries and masks out some keys.
+TEST_F(FusedScaledDotProductAttentionTest, BlockedWithMask) {
+  MakeOp(/*num_masks=*/1);
+  const int64_t batch = 2, heads = 3, seq_q = 70, seq_k = 300, depth = 8,
+                depth_v = 5;
+  const float scale = 0.125f;
+  const std::vector<float> q = Iota(batch * heads * seq_q * depth, 0.1f);
+  const std::vector<float> k = Iota(batch * heads * seq_k * depth, 0.07f);
+  const std::vector<float> v = Iota(batch * heads * seq_k * depth_v, 0.3f);
+  std::vector<float> mask(batch * seq_k, 0.0f);
+  for (int64_t i = 0; i < mask.size(); i += 3) mask[i] = -1e9f;
+  AddInputFromArray<float>(TensorShape({batch, heads, seq_q, depth}), q);
+  AddInputFromArray<float>(TensorShape({batch, heads, seq_k, depth}), k);
+  AddInputFromArray<float>(TensorShape({batch, heads, seq_k, depth_v}), v);
+  AddInputFromArray<float>(TensorShape({}), {scale});
+  AddInputFromArray<float>(TensorShape({batch, 1, 1, seq_k}), mask);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> expected_values;
+  for (int64_t b = 0; b < batch; ++b) {
+    std::vector<float> full_mask(seq_q * seq_k);
+    for (int64_t i = 0; i < seq_q; ++i) {
+      std::copy_n(mask.data() + b * seq_k, seq_k,
+                  full_mask.data() + i * seq_k);
+    }
+    for (int64_t h = 0; h < heads; ++h) {
+      const int64_t bh = b * heads + h;
+      const std::vector<float> output = Reference(
+          q.data() + bh * seq_q * depth, k.data() + bh * seq_k * depth,
+          v.data() + bh * seq_k * depth_v, full_mask.data(), seq_q, seq_k,
+          depth, depth_v, scale);
+      expected_values.insert(expected_values.end(), output.begin(),
+                             output.end());
+    }
+  }
+  Tensor expected(allocator(), DT_FLOAT,
+                  TensorShape({batch, heads, seq_q, depth_v}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+}
+
+TEST_F(FusedScaledDotProductAttentionTest, MaskDoesNotBroadcast) {
+  MakeOp(/*num_masks=*/1);
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), {1, 0, 0, 1});
+  AddInputFromArray<float>(TensorShape({1, 3, 2}), {1, 1, 1, 1, 1, 1});
+  AddInputFromArray<float>(TensorShape({1, 3, 1}), {2, 4, 6});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), {0, 0, 0, 0});
+  EXPECT_TRUE(absl::IsInvalidArgument(RunOpKernel()));
+}
+
+}  // namespace
+}  // namespace tensorflow
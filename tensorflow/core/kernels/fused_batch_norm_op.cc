@@ -13,8 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <functional>
+#include <vector>
 
 #define EIGEN_USE_THREADS
 
@@ -41,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/redux_functor.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
 #include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_format.h"
 
@@ -91,6 +95,132 @@ struct FusedBatchNorm;
 template <typename Device, typename T, typename U>
 struct FusedBatchNormGrad;
 
+// The CPU training kernels work on an NHWC tensor viewed as [rest_size, depth].
+// The channels are contiguous in memory, so the per-channel reductions below
+// split the rows into blocks that are reduced in parallel: every block reads
+// its rows exactly once with a unit-stride inner loop over the channels, and
+// the per-block partials are combined at the end.
+//
+// Returns the number of row blocks to use, each holding enough elements to
+// amortize the cost of scheduling it.
+static int64_t NumBatchNormRowBlocks(OpKernelContext* context,
+                                     int64_t rest_size, int64_t depth) {
+  constexpr int64_t kMinElementsPerBlock = 32 * 1024;
+  const int64_t num_threads =
+      context->device()->tensorflow_cpu_worker_threads()->num_threads;
+  const int64_t max_blocks =
+      std::max<int64_t>(1, rest_size * depth / kMinElementsPerBlock);
+  return std::max<int64_t>(1, std::min({max_blocks, num_threads, rest_size}));
+}
+
+// Runs `fn(block, row_begin, row_end)` for every row block in parallel.
+static void ForEachBatchNormRowBlock(
+    OpKernelContext* context, int64_t rest_size, int64_t depth,
+    int64_t num_blocks,
+    const std::function<void(int64_t, int64_t, int64_t)>& fn) {
+  auto work = [&](int64_t begin, int64_t end) {
+    for (int64_t block = begin; block < end; ++block) {
+      fn(block, block * rest_size / num_blocks,
+         (block + 1) * rest_size / num_blocks);
+    }
+  };
+  if (num_blocks == 1) {
+    work(0, 1);
+    return;
+  }
+  const int64_t cost_per_block =
+      (rest_size / num_blocks) * depth * Eigen::TensorOpCost::AddCost<float>() *
+      4;
+  context->device()->tensorflow_cpu_worker_threads()->workers->ParallelFor(
+      num_blocks, cost_per_block, work);
+}
+
+// Computes the per-channel mean and (biased) variance of `x` in a single pass
+// over memory. Each row block keeps running Welford statistics, which are then
+// merged pairwise with Chan's formula.
+template <typename T, typename U>
+void ComputeBatchMeanAndVariance(OpKernelContext* context, const T* x,
+                                 int64_t rest_size, int64_t depth, U* mean,
+                                 U* variance) {
+  const int64_t num_blocks = NumBatchNormRowBlocks(context, rest_size, depth);
+  std::vector<U> block_mean(num_blocks * depth, U(0));
+  std::vector<U> block_m2(num_blocks * depth, U(0));
+  ForEachBatchNormRowBlock(
+      context, rest_size, depth, num_blocks,
+      [&](int64_t block, int64_t row_begin, int64_t row_end) {
+        U* m = block_mean.data() + block * depth;
+        U* m2 = block_m2.data() + block * depth;
+        for (int64_t row = row_begin; row < row_end; ++row) {
+          const U inv_count = U(1) / static_cast<U>(row - row_begin + 1);
+          const T* x_row = x + row * depth;
+          for (int64_t c = 0; c < depth; ++c) {
+            const U value = static_cast<U>(x_row[c]);
+            const U delta = value - m[c];
+            m[c] += delta * inv_count;
+            m2[c] += delta * (value - m[c]);
+          }
+        }
+      });
+
+  std::copy_n(block_mean.data(), depth, mean);
+  std::copy_n(block_m2.data(), depth, variance);
+  int64_t count = rest_size / num_blocks;
+  for (int64_t block = 1; block < num_blocks; ++block) {
+    const int64_t block_count = (block + 1) * rest_size / num_blocks -
+                                block * rest_size / num_blocks;
+    const int64_t total = count + block_count;
+    const U block_weight = static_cast<U>(block_count) / static_cast<U>(total);
+    const U m2_weight = static_cast<U>(count) * block_weight;
+    const U* m = block_mean.data() + block * depth;
+    const U* m2 = block_m2.data() + block * depth;
+    for (int64_t c = 0; c < depth; ++c) {
+      const U delta = m[c] - mean[c];
+      mean[c] += delta * block_weight;
+      variance[c] += m2[c] + delta * delta * m2_weight;
+    }
+    count = total;
+  }
+  const U inv_rest_size = U(1) / static_cast<U>(rest_size);
+  for (int64_t c = 0; c < depth; ++c) variance[c] *= inv_rest_size;
+}
+
+// Computes sum(y_backprop) and sum(y_backprop * (x - mean)) per channel in a
+// single pass over both inputs.
+template <typename T, typename U>
+void ComputeBatchNormGradSums(OpKernelContext* context, const T* y_backprop,
+                              const T* x, const U* mean, int64_t rest_size,
+                              int64_t depth, U* y_backprop_sum,
+                              U* y_backprop_x_centered_sum) {
+  const int64_t num_blocks = NumBatchNormRowBlocks(context, rest_size, depth);
+  std::vector<U> block_sums(2 * num_blocks * depth, U(0));
+  ForEachBatchNormRowBlock(
+      context, rest_size, depth, num_blocks,
+      [&](int64_t block, int64_t row_begin, int64_t row_end) {
+        U* dy_sum = block_sums.data() + 2 * block * depth;
+        U* dy_xc_sum = dy_sum + depth;
+        for (int64_t row = row_begin; row < row_end; ++row) {
+          const T* dy_row = y_backprop + row * depth;
+          const T* x_row = x + row * depth;
+          for (int64_t c = 0; c < depth; ++c) {
+            const U dy = static_cast<U>(dy_row[c]);
+            dy_sum[c] += dy;
+            dy_xc_sum[c] += dy * (static_cast<U>(x_row[c]) - mean[c]);
+          }
+        }
+      });
+
+  std::fill_n(y_backprop_sum, depth, U(0));
+  std::fill_n(y_backprop_x_centered_sum, depth, U(0));
+  for (int64_t block = 0; block < num_blocks; ++block) {
+    const U* dy_sum = block_sums.data() + 2 * block * depth;
+    const U* dy_xc_sum = dy_sum + depth;
+    for (int64_t c = 0; c < depth; ++c) {
+      y_backprop_sum[c] += dy_sum[c];
+      y_backprop_x_centered_sum[c] += dy_xc_sum[c];
+    }
+  }
+}
+
 template <typename T, typename U>
 struct FusedBatchNorm<CPUDevice, T, U, /* is_training= */ true> {
   void operator()(OpKernelContext* context, const Tensor& x_input,
@@ -178,13 +308,11 @@ struct FusedBatchNorm<CPUDevice, T, U, /* is_training= */ true> {
 
     Eigen::IndexList<Eigen::type2index<1>, Eigen::Index> one_by_depth;
     one_by_depth.set(1, depth);
-    Eigen::IndexList<Eigen::type2index<0>> reduce_dims;
     Eigen::IndexList<Eigen::Index, Eigen::type2index<1>> bcast_spec;
     bcast_spec.set(0, rest_size);
 
     auto x_rest_by_depth = x.reshape(rest_by_depth).template cast<U>();
     const int rest_size_minus_one = (rest_size > 1) ? (rest_size - 1) : 1;
-    U rest_size_inv = static_cast<U>(1.0f / static_cast<U>(rest_size));
     // This adjustment is for Bessel's correction
     U rest_size_adjust =
         static_cast<U>(rest_size) / static_cast<U>(rest_size_minus_one);
@@ -192,12 +320,12 @@ struct FusedBatchNorm<CPUDevice, T, U, /* is_training= */ true> {
     Eigen::Tensor<U, 1, Eigen::RowMajor> batch_mean(depth);
     Eigen::Tensor<U, 1, Eigen::RowMajor> batch_variance(depth);
 
-    batch_mean.device(d) = (x_rest_by_depth.sum(reduce_dims) * rest_size_inv);
+    ComputeBatchMeanAndVariance<T, U>(context, transformed_x.flat<T>().data(),
+                                      rest_size, depth, batch_mean.data(),
+                                      batch_variance.data());
     auto x_centered = x_rest_by_depth -
                       batch_mean.reshape(one_by_depth).broadcast(bcast_spec);
 
-    batch_variance.device(d) =
-        x_centered.square().sum(reduce_dims) * rest_size_inv;
     auto scaling_factor = ((batch_variance + epsilon).rsqrt() * scale)
                               .eval()
                               .reshape(one_by_depth)
@@ -456,64 +584,40 @@ struct FusedBatchNormGrad<CPUDevice, T, U> {
     auto x_rest_by_depth = x.reshape(rest_by_depth).template cast<U>();
     U rest_size_inv = static_cast<U>(1.0f / static_cast<U>(rest_size));
 
-    // Eigen is notoriously bad at reducing outer dimension, so we materialize
-    // all temporary tensors that require reduction, and then use Eigen redux
-    // functor, that is optimized for this particular task.
-    //
-    // All reductions are of this type: [rest_size, depth] -> [depth].
-    using ScalarSum = Eigen::internal::scalar_sum_op<U>;
-    const functor::ReduceOuterDimensions<T, U, U, ScalarSum> redux_sum_t;
-    const functor::ReduceOuterDimensions<U, U, U, ScalarSum> redux_sum_u;
-
-    auto scratch_dtype = DataTypeToEnum<U>::value;
-
     // Allocate a temporary workspace of [depth] shape.
     Tensor scratch_one_by_depth;
-    OP_REQUIRES_OK(context, context->allocate_temp(scratch_dtype, {depth},
-                                                   &scratch_one_by_depth));
-
-    // Maybe allocate a temporary workspace of [rest_size, depth] shape.
-    Tensor scratch_rest_by_depth;
-    if (std::is_same<T, U>::value) {
-      OP_REQUIRES(context,
-                  scratch_rest_by_depth.CopyFrom(transformed_x_backprop_output,
-                                                 {rest_size, depth}),
-                  errors::Internal("Failed to copy a tensor"));
-    } else {
-      OP_REQUIRES_OK(context,
-                     context->allocate_temp(scratch_dtype, {rest_size, depth},
-                                            &scratch_rest_by_depth));
-    }
-
-    typename TTypes<U, 2>::Tensor scratch_tensor(
-        scratch_rest_by_depth.tensor<U, 2>());
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<U>::value, {depth},
+                                          &scratch_one_by_depth));
     typename TTypes<U>::Vec scratch_vector(scratch_one_by_depth.vec<U>());
 
+    // Both reductions of type [rest_size, depth] -> [depth] are done in a
+    // single pass over `y_backprop` and `x`:
+    //   offset_backprop = y_backprop_rest_by_depth.sum(reduce_dims)
+    //   scratch_vector = (y_backprop_rest_by_depth * x_centered)
+    //                        .sum(reduce_dims)
+    ComputeBatchNormGradSums<T, U>(
+        context, transformed_y_backprop_input.flat<T>().data(),
+        transformed_x_input.flat<T>().data(), mean.data(), rest_size, depth,
+        offset_backprop.data(), scratch_vector.data());
+
     auto x_mean_rest_by_depth =
         mean.reshape(one_by_depth).broadcast(bcast_spec);
     auto x_centered = (x_rest_by_depth - x_mean_rest_by_depth);
     auto coef0_one_by_depth =
         (variance.reshape(one_by_depth) + epsilon).rsqrt();
-    auto coef0_rest_by_depth = coef0_one_by_depth.broadcast(bcast_spec);
-    auto x_scaled = x_centered * coef0_rest_by_depth;
 
     auto y_backprop_rest_by_depth =
         y_backprop.reshape(rest_by_depth).template cast<U>();
 
     // Compute `scale_backprop_output`:
     //   scale_backprop =
-    //     (y_backprop_rest_by_depth * x_scaled).sum(reduce_dims)
-    scratch_tensor.device(d) = y_backprop_rest_by_depth * x_scaled;
-    redux_sum_u(d, rest_by_depth, scratch_rest_by_depth, scale_backprop_output);
-
-    // Compute 'offset_backprop_output':
-    //   offset_backprop =
-    //     y_backprop_rest_by_depth.sum(reduce_dims)
-    redux_sum_t(d, rest_by_depth, transformed_y_backprop_input,
-                offset_backprop_output);
-    auto y_backprop_sum = offset_backprop;
-
-    auto y_backprop_sum_one_by_depth = y_backprop_sum.reshape(one_by_depth);
+    //     (y_backprop_rest_by_depth * x_centered).sum(reduce_dims) *
+    //     rsqrt(variance + epsilon)
+    scale_backprop_output->vec<U>().device(d) =
+        scratch_vector * (variance + epsilon).rsqrt();
+
+    auto y_backprop_sum_one_by_depth = offset_backprop.reshape(one_by_depth);
     auto y_backprop_mean_one_by_depth =
         y_backprop_sum_one_by_depth * rest_size_inv;
     auto y_backprop_mean_rest_by_depth =
@@ -521,11 +625,6 @@ struct FusedBatchNormGrad<CPUDevice, T, U> {
     auto y_backprop_centered =
         y_backprop_rest_by_depth - y_backprop_mean_rest_by_depth;
 
-    // Compute expression:
-    //   y_backprop_centered_mean =
-    //     (y_backprop_rest_by_depth * x_centered).mean(reduce_dims)
-    scratch_tensor.device(d) = y_backprop_rest_by_depth * x_centered;
-    redux_sum_u(d, rest_by_depth, scratch_rest_by_depth, &scratch_one_by_depth);
     auto y_backprop_centered_mean =
         scratch_vector.reshape(one_by_depth) / static_cast<U>(rest_size);
 
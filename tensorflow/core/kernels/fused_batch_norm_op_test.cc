@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cmath>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
@@ -103,6 +104,59 @@ TEST_F(FusedBatchNormOpTest, TrainingRunningMean) {
   test::ExpectTensorNear<float>(expected_variance, *GetOutput(2), 0.01);
 }
 
+TEST_F(FusedBatchNormOpTest, TrainingLargeInput) {
+  // Large enough for the statistics to be reduced over several row blocks.
+  const int batch = 8, rows = 16, cols = 16, depth = 64;
+  const int rest_size = batch * rows * cols;
+  TF_EXPECT_OK(NodeDefBuilder("batch_norm_op", "FusedBatchNorm")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("exponential_avg_factor", 1.0)
+                   .Attr("epsilon", 0.001)
+                   .Attr("is_training", true)
+                   .Finalize(node_def()));
+  TF_EXPECT_OK(InitOp());
+  std::vector<float> x(rest_size * depth);
+  for (int i = 0; i < rest_size * depth; ++i) {
+    // Large offsets make a naive sum-of-squares variance lose precision.
+    x[i] = 1000.0f + (i % depth) + static_cast<float>((i * 7919) % 101) / 10;
+  }
+  AddInputFromArray<float>(TensorShape({batch, rows, cols, depth}), x);
+  AddInputFromArray<float>(TensorShape({depth}),
+                           std::vector<float>(depth, 2.0f));
+  AddInputFromArray<float>(TensorShape({depth}),
+                           std::vector<float>(depth, 1.0f));
+  AddInputFromArray<float>(TensorShape({0}), {});
+  AddInputFromArray<float>(TensorShape({0}), {});
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<double> mean(depth, 0.0), variance(depth, 0.0);
+  for (int i = 0; i < rest_size * depth; ++i) mean[i % depth] += x[i];
+  for (int c = 0; c < depth; ++c) mean[c] /= rest_size;
+  for (int i = 0; i < rest_size * depth; ++i) {
+    variance[i % depth] += (x[i] - mean[i % depth]) * (x[i] - mean[i % depth]);
+  }
+  for (int c = 0; c < depth; ++c) variance[c] /= rest_size;
+
+  const auto y = GetOutput(0)->flat<float>();
+  for (int i = 0; i < rest_size * depth; ++i) {
+    const int c = i % depth;
+    EXPECT_NEAR(y(i),
+                2.0 * (x[i] - mean[c]) / std::sqrt(variance[c] + 0.001) + 1.0,
+                1e-3);
+  }
+  const auto batch_mean = GetOutput(3)->flat<float>();
+  const auto batch_variance = GetOutput(4)->flat<float>();
+  for (int c = 0; c < depth; ++c) {
+    EXPECT_NEAR(batch_mean(c), mean[c], 1e-3);
+    EXPECT_NEAR(batch_variance(c), variance[c], 1e-3);
+  }
+}
+
 TEST_F(FusedBatchNormOpTest, Inference) {
   TF_EXPECT_OK(NodeDefBuilder("batch_norm_op", "FusedBatchNorm")
                    .Input(FakeInput(DT_FLOAT))
@@ -213,6 +267,60 @@ TEST_F(FusedBatchNormGradOpTest, Simple) {
   test::ExpectTensorNear<float>(expected_offset, *GetOutput(2), 0.01);
 }
 
+TEST_F(FusedBatchNormGradOpTest, LargeInput) {
+  // Large enough for the gradient sums to be reduced over several row blocks.
+  const int batch = 8, rows = 16, cols = 16, depth = 64;
+  const int rest_size = batch * rows * cols;
+  TF_EXPECT_OK(NodeDefBuilder("batch_norm_grad_op", "FusedBatchNormGrad")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("epsilon", 0.001)
+                   .Finalize(node_def()));
+  TF_EXPECT_OK(InitOp());
+  std::vector<float> y_backprop(rest_size * depth), x(rest_size * depth);
+  for (int i = 0; i < rest_size * depth; ++i) {
+    y_backprop[i] = static_cast<float>((i * 31) % 17) / 8 - 1;
+    x[i] = static_cast<float>((i * 7919) % 101) / 10;
+  }
+  std::vector<float> mean(depth, 5.0f), variance(depth, 8.5f);
+  AddInputFromArray<float>(TensorShape({batch, rows, cols, depth}),
+                           y_backprop);
+  AddInputFromArray<float>(TensorShape({batch, rows, cols, depth}), x);
+  AddInputFromArray<float>(TensorShape({depth}),
+                           std::vector<float>(depth, 2.0f));
+  AddInputFromArray<float>(TensorShape({depth}), mean);
+  AddInputFromArray<float>(TensorShape({depth}), variance);
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<double> y_backprop_sum(depth, 0.0), y_backprop_x_sum(depth, 0.0);
+  for (int i = 0; i < rest_size * depth; ++i) {
+    y_backprop_sum[i % depth] += y_backprop[i];
+    y_backprop_x_sum[i % depth] += y_backprop[i] * (x[i] - mean[i % depth]);
+  }
+  const auto x_backprop = GetOutput(0)->flat<float>();
+  const auto scale_backprop = GetOutput(1)->flat<float>();
+  const auto offset_backprop = GetOutput(2)->flat<float>();
+  for (int c = 0; c < depth; ++c) {
+    const double inv_std = 1.0 / std::sqrt(variance[c] + 0.001);
+    EXPECT_NEAR(offset_backprop(c), y_backprop_sum[c], 1e-2);
+    EXPECT_NEAR(scale_backprop(c), y_backprop_x_sum[c] * inv_std, 1e-2);
+  }
+  for (int i = 0; i < rest_size * depth; ++i) {
+    const int c = i % depth;
+    const double inv_std = 1.0 / std::sqrt(variance[c] + 0.001);
+    const double expected =
+        2.0 * inv_std *
+        (y_backprop[i] - y_backprop_sum[c] / rest_size -
+         (x[i] - mean[c]) * inv_std * inv_std * y_backprop_x_sum[c] /
+             rest_size);
+    EXPECT_NEAR(x_backprop(i), expected, 1e-4);
+  }
+}
+
 //----------------------------------------------------------------------------//
 // Performance benchmarks are below.                                          //
 //----------------------------------------------------------------------------//
@@ -16,6 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_GATHER_FUNCTOR_H_
 #define TENSORFLOW_CORE_KERNELS_GATHER_FUNCTOR_H_
 
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include "absl/base/prefetch.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/bounds_check.h"
@@ -32,6 +37,22 @@ typedef Eigen::GpuDevice GPUDevice;
 
 namespace functor {
 
+// Number of rows that are prefetched ahead of the row being copied. Random
+// rows of a large table miss all caches, and a single row of lookahead is not
+// enough to hide the memory latency.
+constexpr int kGatherPrefetchDistance = 8;
+
+// Gathers of simple types from params of at least this many bytes, far beyond
+// the size of the caches, copy the rows of each shard in the order of their
+// addresses in params rather than in the order of the indices: rows that are
+// gathered repeatedly, as the hot ids of skewed embedding lookups are, are
+// then copied back to back while they are in cache, and the other reads
+// sweep params in one direction, sharing pages and TLB entries.
+constexpr int64_t kSortedGatherMinParamsBytes = int64_t{256} << 20;
+// ... provided that each shard has at least this many rows to copy, so that
+// sorting them pays off.
+constexpr int64_t kSortedGatherMinRowsPerShard = 64;
+
 // Helper method to copy using memcpy.
 template <typename T, typename Index, typename SliceIndex,
           SliceIndex static_slice_elems>
@@ -56,32 +77,41 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
   // Store the value of invalidate index for printing error information, it's a
   // shared variable.
   SliceIndex result = -1;
+  // Prefetches the row of params gathered into out(batch_idx, indices_idx).
+  auto prefetch = [&](SliceIndex batch_idx, SliceIndex indices_idx) {
+    const Index index = internal::SubtleMustCopy(indices(indices_idx));
+    if (FastBoundsCheck(index, limit)) {
+      absl::PrefetchToLocalCache(&params(batch_idx, index, 0));
+    }
+    absl::PrefetchToLocalCache(&out(batch_idx, indices_idx, 0));
+  };
   auto work = [&](int64_t start, int64_t end) {
     SliceIndex batch_idx = static_cast<SliceIndex>(start / indices_size);
     SliceIndex indices_idx = static_cast<SliceIndex>(start % indices_size);
-    SliceIndex batch_idx_end = static_cast<SliceIndex>(end / indices_size);
-    SliceIndex indices_idx_end = static_cast<SliceIndex>(end % indices_size);
+    // The position that is prefetched, kGatherPrefetchDistance ahead.
+    int64_t prefetch_pos = start;
+    SliceIndex prefetch_batch_idx = batch_idx;
+    SliceIndex prefetch_indices_idx = indices_idx;
+    auto advance_prefetch = [&]() {
+      prefetch(prefetch_batch_idx, prefetch_indices_idx);
+      ++prefetch_pos;
+      if (++prefetch_indices_idx == indices_size) {
+        prefetch_indices_idx = 0;
+        ++prefetch_batch_idx;
+      }
+    };
+    const int64_t prefetch_warmup_end =
+        std::min(end, start + kGatherPrefetchDistance);
+    while (prefetch_pos < prefetch_warmup_end) advance_prefetch();
 
-    while ((batch_idx < batch_idx_end) ||
-           (batch_idx == batch_idx_end && indices_idx < indices_idx_end)) {
-      SliceIndex i_next = indices_idx + 1;
-      SliceIndex b_next = batch_idx + 1;
+    for (int64_t pos = start; pos < end; ++pos) {
       const Index index = internal::SubtleMustCopy(indices(indices_idx));
       if (!FastBoundsCheck(index, limit)) {
         mutex_lock l(mu);
         result = indices_idx;
         return;
       }
-      if ((batch_idx == batch_idx_end && i_next < indices_idx_end) ||
-          (i_next < indices_size)) {
-        absl::PrefetchToLocalCache(&params(batch_idx, indices(i_next), 0));
-        absl::PrefetchToLocalCache(&out(batch_idx, i_next, 0));
-        b_next = batch_idx;
-      } else if (b_next <= batch_idx_end) {
-        absl::PrefetchToLocalCache(&params(b_next, indices(0), 0));
-        absl::PrefetchToLocalCache(&out(b_next, 0, 0));
-        i_next = 0;
-      }
+      if (prefetch_pos < end) advance_prefetch();
       // Copy using memcpy if possible, otherwise an Eigen loop
       // TODO(cwhipkey): avoid linking to framework to get Allocator (to improve
       // ahead-of-time compilation binary size).
@@ -98,13 +128,60 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
         out.template chip<0>(batch_idx).template chip<0>(indices_idx) =
             params.template chip<0>(batch_idx).template chip<0>(index);
       }
-      indices_idx = i_next;
-      batch_idx = b_next;
+      if (++indices_idx == indices_size) {
+        indices_idx = 0;
+        ++batch_idx;
+      }
+    }
+  };
+  // Copies the rows of a shard in the order of their addresses in params; see
+  // kSortedGatherMinParamsBytes.
+  auto sorted_work = [&](int64_t start, int64_t end) {
+    if (end - start < kSortedGatherMinRowsPerShard) {
+      work(start, end);
+      return;
+    }
+    // Pairs of (row of params, row of out), both counted in slices.
+    std::vector<std::pair<SliceIndex, SliceIndex>> rows;
+    rows.reserve(end - start);
+    SliceIndex batch_idx = static_cast<SliceIndex>(start / indices_size);
+    SliceIndex indices_idx = static_cast<SliceIndex>(start % indices_size);
+    for (int64_t pos = start; pos < end; ++pos) {
+      const Index index = internal::SubtleMustCopy(indices(indices_idx));
+      if (!FastBoundsCheck(index, limit)) {
+        mutex_lock l(mu);
+        result = indices_idx;
+        return;
+      }
+      rows.emplace_back(batch_idx * static_cast<SliceIndex>(limit) +
+                            static_cast<SliceIndex>(index),
+                        static_cast<SliceIndex>(pos));
+      if (++indices_idx == indices_size) {
+        indices_idx = 0;
+        ++batch_idx;
+      }
+    }
+    std::sort(rows.begin(), rows.end());
+    const size_t num_rows = rows.size();
+    for (size_t i = 0; i < num_rows; ++i) {
+      if (i + kGatherPrefetchDistance < num_rows) {
+        const SliceIndex next_row = rows[i + kGatherPrefetchDistance].first;
+        absl::PrefetchToLocalCache(params_base + next_row * slice_elems);
+      }
+      memcpy(out_base + rows[i].second * slice_elems,
+             params_base + rows[i].first * slice_elems, slice_bytes);
     }
   };
 
-  Shard(worker_threads->num_threads, worker_threads->workers,
-        batch_size * indices_size, slice_elems * sizeof(T), work);
+  const int64_t params_bytes =
+      static_cast<int64_t>(params.size()) * static_cast<int64_t>(sizeof(T));
+  if (is_simple_type<T>::value && params_bytes >= kSortedGatherMinParamsBytes) {
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          batch_size * indices_size, slice_elems * sizeof(T), sorted_work);
+  } else {
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          batch_size * indices_size, slice_elems * sizeof(T), work);
+  }
   return result;
 }
 
@@ -137,6 +214,29 @@ struct GatherFunctorCPU {
     }                                                                      \
   } while (0)
 
+    // Embedding tables commonly have rows of a power of two floats; copies of a
+    // static size compile to a few vector moves instead of a memcpy call.
+    if constexpr (std::is_same_v<T, float>) {
+      switch (slice_size) {
+        case 32:
+          CALL(32);
+          return bad_i;
+        case 64:
+          CALL(64);
+          return bad_i;
+        case 128:
+          CALL(128);
+          return bad_i;
+        case 256:
+          CALL(256);
+          return bad_i;
+        case 512:
+          CALL(512);
+          return bad_i;
+        default:
+          break;
+      }
+    }
     if (slice_size == 10)
       CALL(10);
     else if (slice_size == 20)
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -101,6 +102,26 @@ TEST_F(GatherOpTest, Simple_TwoD32_Axis0) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+TEST_F(GatherOpTest, Simple_TwoD32_Axis0_StaticRowWidths) {
+  for (int dim : {32, 64, 128, 256, 512}) {
+    inputs_.clear();
+    MakeOp(DT_FLOAT, DT_INT32);
+
+    AddInput<float>(TensorShape({5, dim}), [](int i) -> float { return i; });
+    AddInputFromArray<int32>(TensorShape({4}), {0, 4, 0, 2});
+    AddInputFromArray<int32>(TensorShape({}), {0});
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({4, dim}));
+    auto expected_mat = expected.matrix<float>();
+    const int rows[] = {0, 4, 0, 2};
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < dim; ++j) expected_mat(i, j) = rows[i] * dim + j;
+    }
+    test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+  }
+}
+
 TEST_F(GatherOpTest, InvalidInputShape_TwoD32) {
   MakeOp(DT_FLOAT, DT_INT32);
 
@@ -261,5 +282,58 @@ BM_GATHER(gpu, int32);
 BM_GATHER(cpu, int64_t);
 BM_GATHER(gpu, int64_t);
 
+// Gathers kLookups rows of `dim` floats from a table of `table_mb` megabytes.
+// A fraction `hot_percent` of the lookups go to a hot set of 1000 rows, as the
+// frequent ids of an embedding lookup do, and the others are uniform.
+static Graph* SkewedGather(int table_mb, int dim, int hot_percent) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const int64_t rows = (static_cast<int64_t>(table_mb) << 20) /
+                       static_cast<int64_t>(sizeof(float) * dim);
+  Tensor params(DT_FLOAT, TensorShape({rows, dim}));
+  params.flat<float>().setRandom();
+
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  const int64_t hot_rows = std::min<int64_t>(rows, 1000);
+  Tensor indices(DT_INT64, TensorShape({kLookups}));
+  for (int i = 0; i < kLookups; i++) {
+    // The hot rows are spread over the table.
+    indices.flat<int64_t>()(i) =
+        rnd.Uniform(100) < hot_percent
+            ? rnd.Uniform64(hot_rows) * (rows / hot_rows)
+            : rnd.Uniform64(rows);
+  }
+
+  Tensor axis(DT_INT64, TensorShape({}));
+  axis.scalar<int64_t>()() = 0;
+
+  test::graph::Gather(g, test::graph::Constant(g, params),
+                      test::graph::Constant(g, indices),
+                      test::graph::HostConstant(g, axis));
+  return g;
+}
+
+static void BM_cpu_skewed_gather(::testing::benchmark::State& state) {
+  const int table_mb = state.range(0);
+  const int dim = state.range(1);
+  const int hot_percent = state.range(2);
+  test::Benchmark("cpu", SkewedGather(table_mb, dim, hot_percent),
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  const int64_t tot = static_cast<int64_t>(state.iterations()) * kLookups * dim;
+  state.SetItemsProcessed(tot);
+  state.SetBytesProcessed(tot * sizeof(float));
+}
+BENCHMARK(BM_cpu_skewed_gather)
+    ->UseRealTime()
+    ->Args({64, 64, 0})
+    ->Args({64, 64, 90})
+    ->Args({1024, 64, 0})
+    ->Args({1024, 64, 90})
+    ->Args({1024, 128, 0})
+    ->Args({1024, 128, 90})
+    ->Args({1024, 512, 0})
+    ->Args({1024, 512, 90});
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,298 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/op_requires.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/util/image_resizer_state.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+// Bilinear interpolation weights along one axis, as computed by
+// ResizeBilinear with half pixel centers.
+struct Interpolation {
+  int64_t lower;  // Lower source index.
+  int64_t upper;  // Upper source index.
+  float lerp;     // Weight of the upper index.
+};
+
+// Computes the interpolation of the `out_size` output pixels along one axis
+// from a crop window that starts at `offset` in the original image. The
+// decoded pixels, downscaled by `ratio`, start at `decoded_offset` in the
+// downscaled image and are `in_size` long.
+std::vector<Interpolation> ComputeInterpolation(int64_t out_size,
+                                                int64_t in_size, float scale,
+                                                int64_t offset, int ratio,
+                                                int64_t decoded_offset) {
+  std::vector<Interpolation> result(out_size);
+  for (int64_t i = 0; i < out_size; ++i) {
+    // Without downscaling the decoded pixels are exactly the crop window, and
+    // the weights are those of ResizeBilinear.
+    const float in_crop = HalfPixelScaler()(i, scale);
+    const float in =
+        ratio == 1 ? in_crop
+                   : (offset + in_crop + 0.5f) / ratio - 0.5f - decoded_offset;
+    const float in_floor = std::floor(in);
+    result[i].lower = std::max(static_cast<int64_t>(in_floor), int64_t{0});
+    result[i].upper =
+        std::min(static_cast<int64_t>(std::ceil(in)), in_size - 1);
+    result[i].lerp = in - in_floor;
+  }
+  return result;
+}
+
+// Decodes the part of a JPEG image needed to produce a crop of it resized to a
+// given size, and writes the resized crop, normalized, in a single pass.
+//
+// This is equivalent to DecodeAndCropJpeg followed by ResizeBilinear with half
+// pixel centers, a cast and a per-channel normalization, but never
+// materializes more than the decoded crop. If `dct_scaling`, the crop is also
+// downscaled by libjpeg in the DCT domain, by the largest of 2, 4 or 8 that
+// keeps it at least as large as the output. This is much cheaper than decoding
+// at full size, and averages rather than skips the pixels it drops.
+template <typename T>
+class DecodeCropAndResizeJpegOp : public OpKernel {
+ public:
+  explicit DecodeCropAndResizeJpegOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 0 || channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument("channels must be 0, 1, or 3, got ",
+                                        channels_));
+    OP_REQUIRES_OK(context, context->GetAttr("mean", &mean_));
+    OP_REQUIRES_OK(context, context->GetAttr("stddev", &stddev_));
+    for (float stddev : stddev_) {
+      OP_REQUIRES(context, stddev != 0,
+                  errors::InvalidArgument("stddev must be non-zero"));
+    }
+    OP_REQUIRES_OK(context, context->GetAttr("dct_scaling", &dct_scaling_));
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    // Same default as DecodeJpeg.
+    flags_.dct_method =
+        dct_method == "INTEGER_ACCURATE" ? JDCT_ISLOW : JDCT_IFAST;
+    flags_.components = channels_;
+    flags_.crop = true;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(contents.shape()),
+                errors::InvalidArgument("contents must be scalar, got shape ",
+                                        contents.shape().DebugString()));
+    const Tensor& crop_window = context->input(1);
+    OP_REQUIRES(context,
+                crop_window.dims() == 1 && crop_window.dim_size(0) == 4,
+                errors::InvalidArgument(
+                    "crop_window must have four elements, got shape ",
+                    crop_window.shape().DebugString()));
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context, size.dims() == 1 && size.dim_size(0) == 2,
+                errors::InvalidArgument("size must have two elements, got ",
+                                        size.shape().DebugString()));
+    const StringPiece input = contents.scalar<tstring>()();
+    OP_REQUIRES(context, input.size() <= std::numeric_limits<int>::max(),
+                errors::InvalidArgument("JPEG contents are too large for int: ",
+                                        input.size()));
+
+    const auto crop_window_vec = crop_window.vec<int32>();
+    const int crop_y = crop_window_vec(0);
+    const int crop_x = crop_window_vec(1);
+    const int crop_height = crop_window_vec(2);
+    const int crop_width = crop_window_vec(3);
+    const int out_height = size.vec<int32>()(0);
+    const int out_width = size.vec<int32>()(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("size must be positive, got ",
+                                        out_height, "x", out_width));
+
+    int image_width;
+    int image_height;
+    int image_channels;
+    OP_REQUIRES(context,
+                jpeg::GetImageInfo(input.data(), input.size(), &image_width,
+                                   &image_height, &image_channels),
+                errors::InvalidArgument("Invalid JPEG data, size ",
+                                        input.size()));
+    OP_REQUIRES(
+        context,
+        crop_width > 0 && crop_height > 0 && crop_x >= 0 && crop_y >= 0 &&
+            crop_x <= image_width - crop_width &&
+            crop_y <= image_height - crop_height,
+        errors::InvalidArgument("Invalid crop window: y=", crop_y, ", x=",
+                                crop_x, ", h=", crop_height, ", w=",
+                                crop_width, " for image of size ",
+                                image_height, "x", image_width));
+
+    // Decode the crop window, downscaled by `ratio`, rounding it outwards to
+    // whole downscaled pixels.
+    int ratio = 1;
+    if (dct_scaling_) {
+      while (ratio < 8 &&
+             crop_height >= int64_t{2} * ratio * out_height &&
+             crop_width >= int64_t{2} * ratio * out_width) {
+        ratio *= 2;
+      }
+    }
+    jpeg::UncompressFlags flags = flags_;
+    flags.ratio = ratio;
+    flags.crop_y = crop_y / ratio;
+    flags.crop_x = crop_x / ratio;
+    flags.crop_height =
+        (crop_y + crop_height + ratio - 1) / ratio - flags.crop_y;
+    flags.crop_width = (crop_x + crop_width + ratio - 1) / ratio - flags.crop_x;
+
+    Tensor decoded;
+    int channels = 0;
+    const uint8* pixels = jpeg::Uncompress(
+        input.data(), input.size(), flags, nullptr /* nwarn */,
+        [&](int width, int height, int num_channels) -> uint8* {
+          Status status = context->allocate_temp(
+              DT_UINT8, TensorShape({height, width, num_channels}), &decoded);
+          if (!status.ok()) {
+            VLOG(1) << status;
+            context->SetStatus(status);
+            return nullptr;
+          }
+          channels = num_channels;
+          return decoded.flat<uint8>().data();
+        });
+    OP_REQUIRES(
+        context, pixels,
+        errors::InvalidArgument(
+            "jpeg::Uncompress failed. Invalid JPEG data or crop window."));
+    const int64_t decoded_height = decoded.dim_size(0);
+    const int64_t decoded_width = decoded.dim_size(1);
+
+    std::vector<float> offset(channels, 0.0f);
+    std::vector<float> scale(channels, 1.0f);
+    OP_REQUIRES_OK(context, ComputeNormalization(channels, &offset, &scale));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({out_height, out_width, channels}),
+                                &output));
+
+    const std::vector<Interpolation> ys = ComputeInterpolation(
+        out_height, decoded_height,
+        CalculateResizeScale(crop_height, out_height, false), crop_y, ratio,
+        flags.crop_y);
+    const std::vector<Interpolation> xs = ComputeInterpolation(
+        out_width, decoded_width,
+        CalculateResizeScale(crop_width, out_width, false), crop_x, ratio,
+        flags.crop_x);
+
+    const int64_t in_row_size = decoded_width * channels;
+    const int64_t out_row_size = int64_t{out_width} * channels;
+    T* out = output->flat<T>().data();
+    auto resize_rows = [&](int64_t start, int64_t limit) {
+      for (int64_t y = start; y < limit; ++y) {
+        const uint8* top = pixels + ys[y].lower * in_row_size;
+        const uint8* bottom = pixels + ys[y].upper * in_row_size;
+        const float y_lerp = ys[y].lerp;
+        T* out_row = out + y * out_row_size;
+        for (int64_t x = 0; x < out_width; ++x) {
+          const int64_t left = xs[x].lower * channels;
+          const int64_t right = xs[x].upper * channels;
+          const float x_lerp = xs[x].lerp;
+          for (int c = 0; c < channels; ++c) {
+            const float top_left = top[left + c];
+            const float top_right = top[right + c];
+            const float bottom_left = bottom[left + c];
+            const float bottom_right = bottom[right + c];
+            const float top_value = top_left + (top_right - top_left) * x_lerp;
+            const float bottom_value =
+                bottom_left + (bottom_right - bottom_left) * x_lerp;
+            const float value = top_value + (bottom_value - top_value) * y_lerp;
+            out_row[x * channels + c] =
+                static_cast<T>((value - offset[c]) * scale[c]);
+          }
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, out_height,
+          /*cost_per_unit=*/20 * out_row_size, resize_rows);
+  }
+
+ private:
+  // Computes the per-channel normalization `(value - offset) * scale` from
+  // the `mean` and `stddev` attrs, which hold either one value per channel, a
+  // single value for all channels, or nothing.
+  Status ComputeNormalization(int channels, std::vector<float>* offset,
+                              std::vector<float>* scale) const {
+    if (mean_.size() > 1 && mean_.size() != channels) {
+      return errors::InvalidArgument("mean must have 1 or ", channels,
+                                     " values, got ", mean_.size());
+    }
+    if (stddev_.size() > 1 && stddev_.size() != channels) {
+      return errors::InvalidArgument("stddev must have 1 or ", channels,
+                                     " values, got ", stddev_.size());
+    }
+    for (int c = 0; c < channels; ++c) {
+      if (!mean_.empty()) (*offset)[c] = mean_[mean_.size() == 1 ? 0 : c];
+      if (!stddev_.empty()) {
+        (*scale)[c] = 1.0f / stddev_[stddev_.size() == 1 ? 0 : c];
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  int channels_;
+  std::vector<float> mean_;
+  std::vector<float> stddev_;
+  bool dct_scaling_;
+  jpeg::UncompressFlags flags_;
+};
+
+#define REGISTER_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("DecodeCropAndResizeJpeg")      \
+                              .Device(DEVICE_CPU)              \
+                              .TypeConstraint<T>("dtype"),     \
+                          DecodeCropAndResizeJpegOp<T>);
+
+REGISTER_KERNEL(float);
+REGISTER_KERNEL(bfloat16);
+
+#undef REGISTER_KERNEL
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,224 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns a smooth RGB test image with the given size, encoded as a JPEG.
+tstring MakeJpeg(int height, int width) {
+  std::vector<uint8> pixels(height * width * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      uint8* pixel = &pixels[(y * width + x) * 3];
+      pixel[0] = 255 * x / width;
+      pixel[1] = 255 * y / height;
+      pixel[2] = 128 + 100 * std::sin(0.1 * (x + y));
+    }
+  }
+  jpeg::CompressFlags flags;
+  flags.format = jpeg::FORMAT_RGB;
+  flags.quality = 100;
+  return jpeg::Compress(pixels.data(), width, height, flags);
+}
+
+// Decodes the whole JPEG `contents` and resizes its crop window with
+// bilinear interpolation and half pixel centers.
+std::vector<float> Reference(const tstring& contents, int crop_y, int crop_x,
+                             int crop_height, int crop_width, int out_height,
+                             int out_width) {
+  jpeg::UncompressFlags flags;
+  flags.dct_method = JDCT_IFAST;
+  std::vector<uint8> image;
+  int width = 0;
+  jpeg::Uncompress(contents.data(), contents.size(), flags, nullptr,
+                   [&](int w, int h, int c) {
+                     width = w;
+                     image.resize(w * h * c);
+                     return image.data();
+                   });
+  const auto source = [&](float in, int size, int* lower, int* upper) {
+    *lower = std::max(static_cast<int>(std::floor(in)), 0);
+    *upper = std::min(static_cast<int>(std::ceil(in)), size - 1);
+    return in - std::floor(in);
+  };
+  std::vector<float> result;
+  for (int y = 0; y < out_height; ++y) {
+    int y0, y1;
+    const float dy = source((y + 0.5f) * crop_height / out_height - 0.5f,
+                            crop_height, &y0, &y1);
+    for (int x = 0; x < out_width; ++x) {
+      int x0, x1;
+      const float dx = source((x + 0.5f) * crop_width / out_width - 0.5f,
+                              crop_width, &x0, &x1);
+      for (int c = 0; c < 3; ++c) {
+        const auto at = [&](int y, int x) -> float {
+          return image[((crop_y + y) * width + crop_x + x) * 3 + c];
+        };
+        const float top = at(y0, x0) + (at(y0, x1) - at(y0, x0)) * dx;
+        const float bottom = at(y1, x0) + (at(y1, x1) - at(y1, x0)) * dx;
+        result.push_back(top + (bottom - top) * dy);
+      }
+    }
+  }
+  return result;
+}
+
+class DecodeCropAndResizeJpegOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType dtype, bool dct_scaling,
+              const std::vector<float>& mean = {},
+              const std::vector<float>& stddev = {}) {
+    TF_ASSERT_OK(NodeDefBuilder("op", "DecodeCropAndResizeJpeg")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("dtype", dtype)
+                     .Attr("mean", mean)
+                     .Attr("stddev", stddev)
+                     .Attr("dct_scaling", dct_scaling)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void AddInputs(const tstring& contents, const std::vector<int32>& crop,
+                 const std::vector<int32>& size) {
+    AddInputFromArray<tstring>(TensorShape({}), {contents});
+    AddInputFromArray<int32>(TensorShape({4}), crop);
+    AddInputFromArray<int32>(TensorShape({2}), size);
+  }
+
+  // Returns the absolute differences between the output and `expected`.
+  std::vector<float> Errors(const std::vector<float>& expected) {
+    const Tensor& output = *GetOutput(0);
+    EXPECT_EQ(output.NumElements(), expected.size());
+    std::vector<float> errors;
+    for (int i = 0; i < output.NumElements(); ++i) {
+      const float value = output.dtype() == DT_FLOAT
+                              ? output.flat<float>()(i)
+                              : static_cast<float>(output.flat<bfloat16>()(i));
+      errors.push_back(std::abs(value - expected[i]));
+    }
+    return errors;
+  }
+
+  float MaxError(const std::vector<float>& expected) {
+    const std::vector<float> errors = Errors(expected);
+    return *std::max_element(errors.begin(), errors.end());
+  }
+
+  float MeanError(const std::vector<float>& expected) {
+    const std::vector<float> errors = Errors(expected);
+    return std::accumulate(errors.begin(), errors.end(), 0.0f) / errors.size();
+  }
+};
+
+TEST_F(DecodeCropAndResizeJpegOpTest, MatchesDecodeCropAndResizeBilinear) {
+  const tstring contents = MakeJpeg(64, 48);
+  MakeOp(DT_FLOAT, /*dct_scaling=*/false);
+  AddInputs(contents, {5, 7, 40, 30}, {16, 12});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(GetOutput(0)->shape(), TensorShape({16, 12, 3}));
+  EXPECT_LT(MaxError(Reference(contents, 5, 7, 40, 30, 16, 12)), 2.0f);
+}
+
+TEST_F(DecodeCropAndResizeJpegOpTest, DctScalingStaysClose) {
+  const tstring contents = MakeJpeg(256, 192);
+  MakeOp(DT_FLOAT, /*dct_scaling=*/true);
+  // The crop is more than 4 times the output, so it is decoded at a quarter
+  // of its size, from a window that does not fall on downscaled pixels.
+  AddInputs(contents, {13, 9, 200, 170}, {48, 40});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(GetOutput(0)->shape(), TensorShape({48, 40, 3}));
+  // DCT scaling averages the pixels that bilinear resizing skips, so the
+  // output is only close to the reference on average.
+  EXPECT_LT(MeanError(Reference(contents, 13, 9, 200, 170, 48, 40)), 3.0f);
+}
+
+TEST_F(DecodeCropAndResizeJpegOpTest, NormalizesToBfloat16) {
+  const tstring contents = MakeJpeg(32, 32);
+  const std::vector<float> mean = {100, 110, 120};
+  const std::vector<float> stddev = {50, 60, 70};
+  MakeOp(DT_BFLOAT16, /*dct_scaling=*/false, mean, stddev);
+  AddInputs(contents, {0, 0, 32, 32}, {8, 8});
+  TF_ASSERT_OK(RunOpKernel());
+  std::vector<float> expected = Reference(contents, 0, 0, 32, 32, 8, 8);
+  for (int i = 0; i < expected.size(); ++i) {
+    expected[i] = (expected[i] - mean[i % 3]) / stddev[i % 3];
+  }
+  // bfloat16 keeps 8 bits of precision.
+  EXPECT_LT(MaxError(expected), 0.05f);
+}
+
+TEST_F(DecodeCropAndResizeJpegOpTest, InvalidCropWindow) {
+  MakeOp(DT_FLOAT, /*dct_scaling=*/true);
+  AddInputs(MakeJpeg(32, 32), {10, 0, 30, 32}, {8, 8});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(absl::StrContains(s.message(), "Invalid crop window")) << s;
+}
+
+TEST_F(DecodeCropAndResizeJpegOpTest, InvalidMean) {
+  MakeOp(DT_FLOAT, /*dct_scaling=*/true, {1, 2});
+  AddInputs(MakeJpeg(32, 32), {0, 0, 32, 32}, {8, 8});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(absl::StrContains(s.message(), "mean must have 1 or 3 values"))
+      << s;
+}
+
+// Decodes a crop of a 1024x768 image to a 224x224 output, with DCT scaling if
+// `state.range(0)`.
+void BM_DecodeCropAndResizeJpeg(::testing::benchmark::State& state) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor contents(DT_STRING, TensorShape({}));
+  contents.scalar<tstring>()() = MakeJpeg(768, 1024);
+  Node* node;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "DecodeCropAndResizeJpeg")
+          .Input(test::graph::Constant(g, contents))
+          .Input(test::graph::Constant(
+              g, test::AsTensor<int32>({0, 128, 768, 768})))
+          .Input(test::graph::Constant(g, test::AsTensor<int32>({224, 224})))
+          .Attr("dct_scaling", state.range(0) != 0)
+          .Finalize(g, &node));
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeCropAndResizeJpeg)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
@@ -19,9 +19,12 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/image/non_max_suppression_op.h"
 
+#include <algorithm>
 #include <cmath>
+#include <deque>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -110,64 +113,91 @@ static inline void ParseAndCheckCombinedNMSBoxSizes(OpKernelContext* context,
   OP_REQUIRES(context, boxes.dim_size(3) == 4,
               errors::InvalidArgument("boxes must have 4 columns"));
 }
-// Return intersection-over-union overlap between boxes i and j
-template <typename T>
-static inline float IOU(typename TTypes<T, 2>::ConstTensor boxes, int i,
-                        int j) {
-  const float ymin_i = Eigen::numext::mini<float>(
-      static_cast<float>(boxes(i, 0)), static_cast<float>(boxes(i, 2)));
-  const float xmin_i = Eigen::numext::mini<float>(
-      static_cast<float>(boxes(i, 1)), static_cast<float>(boxes(i, 3)));
-  const float ymax_i = Eigen::numext::maxi<float>(
-      static_cast<float>(boxes(i, 0)), static_cast<float>(boxes(i, 2)));
-  const float xmax_i = Eigen::numext::maxi<float>(
-      static_cast<float>(boxes(i, 1)), static_cast<float>(boxes(i, 3)));
-  const float ymin_j = Eigen::numext::mini<float>(
-      static_cast<float>(boxes(j, 0)), static_cast<float>(boxes(j, 2)));
-  const float xmin_j = Eigen::numext::mini<float>(
-      static_cast<float>(boxes(j, 1)), static_cast<float>(boxes(j, 3)));
-  const float ymax_j = Eigen::numext::maxi<float>(
-      static_cast<float>(boxes(j, 0)), static_cast<float>(boxes(j, 2)));
-  const float xmax_j = Eigen::numext::maxi<float>(
-      static_cast<float>(boxes(j, 1)), static_cast<float>(boxes(j, 3)));
-  const float area_i = (ymax_i - ymin_i) * (xmax_i - xmin_i);
-  const float area_j = (ymax_j - ymin_j) * (xmax_j - xmin_j);
-  if (area_i <= 0 || area_j <= 0) {
-    return 0.0;
+
+// Corners of a set of boxes ordered so that min <= max, and their areas, in
+// separate arrays so that one box can be compared against many at once.
+struct NormalizedBoxes {
+  std::vector<float> ymin;
+  std::vector<float> xmin;
+  std::vector<float> ymax;
+  std::vector<float> xmax;
+  std::vector<float> area;
+
+  void Reserve(int size) {
+    ymin.reserve(size);
+    xmin.reserve(size);
+    ymax.reserve(size);
+    xmax.reserve(size);
+    area.reserve(size);
   }
-  const float intersection_ymin = Eigen::numext::maxi<float>(ymin_i, ymin_j);
-  const float intersection_xmin = Eigen::numext::maxi<float>(xmin_i, xmin_j);
-  const float intersection_ymax = Eigen::numext::mini<float>(ymax_i, ymax_j);
-  const float intersection_xmax = Eigen::numext::mini<float>(xmax_i, xmax_j);
-  const float intersection_area =
-      Eigen::numext::maxi<float>(intersection_ymax - intersection_ymin, 0.0) *
-      Eigen::numext::maxi<float>(intersection_xmax - intersection_xmin, 0.0);
-  return intersection_area / (area_i + area_j - intersection_area);
-}
 
-static inline float IOU(const float* boxes, int i, int j) {
-  const float ymin_i = Eigen::numext::mini<float>(boxes[i], boxes[i + 2]);
-  const float xmin_i = Eigen::numext::mini<float>(boxes[i + 1], boxes[i + 3]);
-  const float ymax_i = Eigen::numext::maxi<float>(boxes[i], boxes[i + 2]);
-  const float xmax_i = Eigen::numext::maxi<float>(boxes[i + 1], boxes[i + 3]);
-  const float ymin_j = Eigen::numext::mini<float>(boxes[j], boxes[j + 2]);
-  const float xmin_j = Eigen::numext::mini<float>(boxes[j + 1], boxes[j + 3]);
-  const float ymax_j = Eigen::numext::maxi<float>(boxes[j], boxes[j + 2]);
-  const float xmax_j = Eigen::numext::maxi<float>(boxes[j + 1], boxes[j + 3]);
-  const float area_i = (ymax_i - ymin_i) * (xmax_i - xmin_i);
-  const float area_j = (ymax_j - ymin_j) * (xmax_j - xmin_j);
-  if (area_i <= 0 || area_j <= 0) {
-    return 0.0;
+  // Appends the box with corners (y1, x1) and (y2, x2).
+  void Add(float y1, float x1, float y2, float x2) {
+    ymin.push_back(Eigen::numext::mini<float>(y1, y2));
+    xmin.push_back(Eigen::numext::mini<float>(x1, x2));
+    ymax.push_back(Eigen::numext::maxi<float>(y1, y2));
+    xmax.push_back(Eigen::numext::maxi<float>(x1, x2));
+    area.push_back((ymax.back() - ymin.back()) * (xmax.back() - xmin.back()));
   }
-  const float intersection_ymin = Eigen::numext::maxi<float>(ymin_i, ymin_j);
-  const float intersection_xmin = Eigen::numext::maxi<float>(xmin_i, xmin_j);
-  const float intersection_ymax = Eigen::numext::mini<float>(ymax_i, ymax_j);
-  const float intersection_xmax = Eigen::numext::mini<float>(xmax_i, xmax_j);
-  const float intersection_area =
-      Eigen::numext::maxi<float>(intersection_ymax - intersection_ymin, 0.0) *
-      Eigen::numext::maxi<float>(intersection_xmax - intersection_xmin, 0.0);
-  return intersection_area / (area_i + area_j - intersection_area);
-}
+
+  int size() const { return area.size(); }
+
+  // Return intersection-over-union overlap between boxes i and j
+  float IOU(int i, int j) const {
+    if (area[i] <= 0 || area[j] <= 0) {
+      return 0.0;
+    }
+    const float intersection_ymin =
+        Eigen::numext::maxi<float>(ymin[i], ymin[j]);
+    const float intersection_xmin =
+        Eigen::numext::maxi<float>(xmin[i], xmin[j]);
+    const float intersection_ymax =
+        Eigen::numext::mini<float>(ymax[i], ymax[j]);
+    const float intersection_xmax =
+        Eigen::numext::mini<float>(xmax[i], xmax[j]);
+    const float intersection_area =
+        Eigen::numext::maxi<float>(intersection_ymax - intersection_ymin,
+                                   0.0) *
+        Eigen::numext::maxi<float>(intersection_xmax - intersection_xmin, 0.0);
+    return intersection_area / (area[i] + area[j] - intersection_area);
+  }
+
+  // Returns whether the box with corners (y1, x1) and (y2, x2) has an IOU
+  // above `threshold` with any of the boxes.  The IOUs of a block of boxes are
+  // computed without branches so that the compiler can vectorize them; blocks
+  // are visited from the last one, as the most recently added boxes are the
+  // most likely to overlap.
+  bool AnyIOUAbove(float y1, float x1, float y2, float x2,
+                   float threshold) const {
+    constexpr int kBlockSize = 8;
+    const float ymin_i = Eigen::numext::mini<float>(y1, y2);
+    const float xmin_i = Eigen::numext::mini<float>(x1, x2);
+    const float ymax_i = Eigen::numext::maxi<float>(y1, y2);
+    const float xmax_i = Eigen::numext::maxi<float>(x1, x2);
+    const float area_i = (ymax_i - ymin_i) * (xmax_i - xmin_i);
+    if (area_i <= 0) return false;
+    for (int block_end = size(); block_end > 0; block_end -= kBlockSize) {
+      const int block_begin = std::max(0, block_end - kBlockSize);
+      bool any_above = false;
+      for (int j = block_begin; j < block_end; ++j) {
+        const float intersection_area =
+            Eigen::numext::maxi<float>(
+                Eigen::numext::mini<float>(ymax_i, ymax[j]) -
+                    Eigen::numext::maxi<float>(ymin_i, ymin[j]),
+                0.0) *
+            Eigen::numext::maxi<float>(
+                Eigen::numext::mini<float>(xmax_i, xmax[j]) -
+                    Eigen::numext::maxi<float>(xmin_i, xmin[j]),
+                0.0);
+        const float iou =
+            intersection_area / (area_i + area[j] - intersection_area);
+        any_above |= (area[j] > 0) & (iou > threshold);
+      }
+      if (any_above) return true;
+    }
+    return false;
+  }
+};
 
 template <typename T>
 static inline T Overlap(typename TTypes<T, 2>::ConstTensor overlaps, int i,
@@ -178,9 +208,19 @@ static inline T Overlap(typename TTypes<T, 2>::ConstTensor overlaps, int i,
 template <typename T>
 static inline std::function<float(int, int)> CreateIOUSimilarityFn(
     const Tensor& boxes) {
+  // Normalize the boxes once rather than on every comparison.
   typename TTypes<T, 2>::ConstTensor boxes_data = boxes.tensor<T, 2>();
-  return std::bind(&IOU<T>, boxes_data, std::placeholders::_1,
-                   std::placeholders::_2);
+  auto normalized_boxes = std::make_shared<NormalizedBoxes>();
+  normalized_boxes->Reserve(boxes_data.dimension(0));
+  for (int i = 0; i < boxes_data.dimension(0); ++i) {
+    normalized_boxes->Add(static_cast<float>(boxes_data(i, 0)),
+                          static_cast<float>(boxes_data(i, 1)),
+                          static_cast<float>(boxes_data(i, 2)),
+                          static_cast<float>(boxes_data(i, 3)));
+  }
+  return [normalized_boxes](int i, int j) {
+    return normalized_boxes->IOU(i, j);
+  };
 }
 
 template <typename T>
@@ -219,13 +259,14 @@ void DoNonMaxSuppressionOp(OpKernelContext* context, const Tensor& scores,
     return ((bs_i.score == bs_j.score) && (bs_i.box_index > bs_j.box_index)) ||
            bs_i.score < bs_j.score;
   };
-  std::priority_queue<Candidate, std::deque<Candidate>, decltype(cmp)>
-      candidate_priority_queue(cmp);
+  std::deque<Candidate> candidates;
   for (int i = 0; i < scores_data.size(); ++i) {
     if (scores_data[i] > score_threshold) {
-      candidate_priority_queue.emplace(Candidate({i, scores_data[i], 0}));
+      candidates.push_back(Candidate({i, scores_data[i], 0}));
     }
   }
+  std::priority_queue<Candidate, std::deque<Candidate>, decltype(cmp)>
+      candidate_priority_queue(cmp, std::move(candidates));
 
   T scale = static_cast<T>(0.0);
   bool is_soft_nms = soft_nms_sigma > static_cast<T>(0.0);
@@ -348,57 +389,49 @@ void DoNMSPerClass(int batch_idx, int class_idx, const float* boxes_data,
     int box_index;
     float score;
   };
-  auto cmp = [](const Candidate bs_i, const Candidate bs_j) {
-    return bs_i.score < bs_j.score;
-  };
-  std::priority_queue<Candidate, std::vector<Candidate>, decltype(cmp)>
-      candidate_priority_queue(cmp);
-  float temp_score;
+  std::vector<Candidate> candidates;
   for (int i = 0; i < num_boxes; ++i) {
-    temp_score = scores_data[i * num_classes + class_idx];
-    if (temp_score > score_threshold) {
-      candidate_priority_queue.emplace(Candidate({i, temp_score}));
+    const float score = scores_data[i * num_classes + class_idx];
+    if (score > score_threshold) {
+      candidates.push_back(Candidate({i, score}));
     }
   }
 
-  std::vector<int> selected;
-  Candidate next_candidate;
-
-  int candidate_box_data_idx, selected_box_data_idx, class_box_idx;
-  class_box_idx = (q > 1) ? class_idx : 0;
-
-  float iou;
-  while (selected.size() < size_per_class &&
-         !candidate_priority_queue.empty()) {
-    next_candidate = candidate_priority_queue.top();
-    candidate_priority_queue.pop();
-
-    candidate_box_data_idx = (next_candidate.box_index * q + class_box_idx) * 4;
-
-    // Overlapping boxes are likely to have similar scores,
-    // therefore we iterate through the previously selected boxes backwards
-    // in order to see if `next_candidate` should be suppressed.
-    bool should_select = true;
-    for (int j = selected.size() - 1; j >= 0; --j) {
-      selected_box_data_idx = (selected[j] * q + class_box_idx) * 4;
-      iou = IOU(boxes_data, candidate_box_data_idx, selected_box_data_idx);
-      if (iou > iou_threshold) {
-        should_select = false;
-        break;
-      }
+  // Only the first few candidates in score order are usually visited before
+  // `size_per_class` boxes are selected, so the candidates are sorted in
+  // chunks of growing size as they are needed rather than all at once.
+  auto cmp = [](const Candidate& bs_i, const Candidate& bs_j) {
+    return bs_i.score > bs_j.score ||
+           (bs_i.score == bs_j.score && bs_i.box_index < bs_j.box_index);
+  };
+  int sorted_end = 0;
+  int sort_chunk_size = std::max(size_per_class, 16);
+
+  const int class_box_idx = (q > 1) ? class_idx : 0;
+  NormalizedBoxes selected;
+  selected.Reserve(size_per_class);
+
+  const int num_candidates = candidates.size();
+  for (int next = 0; selected.size() < size_per_class && next < num_candidates;
+       ++next) {
+    if (next == sorted_end) {
+      sorted_end = std::min(num_candidates, next + sort_chunk_size);
+      std::partial_sort(candidates.begin() + next,
+                        candidates.begin() + sorted_end, candidates.end(), cmp);
+      sort_chunk_size *= 2;
     }
+    const Candidate& next_candidate = candidates[next];
+    const float* box =
+        boxes_data + (next_candidate.box_index * q + class_box_idx) * 4;
 
-    if (should_select) {
+    if (!selected.AnyIOUAbove(box[0], box[1], box[2], box[3], iou_threshold)) {
       // Add the selected box to the result candidate. Sorted by score
       result_candidate_vec[selected.size() + size_per_class * class_idx] = {
           next_candidate.box_index,
           next_candidate.score,
           class_idx,
-          {boxes_data[candidate_box_data_idx],
-           boxes_data[candidate_box_data_idx + 1],
-           boxes_data[candidate_box_data_idx + 2],
-           boxes_data[candidate_box_data_idx + 3]}};
-      selected.push_back(next_candidate.box_index);
+          {box[0], box[1], box[2], box[3]}};
+      selected.Add(box[0], box[1], box[2], box[3]);
     }
   }
 }
@@ -77,4 +77,40 @@ BN_Boxes_Number(90, 90);
 BN_Boxes_Number(200, 1);
 BN_Boxes_Number(200, 200);
 
+static Graph* NonMaxSuppressionV3(int box_num) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor boxes(DT_FLOAT, TensorShape({box_num, 4}));
+  boxes.flat<float>().setRandom();
+  Tensor scores(DT_FLOAT, TensorShape({box_num}));
+  scores.flat<float>().setRandom();
+
+  Tensor max_output_size(100);
+  Tensor iou_threshold(float(0.3));
+  Tensor score_threshold(float(0.25));
+
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "NonMaxSuppressionV3")
+                  .Input(test::graph::Constant(g, boxes))
+                  .Input(test::graph::Constant(g, scores))
+                  .Input(test::graph::Constant(g, max_output_size))
+                  .Input(test::graph::Constant(g, iou_threshold))
+                  .Input(test::graph::Constant(g, score_threshold))
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_NonMaxSuppressionV3Dev(DEVICE, BN)                             \
+  static void BM_NMSV3_##DEVICE##_##BN(::testing::benchmark::State& state) { \
+    test::Benchmark(#DEVICE, NonMaxSuppressionV3(BN),                     \
+                    /*old_benchmark_api*/ false)                          \
+        .Run(state);                                                      \
+    state.SetItemsProcessed(state.iterations() * BN);                     \
+  }                                                                       \
+  BENCHMARK(BM_NMSV3_##DEVICE##_##BN);
+
+BM_NonMaxSuppressionV3Dev(cpu, 500);
+BM_NonMaxSuppressionV3Dev(cpu, 1917);
+BM_NonMaxSuppressionV3Dev(cpu, 10000);
+BM_NonMaxSuppressionV3Dev(cpu, 100000);
+
 }  // namespace tensorflow
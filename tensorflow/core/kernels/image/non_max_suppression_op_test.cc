@@ -1086,6 +1086,48 @@ TEST_F(CombinedNonMaxSuppressionOpTest, TestSelectFromThreeClusters) {
   test::ExpectTensorEqual<int>(expected_valid_d, *GetOutput(3));
 }
 
+TEST_F(CombinedNonMaxSuppressionOpTest, TestSelectFromManyBoxes) {
+  // 100 disjoint boxes along the diagonal, each with a duplicate shifted by a
+  // tenth of its size. Box i has score 1 - i / 200 and its duplicate a
+  // slightly lower score, so the first 40 boxes are selected in order.
+  constexpr int kNumBoxes = 100;
+  constexpr int kNumSelected = 40;
+  std::vector<float> boxes;
+  std::vector<float> scores;
+  for (int i = 0; i < kNumBoxes; ++i) {
+    const float offset = i * 0.01f;
+    boxes.insert(boxes.end(), {offset, offset, offset + 0.01f, offset + 0.01f});
+    scores.push_back(1.0f - i / 200.0f);
+    boxes.insert(boxes.end(),
+                 {offset + 0.001f, offset, offset + 0.011f, offset + 0.01f});
+    scores.push_back(1.0f - i / 200.0f - 0.001f);
+  }
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({1, 2 * kNumBoxes, 1, 4}), boxes);
+  AddInputFromArray<float>(TensorShape({1, 2 * kNumBoxes, 1}), scores);
+  AddInputFromArray<int>(TensorShape({}), {kNumSelected});
+  AddInputFromArray<int>(TensorShape({}), {kNumSelected});
+  AddInputFromArray<float>(TensorShape({}), {.5f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> expected_boxes;
+  std::vector<float> expected_scores;
+  for (int i = 0; i < kNumSelected; ++i) {
+    expected_boxes.insert(expected_boxes.end(), boxes.begin() + 8 * i,
+                          boxes.begin() + 8 * i + 4);
+    expected_scores.push_back(scores[2 * i]);
+  }
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>(expected_boxes, TensorShape({1, kNumSelected, 4})),
+      *GetOutput(0));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>(expected_scores, TensorShape({1, kNumSelected})),
+      *GetOutput(1));
+  test::ExpectTensorEqual<int>(test::AsTensor<int>({kNumSelected}),
+                               *GetOutput(3));
+}
+
 TEST_F(CombinedNonMaxSuppressionOpTest,
        TestSelectFromThreeClustersNoBoxClipping) {
   MakeOp(false, false);
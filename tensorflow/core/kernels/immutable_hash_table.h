@@ -0,0 +1,174 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_IMMUTABLE_HASH_TABLE_H_
+#define TENSORFLOW_CORE_KERNELS_IMMUTABLE_HASH_TABLE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/hash/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/prefetch.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// A hash table that is built once from distinct keys and their values, and
+// then searched without locks by any number of threads.
+//
+// The keys and the values are kept in two arrays, in the order they were
+// given, and indexed by an open addressing table with linear probing whose
+// slots are single words. A slot holds the position of its entry and the top
+// bits of the hash of its key, so probes only read the slot array until a
+// likely match is found, and finding a key usually compares just that key.
+//
+// `FindBatch()` pipelines its lookups: while it compares the key of one lookup,
+// it has already prefetched the likely entry of a later one and the slot of a
+// later one still, so that their cache misses overlap.
+template <typename K, typename V>
+class ImmutableHashTable {
+ public:
+  ImmutableHashTable() : mask_(0), slots_(1, kEmptySlot) {}
+
+  // Builds the table of `keys`, which must be distinct, and `values`.
+  ImmutableHashTable(std::vector<K> keys, std::vector<V> values)
+      : keys_(std::move(keys)), values_(new V[values.size()]) {
+    CHECK_EQ(keys_.size(), values.size());
+    std::move(values.begin(), values.end(), values_.get());
+    CHECK_LT(keys_.size(), kPositionMask);
+    // Keeps the load factor at most 2/3, so that probes for missing keys end
+    // after a few slots.
+    size_t num_slots = 8;
+    while (num_slots < keys_.size() + keys_.size() / 2) num_slots *= 2;
+    mask_ = num_slots - 1;
+    slots_.assign(num_slots, kEmptySlot);
+    for (size_t i = 0; i < keys_.size(); ++i) {
+      const uint64_t hash = Hash(keys_[i]);
+      size_t slot = hash & mask_;
+      while (slots_[slot] != kEmptySlot) slot = (slot + 1) & mask_;
+      slots_[slot] = MakeSlot(hash, i);
+    }
+  }
+
+  size_t size() const { return keys_.size(); }
+
+  // The keys and their values, in the order they were given.
+  const std::vector<K>& keys() const { return keys_; }
+  const V* values() const { return values_.get(); }
+
+  // Returns the value of `key`, or null if it is not in the table.
+  const V* Find(const K& key) const { return Probe(key, Hash(key)); }
+
+  // Calls `found(i, Find(keys[i]))` for every i in [0, num_keys), in order.
+  template <typename Callback>
+  void FindBatch(const K* keys, int64_t num_keys, Callback&& found) const {
+    uint64_t hashes[kPipelineSize];
+    const auto prefetch_slot = [&](int64_t i) {
+      const uint64_t hash = Hash(keys[i]);
+      hashes[i & (kPipelineSize - 1)] = hash;
+      port::prefetch<port::PREFETCH_HINT_T0>(&slots_[hash & mask_]);
+    };
+    const auto prefetch_entry = [&](int64_t i) {
+      const uint64_t hash = hashes[i & (kPipelineSize - 1)];
+      const uint64_t slot = slots_[hash & mask_];
+      if (slot != kEmptySlot && SlotMatches(slot, hash)) {
+        port::prefetch<port::PREFETCH_HINT_T0>(&keys_[SlotPosition(slot)]);
+        port::prefetch<port::PREFETCH_HINT_T0>(&values_[SlotPosition(slot)]);
+      }
+    };
+    const auto find = [&](int64_t i) {
+      found(i, Probe(keys[i], hashes[i & (kPipelineSize - 1)]));
+    };
+    if (num_keys < 2 * kPrefetchDistance) {
+      for (int64_t i = 0; i < num_keys; ++i) found(i, Find(keys[i]));
+      return;
+    }
+    for (int64_t i = 0; i < kPrefetchDistance; ++i) prefetch_slot(i);
+    for (int64_t i = kPrefetchDistance; i < 2 * kPrefetchDistance; ++i) {
+      prefetch_slot(i);
+      prefetch_entry(i - kPrefetchDistance);
+    }
+    for (int64_t i = 2 * kPrefetchDistance; i < num_keys; ++i) {
+      prefetch_slot(i);
+      prefetch_entry(i - kPrefetchDistance);
+      find(i - 2 * kPrefetchDistance);
+    }
+    for (int64_t i = num_keys; i < num_keys + kPrefetchDistance; ++i) {
+      prefetch_entry(i - kPrefetchDistance);
+      find(i - 2 * kPrefetchDistance);
+    }
+    for (int64_t i = num_keys - kPrefetchDistance; i < num_keys; ++i) find(i);
+  }
+
+  // Returns the number of bytes used by the table, not counting memory that
+  // the keys and values point to.
+  int64_t MemoryUsed() const {
+    return keys_.size() * (sizeof(K) + sizeof(V)) +
+           slots_.size() * sizeof(uint64_t);
+  }
+
+ private:
+  // A slot holds the top `kTagBits` bits of the hash of its key, and one more
+  // than the position of its entry, so that an empty slot is zero.
+  static constexpr int kTagBits = 24;
+  static constexpr int kPositionBits = 64 - kTagBits;
+  static constexpr uint64_t kPositionMask = (uint64_t{1} << kPositionBits) - 1;
+  static constexpr uint64_t kEmptySlot = 0;
+
+  // Number of lookups between the prefetch of the slot of a key and the
+  // prefetch of its likely entry, and between that and its probe.
+  static constexpr int kPrefetchDistance = 8;
+  // A power of two larger than the number of lookups in flight.
+  static constexpr int kPipelineSize = 32;
+  static_assert(kPipelineSize > 2 * kPrefetchDistance);
+
+  static uint64_t Hash(const K& key) { return absl::Hash<K>()(key); }
+
+  static uint64_t MakeSlot(uint64_t hash, size_t position) {
+    return (hash >> kPositionBits << kPositionBits) | (position + 1);
+  }
+
+  static bool SlotMatches(uint64_t slot, uint64_t hash) {
+    return (slot >> kPositionBits) == (hash >> kPositionBits);
+  }
+
+  static size_t SlotPosition(uint64_t slot) {
+    return (slot & kPositionMask) - 1;
+  }
+
+  const V* Probe(const K& key, uint64_t hash) const {
+    for (size_t slot = hash & mask_;; slot = (slot + 1) & mask_) {
+      const uint64_t value = slots_[slot];
+      if (value == kEmptySlot) return nullptr;
+      if (SlotMatches(value, hash) && keys_[SlotPosition(value)] == key) {
+        return &values_[SlotPosition(value)];
+      }
+    }
+  }
+
+  std::vector<K> keys_;
+  // Not a vector, so that the values can be pointed to even if they are bool.
+  std::unique_ptr<V[]> values_;
+  size_t mask_;
+  std::vector<uint64_t> slots_;
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_IMMUTABLE_HASH_TABLE_H_
@@ -0,0 +1,128 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/immutable_hash_table.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+ImmutableHashTable<tstring, int64_t> MakeVocabulary(int64_t size) {
+  std::vector<tstring> keys;
+  std::vector<int64_t> values;
+  for (int64_t i = 0; i < size; ++i) {
+    keys.push_back(strings::StrCat("token", i));
+    values.push_back(i);
+  }
+  return ImmutableHashTable<tstring, int64_t>(std::move(keys),
+                                              std::move(values));
+}
+
+TEST(ImmutableHashTableTest, Empty) {
+  ImmutableHashTable<int64_t, float> table;
+  EXPECT_EQ(table.size(), 0);
+  EXPECT_EQ(table.Find(7), nullptr);
+  ImmutableHashTable<int64_t, float> built({}, {});
+  EXPECT_EQ(built.Find(7), nullptr);
+}
+
+TEST(ImmutableHashTableTest, Find) {
+  ImmutableHashTable<tstring, int64_t> table = MakeVocabulary(1000);
+  EXPECT_EQ(table.size(), 1000);
+  for (int64_t i = 0; i < 1000; ++i) {
+    const int64_t* value = table.Find(strings::StrCat("token", i));
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, i);
+  }
+  EXPECT_EQ(table.Find("token1000"), nullptr);
+  EXPECT_EQ(table.Find(""), nullptr);
+}
+
+TEST(ImmutableHashTableTest, KeepsOrder) {
+  ImmutableHashTable<int32, bool> table({5, 3, 9}, {true, false, true});
+  EXPECT_EQ(table.keys(), std::vector<int32>({5, 3, 9}));
+  EXPECT_FALSE(table.values()[1]);
+  ASSERT_NE(table.Find(9), nullptr);
+  EXPECT_TRUE(*table.Find(9));
+}
+
+TEST(ImmutableHashTableTest, FindBatchMatchesFind) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int64_t> keys;
+  std::vector<int64_t> values;
+  absl::flat_hash_map<int64_t, int64_t> expected;
+  while (expected.size() < 5000) {
+    const int64_t key = rnd.Uniform64(1 << 20);
+    if (expected.emplace(key, expected.size()).second) {
+      keys.push_back(key);
+      values.push_back(expected.size() - 1);
+    }
+  }
+  ImmutableHashTable<int64_t, int64_t> table(keys, values);
+  // Both shorter and longer than the lookups in flight.
+  for (int num_queries : {0, 1, 7, 16, 17, 33, 1000}) {
+    std::vector<int64_t> queries(num_queries);
+    for (int64_t& query : queries) query = rnd.Uniform64(1 << 20);
+    std::vector<int64_t> found(num_queries, -2);
+    table.FindBatch(queries.data(), num_queries,
+                    [&](int64_t i, const int64_t* value) {
+                      EXPECT_EQ(found[i], -2);
+                      found[i] = value == nullptr ? -1 : *value;
+                    });
+    for (int i = 0; i < num_queries; ++i) {
+      auto it = expected.find(queries[i]);
+      EXPECT_EQ(found[i], it == expected.end() ? -1 : it->second);
+      EXPECT_EQ(table.Find(queries[i]),
+                it == expected.end() ? nullptr : &table.values()[it->second]);
+    }
+  }
+}
+
+// Looks up a batch of 64K keys, about a tenth of them missing, in a vocabulary
+// of `state.range(0)` strings.
+void BM_FindBatch(::testing::benchmark::State& state) {
+  const int64_t size = state.range(0);
+  ImmutableHashTable<tstring, int64_t> table = MakeVocabulary(size);
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<tstring> queries(1 << 16);
+  for (tstring& query : queries) {
+    query = strings::StrCat("token", rnd.Uniform64(size + size / 10));
+  }
+  std::vector<int64_t> values(queries.size());
+  for (auto s : state) {
+    table.FindBatch(queries.data(), queries.size(),
+                    [&](int64_t i, const int64_t* value) {
+                      values[i] = value == nullptr ? -1 : *value;
+                    });
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_FindBatch)->Arg(1000)->Arg(100000)->Arg(1000000);
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
@@ -30,7 +30,7 @@ Status InitializableLookupTable::Find(OpKernelContext* ctx, const Tensor& keys,
   // Do not let the use migrate before the check;  table is used without
   // a lock by the readers.
   std::atomic_thread_fence(std::memory_order_acquire);
-  return DoFind(keys, values, default_value);
+  return DoFind(ctx, keys, values, default_value);
 }
 
 Status InitializableLookupTable::ImportValues(OpKernelContext* ctx,
@@ -95,6 +95,7 @@ Status InitializableLookupTable::Initialize(
   if (!errors::IsOutOfRange(iter.status())) {
     return iter.status();
   }
+  TF_RETURN_IF_ERROR(DoFinalize());
 
   initializer_serializer_ = std::move(serializer);
   is_initialized_.store(true, std::memory_order_release);
@@ -195,10 +195,22 @@ class InitializableLookupTable : public LookupInterface {
   // underlying data structure.
   virtual Status DoInsert(const Tensor& keys, const Tensor& values) = 0;
 
+  // Called by Initialize() once all the entries have been inserted, before
+  // the table is marked as initialized. Implementations may use it to build a
+  // read-only representation of the table.
+  virtual Status DoFinalize() { return absl::OkStatus(); }
+
   // Performs the batch find operation on the underlying data structure.
   virtual Status DoFind(const Tensor& keys, Tensor* values,
                         const Tensor& default_value) = 0;
 
+  // Same as above, but implementations may use `ctx`, e.g. to run the lookups
+  // of a large batch on its worker threads. `ctx` may be null.
+  virtual Status DoFind(OpKernelContext* ctx, const Tensor& keys,
+                        Tensor* values, const Tensor& default_value) {
+    return DoFind(keys, values, default_value);
+  }
+
   virtual Status AreEntriesSame(const InitTableIterator& iter, bool* result);
 
   mutex mu_;
@@ -0,0 +1,469 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A curated suite of microbenchmarks of the hottest CPU and GPU kernels, over
+// shapes and dtypes taken from common models (ResNet, Transformer encoders,
+// recommendation models and input pipelines).
+//
+// Unlike the ad hoc benchmarks of the *_op_test.cc files, the benchmark names
+// only depend on the kernel, device, dtype and shape, so that results can be
+// compared across commits: add new shapes rather than changing existing ones.
+// When run with --benchmark_filter, results are also written in test_log.proto
+// format if TEST_REPORT_FILE_PREFIX is set, e.g. by
+// //tensorflow/tools/test:kernel_benchmark_suite, and two such results can be
+// compared with //tensorflow/tools/test:compare_benchmarks.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/util/reporter.h"
+#include "tensorflow/core/util/test_log.pb.h"
+
+namespace tensorflow {
+namespace {
+
+template <typename T>
+Tensor RandomTensor(const TensorShape& shape) {
+  Tensor tensor(DataTypeToEnum<T>::value, shape);
+  tensor.flat<T>().setRandom();
+  return tensor;
+}
+
+// Returns `n` indices in [0, num_rows), spread over the whole range.
+template <typename Index>
+Tensor SpreadIndices(int64_t n, int64_t num_rows) {
+  Tensor indices(DataTypeToEnum<Index>::value, TensorShape({n}));
+  auto indices_flat = indices.flat<Index>();
+  for (int64_t i = 0; i < n; ++i) {
+    indices_flat(i) = (i * 7919) % num_rows;
+  }
+  return indices;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// MatMul                                                                     //
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+Graph* MatMul(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Matmul(g, test::graph::Constant(g, RandomTensor<T>({m, k})),
+                      test::graph::Constant(g, RandomTensor<T>({k, n})),
+                      /*transpose_a=*/false, /*transpose_b=*/false);
+  return g;
+}
+
+// Dense layers of MLPs and transformers, at inference and training batches.
+#define BM_SUITE_MATMUL(DEVICE, T, TYPE_NAME)                                 \
+  static void BM_MatMul_##DEVICE##_##TYPE_NAME(                               \
+      ::testing::benchmark::State& state) {                                   \
+    const int m = state.range(0);                                             \
+    const int k = state.range(1);                                             \
+    const int n = state.range(2);                                             \
+    test::Benchmark(#DEVICE, MatMul<T>(m, k, n), /*old_benchmark_api=*/false) \
+        .Run(state);                                                          \
+    state.SetItemsProcessed(state.iterations() * 2 * m * k * n);              \
+  }                                                                           \
+  BENCHMARK(BM_MatMul_##DEVICE##_##TYPE_NAME)                                 \
+      ->UseRealTime()                                                         \
+      ->Args({1, 1024, 1024})                                                 \
+      ->Args({32, 1024, 4096})                                                \
+      ->Args({128, 768, 3072})                                                \
+      ->Args({512, 3072, 768})                                                \
+      ->Args({2048, 1024, 1024});
+
+////////////////////////////////////////////////////////////////////////////////
+// Conv2D                                                                     //
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+Graph* Conv2D(int batch, int size, int in_depth, int filter_size,
+              int out_depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* conv;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("conv"), "Conv2D")
+          .Input(test::graph::Constant(
+              g, RandomTensor<T>({batch, size, size, in_depth})))
+          .Input(test::graph::Constant(
+              g,
+              RandomTensor<T>({filter_size, filter_size, in_depth, out_depth})))
+          .Attr("T", DataTypeToEnum<T>::value)
+          .Attr("strides", {1, 1, 1, 1})
+          .Attr("padding", "SAME")
+          .Attr("data_format", "NHWC")
+          .Finalize(g, &conv));
+  return g;
+}
+
+// ResNet-50 convolutions: {batch, height and width, input depth, filter height
+// and width, output depth}.
+#define BM_SUITE_CONV2D(DEVICE, T, TYPE_NAME)                                  \
+  static void BM_Conv2D_##DEVICE##_##TYPE_NAME(                                \
+      ::testing::benchmark::State& state) {                                    \
+    const int batch = state.range(0);                                          \
+    const int size = state.range(1);                                           \
+    const int in_depth = state.range(2);                                       \
+    const int filter_size = state.range(3);                                    \
+    const int out_depth = state.range(4);                                      \
+    test::Benchmark(#DEVICE,                                                   \
+                    Conv2D<T>(batch, size, in_depth, filter_size, out_depth),  \
+                    /*old_benchmark_api=*/false)                               \
+        .Run(state);                                                           \
+    state.SetItemsProcessed(state.iterations() * 2 * batch * size * size *     \
+                            in_depth * filter_size * filter_size * out_depth); \
+  }                                                                            \
+  BENCHMARK(BM_Conv2D_##DEVICE##_##TYPE_NAME)                                  \
+      ->UseRealTime()                                                          \
+      ->Args({1, 56, 64, 3, 64})                                               \
+      ->Args({32, 56, 64, 3, 64})                                              \
+      ->Args({32, 28, 128, 3, 128})                                            \
+      ->Args({32, 14, 256, 1, 1024})                                           \
+      ->Args({32, 7, 2048, 1, 512});
+
+////////////////////////////////////////////////////////////////////////////////
+// Gather                                                                     //
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Index>
+Graph* Gather(int num_rows, int dim, int num_indices) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor axis(DataTypeToEnum<Index>::value, TensorShape({}));
+  axis.scalar<Index>()() = 0;
+  test::graph::Gather(
+      g, test::graph::Constant(g, RandomTensor<T>({num_rows, dim})),
+      test::graph::Constant(g, SpreadIndices<Index>(num_indices, num_rows)),
+      test::graph::HostConstant(g, axis));
+  return g;
+}
+
+// Embedding lookups: {vocabulary size, embedding dimension, number of ids}.
+#define BM_SUITE_GATHER(DEVICE, T, INDEX)                                   \
+  static void BM_Gather_##DEVICE##_##T##_##INDEX(                           \
+      ::testing::benchmark::State& state) {                                 \
+    const int num_rows = state.range(0);                                    \
+    const int dim = state.range(1);                                         \
+    const int num_indices = state.range(2);                                 \
+    test::Benchmark(#DEVICE, Gather<T, INDEX>(num_rows, dim, num_indices),  \
+                    /*old_benchmark_api=*/false)                            \
+        .Run(state);                                                        \
+    state.SetBytesProcessed(state.iterations() * num_indices * dim *        \
+                            sizeof(T));                                     \
+  }                                                                         \
+  BENCHMARK(BM_Gather_##DEVICE##_##T##_##INDEX)                             \
+      ->UseRealTime()                                                       \
+      ->Args({30000, 768, 4096})                                            \
+      ->Args({100000, 64, 16384})                                           \
+      ->Args({1000000, 32, 65536});
+
+////////////////////////////////////////////////////////////////////////////////
+// SparseSegmentSum and SparseSegmentMean                                     //
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+Graph* SparseSegmentReduction(const string& op, int num_rows, int dim,
+                              int num_indices, int segment_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor segment_ids(DT_INT32, TensorShape({num_indices}));
+  auto segment_ids_flat = segment_ids.flat<int32>();
+  for (int i = 0; i < num_indices; ++i) {
+    segment_ids_flat(i) = i / segment_size;
+  }
+  Node* reduction;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), op)
+          .Input(test::graph::Constant(g, RandomTensor<T>({num_rows, dim})))
+          .Input(test::graph::Constant(
+              g, SpreadIndices<int32>(num_indices, num_rows)))
+          .Input(test::graph::Constant(g, segment_ids))
+          .Attr("T", DataTypeToEnum<T>::value)
+          .Finalize(g, &reduction));
+  return g;
+}
+
+// Pooled embedding lookups: {vocabulary size, embedding dimension, number of
+// ids, ids per segment}.
+#define BM_SUITE_SPARSE_SEGMENT(DEVICE, OP, T)                               \
+  static void BM_##OP##_##DEVICE##_##T(::testing::benchmark::State& state) { \
+    const int num_rows = state.range(0);                                     \
+    const int dim = state.range(1);                                          \
+    const int num_indices = state.range(2);                                  \
+    const int segment_size = state.range(3);                                 \
+    test::Benchmark(#DEVICE,                                                 \
+                    SparseSegmentReduction<T>(#OP, num_rows, dim,            \
+                                              num_indices, segment_size),    \
+                    /*old_benchmark_api=*/false)                             \
+        .Run(state);                                                         \
+    state.SetBytesProcessed(state.iterations() * num_indices * dim *         \
+                            sizeof(T));                                      \
+  }                                                                          \
+  BENCHMARK(BM_##OP##_##DEVICE##_##T)                                        \
+      ->UseRealTime()                                                        \
+      ->Args({100000, 64, 16384, 8})                                         \
+      ->Args({100000, 64, 16384, 128})                                       \
+      ->Args({1000000, 32, 4096, 32});
+
+////////////////////////////////////////////////////////////////////////////////
+// Softmax                                                                    //
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+Graph* Softmax(int batch, int num_classes) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Unary(
+      g, "Softmax",
+      test::graph::Constant(g, RandomTensor<T>({batch, num_classes})));
+  return g;
+}
+
+// Classifiers and attention: {batch, number of classes}.
+#define BM_SUITE_SOFTMAX(DEVICE, T, TYPE_NAME)                               \
+  static void BM_Softmax_##DEVICE##_##TYPE_NAME(                             \
+      ::testing::benchmark::State& state) {                                  \
+    const int batch = state.range(0);                                        \
+    const int num_classes = state.range(1);                                  \
+    test::Benchmark(#DEVICE, Softmax<T>(batch, num_classes),                 \
+                    /*old_benchmark_api=*/false)                             \
+        .Run(state);                                                         \
+    state.SetBytesProcessed(state.iterations() * batch * num_classes *       \
+                            sizeof(T));                                      \
+  }                                                                          \
+  BENCHMARK(BM_Softmax_##DEVICE##_##TYPE_NAME)                               \
+      ->UseRealTime()                                                        \
+      ->Args({128, 1000})                                                    \
+      ->Args({32, 32000})                                                    \
+      ->Args({12 * 512, 512});
+
+////////////////////////////////////////////////////////////////////////////////
+// Transpose                                                                  //
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+Graph* Transpose(const TensorShape& shape, const std::vector<int32>& perm) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor perm_tensor(DT_INT32,
+                     TensorShape({static_cast<int64_t>(perm.size())}));
+  std::copy(perm.begin(), perm.end(), perm_tensor.flat<int32>().data());
+  test::graph::Binary(g, "Transpose",
+                      test::graph::Constant(g, RandomTensor<T>(shape)),
+                      test::graph::HostConstant(g, perm_tensor));
+  return g;
+}
+
+// Layout changes: NHWC to NCHW of activations, and the heads of transformers
+// from {batch, sequence, heads, head size} to {batch, heads, sequence, head
+// size}.
+#define BM_SUITE_TRANSPOSE(DEVICE, T, TYPE_NAME)                             \
+  static void BM_TransposeNHWCToNCHW_##DEVICE##_##TYPE_NAME(                 \
+      ::testing::benchmark::State& state) {                                  \
+    const TensorShape shape({state.range(0), state.range(1), state.range(1), \
+                             state.range(2)});                               \
+    test::Benchmark(#DEVICE, Transpose<T>(shape, {0, 3, 1, 2}),              \
+                    /*old_benchmark_api=*/false)                             \
+        .Run(state);                                                         \
+    state.SetBytesProcessed(state.iterations() * shape.num_elements() *      \
+                            sizeof(T));                                      \
+  }                                                                          \
+  BENCHMARK(BM_TransposeNHWCToNCHW_##DEVICE##_##TYPE_NAME)                   \
+      ->UseRealTime()                                                        \
+      ->Args({32, 56, 64})                                                   \
+      ->Args({32, 14, 1024});                                                \
+  static void BM_TransposeHeads_##DEVICE##_##TYPE_NAME(                      \
+      ::testing::benchmark::State& state) {                                  \
+    const TensorShape shape(                                                 \
+        {state.range(0), state.range(1), state.range(2), state.range(3)});   \
+    test::Benchmark(#DEVICE, Transpose<T>(shape, {0, 2, 1, 3}),              \
+                    /*old_benchmark_api=*/false)                             \
+        .Run(state);                                                         \
+    state.SetBytesProcessed(state.iterations() * shape.num_elements() *      \
+                            sizeof(T));                                      \
+  }                                                                          \
+  BENCHMARK(BM_TransposeHeads_##DEVICE##_##TYPE_NAME)                        \
+      ->UseRealTime()                                                        \
+      ->Args({32, 128, 12, 64})                                              \
+      ->Args({8, 512, 16, 64});
+
+////////////////////////////////////////////////////////////////////////////////
+// ParseExampleV2                                                             //
+////////////////////////////////////////////////////////////////////////////////
+
+// Returns `batch` serialized Examples with `num_keys` float features of
+// `feature_size` values each.
+Tensor SerializedExamples(int batch, int num_keys, int feature_size) {
+  Example example;
+  auto& features = *example.mutable_features()->mutable_feature();
+  for (int k = 0; k < num_keys; ++k) {
+    Feature& feature = features[strings::StrCat("feature_", k)];
+    for (int i = 0; i < feature_size; ++i) {
+      feature.mutable_float_list()->add_value(i);
+    }
+  }
+  Tensor serialized(DT_STRING, TensorShape({batch}));
+  for (int b = 0; b < batch; ++b) {
+    CHECK(SerializeToTString(example, &serialized.vec<tstring>()(b)));
+  }
+  return serialized;
+}
+
+Graph* ParseExample(int batch, int num_keys, int feature_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor dense_keys(DT_STRING, TensorShape({num_keys}));
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  std::vector<PartialTensorShape> dense_shapes;
+  for (int k = 0; k < num_keys; ++k) {
+    dense_keys.vec<tstring>()(k) = strings::StrCat("feature_", k);
+    dense_defaults.emplace_back(test::graph::Constant(
+        g, Tensor(DT_FLOAT, TensorShape({feature_size}))));
+    dense_shapes.push_back(PartialTensorShape({feature_size}));
+  }
+  const Tensor no_keys(DT_STRING, TensorShape({0}));
+  Node* parse;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "ParseExampleV2")
+          .Input(test::graph::Constant(
+              g, SerializedExamples(batch, num_keys, feature_size)))
+          .Input(test::graph::Constant(
+              g, Tensor(DT_STRING, TensorShape({batch}))))
+          .Input(test::graph::Constant(g, no_keys))
+          .Input(test::graph::Constant(g, dense_keys))
+          .Input(test::graph::Constant(g, no_keys))
+          .Input(dense_defaults)
+          .Attr("num_sparse", 0)
+          .Attr("sparse_types", DataTypeVector())
+          .Attr("ragged_value_types", DataTypeVector())
+          .Attr("ragged_split_types", DataTypeVector())
+          .Attr("dense_shapes", dense_shapes)
+          .Finalize(g, &parse));
+  FixupSourceAndSinkEdges(g);
+  return g;
+}
+
+// Input pipelines: {batch, number of features, values per feature}.
+static void BM_ParseExampleV2_cpu_float(::testing::benchmark::State& state) {
+  const int batch = state.range(0);
+  const int num_keys = state.range(1);
+  const int feature_size = state.range(2);
+  test::Benchmark("cpu", ParseExample(batch, num_keys, feature_size),
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetItemsProcessed(state.iterations() * batch * num_keys *
+                          feature_size);
+}
+BENCHMARK(BM_ParseExampleV2_cpu_float)
+    ->UseRealTime()
+    ->Args({128, 10, 1})
+    ->Args({128, 100, 1})
+    ->Args({512, 20, 16});
+
+BM_SUITE_MATMUL(cpu, float, float);
+BM_SUITE_MATMUL(cpu, bfloat16, bfloat16);
+BM_SUITE_CONV2D(cpu, float, float);
+BM_SUITE_GATHER(cpu, float, int32);
+BM_SUITE_GATHER(cpu, float, int64_t);
+BM_SUITE_SPARSE_SEGMENT(cpu, SparseSegmentSum, float);
+BM_SUITE_SPARSE_SEGMENT(cpu, SparseSegmentMean, float);
+BM_SUITE_SPARSE_SEGMENT(cpu, SparseSegmentSum, bfloat16);
+BM_SUITE_SOFTMAX(cpu, float, float);
+BM_SUITE_TRANSPOSE(cpu, float, float);
+BM_SUITE_TRANSPOSE(cpu, bfloat16, bfloat16);
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+BM_SUITE_MATMUL(gpu, float, float);
+BM_SUITE_MATMUL(gpu, Eigen::half, half);
+BM_SUITE_CONV2D(gpu, float, float);
+BM_SUITE_CONV2D(gpu, Eigen::half, half);
+BM_SUITE_GATHER(gpu, float, int32);
+BM_SUITE_SPARSE_SEGMENT(gpu, SparseSegmentSum, float);
+BM_SUITE_SPARSE_SEGMENT(gpu, SparseSegmentMean, float);
+BM_SUITE_SOFTMAX(gpu, float, float);
+BM_SUITE_SOFTMAX(gpu, Eigen::half, half);
+BM_SUITE_TRANSPOSE(gpu, float, float);
+BM_SUITE_TRANSPOSE(gpu, Eigen::half, half);
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+TEST(TestLogBenchmarkReporterTest, WritesBenchmarkEntries) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "suite.");
+  setenv(TestReporter::kTestReporterEnv, prefix.c_str(), /*overwrite=*/1);
+
+  ::benchmark::BenchmarkReporter::Run run;
+  run.run_name.function_name = "BM_Test";
+  run.run_name.args = "4/8";
+  run.iterations = 10;
+  run.repetitions = 1;
+  run.real_accumulated_time = 2.0;
+  run.cpu_accumulated_time = 1.0;
+  run.counters["bytes_per_second"] = ::benchmark::Counter(2 << 20);
+  ::benchmark::BenchmarkReporter::Run failed = run;
+  failed.run_name.function_name = "BM_Failed";
+  failed.error_occurred = true;
+  test::TestLogBenchmarkReporter().ReportRuns({run, failed});
+  unsetenv(TestReporter::kTestReporterEnv);
+
+  string content;
+  TF_ASSERT_OK(
+      ReadFileToString(Env::Default(), prefix + "BM_Test__4__8", &content));
+  BenchmarkEntries entries;
+  ASSERT_TRUE(entries.ParseFromString(content));
+  ASSERT_EQ(entries.entry_size(), 1);
+  const BenchmarkEntry& entry = entries.entry(0);
+  EXPECT_EQ(entry.name(), "BM_Test/4/8");
+  EXPECT_EQ(entry.iters(), 10);
+  EXPECT_DOUBLE_EQ(entry.wall_time(), 0.2);
+  EXPECT_DOUBLE_EQ(entry.cpu_time(), 0.1);
+  EXPECT_DOUBLE_EQ(entry.throughput(), 2.0);
+  EXPECT_DOUBLE_EQ(entry.extras().at("bytes_per_second").double_value(),
+                   2 << 20);
+  EXPECT_FALSE(Env::Default()->FileExists(prefix + "BM_Failed__4__8").ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+// Runs the tests, or the benchmarks selected by --benchmark_filter while
+// reporting them in test_log.proto format.
+GTEST_API_ int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (absl::StartsWith(argv[i], "--benchmark_filter=")) {
+      ::benchmark::Initialize(&argc, argv);
+      ::testing::InitGoogleTest(&argc, argv);
+      tensorflow::test::TestLogBenchmarkReporter reporter;
+      ::benchmark::RunSpecifiedBenchmarks(&reporter);
+      return 0;
+    }
+  }
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -21,6 +21,9 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <memory>
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_split.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
@@ -39,6 +42,8 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/math/math_util.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/util/einsum_op_util.h"
@@ -59,6 +64,37 @@ using LabelCounts = gtl::InlinedVector<int, 8>;
 using OperandLabelCounts = gtl::InlinedVector<LabelCounts, 2>;
 using LabelToDimSizes = gtl::InlinedVector<int64_t, 8>;
 
+// How a single operand is brought into the [batch, free, contract] layout
+// expected by the contraction.
+struct EinsumOperandPlan {
+  // Permutation applied to the operand before striding and reducing.
+  std::vector<int> permutation;
+  // Operand labels after the permutation, with repeated labels removed.
+  Labels labels;
+  // Free labels of the operand, in the order they appear in the contraction.
+  Labels free_labels;
+  // Whether the contract dimensions precede the free dimensions, in which case
+  // BatchMatMul is asked to transpose the operand instead.
+  bool swap_free_and_contract = false;
+};
+
+// Everything about an Einsum evaluation that depends only on the equation and
+// the input shapes. Built once per distinct input shape and reused.
+struct EinsumPlan {
+  std::vector<EinsumDimensionType> label_types;
+  OperandLabelCounts input_label_counts;
+  LabelCounts output_label_counts;
+  LabelToDimSizes label_to_dim_sizes;
+  gtl::InlinedVector<EinsumOperandPlan, 2> operands;
+  // Whether the operands are contracted as (input 1, input 0), which produces
+  // the free dimensions in the order the output asks for them.
+  bool swap_operands = false;
+  // Labels of the contraction output, before inflating repeated labels.
+  Labels result_labels;
+  // Permutation from the inflated contraction output to the output.
+  std::vector<int> output_permutation;
+};
+
 struct EinsumHelper {
   // Insert new (unnamed) broadcasting labels at the location of ellipsis.
   static void InsertBroadcastLabels(int num_bcast_dims, int num_named_labels,
@@ -333,42 +369,72 @@ struct EinsumHelper {
     return true;
   }
 
-  template <typename Device, typename T>
-  static Status ReduceOperand(
-      OpKernelContext* ctx, const Tensor& input,
-      const std::vector<EinsumDimensionType>& label_types,
-      const LabelCounts& label_counts, Labels* labels, Labels* free_labels,
-      bool* swap_free_and_contract, Tensor* output) {
-    // Find the permutation to transpose the input dimensions in the order of
-    // EinsumDimensionType; i.e. batch, free, contract and reduce dimensions.
-    // This makes it more convenient to invoke Reduce/Contract operations.
-    std::vector<int> permutation(input.dims());
-    absl::c_iota(permutation, 0);
-    Tensor input_transposed;
+  // Decides how to transpose and dedupe an operand so that its dimensions are
+  // in the order of EinsumDimensionType; i.e. batch, free, contract and reduce
+  // dimensions. This makes it more convenient to invoke Reduce/Contract
+  // operations.
+  static void PlanOperand(const Labels& labels,
+                          const std::vector<EinsumDimensionType>& label_types,
+                          EinsumOperandPlan* plan) {
+    plan->permutation.resize(labels.size());
+    absl::c_iota(plan->permutation, 0);
     // Check if we can avoid the transpose. We need to flip the adj_x (or adj_y)
     // flag during BatchMatMul. This is an extra optimization not necessary for
     // correctness.
-    if (ShouldSwapFreeAndContract(*labels, label_types)) {
-      *swap_free_and_contract = true;
+    if (ShouldSwapFreeAndContract(labels, label_types)) {
+      plan->swap_free_and_contract = true;
     } else {
-      absl::c_sort(permutation, [&](int i, int j) {
-        int label_i = (*labels)[i];
-        int label_j = (*labels)[j];
+      absl::c_sort(plan->permutation, [&](int i, int j) {
+        int label_i = labels[i];
+        int label_j = labels[j];
         return std::tie(label_types[label_i], label_i) <
                std::tie(label_types[label_j], label_j);
       });
     }
+    plan->labels = labels;
+    PermuteLabels(plan->permutation, &plan->labels);
+    plan->labels.erase(std::unique(plan->labels.begin(), plan->labels.end()),
+                       plan->labels.end());
+    for (int label : plan->labels) {
+      if (label_types[label] == EinsumDimensionType::kFree) {
+        plan->free_labels.push_back(label);
+      }
+    }
+  }
+
+  template <typename Device, typename T>
+  static Status ReduceOperand(
+      OpKernelContext* ctx, const Tensor& input,
+      const std::vector<EinsumDimensionType>& label_types,
+      const LabelCounts& label_counts, Labels* labels, Labels* free_labels,
+      bool* swap_free_and_contract, Tensor* output) {
+    EinsumOperandPlan plan;
+    PlanOperand(*labels, label_types, &plan);
+    TF_RETURN_IF_ERROR(ReduceOperand<Device, T>(ctx, input, label_types,
+                                                label_counts, plan, output));
+    *labels = plan.labels;
+    free_labels->insert(free_labels->end(), plan.free_labels.begin(),
+                        plan.free_labels.end());
+    if (plan.swap_free_and_contract) *swap_free_and_contract = true;
+    return absl::OkStatus();
+  }
+
+  template <typename Device, typename T>
+  static Status ReduceOperand(
+      OpKernelContext* ctx, const Tensor& input,
+      const std::vector<EinsumDimensionType>& label_types,
+      const LabelCounts& label_counts, const EinsumOperandPlan& plan,
+      Tensor* output) {
     // Transpose the input so that EinsumDimensionTypes are in order.
-    TF_RETURN_IF_ERROR(TransposeOperand<Device, T>(ctx, input, permutation,
+    Tensor input_transposed;
+    TF_RETURN_IF_ERROR(TransposeOperand<Device, T>(ctx, input, plan.permutation,
                                                    &input_transposed));
-    PermuteLabels(permutation, labels);
 
     // Take the generalized diagonal for dimensions with repeated axis labels.
     Tensor input_deduped;
-    labels->erase(std::unique(labels->begin(), labels->end()), labels->end());
-    TF_RETURN_IF_ERROR(
-        StrideOrInflate<Device, T>(ctx, input_transposed, *labels, label_counts,
-                                   false /* should_inflate */, &input_deduped));
+    TF_RETURN_IF_ERROR(StrideOrInflate<Device, T>(
+        ctx, input_transposed, plan.labels, label_counts,
+        false /* should_inflate */, &input_deduped));
 
     // Reshape denotes the rank-5 shape [broadcast, batch, free, contract,
     // reduce] where we've compacted the dimensions of each EinsumDimensionType.
@@ -378,18 +444,16 @@ struct EinsumHelper {
     // contracting) while the free dims and contract dims are compressed to one
     // dimension each.
     TensorShape output_shape;
-    for (int label_idx = 0; label_idx < labels->size(); ++label_idx) {
-      const int label = labels->at(label_idx);
+    for (int label_idx = 0; label_idx < plan.labels.size(); ++label_idx) {
+      const int label = plan.labels[label_idx];
       int64_t dim = input_deduped.dim_size(label_idx);
       if (label_types[label] == EinsumDimensionType::kBroadcasting ||
           label_types[label] == EinsumDimensionType::kBatch) {
         TF_RETURN_IF_ERROR(output_shape.AddDimWithStatus(dim));
-      } else if (label_types[label] == EinsumDimensionType::kFree) {
-        free_labels->push_back(label);
       }
       reshape[label_types[label]] *= dim;
     }
-    if (*swap_free_and_contract)
+    if (plan.swap_free_and_contract)
       std::swap(reshape[EinsumDimensionType::kFree],
                 reshape[EinsumDimensionType::kContract]);
     TF_RETURN_IF_ERROR(
@@ -492,19 +556,8 @@ class EinsumOp : public OpKernel {
   void Compute(OpKernelContext* ctx) override {
     OpInputList inputs;
     OP_REQUIRES_OK(ctx, ctx->input_list("inputs", &inputs));
-
-    OperandLabels input_labels(input_labels_);
-    Labels output_labels(output_labels_);
-    std::vector<EinsumDimensionType> label_types(label_types_);
-    OperandLabelCounts input_label_counts(input_label_counts_);
-    LabelCounts output_label_counts(output_label_counts_);
-    LabelToDimSizes label_to_dim_sizes;
-
-    OP_REQUIRES_OK(ctx, EinsumHelper::ProcessDimensions(
-                            inputs, input_has_ellipsis_, output_has_ellipsis_,
-                            &input_labels, &output_labels, &label_types,
-                            &input_label_counts, &output_label_counts,
-                            &label_to_dim_sizes));
+    std::shared_ptr<const EinsumPlan> plan;
+    OP_REQUIRES_OK(ctx, GetPlan(inputs, &plan));
 
     // The reduction phase (a) sums across reduction dimensions, (b) takes
     // generalized diagonals, and (c) reshapes it into shape
@@ -512,15 +565,17 @@ class EinsumOp : public OpKernel {
     // where F and C denote the total (compacted) size of free and contract
     // dimensions, respectively.
     const int num_inputs = inputs.size();
-    OperandLabels free_labels(num_inputs);
     gtl::InlinedVector<Tensor, 2> inputs_reduced(num_inputs);
     gtl::InlinedVector<bool, 2> swap_free_and_contract(num_inputs);
     for (int i = 0; i < num_inputs; ++i) {
-      OP_REQUIRES_OK(ctx,
-                     EinsumHelper::ReduceOperand<Device, T>(
-                         ctx, inputs[i], label_types, input_label_counts[i],
-                         &input_labels[i], &free_labels[i],
-                         &swap_free_and_contract[i], &inputs_reduced[i]));
+      // Contracting (input 1, input 0) yields the transposed product.
+      const int operand = plan->swap_operands ? num_inputs - 1 - i : i;
+      OP_REQUIRES_OK(ctx, EinsumHelper::ReduceOperand<Device, T>(
+                              ctx, inputs[operand], plan->label_types,
+                              plan->input_label_counts[operand],
+                              plan->operands[operand], &inputs_reduced[i]));
+      swap_free_and_contract[i] =
+          plan->operands[operand].swap_free_and_contract;
     }
 
     // After reduction, the inputs should be reshaped to Tensors suitable for
@@ -535,24 +590,10 @@ class EinsumOp : public OpKernel {
     // shape, which may have been broadcasted.
     TensorShape result_shape = contraction_output_reshaped.shape();
     result_shape.RemoveLastDims(2);
-
-    int num_labels = label_types.size();
-    Labels result_labels;
-    // All batch dimensions should be present in the contracted result. First
-    // the broadcasting dimensions, then the named batch dimensions.
-    for (int label = 0; label < num_labels; ++label) {
-      if (label_types[label] == EinsumDimensionType::kBroadcasting)
-        result_labels.push_back(label);
-    }
-    for (int label = 0; label < num_labels; ++label) {
-      if (label_types[label] == EinsumDimensionType::kBatch)
-        result_labels.push_back(label);
-    }
-    for (int i = 0; i < num_inputs; ++i) {
-      for (int label : free_labels[i]) {
-        result_labels.push_back(label);
-        OP_REQUIRES_OK(
-            ctx, result_shape.AddDimWithStatus(label_to_dim_sizes[label]));
+    for (int label : plan->result_labels) {
+      if (plan->label_types[label] == EinsumDimensionType::kFree) {
+        OP_REQUIRES_OK(ctx, result_shape.AddDimWithStatus(
+                                plan->label_to_dim_sizes[label]));
       }
     }
 
@@ -570,39 +611,13 @@ class EinsumOp : public OpKernel {
     Tensor output_inflated;
     OP_REQUIRES_OK(
         ctx, EinsumHelper::StrideOrInflate<Device, T>(
-                 ctx, contraction_output, result_labels, output_label_counts,
-                 true /* should_inflate */, &output_inflated));
-    if (output_inflated.dims() > contraction_output.dims()) {
-      // We inflated the output. Modify result labels accordingly.
-      Labels inflated_labels;
-      for (int label : result_labels) {
-        inflated_labels.insert(inflated_labels.end(),
-                               output_label_counts[label], label);
-      }
-      result_labels.swap(inflated_labels);
-    }
-    // Find the permutation to map the result labels to the output labels. Note
-    // that both the result and the final output may have the repeated labels,
-    // in which case the permutation preserves the left-to-right ordering.
-    // E.g. if result labels are [0, 0, 1] and output is [0, l, 0] then the
-    // permutation should be [0, 2, 1]. We also use the fact that repeated
-    // labels in the result are adjacent to each other.
-    std::vector<int> output_permutation(output_labels.size());
-    std::vector<int> label_to_position(num_labels, -1);
-    for (int i = 0; i < result_labels.size(); ++i) {
-      // Remember the position of only the leftmost result label.
-      if (label_to_position[result_labels[i]] == -1) {
-        label_to_position[result_labels[i]] = i;
-      }
-    }
-    for (int i = 0; i < output_labels.size(); ++i) {
-      output_permutation[i] = label_to_position[output_labels[i]];
-      // We have found the leftmost occurrence. The next one would be adjacent.
-      label_to_position[output_labels[i]] += 1;
-    }
+                 ctx, contraction_output, plan->result_labels,
+                 plan->output_label_counts, true /* should_inflate */,
+                 &output_inflated));
     Tensor output;
     OP_REQUIRES_OK(ctx, EinsumHelper::TransposeOperand<Device, T>(
-                            ctx, output_inflated, output_permutation, &output));
+                            ctx, output_inflated, plan->output_permutation,
+                            &output));
     ctx->set_output(0, output);
   }
 
@@ -621,6 +636,134 @@ class EinsumOp : public OpKernel {
   }
 
  private:
+  // Plans are cached for this many distinct input shapes. Beyond that the
+  // cache is cleared, so that a kernel seeing ever-changing shapes doesn't
+  // grow without bound.
+  static constexpr int kMaxCachedPlans = 16;
+
+  // Returns the plan for the shapes of `inputs`, building it on a cache miss.
+  Status GetPlan(const OpInputList& inputs,
+                 std::shared_ptr<const EinsumPlan>* plan) {
+    ShapeVec key;
+    for (const Tensor& input : inputs) {
+      key.push_back(input.dims());
+      for (int64_t dim : input.shape().dim_sizes()) key.push_back(dim);
+    }
+    {
+      tf_shared_lock l(mu_);
+      auto it = plans_.find(key);
+      if (it != plans_.end()) {
+        *plan = it->second;
+        return absl::OkStatus();
+      }
+    }
+    auto new_plan = std::make_shared<EinsumPlan>();
+    TF_RETURN_IF_ERROR(MakePlan(inputs, new_plan.get()));
+    mutex_lock l(mu_);
+    if (plans_.size() >= kMaxCachedPlans) plans_.clear();
+    *plan = plans_.emplace(std::move(key), std::move(new_plan)).first->second;
+    return absl::OkStatus();
+  }
+
+  Status MakePlan(const OpInputList& inputs, EinsumPlan* plan) const {
+    OperandLabels input_labels(input_labels_);
+    Labels output_labels(output_labels_);
+    plan->label_types = label_types_;
+    plan->input_label_counts = input_label_counts_;
+    plan->output_label_counts = output_label_counts_;
+    TF_RETURN_IF_ERROR(EinsumHelper::ProcessDimensions(
+        inputs, input_has_ellipsis_, output_has_ellipsis_, &input_labels,
+        &output_labels, &plan->label_types, &plan->input_label_counts,
+        &plan->output_label_counts, &plan->label_to_dim_sizes));
+
+    const int num_inputs = inputs.size();
+    plan->operands.resize(num_inputs);
+    for (int i = 0; i < num_inputs; ++i) {
+      EinsumHelper::PlanOperand(input_labels[i], plan->label_types,
+                                &plan->operands[i]);
+    }
+
+    // All batch dimensions should be present in the contracted result. First
+    // the broadcasting dimensions, then the named batch dimensions, then the
+    // free dimensions of each operand.
+    const int num_labels = plan->label_types.size();
+    Labels batch_labels;
+    for (int label = 0; label < num_labels; ++label) {
+      if (plan->label_types[label] == EinsumDimensionType::kBroadcasting)
+        batch_labels.push_back(label);
+    }
+    for (int label = 0; label < num_labels; ++label) {
+      if (plan->label_types[label] == EinsumDimensionType::kBatch)
+        batch_labels.push_back(label);
+    }
+    auto result_labels = [&](bool swap_operands) {
+      Labels labels(batch_labels);
+      for (int i = 0; i < num_inputs; ++i) {
+        const int operand = swap_operands ? num_inputs - 1 - i : i;
+        const Labels& free_labels = plan->operands[operand].free_labels;
+        labels.insert(labels.end(), free_labels.begin(), free_labels.end());
+      }
+      return labels;
+    };
+    auto is_identity = [](const std::vector<int>& permutation) {
+      for (int i = 0; i < permutation.size(); ++i) {
+        if (permutation[i] != i) return false;
+      }
+      return true;
+    };
+    plan->result_labels = result_labels(/*swap_operands=*/false);
+    OutputPermutation(plan->result_labels, output_labels,
+                      plan->output_label_counts, num_labels,
+                      &plan->output_permutation);
+    // If the output lists the free dimensions of input 1 before those of
+    // input 0, contracting the operands the other way around produces the
+    // output layout directly and saves the final transpose.
+    if (num_inputs == 2 && !is_identity(plan->output_permutation)) {
+      Labels swapped_labels = result_labels(/*swap_operands=*/true);
+      std::vector<int> swapped_permutation;
+      OutputPermutation(swapped_labels, output_labels,
+                        plan->output_label_counts, num_labels,
+                        &swapped_permutation);
+      if (is_identity(swapped_permutation)) {
+        plan->swap_operands = true;
+        plan->result_labels.swap(swapped_labels);
+        plan->output_permutation.swap(swapped_permutation);
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Finds the permutation to map the result labels, once inflated, to the
+  // output labels. Note that both the result and the final output may have the
+  // repeated labels, in which case the permutation preserves the left-to-right
+  // ordering. E.g. if result labels are [0, 0, 1] and output is [0, l, 0] then
+  // the permutation should be [0, 2, 1]. We also use the fact that repeated
+  // labels in the result are adjacent to each other.
+  static void OutputPermutation(const Labels& result_labels,
+                                const Labels& output_labels,
+                                const LabelCounts& output_label_counts,
+                                int num_labels,
+                                std::vector<int>* output_permutation) {
+    Labels inflated_labels;
+    for (int label : result_labels) {
+      inflated_labels.insert(inflated_labels.end(),
+                             output_label_counts[label], label);
+    }
+    output_permutation->resize(output_labels.size());
+    std::vector<int> label_to_position(num_labels, -1);
+    for (int i = 0; i < inflated_labels.size(); ++i) {
+      // Remember the position of only the leftmost result label.
+      if (label_to_position[inflated_labels[i]] == -1) {
+        label_to_position[inflated_labels[i]] = i;
+      }
+    }
+    for (int i = 0; i < output_labels.size(); ++i) {
+      (*output_permutation)[i] = label_to_position[output_labels[i]];
+      // We have found the leftmost occurrence. The next one would be adjacent.
+      label_to_position[output_labels[i]] += 1;
+    }
+  }
+
   string equation_;
   OperandLabels input_labels_;
   Labels output_labels_;
@@ -629,6 +772,10 @@ class EinsumOp : public OpKernel {
   LabelCounts output_label_counts_;
   gtl::InlinedVector<bool, 2> input_has_ellipsis_;
   bool output_has_ellipsis_ = false;
+
+  mutex mu_;
+  absl::flat_hash_map<ShapeVec, std::shared_ptr<const EinsumPlan>> plans_
+      TF_GUARDED_BY(mu_);
 };
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
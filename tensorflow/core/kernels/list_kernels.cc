@@ -343,6 +343,7 @@ class TensorListReserve : public OpKernel {
     output.element_shape = element_shape;
     output.element_dtype = element_dtype_;
     output.tensors().resize(num_elements, Tensor(DT_INVALID));
+    output.AllowBuffer();
     Tensor* result;
     AllocatorAttributes attr;
     attr.set_on_host(true);
@@ -480,10 +481,40 @@ class TensorListSetItem : public OpKernel {
     } else if (index >= l->tensors().size()) {
       output_list->tensors().resize(index + 1, Tensor(DT_INVALID));
     }
+    if (output_list->buffer_allowed() &&
+        output_list->tensors()[index].dtype() == DT_INVALID) {
+      if (output_list->buffer() == nullptr) {
+        OP_REQUIRES_OK(c, MaybeAllocateBuffer(c, value, output_list));
+      }
+      if (output_list->SetElementInBuffer(index, value)) return;
+    }
     output_list->tensors()[index] = value;
   }
 
  private:
+  // Gives `list` a buffer for elements like `value`, if it has fixed-shape
+  // elements on the CPU that can be copied with memcpy and that keep the
+  // slots of the buffer aligned.
+  Status MaybeAllocateBuffer(OpKernelContext* c, const Tensor& value,
+                             TensorList* list) {
+    const int64_t element_bytes = value.TotalBytes();
+    if (c->device()->device_type() != DEVICE_CPU ||
+        !DataTypeCanUseMemcpy(value.dtype()) ||
+        !list->element_shape.IsFullyDefined() ||
+        !list->element_shape.IsCompatibleWith(value.shape()) ||
+        element_bytes == 0 ||
+        element_bytes % Allocator::kAllocatorAlignment != 0 ||
+        list->tensors().size() < 2) {
+      return absl::OkStatus();
+    }
+    TensorShape buffer_shape = value.shape();
+    buffer_shape.InsertDim(0, list->tensors().size());
+    Tensor buffer;
+    TF_RETURN_IF_ERROR(c->allocate_temp(value.dtype(), buffer_shape, &buffer));
+    list->set_buffer(std::move(buffer));
+    return absl::OkStatus();
+  }
+
   DataType element_dtype_;
   bool resize_if_index_out_of_bounds_;
 };
@@ -219,6 +219,14 @@ class TensorListStack : public OpKernel {
                     partial_element_shape.DebugString()));
     TensorShape output_shape = element_shape;
     output_shape.InsertDim(0, tensor_list->tensors().size());
+    // A list whose elements were all set into its buffer is already stacked.
+    Tensor stacked;
+    if (std::is_same<Device, CPUDevice>::value &&
+        tensor_list->GetStackedElements(&stacked) &&
+        stacked.shape() == output_shape) {
+      c->set_output(0, stacked);
+      return;
+    }
     Tensor* output;
     OP_REQUIRES_OK(c, c->allocate_output(0, output_shape, &output));
     if (output->NumElements() == 0) {
@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <functional>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -24,9 +26,11 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/kernels/striped_hash_map.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -36,11 +40,35 @@ std::string UniqueNodeName(const std::string& base) {
   return strings::StrCat(base, "/", counter.fetch_add(1), "/", random::New64());
 }
 
-// Lookup table that wraps an unordered_map, where the key and value data type
+namespace {
+
+// Rough cost of finding a key in a mutable table, for Shard().
+constexpr int64_t kFindCostPerKey = 200;
+
+// Calls `find(begin, end)` on ranges that cover [0, num_keys), in parallel on
+// the intra-op threads of `ctx` if it has them.
+void ShardFind(OpKernelContext* ctx, int64_t num_keys, int64_t cost_per_key,
+               const std::function<void(int64_t, int64_t)>& find) {
+  const DeviceBase::CpuWorkerThreads* worker_threads =
+      ctx == nullptr ? nullptr : ctx->device()->tensorflow_cpu_worker_threads();
+  if (worker_threads == nullptr) {
+    find(0, num_keys);
+  } else {
+    Shard(worker_threads->num_threads, worker_threads->workers, num_keys,
+          cost_per_key, find);
+  }
+}
+
+}  // namespace
+
+// Lookup table that wraps a StripedHashMap, where the key and value data type
 // is specified. Each individual value must be a scalar. If vector values are
 // required, use MutableHashTableOfTensors.
 //
 // This table is mutable and thread safe - Insert can be called at any time.
+// Its entries are split into shards with their own locks, so that Find,
+// Insert and Remove calls on different keys mostly proceed in parallel, and
+// Find calls on many keys are split across the intra-op threads.
 //
 // Sample use case:
 //
@@ -55,10 +83,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
  public:
   MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -70,19 +95,25 @@ class MutableHashTableOfScalars final : public LookupInterface {
     int64_t default_total = default_flat.size();
     bool is_full_size_default = (total == default_total);
 
-    tf_shared_lock l(mu_);
-    for (int64_t i = 0; i < key_values.size(); ++i) {
+    const auto find_value = [&](int64_t i, const V* v) {
       // is_full_size_default is true:
       //   Each key has an independent default value, key_values(i)
       //   corresponding uses default_flat(i) as its default value.
       //
       // is_full_size_default is false:
       //   All keys will share the default_flat(0) as default value.
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyIfIntegral(key_values(i)),
-          is_full_size_default ? default_flat(i) : default_flat(0));
-    }
-
+      value_values(i) =
+          v != nullptr ? *v
+                       : (is_full_size_default ? default_flat(i)
+                                               : default_flat(0));
+    };
+    ShardFind(ctx, key_values.size(), kFindCostPerKey,
+              [&](int64_t begin, int64_t end) {
+                table_.FindBatch(key_values.data() + begin, end - begin,
+                                 [&](int64_t i, const V* v) {
+                                   find_value(begin + i, v);
+                                 });
+              });
     return absl::OkStatus();
   }
 
@@ -90,13 +121,13 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat<V>();
 
-    mutex_lock l(mu_);
+    const auto assign = [&](int64_t i, V* value) {
+      *value = SubtleMustCopyIfIntegral(value_values(i));
+    };
     if (clear) {
-      table_.clear();
-    }
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          SubtleMustCopyIfIntegral(value_values(i)));
+      table_.ReplaceAll(key_values.data(), key_values.size(), assign);
+    } else {
+      table_.InsertBatch(key_values.data(), key_values.size(), assign);
     }
     return absl::OkStatus();
   }
@@ -109,10 +140,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.EraseBatch(key_values.data(), key_values.size());
     return absl::OkStatus();
   }
 
@@ -122,17 +150,12 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64_t size = table_.size();
-
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("values", TensorShape({size}), &values));
-    ExportKeysAndValues(keys, values);
-    return absl::OkStatus();
+    return ExportKeysAndValues(
+        [ctx](int64_t size, Tensor** keys, Tensor** values) {
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), keys));
+          return ctx->allocate_output("values", TensorShape({size}), values);
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -144,25 +167,20 @@ class MutableHashTableOfScalars final : public LookupInterface {
   TensorShape value_shape() const override { return TensorShape(); }
 
   int64_t MemoryUsed() const override {
-    int64_t ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfScalars) + ret;
+    return sizeof(MutableHashTableOfScalars) + table_.MemoryUsed();
   }
 
   Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
-    tf_shared_lock l(mu_);
-    int64_t size = table_.size();
-    Tensor keys(key_dtype(), TensorShape({size}));
-    Tensor values(value_dtype(), TensorShape({size}));
-    ExportKeysAndValues(&keys, &values);
+    Tensor keys;
+    Tensor values;
+    TF_RETURN_IF_ERROR(ExportKeysAndValues(
+        [&](int64_t size, Tensor** keys_out, Tensor** values_out) {
+          keys = Tensor(key_dtype(), TensorShape({size}));
+          values = Tensor(value_dtype(), TensorShape({size}));
+          *keys_out = &keys;
+          *values_out = &values;
+          return absl::OkStatus();
+        }));
 
     // We set use_node_name_sharing with a unique node name so that the resource
     // can outlive the MutableHashTableV2 kernel. This means that the lifetime
@@ -195,24 +213,34 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
  private:
-  // Writes all keys and values into `keys` and `values`. `keys` and `values`
-  // must point to tensors of size `table_.size()`.
-  void ExportKeysAndValues(Tensor* keys, Tensor* values) const
-      TF_SHARED_LOCKS_REQUIRED(mu_) {
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->flat<V>();
+  // Writes a consistent snapshot of all keys and values into the tensors that
+  // `allocate(size, &keys, &values)` returns for `size` entries.
+  Status ExportKeysAndValues(
+      const std::function<Status(int64_t, Tensor**, Tensor**)>& allocate)
+      const {
+    K* keys_data = nullptr;
+    V* values_data = nullptr;
     int64_t i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
-    }
+    return table_.Snapshot(
+        [&](int64_t size) {
+          Tensor* keys;
+          Tensor* values;
+          TF_RETURN_IF_ERROR(allocate(size, &keys, &values));
+          keys_data = keys->flat<K>().data();
+          values_data = values->flat<V>().data();
+          return absl::OkStatus();
+        },
+        [&](const K& key, const V& value) {
+          keys_data[i] = key;
+          values_data[i] = value;
+          ++i;
+        });
   }
 
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ TF_GUARDED_BY(mu_);
+  StripedHashMap<K, V> table_;
 };
 
-// Lookup table that wraps an unordered_map. Behaves identical to
+// Lookup table that wraps a StripedHashMap. Behaves identical to
 // MutableHashTableOfScalars except that each value must be a vector.
 template <class K, class V>
 class MutableHashTableOfTensors final : public LookupInterface {
@@ -226,10 +254,7 @@ class MutableHashTableOfTensors final : public LookupInterface {
                                 value_shape_.DebugString()));
   }
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -242,10 +267,7 @@ class MutableHashTableOfTensors final : public LookupInterface {
     int64_t default_total = default_flat.size();
     bool is_full_size_default = (total == default_total);
 
-    tf_shared_lock l(mu_);
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      ValueArray* value_vec =
-          gtl::FindOrNull(table_, SubtleMustCopyIfIntegral(key_values(i)));
+    const auto find_values = [&](int64_t i, const ValueArray* value_vec) {
       if (value_vec != nullptr) {
         for (int64_t j = 0; j < value_dim; j++) {
           value_values(i, j) = value_vec->at(j);
@@ -262,8 +284,14 @@ class MutableHashTableOfTensors final : public LookupInterface {
               is_full_size_default ? default_flat(i, j) : default_flat(0, j);
         }
       }
-    }
-
+    };
+    ShardFind(ctx, key_values.size(), kFindCostPerKey + value_dim,
+              [&](int64_t begin, int64_t end) {
+                table_.FindBatch(key_values.data() + begin, end - begin,
+                                 [&](int64_t i, const ValueArray* value_vec) {
+                                   find_values(begin + i, value_vec);
+                                 });
+              });
     return absl::OkStatus();
   }
 
@@ -272,18 +300,17 @@ class MutableHashTableOfTensors final : public LookupInterface {
     const auto value_values = values.flat_inner_dims<V, 2>();
     int64_t value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
-    if (clear) {
-      table_.clear();
-    }
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      ValueArray value_vec;
+    const auto assign = [&](int64_t i, ValueArray* value_vec) {
+      value_vec->clear();
       for (int64_t j = 0; j < value_dim; j++) {
         V value = value_values(i, j);
-        value_vec.push_back(value);
+        value_vec->push_back(value);
       }
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          value_vec);
+    };
+    if (clear) {
+      table_.ReplaceAll(key_values.data(), key_values.size(), assign);
+    } else {
+      table_.InsertBatch(key_values.data(), key_values.size(), assign);
     }
     return absl::OkStatus();
   }
@@ -296,10 +323,7 @@ class MutableHashTableOfTensors final : public LookupInterface {
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.EraseBatch(key_values.data(), key_values.size());
     return absl::OkStatus();
   }
 
@@ -309,18 +333,14 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64_t size = table_.size();
     int64_t value_dim = value_shape_.dim_size(0);
-
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(ctx->allocate_output(
-        "values", TensorShape({size, value_dim}), &values));
-    ExportKeysAndValues(keys, values);
-    return absl::OkStatus();
+    return ExportKeysAndValues(
+        [ctx, value_dim](int64_t size, Tensor** keys, Tensor** values) {
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), keys));
+          return ctx->allocate_output("values",
+                                      TensorShape({size, value_dim}), values);
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -332,25 +352,21 @@ class MutableHashTableOfTensors final : public LookupInterface {
   TensorShape value_shape() const override { return value_shape_; }
 
   int64_t MemoryUsed() const override {
-    int64_t ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfTensors) + ret;
+    return sizeof(MutableHashTableOfTensors) + table_.MemoryUsed();
   }
 
   Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
-    tf_shared_lock l(mu_);
-    int64_t size = table_.size();
-    Tensor keys(key_dtype(), TensorShape({size}));
-    Tensor values(value_dtype(), TensorShape({size, value_shape_.dim_size(0)}));
-    ExportKeysAndValues(&keys, &values);
+    Tensor keys;
+    Tensor values;
+    TF_RETURN_IF_ERROR(ExportKeysAndValues(
+        [&](int64_t size, Tensor** keys_out, Tensor** values_out) {
+          keys = Tensor(key_dtype(), TensorShape({size}));
+          values = Tensor(value_dtype(),
+                          TensorShape({size, value_shape_.dim_size(0)}));
+          *keys_out = &keys;
+          *values_out = &values;
+          return absl::OkStatus();
+        }));
 
     // We set use_node_name_sharing with a unique node name so that the resource
     // can outlive the MutableHashTableOfTensorsV2 kernel. This means that the
@@ -384,28 +400,35 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
  private:
-  // Writes all keys and values into `keys` and `values`. `keys` and `values`
-  // must point to tensors of size `table_.size()`.
-  void ExportKeysAndValues(Tensor* keys, Tensor* values) const
-      TF_SHARED_LOCKS_REQUIRED(mu_) {
+  typedef gtl::InlinedVector<V, 4> ValueArray;
+
+  // Writes a consistent snapshot of all keys and values into the tensors that
+  // `allocate(size, &keys, &values)` returns for `size` entries.
+  Status ExportKeysAndValues(
+      const std::function<Status(int64_t, Tensor**, Tensor**)>& allocate)
+      const {
     int64_t value_dim = value_shape_.dim_size(0);
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->matrix<V>();
+    K* keys_data = nullptr;
+    V* values_data = nullptr;
     int64_t i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      K key = it->first;
-      ValueArray value = it->second;
-      keys_data(i) = key;
-      for (int64_t j = 0; j < value_dim; j++) {
-        values_data(i, j) = value[j];
-      }
-    }
+    return table_.Snapshot(
+        [&](int64_t size) {
+          Tensor* keys;
+          Tensor* values;
+          TF_RETURN_IF_ERROR(allocate(size, &keys, &values));
+          keys_data = keys->flat<K>().data();
+          values_data = values->flat<V>().data();
+          return absl::OkStatus();
+        },
+        [&](const K& key, const ValueArray& value) {
+          keys_data[i] = key;
+          std::copy(value.begin(), value.end(), values_data + i * value_dim);
+          ++i;
+        });
   }
 
   TensorShape value_shape_;
-  mutable mutex mu_;
-  typedef gtl::InlinedVector<V, 4> ValueArray;
-  std::unordered_map<K, ValueArray> table_ TF_GUARDED_BY(mu_);
+  StripedHashMap<K, ValueArray> table_;
 };
 
 namespace {
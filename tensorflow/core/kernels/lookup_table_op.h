@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/kernels/immutable_hash_table.h"
 #include "tensorflow/core/kernels/lookup_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -234,7 +236,7 @@ class HashTable : public InitializableLookupTable {
                            .WithAttr("key_dtype", key_dtype())
                            .WithAttr("value_dtype", value_dtype())
                            .WithAttr("use_node_name_sharing", true));
-    if (table_.empty()) {
+    if (size() == 0) {
       *out = hash_table_node;
       return absl::OkStatus();
     }
@@ -258,7 +260,7 @@ class HashTable : public InitializableLookupTable {
     if (!is_initialized())
       return 0;
     else
-      return table_.size();
+      return immutable_table_.size();
   }
 
   Status ExportValues(OpKernelContext* context) override {
@@ -266,7 +268,7 @@ class HashTable : public InitializableLookupTable {
       return errors::Aborted("HashTable is not initialized.");
     }
 
-    const int64_t size = table_.size();
+    const int64_t size = immutable_table_.size();
 
     Tensor* keys;
     Tensor* values;
@@ -277,10 +279,9 @@ class HashTable : public InitializableLookupTable {
 
     auto keys_data = keys->flat<K>();
     auto values_data = values->flat<V>();
-    int64_t i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
+    for (int64_t i = 0; i < size; ++i) {
+      keys_data(i) = immutable_table_.keys()[i];
+      values_data(i) = immutable_table_.values()[i];
     }
     return absl::OkStatus();
   }
@@ -320,15 +321,49 @@ class HashTable : public InitializableLookupTable {
     return absl::OkStatus();
   }
 
+  Status DoFinalize() override {
+    // The map is only needed to detect conflicting keys while inserting, so
+    // its entries are moved to the immutable table that serves lookups.
+    std::vector<K> keys;
+    std::vector<V> values;
+    keys.reserve(table_.size());
+    values.reserve(table_.size());
+    while (!table_.empty()) {
+      auto entry = table_.extract(table_.begin());
+      keys.push_back(std::move(entry.key()));
+      values.push_back(std::move(entry.mapped()));
+    }
+    absl::flat_hash_map<K, V>().swap(table_);
+    immutable_table_ =
+        ImmutableHashTable<K, V>(std::move(keys), std::move(values));
+    return absl::OkStatus();
+  }
+
   Status DoFind(const Tensor& key, Tensor* value,
                 const Tensor& default_value) override {
+    return DoFind(/*ctx=*/nullptr, key, value, default_value);
+  }
+
+  Status DoFind(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+                const Tensor& default_value) override {
     const V default_val = default_value.flat<V>()(0);
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyIfIntegral(key_values(i)), default_val);
+    const auto find = [&](int64_t begin, int64_t end) {
+      immutable_table_.FindBatch(
+          key_values.data() + begin, end - begin, [&](int64_t i, const V* v) {
+            value_values(begin + i) = v == nullptr ? default_val : *v;
+          });
+    };
+    const DeviceBase::CpuWorkerThreads* worker_threads =
+        ctx == nullptr ? nullptr
+                       : ctx->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads == nullptr) {
+      find(0, key_values.size());
+    } else {
+      Shard(worker_threads->num_threads, worker_threads->workers,
+            key_values.size(), kFindCostPerKey, find);
     }
     return absl::OkStatus();
   }
@@ -337,12 +372,17 @@ class HashTable : public InitializableLookupTable {
     if (!is_initialized()) {
       return 0;
     }
-    const int64_t num_elements = table_.size();
-    return num_elements * (sizeof(K) + sizeof(V));
+    return immutable_table_.MemoryUsed();
   }
 
  private:
+  // Rough cost of a lookup for Shard(), dominated by cache misses.
+  static constexpr int64_t kFindCostPerKey = 200;
+
+  // The entries inserted so far, until the table is initialized.
   absl::flat_hash_map<K, V> table_;
+  // The entries, once the table is initialized.
+  ImmutableHashTable<K, V> immutable_table_;
 };
 
 }  // namespace lookup
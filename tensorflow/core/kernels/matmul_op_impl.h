@@ -23,6 +23,7 @@ limitations under the License.
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -37,11 +38,15 @@ limitations under the License.
 #include "tensorflow/core/framework/type_traits.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/matmul_op_packed_rhs.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/bfloat16.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/matmul_autotune.h"
 #include "tensorflow/core/util/matmul_bcast.h"
 #include "tensorflow/core/util/work_sharder.h"
@@ -908,6 +913,18 @@ class BaseBatchMatMulOp : public OpKernel {
       OP_REQUIRES_OK(context, context->GetAttr("grad_x", &grad_input_1_));
       OP_REQUIRES_OK(context, context->GetAttr("grad_y", &grad_input_2_));
     }
+    // Grappler's remapper sets "_rhs_is_constant" on CPU nodes whose
+    // right-hand side does not change between steps.
+    if (context->HasAttr("_rhs_is_constant")) {
+      OP_REQUIRES_OK(context,
+                     context->GetAttr("_rhs_is_constant", &rhs_is_constant_));
+    }
+    if (rhs_is_constant_) {
+      OP_REQUIRES_OK(context,
+                     ReadBoolFromEnvVar("TF_MATMUL_PACK_CONSTANT_RHS",
+                                        /*default_val=*/true,
+                                        &rhs_is_constant_));
+    }
   }
 
   ~BaseBatchMatMulOp() override {}
@@ -979,6 +996,18 @@ class BaseBatchMatMulOp : public OpKernel {
                     in1_reshaped.data() != nullptr &&
                     out_reshaped.data() != nullptr,
                 absl::InternalError("Null data pointer encountered."));
+    if constexpr (std::is_same_v<Device, CPUDevice> && std::is_same_v<Ta, Tb> &&
+                  std::is_same_v<Ta, Tout> &&
+                  (std::is_same_v<Ta, float> || std::is_same_v<Ta, bfloat16> ||
+                   std::is_same_v<Ta, Eigen::half>)) {
+      // A product of a batch of rows with a matrix that does not change
+      // between steps can reuse the matrix packed by an earlier step.
+      if (rhs_is_constant_ && bcast.y_batch_size() == 1 &&
+          batch_size * d0 > 1) {
+        LaunchWithPackedRhs(ctx, in0_reshaped, in1_reshaped, &out_reshaped);
+        return;
+      }
+    }
     if constexpr (std::is_same_v<Device, CPUDevice> && std::is_same_v<Ta, Tb> &&
                   (std::is_same_v<Ta, bfloat16> ||
                    std::is_same_v<Ta, Eigen::half>)) {
@@ -1031,6 +1060,98 @@ class BaseBatchMatMulOp : public OpKernel {
   bool trans_y_ = false;
   bool grad_input_1_ = false;
   bool grad_input_2_ = false;
+  bool rhs_is_constant_ = false;
+
+  // The right-hand side packed by `GetPackedRhs()`, and the buffer and shape
+  // it was packed from. The remapper only marks right-hand sides whose buffer
+  // keeps its values for as long as it is fed to the kernel (constants, and
+  // opt-in read-only variables), so a later input with the same buffer and
+  // shape holds the same values. No reference to the buffer is kept: it would
+  // make every update of a variable sharing it copy the whole variable.
+  mutex packed_rhs_mu_;
+  const void* packed_rhs_data_ TF_GUARDED_BY(packed_rhs_mu_) = nullptr;
+  TensorShape packed_rhs_shape_ TF_GUARDED_BY(packed_rhs_mu_);
+  std::shared_ptr<const PackedMatMulRhs> packed_rhs_
+      TF_GUARDED_BY(packed_rhs_mu_);
+
+  // Returns `rhs` packed as a k x n matrix, reusing the packing of an earlier
+  // call with the same input.
+  Status GetPackedRhs(OpKernelContext* ctx, const Tensor& rhs, int64_t k,
+                      int64_t n, bool transpose,
+                      std::shared_ptr<const PackedMatMulRhs>* packed) {
+    mutex_lock l(packed_rhs_mu_);
+    if (packed_rhs_ == nullptr || packed_rhs_data_ != rhs.data() ||
+        !packed_rhs_shape_.IsSameSize(rhs.shape())) {
+      packed_rhs_.reset();
+      if constexpr (std::is_same_v<Tb, float>) {
+        packed_rhs_ = std::make_shared<const PackedMatMulRhs>(
+            rhs.flat<float>().data(), k, n, transpose);
+      } else {
+        Tensor rhs_float;
+        TF_RETURN_IF_ERROR(
+            ctx->allocate_temp(DT_FLOAT, rhs.shape(), &rhs_float));
+        FastConvertToFloat(rhs.flat<Tb>().data(),
+                           rhs_float.flat<float>().data(), rhs.NumElements());
+        packed_rhs_ = std::make_shared<const PackedMatMulRhs>(
+            rhs_float.flat<float>().data(), k, n, transpose);
+      }
+      packed_rhs_data_ = rhs.data();
+      packed_rhs_shape_ = rhs.shape();
+      VLOG(2) << "Packed the right-hand side of " << name() << ": "
+              << rhs.shape().DebugString() << ", " << packed_rhs_->bytes()
+              << " bytes";
+    }
+    *packed = packed_rhs_;
+    return absl::OkStatus();
+  }
+
+  // Computes `out` = `in0` * `in1`, where `in1` is a single matrix packed by
+  // `GetPackedRhs()`.
+  void LaunchWithPackedRhs(OpKernelContext* ctx, const Tensor& in0,
+                           const Tensor& in1, Tensor* out) {
+    const bool transpose_x = adj_x_ || trans_x_;
+    const bool transpose_y = adj_y_ || trans_y_;
+    const int64_t batch_size = out->dim_size(0);
+    const int64_t m = out->dim_size(1);
+    const int64_t n = out->dim_size(2);
+    const int64_t k = transpose_x ? in0.dim_size(1) : in0.dim_size(2);
+    std::shared_ptr<const PackedMatMulRhs> packed;
+    OP_REQUIRES_OK(ctx, GetPackedRhs(ctx, in1, k, n, transpose_y, &packed));
+
+    const float* lhs;
+    float* product;
+    Tensor in0_float, out_float;
+    if constexpr (std::is_same_v<Ta, float>) {
+      lhs = in0.flat<float>().data();
+      product = out->flat<float>().data();
+    } else {
+      OP_REQUIRES_OK(ctx,
+                     ctx->allocate_temp(DT_FLOAT, in0.shape(), &in0_float));
+      OP_REQUIRES_OK(ctx,
+                     ctx->allocate_temp(DT_FLOAT, out->shape(), &out_float));
+      FastConvertToFloat(in0.flat<Ta>().data(), in0_float.flat<float>().data(),
+                         in0.NumElements());
+      lhs = in0_float.flat<float>().data();
+      product = out_float.flat<float>().data();
+    }
+
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+    if (transpose_x) {
+      for (int64_t i = 0; i < batch_size; ++i) {
+        packed->Multiply(device, lhs + i * k * m, m, /*transpose_lhs=*/true,
+                         product + i * m * n);
+      }
+    } else {
+      // The batches of rows are contiguous, so they form one m x k matrix.
+      packed->Multiply(device, lhs, batch_size * m, /*transpose_lhs=*/false,
+                       product);
+    }
+
+    if constexpr (!std::is_same_v<Ta, float>) {
+      FastConvertFromFloat<Tout>(product, out->flat<Tout>().data(),
+                                 out->NumElements());
+    }
+  }
 
   // Cast `t` from `SrcT` to `DstT`.
   template <typename SrcT, typename DstT>
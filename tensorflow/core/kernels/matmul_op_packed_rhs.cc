@@ -0,0 +1,191 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/matmul_op_packed_rhs.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Eigen/Core"  // from @eigen_archive
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tensorflow {
+namespace {
+
+// Eigen's GEMM computes column-major products. The row-major product
+// `out = lhs * rhs` is the column-major product `out' = rhs' * lhs'`, so the
+// right-hand side of the op is the left-hand side of the GEMM, and is packed
+// into the blocks that Eigen's micro-kernel expects for that operand.
+using Index = Eigen::Index;
+using Traits = Eigen::internal::gebp_traits<float, float>;
+using ColMajorMapper =
+    Eigen::internal::const_blas_data_mapper<float, Index, Eigen::ColMajor>;
+using RowMajorMapper =
+    Eigen::internal::const_blas_data_mapper<float, Index, Eigen::RowMajor>;
+using OutMapper = Eigen::internal::blas_data_mapper<float, Index,
+                                                    Eigen::ColMajor>;
+template <typename Mapper, int StorageOrder>
+using PackGemmLhs =
+    Eigen::internal::gemm_pack_lhs<float, Index, Mapper, Traits::mr,
+                                   Traits::LhsProgress,
+                                   typename Traits::LhsPacket4Packing,
+                                   StorageOrder>;
+template <typename Mapper, int StorageOrder>
+using PackGemmRhs =
+    Eigen::internal::gemm_pack_rhs<float, Index, Mapper, Traits::nr,
+                                   StorageOrder>;
+using GebpKernel = Eigen::internal::gebp_kernel<float, float, Index, OutMapper,
+                                                Traits::mr, Traits::nr, false,
+                                                false>;
+
+// Block sizes. A (kKc x kNc) block of the packed right-hand side stays in L2
+// while it is multiplied with a (kKc x kMc) block of the packed left-hand side,
+// which stays in L1.
+constexpr int64_t kKc = 256;
+constexpr int64_t kNc = Traits::mr * (192 / Traits::mr);
+constexpr int64_t kMc = Traits::nr * (128 / Traits::nr);
+
+// Packed blocks start on a boundary suitable for aligned packet loads.
+constexpr int64_t kBlockAlignment = EIGEN_MAX_ALIGN_BYTES / sizeof(float) > 0
+                                        ? EIGEN_MAX_ALIGN_BYTES / sizeof(float)
+                                        : 1;
+
+int64_t AlignBlock(int64_t size) {
+  return (size + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+}
+
+int64_t CeilDiv(int64_t a, int64_t b) { return (a + b - 1) / b; }
+
+}  // namespace
+
+PackedMatMulRhs::PackedMatMulRhs(const float* rhs, int64_t k, int64_t n,
+                                 bool transpose)
+    : k_(k),
+      n_(n),
+      kc_(std::min(k, kKc)),
+      nc_(std::min(n, kNc)),
+      num_k_blocks_(CeilDiv(k, kc_)),
+      num_n_blocks_(CeilDiv(n, nc_)) {
+  block_offsets_.reserve(num_k_blocks_ * num_n_blocks_);
+  int64_t size = 0;
+  for (int64_t kb = 0; kb < num_k_blocks_; ++kb) {
+    const int64_t depth = std::min(kc_, k_ - kb * kc_);
+    for (int64_t nb = 0; nb < num_n_blocks_; ++nb) {
+      const int64_t cols = std::min(nc_, n_ - nb * nc_);
+      block_offsets_.push_back(size);
+      size += AlignBlock(depth * cols);
+    }
+  }
+  packed_.resize(size);
+
+  // The GEMM left-hand side is rhs', which is n x k column-major when `rhs` is
+  // k x n row-major, and n x k row-major when `rhs` is stored transposed.
+  const ColMajorMapper col_major(rhs, n_);
+  const RowMajorMapper row_major(rhs, k_);
+  for (int64_t kb = 0; kb < num_k_blocks_; ++kb) {
+    const int64_t k0 = kb * kc_;
+    const int64_t depth = std::min(kc_, k_ - k0);
+    for (int64_t nb = 0; nb < num_n_blocks_; ++nb) {
+      const int64_t n0 = nb * nc_;
+      const int64_t cols = std::min(nc_, n_ - n0);
+      float* block = packed_.data() + BlockOffset(kb, nb);
+      if (transpose) {
+        PackGemmLhs<RowMajorMapper, Eigen::RowMajor>()(
+            block, row_major.getSubMapper(n0, k0), depth, cols);
+      } else {
+        PackGemmLhs<ColMajorMapper, Eigen::ColMajor>()(
+            block, col_major.getSubMapper(n0, k0), depth, cols);
+      }
+    }
+  }
+}
+
+void PackedMatMulRhs::Multiply(const Eigen::ThreadPoolDevice& device,
+                               const float* lhs, int64_t m, bool transpose_lhs,
+                               float* out) const {
+  const int64_t mc = std::min(m, kMc);
+  const int64_t num_m_blocks = CeilDiv(m, mc);
+
+  // Pack all of the GEMM right-hand side lhs' up front. It is k x m
+  // column-major when `lhs` is m x k row-major, and k x m row-major when `lhs`
+  // is stored transposed.
+  std::vector<int64_t> lhs_offsets;
+  lhs_offsets.reserve(num_k_blocks_ * num_m_blocks);
+  int64_t size = 0;
+  for (int64_t kb = 0; kb < num_k_blocks_; ++kb) {
+    const int64_t depth = std::min(kc_, k_ - kb * kc_);
+    for (int64_t mb = 0; mb < num_m_blocks; ++mb) {
+      lhs_offsets.push_back(size);
+      size += AlignBlock(depth * std::min(mc, m - mb * mc));
+    }
+  }
+  std::vector<float, Eigen::aligned_allocator<float>> packed_lhs(size);
+  const ColMajorMapper col_major(lhs, k_);
+  const RowMajorMapper row_major(lhs, m);
+  const Eigen::TensorOpCost pack_cost(kc_ * mc * sizeof(float),
+                                      kc_ * mc * sizeof(float), kc_ * mc);
+  device.parallelFor(
+      num_k_blocks_ * num_m_blocks, pack_cost,
+      [&](Index first, Index last) {
+        for (Index i = first; i < last; ++i) {
+          const int64_t k0 = (i / num_m_blocks) * kc_;
+          const int64_t m0 = (i % num_m_blocks) * mc;
+          const int64_t depth = std::min(kc_, k_ - k0);
+          const int64_t cols = std::min(mc, m - m0);
+          float* block = packed_lhs.data() + lhs_offsets[i];
+          if (transpose_lhs) {
+            PackGemmRhs<RowMajorMapper, Eigen::RowMajor>()(
+                block, row_major.getSubMapper(k0, m0), depth, cols);
+          } else {
+            PackGemmRhs<ColMajorMapper, Eigen::ColMajor>()(
+                block, col_major.getSubMapper(k0, m0), depth, cols);
+          }
+        }
+      });
+
+  // Each task computes one (nc x mc) tile of out' over the full depth, so the
+  // tasks write disjoint parts of `out`.
+  const OutMapper out_mapper(out, n_);
+  const Eigen::TensorOpCost tile_cost(
+      k_ * (nc_ + mc) * sizeof(float), nc_ * mc * sizeof(float),
+      2 * k_ * nc_ * mc);
+  device.parallelFor(
+      num_n_blocks_ * num_m_blocks, tile_cost, [&](Index first, Index last) {
+        GebpKernel gebp;
+        for (Index i = first; i < last; ++i) {
+          const int64_t nb = i / num_m_blocks;
+          const int64_t mb = i % num_m_blocks;
+          const int64_t n0 = nb * nc_;
+          const int64_t m0 = mb * mc;
+          const int64_t rows = std::min(nc_, n_ - n0);
+          const int64_t cols = std::min(mc, m - m0);
+          for (int64_t row = 0; row < cols; ++row) {
+            std::memset(out + (m0 + row) * n_ + n0, 0, rows * sizeof(float));
+          }
+          const OutMapper tile = out_mapper.getSubMapper(n0, m0);
+          for (int64_t kb = 0; kb < num_k_blocks_; ++kb) {
+            const int64_t depth = std::min(kc_, k_ - kb * kc_);
+            gebp(tile, packed_.data() + BlockOffset(kb, nb),
+                 packed_lhs.data() + lhs_offsets[kb * num_m_blocks + mb], rows,
+                 depth, cols, 1.0f);
+          }
+        }
+      });
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,77 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_MATMUL_OP_PACKED_RHS_H_
+#define TENSORFLOW_CORE_KERNELS_MATMUL_OP_PACKED_RHS_H_
+
+#define EIGEN_USE_THREADS
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tensorflow {
+
+// The right-hand side of a float matrix product, packed once into the panel
+// layout consumed by Eigen's GEMM micro-kernel.
+//
+// Every Eigen contraction packs both of its operands before running the
+// micro-kernel. When the right-hand side is a constant weight matrix and the
+// left-hand side is a small batch of activations, packing the weights is a
+// large part of the cost of each product. A `PackedMatMulRhs` pays for it once
+// and then only packs the left-hand side of each product.
+//
+// Instances are immutable after construction and may be shared by concurrent
+// calls to `Multiply()`.
+class PackedMatMulRhs {
+ public:
+  // Packs the k x n matrix `rhs`, stored row-major, or its transpose if
+  // `transpose`, in which case `rhs` is stored row-major as n x k.
+  PackedMatMulRhs(const float* rhs, int64_t k, int64_t n, bool transpose);
+
+  int64_t k() const { return k_; }
+  int64_t n() const { return n_; }
+
+  // Returns the number of bytes held by the packed matrix.
+  size_t bytes() const { return packed_.size() * sizeof(float); }
+
+  // Computes `out = lhs * rhs`, where `out` is m x n row-major and `lhs` is
+  // m x k row-major, or its transpose if `transpose_lhs`, in which case `lhs`
+  // is stored row-major as k x m. The product is sharded over `device`.
+  void Multiply(const Eigen::ThreadPoolDevice& device, const float* lhs,
+                int64_t m, bool transpose_lhs, float* out) const;
+
+ private:
+  // Returns the offset in `packed_` of the block holding rows
+  // [kb * kc_, (kb + 1) * kc_) and columns [nb * nc_, (nb + 1) * nc_).
+  int64_t BlockOffset(int64_t kb, int64_t nb) const {
+    return block_offsets_[kb * num_n_blocks_ + nb];
+  }
+
+  int64_t k_;
+  int64_t n_;
+  // Block sizes along the depth and columns of the right-hand side.
+  int64_t kc_;
+  int64_t nc_;
+  int64_t num_k_blocks_;
+  int64_t num_n_blocks_;
+  std::vector<int64_t> block_offsets_;
+  std::vector<float, Eigen::aligned_allocator<float>> packed_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_MATMUL_OP_PACKED_RHS_H_
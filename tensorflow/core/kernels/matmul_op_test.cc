@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include <functional>
+#include <memory>
 #include <string>
 
 #include "absl/algorithm/container.h"
@@ -21,7 +22,10 @@ limitations under the License.
 #include "tensorflow/cc/ops/nn_ops_internal.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/ops_util.h"
+#include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
@@ -420,6 +424,156 @@ using FusedBiasAddDataTypes = ::testing::Types<float, Eigen::half>;
 INSTANTIATE_TYPED_TEST_SUITE_P(Test, FusedMatMulWithBiasOpTest,
                                FusedBiasAddDataTypes);
 
+// Tests products with a right-hand side marked as constant by Grappler, which
+// the CPU kernels pack once and reuse.
+class MatMulWithConstantRhsTest : public OpsTestBase {
+ protected:
+  static Tensor Random(const TensorShape& shape) {
+    Tensor t(DT_FLOAT, shape);
+    t.flat<float>().setRandom();
+    return t;
+  }
+
+  // Returns the product of the matrix or batch of matrices `lhs` with the
+  // matrix `rhs`, computed without the kernel.
+  static Tensor Reference(const Tensor& lhs, const Tensor& rhs,
+                          bool transpose_lhs, bool transpose_rhs) {
+    const int64_t batch = lhs.dims() == 3 ? lhs.dim_size(0) : 1;
+    const int64_t rows = lhs.dim_size(lhs.dims() - 2);
+    const int64_t cols = lhs.dim_size(lhs.dims() - 1);
+    const int64_t m = transpose_lhs ? cols : rows;
+    const int64_t k = transpose_lhs ? rows : cols;
+    const int64_t n = rhs.dim_size(transpose_rhs ? 0 : 1);
+    Tensor out(DT_FLOAT, lhs.dims() == 3 ? TensorShape({batch, m, n})
+                                         : TensorShape({m, n}));
+    auto a = lhs.shaped<float, 3>({batch, rows, cols});
+    auto b = rhs.matrix<float>();
+    auto c = out.shaped<float, 3>({batch, m, n});
+    for (int64_t s = 0; s < batch; ++s) {
+      for (int64_t i = 0; i < m; ++i) {
+        for (int64_t j = 0; j < n; ++j) {
+          double sum = 0;
+          for (int64_t p = 0; p < k; ++p) {
+            sum += (transpose_lhs ? a(s, p, i) : a(s, i, p)) *
+                   (transpose_rhs ? b(j, p) : b(p, j));
+          }
+          c(s, i, j) = sum;
+        }
+      }
+    }
+    return out;
+  }
+
+  void AddTensorInput(const Tensor& t) {
+    AddInputFromArray<float>(
+        t.shape(), absl::Span<const float>(t.flat<float>().data(),
+                                           t.NumElements()));
+  }
+};
+
+TEST_F(MatMulWithConstantRhsTest, MatMul) {
+  // Spans several blocks of the packed right-hand side in depth and columns.
+  const int64_t m = 37, k = 300, n = 200;
+  for (bool transpose_a : {false, true}) {
+    for (bool transpose_b : {false, true}) {
+      TF_ASSERT_OK(NodeDefBuilder("matmul", "MatMul")
+                       .Input(FakeInput(DT_FLOAT))
+                       .Input(FakeInput(DT_FLOAT))
+                       .Attr("transpose_a", transpose_a)
+                       .Attr("transpose_b", transpose_b)
+                       .Attr("_rhs_is_constant", true)
+                       .Finalize(node_def()));
+      TF_ASSERT_OK(InitOp());
+      const Tensor lhs =
+          Random(transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+      const Tensor rhs =
+          Random(transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+      inputs_.clear();
+      AddTensorInput(lhs);
+      AddTensorInput(rhs);
+      // The second run reuses the right-hand side packed by the first.
+      for (int run = 0; run < 2; ++run) {
+        TF_ASSERT_OK(RunOpKernel());
+        test::ExpectTensorNear<float>(
+            *GetOutput(0), Reference(lhs, rhs, transpose_a, transpose_b),
+            1e-3);
+      }
+      // A different right-hand side is packed again.
+      const Tensor other_rhs = Random(rhs.shape());
+      inputs_.pop_back();
+      AddTensorInput(other_rhs);
+      TF_ASSERT_OK(RunOpKernel());
+      test::ExpectTensorNear<float>(
+          *GetOutput(0), Reference(lhs, other_rhs, transpose_a, transpose_b),
+          1e-3);
+    }
+  }
+}
+
+TEST_F(MatMulWithConstantRhsTest, BatchMatMulWithBroadcastRhs) {
+  const int64_t batch = 3, m = 5, k = 40, n = 30;
+  for (bool adj_x : {false, true}) {
+    TF_ASSERT_OK(NodeDefBuilder("batch_matmul", "BatchMatMulV2")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("adj_x", adj_x)
+                     .Attr("adj_y", false)
+                     .Attr("_rhs_is_constant", true)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    const Tensor lhs = Random(adj_x ? TensorShape({batch, k, m})
+                                    : TensorShape({batch, m, k}));
+    const Tensor rhs = Random(TensorShape({k, n}));
+    inputs_.clear();
+    AddTensorInput(lhs);
+    AddTensorInput(rhs);
+    for (int run = 0; run < 2; ++run) {
+      TF_ASSERT_OK(RunOpKernel());
+      test::ExpectTensorNear<float>(*GetOutput(0),
+                                    Reference(lhs, rhs, adj_x, false), 1e-3);
+    }
+  }
+}
+
+TEST_F(MatMulWithConstantRhsTest, VariableUpdateAfterPackedProductIsInPlace) {
+  const int64_t m = 8, k = 64, n = 32;
+  TF_ASSERT_OK(NodeDefBuilder("matmul", "MatMul")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("_rhs_is_constant", true)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  Var* var = new Var(DT_FLOAT);
+  *var->tensor() = Random(TensorShape({k, n}));
+  var->is_initialized = true;
+  {
+    // Reads of a variable share its buffer, like ReadVariableOp does.
+    Tensor rhs = *var->tensor();
+    inputs_.clear();
+    AddTensorInput(Random(TensorShape({m, k})));
+    inputs_.push_back({nullptr, &rhs});
+    TF_ASSERT_OK(RunOpKernel());
+    inputs_.clear();
+  }
+  // Keep the kernel and its packed right-hand side alive during the update.
+  std::unique_ptr<OpKernel> matmul = std::move(kernel_);
+  const void* buffer = var->tensor()->data();
+
+  TF_ASSERT_OK(NodeDefBuilder("update", "AssignAddVariableOp")
+                   .Input(FakeInput(DT_RESOURCE))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  inputs_.clear();
+  AddResourceInput("", "var", var);
+  AddTensorInput(Random(TensorShape({k, n})));
+  TF_ASSERT_OK(RunOpKernel());
+  // The kernel holds no reference to the variable's buffer, so the update is
+  // made in place instead of on a copy.
+  EXPECT_EQ(buffer, var->tensor()->data());
+}
+
 //----------------------------------------------------------------------------//
 // Performance benchmarks are below.                                          //
 //----------------------------------------------------------------------------//
@@ -775,5 +929,34 @@ BM_BatchMatmul(1, 1, 200, 10000, true, true);
 BM_BatchMatmul(8, 1, 200, 10000, true, true);
 BM_BatchMatmul(32, 1, 200, 10000, true, true);
 
+// Products of a batch of rows with a constant weight matrix, with the weights
+// packed once (`state.range(3) == 1`) or by every product.
+static Graph* MatmulWithConstantRhs(int m, int k, int n, bool pack) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor in0(DT_FLOAT, TensorShape({m, k}));
+  in0.flat<float>().setRandom();
+  Tensor in1(DT_FLOAT, TensorShape({k, n}));
+  in1.flat<float>().setRandom();
+  Node* matmul =
+      test::graph::Matmul(g, test::graph::Constant(g, in0),
+                          test::graph::Constant(g, in1), false, false);
+  matmul->AddAttr("_rhs_is_constant", pack);
+  return g;
+}
+
+static void BM_MatmulConstantRhs(::testing::benchmark::State& state) {
+  const int m = state.range(0);
+  const int k = state.range(1);
+  const int n = state.range(2);
+  const bool pack = state.range(3) == 1;
+  test::Benchmark("cpu", MatmulWithConstantRhs(m, k, n, pack),
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetItemsProcessed(state.iterations() * m * k * n * 2);
+}
+BENCHMARK(BM_MatmulConstantRhs)
+    ->ArgsProduct({{4, 16, 64, 256}, {512, 2048}, {512, 2048}, {0, 1}})
+    ->MeasureProcessCPUTime();
+
 }  // namespace
 }  // namespace tensorflow
@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <string>
@@ -22,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -30,23 +32,40 @@ namespace {
 // For each slice in `(start, limit)` in `value_slices`, append
 // `params_dense_values_in[start:limit] to `values_out`.  `value_size` indicates
 // the number of scalars contained in each value params_dense_values_in[i].
+//
+// Every slice is a contiguous run of values in both the input and the output,
+// so it is copied as a block. The slices are sharded over the intra-op threads.
 template <typename VALUE_TYPE, typename SPLITS_TYPE>
 void WriteValueSlices(
-    const Tensor& params_dense_values_in,
+    OpKernelContext* context, const Tensor& params_dense_values_in,
     const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
     SPLITS_TYPE value_size, Tensor* values_out) {
-  const auto& params_dense_values =
-      params_dense_values_in.flat_outer_dims<VALUE_TYPE, 2>();
-  auto values = values_out->flat_outer_dims<VALUE_TYPE, 2>();
-  int out_pos = 0;
-  for (const auto& slice : value_slices) {
-    for (int i = slice.first; i < slice.second; ++i) {
-      for (int j = 0; j < value_size; ++j) {
-        values(out_pos, j) = params_dense_values(i, j);
-      }
-      ++out_pos;
-    }
+  if (value_slices.empty() || value_size == 0) return;
+  const VALUE_TYPE* params_dense_values =
+      params_dense_values_in.flat<VALUE_TYPE>().data();
+  VALUE_TYPE* values = values_out->flat<VALUE_TYPE>().data();
+
+  // out_starts[i] is the output row at which slice i starts.
+  std::vector<int64_t> out_starts(value_slices.size() + 1, 0);
+  for (size_t i = 0; i < value_slices.size(); ++i) {
+    out_starts[i + 1] =
+        out_starts[i] + value_slices[i].second - value_slices[i].first;
   }
+
+  auto copy_slices = [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const auto& slice = value_slices[i];
+      std::copy_n(params_dense_values + slice.first * value_size,
+                  (slice.second - slice.first) * value_size,
+                  values + out_starts[i] * value_size);
+    }
+  };
+  const int64_t cost_per_slice =
+      value_size * sizeof(VALUE_TYPE) * out_starts.back() / value_slices.size();
+  const auto& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers,
+        value_slices.size(), cost_per_slice, copy_slices);
 }
 
 }  // namespace
@@ -251,8 +270,8 @@ class RaggedGatherOpBase : public OpKernel {
     const SPLITS_TYPE value_size =
         num_elements == 0 ? 0
                           : (num_elements / params_dense_values_in.dim_size(0));
-    CallWriteValueSlices(params_dense_values_in, value_slices, value_size,
-                         values_out);
+    CallWriteValueSlices(context, params_dense_values_in, value_slices,
+                         value_size, values_out);
     return absl::OkStatus();
   }
 
@@ -263,7 +282,7 @@ class RaggedGatherOpBase : public OpKernel {
   // index type), rather than 14 (one for each index type and value type),
   // which cuts the binary size of this op from ~300k to <90k.
   virtual void CallWriteValueSlices(
-      const Tensor& params_dense_values_in,
+      OpKernelContext* context, const Tensor& params_dense_values_in,
       const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
       SPLITS_TYPE value_size, Tensor* values_out) const = 0;
 };
@@ -275,10 +294,10 @@ class RaggedGatherOp : public RaggedGatherOpBase<INDEX_TYPE, SPLITS_TYPE> {
 
  private:
   void CallWriteValueSlices(
-      const Tensor& params_dense_values_in,
+      OpKernelContext* context, const Tensor& params_dense_values_in,
       const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
       SPLITS_TYPE value_size, Tensor* values_out) const override {
-    WriteValueSlices<VALUE_TYPE>(params_dense_values_in, value_slices,
+    WriteValueSlices<VALUE_TYPE>(context, params_dense_values_in, value_slices,
                                  value_size, values_out);
   }
 };
@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/bcast.h"
 #include "tensorflow/core/util/ragged_to_dense_util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -466,6 +467,9 @@ void copy_array<Eigen::half, int32>(Eigen::half* dst, const Eigen::half* src,
 template <typename VALUE_TYPE, typename INDEX_TYPE>
 class RaggedTensorToTensorOp : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
  public:
+  // Outputs smaller than this many elements are written by a single thread.
+  static constexpr int64_t kMinElementsPerRange = 1 << 15;
+
   explicit RaggedTensorToTensorOp(OpKernelConstruction* context)
       : RaggedTensorToTensorBaseOp<INDEX_TYPE>(context) {}
 
@@ -486,7 +490,7 @@ class RaggedTensorToTensorOp : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
     TensorShape element_shape = output_tensor->shape();
     element_shape.RemoveDimRange(0, ragged_rank + 1);
     int value_element_size = element_shape.num_elements();
-    size_t output_index_size = output_index.size();
+    int64_t output_index_size = output_index.size();
 
     // Broadcast the default value to value_element_size.  (We can skip this
     // if default_value_tensor.NumElements() == 1, since we use std::fill
@@ -513,68 +517,112 @@ class RaggedTensorToTensorOp : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
       default_value = bcast_default.flat<VALUE_TYPE>().data();
     }
 
-    // Loop through the output_index vector, finding contiguous regions that
+    // Loop through output_index[begin:end], finding contiguous regions that
     // should be copied.  Once we find the end of a contiguous region, copy it
-    // and add any necessary padding (with default_value).
-    INDEX_TYPE src_start = 0;  // Start of contiguous region (in values)
-    INDEX_TYPE dst_start = 0;  // Destination for contiguous region (in output)
-    INDEX_TYPE dst_end = 0;    // Destination for contiguous region (in output)
-    for (int src_i = 0; src_i <= output_index_size; ++src_i) {
-      // dst_i is the destination where the value at src_i should be copied.
-      INDEX_TYPE dst_i = src_i < output_index_size ? output_index[src_i] : -1;
-
-      // If we're still in a contiguous region, then update dst_end go to the
-      // next src_i.
-      if (dst_i == dst_end) {
-        ++dst_end;
-        continue;
-      }
+    // and add any necessary padding (with default_value).  `prev_dst_end` is
+    // one past the last output row written by earlier sources; the last range
+    // also pads to the end of the output.
+    const int64_t output_size = output_tensor->NumElements();
+    auto copy_range = [&](int64_t begin, int64_t end, INDEX_TYPE prev_dst_end,
+                          bool is_last) {
+      // Start of contiguous region (in values)
+      INDEX_TYPE src_start = begin;
+      // Destination for contiguous region (in output)
+      INDEX_TYPE dst_start = prev_dst_end;
+      INDEX_TYPE dst_end = prev_dst_end;
+      for (int64_t src_i = begin; src_i <= end; ++src_i) {
+        // dst_i is the destination where the value at src_i should be copied.
+        INDEX_TYPE dst_i = src_i < end ? output_index[src_i] : -1;
+
+        // If we're still in a contiguous region, then update dst_end go to the
+        // next src_i.
+        if (dst_i == dst_end) {
+          ++dst_end;
+          continue;
+        }
 
-      // We found the end of contiguous region.  This can be because we found
-      // a gap (dst_i > dst_end), or a source value that shouldn't be copied
-      // because it's out-of-bounds (dst_i == -1), or the end of the tensor
-      // (dst_i = -1).
-      if (dst_start < dst_end) {
-        // Copy the contiguous region.
-        const VALUE_TYPE* src = values_base + src_start * value_element_size;
-        VALUE_TYPE* dst = output_base + dst_start * value_element_size;
-        INDEX_TYPE nvals = (dst_end - dst_start) * value_element_size;
-        copy_array<VALUE_TYPE, INDEX_TYPE>(dst, src, nvals);
-      }
+        // We found the end of contiguous region.  This can be because we found
+        // a gap (dst_i > dst_end), or a source value that shouldn't be copied
+        // because it's out-of-bounds (dst_i == -1), or the end of the range
+        // (dst_i = -1).
+        if (dst_start < dst_end) {
+          // Copy the contiguous region.
+          const VALUE_TYPE* src = values_base + src_start * value_element_size;
+          VALUE_TYPE* dst = output_base + dst_start * value_element_size;
+          INDEX_TYPE nvals = (dst_end - dst_start) * value_element_size;
+          copy_array<VALUE_TYPE, INDEX_TYPE>(dst, src, nvals);
+        }
 
-      // Add any necessary padding (w/ default_value).
-      if (src_i >= output_index_size) {
-        // We reached the end of values: pad to the end of output.
-        size_t output_size = output_tensor->NumElements();
-        dst_i = output_size / value_element_size;
-      }
-      if (dst_i > dst_end) {
-        if (default_value_tensor.NumElements() == 1) {
-          std::fill(output_base + dst_end * value_element_size,
-                    output_base + dst_i * value_element_size, *default_value);
-          dst_end = dst_i;
-        } else {
-          while (dst_i > dst_end) {
-            VALUE_TYPE* dst = output_base + dst_end * value_element_size;
-            copy_array<VALUE_TYPE, INDEX_TYPE>(dst, default_value,
-                                               value_element_size);
-            ++dst_end;
+        // Add any necessary padding (w/ default_value).
+        if (src_i >= end && is_last) {
+          // We reached the end of values: pad to the end of output.
+          dst_i = output_size / value_element_size;
+        }
+        if (dst_i > dst_end) {
+          if (default_value_tensor.NumElements() == 1) {
+            std::fill(output_base + dst_end * value_element_size,
+                      output_base + dst_i * value_element_size, *default_value);
+            dst_end = dst_i;
+          } else {
+            while (dst_i > dst_end) {
+              VALUE_TYPE* dst = output_base + dst_end * value_element_size;
+              copy_array<VALUE_TYPE, INDEX_TYPE>(dst, default_value,
+                                                 value_element_size);
+              ++dst_end;
+            }
           }
         }
-      }
 
-      // Update indices.
-      if (dst_i < 0) {
-        // src_i should be skipped -- leave it out of the contiguous region.
-        src_start = src_i + 1;
-        dst_start = dst_end;
-      } else {
-        // src_i should be copied -- include it in the contiguous region.
-        src_start = src_i;
-        dst_start = dst_end;
-        dst_end = dst_start + 1;
+        // Update indices.
+        if (dst_i < 0) {
+          // src_i should be skipped -- leave it out of the contiguous region.
+          src_start = src_i + 1;
+          dst_start = dst_end;
+        } else {
+          // src_i should be copied -- include it in the contiguous region.
+          src_start = src_i;
+          dst_start = dst_end;
+          dst_end = dst_start + 1;
+        }
+      }
+    };
+
+    // The valid (non-negative) entries of output_index are strictly
+    // increasing, so output_index can be split into ranges that write
+    // disjoint parts of the output.  Each range only needs to know where the
+    // previous ranges stopped writing, which is one past the last valid entry
+    // before it.
+    const auto& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int64_t num_ranges = std::max<int64_t>(
+        1, std::min<int64_t>(worker_threads.num_threads,
+                             output_size / kMinElementsPerRange));
+    if (num_ranges == 1) {
+      copy_range(0, output_index_size, 0, /*is_last=*/true);
+      return;
+    }
+    auto range_begin = [&](int64_t k) {
+      return output_index_size * k / num_ranges;
+    };
+    std::vector<INDEX_TYPE> prev_dst_end(num_ranges, 0);
+    for (int64_t k = 1; k < num_ranges; ++k) {
+      prev_dst_end[k] = prev_dst_end[k - 1];
+      for (int64_t i = range_begin(k) - 1; i >= range_begin(k - 1); --i) {
+        if (output_index[i] >= 0) {
+          prev_dst_end[k] = output_index[i] + 1;
+          break;
+        }
       }
     }
+    const int64_t cost_per_range =
+        output_size / num_ranges * sizeof(VALUE_TYPE);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_ranges,
+          cost_per_range, [&](int64_t begin, int64_t end) {
+            for (int64_t k = begin; k < end; ++k) {
+              copy_range(range_begin(k), range_begin(k + 1), prev_dst_end[k],
+                         /*is_last=*/k == num_ranges - 1);
+            }
+          });
   }
 };
 
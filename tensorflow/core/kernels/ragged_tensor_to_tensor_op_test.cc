@@ -409,6 +409,41 @@ TEST_F(RaggedTensorToTensorOpTest, RaggedTensorToTensorConstrained) {
                                 0.01);
 }
 
+TEST_F(RaggedTensorToTensorOpTest, RaggedTensorToTensorLargeConstrained) {
+  // Row i has i % 13 values; the output keeps the first 8 values of each of
+  // the first kNumOutputRows rows, so both padding and truncation happen in
+  // every part of the output.
+  constexpr int64_t kNumRows = 10000;
+  constexpr int64_t kNumOutputRows = 9000;
+  constexpr int64_t kNumCols = 8;
+  std::vector<int64_t> row_splits = {0};
+  std::vector<int64_t> values;
+  for (int64_t row = 0; row < kNumRows; ++row) {
+    for (int64_t col = 0; col < row % 13; ++col) {
+      values.push_back(row * 100 + col);
+    }
+    row_splits.push_back(values.size());
+  }
+  BuildRaggedTensorToTensorGraph<int64_t, int64_t>(
+      TensorShape({kNumOutputRows, kNumCols}),  // shape
+      {"ROW_SPLITS"},                           // row_partition_types
+      createVector<int64_t>(values),            // values
+      createScalar<int64_t>(-1),                // default_value
+      {createVector<int64_t>(row_splits)}       // row_partition_tensors
+  );
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_INT64, TensorShape({kNumOutputRows, kNumCols}));
+  auto expected_matrix = expected.matrix<int64_t>();
+  for (int64_t row = 0; row < kNumOutputRows; ++row) {
+    for (int64_t col = 0; col < kNumCols; ++col) {
+      expected_matrix(row, col) = col < row % 13 ? row * 100 + col : -1;
+    }
+  }
+  test::ExpectTensorEqual<int64_t>(*GetOutput(0), expected);
+}
+
 TEST_F(RaggedTensorToTensorOpTest, RaggedTensorToTensor_3DParamsConstrained) {
   // params = [
   //           [[]],
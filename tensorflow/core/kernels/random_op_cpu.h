@@ -21,11 +21,13 @@ limitations under the License.
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <type_traits>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/batched_philox_random.h"
 #include "tensorflow/core/kernels/random_op.h"
 #include "tensorflow/core/kernels/random_ops_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
@@ -76,6 +78,21 @@ struct FillPhiloxRandom {
 template <class Distribution, bool VariableSamplesPerOutput>
 struct FillPhiloxRandomTask;
 
+// The same distribution as `Distribution`, but drawing its samples from a
+// BatchedPhiloxRandom, or void if `Distribution` does not draw them from a
+// PhiloxRandom or has state that could not be carried over.
+template <class Distribution>
+struct BatchedPhiloxDistribution {
+  using type = void;
+};
+
+template <template <class, typename> class Distribution, typename T>
+struct BatchedPhiloxDistribution<Distribution<PhiloxRandom, T>> {
+  using type =
+      std::conditional_t<std::is_empty_v<Distribution<PhiloxRandom, T>>,
+                         Distribution<random::BatchedPhiloxRandom, T>, void>;
+};
+
 // Specialization for distribution that takes a fixed number of samples for
 // each output.
 template <class Distribution>
@@ -83,15 +100,33 @@ struct FillPhiloxRandomTask<Distribution, false> {
   typedef typename Distribution::ResultElementType T;
   static void Run(random::PhiloxRandom gen, T* data, int64_t size,
                   int64_t start_group, int64_t limit_group, Distribution dist) {
+    gen.Skip(start_group);
+    using BatchedDistribution =
+        typename BatchedPhiloxDistribution<Distribution>::type;
+    if constexpr (random::BatchedPhiloxRandom::kVectorized &&
+                  !std::is_void_v<BatchedDistribution>) {
+      // Draws the same samples, several Philox counters at a time.
+      random::BatchedPhiloxRandom batched_gen(gen);
+      FillGroups(&batched_gen, data, size, start_group, limit_group,
+                 BatchedDistribution());
+    } else {
+      FillGroups(&gen, data, size, start_group, limit_group, dist);
+    }
+  }
+
+ private:
+  template <class Generator, class GeneratorDistribution>
+  static void FillGroups(Generator* gen, T* data, int64_t size,
+                         int64_t start_group, int64_t limit_group,
+                         GeneratorDistribution dist) {
     const int kGroupSize = Distribution::kResultElementCount;
 
-    gen.Skip(start_group);
     int64_t offset = start_group * kGroupSize;
 
     // First fill all the full-size groups
     int64_t limit_group_full = std::min(limit_group, size / kGroupSize);
     for (int64_t index = start_group; index < limit_group_full; ++index) {
-      auto samples = dist(&gen);
+      auto samples = dist(gen);
       std::copy(&samples[0], &samples[0] + kGroupSize, data + offset);
       offset += kGroupSize;
     }
@@ -99,7 +134,7 @@ struct FillPhiloxRandomTask<Distribution, false> {
     // If there are any remaining elements that need to be filled, process them
     if (limit_group_full < limit_group) {
       int64_t remaining_size = size - limit_group_full * kGroupSize;
-      auto samples = dist(&gen);
+      auto samples = dist(gen);
       std::copy(&samples[0], &samples[0] + remaining_size, data + offset);
     }
   }
@@ -123,10 +123,13 @@ Status CopyVariable(int output_idx, OpKernelContext* ctx, const Tensor* t) {
     n.WaitForNotification();
     return status;
   } else {
+    // The copy is made while holding the variable's mutex in shared mode, which
+    // blocks writers, so it is spread over the intra-op threads.
+    const CPUDevice& d = ctx->eigen_device<CPUDevice>();
     switch (t->dtype()) {
-#define HANDLER(type)                       \
-  case DataTypeToEnum<type>::value:         \
-    output->flat<type>() = t->flat<type>(); \
+#define HANDLER(type)                                 \
+  case DataTypeToEnum<type>::value:                   \
+    output->flat<type>().device(d) = t->flat<type>(); \
     break;
       TF_CALL_ALL_TYPES(HANDLER);
       TF_CALL_float8_e5m2(HANDLER);
@@ -16,6 +16,7 @@ limitations under the License.
 #include <complex>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -38,6 +39,27 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
+// Sets an environment variable for the lifetime of the object and restores
+// its previous value (or unsets it) on destruction.
+class ScopedEnvVar {
+ public:
+  ScopedEnvVar(const char* name, const char* value) : name_(name) {
+    if (const char* old_value = getenv(name)) old_value_ = old_value;
+    setenv(name, value, /*overwrite=*/1);
+  }
+  ~ScopedEnvVar() {
+    if (old_value_.has_value()) {
+      setenv(name_.c_str(), old_value_->c_str(), /*overwrite=*/1);
+    } else {
+      unsetenv(name_.c_str());
+    }
+  }
+
+ private:
+  const std::string name_;
+  std::optional<std::string> old_value_;
+};
+
 // Make an input tensor with filled results.
 template <typename T>
 Tensor MakeInput(const TensorShape& shape,
@@ -352,6 +374,10 @@ class RestoreV2OpTest : public OpsTestBase {
 
 // The intended use case (write in V2, read in V2).
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
+TEST_F(RestoreV2OpTest, RestoreAfterSaveV2WithRestoreThreads) {
+  ScopedEnvVar num_threads("TF_RESTORE_V2_NUM_THREADS", "4");
+  RunTest("SaveV2");
+}
 // For backward compatibility.
 TEST_F(RestoreV2OpTest, RestoreAfterSaveSlicesV1) { RunTest("SaveSlices"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV1) { RunTest("Save"); }
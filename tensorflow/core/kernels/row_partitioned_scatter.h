@@ -0,0 +1,118 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_ROW_PARTITIONED_SCATTER_H_
+#define TENSORFLOW_CORE_KERNELS_ROW_PARTITIONED_SCATTER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tensorflow {
+namespace functor {
+
+// Scatters with fewer updates are not worth partitioning.
+constexpr int64_t kMinRowPartitionedUpdates = 1024;
+// Splitting the rows into more partitions than threads evens out their load.
+constexpr int kRowPartitionsPerThread = 4;
+
+// Calls `update(i, rows[i])` for every i in [0, rows.size()) whose row is not
+// negative, on the threads of `d`. `cost_per_update` is the cost of one call.
+//
+// The rows in [0, num_rows) are split into ranges, and the updates are sorted
+// by range with a stable counting sort, so that each range is updated by a
+// single thread, in the order of i. No locks are needed, and every row sees
+// the same sequence of updates as in a serial loop, so the result is the same
+// even when rows repeat and `update` does not commute.
+template <typename Index, typename Update>
+void RowPartitionedScatter(const Eigen::ThreadPoolDevice& d,
+                           const std::vector<Index>& rows, Index num_rows,
+                           const Eigen::TensorOpCost& cost_per_update,
+                           Update&& update) {
+  const int64_t num_updates = rows.size();
+  if (num_updates == 0 || num_rows == 0) return;
+  const int64_t max_partitions =
+      std::min<int64_t>(num_rows, kRowPartitionsPerThread * d.numThreads());
+  // A power of two number of rows per partition, so that the partition of a
+  // row is a shift away.
+  int shift = 0;
+  while ((num_rows + (int64_t{1} << shift) - 1) >> shift > max_partitions) {
+    ++shift;
+  }
+  const int64_t num_partitions =
+      (num_rows + (int64_t{1} << shift) - 1) >> shift;
+
+  // The sort is itself split into chunks of updates, which are counted and
+  // then placed by one thread each. The updates of a partition are placed
+  // chunk after chunk, which keeps them in order.
+  const int64_t num_chunks = std::min<int64_t>(
+      d.numThreads(), (num_updates + kMinRowPartitionedUpdates - 1) /
+                          kMinRowPartitionedUpdates);
+  const int64_t chunk_size = (num_updates + num_chunks - 1) / num_chunks;
+  const Eigen::TensorOpCost sort_cost =
+      Eigen::TensorOpCost(sizeof(Index), sizeof(Index), 1) * chunk_size;
+  // Entry `c * num_partitions + p` is the number of updates of chunk c in
+  // partition p, and then the position of the first of them in `order`.
+  std::vector<int64_t> offsets(num_chunks * num_partitions, 0);
+  d.parallelFor(num_chunks, sort_cost,
+                [&](Eigen::Index first, Eigen::Index last) {
+                  for (Eigen::Index c = first; c < last; ++c) {
+                    int64_t* counts = &offsets[c * num_partitions];
+                    const int64_t end =
+                        std::min(num_updates, (c + 1) * chunk_size);
+                    for (int64_t i = c * chunk_size; i < end; ++i) {
+                      if (rows[i] >= 0) ++counts[rows[i] >> shift];
+                    }
+                  }
+                });
+  std::vector<int64_t> starts(num_partitions + 1);
+  int64_t num_sorted = 0;
+  for (int64_t p = 0; p < num_partitions; ++p) {
+    starts[p] = num_sorted;
+    for (int64_t c = 0; c < num_chunks; ++c) {
+      const int64_t count = offsets[c * num_partitions + p];
+      offsets[c * num_partitions + p] = num_sorted;
+      num_sorted += count;
+    }
+  }
+  starts[num_partitions] = num_sorted;
+  std::vector<Index> order(num_sorted);
+  d.parallelFor(num_chunks, sort_cost,
+                [&](Eigen::Index first, Eigen::Index last) {
+                  for (Eigen::Index c = first; c < last; ++c) {
+                    int64_t* next = &offsets[c * num_partitions];
+                    const int64_t end =
+                        std::min(num_updates, (c + 1) * chunk_size);
+                    for (int64_t i = c * chunk_size; i < end; ++i) {
+                      if (rows[i] >= 0) order[next[rows[i] >> shift]++] = i;
+                    }
+                  }
+                });
+
+  d.parallelFor(num_partitions,
+                cost_per_update *
+                    (static_cast<double>(num_sorted) / num_partitions),
+                [&](Eigen::Index first, Eigen::Index last) {
+                  for (int64_t k = starts[first]; k < starts[last]; ++k) {
+                    update(order[k], rows[order[k]]);
+                  }
+                });
+}
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_ROW_PARTITIONED_SCATTER_H_
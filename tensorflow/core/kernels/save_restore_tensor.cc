@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
 
+#include <algorithm>
 #include <memory>
 #include <numeric>
 #include <unordered_map>
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -173,18 +175,15 @@ void RestoreTensor(OpKernelContext* context,
   const string& tensor_name = tensor_name_t.flat<tstring>()(restore_index);
 
   // If we cannot find a cached reader we will allocate our own.
-  std::unique_ptr<checkpoint::TensorSliceReader> allocated_reader;
-
-  const checkpoint::TensorSliceReader* reader = nullptr;
+  std::shared_ptr<const checkpoint::TensorSliceReader> reader;
 
   if (context->slice_reader_cache()) {
     reader = context->slice_reader_cache()->GetReader(file_pattern, open_func,
                                                       preferred_shard);
   }
   if (!reader) {
-    allocated_reader.reset(new checkpoint::TensorSliceReader(
-        file_pattern, open_func, preferred_shard));
-    reader = allocated_reader.get();
+    reader = std::make_shared<checkpoint::TensorSliceReader>(
+        file_pattern, open_func, preferred_shard);
   }
   OP_REQUIRES_OK(context, CHECK_NOTNULL(reader)->status());
 
@@ -251,6 +250,30 @@ namespace {
 // Tensors larger than this threshold will be restored from a thread-pool.
 const int64_t kLargeShapeThreshold = 16 << 20;  // 16M
 
+// When small tensors are restored from a thread-pool, runs of tensors that are
+// adjacent in the checkpoint are restored in batches of about this many bytes.
+// Each batch is read by a single BundleReader, whose input buffer coalesces
+// the reads of neighboring tensors into a few large range reads.
+const int64_t kRestoreBatchBytes = 16 << 20;  // 16MB
+
+// Returns the number of threads to restore tensors with, or 0 to keep small
+// tensors on the op thread. An explicit intra-op parallelism in the session
+// config takes precedence over TF_RESTORE_V2_NUM_THREADS.
+int64_t NumRestoreThreads(OpKernelContext* context) {
+  if (context->session_config() != nullptr &&
+      context->session_config()->intra_op_parallelism_threads() > 0) {
+    return context->session_config()->intra_op_parallelism_threads();
+  }
+  int64_t num_threads;
+  Status status =
+      ReadInt64FromEnvVar("TF_RESTORE_V2_NUM_THREADS", 0, &num_threads);
+  if (!status.ok()) {
+    LOG(WARNING) << "Ignoring TF_RESTORE_V2_NUM_THREADS: " << status;
+    return 0;
+  }
+  return std::max<int64_t>(num_threads, 0);
+}
+
 // A restore operation for a single tensor.  Small tensors may be restored
 // directly from the op thread to improve read locality.  Large tensors can be
 // restored from a thread pool: this requires creating a separate BundleReader
@@ -302,7 +325,14 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    if (shape_and_slice.empty() && reader->use_mmap()) {
+      // Lookup the full tensor, letting the reader alias it to the mapped
+      // data file rather than copying it into a fresh output buffer.
+      Tensor restored;
+      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, &restored));
+      context->set_output(idx, restored);
+      restored_tensor = context->mutable_output(idx);
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -356,10 +386,40 @@ struct RestoreOp {
   string shape_and_slice;
   string reader_prefix;
   DataType dtype;
+  // Approximate size of the tensor in the checkpoint.
+  int64_t num_bytes = 0;
 
   ::tensorflow::Status status;
 };
 
+// Runs a batch of restore operations, adjacent in the checkpoint, using a
+// single new BundleReader.
+void RunBatchWithNewReader(const std::vector<RestoreOp*>& batch,
+                           BundleCache* cache) {
+  BundleReader reader(tsl::Env::Default(), batch.front()->reader_prefix,
+                      {cache, false});
+  for (RestoreOp* op : batch) {
+    op->status = reader.status().ok() ? op->run(&reader) : reader.status();
+  }
+}
+
+// Splits "ops", sorted for sequential access, into batches of adjacent
+// operations of about "batch_bytes" bytes each.
+std::vector<std::vector<RestoreOp*>> BatchAdjacentOps(
+    const std::vector<RestoreOp*>& ops, int64_t batch_bytes) {
+  std::vector<std::vector<RestoreOp*>> batches;
+  int64_t bytes_in_batch = 0;
+  for (RestoreOp* op : ops) {
+    if (batches.empty() || bytes_in_batch >= batch_bytes) {
+      batches.emplace_back();
+      bytes_in_batch = 0;
+    }
+    batches.back().push_back(op);
+    bytes_in_batch += op->num_bytes;
+  }
+  return batches;
+}
+
 }  // namespace
 
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
@@ -387,11 +447,15 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
       restore_ops, [](const RestoreOp& op) { return op.tensor_name; }));
 
   std::vector<string> mismatched_errors;
-  for (const RestoreOp& restore_op : restore_ops) {
+  for (RestoreOp& restore_op : restore_ops) {
     TensorShape restored_full_shape;
     DataType original_dtype;
     TF_RETURN_IF_ERROR(default_reader.LookupDtypeAndShape(
         restore_op.tensor_name, &original_dtype, &restored_full_shape));
+    // Strings have no fixed size; count them as one byte per element.
+    restore_op.num_bytes =
+        restored_full_shape.num_elements() *
+        std::max<int64_t>(DataTypeSize(original_dtype), 1);
     if (restore_op.dtype != original_dtype) {
       string error_msg = strings::StrCat(
           "tensor_name = ", restore_op.tensor_name, "; expected dtype ",
@@ -417,22 +481,25 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     }
   }
 
-  if (context->session_config() != nullptr &&
-      context->session_config()->intra_op_parallelism_threads() > 0) {
+  const int64_t num_restore_threads = NumRestoreThreads(context);
+  if (num_restore_threads > 0) {
     // If an explicit restore parallelism is specified, we use it to run
     // run both small and large restore ops in parallel.
     auto reader_pool = std::make_unique<thread::ThreadPool>(
-        tsl::Env::Default(), "restore_tensors",
-        context->session_config()->intra_op_parallelism_threads());
+        tsl::Env::Default(), "restore_tensors", num_restore_threads);
 
-    // Schedule large ops first, followed by the small.
+    // Schedule large ops first, followed by the small. Small ops are batched
+    // so that each batch pays for opening a reader once and its reads are
+    // coalesced, while the batches still proceed in parallel.
     for (auto* op : large_restore_ops) {
       reader_pool->Schedule(
           [op, &cache]() { op->run_with_new_reader(&cache); });
     }
-    for (auto* op : small_restore_ops) {
+    const std::vector<std::vector<RestoreOp*>> batches =
+        BatchAdjacentOps(small_restore_ops, kRestoreBatchBytes);
+    for (const auto& batch : batches) {
       reader_pool->Schedule(
-          [op, &cache]() { op->run_with_new_reader(&cache); });
+          [&batch, &cache]() { RunBatchWithNewReader(batch, &cache); });
     }
 
     // Wait for all scheduled work to finish and check the status of all
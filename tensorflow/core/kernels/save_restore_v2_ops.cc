@@ -15,9 +15,12 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <algorithm>
 #include <cstddef>
 #include <limits>
+#include <numeric>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/framework/bounds_check.h"
@@ -29,10 +32,15 @@ limitations under the License.
 #include "tensorflow/core/kernels/checkpoint_callback_manager.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"  // IWYU pragma: keep
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -90,6 +98,207 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// A tensor to be saved by SaveV2, with the slice of the full tensor it holds
+// if it is a slice.
+struct SaveItem {
+  string name;
+  Tensor tensor;
+  bool is_slice = false;
+  TensorShape full_shape;
+  TensorSlice slice;
+};
+
+Status AddToBundle(const SaveItem& item, BundleWriter* writer) {
+  VLOG(2) << "Starting save of " << item.name;
+  if (VLOG_IS_ON(5) && item.tensor.dtype() == DT_FLOAT) {
+    const float* t_data = item.tensor.flat<float>().data();
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+    double avg = 0.0;
+    for (int i = 0; i < item.tensor.NumElements(); ++i) {
+      if (t_data[i] < min) min = t_data[i];
+      if (t_data[i] > max) max = t_data[i];
+      avg += t_data[i];
+    }
+    VLOG(5) << " min " << min << " max " << max << " avg "
+            << avg / item.tensor.NumElements() << " total elts "
+            << item.tensor.NumElements();
+  }
+  if (item.is_slice) {
+    TF_RETURN_IF_ERROR(
+        writer->AddSlice(item.name, item.full_shape, item.slice, item.tensor));
+  } else {
+    TF_RETURN_IF_ERROR(writer->Add(item.name, item.tensor));
+  }
+  VLOG(2) << "Done save of " << item.name;
+  return absl::OkStatus();
+}
+
+// Returns the number of data files a SaveV2 of `num_tensors` tensors holding
+// `total_bytes` bytes is written to in parallel. A single data file is written
+// sequentially, so large saves can be split to use the bandwidth of the
+// storage. This is opt-in: if TF_SAVE_V2_MIN_BYTES_PER_SHARD is positive, one
+// shard is used per that many bytes, up to TF_SAVE_V2_MAX_WRITE_SHARDS shards
+// (8 by default).
+int NumWriteShards(int64_t total_bytes, int num_tensors) {
+  int64_t min_bytes_per_shard;
+  int64_t max_shards;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_SAVE_V2_MIN_BYTES_PER_SHARD", 0,
+                                  &min_bytes_per_shard));
+  TF_CHECK_OK(
+      ReadInt64FromEnvVar("TF_SAVE_V2_MAX_WRITE_SHARDS", 8, &max_shards));
+  if (min_bytes_per_shard <= 0 || max_shards <= 1) return 1;
+  return static_cast<int>(std::clamp<int64_t>(
+      total_bytes / min_bytes_per_shard, 1,
+      std::min<int64_t>(max_shards, num_tensors)));
+}
+
+// Returns TF_SAVE_V2_MAX_DELTA_CHAIN. If positive, SaveV2 writes delta
+// checkpoints: tensors that did not change since the last checkpoint saved by
+// this process into the same directory are not written again, but referenced
+// in that checkpoint. A full checkpoint is written, compacting the chain,
+// whenever a delta would have more than this many bases.
+//
+// A checkpoint stays referenced by up to this many later ones, so callers that
+// delete old checkpoints must keep more than this many.
+int64_t MaxDeltaChain() {
+  int64_t max_chain;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_SAVE_V2_MAX_DELTA_CHAIN", 0, &max_chain));
+  return max_chain;
+}
+
+// Remembers, per directory, the last checkpoint that SaveV2 or
+// MergeV2Checkpoints completed in this process. It is the base of the next
+// delta checkpoint saved into that directory or into one of its
+// subdirectories, which is where sharded saves write their temporary parts.
+class DeltaBaseRegistry {
+ public:
+  static DeltaBaseRegistry* Global() {
+    static DeltaBaseRegistry* registry = new DeltaBaseRegistry();
+    return registry;
+  }
+
+  void Record(const string& prefix) {
+    mutex_lock l(mu_);
+    // Forgetting a directory only costs one full save.
+    if (last_prefixes_.size() >= kMaxDirectories) last_prefixes_.clear();
+    last_prefixes_[string(io::Dirname(prefix))] = prefix;
+  }
+
+  // Returns the base for a checkpoint at `prefix`, or the empty string.
+  string Find(const string& prefix) {
+    mutex_lock l(mu_);
+    string dir(io::Dirname(prefix));
+    while (!dir.empty()) {
+      auto it = last_prefixes_.find(dir);
+      if (it != last_prefixes_.end()) return it->second;
+      string parent(io::Dirname(dir));
+      if (parent == dir) break;
+      dir = std::move(parent);
+    }
+    return "";
+  }
+
+ private:
+  static constexpr int kMaxDirectories = 1024;
+
+  mutex mu_;
+  std::unordered_map<string, string> last_prefixes_ TF_GUARDED_BY(mu_);
+};
+
+// Returns the options of the writers of a SaveV2 to `prefix`.
+BundleWriter::Options SaveWriterOptions(const string& prefix,
+                                        int64_t max_delta_chain) {
+  BundleWriter::Options options;
+  if (max_delta_chain <= 0) return options;
+  options.write_fingerprints = true;
+  const string base = DeltaBaseRegistry::Global()->Find(prefix);
+  if (base.empty() || base == prefix) return options;
+  BundleReader reader(Env::Default(), base);
+  if (!reader.status().ok()) {
+    VLOG(1) << "Not writing " << prefix << " as a delta against " << base
+            << ": " << reader.status();
+    return options;
+  }
+  if (reader.delta_depth() + 1 > max_delta_chain) {
+    VLOG(1) << "Compacting the chain of deltas of " << base << " into "
+            << prefix;
+    return options;
+  }
+  options.delta_base_prefix = base;
+  return options;
+}
+
+// Writes `items` to `num_shards` bundles in parallel, and merges them into one
+// bundle at `prefix` whose data is split across `num_shards` files.
+//
+// The tensors are not copied: each writer reads the buffers of the inputs,
+// which the op holds until it completes. Shard 0 is written by the calling
+// thread and the others are scheduled on `workers`. On error, no temporary
+// shard files are left behind.
+Status SaveInShards(const string& prefix, const std::vector<SaveItem>& items,
+                    int num_shards, const BundleWriter::Options& options,
+                    thread::ThreadPool* workers) {
+  // Assign the largest tensors first, each to the least loaded shard.
+  std::vector<int> order(items.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&items](int a, int b) {
+    return items[a].tensor.TotalBytes() > items[b].tensor.TotalBytes();
+  });
+  std::vector<std::vector<int>> shard_items(num_shards);
+  std::vector<int64_t> shard_bytes(num_shards, 0);
+  for (int index : order) {
+    const int shard =
+        std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+        shard_bytes.begin();
+    shard_items[shard].push_back(index);
+    shard_bytes[shard] += items[index].tensor.TotalBytes();
+  }
+
+  std::vector<tstring> shard_prefixes(num_shards);
+  for (int shard = 0; shard < num_shards; ++shard) {
+    shard_prefixes[shard] = strings::StrCat(prefix, "_temp_shard_", shard);
+  }
+  std::vector<Status> statuses(num_shards);
+  auto write_shard = [&](int shard) {
+    BundleWriter writer(Env::Default(), shard_prefixes[shard], options);
+    Status s = writer.status();
+    for (int index : shard_items[shard]) {
+      if (!s.ok()) break;
+      s = AddToBundle(items[index], &writer);
+    }
+    // On error, this removes the partially written data file.
+    s.Update(writer.Finish());
+    statuses[shard] = s;
+  };
+  BlockingCounter counter(num_shards - 1);
+  for (int shard = 1; shard < num_shards; ++shard) {
+    workers->Schedule([&write_shard, &counter, shard]() {
+      write_shard(shard);
+      counter.DecrementCount();
+    });
+  }
+  write_shard(0);
+  counter.Wait();
+
+  Status status;
+  for (const Status& s : statuses) status.Update(s);
+  if (status.ok()) {
+    status = MergeBundles(Env::Default(), shard_prefixes, prefix);
+  }
+  if (!status.ok()) {
+    // A failed writer removes its own data file, but the other shards are
+    // complete bundles.
+    for (const tstring& shard_prefix : shard_prefixes) {
+      Env::Default()->DeleteFile(MetaFilename(shard_prefix)).IgnoreError();
+      Env::Default()
+          ->DeleteFile(DataFilename(shard_prefix, 0, 1))
+          .IgnoreError();
+    }
+  }
+  return status;
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
@@ -111,57 +320,54 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
+    std::vector<SaveItem> items(num_tensors);
+    int64_t total_bytes = 0;
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
-      const Tensor& tensor = context->input(i + kFixedInputs);
-      VLOG(2) << "Starting save of " << tensor_name;
+      SaveItem& item = items[i];
+      item.name = tensor_names_flat(i);
+      item.tensor = context->input(i + kFixedInputs);
+      total_bytes += item.tensor.TotalBytes();
 
       if (!shape_and_slices_flat(i).empty()) {
         const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
         TensorShape slice_shape;
-
+        item.slice = TensorSlice(item.tensor.dims());
         OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
+                                    shape_spec, &item.full_shape, &item.slice,
+                                    &slice_shape));
+        OP_REQUIRES(context, slice_shape.IsSameSize(item.tensor.shape()),
                     errors::InvalidArgument("Slice in shape_and_slice "
                                             "specification does not match the "
                                             "shape of the tensor to  save: ",
                                             shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
+                                            item.tensor.shape().DebugString()));
+        item.is_slice = true;
       }
+    }
 
-      if (VLOG_IS_ON(5)) {
-        if (tensor.dtype() == DT_FLOAT) {
-          const float* t_data = tensor.flat<float>().data();
-          float min = std::numeric_limits<float>::infinity();
-          float max = -std::numeric_limits<float>::infinity();
-          double avg = 0.0;
-          for (int i = 0; i < tensor.NumElements(); ++i) {
-            if (t_data[i] < min) min = t_data[i];
-            if (t_data[i] > max) max = t_data[i];
-            avg += t_data[i];
-          }
-          VLOG(5) << " min " << min << " max " << max << " avg "
-                  << avg / tensor.NumElements() << " total elts "
-                  << tensor.NumElements();
-        }
+    const int64_t max_delta_chain = MaxDeltaChain();
+    const BundleWriter::Options options =
+        SaveWriterOptions(prefix_string, max_delta_chain);
+    const int num_shards = NumWriteShards(total_bytes, num_tensors);
+    if (num_shards > 1) {
+      VLOG(1) << "Writing " << total_bytes << " bytes to " << num_shards
+              << " shards, prefix_string: " << prefix_string;
+      OP_REQUIRES_OK(context,
+                     SaveInShards(prefix_string, items, num_shards, options,
+                                  context->device()
+                                      ->tensorflow_cpu_worker_threads()
+                                      ->workers));
+    } else {
+      BundleWriter writer(Env::Default(), prefix_string, options);
+      OP_REQUIRES_OK(context, writer.status());
+      VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
+      for (const SaveItem& item : items) {
+        OP_REQUIRES_OK(context, AddToBundle(item, &writer));
       }
-
-      VLOG(2) << "Done save of " << tensor_name;
+      OP_REQUIRES_OK(context, writer.Finish());
     }
-    OP_REQUIRES_OK(context, writer.Finish());
     VLOG(1) << "Done BundleWriter, prefix_string: " << prefix_string;
+    if (max_delta_chain > 0) DeltaBaseRegistry::Global()->Record(prefix_string);
 
     ResourceMgr* resource_manager = context->resource_manager();
     if (resource_manager != nullptr) {
@@ -290,6 +496,7 @@ class MergeV2Checkpoints : public OpKernel {
     OP_REQUIRES_OK(context,
                    tensorflow::MergeBundles(env, input_prefixes, merged_prefix,
                                             allow_missing_files_));
+    if (MaxDeltaChain() > 0) DeltaBaseRegistry::Global()->Record(merged_prefix);
 
     if (delete_old_dirs_) {
       const string merged_dir(io::Dirname(merged_prefix));
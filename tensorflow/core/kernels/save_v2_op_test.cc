@@ -15,7 +15,9 @@ limitations under the License.
 
 #include <complex>
 #include <string>
+#include <vector>
 
+#include "absl/strings/str_join.h"
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -26,9 +28,11 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -340,5 +344,154 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+class SaveV2ShardedOpTest : public OpsTestBase {
+ protected:
+  void SetUp() override {
+    // Write one shard per tensor.
+    setenv("TF_SAVE_V2_MIN_BYTES_PER_SHARD", "1", /*overwrite=*/1);
+  }
+  void TearDown() override {
+    unsetenv("TF_SAVE_V2_MIN_BYTES_PER_SHARD");
+    unsetenv("TF_SAVE_V2_MAX_WRITE_SHARDS");
+  }
+
+  void MakeOp(const DataTypeVector& dtypes = {DT_FLOAT, DT_FLOAT, DT_INT32}) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "SaveV2")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput())  // shape_and_slices
+                     .Input(FakeInput(dtypes))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void MakeRestoreOp(const DataTypeVector& dtypes) {
+    inputs_.clear();
+    TF_ASSERT_OK(NodeDefBuilder("myop", "RestoreV2")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput())  // shape_and_slices
+                     .Attr("dtypes", dtypes)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(SaveV2ShardedOpTest, WritesOneDataFilePerShard) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_sharded");
+  const string tensornames[] = {"big", "sliced", "small"};
+
+  MakeOp();
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({3}), [&tensornames](int x) -> tstring {
+    return tensornames[x];
+  });
+  AddInput<tstring>(TensorShape({3}), [](int x) -> tstring {
+    return x == 1 ? "4 2 0,2:-" : "";
+  });
+  AddInput<float>(TensorShape({100}), [](int x) -> float { return x; });
+  AddInput<float>(TensorShape({2, 2}), [](int x) -> float { return -x; });
+  AddInput<int32>(TensorShape({3}), [](int x) -> int32 { return x + 1; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int shard = 0; shard < 3; ++shard) {
+    TF_EXPECT_OK(Env::Default()->FileExists(DataFilename(prefix, shard, 3)));
+  }
+
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("big", &val));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(static_cast<float>(i), val.flat<float>()(i));
+  }
+  TF_ASSERT_OK(reader.Lookup("small", &val));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i + 1, val.flat<int32>()(i));
+  }
+  TensorShape shape;
+  TF_ASSERT_OK(reader.LookupTensorShape("sliced", &shape));
+  EXPECT_TRUE(shape.IsSameSize(TensorShape({4, 2})));
+}
+
+TEST_F(SaveV2ShardedOpTest, RestoresSaveAboveThreshold) {
+  // 428 bytes are saved, so two shards are written.
+  setenv("TF_SAVE_V2_MIN_BYTES_PER_SHARD", "200", /*overwrite=*/1);
+  const string prefix =
+      io::JoinPath(testing::TmpDir(), "tensor_sharded_restore");
+  const string tensornames[] = {"big", "sliced", "small"};
+  const string slices[] = {"", "4 2 0,2:-", ""};
+
+  MakeOp();
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({3}), [&tensornames](int x) -> tstring {
+    return tensornames[x];
+  });
+  AddInput<tstring>(TensorShape({3}),
+                    [&slices](int x) -> tstring { return slices[x]; });
+  AddInput<float>(TensorShape({100}), [](int x) -> float { return x; });
+  AddInput<float>(TensorShape({2, 2}), [](int x) -> float { return -x; });
+  AddInput<int32>(TensorShape({3}), [](int x) -> int32 { return x + 1; });
+  TF_ASSERT_OK(RunOpKernel());
+  for (int shard = 0; shard < 2; ++shard) {
+    TF_EXPECT_OK(Env::Default()->FileExists(DataFilename(prefix, shard, 2)));
+  }
+
+  MakeRestoreOp({DT_FLOAT, DT_FLOAT, DT_INT32});
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({3}), [&tensornames](int x) -> tstring {
+    return tensornames[x];
+  });
+  AddInput<tstring>(TensorShape({3}),
+                    [&slices](int x) -> tstring { return slices[x]; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  const Tensor& big = *GetOutput(0);
+  ASSERT_TRUE(big.shape().IsSameSize(TensorShape({100})));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(static_cast<float>(i), big.flat<float>()(i));
+  }
+  const Tensor& sliced = *GetOutput(1);
+  ASSERT_TRUE(sliced.shape().IsSameSize(TensorShape({2, 2})));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(static_cast<float>(-i), sliced.flat<float>()(i));
+  }
+  const Tensor& small = *GetOutput(2);
+  ASSERT_TRUE(small.shape().IsSameSize(TensorShape({3})));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i + 1, small.flat<int32>()(i));
+  }
+}
+
+TEST_F(SaveV2ShardedOpTest, FailedShardRemovesAllTemporaryShards) {
+  // "x" is written to shard 0, and "y" and both "dup" to shard 1, which fails
+  // on the duplicate key after shard 0 was written successfully.
+  setenv("TF_SAVE_V2_MAX_WRITE_SHARDS", "2", /*overwrite=*/1);
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_sharded_fail");
+  const string tensornames[] = {"x", "y", "dup", "dup"};
+
+  MakeOp({DT_FLOAT, DT_FLOAT, DT_INT32, DT_INT32});
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({4}), [&tensornames](int x) -> tstring {
+    return tensornames[x];
+  });
+  AddInput<tstring>(TensorShape({4}), [](int x) -> tstring { return ""; });
+  AddInput<float>(TensorShape({100}), [](int x) -> float { return x; });
+  AddInput<float>(TensorShape({75}), [](int x) -> float { return x; });
+  AddInput<int32>(TensorShape({1}), [](int x) -> int32 { return 1; });
+  AddInput<int32>(TensorShape({1}), [](int x) -> int32 { return 2; });
+  EXPECT_FALSE(RunOpKernel().ok());
+
+  std::vector<string> leftovers;
+  TF_ASSERT_OK(Env::Default()->GetMatchingPaths(
+      strings::StrCat(prefix, "_temp_shard_*"), &leftovers));
+  EXPECT_TRUE(leftovers.empty()) << absl::StrJoin(leftovers, ", ");
+  EXPECT_FALSE(Env::Default()->FileExists(MetaFilename(prefix)).ok());
+}
+
 }  // namespace
 }  // namespace tensorflow
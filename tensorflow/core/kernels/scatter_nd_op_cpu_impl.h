@@ -21,6 +21,7 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include <atomic>
+#include <vector>
 
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/row_partitioned_scatter.h"
 #include "tensorflow/core/kernels/scatter_nd_op.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -127,6 +129,47 @@ struct ScatterNdFunctor<CPUDevice, T, Index, OP, IXDIM> {
           batch_strides[dim + 1] * output_shape_prefix[dim + 1];
     }
 
+    const Index num_rows = static_cast<Index>(Toutput.dimension(0));
+    if (batch_size >= kMinRowPartitionedUpdates && num_rows >= 2 &&
+        d.numThreads() >= 2) {
+      // Computes the rows first, so that they can be split between threads.
+      // Each row still sees its updates in order, so the result is the same as
+      // that of the serial loop below.
+      std::vector<Index> rows(batch_size);
+      for (Eigen::DenseIndex loc = 0; loc < batch_size; ++loc) {
+        Index i = 0;
+        bool out_of_bounds = false;
+        for (int dim = 0; dim < IXDIM; ++dim) {
+          const Index ix_d = internal::SubtleMustCopy(Tindices(loc, dim));
+          out_of_bounds |= !FastBoundsCheck(ix_d, output_shape_prefix[dim]);
+          i += ix_d * batch_strides[dim];
+        }
+        if (TF_PREDICT_FALSE(out_of_bounds)) {
+          // Skip the update, as the serial loop does.
+          error_loc = loc;
+          i = -1;
+        }
+        rows[loc] = i;
+      }
+      // Each thread updates its slices by itself, rather than splitting them
+      // between threads again.
+      Eigen::DefaultDevice device;
+      RowPartitionedScatter(
+          d, rows, num_rows,
+          Eigen::TensorOpCost(2 * slice_size * sizeof(T),
+                              slice_size * sizeof(T), slice_size),
+          [&](Index loc, Index i) {
+            auto input_chip = Toutput.template chip<0>(i);
+            auto output_chip = input_chip;
+            auto update_chip = Tupdates.template chip<0>(loc);
+            update_executor::UpdateExecutor<
+                Eigen::DefaultDevice, decltype(input_chip),
+                decltype(update_chip), decltype(output_chip),
+                OP>::Execute(device, input_chip, update_chip, output_chip);
+          });
+      return error_loc;
+    }
+
     for (Eigen::DenseIndex loc = 0; loc < batch_size; ++loc) {
       Index i = 0;
       bool out_of_bounds = false;
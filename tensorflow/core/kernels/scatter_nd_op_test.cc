@@ -540,6 +540,40 @@ TEST_F(ScatterNdOpTest, Error_IndexOutOfRange) {
       << s;
 }
 
+TEST_F(ScatterNdOpTest, ManyUpdatesInSerialOrder) {
+  MakeOp(DT_FLOAT, DT_INT32);
+  // Enough updates to be applied in parallel, with repeated slices whose float
+  // sums depend on the order of the updates.
+  const int kRows = 10;
+  const int kCols = 20;
+  const int kSliceSize = 2;
+  const int kNumUpdates = 100000;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int32> indices;
+  std::vector<float> updates;
+  std::vector<float> expected_values(kRows * kCols * kSliceSize, 0.0f);
+  for (int i = 0; i < kNumUpdates; i++) {
+    const int row = rnd.Uniform(kRows);
+    const int col = rnd.Uniform(kCols);
+    indices.push_back(row);
+    indices.push_back(col);
+    for (int j = 0; j < kSliceSize; j++) {
+      updates.push_back(rnd.RandFloat() * i);
+      expected_values[(row * kCols + col) * kSliceSize + j] += updates.back();
+    }
+  }
+  AddInputFromArray<int32>(TensorShape({kNumUpdates, 2}), indices);
+  AddInputFromArray<float>(TensorShape({kNumUpdates, kSliceSize}), updates);
+  AddInputFromArray<int32>(TensorShape({3}), {kRows, kCols, kSliceSize});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT,
+                  TensorShape({kRows, kCols, kSliceSize}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
 class ScatterNdOpErrorOnBadIndicesTest : public OpsTestBase {
  protected:
   void MakeOp(DataType variable_type, DataType index_type) {
@@ -632,14 +666,14 @@ class ScatterNdUpdateBM : public ScatterNdUpdateOpTest {
 
 template <typename Index>
 void BM_ScatterNdHelper(::testing::benchmark::State& state, int embedding_size,
-                        const char* op) {
+                        const char* op, bool big_num_updates = false) {
   const int kRows = 10000000 / embedding_size;
   std::vector<float> values;
   values.reserve(kRows);
   for (int i = 0; i < kRows * embedding_size; i++) {
     values.push_back(i);
   }
-  const int kNumUpdates = 1000;
+  const int kNumUpdates = big_num_updates ? 1000000 : 1000;
   random::PhiloxRandom philox(301, 17);
   random::SimplePhilox rnd(&philox);
   std::vector<Index> indices;
@@ -680,6 +714,11 @@ void BM_ScatterNdAddInt32(::testing::benchmark::State& state) {
 
   BM_ScatterNdHelper<int32>(state, embedding_size, "ScatterNdAdd");
 }
+void BM_ScatterNdAddInt32Large(::testing::benchmark::State& state) {
+  const int embedding_size = state.range(0);
+
+  BM_ScatterNdHelper<int32>(state, embedding_size, "ScatterNdAdd", true);
+}
 void BM_ScatterNdAddInt64(::testing::benchmark::State& state) {
   const int embedding_size = state.range(0);
 
@@ -700,6 +739,12 @@ BENCHMARK(BM_ScatterNdUpdateInt64)
     ->Arg(1024);
 
 BENCHMARK(BM_ScatterNdAddInt32)->Arg(1)->Arg(10)->Arg(64)->Arg(256)->Arg(1024);
+BENCHMARK(BM_ScatterNdAddInt32Large)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(64)
+    ->Arg(256)
+    ->Arg(1024);
 BENCHMARK(BM_ScatterNdAddInt64)->Arg(1)->Arg(10)->Arg(64)->Arg(256)->Arg(1024);
 
 }  // namespace
@@ -217,6 +217,60 @@ TEST_F(ScatterSubOpTest, StressIndexTest) {
   test::ExpectTensorEqual<int32>(expected, params_tensor);
 }
 
+TEST_F(ScatterSubOpTest, ManyUpdatesInSerialOrder) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+  // Enough updates to be applied in parallel, with repeated rows whose float
+  // sums depend on the order of the updates.
+  const int kRows = 100;
+  const int kCols = 3;
+  const int kNumUpdates = 100000;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<float> values(kRows * kCols, 1.0f);
+  std::vector<int32> indices;
+  std::vector<float> updates;
+  for (int i = 0; i < kNumUpdates; i++) {
+    indices.push_back(rnd.Uniform(kRows));
+    for (int j = 0; j < kCols; j++) updates.push_back(rnd.RandFloat() * i);
+  }
+  std::vector<float> expected_values = values;
+  for (int i = 0; i < kNumUpdates; i++) {
+    for (int j = 0; j < kCols; j++) {
+      expected_values[indices[i] * kCols + j] -= updates[i * kCols + j];
+    }
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kCols}), values);
+  AddInputFromArray<int32>(TensorShape({kNumUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kNumUpdates, kCols}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kCols}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorEqual<float>(expected, params_tensor);
+}
+
+TEST_F(ScatterUpdateOpTest, ManyUpdatesKeepLast) {
+  MakeOp(DT_INT32_REF, DT_INT32);
+  const int kRows = 100;
+  const int kNumUpdates = 100000;
+  std::vector<int32> indices;
+  std::vector<int32> updates;
+  std::vector<int32> expected_values(kRows, 0);
+  for (int i = 0; i < kNumUpdates; i++) {
+    indices.push_back((i * 7919) % kRows);
+    updates.push_back(i);
+    expected_values[indices.back()] = i;
+  }
+  AddInputFromArray<int32>(TensorShape({kRows}), std::vector<int32>(kRows, 0));
+  AddInputFromArray<int32>(TensorShape({kNumUpdates}), indices);
+  AddInputFromArray<int32>(TensorShape({kNumUpdates}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_INT32, TensorShape({kRows}));
+  test::FillValues<int32>(&expected, expected_values);
+  test::ExpectTensorEqual<int32>(expected, params_tensor);
+}
+
 TEST_F(ScatterUpdateOpTest, Error_WrongDimsIndices) {
   MakeOp(DT_FLOAT_REF, DT_INT32);
 
@@ -35,6 +35,7 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include "absl/base/prefetch.h"
 #include "absl/container/flat_hash_map.h"
 #include "Eigen/Core"  // from @eigen_archive
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
@@ -53,6 +54,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/determinism.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -400,6 +402,22 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
     // Nothing to reduce. All output values equal to `InitialValueF()`.
     if (num_reductions == 0) return;
 
+    // Large reductions, which the scans of `segment_ids` by every worker below
+    // do not scale to, are either reduced into per-thread partial outputs or
+    // sorted by segment; see ReduceIntoPartials() and ReduceSorted().
+    const int num_threads =
+        ctx->device()->tensorflow_cpu_worker_threads()->num_threads;
+    if (num_threads > 1 && num_real_segment * inner_dim >= kMinParallelElems) {
+      if (!OpDeterminismRequired() &&
+          num_segments * num_threads * kMinRowsPerPartialRow <=
+              num_real_segment) {
+        ReduceIntoPartials(ctx, segment_ids, data, num_threads, output);
+      } else {
+        ReduceSorted(ctx, segment_ids, data, row_counter, output);
+      }
+      return;
+    }
+
     // Parallelize by `num_segments`. It's simple, efficient and safe
     // (no data dependency):
     //
@@ -443,6 +461,136 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
       cpu_device.parallelFor(num_segments, cost, reductionWorker);
     }
   }
+
+ private:
+  // Reductions of fewer elements than this are parallelized by scanning all
+  // of `segment_ids` in every worker.
+  static constexpr int64_t kMinParallelElems = 1 << 16;
+  // Per-thread partial outputs are used when there are at least this many
+  // input rows per row of the partial outputs.
+  static constexpr int64_t kMinRowsPerPartialRow = 4;
+
+  // Reduces `num_partials` contiguous ranges of the input rows in parallel,
+  // each into its own partial output, and then reduces the partial outputs
+  // into `output`. This suits inputs with many more rows than there are
+  // segments, and skewed segment ids, but the order in which the rows of a
+  // segment are reduced depends on the number of threads.
+  void ReduceIntoPartials(OpKernelContext* ctx,
+                          typename TTypes<Index>::ConstFlat segment_ids,
+                          typename TTypes<T, 2>::ConstTensor data,
+                          int num_partials,
+                          typename TTypes<T, 2>::Tensor output) {
+    const int64_t N = segment_ids.dimension(0);
+    const int64_t num_segments = output.dimension(0);
+    const int64_t inner_dim = data.dimension(1);
+    Tensor partials;
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_temp(
+                 DataTypeToEnum<T>::value,
+                 TensorShape({num_partials * num_segments, inner_dim}),
+                 &partials));
+    auto partials_mat = partials.matrix<T>();
+    ReductionF reduction;
+    auto cpu_device = ctx->eigen_cpu_device();
+
+    const int64_t rows_per_partial = (N + num_partials - 1) / num_partials;
+    auto reduce_rows = [&](int64_t begin, int64_t end) {
+      for (int64_t p = begin; p < end; ++p) {
+        auto partial = partials_mat.slice(
+            Eigen::DSizes<Eigen::DenseIndex, 2>(p * num_segments, 0),
+            Eigen::DSizes<Eigen::DenseIndex, 2>(num_segments, inner_dim));
+        partial.setConstant(InitialValueF()());
+        const int64_t row_end = std::min(N, (p + 1) * rows_per_partial);
+        for (int64_t i = p * rows_per_partial; i < row_end; ++i) {
+          const Index j = internal::SubtleMustCopy(segment_ids(i));
+          if (j < 0) continue;
+          reduction(data.template chip<0>(i),
+                    partials_mat.template chip<0>(p * num_segments + j));
+        }
+      }
+    };
+    const Eigen::TensorOpCost rows_cost(
+        sizeof(T) * inner_dim * rows_per_partial,
+        sizeof(T) * inner_dim * rows_per_partial,
+        5 * inner_dim * rows_per_partial);
+    cpu_device.parallelFor(num_partials, rows_cost, reduce_rows);
+
+    typename TTypes<T, 2>::ConstTensor const_partials =
+        const_cast<const Tensor&>(partials).matrix<T>();
+    auto reduce_partials = [&](int64_t begin, int64_t end) {
+      for (int64_t j = begin; j < end; ++j) {
+        for (int p = 0; p < num_partials; ++p) {
+          reduction(const_partials.template chip<0>(p * num_segments + j),
+                    output.template chip<0>(j));
+        }
+      }
+    };
+    const Eigen::TensorOpCost partials_cost(
+        sizeof(T) * inner_dim * num_partials, sizeof(T) * inner_dim,
+        5 * inner_dim * num_partials);
+    cpu_device.parallelFor(num_segments, partials_cost, reduce_partials);
+  }
+
+  // Sorts the input rows by segment with a counting sort, and then reduces
+  // ranges of segments that hold about the same number of rows in parallel.
+  // The rows of a segment are reduced in their input order, so the result
+  // does not depend on the number of threads.
+  void ReduceSorted(OpKernelContext* ctx,
+                    typename TTypes<Index>::ConstFlat segment_ids,
+                    typename TTypes<T, 2>::ConstTensor data,
+                    const std::vector<Index>& row_counter,
+                    typename TTypes<T, 2>::Tensor output) {
+    const int64_t N = segment_ids.dimension(0);
+    const int64_t num_segments = output.dimension(0);
+    const int64_t inner_dim = data.dimension(1);
+    // `segment_starts[j]` is the position in `sorted_rows` of the first row of
+    // segment `j`.
+    std::vector<int64_t> segment_starts(num_segments + 1, 0);
+    for (int64_t j = 0; j < num_segments; ++j) {
+      segment_starts[j + 1] = segment_starts[j] + row_counter[j];
+    }
+    std::vector<int64_t> next(segment_starts.begin(), segment_starts.end() - 1);
+    std::vector<int64_t> sorted_rows(segment_starts[num_segments]);
+    for (int64_t i = 0; i < N; ++i) {
+      const Index j = internal::SubtleMustCopy(segment_ids(i));
+      if (j < 0) continue;
+      sorted_rows[next[j]++] = i;
+    }
+
+    // Splits the segments into blocks of about `rows_per_block` rows, so that
+    // a hot segment does not leave the other workers idle behind it.
+    const int num_threads =
+        ctx->device()->tensorflow_cpu_worker_threads()->num_threads;
+    const int64_t num_rows = segment_starts[num_segments];
+    const int64_t rows_per_block =
+        std::max<int64_t>(1, num_rows / (4 * num_threads));
+    std::vector<int64_t> block_starts = {0};
+    for (int64_t j = 1; j < num_segments; ++j) {
+      if (segment_starts[j] - segment_starts[block_starts.back()] >=
+          rows_per_block) {
+        block_starts.push_back(j);
+      }
+    }
+    block_starts.push_back(num_segments);
+
+    ReductionF reduction;
+    auto work = [&](int64_t begin, int64_t end) {
+      for (int64_t b = begin; b < end; ++b) {
+        for (int64_t j = block_starts[b]; j < block_starts[b + 1]; ++j) {
+          for (int64_t k = segment_starts[j]; k < segment_starts[j + 1]; ++k) {
+            reduction(data.template chip<0>(sorted_rows[k]),
+                      output.template chip<0>(j));
+          }
+        }
+      }
+    };
+    const int64_t num_blocks = block_starts.size() - 1;
+    const int64_t rows_per_task = std::max<int64_t>(1, num_rows / num_blocks);
+    const Eigen::TensorOpCost cost(sizeof(T) * inner_dim * rows_per_task,
+                                   sizeof(T) * inner_dim * rows_per_task,
+                                   5 * inner_dim * rows_per_task);
+    ctx->eigen_cpu_device().parallelFor(num_blocks, cost, work);
+  }
 };
 
 template <typename T>
@@ -618,6 +766,14 @@ class SparseSegmentReductionOpBase : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
+    if constexpr (std::is_same<T, float>::value ||
+                  std::is_same<T, bfloat16>::value) {
+      OP_REQUIRES_OK(context, ReduceSegmentsInParallel(
+                                  context, input_flat, indices_vec, segment_vec,
+                                  output_rows, output_flat));
+      return;
+    }
+
     // If we use DT_BFLOAT16 or DT_HALF, we need to use DT_FLOAT for
     // accumulation. We create a temp tensor to perform this accumulation for
     // every segment.
@@ -719,6 +875,120 @@ class SparseSegmentReductionOpBase : public OpKernel {
     return input_flat.template chip<0>(index).template cast<float>();
   }
 
+  // Number of columns of a segment that are accumulated at a time by
+  // ReduceSegmentsInParallel(), and number of rows read ahead of the one being
+  // accumulated.
+  static constexpr int64_t kColumnBlock = 64;
+  static constexpr int64_t kPrefetchRows = 4;
+
+  // Reduces the rows of float or bfloat16 `input_flat` in place, without the
+  // per-segment Eigen expressions of ReduceImpl(): the segments are first
+  // validated in order, so that errors match those of the sequential loop, and
+  // are then reduced in parallel. Each segment is reduced kColumnBlock columns
+  // at a time into a float accumulator that stays in registers, while the
+  // rows that follow are prefetched, which is what embedding bags of rows
+  // picked at random in a large table need.
+  Status ReduceSegmentsInParallel(
+      OpKernelContext* context, const typename TTypes<T>::ConstMatrix& input,
+      const typename TTypes<Index>::ConstVec& indices_vec,
+      const typename TTypes<SegmentId>::ConstVec& segment_vec,
+      Index output_rows, typename TTypes<T>::Matrix& output) {
+    struct Segment {
+      int64_t start;
+      int64_t end;
+      SegmentId id;
+    };
+    const int64_t num_indices = indices_vec.dimension(0);
+    const Index input_rows = input.dimension(0);
+    std::vector<Segment> segments;
+    int64_t start = 0;
+    SegmentId out_index = internal::SubtleMustCopy(segment_vec(0));
+    for (int64_t end = 1;; ++end) {
+      SegmentId next_index = 0;
+      if (end < num_indices) {
+        next_index = internal::SubtleMustCopy(segment_vec(end));
+        if (out_index == next_index) continue;
+        if (out_index > next_index) {
+          return errors::InvalidArgument("segment ids are not increasing");
+        }
+      }
+      if (!FastBoundsCheck(out_index, output_rows)) {
+        return errors::InvalidArgument(
+            "Segment id ", out_index, " out of range [0, ", output_rows,
+            "), possibly because 'segment_ids' input is not sorted.");
+      }
+      for (int64_t i = start; i < end; ++i) {
+        if (!FastBoundsCheck(indices_vec(i), input_rows)) {
+          return errors::InvalidArgument("Bad: indices[", i,
+                                         "] == ", indices_vec(i),
+                                         " out of range [0, ", input_rows, ")");
+        }
+      }
+      segments.push_back({start, end, out_index});
+      if (end >= num_indices) break;
+      start = end;
+      out_index = next_index;
+    }
+
+    const int64_t num_col = input.dimension(1);
+    const T* input_base = input.data();
+    T* output_base = output.data();
+    auto fill_gap = [&](SegmentId begin, SegmentId end) {
+      std::fill(output_base + begin * num_col, output_base + end * num_col,
+                default_value_);
+    };
+    auto work = [&](int64_t begin, int64_t end) {
+      float acc[kColumnBlock];
+      for (int64_t s = begin; s < end; ++s) {
+        const Segment& segment = segments[s];
+        fill_gap(s == 0 ? 0 : segments[s - 1].id + 1, segment.id);
+        const int64_t num = segment.end - segment.start;
+        const float scale = is_mean_    ? static_cast<float>(num)
+                            : is_sqrtn_ ? static_cast<float>(sqrt(num))
+                                        : 1.0f;
+        T* out_row = output_base + segment.id * num_col;
+        for (int64_t col = 0; col < num_col; col += kColumnBlock) {
+          const int64_t width = std::min(kColumnBlock, num_col - col);
+          std::fill(acc, acc + width, 0.0f);
+          for (int64_t i = segment.start; i < segment.end; ++i) {
+            if (i + kPrefetchRows < segment.end) {
+              const T* next_row =
+                  input_base + indices_vec(i + kPrefetchRows) * num_col + col;
+              for (int64_t j = 0; j < width; j += 64 / sizeof(T)) {
+                absl::PrefetchToLocalCache(next_row + j);
+              }
+            }
+            const T* row = input_base + indices_vec(i) * num_col + col;
+            for (int64_t j = 0; j < width; ++j) {
+              acc[j] += static_cast<float>(row[j]);
+            }
+          }
+          // Same rounding as ReduceImpl(): small segments are scaled by the
+          // reciprocal of their size, and the other ones divided by it.
+          if (num < 10) {
+            const float factor = 1.0f / scale;
+            for (int64_t j = 0; j < width; ++j) {
+              out_row[col + j] = static_cast<T>(acc[j] * factor);
+            }
+          } else {
+            for (int64_t j = 0; j < width; ++j) {
+              out_row[col + j] = static_cast<T>(acc[j] / scale);
+            }
+          }
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int64_t cost_per_segment =
+        std::max<int64_t>(1, num_indices / segments.size()) * num_col *
+        sizeof(T);
+    Shard(worker_threads.num_threads, worker_threads.workers, segments.size(),
+          cost_per_segment, work);
+    fill_gap(segments.back().id + 1, output_rows);
+    return absl::OkStatus();
+  }
+
   template <typename Tout>
   EIGEN_ALWAYS_INLINE Tout get_scaling_factor(int64_t num) {
     Tout m(1);
@@ -16,6 +16,7 @@ limitations under the License.
 #include <functional>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
@@ -38,9 +39,12 @@ limitations under the License.
 
 namespace tensorflow {
 
+// `hot_percent` percent of the rows go to segment 0, and the others are spread
+// evenly over the `segment_size` segments.
 static void BM_UnsortedSegmentReduction(::testing::benchmark::State& state,
                                         const string& reduction, int num_rows,
-                                        int num_cols, int segment_size) {
+                                        int num_cols, int segment_size,
+                                        int hot_percent = 0) {
   std::unique_ptr<Device> device(
       DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:0"));
 
@@ -53,8 +57,9 @@ static void BM_UnsortedSegmentReduction(::testing::benchmark::State& state,
 
   TensorShape shape2({num_rows});
   Tensor indices(DT_INT32, shape2);
-  test::FillFn<int>(&indices,
-                    [&segment_size](int i) -> int { return i % segment_size; });
+  test::FillFn<int>(&indices, [&segment_size, &hot_percent](int i) -> int {
+    return i % 100 < hot_percent ? 0 : i % segment_size;
+  });
   reduction_inputs.push_back({nullptr, &indices});
 
   Tensor num_segments(DT_INT32, TensorShape({}));
@@ -106,6 +111,20 @@ static void BM_UnsortedSegmentReduction(::testing::benchmark::State& state,
 BM_UnsortedReduce_Arg(4096, 1024, 1);
 BM_UnsortedReduce_Arg(4096, 1024, 128);
 
+#define BM_UnsortedReduceSkewed(R, C, S, K)                                  \
+  static void BM_UnsortedSegmentSum_##R##_##C##_##S##_hot##K(                \
+      ::testing::benchmark::State& state) {                                  \
+    BM_UnsortedSegmentReduction(state, "UnsortedSegmentSum", R, C, S, K);    \
+  }                                                                          \
+  BENCHMARK(BM_UnsortedSegmentSum_##R##_##C##_##S##_hot##K)->UseRealTime();
+
+BM_UnsortedReduceSkewed(262144, 64, 64, 0);
+BM_UnsortedReduceSkewed(262144, 64, 64, 90);
+BM_UnsortedReduceSkewed(262144, 64, 65536, 0);
+BM_UnsortedReduceSkewed(262144, 64, 65536, 90);
+BM_UnsortedReduceSkewed(262144, 64, 262144, 0);
+BM_UnsortedReduceSkewed(262144, 64, 262144, 90);
+
 template <typename Index>
 static void BM_SegmentReduction(::testing::benchmark::State& state,
                                 const string& reduction, Index num_rows,
@@ -290,4 +309,164 @@ BENCHMARK(BM_SparseSegmentMeanGrad_High_FP16)
     ->Arg(1000)
     ->Arg(100000);
 
+class SparseSegmentReductionOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& op, DataType type) {
+    TF_ASSERT_OK(NodeDefBuilder("op", op)
+                     .Input(FakeInput(type))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(SparseSegmentReductionOpTest, WideRowsWithEmptySegments) {
+  // Rows wider than the column blocks of the CPU kernel, and segments 1 and 3
+  // that are empty.
+  constexpr int kCols = 100;
+  for (const string op : {"SparseSegmentSum", "SparseSegmentMean"}) {
+    for (DataType type : {DT_FLOAT, DT_BFLOAT16}) {
+      inputs_.clear();
+      MakeOp(op, type);
+      // Row i of the data is i + j in column j.
+      if (type == DT_FLOAT) {
+        AddInput<float>(TensorShape({3, kCols}),
+                        [](int k) -> float { return k / kCols + k % kCols; });
+      } else {
+        AddInput<bfloat16>(TensorShape({3, kCols}), [](int k) -> bfloat16 {
+          return static_cast<bfloat16>(k / kCols + k % kCols);
+        });
+      }
+      Tensor expected(DT_FLOAT, TensorShape({5, kCols}));
+      auto expected_mat = expected.matrix<float>();
+      for (int j = 0; j < kCols; ++j) {
+        const float rows[] = {0.0f + j, 1.0f + j, 2.0f + j};
+        const float scale = op == "SparseSegmentMean" ? 0.5f : 1.0f;
+        expected_mat(0, j) = (rows[2] + rows[0]) * scale;
+        expected_mat(1, j) = 0;
+        expected_mat(2, j) = rows[1];
+        expected_mat(3, j) = 0;
+        expected_mat(4, j) = (rows[1] + rows[1]) * scale;
+      }
+      AddInputFromArray<int32>(TensorShape({5}), {2, 0, 1, 1, 1});
+      AddInputFromArray<int32>(TensorShape({5}), {0, 0, 2, 4, 4});
+      TF_ASSERT_OK(RunOpKernel());
+      Tensor output(DT_FLOAT, TensorShape({5, kCols}));
+      if (type == DT_FLOAT) {
+        output = *GetOutput(0);
+      } else {
+        output.flat<float>() = GetOutput(0)->flat<bfloat16>().cast<float>();
+      }
+      test::ExpectTensorNear<float>(output, expected, 1e-1);
+    }
+  }
+}
+
+TEST_F(SparseSegmentReductionOpTest, OutOfRangeIndex) {
+  MakeOp("SparseSegmentSum", DT_FLOAT);
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<int32>(TensorShape({3}), {0, 1, 2});
+  AddInputFromArray<int32>(TensorShape({3}), {0, 1, 1});
+  EXPECT_TRUE(absl::StrContains(RunOpKernel().message(),
+                                "Bad: indices[2] == 2 out of range [0, 2)"));
+}
+
+class UnsortedSegmentSumOpTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("op", "UnsortedSegmentSum")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(UnsortedSegmentSumOpTest, LargeInputs) {
+  // Large enough to be parallelized, with few segments (reduced into
+  // per-thread partials) or many segments (sorted by segment).
+  constexpr int kRows = 8192;
+  constexpr int kCols = 16;
+  for (int num_segments : {4, 6000}) {
+    inputs_.clear();
+    MakeOp();
+    AddInput<float>(TensorShape({kRows, kCols}),
+                    [](int k) -> float { return k % 7; });
+    // A third of the rows go to segment 1, and some rows are dropped.
+    std::vector<int32> segment_ids(kRows);
+    for (int i = 0; i < kRows; ++i) {
+      segment_ids[i] = i % 3 == 0    ? 1
+                       : i % 11 == 0 ? -1
+                                     : (i * 7) % num_segments;
+    }
+    AddInputFromArray<int32>(TensorShape({kRows}), segment_ids);
+    AddInputFromArray<int32>(TensorShape({}), {num_segments});
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(DT_FLOAT, TensorShape({num_segments, kCols}));
+    expected.flat<float>().setZero();
+    for (int i = 0; i < kRows; ++i) {
+      if (segment_ids[i] < 0) continue;
+      for (int j = 0; j < kCols; ++j) {
+        expected.matrix<float>()(segment_ids[i], j) += (i * kCols + j) % 7;
+      }
+    }
+    test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+  }
+}
+
+// Embedding bags of `state.range(1)` rows of 64 columns each, picked at random
+// in a table of `state.range(0)` rows.
+template <DataType T>
+static void SparseSegmentSumHelper(::testing::benchmark::State& state) {
+  typedef typename EnumToDataType<T>::Type DT;
+  const int table_rows = state.range(0);
+  const int bag_size = state.range(1);
+  constexpr int kNumBags = 1024;
+  constexpr int kCols = 64;
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input(T, TensorShape({table_rows, kCols}));
+  input.flat<DT>().setRandom();
+  Tensor indices(DT_INT32, TensorShape({kNumBags * bag_size}));
+  Tensor segments(DT_INT32, TensorShape({kNumBags * bag_size}));
+  for (int i = 0; i < kNumBags * bag_size; ++i) {
+    indices.flat<int32>()(i) = (i * 2654435761u) % table_rows;
+    segments.flat<int32>()(i) = i / bag_size;
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseSegmentSum")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, indices))
+                  .Input(test::graph::Constant(g, segments))
+                  .Attr("T", T)
+                  .Finalize(g, &node));
+
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          kNumBags * bag_size * kCols * sizeof(DT));
+}
+
+static void BM_SparseSegmentSum_FP32(::testing::benchmark::State& state) {
+  return SparseSegmentSumHelper<DT_FLOAT>(state);
+}
+
+static void BM_SparseSegmentSum_BF16(::testing::benchmark::State& state) {
+  return SparseSegmentSumHelper<DT_BFLOAT16>(state);
+}
+
+BENCHMARK(BM_SparseSegmentSum_FP32)
+    ->UseRealTime()
+    ->Args({1 << 10, 16})
+    ->Args({1 << 20, 16})
+    ->Args({1 << 20, 64});
+BENCHMARK(BM_SparseSegmentSum_BF16)
+    ->UseRealTime()
+    ->Args({1 << 10, 16})
+    ->Args({1 << 20, 16})
+    ->Args({1 << 20, 64});
+
 }  // namespace tensorflow
@@ -18,6 +18,11 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -30,18 +35,85 @@ namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
-// Partial specialization for a CPUDevice, that uses the Eigen implementation
-// from SoftmaxEigenImpl.
+// Partial specialization for a CPUDevice. Each row is processed in two passes:
+// the first one computes the maximum and the sum of exponentials with online
+// normalization, one block of classes at a time, and the second one writes the
+// output. Rows are sharded over the threads of the device. Half and bfloat16
+// logits are accumulated in float.
 namespace functor {
-template <typename Device, typename T>
-struct SoftmaxFunctorBase {
-  void operator()(const Device& d, typename TTypes<T>::ConstMatrix logits,
+template <typename T>
+struct SoftmaxFunctor<CPUDevice, T> {
+  using Acc = typename std::conditional<std::is_same<T, double>::value, double,
+                                        float>::type;
+  using AccBlock = Eigen::Map<const Eigen::Array<Acc, Eigen::Dynamic, 1>>;
+  using OutBlock = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+  // Number of classes processed at once; a block stays in L1 between reading
+  // its maximum and its exponentials.
+  static constexpr int64_t kBlockSize = 512;
+
+  // Returns logits[0, size) as accumulator values, converting them into
+  // `buffer` if needed.
+  static AccBlock LoadBlock(const T* logits, int64_t size, Acc* buffer) {
+    if constexpr (std::is_same<T, Acc>::value) {
+      return AccBlock(logits, size);
+    } else {
+      for (int64_t i = 0; i < size; ++i) {
+        buffer[i] = static_cast<Acc>(logits[i]);
+      }
+      return AccBlock(buffer, size);
+    }
+  }
+
+  void operator()(const CPUDevice& d, typename TTypes<T>::ConstMatrix logits,
                   typename TTypes<T>::Matrix softmax, const bool log) {
-    SoftmaxEigenImpl<Device, T>::Compute(d, logits, softmax, log);
+    const int64_t num_classes = logits.dimension(1);
+    auto compute_rows = [&](Eigen::Index begin, Eigen::Index end) {
+      Acc buffer[kBlockSize];
+      for (Eigen::Index row = begin; row < end; ++row) {
+        const T* logits_row = &logits(row, 0);
+        T* softmax_row = &softmax(row, 0);
+
+        Acc max = -std::numeric_limits<Acc>::infinity();
+        Acc sum = 0;
+        for (int64_t c = 0; c < num_classes; c += kBlockSize) {
+          const int64_t size = std::min(kBlockSize, num_classes - c);
+          const AccBlock block = LoadBlock(logits_row + c, size, buffer);
+          const Acc block_max = block.maxCoeff();
+          if (block_max > max) {
+            sum *= std::exp(max - block_max);
+            max = block_max;
+          }
+          sum += (block - max).exp().sum();
+        }
+
+        // `softmax` may alias `logits`, which is fine since every output is
+        // computed from the input at the same position.
+        const Acc log_sum = std::log(sum);
+        const Acc inv_sum = Acc(1) / sum;
+        for (int64_t c = 0; c < num_classes; c += kBlockSize) {
+          const int64_t size = std::min(kBlockSize, num_classes - c);
+          const AccBlock block = LoadBlock(logits_row + c, size, buffer);
+          OutBlock out(softmax_row + c, size);
+          if (log) {
+            out = ((block - max) - log_sum).template cast<T>();
+          } else {
+            out = ((block - max).exp() * inv_sum).template cast<T>();
+          }
+        }
+      }
+    };
+
+    const double bytes_per_row = num_classes * sizeof(T);
+    const double cycles_per_row =
+        num_classes * 2 * Eigen::internal::functor_traits<
+                              Eigen::internal::scalar_exp_op<Acc>>::Cost;
+    d.parallelFor(logits.dimension(0),
+                  Eigen::TensorOpCost(2 * bytes_per_row, bytes_per_row,
+                                      cycles_per_row),
+                  compute_rows);
   }
 };
-template <typename T>
-struct SoftmaxFunctor<CPUDevice, T> : SoftmaxFunctorBase<CPUDevice, T> {};
 
 }  // namespace functor
 
@@ -60,6 +60,9 @@ namespace tensorflow {
 static constexpr int32_t kMaxShards = 20;
 // Number of shards allocated to each thread.
 static constexpr int32_t kNumShardsPerThread = 3;
+// Size of the blocks of columns of the dense matrix, in bytes, in which rows of
+// the output are accumulated on CPU.
+static constexpr int64_t kDenseColumnBlockBytes = 4096;
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
@@ -158,10 +161,10 @@ class CSRMatMulOp : public OpKernel {
 
 // CPU Kernel to compute sparse-dense matrix multiplication.
 //
-// Uses Eigen SparseMatrix to compute the sparse-dense multiplication between
-// a CSR SparseMatrix `a` and dense Tensor `b`. If intra-op parallelism is
-// available, the implementation parallelizes the computation across each row
-// of the sparse matrix.
+// Computes the sparse-dense multiplication between a CSR SparseMatrix `a` and
+// dense Tensor `b`. If intra-op parallelism is available, the implementation
+// parallelizes the computation across shards of rows of the sparse matrix that
+// hold roughly the same number of nonzeros.
 template <typename T>
 class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
   using SparseMatrix = Eigen::SparseMatrix<T, Eigen::RowMajor>;
@@ -220,6 +223,18 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
     if (!this->transpose_a_) {
       SparseDenseMatMulWithoutTransposedLHS(
           ctx, batch_size, num_lhs_rows, *sparse_matrix_a, *rhs, matmul_result);
+    } else if (sparse_matrix_a->total_nnz() < matmul_result->NumElements()) {
+      // The product with the transposed LHS below keeps a copy of the output
+      // per thread and sums them up. When the output is larger than the sparse
+      // matrix, transposing the sparse matrix is cheaper.
+      CSRSparseMatrix sparse_matrix_a_transposed;
+      functor::CSRSparseMatrixTranspose<CPUDevice, T> transpose;
+      OP_REQUIRES_OK(ctx,
+                     transpose(ctx, this->conjugate_a_, *sparse_matrix_a,
+                               &sparse_matrix_a_transposed));
+      SparseDenseMatMulWithoutTransposedLHS(ctx, batch_size, num_lhs_rows,
+                                            sparse_matrix_a_transposed, *rhs,
+                                            matmul_result);
     } else {  // transpose_a_ == true
       SparseDenseMatMulWithTransposedLHS(ctx, batch_size, num_lhs_rows,
                                          num_lhs_cols, *sparse_matrix_a, *rhs,
@@ -302,49 +317,107 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
                                              const CSRSparseMatrix& lhs,
                                              const Tensor& rhs,
                                              Tensor* output) {
-    // Parallelize matrix multiplication across batch dimensions and across
-    // rows in each batch.
+    const int64_t total_rows = batch_size * num_lhs_rows;
+    if (total_rows == 0) return;
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     const int32_t num_threads = worker_threads.num_threads;
-    const int64_t block_size =
-        num_lhs_rows / std::max(kMaxShards, kNumShardsPerThread * num_threads);
     const int64_t num_rhs_rows = rhs.dim_size(rhs.dims() - 2);
     const int64_t num_rhs_cols = rhs.dim_size(rhs.dims() - 1);
+
+    // Parallelize matrix multiplication across batch dimensions and across
+    // rows in each batch. Each row costs one row of the output plus one row of
+    // the RHS per nonzero, so the rows are split into shards of roughly equal
+    // `cost`, which is the cost of the first `batch_and_row` rows.
+    auto cost = [&](int64_t batch_and_row) -> int64_t {
+      const int64_t batch_idx = batch_and_row / num_lhs_rows;
+      if (batch_idx == batch_size) return lhs.total_nnz() + batch_and_row;
+      const int64_t row = batch_and_row % num_lhs_rows;
+      return lhs.batch_offset(batch_idx) +
+             lhs.row_pointers_vec(batch_idx)(row) + batch_and_row;
+    };
+    const int64_t num_shards = std::min<int64_t>(
+        total_rows, std::max(kMaxShards, kNumShardsPerThread * num_threads));
+    const int64_t total_cost = cost(total_rows);
+    std::vector<int64_t> shard_begins(num_shards + 1, total_rows);
+    shard_begins[0] = 0;
+    for (int64_t shard = 1; shard < num_shards; ++shard) {
+      // Find the first row at which the cost reaches the shard's share.
+      const int64_t target_cost = total_cost * shard / num_shards;
+      int64_t low = shard_begins[shard - 1];
+      int64_t high = total_rows;
+      while (low < high) {
+        const int64_t mid = low + (high - low) / 2;
+        if (cost(mid) < target_cost) {
+          low = mid + 1;
+        } else {
+          high = mid;
+        }
+      }
+      shard_begins[shard] = low;
+    }
+
     worker_threads.workers->ParallelFor(
-        batch_size * num_lhs_rows /* total */,
+        num_shards /* total */,
         thread::ThreadPool::SchedulingParams(
             thread::ThreadPool::SchedulingStrategy::
                 kFixedBlockSize /* strategy */,
-            absl::nullopt /* cost_per_unit */, block_size),
-        [&](int64_t batch_and_row_begin, int64_t batch_and_row_end) {
-          HandleBatchAndRowRange(
-              num_lhs_rows, batch_and_row_begin, batch_and_row_end,
-              [&](int64_t batch_idx, int64_t row_begin, int64_t row_end) {
-                const int64_t num_shard_rows = row_end - row_begin;
-
-                // Define an Eigen::SparseMatrix over the row range:
-                // [row_begin, row_end) of the CSR SparseMatrix A.
-                std::vector<int32> row_ptrs;
-                auto sparse_matrix = GetSparseMatrixRef(
-                    lhs, batch_idx, row_begin, num_shard_rows, &row_ptrs);
-
-                // Map the corresponding rows of the rhs.
-                ConstMatrixMap rhs_map(rhs.flat<T>().data() + batch_idx *
-                                                                  num_rhs_rows *
-                                                                  num_rhs_cols,
-                                       num_rhs_rows, num_rhs_cols);
-
-                // Write to the corresponding rows of the output matrix.
-                MatrixMap output_map(
-                    output->flat<T>().data() +
-                        batch_idx * num_lhs_rows * num_rhs_cols +
-                        row_begin * num_rhs_cols,
-                    num_shard_rows, num_rhs_cols);
-                output_map.noalias() = sparse_matrix * rhs_map;
-              });
+            absl::nullopt /* cost_per_unit */, 1 /* block_size */),
+        [&](int64_t shard_begin, int64_t shard_end) {
+          for (int64_t shard = shard_begin; shard < shard_end; ++shard) {
+            HandleBatchAndRowRange(
+                num_lhs_rows, shard_begins[shard], shard_begins[shard + 1],
+                [&](int64_t batch_idx, int64_t row_begin, int64_t row_end) {
+                  // Map the rhs and the output of the current batch.
+                  ConstMatrixMap rhs_map(
+                      rhs.flat<T>().data() +
+                          batch_idx * num_rhs_rows * num_rhs_cols,
+                      num_rhs_rows, num_rhs_cols);
+                  MatrixMap output_map(
+                      output->flat<T>().data() +
+                          batch_idx * num_lhs_rows * num_rhs_cols,
+                      num_lhs_rows, num_rhs_cols);
+                  SparseDenseMatMulRows(lhs, batch_idx, row_begin, row_end,
+                                        rhs_map, &output_map);
+                });
+          }
         });
   }
 
+  // Computes the rows [row_begin, row_end) of the product of the sparse matrix
+  // `lhs` and `rhs` in batch `batch_idx`. Each output row is the sum of the
+  // rows of `rhs` selected by the nonzeros of the `lhs` row, which Eigen
+  // vectorizes across the columns. Wide rows are accumulated in blocks of
+  // columns, so that the block of the output row stays in cache.
+  void SparseDenseMatMulRows(const CSRSparseMatrix& lhs, const int batch_idx,
+                             const int64_t row_begin, const int64_t row_end,
+                             const ConstMatrixMap& rhs, MatrixMap* output) {
+    const auto row_ptrs = lhs.row_pointers_vec(batch_idx);
+    const auto col_indices = lhs.col_indices_vec(batch_idx);
+    const auto values = lhs.values_vec<T>(batch_idx);
+    const int64_t num_cols = rhs.cols();
+    const int64_t block_cols =
+        std::max<int64_t>(1, kDenseColumnBlockBytes / sizeof(T));
+    for (int64_t row = row_begin; row < row_end; ++row) {
+      const int64_t nnz_begin = row_ptrs(row);
+      const int64_t nnz_end = row_ptrs(row + 1);
+      if (nnz_begin == nnz_end) {
+        output->row(row).setZero();
+        continue;
+      }
+      for (int64_t col = 0; col < num_cols; col += block_cols) {
+        const int64_t num_block_cols = std::min(block_cols, num_cols - col);
+        auto output_block = output->row(row).segment(col, num_block_cols);
+        output_block.noalias() =
+            values(nnz_begin) *
+            rhs.row(col_indices(nnz_begin)).segment(col, num_block_cols);
+        for (int64_t i = nnz_begin + 1; i < nnz_end; ++i) {
+          output_block.noalias() +=
+              values(i) * rhs.row(col_indices(i)).segment(col, num_block_cols);
+        }
+      }
+    }
+  }
+
   // Sparse-Dense Matrix Multiplication assuming the CSRSparseMatrix (LHS) is
   // to be transposed before the operation.
   void SparseDenseMatMulWithTransposedLHS(OpKernelContext* ctx,
@@ -364,8 +437,8 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
     // to have them in column major form.
     //
     // However, if A is hypersparse and B and C are huge, transposing A will be
-    // cheaper. In the future, we should have a cost model estimating the cost
-    // of transposing all matrices (A, B, C) to decide which variant to use.
+    // cheaper, in which case Compute() transposes A explicitly and does not
+    // call this function.
 
     // Each thread writes to its own copy of the matrix product. These
     // `num_threads` copies are summed together to obtain the final result.
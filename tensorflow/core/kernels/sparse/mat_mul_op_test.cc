@@ -0,0 +1,107 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Builds a graph multiplying a random `m` x `k` CSR SparseMatrix (or its
+// adjoint) with `density_per_mille` nonzeros per thousand entries and a dense
+// `k` x `n` matrix. The graph also converts the sparse matrix from a
+// SparseTensor, which is linear in the number of nonzeros.
+Graph* CSRMatMul(int m, int k, int n, int density_per_mille, bool adjoint_a) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const int64_t a_rows = adjoint_a ? k : m;
+  const int64_t a_cols = adjoint_a ? m : k;
+  std::mt19937 gen(0);
+  std::bernoulli_distribution nonzero(density_per_mille / 1000.0);
+  // SparseTensorToCSRSparseMatrix requires indices in row-major order.
+  std::vector<int64_t> indices;
+  for (int64_t row = 0; row < a_rows; ++row) {
+    for (int64_t col = 0; col < a_cols; ++col) {
+      if (nonzero(gen)) {
+        indices.push_back(row);
+        indices.push_back(col);
+      }
+    }
+  }
+  const int64_t nnz = indices.size() / 2;
+  Tensor a_indices(DT_INT64, TensorShape({nnz, 2}));
+  std::copy(indices.begin(), indices.end(), a_indices.flat<int64_t>().data());
+  Tensor a_values(DT_FLOAT, TensorShape({nnz}));
+  a_values.flat<float>().setRandom();
+  Tensor a_shape(DT_INT64, TensorShape({2}));
+  a_shape.vec<int64_t>()(0) = a_rows;
+  a_shape.vec<int64_t>()(1) = a_cols;
+  Tensor b(DT_FLOAT, TensorShape({k, n}));
+  b.flat<float>().setRandom();
+
+  Node* a;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseTensorToCSRSparseMatrix")
+                  .Input(test::graph::Constant(g, a_indices))
+                  .Input(test::graph::Constant(g, a_values))
+                  .Input(test::graph::Constant(g, a_shape))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &a));
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseMatrixMatMul")
+                  .Input(a)
+                  .Input(test::graph::Constant(g, b))
+                  .Attr("T", DT_FLOAT)
+                  .Attr("adjoint_a", adjoint_a)
+                  .Finalize(g, &ret));
+  return g;
+}
+
+void BM_CSRMatMul(::testing::benchmark::State& state) {
+  const int m = state.range(0);
+  const int n = state.range(1);
+  const int density_per_mille = state.range(2);
+  const bool adjoint_a = state.range(3);
+  const int k = m;
+  test::Benchmark("cpu", CSRMatMul(m, k, n, density_per_mille, adjoint_a),
+                  /*old_benchmark_api*/ false)
+      .Run(state);
+  // Each nonzero of the sparse matrix is multiplied with a row of `b`.
+  const int64_t items_per_iter =
+      static_cast<int64_t>(m) * k * density_per_mille / 1000 * n;
+  state.SetItemsProcessed(state.iterations() * items_per_iter);
+}
+
+BENCHMARK(BM_CSRMatMul)
+    ->Args({1024, 1, 10, 0})
+    ->Args({1024, 64, 10, 0})
+    ->Args({1024, 64, 10, 1})
+    ->Args({1024, 1024, 10, 0})
+    ->Args({1024, 1024, 10, 1})
+    ->Args({4096, 256, 1, 0})
+    ->Args({4096, 256, 1, 1})
+    ->Args({4096, 4096, 1, 0})
+    ->Args({4096, 4096, 1, 1})
+    ->Args({4096, 256, 50, 0})
+    ->Args({4096, 256, 50, 1});
+
+}  // namespace
+}  // namespace tensorflow
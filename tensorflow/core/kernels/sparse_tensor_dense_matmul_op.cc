@@ -19,12 +19,16 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "Eigen/Core"  // from @eigen_archive
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -251,75 +255,130 @@ Status MOutOfBoundsError(int64_t m, std::size_t i, int lhs_index_a,
                                  "] out of bounds (>=", out_dim0, ")");
 }
 
+// Number of shards of the output rows allocated to each thread.
+constexpr int64_t kNumShardsPerThread = 4;
+// Minimum number of multiply-adds in a shard of the output rows.
+constexpr int64_t kMinCostPerShard = 1 << 16;
+
 template <typename T, typename Tsum, typename Tindices, bool ADJ_A, bool ADJ_B>
 Status SparseTensorDenseMatMulImpl(
-    typename TTypes<Tsum>::Matrix out,
+    OpKernelContext* ctx, typename TTypes<Tsum>::Matrix out,
     typename TTypes<Tindices>::ConstMatrix a_indices,
     typename TTypes<T>::ConstVec a_values, typename TTypes<T>::ConstMatrix b) {
-  // Vectorize certain operations above this size.
-  static constexpr std::size_t kNumVectorize = 32;
-
-  const std::size_t nnz = a_values.size();
-  const std::size_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
-  const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
+  using Matrix =
+      Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  using SumMatrix =
+      Eigen::Matrix<Tsum, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  const int64_t nnz = a_values.size();
+  const int64_t out_rows = out.dimension(0);
+  const int64_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
+  const int64_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
   const int lhs_index_a = ADJ_A ? 1 : 0;
   const int rhs_index_a = ADJ_A ? 0 : 1;
 
-  // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-  // approach that achieves the performance of the single threaded
-  // one.  Perhaps Eigen threadpool implementation is just too slow?
-
-  if (rhs_right < kNumVectorize) {
-    // Disable vectorization if the RHS of output is too small
-    auto maybe_adjoint_b = MaybeAdjoint<decltype(b), ADJ_B>(b);
+  // Validate the indices once, outside of the multiplication loop, and group
+  // the nonzeros by output row so that each output row is computed by a
+  // single thread. `row_starts[m]` is the position of the first nonzero of
+  // row m in that grouping.
+  std::vector<Tindices> rows(nnz);
+  std::vector<Tindices> cols(nnz);
+  std::vector<int64_t> row_starts(out_rows + 1, 0);
+  bool sorted = true;
+  for (int64_t i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    if (!FastBoundsCheck(k, lhs_right)) {
+      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+    }
+    if (!FastBoundsCheck(m, out_rows)) {
+      return MOutOfBoundsError(m, i, lhs_index_a, out_rows);
+    }
+    sorted = sorted && (i == 0 || m >= rows[i - 1]);
+    rows[i] = m;
+    cols[i] = k;
+    ++row_starts[m + 1];
+  }
+  for (int64_t m = 0; m < out_rows; ++m) {
+    row_starts[m + 1] += row_starts[m];
+  }
+  // If the nonzeros are not sorted by output row, sort their positions with a
+  // stable counting sort, which keeps the order in which each output row
+  // accumulates its nonzeros.
+  std::vector<int64_t> order;
+  if (!sorted) {
+    order.resize(nnz);
+    std::vector<int64_t> next(row_starts.begin(), row_starts.end() - 1);
+    for (int64_t i = 0; i < nnz; ++i) {
+      order[next[rows[i]]++] = i;
+    }
+  }
 
-    for (std::size_t i = 0; i < nnz; ++i) {
-      const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
-      const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
-      if (!FastBoundsCheck(k, lhs_right)) {
-        return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
-      }
-      if (!FastBoundsCheck(m, out.dimension(0))) {
-        return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));
-      }
-      const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
-      for (std::size_t n = 0; n < rhs_right; ++n) {
-        const T b_value = maybe_adjoint_b(k, n);
-        out(m, n) += static_cast<Tsum>(a_value) * static_cast<Tsum>(b_value);
+  // Each nonzero reads a row of B (or of its adjoint), so an adjoint B is
+  // transposed and conjugated once up front.
+  const T* b_data = b.data();
+  Tensor b_adjoint;
+  if (ADJ_B) {
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(DataTypeToEnum<T>::value,
+                           TensorShape({lhs_right, rhs_right}), &b_adjoint));
+    Eigen::array<int, 2> shuffle{1, 0};
+    b_adjoint.matrix<T>().device(ctx->eigen_device<CPUDevice>()) =
+        b.shuffle(shuffle).conjugate();
+    b_data = b_adjoint.matrix<T>().data();
+  }
+  Eigen::Map<const Matrix> b_map(b_data, lhs_right, rhs_right);
+  Eigen::Map<SumMatrix> out_map(out.data(), out_rows, rhs_right);
+
+  auto compute_rows = [&](int64_t row_begin, int64_t row_end) {
+    for (int64_t m = row_begin; m < row_end; ++m) {
+      auto out_row = out_map.row(m);
+      for (int64_t j = row_starts[m]; j < row_starts[m + 1]; ++j) {
+        const int64_t i = sorted ? j : order[j];
+        const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
+        out_row.noalias() += b_map.row(cols[i]).template cast<Tsum>() *
+                             static_cast<Tsum>(a_value);
       }
     }
-  } else {
-    // Vectorization via Eigen.
-    const int b_chip_index = ADJ_B ? 1 : 0;
-
-#define LOOP_NNZ(b_passed)                                                  \
-  for (std::size_t i = 0; i < nnz; ++i) {                                   \
-    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a)); \
-    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a)); \
-    const T a_value = (ADJ_A) ? MaybeConj(a_values(i)) : a_values(i);       \
-    if (!FastBoundsCheck(k, lhs_right)) {                                   \
-      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);               \
-    }                                                                       \
-    if (!FastBoundsCheck(m, out.dimension(0))) {                            \
-      return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));        \
-    }                                                                       \
-    out.template chip<0>(m) +=                                              \
-        b_passed.template chip<b_chip_index>(k).template cast<Tsum>() *     \
-        static_cast<Tsum>(a_value);                                         \
+  };
+
+  // Shard the output rows so that each shard holds roughly the same number of
+  // nonzeros, where the first `m` rows cost `row_starts[m] + m`.
+  auto* worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  const int64_t total_cost = nnz + out_rows;
+  const int64_t num_shards = std::min(
+      {out_rows, kNumShardsPerThread * worker_threads->num_threads,
+       std::max<int64_t>(1, total_cost * rhs_right / kMinCostPerShard)});
+  if (num_shards <= 1) {
+    compute_rows(0, out_rows);
+    return absl::OkStatus();
   }
-
-    if (ADJ_B) {
-      // Perform transpose and conjugation on B once, since we chip out B's
-      // columns in the nnz loop.
-      Eigen::array<int, 2> shuffle{1, 0};  // preserve dimension order
-      Eigen::Tensor<T, 2, Eigen::ColMajor> col_major_conj_b =
-          b.swap_layout().shuffle(shuffle).conjugate();
-      LOOP_NNZ(col_major_conj_b);
-    } else {
-      LOOP_NNZ(b);
+  std::vector<int64_t> shard_begins(num_shards + 1, out_rows);
+  shard_begins[0] = 0;
+  for (int64_t shard = 1; shard < num_shards; ++shard) {
+    const int64_t target_cost = total_cost * shard / num_shards;
+    int64_t low = shard_begins[shard - 1];
+    int64_t high = out_rows;
+    while (low < high) {
+      const int64_t mid = low + (high - low) / 2;
+      if (row_starts[mid] + mid < target_cost) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
     }
-#undef LOOP_NNZ
+    shard_begins[shard] = low;
   }
+  worker_threads->workers->ParallelFor(
+      num_shards,
+      thread::ThreadPool::SchedulingParams(
+          thread::ThreadPool::SchedulingStrategy::kFixedBlockSize,
+          absl::nullopt /* cost_per_unit */, 1 /* block_size */),
+      [&](int64_t shard_begin, int64_t shard_end) {
+        for (int64_t shard = shard_begin; shard < shard_end; ++shard) {
+          compute_rows(shard_begins[shard], shard_begins[shard + 1]);
+        }
+      });
   return absl::OkStatus();
 }
 }  // namespace
@@ -340,7 +399,7 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
       temp_out.setZero();
       TF_RETURN_IF_ERROR(
           SparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A, ADJ_B>(
-              temp_out, a_indices, a_values, b));
+              ctx, temp_out, a_indices, a_values, b));
       out = temp_out.template cast<T>();
     } else {
       out.setZero();
@@ -350,7 +409,7 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
           *reinterpret_cast<typename TTypes<Tsum>::Matrix*>(&out);
       TF_RETURN_IF_ERROR(
           SparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A, ADJ_B>(
-              out_workaround, a_indices, a_values, b));
+              ctx, out_workaround, a_indices, a_values, b));
     }
     return absl::OkStatus();
   }
@@ -0,0 +1,113 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_STRING_FINGERPRINT_H_
+#define TENSORFLOW_CORE_KERNELS_STRING_FINGERPRINT_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "absl/base/prefetch.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace string_fingerprint_internal {
+
+// Strings are hashed in groups of this many. The descriptors of a group are
+// loaded before any of them is hashed, so the hashes of a group are independent
+// and the CPU can overlap them.
+constexpr int64_t kGroupSize = 4;
+
+// Out-of-line string data is prefetched this many strings ahead.
+constexpr int64_t kPrefetchDistance = 2 * kGroupSize;
+
+// Returns a rough per-string cost for sharding, estimated from the lengths of
+// a few strings spread over `input`.
+inline int64_t EstimateCostPerString(TTypes<tstring>::ConstFlat input) {
+  constexpr int64_t kNumSamples = 16;
+  const int64_t size = input.size();
+  const int64_t num_samples = std::min(size, kNumSamples);
+  int64_t total_length = 0;
+  for (int64_t i = 0; i < num_samples; ++i) {
+    total_length += input(i * size / num_samples).size();
+  }
+  // Fingerprint64 and similar hashes take roughly a cycle per byte plus a
+  // fixed overhead.
+  return 50 + (num_samples > 0 ? total_length / num_samples : 0);
+}
+
+inline void PrefetchStringData(const tstring& str) {
+  // Small strings are stored inline in the tstring itself, which is already
+  // being read, so only the other representations need their data prefetched.
+  if (str.type() != tstring::SMALL) {
+    absl::PrefetchToLocalCache(str.data());
+  }
+}
+
+}  // namespace string_fingerprint_internal
+
+// Computes `hash` of every string of `input` and calls `emit(i, hash)` with
+// the hash of `input(i)`. The work is sharded over the intra-op threads of
+// `context`; `emit` is called concurrently for different indices.
+template <uint64 hash(StringPiece), typename Emit>
+void BatchHashStrings(OpKernelContext* context,
+                      TTypes<tstring>::ConstFlat input, const Emit& emit) {
+  using string_fingerprint_internal::kGroupSize;
+  using string_fingerprint_internal::kPrefetchDistance;
+  using string_fingerprint_internal::PrefetchStringData;
+
+  auto work = [&input, &emit](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < std::min(end, begin + kPrefetchDistance);
+         ++i) {
+      PrefetchStringData(input(i));
+    }
+    int64_t i = begin;
+    for (; i + kGroupSize <= end; i += kGroupSize) {
+      absl::string_view group[kGroupSize];
+      for (int64_t j = 0; j < kGroupSize; ++j) {
+        group[j] = input(i + j);
+      }
+      for (int64_t j = i + kPrefetchDistance;
+           j < std::min(end, i + kPrefetchDistance + kGroupSize); ++j) {
+        PrefetchStringData(input(j));
+      }
+      uint64 hashes[kGroupSize];
+      for (int64_t j = 0; j < kGroupSize; ++j) {
+        hashes[j] = hash(group[j]);
+      }
+      for (int64_t j = 0; j < kGroupSize; ++j) {
+        emit(i + j, hashes[j]);
+      }
+    }
+    for (; i < end; ++i) {
+      emit(i, hash(input(i)));
+    }
+  };
+
+  const auto& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, input.size(),
+        string_fingerprint_internal::EstimateCostPerString(input), work);
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_STRING_FINGERPRINT_H_
@@ -0,0 +1,250 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_STRIPED_HASH_MAP_H_
+#define TENSORFLOW_CORE_KERNELS_STRIPED_HASH_MAP_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/hash/hash.h"
+#include "tensorflow/core/framework/bounds_check.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// A hash map split into shards that each have their own lock, so that threads
+// reading or writing different keys rarely wait for one another.
+//
+// Batch operations group their keys by shard and then take each lock once.
+// Each shard grows on its own, under its own lock, so that a resize only
+// stalls the operations on that shard.
+template <typename K, typename V>
+class StripedHashMap {
+ public:
+  static constexpr int kShardBits = 4;
+  static constexpr int kNumShards = 1 << kShardBits;
+  // Batches with fewer keys are not grouped by shard.
+  static constexpr int64_t kMinGroupedBatchSize = 16;
+  // Batches with fewer keys are grouped without allocating memory.
+  static constexpr int64_t kInlinedBatchSize = 128;
+
+  size_t size() const {
+    size_t size = 0;
+    for (const Shard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      size += shard.map.size();
+    }
+    return size;
+  }
+
+  // Calls `found(i, value)` for every i in [0, num_keys), where `value` points
+  // to the value of `keys[i]` or is null if the key is absent. The calls for
+  // the keys of a shard are made in order, while holding its lock for reading.
+  template <typename Callback>
+  void FindBatch(const K* keys, int64_t num_keys, Callback&& found) const {
+    ForEachKey<tf_shared_lock>(
+        shards_, keys, num_keys, [&](const Shard& shard, int64_t i) {
+          const auto it = shard.map.find(KeyAt(keys, i));
+          found(i, it == shard.map.end() ? nullptr : &it->second);
+        });
+  }
+
+  // Sets the value of `keys[i]`, for every i in [0, num_keys), by calling
+  // `assign(i, &value)` on the existing or newly inserted value. If a key
+  // occurs several times, its last value is kept.
+  template <typename Callback>
+  void InsertBatch(const K* keys, int64_t num_keys, Callback&& assign) {
+    ForEachKey<mutex_lock>(shards_, keys, num_keys,
+                           [&](Shard& shard, int64_t i) {
+                             assign(i, &shard.map[KeyAt(keys, i)]);
+                           });
+  }
+
+  // Removes `keys[i]`, for every i in [0, num_keys), if present.
+  void EraseBatch(const K* keys, int64_t num_keys) {
+    ForEachKey<mutex_lock>(
+        shards_, keys, num_keys,
+        [&](Shard& shard, int64_t i) { shard.map.erase(KeyAt(keys, i)); });
+  }
+
+  // Replaces all the entries with those that `InsertBatch()` would insert.
+  // All the shards are locked meanwhile, so that no other thread sees a mix of
+  // the old and new entries.
+  template <typename Callback>
+  void ReplaceAll(const K* keys, int64_t num_keys, Callback&& assign)
+      TF_NO_THREAD_SAFETY_ANALYSIS {
+    ShardPositions positions(keys, num_keys);
+    LockAll();
+    for (int s = 0; s < kNumShards; ++s) {
+      Shard& shard = shards_[s];
+      absl::flat_hash_map<K, V>().swap(shard.map);
+      for (int64_t i : positions.shard(s)) {
+        assign(i, &shard.map[KeyAt(keys, i)]);
+      }
+    }
+    UnlockAll();
+  }
+
+  // Calls `start(size)` with the number of entries and, if it succeeds,
+  // `visit(key, value)` for every entry, while holding all the locks for
+  // reading so that the entries are a consistent snapshot. Returns the status
+  // of `start`.
+  template <typename Start, typename Visit>
+  Status Snapshot(Start&& start, Visit&& visit) const
+      TF_NO_THREAD_SAFETY_ANALYSIS {
+    ReaderLockAll();
+    size_t size = 0;
+    for (const Shard& shard : shards_) size += shard.map.size();
+    Status status = start(size);
+    if (status.ok()) {
+      for (const Shard& shard : shards_) {
+        for (const auto& entry : shard.map) visit(entry.first, entry.second);
+      }
+    }
+    ReaderUnlockAll();
+    return status;
+  }
+
+  // Returns the number of bytes that the shards allocated, not counting memory
+  // that the keys and values point to.
+  int64_t MemoryUsed() const {
+    int64_t bytes = 0;
+    for (const Shard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      // Swiss tables have one control byte per slot.
+      bytes += shard.map.capacity() *
+               (sizeof(typename absl::flat_hash_map<K, V>::value_type) + 1);
+    }
+    return bytes;
+  }
+
+ private:
+  // Padded to a cache line, so that locking one shard does not slow down the
+  // threads that use the next one.
+  struct alignas(64) Shard {
+    mutable mutex mu;
+    absl::flat_hash_map<K, V> map TF_GUARDED_BY(mu);
+  };
+
+  // The positions of a batch of keys, stably sorted by shard.
+  class ShardPositions {
+   public:
+    // A range of positions.
+    struct Range {
+      const int64_t* begin() const { return begin_; }
+      const int64_t* end() const { return end_; }
+      const int64_t* begin_;
+      const int64_t* end_;
+    };
+
+    ShardPositions(const K* keys, int64_t num_keys) : positions_(num_keys) {
+      absl::InlinedVector<uint8_t, kInlinedBatchSize> shards(num_keys);
+      std::array<int64_t, kNumShards> counts{};
+      for (int64_t i = 0; i < num_keys; ++i) {
+        shards[i] = ShardOf(KeyAt(keys, i));
+        ++counts[shards[i]];
+      }
+      starts_[0] = 0;
+      for (int s = 0; s < kNumShards; ++s) {
+        starts_[s + 1] = starts_[s] + counts[s];
+      }
+      std::array<int64_t, kNumShards> next;
+      std::copy(starts_.begin(), starts_.end() - 1, next.begin());
+      for (int64_t i = 0; i < num_keys; ++i) positions_[next[shards[i]]++] = i;
+    }
+
+    bool empty(int s) const { return starts_[s] == starts_[s + 1]; }
+
+    Range shard(int s) const {
+      return {positions_.data() + starts_[s],
+              positions_.data() + starts_[s + 1]};
+    }
+
+   private:
+    absl::InlinedVector<int64_t, kInlinedBatchSize> positions_;
+    std::array<int64_t, kNumShards + 1> starts_;
+  };
+
+  // Copies integral keys, which may be in a tensor that another op writes
+  // meanwhile, as `SubtleMustCopyIfIntegral()` does.
+  static std::conditional_t<std::is_integral_v<K>, K, const K&> KeyAt(
+      const K* keys, int64_t i) {
+    if constexpr (std::is_integral_v<K>) {
+      return internal::SubtleMustCopy(keys[i]);
+    } else {
+      return keys[i];
+    }
+  }
+
+  // Uses the top bits of the hash, which the maps barely use to place their
+  // entries.
+  static int ShardOf(const K& key) {
+    return absl::Hash<K>()(key) >> (64 - kShardBits);
+  }
+
+  // Calls `fn(shard, i)` for every i in [0, num_keys), where `shard` is the
+  // shard of `keys[i]` and is locked with a `Lock`. The calls for the keys of
+  // a shard are made in order. Small batches take a lock per key, to save the
+  // grouping, and larger ones a lock per shard.
+  template <typename Lock, typename Shards, typename Callback>
+  static void ForEachKey(Shards& shards, const K* keys, int64_t num_keys,
+                         Callback&& fn) TF_NO_THREAD_SAFETY_ANALYSIS {
+    if (num_keys < kMinGroupedBatchSize) {
+      for (int64_t i = 0; i < num_keys; ++i) {
+        auto& shard = shards[ShardOf(KeyAt(keys, i))];
+        Lock l(shard.mu);
+        fn(shard, i);
+      }
+      return;
+    }
+    ShardPositions positions(keys, num_keys);
+    for (int s = 0; s < kNumShards; ++s) {
+      if (positions.empty(s)) continue;
+      auto& shard = shards[s];
+      Lock l(shard.mu);
+      for (int64_t i : positions.shard(s)) fn(shard, i);
+    }
+  }
+
+  // The locks are always taken in the order of the shards, so that threads
+  // taking several of them do not deadlock.
+  void LockAll() TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (Shard& shard : shards_) shard.mu.lock();
+  }
+  void UnlockAll() TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (Shard& shard : shards_) shard.mu.unlock();
+  }
+  void ReaderLockAll() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (const Shard& shard : shards_) shard.mu.lock_shared();
+  }
+  void ReaderUnlockAll() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (const Shard& shard : shards_) shard.mu.unlock_shared();
+  }
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_STRIPED_HASH_MAP_H_
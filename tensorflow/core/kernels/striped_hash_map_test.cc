@@ -0,0 +1,169 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/striped_hash_map.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+template <typename K, typename V>
+void Insert(StripedHashMap<K, V>* map, const std::vector<K>& keys,
+            const std::vector<V>& values) {
+  map->InsertBatch(keys.data(), keys.size(),
+                   [&](int64_t i, V* value) { *value = values[i]; });
+}
+
+// Returns the values of `keys`, or -1 for the absent ones.
+template <typename K>
+std::vector<int64_t> Find(const StripedHashMap<K, int64_t>& map,
+                          const std::vector<K>& keys) {
+  std::vector<int64_t> values(keys.size(), -2);
+  map.FindBatch(keys.data(), keys.size(), [&](int64_t i, const int64_t* v) {
+    values[i] = v == nullptr ? -1 : *v;
+  });
+  return values;
+}
+
+template <typename K>
+std::map<K, int64_t> Entries(const StripedHashMap<K, int64_t>& map) {
+  std::map<K, int64_t> entries;
+  TF_CHECK_OK(map.Snapshot(
+      [&](size_t size) {
+        EXPECT_EQ(size, map.size());
+        return absl::OkStatus();
+      },
+      [&](const K& key, int64_t value) { entries[key] = value; }));
+  return entries;
+}
+
+TEST(StripedHashMapTest, InsertFindErase) {
+  StripedHashMap<tstring, int64_t> map;
+  std::vector<tstring> keys;
+  std::vector<int64_t> values;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(strings::StrCat("key", i));
+    values.push_back(i);
+  }
+  Insert(&map, keys, values);
+  EXPECT_EQ(map.size(), 1000);
+  EXPECT_EQ(Find<tstring>(map, keys), values);
+  EXPECT_EQ(Find<tstring>(map, {"key7", "missing", "key999"}),
+            std::vector<int64_t>({7, -1, 999}));
+
+  map.EraseBatch(keys.data(), 500);
+  EXPECT_EQ(map.size(), 500);
+  EXPECT_EQ(Find<tstring>(map, {"key7", "key500", "key499"}),
+            std::vector<int64_t>({-1, 500, -1}));
+}
+
+TEST(StripedHashMapTest, KeepsLastDuplicate) {
+  StripedHashMap<int64_t, int64_t> map;
+  Insert<int64_t, int64_t>(&map, {1, 2, 1, 3, 1}, {10, 20, 30, 40, 50});
+  EXPECT_EQ(Entries(map),
+            (std::map<int64_t, int64_t>({{1, 50}, {2, 20}, {3, 40}})));
+}
+
+TEST(StripedHashMapTest, ReplaceAll) {
+  StripedHashMap<int64_t, int64_t> map;
+  Insert<int64_t, int64_t>(&map, {1, 2, 3}, {10, 20, 30});
+  const std::vector<int64_t> keys = {3, 4};
+  map.ReplaceAll(keys.data(), keys.size(),
+                 [](int64_t i, int64_t* value) { *value = 100 + i; });
+  EXPECT_EQ(Entries(map), (std::map<int64_t, int64_t>({{3, 100}, {4, 101}})));
+}
+
+TEST(StripedHashMapTest, SnapshotStopsOnError) {
+  StripedHashMap<int64_t, int64_t> map;
+  Insert<int64_t, int64_t>(&map, {1, 2, 3}, {10, 20, 30});
+  int visited = 0;
+  Status status = map.Snapshot(
+      [](size_t size) { return errors::ResourceExhausted("size ", size); },
+      [&](int64_t key, int64_t value) { ++visited; });
+  EXPECT_TRUE(errors::IsResourceExhausted(status)) << status;
+  EXPECT_EQ(visited, 0);
+}
+
+TEST(StripedHashMapTest, ConcurrentInsertAndFind) {
+  StripedHashMap<int64_t, int64_t> map;
+  constexpr int kNumThreads = 8;
+  constexpr int kKeysPerThread = 10000;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&map, t]() {
+        std::vector<int64_t> keys;
+        for (int64_t i = 0; i < kKeysPerThread; ++i) {
+          keys.push_back(i * kNumThreads + t);
+        }
+        for (int64_t begin = 0; begin < kKeysPerThread; begin += 100) {
+          map.InsertBatch(keys.data() + begin, 100,
+                          [&](int64_t i, int64_t* value) {
+                            *value = 2 * keys[begin + i];
+                          });
+          // Every key inserted so far by this thread is found.
+          map.FindBatch(keys.data(), begin + 100,
+                        [&](int64_t i, const int64_t* value) {
+                          ASSERT_NE(value, nullptr);
+                          EXPECT_EQ(*value, 2 * keys[i]);
+                        });
+        }
+      });
+    }
+  }
+  const std::map<int64_t, int64_t> entries = Entries(map);
+  EXPECT_EQ(entries.size(), kNumThreads * kKeysPerThread);
+  for (const auto& entry : entries) EXPECT_EQ(entry.second, 2 * entry.first);
+}
+
+// Looks up batches of `state.range(0)` keys in a table of 1M int64 keys, in
+// all the benchmark threads at once.
+void BM_FindBatch(::testing::benchmark::State& state) {
+  static StripedHashMap<int64_t, int64_t>* map = []() {
+    auto* map = new StripedHashMap<int64_t, int64_t>();
+    std::vector<int64_t> keys(1 << 20);
+    for (int64_t i = 0; i < keys.size(); ++i) keys[i] = i * 7919;
+    map->InsertBatch(keys.data(), keys.size(),
+                     [](int64_t i, int64_t* value) { *value = i; });
+    return map;
+  }();
+  const int64_t batch_size = state.range(0);
+  std::vector<int64_t> keys(batch_size);
+  for (int64_t i = 0; i < batch_size; ++i) {
+    keys[i] = (i * 104729 + state.thread_index() * 31) % (1 << 20) * 7919;
+  }
+  std::vector<int64_t> values(batch_size);
+  for (auto s : state) {
+    map->FindBatch(keys.data(), batch_size,
+                   [&](int64_t i, const int64_t* v) { values[i] = *v; });
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_FindBatch)->Arg(1)->Arg(1024)->ThreadRange(1, 8);
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <limits>
+
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
@@ -23,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/summary/schema.h"
 #include "tensorflow/core/summary/summary_db_writer.h"
 #include "tensorflow/core/summary/summary_file_writer.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/event.pb.h"
 
 namespace tensorflow {
@@ -33,7 +37,18 @@ REGISTER_KERNEL_BUILDER(Name("SummaryWriter").Device(DEVICE_CPU),
 class CreateSummaryFileWriterOp : public OpKernel {
  public:
   explicit CreateSummaryFileWriterOp(OpKernelConstruction* ctx)
-      : OpKernel(ctx) {}
+      : OpKernel(ctx) {
+    // By default, writing more than `max_queue` events blocks the step until
+    // they have been flushed. These let the events be buffered further or be
+    // dropped instead, e.g. when writing to slow remote file systems.
+    OP_REQUIRES_OK(ctx, ReadInt64FromEnvVar("TF_SUMMARY_MAX_PENDING_EVENTS",
+                                            /*default_val=*/0,
+                                            &max_pending_events_));
+    OP_REQUIRES_OK(ctx,
+                   ReadBoolFromEnvVar("TF_SUMMARY_DROP_EVENTS_WHEN_FULL",
+                                      /*default_val=*/false,
+                                      &drop_events_when_full_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
     const Tensor* tmp;
@@ -54,16 +69,26 @@ class CreateSummaryFileWriterOp : public OpKernel {
                 errors::InvalidArgument("filename_suffix must be a scalar"));
     const string filename_suffix = tmp->scalar<tstring>()();
 
+    SummaryFileWriterOptions options;
+    options.max_queue = max_queue;
+    options.flush_millis = flush_millis;
+    options.max_pending_events = static_cast<int>(
+        std::min<int64_t>(max_pending_events_, std::numeric_limits<int>::max()));
+    options.drop_events_when_full = drop_events_when_full_;
     core::RefCountPtr<SummaryWriterInterface> s;
     OP_REQUIRES_OK(ctx, LookupOrCreateResource<SummaryWriterInterface>(
                             ctx, HandleFromInput(ctx, 0), &s,
-                            [max_queue, flush_millis, logdir, filename_suffix,
+                            [options, logdir, filename_suffix,
                              ctx](SummaryWriterInterface** s) {
                               return CreateSummaryFileWriter(
-                                  max_queue, flush_millis, logdir,
-                                  filename_suffix, ctx->env(), s);
+                                  options, logdir, filename_suffix, ctx->env(),
+                                  s);
                             }));
   }
+
+ private:
+  int64_t max_pending_events_;
+  bool drop_events_when_full_;
 };
 REGISTER_KERNEL_BUILDER(Name("CreateSummaryFileWriter").Device(DEVICE_CPU),
                         CreateSummaryFileWriterOp);
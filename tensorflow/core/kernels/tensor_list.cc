@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/tensor_list.h"
 
+#include <cstring>
+
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
@@ -25,6 +27,49 @@ TensorList::~TensorList() {
   if (tensors_) tensors_->Unref();
 }
 
+void TensorList::set_buffer(Tensor buffer) {
+  DCHECK_EQ(buffer.dim_size(0), tensors().size());
+  tensors_->written_.assign(buffer.dim_size(0), false);
+  tensors_->buffer_ = std::move(buffer);
+}
+
+bool TensorList::SetElementInBuffer(int64_t index, const Tensor& value) {
+  const Tensor& buffer = tensors_->buffer_;
+  if (!buffer.IsInitialized() || buffer.dim_size(0) != tensors().size() ||
+      index < 0 || index >= tensors().size() || tensors_->written_[index] ||
+      tensors()[index].dtype() != DT_INVALID ||
+      value.dtype() != buffer.dtype()) {
+    return false;
+  }
+  Tensor slot = buffer.SubSlice(index);
+  if (slot.shape() != value.shape()) return false;
+  const StringPiece data = value.tensor_data();
+  std::memcpy(const_cast<char*>(slot.tensor_data().data()), data.data(),
+              data.size());
+  tensors_->written_[index] = true;
+  tensors()[index] = std::move(slot);
+  return true;
+}
+
+bool TensorList::GetStackedElements(Tensor* stacked) const {
+  const Tensor& buffer = tensors_->buffer_;
+  if (!buffer.IsInitialized() || buffer.dim_size(0) != tensors().size()) {
+    return false;
+  }
+  const char* const base = buffer.tensor_data().data();
+  const size_t slot_size =
+      tensors().empty() ? 0 : buffer.TotalBytes() / tensors().size();
+  for (size_t i = 0; i < tensors().size(); ++i) {
+    const Tensor& t = tensors()[i];
+    if (t.dtype() != buffer.dtype() || t.TotalBytes() != slot_size ||
+        t.tensor_data().data() != base + i * slot_size) {
+      return false;
+    }
+  }
+  *stacked = buffer;
+  return true;
+}
+
 void TensorList::Encode(VariantTensorData* data) const {
   data->set_type_name(TypeName());
   std::vector<size_t> invalid_indices;
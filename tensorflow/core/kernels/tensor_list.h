@@ -15,7 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_TENSOR_LIST_H_
 #define TENSORFLOW_CORE_KERNELS_TENSOR_LIST_H_
 
+#include <cstdint>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/variant.h"
@@ -141,10 +143,43 @@ class TensorList {
   // container?
   bool RefCountIsOne() const { return tensors_->RefCountIsOne(); }
 
+  // A list made by TensorListReserve may keep its elements in a single
+  // contiguous buffer, so that stacking them needs no copy. The buffer holds
+  // one element per entry of `tensors()` when it is allocated, and each of its
+  // slots is written at most once: an element set into an unset slot becomes
+  // a view of that slot, and any other element is stored as usual. Copies
+  // made by `Copy()` do not share the buffer, so the views of a slot always
+  // see the same data.
+
+  // Lets `SetElementInBuffer()` use a buffer, once `set_buffer()` gives one.
+  void AllowBuffer() { tensors_->buffer_allowed_ = true; }
+  bool buffer_allowed() const { return tensors_->buffer_allowed_; }
+
+  // The buffer, or null if none was given.
+  const Tensor* buffer() const {
+    return tensors_->buffer_.IsInitialized() ? &tensors_->buffer_ : nullptr;
+  }
+  // Gives the list a buffer, whose first dimension must be the number of
+  // elements.
+  void set_buffer(Tensor buffer);
+
+  // Sets element `index`, if it is unset and its slot in the buffer was never
+  // written, to a view of that slot holding a copy of `value`, which must have
+  // the element shape and dtype of the buffer. Returns whether it did.
+  bool SetElementInBuffer(int64_t index, const Tensor& value);
+
+  // Sets `*stacked` to the buffer and returns true if every element is the
+  // view of its slot, so that the buffer is the stack of the elements.
+  bool GetStackedElements(Tensor* stacked) const;
+
  private:
   class Tensors : public core::RefCounted {
    public:
     std::vector<Tensor> values_;
+    bool buffer_allowed_ = false;
+    Tensor buffer_;
+    // Whether each slot of `buffer_` was written.
+    std::vector<bool> written_;
   };
   Tensors* tensors_;
 };
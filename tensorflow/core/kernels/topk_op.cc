@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/topk_op.h"
 
 #include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <vector>
 
@@ -29,7 +30,6 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
-#include "tensorflow/core/lib/gtl/top_n.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -128,6 +128,83 @@ class TopK : public OpKernel {
 };
 
 namespace functor {
+namespace {
+
+// An entry of a row of the input: its value and its column.
+template <typename T, typename Tidx>
+struct TopKEntry {
+  T value;
+  Tidx index;
+};
+
+// Orders entries as TopK returns them: by decreasing value, and then by
+// increasing index.
+template <typename T, typename Tidx>
+bool TopKBefore(const TopKEntry<T, Tidx>& a, const TopKEntry<T, Tidx>& b) {
+  if (b.value < a.value) return true;
+  if (a.value < b.value) return false;
+  return a.index < b.index;
+}
+
+// Replaces the front of `heap`, a heap ordered by TopKBefore whose front is
+// its last entry, with `entry`, which must come before it.
+template <typename T, typename Tidx>
+void ReplaceLast(const TopKEntry<T, Tidx>& entry,
+                 std::vector<TopKEntry<T, Tidx>>* heap) {
+  TopKEntry<T, Tidx>* data = heap->data();
+  const size_t size = heap->size();
+  size_t i = 0;
+  while (true) {
+    size_t child = 2 * i + 1;
+    if (child >= size) break;
+    if (child + 1 < size && TopKBefore(data[child], data[child + 1])) ++child;
+    if (!TopKBefore(entry, data[child])) break;
+    data[i] = data[child];
+    i = child;
+  }
+  data[i] = entry;
+}
+
+// Number of columns compared against the threshold at once, in a loop that
+// the compiler vectorizes.
+constexpr int kTopKBlockSize = 16;
+
+// Rows are only split into column blocks of at least this many columns.
+constexpr int64_t kTopKMinBlockCols = 1 << 15;
+
+// Replaces the contents of `heap` with the top `k` entries of columns
+// [begin, end) of `row`, as a heap ordered by TopKBefore. Requires
+// k <= end - begin.
+template <typename T, typename Tidx>
+void SelectTopK(const T* row, int64_t begin, int64_t end, int k,
+                std::vector<TopKEntry<T, Tidx>>* heap) {
+  heap->clear();
+  int64_t c = begin;
+  for (; c < begin + k; ++c) heap->push_back({row[c], static_cast<Tidx>(c)});
+  std::make_heap(heap->begin(), heap->end(), TopKBefore<T, Tidx>);
+  // Later columns lose ties, so only a column whose value is greater than
+  // that of the last entry can enter. Testing for !(value <= threshold) also
+  // lets NaNs through, to be ordered by TopKBefore like any other value.
+  T threshold = heap->front().value;
+  const auto consider = [&](int64_t c) {
+    const TopKEntry<T, Tidx> entry{row[c], static_cast<Tidx>(c)};
+    if (TopKBefore(entry, heap->front())) {
+      ReplaceLast(entry, heap);
+      threshold = heap->front().value;
+    }
+  };
+  for (; c + kTopKBlockSize <= end; c += kTopKBlockSize) {
+    int any = 0;
+    for (int i = 0; i < kTopKBlockSize; ++i) {
+      any |= !(row[c + i] <= threshold);
+    }
+    if (!any) continue;
+    for (int i = 0; i < kTopKBlockSize; ++i) consider(c + i);
+  }
+  for (; c < end; ++c) consider(c);
+}
+
+}  // namespace
 
 template <typename T, typename Tidx>
 struct TopKFunctor<CPUDevice, T, Tidx> {
@@ -161,28 +238,23 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
       return absl::OkStatus();
     }
 
-    auto SortIndices = [&](int64_t start_batch, int64_t limit_batch) {
-      for (int32_t b = start_batch; b < limit_batch; ++b) {
-        const T* input_data = &input(b, 0);
-        const auto stable_comp = [input_data](const int32_t a,
-                                              const int32_t b) {
-          if (input_data[b] < input_data[a]) {
-            return true;
-          } else if (input_data[b] > input_data[a]) {
-            return false;
-          } else {
-            return a < b;
-          }
-        };
-        const auto comp = [input_data](const int32_t a, const int32_t b) {
-          return input_data[b] < input_data[a];
-        };
-        // TODO(ebrevdo): For large k < num_cols, instead of using
-        // TopN, it may be faster to create a temporary vector of
-        // values 0..num_cols - 1 and then use std::partial_sort_copy
-        // of this into indices. Choosing the appropriate minimum k or
-        // ratio of k/num_cols will require some experimentation.
-        if (k == num_cols) {
+    const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<Tidx>() +
+                            Eigen::TensorOpCost::AddCost<T>();
+    const double copy_cost = 2 * k * Eigen::TensorOpCost::AddCost<T>();
+    const auto clamp_cost = [](double cost) {
+      return cost >= static_cast<double>(kint64max)
+                 ? kint64max
+                 : static_cast<int64_t>(cost);
+    };
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    if (k == num_cols) {
+      auto SortIndices = [&](int64_t start_batch, int64_t limit_batch) {
+        for (int32_t b = start_batch; b < limit_batch; ++b) {
+          const T* input_data = &input(b, 0);
+          const auto comp = [input_data](const int32_t a, const int32_t b) {
+            return input_data[b] < input_data[a];
+          };
           auto* begin = &indices(b, 0);
           auto* end = &indices(b, k);
           // Set the initial array of indices 0 ... k - 1.
@@ -204,52 +276,104 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
             }
             run_begin = run_end;
           }
-        } else {
-          // Use the TopN heap object to sort.
-          gtl::TopN<Tidx, decltype(stable_comp)> filter(k, stable_comp);
-          filter.reserve(num_cols);
-          for (Tidx c = 0; c < num_cols; ++c) {
-            filter.push(c);
-          }
+          // Now that the indices are sorted, copy the values over in
+          // sorted order.
+          std::transform(
+              &indices(b, 0), &indices(b, k), &values(b, 0),
+              [b, &input](const Tidx loc) { return input(b, loc); });
+        }  // for (Tidx b = ...
+      };
+      // Guesstimate of cost; N*log(N + 1) where N == num_cols.
+      const double sort_cost =
+          cmp_cost *
+          static_cast<double>(num_cols *
+                              Eigen::numext::log2(static_cast<float>(k + 1)));
+      Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+            clamp_cost(sort_cost + copy_cost), SortIndices);
+      return absl::OkStatus();
+    }
+
+    // Otherwise each row is scanned for its top k with a bounded heap, which
+    // only the entries above its current threshold need to enter. Rows that
+    // are large but too few to keep the workers busy are split into column
+    // blocks, whose top k are merged afterwards.
+    int64_t num_blocks = 1;
+    if (num_rows < worker_threads.num_threads &&
+        num_cols >= 2 * kTopKMinBlockCols) {
+      const int64_t max_blocks =
+          num_cols / std::max<int64_t>(kTopKMinBlockCols, 8 * k);
+      num_blocks = std::min<int64_t>(
+          max_blocks, (worker_threads.num_threads + num_rows - 1) / num_rows);
+      num_blocks = std::max<int64_t>(num_blocks, 1);
+    }
+    const int64_t block_cols = (num_cols + num_blocks - 1) / num_blocks;
+
+    // Guesstimate of cost; N comparisons against the threshold, and roughly
+    // K*(1 + ln(N/K)) heap insertions of log(K) comparisons each, where N is
+    // the number of columns scanned.
+    const auto select_cost = [&](int64_t n) {
+      const double insertions =
+          k * (1 + std::log(static_cast<double>(n) / k));
+      return n * Eigen::TensorOpCost::AddCost<T>() +
+             cmp_cost * insertions *
+                 Eigen::numext::log2(static_cast<float>(k + 1));
+    };
 
-          int32_t i = 0;
+    if (num_blocks == 1) {
+      auto SelectRows = [&](int64_t start_batch, int64_t limit_batch) {
+        std::vector<TopKEntry<T, Tidx>> heap;
+        for (int64_t b = start_batch; b < limit_batch; ++b) {
+          SelectTopK(&input(b, 0), 0, num_cols, k, &heap);
           if (sorted) {
-            std::unique_ptr<std::vector<Tidx>> top_k(filter.Extract());
-            for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
-                 ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
-          } else {
-            for (auto top_k_it = filter.unsorted_begin();
-                 top_k_it != filter.unsorted_end(); ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
+            std::sort_heap(heap.begin(), heap.end(), TopKBefore<T, Tidx>);
+          }
+          for (int i = 0; i < k; ++i) {
+            values(b, i) = heap[i].value;
+            indices(b, i) = heap[i].index;
           }
         }
-        // Now that the indices are sorted, copy the values over in
-        // sorted order.
-        std::transform(&indices(b, 0), &indices(b, k), &values(b, 0),
-                       [b, &input](const Tidx loc) { return input(b, loc); });
-      }  // for (Tidx b = ...
-    };
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+            clamp_cost(select_cost(num_cols) + copy_cost), SelectRows);
+      return absl::OkStatus();
+    }
 
-    // Guesstimate of cost; 4*N*log(K) where N == num_cols.
-    // If K == N, assume the cost is N*log(K + 1).
-    const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<Tidx>() +
-                            Eigen::TensorOpCost::AddCost<T>();
-    const double base_cost =
-        cmp_cost *
-        static_cast<double>(num_cols *
-                            Eigen::numext::log2(static_cast<float>(k + 1)));
-    const double sort_cost = (k == num_cols) ? base_cost : 4 * base_cost;
-    const double copy_cost = 2 * k * Eigen::TensorOpCost::AddCost<T>();
-    const double total_cost = sort_cost + copy_cost;
-    const int64_t final_cost = (total_cost >= static_cast<double>(kint64max))
-                                   ? kint64max
-                                   : static_cast<int64_t>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    // Every block has at least k columns, so its top k are all candidates.
+    std::vector<TopKEntry<T, Tidx>> candidates(num_rows * num_blocks * k);
+    auto SelectBlocks = [&](int64_t start_block, int64_t limit_block) {
+      std::vector<TopKEntry<T, Tidx>> heap;
+      for (int64_t block = start_block; block < limit_block; ++block) {
+        const int64_t b = block / num_blocks;
+        const int64_t begin = (block % num_blocks) * block_cols;
+        const int64_t end = std::min(begin + block_cols, num_cols);
+        SelectTopK(&input(b, 0), begin, end, k, &heap);
+        std::copy(heap.begin(), heap.end(), candidates.begin() + block * k);
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_rows * num_blocks, clamp_cost(select_cost(block_cols)),
+          SelectBlocks);
+
+    auto MergeBlocks = [&](int64_t start_batch, int64_t limit_batch) {
+      for (int64_t b = start_batch; b < limit_batch; ++b) {
+        auto begin = candidates.begin() + b * num_blocks * k;
+        auto end = begin + num_blocks * k;
+        if (sorted) {
+          std::partial_sort(begin, begin + k, end, TopKBefore<T, Tidx>);
+        } else {
+          std::nth_element(begin, begin + k - 1, end, TopKBefore<T, Tidx>);
+        }
+        for (int i = 0; i < k; ++i) {
+          values(b, i) = begin[i].value;
+          indices(b, i) = begin[i].index;
+        }
+      }
+    };
+    const double merge_cost =
+        cmp_cost * num_blocks * k *
+        Eigen::numext::log2(static_cast<float>(k + 1));
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
-          final_cost, SortIndices);
+          clamp_cost(merge_cost + copy_cost), MergeBlocks);
 
     return absl::OkStatus();
   }
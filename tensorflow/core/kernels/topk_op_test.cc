@@ -0,0 +1,146 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class TopKOpTest : public OpsTestBase {
+ protected:
+  // Runs TopKV2 on `num_rows` rows of `num_cols` values each, and checks
+  // the result against a stable sort of each row.
+  void RunAndCheck(int num_rows, int num_cols, int k, bool sorted,
+                   const std::vector<float>& input) {
+    TF_ASSERT_OK(NodeDefBuilder("top_k", "TopKV2")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("sorted", sorted)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInputFromArray<float>(TensorShape({num_rows, num_cols}), input);
+    AddInputFromArray<int32>(TensorShape({}), {k});
+    TF_ASSERT_OK(RunOpKernel());
+
+    const auto values = GetOutput(0)->matrix<float>();
+    const auto indices = GetOutput(1)->matrix<int32>();
+    for (int r = 0; r < num_rows; ++r) {
+      const float* row = input.data() + r * num_cols;
+      std::vector<int32> expected(num_cols);
+      std::iota(expected.begin(), expected.end(), 0);
+      std::stable_sort(expected.begin(), expected.end(),
+                       [row](int32 a, int32 b) { return row[b] < row[a]; });
+      expected.resize(k);
+      std::vector<int32> actual(&indices(r, 0), &indices(r, 0) + k);
+      if (!sorted) {
+        std::sort(actual.begin(), actual.end());
+        std::sort(expected.begin(), expected.end());
+      }
+      EXPECT_EQ(actual, expected) << "row " << r;
+      for (int i = 0; i < k; ++i) {
+        EXPECT_EQ(values(r, i), row[indices(r, i)]);
+      }
+    }
+  }
+};
+
+// Returns `size` values drawn from `num_distinct` values, so that there are
+// ties to break if `num_distinct` is small.
+std::vector<float> RandomValues(int size, int num_distinct) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<float> values(size);
+  for (float& value : values) value = rnd.Uniform(num_distinct);
+  return values;
+}
+
+TEST_F(TopKOpTest, SmallRows) {
+  RunAndCheck(8, 100, 7, /*sorted=*/true, RandomValues(800, 1000));
+}
+
+TEST_F(TopKOpTest, BreaksTiesByIndex) {
+  RunAndCheck(4, 1000, 30, /*sorted=*/true, RandomValues(4000, 5));
+}
+
+TEST_F(TopKOpTest, AscendingRow) {
+  std::vector<float> input(5000);
+  std::iota(input.begin(), input.end(), 0.0f);
+  RunAndCheck(1, 5000, 100, /*sorted=*/true, input);
+}
+
+TEST_F(TopKOpTest, Unsorted) {
+  RunAndCheck(3, 2000, 50, /*sorted=*/false, RandomValues(6000, 100000));
+}
+
+TEST_F(TopKOpTest, FewLargeRows) {
+  // Large enough to be split into column blocks when there are enough worker
+  // threads.
+  RunAndCheck(2, 300000, 100, /*sorted=*/true, RandomValues(600000, 100000));
+}
+
+TEST_F(TopKOpTest, AllColumns) {
+  RunAndCheck(2, 500, 500, /*sorted=*/true, RandomValues(1000, 50));
+}
+
+Graph* TopKGraph(int batch, int num_cols, int k) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_FLOAT, TensorShape({batch, num_cols}));
+  input.flat<float>().setRandom();
+  Node* top_k;
+  TF_CHECK_OK(NodeBuilder(g->NewName("top_k"), "TopKV2")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, test::AsScalar<int32>(k)))
+                  .Finalize(g, &top_k));
+  return g;
+}
+
+// Arguments are the batch size, the number of columns and k.
+void BM_TopK(::testing::benchmark::State& state) {
+  const int batch = state.range(0);
+  const int num_cols = state.range(1);
+  const int k = state.range(2);
+  test::Benchmark("cpu", TopKGraph(batch, num_cols, k),
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * batch *
+                          num_cols);
+}
+BENCHMARK(BM_TopK)
+    ->UseRealTime()
+    ->Args({1, 1000000, 100})
+    ->Args({1, 1000000, 1000})
+    ->Args({8, 1000000, 100})
+    ->Args({64, 100000, 100})
+    ->Args({256, 10000, 10})
+    ->Args({256, 10000, 1000})
+    ->Args({1024, 1000, 100});
+
+}  // namespace
+}  // namespace tensorflow
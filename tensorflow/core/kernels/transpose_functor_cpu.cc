@@ -15,7 +15,10 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <complex>
+#include <cstring>
+#include <type_traits>
 
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -68,12 +71,324 @@ void TransposeSimple(const CPUDevice& device, const Tensor& in,
   device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
 }
 
+// Side of the square tiles that TransposeBlocked() moves at a time. A tile of
+// 8-byte elements is 32KB.
+constexpr int64_t kTransposeTileSize = 64;
+
+// The scalar whose packets are used to move elements of type T in registers:
+// elements are only moved and never computed with, so the 4- and 8-byte
+// integer types are loaded as float and double packets.
+template <typename T, typename Enable = void>
+struct TransposePacketScalar {
+  using type = void;
+};
+template <typename T>
+struct TransposePacketScalar<T, std::enable_if_t<sizeof(T) == 4>> {
+  using type = float;
+};
+template <typename T>
+struct TransposePacketScalar<T, std::enable_if_t<sizeof(T) == 8>> {
+  using type = double;
+};
+
+// Transposes the `rows` x `cols` tile at `in` into the `cols` x `rows` tile at
+// `out`, whose rows are `in_stride` and `out_stride` elements apart. Square
+// blocks of a full packet are transposed in registers.
+template <typename T>
+void TransposeTile(const T* in, int64_t in_stride, T* out, int64_t out_stride,
+                   int64_t rows, int64_t cols) {
+  using Scalar = typename TransposePacketScalar<T>::type;
+  int64_t r = 0;
+  if constexpr (!std::is_void_v<Scalar>) {
+    using Packet = typename Eigen::internal::packet_traits<Scalar>::type;
+    constexpr int kPacketSize = Eigen::internal::unpacket_traits<Packet>::size;
+    if constexpr (kPacketSize > 1) {
+      for (; r + kPacketSize <= rows; r += kPacketSize) {
+        int64_t c = 0;
+        for (; c + kPacketSize <= cols; c += kPacketSize) {
+          Eigen::internal::PacketBlock<Packet, kPacketSize> block;
+          for (int k = 0; k < kPacketSize; ++k) {
+            block.packet[k] = Eigen::internal::ploadu<Packet>(
+                reinterpret_cast<const Scalar*>(in + (r + k) * in_stride + c));
+          }
+          Eigen::internal::ptranspose(block);
+          for (int k = 0; k < kPacketSize; ++k) {
+            Eigen::internal::pstoreu(
+                reinterpret_cast<Scalar*>(out + (c + k) * out_stride + r),
+                block.packet[k]);
+          }
+        }
+        for (; c < cols; ++c) {
+          for (int k = 0; k < kPacketSize; ++k) {
+            out[c * out_stride + r + k] = in[(r + k) * in_stride + c];
+          }
+        }
+      }
+    }
+  }
+  // Other elements are gathered into square blocks on the stack, which are
+  // then written out a row at a time.
+  constexpr int kBlockSize = 8;
+  for (; r + kBlockSize <= rows; r += kBlockSize) {
+    int64_t c = 0;
+    for (; c + kBlockSize <= cols; c += kBlockSize) {
+      T block[kBlockSize][kBlockSize];
+      for (int i = 0; i < kBlockSize; ++i) {
+        for (int j = 0; j < kBlockSize; ++j) {
+          block[j][i] = in[(r + i) * in_stride + c + j];
+        }
+      }
+      for (int j = 0; j < kBlockSize; ++j) {
+        memcpy(out + (c + j) * out_stride + r, block[j], sizeof(block[j]));
+      }
+    }
+    for (; c < cols; ++c) {
+      for (int i = 0; i < kBlockSize; ++i) {
+        out[c * out_stride + r + i] = in[(r + i) * in_stride + c];
+      }
+    }
+  }
+  for (; r < rows; ++r) {
+    for (int64_t c = 0; c < cols; ++c) {
+      out[c * out_stride + r] = in[r * in_stride + c];
+    }
+  }
+}
+
+// A dimension of the output of a transpose, with the strides of its index in
+// the input and in the output.
+struct TransposeDim {
+  int64_t size;
+  int64_t in_stride;
+  int64_t out_stride;
+};
+
+// Returns the dimensions of the output of transposing `dims` by `perm`.
+absl::InlinedVector<TransposeDim, 8UL> TransposeOutputDims(
+    const internal::TransposeDimsVec& dims,
+    const internal::TransposePermsVec& perm) {
+  const int ndims = dims.size();
+  internal::TransposeDimsVec in_strides(ndims, 1);
+  for (int i = ndims - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * dims[i + 1];
+  }
+  absl::InlinedVector<TransposeDim, 8UL> out_dims(ndims);
+  int64_t out_stride = 1;
+  for (int i = ndims - 1; i >= 0; --i) {
+    out_dims[i] = {dims[perm[i]], in_strides[perm[i]], out_stride};
+    out_stride *= dims[perm[i]];
+  }
+  return out_dims;
+}
+
+// Transposes `in`, of dimensions `dims`, into `out` by `perm`, where
+// `perm.back() != dims.size() - 1`: the dimension that is contiguous in the
+// output is not the one that is contiguous in the input. The plane of these
+// two dimensions is transposed in tiles, and the tiles of all the other
+// dimensions are spread across the threads.
+template <typename T>
+void TransposeTiled(const CPUDevice& d, const T* in, T* out,
+                    const internal::TransposeDimsVec& dims,
+                    const internal::TransposePermsVec& perm) {
+  const int ndims = dims.size();
+  const auto out_dims = TransposeOutputDims(dims, perm);
+  // The rows of the tiles are along the last dimension of the output, and
+  // their columns along the last dimension of the input, which is dimension
+  // `col_dim` of the output.
+  const int col_dim = std::find(perm.begin(), perm.end(), ndims - 1) -
+                      perm.begin();
+  const TransposeDim& rows = out_dims[ndims - 1];
+  const TransposeDim& cols = out_dims[col_dim];
+  // The tiles are visited in the order of the output, so that consecutive
+  // tiles of a thread write to nearby memory: `tile_dims` are the dimensions
+  // of the output, with the two of the plane counted in tiles.
+  absl::InlinedVector<TransposeDim, 8UL> tile_dims(out_dims.begin(),
+                                                   out_dims.end());
+  for (int i : {col_dim, ndims - 1}) {
+    tile_dims[i].size =
+        (tile_dims[i].size + kTransposeTileSize - 1) / kTransposeTileSize;
+    tile_dims[i].in_stride *= kTransposeTileSize;
+    tile_dims[i].out_stride *= kTransposeTileSize;
+  }
+  int64_t num_tiles = 1;
+  for (const TransposeDim& dim : tile_dims) num_tiles *= dim.size;
+
+  auto work = [&](int64_t begin, int64_t end) {
+    for (int64_t tile = begin; tile < end; ++tile) {
+      int64_t t = tile;
+      int64_t in_offset = 0;
+      int64_t out_offset = 0;
+      int64_t row = 0;
+      int64_t col = 0;
+      for (int i = ndims - 1; i >= 0; --i) {
+        const int64_t index = t % tile_dims[i].size;
+        t /= tile_dims[i].size;
+        in_offset += index * tile_dims[i].in_stride;
+        out_offset += index * tile_dims[i].out_stride;
+        if (i == ndims - 1) row = index * kTransposeTileSize;
+        if (i == col_dim) col = index * kTransposeTileSize;
+      }
+      TransposeTile(in + in_offset, rows.in_stride, out + out_offset,
+                    cols.out_stride,
+                    std::min(kTransposeTileSize, rows.size - row),
+                    std::min(kTransposeTileSize, cols.size - col));
+    }
+  };
+  const int64_t tile_bytes =
+      kTransposeTileSize * kTransposeTileSize * sizeof(T);
+  const Eigen::TensorOpCost cost(tile_bytes, tile_bytes,
+                                 kTransposeTileSize * kTransposeTileSize);
+  d.parallelFor(num_tiles, cost, work);
+}
+
+// Transposes `in`, of dimensions `dims`, into `out` by `perm`, where
+// `perm.back() == dims.size() - 1`: the rows of the last dimension stay
+// contiguous and are copied whole, spread across the threads.
+template <typename T>
+void TransposeRows(const CPUDevice& d, const T* in, T* out,
+                   const internal::TransposeDimsVec& dims,
+                   const internal::TransposePermsVec& perm) {
+  const int ndims = dims.size();
+  const auto out_dims = TransposeOutputDims(dims, perm);
+  const int64_t row_size = dims[ndims - 1];
+  int64_t num_rows = 1;
+  for (int i = 0; i < ndims - 1; ++i) num_rows *= dims[i];
+
+  auto work = [&](int64_t begin, int64_t end) {
+    // The index of row `begin` of the output, which is then incremented.
+    internal::TransposeDimsVec index(ndims - 1);
+    int64_t in_offset = 0;
+    int64_t t = begin;
+    for (int i = ndims - 2; i >= 0; --i) {
+      index[i] = t % out_dims[i].size;
+      t /= out_dims[i].size;
+      in_offset += index[i] * out_dims[i].in_stride;
+    }
+    for (int64_t r = begin; r < end; ++r) {
+      memcpy(out + r * row_size, in + in_offset, row_size * sizeof(T));
+      for (int i = ndims - 2; i >= 0; --i) {
+        in_offset += out_dims[i].in_stride;
+        if (++index[i] < out_dims[i].size) break;
+        in_offset -= index[i] * out_dims[i].in_stride;
+        index[i] = 0;
+      }
+    }
+  };
+  const int64_t row_bytes = row_size * sizeof(T);
+  const Eigen::TensorOpCost cost(row_bytes, row_bytes, ndims);
+  d.parallelFor(num_rows, cost, work);
+}
+
+template <typename T>
+void TransposeBlocked(const CPUDevice& d, const T* in, T* out,
+                      internal::TransposeDimsVec dims,
+                      internal::TransposePermsVec perm);
+
+// Transposes rows of `dims.back()` elements of type T, which are moved as
+// single elements of type U, the size of a row.
+template <typename T, typename U>
+void TransposeRowsAsElements(const CPUDevice& d, const T* in, T* out,
+                             internal::TransposeDimsVec dims,
+                             internal::TransposePermsVec perm) {
+  dims.pop_back();
+  perm.pop_back();
+  TransposeBlocked<U>(d, reinterpret_cast<const U*>(in),
+                      reinterpret_cast<U*>(out), std::move(dims),
+                      std::move(perm));
+}
+
+// Transposes `in`, of dimensions `dims`, into `out` by `perm`, which must be
+// reduced by ReduceTransposeDimensions() and have no dimensions of size 1.
+template <typename T>
+void TransposeBlocked(const CPUDevice& d, const T* in, T* out,
+                      internal::TransposeDimsVec dims,
+                      internal::TransposePermsVec perm) {
+  const int ndims = dims.size();
+  if (ndims == 1) {
+    const int64_t num_elements = dims[0];
+    auto copy = [&](int64_t begin, int64_t end) {
+      memcpy(out + begin, in + begin, (end - begin) * sizeof(T));
+    };
+    d.parallelFor(num_elements,
+                  Eigen::TensorOpCost(sizeof(T), sizeof(T), 0), copy);
+    return;
+  }
+  if (perm[ndims - 1] != ndims - 1) {
+    TransposeTiled(d, in, out, dims, perm);
+    return;
+  }
+  // Rows that are no larger than the widest element type are moved as
+  // elements, and transposed in tiles rather than copied one by one.
+  switch (dims[ndims - 1] * sizeof(T)) {
+    case 2:
+      if constexpr (sizeof(T) < 2) {
+        return TransposeRowsAsElements<T, uint16>(d, in, out, dims, perm);
+      }
+      break;
+    case 4:
+      if constexpr (sizeof(T) < 4) {
+        return TransposeRowsAsElements<T, uint32>(d, in, out, dims, perm);
+      }
+      break;
+    case 8:
+      if constexpr (sizeof(T) < 8) {
+        return TransposeRowsAsElements<T, uint64>(d, in, out, dims, perm);
+      }
+      break;
+    default:
+      break;
+  }
+  TransposeRows(d, in, out, dims, perm);
+}
+
+// Transposes `in` into `out` by `perm` with TransposeBlocked(), after dropping
+// the dimensions of size 1 and merging the dimensions that stay adjacent.
+template <typename T>
+void TransposeBlockedUnreduced(const CPUDevice& d, const Tensor& in,
+                               const absl::Span<const int32> perm,
+                               Tensor* out) {
+  if (in.NumElements() == 0) return;
+  TensorShape squeezed_shape;
+  internal::TransposePermsVec squeezed_perm;
+  // Position of each non-singleton dimension of `in` in `squeezed_shape`.
+  internal::TransposePermsVec squeezed_dim(in.dims(), -1);
+  for (int i = 0; i < in.dims(); ++i) {
+    if (in.dim_size(i) == 1) continue;
+    squeezed_dim[i] = squeezed_shape.dims();
+    squeezed_shape.AddDim(in.dim_size(i));
+  }
+  for (int32 p : perm) {
+    if (squeezed_dim[p] >= 0) squeezed_perm.push_back(squeezed_dim[p]);
+  }
+  if (squeezed_shape.dims() == 0) {
+    squeezed_shape.AddDim(1);
+    squeezed_perm.push_back(0);
+  }
+  internal::TransposePermsVec new_perm;
+  internal::TransposeDimsVec new_dims(squeezed_shape.dims());
+  internal::ReduceTransposeDimensions(squeezed_shape, squeezed_perm, &new_perm,
+                                      &new_dims);
+  TransposeBlocked<T>(
+      d, reinterpret_cast<const T*>(in.tensor_data().data()),
+      reinterpret_cast<T*>(const_cast<char*>(out->tensor_data().data())),
+      std::move(new_dims), std::move(new_perm));
+}
+
 }  // namespace
 
 template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const absl::Span<const int32> perm, Tensor* out) {
+    // Elements that are only moved, not conjugated, are transposed by
+    // TransposeBlocked(); see DoTransposeImpl() for the types of the elements.
+    if constexpr (!conjugate && (std::is_same_v<T, uint8> ||
+                                 std::is_same_v<T, uint16> ||
+                                 std::is_same_v<T, uint32> ||
+                                 std::is_same_v<T, uint64>)) {
+      TransposeBlockedUnreduced<T>(d, in, perm, out);
+      return;
+    }
     switch (in.dims()) {
       case 2:
         internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
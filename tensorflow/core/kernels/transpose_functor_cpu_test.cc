@@ -0,0 +1,176 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/transpose_functor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+class TransposeFunctorCpuTest : public ::testing::Test {
+ protected:
+  TransposeFunctorCpuTest()
+      : pool_(Env::Default(), "test", 4),
+        device_(pool_.AsEigenThreadPool(), pool_.NumThreads()) {}
+
+  // Transposes a tensor of `shape` filled with distinct values by `perm`, and
+  // compares the result with an element by element transpose.
+  template <typename T>
+  void TestTranspose(const TensorShape& shape, const std::vector<int32>& perm) {
+    Tensor in(DataTypeToEnum<T>::value, shape);
+    auto in_flat = in.flat<T>();
+    for (int64_t i = 0; i < in.NumElements(); ++i) {
+      in_flat(i) = static_cast<T>(i % 251);
+    }
+    TensorShape out_shape;
+    for (int32 p : perm) out_shape.AddDim(shape.dim_size(p));
+    Tensor out(DataTypeToEnum<T>::value, out_shape);
+    TF_ASSERT_OK(DoTranspose(device_, in, perm, &out));
+
+    Tensor expected(DataTypeToEnum<T>::value, out_shape);
+    auto expected_flat = expected.flat<T>();
+    const int ndims = shape.dims();
+    std::vector<int64_t> in_strides(ndims, 1);
+    for (int i = ndims - 2; i >= 0; --i) {
+      in_strides[i] = in_strides[i + 1] * shape.dim_size(i + 1);
+    }
+    for (int64_t o = 0; o < expected.NumElements(); ++o) {
+      int64_t t = o;
+      int64_t i_idx = 0;
+      for (int i = ndims - 1; i >= 0; --i) {
+        i_idx += (t % out_shape.dim_size(i)) * in_strides[perm[i]];
+        t /= out_shape.dim_size(i);
+      }
+      expected_flat(o) = in_flat(i_idx);
+    }
+    test::ExpectTensorEqual<T>(out, expected);
+  }
+
+  template <typename T>
+  void TestAllPermutations(const TensorShape& shape) {
+    std::vector<int32> perm(shape.dims());
+    std::iota(perm.begin(), perm.end(), 0);
+    do {
+      TestTranspose<T>(shape, perm);
+    } while (std::next_permutation(perm.begin(), perm.end()));
+  }
+
+  thread::ThreadPool pool_;
+  CPUDevice device_;
+};
+
+TEST_F(TransposeFunctorCpuTest, AllPermutationsOfRank4) {
+  // Sizes that are not multiples of the tiles or of the packets.
+  const TensorShape shape({3, 70, 5, 67});
+  TestAllPermutations<int8>(shape);
+  TestAllPermutations<bfloat16>(shape);
+  TestAllPermutations<float>(shape);
+  TestAllPermutations<double>(shape);
+}
+
+TEST_F(TransposeFunctorCpuTest, AttentionHeads) {
+  // [B, S, H, D] -> [B, H, S, D] and back.
+  TestTranspose<float>({2, 130, 8, 64}, {0, 2, 1, 3});
+  TestTranspose<bfloat16>({2, 130, 8, 64}, {0, 2, 1, 3});
+  TestTranspose<float>({2, 8, 130, 64}, {0, 2, 1, 3});
+}
+
+TEST_F(TransposeFunctorCpuTest, SmallRowsMovedAsElements) {
+  // Rows of 2, 4 and 8 bytes that stay contiguous.
+  TestTranspose<int8>({33, 17, 2}, {1, 0, 2});
+  TestTranspose<bfloat16>({33, 17, 2}, {1, 0, 2});
+  TestTranspose<float>({33, 17, 2}, {1, 0, 2});
+  TestTranspose<int8>({5, 33, 17, 8}, {2, 0, 1, 3});
+}
+
+TEST_F(TransposeFunctorCpuTest, SingletonAndEmptyDimensions) {
+  TestTranspose<float>({1, 65, 1, 66}, {3, 2, 1, 0});
+  TestTranspose<float>({65, 1, 66}, {0, 2, 1});
+  TestTranspose<float>({1, 1}, {1, 0});
+  TestTranspose<float>({}, {});
+  TestTranspose<float>({0, 3, 4}, {2, 1, 0});
+}
+
+TEST_F(TransposeFunctorCpuTest, HighRank) {
+  TestTranspose<float>({2, 3, 2, 5, 2, 3, 2, 4, 3},
+                       {8, 1, 6, 3, 4, 5, 2, 7, 0});
+  TestTranspose<uint16>({3, 2, 5, 2, 3, 2, 4, 3}, {1, 0, 3, 2, 5, 4, 7, 6});
+}
+
+// Transposes a [8, 512, 16, 64] tensor of type T by the permutation
+// `state.range(0)` of kBenchmarkPerms.
+constexpr int kBenchmarkPerms[][4] = {
+    {0, 2, 1, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {3, 2, 1, 0}, {1, 0, 3, 2}};
+
+template <typename T>
+void TransposeHelper(::testing::benchmark::State& state) {
+  thread::ThreadPool pool(Env::Default(), "bench", port::MaxParallelism());
+  CPUDevice device(pool.AsEigenThreadPool(), pool.NumThreads());
+  const TensorShape shape({8, 512, 16, 64});
+  const int* perm = kBenchmarkPerms[state.range(0)];
+  Tensor in(DataTypeToEnum<T>::value, shape);
+  in.flat<T>().setZero();
+  TensorShape out_shape;
+  for (int i = 0; i < 4; ++i) out_shape.AddDim(shape.dim_size(perm[i]));
+  Tensor out(DataTypeToEnum<T>::value, out_shape);
+  const std::vector<int32> perm_vec(perm, perm + 4);
+  for (auto s : state) {
+    TF_CHECK_OK(DoTranspose(device, in, perm_vec, &out));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          in.TotalBytes());
+}
+
+void BM_Transpose_FP32(::testing::benchmark::State& state) {
+  TransposeHelper<float>(state);
+}
+
+void BM_Transpose_BF16(::testing::benchmark::State& state) {
+  TransposeHelper<bfloat16>(state);
+}
+
+void BM_Transpose_INT8(::testing::benchmark::State& state) {
+  TransposeHelper<int8>(state);
+}
+
+void BM_Transpose_FP64(::testing::benchmark::State& state) {
+  TransposeHelper<double>(state);
+}
+
+BENCHMARK(BM_Transpose_FP32)->UseRealTime()->DenseRange(0, 4);
+BENCHMARK(BM_Transpose_BF16)->UseRealTime()->DenseRange(0, 4);
+BENCHMARK(BM_Transpose_INT8)->UseRealTime()->DenseRange(0, 4);
+BENCHMARK(BM_Transpose_FP64)->UseRealTime()->DenseRange(0, 4);
+
+}  // namespace
+}  // namespace tensorflow
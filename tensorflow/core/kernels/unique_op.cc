@@ -13,11 +13,17 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/numeric/bits.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -26,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -68,6 +75,272 @@ struct UniqueOpHashMap<bfloat16, TIndex> {
   using map_type = std::unordered_map<bfloat16, TIndex>;
 };
 
+// `IntegerUniquifier` computes the unique elements of a vector of `int32` or
+// `int64` keys, in the same order and with the same indices as the general
+// implementation in `UniqueOp`, but with an open addressing table of the keys
+// themselves and, given several threads, in parallel.
+//
+// With several threads, the keys are first sorted by hash into partitions,
+// with a stable counting sort, so that each partition can be deduplicated by
+// a single thread with its own table. The distinct keys are then numbered in
+// order of first occurrence, from a prefix count of the first occurrences, and
+// every key finds its number in the table of its partition.
+template <typename T, typename TIndex>
+class IntegerUniquifier {
+ public:
+  // Inputs with fewer elements are left to the general implementation.
+  static constexpr int64_t kMinSize = 1 << 15;
+
+  IntegerUniquifier(const DeviceBase::CpuWorkerThreads& workers,
+                    const T* keys, int64_t size, bool count)
+      : workers_(workers), keys_(keys), size_(size), count_(count) {
+    if (workers_.num_threads > 1) {
+      while (num_partitions() < kPartitionsPerThread * workers_.num_threads) {
+        ++partition_bits_;
+      }
+    }
+    num_chunks_ = std::min<int64_t>(workers_.num_threads,
+                                    (size_ + kMinSize - 1) / kMinSize);
+    chunk_size_ = (size_ + num_chunks_ - 1) / num_chunks_;
+  }
+
+  // Finds the distinct keys, and returns their number. `idx` has room for an
+  // index per key, and may be written to.
+  int64_t Deduplicate(TIndex* idx) {
+    tables_.resize(num_partitions());
+    first_positions_.resize(size_);
+    if (count_) counts_.assign(size_, 0);
+    num_unique_.assign(num_partitions(), 0);
+    if (num_partitions() == 1) {
+      // The keys are numbered as they are inserted.
+      DeduplicatePartition(0, keys_, idx);
+      return num_unique_[0];
+    }
+    SortByPartition();
+    Shard(workers_.num_threads, workers_.workers, num_partitions(),
+          kCostPerKey * size_ / num_partitions(),
+          [&](int64_t first, int64_t last) {
+            for (int64_t p = first; p < last; ++p) {
+              DeduplicatePartition(p, sorted_keys_.data(), nullptr);
+            }
+          });
+    int64_t num_unique = 0;
+    for (const int64_t n : num_unique_) num_unique += n;
+    return num_unique;
+  }
+
+  // Writes the distinct keys into `unique`, the index of every key into
+  // `idx`, and the number of occurrences of every distinct key into `counts`
+  // if the keys were counted.
+  void Finish(T* unique, TIndex* idx, TIndex* counts) {
+    if (num_partitions() == 1) {
+      for (int64_t id = 0; id < num_unique_[0]; ++id) {
+        unique[id] = keys_[first_positions_[id]];
+        if (count_) counts[id] = counts_[id];
+      }
+      return;
+    }
+    std::vector<uint8_t> is_first(size_, 0);
+    Shard(workers_.num_threads, workers_.workers, num_partitions(),
+          kCostPerKey * size_ / num_partitions(),
+          [&](int64_t first, int64_t last) {
+            for (int64_t p = first; p < last; ++p) {
+              for (int64_t id = 0; id < num_unique_[p]; ++id) {
+                is_first[first_positions_[starts_[p] + id]] = 1;
+              }
+            }
+          });
+    // Numbers the first occurrences in one pass over each chunk, after
+    // counting those of every chunk. The number of a distinct key is left in
+    // `idx` at its first occurrence.
+    std::vector<int64_t> chunk_offsets(num_chunks_ + 1, 0);
+    ForEachChunk([&](int64_t c, int64_t begin, int64_t end) {
+      int64_t n = 0;
+      for (int64_t i = begin; i < end; ++i) n += is_first[i];
+      chunk_offsets[c + 1] = n;
+    });
+    for (int64_t c = 0; c < num_chunks_; ++c) {
+      chunk_offsets[c + 1] += chunk_offsets[c];
+    }
+    ForEachChunk([&](int64_t c, int64_t begin, int64_t end) {
+      TIndex next = chunk_offsets[c];
+      for (int64_t i = begin; i < end; ++i) {
+        if (is_first[i]) {
+          unique[next] = keys_[i];
+          idx[i] = next++;
+        }
+      }
+    });
+    // Replaces the numbers of the keys within their partitions by their
+    // indices.
+    Shard(workers_.num_threads, workers_.workers, num_partitions(),
+          kCostPerKey * size_ / num_partitions(),
+          [&](int64_t first, int64_t last) {
+            for (int64_t p = first; p < last; ++p) {
+              for (Slot& slot : tables_[p]) {
+                if (slot.id < 0) continue;
+                const int64_t begin = starts_[p];
+                const TIndex index = idx[first_positions_[begin + slot.id]];
+                if (count_) counts[index] = counts_[begin + slot.id];
+                slot.id = index;
+              }
+            }
+          });
+    ForEachChunk([&](int64_t c, int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        const T key = keys_[i];
+        const std::vector<Slot>& table = tables_[PartitionOf(key)];
+        idx[i] = table[FindSlot(table, key)].id;
+      }
+    });
+  }
+
+ private:
+  static_assert(std::is_same_v<T, int32> || std::is_same_v<T, int64_t>);
+
+  static constexpr int kPartitionsPerThread = 4;
+  static constexpr int64_t kCostPerKey = 20;
+  // Tables start with this many slots, in case the keys repeat a lot, and
+  // double whenever they get half full.
+  static constexpr int kMinTableBits = 10;
+
+  // A slot of an open addressing table, empty if `id` is negative.
+  struct Slot {
+    T key;
+    int32 id;
+  };
+
+  int64_t num_partitions() const { return int64_t{1} << partition_bits_; }
+
+  // A multiplicative hash, whose top bits pick the partition of a key and the
+  // next ones its slot.
+  static uint64_t Hash(T key) {
+    return static_cast<uint64_t>(key) * uint64_t{0x9E3779B97F4A7C15};
+  }
+
+  int64_t PartitionOf(T key) const {
+    return partition_bits_ == 0 ? 0 : Hash(key) >> (64 - partition_bits_);
+  }
+
+  // Returns the slot of `key` in `table`, or the empty slot it would go in.
+  uint64_t FindSlot(const std::vector<Slot>& table, T key) const {
+    const uint64_t mask = table.size() - 1;
+    uint64_t slot = (Hash(key) << partition_bits_) >>
+                    (64 - absl::countr_zero(table.size()));
+    while (table[slot].id >= 0 && table[slot].key != key) {
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  // Calls `fn(c, begin, end)` for every chunk c of the keys, which spans
+  // [begin, end), one thread per chunk.
+  template <typename Fn>
+  void ForEachChunk(Fn&& fn) {
+    Shard(workers_.num_threads, workers_.workers, num_chunks_,
+          kCostPerKey * chunk_size_, [&](int64_t first, int64_t last) {
+            for (int64_t c = first; c < last; ++c) {
+              fn(c, c * chunk_size_, std::min(size_, (c + 1) * chunk_size_));
+            }
+          });
+  }
+
+  // Stably sorts the keys into `sorted_keys_` by partition, and their
+  // positions into `order_`, with a counting sort of each chunk. The keys of
+  // partition p are at `starts_[p]` up to `starts_[p + 1]`.
+  void SortByPartition() {
+    // Entry `c * num_partitions() + p` is the number of keys of chunk c in
+    // partition p, and then where the first of them goes.
+    std::vector<int64_t> offsets(num_chunks_ * num_partitions(), 0);
+    ForEachChunk([&](int64_t c, int64_t begin, int64_t end) {
+      int64_t* counts = &offsets[c * num_partitions()];
+      for (int64_t i = begin; i < end; ++i) ++counts[PartitionOf(keys_[i])];
+    });
+    starts_.resize(num_partitions() + 1);
+    int64_t start = 0;
+    for (int64_t p = 0; p < num_partitions(); ++p) {
+      starts_[p] = start;
+      for (int64_t c = 0; c < num_chunks_; ++c) {
+        const int64_t count = offsets[c * num_partitions() + p];
+        offsets[c * num_partitions() + p] = start;
+        start += count;
+      }
+    }
+    starts_[num_partitions()] = start;
+    sorted_keys_.resize(size_);
+    order_.resize(size_);
+    ForEachChunk([&](int64_t c, int64_t begin, int64_t end) {
+      int64_t* next = &offsets[c * num_partitions()];
+      for (int64_t i = begin; i < end; ++i) {
+        const T key = keys_[i];
+        const int64_t k = next[PartitionOf(key)]++;
+        sorted_keys_[k] = key;
+        order_[k] = i;
+      }
+    });
+  }
+
+  // Numbers the distinct keys of partition p in order of first occurrence,
+  // in `tables_[p]`, and records the position of the first occurrence and
+  // the count of each. The keys of the partition are at `keys[starts_[p]]`
+  // onwards. Sets `idx[i]` to the number of key i, unless `idx` is null.
+  void DeduplicatePartition(int64_t p, const T* keys, TIndex* idx) {
+    const int64_t begin = num_partitions() == 1 ? 0 : starts_[p];
+    const int64_t end = num_partitions() == 1 ? size_ : starts_[p + 1];
+    std::vector<Slot>& table = tables_[p];
+    table.assign(int64_t{1} << kMinTableBits, Slot{0, -1});
+    int32 num_unique = 0;
+    for (int64_t k = begin; k < end; ++k) {
+      const T key = keys[k];
+      uint64_t slot = FindSlot(table, key);
+      if (table[slot].id < 0) {
+        if (2 * (num_unique + 1) > table.size()) {
+          Grow(&table);
+          slot = FindSlot(table, key);
+        }
+        table[slot] = Slot{key, num_unique};
+        first_positions_[begin + num_unique] =
+            num_partitions() == 1 ? k : order_[k];
+        ++num_unique;
+      }
+      const int32 id = table[slot].id;
+      if (count_) ++counts_[begin + id];
+      if (idx != nullptr) idx[k] = id;
+    }
+    num_unique_[p] = num_unique;
+  }
+
+  void Grow(std::vector<Slot>* table) const {
+    std::vector<Slot> old_table(2 * table->size(), Slot{0, -1});
+    old_table.swap(*table);
+    for (const Slot& slot : old_table) {
+      if (slot.id >= 0) (*table)[FindSlot(*table, slot.key)] = slot;
+    }
+  }
+
+  const DeviceBase::CpuWorkerThreads& workers_;
+  const T* const keys_;
+  const int64_t size_;
+  const bool count_;
+  int partition_bits_ = 0;
+  int64_t num_chunks_;
+  int64_t chunk_size_;
+
+  // With several partitions, the keys and their positions sorted by
+  // partition, and the start of each partition in them.
+  std::vector<T> sorted_keys_;
+  std::vector<int32> order_;
+  std::vector<int64_t> starts_;
+  // The table and the number of distinct keys of each partition.
+  std::vector<std::vector<Slot>> tables_;
+  std::vector<int64_t> num_unique_;
+  // For the distinct keys of the partition starting at `starts_[p]`, in order
+  // of first occurrence, the position of their first occurrence and their
+  // number of occurrences, at `starts_[p]` onwards.
+  std::vector<int32> first_positions_;
+  std::vector<int32> counts_;
+};
+
 // `UniqueOp` computes the unique elements in the input tensor.
 //
 // * `T` is the element type.
@@ -143,6 +416,34 @@ class UniqueOp : public OpKernel {
     auto idx_vec = idx->template vec<TIndex>();
 
     int64_t uniq_size;
+    if constexpr (std::is_same_v<T, int32> || std::is_same_v<T, int64_t>) {
+      if (new_sizes[0] == 1 && new_sizes[2] == 1 &&
+          input.NumElements() >= IntegerUniquifier<T, TIndex>::kMinSize) {
+        // Faster implementation for large vectors of integer keys, which
+        // uses several threads if there are, and counts the keys itself.
+        auto Tin = input.flat<T>();
+        IntegerUniquifier<T, TIndex> uniquifier(
+            *context->device()->tensorflow_cpu_worker_threads(), Tin.data(),
+            Tin.size(), /*count=*/num_outputs() > 2);
+        uniq_size = uniquifier.Deduplicate(idx_vec.data());
+        TensorShape output_shape(input.shape());
+        output_shape.set_dim(axis, uniq_size);
+        Tensor* output = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(0, output_shape, &output));
+        Tensor* count_output = nullptr;
+        if (num_outputs() > 2) {
+          OP_REQUIRES_OK(context,
+                         context->allocate_output(
+                             2, TensorShape({uniq_size}), &count_output));
+        }
+        uniquifier.Finish(output->flat<T>().data(), idx_vec.data(),
+                          count_output == nullptr
+                              ? nullptr
+                              : count_output->template vec<TIndex>().data());
+        return;
+      }
+    }
     if (new_sizes[0] == 1 && new_sizes[2] == 1) {
       // Specialized and faster implementation when unique is run over single
       // elements. Here we put T directly into the map rather than ints pointing
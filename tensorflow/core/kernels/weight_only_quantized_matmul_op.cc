@@ -0,0 +1,249 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements a matmul of float activations with weights that are quantized to
+// eight or four bits, and dequantized as the product is computed.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "Eigen/Core"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/op_requires.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+using RowMajorMatrix =
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+using ConstMatrixMap = Eigen::Map<const RowMajorMatrix, Eigen::Unaligned,
+                                  Eigen::OuterStride<>>;
+using MatrixMap =
+    Eigen::Map<RowMajorMatrix, Eigen::Unaligned, Eigen::OuterStride<>>;
+
+// Columns are sharded over threads in units of this many, and each thread
+// splits its columns into blocks.
+constexpr int64_t kColumnUnit = 64;
+
+// Products of at most this many rows of activations are accumulated directly
+// from each dequantized row of weights, over wide blocks of columns, so that
+// the weights are read in long runs. Larger products dequantize panels of
+// weights, which stay in cache while a GEMM multiplies them.
+constexpr int64_t kMaxDirectRows = 8;
+constexpr int64_t kDirectBlockColumns = 1024;
+constexpr int64_t kBlockColumns = 256;
+constexpr int64_t kPanelRows = 128;
+
+// Sets `out[j]`, for j in [0, nb), to the weight in row `r` and column
+// `n0 + j` of `b`, times `scales[j]` unless `scales` is null. `b` has `n`
+// columns, and holds two rows per byte if `kNumBits` is 4, the even rows in
+// the low nibbles. Both nibbles are sign extended.
+template <int kNumBits>
+void DequantizeRow(const int8* b, int64_t n, int64_t r, int64_t n0,
+                   int64_t nb, const float* scales, float* out) {
+  const int8* row = b + (kNumBits == 8 ? r : r / 2) * n + n0;
+  const bool low_nibble = kNumBits == 4 && r % 2 == 0;
+  int64_t j = 0;
+#ifdef EIGEN_VECTORIZE_AVX2
+  for (; j + 8 <= nb; j += 8) {
+    __m256i q = _mm256_cvtepi8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + j)));
+    if (kNumBits == 4) {
+      q = low_nibble ? _mm256_srai_epi32(_mm256_slli_epi32(q, 28), 28)
+                     : _mm256_srai_epi32(q, 4);
+    }
+    __m256 w = _mm256_cvtepi32_ps(q);
+    if (scales != nullptr) w = _mm256_mul_ps(w, _mm256_loadu_ps(scales + j));
+    _mm256_storeu_ps(out + j, w);
+  }
+#endif
+  for (; j < nb; ++j) {
+    int8 q = row[j];
+    if (kNumBits == 4) q = (low_nibble ? static_cast<int8>(q << 4) : q) >> 4;
+    out[j] = scales == nullptr ? q : q * scales[j];
+  }
+}
+
+// Sets columns [n0, n0 + nb) of the `m` by `n` `product` to `a` times the
+// weights in `b`, for small `m`. The weights of each group of rows, which
+// share their scales, are accumulated unscaled, and the sum is scaled once.
+// `scratch` holds (m + 1) * nb floats.
+template <int kNumBits>
+void MultiplyDirect(const float* a, const int8* b, const float* scales,
+                    int64_t m, int64_t k, int64_t n, int64_t group_size,
+                    int64_t n0, int64_t nb, float* scratch, float* product) {
+  using ArrayMap = Eigen::Map<Eigen::ArrayXf>;
+  using ColumnArrayMap = Eigen::Map<Eigen::ArrayXXf>;
+  float* weights = scratch;
+  ColumnArrayMap accumulator(product, nb, m);
+  ColumnArrayMap group_sum(scratch + nb, nb, m);
+  accumulator.setZero();
+  for (int64_t g0 = 0; g0 < k; g0 += group_size) {
+    group_sum.setZero();
+    for (int64_t r = g0; r < std::min(k, g0 + group_size); ++r) {
+      DequantizeRow<kNumBits>(b, n, r, n0, nb, /*scales=*/nullptr, weights);
+      const ArrayMap row(weights, nb);
+      for (int64_t i = 0; i < m; ++i) group_sum.col(i) += a[i * k + r] * row;
+    }
+    accumulator +=
+        group_sum.colwise() *
+        Eigen::Map<const Eigen::ArrayXf>(scales + (g0 / group_size) * n + n0,
+                                         nb);
+  }
+}
+
+// Like `MultiplyDirect`, for any `m`, by multiplying panels of dequantized
+// weights. `scratch` holds kPanelRows * nb floats.
+template <int kNumBits>
+void MultiplyPanels(const float* a, const int8* b, const float* scales,
+                    int64_t m, int64_t k, int64_t n, int64_t group_size,
+                    int64_t n0, int64_t nb, float* scratch, float* product) {
+  MatrixMap accumulator(product, m, nb, Eigen::OuterStride<>(nb));
+  accumulator.setZero();
+  for (int64_t k0 = 0; k0 < k; k0 += kPanelRows) {
+    const int64_t kb = std::min(kPanelRows, k - k0);
+    for (int64_t r = 0; r < kb; ++r) {
+      DequantizeRow<kNumBits>(b, n, k0 + r, n0, nb,
+                              scales + ((k0 + r) / group_size) * n + n0,
+                              scratch + r * nb);
+    }
+    accumulator.noalias() +=
+        ConstMatrixMap(a + k0, m, kb, Eigen::OuterStride<>(k)) *
+        ConstMatrixMap(scratch, kb, nb, Eigen::OuterStride<>(nb));
+  }
+}
+
+template <typename T>
+class WeightOnlyQuantizedMatMulOp : public OpKernel {
+ public:
+  explicit WeightOnlyQuantizedMatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_bits", &num_bits_));
+    OP_REQUIRES(context, num_bits_ == 4 || num_bits_ == 8,
+                errors::InvalidArgument("num_bits must be 4 or 8, got ",
+                                        num_bits_));
+    OP_REQUIRES_OK(context, context->GetAttr("group_size", &group_size_));
+    OP_REQUIRES(context, group_size_ >= 0,
+                errors::InvalidArgument(
+                    "group_size must be non-negative, got ", group_size_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+    const Tensor& scales = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("a must be a matrix, got ",
+                                        a.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("b must be a matrix, got ",
+                                        b.shape().DebugString()));
+    const int64_t m = a.dim_size(0);
+    const int64_t k = a.dim_size(1);
+    const int64_t n = b.dim_size(1);
+    const int64_t b_rows = num_bits_ == 8 ? k : (k + 1) / 2;
+    OP_REQUIRES(context, b.dim_size(0) == b_rows,
+                errors::InvalidArgument(
+                    "b must have ", b_rows, " rows for ", k, " inputs of ",
+                    num_bits_, " bits, got ", b.shape().DebugString()));
+    const int64_t group_size = group_size_ == 0 ? std::max<int64_t>(k, 1)
+                                                : group_size_;
+    const int64_t num_groups =
+        group_size_ == 0 ? 1 : (k + group_size - 1) / group_size;
+    OP_REQUIRES(
+        context,
+        scales.shape() == TensorShape({num_groups, n}),
+        errors::InvalidArgument("scales must have shape [", num_groups, ", ",
+                                n, "], got ", scales.shape().DebugString()));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({m, n}), &output));
+    if (output->NumElements() == 0) return;
+    if (k == 0) {
+      output->flat<T>().setZero();
+      return;
+    }
+
+    const float* a_data;
+    Tensor a_float;
+    if (std::is_same<T, float>::value) {
+      a_data = reinterpret_cast<const float*>(a.flat<T>().data());
+    } else {
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DT_FLOAT, a.shape(), &a_float));
+      a_float.flat<float>() = a.flat<T>().template cast<float>();
+      a_data = a_float.flat<float>().data();
+    }
+    const int8* b_data = b.flat<int8>().data();
+    const float* scales_data = scales.flat<float>().data();
+    T* output_data = output->flat<T>().data();
+    const bool direct = m <= kMaxDirectRows;
+    const int64_t block_columns = direct ? kDirectBlockColumns : kBlockColumns;
+    const auto multiply =
+        num_bits_ == 8 ? (direct ? MultiplyDirect<8> : MultiplyPanels<8>)
+                       : (direct ? MultiplyDirect<4> : MultiplyPanels<4>);
+
+    auto compute_units = [&](int64_t begin_unit, int64_t end_unit) {
+      const int64_t end_column = std::min(n, end_unit * kColumnUnit);
+      std::vector<float> scratch((direct ? m + 1 : kPanelRows) *
+                                 block_columns);
+      std::vector<float> product(m * block_columns);
+      for (int64_t n0 = begin_unit * kColumnUnit; n0 < end_column;
+           n0 += block_columns) {
+        const int64_t nb = std::min(block_columns, end_column - n0);
+        multiply(a_data, b_data, scales_data, m, k, n, group_size, n0, nb,
+                 scratch.data(), product.data());
+        for (int64_t i = 0; i < m; ++i) {
+          for (int64_t j = 0; j < nb; ++j) {
+            output_data[i * n + n0 + j] = static_cast<T>(product[i * nb + j]);
+          }
+        }
+      }
+    };
+    const int64_t num_units = (n + kColumnUnit - 1) / kColumnUnit;
+    const auto& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_units,
+          /*cost_per_unit=*/2 * m * k * kColumnUnit, compute_units);
+  }
+
+ private:
+  int num_bits_;
+  int group_size_;
+};
+
+}  // namespace
+
+#define REGISTER_KERNEL(T)                                   \
+  REGISTER_KERNEL_BUILDER(Name("WeightOnlyQuantizedMatMul") \
+                              .Device(DEVICE_CPU)           \
+                              .TypeConstraint<T>("T"),      \
+                          WeightOnlyQuantizedMatMulOp<T>);
+TF_CALL_float(REGISTER_KERNEL);
+TF_CALL_bfloat16(REGISTER_KERNEL);
+#undef REGISTER_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,161 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class WeightOnlyQuantizedMatMulTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType type, int num_bits, int group_size) {
+    TF_ASSERT_OK(NodeDefBuilder("weight_only_quantized_matmul",
+                                "WeightOnlyQuantizedMatMul")
+                     .Input(FakeInput(type))
+                     .Input(FakeInput(DT_INT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("num_bits", num_bits)
+                     .Attr("group_size", group_size)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Multiplies `a` by `weights` dequantized with `scales`, all in float.
+  static std::vector<float> Reference(const std::vector<float>& a,
+                                      const std::vector<int8>& weights,
+                                      const std::vector<float>& scales,
+                                      int64_t m, int64_t k, int64_t n,
+                                      int64_t group_size) {
+    std::vector<float> product(m * n, 0.0f);
+    for (int64_t i = 0; i < m; ++i) {
+      for (int64_t r = 0; r < k; ++r) {
+        for (int64_t j = 0; j < n; ++j) {
+          product[i * n + j] += a[i * k + r] * weights[r * n + j] *
+                                scales[(r / group_size) * n + j];
+        }
+      }
+    }
+    return product;
+  }
+};
+
+TEST_F(WeightOnlyQuantizedMatMulTest, Int8PerChannel) {
+  MakeOp(DT_FLOAT, 8, 0);
+  // A matrix is:
+  // | 1 | 2 | 3 |
+  // | 4 | 5 | 6 |
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  // B matrix is:
+  // |  7 |  -8 |
+  // |  9 | -10 |
+  // | 11 | -12 |
+  AddInputFromArray<int8>(TensorShape({3, 2}), {7, -8, 9, -10, 11, -12});
+  AddInputFromArray<float>(TensorShape({1, 2}), {0.5f, 2.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected, {29, -128, 69.5, -308});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(WeightOnlyQuantizedMatMulTest, Int4Grouped) {
+  MakeOp(DT_FLOAT, 4, 2);
+  // Five rows of weights, packed two to a byte with the even row in the low
+  // nibble, and the last byte padded with zero.
+  //  |  1 | -8 |
+  //  |  7 | -1 |
+  //  | -3 |  4 |
+  //  |  2 |  0 |
+  //  | -5 |  6 |
+  const std::vector<int8> weights = {1, -8, 7, -1, -3, 4, 2, 0, -5, 6};
+  std::vector<int8> packed(3 * 2);
+  for (int r = 0; r < 5; ++r) {
+    for (int j = 0; j < 2; ++j) {
+      const uint8 nibble = static_cast<uint8>(weights[r * 2 + j]) & 0xf;
+      packed[(r / 2) * 2 + j] |= static_cast<int8>(nibble << (4 * (r % 2)));
+    }
+  }
+  const std::vector<float> a = {1, -2, 3, 0.5, 4, -1, 0, 2, 1, -3};
+  const std::vector<float> scales = {0.25, 1, 2, 0.5, -1, 3};
+  AddInputFromArray<float>(TensorShape({2, 5}), a);
+  AddInputFromArray<int8>(TensorShape({3, 2}), packed);
+  AddInputFromArray<float>(TensorShape({3, 2}), scales);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected,
+                          Reference(a, weights, scales, 2, 5, 2, 2));
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+// Spans several column blocks and row panels, so that the sharded blocked
+// product is compared against the plain one.
+TEST_F(WeightOnlyQuantizedMatMulTest, Int8Large) {
+  MakeOp(DT_FLOAT, 8, 64);
+  const int64_t m = 3, k = 300, n = 200;
+  std::vector<float> a(m * k);
+  for (int64_t i = 0; i < m * k; ++i) a[i] = ((i * 37) % 19 - 9) / 8.0f;
+  std::vector<int8> weights(k * n);
+  for (int64_t i = 0; i < k * n; ++i) weights[i] = (i * 53) % 255 - 127;
+  const int64_t num_groups = (k + 63) / 64;
+  std::vector<float> scales(num_groups * n);
+  for (int64_t i = 0; i < num_groups * n; ++i) {
+    scales[i] = ((i * 11) % 7 + 1) / 64.0f;
+  }
+  AddInputFromArray<float>(TensorShape({m, k}), a);
+  AddInputFromArray<int8>(TensorShape({k, n}), weights);
+  AddInputFromArray<float>(TensorShape({num_groups, n}), scales);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({m, n}));
+  test::FillValues<float>(&expected,
+                          Reference(a, weights, scales, m, k, n, 64));
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-3);
+}
+
+TEST_F(WeightOnlyQuantizedMatMulTest, BFloat16) {
+  MakeOp(DT_BFLOAT16, 8, 0);
+  AddInputFromArray<bfloat16>(TensorShape({1, 2}), {static_cast<bfloat16>(1),
+                                                     static_cast<bfloat16>(2)});
+  AddInputFromArray<int8>(TensorShape({2, 2}), {3, -4, 5, 6});
+  AddInputFromArray<float>(TensorShape({1, 2}), {1.0f, 0.5f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_BFLOAT16, TensorShape({1, 2}));
+  test::FillValues<bfloat16>(
+      &expected, {static_cast<bfloat16>(13), static_cast<bfloat16>(4)});
+  test::ExpectTensorEqual<bfloat16>(expected, *GetOutput(0));
+}
+
+TEST_F(WeightOnlyQuantizedMatMulTest, WrongScalesShape) {
+  MakeOp(DT_FLOAT, 8, 2);
+  AddInputFromArray<float>(TensorShape({1, 3}), {1, 2, 3});
+  AddInputFromArray<int8>(TensorShape({3, 1}), {1, 2, 3});
+  AddInputFromArray<float>(TensorShape({1, 1}), {1});
+  EXPECT_TRUE(absl::IsInvalidArgument(RunOpKernel()));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -23,8 +23,14 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/where_op.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <memory>
 #include <numeric>
+#include <vector>
+
+#include "absl/numeric/bits.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -64,9 +70,29 @@ int64_t CountAccumulator(const T* begin, const T* end) {
   });
 }
 
+// A bool is stored as a byte holding 0 or 1, so the popcount of a word of
+// packed bools is the number of true values in it.
 template <>
 int64_t CountAccumulator<bool>(const bool* begin, const bool* end) {
-  return std::accumulate(begin, end, 0LL);
+  int64_t count = 0;
+  const bool* p = begin;
+  for (; end - p >= static_cast<ptrdiff_t>(sizeof(uint64_t));
+       p += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    count += absl::popcount(word);
+  }
+  return count + std::accumulate(p, end, 0LL);
+}
+
+// Returns the number of shards the elements of a Where input are split into.
+// Each shard is counted and then written independently.
+int64_t NumWhereShards(OpKernelContext* ctx, int64_t num_elements) {
+  constexpr int64_t kMinElementsPerShard = 64 * 1024;
+  const int64_t num_threads =
+      ctx->device()->tensorflow_cpu_worker_threads()->num_threads;
+  return std::max<int64_t>(
+      1, std::min(num_threads, num_elements / kMinElementsPerShard));
 }
 
 }  // namespace
@@ -87,16 +113,26 @@ struct Where<CPUDevice, DIMS, T, TIndex> {
       typename TTypes<int64_t>::Matrix output,
       const typename Eigen::DSizes<TIndex, DIMS>& strides, TIndex true_n,
       TIndex index) {
-    for (int i = 0; i < DIMS; ++i) {
-      output(true_n, i) = index / strides[i];
-      index -= output(true_n, i) * strides[i];
+    if constexpr (DIMS == 1) {
+      output(true_n, 0) = index;
+    } else if constexpr (DIMS == 2) {
+      output(true_n, 0) = index / strides[0];
+      output(true_n, 1) = index - output(true_n, 0) * strides[0];
+    } else {
+      for (int i = 0; i < DIMS; ++i) {
+        output(true_n, i) = index / strides[i];
+        index -= output(true_n, i) * strides[i];
+      }
     }
   }
 
-  EIGEN_ALWAYS_INLINE static Status Compute(
-      OpKernelContext* ctx, const CPUDevice& d,
-      typename TTypes<T, DIMS>::ConstTensor input,
-      typename TTypes<int64_t>::Matrix output, TIndex* found_true) {
+  // Writes the indices of the true values among the elements [begin, end) of
+  // input into output, starting at row *found_true, and advances *found_true
+  // past them.
+  static void ComputeRange(typename TTypes<T, DIMS>::ConstTensor input,
+                           typename TTypes<int64_t>::Matrix output,
+                           Eigen::DenseIndex begin, Eigen::DenseIndex end,
+                           TIndex* found_true) {
     Eigen::DSizes<Eigen::DenseIndex, DIMS> dims = input.dimensions();
     Eigen::DSizes<TIndex, DIMS> strides;
 
@@ -110,14 +146,40 @@ struct Where<CPUDevice, DIMS, T, TIndex> {
     }
 
     Eigen::DenseIndex output_size = output.dimension(0);
-    for (Eigen::DenseIndex n = 0; n < input.size(); ++n) {
-      if (input.data()[n] != T(0)) {
+    const T* data = input.data();
+    Eigen::DenseIndex n = begin;
+    if constexpr (std::is_same<T, bool>::value) {
+      // Masks are usually sparse, so skip over words of false values.
+      for (; end - n >= static_cast<Eigen::DenseIndex>(sizeof(uint64_t));
+           n += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + n, sizeof(word));
+        if (word == 0) continue;
+        for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+          if (data[n + i]) {
+            if (FastBoundsCheck(*found_true, output_size)) {
+              WriteIndexRowMajor(output, strides, *found_true, n + i);
+            }
+            ++*found_true;
+          }
+        }
+      }
+    }
+    for (; n < end; ++n) {
+      if (data[n] != T(0)) {
         if (FastBoundsCheck(*found_true, output_size)) {
           WriteIndexRowMajor(output, strides, *found_true, n);
         }
         ++*found_true;
       }
     }
+  }
+
+  EIGEN_ALWAYS_INLINE static Status Compute(
+      OpKernelContext* ctx, const CPUDevice& d,
+      typename TTypes<T, DIMS>::ConstTensor input,
+      typename TTypes<int64_t>::Matrix output, TIndex* found_true) {
+    ComputeRange(input, output, 0, input.size(), found_true);
     return absl::OkStatus();
   }
 };
@@ -139,29 +201,72 @@ class WhereCPUOp : public OpKernel {
                               "creating costly copies from device."));
 
     const int input_dims = input.dims();
+    OP_REQUIRES(context, input_dims >= 1 && input_dims <= 8,
+                errors::InvalidArgument(
+                    "WhereOp : Unhandled input dimensions: ", input_dims));
+
+    // The elements are split into shards that are processed in two parallel
+    // phases: the true values of every shard are counted, and after a prefix
+    // sum of the counts each shard writes its indices at its own offset.
+    const int64_t num_elements = input.NumElements();
+    const int64_t num_shards =
+        functor::NumWhereShards(context, num_elements);
+    auto shard_begin = [&](int64_t shard) {
+      return shard * num_elements / num_shards;
+    };
+    auto* workers = context->device()->tensorflow_cpu_worker_threads()->workers;
+    const int64_t cost_per_shard = num_elements / num_shards;
 
     int64_t num_true;
     TTypes<int64_t>::UnalignedScalar num_true_t(&num_true);
-
-    Status s = functor::NumTrue<CPUDevice, T, int64_t>::Compute(
-        context, context->eigen_device<CPUDevice>(), input.flat<T>(),
-        num_true_t);
-    OP_REQUIRES_OK(context, s);
+    std::vector<int64_t> shard_offsets(num_shards + 1, 0);
+    if (num_shards == 1) {
+      Status s = functor::NumTrue<CPUDevice, T, int64_t>::Compute(
+          context, context->eigen_device<CPUDevice>(), input.flat<T>(),
+          num_true_t);
+      OP_REQUIRES_OK(context, s);
+    } else {
+      const T* data = input.flat<T>().data();
+      workers->ParallelFor(
+          num_shards, cost_per_shard, [&](int64_t begin, int64_t end) {
+            for (int64_t shard = begin; shard < end; ++shard) {
+              shard_offsets[shard + 1] = functor::CountAccumulator<T>(
+                  data + shard_begin(shard), data + shard_begin(shard + 1));
+            }
+          });
+      std::partial_sum(shard_offsets.begin(), shard_offsets.end(),
+                       shard_offsets.begin());
+      num_true = shard_offsets[num_shards];
+    }
     TensorShape output_shape({num_true, input_dims});
     Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
 
-    // TODO(ebrevdo): Replace single-threaded copy with a multithreaded block
-    // copy by getting block counts above instead of a global NumTrue, then
-    // having each block filled in separate threads below.
     int64_t found_true = 0;
 
-#define HANDLE_DIM(NDIM)                                                      \
-  case NDIM: {                                                                \
-    Status s = functor::Where<CPUDevice, NDIM, T, int64_t>::Compute(          \
-        context, context->eigen_device<CPUDevice>(), input.tensor<T, NDIM>(), \
-        output->matrix<int64_t>(), &found_true);                              \
-    OP_REQUIRES_OK(context, s);                                               \
+#define HANDLE_DIM(NDIM)                                                     \
+  case NDIM: {                                                               \
+    using WhereFunctor = functor::Where<CPUDevice, NDIM, T, int64_t>;        \
+    if (num_shards == 1) {                                                   \
+      Status s = WhereFunctor::Compute(                                      \
+          context, context->eigen_device<CPUDevice>(),                       \
+          input.tensor<T, NDIM>(), output->matrix<int64_t>(), &found_true);  \
+      OP_REQUIRES_OK(context, s);                                            \
+      break;                                                                 \
+    }                                                                        \
+    std::atomic<int64_t> shards_found_true(0);                               \
+    workers->ParallelFor(                                                    \
+        num_shards, cost_per_shard, [&](int64_t begin, int64_t end) {        \
+          for (int64_t shard = begin; shard < end; ++shard) {                \
+            int64_t shard_found_true = shard_offsets[shard];                 \
+            WhereFunctor::ComputeRange(                                      \
+                input.tensor<T, NDIM>(), output->matrix<int64_t>(),          \
+                shard_begin(shard), shard_begin(shard + 1),                  \
+                &shard_found_true);                                          \
+            shards_found_true += shard_found_true - shard_offsets[shard];    \
+          }                                                                  \
+        });                                                                  \
+    found_true = shards_found_true;                                          \
   } break;
 
     switch (input_dims) {
@@ -173,11 +278,6 @@ class WhereCPUOp : public OpKernel {
       HANDLE_DIM(6);
       HANDLE_DIM(7);
       HANDLE_DIM(8);
-
-      default:
-        OP_REQUIRES(context, false,
-                    errors::InvalidArgument(
-                        "WhereOp : Unhandled input dimensions: ", input_dims));
     }
 #undef HANDLE_DIM
 
@@ -372,6 +372,105 @@ void WinogradTransform<T>::GetOutputTransformMatrix(const int64_t rows,
   transform_matrix[3 * cols + 15] = T(1.0);
 };
 
+// Winograd F(4x4, 3x3) DeepConv2DTransform implementation for 3x3 filters.
+// Computes 4x4 output tiles from 6x6 input tiles, which takes 36 instead of
+// the 144 multiplications of a direct convolution per tile and input/output
+// depth pair (vs. 16 instead of 36 for the 2x2 output tiles above). The
+// transform matrices are larger, so this pays off for deep convolutions.
+template <typename T>
+class Winograd4x4Transform : public DeepConv2DTransform<T> {
+ public:
+  typedef typename DeepConv2DTransform<T>::Shape Shape;
+
+  Winograd4x4Transform()
+      : filter_shape_(3, 3), input_shape_(6, 6), output_shape_(4, 4) {}
+
+  // The filter transform matrix is the kronecker product 'G * G' of:
+  //
+  //   [  1/4     0     0   ]
+  //   [ -1/6  -1/6  -1/6   ]
+  //   [ -1/6   1/6  -1/6   ]
+  //   [  1/24  1/12  1/6   ]
+  //   [  1/24 -1/12  1/6   ]
+  //   [  0     0     1     ]
+  //
+  // Data layout: [input_tile_spatial_size, filter_spatial_size].
+  virtual void GetFilterTransformMatrix(const int64_t rows, const int64_t cols,
+                                        T* transform_matrix) const {
+    static constexpr double kG[6][3] = {
+        {1.0 / 4, 0, 0},
+        {-1.0 / 6, -1.0 / 6, -1.0 / 6},
+        {-1.0 / 6, 1.0 / 6, -1.0 / 6},
+        {1.0 / 24, 1.0 / 12, 1.0 / 6},
+        {1.0 / 24, -1.0 / 12, 1.0 / 6},
+        {0, 0, 1}};
+    SetKroneckerSquare(&kG[0][0], 6, 3, rows, cols, transform_matrix);
+  }
+
+  // The input transform matrix is the kronecker product 'B * B' of:
+  //
+  //   [ 4   0  -5   0   1   0 ]
+  //   [ 0  -4  -4   1   1   0 ]
+  //   [ 0   4  -4  -1   1   0 ]
+  //   [ 0  -2  -1   2   1   0 ]
+  //   [ 0   2  -1  -2   1   0 ]
+  //   [ 0   4   0  -5   0   1 ]
+  //
+  // Data layout: [tile_spatial_size, tile_spatial_size].
+  virtual void GetInputTransformMatrix(const int64_t rows, const int64_t cols,
+                                       T* transform_matrix) const {
+    static constexpr double kB[6][6] = {
+        {4, 0, -5, 0, 1, 0},  {0, -4, -4, 1, 1, 0}, {0, 4, -4, -1, 1, 0},
+        {0, -2, -1, 2, 1, 0}, {0, 2, -1, -2, 1, 0}, {0, 4, 0, -5, 0, 1}};
+    SetKroneckerSquare(&kB[0][0], 6, 6, rows, cols, transform_matrix);
+  }
+
+  // The output transform matrix is the kronecker product 'A * A' of:
+  //
+  //   [ 1   1   1   1   1   0 ]
+  //   [ 0   1  -1   2  -2   0 ]
+  //   [ 0   1   1   4   4   0 ]
+  //   [ 0   1  -1   8  -8   1 ]
+  //
+  // Data layout: [out_tile_spatial_size, tile_spatial_size].
+  virtual void GetOutputTransformMatrix(const int64_t rows, const int64_t cols,
+                                        T* transform_matrix) const {
+    static constexpr double kA[4][6] = {{1, 1, 1, 1, 1, 0},
+                                        {0, 1, -1, 2, -2, 0},
+                                        {0, 1, 1, 4, 4, 0},
+                                        {0, 1, -1, 8, -8, 1}};
+    SetKroneckerSquare(&kA[0][0], 4, 6, rows, cols, transform_matrix);
+  }
+
+  virtual const Shape& filter_shape() const { return filter_shape_; }
+  virtual const Shape& input_shape() const { return input_shape_; }
+  virtual const Shape& output_shape() const { return output_shape_; }
+
+ private:
+  // Sets 'transform_matrix' [rows, cols] to the kronecker product of the
+  // row-major matrix 'm' [m_rows, m_cols] with itself.
+  static void SetKroneckerSquare(const double* m, const int64_t m_rows,
+                                 const int64_t m_cols, const int64_t rows,
+                                 const int64_t cols, T* transform_matrix) {
+    CHECK_EQ(rows, m_rows * m_rows);
+    CHECK_EQ(cols, m_cols * m_cols);
+    for (int64_t i = 0; i < m_rows; ++i) {
+      for (int64_t j = 0; j < m_rows; ++j) {
+        T* row = transform_matrix + (i * m_rows + j) * cols;
+        for (int64_t k = 0; k < m_cols; ++k) {
+          for (int64_t l = 0; l < m_cols; ++l) {
+            row[k * m_cols + l] = T(m[i * m_cols + k] * m[j * m_cols + l]);
+          }
+        }
+      }
+    }
+  }
+
+  const Shape filter_shape_;
+  const Shape input_shape_;
+  const Shape output_shape_;
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_WINOGRAD_TRANSFORM_H_
@@ -25,6 +25,7 @@ namespace table {
 // NOLINTBEGIN(misc-unused-using-decls)
 using tsl::table::Cache;
 using tsl::table::NewLRUCache;
+using tsl::table::SharedBlockCache;
 // NOLINTEND(misc-unused-using-decls)
 }  // namespace table
 }  // namespace tensorflow
@@ -30,9 +30,11 @@ limitations under the License.
 namespace tensorflow {
 namespace io {
 // NOLINTBEGIN(misc-unused-using-decls)
+using tsl::io::RecordIndex;
 using tsl::io::RecordReader;
 using tsl::io::RecordReaderOptions;
 using tsl::io::SequentialRecordReader;
+using tsl::io::WriteRecordIndexFile;
 // NOLINTEND(misc-unused-using-decls)
 }  // namespace io
 }  // namespace tensorflow
@@ -14,7 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/nccl/nccl_manager.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
@@ -28,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/annotated_traceme.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 #if GOOGLE_CUDA
 #include "xla/stream_executor/gpu/scoped_activate_context.h"
 #elif TENSORFLOW_USE_ROCM
@@ -711,6 +715,30 @@ size_t ComputeBufferSize(const NcclManager::Participant* p,
   }
   return num_elements * DataTypeSize(data_type);
 }
+
+// Maximum number of collectives launched together in one NCCL group.
+int64_t MaxGroupLaunchSize() {
+  static const int64_t max_group_launch_size = [] {
+    int64_t value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_NCCL_MAX_GROUP_LAUNCH_SIZE",
+                                    /*default_val=*/64, &value));
+    return std::max<int64_t>(1, value);
+  }();
+  return max_group_launch_size;
+}
+
+// How long a stream waits for more collectives to become ready before
+// launching the ones it has. By default only the collectives that are already
+// ready are grouped, which adds no latency.
+int64_t GroupLaunchWindowMicros() {
+  static const int64_t group_launch_window_us = [] {
+    int64_t value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_NCCL_GROUP_LAUNCH_WINDOW_US",
+                                    /*default_val=*/0, &value));
+    return value;
+  }();
+  return group_launch_window_us;
+}
 }  // namespace
 
 void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
@@ -723,30 +751,15 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
   cudaStream_t cu_stream = reinterpret_cast<cudaStream_t>(
       comm_stream->platform_specific_handle().stream);
 
-  while (true) {
-    // Find collective to run.
-    std::pair<Collective*, int> next_launch;
-    {
-      VLOG(3) << "Locking mutex nccl_stream " << nccl_stream;
-      mutex_lock l(nccl_stream->mu);
-      while (nccl_stream->pending_launches_.empty()) {
-        if (nccl_stream->shutdown_requested) {
-          // No work and shutdown requested, exit.
-          return;
-        }
-        nccl_stream->cv.wait(l);
-      }
-      next_launch = nccl_stream->pending_launches_.back();
-      nccl_stream->pending_launches_.pop_back();
-    }
-
-    // Launch the nccl kernel.
-    Collective* collective = next_launch.first;
+  // Enqueues the kernel of participant `p_idx` of `collective` on the
+  // communication stream. Sets `status` and enqueues nothing if the
+  // participant is malformed.
+  auto launch_kernel = [&](Collective* collective, int p_idx,
+                           Status* status) -> ncclResult_t {
     tensorflow::profiler::TraceMeConsumer traceme("Run Collective",
                                                   collective->trace_context);
 
     ncclDataType_t data_type = ToNcclType(collective->data_type);
-    int p_idx = next_launch.second;
     Participant* p = collective->participants[p_idx].get();
     auto nccl_comm = collective->communicator->members[p_idx].nccl_comm;
     ncclResult_t nccl_result = ncclSuccess;
@@ -788,10 +801,9 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
           recvbuff = const_cast<void*>(sendbuff);
         }
         if (num_elements < 0) {
-          p->done_callback(errors::Internal(
-              "Both input and output are null in ncclBroadcast"));
-          collective->Unref();
-          continue;
+          *status = errors::Internal(
+              "Both input and output are null in ncclBroadcast");
+          return ncclSuccess;
         }
         VLOG(2) << "call NcclBroadcast collective_key "
                 << collective->collective_key << " participant " << p_idx
@@ -900,23 +912,110 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
         break;
       }
     }
+    return nccl_result;
+  };
+
+  const size_t max_group_launch_size = MaxGroupLaunchSize();
+  const int64_t group_launch_window_us = GroupLaunchWindowMicros();
+  std::vector<std::pair<Collective*, int>> launches;
+  std::vector<Status> launch_statuses;
+  std::vector<ncclResult_t> nccl_results;
+  while (true) {
+    // Find collectives to run. Collectives that are ready on the same
+    // communicator are launched together, as a single NCCL group, so that many
+    // small collectives pay for one launch and synchronization.
+    launches.clear();
+    {
+      VLOG(3) << "Locking mutex nccl_stream " << nccl_stream;
+      mutex_lock l(nccl_stream->mu);
+      while (nccl_stream->pending_launches_.empty()) {
+        if (nccl_stream->shutdown_requested) {
+          // No work and shutdown requested, exit.
+          return;
+        }
+        nccl_stream->cv.wait(l);
+      }
+      if (group_launch_window_us > 0) {
+        // Give more collectives a chance to become ready before launching.
+        const uint64 deadline_us =
+            Env::Default()->NowMicros() + group_launch_window_us;
+        while (nccl_stream->pending_launches_.size() < max_group_launch_size &&
+               !nccl_stream->shutdown_requested) {
+          const uint64 now_us = Env::Default()->NowMicros();
+          if (now_us >= deadline_us) break;
+          nccl_stream->cv.wait_for(
+              l, std::chrono::microseconds(deadline_us - now_us));
+        }
+      }
+      // Pending launches are queued in the same order on every stream, so the
+      // collectives of each communicator are issued in the same order on every
+      // member even when they are grouped differently.
+      const Communicator* communicator =
+          nccl_stream->pending_launches_.back().first->communicator;
+      while (!nccl_stream->pending_launches_.empty() &&
+             launches.size() < max_group_launch_size &&
+             nccl_stream->pending_launches_.back().first->communicator ==
+                 communicator) {
+        launches.push_back(nccl_stream->pending_launches_.back());
+        nccl_stream->pending_launches_.pop_back();
+      }
+    }
 
-    // Run the done_callback when the nccl kernel finishes running.
-    auto done_callback = [collective, p_idx, nccl_result]() {
-      VLOG(2) << "done Nccl kernel collective_key "
-              << collective->collective_key << " participant " << p_idx
-              << " ncclResult " << nccl_result;
-      if (nccl_result == ncclSuccess) {
-        collective->participants[p_idx]->done_callback(OkStatus());
-      } else {
-        // Propagate the error, but note that if other members of the collective
-        // did launch their kernels, then they are hanging.
-        collective->participants[p_idx]->done_callback(errors::Unknown(
-            "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
+    // Launch the nccl kernels.
+    const bool grouped = launches.size() > 1;
+    ncclResult_t group_result = ncclSuccess;
+    if (grouped) {
+      VLOG(2) << "Grouping " << launches.size() << " NCCL collectives";
+      group_result = ncclGroupStart();
+    }
+    launch_statuses.assign(launches.size(), OkStatus());
+    // If the group could not be started, none of its collectives is launched
+    // and all of them fail with the error of ncclGroupStart.
+    nccl_results.assign(launches.size(), group_result);
+    if (group_result == ncclSuccess) {
+      for (size_t i = 0; i < launches.size(); ++i) {
+        nccl_results[i] = launch_kernel(launches[i].first, launches[i].second,
+                                        &launch_statuses[i]);
+      }
+      if (grouped) {
+        // Errors of the grouped launches may only be reported by ncclGroupEnd.
+        group_result = ncclGroupEnd();
+        for (ncclResult_t& nccl_result : nccl_results) {
+          if (nccl_result == ncclSuccess) nccl_result = group_result;
+        }
+      }
+    } else {
+      LOG(ERROR) << "ncclGroupStart failed for " << launches.size()
+                 << " NCCL collectives: " << ncclGetErrorString(group_result);
+    }
+
+    for (size_t i = 0; i < launches.size(); ++i) {
+      Collective* collective = launches[i].first;
+      const int p_idx = launches[i].second;
+      Participant* p = collective->participants[p_idx].get();
+      if (!launch_statuses[i].ok()) {
+        p->done_callback(launch_statuses[i]);
+        collective->Unref();
+        continue;
       }
-      collective->Unref();
-    };
-    p->event_mgr->ThenExecute(comm_stream, done_callback);
+      const ncclResult_t nccl_result = nccl_results[i];
+      // Run the done_callback when the nccl kernel finishes running.
+      auto done_callback = [collective, p_idx, nccl_result]() {
+        VLOG(2) << "done Nccl kernel collective_key "
+                << collective->collective_key << " participant " << p_idx
+                << " ncclResult " << nccl_result;
+        if (nccl_result == ncclSuccess) {
+          collective->participants[p_idx]->done_callback(OkStatus());
+        } else {
+          // Propagate the error, but note that if other members of the
+          // collective did launch their kernels, then they are hanging.
+          collective->participants[p_idx]->done_callback(errors::Unknown(
+              "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
+        }
+        collective->Unref();
+      };
+      p->event_mgr->ThenExecute(comm_stream, done_callback);
+    }
   }
 }
 
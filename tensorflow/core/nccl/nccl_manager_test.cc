@@ -68,6 +68,8 @@ class NcclManagerTest : public ::testing::Test {
   static void SetUpTestSuite() {
     setenv("NCCL_DEBUG", "INFO", 1 /* replace */);
     setenv("NCCL_LAUNCH_MODE", "PARALLEL", 1 /* replace */);
+    // Let collectives that become ready together be launched as one group.
+    setenv("TF_NCCL_GROUP_LAUNCH_WINDOW_US", "1000", 1 /* replace */);
     devices_ = new std::vector<std::unique_ptr<BaseGPUDevice>>(GetGPUDevices());
     VLOG(1) << "Running test with " << devices_->size() << " gpus";
     if (devices_->size() <= 1) {
@@ -573,6 +575,63 @@ TYPED_TEST(NcclManagerTest, MultipleCallers) {
   }
 }
 
+// Many all-reduces and all-gathers on one communicator that become ready
+// together, so each stream launches them in NCCL groups.
+TYPED_TEST(NcclManagerTest, GroupedCollectives) {
+  const int num_ranks = this->NumGPUs();
+  const int num_collectives = 32;
+
+  std::vector<std::unique_ptr<typename TestFixture::TestCase>> test_cases;
+  for (int i = 0; i < num_collectives; ++i) {
+    if (i % 2 == 0) {
+      test_cases.emplace_back(this->MakeReductionTestCase(
+          /*num_nodes=*/1, num_ranks, ncclSum, TensorShape({i + 1, 3}),
+          0.5f * i));
+    } else {
+      test_cases.emplace_back(this->MakeGatherTestCase(
+          /*num_nodes=*/1, num_ranks, TensorShape({i, 2}),
+          TensorShape({i * num_ranks, 2})));
+    }
+  }
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    auto* device = this->GetDevice(num_ranks, /*node=*/0, rank);
+    auto* stream = device->tensorflow_accelerator_device_info()->stream;
+    TF_ASSERT_OK(stream->BlockHostUntilDone());
+  }
+
+  // The collectives are only ready once the last rank joins them, which it
+  // does for all of them in a row.
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    auto* device = this->GetDevice(num_ranks, /*node=*/0, rank);
+    auto* info = device->tensorflow_accelerator_device_info();
+    auto* stream = device->tensorflow_accelerator_device_info()->stream;
+    for (int i = 0; i < num_collectives; ++i) {
+      typename TestFixture::TestCase* test_case = test_cases[i].get();
+      auto participant = absl::make_unique<NcclManager::Participant>(
+          device->executor(), stream, info, &test_case->ins[rank],
+          &test_case->outs[rank], rank, this->CreateDoneCallback(test_case));
+      if (i % 2 == 0) {
+        NcclManager::instance()->AddToAllReduce(
+            std::move(participant),
+            {strings::StrCat("grouped", i), /*num_local_devices=*/num_ranks,
+             /*num_global_devices=*/num_ranks, /*communicator_key=*/"",
+             /*source_rank=*/-1},
+            ncclSum);
+      } else {
+        NcclManager::instance()->AddToAllGather(
+            std::move(participant),
+            {strings::StrCat("grouped", i), /*num_local_devices=*/num_ranks,
+             /*num_global_devices=*/num_ranks, /*communicator_key=*/"",
+             /*source_rank=*/-1});
+      }
+    }
+  }
+
+  for (int i = 0; i < num_collectives; ++i) {
+    this->VerifyResults(test_cases[i].get());
+  }
+}
+
 // Test basic all-gather.
 TYPED_TEST(NcclManagerTest, BasicAllGather) {
   const int num_ranks = this->NumGPUs();
@@ -1932,6 +1932,34 @@ REGISTER_OP("QuantizedMatMul")
       return absl::OkStatus();
     });
 
+REGISTER_OP("WeightOnlyQuantizedMatMul")
+    .Input("a: T")
+    .Input("b: int8")
+    .Input("scales: float")
+    .Output("product: T")
+    .Attr("T: {float, bfloat16}")
+    .Attr("num_bits: int = 8")
+    .Attr("group_size: int >= 0 = 0")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a));
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &b));
+      ShapeHandle scales;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &scales));
+
+      DimensionHandle n;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(b, 1), c->Dim(scales, 1), &n));
+      int32_t num_bits;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_bits", &num_bits));
+      if (num_bits == 8) {
+        DimensionHandle unused;
+        TF_RETURN_IF_ERROR(c->Merge(c->Dim(a, 1), c->Dim(b, 0), &unused));
+      }
+      c->set_output(0, c->Matrix(c->Dim(a, 0), n));
+      return absl::OkStatus();
+    });
+
 // Note: This op is not commutative w.r.t. to all its inputs.
 REGISTER_OP("QuantizedMul")
     .Input("x: T1")
@@ -1299,6 +1299,46 @@ REGISTER_OP("LogSoftmax")
       return shape_inference::UnchangedShapeWithRankAtLeast(c, 1);
     });
 
+REGISTER_OP("_FusedScaledDotProductAttention")
+    .Input("query: T")
+    .Input("key: T")
+    .Input("value: T")
+    .Input("scale: T")
+    .Input("mask: num_masks * T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("num_masks: int >= 0 = 0")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle query;
+      ShapeHandle key;
+      ShapeHandle value;
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 3, &query));
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(1), 3, &key));
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(2), 3, &value));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      // query and key share the depth, key and value the sequence length.
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(query, -1), c->Dim(key, -1), &unused_dim));
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(key, -2), c->Dim(value, -2), &unused_dim));
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->Subshape(query, 0, -1, &output));
+      TF_RETURN_IF_ERROR(
+          c->Concatenate(output, c->Vector(c->Dim(value, -1)), &output));
+      c->set_output(0, output);
+      return absl::OkStatus();
+    })
+    .Doc(R"doc(
+Computes softmax(query * key^T * scale + mask) * value over the last two
+dimensions, where the leading dimensions of query, key and value are batch
+dimensions and mask, if given, broadcasts to the attention scores.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 
 REGISTER_OP("SoftmaxCrossEntropyWithLogits")
@@ -14,7 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/summary/summary_file_writer.h"
 
+#include <algorithm>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -24,6 +27,8 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/summary/summary_converter.h"
 #include "tensorflow/core/util/events_writer.h"
 
@@ -32,11 +37,14 @@ namespace {
 
 class SummaryFileWriter : public SummaryWriterInterface {
  public:
-  SummaryFileWriter(int max_queue, int flush_millis, Env* env)
+  SummaryFileWriter(const SummaryFileWriterOptions& options, Env* env)
       : SummaryWriterInterface(),
         is_initialized_(false),
-        max_queue_(max_queue),
-        flush_millis_(flush_millis),
+        max_queue_(options.max_queue),
+        flush_millis_(options.flush_millis),
+        max_pending_events_(
+            std::max(options.max_pending_events, options.max_queue)),
+        drop_events_when_full_(options.drop_events_when_full),
         env_(env) {}
 
   Status Initialize(const string& logdir, const string& filename_suffix) {
@@ -63,6 +71,9 @@ class SummaryFileWriter : public SummaryWriterInterface {
         "Could not initialize events writer.");
     last_flush_ = env_->NowMicros();
     is_initialized_ = true;
+    writer_thread_.reset(env_->StartThread(ThreadOptions(),
+                                           "tf_summary_file_writer",
+                                           [this]() { WriterLoop(); }));
     return absl::OkStatus();
   }
 
@@ -71,11 +82,23 @@ class SummaryFileWriter : public SummaryWriterInterface {
     if (!is_initialized_) {
       return errors::FailedPrecondition("Class was not properly initialized.");
     }
-    return InternalFlush();
+    const int64_t flush_id = ++flushes_requested_;
+    writer_cv_.notify_one();
+    while (flushes_done_ < flush_id) {
+      caller_cv_.wait(ml);
+    }
+    return ConsumeWriterStatus();
   }
 
   ~SummaryFileWriter() override {
-    (void)Flush();  // Ignore errors.
+    {
+      mutex_lock ml(mu_);
+      shutdown_ = true;
+      writer_cv_.notify_one();
+    }
+    // Joins the writer thread, which writes and flushes the pending events
+    // before exiting. Errors are ignored.
+    writer_thread_.reset();
   }
 
   Status WriteTensor(int64_t global_step, Tensor t, const string& tag,
@@ -152,12 +175,25 @@ class SummaryFileWriter : public SummaryWriterInterface {
 
   Status WriteEvent(std::unique_ptr<Event> event) override {
     mutex_lock ml(mu_);
+    if (drop_events_when_full_ && num_pending_events_ >= max_pending_events_) {
+      LOG_EVERY_N_SEC(WARNING, 60)
+          << "Dropping summary events, as " << num_pending_events_
+          << " events are waiting to be written.";
+      writer_cv_.notify_one();
+      return ConsumeWriterStatus();
+    }
     queue_.emplace_back(std::move(event));
-    if (queue_.size() > max_queue_ ||
-        env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
-      return InternalFlush();
+    ++num_pending_events_;
+    if (FlushDue()) {
+      writer_cv_.notify_one();
     }
-    return absl::OkStatus();
+    // Apply backpressure until the writer thread has caught up. As
+    // `max_pending_events_ >= max_queue_`, the writer thread is either busy or
+    // has been notified above.
+    while (num_pending_events_ > max_pending_events_) {
+      caller_cv_.wait(ml);
+    }
+    return ConsumeWriterStatus();
   }
 
   string DebugString() const override { return "SummaryFileWriter"; }
@@ -167,37 +203,101 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status InternalFlush() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    for (const std::unique_ptr<Event>& e : queue_) {
+  bool FlushDue() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (static_cast<int64_t>(queue_.size()) > max_queue_) return true;
+    return !queue_.empty() &&
+           (flush_millis_ <= 0 ||
+            env_->NowMicros() - last_flush_ >
+                1000 * static_cast<uint64>(flush_millis_));
+  }
+
+  // Returns the first error of the writer thread since the last call.
+  Status ConsumeWriterStatus() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Status s = std::move(writer_status_);
+    writer_status_ = absl::OkStatus();
+    return s;
+  }
+
+  // Body of the writer thread. Takes all queued events whenever a flush is
+  // due or requested, and writes them with a single flush of the file.
+  void WriterLoop() {
+    while (true) {
+      std::vector<std::unique_ptr<Event>> batch;
+      int64_t flush_id;
+      bool shutdown;
+      {
+        mutex_lock ml(mu_);
+        while (!shutdown_ && flushes_requested_ == flushes_done_ &&
+               !FlushDue()) {
+          if (flush_millis_ > 0) {
+            WaitForMilliseconds(&ml, &writer_cv_, flush_millis_);
+          } else {
+            writer_cv_.wait(ml);
+          }
+        }
+        batch.swap(queue_);
+        flush_id = flushes_requested_;
+        shutdown = shutdown_;
+      }
+      const Status s = WriteAndFlush(batch);
+      {
+        mutex_lock ml(mu_);
+        if (!s.ok() && writer_status_.ok()) {
+          writer_status_ = s;
+        }
+        num_pending_events_ -= batch.size();
+        flushes_done_ = flush_id;
+        last_flush_ = env_->NowMicros();
+        caller_cv_.notify_all();
+        if (shutdown) return;
+      }
+    }
+  }
+
+  Status WriteAndFlush(const std::vector<std::unique_ptr<Event>>& batch) {
+    for (const std::unique_ptr<Event>& e : batch) {
       events_writer_->WriteEvent(*e);
     }
-    queue_.clear();
     TF_RETURN_WITH_CONTEXT_IF_ERROR(events_writer_->Flush(),
                                     "Could not flush events file.");
-    last_flush_ = env_->NowMicros();
     return absl::OkStatus();
   }
 
   bool is_initialized_;
   const int max_queue_;
   const int flush_millis_;
-  uint64 last_flush_;
+  const int max_pending_events_;
+  const bool drop_events_when_full_;
+  uint64 last_flush_ TF_GUARDED_BY(mu_);
   Env* env_;
   mutex mu_;
+  // Signals the writer thread that a flush is due, requested or that the
+  // writer is being destroyed.
+  condition_variable writer_cv_;
+  // Signals callers that the writer thread has written a batch.
+  condition_variable caller_cv_;
   std::vector<std::unique_ptr<Event>> queue_ TF_GUARDED_BY(mu_);
-  // A pointer to allow deferred construction.
-  std::unique_ptr<EventsWriter> events_writer_ TF_GUARDED_BY(mu_);
+  // Events in `queue_` plus the events being written by the writer thread.
+  int64_t num_pending_events_ TF_GUARDED_BY(mu_) = 0;
+  int64_t flushes_requested_ TF_GUARDED_BY(mu_) = 0;
+  int64_t flushes_done_ TF_GUARDED_BY(mu_) = 0;
+  bool shutdown_ TF_GUARDED_BY(mu_) = false;
+  Status writer_status_ TF_GUARDED_BY(mu_);
+  // A pointer to allow deferred construction. Only used by the writer thread
+  // once it has been started.
+  std::unique_ptr<EventsWriter> events_writer_;
+  std::unique_ptr<Thread> writer_thread_;
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
       TF_GUARDED_BY(mu_);
 };
 
 }  // namespace
 
-Status CreateSummaryFileWriter(int max_queue, int flush_millis,
+Status CreateSummaryFileWriter(const SummaryFileWriterOptions& options,
                                const string& logdir,
                                const string& filename_suffix, Env* env,
                                SummaryWriterInterface** result) {
-  SummaryFileWriter* w = new SummaryFileWriter(max_queue, flush_millis, env);
+  SummaryFileWriter* w = new SummaryFileWriter(options, env);
   const Status s = w->Initialize(logdir, filename_suffix);
   if (!s.ok()) {
     w->Unref();
@@ -208,4 +308,16 @@ Status CreateSummaryFileWriter(int max_queue, int flush_millis,
   return absl::OkStatus();
 }
 
+Status CreateSummaryFileWriter(int max_queue, int flush_millis,
+                               const string& logdir,
+                               const string& filename_suffix, Env* env,
+                               SummaryWriterInterface** result) {
+  SummaryFileWriterOptions options;
+  options.max_queue = max_queue;
+  options.flush_millis = flush_millis;
+  options.max_pending_events = max_queue;
+  return CreateSummaryFileWriter(options, logdir, filename_suffix, env,
+                                 result);
+}
+
 }  // namespace tensorflow
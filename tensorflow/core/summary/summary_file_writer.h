@@ -22,17 +22,46 @@ limitations under the License.
 
 namespace tensorflow {
 
+/// \brief Options for the summary writer created by CreateSummaryFileWriter.
+struct SummaryFileWriterOptions {
+  /// Number of events enqueued before they are written to the file.
+  int max_queue = 10;
+
+  /// The file is flushed at least every flush_millis milliseconds.
+  int flush_millis = 120000;
+
+  /// Number of events that may be waiting to be written before the writer
+  /// applies backpressure. Values smaller than max_queue are raised to it.
+  int max_pending_events = 10;
+
+  /// If true, events written while max_pending_events events are waiting are
+  /// dropped instead of blocking the caller until the file has been written.
+  bool drop_events_when_full = false;
+};
+
 /// \brief Creates SummaryWriterInterface which writes to a file.
 ///
 /// The file is an append-only records file of tf.Event protos. That
 /// makes this summary writer suitable for file systems like GCS.
 ///
+/// Events are written and flushed in batches by a background thread, so
+/// that callers do not block on file I/O unless more than
+/// max_pending_events events are waiting to be written. Errors of the
+/// background writes are returned by the next call to write or flush. The
+/// summaries will be written to the directory specified by logdir and with
+/// the filename suffixed by filename_suffix. The caller owns a reference to
+/// result if the returned status is ok. The Env object must not be destroyed
+/// until after the returned writer.
+Status CreateSummaryFileWriter(const SummaryFileWriterOptions& options,
+                               const string& logdir,
+                               const string& filename_suffix, Env* env,
+                               SummaryWriterInterface** result);
+
+/// \brief Creates SummaryWriterInterface which writes to a file.
+///
 /// It will enqueue up to max_queue summaries, and flush at least every
-/// flush_millis milliseconds. The summaries will be written to the
-/// directory specified by logdir and with the filename suffixed by
-/// filename_suffix. The caller owns a reference to result if the
-/// returned status is ok. The Env object must not be destroyed until
-/// after the returned writer.
+/// flush_millis milliseconds. Writing more than max_queue summaries blocks
+/// until they have been flushed.
 Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& logdir,
                                const string& filename_suffix, Env* env,
@@ -87,6 +87,30 @@ class SummaryFileWriterTest : public ::testing::Test {
     return absl::OkStatus();
   }
 
+  // Returns the number of events in the single file written for `test_name`.
+  int CountEvents(const string& test_name) {
+    std::vector<string> files;
+    TF_CHECK_OK(env_.GetChildren(testing::TmpDir(), &files));
+    int num_events = -1;
+    for (const string& f : files) {
+      if (absl::StrContains(f, test_name)) {
+        CHECK_EQ(num_events, -1) << "Found more than one file for "
+                                 << test_name;
+        std::unique_ptr<RandomAccessFile> read_file;
+        TF_CHECK_OK(env_.NewRandomAccessFile(io::JoinPath(testing::TmpDir(), f),
+                                             &read_file));
+        io::RecordReader reader(read_file.get(), io::RecordReaderOptions());
+        tstring record;
+        uint64 offset = 0;
+        num_events = 0;
+        while (reader.ReadRecord(&offset, &record).ok()) {
+          ++num_events;
+        }
+      }
+    }
+    return num_events;
+  }
+
   FakeClockEnv env_;
 };
 
@@ -281,5 +305,65 @@ TEST_F(SummaryFileWriterTest, AvoidFilenameCollision) {
       << "files = [" << absl::StrJoin(files, ", ") << "]";
 }
 
+TEST_F(SummaryFileWriterTest, WritesPendingEventsOnDestruction) {
+  const string test_name = "pending_events_on_destruction_test";
+  SummaryFileWriterOptions options;
+  options.max_queue = 1000;
+  options.flush_millis = 1000000;
+  options.max_pending_events = 1000;
+  SummaryWriterInterface* writer;
+  TF_CHECK_OK(CreateSummaryFileWriter(options, testing::TmpDir(), test_name,
+                                      &env_, &writer));
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  for (int step = 0; step < 100; ++step) {
+    TF_CHECK_OK(writer->WriteScalar(step, one, "name"));
+  }
+  writer->Unref();
+  // The first event is the file version.
+  EXPECT_EQ(101, CountEvents(test_name));
+}
+
+TEST_F(SummaryFileWriterTest, Backpressure) {
+  const string test_name = "backpressure_test";
+  SummaryFileWriterOptions options;
+  options.max_queue = 2;
+  options.flush_millis = 1000000;
+  options.max_pending_events = 4;
+  SummaryWriterInterface* writer;
+  TF_CHECK_OK(CreateSummaryFileWriter(options, testing::TmpDir(), test_name,
+                                      &env_, &writer));
+  core::ScopedUnref deleter(writer);
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  for (int step = 0; step < 100; ++step) {
+    TF_CHECK_OK(writer->WriteScalar(step, one, "name"));
+  }
+  TF_CHECK_OK(writer->Flush());
+  EXPECT_EQ(101, CountEvents(test_name));
+}
+
+TEST_F(SummaryFileWriterTest, DropEventsWhenFull) {
+  const string test_name = "drop_events_when_full_test";
+  SummaryFileWriterOptions options;
+  options.max_queue = 2;
+  options.flush_millis = 1000000;
+  options.max_pending_events = 2;
+  options.drop_events_when_full = true;
+  SummaryWriterInterface* writer;
+  TF_CHECK_OK(CreateSummaryFileWriter(options, testing::TmpDir(), test_name,
+                                      &env_, &writer));
+  core::ScopedUnref deleter(writer);
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  // The queue never exceeds `max_queue` and the fake clock does not advance,
+  // so nothing is written until the flush and all but two events are dropped.
+  for (int step = 0; step < 5; ++step) {
+    TF_CHECK_OK(writer->WriteScalar(step, one, "name"));
+  }
+  TF_CHECK_OK(writer->Flush());
+  EXPECT_EQ(3, CountEvents(test_name));
+}
+
 }  // namespace
 }  // namespace tensorflow
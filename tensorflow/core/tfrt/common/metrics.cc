@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 
 #include "absl/strings/str_cat.h"
+#include "xla/tsl/lib/monitoring/counter.h"
 #include "xla/tsl/lib/monitoring/sampler.h"
 
 namespace tensorflow {
@@ -45,5 +46,30 @@ tsl::monitoring::SamplerCell* GetTfrtDeviceExecutionLatency(
   return cell->GetCell(model_name, absl::StrCat(model_version));
 }
 
+tsl::monitoring::SamplerCell* GetIfrtCheckpointShardRestoreLatency() {
+  static auto* cell = tsl::monitoring::Sampler<0>::New(
+      {"/tfrt/ifrt/checkpoint_loader/shard_restore_latency",
+       "Tracks the latency of restoring a shard of variables from a "
+       "checkpoint (in microseconds)."},
+      tsl::monitoring::Buckets::Exponential(10, 1.5, 33));
+  return cell->GetCell();
+}
+
+tsl::monitoring::CounterCell* GetIfrtCheckpointRestoredBytes() {
+  static auto* cell = tsl::monitoring::Counter<0>::New(
+      "/tfrt/ifrt/checkpoint_loader/restored_bytes",
+      "Counts the bytes of variables restored from checkpoints.");
+  return cell->GetCell();
+}
+
+tsl::monitoring::SamplerCell* GetIfrtVariableDeviceTransferLatency() {
+  static auto* cell = tsl::monitoring::Sampler<0>::New(
+      {"/tfrt/ifrt/variable_device_transfer/latency",
+       "Tracks the latency of transferring a restored variable to its devices "
+       "(in microseconds)."},
+      tsl::monitoring::Buckets::Exponential(10, 1.5, 33));
+  return cell->GetCell();
+}
+
 }  // namespace tfrt_metrics
 }  // namespace tensorflow
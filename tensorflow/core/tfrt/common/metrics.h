@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstdint>
 #include <string>
 
+#include "xla/tsl/lib/monitoring/counter.h"
 #include "xla/tsl/lib/monitoring/sampler.h"
 
 namespace tensorflow {
@@ -31,6 +32,17 @@ tsl::monitoring::SamplerCell* GetTfrtGraphExecutorLatencySampler(
 tsl::monitoring::SamplerCell* GetTfrtDeviceExecutionLatency(
     const std::string& model_name, int64_t model_version);
 
+// Tracks the latency of restoring a shard of the variables of an IFRT model
+// from its checkpoint (in microseconds).
+tsl::monitoring::SamplerCell* GetIfrtCheckpointShardRestoreLatency();
+
+// Counts the bytes of variables restored from checkpoints by IFRT models.
+tsl::monitoring::CounterCell* GetIfrtCheckpointRestoredBytes();
+
+// Tracks the latency of transferring a restored variable to its devices (in
+// microseconds).
+tsl::monitoring::SamplerCell* GetIfrtVariableDeviceTransferLatency();
+
 }  // namespace tfrt_metrics
 }  // namespace tensorflow
 
@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/tfrt/fallback/cost_recorder.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <limits>
 #include <string>
 
@@ -51,6 +55,34 @@ uint64_t CostRecorder::GetCost(int64_t op_key) const {
   return r;
 }
 
+absl::flat_hash_map<int64_t, uint64_t> CostRecorder::GetCosts() const {
+  absl::flat_hash_map<int64_t, uint64_t> costs;
+  tf_shared_lock l(op_cost_map_mutex_);
+  costs.reserve(op_cost_map_.size());
+  for (const auto& [op_key, op_cost] : op_cost_map_) {
+    costs[op_key] = std::max(static_cast<uint64_t>(1),
+                             static_cast<uint64_t>(op_cost.first /
+                                                   op_cost.second));
+  }
+  return costs;
+}
+
+double CostRecorder::MaxRelativeCostDrift(
+    const absl::flat_hash_map<int64_t, uint64_t>& costs) const {
+  double max_drift = 0.0;
+  tf_shared_lock l(op_cost_map_mutex_);
+  for (const auto& [op_key, op_cost] : op_cost_map_) {
+    const auto iter = costs.find(op_key);
+    if (iter == costs.end()) return std::numeric_limits<double>::infinity();
+    const double recorded_cost = std::max(
+        1.0, static_cast<double>(op_cost.first) / op_cost.second);
+    const double compiled_cost = std::max<uint64_t>(1, iter->second);
+    max_drift = std::max(
+        max_drift, std::abs(recorded_cost - compiled_cost) / compiled_cost);
+  }
+  return max_drift;
+}
+
 Status CostRecorder::WriteToFile() const {
   OpCostMapProto op_cost_map_proto;
   {
@@ -42,6 +42,16 @@ class CostRecorder {
   // otherwise adding op costs would cause overflow.
   uint64_t GetCost(int64_t op_key) const;
 
+  // Returns the normalized average execution durations of all recorded ops.
+  absl::flat_hash_map<int64_t, uint64_t> GetCosts() const;
+
+  // Returns the largest relative difference between the recorded cost of an op
+  // and its cost in `costs`, e.g. the costs an executable was compiled with.
+  // An op missing from `costs` counts as an infinite difference; ops that are
+  // not recorded are ignored, as they may simply not have been sampled.
+  double MaxRelativeCostDrift(
+      const absl::flat_hash_map<int64_t, uint64_t>& costs) const;
+
   // Writes the op cost map (in format of `OpCostMapProto`) to a file specified
   // by the env var name `MesuredCostPathEnvVarName()`.
   // TODO(b/263837451): Fix the op_key unstableness during serialization.
@@ -56,6 +56,37 @@ TEST(CostRecorderTest, GetCostDefaultValueTest) {
             std::numeric_limits<uint32_t>::max());
 }
 
+TEST(CostRecorderTest, GetCostsTest) {
+  CostRecorder recorder;
+
+  recorder.RecordCost(kTestOpKey, kTestCost);
+  recorder.RecordCost(kTestOpKey, 2 * kTestCost);
+  recorder.RecordCost(kTestOpKey + 1, 0);
+
+  const auto costs = recorder.GetCosts();
+  ASSERT_EQ(costs.size(), 2);
+  EXPECT_EQ(costs.at(kTestOpKey), kTestAvgCost);
+  EXPECT_EQ(costs.at(kTestOpKey + 1), 1);
+}
+
+TEST(CostRecorderTest, MaxRelativeCostDriftTest) {
+  CostRecorder recorder;
+  recorder.RecordCost(kTestOpKey, 150);
+  recorder.RecordCost(kTestOpKey + 1, 100);
+
+  EXPECT_DOUBLE_EQ(
+      recorder.MaxRelativeCostDrift({{kTestOpKey, 100}, {kTestOpKey + 1, 100}}),
+      0.5);
+  // Ops that are compiled with a cost but not recorded are ignored.
+  EXPECT_DOUBLE_EQ(recorder.MaxRelativeCostDrift({{kTestOpKey, 150},
+                                                  {kTestOpKey + 1, 100},
+                                                  {kTestOpKey + 2, 100}}),
+                   0.0);
+  // Ops that are recorded but not compiled with a cost always drift.
+  EXPECT_EQ(recorder.MaxRelativeCostDrift({{kTestOpKey, 150}}),
+            std::numeric_limits<double>::infinity());
+}
+
 TEST(CostRecorderTest, WriteToFileTest) {
   CostRecorder recorder;
   ASSERT_EQ(recorder.size(), 0);
@@ -18,12 +18,39 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/base/casts.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 
 namespace tensorflow {
 namespace tfrt_stub {
 
+namespace {
+
+absl::StatusOr<OpKernelRunner> CreateOpKernelRunner(
+    tfrt::Location loc, absl::string_view op_name,
+    absl::string_view device_name, int num_args,
+    const std::function<Status(tensorflow::AttrValueMap*)>& attr_builder,
+    const tensorflow::DeviceMgr& device_manager,
+    const tensorflow::ProcessFunctionLibraryRuntime&
+        process_function_library_runtime) {
+  VLOG(1) << "KernelFallbackExecuteCompat creating op " << op_name
+          << " at location " << loc.data << " on device " << device_name;
+
+  std::string node_name = absl::StrCat(
+      op_name, "_", loc.data, "_", absl::bit_cast<uintptr_t>(loc.GetHandler()));
+
+  return OpKernelRunner::Create(op_name, node_name, device_name, num_args,
+                                attr_builder, device_manager,
+                                process_function_library_runtime);
+}
+
+}  // namespace
+
 absl::StatusOr<OpKernelRunner*> OpKernelRunnerCache::GetOrCreate(
     tfrt::Location loc, absl::string_view op_name,
     absl::string_view device_name, int num_args,
@@ -32,6 +59,11 @@ absl::StatusOr<OpKernelRunner*> OpKernelRunnerCache::GetOrCreate(
     const tensorflow::ProcessFunctionLibraryRuntime&
         process_function_library_runtime) {
   OpLocationKey key(loc);
+  if (auto* runner = Lookup(key)) {
+    DCHECK_EQ(runner->op_kernel()->def().op(), op_name);
+    return runner;
+  }
+
   {
     tf_shared_lock lock(mu_);
     auto it = map_.find(key);
@@ -49,16 +81,10 @@ absl::StatusOr<OpKernelRunner*> OpKernelRunnerCache::GetOrCreate(
     return it->second.get();
   }
 
-  VLOG(1) << "KernelFallbackExecuteCompat creating op " << op_name
-          << " at location " << loc.data << " on device " << device_name;
-
-  std::string node_name = absl::StrCat(
-      op_name, "_", loc.data, "_", absl::bit_cast<uintptr_t>(loc.GetHandler()));
-
   TF_ASSIGN_OR_RETURN(
-      auto runner, OpKernelRunner::Create(
-                       op_name, node_name, device_name, num_args, attr_builder,
-                       device_manager, process_function_library_runtime));
+      auto runner,
+      CreateOpKernelRunner(loc, op_name, device_name, num_args, attr_builder,
+                           device_manager, process_function_library_runtime));
 
   auto runner_uptr = std::make_unique<OpKernelRunner>(std::move(runner));
 
@@ -66,8 +92,80 @@ absl::StatusOr<OpKernelRunner*> OpKernelRunnerCache::GetOrCreate(
   auto r = map_.emplace(key, std::move(runner_uptr)).second;
   DCHECK(r);
 
+  const Snapshot* snapshot = snapshot_.load(std::memory_order_relaxed);
+  if (snapshot == nullptr || map_.size() >= 2 * snapshot->size()) {
+    PublishSnapshot();
+  }
+
   return runner_ptr;
 }
 
+Status OpKernelRunnerCache::Prepopulate(
+    absl::Span<const OpSpec> specs, const tensorflow::DeviceMgr& device_manager,
+    const tensorflow::ProcessFunctionLibraryRuntime&
+        process_function_library_runtime,
+    const std::function<void(std::function<void()>)>& runner) {
+  std::vector<const OpSpec*> missing_specs;
+  {
+    tf_shared_lock lock(mu_);
+    for (const auto& spec : specs) {
+      if (!map_.contains(OpLocationKey(spec.loc))) {
+        missing_specs.push_back(&spec);
+      }
+    }
+  }
+
+  std::vector<absl::StatusOr<OpKernelRunner>> runners(missing_specs.size());
+  auto create = [&](size_t i) {
+    const OpSpec& spec = *missing_specs[i];
+    runners[i] = CreateOpKernelRunner(
+        spec.loc, spec.op_name, spec.device_name, spec.num_args,
+        spec.attr_builder, device_manager, process_function_library_runtime);
+  };
+  if (runner) {
+    BlockingCounter counter(missing_specs.size());
+    for (size_t i = 0; i < missing_specs.size(); ++i) {
+      runner([&, i]() {
+        create(i);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  } else {
+    for (size_t i = 0; i < missing_specs.size(); ++i) create(i);
+  }
+
+  Status status;
+  mutex_lock lock(mu_);
+  for (size_t i = 0; i < missing_specs.size(); ++i) {
+    if (!runners[i].ok()) {
+      status.Update(runners[i].status());
+      continue;
+    }
+    // A concurrent GetOrCreate() may have created the same runner meanwhile.
+    map_.try_emplace(OpLocationKey(missing_specs[i]->loc),
+                     std::make_unique<OpKernelRunner>(*std::move(runners[i])));
+  }
+  PublishSnapshot();
+  return status;
+}
+
+OpKernelRunner* OpKernelRunnerCache::Lookup(const OpLocationKey& key) const {
+  const Snapshot* snapshot = snapshot_.load(std::memory_order_acquire);
+  if (snapshot == nullptr) return nullptr;
+  auto it = snapshot->find(key);
+  return it == snapshot->end() ? nullptr : it->second;
+}
+
+void OpKernelRunnerCache::PublishSnapshot() {
+  auto snapshot = std::make_unique<Snapshot>();
+  snapshot->reserve(map_.size());
+  for (const auto& [key, runner] : map_) {
+    snapshot->emplace(key, runner.get());
+  }
+  snapshot_.store(snapshot.get(), std::memory_order_release);
+  snapshots_.push_back(std::move(snapshot));
+}
+
 }  // namespace tfrt_stub
 }  // namespace tensorflow
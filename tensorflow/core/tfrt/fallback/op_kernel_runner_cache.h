@@ -15,10 +15,15 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_TFRT_FALLBACK_OP_KERNEL_RUNNER_CACHE_H_
 #define TENSORFLOW_CORE_TFRT_FALLBACK_OP_KERNEL_RUNNER_CACHE_H_
 
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner.h"
 #include "tfrt/host_context/location.h"  // from @tf_runtime
 
@@ -47,8 +52,23 @@ class OpLocationKey {
 };
 
 // OpKernelRunnerCache is similar to OpKernelRunnerTable but thread-safe.
+//
+// Lookups of existing runners do not take any lock: they read an immutable
+// snapshot of the cache, which is republished whenever the cache has doubled
+// in size since the last snapshot, or after Prepopulate(). Only the lookups
+// that miss the snapshot go through the mutex.
 class OpKernelRunnerCache {
  public:
+  // Describes a runner to create ahead of time. See GetOrCreate() for the
+  // meaning of the fields.
+  struct OpSpec {
+    tfrt::Location loc;
+    std::string op_name;
+    std::string device_name;
+    int num_args = 0;
+    std::function<Status(tensorflow::AttrValueMap*)> attr_builder;
+  };
+
   OpKernelRunnerCache() = default;
 
   absl::StatusOr<OpKernelRunner*> GetOrCreate(
@@ -59,10 +79,37 @@ class OpKernelRunnerCache {
       const tensorflow::ProcessFunctionLibraryRuntime&
           process_function_library_runtime);
 
+  // Creates the runners for `specs` that are not in the cache yet, e.g. when
+  // loading a model, so that the first requests do not pay for creating the
+  // kernels. The runners are created in parallel on `runner` if it is set, and
+  // sequentially otherwise. Returns the first error, if any; the runners that
+  // were created successfully are cached regardless.
+  Status Prepopulate(
+      absl::Span<const OpSpec> specs,
+      const tensorflow::DeviceMgr& device_manager,
+      const tensorflow::ProcessFunctionLibraryRuntime&
+          process_function_library_runtime,
+      const std::function<void(std::function<void()>)>& runner = nullptr);
+
  private:
+  using Snapshot = absl::flat_hash_map<OpLocationKey, OpKernelRunner*>;
+
+  // Returns the cached runner for `key` or nullptr.
+  OpKernelRunner* Lookup(const OpLocationKey& key) const;
+
+  // Publishes a snapshot of `map_`.
+  void PublishSnapshot() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  std::atomic<const Snapshot*> snapshot_{nullptr};
+
   mutable mutex mu_;
   absl::flat_hash_map<OpLocationKey, std::unique_ptr<OpKernelRunner>> map_
       TF_GUARDED_BY(mu_);
+  // All the snapshots published so far. Older snapshots may still be read by
+  // concurrent lookups, so they are only deleted with the cache. As snapshots
+  // are republished when the cache doubles, they take at most twice the memory
+  // of the latest one.
+  std::vector<std::unique_ptr<const Snapshot>> snapshots_ TF_GUARDED_BY(mu_);
 };
 
 }  // namespace tfrt_stub
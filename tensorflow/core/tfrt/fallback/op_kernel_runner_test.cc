@@ -14,10 +14,14 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner.h"
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/device_factory.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -25,7 +29,9 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/tfrt/fallback/fallback_state.h"
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner_cache.h"
@@ -126,6 +132,75 @@ TEST(OpKernelRunnerTest, OpKernelRunnerCache) {
   EXPECT_EQ(runner->op_kernel()->name(), "TestOp_100_0");
 }
 
+TEST(OpKernelRunnerTest, OpKernelRunnerCachePrepopulate) {
+  tensorflow::SessionOptions session_options;
+  tensorflow::FunctionDefLibrary fdef_lib;
+  TF_ASSERT_OK_AND_ASSIGN(auto fallback_state,
+                          FallbackState::Create(session_options, fdef_lib));
+
+  std::vector<OpKernelRunnerCache::OpSpec> specs;
+  for (int i = 0; i < 8; ++i) {
+    OpKernelRunnerCache::OpSpec spec;
+    spec.loc = tfrt::Location(/*handler=*/nullptr, /*data=*/i);
+    spec.op_name = "TestOp";
+    spec.device_name = "/job:localhost/replica:0/task:0/device:CPU:0";
+    spec.num_args = 1;
+    spec.attr_builder = [](tensorflow::AttrValueMap*) {
+      return absl::OkStatus();
+    };
+    specs.push_back(std::move(spec));
+  }
+
+  OpKernelRunnerCache cache;
+  thread::ThreadPool thread_pool(Env::Default(), "test", /*num_threads=*/4);
+  TF_ASSERT_OK(cache.Prepopulate(
+      specs, fallback_state->device_manager(),
+      fallback_state->process_function_library_runtime(),
+      [&](std::function<void()> fn) { thread_pool.Schedule(std::move(fn)); }));
+
+  for (int i = 0; i < 8; ++i) {
+    // The attribute builder must not be called for prepopulated runners.
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto* runner,
+        cache.GetOrCreate(
+            tfrt::Location(/*handler=*/nullptr, /*data=*/i),
+            /*op_name=*/"TestOp",
+            /*device_name=*/"/job:localhost/replica:0/task:0/device:CPU:0",
+            /*num_args=*/1,
+            /*attr_builder=*/
+            [](tensorflow::AttrValueMap*) {
+              return absl::InternalError("Unexpected creation");
+            },
+            fallback_state->device_manager(),
+            fallback_state->process_function_library_runtime()));
+    ASSERT_TRUE(runner);
+    EXPECT_EQ(runner->op_kernel()->name(), absl::StrCat("TestOp_", i, "_0"));
+  }
+
+  // A spec that fails is reported, and does not prevent caching the others.
+  specs[0].loc = tfrt::Location(/*handler=*/nullptr, /*data=*/100);
+  specs[0].op_name = "UnknownOp";
+  specs[1].loc = tfrt::Location(/*handler=*/nullptr, /*data=*/101);
+  Status status = cache.Prepopulate(
+      absl::MakeConstSpan(specs).first(2), fallback_state->device_manager(),
+      fallback_state->process_function_library_runtime());
+  EXPECT_FALSE(status.ok());
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto* runner,
+      cache.GetOrCreate(
+          tfrt::Location(/*handler=*/nullptr, /*data=*/101),
+          /*op_name=*/"TestOp",
+          /*device_name=*/"/job:localhost/replica:0/task:0/device:CPU:0",
+          /*num_args=*/1,
+          /*attr_builder=*/
+          [](tensorflow::AttrValueMap*) {
+            return absl::InternalError("Unexpected creation");
+          },
+          fallback_state->device_manager(),
+          fallback_state->process_function_library_runtime()));
+  EXPECT_EQ(runner->op_kernel()->name(), "TestOp_101_0");
+}
+
 TEST(OpKernelRunnerTest, OpKernelRunState) {
   SessionOptions options;
   auto* device_count = options.config.mutable_device_count();
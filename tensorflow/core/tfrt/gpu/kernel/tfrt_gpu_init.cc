@@ -14,12 +14,18 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/tfrt/gpu/kernel/tfrt_gpu_init.h"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <utility>
 
 #include "absl/status/status.h"
+#include "xla/tsl/framework/device_id.h"
+#include "xla/tsl/framework/serving_device_selector.h"
 #include "xla/tsl/framework/serving_device_selector_policies.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_serving_device_selector.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/tfrt/gpu/kernel/gpu_runner.h"
 #include "tensorflow/core/tfrt/runtime/runtime.h"
@@ -27,13 +33,39 @@ limitations under the License.
 
 namespace tensorflow {
 namespace gpu {
+namespace {
+
+// Returns the memory that the allocator of the GPU can still hand out, or -1
+// if unknown.
+int64_t FreeGpuMemoryBytes(int device_index) {
+  Allocator* allocator = GPUProcessState::singleton()->GetGPUAllocator(
+      tsl::TfDeviceId(device_index));
+  if (allocator == nullptr) return -1;
+  std::optional<AllocatorStats> stats = allocator->GetStats();
+  if (!stats.has_value() || !stats->bytes_limit.has_value()) return -1;
+  return *stats->bytes_limit - stats->bytes_in_use;
+}
+
+}  // namespace
 
 Status InitTfrtGpu(const GpuRunnerOptions& options,
                    tensorflow::tfrt_stub::Runtime& runtime) {
-  auto policy = std::make_unique<tsl::RoundRobinPolicy>();
+  std::unique_ptr<tsl::ServingDeviceSelector::Policy> policy;
+  GpuServingDeviceSelector::FreeMemoryFn free_memory_fn;
+  switch (options.serving_selector_policy) {
+    case tsl::ServingDeviceSelectorPolicy::kRoundRobin:
+      policy = std::make_unique<tsl::RoundRobinPolicy>();
+      break;
+    case tsl::ServingDeviceSelectorPolicy::kLoadAndMemoryAware:
+      policy = std::make_unique<GpuLoadAwarePolicy>(
+          options.serving_selector_min_free_memory_bytes);
+      free_memory_fn = FreeGpuMemoryBytes;
+      break;
+  }
   auto serving_device_selector =
       std::make_unique<tensorflow::gpu::GpuServingDeviceSelector>(
-          options.num_gpu_streams, std::move(policy));
+          options.num_gpu_streams, std::move(policy),
+          std::move(free_memory_fn));
 
   // We need to move `serving_device_selector` to the heap here, as
   // `AddCreateRuntimeResourceFn` requires a copyable callback.
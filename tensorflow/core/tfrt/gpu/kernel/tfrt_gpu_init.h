@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #ifndef TENSORFLOW_CORE_TFRT_GPU_KERNEL_TFRT_GPU_INIT_H_
 #define TENSORFLOW_CORE_TFRT_GPU_KERNEL_TFRT_GPU_INIT_H_
+#include <cstdint>
+
 #include "xla/tsl/framework/serving_device_selector_policies.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/tfrt/runtime/runtime.h"
@@ -25,6 +27,9 @@ struct GpuRunnerOptions {
   int num_gpu_streams = 1;
   tsl::ServingDeviceSelectorPolicy serving_selector_policy =
       tsl::ServingDeviceSelectorPolicy::kRoundRobin;
+  // With kLoadAndMemoryAware, GPUs whose allocator has less memory free are
+  // only selected if no GPU has this much free.
+  int64_t serving_selector_min_free_memory_bytes = 0;
 };
 
 Status InitTfrtGpu(const GpuRunnerOptions& options,
@@ -123,7 +123,9 @@ std::ostream& operator<<(std::ostream& os,
             << ", enable_grappler_function_optimizer = "
             << options.enable_grappler_function_optimizer
             << ", enable_tfrt_gpu = " << options.enable_tfrt_gpu
-            << ", use_ifrt = " << options.use_ifrt << ", runtime = "
+            << ", use_ifrt = " << options.use_ifrt
+            << ", mlrt_bytecode_cache_dir = " << options.mlrt_bytecode_cache_dir
+            << ", runtime = "
             << options.runtime
             // clang-tidy off
             << ", model_metadata = "
@@ -96,6 +96,17 @@ struct GraphExecutionOptions {
     // Number of times to record costs before resetting Op cost estimates.
     // However, a reset always occurs after the first execution.
     int updates_per_interval = 1;
+
+    // Upon reset, the executable is only recompiled if the measured cost of
+    // some op differs from the cost it was last compiled with by at least this
+    // fraction, e.g. 0.2 for 20%. With the default of 0, every reset
+    // recompiles.
+    double recompilation_cost_drift_threshold = 0.0;
+
+    // If true, recompilation runs in the background and the new executable is
+    // swapped in once it is ready, instead of delaying the request that
+    // triggers it. Costs are not recorded while a recompilation is pending.
+    bool recompile_in_background = false;
   };
 
   CostAnalysisOptions cost_analysis_options;
@@ -108,6 +119,13 @@ struct GraphExecutionOptions {
   // This option is experimental.
   bool use_ifrt = false;
 
+  // If not empty, the MLRT bytecode compiled for a client graph is stored in
+  // this directory, keyed by the imported graph and `compile_options`, and
+  // later loads of the same graph (e.g. in another process) reuse it instead of
+  // compiling again. Only used for CPU models without a backend compiler or
+  // online cost analysis.
+  std::string mlrt_bytecode_cache_dir;
+
   tensorflow::TfrtCompileOptions compile_options;
 };
 
@@ -17,10 +17,12 @@ limitations under the License.
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <numeric>
 #include <optional>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -38,6 +40,7 @@ limitations under the License.
 #include "absl/types/span.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/Extensions/AllExtensions.h"  // from @llvm-project
 #include "mlir/Dialect/Func/IR/FuncOps.h"  // from @llvm-project
 #include "mlir/IR/BuiltinAttributes.h"  // from @llvm-project
@@ -65,6 +68,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/tstring.h"
@@ -97,7 +101,9 @@ limitations under the License.
 #include "tensorflow/core/tfrt/utils/fallback_tensor.h"
 #include "tensorflow/core/tfrt/utils/tfrt_graph_execution_state.h"
 #include "tensorflow/core/tfrt/utils/utils.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
+#include "tsl/platform/path.h"
 #include "tsl/platform/refcount.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/profiler/lib/traceme.h"
@@ -501,6 +507,11 @@ GraphExecutor::GraphExecutor(
   SetSessionCreatedMetric();
 }
 
+GraphExecutor::~GraphExecutor() {
+  tensorflow::mutex_lock l(loaded_client_graphs_mu_);
+  loaded_client_graphs_.clear();
+}
+
 absl::StatusOr<std::unique_ptr<GraphExecutor>> GraphExecutor::Create(
     Options options, std::unique_ptr<FallbackState> fallback_state,
     std::unique_ptr<tfrt::ResourceContext> resource_context,
@@ -560,6 +571,75 @@ void CreateSortedNamesAndOriginalIndices(absl::Span<const std::string> names,
   }
 }
 
+// Returns true if the MLRT bytecode of client graphs may be cached in
+// `options.mlrt_bytecode_cache_dir`. The bytecode is reusable only if compiling
+// it has no side effect other than producing it: backend compilers and non-CPU
+// targets register programs and functions with the runtime while compiling,
+// and online cost analysis needs the compiler's intermediate module.
+bool UseMlrtBytecodeCache(const GraphExecutionOptions& options) {
+  return !options.mlrt_bytecode_cache_dir.empty() &&
+         options.compile_options.backend_compiler == nullptr &&
+         options.compile_options.device_target ==
+             TfrtDeviceInfraTarget::kCpu &&
+         options.cost_analysis_options.version ==
+             GraphExecutionOptions::CostAnalysisOptions::kDisabled;
+}
+
+// Returns the path in `cache_dir` of the MLRT bytecode compiled from the
+// imported client graph `module` with `compile_options`.
+std::string GetMlrtBytecodeCachePath(
+    absl::string_view cache_dir, mlir::ModuleOp module,
+    const TfrtCompileOptions& compile_options) {
+  std::ostringstream options_string;
+  options_string << compile_options;
+  std::string data = absl::StrCat(TF_VERSION_STRING, ";", TF_GRAPH_DEF_VERSION,
+                                  ";", options_string.str(), ";");
+  llvm::raw_string_ostream os(data);
+  module.print(os);
+  os.flush();
+  const Fprint128 fingerprint = Fingerprint128(data);
+  return tsl::io::JoinPath(
+      cache_dir,
+      absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                   absl::Hex(fingerprint.low64, absl::kZeroPad16), ".mlrt"));
+}
+
+// Reads the cached bytecode at `path`. Returns nullopt if there is none or it
+// is unreadable, in which case the graph is compiled again.
+std::optional<mlrt::bc::Buffer> ReadMlrtBytecodeCache(const std::string& path) {
+  tsl::Env* env = tsl::Env::Default();
+  if (!env->FileExists(path).ok()) return std::nullopt;
+  std::string data;
+  if (auto status = tsl::ReadFileToString(env, path, &data); !status.ok()) {
+    LOG(WARNING) << "Ignoring unreadable MLRT bytecode cache entry " << path
+                 << ": " << status;
+    return std::nullopt;
+  }
+  mlrt::bc::Buffer buffer;
+  mlrt::bc::Allocator allocator(&buffer);
+  allocator.Allocate(data.size(), alignof(char));
+  std::memcpy(buffer.data(), data.data(), data.size());
+  return buffer;
+}
+
+// Stores `bytecode` at `path`. The bytecode is written to a file of a unique
+// name first, so that concurrent loads never read a partially written entry.
+absl::Status WriteMlrtBytecodeCache(const std::string& path,
+                                    const mlrt::bc::Buffer& bytecode) {
+  tsl::Env* env = tsl::Env::Default();
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(tsl::io::Dirname(path)));
+  std::string temp_path = path;
+  if (!env->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return absl::InternalError(
+        absl::StrCat("Could not create a unique file name for ", path));
+  }
+  TF_RETURN_IF_ERROR(tsl::WriteStringToFile(
+      env, temp_path, absl::string_view(bytecode.data(), bytecode.size())));
+  absl::Status status = env->RenameFile(temp_path, path);
+  if (!status.ok()) env->DeleteFile(temp_path).IgnoreError();
+  return status;
+}
+
 }  // namespace
 
 tensorflow::Status GraphExecutor::Run(
@@ -654,13 +734,10 @@ tensorflow::Status GraphExecutor::Run(
       cost_recorder));
 
   if (do_recompilation) {
-    TF_RETURN_IF_ERROR(
-        loaded_client_graph.UpdateCost(*cost_recorder, runtime()));
-    tensorflow::mutex_lock l(num_recompilations_mu_);
-    num_recompilations_ += 1;
-  }
-  if (cost_recorder != nullptr) {
-    loaded_client_graph.UpdateCostAnalysisData(now, do_recompilation);
+    TF_RETURN_IF_ERROR(loaded_client_graph.MaybeRecompile(now, runtime()));
+  } else if (cost_recorder != nullptr) {
+    loaded_client_graph.UpdateCostAnalysisData(now,
+                                               /*do_recompilation=*/false);
   }
   // Create the outputs from the actual function results, which are sorted
   // according to the output tensor names.
@@ -764,16 +841,41 @@ GraphExecutor::ImportAndCompileClientGraph(
       return tensorflow::errors::Internal("Missing kernel registry in MLRT.");
     }
 
-    ASSIGN_OR_RETURN_IN_COMPILE(
-        auto bytecode_buffer,
-        tensorflow::mlrt_compiler::ConvertTfMlirToBytecode(
-            options_.compile_options, fallback_state(), module.get(),
-            model_context, &module_with_op_keys));
-    mlrt::bc::Executable executable(bytecode_buffer.data());
+    // Restore graphs depend on the checkpoint fed at load time, which is not
+    // part of the imported module.
+    std::string bytecode_cache_path;
+    if (UseMlrtBytecodeCache(options_) && checkpoint_path.empty()) {
+      bytecode_cache_path =
+          GetMlrtBytecodeCachePath(options_.mlrt_bytecode_cache_dir,
+                                   module.get(), options_.compile_options);
+    }
+    std::optional<mlrt::bc::Buffer> bytecode_buffer;
+    if (!bytecode_cache_path.empty()) {
+      bytecode_buffer = ReadMlrtBytecodeCache(bytecode_cache_path);
+    }
+    if (bytecode_buffer.has_value()) {
+      LOG(INFO) << "TFRT reusing cached MLRT bytecode " << bytecode_cache_path
+                << " for client graph " << client_graph.name;
+    } else {
+      ASSIGN_OR_RETURN_IN_COMPILE(
+          bytecode_buffer,
+          tensorflow::mlrt_compiler::ConvertTfMlirToBytecode(
+              options_.compile_options, fallback_state(), module.get(),
+              model_context, &module_with_op_keys));
+      if (!bytecode_cache_path.empty()) {
+        absl::Status status =
+            WriteMlrtBytecodeCache(bytecode_cache_path, *bytecode_buffer);
+        if (!status.ok()) {
+          LOG(WARNING) << "Failed to cache MLRT bytecode for client graph "
+                       << client_graph.name << ": " << status;
+        }
+      }
+    }
+    mlrt::bc::Executable executable(bytecode_buffer->data());
     auto bytecode_executable =
         std::make_unique<mlrt::LoadedExecutable>(executable, *kernel_registry_);
     executable_context = std::make_shared<ExecutableContext>(
-        std::move(bytecode_buffer), std::move(bytecode_executable));
+        std::move(*bytecode_buffer), std::move(bytecode_executable));
   } else {
     tfrt::BefBuffer bef;
     TF_RETURN_IF_ERROR(
@@ -951,11 +1053,22 @@ GraphExecutor::GetOrCreateLoadedClientGraph(
                 absl::StrJoin(target_tensor_names,
                               kTensorNameJoiningDelimiter));
 
-  tensorflow::mutex_lock l(loaded_client_graphs_mu_);
+  LoadedClientGraphEntry* entry = nullptr;
+  {
+    tensorflow::mutex_lock l(loaded_client_graphs_mu_);
+    auto& slot = loaded_client_graphs_[joined_name];
+    if (slot == nullptr) slot = std::make_unique<LoadedClientGraphEntry>();
+    entry = slot.get();
+  }
+
+  // Only the entry is locked while loading, so that loading a graph does not
+  // block requests for other graphs.
+  tensorflow::mutex_lock l(entry->mu);
 
   // Cache hit; return immediately.
-  const auto iter = loaded_client_graphs_.find(joined_name);
-  if (iter != loaded_client_graphs_.end()) return {*iter->second};
+  if (entry->loaded_client_graph != nullptr) {
+    return {*entry->loaded_client_graph};
+  }
 
   if (run_options.disable_compilation) {
     return tensorflow::errors::InvalidArgument(
@@ -985,9 +1098,8 @@ GraphExecutor::GetOrCreateLoadedClientGraph(
                       LoadClientGraph(client_graph, work_queue, inputs));
 
   // Store the new loaded client graph in cache and return.
-  auto* loaded_client_graph_ptr = loaded_client_graph.get();
-  loaded_client_graphs_[joined_name] = std::move(loaded_client_graph);
-  return {*loaded_client_graph_ptr};
+  entry->loaded_client_graph = std::move(loaded_client_graph);
+  return {*entry->loaded_client_graph};
 }
 
 tensorflow::Status GraphExecutor::RunWithSyncInterpreter(
@@ -1107,6 +1219,54 @@ Status GraphExecutor::LoadedClientGraph::UpdateCost(
     // add a test kernel that examines the cost.
     executable_context_ = std::move(new_executable_context);
   }
+  cost_analysis_data_.compiled_costs = cost_recorder.GetCosts();
+  return absl::OkStatus();
+}
+
+Status GraphExecutor::LoadedClientGraph::MaybeRecompile(
+    absl::Time now, const Runtime& runtime) {
+  const auto& options = graph_executor_->options().cost_analysis_options;
+  const CostRecorder& cost_recorder = *cost_analysis_data_.cost_recorder;
+  const double drift =
+      cost_recorder.MaxRelativeCostDrift(cost_analysis_data_.compiled_costs);
+  if (drift < options.recompilation_cost_drift_threshold) {
+    VLOG(1) << "TFRT skipping recompilation of loaded client graph " << name_
+            << " as op costs drifted by " << drift;
+    UpdateCostAnalysisData(now, /*do_recompilation=*/true);
+    return absl::OkStatus();
+  }
+
+  auto recompile = [this, &runtime, &cost_recorder]() -> Status {
+    TF_RETURN_IF_ERROR(UpdateCost(cost_recorder, runtime));
+    tensorflow::mutex_lock l(graph_executor_->num_recompilations_mu_);
+    graph_executor_->num_recompilations_ += 1;
+    return absl::OkStatus();
+  };
+  if (!options.recompile_in_background) {
+    TF_RETURN_IF_ERROR(recompile());
+    UpdateCostAnalysisData(now, /*do_recompilation=*/true);
+    return absl::OkStatus();
+  }
+
+  {
+    tensorflow::mutex_lock l(cost_analysis_data_.mu);
+    cost_analysis_data_.is_recompiling = true;
+  }
+  graph_executor_->fallback_state().session_options().env->SchedClosure(
+      [this, now, recompile = std::move(recompile)]() {
+        Status status = recompile();
+        if (status.ok()) {
+          UpdateCostAnalysisData(now, /*do_recompilation=*/true);
+        } else {
+          // Like a failed recompilation on the request path, this stops
+          // further cost analysis of this graph.
+          LOG(ERROR) << "TFRT failed to recompile loaded client graph "
+                     << name_ << " in the background: " << status;
+        }
+        tensorflow::mutex_lock l(cost_analysis_data_.mu);
+        cost_analysis_data_.is_recompiling = false;
+        cost_analysis_data_.recompiled.notify_all();
+      });
   return absl::OkStatus();
 }
 
@@ -1160,6 +1320,13 @@ GraphExecutor::LoadedClientGraph::LoadedClientGraph(
   }
 }
 
+GraphExecutor::LoadedClientGraph::~LoadedClientGraph() {
+  tensorflow::mutex_lock l(cost_analysis_data_.mu);
+  while (cost_analysis_data_.is_recompiling) {
+    cost_analysis_data_.recompiled.wait(l);
+  }
+}
+
 void GraphExecutor::LoadedClientGraph::UpdateCostAnalysisData(
     absl::Time now, bool do_recompilation) {
   tensorflow::mutex_lock lock(cost_analysis_data_.mu);
@@ -1197,6 +1364,44 @@ tensorflow::Status GraphExecutor::CompileGraph(
       .status();
 }
 
+tensorflow::Status GraphExecutor::PrecompileGraph(
+    const std::string& graph_name,
+    absl::Span<const std::string> input_tensor_names,
+    absl::Span<const tensorflow::DataType> input_tensor_dtypes,
+    absl::Span<const std::string> output_tensor_names,
+    absl::Span<const std::string> target_tensor_names) {
+  TF_RET_CHECK(input_tensor_names.size() == input_tensor_dtypes.size());
+
+  // Sort the names the way `Run()` does, so that the graph is cached under the
+  // joined name that `Run()` looks up.
+  std::vector<std::string> sorted_input_names;
+  std::vector<int> input_original_indices;
+  CreateSortedNamesAndOriginalIndices(input_tensor_names, sorted_input_names,
+                                      input_original_indices);
+  std::vector<tensorflow::DataType> sorted_input_dtypes;
+  sorted_input_dtypes.reserve(input_tensor_dtypes.size());
+  for (int original_index : input_original_indices) {
+    sorted_input_dtypes.push_back(input_tensor_dtypes[original_index]);
+  }
+
+  std::vector<std::string> sorted_output_names;
+  std::vector<int> output_original_indices;
+  CreateSortedNamesAndOriginalIndices(output_tensor_names, sorted_output_names,
+                                      output_original_indices);
+
+  std::vector<std::string> sorted_target_node_names(target_tensor_names.begin(),
+                                                    target_tensor_names.end());
+  std::sort(sorted_target_node_names.begin(), sorted_target_node_names.end());
+
+  RunOptions run_options;
+  run_options.name = graph_name;
+  return GetOrCreateLoadedClientGraph(
+             run_options, sorted_input_names, sorted_input_dtypes,
+             sorted_output_names, sorted_target_node_names,
+             options_.runtime->work_queue())
+      .status();
+}
+
 void RegisterMlirDialect(mlir::DialectRegistry& registry,
                          tensorflow::BackendCompiler* backend_compiler) {
   registry.insert<mlir::BuiltinDialect, mlir::func::FuncDialect>();
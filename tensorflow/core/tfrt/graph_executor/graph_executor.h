@@ -160,6 +160,8 @@ class GraphExecutor {
                       std::optional<StreamCallbackId> stream_callback_id,
                       bool is_restore, FunctionLibraryDefinition flib_def,
                       tsl::monitoring::SamplerCell* latency_sampler);
+    // Waits for any pending background recompilation.
+    ~LoadedClientGraph();
 
     // Returns this instance's CostRecorder if it is time to update costs,
     // else returns nullptr. Only allows one non-null return value at a time
@@ -170,6 +172,11 @@ class GraphExecutor {
     // `cost_recorder`.
     Status UpdateCost(const CostRecorder& cost_recorder,
                       const Runtime& runtime);
+    // Recompiles with the costs recorded this cycle if they drifted from the
+    // ones the executable was compiled with, in the background if so
+    // configured, and then starts the next cycle. Must be called when
+    // `MaybeGetCostRecorder()` requested a recompilation.
+    Status MaybeRecompile(absl::Time now, const Runtime& runtime);
     // Updates `cost_analysis_data_` to make it accurate for the next execution.
     // Assumes a cost update occurred this cycle.
     void UpdateCostAnalysisData(absl::Time now, bool do_recompilation);
@@ -219,6 +226,13 @@ class GraphExecutor {
       absl::Time start_time TF_GUARDED_BY(mu) = absl::Now();
       // Cost recordings within the current measurement cycle.
       int num_cost_updates TF_GUARDED_BY(mu) = 0;
+      // The costs the current executable was compiled with. Only accessed by
+      // the thread that holds the cost recorder.
+      absl::flat_hash_map<int64_t, uint64_t> compiled_costs;
+      // Whether a background recompilation is pending, and signaled when it
+      // is done.
+      bool is_recompiling TF_GUARDED_BY(mu) = false;
+      tensorflow::condition_variable recompiled;
     };
     CostAnalysisData cost_analysis_data_;
 
@@ -266,6 +280,10 @@ class GraphExecutor {
                     graph_execution_state,
                 std::unique_ptr<mlrt::KernelRegistry> kernel_registry);
 
+  // Releases the loaded client graphs first, which waits for their background
+  // recompilations that use the rest of this executor.
+  ~GraphExecutor();
+
   // Runs on the graph according to given input/output.
   tensorflow::Status Run(
       const RunOptions& run_options,
@@ -315,6 +333,20 @@ class GraphExecutor {
       absl::Span<const std::string> output_tensor_names,
       absl::Span<const std::string> target_tensor_names);
 
+  // Compiles the graph that `Run()` uses for the given inputs, outputs and
+  // targets and runs any initializers, so that the first `Run()` with them does
+  // not pay for the compilation. The names need not be sorted. `graph_name`
+  // names the graph in logs and metrics, like `RunOptions::name`.
+  //
+  // Different graphs are compiled concurrently when called from several
+  // threads.
+  tensorflow::Status PrecompileGraph(
+      const std::string& graph_name,
+      absl::Span<const std::string> input_tensor_names,
+      absl::Span<const tensorflow::DataType> input_tensor_dtypes,
+      absl::Span<const std::string> output_tensor_names,
+      absl::Span<const std::string> target_tensor_names);
+
   const mlrt::KernelRegistry& kernel_registry() const {
     return *kernel_registry_;
   }
@@ -365,12 +397,20 @@ class GraphExecutor {
 
   tfrt::RequestDeadlineTracker req_deadline_tracker_;
 
+  // An entry of `loaded_client_graphs_`. The graph is loaded under the entry's
+  // own lock rather than `loaded_client_graphs_mu_`, so that different graphs
+  // load concurrently while requests for the same graph wait for one load.
+  struct LoadedClientGraphEntry {
+    tensorflow::mutex mu;
+    std::unique_ptr<LoadedClientGraph> loaded_client_graph TF_GUARDED_BY(mu);
+  };
+
   tensorflow::mutex loaded_client_graphs_mu_;
   // Caches `LoadedClientGraph` by the joined name.
   // For pointer stability of values in `absl::flat_hash_map<>`, additional
   // `std::unique_ptr<>` is necessary. (See https://abseil.io/tips/136.)
   absl::flat_hash_map<std::string /*joined_name*/,
-                      std::unique_ptr<LoadedClientGraph>>
+                      std::unique_ptr<LoadedClientGraphEntry>>
       loaded_client_graphs_ TF_GUARDED_BY(loaded_client_graphs_mu_);
 
   std::unique_ptr<mlrt::KernelRegistry> kernel_registry_;
@@ -14,17 +14,24 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/tfrt/ifrt/checkpoint_loader.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "mlir/IR/BuiltinOps.h"  // from @llvm-project
 #include "tensorflow/compiler/mlir/tfrt/transforms/ifrt/ifrt_types.h"
@@ -39,6 +46,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/tfrt/common/metrics.h"
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner.h"
 #include "tensorflow/core/tfrt/ifrt/ifrt_loaded_variable_utils.h"
 #include "tensorflow/core/tfrt/ifrt/ifrt_restore_tensor_registry.h"
@@ -59,8 +67,19 @@ namespace {
 
 static constexpr int kNumRestoreClusters = 4;
 
+// Variables are split in shards of at most this size, so that the first ones
+// are restored, and start being transferred to the devices, while the others
+// are still being restored.
+static constexpr int64_t kMaxRestoreShardBytes = int64_t{256} << 20;
+
+// The size of the shards being restored at a time. This bounds the host memory
+// used for staging the restored tensors before they are registered. At least
+// one shard is always restored, whatever its size.
+static constexpr int64_t kMaxInFlightRestoreBytes = int64_t{2} << 30;
+
 // A shard of variables to be restored.
 struct RestoreVariableShard {
+  int64_t size_in_bytes = 0;
   tensorflow::Tensor prefix;
   tensorflow::Tensor tensor_names;
   tensorflow::Tensor shape_and_slices;
@@ -138,16 +157,15 @@ absl::StatusOr<tensorflow::Tensor> Cast(
   return *(op_kernel_context.mutable_output(0));
 }
 
-absl::Status RunShard(RestoreVariableShard shard,
-                      IfrtRestoreTensorRegistry* ifrt_restore_tensor_registry,
-                      tfrt::ConcurrentWorkQueue* checkpoint_loader_work_queue,
-                      tf_mlrt::Context& context) {
+// Registers the futures of the variables of `shard`, and returns the function
+// that restores them.
+absl::StatusOr<absl::AnyInvocable<void()>> PrepareShard(
+    RestoreVariableShard shard,
+    IfrtRestoreTensorRegistry* ifrt_restore_tensor_registry,
+    tf_mlrt::Context& context) {
   if (!ifrt_restore_tensor_registry) {
     return absl::InternalError("ifrt_restore_tensor_registry must not be null");
   }
-  if (!checkpoint_loader_work_queue) {
-    return absl::InternalError("checkpoint_loader_work_queue must not be null");
-  }
   const int num_outputs = shard.var_handles.size();
   DCHECK_EQ(num_outputs, shard.tensor_names.NumElements());
   auto& fallback_request_state = context.fallback_request_state();
@@ -219,13 +237,14 @@ absl::Status RunShard(RestoreVariableShard shard,
     async_state->results.push_back(std::move(promise));
   }
 
-  // Use dedicated work queue for restore operation.
-  checkpoint_loader_work_queue->AddTask([runner = std::move(runner),
-                                         async_state = std::move(async_state),
-                                         shard = std::move(shard)]() {
+  return [runner = std::move(runner), async_state = std::move(async_state),
+          shard = std::move(shard)]() {
+    const absl::Time start_time = absl::Now();
     // Keep input tensor alive in `shard`.
     auto* op_kernel_context_ptr = &async_state->context;
     runner.Run(op_kernel_context_ptr);
+    tfrt_metrics::GetIfrtCheckpointShardRestoreLatency()->Add(
+        absl::ToDoubleMicroseconds(absl::Now() - start_time));
 
     auto& op_kernel_context = async_state->context;
     if (!op_kernel_context.status().ok()) {
@@ -271,12 +290,80 @@ absl::Status RunShard(RestoreVariableShard shard,
         }
       }
     }
-  });
-  return absl::OkStatus();
+    tfrt_metrics::GetIfrtCheckpointRestoredBytes()->IncrementBy(
+        shard.size_in_bytes);
+  };
 }
 
+// Restores shards on a work queue, a bounded number of bytes at a time.
+//
+// Restoring all the shards at once would both hold the staging memory of all
+// of them, and queue the transfers of the restored variables to the devices,
+// which use the same work queue, behind all the restores. Instead, a shard is
+// only queued when another one is done, so that restores and transfers are
+// pipelined.
+class ShardRestoreScheduler
+    : public std::enable_shared_from_this<ShardRestoreScheduler> {
+ public:
+  ShardRestoreScheduler(tfrt::ConcurrentWorkQueue* work_queue,
+                        int max_in_flight_shards, int64_t max_in_flight_bytes)
+      : work_queue_(work_queue),
+        max_in_flight_shards_(max_in_flight_shards),
+        max_in_flight_bytes_(max_in_flight_bytes) {}
+
+  void Add(int64_t size_in_bytes, absl::AnyInvocable<void()> restore) {
+    absl::MutexLock lock(&mu_);
+    pending_.push_back({size_in_bytes, std::move(restore)});
+  }
+
+  // Queues as many pending shards as the limits allow.
+  void Schedule() {
+    std::vector<PendingShard> shards;
+    {
+      absl::MutexLock lock(&mu_);
+      while (!pending_.empty() &&
+             (in_flight_shards_ == 0 ||
+              (in_flight_shards_ < max_in_flight_shards_ &&
+               in_flight_bytes_ + pending_.front().size_in_bytes <=
+                   max_in_flight_bytes_))) {
+        ++in_flight_shards_;
+        in_flight_bytes_ += pending_.front().size_in_bytes;
+        shards.push_back(std::move(pending_.front()));
+        pending_.pop_front();
+      }
+    }
+    for (auto& shard : shards) {
+      work_queue_->AddTask([self = shared_from_this(),
+                            shard = std::move(shard)]() mutable {
+        std::move(shard.restore)();
+        {
+          absl::MutexLock lock(&self->mu_);
+          --self->in_flight_shards_;
+          self->in_flight_bytes_ -= shard.size_in_bytes;
+        }
+        self->Schedule();
+      });
+    }
+  }
+
+ private:
+  struct PendingShard {
+    int64_t size_in_bytes;
+    absl::AnyInvocable<void()> restore;
+  };
+
+  tfrt::ConcurrentWorkQueue* const work_queue_;
+  const int max_in_flight_shards_;
+  const int64_t max_in_flight_bytes_;
+
+  absl::Mutex mu_;
+  std::deque<PendingShard> pending_ ABSL_GUARDED_BY(mu_);
+  int in_flight_shards_ ABSL_GUARDED_BY(mu_) = 0;
+  int64_t in_flight_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
 int64_t GetSizeFromVarHandle(const ResourceHandle& handle) {
-  int size = 0;
+  int64_t size = 0;
   for (auto& dtype_and_shape : handle.dtypes_and_shapes()) {
     size += DataTypeSize(dtype_and_shape.dtype) *
             dtype_and_shape.shape.num_elements();
@@ -299,15 +386,31 @@ absl::Status CheckpointLoader::Load(
     const tensorflow::tfrt_stub::FallbackTensor& shape_and_slices,
     absl::Span<const tensorflow::DataType> restored_dtypes,
     const std::vector<bool>& truncate_in_cast, tf_mlrt::Context& context) {
+  if (!checkpoint_loader_work_queue_) {
+    return absl::InternalError("checkpoint_loader_work_queue must not be null");
+  }
   std::vector<int64_t> variable_sizes;
   variable_sizes.reserve(var_handles.size());
+  int64_t total_size = 0;
   for (auto& handle : var_handles) {
     variable_sizes.push_back(GetSizeFromVarHandle(
         handle.tensor().scalar<tensorflow::ResourceHandle>()()));
+    total_size += variable_sizes.back();
   }
 
-  std::vector<std::vector<int>> sharded_indices = tf_mlrt::ShardVariables(
-      kNumRestoreClusters, absl::MakeSpan(variable_sizes));
+  // Use at least enough shards to keep the work queue busy, and more for large
+  // checkpoints so that shards stay under kMaxRestoreShardBytes.
+  const int parallelism =
+      std::max(kNumRestoreClusters,
+               checkpoint_loader_work_queue_->GetParallelismLevel());
+  int64_t num_shards = std::max<int64_t>(
+      parallelism,
+      (total_size + kMaxRestoreShardBytes - 1) / kMaxRestoreShardBytes);
+  num_shards = std::max<int64_t>(
+      1, std::min<int64_t>(num_shards, var_handles.size()));
+  std::vector<std::vector<int>> sharded_indices =
+      tf_mlrt::ShardVariables(static_cast<int>(num_shards),
+                              absl::MakeSpan(variable_sizes));
 
   // Converts the names and slices back to the tensor.
   auto vector_to_tensor = [](const std::vector<tsl::tstring>& vec) {
@@ -341,17 +444,31 @@ absl::Status CheckpointLoader::Load(
       shard.var_handles.push_back(var_handles[index]);
       shard.restored_dtypes.push_back(restored_dtypes[index]);
       shard.truncate_in_cast.push_back(truncate_in_cast[index]);
+      shard.size_in_bytes += variable_sizes[index];
     }
     shard.prefix = prefix.tensor();
     shard.tensor_names = vector_to_tensor(tensor_names);
     shard.shape_and_slices = vector_to_tensor(shape_and_slices);
     shards.push_back(std::move(shard));
   }
-  for (const auto& shard : shards) {
-    TF_RETURN_IF_ERROR(RunShard(shard, ifrt_restore_tensor_registry_,
-                                checkpoint_loader_work_queue_, context));
+  // Use dedicated work queue for restore operation.
+  auto scheduler = std::make_shared<ShardRestoreScheduler>(
+      checkpoint_loader_work_queue_, parallelism, kMaxInFlightRestoreBytes);
+  absl::Status status;
+  for (auto& shard : shards) {
+    const int64_t size_in_bytes = shard.size_in_bytes;
+    absl::StatusOr<absl::AnyInvocable<void()>> restore =
+        PrepareShard(std::move(shard), ifrt_restore_tensor_registry_, context);
+    if (!restore.ok()) {
+      status = restore.status();
+      break;
+    }
+    scheduler->Add(size_in_bytes, *std::move(restore));
   }
-  return absl::OkStatus();
+  // The shards prepared before an error are still restored, as their futures
+  // are registered and may be waited on.
+  scheduler->Schedule();
+  return status;
 }
 
 }  // namespace ifrt_serving
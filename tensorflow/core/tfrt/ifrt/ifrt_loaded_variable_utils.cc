@@ -25,6 +25,8 @@ limitations under the License.
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "tensorflow/compiler/mlir/tfrt/transforms/ifrt/ifrt_types.h"
 #include "xla/python/ifrt/array.h"
@@ -34,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/tfrt/common/metrics.h"
 #include "tensorflow/core/tfrt/ifrt/ifrt_loaded_variable_registry.h"
 #include "tensorflow/core/tfrt/ifrt/ifrt_restore_tensor_registry.h"
 #include "tensorflow/core/tfrt/ifrt/sharding_utils.h"
@@ -141,10 +144,13 @@ absl::Status AsyncLoadRestoredTensorAsIfrtLoadedVariable(
              restored_tensor = std::move(*restored_tensor),
              loaded_variable_promise =
                  std::move(loaded_variable_promise)]() mutable {
+              const absl::Time start_time = absl::Now();
               absl::StatusOr<tsl::RCReference<xla::ifrt::Array>>
                   variable_array =
                       LoadIfrtVariable(ifrt_client, thread_pool,
                                        restored_tensor, sharding_config);
+              tfrt_metrics::GetIfrtVariableDeviceTransferLatency()->Add(
+                  absl::ToDoubleMicroseconds(absl::Now() - start_time));
               loaded_variable_promise.Set(std::move(variable_array));
             });
       });
@@ -0,0 +1,96 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_TFRT_MLRT_BYTECODE_LIVENESS_H_
+#define TENSORFLOW_CORE_TFRT_MLRT_BYTECODE_LIVENESS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/tfrt/mlrt/bytecode/bytecode.h"
+#include "tensorflow/core/tfrt/mlrt/bytecode/function.h"
+#include "tensorflow/core/tfrt/mlrt/bytecode/kernel.h"
+
+namespace mlrt {
+namespace bc {
+
+// RegisterLiveness holds, for each kernel of a function, the argument registers
+// whose values die at the kernel, i.e. that no later kernel reads before they
+// are written again. Since a function is a single block of kernels executed in
+// order, this is computed with one backward pass over the kernels.
+//
+// Registers that are also results of the same kernel are never reported, as
+// the kernel overwrites them.
+class RegisterLiveness {
+ public:
+  explicit RegisterLiveness(Function function) {
+    Vector<Kernel> kernels = function.kernels();
+    std::vector<bool> live(function.num_regs(), false);
+    std::vector<std::vector<uint32_t>> dead(kernels.size());
+    for (size_t i = kernels.size(); i-- > 0;) {
+      Kernel kernel = kernels[i];
+      Vector<uint32_t> results = kernel.results();
+      for (uint32_t reg : kernel.arguments()) {
+        DCHECK_LT(reg, live.size());
+        if (live[reg] || IsResult(results, reg)) continue;
+        // Marks the register live right away, so that a register passed
+        // several times to the kernel is reported once.
+        live[reg] = true;
+        dead[i].push_back(reg);
+      }
+      for (uint32_t reg : results) {
+        DCHECK_LT(reg, live.size());
+        live[reg] = false;
+      }
+      for (uint32_t reg : kernel.arguments()) live[reg] = true;
+    }
+
+    offsets_.reserve(kernels.size() + 1);
+    offsets_.push_back(0);
+    for (const auto& regs : dead) {
+      registers_.insert(registers_.end(), regs.begin(), regs.end());
+      offsets_.push_back(registers_.size());
+    }
+  }
+
+  // Returns the argument registers whose values die at the kernel at
+  // `kernel_index`.
+  absl::Span<const uint32_t> DeadArguments(size_t kernel_index) const {
+    DCHECK_LT(kernel_index + 1, offsets_.size());
+    return absl::MakeConstSpan(registers_)
+        .subspan(offsets_[kernel_index],
+                 offsets_[kernel_index + 1] - offsets_[kernel_index]);
+  }
+
+ private:
+  static bool IsResult(Vector<uint32_t> results, uint32_t reg) {
+    for (uint32_t result : results) {
+      if (result == reg) return true;
+    }
+    return false;
+  }
+
+  // The dead registers of kernel i are registers_[offsets_[i]] to
+  // registers_[offsets_[i + 1] - 1].
+  std::vector<uint32_t> offsets_;
+  std::vector<uint32_t> registers_;
+};
+
+}  // namespace bc
+}  // namespace mlrt
+
+#endif  // TENSORFLOW_CORE_TFRT_MLRT_BYTECODE_LIVENESS_H_
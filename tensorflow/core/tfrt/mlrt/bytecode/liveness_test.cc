@@ -0,0 +1,82 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/tfrt/mlrt/bytecode/liveness.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/tfrt/mlrt/bytecode/bytecode.h"
+#include "tensorflow/core/tfrt/mlrt/bytecode/function.h"
+#include "tensorflow/core/tfrt/mlrt/bytecode/kernel.h"
+
+namespace mlrt {
+namespace bc {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(RegisterLivenessTest, DeadArguments) {
+  Buffer buffer;
+  Allocator allocator(&buffer);
+
+  Function::Constructor ctor = New<Function>(&allocator);
+  ctor.construct_name("main");
+  ctor.set_num_regs(3);
+  ctor.construct_input_regs(/*size=*/1).Assign({0});
+  ctor.construct_output_regs(/*size=*/0);
+  ctor.construct_output_last_uses(/*size=*/0);
+  auto kernels_ctor = ctor.construct_kernels(/*size=*/4);
+
+  // %1 = k0(%0)
+  {
+    auto kernel_ctor = kernels_ctor.ConstructAt(0);
+    kernel_ctor.construct_arguments(/*size=*/1).Assign({0});
+    kernel_ctor.construct_results(/*size=*/1).Assign({1});
+  }
+
+  // %2 = k1(%1, %1)
+  {
+    auto kernel_ctor = kernels_ctor.ConstructAt(1);
+    kernel_ctor.construct_arguments(/*size=*/2).Assign({1, 1});
+    kernel_ctor.construct_results(/*size=*/1).Assign({2});
+  }
+
+  // %0 = k2(%0, %2)
+  {
+    auto kernel_ctor = kernels_ctor.ConstructAt(2);
+    kernel_ctor.construct_arguments(/*size=*/2).Assign({0, 2});
+    kernel_ctor.construct_results(/*size=*/1).Assign({0});
+  }
+
+  // k3(%0)
+  {
+    auto kernel_ctor = kernels_ctor.ConstructAt(3);
+    kernel_ctor.construct_arguments(/*size=*/1).Assign({0});
+  }
+
+  RegisterLiveness liveness(Function(buffer.Get(ctor.address())));
+
+  // %0 is read again by k2.
+  EXPECT_THAT(liveness.DeadArguments(0), IsEmpty());
+  // %1 is reported once although it is passed twice.
+  EXPECT_THAT(liveness.DeadArguments(1), ElementsAre(1));
+  // %0 is overwritten by k2 itself, so only %2 dies.
+  EXPECT_THAT(liveness.DeadArguments(2), ElementsAre(2));
+  EXPECT_THAT(liveness.DeadArguments(3), ElementsAre(0));
+}
+
+}  // namespace
+}  // namespace bc
+}  // namespace mlrt
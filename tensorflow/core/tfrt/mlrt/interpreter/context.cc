@@ -48,8 +48,18 @@ LoadedExecutable::LoadedExecutable(bc::Executable executable,
   }
 
   functions_.reserve(executable_.functions().size());
+  prepared_functions_.reserve(executable_.functions().size());
   for (auto function : executable_.functions()) {
     functions_[function.name().Get()] = function;
+
+    auto& prepared_function =
+        prepared_functions_.try_emplace(function.name().Get(), function)
+            .first->second;
+    prepared_function.implementations.reserve(function.kernels().size());
+    for (auto kernel : function.kernels()) {
+      DCHECK_LT(kernel.code(), kernels_.size());
+      prepared_function.implementations.push_back(kernels_[kernel.code()]);
+    }
   }
 }
 
@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/tfrt/mlrt/bytecode/executable.h"
 #include "tensorflow/core/tfrt/mlrt/bytecode/function.h"
 #include "tensorflow/core/tfrt/mlrt/bytecode/kernel.h"
+#include "tensorflow/core/tfrt/mlrt/bytecode/liveness.h"
 #include "tensorflow/core/tfrt/mlrt/bytecode/span.h"
 #include "tensorflow/core/tfrt/mlrt/interpreter/attribute_span.h"
 #include "tensorflow/core/tfrt/mlrt/interpreter/register_span.h"
@@ -78,6 +79,17 @@ class KernelRegistry {
 
 class LoadedExecutable {
  public:
+  // The per-function state computed once at load time and used by the
+  // interpreter loop: the implementation of each kernel in program order, so
+  // that dispatch does not go through the kernel codes, and the registers to
+  // free after each kernel.
+  struct PreparedFunction {
+    explicit PreparedFunction(bc::Function function) : liveness(function) {}
+
+    std::vector<KernelImplementation> implementations;
+    bc::RegisterLiveness liveness;
+  };
+
   LoadedExecutable(bc::Executable executable,
                    const KernelRegistry& kernel_registry);
 
@@ -91,6 +103,17 @@ class LoadedExecutable {
     return nullptr;
   }
 
+  // Returns the prepared state of `function`, or nullptr if `function` is not
+  // one of the functions of this executable.
+  const PreparedFunction* GetPreparedFunction(bc::Function function) const {
+    if (auto iter = prepared_functions_.find(function.name().Get());
+        iter != prepared_functions_.end()) {
+      return &iter->second;
+    }
+
+    return nullptr;
+  }
+
   bc::Executable executable() const { return executable_; }
 
  private:
@@ -98,6 +121,7 @@ class LoadedExecutable {
 
   absl::flat_hash_map<std::string, bc::Function> functions_;
   std::vector<KernelImplementation> kernels_;
+  absl::flat_hash_map<std::string, PreparedFunction> prepared_functions_;
 };
 
 // A helper structure that holds states for a kernel. Typical usuage is that a
@@ -207,6 +231,8 @@ class FunctionContext {
   std::vector<Value> registers_;
   std::vector<Value*> results_;
   bc::Function function_object_;
+  // Set by the interpreter loop on the first execution of the function.
+  const LoadedExecutable::PreparedFunction* prepared_function_ = nullptr;
   KernelContext kernel_context_;
 
   ExecutionContext* execution_context_ = nullptr;
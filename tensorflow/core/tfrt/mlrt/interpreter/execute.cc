@@ -23,6 +23,7 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/tfrt/mlrt/bytecode/kernel.h"
+#include "tensorflow/core/tfrt/mlrt/bytecode/liveness.h"
 #include "tensorflow/core/tfrt/mlrt/interpreter/context.h"
 #include "tensorflow/core/tfrt/mlrt/interpreter/register_span.h"
 #include "tensorflow/core/tfrt/mlrt/interpreter/value.h"
@@ -92,7 +93,12 @@ void Execute(ExecutionContext& ctx) {
     FunctionContext* current_function = &context.function_stack_.back();
     int64_t pc = current_function->pc_;
 
-    auto kernels = context.loaded_executable().kernels();
+    if (current_function->prepared_function_ == nullptr) {
+      current_function->prepared_function_ =
+          context.loaded_executable().GetPreparedFunction(
+              current_function->function_object());
+    }
+    const auto* prepared_function = current_function->prepared_function_;
 
     auto kernel_object_iter =
         current_function->function_object().kernels().begin();
@@ -104,13 +110,35 @@ void Execute(ExecutionContext& ctx) {
     // The main loop for executing kernels in program order. The kernels may set
     // the execution state to break this loop for context-switching or error
     // handling.
-    for (; context.state_ == ExecutionContext::State::kRunning; ++pc) {
-      DCHECK(kernel_object_iter <
-             current_function->function_object().kernels().end());
-      bc::Kernel kernel_object = *kernel_object_iter;
-      frame.set_kernel(kernel_object);
-      kernels[kernel_object.code()](frame);
-      ++kernel_object_iter;
+    if (prepared_function != nullptr) {
+      const KernelImplementation* implementations =
+          prepared_function->implementations.data();
+      const bc::RegisterLiveness& liveness = prepared_function->liveness;
+      for (; context.state_ == ExecutionContext::State::kRunning; ++pc) {
+        DCHECK(kernel_object_iter <
+               current_function->function_object().kernels().end());
+        frame.set_kernel(*kernel_object_iter);
+        implementations[pc](frame);
+        ++kernel_object_iter;
+
+        // Free the values that no later kernel reads, unless the kernel is
+        // going to be reentered or the execution is leaving this function.
+        if (context.state_ == ExecutionContext::State::kRunning) {
+          for (uint32_t reg : liveness.DeadArguments(pc)) {
+            kstate.regs[reg].Reset();
+          }
+        }
+      }
+    } else {
+      auto kernels = context.loaded_executable().kernels();
+      for (; context.state_ == ExecutionContext::State::kRunning; ++pc) {
+        DCHECK(kernel_object_iter <
+               current_function->function_object().kernels().end());
+        bc::Kernel kernel_object = *kernel_object_iter;
+        frame.set_kernel(kernel_object);
+        kernels[kernel_object.code()](frame);
+        ++kernel_object_iter;
+      }
     }
 
     // Update the program counter if we need to break the sequential execution
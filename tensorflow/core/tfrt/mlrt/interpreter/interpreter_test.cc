@@ -123,6 +123,107 @@ bc::Buffer CreateSequentialAddExecutable(int num_add) {
   return buffer;
 }
 
+// The value passed to the function, and whether it was released by the time
+// "check_released" ran.
+std::weak_ptr<int32_t>& WatchedValue() {
+  static auto* const watched_value = new std::weak_ptr<int32_t>();
+  return *watched_value;
+}
+
+bool& ValueReleased() {
+  static bool value_released = false;
+  return value_released;
+}
+
+void ReadSharedPtrI32(KernelFrame frame) {
+  CHECK_EQ(*frame.arguments()[0].Get<std::shared_ptr<int32_t>>(), 1);
+}
+
+void CheckReleased(KernelFrame frame) {
+  ValueReleased() = WatchedValue().expired();
+}
+
+bc::Buffer CreateReleaseAfterLastUseExecutable() {
+  bc::Buffer buffer;
+  bc::Allocator allocator(&buffer);
+
+  auto executable_ctor = bc::New<bc::Executable>(&allocator);
+
+  testing::SymbolTable kernels;
+  std::vector<std::string> names = {"read", "check_released", "return"};
+  executable_ctor.construct_kernel_names(names.size()).Assign(names);
+  kernels.Def(names);
+
+  auto functions_ctor = executable_ctor.construct_functions(1);
+  auto function_ctor = functions_ctor.ConstructAt(0);
+
+  testing::SymbolTable regs;
+
+  function_ctor.construct_name("main");
+  function_ctor.construct_input_regs(1).Assign({regs.Def("r0")});
+  function_ctor.construct_output_regs(0);
+  function_ctor.construct_output_last_uses(0);
+
+  auto kernels_ctor = function_ctor.construct_kernels(3);
+
+  {
+    // The kernel does not take the value out of the register on its last use.
+    auto kernel_ctor = kernels_ctor.ConstructAt(0);
+    kernel_ctor.set_code(kernels.Use("read"));
+    kernel_ctor.construct_arguments(1).Assign({regs.Use("r0")});
+    kernel_ctor.construct_last_uses(1).Assign({false});
+  }
+
+  {
+    auto kernel_ctor = kernels_ctor.ConstructAt(1);
+    kernel_ctor.set_code(kernels.Use("check_released"));
+  }
+
+  {
+    auto kernel_ctor = kernels_ctor.ConstructAt(2);
+    kernel_ctor.set_code(kernels.Use("return"));
+  }
+
+  function_ctor.set_num_regs(regs.size());
+
+  return buffer;
+}
+
+TEST(InterpreterTest, ReleaseAfterLastUse) {
+  auto buffer = CreateReleaseAfterLastUseExecutable();
+
+  bc::Executable executable(buffer.data());
+
+  KernelRegistry kernel_registry;
+  RegisterBuiltinKernels(kernel_registry);
+  kernel_registry.Register("read", &ReadSharedPtrI32);
+  kernel_registry.Register("check_released", &CheckReleased);
+
+  LoadedExecutable loaded_executable(executable, kernel_registry);
+
+  absl::Notification notification;
+
+  ExecutionContext execution_context(&loaded_executable);
+  execution_context.set_exit_handler([&]() { notification.Notify(); });
+
+  auto value = std::make_shared<int32_t>(1);
+  WatchedValue() = value;
+  mlrt::Value arg(std::move(value));
+
+  auto function = loaded_executable.GetFunction("main");
+  ASSERT_TRUE(function);
+
+  std::vector<uint8_t> last_uses = {true};
+  execution_context.Call(function, last_uses, absl::Span<Value>(&arg, 1),
+                         absl::Span<Value>());
+  Execute(execution_context);
+
+  notification.WaitForNotification();
+
+  TF_ASSERT_OK(execution_context.status());
+  EXPECT_TRUE(ValueReleased());
+}
+
 bc::Buffer CreateSequentialAddAttributesExecutable(int num_add) {
   bc::Buffer buffer;
   bc::Allocator allocator(&buffer);
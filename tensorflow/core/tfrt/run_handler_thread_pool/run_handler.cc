@@ -25,12 +25,16 @@ limitations under the License.
 
 #include <optional>
 
+#include "absl/strings/str_cat.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/lib/core/threadpool_interface.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/setround.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -48,6 +52,28 @@ namespace {
 typedef typename internal::RunHandlerEnvironment::Task Task;
 typedef Eigen::RunQueue<Task, 1024> Queue;
 
+auto* run_handler_busy_time_usecs = tensorflow::monitoring::Counter<1>::New(
+    "/tensorflow/tfrt/run_handler/busy_time_usecs",
+    "The time the run handler threads spent running tasks, by the NUMA node "
+    "the threads are bound to. Divided by the wall time and the number of "
+    "threads, this is the utilization of the threads of a node.",
+    "numa_node");
+
+auto* run_handler_task_wait_time_usecs =
+    tensorflow::monitoring::Sampler<1>::New(
+        {"/tensorflow/tfrt/run_handler/task_wait_time_usecs",
+         "The time tasks waited in the run handler queues before running, by "
+         "the NUMA node of the threads that ran them.",
+         "numa_node"},
+        // Power of 2 buckets, from 1us to about 1s.
+        {tensorflow::monitoring::Buckets::Exponential(1, 2, 20)});
+
+std::string NumaNodeLabel(int numa_node) {
+  return numa_node == tensorflow::port::kNUMANoAffinity
+             ? "none"
+             : absl::StrCat(numa_node);
+}
+
 }  // namespace
 
 namespace internal {
@@ -58,13 +84,20 @@ RunHandlerEnvironment::RunHandlerEnvironment(
 
 RunHandlerEnvironment::EnvThread* RunHandlerEnvironment::CreateThread(
     std::function<void()> f) {
-  return env_->StartThread(thread_options_, name_, [=]() {
+  return CreateThread(std::move(f), thread_options_.numa_node);
+}
+
+RunHandlerEnvironment::EnvThread* RunHandlerEnvironment::CreateThread(
+    std::function<void()> f, int numa_node) {
+  tensorflow::ThreadOptions thread_options = thread_options_;
+  thread_options.numa_node = numa_node;
+  return env_->StartThread(thread_options, name_, [=]() {
     // Set the processor flag to flush denormals to zero.
     tensorflow::port::ScopedFlushDenormal flush;
     // Set the processor rounding mode to ROUND TO NEAREST.
     tensorflow::port::ScopedSetRound round(FE_TONEAREST);
-    if (thread_options_.numa_node != tensorflow::port::kNUMANoAffinity) {
-      tensorflow::port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
+    if (numa_node != tensorflow::port::kNUMANoAffinity) {
+      tensorflow::port::NUMASetThreadNodeAffinity(numa_node);
     }
     f();
   });
@@ -82,6 +115,7 @@ RunHandlerEnvironment::Task RunHandlerEnvironment::CreateTask(TaskFunction f) {
           std::move(f),
           tensorflow::Context(tensorflow::ContextKind::kThread),
           id,
+          tensorflow::EnvTime::NowMicros(),
       }),
   };
 }
@@ -141,6 +175,7 @@ ThreadWorkSource::ThreadWorkSource()
       non_blocking_inflight_(0),
       pending_tasks_(0),
       traceme_id_(0),
+      numa_node_(tensorflow::port::kNUMANoAffinity),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
   queue_waiters_.next = &queue_waiters_;
@@ -275,6 +310,12 @@ int64_t ThreadWorkSource::GetTracemeId() {
 
 void ThreadWorkSource::SetTracemeId(int64_t value) { traceme_id_ = value; }
 
+int ThreadWorkSource::GetNumaNode() {
+  return numa_node_.load(std::memory_order_relaxed);
+}
+
+void ThreadWorkSource::SetNumaNode(int numa_node) { numa_node_ = numa_node; }
+
 void ThreadWorkSource::SetWaiter(uint64_t version, Waiter* waiter,
                                  tensorflow::mutex* mutex) {
   {
@@ -356,6 +397,7 @@ RunHandlerThreadPool::RunHandlerThreadPool(
       blocking_thread_max_waiting_time_(
           options.blocking_threads_max_sleep_time_micro_sec),
       enable_wake_up_(options.enable_wake_up),
+      yield_to_higher_priority_(options.yield_to_higher_priority),
       thread_data_(num_threads_),
       env_(env, thread_options, name),
       name_(name),
@@ -363,7 +405,11 @@ RunHandlerThreadPool::RunHandlerThreadPool(
       queue_waiters_(queue_waiters),
       num_threads_in_sub_thread_pool_(options.num_threads_in_sub_thread_pool),
       sub_thread_pool_end_request_percentage_(
-          options.sub_thread_request_percentage) {
+          options.sub_thread_request_percentage),
+      numa_node_of_sub_thread_pool_(options.numa_node_of_sub_thread_pool) {
+  DCHECK(numa_node_of_sub_thread_pool_.empty() ||
+         numa_node_of_sub_thread_pool_.size() ==
+             num_threads_in_sub_thread_pool_.size());
   thread_data_.resize(num_threads_);
   for (int i = 0; i < num_threads_; ++i) {
     thread_data_[i].new_thread_work_sources =
@@ -403,16 +449,22 @@ void RunHandlerThreadPool::Start() {
       }
     }
     thread_data_[i].sub_thread_pool_id = sub_thread_pool_id;
-    thread_data_[i].thread.reset(
-        env_.CreateThread([this, i, num_blocking_threads]() {
+    thread_data_[i].numa_node = numa_node_of_sub_thread_pool_.empty()
+                                    ? env_.thread_options_.numa_node
+                                    : numa_node_of_sub_thread_pool_
+                                          [sub_thread_pool_id];
+    thread_data_[i].thread.reset(env_.CreateThread(
+        [this, i, num_blocking_threads]() {
           WorkerLoop(i, i < num_blocking_threads);
-        }));
+        },
+        thread_data_[i].numa_node));
   }
 }
 
 void RunHandlerThreadPool::StartOneThreadForTesting() {
   cancelled_ = false;
   thread_data_[0].sub_thread_pool_id = 0;
+  thread_data_[0].numa_node = env_.thread_options_.numa_node;
   thread_data_[0].thread.reset(
       env_.CreateThread([this]() { WorkerLoop(0, true); }));
 }
@@ -474,8 +526,22 @@ int RunHandlerThreadPool::NumNonBlockingThreads() const {
   return num_non_blocking_threads_;
 }
 
+int RunHandlerThreadPool::GetEffectiveNumaNode(int numa_node) const {
+  if (numa_node == tensorflow::port::kNUMANoAffinity) return numa_node;
+  // The blocking threads are the first ones; they are the only ones that run
+  // the inter-op tasks.
+  for (int i = 0; i < num_blocking_threads_; ++i) {
+    if (thread_data_[i].numa_node == numa_node) return numa_node;
+  }
+  return tensorflow::port::kNUMANoAffinity;
+}
+
 RunHandlerThreadPool::ThreadData::ThreadData()
-    : new_version(0), current_index(0), current_version(0) {}
+    : new_version(0),
+      current_index(0),
+      current_version(0),
+      sub_thread_pool_id(0),
+      numa_node(tensorflow::port::kNUMANoAffinity) {}
 
 Task RunHandlerThreadPool::FindTask(
     int searching_range_start, int searching_range_end, int thread_id,
@@ -484,7 +550,12 @@ Task RunHandlerThreadPool::FindTask(
     const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
     bool* task_from_blocking_queue, ThreadWorkSource** tws) {
   Task t;
-  int current_index = thread_data_[thread_id].current_index;
+  // The requests are sorted by decreasing priority, so starting from the first
+  // one serves the highest priority requests first.
+  int current_index = yield_to_higher_priority_
+                          ? searching_range_start
+                          : thread_data_[thread_id].current_index;
+  const int thread_numa_node = thread_data_[thread_id].numa_node;
   *task_from_blocking_queue = false;
 
   for (int i = 0; i < searching_range_end - searching_range_start; ++i) {
@@ -495,6 +566,13 @@ Task RunHandlerThreadPool::FindTask(
     *tws = thread_work_sources[current_index];
     ++current_index;
 
+    // Leave the requests pinned to another NUMA node to the threads there.
+    const int numa_node = (*tws)->GetNumaNode();
+    if (numa_node != tensorflow::port::kNUMANoAffinity &&
+        numa_node != thread_numa_node) {
+      continue;
+    }
+
     // For blocking thread, search for blocking tasks first.
     if (may_steal_blocking_work &&
         (*tws)->GetInflightTaskCount(true) < max_blocking_inflight) {
@@ -523,6 +601,12 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
   pt->thread_id = thread_id;
   static constexpr int32_t kMaxBlockingInflight = 10;
 
+  const std::string numa_node_label =
+      NumaNodeLabel(thread_data_[thread_id].numa_node);
+  auto* busy_time_cell = run_handler_busy_time_usecs->GetCell(numa_node_label);
+  auto* wait_time_cell =
+      run_handler_task_wait_time_usecs->GetCell(numa_node_label);
+
   while (!cancelled_) {
     Task t;
     ThreadWorkSource* tws = nullptr;
@@ -582,7 +666,11 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
       VLOG(2) << "Running " << (task_from_blocking_queue ? "inter" : "intra")
               << " work from " << tws->GetTracemeId();
       tws->IncrementInflightTaskCount(task_from_blocking_queue);
+      const uint64_t start_time_us = tensorflow::EnvTime::NowMicros();
+      wait_time_cell->Add(start_time_us - t.f->create_time_us);
       env_.ExecuteTask(t);
+      busy_time_cell->IncrementBy(tensorflow::EnvTime::NowMicros() -
+                                  start_time_us);
       tws->DecrementInflightTaskCount(task_from_blocking_queue);
       tws->DecrementPendingTaskCount();
     } else {
@@ -732,14 +820,17 @@ class RunHandlerPool::Impl {
                 options.use_adaptive_waiting_time, options.enable_wake_up,
                 options.max_concurrent_handler,
                 options.num_threads_in_sub_thread_pool,
-                options.sub_thread_request_percentage),
+                options.sub_thread_request_percentage,
+                options.numa_node_of_sub_thread_pool,
+                options.yield_to_higher_priority),
             tensorflow::Env::Default(), tensorflow::ThreadOptions(),
             "tf_run_handler_pool", &waiters_mu_, &queue_waiters_)),
         iterations_(0),
         version_(0),
         wait_if_no_active_request_(options.wait_if_no_active_request),
         sub_thread_pool_end_request_percentage_(
-            options.sub_thread_request_percentage) {
+            options.sub_thread_request_percentage),
+        numa_node_of_sub_thread_pool_(options.numa_node_of_sub_thread_pool) {
     VLOG(1) << "Creating a RunHandlerPool with max handlers: " << max_handlers_;
     free_handlers_.reserve(max_handlers_);
     handlers_.reserve(max_handlers_);
@@ -938,6 +1029,7 @@ class RunHandlerPool::Impl {
   int64_t version_ TF_GUARDED_BY(mu_);
   bool wait_if_no_active_request_;
   const std::vector<double> sub_thread_pool_end_request_percentage_;
+  const std::vector<int> numa_node_of_sub_thread_pool_;
 };
 
 void RunHandlerPool::Impl::RecomputePoolStats(
@@ -953,9 +1045,19 @@ void RunHandlerPool::Impl::RecomputePoolStats(
                  sub_thread_pool_end_request_percentage_[sub_thread_pool_id]) {
       sub_thread_pool_id++;
     }
-    thread_work_sources[i]->SetWaiter(version,
-                                      &queue_waiters_[sub_thread_pool_id],
-                                      &waiters_mu_[sub_thread_pool_id]);
+    // New tasks of a request pinned to a NUMA node wake up the threads on that
+    // node, as the others would not run them.
+    int waiter_id = sub_thread_pool_id;
+    const int numa_node = thread_work_sources[i]->GetNumaNode();
+    if (numa_node != tensorflow::port::kNUMANoAffinity) {
+      auto it = std::find(numa_node_of_sub_thread_pool_.begin(),
+                          numa_node_of_sub_thread_pool_.end(), numa_node);
+      if (it != numa_node_of_sub_thread_pool_.end()) {
+        waiter_id = it - numa_node_of_sub_thread_pool_.begin();
+      }
+    }
+    thread_work_sources[i]->SetWaiter(version, &queue_waiters_[waiter_id],
+                                      &waiters_mu_[waiter_id]);
   }
 
   int num_threads = run_handler_thread_pool()->NumThreads();
@@ -1016,6 +1118,9 @@ void RunHandler::Impl::Reset(int64_t step_id,
   step_id_ = step_id;
   options_ = options;
   tws_.SetTracemeId(step_id);
+  tws_.SetNumaNode(
+      pool_impl_->run_handler_thread_pool()->GetEffectiveNumaNode(
+          options.numa_node));
 }
 
 int RunHandler::Impl::RunHandlerEigenThreadPool::NumThreads() const {
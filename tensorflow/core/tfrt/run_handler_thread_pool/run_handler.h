@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/tfrt/runtime/work_queue_interface.h"
@@ -44,10 +45,16 @@ class RunHandler;
 
 // Options for RunHanler.
 struct RunHandlerOptions {
-  RunHandlerOptions() : priority(0) {}
+  RunHandlerOptions()
+      : priority(0), numa_node(tensorflow::port::kNUMANoAffinity) {}
 
   // Request priority.
   int priority;
+
+  // The NUMA node to run the request on, e.g. the one holding the model
+  // weights. The request is then only run by the threads of the sub thread
+  // pools on that node, if there are any. kNUMANoAffinity means any thread.
+  int numa_node;
 };
 
 // RunHandlerPool is a fixed size pool of pre-allocated RunHandlers
@@ -108,6 +115,17 @@ class RunHandlerPool {
 
     // If true, threads will be waken up by new tasks.
     bool enable_wake_up = true;
+
+    // The NUMA node the threads of each sub thread pool are bound to. If not
+    // empty, the length of the vector should equal to num_sub_thread_pool.
+    // kNUMANoAffinity leaves the threads of a sub thread pool unbound.
+    std::vector<int> numa_node_of_sub_thread_pool;
+
+    // If true, threads look for work in the highest priority requests first
+    // every time they finish a task, instead of going round robin over the
+    // requests. A long running low priority request then gives its threads
+    // up to higher priority requests at the next kernel boundary.
+    bool yield_to_higher_priority = false;
   };
   explicit RunHandlerPool(Options options);
   ~RunHandlerPool();
@@ -182,6 +200,8 @@ class RunHandlerEnvironment {
     TaskFunction f;
     tensorflow::Context context;
     uint64_t trace_id;
+    // When the task was created, in microseconds.
+    uint64_t create_time_us;
   };
   tensorflow::Env* const env_;
   const tensorflow::ThreadOptions thread_options_;
@@ -198,6 +218,10 @@ class RunHandlerEnvironment {
 
   EnvThread* CreateThread(std::function<void()> f);
 
+  // Same as above, but binds the thread to `numa_node` instead of the NUMA
+  // node of the thread options.
+  EnvThread* CreateThread(std::function<void()> f, int numa_node);
+
   Task CreateTask(TaskFunction f);
 
   void ExecuteTask(const Task& t);
@@ -239,6 +263,11 @@ class ThreadWorkSource {
 
   void SetTracemeId(int64_t value);
 
+  // The NUMA node the request is pinned to, or kNUMANoAffinity.
+  int GetNumaNode();
+
+  void SetNumaNode(int numa_node);
+
   void SetWaiter(uint64_t version, Waiter* waiter, tensorflow::mutex* mutex);
 
   int64_t GetInflightTaskCount(bool is_blocking);
@@ -280,6 +309,7 @@ class ThreadWorkSource {
   tensorflow::mutex waiters_mu_;
   Waiter queue_waiters_ TF_GUARDED_BY(waiters_mu_);
   std::atomic<int64_t> traceme_id_;
+  std::atomic<int> numa_node_;
 
   tensorflow::mutex run_handler_waiter_mu_;
   uint64_t version_ TF_GUARDED_BY(run_handler_waiter_mu_);
@@ -301,6 +331,8 @@ class RunHandlerThreadPool {
     int max_concurrent_handler;
     std::vector<int> num_threads_in_sub_thread_pool;
     std::vector<double> sub_thread_request_percentage;
+    std::vector<int> numa_node_of_sub_thread_pool;
+    bool yield_to_higher_priority;
     Options(int num_blocking_threads, int num_non_blocking_threads,
             bool wait_if_no_active_request,
             int non_blocking_threads_sleep_time_micro_sec,
@@ -308,7 +340,9 @@ class RunHandlerThreadPool {
             bool use_adaptive_waiting_time, bool enable_wake_up,
             int max_concurrent_handler,
             const std::vector<int>& num_threads_in_sub_thread_pool,
-            const std::vector<double>& sub_thread_request_percentage)
+            const std::vector<double>& sub_thread_request_percentage,
+            const std::vector<int>& numa_node_of_sub_thread_pool = {},
+            bool yield_to_higher_priority = false)
         : num_blocking_threads(num_blocking_threads),
           num_non_blocking_threads(num_non_blocking_threads),
           wait_if_no_active_request(wait_if_no_active_request),
@@ -320,7 +354,9 @@ class RunHandlerThreadPool {
           enable_wake_up(enable_wake_up),
           max_concurrent_handler(max_concurrent_handler),
           num_threads_in_sub_thread_pool(num_threads_in_sub_thread_pool),
-          sub_thread_request_percentage(sub_thread_request_percentage) {}
+          sub_thread_request_percentage(sub_thread_request_percentage),
+          numa_node_of_sub_thread_pool(numa_node_of_sub_thread_pool),
+          yield_to_higher_priority(yield_to_higher_priority) {}
   };
   struct PerThread {
     constexpr PerThread() : pool(nullptr), thread_id(-1) {}
@@ -357,6 +393,11 @@ class RunHandlerThreadPool {
 
   int NumNonBlockingThreads() const;
 
+  // Returns the NUMA node that requests pinned to `numa_node` actually run
+  // on: `numa_node` if some blocking threads are bound to it, and
+  // kNUMANoAffinity otherwise.
+  int GetEffectiveNumaNode(int numa_node) const;
+
   void WorkerLoop(int thread_id, bool may_steal_blocking_work);
 
   // Search tasks from Requets range searching_range_start to
@@ -389,6 +430,8 @@ class RunHandlerThreadPool {
         current_thread_work_sources;
 
     int sub_thread_pool_id;
+    // The NUMA node the thread is bound to, or kNUMANoAffinity.
+    int numa_node;
   };
 
   const int num_threads_;
@@ -399,6 +442,7 @@ class RunHandlerThreadPool {
   const int non_blocking_thread_sleep_time_;
   const int blocking_thread_max_waiting_time_;
   const bool enable_wake_up_;
+  const bool yield_to_higher_priority_;
   Eigen::MaxSizeVector<ThreadData> thread_data_;
   internal::RunHandlerEnvironment env_;
   std::atomic<bool> cancelled_;
@@ -412,6 +456,8 @@ class RunHandlerThreadPool {
   // the end_request_percentage of previous sub thread pool to its own
   // end_request_percentage in a round robin fashion.
   std::vector<double> sub_thread_pool_end_request_percentage_;
+
+  std::vector<int> numa_node_of_sub_thread_pool_;
 };
 
 }  // namespace internal
@@ -39,6 +39,9 @@ RunHandlerThreadWorkQueue::RunHandlerThreadWorkQueue(const Options& options)
         options.num_sub_thread_pool);
   CHECK(options.sub_thread_request_percentage.size() ==  // Crash OK.
         options.num_sub_thread_pool);
+  CHECK(options.numa_node_of_sub_thread_pool.empty() ||  // Crash OK.
+        options.numa_node_of_sub_thread_pool.size() ==
+            options.num_sub_thread_pool);
 
   RunHandlerPool::Options pool_options;
   pool_options.num_inter_op_threads = options.num_main_threads;
@@ -56,12 +59,16 @@ RunHandlerThreadWorkQueue::RunHandlerThreadWorkQueue(const Options& options)
   pool_options.enable_wake_up = options.enable_wake_up;
   pool_options.wait_if_no_active_request = options.wait_if_no_active_request;
   pool_options.use_adaptive_waiting_time = options.use_adaptive_waiting_time;
+  pool_options.numa_node_of_sub_thread_pool =
+      options.numa_node_of_sub_thread_pool;
+  pool_options.yield_to_higher_priority = options.yield_to_higher_priority;
   handler_pool_ = std::make_unique<RunHandlerPool>(pool_options);
 }
 
 absl::StatusOr<std::unique_ptr<tensorflow::tfrt_stub::WorkQueueInterface>>
 RunHandlerThreadWorkQueue::InitializeRequest(int64_t request_id) const {
   RunHandlerOptions options;
+  options.numa_node = options_.numa_node;
   std::unique_ptr<RunHandler> handler =
       handler_pool_->Get(request_id, options_.init_timeout_ms, options);
   if (!handler) {
@@ -126,7 +133,13 @@ std::ostream& operator<<(std::ostream& strm,
               << options.use_adaptive_waiting_time
               << ", wait_if_no_active_request = "
               << options.wait_if_no_active_request
-              << ", enable_wake_up = " << options.enable_wake_up << "}";
+              << ", enable_wake_up = " << options.enable_wake_up
+              << ", numa_node_of_sub_thread_pool = ["
+              << absl::StrJoin(options.numa_node_of_sub_thread_pool, ",")
+              << "]"
+              << ", numa_node = " << options.numa_node
+              << ", yield_to_higher_priority = "
+              << options.yield_to_higher_priority << "}";
 }
 
 }  // namespace tf
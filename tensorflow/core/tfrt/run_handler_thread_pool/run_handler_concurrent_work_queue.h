@@ -22,6 +22,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/tfrt/run_handler_thread_pool/run_handler.h"
 #include "tensorflow/core/tfrt/runtime/work_queue_interface.h"
@@ -79,6 +80,18 @@ class RunHandlerThreadWorkQueue
 
     // If true, threads will be waken up by new tasks.
     bool enable_wake_up = true;
+
+    // The NUMA node the threads of each sub thread pool are bound to. If not
+    // empty, the length of the vector should equal to num_sub_thread_pool.
+    std::vector<int> numa_node_of_sub_thread_pool;
+
+    // The NUMA node to run the requests on, e.g. the one holding the model
+    // weights, or kNUMANoAffinity.
+    int numa_node = tensorflow::port::kNUMANoAffinity;
+
+    // If true, threads give up low priority requests for higher priority ones
+    // at kernel boundaries. See RunHandlerPool::Options.
+    bool yield_to_higher_priority = false;
   };
 
   explicit RunHandlerThreadWorkQueue(const Options& options);
@@ -137,6 +137,40 @@ TEST(RunHandlerUtilTest, IntraOpThreadPool) {
   notification.WaitForNotification();
 }
 
+TEST(RunHandlerUtilTest, NumaPinnedRequest) {
+  RunHandlerPool::Options pool_options;
+  pool_options.num_inter_op_threads = 4;
+  pool_options.num_intra_op_threads = 1;
+  pool_options.num_sub_thread_pool = 2;
+  // Threads 0 and 1 are in the first sub thread pool, the others in the
+  // second one.
+  pool_options.num_threads_in_sub_thread_pool = {2, 5};
+  pool_options.sub_thread_request_percentage = {0.5, 1.0};
+  pool_options.numa_node_of_sub_thread_pool = {0, 1};
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(pool_options));
+
+  RunHandlerOptions options = RunHandlerOptions();
+  options.numa_node = 1;
+  auto handler = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  auto* intra_pool = handler->AsIntraThreadPoolInterface();
+
+  constexpr int kNumTasks = 20;
+  std::vector<int> thread_ids(kNumTasks, -1);
+  tensorflow::BlockingCounter counter(kNumTasks);
+  for (int i = 0; i < kNumTasks; ++i) {
+    handler->ScheduleInterOpClosure(
+        TaskFunction([&thread_ids, &counter, intra_pool, i]() {
+          thread_ids[i] = intra_pool->CurrentThreadId();
+          counter.DecrementCount();
+        }));
+  }
+  counter.Wait();
+
+  for (int thread_id : thread_ids) {
+    EXPECT_GE(thread_id, 2);
+  }
+}
+
 class RunHandlerThreadPoolTest
     : public testing::TestWithParam<std::tuple<bool, bool>> {
  protected:
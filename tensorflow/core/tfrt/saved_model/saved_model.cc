@@ -54,12 +54,14 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/runtime_fallback/kernel/kernel_fallback_compat_request_state.h"
@@ -779,13 +781,15 @@ absl::StatusOr<std::unique_ptr<SavedModel>> SavedModelImpl::LoadSavedModel(
   }
 
   // Finally, create the saved model.
-  return {std::make_unique<SavedModelImpl>(
+  auto saved_model = std::make_unique<SavedModelImpl>(
       std::move(options), std::move(symbol_uids), std::move(meta_graph_def),
       std::move(bef), std::move(bef_file), std::move(bytecode),
       std::move(loaded_executable),
       std::move(initializers_and_signatures.signature_map),
       std::move(runner_table), std::move(resource_array),
-      std::move(graph_executor))};
+      std::move(graph_executor));
+  TF_RETURN_IF_ERROR(saved_model->PrecompileSignatures());
+  return {std::move(saved_model)};
 }
 
 SavedModelImpl::SavedModelImpl(
@@ -813,6 +817,113 @@ SavedModelImpl::SavedModelImpl(
   }
 }
 
+tensorflow::Status SavedModelImpl::PrecompileSignatures() {
+  // Without lazy loading through the graph executor, the signatures are
+  // compiled along with the saved model.
+  if (!options_.enable_lazy_loading ||
+      !options_.lazy_loading_use_graph_executor) {
+    return absl::OkStatus();
+  }
+
+  std::vector<std::string> names;
+  if (options_.precompile_all_signatures) {
+    names = GetFunctionNames();
+    std::sort(names.begin(), names.end());
+  } else {
+    names = options_.signatures_to_precompile;
+  }
+  if (names.empty()) return absl::OkStatus();
+
+  // The graph executor caches compiled graphs by their sorted feeds and
+  // fetches, so signatures that agree on them share one compiled graph, which
+  // is compiled once.
+  struct SignatureGraph {
+    std::string name;
+    std::vector<std::string> input_names;
+    std::vector<tensorflow::DataType> input_dtypes;
+    std::vector<std::string> output_names;
+  };
+  std::vector<SignatureGraph> graphs;
+  absl::flat_hash_set<std::string> visited_joined_names;
+  const auto& signature_defs = meta_graph_def_.signature_def();
+  for (const std::string& name : names) {
+    const auto sig_iter = signatures_.find(name);
+    TF_RET_CHECK(sig_iter != signatures_.end())
+        << "failed to find signature " << name << " in the graph";
+    const internal::Signature& signature = sig_iter->second;
+    const tensorflow::SignatureDef& signature_def = signature_defs.at(name);
+
+    SignatureGraph graph;
+    graph.name = name;
+    for (int i = 0; i < signature.input_names.size(); ++i) {
+      const auto& tensor_info =
+          signature_def.inputs().at(signature.input_names[i]);
+      TF_RET_CHECK(tensor_info.encoding_case() ==
+                   tensorflow::TensorInfo::kName)
+          << "Only dense tensor is supported, but got encoding case "
+          << tensor_info.encoding_case();
+      graph.input_names.push_back(tensor_info.name());
+      graph.input_dtypes.push_back(signature.input_specs[i].dtype);
+    }
+    for (const auto& output_key : signature.output_names) {
+      const auto& tensor_info = signature_def.outputs().at(output_key);
+      TF_RET_CHECK(tensor_info.encoding_case() ==
+                   tensorflow::TensorInfo::kName)
+          << "Only dense tensor is supported, but got encoding case "
+          << tensor_info.encoding_case();
+      graph.output_names.push_back(tensor_info.name());
+    }
+
+    std::vector<std::string> sorted_input_names = graph.input_names;
+    std::sort(sorted_input_names.begin(), sorted_input_names.end());
+    std::vector<std::string> sorted_output_names = graph.output_names;
+    std::sort(sorted_output_names.begin(), sorted_output_names.end());
+    if (!visited_joined_names
+             .insert(absl::StrCat(absl::StrJoin(sorted_input_names, ","), "^",
+                                  absl::StrJoin(sorted_output_names, ",")))
+             .second) {
+      VLOG(1) << "Signature " << name
+              << " shares its compiled graph with an earlier signature.";
+      continue;
+    }
+    graphs.push_back(std::move(graph));
+  }
+
+  const auto precompile_start_time = absl::Now();
+  const int num_threads = std::min<int>(
+      options_.num_precompile_threads > 0 ? options_.num_precompile_threads
+                                          : tensorflow::port::MaxParallelism(),
+      graphs.size());
+  std::vector<absl::Status> statuses(graphs.size());
+  {
+    tensorflow::thread::ThreadPool thread_pool(
+        tensorflow::Env::Default(), "tfrt_precompile_signatures", num_threads);
+    for (int i = 0; i < graphs.size(); ++i) {
+      thread_pool.Schedule([this, &graphs, &statuses, i]() {
+        const SignatureGraph& graph = graphs[i];
+        statuses[i] = graph_executor_->PrecompileGraph(
+            graph.name, graph.input_names, graph.input_dtypes,
+            graph.output_names, /*target_tensor_names=*/{});
+      });
+    }
+    // The thread pool waits for the compilations when it is destroyed.
+  }
+  for (int i = 0; i < graphs.size(); ++i) {
+    if (!statuses[i].ok()) {
+      return tensorflow::errors::CreateWithUpdatedMessage(
+          statuses[i], absl::StrCat("Failed to precompile signature ",
+                                    graphs[i].name, ": ",
+                                    statuses[i].message()));
+    }
+  }
+  LOG(INFO) << "TFRT finished precompiling " << graphs.size()
+            << " graphs for " << names.size() << " signatures on "
+            << num_threads << " threads. Took "
+            << absl::ToInt64Milliseconds(absl::Now() - precompile_start_time)
+            << " ms.";
+  return absl::OkStatus();
+}
+
 std::vector<std::string> SavedModelImpl::GetFunctionNames() const {
   std::vector<std::string> result;
   for (const auto& entry : signatures_) {
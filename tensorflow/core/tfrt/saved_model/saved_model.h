@@ -110,6 +110,20 @@ class SavedModel {
     // True if and only if SavedModel is being loaded to generate AOT results.
     bool aot_generation = false;
 
+    // Signatures to compile in parallel while loading when lazy loading uses
+    // the graph executor, so that their first runs do not pay for the
+    // compilation. Signatures with the same feeds and fetches share a compiled
+    // graph, which is compiled once.
+    std::vector<std::string> signatures_to_precompile;
+
+    // If true, all signatures are precompiled, regardless of
+    // `signatures_to_precompile`.
+    bool precompile_all_signatures = false;
+
+    // The number of threads that precompile signatures. If zero, one per core
+    // is used.
+    int num_precompile_threads = 0;
+
     GraphExecutionOptions graph_execution_options;
   };
 
@@ -257,6 +271,10 @@ class SavedModelImpl final : public SavedModel {
       std::vector<tensorflow::Tensor>* outputs) override;
 
  private:
+  // Compiles the signatures selected by `Options::signatures_to_precompile` and
+  // `Options::precompile_all_signatures` in parallel.
+  tensorflow::Status PrecompileSignatures();
+
   // The result of loading signature(s).
   struct LoadingResult {
     std::string name;
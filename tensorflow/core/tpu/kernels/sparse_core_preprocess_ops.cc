@@ -44,15 +44,22 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/tpu/kernels/sparse_core_ops_stats_handler.h"
 #include "tensorflow/core/tpu/kernels/sparse_core_ops_utils.h"
+#include "tensorflow/core/util/work_sharder.h"
 #include "tsl/profiler/lib/traceme.h"
 
 namespace tensorflow {
 
 bool IsPowerOfTwo(int32_t x) { return x > 0 && (x & (x - 1)) == 0; }
 
+// Estimated costs in cycles of sorting and deduping an id, and of writing it
+// out, when sharding SortListOfSparseCoreCooTensors across feature groups.
+constexpr int64_t kSortCostPerId = 200;
+constexpr int64_t kWriteCostPerId = 20;
+
 Status ValidateInputs(const Tensor& indices_or_row_splits, const Tensor& values,
                       const Tensor& weights, int sample_count) {
   if (values.dims() != 1) {
@@ -176,117 +183,146 @@ Status ComputeRowIdsBeforePadding(const Tensor& indices_or_row_splits,
   return absl::OkStatus();
 }
 
-absl::Status ConcatInputFeatureFromSameTable(
-    OpInputList* row_ids_list, OpInputList* col_ids_list,
-    OpInputList* gains_list,
-    std::vector<std::unique_ptr<int32_t[]>>* updated_row_ids,
-    std::vector<std::unique_ptr<int32_t[]>>* updated_col_ids,
-    std::vector<std::unique_ptr<float[]>>* updated_gains,
-    std::vector<int32_t>* total_id_counts,
-    std::map<int32_t, std::vector<int32_t>> col_offset_to_feature_id) {
-  int32_t feature_group_id = 0;
-  for (const auto& [col_offset, feature_id_list] : col_offset_to_feature_id) {
-    int32_t total_id_count = 0;
-    for (int32_t feature_id : feature_id_list) {
-      total_id_count += (*col_ids_list)[feature_id].NumElements();
-    }
-    (*total_id_counts)[feature_group_id] = total_id_count;
-    (*updated_row_ids)[feature_group_id] =
-        std::unique_ptr<int32_t[]>(new int32_t[total_id_count]);
-    (*updated_col_ids)[feature_group_id] =
-        std::unique_ptr<int32_t[]>(new int32_t[total_id_count]);
-    (*updated_gains)[feature_group_id] =
-        std::unique_ptr<float[]>(new float[total_id_count]);
-    int32_t tmp_size = 0;
-    for (int32_t feature_id : feature_id_list) {
-      int32_t feature_id_count = (*row_ids_list)[feature_id].NumElements();
-      std::copy_n((*row_ids_list)[feature_id].flat<int32_t>().data(),
-                  feature_id_count,
-                  (*updated_row_ids)[feature_group_id].get() + tmp_size);
-      std::copy_n((*col_ids_list)[feature_id].flat<int32_t>().data(),
-                  feature_id_count,
-                  (*updated_col_ids)[feature_group_id].get() + tmp_size);
-      std::copy_n((*gains_list)[feature_id].flat<float>().data(),
-                  feature_id_count,
-                  (*updated_gains)[feature_group_id].get() + tmp_size);
-      tmp_size += feature_id_count;
+// Concatenates the ids and gains of `feature_ids`, which are mapped to the
+// same table, into `buffers`.
+void ConcatInputFeatureFromSameTable(const OpInputList& row_ids_list,
+                                     const OpInputList& col_ids_list,
+                                     const OpInputList& gains_list,
+                                     absl::Span<const int32_t> feature_ids,
+                                     SparseCoreFeatureGroupBuffers* buffers) {
+  int32_t total_id_count = 0;
+  for (int32_t feature_id : feature_ids) {
+    total_id_count += col_ids_list[feature_id].NumElements();
+  }
+  buffers->row_ids.resize(total_id_count);
+  buffers->col_ids.resize(total_id_count);
+  buffers->gains.resize(total_id_count);
+  int32_t tmp_size = 0;
+  for (int32_t feature_id : feature_ids) {
+    int32_t feature_id_count = row_ids_list[feature_id].NumElements();
+    std::copy_n(row_ids_list[feature_id].flat<int32_t>().data(),
+                feature_id_count, buffers->row_ids.data() + tmp_size);
+    std::copy_n(col_ids_list[feature_id].flat<int32_t>().data(),
+                feature_id_count, buffers->col_ids.data() + tmp_size);
+    std::copy_n(gains_list[feature_id].flat<float>().data(), feature_id_count,
+                buffers->gains.data() + tmp_size);
+    tmp_size += feature_id_count;
+  }
+}
+
+// Sorts the ids in `buffers` by col id, dedups the ids with the same row id
+// and col id, and counts the ids and unique ids of each physical replica.
+void SortDedupAndCountStatsOfCooTensor(int32_t num_physical_replica,
+                                       int32_t num_physical_replica_mod,
+                                       SparseCoreFeatureGroupBuffers* buffers) {
+  const int32_t total_id_count = buffers->col_ids.size();
+  buffers->dedup_ids_index_mapping.resize(total_id_count);
+  buffers->gains_after_dedup.resize(total_id_count);
+  buffers->col_ids_index_list.resize(total_id_count);
+  buffers->id_counter.assign(num_physical_replica, 0);
+  buffers->unique_id_counter.assign(num_physical_replica, 0);
+
+  uint32_t* per_feature_dedup_ids_index_mapping =
+      buffers->dedup_ids_index_mapping.data();
+  float* per_feature_gains_after_dedup = buffers->gains_after_dedup.data();
+  const int32_t* row_ids_ptr = buffers->row_ids.data();
+  const int32_t* col_ids_ptr = buffers->col_ids.data();
+  const float* gains_ptr = buffers->gains.data();
+  uint64_t* per_feature_col_ids_index_list = buffers->col_ids_index_list.data();
+  for (int32_t index = 0; index < total_id_count; ++index) {
+    per_feature_col_ids_index_list[index] =
+        (static_cast<uint64_t>(*(col_ids_ptr + index)) << 32) + index;
+  }
+  hwy::VQSort(per_feature_col_ids_index_list, total_id_count,
+              hwy::SortAscending());
+
+  // Loop through the col ids to count the ids and unique ids.
+  int32_t previous_col_id = -1;
+  int32_t previous_row_id = -1;
+  uint32_t previous_id_array_index = 0;
+  for (int32_t index = 0; index < total_id_count; ++index) {
+    uint64_t item = per_feature_col_ids_index_list[index];
+    int32 col_id = item >> 32;
+    uint32_t id_array_index = item & 0xffffffff;
+    int32_t row_id = *(row_ids_ptr + id_array_index);
+    // If the row ids and col ids are both same as the previous one,
+    // dedup the id by adding the gains.
+    if (row_id != previous_row_id || col_id != previous_col_id) {
+      per_feature_dedup_ids_index_mapping[id_array_index] = id_array_index;
+      per_feature_gains_after_dedup[id_array_index] =
+          *(gains_ptr + id_array_index);
+      uint32_t replica_id = col_id & num_physical_replica_mod;
+      buffers->id_counter[replica_id]++;
+      if (col_id != previous_col_id) buffers->unique_id_counter[replica_id]++;
+    } else {
+      // Dedup the id if both row id and col id is the same.
+      uint32_t parent_idx =
+          per_feature_dedup_ids_index_mapping[previous_id_array_index];
+      per_feature_dedup_ids_index_mapping[id_array_index] = parent_idx;
+      per_feature_gains_after_dedup[parent_idx] +=
+          *(gains_ptr + id_array_index);
     }
-    feature_group_id++;
+    previous_id_array_index = id_array_index;
+    previous_col_id = col_id;
+    previous_row_id = row_id;
   }
-  return absl::OkStatus();
 }
 
-absl::Status SortDedupAndCountStatsOfCooTensor(
-    std::vector<std::unique_ptr<int32_t[]>>* updated_row_ids,
-    std::vector<std::unique_ptr<int32_t[]>>* updated_col_ids,
-    std::vector<std::unique_ptr<float[]>>* updated_gains,
-    std::vector<int32_t>* total_id_counts,
-    std::vector<std::unique_ptr<uint32_t[]>>* dedup_ids_index_mapping,
-    std::vector<std::unique_ptr<float[]>>* gains_after_dedup,
-    std::vector<std::unique_ptr<uint64_t[]>>* col_ids_index_list,
+// Concatenates, sorts and dedups the ids of each feature group of
+// `col_offset_to_feature_id` into `buffers`, and sums up the id counts of each
+// physical replica. The feature groups are independent of each other, so they
+// are processed in parallel.
+void SortDedupAndCountStatsOfFeatureGroups(
+    OpKernelContext* ctx, const OpInputList& row_ids_list,
+    const OpInputList& col_ids_list, const OpInputList& gains_list,
+    const std::map<int32_t, std::vector<int32_t>>& col_offset_to_feature_id,
+    int32_t num_physical_replica, int32_t num_physical_replica_mod,
+    std::vector<SparseCoreFeatureGroupBuffers>* buffers,
     std::vector<int32_t>* total_id_counter,
-    std::vector<int32_t>* total_unique_id_counter,
-    int32_t num_physical_replica_mod, int32_t num_input_feature_group) {
-  for (int feature_group_id = 0; feature_group_id < num_input_feature_group;
-       ++feature_group_id) {
-    int32_t total_id_count = (*total_id_counts)[feature_group_id];
-    (*dedup_ids_index_mapping)[feature_group_id] =
-        std::unique_ptr<uint32_t[]>(new uint32_t[total_id_count]);
-
-    (*gains_after_dedup)[feature_group_id] =
-        std::unique_ptr<float[]>(new float[total_id_count]);
-
-    uint32_t* per_feature_dedup_ids_index_mapping =
-        (*dedup_ids_index_mapping)[feature_group_id].get();
-
-    float* per_feature_gains_after_dedup =
-        (*gains_after_dedup)[feature_group_id].get();
-    const int32_t* row_ids_ptr = (*updated_row_ids)[feature_group_id].get();
-    const int32_t* col_ids_ptr = (*updated_col_ids)[feature_group_id].get();
-    const float* gains_ptr = (*updated_gains)[feature_group_id].get();
-    (*col_ids_index_list)[feature_group_id] =
-        std::make_unique<uint64_t[]>(total_id_count);
-    uint64_t* per_feature_col_ids_index_list =
-        (*col_ids_index_list)[feature_group_id].get();
-    for (int32_t index = 0; index < total_id_count; ++index) {
-      per_feature_col_ids_index_list[index] =
-          (static_cast<uint64_t>(*(col_ids_ptr + index)) << 32) + index;
+    std::vector<int32_t>* total_unique_id_counter) {
+  const int32_t num_input_feature_group = col_offset_to_feature_id.size();
+  std::vector<const std::vector<int32_t>*> feature_ids_list;
+  feature_ids_list.reserve(num_input_feature_group);
+  int64_t total_id_count = 0;
+  for (const auto& [col_offset, feature_ids] : col_offset_to_feature_id) {
+    feature_ids_list.push_back(&feature_ids);
+    for (int32_t feature_id : feature_ids) {
+      total_id_count += col_ids_list[feature_id].NumElements();
     }
-    hwy::VQSort(per_feature_col_ids_index_list, total_id_count,
-                hwy::SortAscending());
+  }
+  buffers->resize(num_input_feature_group);
+
+  auto* worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers,
+        num_input_feature_group,
+        kSortCostPerId * std::max<int64_t>(
+                             1, total_id_count /
+                                    std::max(1, num_input_feature_group)),
+        [&](int64_t begin, int64_t end) {
+          for (int64_t feature_group_id = begin; feature_group_id < end;
+               ++feature_group_id) {
+            SparseCoreFeatureGroupBuffers* group_buffers =
+                &(*buffers)[feature_group_id];
+            // Concatenate the input features together if they are mapped to
+            // the same table.
+            ConcatInputFeatureFromSameTable(
+                row_ids_list, col_ids_list, gains_list,
+                *feature_ids_list[feature_group_id], group_buffers);
+            SortDedupAndCountStatsOfCooTensor(num_physical_replica,
+                                              num_physical_replica_mod,
+                                              group_buffers);
+          }
+        });
 
-    // Loop through the col ids to count the ids and unique ids.
-    int32_t previous_col_id = -1;
-    int32_t previous_row_id = -1;
-    uint32_t previous_id_array_index = 0;
-    for (int32_t index = 0; index < total_id_count; ++index) {
-      uint64_t item = per_feature_col_ids_index_list[index];
-      int32 col_id = item >> 32;
-      uint32_t id_array_index = item & 0xffffffff;
-      int32_t row_id = *(row_ids_ptr + id_array_index);
-      // If the row ids and col ids are both same as the previous one,
-      // dedup the id by adding the gains.
-      if (row_id != previous_row_id || col_id != previous_col_id) {
-        per_feature_dedup_ids_index_mapping[id_array_index] = id_array_index;
-        per_feature_gains_after_dedup[id_array_index] =
-            *(gains_ptr + id_array_index);
-        uint32_t replica_id = col_id & num_physical_replica_mod;
-        (*total_id_counter)[replica_id]++;
-        if (col_id != previous_col_id) (*total_unique_id_counter)[replica_id]++;
-      } else {
-        // Dedup the id if both row id and col id is the same.
-        uint32_t parent_idx =
-            per_feature_dedup_ids_index_mapping[previous_id_array_index];
-        per_feature_dedup_ids_index_mapping[id_array_index] = parent_idx;
-        per_feature_gains_after_dedup[parent_idx] +=
-            *(gains_ptr + id_array_index);
-      }
-      previous_id_array_index = id_array_index;
-      previous_col_id = col_id;
-      previous_row_id = row_id;
+  total_id_counter->assign(num_physical_replica, 0);
+  total_unique_id_counter->assign(num_physical_replica, 0);
+  for (const SparseCoreFeatureGroupBuffers& group_buffers : *buffers) {
+    for (int replica_id = 0; replica_id < num_physical_replica; ++replica_id) {
+      (*total_id_counter)[replica_id] += group_buffers.id_counter[replica_id];
+      (*total_unique_id_counter)[replica_id] +=
+          group_buffers.unique_id_counter[replica_id];
     }
   }
-  return absl::OkStatus();
 }
 
 // Convert the input sparse/dense/ragged tensor into COO format and normalize
@@ -1426,9 +1462,6 @@ void SortListOfSparseCoreCooTensorsOp::Compute(OpKernelContext* ctx) {
 
   const int32_t num_input_feature_group = col_offset_to_feature_id_.size();
 
-  std::vector<std::unique_ptr<uint64_t[]>> col_ids_index_list(
-      num_input_feature_group);
-
   const int32_t num_physical_replica_mod = (1 << num_physical_replica_bit_) - 1;
 
   Tensor* id_counts_tensor;
@@ -1438,33 +1471,17 @@ void SortListOfSparseCoreCooTensorsOp::Compute(OpKernelContext* ctx) {
   int32_t* id_counts_tensor_ptr = id_counts_tensor->flat<int32_t>().data();
   *id_counts_tensor_ptr = 0;
 
-  std::vector<int32_t> total_id_counter(num_physical_replica_);
-  std::vector<int32_t> total_unique_id_counter(num_physical_replica_);
-  std::vector<std::unique_ptr<uint32_t[]>> dedup_ids_index_mapping(
-      num_input_feature_group);
-  std::vector<std::unique_ptr<float[]>> gains_after_dedup(
-      num_input_feature_group);
-
-  std::vector<int32_t> total_id_counts(num_input_feature_group);
-  std::vector<std::unique_ptr<int32_t[]>> updated_row_ids(
-      num_input_feature_group);
-  std::vector<std::unique_ptr<int32_t[]>> updated_col_ids(
-      num_input_feature_group);
-  std::vector<std::unique_ptr<float[]>> updated_gains(num_input_feature_group);
-
-  // Concatenate the input features together if they are mapped to the same
-  // table.
-  OP_REQUIRES_OK(ctx, ConcatInputFeatureFromSameTable(
-                          &row_ids_list, &col_ids_list, &gains_list,
-                          &updated_row_ids, &updated_col_ids, &updated_gains,
-                          &total_id_counts, col_offset_to_feature_id_));
-
-  OP_REQUIRES_OK(
-      ctx, SortDedupAndCountStatsOfCooTensor(
-               &updated_row_ids, &updated_col_ids, &updated_gains,
-               &total_id_counts, &dedup_ids_index_mapping, &gains_after_dedup,
-               &col_ids_index_list, &total_id_counter, &total_unique_id_counter,
-               num_physical_replica_mod, num_input_feature_group));
+  std::vector<SparseCoreFeatureGroupBuffers> buffers;
+  {
+    mutex_lock l(buffers_mu_);
+    buffers.swap(buffers_);
+  }
+  std::vector<int32_t> total_id_counter;
+  std::vector<int32_t> total_unique_id_counter;
+  SortDedupAndCountStatsOfFeatureGroups(
+      ctx, row_ids_list, col_ids_list, gains_list, col_offset_to_feature_id_,
+      num_physical_replica_, num_physical_replica_mod, &buffers,
+      &total_id_counter, &total_unique_id_counter);
 
   for (int replica_id = 0; replica_id < num_physical_replica_; ++replica_id) {
     // If the one of the replica (unique) id count is larger than the max
@@ -1512,45 +1529,63 @@ void SortListOfSparseCoreCooTensorsOp::Compute(OpKernelContext* ctx) {
       sorted_col_ids_tensor->flat<int32_t>().data();
   float* sorted_gains_tensor_ptr = sorted_gains_tensor->flat<float>().data();
 
-  std::vector<int32_t> per_physical_replica_index(num_physical_replica_);
-
-  for (int feature_group_id = 0; feature_group_id < num_input_feature_group;
-       ++feature_group_id) {
-    const int32_t* row_ids_ptr = updated_row_ids[feature_group_id].get();
-
-    const uint32_t* per_feature_dedup_ids_index_mapping =
-        dedup_ids_index_mapping[feature_group_id].get();
-
-    const float* per_feature_gains_after_dedup =
-        gains_after_dedup[feature_group_id].get();
-
-    const uint64_t* per_feature_col_ids_index_list =
-        col_ids_index_list[feature_group_id].get();
-
-    const int32_t total_id_count = total_id_counts[feature_group_id];
-
-    for (int32_t index = 0; index < total_id_count; ++index) {
-      uint64_t item = per_feature_col_ids_index_list[index];
-      uint32_t id_array_index = item & 0xffffffff;
-      if (id_array_index !=
-          per_feature_dedup_ids_index_mapping[id_array_index]) {
-        continue;
-      }
-      int32_t col_id = item >> 32;
-      int32_t replica_id = col_id & num_physical_replica_mod;
-
-      int32_t main_index = *(id_counts_tensor_ptr + replica_id) +
-                           per_physical_replica_index[replica_id];
-      *(sorted_row_ids_tensor_ptr + main_index) =
-          *(row_ids_ptr + id_array_index) % per_sparse_core_batch_size;
-      *(sorted_col_ids_tensor_ptr + main_index) =
-          col_id >> num_physical_replica_bit_;
-      // Use the updated gains instead.
-      *(sorted_gains_tensor_ptr + main_index) =
-          per_feature_gains_after_dedup[id_array_index];
-      ++per_physical_replica_index[replica_id];
+  // The ids of each physical replica are laid out feature group after feature
+  // group, so each feature group starts at a known index of each replica and
+  // can be written out independently.
+  std::vector<int32_t> per_physical_replica_index(num_input_feature_group *
+                                                  num_physical_replica_);
+  for (int replica_id = 0; replica_id < num_physical_replica_; ++replica_id) {
+    int32_t index = *(id_counts_tensor_ptr + replica_id);
+    for (int feature_group_id = 0; feature_group_id < num_input_feature_group;
+         ++feature_group_id) {
+      per_physical_replica_index[feature_group_id * num_physical_replica_ +
+                                 replica_id] = index;
+      index += buffers[feature_group_id].id_counter[replica_id];
     }
   }
+
+  auto* worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers,
+        num_input_feature_group,
+        kWriteCostPerId * std::max(1, updated_total_id_count /
+                                          std::max(1, num_input_feature_group)),
+        [&](int64_t begin, int64_t end) {
+          for (int64_t feature_group_id = begin; feature_group_id < end;
+               ++feature_group_id) {
+            const SparseCoreFeatureGroupBuffers& group_buffers =
+                buffers[feature_group_id];
+            const int32_t* row_ids_ptr = group_buffers.row_ids.data();
+            const uint32_t* per_feature_dedup_ids_index_mapping =
+                group_buffers.dedup_ids_index_mapping.data();
+            const float* per_feature_gains_after_dedup =
+                group_buffers.gains_after_dedup.data();
+            int32_t* replica_index =
+                &per_physical_replica_index[feature_group_id *
+                                            num_physical_replica_];
+
+            for (uint64_t item : group_buffers.col_ids_index_list) {
+              uint32_t id_array_index = item & 0xffffffff;
+              if (id_array_index !=
+                  per_feature_dedup_ids_index_mapping[id_array_index]) {
+                continue;
+              }
+              int32_t col_id = item >> 32;
+              int32_t replica_id = col_id & num_physical_replica_mod;
+
+              int32_t main_index = replica_index[replica_id]++;
+              *(sorted_row_ids_tensor_ptr + main_index) =
+                  *(row_ids_ptr + id_array_index) % per_sparse_core_batch_size;
+              *(sorted_col_ids_tensor_ptr + main_index) =
+                  col_id >> num_physical_replica_bit_;
+              // Use the updated gains instead.
+              *(sorted_gains_tensor_ptr + main_index) =
+                  per_feature_gains_after_dedup[id_array_index];
+            }
+          }
+        });
+
+  mutex_lock l(buffers_mu_);
+  buffers_.swap(buffers);
 }
 
 REGISTER_KERNEL_BUILDER(
@@ -1850,40 +1885,15 @@ void GetStatsFromListOfSparseCoreCooTensorsOp::Compute(OpKernelContext* ctx) {
   OP_REQUIRES_OK(ctx, ctx->input_list("col_ids_list", &col_ids_list));
   OP_REQUIRES_OK(ctx, ctx->input_list("gains_list", &gains_list));
 
-  const int32_t num_input_feature_group = col_offset_to_feature_id_.size();
-
-  std::vector<std::unique_ptr<uint64_t[]>> col_ids_index_list(
-      num_input_feature_group);
-
   const int32_t num_physical_replica_mod = (1 << num_physical_replica_bit_) - 1;
 
-  std::vector<int32_t> total_id_counter(num_physical_replica_);
-  std::vector<int32_t> total_unique_id_counter(num_physical_replica_);
-  std::vector<std::unique_ptr<uint32_t[]>> dedup_ids_index_mapping(
-      num_input_feature_group);
-  std::vector<std::unique_ptr<float[]>> gains_after_dedup(
-      num_input_feature_group);
-
-  std::vector<int32_t> total_id_counts(num_input_feature_group);
-  std::vector<std::unique_ptr<int32_t[]>> updated_row_ids(
-      num_input_feature_group);
-  std::vector<std::unique_ptr<int32_t[]>> updated_col_ids(
-      num_input_feature_group);
-  std::vector<std::unique_ptr<float[]>> updated_gains(num_input_feature_group);
-
-  // Concatenate the input features together if they are mapped to the same
-  // table.
-  OP_REQUIRES_OK(ctx, ConcatInputFeatureFromSameTable(
-                          &row_ids_list, &col_ids_list, &gains_list,
-                          &updated_row_ids, &updated_col_ids, &updated_gains,
-                          &total_id_counts, col_offset_to_feature_id_));
-
-  OP_REQUIRES_OK(
-      ctx, SortDedupAndCountStatsOfCooTensor(
-               &updated_row_ids, &updated_col_ids, &updated_gains,
-               &total_id_counts, &dedup_ids_index_mapping, &gains_after_dedup,
-               &col_ids_index_list, &total_id_counter, &total_unique_id_counter,
-               num_physical_replica_mod, num_input_feature_group));
+  std::vector<SparseCoreFeatureGroupBuffers> buffers;
+  std::vector<int32_t> total_id_counter;
+  std::vector<int32_t> total_unique_id_counter;
+  SortDedupAndCountStatsOfFeatureGroups(
+      ctx, row_ids_list, col_ids_list, gains_list, col_offset_to_feature_id_,
+      num_physical_replica_, num_physical_replica_mod, &buffers,
+      &total_id_counter, &total_unique_id_counter);
 
   int32_t max_ids_per_sparse_core = *absl::c_max_element(total_id_counter);
   int32_t max_unique_ids_per_sparse_core =
@@ -24,7 +24,9 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/tpu/kernels/sparse_core_ops_stats_handler.h"
@@ -182,6 +184,25 @@ class ConvertToListOfSparseCoreCooTensorsOp : public OpKernel {
   std::string combiner_;
 };
 
+// Buffers used by SortListOfSparseCoreCooTensorsOp to sort the ids of the
+// features mapped to the same table.
+struct SparseCoreFeatureGroupBuffers {
+  // Concatenated ids and gains of the features in the group.
+  std::vector<int32_t> row_ids;
+  std::vector<int32_t> col_ids;
+  std::vector<float> gains;
+  // Col ids in the high 32 bits and the index of the id in the low 32 bits,
+  // sorted by col id.
+  std::vector<uint64_t> col_ids_index_list;
+  // Index of the first occurrence of each (row id, col id) pair, and the sum
+  // of the gains of its occurrences.
+  std::vector<uint32_t> dedup_ids_index_mapping;
+  std::vector<float> gains_after_dedup;
+  // Number of ids and unique ids per physical replica after dedup.
+  std::vector<int32_t> id_counter;
+  std::vector<int32_t> unique_id_counter;
+};
+
 class SortListOfSparseCoreCooTensorsOp : public OpKernel {
  public:
   explicit SortListOfSparseCoreCooTensorsOp(OpKernelConstruction* ctx);
@@ -205,6 +226,12 @@ class SortListOfSparseCoreCooTensorsOp : public OpKernel {
   std::vector<int32_t> sample_count_list_;
   std::vector<int32_t> col_offset_list_;
   std::map<int32_t, std::vector<int32_t>> col_offset_to_feature_id_;
+
+  mutex buffers_mu_;
+  // Buffers of each feature group, kept across steps to avoid reallocating
+  // them. A step running concurrently with another one allocates its own.
+  std::vector<SparseCoreFeatureGroupBuffers> buffers_
+      TF_GUARDED_BY(buffers_mu_);
 };
 
 class ConvertToSparseCoreCsrWrappedCooTensorOp : public OpKernel {
@@ -0,0 +1,100 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int32_t kNumReplica = 4;
+constexpr int32_t kNumScPerChip = 4;
+constexpr int32_t kSampleCount = 1024;
+constexpr int32_t kVocabSize = 1 << 20;
+
+// Builds a graph sorting `num_features` features with `ids_per_feature` random
+// ids each, every feature being mapped to a different table offset.
+Graph* SortListOfSparseCoreCooTensors(int num_features, int ids_per_feature) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int32_t> row_dist(0, kSampleCount - 1);
+  std::uniform_int_distribution<int32_t> col_dist(0, kVocabSize - 1);
+  std::vector<NodeBuilder::NodeOut> row_ids_list;
+  std::vector<NodeBuilder::NodeOut> col_ids_list;
+  std::vector<NodeBuilder::NodeOut> gains_list;
+  std::vector<int32_t> sample_count_list;
+  std::vector<int32_t> col_offset_list;
+  for (int feature = 0; feature < num_features; ++feature) {
+    Tensor row_ids(DT_INT32, TensorShape({ids_per_feature}));
+    Tensor col_ids(DT_INT32, TensorShape({ids_per_feature}));
+    Tensor gains(DT_FLOAT, TensorShape({ids_per_feature}));
+    for (int i = 0; i < ids_per_feature; ++i) {
+      row_ids.flat<int32_t>()(i) = row_dist(gen);
+      col_ids.flat<int32_t>()(i) = col_dist(gen);
+    }
+    gains.flat<float>().setConstant(1.0f);
+    row_ids_list.emplace_back(test::graph::Constant(g, row_ids));
+    col_ids_list.emplace_back(test::graph::Constant(g, col_ids));
+    gains_list.emplace_back(test::graph::Constant(g, gains));
+    sample_count_list.push_back(kSampleCount);
+    col_offset_list.push_back(feature * kVocabSize);
+  }
+
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SortListOfSparseCoreCooTensors")
+                  .Input(row_ids_list)
+                  .Input(col_ids_list)
+                  .Input(gains_list)
+                  .Attr("sample_count_list", sample_count_list)
+                  .Attr("col_offset_list", col_offset_list)
+                  .Attr("num_replica", kNumReplica)
+                  .Attr("table_vocab_size", kVocabSize)
+                  .Attr("feature_width", 8)
+                  .Attr("num_sc_per_chip", kNumScPerChip)
+                  .Attr("max_ids_per_sparse_core",
+                        num_features * ids_per_feature)
+                  .Attr("max_unique_ids_per_sparse_core",
+                        num_features * ids_per_feature)
+                  .Attr("table_name", "table")
+                  .Finalize(g, &ret));
+  return g;
+}
+
+void BM_SortListOfSparseCoreCooTensors(::testing::benchmark::State& state) {
+  const int num_features = state.range(0);
+  const int ids_per_feature = state.range(1);
+  test::Benchmark("cpu",
+                  SortListOfSparseCoreCooTensors(num_features, ids_per_feature),
+                  /*old_benchmark_api*/ false)
+      .Run(state);
+  state.SetItemsProcessed(state.iterations() * num_features *
+                          ids_per_feature);
+}
+
+BENCHMARK(BM_SortListOfSparseCoreCooTensors)
+    ->ArgPair(1, 16384)
+    ->ArgPair(16, 16384)
+    ->ArgPair(128, 4096)
+    ->ArgPair(512, 1024);
+
+}  // namespace
+}  // namespace tensorflow
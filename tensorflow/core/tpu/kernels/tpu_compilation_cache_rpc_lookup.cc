@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/tpu/kernels/tpu_compilation_cache_rpc_lookup.h"
 
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <string>
@@ -23,6 +24,11 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/tpu/kernels/tpu_compilation_cache_rpc_support.h"
 
 namespace tensorflow {
@@ -36,6 +42,8 @@ using ResponseType = GetTpuProgramResponse;
 #endif
 
 static constexpr absl::Duration kProtoTimeout = absl::Minutes(15);
+// Maximum number of programs fetched concurrently by Prefetch().
+static constexpr int kMaxPrefetchThreads = 16;
 static gpr_timespec TimeToGprTimespec(absl::Time time) {
   if (time == absl::InfiniteFuture()) {
     return gpr_inf_future(GPR_CLOCK_REALTIME);
@@ -53,8 +61,10 @@ static gpr_timespec TimeToGprTimespec(absl::Time time) {
 }
 }  // namespace
 TpuCompilationCacheRpcLookup::TpuCompilationCacheRpcLookup(
-    const std::string& server_address, int64_t max_cache_size)
-    : max_cache_size_(max_cache_size) {
+    const std::string& server_address, int64_t max_cache_size,
+    const std::string& persistent_cache_dir)
+    : max_cache_size_(max_cache_size),
+      persistent_cache_dir_(persistent_cache_dir) {
   // Ensure that large TPU program can get sent over the channel.
   ::grpc::ChannelArguments args;
   args.SetInt(GRPC_ARG_MAX_MESSAGE_LENGTH, std::numeric_limits<int32>::max());
@@ -62,6 +72,13 @@ TpuCompilationCacheRpcLookup::TpuCompilationCacheRpcLookup(
       ::grpc::CreateCustomChannel(absl::StrCat("dns:///", server_address),
                                   CreateChannelCredentials(), args);
   stub_ = tpu::grpc::TpuCompilationCacheService::NewStub(channel);
+  if (!persistent_cache_dir_.empty()) {
+    Status s = Env::Default()->RecursivelyCreateDir(persistent_cache_dir_);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to create TPU program cache directory "
+                   << persistent_cache_dir_ << ": " << s;
+    }
+  }
   VLOG(1) << "Created RPC lookup cache size " << max_cache_size_ << " bytes.";
 }
 
@@ -71,33 +88,13 @@ Status TpuCompilationCacheRpcLookup::Lookup(
     tpu::CompilationCacheFetchTarget fetch_target) {
   tsl::profiler::TraceMe proto_lookup_traceme("Remote TPU proto cache lookup",
                                               /*level=*/2);
-  entry->reset();
-  std::shared_ptr<CacheEntry> cache_entry;
-  // Keep a reference to CacheEntry objects evicted from the cache so that the
-  // potential deletion happens outside the lock upon method exit.
-  std::vector<std::shared_ptr<CacheEntry>> removed_entries;
-
   std::string local_proto_key = absl::StrCat(
       proto_key, "_", tpu::CompilationCacheFetchTarget_Name(fetch_target));
-
-  {
-    absl::MutexLock lock(&mu_);
-    auto iter = cache_.find(local_proto_key);
-    if (iter == cache_.end()) {
-      tpu::GetTpuProgramRequest request;
-      request.set_key(proto_key);
-      request.set_fetch_target(fetch_target);
-      TF_RETURN_IF_ERROR(
-          RemoteLookupLocked(local_proto_key, request, &cache_entry));
-    } else {
-      VLOG(1) << "Found key " << local_proto_key << " in local proto cache.";
-      cache_entry = iter->second;
-      auto erased = entries_by_last_use_.erase(cache_entry->last_use);
-      CHECK_EQ(erased, 1);
-    }
-    PostLookupLocked(&cache_entry, entry, &removed_entries);
-  }
-  return absl::OkStatus();
+  tpu::GetTpuProgramRequest request;
+  request.set_key(proto_key);
+  request.set_fetch_target(fetch_target);
+  return LookupOrFetch(local_proto_key, request,
+                       PersistentCachePath(local_proto_key), entry);
 }
 
 Status TpuCompilationCacheRpcLookup::Lookup(
@@ -107,12 +104,6 @@ Status TpuCompilationCacheRpcLookup::Lookup(
   tsl::profiler::TraceMe proto_lookup_traceme(
       "Remote TPU proto cache lookup by uid",
       /*level=*/2);
-  entry->reset();
-  std::shared_ptr<CacheEntry> cache_entry;
-  // Keep a reference to CacheEntry objects evicted from the cache so that the
-  // potential deletion happens outside the lock upon method exit.
-  std::vector<std::shared_ptr<CacheEntry>> removed_entries;
-
   // Make a string key so that we can uniformly store cached entries under
   // string keys whether they are looked up by proto_key or uid+index. The
   // expectation is that any given executable will only ever be looked up
@@ -122,21 +113,82 @@ Status TpuCompilationCacheRpcLookup::Lookup(
   std::string local_proto_key =
       absl::StrCat(" _ ", uid, ":", proto_index, "_",
                    tpu::CompilationCacheFetchTarget_Name(fetch_target));
+  tpu::GetTpuProgramRequest request;
+  tpu::TpuCompilationUidAndIndex* uid_and_index =
+      request.mutable_uid_and_index();
+  uid_and_index->set_uid(uid);
+  uid_and_index->set_proto_index(proto_index);
+  request.set_fetch_target(fetch_target);
+  // Uids are only valid for the lifetime of the central cache, so programs
+  // looked up by uid are not persisted.
+  return LookupOrFetch(local_proto_key, request,
+                       /*persistent_cache_path=*/"", entry);
+}
+
+Status TpuCompilationCacheRpcLookup::Prefetch(
+    absl::Span<const std::string> proto_keys,
+    tpu::CompilationCacheFetchTarget fetch_target) {
+  if (proto_keys.empty()) {
+    return absl::OkStatus();
+  }
+  tsl::profiler::TraceMe prefetch_traceme("Remote TPU proto cache prefetch",
+                                          /*level=*/2);
+  std::vector<Status> statuses(proto_keys.size());
+  {
+    thread::ThreadPool pool(
+        Env::Default(), "tpu_program_prefetch",
+        std::min<int>(kMaxPrefetchThreads, proto_keys.size()));
+    for (int i = 0; i < proto_keys.size(); ++i) {
+      pool.Schedule([this, &proto_keys, &statuses, fetch_target, i]() {
+        std::unique_ptr<CompilationCacheEntryRef> entry;
+        statuses[i] = Lookup(proto_keys[i], &entry, fetch_target);
+      });
+    }
+  }
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  return absl::OkStatus();
+}
+
+Status TpuCompilationCacheRpcLookup::LookupOrFetch(
+    const std::string& local_proto_key,
+    const tpu::GetTpuProgramRequest& request,
+    const std::string& persistent_cache_path,
+    std::unique_ptr<CompilationCacheEntryRef>* entry) {
+  entry->reset();
+  std::shared_ptr<CacheEntry> cache_entry;
+  std::shared_ptr<CacheEntry> fetched_entry;
+  // Keep a reference to CacheEntry objects evicted from the cache so that the
+  // potential deletion happens outside the lock upon method exit.
+  std::vector<std::shared_ptr<CacheEntry>> removed_entries;
+
+  {
+    absl::MutexLock lock(&mu_);
+    auto iter = cache_.find(local_proto_key);
+    if (iter != cache_.end()) {
+      VLOG(1) << "Found key " << local_proto_key << " in local proto cache.";
+      cache_entry = iter->second;
+      auto erased = entries_by_last_use_.erase(cache_entry->last_use);
+      CHECK_EQ(erased, 1);
+      PostLookupLocked(&cache_entry, entry, &removed_entries);
+      return absl::OkStatus();
+    }
+  }
+
+  TF_RETURN_IF_ERROR(RemoteLookup(local_proto_key, request,
+                                  persistent_cache_path, &fetched_entry));
+
   {
     absl::MutexLock lock(&mu_);
     auto iter = cache_.find(local_proto_key);
     if (iter == cache_.end()) {
-      tpu::GetTpuProgramRequest request;
-      tpu::TpuCompilationUidAndIndex* uid_and_index =
-          request.mutable_uid_and_index();
-      uid_and_index->set_uid(uid);
-      uid_and_index->set_proto_index(proto_index);
-      request.set_fetch_target(fetch_target);
-      TF_RETURN_IF_ERROR(
-          RemoteLookupLocked(local_proto_key, request, &cache_entry));
+      cache_entry = fetched_entry;
+      cache_.emplace(local_proto_key, cache_entry);
+      cache_size_ += cache_entry->size;
     } else {
-      VLOG(1) << "Found uid " << uid << " and index " << proto_index
-              << " in local proto cache.";
+      // Another thread fetched the same program in the meantime. Use its entry
+      // and drop `fetched_entry` outside the lock.
       cache_entry = iter->second;
       auto erased = entries_by_last_use_.erase(cache_entry->last_use);
       CHECK_EQ(erased, 1);
@@ -146,31 +198,75 @@ Status TpuCompilationCacheRpcLookup::Lookup(
   return absl::OkStatus();
 }
 
-Status TpuCompilationCacheRpcLookup::RemoteLookupLocked(
+Status TpuCompilationCacheRpcLookup::RemoteLookup(
     const std::string& local_proto_key,
     const tpu::GetTpuProgramRequest& request,
+    const std::string& persistent_cache_path,
     std::shared_ptr<CacheEntry>* cache_entry) {
+  Env* env = Env::Default();
+  ResponseType response;
+  if (!persistent_cache_path.empty() &&
+      env->FileExists(persistent_cache_path).ok()) {
+    tsl::profiler::TraceMe proto_lookup_traceme(
+        "Persistent TPU proto cache read", /*level=*/2);
+    Status s = ReadBinaryProto(env, persistent_cache_path, &response);
+    if (s.ok()) {
+      s = DeserializeRpcResponseToCacheEntry(local_proto_key, &response,
+                                             cache_entry);
+    }
+    if (s.ok()) {
+      VLOG(1) << "Read key " << local_proto_key << " from "
+              << persistent_cache_path;
+      return absl::OkStatus();
+    }
+    // Fall back to the central cache if the file is unreadable, e.g. because
+    // it was written by an incompatible version.
+    LOG(WARNING) << "Failed to read TPU program " << local_proto_key
+                 << " from " << persistent_cache_path << ": " << s;
+    response.Clear();
+  }
+
   tsl::profiler::TraceMe proto_lookup_traceme("Remote TPU proto cache fetch",
                                               /*level=*/2);
-  // Perform the RPC while holding the lock unless it is demonstrated that
-  // this causes a performance problem.
   ::grpc::ClientContext client_context;
   client_context.set_deadline(TimeToGprTimespec(::absl::Now() + kProtoTimeout));
   client_context.set_compression_algorithm(GRPC_COMPRESS_GZIP);
 
-  ResponseType response;
   Status s =
       FromGrpcStatus(stub_->GetTpuProgram(&client_context, request, &response));
   VLOG(1) << "Looked up key " << local_proto_key
           << " in remote subgraph cache status " << s;
   TF_RETURN_IF_ERROR(s);
 
-  TF_RETURN_IF_ERROR(DeserializeRpcResponseToCacheEntry(
-      local_proto_key, &response, cache_entry));
-  cache_.emplace(local_proto_key, (*cache_entry));
-  cache_size_ += (*cache_entry)->size;
+  if (!persistent_cache_path.empty()) {
+    // Write to a temporary file first, so that a concurrent reader or a crash
+    // never leaves a partial program behind.
+    const std::string tmp_path =
+        absl::StrCat(persistent_cache_path, ".tmp.", random::New64());
+    s = WriteBinaryProto(env, tmp_path, response);
+    if (s.ok()) {
+      s = env->RenameFile(tmp_path, persistent_cache_path);
+    }
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to write TPU program " << local_proto_key
+                   << " to " << persistent_cache_path << ": " << s;
+      env->DeleteFile(tmp_path).IgnoreError();
+    }
+  }
+
+  return DeserializeRpcResponseToCacheEntry(local_proto_key, &response,
+                                            cache_entry);
+}
 
-  return absl::OkStatus();
+std::string TpuCompilationCacheRpcLookup::PersistentCachePath(
+    const std::string& local_proto_key) const {
+  if (persistent_cache_dir_.empty()) {
+    return "";
+  }
+  return io::JoinPath(
+      persistent_cache_dir_,
+      absl::StrCat(absl::Hex(Fingerprint64(local_proto_key), absl::kZeroPad16),
+                   ".tpu_program"));
 }
 
 void TpuCompilationCacheRpcLookup::PostLookupLocked(
@@ -22,6 +22,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/tpu/kernels/tpu_compilation_cache_common.pb.h"
 #include "tensorflow/core/tpu/kernels/tpu_compilation_cache_grpc.h"
 #include "tensorflow/core/tpu/kernels/tpu_compilation_cache_interface.h"
@@ -33,12 +34,17 @@ namespace tensorflow {
 namespace tpu {
 
 // Class for looking up and caching TPU program via RPC.
+//
+// If `persistent_cache_dir` is not empty, programs looked up by proto key are
+// also stored in that directory, so that a restarted process can load them
+// from local disk instead of fetching them from the central cache again.
 class TpuCompilationCacheRpcLookup : public TpuCompilationCacheLookup {
  public:
   using StubType = tpu::grpc::TpuCompilationCacheService::Stub;
 
   TpuCompilationCacheRpcLookup(const string& server_address,
-                               int64_t max_cache_size);
+                               int64_t max_cache_size,
+                               const string& persistent_cache_dir = "");
   ~TpuCompilationCacheRpcLookup() override = default;
 
   Status Lookup(const string& proto_key,
@@ -49,14 +55,35 @@ class TpuCompilationCacheRpcLookup : public TpuCompilationCacheLookup {
                 std::unique_ptr<tpu::CompilationCacheEntryRef>* entry,
                 tpu::CompilationCacheFetchTarget fetch_target) override;
 
+  // Looks up the programs for `proto_keys` in parallel, so that their
+  // subsequent lookups, e.g. after a model is loaded, hit the local cache
+  // unless they have been evicted in the meantime.
+  Status Prefetch(absl::Span<const string> proto_keys,
+                  tpu::CompilationCacheFetchTarget fetch_target);
+
   string DebugString() const override;
 
  private:
-  // Helper method to make the RPC request to the central cache.
-  Status RemoteLookupLocked(const string& local_proto_key,
-                            const tpu::GetTpuProgramRequest& request,
-                            std::shared_ptr<CacheEntry>* cache_entry)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Looks up `local_proto_key` in the local cache, and otherwise fetches it
+  // with `request`. Programs are fetched outside the lock, so that lookups of
+  // other programs proceed concurrently. `persistent_cache_path` is the file
+  // that backs the entry on disk, or empty.
+  Status LookupOrFetch(const string& local_proto_key,
+                       const tpu::GetTpuProgramRequest& request,
+                       const string& persistent_cache_path,
+                       std::unique_ptr<tpu::CompilationCacheEntryRef>* entry)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Helper method to make the RPC request to the central cache, or to read the
+  // response from `persistent_cache_path` if it exists.
+  Status RemoteLookup(const string& local_proto_key,
+                      const tpu::GetTpuProgramRequest& request,
+                      const string& persistent_cache_path,
+                      std::shared_ptr<CacheEntry>* cache_entry);
+
+  // Returns the file in `persistent_cache_dir_` that stores the program for
+  // `local_proto_key`, or an empty string if there is no persistent cache.
+  string PersistentCachePath(const string& local_proto_key) const;
 
   // Helper method to adjust datastructures after a cache lookup.
   // We use `removed_entries` so that actual CacheEntry destruction happens
@@ -71,6 +98,9 @@ class TpuCompilationCacheRpcLookup : public TpuCompilationCacheLookup {
   // evicted.
   const int64_t max_cache_size_;
 
+  // The directory storing the programs fetched by proto key, or empty.
+  const string persistent_cache_dir_;
+
   std::unique_ptr<StubType> stub_;
 
   // Protect concurrent access to member variables below.
@@ -54,6 +54,7 @@ limitations under the License.
 #include "tensorflow/core/tpu/tpu_configuration.h"
 #include "tensorflow/core/tpu/tpu_defs.h"  // IWYU pragma: keep
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/logging.h"  // IWYU pragma: keep
 #include "tsl/platform/tstring.h"
@@ -394,8 +395,14 @@ void InitializeHostForDistributedTpuOp::Compute(OpKernelContext* ctx) {
 
     std::string server_address(server_address_output,
                                server_address_output_size);
+    // Programs fetched from the master are kept on local disk across restarts
+    // if TF_TPU_PROGRAM_CACHE_DIR is set.
+    std::string persistent_cache_dir;
+    OP_REQUIRES_OK(ctx, ReadStringFromEnvVar("TF_TPU_PROGRAM_CACHE_DIR", "",
+                                             &persistent_cache_dir));
     tpu::TpuCompilationCacheLookup* proto_lookup =
-        new tpu::TpuCompilationCacheRpcLookup(server_address, cache_size_bytes);
+        new tpu::TpuCompilationCacheRpcLookup(server_address, cache_size_bytes,
+                                              persistent_cache_dir);
     OP_REQUIRES_OK(
         ctx, rmgr->Create(rmgr->default_container(),
                           tpu::kCompiledProtoCacheResourceName, proto_lookup));
@@ -15,17 +15,20 @@ limitations under the License.
 
 #include "tensorflow/core/util/debug_events_writer.h"
 
-#include <deque>
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/str_split.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/host_info.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace tfdbg {
@@ -36,8 +39,147 @@ void MaybeSetDebugEventTimestamp(DebugEvent* debug_event, Env* env) {
     debug_event->set_wall_time(env->NowMicros() / 1e6);
   }
 }
+
+// Returns true if any of the elements [begin, end) of `t` is not finite or,
+// if `nonzero` is true, is not zero.
+template <typename T>
+bool AnyElementIsSet(const Tensor& t, int64_t begin, int64_t end,
+                     bool nonzero) {
+  auto flat = t.flat<T>();
+  end = std::min<int64_t>(end, flat.size());
+  for (int64_t i = begin; i < end; ++i) {
+    const double value = static_cast<double>(flat(i));
+    if (!std::isfinite(value) || (nonzero && value != 0.0)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool AnyElementIsSet(const Tensor& t, int64_t begin, int64_t end,
+                     bool nonzero) {
+  switch (t.dtype()) {
+    case DT_HALF:
+      return AnyElementIsSet<Eigen::half>(t, begin, end, nonzero);
+    case DT_BFLOAT16:
+      return AnyElementIsSet<bfloat16>(t, begin, end, nonzero);
+    case DT_FLOAT:
+      return AnyElementIsSet<float>(t, begin, end, nonzero);
+    case DT_DOUBLE:
+      return AnyElementIsSet<double>(t, begin, end, nonzero);
+    default:
+      return false;
+  }
+}
 }  // namespace
 
+CircularDebugEventBuffer::CircularDebugEventBuffer(int64_t capacity)
+    : capacity_(capacity),
+      slots_(new Slot[capacity]),
+      next_sequence_number_(0) {}
+
+void CircularDebugEventBuffer::Push(string debug_event_str) {
+  const int64_t sequence_number =
+      next_sequence_number_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[sequence_number % capacity_];
+  mutex_lock l(slot.mu);
+  // A slower writer may arrive after the slot was reused by a later event.
+  if (slot.sequence_number < sequence_number) {
+    slot.sequence_number = sequence_number;
+    slot.debug_event_str = std::move(debug_event_str);
+  }
+}
+
+void CircularDebugEventBuffer::Drain(
+    const std::function<void(const string&)>& fn) {
+  std::vector<std::pair<int64_t, string>> events;
+  for (int64_t i = 0; i < capacity_; ++i) {
+    Slot& slot = slots_[i];
+    mutex_lock l(slot.mu);
+    if (slot.sequence_number >= 0) {
+      events.emplace_back(slot.sequence_number,
+                          std::move(slot.debug_event_str));
+      slot.sequence_number = -1;
+      slot.debug_event_str.clear();
+    }
+  }
+  std::sort(events.begin(), events.end(),
+            [](const std::pair<int64_t, string>& a,
+               const std::pair<int64_t, string>& b) {
+              return a.first < b.first;
+            });
+  for (const auto& event : events) {
+    fn(event.second);
+  }
+}
+
+// static
+Status GraphExecutionTraceSampler::OptionsFromEnv(Options* options) {
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar(
+      "TFDBG_TRACE_EVERY_N", /*default_val=*/1, &options->every_n));
+  string op_name_patterns;
+  TF_RETURN_IF_ERROR(ReadStringFromEnvVar(
+      "TFDBG_TRACE_OP_NAME_PATTERNS", /*default_val=*/"", &op_name_patterns));
+  options->op_name_patterns =
+      absl::StrSplit(op_name_patterns, ',', absl::SkipWhitespace());
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TFDBG_TRACE_ANOMALIES",
+                                        /*default_val=*/true,
+                                        &options->always_write_anomalies));
+  return absl::OkStatus();
+}
+
+// static
+bool GraphExecutionTraceSampler::HasInfOrNan(int32_t tensor_debug_mode,
+                                             const Tensor& tensor_value) {
+  switch (tensor_debug_mode) {
+    case CURT_HEALTH:
+      // [tensor_id, any_inf_or_nan].
+      return AnyElementIsSet(tensor_value, 1, 2, /*nonzero=*/true);
+    case CONCISE_HEALTH:
+      // [tensor_id, size, neg_inf_count, pos_inf_count, nan_count].
+      return AnyElementIsSet(tensor_value, 2, 5, /*nonzero=*/true);
+    case FULL_HEALTH:
+      // [tensor_id, device_id, dtype, rank, size, neg_inf_count,
+      //  pos_inf_count, nan_count, ...].
+      return AnyElementIsSet(tensor_value, 5, 8, /*nonzero=*/true);
+    case REDUCE_INF_NAN_THREE_SLOTS:
+      return AnyElementIsSet(tensor_value, 0, 3, /*nonzero=*/false);
+    case UNSPECIFIED:
+    case FULL_TENSOR:
+      return AnyElementIsSet(tensor_value, 0, tensor_value.NumElements(),
+                             /*nonzero=*/false);
+    default:
+      return false;
+  }
+}
+
+GraphExecutionTraceSampler::GraphExecutionTraceSampler(const Options& options,
+                                                       const string& op_name)
+    : every_n_(std::max<int64_t>(1, options.every_n)),
+      always_write_anomalies_(options.always_write_anomalies),
+      op_name_matches_(options.op_name_patterns.empty()),
+      num_executions_(0) {
+  for (const string& pattern : options.op_name_patterns) {
+    if (Env::Default()->MatchPath(op_name, pattern)) {
+      op_name_matches_ = true;
+      break;
+    }
+  }
+}
+
+bool GraphExecutionTraceSampler::ShouldWrite(int32_t tensor_debug_mode,
+                                             const Tensor& tensor_value) {
+  if (op_name_matches_) {
+    if (every_n_ == 1 ||
+        num_executions_.fetch_add(1, std::memory_order_relaxed) % every_n_ ==
+            0) {
+      return true;
+    }
+  }
+  return always_write_anomalies_ &&
+         HasInfOrNan(tensor_debug_mode, tensor_value);
+}
+
 SingleDebugEventFileWriter::SingleDebugEventFileWriter(const string& file_path)
     : env_(Env::Default()),
       file_path_(file_path),
@@ -245,11 +387,7 @@ Status DebugEventsWriter::WriteExecution(Execution* execution) {
     string serialized;
     debug_event.SerializeToString(&serialized);
 
-    mutex_lock l(execution_buffer_mu_);
-    execution_buffer_.emplace_back(std::move(serialized));
-    if (execution_buffer_.size() > circular_buffer_size_) {
-      execution_buffer_.pop_front();
-    }
+    execution_buffer_->Push(std::move(serialized));
     return absl::OkStatus();
   }
 }
@@ -270,11 +408,7 @@ Status DebugEventsWriter::WriteGraphExecutionTrace(
     string serialized;
     debug_event.SerializeToString(&serialized);
 
-    mutex_lock l(graph_execution_trace_buffer_mu_);
-    graph_execution_trace_buffer_.emplace_back(std::move(serialized));
-    if (graph_execution_trace_buffer_.size() > circular_buffer_size_) {
-      graph_execution_trace_buffer_.pop_front();
-    }
+    graph_execution_trace_buffer_->Push(std::move(serialized));
     return absl::OkStatus();
   }
 }
@@ -309,18 +443,15 @@ void DebugEventsWriter::WriteSerializedNonExecutionDebugEvent(
 void DebugEventsWriter::WriteSerializedExecutionDebugEvent(
     const string& debug_event_str, DebugEventFileType type) {
   const std::unique_ptr<SingleDebugEventFileWriter>* writer = nullptr;
-  std::deque<string>* buffer = nullptr;
-  mutex* mu = nullptr;
+  CircularDebugEventBuffer* buffer = nullptr;
   switch (type) {
     case EXECUTION:
       writer = &execution_writer_;
-      buffer = &execution_buffer_;
-      mu = &execution_buffer_mu_;
+      buffer = execution_buffer_.get();
       break;
     case GRAPH_EXECUTION_TRACES:
       writer = &graph_execution_traces_writer_;
-      buffer = &graph_execution_trace_buffer_;
-      mu = &graph_execution_trace_buffer_mu_;
+      buffer = graph_execution_trace_buffer_.get();
       break;
     default:
       return;
@@ -331,11 +462,7 @@ void DebugEventsWriter::WriteSerializedExecutionDebugEvent(
     (*writer)->WriteSerializedDebugEvent(debug_event_str);
   } else {
     // Circular buffer behavior.
-    mutex_lock l(*mu);
-    buffer->push_back(debug_event_str);
-    if (buffer->size() > circular_buffer_size_) {
-      buffer->pop_front();
-    }
+    buffer->Push(debug_event_str);
   }
 }
 
@@ -376,12 +503,9 @@ Status DebugEventsWriter::FlushExecutionFiles() {
   if (execution_writer_ != nullptr) {
     if (circular_buffer_size_ > 0) {
       // Write out all the content in the circular buffers.
-      mutex_lock l(execution_buffer_mu_);
-      while (!execution_buffer_.empty()) {
-        execution_writer_->WriteSerializedDebugEvent(execution_buffer_.front());
-        // SerializeAndWriteDebugEvent(&execution_buffer_.front());
-        execution_buffer_.pop_front();
-      }
+      execution_buffer_->Drain([this](const string& debug_event_str) {
+        execution_writer_->WriteSerializedDebugEvent(debug_event_str);
+      });
     }
     TF_RETURN_IF_ERROR(execution_writer_->Flush());
   }
@@ -389,12 +513,11 @@ Status DebugEventsWriter::FlushExecutionFiles() {
   if (graph_execution_traces_writer_ != nullptr) {
     if (circular_buffer_size_ > 0) {
       // Write out all the content in the circular buffers.
-      mutex_lock l(graph_execution_trace_buffer_mu_);
-      while (!graph_execution_trace_buffer_.empty()) {
-        graph_execution_traces_writer_->WriteSerializedDebugEvent(
-            graph_execution_trace_buffer_.front());
-        graph_execution_trace_buffer_.pop_front();
-      }
+      graph_execution_trace_buffer_->Drain(
+          [this](const string& debug_event_str) {
+            graph_execution_traces_writer_->WriteSerializedDebugEvent(
+                debug_event_str);
+          });
     }
     TF_RETURN_IF_ERROR(graph_execution_traces_writer_->Flush());
   }
@@ -488,12 +611,15 @@ DebugEventsWriter::DebugEventsWriter(const string& dump_root,
       is_initialized_(false),
       initialization_mu_(),
       circular_buffer_size_(circular_buffer_size),
-      execution_buffer_(),
-      execution_buffer_mu_(),
-      graph_execution_trace_buffer_(),
-      graph_execution_trace_buffer_mu_(),
       device_name_to_id_(),
-      device_mu_() {}
+      device_mu_() {
+  if (circular_buffer_size_ > 0) {
+    execution_buffer_ =
+        std::make_unique<CircularDebugEventBuffer>(circular_buffer_size_);
+    graph_execution_trace_buffer_ =
+        std::make_unique<CircularDebugEventBuffer>(circular_buffer_size_);
+  }
+}
 
 Status DebugEventsWriter::InitNonMetadataFile(DebugEventFileType type) {
   std::unique_ptr<SingleDebugEventFileWriter>* writer = nullptr;
@@ -17,9 +17,10 @@ limitations under the License.
 #define TENSORFLOW_CORE_UTIL_DEBUG_EVENTS_WRITER_H_
 
 #include <atomic>
-#include <deque>
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/debug_event.pb.h"
 
@@ -70,6 +72,73 @@ class SingleDebugEventFileWriter {
   mutex writer_mu_;
 };
 
+// Helper class for DebugEventsWriter.
+// A circular buffer of serialized DebugEvents, which retains the most recent
+// `capacity` events. Each event goes to its own slot, chosen by an atomic
+// counter, so that concurrent writers do not contend on a common lock.
+class CircularDebugEventBuffer {
+ public:
+  explicit CircularDebugEventBuffer(int64_t capacity);
+
+  void Push(string debug_event_str);
+
+  // Calls `fn` on the retained events in the order they were pushed and
+  // clears the buffer.
+  void Drain(const std::function<void(const string&)>& fn);
+
+ private:
+  struct Slot {
+    mutex mu;
+    // Position of the event in the sequence of pushed events, or -1 if the
+    // slot is empty.
+    int64_t sequence_number TF_GUARDED_BY(mu) = -1;
+    string debug_event_str TF_GUARDED_BY(mu);
+  };
+
+  const int64_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<int64_t> next_sequence_number_;
+};
+
+// Decides which graph execution traces are written by the DebugIdentityV2 op.
+// Sampling the traces makes it possible to dump the tensors of large models
+// at a fraction of the cost of dumping all tensors at every step.
+class GraphExecutionTraceSampler {
+ public:
+  struct Options {
+    // Writes one of every `every_n` executions of each traced tensor.
+    int64_t every_n = 1;
+    // If non-empty, only the ops whose name matches one of these glob
+    // patterns are traced.
+    std::vector<string> op_name_patterns;
+    // Writes the traces reporting an infinity or a NaN even if they are not
+    // sampled otherwise.
+    bool always_write_anomalies = true;
+  };
+
+  // Reads the options from the TFDBG_TRACE_EVERY_N,
+  // TFDBG_TRACE_OP_NAME_PATTERNS (comma-separated) and TFDBG_TRACE_ANOMALIES
+  // environment variables.
+  static Status OptionsFromEnv(Options* options);
+
+  // Returns true if `tensor_value`, as computed for `tensor_debug_mode`,
+  // reports an infinity or a NaN.
+  static bool HasInfOrNan(int32_t tensor_debug_mode,
+                          const Tensor& tensor_value);
+
+  GraphExecutionTraceSampler(const Options& options, const string& op_name);
+
+  // Returns true if the trace of the current execution of the op should be
+  // written. Thread-safe.
+  bool ShouldWrite(int32_t tensor_debug_mode, const Tensor& tensor_value);
+
+ private:
+  const int64_t every_n_;
+  const bool always_write_anomalies_;
+  bool op_name_matches_;
+  std::atomic<int64_t> num_executions_;
+};
+
 // The DebugEvents writer class.
 class DebugEventsWriter {
  public:
@@ -185,6 +254,8 @@ class DebugEventsWriter {
   // concerned with the execution-related events: the EXECUTION and
   // GRAPH_EXECUTION_TRACES files. This involves the cyclic-buffer behavior if
   // circular_buffer_size is configured to be >0.
+  // Thread-safe: concurrent writers to the circular buffer do not block each
+  // other.
   // NOTE: Actually used in the Python binding, to avoid overhead of
   // serializing and parsing protos at the language interface.
   void WriteSerializedExecutionDebugEvent(const string& debug_event_str,
@@ -247,11 +318,9 @@ class DebugEventsWriter {
   mutex initialization_mu_;
 
   const int64_t circular_buffer_size_;
-  std::deque<string> execution_buffer_ TF_GUARDED_BY(execution_buffer_mu_);
-  mutex execution_buffer_mu_;
-  std::deque<string> graph_execution_trace_buffer_
-      TF_GUARDED_BY(graph_execution_trace_buffer_mu_);
-  mutex graph_execution_trace_buffer_mu_;
+  // Only created if `circular_buffer_size_` is positive.
+  std::unique_ptr<CircularDebugEventBuffer> execution_buffer_;
+  std::unique_ptr<CircularDebugEventBuffer> graph_execution_trace_buffer_;
 
   absl::flat_hash_map<string, int> device_name_to_id_ TF_GUARDED_BY(device_mu_);
   mutex device_mu_;
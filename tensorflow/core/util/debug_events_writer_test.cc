@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <limits>
 #include <memory>
 #include <vector>
 
@@ -26,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -886,5 +888,106 @@ TEST_F(DebugEventsWriterTest, DisableCyclicBufferBehavior) {
   TF_ASSERT_OK(writer->Close());
 }
 
+TEST(CircularDebugEventBufferTest, DrainKeepsMostRecentEventsInOrder) {
+  CircularDebugEventBuffer buffer(4);
+  for (int i = 0; i < 10; ++i) {
+    buffer.Push(strings::StrCat(i));
+  }
+  std::vector<string> drained;
+  auto append = [&drained](const string& s) { drained.push_back(s); };
+  buffer.Drain(append);
+  EXPECT_EQ(drained, std::vector<string>({"6", "7", "8", "9"}));
+
+  drained.clear();
+  buffer.Drain(append);
+  EXPECT_TRUE(drained.empty());
+
+  buffer.Push("10");
+  buffer.Drain(append);
+  EXPECT_EQ(drained, std::vector<string>({"10"}));
+}
+
+TEST(CircularDebugEventBufferTest, ConcurrentPushes) {
+  const int kCapacity = 16;
+  CircularDebugEventBuffer buffer(kCapacity);
+  {
+    thread::ThreadPool thread_pool(Env::Default(), "test_pool", 8);
+    for (int i = 0; i < 1000; ++i) {
+      thread_pool.Schedule([&buffer, i]() { buffer.Push(strings::StrCat(i)); });
+    }
+  }
+  std::vector<string> drained;
+  buffer.Drain([&drained](const string& s) { drained.push_back(s); });
+  EXPECT_EQ(drained.size(), kCapacity);
+}
+
+TEST(GraphExecutionTraceSamplerTest, EveryN) {
+  GraphExecutionTraceSampler::Options options;
+  options.every_n = 3;
+  GraphExecutionTraceSampler sampler(options, "dense/MatMul");
+  Tensor t(DT_FLOAT, TensorShape({2}));
+  t.flat<float>().setZero();
+  std::vector<bool> written;
+  for (int i = 0; i < 7; ++i) {
+    written.push_back(sampler.ShouldWrite(FULL_TENSOR, t));
+  }
+  EXPECT_EQ(written, std::vector<bool>(
+                         {true, false, false, true, false, false, true}));
+}
+
+TEST(GraphExecutionTraceSamplerTest, OpNamePatterns) {
+  GraphExecutionTraceSampler::Options options;
+  options.op_name_patterns = {"dense_1/*", "*/Relu"};
+  Tensor t(DT_FLOAT, TensorShape({2}));
+  t.flat<float>().setZero();
+  EXPECT_TRUE(GraphExecutionTraceSampler(options, "dense_1/MatMul")
+                  .ShouldWrite(FULL_TENSOR, t));
+  EXPECT_TRUE(GraphExecutionTraceSampler(options, "dense_2/Relu")
+                  .ShouldWrite(FULL_TENSOR, t));
+  EXPECT_FALSE(GraphExecutionTraceSampler(options, "dense_2/MatMul")
+                   .ShouldWrite(FULL_TENSOR, t));
+}
+
+TEST(GraphExecutionTraceSamplerTest, AlwaysWritesAnomalies) {
+  GraphExecutionTraceSampler::Options options;
+  options.op_name_patterns = {"unmatched"};
+  GraphExecutionTraceSampler sampler(options, "dense/MatMul");
+  Tensor finite(DT_FLOAT, TensorShape({2}));
+  finite.flat<float>().setZero();
+  Tensor with_nan(DT_FLOAT, TensorShape({2}));
+  with_nan.flat<float>().setConstant(std::numeric_limits<float>::quiet_NaN());
+  EXPECT_FALSE(sampler.ShouldWrite(FULL_TENSOR, finite));
+  EXPECT_TRUE(sampler.ShouldWrite(FULL_TENSOR, with_nan));
+
+  options.always_write_anomalies = false;
+  GraphExecutionTraceSampler no_anomalies(options, "dense/MatMul");
+  EXPECT_FALSE(no_anomalies.ShouldWrite(FULL_TENSOR, with_nan));
+}
+
+TEST(GraphExecutionTraceSamplerTest, HasInfOrNanInSummaries) {
+  // CURT_HEALTH: [tensor_id, any_inf_or_nan].
+  Tensor curt_health(DT_FLOAT, TensorShape({2}));
+  curt_health.flat<float>()(0) = 7;
+  curt_health.flat<float>()(1) = 0;
+  EXPECT_FALSE(
+      GraphExecutionTraceSampler::HasInfOrNan(CURT_HEALTH, curt_health));
+  curt_health.flat<float>()(1) = 1;
+  EXPECT_TRUE(GraphExecutionTraceSampler::HasInfOrNan(CURT_HEALTH, curt_health));
+
+  // CONCISE_HEALTH: [tensor_id, size, neg_inf, pos_inf, nan].
+  Tensor concise_health(DT_DOUBLE, TensorShape({5}));
+  concise_health.flat<double>().setValues({7, 100, 0, 0, 0});
+  EXPECT_FALSE(GraphExecutionTraceSampler::HasInfOrNan(CONCISE_HEALTH,
+                                                       concise_health));
+  concise_health.flat<double>()(4) = 2;
+  EXPECT_TRUE(GraphExecutionTraceSampler::HasInfOrNan(CONCISE_HEALTH,
+                                                      concise_health));
+
+  // SHAPE summaries carry no information about the values.
+  Tensor shape(DT_DOUBLE, TensorShape({10}));
+  shape.flat<double>().setConstant(std::numeric_limits<double>::infinity());
+  EXPECT_FALSE(GraphExecutionTraceSampler::HasInfOrNan(SHAPE, shape));
+}
+
 }  // namespace tfdbg
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 #include <optional>
 #include <utility>
@@ -115,6 +116,63 @@ uint8 PeekTag(protobuf::io::CodedInputStream* stream) {
   return *static_cast<const uint8*>(ptr);
 }
 
+// Returns in `data` and `size` the bytes between the position of `stream` and
+// its current limit, without consuming them. Returns false if the bytes are
+// not all available or end inside a varint.
+bool PeekPackedVarints(protobuf::io::CodedInputStream* stream,
+                       const uint8** data, int* size) {
+  *size = stream->BytesUntilLimit();
+  if (*size <= 0) return *size == 0;
+  const void* ptr;
+  int available;
+  if (!stream->GetDirectBufferPointer(&ptr, &available) || available < *size) {
+    return false;
+  }
+  *data = static_cast<const uint8*>(ptr);
+  return ((*data)[*size - 1] & 0x80) == 0;
+}
+
+// Decodes `size` bytes of packed varints, storing the first `capacity` values
+// in `out`. Returns the number of varints, or -1 if one is longer than 10
+// bytes.
+//
+// REQUIRES: the last byte ends a varint, as checked by PeekPackedVarints().
+//
+// Most values of int64 features are small ids, counts or timestamp deltas, so
+// eight one-byte varints are detected and decoded at a time.
+int64_t DecodePackedVarints(const uint8* data, int size, int64_t* out,
+                            size_t capacity) {
+  constexpr uint64 kContinuationBits = 0x8080808080808080ULL;
+  const uint8* p = data;
+  const uint8* const end = data + size;
+  size_t n = 0;
+  while (p < end) {
+    if (port::kLittleEndian && end - p >= 8 && n + 8 <= capacity) {
+      uint64 word;
+      std::memcpy(&word, p, sizeof(word));
+      if ((word & kContinuationBits) == 0) {
+        for (int i = 0; i < 8; ++i) out[n + i] = (word >> (8 * i)) & 0xff;
+        p += 8;
+        n += 8;
+        continue;
+      }
+    }
+    uint64 value = *p++;
+    if (value >= 0x80) {
+      value &= 0x7f;
+      for (int shift = 7;; shift += 7) {
+        if (shift >= 70) return -1;
+        const uint8 byte = *p++;
+        value |= static_cast<uint64>(byte & 0x7f) << shift;
+        if (byte < 0x80) break;
+      }
+    }
+    if (n < capacity) out[n] = static_cast<int64_t>(value);
+    ++n;
+  }
+  return n;
+}
+
 constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
@@ -307,11 +365,22 @@ class Feature {
         if (!stream.ReadVarint32(&packed_length)) return false;
         auto packed_limit = stream.PushLimit(packed_length);
 
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64_t>(n));
+        const uint8* packed = nullptr;
+        int packed_size;
+        if (!PeekPackedVarints(&stream, &packed, &packed_size)) return false;
+        if (packed_size > 0) {
+          // There are at most as many values as bytes. As for floats, a
+          // LimitedArraySlice may hold fewer elements than requested, and then
+          // only its first elements are written.
+          const size_t initial_size = int64_list->size();
+          int64_list->resize(initial_size + packed_size);
+          const int64_t num_elements = DecodePackedVarints(
+              packed, packed_size, int64_list->data() + initial_size,
+              int64_list->size() - initial_size);
+          if (num_elements < 0) return false;
+          int64_list->resize(initial_size + num_elements);
         }
+        if (!stream.Skip(packed_size)) return false;
 
         stream.PopLimit(packed_limit);
       } else {  // non-packed
@@ -589,6 +658,30 @@ void LogSparseFeatureDataLoss(StringPiece feature_name) {
   duplicated_sparse_feature->GetCell()->IncrementBy(1);
 }
 
+// State of FastParseSerializedExample() that is reused by the examples of a
+// minibatch, so that parsing an example does not allocate.
+struct FastParseScratch {
+  explicit FastParseScratch(const Config& config)
+      : sparse_feature_last_example(config.sparse.size(), -1),
+        dense_feature_last_example(config.dense.size(), -1),
+        ragged_feature_last_example(config.ragged.size(), -1) {}
+
+  parsed::Example parsed_example;
+
+  // Index of the last example in which each configured feature was seen.
+  std::vector<int64_t> sparse_feature_last_example;
+  std::vector<int64_t> dense_feature_last_example;
+  std::vector<int64_t> ragged_feature_last_example;
+
+  // The name of the feature at each position of the previous example, and its
+  // config entry, or nullopt if it is not configured. Examples written by the
+  // same producer usually list their features in the same order, so most
+  // features are dispatched by comparing their name with the one at the same
+  // position, without hashing it.
+  std::vector<std::pair<StringPiece, std::optional<std::pair<size_t, Type>>>>
+      dispatch;
+};
+
 Status FastParseSerializedExample(
     const tstring& serialized_example, const tstring& example_name,
     const size_t example_index, const Config& config,
@@ -597,18 +690,27 @@ Status FastParseSerializedExample(
     std::vector<SparseBuffer>* output_varlen_dense,
     std::vector<SparseBuffer>* output_sparse,
     std::vector<SparseBuffer>* output_ragged,
-    PerExampleFeatureStats* output_stats) {
+    PerExampleFeatureStats* output_stats, FastParseScratch* scratch) {
   DCHECK(output_dense != nullptr);
   DCHECK(output_sparse != nullptr);
   DCHECK(output_ragged != nullptr);
-  parsed::Example parsed_example;
+  parsed::Example& parsed_example = scratch->parsed_example;
+  parsed_example.clear();
   if (!ParseExample(serialized_example, &parsed_example)) {
     return errors::InvalidArgument("Could not parse example input, value: '",
                                    serialized_example, "'");
   }
-  std::vector<int64_t> sparse_feature_last_example(config.sparse.size(), -1);
-  std::vector<int64_t> dense_feature_last_example(config.dense.size(), -1);
-  std::vector<int64_t> ragged_feature_last_example(config.ragged.size(), -1);
+  // These are only compared with `example_index`, so they need no reset
+  // between the examples of a minibatch.
+  std::vector<int64_t>& sparse_feature_last_example =
+      scratch->sparse_feature_last_example;
+  std::vector<int64_t>& dense_feature_last_example =
+      scratch->dense_feature_last_example;
+  std::vector<int64_t>& ragged_feature_last_example =
+      scratch->ragged_feature_last_example;
+  if (scratch->dispatch.size() < parsed_example.size()) {
+    scratch->dispatch.resize(parsed_example.size());
+  }
 
   // Handle features present in the example.
   const size_t parsed_example_size = parsed_example.size();
@@ -629,23 +731,30 @@ Status FastParseSerializedExample(
     const StringPiece feature_name = name_and_feature.first;
     parsed::Feature& feature = name_and_feature.second;
 
-    std::pair<size_t, Type> d_and_type;
-    uint64 h = hasher(feature_name);
-    if (!config_index.Find(h, &d_and_type)) continue;
-
-    size_t d = d_and_type.first;
-    bool is_dense = d_and_type.second == Type::Dense;
-    bool is_ragged = d_and_type.second == Type::Ragged;
-
-    {
-      // Testing for PresizedCuckooMap collision.
-      // TODO(lew): Use dense_hash_map and avoid this and hasher creation.
-      const tstring& config_feature_name =
-          is_dense ? config.dense[d].feature_name
-                   : (is_ragged ? config.ragged[d].feature_name
-                                : config.sparse[d].feature_name);
-      if (feature_name != config_feature_name) continue;
-    }
+    auto& cached = scratch->dispatch[i];
+    if (cached.first.data() == nullptr || cached.first != feature_name) {
+      cached.first = feature_name;
+      cached.second.reset();
+      std::pair<size_t, Type> d_and_type;
+      uint64 h = hasher(feature_name);
+      if (config_index.Find(h, &d_and_type)) {
+        // Testing for PresizedCuckooMap collision.
+        // TODO(lew): Use dense_hash_map and avoid this and hasher creation.
+        const size_t d = d_and_type.first;
+        const tstring& config_feature_name =
+            d_and_type.second == Type::Dense
+                ? config.dense[d].feature_name
+                : (d_and_type.second == Type::Ragged
+                       ? config.ragged[d].feature_name
+                       : config.sparse[d].feature_name);
+        if (feature_name == config_feature_name) cached.second = d_and_type;
+      }
+    }
+    if (!cached.second.has_value()) continue;
+
+    size_t d = cached.second->first;
+    bool is_dense = cached.second->second == Type::Dense;
+    bool is_ragged = cached.second->second == Type::Ragged;
 
     auto example_error = [&](StringPiece suffix) {
       return errors::InvalidArgument("Name: ", example_name,
@@ -1235,6 +1344,7 @@ Status FastParseExample(const Config& config,
     sparse_buffers[minibatch].resize(config.sparse.size());
     varlen_dense_buffers[minibatch].resize(config.dense.size());
     ragged_buffers[minibatch].resize(config.ragged.size());
+    FastParseScratch scratch(config);
     size_t start = first_example_of_minibatch(minibatch);
     size_t end = first_example_of_minibatch(minibatch + 1);
     for (size_t e = start; e < end; ++e) {
@@ -1247,7 +1357,7 @@ Status FastParseExample(const Config& config,
           (!example_names.empty() ? example_names[e] : "<unknown>"), e, config,
           config_index, hasher, &fixed_dense_values,
           &varlen_dense_buffers[minibatch], &sparse_buffers[minibatch],
-          &ragged_buffers[minibatch], stats);
+          &ragged_buffers[minibatch], stats, &scratch);
       if (!status_of_minibatch[minibatch].ok()) break;
     }
   };
@@ -1981,16 +2091,17 @@ inline int ParseInt64Feature(protobuf::io::CodedInputStream* stream,
         return -1;
       }
       auto packed_limit = stream->PushLimit(packed_length);
-      while (!stream->ExpectAtEnd()) {
-        protobuf_uint64 n;  // There is no API for int64
-        if (!stream->ReadVarint64(&n)) {
-          return -1;
-        }
-        if (out != nullptr) {
-          *out++ = n;
-        }
-        num_elements++;
-      }
+      const uint8* packed = nullptr;
+      int packed_size;
+      if (!PeekPackedVarints(stream, &packed, &packed_size)) return -1;
+      // The caller sized `out` from a first call that only counts, so all the
+      // values fit.
+      const int64_t count = DecodePackedVarints(
+          packed, packed_size, out, out != nullptr ? packed_size : 0);
+      if (count < 0) return -1;
+      if (out != nullptr) out += count;
+      num_elements += count;
+      if (!stream->Skip(packed_size)) return -1;
       stream->PopLimit(packed_limit);
     } else if (peek_tag == kVarintTag(1)) {
       while (!stream->ExpectAtEnd()) {
@@ -15,14 +15,21 @@ limitations under the License.
 
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -255,6 +262,32 @@ static string ExampleWithSomeFeatures() {
 
 TEST(FastParse, SomeFeatures) { TestCorrectness(ExampleWithSomeFeatures()); }
 
+TEST(FastParse, PackedInt64OfAllWidths) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["int64_list"]
+          .mutable_int64_list();
+  // Runs of one-byte varints are decoded eight at a time; the other values
+  // interrupt them at varying offsets.
+  for (int64_t i = 0; i < 20; ++i) int64_list->add_value(i);
+  for (int64_t value :
+       {int64_t{127}, int64_t{128}, int64_t{300}, int64_t{-1},
+        int64_t{1} << 35, std::numeric_limits<int64_t>::max(),
+        std::numeric_limits<int64_t>::min()}) {
+    int64_list->add_value(value);
+    for (int64_t i = 0; i < 9; ++i) int64_list->add_value(i);
+  }
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, TruncatedPackedInt64) {
+  Example example;
+  // The packed list of "age" ends inside a varint.
+  EXPECT_FALSE(TestFastParse(
+      "\x0a\x0e\x0a\x0c\x0a\x03\x61\x67\x65\x12\x05\x1a\x03\x0a\x01\x80",
+      &example));
+}
+
 static void AddDenseFeature(const char* feature_name, DataType dtype,
                             PartialTensorShape shape, bool variable_length,
                             size_t elements_per_stride,
@@ -419,6 +452,66 @@ TEST(FastParse, FuzzTest) {
   }
 }
 
+// Returns an Example with the given int64 and float features, serialized in
+// the given order.
+string SerializeInOrder(
+    const std::vector<std::pair<string, std::vector<int64_t>>>& int64s,
+    const std::vector<std::pair<string, std::vector<float>>>& floats,
+    bool int64s_first) {
+  string int64_part, float_part;
+  for (const auto& [name, values] : int64s) {
+    Example example;
+    Int64List* list = (*example.mutable_features()->mutable_feature())[name]
+                          .mutable_int64_list();
+    for (int64_t value : values) list->add_value(value);
+    int64_part += Serialize(example);
+  }
+  for (const auto& [name, values] : floats) {
+    Example example;
+    FloatList* list = (*example.mutable_features()->mutable_feature())[name]
+                          .mutable_float_list();
+    for (float value : values) list->add_value(value);
+    float_part += Serialize(example);
+  }
+  // Concatenated Examples are parsed as one Example.
+  return int64s_first ? int64_part + float_part : float_part + int64_part;
+}
+
+TEST(TestFastParseExample, FeaturesInVaryingOrder) {
+  std::vector<tstring> serialized = {
+      SerializeInOrder({{"ids", {1, 2}}, {"unknown", {7}}}, {{"score", {0.5}}},
+                       /*int64s_first=*/true),
+      SerializeInOrder({{"ids", {3}}}, {{"score", {1.5}}, {"other", {2}}},
+                       /*int64s_first=*/false),
+      SerializeInOrder({{"unknown", {8}}, {"ids", {300, int64_t{1} << 40}}},
+                       {}, /*int64s_first=*/true),
+  };
+  FastParseExampleConfig config;
+  config.sparse.push_back({"ids", DT_INT64});
+  config.dense.push_back({"score", DT_FLOAT, PartialTensorShape({1}),
+                          test::AsTensor<float>({-1}), false, 1});
+  Result result;
+  TF_ASSERT_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+  test::ExpectTensorEqual<int64_t>(
+      result.sparse_values[0],
+      test::AsTensor<int64_t>({1, 2, 3, 300, int64_t{1} << 40}));
+  test::ExpectTensorEqual<int64_t>(
+      result.sparse_indices[0],
+      test::AsTensor<int64_t>({0, 0, 0, 1, 1, 0, 2, 0, 2, 1}, {5, 2}));
+  test::ExpectTensorEqual<float>(result.dense_values[0],
+                                 test::AsTensor<float>({0.5, 1.5, -1}, {3, 1}));
+}
+
+TEST(TestFastParseExample, TooManyDenseInt64Values) {
+  std::vector<tstring> serialized = {
+      SerializeInOrder({{"ids", {1, 2, 3}}}, {}, /*int64s_first=*/true)};
+  FastParseExampleConfig config;
+  config.dense.push_back({"ids", DT_INT64, PartialTensorShape({2}),
+                          test::AsTensor<int64_t>({0, 0}), false, 2});
+  Result result;
+  EXPECT_FALSE(FastParseExample(config, serialized, {}, nullptr, &result).ok());
+}
+
 TEST(TestFastParseExample, Empty) {
   Result result;
   FastParseExampleConfig config;
@@ -429,6 +522,104 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+// Builds a batch of examples resembling a ranking model's input: sparse id
+// lists of varying length and magnitude, a timestamp, dense float features and
+// an embedding, a few strings, and features the model does not read.
+std::vector<tstring> MixedFeatureExamples(int batch_size,
+                                          FastParseExampleConfig* config) {
+  constexpr int kNumIdFeatures = 8;
+  constexpr int kNumFloatFeatures = 10;
+  constexpr int kNumStringFeatures = 3;
+  constexpr int kNumUnusedFeatures = 5;
+  constexpr int kEmbeddingSize = 32;
+  for (int i = 0; i < kNumIdFeatures; ++i) {
+    config->sparse.push_back({strings::StrCat("ids_", i), DT_INT64});
+  }
+  for (int i = 0; i < kNumStringFeatures; ++i) {
+    config->sparse.push_back({strings::StrCat("string_", i), DT_STRING});
+  }
+  config->dense.push_back({"timestamp", DT_INT64, PartialTensorShape({1}),
+                           test::AsTensor<int64_t>({0}), false, 1});
+  for (int i = 0; i < kNumFloatFeatures; ++i) {
+    config->dense.push_back({strings::StrCat("float_", i), DT_FLOAT,
+                             PartialTensorShape({1}),
+                             test::AsTensor<float>({0}), false, 1});
+  }
+  Tensor embedding_default(DT_FLOAT, TensorShape({kEmbeddingSize}));
+  embedding_default.flat<float>().setZero();
+  config->dense.push_back({"embedding", DT_FLOAT,
+                           PartialTensorShape({kEmbeddingSize}),
+                           embedding_default, false, kEmbeddingSize});
+
+  random::PhiloxRandom philox(42);
+  random::SimplePhilox rng(&philox);
+  std::vector<tstring> serialized(batch_size);
+  for (int e = 0; e < batch_size; ++e) {
+    Example example;
+    auto& features = *example.mutable_features()->mutable_feature();
+    for (int i = 0; i < kNumIdFeatures; ++i) {
+      Int64List* ids =
+          features[strings::StrCat("ids_", i)].mutable_int64_list();
+      // Half of the id features hold small vocabulary ids, the others hashed
+      // ids of up to 40 bits.
+      const int num_ids = 1 + rng.Uniform(20);
+      for (int j = 0; j < num_ids; ++j) {
+        ids->add_value(i % 2 == 0 ? rng.Uniform(100)
+                                  : rng.Uniform64(int64_t{1} << 40));
+      }
+    }
+    features["timestamp"].mutable_int64_list()->add_value(1700000000000 + e);
+    for (int i = 0; i < kNumFloatFeatures; ++i) {
+      features[strings::StrCat("float_", i)].mutable_float_list()->add_value(
+          rng.RandFloat());
+    }
+    FloatList* embedding = features["embedding"].mutable_float_list();
+    for (int i = 0; i < kEmbeddingSize; ++i) {
+      embedding->add_value(rng.RandFloat());
+    }
+    for (int i = 0; i < kNumStringFeatures; ++i) {
+      features[strings::StrCat("string_", i)].mutable_bytes_list()->add_value(
+          strings::StrCat("value_", rng.Uniform(1000)));
+    }
+    for (int i = 0; i < kNumUnusedFeatures; ++i) {
+      features[strings::StrCat("unused_", i)].mutable_int64_list()->add_value(
+          rng.Uniform(1000));
+    }
+    serialized[e] = Serialize(example);
+  }
+  return serialized;
+}
+
+// Parses `state.range(0)` mixed examples with `state.range(1)` threads, or on
+// the calling thread if it is 0.
+void BM_FastParseMixedFeatures(::testing::benchmark::State& state) {
+  const int batch_size = state.range(0);
+  const int num_threads = state.range(1);
+  FastParseExampleConfig config;
+  const std::vector<tstring> serialized =
+      MixedFeatureExamples(batch_size, &config);
+  std::unique_ptr<thread::ThreadPool> thread_pool;
+  if (num_threads > 0) {
+    thread_pool = std::make_unique<thread::ThreadPool>(Env::Default(), "parse",
+                                                       num_threads);
+  }
+  int64_t bytes = 0;
+  for (const tstring& s : serialized) bytes += s.size();
+  for (auto s : state) {
+    Result result;
+    TF_CHECK_OK(FastParseExample(config, serialized, {}, thread_pool.get(),
+                                 &result));
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_FastParseMixedFeatures)
+    ->ArgPair(1, 0)
+    ->ArgPair(128, 0)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 4)
+    ->ArgPair(8192, 4);
+
 }  // namespace
 }  // namespace example
 }  // namespace tensorflow
@@ -15,15 +15,24 @@ limitations under the License.
 
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
 #include <utility>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !_WIN32
+
 #include "absl/base/call_once.h"
 #include "absl/synchronization/mutex.h"
 #include "xla/tsl/lib/io/buffered_file.h"
 #include "xla/tsl/util/byte_swap_array.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -36,14 +45,18 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/cache.h"
+#include "tensorflow/core/lib/io/filter_policy.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/bfloat16.h"
 #include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/random.h"
@@ -82,8 +95,100 @@ const int kMaxFileReadThreads = 8;
 // Minimum size of a file section handled by each thread.
 const int64_t kMinSectionSize = static_cast<int64_t>(1) << 31;
 
+// A data file mapped into memory with MAP_PRIVATE. Tensors that alias the
+// mapping share its pages with the page cache; the first write to a page
+// gives the writer a private copy of it, so that restored variables can be
+// updated in place without ever modifying the file.
+//
+// Like any mapping, this assumes that the file is not truncated while it is
+// mapped. Checkpoints are written to temporary files and renamed into place,
+// so this holds as long as nobody rewrites a data file in place.
+class MappedDataFile : public core::RefCounted {
+ public:
+  // Maps the data file "fname". Returns Unimplemented if the file is not on
+  // a local file system or if mapping is not supported on this platform.
+  static Status Map(const string& fname, MappedDataFile** mapped);
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  MappedDataFile(char* data, size_t size) : data_(data), size_(size) {}
+  ~MappedDataFile() override;
+
+  char* const data_;
+  const size_t size_;
+};
+
+Status MappedDataFile::Map(const string& fname, MappedDataFile** mapped) {
+#if defined(_WIN32)
+  return errors::Unimplemented("Memory-mapped restore of ", fname,
+                               " is not supported on Windows");
+#else
+  StringPiece scheme, host, path;
+  io::ParseURI(fname, &scheme, &host, &path);
+  if (!scheme.empty() && scheme != "file") {
+    return errors::Unimplemented("Can not map ", fname,
+                                 ": not on a local file system");
+  }
+  const string local_path(path);
+  const int fd = open(local_path.c_str(), O_RDONLY);
+  if (fd < 0) return errors::IOError(fname, errno);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    const int error = errno;
+    close(fd);
+    return errors::IOError(fname, error);
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return errors::Unimplemented("Can not map empty file ", fname);
+  }
+  // PROT_WRITE on a MAP_PRIVATE mapping only permits copy-on-write; the file
+  // itself was opened read-only.
+  void* data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fd, 0);
+  const int error = errno;
+  close(fd);
+  if (data == MAP_FAILED) return errors::IOError(fname, error);
+  *mapped = new MappedDataFile(static_cast<char*>(data), st.st_size);
+  return absl::OkStatus();
+#endif  // _WIN32
+}
+
+MappedDataFile::~MappedDataFile() {
+#if !defined(_WIN32)
+  munmap(data_, size_);
+#endif  // !_WIN32
+}
+
 namespace {
 
+// A TensorBuffer that aliases part of a MappedDataFile, keeping the mapping
+// alive for as long as the buffer is referenced.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(MappedDataFile* file, size_t offset, size_t size)
+      : TensorBuffer(file->data() + offset), file_(file), size_(size) {
+    file_->Ref();
+  }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("MappedDataFile");
+  }
+  // The mapping is copy-on-write, so the buffer may be written to and
+  // forwarded like any other host allocation.
+
+ private:
+  ~MappedTensorBuffer() override { file_->Unref(); }
+
+  MappedDataFile* const file_;
+  const size_t size_;
+};
+
 // Reads "num_elements" string elements from file[offset, offset+size) into the
 // length-N "destination".  Discards the original content of "destination".
 //
@@ -397,6 +502,32 @@ Status CorruptFileError(const Status& in_status, const string& filename,
                       detail, "): ", in_status.message()));
 }
 
+// Returns the base prefix to record in the header of the bundle at "prefix":
+// relative if the base is in the same directory, so that the chain survives
+// moving the whole directory.
+string BasePrefixForHeader(StringPiece prefix, StringPiece base_prefix) {
+  if (io::Dirname(base_prefix) == io::Dirname(prefix)) {
+    return string(io::Basename(base_prefix));
+  }
+  return string(base_prefix);
+}
+
+// Inverse of BasePrefixForHeader().
+string ResolveBasePrefix(StringPiece prefix, StringPiece base_prefix) {
+  if (io::Dirname(base_prefix).empty()) {
+    return io::JoinPath(io::Dirname(prefix), base_prefix);
+  }
+  return string(base_prefix);
+}
+
+// Bloom filters of the keys of the metadata table, which let lookups of keys
+// that are not in the bundle skip reading data blocks. Readers that predate
+// them ignore the filters.
+const table::FilterPolicy* BundleFilterPolicy() {
+  static const table::FilterPolicy* policy = table::NewBloomFilterPolicy(10);
+  return policy;
+}
+
 table::Options TableBuilderOptions() {
   table::Options o;
   // Compressed tables cannot be read by TensorFlow releases prior to 1.1.
@@ -404,6 +535,7 @@ table::Options TableBuilderOptions() {
   // (version 1.2) with the intention that they will be enabled again at
   // some point (perhaps the 1.3 release?).
   o.compression = table::kNoCompression;
+  o.filter_policy = BundleFilterPolicy();
   return o;
 }
 
@@ -450,9 +582,17 @@ BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
   out_ = std::make_unique<tsl::BufferedWritableFile>(
       std::move(wrapper), 8 << 20 /* 8MB write buffer */);
 
+  if (!options_.delta_base_prefix.empty()) {
+    base_ = std::make_unique<BundleReader>(env_, options_.delta_base_prefix);
+    status_ = base_->status();
+    if (!status_.ok()) return;
+  }
+
   VLOG(1) << "Writing to file " << data_path_;
 }
 
+BundleWriter::~BundleWriter() = default;
+
 Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   if (!status_.ok()) return status_;
   CHECK_NE(key, kHeaderEntryKey);
@@ -463,10 +603,33 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   }
 
   BundleEntryProto* entry = &entries_[key_string];
+  uint64 fingerprint = 0;
+  if ((options_.write_fingerprints || base_ != nullptr) &&
+      DataTypeCanUseMemcpy(val.dtype())) {
+    // Zero means "no fingerprint".
+    fingerprint = std::max<uint64>(Fingerprint64(val.tensor_data()), 1);
+  }
+  if (base_ != nullptr && fingerprint != 0) {
+    BundleEntryProto base_entry;
+    if (base_->GetBundleEntryProto(key, &base_entry).ok() &&
+        base_entry.slices().empty() &&
+        base_entry.fingerprint64() == fingerprint &&
+        base_entry.dtype() == val.dtype() &&
+        TensorShape(base_entry.shape()) == val.shape()) {
+      // Unchanged since the base was written.
+      base_entry.set_data_in_base(true);
+      base_entry.set_shard_id(0);
+      base_entry.set_offset(0);
+      entry->Swap(&base_entry);
+      ++num_entries_in_base_;
+      return absl::OkStatus();
+    }
+  }
   entry->set_dtype(val.dtype());
   val.shape().AsProto(entry->mutable_shape());
   entry->set_shard_id(0);
   entry->set_offset(size_);
+  entry->set_fingerprint64(fingerprint);
 
   // Updates the data file.
   size_t data_bytes_written = 0;
@@ -556,6 +719,7 @@ Status BundleWriter::Finish() {
     // platforms (e.g. Android).  The metadata file is small, so this is fine.
     table::Options options;
     options.compression = table::kNoCompression;
+    options.filter_policy = BundleFilterPolicy();
     table::TableBuilder builder(options, file.get());
     // Header entry.
     BundleHeaderProto header;
@@ -565,6 +729,11 @@ Status BundleWriter::Finish() {
     VersionDef* version = header.mutable_version();
     version->set_producer(kTensorBundleVersion);
     version->set_min_consumer(kTensorBundleMinConsumer);
+    if (num_entries_in_base_ > 0) {
+      header.set_base_prefix(
+          BasePrefixForHeader(prefix_, options_.delta_base_prefix));
+      header.set_delta_depth(base_->delta_depth() + 1);
+    }
 
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
 
@@ -600,6 +769,11 @@ struct MergeState {
   BundleHeaderProto_Endianness endianness;
   VersionDef version;
 
+  // The base of the merged bundles that are deltas, which must all have the
+  // same base, and the longest chain of bases among them.
+  string base_prefix;
+  int delta_depth = 0;
+
   // Tensor key -> BundleEntryProto.
   std::map<string, BundleEntryProto> entries;
   // Data file path -> new shard id in the final merged bundle.
@@ -656,6 +830,19 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
             merge_version, " vs. curr ", curr_version);
       }
     }
+    if (!header.base_prefix().empty()) {
+      const string base_prefix =
+          ResolveBasePrefix(prefix, header.base_prefix());
+      if (!merge_state->base_prefix.empty() &&
+          merge_state->base_prefix != base_prefix) {
+        return errors::InvalidArgument(
+            "Merging delta bundles with different bases: ",
+            merge_state->base_prefix, " vs. ", base_prefix);
+      }
+      merge_state->base_prefix = base_prefix;
+      merge_state->delta_depth =
+          std::max(merge_state->delta_depth, header.delta_depth());
+    }
     num_shards = header.num_shards();
     iter->Next();
   }
@@ -729,6 +916,10 @@ Status MergeBundles(Env* env, absl::Span<const tstring> prefixes,
     return errors::InvalidArgument(
         "At least one prefix checkpoint file must exist, but none existed.");
   }
+  if (merge.base_prefix == merged_prefix) {
+    return errors::InvalidArgument("Merged delta bundle ", merged_prefix,
+                                   " can not be its own base");
+  }
   // Renames data files to contain the merged bundle prefix.
   for (const auto& p : merge.shard_ids) {
     VLOG(1) << "Renaming " << p.first << " to "
@@ -749,6 +940,11 @@ Status MergeBundles(Env* env, absl::Span<const tstring> prefixes,
     header.set_num_shards(merge.num_shards);
     header.set_endianness(merge.endianness);
     *header.mutable_version() = merge.version;
+    if (!merge.base_prefix.empty()) {
+      header.set_base_prefix(
+          BasePrefixForHeader(merged_prefix, merge.base_prefix));
+      header.set_delta_depth(merge.delta_depth);
+    }
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
     // All others.
     for (const auto& p : merge.entries) {
@@ -785,12 +981,32 @@ BundleReader::BundleReader(Env* env, StringPiece prefix, Options options)
       iter_(nullptr),
       need_to_swap_bytes_(false),
       enable_multi_threading_for_testing_(
-          options.enable_multi_threading_for_testing) {
+          options.enable_multi_threading_for_testing),
+      use_mmap_(options.use_mmap),
+      lazy_mmap_(options.lazy_mmap) {
   if (cache_ == nullptr) {
     // Make a cache for use just by this BundleReader.
     owned_cache_ = std::make_unique<BundleCache>(env);
     cache_ = owned_cache_.get();
   }
+  if (!lazy_mmap_) {
+    TF_CHECK_OK(
+        ReadBoolFromEnvVar("TF_BUNDLE_READER_LAZY_MMAP", false, &lazy_mmap_));
+  }
+  if (!use_mmap_) {
+    TF_CHECK_OK(
+        ReadBoolFromEnvVar("TF_BUNDLE_READER_USE_MMAP", false, &use_mmap_));
+  }
+  use_mmap_ = use_mmap_ || lazy_mmap_;
+  // On remote file systems a single range read rarely saturates the storage,
+  // so this allows splitting the reads of much smaller tensors than the
+  // default into parallel range reads.
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_BUNDLE_READER_PARALLEL_READ_MIN_BYTES",
+                                  kLargeTensorThreshold,
+                                  &large_tensor_threshold_));
+  large_tensor_threshold_ = std::max<int64_t>(large_tensor_threshold_, 1);
+  min_section_size_ = std::min(kMinSectionSize, large_tensor_threshold_ / 2);
+  min_section_size_ = std::max<int64_t>(min_section_size_, kBufferSize);
 
   const string filename = MetaFilename(prefix_);
   uint64 file_size;
@@ -804,12 +1020,16 @@ BundleReader::BundleReader(Env* env, StringPiece prefix, Options options)
   metadata_ = wrapper.release();
 
   table::Options o;
+  o.filter_policy = BundleFilterPolicy();
   int64_t cache_size;
   Status s =
       ReadInt64FromEnvVar("TF_TABLE_INDEX_CACHE_SIZE_IN_MB", 0, &cache_size);
   if (s.ok() && cache_size > 0) {
     index_cache_ = table::NewLRUCache(cache_size << 20);
     o.block_cache = index_cache_;
+  } else {
+    // Null unless TF_TABLE_SHARED_BLOCK_CACHE_SIZE_IN_MB is set.
+    o.block_cache = table::SharedBlockCache();
   }
 
   status_ = table::Table::Open(o, metadata_, file_size, &table_);
@@ -830,6 +1050,10 @@ BundleReader::BundleReader(Env* env, StringPiece prefix, Options options)
     return;
   }
   num_shards_ = header.num_shards();
+  if (!header.base_prefix().empty()) {
+    base_prefix_ = ResolveBasePrefix(prefix_, header.base_prefix());
+    delta_depth_ = header.delta_depth();
+  }
   if ((header.endianness() == BundleHeaderProto::BIG && port::kLittleEndian) ||
       (header.endianness() == BundleHeaderProto::LITTLE &&
        !port::kLittleEndian)) {
@@ -840,6 +1064,37 @@ BundleReader::BundleReader(Env* env, StringPiece prefix, Options options)
 }
 
 BundleReader::~BundleReader() {
+  if (!deferred_checksums_.empty()) {
+    // Reads through the file rather than the mapping, whose pages may have
+    // been written to by now. Holds no reference to "this".
+    env_->SchedClosure([env = env_, prefix = prefix_, num_shards = num_shards_,
+                        checksums = std::move(deferred_checksums_)]() {
+      std::vector<char> scratch(kBufferSize);
+      for (const DeferredChecksum& c : checksums) {
+        const string fname = DataFilename(prefix, c.shard_id, num_shards);
+        std::unique_ptr<RandomAccessFile> file;
+        Status s = env->NewRandomAccessFile(fname, &file);
+        uint32 actual_crc32c = 0;
+        for (int64_t pos = 0; s.ok() && pos < c.size; pos += kBufferSize) {
+          const size_t n = std::min<int64_t>(kBufferSize, c.size - pos);
+          StringPiece sp;
+          s = file->Read(c.offset + pos, n, &sp, scratch.data());
+          if (s.ok()) {
+            actual_crc32c = crc32c::Extend(actual_crc32c, sp.data(), sp.size());
+          }
+        }
+        if (!s.ok()) {
+          LOG(ERROR) << "Failed to verify the checksum of a lazily restored "
+                     << "tensor in " << fname << ": " << s;
+        } else if (actual_crc32c != c.crc32c) {
+          LOG(ERROR) << "Lazily restored tensor in " << fname << " ("
+                     << c.size << " bytes at offset " << c.offset
+                     << "): Checksum does not match: stored " << c.crc32c
+                     << " vs. calculated " << actual_crc32c;
+        }
+      }
+    });
+  }
   delete metadata_;
   delete iter_;
   delete table_;
@@ -849,6 +1104,9 @@ BundleReader::~BundleReader() {
   for (auto& temp : data_) {
     delete temp.second;
   }
+  for (auto& temp : mapped_data_) {
+    if (temp.second != nullptr) temp.second->Unref();
+  }
   for (auto& temp : tensor_slices_) {
     delete temp.second;
   }
@@ -860,6 +1118,9 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
                                          BundleEntryProto* entry) {
   entry->Clear();
   TF_CHECK_OK(status_);
+  if (!table_->KeyMayMatch(key)) {
+    return errors::NotFound("Key ", key, " not found in checkpoint");
+  }
   Seek(key);
   if (!iter_->Valid() || iter_->key() != key) {
     return errors::NotFound("Key ", key, " not found in checkpoint");
@@ -877,7 +1138,110 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return absl::OkStatus();
 }
 
+Status BundleReader::GetMappedValue(const BundleEntryProto& entry,
+                                    Tensor* val, bool* aliased) {
+  *aliased = false;
+  // Only plain old data can alias the file, and only if its bytes are stored
+  // in our byte order at an offset that satisfies the alignment of Tensor.
+  if (!DataTypeCanUseMemcpy(entry.dtype()) || need_to_swap_bytes_ ||
+      entry.size() == 0 || entry.offset() % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return absl::OkStatus();
+  }
+  auto it = mapped_data_.find(entry.shard_id());
+  if (it == mapped_data_.end()) {
+    const string fname = DataFilename(prefix_, entry.shard_id(), num_shards_);
+    MappedDataFile* mapped = nullptr;
+    Status s = MappedDataFile::Map(fname, &mapped);
+    if (!s.ok()) {
+      VLOG(1) << "Reading " << fname << " without mmap: " << s;
+    }
+    it = mapped_data_.emplace(entry.shard_id(), mapped).first;
+  }
+  MappedDataFile* mapped = it->second;
+  if (mapped == nullptr) return absl::OkStatus();
+
+  const TensorShape stored_shape(entry.shape());
+  const size_t expected_size =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+  if (entry.offset() + entry.size() > mapped->size()) {
+    return errors::DataLoss("TensorBundle at ", prefix_, " shard ",
+                            entry.shard_id(), " is truncated: entry ends at ",
+                            entry.offset() + entry.size(), " but the file has ",
+                            mapped->size(), " bytes");
+  }
+  if (lazy_mmap_) {
+    deferred_checksums_.push_back({entry.shard_id(), entry.offset(),
+                                   entry.size(),
+                                   crc32c::Unmask(entry.crc32c())});
+  } else {
+    // Checksumming fetches every page of the tensor, which the copying path
+    // has to do as well, but without the memcpy.
+    const uint32 actual_crc32c =
+        crc32c::Value(mapped->data() + entry.offset(), entry.size());
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+          entry.size(), " bytes): Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+          " vs. calculated on the restored bytes ", actual_crc32c);
+    }
+  }
+
+  *val = Tensor(entry.dtype(), stored_shape,
+                core::RefCountPtr<TensorBuffer>(new MappedTensorBuffer(
+                    mapped, entry.offset(), entry.size())));
+  *aliased = true;
+  return absl::OkStatus();
+}
+
+Status BundleReader::GetBaseValue(const BundleEntryProto& entry,
+                                  Tensor* val) {
+  const string key_string(key());
+  if (base_prefix_.empty()) {
+    return errors::DataLoss("Entry ", key_string, " of TensorBundle at ",
+                            prefix_, " is stored in a base bundle, but the "
+                            "bundle has no base");
+  }
+  if (base_reader_ == nullptr) {
+    Options options;
+    options.cache = cache_;
+    options.enable_multi_threading_for_testing =
+        enable_multi_threading_for_testing_;
+    options.use_mmap = use_mmap_;
+    options.lazy_mmap = lazy_mmap_;
+    base_reader_ = std::make_unique<BundleReader>(env_, base_prefix_, options);
+  }
+  if (!base_reader_->status().ok()) {
+    return errors::DataLoss("Failed to open the base ", base_prefix_,
+                            " of TensorBundle at ", prefix_, ": ",
+                            base_reader_->status().message());
+  }
+  BundleEntryProto base_entry;
+  TF_RETURN_IF_ERROR(
+      base_reader_->GetBundleEntryProto(key_string, &base_entry));
+  if (base_entry.fingerprint64() != entry.fingerprint64() ||
+      base_entry.dtype() != entry.dtype() ||
+      TensorShape(base_entry.shape()) != TensorShape(entry.shape())) {
+    return errors::DataLoss("Entry ", key_string, " of TensorBundle at ",
+                            prefix_, " does not match the entry in its base ",
+                            base_prefix_, "; was the base overwritten?");
+  }
+  return base_reader_->GetValue(base_entry, val);
+}
+
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
+  if (entry.data_in_base()) return GetBaseValue(entry, val);
+  if (use_mmap_ && val->NumElements() == 0) {
+    bool aliased = false;
+    TF_RETURN_IF_ERROR(GetMappedValue(entry, val, &aliased));
+    if (aliased) return absl::OkStatus();
+  }
+
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
   if (val->NumElements() == 0) {
@@ -926,16 +1290,16 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     if (entry.size() > kBufferSize || enable_multi_threading_for_testing_) {
       StringPiece sp;
       if (!enable_multi_threading_for_testing_ &&
-          entry.size() < kLargeTensorThreshold) {
+          entry.size() < large_tensor_threshold_) {
         TF_RETURN_IF_ERROR(buffered_file->file()->Read(
             entry.offset(), entry.size(), &sp, backing_buffer));
         if (sp.data() != backing_buffer) {
           memmove(backing_buffer, sp.data(), entry.size());
         }
       } else {
-        int64_t section_size = kMinSectionSize;
+        int64_t section_size = min_section_size_;
         int64_t thread_pool_size =
-            (entry.size() + kMinSectionSize - 1) / kMinSectionSize;
+            (entry.size() + min_section_size_ - 1) / min_section_size_;
         if (thread_pool_size > kMaxFileReadThreads ||
             enable_multi_threading_for_testing_) {
           thread_pool_size = kMaxFileReadThreads;
@@ -1027,6 +1391,9 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   if (entry.slices().empty()) {
     return GetValue(entry, val);
   } else {
+    if (val->NumElements() == 0) {
+      *val = Tensor(entry.dtype(), TensorShape(entry.shape()));
+    }
     return GetSliceValue(
         key, entry,
         /* a full slice */ TensorSlice(TensorShape(entry.shape()).dims()), val);
@@ -1045,6 +1412,9 @@ Status BundleReader::ReadCurrent(Tensor* val) {
   if (entry.slices().empty()) {
     return GetValue(entry, val);
   } else {
+    if (val->NumElements() == 0) {
+      *val = Tensor(entry.dtype(), TensorShape(entry.shape()));
+    }
     return GetSliceValue(
         iter_->key(), entry,
         /* a full slice */ TensorSlice(TensorShape(entry.shape()).dims()), val);
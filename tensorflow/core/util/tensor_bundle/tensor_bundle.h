@@ -57,6 +57,11 @@ limitations under the License.
 //        "/fs/model/train/ckpt-step/tmp/worker1-step"},
 //       "/fs/model/train/ckpt-step/ckpt" /* merged prefix */);
 //
+// A bundle may also be written as a delta against an existing base bundle
+// (see BundleWriter::Options::delta_base_prefix), in which case it only holds
+// the data of the tensors that changed; BundleReader resolves the others
+// through the chain of bases transparently.
+//
 
 #ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 #define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
@@ -112,6 +117,8 @@ extern const char* const kHeaderEntryKey;
 // "prefix", so "status()" must be checked before calling any member functions.
 //
 // All threads accessing the same BundleWriter must synchronize.
+class BundleReader;
+
 class BundleWriter {
  public:
   struct Options {
@@ -119,9 +126,21 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+
+    // If true, stores the fingerprint of each tensor that can be memcpy'd, so
+    // that later bundles can be written as deltas against this one.
+    bool write_fingerprints = false;
+
+    // If not empty, the prefix of an existing bundle to write this one as a
+    // delta against. Tensors passed to Add() whose type, shape and
+    // fingerprint match the entry of the same key in the base are not
+    // written again; BundleReader reads them from the base instead, so the
+    // base must outlive this bundle. Implies write_fingerprints.
+    std::string delta_base_prefix;
   };
   BundleWriter(Env* env, absl::string_view prefix,
                const Options& options = Options());
+  ~BundleWriter();
 
   // Adds the tensor "val" under key "key".
   // Across calls "key" must be unique but can be added in any order.
@@ -164,6 +183,10 @@ class BundleWriter {
   std::map<std::string, BundleEntryProto> entries_;
   Status status_;
 
+  // The bundle this one is a delta against, if any.
+  std::unique_ptr<BundleReader> base_;
+  int num_entries_in_base_ = 0;
+
   BundleWriter(const BundleWriter&) = delete;
   void operator=(const BundleWriter&) = delete;
 };
@@ -195,6 +218,7 @@ Status MergeBundles(Env* env, absl::Span<const tstring> prefixes,
                     bool allow_missing_files = false);
 
 class BundleCache;
+class MappedDataFile;
 
 // On construction, silently attempts to read the metadata associated with
 // "prefix".  If caller intends to call any function afterwards, "status()"
@@ -212,6 +236,25 @@ class BundleReader {
 
     // For tests only.
     bool enable_multi_threading_for_testing = false;
+
+    // If true, data files on a local file system are memory-mapped, and
+    // Lookup() into an empty tensor returns tensors whose buffer aliases the
+    // mapping instead of a copy, provided that the entry is suitably aligned
+    // in the file and needs no byte swapping. The mapping is private and
+    // copy-on-write: writes to such a tensor never reach the file. Can also
+    // be enabled with the TF_BUNDLE_READER_USE_MMAP environment variable.
+    bool use_mmap = false;
+
+    // Only has an effect together with use_mmap. If true, Lookup() does not
+    // verify the checksums of tensors that alias a mapped data file, so that
+    // their pages are only read from the file when they are first accessed.
+    // Instead, once the reader is destroyed, a background thread verifies
+    // them by reading the data files in order, which also warms the page
+    // cache for tensors that were not accessed yet. Since the tensors are in
+    // use by then, mismatches are logged as errors. Can also be enabled with
+    // the TF_BUNDLE_READER_LAZY_MMAP environment variable, which implies
+    // use_mmap.
+    bool lazy_mmap = false;
   };
   BundleReader(Env* env, absl::string_view prefix, Options options);
 
@@ -221,6 +264,14 @@ class BundleReader {
   // the metadata).
   Status status() const { return status_; }
 
+  // Whether lookups may return tensors that alias memory-mapped data files.
+  // See Options::use_mmap.
+  bool use_mmap() const { return use_mmap_; }
+
+  // The number of bases this bundle is a chain of deltas against; 0 if it
+  // holds all of its data. See BundleWriter::Options::delta_base_prefix.
+  int delta_depth() const { return delta_depth_; }
+
   // Queries whether the bundle contains an entry keyed by "key".  Calls Seek()
   // internally, so this call invalidates the reader's current position.
   // REQUIRES: status().ok()
@@ -256,6 +307,8 @@ class BundleReader {
   // Caller must make sure "val" has the same shape and dtype as the
   // corresponding contents, so that its buffer can be filled without needing
   // extra allocation.  These can be queried via "LookupDtypeAndShape()".
+  // Alternatively "val" may be empty, in which case the reader allocates it,
+  // or aliases it to the mapped data file if use_mmap() is true.
   //
   // On error, "val" may contain nonsense data.  Returns a NotFound error if
   // tensor keyed by "key" does not exist in this bundle.
@@ -311,7 +364,8 @@ class BundleReader {
   std::string DebugString();
 
  private:
-  // Seeks for "key" and reads the metadata proto.
+  // Seeks for "key" and reads the metadata proto. Does not seek for keys
+  // that the filter of the metadata table rules out.
   // On non-OK return, clears "entry" for the caller.
   // REQUIRES: status().ok()
   Status GetBundleEntryProto(absl::string_view key,
@@ -322,6 +376,17 @@ class BundleReader {
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Reads the tensor value of the entry "entry" at the current key, whose
+  // data is stored in the base bundle.
+  Status GetBaseValue(const BundleEntryProto& entry,
+                      Tensor* val) TF_MUST_USE_RESULT;
+
+  // Tries to return the tensor described by "entry" as an alias of the mapped
+  // data file. Sets "*aliased" to false, leaving "val" untouched, if the entry
+  // can not be aliased and has to be read by GetValue() instead.
+  Status GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                        bool* aliased) TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -344,6 +409,10 @@ class BundleReader {
   // Owned InputBuffer objects. cache_ owns the underlying RandomAccessFiles.
   std::unordered_map<int32_t, io::InputBuffer*> data_;
 
+  // Data files mapped by GetMappedValue(), each holding a reference. Null
+  // for shards that could not be mapped.
+  std::unordered_map<int32_t, MappedDataFile*> mapped_data_;
+
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
   std::unordered_map<std::string, checkpoint::TensorSliceSet*> tensor_slices_;
@@ -356,10 +425,35 @@ class BundleReader {
   // differs from that of the current system's processor architecture.
   bool need_to_swap_bytes_;
 
+  // The prefix of the bundle this one is a delta against, or empty, and the
+  // length of its chain of bases. The base is opened on first use.
+  std::string base_prefix_;
+  int delta_depth_ = 0;
+  std::unique_ptr<BundleReader> base_reader_;
+
   friend class TensorBundleAlignmentTest;  // For testing data alignment.
+  friend class BundleWriter;  // Looks up the entries of delta bases.
 
   bool enable_multi_threading_for_testing_ = false;
 
+  bool use_mmap_ = false;
+  bool lazy_mmap_ = false;
+
+  // A checksum of an aliased tensor whose verification was deferred by
+  // Options::lazy_mmap.
+  struct DeferredChecksum {
+    int32_t shard_id;
+    int64_t offset;
+    int64_t size;
+    uint32_t crc32c;
+  };
+  std::vector<DeferredChecksum> deferred_checksums_;
+
+  // Tensors of at least this many bytes are read with parallel range reads
+  // of at least "min_section_size_" bytes each.
+  int64_t large_tensor_threshold_;
+  int64_t min_section_size_;
+
   BundleReader(const BundleReader&) = delete;
   void operator=(const BundleReader&) = delete;
 };
@@ -24,6 +24,8 @@ limitations under the License.
 #endif  // _WIN32
 
 #include "absl/status/status.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -917,6 +919,108 @@ TEST(TensorBundleTest, DirectoryStructure) {
                           "merged.data-00001-of-00002"});
 }
 
+TEST(TensorBundleTest, DeltaBundles) {
+  Env* env = Env::Default();
+  {
+    BundleWriter::Options opts;
+    opts.write_fingerprints = true;
+    BundleWriter writer(env, Prefix("delta_0"), opts);
+    TF_EXPECT_OK(writer.Add("changed", Constant_100x100<float>(0)));
+    TF_EXPECT_OK(writer.Add("unchanged", Constant_100x100<float>(1)));
+    TF_EXPECT_OK(writer.Add("string", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  for (int i = 1; i <= 2; ++i) {
+    BundleWriter::Options opts;
+    opts.delta_base_prefix = Prefix(strings::StrCat("delta_", i - 1));
+    BundleWriter writer(env, Prefix(strings::StrCat("delta_", i)), opts);
+    TF_EXPECT_OK(writer.Add("changed", Constant_100x100<float>(i)));
+    TF_EXPECT_OK(writer.Add("unchanged", Constant_100x100<float>(1)));
+    TF_EXPECT_OK(writer.Add("string", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  // Only the changed tensor and the string are written to the deltas.
+  uint64 full_size, delta_size;
+  TF_ASSERT_OK(env->GetFileSize(DataFilename(Prefix("delta_0"), 0, 1),
+                                &full_size));
+  TF_ASSERT_OK(env->GetFileSize(DataFilename(Prefix("delta_2"), 0, 1),
+                                &delta_size));
+  EXPECT_LT(delta_size, full_size);
+
+  BundleReader reader(env, Prefix("delta_2"));
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(reader.delta_depth(), 2);
+  EXPECT_EQ(AllTensorKeys(&reader),
+            std::vector<string>({"changed", "string", "unchanged"}));
+  Expect<float>(&reader, "changed", Constant_100x100<float>(2));
+  Expect<float>(&reader, "unchanged", Constant_100x100<float>(1));
+  Expect<tstring>(&reader, "string", Constant_2x3<tstring>("foo"));
+  reader.Seek(kHeaderEntryKey);
+  ExpectNext<float>(&reader, Constant_100x100<float>(2));
+  ExpectNext<tstring>(&reader, Constant_2x3<tstring>("foo"));
+  ExpectNext<float>(&reader, Constant_100x100<float>(1));
+}
+
+TEST(TensorBundleTest, MergedDeltaBundles) {
+  Env* env = Env::Default();
+  {
+    BundleWriter::Options opts;
+    opts.write_fingerprints = true;
+    BundleWriter writer(env, Prefix("merged_delta_base"), opts);
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<float>(0)));
+    TF_EXPECT_OK(writer.Add("bar", Constant_2x3<int32>(1)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleWriter::Options opts;
+  opts.delta_base_prefix = Prefix("merged_delta_base");
+  {
+    BundleWriter writer(env, Prefix("merged_delta_part_0"), opts);
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<float>(0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(env, Prefix("merged_delta_part_1"), opts);
+    TF_EXPECT_OK(writer.Add("bar", Constant_2x3<int32>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK(MergeBundles(
+      env, {Prefix("merged_delta_part_0"), Prefix("merged_delta_part_1")},
+      Prefix("merged_delta")));
+
+  BundleReader reader(env, Prefix("merged_delta"));
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(reader.delta_depth(), 1);
+  Expect<float>(&reader, "foo", Constant_2x3<float>(0));
+  Expect<int32>(&reader, "bar", Constant_2x3<int32>(2));
+}
+
+TEST(TensorBundleTest, DeltaBundleDetectsOverwrittenBase) {
+  Env* env = Env::Default();
+  BundleWriter::Options opts;
+  opts.write_fingerprints = true;
+  {
+    BundleWriter writer(env, Prefix("overwritten_base"), opts);
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<float>(0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter::Options delta_opts;
+    delta_opts.delta_base_prefix = Prefix("overwritten_base");
+    BundleWriter writer(env, Prefix("overwritten_delta"), delta_opts);
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<float>(0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(env, Prefix("overwritten_base"), opts);
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<float>(3)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(env, Prefix("overwritten_delta"));
+  TF_ASSERT_OK(reader.status());
+  Tensor val(DT_FLOAT, TensorShape({2, 3}));
+  EXPECT_TRUE(errors::IsDataLoss(reader.Lookup("foo", &val)));
+}
+
 TEST(TensorBundleTest, SortForSequentialAccess) {
   Env* env = Env::Default();
   const std::vector<string> kBundlePrefixes = {Prefix("worker0"),
@@ -1151,6 +1255,125 @@ TEST(TensorBundleTest, LargeVariableLoadingTest) {
   }
 }
 
+// Returns whether the buffer of "t" aliases a memory-mapped data file.
+bool IsMapped(const Tensor& t) {
+  TensorDescription description;
+  t.FillDescription(&description);
+  return description.allocation_description().allocator_name() ==
+         "MappedDataFile";
+}
+
+#if !defined(_WIN32)
+TEST(TensorBundleTest, MmapLookupAliasesAlignedEntries) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = 64;
+    BundleWriter writer(Env::Default(), Prefix("mmap"), opts);
+    TF_EXPECT_OK(writer.Add("aligned_000", Constant_100x100<float>(0)));
+    TF_EXPECT_OK(writer.Add("aligned_001", Constant_2x3<int32>(1)));
+    TF_EXPECT_OK(writer.Add("string", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options options;
+  options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap"), options);
+  TF_ASSERT_OK(reader.status());
+  EXPECT_TRUE(reader.use_mmap());
+
+  Tensor aligned;
+  TF_ASSERT_OK(reader.Lookup("aligned_000", &aligned));
+  test::ExpectTensorEqual<float>(aligned, Constant_100x100<float>(0));
+  EXPECT_TRUE(IsMapped(aligned));
+
+  Tensor small;
+  TF_ASSERT_OK(reader.Lookup("aligned_001", &small));
+  test::ExpectTensorEqual<int32>(small, Constant_2x3<int32>(1));
+  EXPECT_TRUE(IsMapped(small));
+
+  // Strings can not alias the file.
+  Tensor str;
+  TF_ASSERT_OK(reader.Lookup("string", &str));
+  test::ExpectTensorEqual<tstring>(str, Constant_2x3<tstring>("foo"));
+  EXPECT_FALSE(IsMapped(str));
+
+  // A preallocated tensor is filled in as before.
+  Tensor preallocated(DT_FLOAT, TensorShape({100, 100}));
+  TF_ASSERT_OK(reader.Lookup("aligned_000", &preallocated));
+  test::ExpectTensorEqual<float>(preallocated, Constant_100x100<float>(0));
+  EXPECT_FALSE(IsMapped(preallocated));
+}
+#endif  // !_WIN32
+
+TEST(TensorBundleTest, MmapLookupIsCopyOnWrite) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = 64;
+    BundleWriter writer(Env::Default(), Prefix("mmap_cow"), opts);
+    TF_EXPECT_OK(writer.Add("foo", Constant_100x100<float>(3)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options options;
+  options.use_mmap = true;
+  Tensor written;
+  {
+    BundleReader reader(Env::Default(), Prefix("mmap_cow"), options);
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.Lookup("foo", &written));
+  }
+  // The tensor outlives its reader, and writing to it leaves the file intact.
+  test::ExpectTensorEqual<float>(written, Constant_100x100<float>(3));
+  written.flat<float>().setConstant(7);
+  test::ExpectTensorEqual<float>(written, Constant_100x100<float>(7));
+
+  BundleReader reader(Env::Default(), Prefix("mmap_cow"), options);
+  TF_ASSERT_OK(reader.status());
+  Tensor reread;
+  TF_ASSERT_OK(reader.Lookup("foo", &reread));
+  test::ExpectTensorEqual<float>(reread, Constant_100x100<float>(3));
+}
+
+TEST(TensorBundleTest, LazyMmapLookup) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = 64;
+    BundleWriter writer(Env::Default(), Prefix("mmap_lazy"), opts);
+    TF_EXPECT_OK(writer.Add("foo_000", Constant_100x100<float>(0)));
+    TF_EXPECT_OK(writer.Add("foo_001", Constant_100x100<float>(1)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options options;
+  options.lazy_mmap = true;
+  Tensor foo_000, foo_001;
+  {
+    BundleReader reader(Env::Default(), Prefix("mmap_lazy"), options);
+    TF_ASSERT_OK(reader.status());
+    EXPECT_TRUE(reader.use_mmap());
+    TF_ASSERT_OK(reader.Lookup("foo_000", &foo_000));
+    TF_ASSERT_OK(reader.Lookup("foo_001", &foo_001));
+  }
+  // Writes do not affect the deferred verification, which reads the file.
+  foo_000.flat<float>().setConstant(5);
+  test::ExpectTensorEqual<float>(foo_000, Constant_100x100<float>(5));
+  test::ExpectTensorEqual<float>(foo_001, Constant_100x100<float>(1));
+}
+
+TEST(TensorBundleTest, MmapLookupCopiesUnalignedEntries) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("mmap_unaligned"));
+    TF_EXPECT_OK(writer.Add("a", Constant(true, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options options;
+  options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_unaligned"), options);
+  TF_ASSERT_OK(reader.status());
+  Tensor b;
+  TF_ASSERT_OK(reader.Lookup("b", &b));
+  test::ExpectTensorEqual<float>(b, Constant_2x3<float>(2));
+  EXPECT_FALSE(IsMapped(b));
+}
+
 absl::Status CreateFile(Env* env, const std::string& fname) {
   std::unique_ptr<WritableFile> file;
   TF_RETURN_IF_ERROR(env->NewWritableFile(fname, &file));
@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
+#include <cstdint>
+#include <memory>
 #include <utility>
 
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/tensor_slice_set.h"
 
 namespace tensorflow {
 
@@ -29,27 +32,72 @@ TensorSliceReaderCacheWrapper::~TensorSliceReaderCacheWrapper() {
   cache_ = nullptr;
 }
 
-const TensorSliceReader* TensorSliceReaderCacheWrapper::GetReader(
+std::shared_ptr<const TensorSliceReader>
+TensorSliceReaderCacheWrapper::GetReader(
     const string& filepattern,
     TensorSliceReader::OpenTableFunction open_function,
     int preferred_shard) const {
-  mutex_lock l(mu_);
-  if (!cache_) {
-    cache_ = new TensorSliceReaderCache;
+  TensorSliceReaderCache* cache;
+  {
+    mutex_lock l(mu_);
+    if (!cache_) {
+      cache_ = new TensorSliceReaderCache;
+    }
+    cache = cache_;
+  }
+  // The cache has its own lock, so that readers of different files can be
+  // opened concurrently.
+  return cache->GetReader(filepattern, std::move(open_function),
+                          preferred_shard);
+}
+
+namespace {
+
+// Returns an estimate of the memory taken by the index of 'reader', which
+// holds the names, shapes and slices of the tensors in the checkpoint.
+int64_t IndexBytes(const TensorSliceReader& reader) {
+  int64_t bytes = sizeof(TensorSliceReader);
+  for (const auto& tensor : reader.Tensors()) {
+    bytes += tensor.first.size() + sizeof(TensorSliceSet);
+    for (const auto& slice : tensor.second->Slices()) {
+      bytes += slice.first.size() + slice.second.tag.size() +
+               sizeof(TensorSliceSet::SliceInfo);
+    }
   }
-  return cache_->GetReader(filepattern, std::move(open_function),
-                           preferred_shard);
+  return bytes;
 }
 
-TensorSliceReaderCache::TensorSliceReaderCache() = default;
+}  // namespace
+
+TensorSliceReaderCache::TensorSliceReaderCache(int max_readers,
+                                               int64_t max_index_bytes)
+    : max_readers_(max_readers), max_index_bytes_(max_index_bytes) {}
+
+TensorSliceReaderCache::~TensorSliceReaderCache() = default;
 
-TensorSliceReaderCache::~TensorSliceReaderCache() {
-  for (const auto& pair : readers_) {
-    delete pair.second.second;
+int TensorSliceReaderCache::num_readers() {
+  mutex_lock l(mu_);
+  return readers_.size();
+}
+
+int64_t TensorSliceReaderCache::index_bytes() {
+  mutex_lock l(mu_);
+  return index_bytes_;
+}
+
+void TensorSliceReaderCache::EvictReaders() {
+  while (lru_.size() > 1 &&
+         (static_cast<int>(readers_.size()) > max_readers_ ||
+          index_bytes_ > max_index_bytes_)) {
+    auto it = readers_.find(lru_.back());
+    VLOG(1) << "Evicting TensorSliceReader for " << it->first;
+    index_bytes_ -= it->second.index_bytes;
+    readers_.erase(it);
+    lru_.pop_back();
   }
 }
 
-const TensorSliceReader* TensorSliceReaderCache::GetReader(
+std::shared_ptr<const TensorSliceReader> TensorSliceReaderCache::GetReader(
     const string& filepattern,
     TensorSliceReader::OpenTableFunction open_function, int preferred_shard) {
   mutex_lock l(mu_);
@@ -77,31 +125,39 @@ const TensorSliceReader* TensorSliceReaderCache::GetReader(
     cv_.wait(l);
   }
 
-  TensorSliceReader* reader = nullptr;
-  if (readers_.find(filepattern) == readers_.end()) {
+  std::shared_ptr<const TensorSliceReader> reader;
+  auto it = readers_.find(filepattern);
+  if (it == readers_.end()) {
     VLOG(1) << "Creating new TensorSliceReader for " << filepattern;
     still_opening_.insert(filepattern);
     // Release the lock temporary as constructing TensorSliceReader is
     // expensive.
     mu_.unlock();
-    TensorSliceReader* tmp_reader(
-        new TensorSliceReader(filepattern, open_function, preferred_shard));
+    auto tmp_reader = std::make_shared<TensorSliceReader>(
+        filepattern, open_function, preferred_shard);
+    // The reader is not shared yet, so its index can be read without locking.
+    const int64_t reader_index_bytes =
+        tmp_reader->status().ok() ? IndexBytes(*tmp_reader) : 0;
     // Acquire the lock again.
     mu_.lock();
     if (tmp_reader->status().ok()) {
-      reader = tmp_reader;
-      readers_[filepattern] = std::make_pair(*func_ptr, reader);
-    } else {
-      delete tmp_reader;
+      reader = std::move(tmp_reader);
+      lru_.push_front(filepattern);
+      readers_[filepattern] =
+          CachedReader{*func_ptr, reader, reader_index_bytes, lru_.begin()};
+      index_bytes_ += reader_index_bytes;
+      EvictReaders();
     }
     CHECK_EQ(size_t{1}, still_opening_.erase(filepattern));
-    VLOG(1) << "Cached TensorSliceReader for " << filepattern << ": " << reader;
+    VLOG(1) << "Cached TensorSliceReader for " << filepattern << ": "
+            << reader.get();
   } else {
-    auto cached_val = readers_[filepattern];
-    if (cached_val.first == *func_ptr) {
-      reader = cached_val.second;
+    CachedReader& cached_val = it->second;
+    if (cached_val.open_func == *func_ptr) {
+      reader = cached_val.reader;
+      lru_.splice(lru_.begin(), lru_, cached_val.lru_pos);
       VLOG(1) << "Using cached TensorSliceReader for " << filepattern << ": "
-              << reader;
+              << reader.get();
     } else {
       LOG(WARNING) << "Caching disabled because the checkpoint file "
                    << "is being opened with two different open functions: "
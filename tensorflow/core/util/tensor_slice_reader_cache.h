@@ -19,6 +19,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_TENSOR_SLICE_READER_CACHE_H_
 #define TENSORFLOW_CORE_UTIL_TENSOR_SLICE_READER_CACHE_H_
 
+#include <cstdint>
+#include <list>
+#include <memory>
 #include <set>
 #include <unordered_map>
 #include <utility>
@@ -41,7 +44,7 @@ class TensorSliceReaderCacheWrapper {
   ~TensorSliceReaderCacheWrapper();
 
   // Same as TensorSliceReaderCache::GetReader().
-  const TensorSliceReader* GetReader(
+  std::shared_ptr<const TensorSliceReader> GetReader(
       const string& filepattern,
       TensorSliceReader::OpenTableFunction open_function,
       int preferred_shard) const;
@@ -52,29 +55,65 @@ class TensorSliceReaderCacheWrapper {
 };
 
 // A cache of TensorSliceReaders.
+//
+// The cache holds at most 'max_readers' readers, whose indices take at most
+// 'max_index_bytes' of memory in total, and evicts the least recently used
+// readers beyond that. The most recently used reader is always kept. Readers
+// of different files are opened concurrently.
 class TensorSliceReaderCache {
  public:
-  TensorSliceReaderCache();
+  static constexpr int kDefaultMaxReaders = 64;
+  static constexpr int64_t kDefaultMaxIndexBytes = 1LL << 30;
+
+  explicit TensorSliceReaderCache(
+      int max_readers = kDefaultMaxReaders,
+      int64_t max_index_bytes = kDefaultMaxIndexBytes);
   ~TensorSliceReaderCache();
 
   // Returns the TensorSliceReader corresponding to 'filepattern' and the
   // open_function.  May return nullptr if we can not create a new
-  // TensorSliceReader for the filepattern/open_function combination.
-  const TensorSliceReader* GetReader(
+  // TensorSliceReader for the filepattern/open_function combination. The
+  // returned reader stays valid after it is evicted from the cache.
+  std::shared_ptr<const TensorSliceReader> GetReader(
       const string& filepattern,
       TensorSliceReader::OpenTableFunction open_function, int preferred_shard);
 
+  // Returns the number of cached readers.
+  int num_readers();
+
+  // Returns the memory taken by the indices of the cached readers.
+  int64_t index_bytes();
+
  private:
   // Need to use a regular function type in the key map as std::function does
   // not support ==.
   typedef Status (*OpenFuncType)(const string&, TensorSliceReader::Table**);
 
+  struct CachedReader {
+    OpenFuncType open_func;
+    std::shared_ptr<const TensorSliceReader> reader;
+    int64_t index_bytes;
+    // Position of the file pattern in lru_.
+    std::list<string>::iterator lru_pos;
+  };
+
+  // Evicts least recently used readers until the cache is within its limits.
+  void EvictReaders() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int max_readers_;
+  const int64_t max_index_bytes_;
+
   // Protects attributes below.
   mutex mu_;
 
   // Maps of opened readers.
-  std::unordered_map<string, std::pair<OpenFuncType, TensorSliceReader*>>
-      readers_;
+  std::unordered_map<string, CachedReader> readers_ TF_GUARDED_BY(mu_);
+
+  // File patterns of the cached readers, most recently used first.
+  std::list<string> lru_ TF_GUARDED_BY(mu_);
+
+  // Sum of the index_bytes of the cached readers.
+  int64_t index_bytes_ TF_GUARDED_BY(mu_) = 0;
 
   // Set of keys that a previous GetReader() call is still trying to populate.
   std::set<string> still_opening_;
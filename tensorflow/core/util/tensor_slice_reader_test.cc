@@ -551,7 +551,7 @@ void CachedTensorSliceReaderTesterHelper(
   // Now we need to read the tensor slices
   TensorSliceReaderCache cache;
   const string filepattern = strings::StrCat(fname_base, "_*");
-  const TensorSliceReader* reader = cache.GetReader(
+  std::shared_ptr<const TensorSliceReader> reader = cache.GetReader(
       filepattern, open_function, TensorSliceReader::kLoadAllShards);
   EXPECT_TRUE(reader != nullptr);
   EXPECT_EQ(2, reader->num_files());
@@ -567,7 +567,7 @@ void CachedTensorSliceReaderTesterHelper(
   }
 
   // Make sure the reader is cached.
-  const TensorSliceReader* reader2 = cache.GetReader(
+  std::shared_ptr<const TensorSliceReader> reader2 = cache.GetReader(
       filepattern, open_function, TensorSliceReader::kLoadAllShards);
   EXPECT_EQ(reader, reader2);
 
@@ -581,6 +581,70 @@ TEST(CachedTensorSliceReaderTest, SimpleFloat) {
                                       OpenTableTensorSliceReader);
 }
 
+TEST(CachedTensorSliceReaderTest, EvictsLeastRecentlyUsed) {
+  std::vector<string> fnames;
+  for (int i = 0; i < 3; ++i) {
+    fnames.push_back(
+        io::JoinPath(testing::TmpDir(), strings::StrCat("evict_ckpt_", i)));
+    TensorSliceWriter writer(fnames.back(), CreateTableTensorSliceBuilder);
+    const float data[] = {0, 1, 2, 3};
+    TF_CHECK_OK(writer.Add("test", TensorShape({4}),
+                           TensorSlice::ParseOrDie("-"), data));
+    TF_CHECK_OK(writer.Finish());
+  }
+
+  TensorSliceReaderCache cache(/*max_readers=*/2);
+  std::shared_ptr<const TensorSliceReader> reader0 = cache.GetReader(
+      fnames[0], OpenTableTensorSliceReader, TensorSliceReader::kLoadAllShards);
+  ASSERT_TRUE(reader0 != nullptr);
+  std::shared_ptr<const TensorSliceReader> reader1 = cache.GetReader(
+      fnames[1], OpenTableTensorSliceReader, TensorSliceReader::kLoadAllShards);
+  ASSERT_TRUE(reader1 != nullptr);
+  // Use reader0 so that reader1 is the least recently used.
+  EXPECT_EQ(reader0, cache.GetReader(fnames[0], OpenTableTensorSliceReader,
+                                     TensorSliceReader::kLoadAllShards));
+  EXPECT_EQ(2, cache.num_readers());
+  EXPECT_GT(cache.index_bytes(), 0);
+
+  std::shared_ptr<const TensorSliceReader> reader2 = cache.GetReader(
+      fnames[2], OpenTableTensorSliceReader, TensorSliceReader::kLoadAllShards);
+  ASSERT_TRUE(reader2 != nullptr);
+  EXPECT_EQ(2, cache.num_readers());
+  EXPECT_EQ(reader0, cache.GetReader(fnames[0], OpenTableTensorSliceReader,
+                                     TensorSliceReader::kLoadAllShards));
+  // reader1 was evicted, but stays usable by its holders.
+  EXPECT_TRUE(reader1->HasTensor("test", nullptr, nullptr));
+  EXPECT_NE(reader1, cache.GetReader(fnames[1], OpenTableTensorSliceReader,
+                                     TensorSliceReader::kLoadAllShards));
+  EXPECT_EQ(2, cache.num_readers());
+}
+
+TEST(CachedTensorSliceReaderTest, EvictsOverIndexMemoryLimit) {
+  std::vector<string> fnames;
+  for (int i = 0; i < 2; ++i) {
+    fnames.push_back(io::JoinPath(testing::TmpDir(),
+                                  strings::StrCat("evict_memory_ckpt_", i)));
+    TensorSliceWriter writer(fnames.back(), CreateTableTensorSliceBuilder);
+    const float data[] = {0, 1, 2, 3};
+    TF_CHECK_OK(writer.Add("test", TensorShape({4}),
+                           TensorSlice::ParseOrDie("-"), data));
+    TF_CHECK_OK(writer.Finish());
+  }
+
+  // The most recently used reader is kept even if it is over the limit.
+  TensorSliceReaderCache cache(/*max_readers=*/10, /*max_index_bytes=*/1);
+  std::shared_ptr<const TensorSliceReader> reader0 = cache.GetReader(
+      fnames[0], OpenTableTensorSliceReader, TensorSliceReader::kLoadAllShards);
+  ASSERT_TRUE(reader0 != nullptr);
+  EXPECT_EQ(1, cache.num_readers());
+  std::shared_ptr<const TensorSliceReader> reader1 = cache.GetReader(
+      fnames[1], OpenTableTensorSliceReader, TensorSliceReader::kLoadAllShards);
+  ASSERT_TRUE(reader1 != nullptr);
+  EXPECT_EQ(1, cache.num_readers());
+  EXPECT_EQ(reader1, cache.GetReader(fnames[1], OpenTableTensorSliceReader,
+                                     TensorSliceReader::kLoadAllShards));
+}
+
 static void VersionTest(const VersionDef& versions, const string& error) {
   const string path = io::JoinPath(testing::TmpDir(), "checkpoint");
 
@@ -16,8 +16,11 @@ limitations under the License.
 #include "tensorflow/dtensor/cc/dtensor_graph_to_mlir_pass.h"
 
 #include <memory>
+#include <string>
 #include <utility>
 
+#include "absl/strings/str_cat.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/Builders.h"  // from @llvm-project
 #include "mlir/IR/BuiltinAttributes.h"  // from @llvm-project
 #include "mlir/IR/BuiltinOps.h"  // from @llvm-project
@@ -26,6 +29,7 @@ limitations under the License.
 #include "mlir/IR/SymbolTable.h"  // from @llvm-project
 #include "mlir/IR/Types.h"  // from @llvm-project
 #include "mlir/InitAllExtensions.h"  // from @llvm-project
+#include "mlir/Parser/Parser.h"  // from @llvm-project
 #include "mlir/Support/LogicalResult.h"  // from @llvm-project
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/mlir/tensorflow/dialect_registration.h"
@@ -40,7 +44,11 @@ limitations under the License.
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/dtensor/cc/constants.h"
 #include "tensorflow/dtensor/cc/dtensor_utils.h"
@@ -72,6 +80,9 @@ DTensorMlirPassRunner::DTensorMlirPassRunner()
   // Creates a pipeline that include each DTensor related passes.
   mlir::TF::StandardPipelineOptions pipeline_options;
   dtensor::CreateDTensorMLIRPass(pipeline_options, &pass_manager_);
+
+  llvm::raw_string_ostream os(pipeline_);
+  pass_manager_.printAsTextualPipeline(os);
 }
 
 absl::StatusOr<mlir::OwningOpRef<mlir::ModuleOp>>
@@ -140,7 +151,78 @@ DTensorMlirPassRunner::ImportGraphToMlir(
   return module_ref;
 }
 
+std::string DTensorMlirPassRunner::CompilationCachePath(
+    const std::string& cache_dir, mlir::ModuleOp module) {
+  // The module carries the graph, function library, devices, default mesh and
+  // DTensor settings, so together with the pipeline and the TensorFlow
+  // version it determines the lowered module.
+  std::string module_str;
+  llvm::raw_string_ostream os(module_str);
+  module.print(os);
+  Fprint128 fingerprint = Fingerprint128(TF_VERSION_STRING);
+  fingerprint = FingerprintCat128(fingerprint, Fingerprint128(pipeline_));
+  fingerprint = FingerprintCat128(fingerprint, Fingerprint128(module_str));
+  return io::JoinPath(cache_dir, absl::StrCat(absl::Hex(fingerprint.high64,
+                                                        absl::kZeroPad16),
+                                              absl::Hex(fingerprint.low64,
+                                                        absl::kZeroPad16),
+                                              ".mlir"));
+}
+
+bool DTensorMlirPassRunner::LoadLoweredModule(const std::string& path,
+                                              mlir::ModuleOp module) {
+  std::string module_str;
+  Status status = ReadFileToString(Env::Default(), path, &module_str);
+  if (!status.ok()) {
+    if (!errors::IsNotFound(status)) {
+      LOG(WARNING) << "Failed to read DTensor compilation cache entry " << path
+                   << ": " << status;
+    }
+    return false;
+  }
+  mlir::OwningOpRef<mlir::ModuleOp> cached =
+      mlir::parseSourceString<mlir::ModuleOp>(module_str, &context_);
+  if (!cached) {
+    LOG(WARNING) << "Ignoring invalid DTensor compilation cache entry " << path;
+    return false;
+  }
+  module.getBodyRegion().takeBody(cached->getBodyRegion());
+  module->setAttrs(cached.get()->getAttrDictionary());
+  VLOG(2) << "Loaded lowered DTensor module from " << path;
+  return true;
+}
+
+void DTensorMlirPassRunner::SaveLoweredModule(const std::string& path,
+                                              mlir::ModuleOp module) {
+  std::string module_str;
+  llvm::raw_string_ostream os(module_str);
+  module.print(os);
+  // Write to a temporary file first so that concurrent processes never read a
+  // partially written entry.
+  Env* env = Env::Default();
+  Status status = env->RecursivelyCreateDir(std::string(io::Dirname(path)));
+  const std::string tmp_path = absl::StrCat(path, ".tmp", random::New64());
+  if (status.ok()) {
+    status = WriteStringToFile(env, tmp_path, module_str);
+  }
+  if (status.ok()) {
+    status = env->RenameFile(tmp_path, path);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write DTensor compilation cache entry " << path
+                 << ": " << status;
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+}
+
 Status DTensorMlirPassRunner::Run(mlir::ModuleOp module) {
+  const std::string cache_dir = dtensor::CompilationCacheDir();
+  std::string cache_path;
+  if (!cache_dir.empty()) {
+    cache_path = CompilationCachePath(cache_dir, module);
+    if (LoadLoweredModule(cache_path, module)) return absl::OkStatus();
+  }
+
   // Executes and collects results from the passes.
   mlir::StatusScopedDiagnosticHandler diag_handler(&context_);
 
@@ -151,6 +233,8 @@ Status DTensorMlirPassRunner::Run(mlir::ModuleOp module) {
   TF_RETURN_IF_ERROR(diag_handler.ConsumeStatus());
 
   if (logging_enabled_) pass_manager_.getContext()->enableMultithreading();
+
+  if (!cache_path.empty()) SaveLoweredModule(cache_path, module);
   return absl::OkStatus();
 }
 
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_DTENSOR_CC_DTENSOR_GRAPH_TO_MLIR_PASS_H_
 
 #include <memory>
+#include <string>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
@@ -42,15 +43,37 @@ class DTensorMlirPassRunner {
       Fprint128 cache_key);
 
   // Transforms input MLIR module with DTensor Pass pipeline.
+  //
+  // If DTENSOR_COMPILATION_CACHE_DIR is set, lowered modules are cached in
+  // that directory, keyed by a fingerprint of the input module and the
+  // pipeline. A module found in the cache replaces the contents of `module`
+  // without running the pipeline, so processes that trace the same functions
+  // skip layout propagation and SPMD expansion.
   Status Run(mlir::ModuleOp module);
 
  private:
+  // Returns the path under `cache_dir` of the cached lowering of `module`.
+  std::string CompilationCachePath(const std::string& cache_dir,
+                                   mlir::ModuleOp module);
+
+  // Replaces the contents of `module` with the module cached at `path`.
+  // Returns false if there is no usable module at `path`.
+  bool LoadLoweredModule(const std::string& path, mlir::ModuleOp module);
+
+  // Caches the lowered `module` at `path`. Failures are logged, as the cache
+  // is only an optimization.
+  void SaveLoweredModule(const std::string& path, mlir::ModuleOp module);
+
   // N.B. op_registration_ must be initialized before context/pass-manager to
   // ensure DTensor operations are available during optimization passes.
   bool op_registration_ = mlir::TF::RegisterDTensorTFOps();
   mlir::MLIRContext context_;
   mlir::PassManager pass_manager_;
 
+  // The textual form of the pass pipeline, which is part of the key of cached
+  // lowered modules.
+  std::string pipeline_;
+
   bool logging_enabled_;
 };
 
@@ -182,5 +182,11 @@ bool EnableMultiDeviceMode() {
       "DTENSOR_ENABLE_MULTI_DEVICE_EXPANSION", false, &multi_device_mode);
   return status.ok() && multi_device_mode;
 }
+
+std::string CompilationCacheDir() {
+  char* cache_dir_str = std::getenv("DTENSOR_COMPILATION_CACHE_DIR");
+  if (cache_dir_str == nullptr) return "";
+  return cache_dir_str;
+}
 }  // namespace dtensor
 }  // namespace tensorflow
@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <string>
 
+#include <string>
+
 #include "absl/strings/string_view.h"
 
 namespace tensorflow {
@@ -86,6 +88,10 @@ int AllReduceCombineOptimizationTopologicalDistance();
 
 // Returns whether to perform multi-device expansion.
 bool EnableMultiDeviceMode();
+
+// Returns the directory in which modules lowered by the DTensor MLIR pipeline
+// are cached across processes, or an empty string if caching is disabled.
+std::string CompilationCacheDir();
 }  // namespace dtensor
 }  // namespace tensorflow
 
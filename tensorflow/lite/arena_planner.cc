@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdint>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <utility>
@@ -33,6 +34,8 @@ constexpr int32_t kLastActiveNodeUndefined =
     std::numeric_limits<int32_t>::max();
 constexpr int32_t kNodeNotAssigned = std::numeric_limits<int32_t>::max();
 constexpr int32_t kScalarTensorBytes = 4;
+// The number of plans calculated from scratch which are cached.
+constexpr size_t kMaxCachedPlans = 4;
 
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
                            std::unique_ptr<GraphInfo> graph_info,
@@ -211,6 +214,7 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
   nodes_to_tensors_.clear();
   nodes_to_tensors_.resize(
       std::max(graph_info_->num_execution_nodes(), (size_t)1), {});
+  cached_plans_.clear();
 
   // Keeps track of references to each tensor.
   refcounts_.assign(num_tensors, 0);
@@ -428,6 +432,39 @@ void ArenaPlanner::GetAllocInfo(size_t* arena_size,
   *arena_persist_size = persistent_arena_.GetBufferSize();
 }
 
+void ArenaPlanner::GetFreeNonPersistentMemory(int node, char** ptr,
+                                              size_t* size) const {
+  *ptr = nullptr;
+  *size = 0;
+  if (!has_nonpersistent_memory_) return;
+  // Allocations of tensors that are no longer on the arena are counted too,
+  // which can only make the region smaller.
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  size_t live_end = 0;
+  for (int i = 0; i < static_cast<int>(allocs_.size()); ++i) {
+    const ArenaAllocWithUsageInterval& alloc = allocs_[i];
+    if (tensors[i].allocation_type == kTfLiteArenaRwPersistent ||
+        alloc.size == 0 || alloc.first_node > node || alloc.last_node < node) {
+      continue;
+    }
+    live_end = std::max(live_end, alloc.offset + alloc.size);
+  }
+  const size_t start = (live_end + kDefaultArenaAlignment - 1) /
+                       kDefaultArenaAlignment * kDefaultArenaAlignment;
+  const size_t committed_size = arena_.GetCommittedSize();
+  if (start >= committed_size) return;
+  *ptr = reinterpret_cast<char*>(arena_.BasePointer()) + start;
+  *size = committed_size - start;
+}
+
+void ArenaPlanner::LendNonPersistentMemory(char* ptr, size_t size) {
+  arena_.BorrowBuffer(ptr, size);
+}
+
+size_t ArenaPlanner::GetRequiredNonPersistentMemory() const {
+  return arena_.GetRequiredSize();
+}
+
 TfLiteStatus ArenaPlanner::Commit(bool* reallocated) {
   bool arena_reallocated, persistent_arena_reallocated;
   TF_LITE_ENSURE_STATUS(arena_.Commit(&arena_reallocated));
@@ -509,6 +546,18 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
     last_active_node_ = last_node;
     return kTfLiteOk;
   }
+  // Only plans calculated from scratch, i.e. after ResetAllocations(), are
+  // cached. They don't depend on earlier allocations.
+  const bool from_scratch = last_active_node_ == kLastActiveNodeUndefined;
+  std::vector<size_t> plan_key;
+  if (from_scratch) {
+    plan_key = GetPlanKey(first_node, last_node, tensors_to_allocate);
+    if (RestoreCachedPlan(plan_key, tensors_allocated)) {
+      last_active_node_ = last_node;
+      return kTfLiteOk;
+    }
+  }
+  std::vector<int32_t> unshared_tensors;
   if (first_node < last_active_node_) {
     arena_.ResetAllocs();
     last_active_node_ = first_node;
@@ -534,6 +583,7 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
           tensors[it->second].allocation_type;
       if (allocation_type != kTfLiteArenaRw ||
           tensors[it->second].bytes != tensors[it->first].bytes) {
+        unshared_tensors.push_back(it->first);
         actual_tensor_id_.erase(it);
       } else {
         // Don't allocate the tensor, it can safely share the input buffer.
@@ -560,9 +610,77 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
     }
   }
   last_active_node_ = last_node;
+  if (from_scratch) {
+    CachedPlan plan;
+    plan.key = std::move(plan_key);
+    plan.tensors_allocated = *tensors_allocated;
+    plan.allocs.reserve(tensors_allocated->size());
+    for (const auto& tensor_index : *tensors_allocated) {
+      plan.allocs.push_back(allocs_[tensor_index]);
+    }
+    plan.unshared_tensors = std::move(unshared_tensors);
+    cached_plans_.push_front(std::move(plan));
+    if (cached_plans_.size() > kMaxCachedPlans) cached_plans_.pop_back();
+  }
   return kTfLiteOk;
 }
 
+std::vector<size_t> ArenaPlanner::GetPlanKey(
+    int first_node, int last_node, std::vector<int32_t> tensors_to_allocate) {
+  // The order of `tensors_to_allocate` depends on hashing.
+  std::sort(tensors_to_allocate.begin(), tensors_to_allocate.end());
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  std::vector<size_t> key = {static_cast<size_t>(first_node),
+                             static_cast<size_t>(last_node)};
+  key.reserve(2 + 6 * tensors_to_allocate.size());
+  for (const auto& tensor_index : tensors_to_allocate) {
+    const TfLiteTensor& tensor = tensors[tensor_index];
+    const int root_index = FindSharedTensor(tensor_index);
+    const TfLiteTensor& root = tensors[root_index];
+    key.insert(key.end(), {static_cast<size_t>(tensor_index),
+                           static_cast<size_t>(tensor.allocation_type),
+                           tensor.bytes,
+                           static_cast<size_t>(alloc_node_[tensor_index]),
+                           static_cast<size_t>(dealloc_node_[tensor_index]),
+                           static_cast<size_t>(root_index)});
+    if (root_index != tensor_index) {
+      key.insert(key.end(),
+                 {static_cast<size_t>(root.allocation_type), root.bytes});
+    }
+  }
+  return key;
+}
+
+bool ArenaPlanner::RestoreCachedPlan(const std::vector<size_t>& key,
+                                     std::vector<int32_t>* tensors_allocated) {
+  auto plan = std::find_if(
+      cached_plans_.begin(), cached_plans_.end(),
+      [&key](const CachedPlan& cached) { return cached.key == key; });
+  if (plan == cached_plans_.end()) return false;
+  cached_plans_.splice(cached_plans_.begin(), cached_plans_, plan);
+
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  std::vector<ArenaAllocWithUsageInterval> arena_allocs;
+  std::vector<ArenaAllocWithUsageInterval> persistent_allocs;
+  for (int i = 0; i < static_cast<int>(plan->tensors_allocated.size()); ++i) {
+    const int tensor_index = plan->tensors_allocated[i];
+    allocs_[tensor_index] = plan->allocs[i];
+    if (tensors[tensor_index].allocation_type == kTfLiteArenaRw) {
+      arena_allocs.push_back(plan->allocs[i]);
+    } else if (tensors[tensor_index].allocation_type ==
+               kTfLiteArenaRwPersistent) {
+      persistent_allocs.push_back(plan->allocs[i]);
+    }
+  }
+  arena_.RestoreAllocs(arena_allocs);
+  persistent_arena_.RestoreAllocs(persistent_allocs);
+  for (const auto& tensor_index : plan->unshared_tensors) {
+    actual_tensor_id_.erase(tensor_index);
+  }
+  *tensors_allocated = plan->tensors_allocated;
+  return true;
+}
+
 bool AreTensorsAllocatedInSameArena(int32_t root_tensor_index,
                                     int32_t tensor_index,
                                     const TfLiteTensor* tensors) {
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <cstddef>
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -45,6 +46,11 @@ constexpr const int kDefaultArenaAlignment = 64;
 // execution. Since dynamic tensors don't have sizes until after the
 // corresponding operation is executed, this class supports incremental
 // planning.
+//
+// Models whose inputs are resized between a few shapes, e.g. a handful of
+// sequence lengths, plan the same allocations over and over. The last few
+// plans calculated for the whole graph are therefore cached, keyed by the
+// sizes and lifetimes of the tensors, and reused when they match again.
 class ArenaPlanner : public MemoryPlanner {
  public:
   // Ownership of 'context' is not taken and it must remain util the
@@ -68,6 +74,10 @@ class ArenaPlanner : public MemoryPlanner {
   void DumpDebugInfo(const std::vector<int>& execution_plan) const override;
   void GetAllocInfo(size_t* arena_size,
                     size_t* arena_persist_size) const override;
+  void GetFreeNonPersistentMemory(int node, char** ptr,
+                                  size_t* size) const override;
+  void LendNonPersistentMemory(char* ptr, size_t size) override;
+  size_t GetRequiredNonPersistentMemory() const override;
 
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
@@ -120,6 +130,26 @@ class ArenaPlanner : public MemoryPlanner {
   // Return the index of the tensor owing `tensor_index's` buffer.
   int FindSharedTensor(int tensor_index);
 
+  // Returns everything the plan of `tensors_to_allocate` between `first_node`
+  // and `last_node` depends on, when planned from scratch.
+  std::vector<size_t> GetPlanKey(int first_node, int last_node,
+                                 std::vector<int32_t> tensors_to_allocate);
+
+  // A plan calculated from scratch by CalculateAllocations.
+  struct CachedPlan {
+    std::vector<size_t> key;
+    // The tensors allocated by the plan, in allocation order.
+    std::vector<int32_t> tensors_allocated;
+    // The allocations of `tensors_allocated`.
+    std::vector<ArenaAllocWithUsageInterval> allocs;
+    // Tensors which could no longer share the buffer of another tensor.
+    std::vector<int32_t> unshared_tensors;
+  };
+
+  // Restores the cached plan with `key`, if any. Returns false otherwise.
+  bool RestoreCachedPlan(const std::vector<size_t>& key,
+                         std::vector<int32_t>* tensors_allocated);
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -166,6 +196,9 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Store number of references to each tensor.
   std::vector<int> refcounts_;
+
+  // The last plans calculated from scratch, most recently used first.
+  std::list<CachedPlan> cached_plans_;
 };
 
 }  // namespace tflite
@@ -370,6 +370,44 @@ TEST_F(ArenaPlannerTest, AllocsCorrectlyReset) {
   EXPECT_EQ(GetOffset(1), 4);
 }
 
+TEST_F(ArenaPlannerTest, CachedPlanIsReusedForSameSizes) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  std::vector<TfLiteTensor>& tensors = *graph.tensors();
+  const std::vector<size_t> small_bytes = {4, 8, 12, 16, 20, 24};
+  for (int i = 0; i < 6; ++i) tensors[i].bytes = small_bytes[i];
+  Execute(0, graph.nodes().size() - 1);
+  std::vector<std::ptrdiff_t> small_offsets;
+  for (int i = 0; i < 6; ++i) small_offsets.push_back(GetOffset(i));
+  const size_t small_required = planner_->GetRequiredNonPersistentMemory();
+
+  // A larger tensor 2 moves the tensors allocated after it.
+  ResetAllocations();
+  tensors[2].bytes = 400;
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_NE(GetOffset(4), small_offsets[4]);
+  EXPECT_GT(planner_->GetRequiredNonPersistentMemory(), small_required);
+
+  // Back to the first sizes, the plan is the one calculated for them.
+  ResetAllocations();
+  tensors[2].bytes = small_bytes[2];
+  Execute(0, graph.nodes().size() - 1);
+  for (int i = 0; i < 6; ++i) EXPECT_EQ(GetOffset(i), small_offsets[i]);
+  EXPECT_EQ(planner_->GetRequiredNonPersistentMemory(), small_required);
+
+  // Allocating tensors incrementally after the restored plan still works.
+  ResetAllocationsAfter(0);
+  Execute(1, graph.nodes().size() - 1);
+  for (int i = 0; i < 6; ++i) EXPECT_EQ(GetOffset(i), small_offsets[i]);
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphInputsPreserved) {
   TestGraph graph({0, 1},
                   {
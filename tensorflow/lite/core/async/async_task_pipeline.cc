@@ -0,0 +1,143 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/async/async_task_pipeline.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#include "tensorflow/lite/core/async/async_signature_runner.h"
+#include "tensorflow/lite/core/c/c_api_types.h"
+
+namespace tflite {
+namespace async {
+
+AsyncTaskPipeline::AsyncTaskPipeline(AsyncSignatureRunner* runner,
+                                     const Options& options,
+                                     CompletionCallback on_complete)
+    : runner_(runner),
+      completion_order_(options.completion_order),
+      on_complete_(std::move(on_complete)),
+      slots_(std::max(1, options.max_in_flight)) {
+  for (Slot& slot : slots_) {
+    slot.task = runner_->CreateTask();
+  }
+  waiters_.reserve(slots_.size());
+  for (int i = 0; i < num_slots(); ++i) {
+    waiters_.emplace_back([this, i] { WaitLoop(i); });
+  }
+}
+
+AsyncTaskPipeline::~AsyncTaskPipeline() {
+  Drain();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  changed_.notify_all();
+  for (std::thread& waiter : waiters_) {
+    waiter.join();
+  }
+  for (Slot& slot : slots_) {
+    runner_->Finish(slot.task);
+  }
+}
+
+int AsyncTaskPipeline::AcquireSlot() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  int slot = -1;
+  if (completion_order_ == CompletionOrder::kSubmission) {
+    // The slots are used in turn, so the next one holds the oldest request.
+    slot = next_slot_;
+    changed_.wait(lock,
+                  [&] { return slots_[slot].state != SlotState::kInFlight; });
+  } else {
+    changed_.wait(lock, [&] {
+      for (int i = 0; i < num_slots(); ++i) {
+        if (slots_[i].state != SlotState::kInFlight) {
+          slot = i;
+          return true;
+        }
+      }
+      return false;
+    });
+  }
+  slots_[slot].state = SlotState::kAcquired;
+  return slot;
+}
+
+TfLiteStatus AsyncTaskPipeline::Submit(int slot, int64_t* request) {
+  if (slot < 0 || slot >= num_slots()) return kTfLiteError;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slots_[slot].state != SlotState::kAcquired) return kTfLiteError;
+  }
+  if (runner_->InvokeAsync(slots_[slot].task) != kTfLiteOk) {
+    // The task stays scheduled until waited for.
+    runner_->Wait(slots_[slot].task);
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_[slot].state = SlotState::kFree;
+    return kTfLiteError;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_[slot].state = SlotState::kInFlight;
+    slots_[slot].request = num_submitted_++;
+    if (request != nullptr) *request = slots_[slot].request;
+    next_slot_ = (slot + 1) % num_slots();
+  }
+  changed_.notify_all();
+  return kTfLiteOk;
+}
+
+TfLiteStatus AsyncTaskPipeline::Drain() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  changed_.wait(lock, [&] { return num_completed_ == num_submitted_; });
+  return std::exchange(status_, kTfLiteOk);
+}
+
+void AsyncTaskPipeline::WaitLoop(int slot) {
+  while (true) {
+    int64_t request;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      changed_.wait(lock, [&] {
+        return stopped_ || slots_[slot].state == SlotState::kInFlight;
+      });
+      if (stopped_) return;
+      request = slots_[slot].request;
+    }
+    // Only this thread waits for the task while it is in flight.
+    const TfLiteStatus status = runner_->Wait(slots_[slot].task);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (completion_order_ == CompletionOrder::kSubmission) {
+        changed_.wait(lock, [&] { return num_completed_ == request; });
+      }
+    }
+    if (on_complete_) on_complete_(request, slot, status);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (status != kTfLiteOk && status_ == kTfLiteOk) status_ = status;
+      ++num_completed_;
+      slots_[slot].state = SlotState::kFree;
+    }
+    changed_.notify_all();
+  }
+}
+
+}  // namespace async
+}  // namespace tflite
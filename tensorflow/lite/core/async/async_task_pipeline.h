@@ -0,0 +1,124 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_CORE_ASYNC_ASYNC_TASK_PIPELINE_H_
+#define TENSORFLOW_LITE_CORE_ASYNC_ASYNC_TASK_PIPELINE_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tensorflow/lite/core/async/async_signature_runner.h"
+#include "tensorflow/lite/core/async/c/types.h"
+#include "tensorflow/lite/core/c/c_api_types.h"
+
+namespace tflite {
+namespace async {
+
+// WARNING: Experimental interface, subject to change
+//
+// Keeps several executions of an AsyncSignatureRunner in flight, so that an
+// async backend can e.g. transfer the inputs of a request while it computes
+// the previous one.
+//
+// The pipeline owns one execution task per slot, with its own buffers and
+// synchronizations, set through `task(slot)`. Two slots whose tasks use
+// different registered buffers double buffer the I/O. A request runs in a
+// slot acquired with `AcquireSlot`, which blocks while all the slots are in
+// flight, and is scheduled with `Submit`. `on_complete` is called once the
+// request finished, from a thread of the pipeline, and the outputs of the
+// slot are valid until it is acquired again. With CompletionOrder::kFinish,
+// calls for different slots may be concurrent.
+//
+// `AcquireSlot` and `Submit` must be called from a single thread.
+class AsyncTaskPipeline {
+ public:
+  enum class CompletionOrder {
+    // Requests complete in the order they were submitted, a request which
+    // finished early waiting for the previous ones.
+    kSubmission,
+    // Requests complete as soon as they finish, and slots are reused in the
+    // order they become free.
+    kFinish,
+  };
+
+  struct Options {
+    // The number of slots, i.e. of requests in flight at most.
+    int max_in_flight = 2;
+    CompletionOrder completion_order = CompletionOrder::kSubmission;
+  };
+
+  // Called with the id of a request (in submission order, from 0), the slot
+  // it ran in and the status of its execution.
+  using CompletionCallback =
+      std::function<void(int64_t request, int slot, TfLiteStatus status)>;
+
+  // `runner` must be prepared and outlive the pipeline.
+  AsyncTaskPipeline(AsyncSignatureRunner* runner, const Options& options,
+                    CompletionCallback on_complete);
+  // Waits for the requests in flight, and finishes the tasks.
+  ~AsyncTaskPipeline();
+
+  AsyncTaskPipeline(const AsyncTaskPipeline&) = delete;
+  AsyncTaskPipeline& operator=(const AsyncTaskPipeline&) = delete;
+
+  int num_slots() const { return slots_.size(); }
+  // The task of `slot`, to set the buffers and synchronizations of its I/O.
+  TfLiteExecutionTask* task(int slot) { return slots_[slot].task; }
+
+  // Returns the slot of the next request, once its previous request
+  // completed.
+  int AcquireSlot();
+  // Schedules the next request in `slot`, which must have been acquired.
+  // If scheduling fails, returns the error and the slot must be acquired
+  // again.
+  TfLiteStatus Submit(int slot, int64_t* request = nullptr);
+  // Waits for all the submitted requests to complete. Returns the first
+  // error of their executions since the last call.
+  TfLiteStatus Drain();
+
+ private:
+  enum class SlotState { kFree, kAcquired, kInFlight };
+  struct Slot {
+    TfLiteExecutionTask* task = nullptr;
+    SlotState state = SlotState::kFree;
+    int64_t request = -1;
+  };
+
+  // Waits for the requests of `slot` and completes them, until stopped.
+  void WaitLoop(int slot);
+
+  AsyncSignatureRunner* const runner_;
+  const CompletionOrder completion_order_;
+  const CompletionCallback on_complete_;
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<Slot> slots_;
+  std::vector<std::thread> waiters_;
+  // The slot of the next request with CompletionOrder::kSubmission.
+  int next_slot_ = 0;
+  int64_t num_submitted_ = 0;
+  int64_t num_completed_ = 0;
+  TfLiteStatus status_ = kTfLiteOk;
+  bool stopped_ = false;
+};
+
+}  // namespace async
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_CORE_ASYNC_ASYNC_TASK_PIPELINE_H_
@@ -0,0 +1,190 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/async/async_task_pipeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/async/async_signature_runner.h"
+#include "tensorflow/lite/core/async/c/task.h"
+#include "tensorflow/lite/core/async/c/types.h"
+#include "tensorflow/lite/core/async/testing/mock_async_kernel.h"
+#include "tensorflow/lite/core/async/testing/test_backend.h"
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/interpreter_test_util.h"
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Return;
+using ::testing::UnorderedElementsAre;
+
+namespace tflite {
+namespace async {
+namespace {
+
+class AsyncTaskPipelineTest : public InterpreterTest {
+ protected:
+  void SetUp() override {
+    kernel_ =
+        std::make_unique<::testing::NiceMock<testing::MockAsyncKernel>>();
+    backend_ = std::make_unique<testing::TestBackend>(kernel_->kernel());
+
+    interpreter_ = std::make_unique<Interpreter>();
+    interpreter_->AddTensors(2);
+    interpreter_->SetInputs({0});
+    interpreter_->SetOutputs({1});
+    TfLiteQuantizationParams quant;
+    interpreter_->SetTensorParametersReadWrite(0, kTfLiteFloat32, "x", {3},
+                                               quant);
+    interpreter_->SetTensorParametersReadWrite(1, kTfLiteFloat32, "a", {3},
+                                               quant);
+    TfLiteRegistration* reg = ops::builtin::Register_ADD();
+    void* builtin_data_1 = malloc(sizeof(int));
+    interpreter_->AddNodeWithParameters({0, 0}, {1}, nullptr, 0, builtin_data_1,
+                                        reg);
+    interpreter_->ModifyGraphWithDelegate(backend_->get_delegate());
+    BuildSignature("serving_default", {{"input", 0}}, {{"output", 1}});
+    runner_ = interpreter_->GetAsyncSignatureRunner("serving_default");
+
+    // Requests whose input buffer is 0 take longer than the others.
+    ON_CALL(*kernel_, Eval(_, _, _)).WillByDefault([this](auto, auto, auto) {
+      const int in_flight = ++in_flight_;
+      int max_in_flight = max_in_flight_.load();
+      while (in_flight > max_in_flight &&
+             !max_in_flight_.compare_exchange_weak(max_in_flight, in_flight)) {
+      }
+      return kTfLiteOk;
+    });
+    ON_CALL(*kernel_, Wait(_, _))
+        .WillByDefault([this](auto, TfLiteExecutionTask* task) {
+          if (TfLiteExecutionTaskGetBufferByIndex(task, 0) == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+          }
+          --in_flight_;
+          return kTfLiteOk;
+        });
+  }
+
+  // Gives a buffer of its own to the input of each slot.
+  void SetSlotBuffers(AsyncTaskPipeline* pipeline) {
+    for (int slot = 0; slot < pipeline->num_slots(); ++slot) {
+      TfLiteExecutionTaskSetBuffer(pipeline->task(slot), kTfLiteIoTypeInput,
+                                   "input", slot);
+    }
+  }
+
+  AsyncTaskPipeline::CompletionCallback RecordCompletion() {
+    return [this](int64_t request, int slot, TfLiteStatus status) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      completed_.push_back(request);
+    };
+  }
+
+  std::unique_ptr<::testing::NiceMock<testing::MockAsyncKernel>> kernel_;
+  std::unique_ptr<testing::TestBackend> backend_;
+  AsyncSignatureRunner* runner_ = nullptr;
+  std::atomic<int> in_flight_ = 0;
+  std::atomic<int> max_in_flight_ = 0;
+  std::mutex mutex_;
+  std::vector<int64_t> completed_;
+};
+
+TEST_F(AsyncTaskPipelineTest, CompletesInSubmissionOrder) {
+  AsyncTaskPipeline pipeline(runner_, {/*max_in_flight=*/2},
+                             RecordCompletion());
+  SetSlotBuffers(&pipeline);
+  for (int i = 0; i < 4; ++i) {
+    const int slot = pipeline.AcquireSlot();
+    EXPECT_EQ(slot, i % 2);
+    int64_t request;
+    ASSERT_EQ(pipeline.Submit(slot, &request), kTfLiteOk);
+    EXPECT_EQ(request, i);
+  }
+  EXPECT_EQ(pipeline.Drain(), kTfLiteOk);
+  EXPECT_THAT(completed_, ElementsAre(0, 1, 2, 3));
+}
+
+TEST_F(AsyncTaskPipelineTest, CompletesAsFinished) {
+  AsyncTaskPipeline pipeline(
+      runner_,
+      {/*max_in_flight=*/2, AsyncTaskPipeline::CompletionOrder::kFinish},
+      RecordCompletion());
+  SetSlotBuffers(&pipeline);
+  // The first request is slow, so the second one completes first and its
+  // slot runs the third one.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(pipeline.Submit(pipeline.AcquireSlot()), kTfLiteOk);
+  }
+  EXPECT_EQ(pipeline.Drain(), kTfLiteOk);
+  ASSERT_THAT(completed_, UnorderedElementsAre(0, 1, 2));
+  EXPECT_EQ(completed_[0], 1);
+}
+
+TEST_F(AsyncTaskPipelineTest, BoundsRequestsInFlight) {
+  AsyncTaskPipeline pipeline(runner_, {/*max_in_flight=*/3},
+                             RecordCompletion());
+  SetSlotBuffers(&pipeline);
+  for (int i = 0; i < 9; ++i) {
+    ASSERT_EQ(pipeline.Submit(pipeline.AcquireSlot()), kTfLiteOk);
+  }
+  EXPECT_EQ(pipeline.Drain(), kTfLiteOk);
+  EXPECT_EQ(completed_.size(), size_t{9});
+  EXPECT_GT(max_in_flight_.load(), 1);
+  EXPECT_LE(max_in_flight_.load(), 3);
+}
+
+TEST_F(AsyncTaskPipelineTest, ReportsFailedExecutions) {
+  EXPECT_CALL(*kernel_, Wait(_, _))
+      .WillOnce(Return(kTfLiteError))
+      .WillRepeatedly(Return(kTfLiteOk));
+  AsyncTaskPipeline pipeline(runner_, {/*max_in_flight=*/2},
+                             RecordCompletion());
+  ASSERT_EQ(pipeline.Submit(pipeline.AcquireSlot()), kTfLiteOk);
+  ASSERT_EQ(pipeline.Submit(pipeline.AcquireSlot()), kTfLiteOk);
+  EXPECT_EQ(pipeline.Drain(), kTfLiteError);
+  EXPECT_EQ(pipeline.Drain(), kTfLiteOk);
+}
+
+TEST_F(AsyncTaskPipelineTest, FailedSubmissionFreesSlot) {
+  EXPECT_CALL(*kernel_, Eval(_, _, _))
+      .WillOnce(Return(kTfLiteError))
+      .WillRepeatedly(Return(kTfLiteOk));
+  AsyncTaskPipeline pipeline(runner_, {/*max_in_flight=*/2},
+                             RecordCompletion());
+  const int slot = pipeline.AcquireSlot();
+  EXPECT_EQ(pipeline.Submit(slot), kTfLiteError);
+  // Submitting requires acquiring the slot again.
+  EXPECT_EQ(pipeline.Submit(slot), kTfLiteError);
+  EXPECT_EQ(pipeline.AcquireSlot(), slot);
+  int64_t request;
+  ASSERT_EQ(pipeline.Submit(slot, &request), kTfLiteOk);
+  EXPECT_EQ(request, 0);
+  EXPECT_EQ(pipeline.Drain(), kTfLiteOk);
+}
+
+}  // namespace
+}  // namespace async
+}  // namespace tflite
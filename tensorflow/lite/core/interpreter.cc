@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/signature_runner.h"
 #include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/cpu_backend_scheduler.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/internal/signature_def.h"
 #include "tensorflow/lite/interpreter_options.h"
@@ -239,6 +240,9 @@ TfLiteStatus Interpreter::Invoke() {
   // platforms like x86, therefore, we suppress denormals here to prevent this
   // from happening.
   ruy::ScopedSuppressDenormals suppress_denormals;
+  ScopedCpuBackendLease cpu_backend_lease(
+      primary_subgraph().cpu_backend_scheduler_,
+      primary_subgraph().cpu_backend_priority_, context_);
 
   TF_LITE_ENSURE_STATUS_WITH_SCOPED_INSTRUMENTATION(
       scoped_runtime_event, primary_subgraph().Invoke());
@@ -48,6 +48,7 @@ limitations under the License.
 #include "tensorflow/lite/core/c/common.h"  // IWYU pragma: export
 #include "tensorflow/lite/core/signature_runner.h"
 #include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/cpu_backend_scheduler.h"
 #include "tensorflow/lite/experimental/resource/initialization_status.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
@@ -560,6 +561,19 @@ class Interpreter {
   /// non-null, remains owned by the caller.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  /// \warning This is an experimental API and subject to change. \n
+  /// \brief Makes every `Invoke` (of the interpreter or of its signature
+  /// runners) lease the threads of the CPU kernels from `scheduler`, so that
+  /// interpreters sharing it don't use more threads than it has. At most
+  /// the number of threads set by `SetNumThreads` is leased, and fewer if other
+  /// interpreters are running; `priority` (at least 1) weighs the share of the
+  /// interpreter and orders the ones waiting for a thread. Passing nullptr
+  /// stops leasing. `scheduler` is not owned and must outlive the interpreter.
+  ///
+  /// NOTE: Delegates, e.g. XNNPack, keep using their own threads.
+  void SetCpuBackendScheduler(CpuBackendScheduler* scheduler,
+                              int priority = 1);
+
   /// \warning This is an experimental API and subject to change. \n
   /// \brief  Attempts to cancel in flight invocation if any.
   /// This will not affect `Invoke`s that happends after the cancellation.
@@ -446,16 +446,26 @@ TfLiteStatus InterpreterBuilder::ParseQuantization(
   }
 
   // Ensure that the number of scales is 1 for per-layer quantization, and
-  // matches number of quantization dimensions for per-axis quantization.
-  if (num_scales != 1 &&
-      (!dims.empty() &&
-       num_scales != dims[src_quantization->quantized_dimension()])) {
-    TF_LITE_REPORT_ERROR(
-        error_reporter_,
-        "num_scales must be 1 for per-layer quantization, or %d for per-axis "
-        "quantization, but got %d.",
-        dims[src_quantization->quantized_dimension()], num_scales);
-    return kTfLiteError;
+  // matches number of quantization dimensions for per-axis quantization. A
+  // multiple of it is per-axis quantization with groups along the last
+  // dimension, which must divide it.
+  if (num_scales != 1 && !dims.empty()) {
+    const int quantized_dimension = src_quantization->quantized_dimension();
+    const int channels = dims[quantized_dimension];
+    const int scales = static_cast<int>(num_scales);
+    const int groups = channels > 0 ? scales / channels : 0;
+    const bool is_grouped =
+        quantized_dimension + 1 < static_cast<int>(dims.size()) &&
+        groups > 1 && scales % channels == 0 && dims.back() % groups == 0;
+    if (scales != channels && !is_grouped) {
+      TF_LITE_REPORT_ERROR(
+          error_reporter_,
+          "num_scales must be 1 for per-layer quantization, or %d times a "
+          "divisor of the last dimension for per-axis quantization, but got "
+          "%d.",
+          channels, scales);
+      return kTfLiteError;
+    }
   }
 
   // Affine-quantization.
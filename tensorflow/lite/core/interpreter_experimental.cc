@@ -68,6 +68,14 @@ void Interpreter::SetCancellationFunction(void* data,
   }
 }
 
+void Interpreter::SetCpuBackendScheduler(CpuBackendScheduler* scheduler,
+                                         int priority) {
+  for (auto& subgraph : subgraphs_) {
+    subgraph->cpu_backend_scheduler_ = scheduler;
+    subgraph->cpu_backend_priority_ = priority;
+  }
+}
+
 bool Interpreter::IsCancelled() { return primary_subgraph().IsCancelled(); }
 
 TfLiteStatus Interpreter::ModifyGraphWithDelegate(TfLiteDelegate* delegate) {
@@ -0,0 +1,91 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/node_thread_pool.h"
+
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+
+namespace tflite {
+namespace {
+
+// The pool and worker index of the calling thread, if it is a worker.
+thread_local const NodeThreadPool* current_pool = nullptr;
+thread_local int current_worker = -1;
+
+}  // namespace
+
+NodeThreadPool::NodeThreadPool(int num_threads) {
+  for (int i = 0; i + 1 < num_threads; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+NodeThreadPool::~NodeThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+void NodeThreadPool::Run(int count, const std::function<void(int)>& task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    count_ = count;
+    next_task_ = 0;
+    busy_workers_ = num_workers();
+    ++generation_;
+  }
+  work_cv_.notify_all();
+  RunTasks();
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+  task_ = nullptr;
+}
+
+int NodeThreadPool::CurrentWorker() const {
+  return current_pool == this ? current_worker : -1;
+}
+
+void NodeThreadPool::WorkerLoop(int worker) {
+  current_pool = this;
+  current_worker = worker;
+  int seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock,
+                    [&] { return stop_ || generation_ != seen_generation; });
+      if (stop_) return;
+      seen_generation = generation_;
+    }
+    RunTasks();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --busy_workers_;
+    }
+    done_cv_.notify_one();
+  }
+}
+
+void NodeThreadPool::RunTasks() {
+  for (int i = next_task_++; i < count_; i = next_task_++) {
+    (*task_)(i);
+  }
+}
+
+}  // namespace tflite
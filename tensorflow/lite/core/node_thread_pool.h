@@ -0,0 +1,72 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_CORE_NODE_THREAD_POOL_H_
+#define TENSORFLOW_LITE_CORE_NODE_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace tflite {
+
+// A fixed set of threads that a subgraph runs independent nodes on. The
+// calling thread takes part in the work, so a pool of `num_threads` threads
+// has `num_threads - 1` workers.
+class NodeThreadPool {
+ public:
+  explicit NodeThreadPool(int num_threads);
+  ~NodeThreadPool();
+
+  NodeThreadPool(const NodeThreadPool&) = delete;
+  NodeThreadPool& operator=(const NodeThreadPool&) = delete;
+
+  int num_workers() const { return static_cast<int>(workers_.size()); }
+
+  // Runs `task(i)` for i in [0, count), spread over the workers and the
+  // calling thread, and returns when all are done. Must not be called
+  // concurrently, nor from a task.
+  void Run(int count, const std::function<void(int)>& task);
+
+  // Returns the index in [0, num_workers()) of the calling thread if it is a
+  // worker of this pool, and -1 otherwise.
+  int CurrentWorker() const;
+
+ private:
+  void WorkerLoop(int worker);
+  // Runs tasks until none are left.
+  void RunTasks();
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  // Incremented for each Run(), which workers wait for.
+  int generation_ = 0;
+  // Number of workers that did not finish the tasks of the current Run().
+  int busy_workers_ = 0;
+  bool stop_ = false;
+
+  const std::function<void(int)>* task_ = nullptr;
+  int count_ = 0;
+  std::atomic<int> next_task_{0};
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_CORE_NODE_THREAD_POOL_H_
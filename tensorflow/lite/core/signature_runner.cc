@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/cpu_backend_scheduler.h"
 #include "tensorflow/lite/internal/signature_def.h"
 
 namespace tflite {
@@ -106,6 +107,9 @@ TfLiteStatus SignatureRunner::Invoke() {
   if (subgraph_->continue_invocation_)
     (void)subgraph_->continue_invocation_->test_and_set();
 
+  ScopedCpuBackendLease cpu_backend_lease(subgraph_->cpu_backend_scheduler_,
+                                          subgraph_->cpu_backend_priority_,
+                                          subgraph_->context());
   TF_LITE_ENSURE_STATUS(subgraph_->Invoke());
 
   // Makes sure output tensors are readable.
@@ -618,6 +618,10 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  if (type == kTfLiteCpuBackendContext && node_thread_pool_ != nullptr) {
+    const int worker = node_thread_pool_->CurrentWorker();
+    if (worker >= 0) return worker_cpu_backend_contexts_[worker].get();
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -1251,6 +1255,232 @@ TfLiteStatus Subgraph::ReleaseNonPersistentMemory() {
   return kTfLiteOk;
 }
 
+namespace {
+
+// Tensors a node reads and writes, and the memory they occupy.
+struct NodeAccesses {
+  std::vector<int> reads;
+  std::vector<int> writes;
+  std::vector<std::pair<const char*, const char*>> read_ranges;
+  std::vector<std::pair<const char*, const char*>> write_ranges;
+};
+
+void AddAccess(const TfLiteTensor* tensors, const TfLiteIntArray* indices,
+               std::vector<int>* accessed,
+               std::vector<std::pair<const char*, const char*>>* ranges) {
+  for (int index : TfLiteIntArrayView(indices)) {
+    if (index == kTfLiteOptionalTensor) continue;
+    accessed->push_back(index);
+    const TfLiteTensor& tensor = tensors[index];
+    if (tensor.data.raw != nullptr && tensor.bytes > 0) {
+      ranges->emplace_back(tensor.data.raw, tensor.data.raw + tensor.bytes);
+    }
+  }
+}
+
+NodeAccesses GetNodeAccesses(const TfLiteTensor* tensors,
+                             const TfLiteNode& node) {
+  NodeAccesses accesses;
+  AddAccess(tensors, node.inputs, &accesses.reads, &accesses.read_ranges);
+  AddAccess(tensors, node.outputs, &accesses.writes, &accesses.write_ranges);
+  AddAccess(tensors, node.temporaries, &accesses.writes,
+            &accesses.write_ranges);
+  if (node.intermediates != nullptr) {
+    AddAccess(tensors, node.intermediates, &accesses.writes,
+              &accesses.write_ranges);
+  }
+  return accesses;
+}
+
+bool Intersect(const std::vector<int>& a, const std::vector<int>& b) {
+  for (int x : a) {
+    if (std::find(b.begin(), b.end(), x) != b.end()) return true;
+  }
+  return false;
+}
+
+bool Overlap(const std::vector<std::pair<const char*, const char*>>& a,
+             const std::vector<std::pair<const char*, const char*>>& b) {
+  for (const auto& x : a) {
+    for (const auto& y : b) {
+      if (x.first < y.second && y.first < x.second) return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if nodes accessing `a` and `b` can't run concurrently.
+bool Conflict(const NodeAccesses& a, const NodeAccesses& b) {
+  return Intersect(a.writes, b.reads) || Intersect(a.writes, b.writes) ||
+         Intersect(a.reads, b.writes) ||
+         Overlap(a.write_ranges, b.read_ranges) ||
+         Overlap(a.write_ranges, b.write_ranges) ||
+         Overlap(a.read_ranges, b.write_ranges);
+}
+
+// Number of later nodes of the execution plan that are considered for
+// running concurrently with a node.
+constexpr int kConcurrentNodesWindow = 64;
+
+}  // namespace
+
+bool Subgraph::CanInvokeConcurrently(
+    const TfLiteNode& node, const TfLiteRegistration& registration) const {
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinCustom:
+    case kTfLiteBuiltinDelegate:
+    case kTfLiteBuiltinIf:
+    case kTfLiteBuiltinWhile:
+    case kTfLiteBuiltinCallOnce:
+    case kTfLiteBuiltinStablehloComposite:
+      return false;
+    default:
+      break;
+  }
+  if (node.delegate != nullptr || (registration.registration_external &&
+                                   registration.registration_external
+                                           ->node_index == -1)) {
+    return false;
+  }
+  auto is_plain = [](const TfLiteTensor& tensor) {
+    return tensor.type != kTfLiteResource && tensor.type != kTfLiteVariant &&
+           tensor.type != kTfLiteString && !tensor.is_variable;
+  };
+  for (int index : TfLiteIntArrayView(node.inputs)) {
+    if (index == kTfLiteOptionalTensor) continue;
+    const TfLiteTensor& tensor = context_.tensors[index];
+    if (!is_plain(tensor) || (tensor.data.raw == nullptr && tensor.bytes > 0)) {
+      return false;
+    }
+  }
+  for (const TfLiteIntArray* indices : {node.outputs, node.temporaries}) {
+    for (int index : TfLiteIntArrayView(indices)) {
+      if (index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor& tensor = context_.tensors[index];
+      if (!is_plain(tensor) || tensor.allocation_type == kTfLiteDynamic) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+TfLiteStatus Subgraph::MaybeInvokeConcurrently(int execution_plan_index,
+                                               bool* invoked) {
+  *invoked = false;
+  const int num_threads = options_ ? options_->GetInterOpNumThreads() : 0;
+  if (num_threads < 2 || profiler_) return kTfLiteOk;
+
+  // Scans the prepared nodes in plan order, up to the first that can't run
+  // concurrently, and picks those that conflict with no earlier node that is
+  // yet to run.
+  const int end = std::min<int>(
+      {static_cast<int>(execution_plan_.size()),
+       next_execution_plan_index_to_prepare_,
+       execution_plan_index + kConcurrentNodesWindow});
+  std::vector<int> picked;
+  std::vector<NodeAccesses> pending;
+  for (int i = execution_plan_index;
+       i < end && static_cast<int>(picked.size()) < num_threads; ++i) {
+    if (invoked_ahead_[i]) continue;
+    const auto& node_and_registration =
+        nodes_and_registration_[execution_plan_[i]];
+    if (!CanInvokeConcurrently(node_and_registration.first,
+                               node_and_registration.second)) {
+      break;
+    }
+    NodeAccesses accesses =
+        GetNodeAccesses(context_.tensors, node_and_registration.first);
+    const bool conflict =
+        std::any_of(pending.begin(), pending.end(),
+                    [&](const NodeAccesses& earlier) {
+                      return Conflict(earlier, accesses);
+                    });
+    pending.push_back(std::move(accesses));
+    if (!conflict) picked.push_back(i);
+  }
+  if (picked.size() < 2) return kTfLiteOk;
+
+  if (node_thread_pool_ == nullptr ||
+      node_thread_pool_->num_workers() != num_threads - 1) {
+    node_thread_pool_ = std::make_unique<NodeThreadPool>(num_threads);
+    worker_cpu_backend_contexts_.clear();
+    for (int i = 0; i < num_threads - 1; ++i) {
+      worker_cpu_backend_contexts_.push_back(
+          std::make_unique<ExternalCpuBackendContext>());
+    }
+  }
+  std::vector<TfLiteStatus> statuses(picked.size(), kTfLiteOk);
+  node_thread_pool_->Run(static_cast<int>(picked.size()), [&](int i) {
+    const int node_index = execution_plan_[picked[i]];
+    statuses[i] = OpInvoke(nodes_and_registration_[node_index].second,
+                           &nodes_and_registration_[node_index].first);
+    // Kernels on workers run single threaded, the parallelism comes from
+    // running several of them.
+    const int worker = node_thread_pool_->CurrentWorker();
+    if (worker >= 0) {
+      TfLiteInternalBackendContext* backend_context =
+          worker_cpu_backend_contexts_[worker]->internal_backend_context();
+      if (backend_context != nullptr) backend_context->SetMaxNumThreads(1);
+    }
+  });
+
+  for (int i = 0; i < static_cast<int>(picked.size()); ++i) {
+    invoked_ahead_[picked[i]] = true;
+    if (statuses[i] != kTfLiteOk) {
+      const int node_index = execution_plan_[picked[i]];
+      auto err = ReportOpError(&context_,
+                               nodes_and_registration_[node_index].first,
+                               nodes_and_registration_[node_index].second,
+                               node_index, "failed to invoke");
+      return statuses[i] == kTfLiteCancelled ? statuses[i] : err;
+    }
+  }
+  *invoked = true;
+  return kTfLiteOk;
+}
+
+void Subgraph::LendFreeArenaTo(const std::vector<Subgraph*>& callees) {
+  if (!ShouldShareSubgraphArenas() || !memory_planner_ ||
+      invoking_execution_plan_index_ < 0) {
+    return;
+  }
+  char* ptr;
+  size_t size;
+  memory_planner_->GetFreeNonPersistentMemory(invoking_execution_plan_index_,
+                                              &ptr, &size);
+  for (int i = 0; i < static_cast<int>(callees.size()); ++i) {
+    Subgraph* callee = callees[i];
+    if (!callee->memory_planner_ ||
+        callee->memory_planner_->HasNonPersistentMemory()) {
+      continue;
+    }
+    size_t share = size;
+    if (i + 1 < static_cast<int>(callees.size())) {
+      const size_t required =
+          callee->memory_planner_->GetRequiredNonPersistentMemory();
+      share = std::min(size, (required + kDefaultArenaAlignment - 1) /
+                                 kDefaultArenaAlignment *
+                                 kDefaultArenaAlignment);
+    }
+    callee->memory_planner_->LendNonPersistentMemory(ptr, share);
+    arena_borrowers_.push_back(callee);
+    if (ptr != nullptr) ptr += share;
+    size -= share;
+  }
+}
+
+void Subgraph::EndArenaLoans() {
+  for (Subgraph* callee : arena_borrowers_) {
+    // Control flow ops release the memory of the subgraphs they ran, unless
+    // they failed.
+    if (callee->memory_planner_->HasNonPersistentMemory()) {
+      callee->ReleaseMemory();
+    }
+  }
+  arena_borrowers_.clear();
+}
+
 TfLiteStatus Subgraph::ReleaseMemory() {
   state_ = kStateUninvokable;
   ReleaseNonPersistentMemory();
@@ -1640,10 +1870,12 @@ TfLiteStatus Subgraph::InvokeImpl() {
       tflite::OnTfLiteSubgraphInvoke(name_.c_str(), subgraph_index_);
 #endif  // TF_LITE_TENSORFLOW_PROFILER
 
-  // Invocations are always done in node order.
+  // Invocations are always done in node order, except for independent nodes
+  // that MaybeInvokeConcurrently() runs ahead of their turn.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
   // called.
+  invoked_ahead_.assign(execution_plan_.size(), false);
   for (int execution_plan_index = 0;
        execution_plan_index < execution_plan_.size(); execution_plan_index++) {
     if (execution_plan_index == next_execution_plan_index_to_prepare_) {
@@ -1655,6 +1887,10 @@ TfLiteStatus Subgraph::InvokeImpl() {
     TfLiteNode& node = nodes_and_registration_[node_index].first;
     const TfLiteRegistration& registration =
         nodes_and_registration_[node_index].second;
+    if (invoked_ahead_[execution_plan_index]) {
+      MaybeReleaseDynamicTensors(node, node_index);
+      continue;
+    }
 
     const char* op_name = nullptr;
     if (profiler_) op_name = GetTFLiteOpName(registration);
@@ -1722,8 +1958,23 @@ TfLiteStatus Subgraph::InvokeImpl() {
     }
 
     EnsureTensorsVectorCapacity();
+    bool invoked_concurrently = false;
+    TF_LITE_ENSURE_STATUS(
+        MaybeInvokeConcurrently(execution_plan_index, &invoked_concurrently));
+    if (invoked_concurrently) {
+      MaybeReleaseDynamicTensors(node, node_index);
+#ifdef TF_LITE_TENSORFLOW_PROFILER
+      tflite::OnTfLiteOpInvokeEnd(trace_op);
+#endif  // TF_LITE_TENSORFLOW_PROFILER
+      continue;
+    }
+
     tensor_resized_since_op_invoke_ = false;
-    if (auto s = OpInvoke(registration, &node); s != kTfLiteOk) {
+    invoking_execution_plan_index_ = execution_plan_index;
+    auto s = OpInvoke(registration, &node);
+    invoking_execution_plan_index_ = -1;
+    EndArenaLoans();
+    if (s != kTfLiteOk) {
       auto err = ReportOpError(&context_, node, registration, node_index,
                                "failed to invoke");
       return s == kTfLiteCancelled ? s : err;
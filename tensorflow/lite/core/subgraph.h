@@ -37,8 +37,11 @@ limitations under the License.
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/core/macros.h"
+#include "tensorflow/lite/core/node_thread_pool.h"
+#include "tensorflow/lite/cpu_backend_scheduler.h"
 #include "tensorflow/lite/experimental/resource/initialization_status.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/interpreter_options.h"
 #include "tensorflow/lite/memory_planner.h"
@@ -287,6 +290,16 @@ class Subgraph {
   // AllocateTensors needs to be called before next invocation.
   TfLiteStatus ReleaseMemory();
 
+  // WARNING: Experimental interface, subject to change
+  // Lends `callees`, which the node being invoked runs, disjoint parts of the
+  // part of this subgraph's non-persistent arena that no tensor live at the
+  // node uses, to place their non-persistent tensors in as far as they fit.
+  // All but the last callee get as much as their last memory plan needed. Only
+  // callees whose memory is released are lent memory, and the loans end when
+  // the node returns, releasing the callees' memory if the node did not. Does
+  // nothing unless the interpreter options enable shared subgraph arenas.
+  void LendFreeArenaTo(const std::vector<Subgraph*>& callees);
+
   // Update allocations for all tensors. This will redim dependent tensors using
   // the input tensor dimensionality as given. This is relatively expensive.
   // If you know that your sizes are not changing, you need not call this.
@@ -459,6 +472,14 @@ class Subgraph {
     return (options_ && options_->GetPreserveAllTensors());
   }
 
+  // WARNING: This is an experimental API and subject to change.
+  // True if control flow subgraphs should borrow the free arena of their
+  // caller.
+  bool ShouldShareSubgraphArenas() const {
+    return (options_ && options_->GetShareSubgraphArenas() &&
+            !options_->GetPreserveAllTensors());
+  }
+
   // WARNING: This is an experimental API and subject to change.
   // True if all intermediate dynamic tensors should be released once they are
   // not used by the model.
@@ -948,6 +969,23 @@ class Subgraph {
   // tensors if configured.
   void MaybeReleaseDynamicTensors(const TfLiteNode& node, size_t node_index);
 
+  // Ends the loans made by LendFreeArenaTo() for the node that was invoked.
+  void EndArenaLoans();
+
+  // Returns true if `node` may run concurrently with other nodes, i.e. it has
+  // no effects besides writing its outputs and temporaries, which are not
+  // dynamic, and all its inputs have data.
+  bool CanInvokeConcurrently(const TfLiteNode& node,
+                             const TfLiteRegistration& registration) const;
+
+  // If the interpreter options set more than one inter-op thread, invokes
+  // the node at `execution_plan_index` concurrently with the later prepared
+  // nodes that depend neither on it nor on any node left out in between, and
+  // whose tensors don't share memory with theirs. Sets `invoked` if it did,
+  // which it only does for at least two nodes.
+  TfLiteStatus MaybeInvokeConcurrently(int execution_plan_index,
+                                       bool* invoked);
+
   // Set the buffer handle to a tensor.
   // The method is used to implement Interpreter::SetBufferHandle and
   // SignatureRunner::SetInputBufferHandle/SetOutputBufferHandle APIs.
@@ -1096,6 +1134,23 @@ class Subgraph {
   // trigger downstream reallocation after op invocation.
   bool tensor_resized_since_op_invoke_ = false;
 
+  // Index in the execution plan of the node being invoked, or -1.
+  int invoking_execution_plan_index_ = -1;
+
+  // Subgraphs lent memory by LendFreeArenaTo() for the node being invoked.
+  std::vector<Subgraph*> arena_borrowers_;
+
+  // Threads that MaybeInvokeConcurrently() runs nodes on, created when first
+  // needed, and the CPU backend context of each worker, so that kernels on
+  // different threads don't share one.
+  std::unique_ptr<NodeThreadPool> node_thread_pool_;
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      worker_cpu_backend_contexts_;
+
+  // Whether each node of the execution plan was already invoked by
+  // MaybeInvokeConcurrently() in the current invocation.
+  std::vector<bool> invoked_ahead_;
+
   // Profiler for this interpreter instance.
   std::unique_ptr<SubgraphAwareProfiler> profiler_;
 
@@ -1133,6 +1188,11 @@ class Subgraph {
   // `check_cancelled_func_`.
   void* cancellation_data_ = nullptr;
 
+  // The scheduler the threads of the CPU backend are leased from when the
+  // interpreter or a signature runner invokes the subgraph, if any. Not owned.
+  CpuBackendScheduler* cpu_backend_scheduler_ = nullptr;
+  int cpu_backend_priority_ = 1;
+
   // A map of resources. Owned by interpreter and shared by multiple subgraphs.
   resource::ResourceMap* resources_ = nullptr;
 
@@ -27,6 +27,7 @@ limitations under the License.
 #include "absl/log/check.h"
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/interpreter_options.h"
 #include "tensorflow/lite/stderr_reporter.h"
 #include "tensorflow/lite/util.h"
 
@@ -124,6 +125,43 @@ TEST(MarkSubgraphAsDelegationSkippable, MarkSubgraphAsDelegationSkippable) {
   ASSERT_TRUE(subgraphs[1]->IsDelegationSkippable());
 }
 
+TEST(InvokeConcurrently, IndependentBranches) {
+  Interpreter interpreter;
+  auto& subgraph = interpreter.primary_subgraph();
+  subgraph.AddTensors(6);
+  subgraph.SetInputs({0, 1});
+  subgraph.SetOutputs({4, 5});
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_EQ(subgraph.SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, "", {3}, TfLiteQuantization()),
+              kTfLiteOk);
+  }
+  // Two chains of two NEG ops that don't depend on each other.
+  TfLiteRegistration* neg_op = tflite::ops::builtin::Register_NEG();
+  subgraph.AddNodeWithParameters({0}, {2}, {}, nullptr, 0, nullptr, neg_op);
+  subgraph.AddNodeWithParameters({1}, {3}, {}, nullptr, 0, nullptr, neg_op);
+  subgraph.AddNodeWithParameters({2}, {4}, {}, nullptr, 0, nullptr, neg_op);
+  subgraph.AddNodeWithParameters({3}, {5}, {}, nullptr, 0, nullptr, neg_op);
+
+  InterpreterOptions options;
+  options.SetInterOpNumThreads(2);
+  ASSERT_EQ(interpreter.ApplyOptions(&options), kTfLiteOk);
+  ASSERT_EQ(subgraph.AllocateTensors(), kTfLiteOk);
+  for (int run = 0; run < 3; ++run) {
+    float* input0 = subgraph.tensor(0)->data.f;
+    float* input1 = subgraph.tensor(1)->data.f;
+    for (int i = 0; i < 3; ++i) {
+      input0[i] = i + run;
+      input1[i] = -i * run;
+    }
+    ASSERT_EQ(subgraph.Invoke(), kTfLiteOk);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(subgraph.tensor(4)->data.f[i], input0[i]);
+      EXPECT_EQ(subgraph.tensor(5)->data.f[i], input1[i]);
+    }
+  }
+}
+
 // Helper to get the minimal buffer size to allocate for a buffer of given
 // shape.
 size_t BytesFor(const TfLiteType type, const int* const data,
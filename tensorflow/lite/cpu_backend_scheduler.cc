@@ -0,0 +1,96 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/cpu_backend_scheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+
+namespace tflite {
+
+CpuBackendScheduler::Lease::~Lease() {
+  if (scheduler_) scheduler_->Release(num_threads_, priority_);
+}
+
+CpuBackendScheduler::CpuBackendScheduler(int num_threads)
+    : num_threads_(std::max(num_threads, 1)), free_threads_(num_threads_) {}
+
+CpuBackendScheduler* CpuBackendScheduler::Global() {
+  static CpuBackendScheduler* scheduler = new CpuBackendScheduler(
+      static_cast<int>(std::thread::hardware_concurrency()));
+  return scheduler;
+}
+
+CpuBackendScheduler::Lease CpuBackendScheduler::Acquire(int max_threads,
+                                                        int priority) {
+  priority = std::max(priority, 1);
+  std::unique_lock<std::mutex> lock(mutex_);
+  // Negated so that higher priorities come first.
+  const std::pair<int, int64_t> waiter = {-priority, next_ticket_++};
+  waiters_.insert(waiter);
+  total_priority_ += priority;
+  released_.wait(lock, [this, &waiter] {
+    return free_threads_ > 0 && *waiters_.begin() == waiter;
+  });
+  waiters_.erase(waiters_.begin());
+
+  const int fair_share = std::max<int>(
+      1, static_cast<int64_t>(num_threads_) * priority / total_priority_);
+  int num_threads = std::min(fair_share, free_threads_);
+  if (max_threads > 0) num_threads = std::min(num_threads, max_threads);
+  free_threads_ -= num_threads;
+  // The next waiter may be able to run too.
+  if (!waiters_.empty() && free_threads_ > 0) released_.notify_all();
+  return Lease(this, num_threads, priority);
+}
+
+void CpuBackendScheduler::Release(int num_threads, int priority) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_threads_ += num_threads;
+    total_priority_ -= priority;
+  }
+  released_.notify_all();
+}
+
+ScopedCpuBackendLease::ScopedCpuBackendLease(CpuBackendScheduler* scheduler,
+                                             int priority,
+                                             TfLiteContext* context)
+    : context_(context) {
+  if (!scheduler) return;
+  auto* external_context = static_cast<ExternalCpuBackendContext*>(
+      context->GetExternalContext(context, kTfLiteCpuBackendContext));
+  if (!external_context || !external_context->internal_backend_context()) {
+    return;
+  }
+  backend_context_ = external_context->internal_backend_context();
+  lease_.emplace(
+      scheduler->Acquire(context->recommended_num_threads, priority));
+  backend_context_->SetMaxNumThreads(lease_->num_threads());
+}
+
+ScopedCpuBackendLease::~ScopedCpuBackendLease() {
+  if (backend_context_) {
+    backend_context_->SetMaxNumThreads(context_->recommended_num_threads);
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,117 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_CPU_BACKEND_SCHEDULER_H_
+#define TENSORFLOW_LITE_CPU_BACKEND_SCHEDULER_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
+#include <optional>
+#include <set>
+#include <utility>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+
+namespace tflite {
+
+// Shares a fixed number of CPU threads between interpreters, so that models
+// running at the same time don't oversubscribe the cores with their own
+// thread pools.
+//
+// An interpreter leases threads for each Invoke() and runs its CPU kernels
+// with at most that many threads. The threads are split between the
+// interpreters running or waiting to run in proportion to their priority, and
+// when no thread is free, waiting interpreters go in order of priority, then
+// of arrival.
+//
+// Example:
+//   CpuBackendScheduler* scheduler = CpuBackendScheduler::Global();
+//   interpreter_a->SetCpuBackendScheduler(scheduler, /*priority=*/2);
+//   interpreter_b->SetCpuBackendScheduler(scheduler, /*priority=*/1);
+class CpuBackendScheduler {
+ public:
+  // Threads leased to an interpreter, returned on destruction.
+  class Lease {
+   public:
+    Lease(Lease&& other)
+        : scheduler_(std::exchange(other.scheduler_, nullptr)),
+          num_threads_(other.num_threads_),
+          priority_(other.priority_) {}
+    Lease& operator=(Lease&&) = delete;
+    ~Lease();
+
+    int num_threads() const { return num_threads_; }
+
+   private:
+    friend class CpuBackendScheduler;
+    Lease(CpuBackendScheduler* scheduler, int num_threads, int priority)
+        : scheduler_(scheduler),
+          num_threads_(num_threads),
+          priority_(priority) {}
+
+    CpuBackendScheduler* scheduler_;
+    int num_threads_;
+    int priority_;
+  };
+
+  // Shares `num_threads` threads, at least 1.
+  explicit CpuBackendScheduler(int num_threads);
+  CpuBackendScheduler(const CpuBackendScheduler&) = delete;
+  CpuBackendScheduler& operator=(const CpuBackendScheduler&) = delete;
+
+  // Returns the scheduler of the process, which shares as many threads as
+  // there are cores.
+  static CpuBackendScheduler* Global();
+
+  // Blocks until a thread is free, then leases at most `max_threads` threads,
+  // or the fair share if `max_threads` is -1. `priority` is at least 1.
+  Lease Acquire(int max_threads, int priority = 1);
+
+  int num_threads() const { return num_threads_; }
+
+ private:
+  void Release(int num_threads, int priority);
+
+  const int num_threads_;
+  std::mutex mutex_;
+  std::condition_variable released_;
+  int free_threads_;
+  // The sum of the priorities of the leases and waiters.
+  int total_priority_ = 0;
+  int64_t next_ticket_ = 0;
+  // The waiters by decreasing priority, then by arrival.
+  std::set<std::pair<int, int64_t>> waiters_;
+};
+
+// Limits the CPU backend of `context` to threads leased from `scheduler` for
+// the lifetime of the object, then restores the recommended number of
+// threads. Does nothing if `scheduler` is null or the backend was not created.
+class ScopedCpuBackendLease {
+ public:
+  ScopedCpuBackendLease(CpuBackendScheduler* scheduler, int priority,
+                        TfLiteContext* context);
+  ~ScopedCpuBackendLease();
+
+ private:
+  TfLiteContext* context_;
+  TfLiteInternalBackendContext* backend_context_ = nullptr;
+  std::optional<CpuBackendScheduler::Lease> lease_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_CPU_BACKEND_SCHEDULER_H_
@@ -0,0 +1,123 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/cpu_backend_scheduler.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <optional>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+
+namespace tflite {
+namespace {
+
+TEST(CpuBackendSchedulerTest, LeasesAtMostRequestedThreads) {
+  CpuBackendScheduler scheduler(8);
+  CpuBackendScheduler::Lease lease = scheduler.Acquire(/*max_threads=*/3);
+  EXPECT_EQ(lease.num_threads(), 3);
+  // Two interpreters with the same priority get half of the threads each.
+  CpuBackendScheduler::Lease other_lease = scheduler.Acquire(-1);
+  EXPECT_EQ(other_lease.num_threads(), 4);
+}
+
+TEST(CpuBackendSchedulerTest, SharesThreadsByPriority) {
+  CpuBackendScheduler scheduler(8);
+  std::optional<CpuBackendScheduler::Lease> low_priority;
+  low_priority.emplace(scheduler.Acquire(-1, /*priority=*/1));
+  EXPECT_EQ(low_priority->num_threads(), 8);
+  low_priority.reset();
+
+  // Leases are only shared once they are held at the same time.
+  CpuBackendScheduler::Lease first = scheduler.Acquire(2, /*priority=*/1);
+  CpuBackendScheduler::Lease high_priority =
+      scheduler.Acquire(-1, /*priority=*/3);
+  // 8 threads * 3 / (1 + 3).
+  EXPECT_EQ(high_priority.num_threads(), 6);
+}
+
+TEST(CpuBackendSchedulerTest, WaitsForFreeThreadsInPriorityOrder) {
+  CpuBackendScheduler scheduler(1);
+  std::optional<CpuBackendScheduler::Lease> lease;
+  lease.emplace(scheduler.Acquire(-1));
+
+  std::vector<int> order;
+  std::mutex order_mutex;
+  auto run = [&](int priority) {
+    CpuBackendScheduler::Lease waiter = scheduler.Acquire(-1, priority);
+    std::lock_guard<std::mutex> lock(order_mutex);
+    order.push_back(priority);
+  };
+  std::thread low(run, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::thread high(run, 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  {
+    std::lock_guard<std::mutex> lock(order_mutex);
+    EXPECT_TRUE(order.empty());
+  }
+
+  lease.reset();
+  low.join();
+  high.join();
+  EXPECT_EQ(order, std::vector<int>({2, 1}));
+}
+
+class FakeBackendContext : public TfLiteInternalBackendContext {
+ public:
+  void SetMaxNumThreads(int max_num_threads) override {
+    max_num_threads_ = max_num_threads;
+  }
+  void ClearCaches() override {}
+
+  int max_num_threads_ = -1;
+};
+
+TfLiteExternalContext* GetExternalContext(TfLiteContext* context,
+                                          TfLiteExternalContextType type) {
+  return static_cast<TfLiteExternalContext*>(context->impl_);
+}
+
+TEST(ScopedCpuBackendLeaseTest, LimitsThreadsOfBackend) {
+  ExternalCpuBackendContext external_context;
+  auto backend_context = std::make_unique<FakeBackendContext>();
+  FakeBackendContext* backend = backend_context.get();
+  external_context.set_internal_backend_context(std::move(backend_context));
+  TfLiteContext context = {};
+  context.impl_ = &external_context;
+  context.GetExternalContext = GetExternalContext;
+  context.recommended_num_threads = 4;
+
+  CpuBackendScheduler scheduler(8);
+  CpuBackendScheduler::Lease other = scheduler.Acquire(/*max_threads=*/6);
+  {
+    ScopedCpuBackendLease lease(&scheduler, /*priority=*/1, &context);
+    EXPECT_EQ(backend->max_num_threads_, 2);
+  }
+  EXPECT_EQ(backend->max_num_threads_, 4);
+
+  {
+    ScopedCpuBackendLease lease(/*scheduler=*/nullptr, 1, &context);
+    EXPECT_EQ(backend->max_num_threads_, 4);
+  }
+}
+
+}  // namespace
+}  // namespace tflite
@@ -55,9 +55,14 @@ class BufferMap {
   // Same as above but creates a new tensorflow::Tensor with a copy of the
   // given TfLiteTensor's data. If `allow_reusing=false`, then we explicitly
   // disallow reusing the TF Lite tensor buffer when constructing the new
-  // tensorflow Tensor.
+  // tensorflow Tensor. See TfLiteTensorBuffer for `allow_reusing_arena`.
   void SetFromTfLite(int tensor_index, const TfLiteTensor* tensor,
-                     bool allow_reusing = true);
+                     bool allow_reusing = true,
+                     bool allow_reusing_arena = false);
+
+  // Removes the tensorflow::Tensor associated with the given 'tensor_index',
+  // if any.
+  void RemoveTensor(int tensor_index);
 
  private:
   // Mapping from TL Lite tensor ID to TensorFlow's Tensor. All tensors that
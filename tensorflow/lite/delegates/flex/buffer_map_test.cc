@@ -287,6 +287,37 @@ TEST(BufferMapTest, ExplicitlyDisableBufferReuse) {
   TfLiteTensorDataFree(&tensor);
 }
 
+TEST(BufferMapTest, ArenaBufferReuse) {
+  alignas(64) char arena[64];
+  TfLiteTensor tensor;
+  tensor.allocation_type = kTfLiteArenaRw;
+  tensor.data.raw = arena;
+  tensor.bytes = sizeof(arena);
+
+  // Arena buffers are only reused when explicitly allowed.
+  TfLiteTensorBuffer* tensor_buffer = new TfLiteTensorBuffer(&tensor);
+  EXPECT_FALSE(tensor_buffer->BufferReusedFromTfLiteTensor());
+  EXPECT_NE(tensor_buffer->data(), tensor.data.raw);
+  tensor_buffer->Unref();
+
+  TfLiteTensorBuffer* tensor_buffer_reused =
+      new TfLiteTensorBuffer(&tensor, /*allow_reusing=*/true,
+                             /*allow_reusing_arena=*/true);
+  EXPECT_TRUE(tensor_buffer_reused->BufferReusedFromTfLiteTensor());
+  EXPECT_EQ(tensor_buffer_reused->data(), tensor.data.raw);
+  tensor_buffer_reused->Unref();
+}
+
+TEST(BufferMapTest, RemoveTensor) {
+  BufferMap buffer_map;
+  buffer_map.SetFromTensorFlow(
+      0, MakeTensor<float>({1}, {1.0f}, tensorflow::DT_FLOAT));
+  buffer_map.RemoveTensor(0);
+  EXPECT_FALSE(buffer_map.HasTensor(0));
+  // Removing a missing tensor is a no-op.
+  buffer_map.RemoveTensor(1);
+}
+
 }  // namespace
 }  // namespace flex
 }  // namespace tflite
@@ -35,16 +35,17 @@ namespace flex {
 namespace {
 // Returns a boolean to indicate whether we should reuse memory from the
 // TfLiteTensor.
-inline bool ShouldReuseTensorMemory(const TfLiteTensor* tensor) {
-  // TODO(b/205153246): Currently arena-allocated memory could not be reused
-  // since it might be invalid after the original arena grow in size and copied
-  // over to a new memory block.
+inline bool ShouldReuseTensorMemory(const TfLiteTensor* tensor,
+                                    bool allow_reusing_arena) {
+  // Arena-allocated memory is only reused on request, since it might be
+  // invalid after the original arena grow in size and copied over to a new
+  // memory block, and is reused by other tensors.
   // First check alignment is consistent with Tensorflow.
   if (EIGEN_MAX_ALIGN_BYTES != 0 &&
       reinterpret_cast<intptr_t>(tensor->data.raw) % EIGEN_MAX_ALIGN_BYTES) {
     return false;
   }
-  return tensor->allocation_type != kTfLiteArenaRw;
+  return allow_reusing_arena || tensor->allocation_type != kTfLiteArenaRw;
 }
 }  // namespace
 
@@ -73,8 +74,9 @@ void BaseTfLiteTensorBuffer::LogDeallocation() {
 }
 
 void* TfLiteTensorBuffer::MaybeAllocateTensorflowBuffer(
-    const TfLiteTensor* tensor, bool allow_reusing) const {
-  if (allow_reusing && ShouldReuseTensorMemory(tensor)) {
+    const TfLiteTensor* tensor, bool allow_reusing,
+    bool allow_reusing_arena) const {
+  if (allow_reusing && ShouldReuseTensorMemory(tensor, allow_reusing_arena)) {
     return tensor->data.raw;
   }
   return tensorflow::cpu_allocator()->AllocateRaw(EIGEN_MAX_ALIGN_BYTES,
@@ -82,12 +84,14 @@ void* TfLiteTensorBuffer::MaybeAllocateTensorflowBuffer(
 }
 
 TfLiteTensorBuffer::TfLiteTensorBuffer(const TfLiteTensor* tensor,
-                                       bool allow_reusing)
-    : BaseTfLiteTensorBuffer(
-          MaybeAllocateTensorflowBuffer(tensor, allow_reusing)) {
+                                       bool allow_reusing,
+                                       bool allow_reusing_arena)
+    : BaseTfLiteTensorBuffer(MaybeAllocateTensorflowBuffer(
+          tensor, allow_reusing, allow_reusing_arena)) {
   len_ = tensor->bytes;
 
-  reused_buffer_from_tflite_ = allow_reusing && ShouldReuseTensorMemory(tensor);
+  reused_buffer_from_tflite_ =
+      allow_reusing && ShouldReuseTensorMemory(tensor, allow_reusing_arena);
 
   if (data() && !reused_buffer_from_tflite_) {
     LogAllocation();
@@ -137,7 +141,8 @@ StringTfLiteTensorBuffer::StringTfLiteTensorBuffer(const TfLiteTensor* tensor,
 
 tensorflow::Status SetTfTensorFromTfLite(const TfLiteTensor* tensor,
                                          tensorflow::Tensor* tf_tensor,
-                                         bool allow_reusing) {
+                                         bool allow_reusing,
+                                         bool allow_reusing_arena) {
   if (resource::IsBuiltinResource(tensor)) {
     // If this is native TF Lite resource variable, then we create a TF resource
     // tensor where the tensor handle encodes the identifier of the TF Lite
@@ -185,7 +190,7 @@ tensorflow::Status SetTfTensorFromTfLite(const TfLiteTensor* tensor,
   if (tensor->type == kTfLiteString) {
     buf = new StringTfLiteTensorBuffer(tensor);
   } else {
-    buf = new TfLiteTensorBuffer(tensor, allow_reusing);
+    buf = new TfLiteTensorBuffer(tensor, allow_reusing, allow_reusing_arena);
   }
   tensorflow::Tensor t = tensorflow::TensorCApi::MakeTensor(
       GetTensorFlowDataType(tensor->type), shape, buf);
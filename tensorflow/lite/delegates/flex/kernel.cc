@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/eager/context.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -416,6 +417,11 @@ struct OpData {
       disable_reusing_buffer_tensors;  // A list of input tensor indexes which
                                        // input buffer should not be reused by
                                        // tensorflow::Tensor.
+  // Whether arena allocated inputs can be used by TF without copying them.
+  // This is only safe if no op can keep a reference to its inputs beyond
+  // Eval(), i.e. there are no stateful ops and no resource, variant or string
+  // outputs.
+  bool bind_arena_inputs = true;
   OpDataInfo shared_info;
 };
 
@@ -516,6 +522,16 @@ TfLiteStatus DelegateKernel::Init(TfLiteContext* context,
     status = node_data.BuildOpKernelRunner(op_data_->eager_context);
     if (!status.ok()) break;
 
+    if (node_data.op_reg_data()->op_def.is_stateful()) {
+      op_data_->bind_arena_inputs = false;
+    }
+    for (auto tensor_index : TfLiteIntArrayView(node->outputs)) {
+      const TfLiteTensor* tensor = &context->tensors[tensor_index];
+      if (IsResourceOrVariant(tensor) || tensor->type == kTfLiteString) {
+        op_data_->bind_arena_inputs = false;
+      }
+    }
+
     // For each node handled by this delegate partition, record the mapping
     // information between each input tensor and the node index. The node index
     // is the index of the last node in execution order that uses this tensor.
@@ -736,6 +752,10 @@ TfLiteStatus DelegateKernel::Eval(TfLiteContext* context, TfLiteNode* node) {
 
   // Insert a tensor in the buffer map for all inputs that are not constant.
   // Constants were handled in Prepare() already.
+  // Arena allocated inputs are bound without copying when possible. As the
+  // arena memory is reused by other tensors, they are dropped from the buffer
+  // map at the end of Eval().
+  std::vector<int> bound_arena_inputs;
   for (auto tensor_index : op_data_->subgraph_inputs) {
     TfLiteTensor* tensor = &context->tensors[tensor_index];
     if (!IsConstantTensor(tensor)) {
@@ -743,12 +763,22 @@ TfLiteStatus DelegateKernel::Eval(TfLiteContext* context, TfLiteNode* node) {
       // to the BufferMap again, because TF already knows about it and its
       // contents are kept automatically up-to-date.
       if (!tensor->data_is_stale || !buffer_map->HasTensor(tensor_index)) {
-        buffer_map->SetFromTfLite(
-            tensor_index, tensor,
-            !op_data_->disable_reusing_buffer_tensors.count(tensor_index));
+        const bool allow_reusing =
+            !op_data_->disable_reusing_buffer_tensors.count(tensor_index);
+        const bool bind_arena = allow_reusing &&
+                                op_data_->bind_arena_inputs &&
+                                tensor->allocation_type == kTfLiteArenaRw;
+        buffer_map->SetFromTfLite(tensor_index, tensor, allow_reusing,
+                                  bind_arena);
+        if (bind_arena) bound_arena_inputs.push_back(tensor_index);
       }
     }
   }
+  auto release_bound_arena_inputs = [&]() {
+    for (auto tensor_index : bound_arena_inputs) {
+      buffer_map->RemoveTensor(tensor_index);
+    }
+  };
 
   auto& eager_context = *op_data_->eager_context;
 
@@ -776,14 +806,33 @@ TfLiteStatus DelegateKernel::Eval(TfLiteContext* context, TfLiteNode* node) {
           op_data_->cancellation_manager->IsCancelled()) {
         TF_LITE_KERNEL_LOG(
             context, "Client requested cancel during DelegateKernel::Eval");
+        release_bound_arena_inputs();
         return kTfLiteError;
       }
 
       auto status = ExecuteOpKernelRunner(&run_state, context, node_data.get());
+      if (!status.ok()) release_bound_arena_inputs();
       TF_LITE_ENSURE_OK(context, ConvertStatus(context, status));
     }
   }
 
+  // Outputs which alias a bound input (e.g. from Identity or Reshape) must
+  // own their data, since they may be read after the input is overwritten.
+  for (auto input_index : bound_arena_inputs) {
+    const tensorflow::Tensor& input = buffer_map->GetTensor(input_index);
+    for (auto tensor_index : op_data_->subgraph_outputs) {
+      if (tensor_index == input_index || !buffer_map->HasTensor(tensor_index)) {
+        continue;
+      }
+      const tensorflow::Tensor& output = buffer_map->GetTensor(tensor_index);
+      if (output.IsInitialized() && output.SharesBufferWith(input)) {
+        buffer_map->SetFromTensorFlow(tensor_index,
+                                      tensorflow::tensor::DeepCopy(output));
+      }
+    }
+  }
+  release_bound_arena_inputs();
+
   for (auto tensor_index : op_data_->subgraph_outputs) {
     if (op_data_->shared_info.already_transferred_outputs.count(tensor_index) !=
         0) {
@@ -36,6 +36,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/cl/inference_context.h"
 #include "tensorflow/lite/delegates/gpu/cl/kernels/converter.h"
 #include "tensorflow/lite/delegates/gpu/cl/opencl_wrapper.h"
+#include "tensorflow/lite/delegates/gpu/cl/program_cache_store.h"
 #include "tensorflow/lite/delegates/gpu/cl/tensor.h"
 #include "tensorflow/lite/delegates/gpu/cl/tensor_type_util.h"
 #include "tensorflow/lite/delegates/gpu/common/data_type.h"
@@ -962,7 +963,14 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
         CreateProfilingCommandQueue(device, context, &profiling_queue));
     environment_ = Environment(std::move(device), std::move(context),
                                std::move(queue), std::move(profiling_queue));
-    return environment_.Init();
+    RETURN_IF_ERROR(environment_.Init());
+    if (!options_.program_cache_dir.empty()) {
+      program_cache_store_ = std::make_unique<ProgramCacheStore>(
+          options_.program_cache_dir, options_.program_cache_max_bytes,
+          GetProgramCacheDeviceKey(environment_.device().GetInfo()));
+      environment_.program_cache()->SetStore(program_cache_store_.get());
+    }
+    return absl::OkStatus();
   }
 
   absl::Status BuildSerializedModel(
@@ -1048,6 +1056,7 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
 
  private:
   const InferenceEnvironmentOptions options_;
+  std::unique_ptr<ProgramCacheStore> program_cache_store_;
   Environment environment_;
   InferenceEnvironmentProperties properties_;
 };
@@ -24,6 +24,7 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 
 #include "absl/types/span.h"
 #include "tensorflow/lite/delegates/gpu/api.h"
@@ -129,6 +130,12 @@ struct InferenceEnvironmentOptions {
   // incompatible when GPU driver is updated.
   absl::Span<const uint8_t> serialized_binary_cache;
 
+  // If set, compiled programs are kept in this directory and shared by all
+  // environments on the device, see ProgramCacheStore. Binaries are evicted
+  // once the directory holds more than program_cache_max_bytes of them.
+  std::string program_cache_dir;
+  uint64_t program_cache_max_bytes = 64 * 1024 * 1024;
+
   bool IsGlAware() const {
     return egl_context != EGL_NO_CONTEXT && egl_display != EGL_NO_DISPLAY;
   }
@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstdint>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "flatbuffers/flatbuffers.h"  // from @flatbuffers
 #include "tensorflow/lite/delegates/gpu/cl/cl_program.h"
@@ -67,11 +68,13 @@ ProgramCache::ProgramDescriptor::ProgramDescriptor(uint64_t fingerprints)
     : fingerprint(fingerprints) {}
 
 ProgramCache::ProgramCache(ProgramCache&& program_cache)
-    : programs_(std::move(program_cache.programs_)) {}
+    : programs_(std::move(program_cache.programs_)),
+      store_(program_cache.store_) {}
 
 ProgramCache& ProgramCache::operator=(ProgramCache&& program_cache) {
   if (this != &program_cache) {
     programs_ = std::move(program_cache.programs_);
+    store_ = program_cache.store_;
   }
   return *this;
 }
@@ -93,7 +96,15 @@ absl::Status ProgramCache::GetOrCreateCLKernel(
   }
 
   CLProgram program;
-  RETURN_IF_ERROR(CreateCLProgram(code, options, context, device, &program));
+  std::vector<uint8_t> binary;
+  if (!store_ || !store_->Load(desc.fingerprint, &binary).ok() ||
+      !CreateCLProgramFromBinary(context, device, binary, &program).ok()) {
+    RETURN_IF_ERROR(CreateCLProgram(code, options, context, device, &program));
+    if (store_ && program.GetBinary(&binary).ok()) {
+      // Ignore returned error. The program is compiled again next time.
+      store_->Store(desc.fingerprint, binary).IgnoreError();
+    }
+  }
   RETURN_IF_ERROR(result->CreateFromProgram(program, function_name));
   programs_.insert(std::make_pair(std::move(desc), std::move(program)));
   return absl::OkStatus();
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/cl/cl_device.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_kernel.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_program.h"
+#include "tensorflow/lite/delegates/gpu/cl/program_cache_store.h"
 #include "tensorflow/lite/delegates/gpu/common/status.h"
 
 namespace tflite {
@@ -41,6 +42,11 @@ class ProgramCache {
   ProgramCache(const ProgramCache&) = delete;
   ProgramCache& operator=(const ProgramCache&) = delete;
 
+  // Programs missing from the cache are loaded from `store` before they are
+  // compiled, and compiled ones are added to it. The store is not owned and
+  // must outlive the cache. Passing nullptr disables it.
+  void SetStore(ProgramCacheStore* store) { store_ = store; }
+
   absl::Status GetOrCreateCLKernel(
       const std::string& code, const std::string& function_name,
       const std::vector<CompilerOptions>& compiler_options,
@@ -92,6 +98,7 @@ class ProgramCache {
   absl::flat_hash_map<ProgramDescriptor, CLProgram, ProgramDescriptorHasher,
                       ProgramDescriptorEqual>
       programs_;
+  ProgramCacheStore* store_ = nullptr;
 };
 
 }  // namespace cl
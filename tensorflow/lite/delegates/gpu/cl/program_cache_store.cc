@@ -0,0 +1,178 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/delegates/gpu/cl/program_cache_store.h"
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif  // !defined(_WIN32)
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "tensorflow/lite/delegates/gpu/common/gpu_info.h"
+#include "tensorflow/lite/delegates/gpu/common/status.h"
+#include <farmhash.h>
+
+namespace tflite {
+namespace gpu {
+namespace cl {
+namespace {
+
+constexpr char kBinaryExtension[] = ".clbin";
+
+std::string JoinPath(const std::string& path1, const std::string& path2) {
+  return (path1.back() == '/') ? (path1 + path2) : (path1 + "/" + path2);
+}
+
+#if !defined(_WIN32)
+int64_t GetModificationTimeNs(const struct stat& file_stat) {
+#if defined(__APPLE__)
+  const struct timespec& time = file_stat.st_mtimespec;
+#else
+  const struct timespec& time = file_stat.st_mtim;
+#endif
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+#endif  // !defined(_WIN32)
+
+}  // namespace
+
+std::string GetProgramCacheDeviceKey(const GpuInfo& gpu_info) {
+  const OpenClInfo& info = gpu_info.opencl_info;
+  return absl::StrCat(info.vendor_name, "|", info.device_name, "|",
+                      info.platform_version, "|", info.driver_version);
+}
+
+ProgramCacheStore::ProgramCacheStore(const std::string& directory,
+                                     uint64_t max_bytes,
+                                     const std::string& device_key)
+    : directory_(directory),
+      max_bytes_(max_bytes),
+      device_fingerprint_(::util::Fingerprint64(device_key)) {}
+
+std::string ProgramCacheStore::GetPath(uint64_t fingerprint) const {
+  return JoinPath(directory_,
+                  absl::StrCat(absl::Hex(device_fingerprint_, absl::kZeroPad16),
+                               "_", absl::Hex(fingerprint, absl::kZeroPad16),
+                               kBinaryExtension));
+}
+
+absl::Status ProgramCacheStore::Load(uint64_t fingerprint,
+                                     std::vector<uint8_t>* binary) {
+  const std::string path = GetPath(fingerprint);
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return absl::NotFoundError("No binary with this fingerprint.");
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);  // NOLINT
+  fseek(file, 0, SEEK_SET);
+  binary->resize(size < 0 ? 0 : size);
+  const size_t read = fread(binary->data(), 1, binary->size(), file);
+  fclose(file);
+  if (size <= 0 || read != binary->size()) {
+    return absl::DataLossError(absl::StrCat("Could not read ", path));
+  }
+#if !defined(_WIN32)
+  // Marks the binary as recently used.
+  utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+#endif  // !defined(_WIN32)
+  return absl::OkStatus();
+}
+
+absl::Status ProgramCacheStore::Store(uint64_t fingerprint,
+                                      absl::Span<const uint8_t> binary) {
+  const std::string path = GetPath(fingerprint);
+  // Writes to a temporary file first, as rename is atomic on most systems.
+  const std::string temp_path =
+      absl::StrCat(path, ".", reinterpret_cast<uintptr_t>(this), ".",
+                   time(nullptr), ".tmp");
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (!file) {
+    return absl::UnavailableError(
+        absl::StrCat("Could not create ", temp_path));
+  }
+  const size_t written = fwrite(binary.data(), 1, binary.size(), file);
+  if (fclose(file) != 0 || written != binary.size() ||
+      rename(temp_path.c_str(), path.c_str()) != 0) {
+    remove(temp_path.c_str());
+    return absl::UnavailableError(absl::StrCat("Could not write ", path));
+  }
+  size_ += binary.size();
+  if (!size_known_ || size_ > max_bytes_) {
+    return Trim();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ProgramCacheStore::Trim() {
+#if defined(_WIN32)
+  return absl::UnimplementedError("Evicting binaries is not supported.");
+#else
+  struct CachedBinary {
+    int64_t used_time_ns;
+    uint64_t size;
+    std::string path;
+  };
+  DIR* dir = opendir(directory_.c_str());
+  if (!dir) {
+    return absl::UnavailableError(
+        absl::StrCat("Could not open ", directory_));
+  }
+  std::vector<CachedBinary> binaries;
+  uint64_t total_size = 0;
+  // Binaries of all devices and drivers are counted, so that binaries of a
+  // replaced driver are the first to go.
+  while (const struct dirent* entry = readdir(dir)) {
+    if (!absl::EndsWith(entry->d_name, kBinaryExtension)) continue;
+    std::string path = JoinPath(directory_, entry->d_name);
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) != 0) continue;
+    const uint64_t size = file_stat.st_size;
+    binaries.push_back({GetModificationTimeNs(file_stat), size,
+                        std::move(path)});
+    total_size += size;
+  }
+  closedir(dir);
+
+  std::sort(binaries.begin(), binaries.end(),
+            [](const CachedBinary& a, const CachedBinary& b) {
+              return a.used_time_ns < b.used_time_ns;
+            });
+  for (const CachedBinary& binary : binaries) {
+    if (total_size <= max_bytes_) break;
+    if (remove(binary.path.c_str()) == 0) {
+      total_size -= binary.size;
+    }
+  }
+  size_ = total_size;
+  size_known_ = true;
+  return absl::OkStatus();
+#endif  // defined(_WIN32)
+}
+
+}  // namespace cl
+}  // namespace gpu
+}  // namespace tflite
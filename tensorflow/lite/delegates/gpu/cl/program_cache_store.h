@@ -0,0 +1,78 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_DELEGATES_GPU_CL_PROGRAM_CACHE_STORE_H_
+#define TENSORFLOW_LITE_DELEGATES_GPU_CL_PROGRAM_CACHE_STORE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/lite/delegates/gpu/common/gpu_info.h"
+#include "tensorflow/lite/delegates/gpu/common/status.h"
+
+namespace tflite {
+namespace gpu {
+namespace cl {
+
+// Returns a string that identifies the device and driver compiled programs
+// are valid for.
+std::string GetProgramCacheDeviceKey(const GpuInfo& gpu_info);
+
+// A directory of compiled program binaries, shared by all the models that run
+// on a device.
+//
+// Binaries are keyed by the fingerprint of the program source and compiler
+// options, and by the device key, so binaries of another GPU or of an earlier
+// driver are never loaded. They are evicted instead: once the directory holds
+// more than `max_bytes` of binaries, the least recently used ones are removed
+// until it fits again.
+//
+// The directory should be private to the app. Concurrent stores write every
+// binary atomically, so they can share it.
+class ProgramCacheStore {
+ public:
+  ProgramCacheStore(const std::string& directory, uint64_t max_bytes,
+                    const std::string& device_key);
+
+  // Reads the binary of the program with `fingerprint`.
+  absl::Status Load(uint64_t fingerprint, std::vector<uint8_t>* binary);
+
+  // Writes the binary of the program with `fingerprint`, then evicts binaries
+  // if the directory became too large.
+  absl::Status Store(uint64_t fingerprint, absl::Span<const uint8_t> binary);
+
+  // Removes the least recently used binaries until the directory holds at
+  // most `max_bytes` of them.
+  absl::Status Trim();
+
+ private:
+  std::string GetPath(uint64_t fingerprint) const;
+
+  const std::string directory_;
+  const uint64_t max_bytes_;
+  const uint64_t device_fingerprint_;
+  // The size of the binaries in the directory, as of the last Trim() and the
+  // stores since.
+  uint64_t size_ = 0;
+  bool size_known_ = false;
+};
+
+}  // namespace cl
+}  // namespace gpu
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_DELEGATES_GPU_CL_PROGRAM_CACHE_STORE_H_
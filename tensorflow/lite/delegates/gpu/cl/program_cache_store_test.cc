@@ -0,0 +1,120 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/delegates/gpu/cl/program_cache_store.h"
+
+#include <stdlib.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/delegates/gpu/common/status.h"
+
+namespace tflite {
+namespace gpu {
+namespace cl {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+class ProgramCacheStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::string dir_template = ::testing::TempDir() + "/program_cacheXXXXXX";
+    ASSERT_NE(mkdtemp(dir_template.data()), nullptr);
+    directory_ = dir_template;
+  }
+
+  // Lets the modification times of the binaries tell them apart.
+  static void WaitForClockTick() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  std::string directory_;
+};
+
+TEST_F(ProgramCacheStoreTest, LoadsStoredBinary) {
+  ProgramCacheStore store(directory_, 1024, "vendor|device|driver 1");
+  const std::vector<uint8_t> binary = {1, 2, 3, 4};
+  ASSERT_TRUE(store.Store(42, binary).ok());
+
+  std::vector<uint8_t> loaded;
+  ASSERT_TRUE(store.Load(42, &loaded).ok());
+  EXPECT_THAT(loaded, ElementsAreArray(binary));
+  EXPECT_TRUE(absl::IsNotFound(store.Load(43, &loaded)));
+
+  // Another store on the same device shares the binaries.
+  ProgramCacheStore other_store(directory_, 1024, "vendor|device|driver 1");
+  loaded.clear();
+  ASSERT_TRUE(other_store.Load(42, &loaded).ok());
+  EXPECT_THAT(loaded, ElementsAreArray(binary));
+}
+
+TEST_F(ProgramCacheStoreTest, IgnoresBinariesOfOtherDrivers) {
+  ProgramCacheStore old_driver(directory_, 1024, "vendor|device|driver 1");
+  ASSERT_TRUE(old_driver.Store(42, std::vector<uint8_t>{1, 2, 3}).ok());
+
+  ProgramCacheStore new_driver(directory_, 1024, "vendor|device|driver 2");
+  std::vector<uint8_t> loaded;
+  EXPECT_TRUE(absl::IsNotFound(new_driver.Load(42, &loaded)));
+}
+
+TEST_F(ProgramCacheStoreTest, EvictsLeastRecentlyUsedBinaries) {
+  ProgramCacheStore store(directory_, 300, "vendor|device|driver 1");
+  const std::vector<uint8_t> binary(100, 7);
+  ASSERT_TRUE(store.Store(1, binary).ok());
+  WaitForClockTick();
+  ASSERT_TRUE(store.Store(2, binary).ok());
+  WaitForClockTick();
+  ASSERT_TRUE(store.Store(3, binary).ok());
+  WaitForClockTick();
+  std::vector<uint8_t> loaded;
+  ASSERT_TRUE(store.Load(1, &loaded).ok());
+  WaitForClockTick();
+
+  // Binary 2 is the least recently used one.
+  ASSERT_TRUE(store.Store(4, binary).ok());
+  EXPECT_TRUE(store.Load(1, &loaded).ok());
+  EXPECT_TRUE(absl::IsNotFound(store.Load(2, &loaded)));
+  EXPECT_TRUE(store.Load(3, &loaded).ok());
+  EXPECT_TRUE(store.Load(4, &loaded).ok());
+}
+
+TEST_F(ProgramCacheStoreTest, EvictsBinariesOfOtherDriversFirst) {
+  ProgramCacheStore old_driver(directory_, 200, "vendor|device|driver 1");
+  const std::vector<uint8_t> binary(100, 7);
+  ASSERT_TRUE(old_driver.Store(1, binary).ok());
+  WaitForClockTick();
+
+  ProgramCacheStore new_driver(directory_, 200, "vendor|device|driver 2");
+  ASSERT_TRUE(new_driver.Store(1, binary).ok());
+  WaitForClockTick();
+  ASSERT_TRUE(new_driver.Store(2, binary).ok());
+
+  std::vector<uint8_t> loaded;
+  EXPECT_TRUE(absl::IsNotFound(old_driver.Load(1, &loaded)));
+  EXPECT_TRUE(new_driver.Load(1, &loaded).ok());
+  EXPECT_TRUE(new_driver.Load(2, &loaded).ok());
+}
+
+}  // namespace
+}  // namespace cl
+}  // namespace gpu
+}  // namespace tflite
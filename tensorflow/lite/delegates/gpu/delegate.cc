@@ -209,6 +209,15 @@ bool ParseOptions(const char* const* options_keys,
       options->serialization_dir = options_values[i];
     } else if (strcmp(options_keys[i], "model_token")) {
       options->model_token = options_values[i];
+    } else if (strcmp(options_keys[i], "program_cache_dir")) {
+      options->program_cache_dir = options_values[i];
+    } else if (strcmp(options_keys[i], "program_cache_max_bytes")) {
+      if (!absl::SimpleAtoi(options_values[i],
+                            &options->program_cache_max_bytes)) {
+        TFLITE_LOG(TFLITE_LOG_WARNING, "ParseOptions: malformed option %s.",
+                   options_keys[i]);
+        return false;
+      }
     } else {
       TFLITE_LOG(TFLITE_LOG_WARNING, "ParseOptions: unknown option %s.",
                  options_keys[i]);
@@ -527,6 +536,11 @@ absl::Status DelegateKernelCore::InitializeOpenClApi(
 
   // OpenCL initialization is parameterized by these InferenceOptions.
   auto delegate_options = delegate_->options();
+  if (delegate_options.program_cache_dir) {
+    env_options.program_cache_dir = delegate_options.program_cache_dir;
+    env_options.program_cache_max_bytes =
+        delegate_options.program_cache_max_bytes;
+  }
   cl::InferenceOptions options;
   // If is_precision_loss_allowed == -1, then just use priorities instead
   // of paying attention to is_precision_loss_allowed value.
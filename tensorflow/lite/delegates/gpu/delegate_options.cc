@@ -30,6 +30,8 @@ TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default() {
   options.max_delegated_partitions = 1;
   options.model_token = nullptr;
   options.serialization_dir = nullptr;
+  options.program_cache_dir = nullptr;
+  options.program_cache_max_bytes = 64 * 1024 * 1024;
 #ifdef TFLITE_DEBUG_DELEGATE
   options.first_delegate_node_index = 0;
   options.last_delegate_node_index = std::numeric_limits<int>::max();
@@ -137,6 +137,22 @@ typedef struct {
   // delegate will not try serialization.
   const char* model_token;
 
+  // The nul-terminated directory to keep compiled GPU programs in. Unlike
+  // serialization, the programs are shared by all models, keyed by their
+  // source and the GPU and driver version, so any model compiles faster once
+  // another one compiled the same kernels. Programs compiled by an earlier
+  // driver are never loaded, and are the first ones evicted.
+  // Set to nullptr in TfLiteGpuDelegateOptionsV2Default(), which disables the
+  // cache. Currently works only if CL backend is used.
+  //
+  // NOTE: Users should ensure that this directory is private to the app.
+  const char* program_cache_dir;
+
+  // The maximum size of the programs kept in program_cache_dir. The least
+  // recently used ones are removed beyond it. Set to 64MB in
+  // TfLiteGpuDelegateOptionsV2Default().
+  int64_t program_cache_max_bytes;
+
 #ifdef TFLITE_DEBUG_DELEGATE
   // This sets the index of the first node that could be delegated.
   int first_delegate_node_index;
@@ -158,6 +174,7 @@ typedef struct {
 //   priority3 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO
 //   experimental_flags = TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_QUANT
 //   max_delegated_partitions = 1
+//   program_cache_max_bytes = 64MB
 TFL_CAPI_EXPORT TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default();
 
 #ifdef __cplusplus
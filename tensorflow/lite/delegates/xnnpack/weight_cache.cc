@@ -21,6 +21,7 @@ limitations under the License.
 #include <io.h>
 #define F_OK 0
 #else
+#include <sys/file.h>
 #include <sys/mman.h>
 #include <unistd.h>
 #endif
@@ -127,6 +128,36 @@ bool FileExists(const char* path) {
   return access(path, F_OK) != -1;
 }
 
+// Returns a 64 bit hash of the tensor data.
+//
+// This is FNV-1a applied to 8 byte words, with a shift to propagate the high
+// bits down, which is fast enough to hash all the weights of a model when it is
+// loaded.
+uint64_t HashTensorData(const TfLiteTensor& tensor) {
+  constexpr uint64_t kPrime = 0x100000001b3;
+  uint64_t hash = 0xcbf29ce484222325;
+  const auto mix = [&hash](uint64_t word) {
+    hash = (hash ^ word) * kPrime;
+    hash ^= hash >> 29;
+  };
+  mix(tensor.type);
+  mix(tensor.bytes);
+  const uint8_t* const data = static_cast<const uint8_t*>(tensor.data.data);
+  size_t i = 0;
+  if (data) {
+    for (; i + sizeof(uint64_t) <= tensor.bytes; i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, data + i, sizeof(word));
+      mix(word);
+    }
+    for (; i < tensor.bytes; ++i) {
+      mix(data[i]);
+    }
+  }
+  // Don't collide with the value reserved for missing buffers.
+  return hash == PackIdentifier::kNoId ? hash - 1 : hash;
+}
+
 }  // namespace
 
 void swap(MMapHandle& a, MMapHandle& b) {
@@ -271,6 +302,18 @@ bool WeightCacheBuilder::Start(const char* path) {
   return true;
 }
 
+bool WeightCacheBuilder::Reopen(const char* path) {
+  XNNPACK_RETURN_CHECK(!IsStarted());
+  file_path_ = path;
+  fd_ = FileDescriptor::Open(file_path_.c_str(), O_RDWR);
+  XNNPACK_RETURN_CHECK(fd_.IsValid(), "could not open file ('%s'): %s.",
+                       file_path_.c_str(), strerror(errno));
+  // The header is already valid, build steps that don't add anything don't
+  // need to rewrite it.
+  first_write_done_ = true;
+  return true;
+}
+
 bool WeightCacheBuilder::StartBuildStep() {
   XNNPACK_RETURN_CHECK(IsStarted());
 
@@ -411,6 +454,9 @@ MMapWeightCacheProvider& MMapWeightCacheProvider::operator=(
   swap(mmap_handles_, other.mmap_handles_);
   swap(mmap_buffer_base_offset_, other.mmap_buffer_base_offset_);
   swap(builder_, other.builder_);
+  swap(content_addressed_, other.content_addressed_);
+  swap(store_user_lock_, other.store_user_lock_);
+  swap(store_append_lock_, other.store_append_lock_);
   return *this;
 }
 
@@ -449,6 +495,84 @@ bool MMapWeightCacheProvider::StartBuild(const char* path) {
   return building_run_;
 }
 
+bool MMapWeightCacheProvider::LoadOrStartSharedStore(const char* path,
+                                                     const size_t size_limit) {
+#if defined(_MSC_VER)
+  TFLITE_LOG_PROD(tflite::TFLITE_LOG_ERROR,
+                  "XNNPack weight cache: shared stores are not supported on "
+                  "this platform ('%s').",
+                  path);
+  return false;
+#else
+  XNNPACK_RETURN_CHECK(!IsInMemoryCachePath(path),
+                       "a shared weight cache store needs a file path.");
+  XNNPACK_RETURN_CHECK(!IsActive(), "the weight cache is already in use.");
+
+  // Serialize with the processes that are opening or appending to the store.
+  const std::string lock_path = std::string(path) + ".lock";
+  FileDescriptor append_lock =
+      FileDescriptor::Open(lock_path.c_str(), O_CREAT | O_RDWR, 0644);
+  XNNPACK_RETURN_CHECK(append_lock.IsValid(), "could not open '%s': %s.",
+                       lock_path.c_str(), strerror(errno));
+  XNNPACK_RETURN_CHECK(flock(append_lock.Value(), LOCK_EX) == 0,
+                       "could not lock '%s': %s.", lock_path.c_str(),
+                       strerror(errno));
+  ScopeGuard unlock_appends(
+      [fd = append_lock.Value()] { flock(fd, LOCK_UN); });
+
+  FileDescriptor user_lock = FileDescriptor::Open(path, O_CREAT | O_RDWR, 0644);
+  XNNPACK_RETURN_CHECK(user_lock.IsValid(), "could not open '%s': %s.", path,
+                       strerror(errno));
+  struct stat file_stats;
+  XNNPACK_RETURN_CHECK(fstat(user_lock.Value(), &file_stats) == 0,
+                       "could not access file stats of '%s': %s.", path,
+                       strerror(errno));
+  // Only the first user may reset the store, the others have it mapped.
+  const bool first_user = flock(user_lock.Value(), LOCK_EX | LOCK_NB) == 0;
+  if (!first_user) {
+    XNNPACK_RETURN_CHECK(flock(user_lock.Value(), LOCK_SH) == 0,
+                         "could not lock '%s': %s.", path, strerror(errno));
+  }
+  bool full =
+      size_limit != 0 && static_cast<size_t>(file_stats.st_size) >= size_limit;
+
+  content_addressed_ = true;
+  SetFilePath(path);
+  bool loaded = file_stats.st_size != 0 && !(full && first_user) && Load();
+  if (!loaded && first_user) {
+    full = false;
+    TFLITE_LOG_PROD(tflite::TFLITE_LOG_VERBOSE,
+                    "XNNPack weight cache: resetting store '%s'.", path);
+    offset_to_addr_.clear();
+    loaded = builder_.Start(path) && builder_.StartBuildStep() &&
+             builder_.StopBuildStep() && Load();
+    builder_.Reset();
+  }
+  if (!loaded || full) {
+    TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING,
+                    "XNNPack weight cache: store '%s' is %s and used by other "
+                    "interpreters, falling back to a private in-memory cache.",
+                    path, loaded ? "full" : "invalid");
+    Release();
+    return StartBuild(kInMemoryCachePath);
+  }
+  XNNPACK_RETURN_CHECK(builder_.Reopen(path));
+  building_run_ = true;
+
+  if (first_user) {
+    // Let other providers use the store. The append lock we hold prevents
+    // another provider from resetting it in between.
+    XNNPACK_RETURN_CHECK(flock(user_lock.Value(), LOCK_SH) == 0,
+                         "could not lock '%s': %s.", path, strerror(errno));
+  }
+  store_user_lock_ = std::move(user_lock);
+  store_append_lock_ = std::move(append_lock);
+  TFLITE_LOG_PROD(tflite::TFLITE_LOG_VERBOSE,
+                  "XNNPack weight cache: using shared store '%s'.", path);
+  return true;
+#endif
+}
+
 bool MMapWeightCacheProvider::Load(const std::string& path) {
   SetFilePath(path.c_str());
   return Load();
@@ -554,9 +678,12 @@ bool MMapWeightCacheProvider::LoadLastBuildStep() {
   // - or add a new mapping handle.
   {
     MMapHandle& last_mmap_handle = mmap_handles_.back();
-    const int last_mmap_size = last_mmap_handle.size();
-    if (!last_mmap_handle.Resize(last_mmap_size +
-                                 builder_.LastBuildStepSize())) {
+    // With a shared store, other processes may have appended data between
+    // the end of the mapping and the start of the last build step.
+    const size_t last_build_step_end =
+        builder_.LastBuildStepStart() + builder_.LastBuildStepSize();
+    if (!last_mmap_handle.Resize(last_build_step_end -
+                                 last_mmap_handle.offset())) {
       mmap_handles_.emplace_back();
       if (temporary_file_descriptor_.IsValid()) {
         XNNPACK_RETURN_CHECK(
@@ -591,6 +718,10 @@ bool MMapWeightCacheProvider::LoadLastBuildStep() {
       buffer_list->base_offset() - segment_mmap_handle.offset();
   for (const auto* buffer : *(buffer_list->buffers())) {
     const size_t offset = buffer->offset();
+    if (buffer_list->base_offset() + offset < segment_mmap_handle.offset()) {
+      // Written by another user of a shared store, outside of the mapping.
+      continue;
+    }
     if (!offset_to_addr_.count(offset)) {
       offset_to_addr_.insert(
           {offset, segment_mmap_handle.data() + offset + offset_modifier});
@@ -605,11 +736,31 @@ bool MMapWeightCacheProvider::StartBuildStep() {
   if (IsBuilding()) {
     return true;
   }
+#if !defined(_MSC_VER)
+  if (store_append_lock_.IsValid()) {
+    // Held until StopBuildStep.
+    XNNPACK_RETURN_CHECK(flock(store_append_lock_.Value(), LOCK_EX) == 0,
+                         "could not lock the shared store: %s.",
+                         strerror(errno));
+  }
+#endif
   is_build_step_ = builder_.StartBuildStep();
+#if !defined(_MSC_VER)
+  if (!is_build_step_ && store_append_lock_.IsValid()) {
+    flock(store_append_lock_.Value(), LOCK_UN);
+  }
+#endif
   return is_build_step_;
 }
 
 bool MMapWeightCacheProvider::StopBuildStep() {
+#if !defined(_MSC_VER)
+  ScopeGuard unlock_appends([this] {
+    if (store_append_lock_.IsValid()) {
+      flock(store_append_lock_.Value(), LOCK_UN);
+    }
+  });
+#endif
   XNNPACK_RETURN_CHECK(builder_.StopBuildStep());
   is_build_step_ = false;
   return LoadLastBuildStep();
@@ -621,7 +772,8 @@ void MMapWeightCacheProvider::MapTensorIdentifiers(
   for (const auto [index, identifier] : tensor_index_to_identifier) {
     XNNPACK_ABORT_CHECK(index < size,
                         "Tensor index corresponds to a non existing tensor.");
-    buffer_address_to_identifier_[tensors[index].data.data] = identifier;
+    buffer_address_to_identifier_[tensors[index].data.data] =
+        content_addressed_ ? HashTensorData(tensors[index]) : identifier;
   }
 }
 
@@ -686,6 +838,9 @@ void MMapWeightCacheProvider::Release() {
   mmap_handles_.clear();
   mmap_buffer_base_offset_ = 0;
   builder_ = WeightCacheBuilder();
+  // Drops this provider's reference to the shared store.
+  store_user_lock_.Close();
+  store_append_lock_.Close();
 }
 
 size_t MMapWeightCacheProvider::look_up(
@@ -184,6 +184,13 @@ class WeightCacheBuilder {
   [[nodiscard /*Starting the builder may fail.*/]]
   bool Start(const char* path);
 
+  // Opens an existing cache file to add data to it.
+  //
+  // Contrary to `Start`, the file content is kept. The file must hold a valid
+  // cache.
+  [[nodiscard /*Opening the file may fail.*/]]
+  bool Reopen(const char* path);
+
   [[nodiscard]]
   bool IsStarted() const {
     return fd_.IsValid();
@@ -284,6 +291,9 @@ class WeightCacheBuilder {
 //  - Load the cache file.
 //  - Finalize the cache before calling the run functions of XNNPack (setup and
 //    reshape are ok).
+//
+// A cache file can also be used as a shared store, see
+// `LoadOrStartSharedStore`.
 class MMapWeightCacheProvider {
  public:
   MMapWeightCacheProvider() = default;
@@ -307,6 +317,30 @@ class MMapWeightCacheProvider {
   [[nodiscard /*Starting to build a cache file may fail.*/]]
   bool StartBuild(const char* file_path);
 
+  // Opens the given file as a packed weight store shared by all the
+  // interpreters, in this process or others, that open it.
+  //
+  // Packed buffers are identified by a hash of their source weights instead of
+  // the model buffer identifiers, so that models sharing weights (e.g.
+  // finetuned variants of a model) find each other's packed buffers. The
+  // buffers that are missing are appended to the store. Appends are serialized
+  // across processes by a lock on `<file_path>.lock`.
+  //
+  // Every provider using the store holds a shared lock on it, which acts as a
+  // reference count: when the store is invalid or reached `size_limit` bytes
+  // (0 means no limit), it is only reset if no other provider uses it.
+  // Otherwise, this provider falls back to a private in-memory cache.
+  //
+  // WARNING: `MapTensorIdentifiers` must be called after this.
+  [[nodiscard /*Opening a shared store may fail.*/]]
+  bool LoadOrStartSharedStore(const char* file_path, size_t size_limit);
+
+  // Returns true if the cache is a shared store.
+  [[nodiscard]]
+  bool IsSharedStore() const {
+    return store_user_lock_.IsValid();
+  }
+
   // Set the weight file path and loads it.
   [[nodiscard /*Loading a cache file may fail.*/]]
   bool Load(const std::string& path);
@@ -331,6 +365,9 @@ class MMapWeightCacheProvider {
   bool StopBuildStep();
 
   // Creates the tensor map.
+  //
+  // For a shared store, the identifiers are replaced by a hash of the tensor
+  // data.
   void MapTensorIdentifiers(
       const TfLiteTensor* tensors, size_t size,
       const std::unordered_map<size_t, size_t>& tensor_index_to_identifier);
@@ -464,6 +501,17 @@ class MMapWeightCacheProvider {
   // of the buffers are not available/can't be retrieved.
   bool is_build_step_ = false;
 
+  // True if buffers are identified by a hash of their data.
+  bool content_addressed_ = false;
+
+  // For a shared store, holds a shared lock on the store file for as long as
+  // it is mapped.
+  FileDescriptor store_user_lock_;
+
+  // For a shared store, the lock file that is held exclusively during build
+  // steps.
+  FileDescriptor store_append_lock_;
+
   // Stores the loaded buffer addresses corresponding to the given offset in the
   // cache file.
   std::map<size_t, void*> offset_to_addr_;
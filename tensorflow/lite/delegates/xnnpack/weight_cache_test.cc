@@ -1052,5 +1052,104 @@ TEST(MMapWeightCacheProviderTest, XnnpackCApiJourney) {
   }
 }
 
+#if !defined(_MSC_VER)
+struct SharedStoreMMapWeightCacheProviderTest : testing::Test {
+  enum { kAlgoSeed };
+  enum { kWeightIndex, kBiasIndex };
+
+  void SetUp() override {
+    // Both models have the same weights under different buffer identifiers.
+    model_a.AddTensor(/*buffer_identifier=*/1, /*size=*/12);
+    model_a.AddTensor(/*buffer_identifier=*/2, /*size=*/43);
+    model_b.AddTensor(/*buffer_identifier=*/7, /*size=*/12);
+    model_b.AddTensor(/*buffer_identifier=*/3, /*size=*/43);
+    model_b.buffers = model_a.buffers;
+    model_a.FinalizeTensors();
+    model_b.FinalizeTensors();
+  }
+
+  void TearDown() override {
+    std::remove((tmp_file.GetPath() + ".lock").c_str());
+  }
+
+  // Opens the store and packs the weights of `model_a` in it.
+  void BuildStore(MMapWeightCacheProvider& provider) {
+    ASSERT_TRUE(provider.LoadOrStartSharedStore(tmp_file.GetCPath(),
+                                                /*size_limit=*/0));
+    provider.MapTensorIdentifiers(model_a.tensors.data(),
+                                  model_a.tensors.size(),
+                                  model_a.tensor_buffer_identifiers);
+    ASSERT_TRUE(provider.StartBuildStep());
+    pack_id = model_a.PackTensors(&provider.GetCacheProvider(), kAlgoSeed,
+                                  kWeightIndex, kBiasIndex);
+    ASSERT_TRUE(provider.StopBuildStep());
+  }
+
+  FakeContext model_a;
+  FakeContext model_b;
+  PackIdentifier pack_id;
+  TempFileDesc tmp_file{TempFileDesc::kAutoClose};
+};
+
+TEST_F(SharedStoreMMapWeightCacheProviderTest, ModelsShareIdenticalWeights) {
+  MMapWeightCacheProvider provider_a;
+  BuildStore(provider_a);
+
+  MMapWeightCacheProvider provider_b;
+  ASSERT_TRUE(provider_b.LoadOrStartSharedStore(tmp_file.GetCPath(),
+                                                /*size_limit=*/0));
+  EXPECT_TRUE(provider_b.IsSharedStore());
+  provider_b.MapTensorIdentifiers(model_b.tensors.data(),
+                                  model_b.tensors.size(),
+                                  model_b.tensor_buffer_identifiers);
+
+  const auto& reference = model_a.packed_buffers.find(pack_id)->second;
+  const xnn_weights_cache_look_up_key look_up_key =
+      model_b.LookUpKey(kAlgoSeed, kWeightIndex, kBiasIndex);
+  const size_t offset = provider_b.LookUp(&look_up_key);
+  ASSERT_EQ(offset, reference.offset);
+  EXPECT_THAT(LightSpan<const uint8_t>(provider_b.OffsetToAddr(offset),
+                                       reference.buffer.size()),
+              ElementsAreArray(reference.buffer));
+
+  // Different weights are not found.
+  model_b.buffers[kWeightIndex][0] ^= 1;
+  MMapWeightCacheProvider provider_c;
+  ASSERT_TRUE(provider_c.LoadOrStartSharedStore(tmp_file.GetCPath(),
+                                                /*size_limit=*/0));
+  provider_c.MapTensorIdentifiers(model_b.tensors.data(),
+                                  model_b.tensors.size(),
+                                  model_b.tensor_buffer_identifiers);
+  EXPECT_EQ(provider_c.LookUp(&look_up_key), SIZE_MAX);
+}
+
+TEST_F(SharedStoreMMapWeightCacheProviderTest, FullStoreIsResetWhenUnused) {
+  {
+    MMapWeightCacheProvider provider_a;
+    BuildStore(provider_a);
+
+    if (TfLiteXNNPackDelegateCanUseInMemoryWeightCacheProvider()) {
+      // The store is in use, a full store can't be reset.
+      MMapWeightCacheProvider provider_b;
+      ASSERT_TRUE(provider_b.LoadOrStartSharedStore(tmp_file.GetCPath(),
+                                                    /*size_limit=*/1));
+      EXPECT_FALSE(provider_b.IsSharedStore());
+      EXPECT_EQ(provider_b.GetFilePath(), kInMemoryCachePath);
+    }
+  }
+
+  MMapWeightCacheProvider provider_b;
+  ASSERT_TRUE(provider_b.LoadOrStartSharedStore(tmp_file.GetCPath(),
+                                                /*size_limit=*/1));
+  EXPECT_TRUE(provider_b.IsSharedStore());
+  provider_b.MapTensorIdentifiers(model_b.tensors.data(),
+                                  model_b.tensors.size(),
+                                  model_b.tensor_buffer_identifiers);
+  const xnn_weights_cache_look_up_key look_up_key =
+      model_b.LookUpKey(kAlgoSeed, kWeightIndex, kBiasIndex);
+  EXPECT_EQ(provider_b.LookUp(&look_up_key), SIZE_MAX);
+}
+#endif  // !defined(_MSC_VER)
+
 }  // namespace
 }  // namespace tflite::xnnpack
@@ -544,8 +544,15 @@ class Delegate {
     // If no weight cache is provided, add one when requested.
     if (!options_.weights_cache) {
       if (options_.weight_cache_file_path) {
-        if (weight_cache_provider_.LoadOrStartBuild(
-                options_.weight_cache_file_path)) {
+        const bool shared_weight_cache =
+            (options_.flags &
+             TFLITE_XNNPACK_DELEGATE_FLAG_SHARED_WEIGHT_CACHE) != 0;
+        if (shared_weight_cache
+                ? weight_cache_provider_.LoadOrStartSharedStore(
+                      options_.weight_cache_file_path,
+                      options_.weight_cache_size_limit)
+                : weight_cache_provider_.LoadOrStartBuild(
+                      options_.weight_cache_file_path)) {
           options_.weights_cache =
               reinterpret_cast<TfLiteXNNPackDelegateWeightsCache*>(
                   weight_cache_provider_.GetCacheProvider().context);
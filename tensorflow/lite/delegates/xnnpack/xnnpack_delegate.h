@@ -45,6 +45,11 @@ extern "C" {
 // Enable XNNPack subgraph reshaping. This means that models with dynamic
 // tensors are supported and that inputs may be efficiently resized.
 #define TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_SUBGRAPH_RESHAPING 0x00000080
+// Use the weight cache file as a packed weight store shared by all the
+// delegates that open it, across models and processes. Packed weights are
+// identified by their content, so that models sharing weights share their
+// packed buffers.
+#define TFLITE_XNNPACK_DELEGATE_FLAG_SHARED_WEIGHT_CACHE 0x00000100
 
 struct TfLiteXNNPackDelegateWeightsCache;
 
@@ -61,6 +66,7 @@ typedef struct {
   // - TFLITE_XNNPACK_DELEGATE_FLAG_TRANSIENT_INDIRECTION_BUFFER
   // - TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_LATEST_OPERATORS
   // - TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_SUBGRAPH_RESHAPING
+  // - TFLITE_XNNPACK_DELEGATE_FLAG_SHARED_WEIGHT_CACHE
   uint32_t flags;
   // Cache for packed weights, can be shared between multiple instances of
   // delegates.
@@ -73,6 +79,10 @@ typedef struct {
   // To keep backwards compatibility with the previous caching mechanism, the
   // weight cache will only be loaded from this if `weight_cache` is undefined.
   const char* weight_cache_file_path;
+  // Size in bytes above which a shared weight cache (see
+  // TFLITE_XNNPACK_DELEGATE_FLAG_SHARED_WEIGHT_CACHE) is reset when no other
+  // delegate uses it, or not grown otherwise. 0 means no limit.
+  size_t weight_cache_size_limit;
 } TfLiteXNNPackDelegateOptions;
 
 // Returns true on systems that support running the in-memory weight cache
@@ -28,6 +28,8 @@ extern "C" void GenAIOpsRegisterer(::tflite::MutableOpResolver* resolver) {
                       tflite::ops::custom::Register_SDPA());
   resolver->AddCustom("odml.update_external_kv_cache",
                       tflite::ops::custom::Register_EXTERNAL_KV_CACHE());
+  resolver->AddCustom("odml.update_paged_kv_cache",
+                      tflite::ops::custom::Register_PAGED_KV_CACHE());
 }
 
 }  // namespace custom
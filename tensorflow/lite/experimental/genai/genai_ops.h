@@ -26,6 +26,11 @@ namespace custom {
 TfLiteRegistration* Register_KV_CACHE();
 TfLiteRegistration* Register_EXTERNAL_KV_CACHE();
 TfLiteRegistration* Register_SDPA();
+TfLiteRegistration* Register_PAGED_KV_CACHE();
+
+// The id of the `resource::PagedCacheBuffer` shared by the paged KV cache ops
+// of a subgraph. Sequences are forked and freed through it.
+constexpr int kPagedKVCacheResourceId = 44;
 
 extern "C" void GenAIOpsRegisterer(::tflite::MutableOpResolver* resolver);
 
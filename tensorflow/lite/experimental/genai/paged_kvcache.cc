@@ -0,0 +1,277 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/genai/genai_ops.h"
+#include "tensorflow/lite/experimental/resource/paged_cache_buffer.h"
+#include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/kernels/internal/runtime_shape.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+namespace llm {
+
+static const int kPositionTensor = 0;
+static const int kKeyTensor = 1;
+static const int kValueTensor = 2;
+static const int kSequenceTensor = 3;
+static const int kKeyPoolTensor = 0;
+static const int kValuePoolTensor = 1;
+static const int kBlockTableTensor = 2;
+static const int kRequiredNumDimensions = 4;
+static const int kDefaultMaxNumCacheEntries = 2048;
+static const int kDefaultNumTransformerLayers = 32;
+static const int kDefaultTransformerLayerId = 0;
+static const int kDefaultBlockSize = 16;
+
+struct PagedOpData {
+  int num_layers;
+  int layer_index;
+  // Maximum number of entries of a sequence.
+  int max_num_entries;
+  int block_size;
+  // Number of blocks in the pool of each layer.
+  int num_blocks;
+  // The cache that this Op doesn't own.
+  resource::PagedCacheBuffer* cache;
+  bool is_initialized;
+};
+
+void* PagedKVCacheInit(TfLiteContext* context, const char* buffer,
+                       size_t length) {
+  PagedOpData* op_data = new PagedOpData();
+  op_data->num_layers = -1;
+  op_data->layer_index = -1;
+  op_data->max_num_entries = -1;
+  op_data->block_size = -1;
+  op_data->num_blocks = -1;
+  op_data->cache = nullptr;
+  op_data->is_initialized = false;
+  return op_data;
+}
+
+int MaxBlocksPerSequence(const PagedOpData* op_data) {
+  return (op_data->max_num_entries + op_data->block_size - 1) /
+         op_data->block_size;
+}
+
+TfLiteStatus PagedKVCachePrepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 4);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 3);
+
+  PagedOpData* op_data = reinterpret_cast<PagedOpData*>(node->user_data);
+
+  if (!op_data->is_initialized) {
+    const uint8_t* buffer =
+        reinterpret_cast<const uint8_t*>(node->custom_initial_data);
+    const size_t length = node->custom_initial_data_size;
+    auto flexbuffer_map = flexbuffers::GetRoot(buffer, length).AsMap();
+    int32_t max_num_entries = flexbuffer_map["kv_cache_max"].AsInt32();
+    int32_t num_layers = flexbuffer_map["num_layers"].AsInt32();
+    int32_t layer_index = flexbuffer_map["layer_index"].AsInt32();
+    int32_t block_size = flexbuffer_map["block_size"].AsInt32();
+    int32_t num_blocks = flexbuffer_map["num_blocks"].AsInt32();
+    op_data->max_num_entries =
+        max_num_entries > 0 ? max_num_entries : kDefaultMaxNumCacheEntries;
+    op_data->num_layers =
+        num_layers > 0 ? num_layers : kDefaultNumTransformerLayers;
+    op_data->layer_index =
+        layer_index > 0 ? layer_index : kDefaultTransformerLayerId;
+    op_data->block_size = block_size > 0 ? block_size : kDefaultBlockSize;
+    // By default, the pool holds as much as one contiguous cache.
+    op_data->num_blocks =
+        num_blocks > 0 ? num_blocks : MaxBlocksPerSequence(op_data);
+    op_data->is_initialized = true;
+  }
+  TF_LITE_ENSURE(context, op_data->layer_index < op_data->num_layers);
+
+  const TfLiteTensor* position;
+  const TfLiteTensor* key;
+  const TfLiteTensor* value;
+  const TfLiteTensor* sequence;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kPositionTensor, &position));
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kKeyTensor, &key));
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kValueTensor, &value));
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kSequenceTensor, &sequence));
+
+  TF_LITE_ENSURE_EQ(context, position->type, kTfLiteInt64);
+  TF_LITE_ENSURE_EQ(context, key->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, value->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, sequence->type, kTfLiteInt32);
+  TF_LITE_ENSURE_EQ(context, NumElements(sequence), 1);
+  // Ensure Positions correspond to KV sequence length.
+  TF_LITE_ENSURE(context, NumDimensions(position) == 1);
+  TF_LITE_ENSURE(
+      context, GetTensorShape(position).Dims(0) == GetTensorShape(key).Dims(1));
+  // Support only (B, S, N, H) for now.
+  TF_LITE_ENSURE(context, NumDimensions(key) == kRequiredNumDimensions);
+  // Enforce Batch == 1 for now.
+  TF_LITE_ENSURE(context, GetTensorShape(key).Dims(0) == 1);
+  TF_LITE_ENSURE(context, HaveSameShapes(key, value));
+
+  const int num_heads = key->dims->data[2];
+  const int head_dim = key->dims->data[3];
+
+  // All the layers share one cache.
+  Subgraph* subgraph = reinterpret_cast<Subgraph*>(context->impl_);
+  auto& resources = subgraph->resources();
+  if (resources.count(kPagedKVCacheResourceId) == 0) {
+    auto* cache = new resource::PagedCacheBuffer();
+    resources.emplace(kPagedKVCacheResourceId, cache);
+    TF_LITE_ENSURE_OK(
+        context,
+        cache->Initialize(op_data->num_layers, op_data->num_blocks,
+                          op_data->block_size, num_heads * head_dim));
+  }
+  op_data->cache = static_cast<resource::PagedCacheBuffer*>(
+      resources.at(kPagedKVCacheResourceId).get());
+  TF_LITE_ENSURE(context, op_data->cache->IsInitialized());
+  TF_LITE_ENSURE_EQ(context, op_data->cache->num_layers(),
+                    op_data->num_layers);
+  TF_LITE_ENSURE_EQ(context, op_data->cache->block_size(),
+                    op_data->block_size);
+  TF_LITE_ENSURE_EQ(context, op_data->cache->entry_size(),
+                    num_heads * head_dim);
+
+  // The pools of the layer, as [num_blocks, block_size, num_heads, head_dim].
+  TfLiteTensor* key_pool;
+  TfLiteTensor* value_pool;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kKeyPoolTensor, &key_pool));
+  TF_LITE_ENSURE_OK(
+      context, GetOutputSafe(context, node, kValuePoolTensor, &value_pool));
+  key_pool->type = kTfLiteFloat32;
+  value_pool->type = kTfLiteFloat32;
+  // Custom data pointer to the resource pools.
+  key_pool->allocation_type = kTfLiteCustom;
+  value_pool->allocation_type = kTfLiteCustom;
+  key_pool->data.data = op_data->cache->GetKeys(op_data->layer_index);
+  value_pool->data.data = op_data->cache->GetValues(op_data->layer_index);
+  TfLiteIntArray* key_pool_dims = TfLiteIntArrayCreate(4);
+  key_pool_dims->data[0] = op_data->cache->num_blocks();
+  key_pool_dims->data[1] = op_data->block_size;
+  key_pool_dims->data[2] = num_heads;
+  key_pool_dims->data[3] = head_dim;
+  TfLiteIntArray* value_pool_dims = TfLiteIntArrayCopy(key_pool_dims);
+  TF_LITE_ENSURE_OK(context,
+                    context->ResizeTensor(context, key_pool, key_pool_dims));
+  TF_LITE_ENSURE_OK(
+      context, context->ResizeTensor(context, value_pool, value_pool_dims));
+
+  // The block table of the sequence, padded with -1.
+  TfLiteTensor* block_table;
+  TF_LITE_ENSURE_OK(
+      context, GetOutputSafe(context, node, kBlockTableTensor, &block_table));
+  block_table->type = kTfLiteInt32;
+  TfLiteIntArray* block_table_dims = TfLiteIntArrayCreate(1);
+  block_table_dims->data[0] = MaxBlocksPerSequence(op_data);
+  return context->ResizeTensor(context, block_table, block_table_dims);
+}
+
+void PagedKVCacheFree(TfLiteContext* context, void* buffer) {
+  delete static_cast<PagedOpData*>(buffer);
+}
+
+TfLiteStatus PagedKVCacheEval(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteTensor* position;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kPositionTensor, &position));
+  const TfLiteTensor* key;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kKeyTensor, &key));
+  const TfLiteTensor* value;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kValueTensor, &value));
+  const TfLiteTensor* sequence;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kSequenceTensor, &sequence));
+  TfLiteTensor* block_table;
+  TF_LITE_ENSURE_OK(
+      context, GetOutputSafe(context, node, kBlockTableTensor, &block_table));
+  PagedOpData* op_data = reinterpret_cast<PagedOpData*>(node->user_data);
+  resource::PagedCacheBuffer* cache = op_data->cache;
+  const int layer_index = op_data->layer_index;
+  const int sequence_id = sequence->data.i32[0];
+
+  // The inputs take up consecutive entries from the first position.
+  const int num_entries = GetTensorShape(key).Dims(1);
+  const int64_t first_entry = position->data.i64[0];
+  if (first_entry < 0 ||
+      first_entry + num_entries > op_data->max_num_entries) {
+    TF_LITE_KERNEL_LOG(context,
+                       "Positions must be in [0, %d) for a paged KV cache.",
+                       op_data->max_num_entries);
+    return kTfLiteError;
+  }
+  if (cache->PrepareWrite(sequence_id, layer_index, first_entry,
+                          num_entries) != kTfLiteOk) {
+    TF_LITE_KERNEL_LOG(context, "The paged KV cache has no free block left.");
+    return kTfLiteError;
+  }
+
+  // Put the keys and values in the blocks of their entries.
+  const std::vector<int>& blocks =
+      cache->GetBlockTable(sequence_id, layer_index);
+  const int block_size = op_data->block_size;
+  const int entry_size = cache->entry_size();
+  float* key_pool = cache->GetKeys(layer_index);
+  float* value_pool = cache->GetValues(layer_index);
+  for (int i = 0; i < num_entries; ++i) {
+    const int entry = first_entry + i;
+    const size_t pool_offset =
+        (static_cast<size_t>(blocks[entry / block_size]) * block_size +
+         entry % block_size) *
+        entry_size;
+    memcpy(key_pool + pool_offset, key->data.f + i * entry_size,
+           sizeof(float) * entry_size);
+    memcpy(value_pool + pool_offset, value->data.f + i * entry_size,
+           sizeof(float) * entry_size);
+  }
+  cache->SetNumEntries(
+      sequence_id, layer_index,
+      std::max<size_t>(cache->GetNumEntries(sequence_id, layer_index),
+                       first_entry + num_entries));
+
+  int32_t* block_table_data = GetTensorData<int32_t>(block_table);
+  const int max_blocks = NumElements(block_table);
+  std::fill_n(block_table_data, max_blocks, -1);
+  std::copy_n(blocks.begin(), std::min<int>(blocks.size(), max_blocks),
+              block_table_data);
+  return kTfLiteOk;
+}
+
+}  // namespace llm
+
+TfLiteRegistration* Register_PAGED_KV_CACHE() {
+  static TfLiteRegistration r = {llm::PagedKVCacheInit, llm::PagedKVCacheFree,
+                                 llm::PagedKVCachePrepare,
+                                 llm::PagedKVCacheEval};
+  return &r;
+}
+
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
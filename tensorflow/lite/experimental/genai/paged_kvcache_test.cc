@@ -0,0 +1,228 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/lite/c/c_api_types.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/genai/genai_ops.h"
+#include "tensorflow/lite/experimental/resource/paged_cache_buffer.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+// A cache of up to 8 entries per sequence, in blocks of 2 entries of 2 floats.
+class PagedCacheOpModel : public SingleOpModel {
+ public:
+  PagedCacheOpModel() {
+    pos_ = AddInput({TensorType_INT64, {2}});
+    k_ = AddInput({TensorType_FLOAT32, {1, 2, 1, 2}});
+    v_ = AddInput({TensorType_FLOAT32, {1, 2, 1, 2}});
+    seq_ = AddInput({TensorType_INT32, {1}});
+    kpool_ = AddOutput(TensorType_FLOAT32);
+    vpool_ = AddOutput(TensorType_FLOAT32);
+    block_table_ = AddOutput(TensorType_INT32);
+    flexbuffers::Builder fbb;
+    fbb.Map([&]() {
+      fbb.Int("kv_cache_max", 8);
+      fbb.Int("num_layers", 1);
+      fbb.Int("block_size", 2);
+      fbb.Int("num_blocks", 8);
+    });
+    fbb.Finish();
+    SetCustomOp("PAGED_KV_CACHE", fbb.GetBuffer(),
+                ops::custom::Register_PAGED_KV_CACHE);
+
+    BuildInterpreter(
+        {GetShape(pos_), GetShape(k_), GetShape(v_), GetShape(seq_)});
+  }
+
+  TfLiteStatus Write(int sequence, int64_t position,
+                     const std::vector<float>& key,
+                     const std::vector<float>& value) {
+    PopulateTensor(pos_, {position, position + 1});
+    PopulateTensor(k_, key);
+    PopulateTensor(v_, value);
+    PopulateTensor(seq_, {sequence});
+    return Invoke();
+  }
+
+  std::vector<float> GetKeyPool() { return ExtractVector<float>(kpool_); }
+  std::vector<float> GetValuePool() { return ExtractVector<float>(vpool_); }
+  std::vector<int32_t> GetBlockTable() {
+    return ExtractVector<int32_t>(block_table_);
+  }
+
+  resource::PagedCacheBuffer* GetCache() {
+    return static_cast<resource::PagedCacheBuffer*>(
+        interpreter_->primary_subgraph()
+            .resources()
+            .at(ops::custom::kPagedKVCacheResourceId)
+            .get());
+  }
+
+ protected:
+  int pos_;
+  int k_;
+  int v_;
+  int seq_;
+  int kpool_;
+  int vpool_;
+  int block_table_;
+};
+
+// Returns the 2 floats of `entry` in `pool` according to `block_table`.
+std::vector<float> Entry(const std::vector<float>& pool,
+                         const std::vector<int32_t>& block_table, int entry) {
+  const int offset = (block_table[entry / 2] * 2 + entry % 2) * 2;
+  return {pool[offset], pool[offset + 1]};
+}
+
+TEST(PagedCacheOpTest, WritesEntriesInBlocks) {
+  PagedCacheOpModel m;
+  ASSERT_EQ(m.Write(/*sequence=*/0, /*position=*/0, {1, 2, 3, 4},
+                    {5, 6, 7, 8}),
+            kTfLiteOk);
+  ASSERT_EQ(m.Write(/*sequence=*/0, /*position=*/2, {9, 10, 11, 12},
+                    {13, 14, 15, 16}),
+            kTfLiteOk);
+
+  const std::vector<int32_t> block_table = m.GetBlockTable();
+  EXPECT_THAT(block_table, ElementsAre(0, 1, -1, -1));
+  EXPECT_EQ(m.GetKeyPool().size(), size_t{8 * 2 * 2});
+  EXPECT_THAT(Entry(m.GetKeyPool(), block_table, 1), ElementsAre(3, 4));
+  EXPECT_THAT(Entry(m.GetKeyPool(), block_table, 3), ElementsAre(11, 12));
+  EXPECT_THAT(Entry(m.GetValuePool(), block_table, 2), ElementsAre(13, 14));
+
+  // Another sequence gets blocks of its own.
+  ASSERT_EQ(m.Write(/*sequence=*/1, /*position=*/4, {0, 0, 0, 0},
+                    {0, 0, 0, 0}),
+            kTfLiteOk);
+  EXPECT_THAT(m.GetBlockTable(), ElementsAre(2, 3, 4, -1));
+}
+
+TEST(PagedCacheOpTest, ForkedSequenceSharesPrefix) {
+  PagedCacheOpModel m;
+  ASSERT_EQ(m.Write(/*sequence=*/0, /*position=*/0, {1, 2, 3, 4},
+                    {5, 6, 7, 8}),
+            kTfLiteOk);
+  ASSERT_EQ(m.Write(/*sequence=*/0, /*position=*/2, {9, 10, 11, 12},
+                    {13, 14, 15, 16}),
+            kTfLiteOk);
+  const std::vector<int32_t> parent_table = m.GetBlockTable();
+
+  // The fork keeps the first 3 entries, and overwrites the 4th.
+  ASSERT_EQ(m.GetCache()->ForkSequence(/*parent=*/0, /*sequence=*/1, 3),
+            kTfLiteOk);
+  ASSERT_EQ(m.Write(/*sequence=*/1, /*position=*/3, {20, 21, 22, 23},
+                    {24, 25, 26, 27}),
+            kTfLiteOk);
+  const std::vector<int32_t> table = m.GetBlockTable();
+  EXPECT_EQ(table[0], parent_table[0]);
+  EXPECT_NE(table[1], parent_table[1]);
+  EXPECT_THAT(Entry(m.GetKeyPool(), table, 2), ElementsAre(9, 10));
+  EXPECT_THAT(Entry(m.GetKeyPool(), table, 3), ElementsAre(20, 21));
+  // The parent still has its own entries.
+  EXPECT_THAT(Entry(m.GetKeyPool(), parent_table, 3), ElementsAre(11, 12));
+
+  m.GetCache()->FreeSequence(1);
+  EXPECT_EQ(m.GetCache()->GetNumFreeBlocks(0), 6);
+}
+
+TEST(PagedCacheOpTest, FailsOutOfRange) {
+  PagedCacheOpModel m;
+  EXPECT_EQ(m.Write(/*sequence=*/0, /*position=*/7, {1, 2, 3, 4},
+                    {5, 6, 7, 8}),
+            kTfLiteError);
+}
+
+// Attention of 2 query heads over a single KV head, in blocks of 2 entries.
+class PagedSDPAOpModel : public SingleOpModel {
+ public:
+  PagedSDPAOpModel(int num_blocks, int table_size) {
+    q_ = AddInput({TensorType_FLOAT32, {1, 1, 2, 2}});
+    kpool_ = AddInput({TensorType_FLOAT32, {num_blocks, 2, 1, 2}});
+    vpool_ = AddInput({TensorType_FLOAT32, {num_blocks, 2, 1, 2}});
+    mask_ = AddInput({TensorType_FLOAT32, {1, 1, 1, table_size * 2}});
+    block_table_ = AddInput({TensorType_INT32, {table_size}});
+    output_ = AddOutput({TensorType_FLOAT32, {1, 1, 2, 2}});
+    SetCustomOp("SDPA", {}, ops::custom::Register_SDPA);
+
+    BuildInterpreter({GetShape(q_), GetShape(kpool_), GetShape(vpool_),
+                      GetShape(mask_), GetShape(block_table_)});
+  }
+
+  std::vector<float> Run(const std::vector<float>& query,
+                         const std::vector<float>& keys,
+                         const std::vector<float>& values,
+                         const std::vector<float>& mask,
+                         const std::vector<int32_t>& block_table) {
+    PopulateTensor(q_, query);
+    PopulateTensor(kpool_, keys);
+    PopulateTensor(vpool_, values);
+    PopulateTensor(mask_, mask);
+    PopulateTensor(block_table_, block_table);
+    EXPECT_EQ(Invoke(), kTfLiteOk);
+    return ExtractVector<float>(output_);
+  }
+
+ protected:
+  int q_;
+  int kpool_;
+  int vpool_;
+  int mask_;
+  int block_table_;
+  int output_;
+};
+
+TEST(PagedSDPAOpTest, AttendsToEntriesOfBlockTable) {
+  PagedSDPAOpModel m(/*num_blocks=*/3, /*table_size=*/2);
+  // Equal keys, so each head averages the values of its entries. Block 1 is
+  // not part of the sequence.
+  const std::vector<float> keys(3 * 2 * 2, 1.0f);
+  const std::vector<float> values = {1, 2, 3, 4,  100, 100, 100, 100,
+                                     5, 6, 7, 8};
+  EXPECT_THAT(m.Run({1, 0, 0, 1}, keys, values, {0, 0, 0, 0}, {2, 0}),
+              ElementsAreArray(ArrayFloatNear({4, 5, 4, 5})));
+
+  // Masked and missing entries are left out.
+  const float kMasked = -std::numeric_limits<float>::infinity();
+  EXPECT_THAT(m.Run({1, 0, 0, 1}, keys, values, {0, kMasked, 0, 0}, {2, -1}),
+              ElementsAreArray(ArrayFloatNear({5, 6, 5, 6})));
+}
+
+TEST(PagedSDPAOpTest, WeightsEntriesBySoftmaxOfScores) {
+  PagedSDPAOpModel m(/*num_blocks=*/1, /*table_size=*/1);
+  const std::vector<float> keys = {1, 0, 0, 1};
+  const std::vector<float> values = {1, 0, 0, 1};
+  // Scores are (2, 0) / sqrt(2) for the first head, and (0, 2) / sqrt(2) for
+  // the second.
+  const float w = 1.0f / (1.0f + std::exp(-2.0f / std::sqrt(2.0f)));
+  EXPECT_THAT(m.Run({2, 0, 0, 2}, keys, values, {0, 0}, {0}),
+              ElementsAreArray(ArrayFloatNear({w, 1 - w, 1 - w, w})));
+}
+
+}  // namespace
+}  // namespace tflite
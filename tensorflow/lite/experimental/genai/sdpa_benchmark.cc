@@ -0,0 +1,86 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"  // from @com_google_benchmark
+#include "tensorflow/lite/c/c_api_types.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/genai/genai_ops.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+// Attention of 32 query heads over 8 KV heads of 128 floats, e.g. during the
+// decoding (a single query) or the prefill (many queries) of an LLM.
+class SDPABenchmarkModel : public SingleOpModel {
+ public:
+  SDPABenchmarkModel(int seq_len, int kv_len, int num_threads) {
+    const std::vector<int> q_shape = {1, seq_len, 32, 128};
+    const std::vector<int> kv_shape = {1, kv_len, 8, 128};
+    const std::vector<int> mask_shape = {1, 1, seq_len, kv_len};
+    q_ = AddInput({TensorType_FLOAT32, q_shape});
+    k_ = AddInput({TensorType_FLOAT32, kv_shape});
+    v_ = AddInput({TensorType_FLOAT32, kv_shape});
+    mask_ = AddInput({TensorType_FLOAT32, mask_shape});
+    AddOutput({TensorType_FLOAT32, q_shape});
+    SetCustomOp("SDPA", {}, ops::custom::Register_SDPA);
+    BuildInterpreter({q_shape, kv_shape, kv_shape, mask_shape}, num_threads,
+                     /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+    PopulateTensor(q_, std::vector<float>(seq_len * 32 * 128, 0.1f));
+    PopulateTensor(k_, std::vector<float>(kv_len * 8 * 128, 0.2f));
+    PopulateTensor(v_, std::vector<float>(kv_len * 8 * 128, 0.3f));
+    PopulateTensor(mask_, std::vector<float>(seq_len * kv_len, 0.0f));
+  }
+
+  // The size of the arena of the model, inputs and outputs included.
+  size_t GetArenaSize() {
+    Subgraph::SubgraphAllocInfo alloc_info;
+    interpreter_->primary_subgraph().GetMemoryAllocInfo(&alloc_info);
+    return alloc_info.arena_size;
+  }
+
+ private:
+  int q_;
+  int k_;
+  int v_;
+  int mask_;
+};
+
+// Args are the number of queries, the context length and the number of
+// threads.
+void BM_SDPA(benchmark::State& state) {
+  SDPABenchmarkModel model(state.range(0), state.range(1), state.range(2));
+  for (auto _ : state) {
+    if (model.Invoke() != kTfLiteOk) {
+      state.SkipWithError("Invoke failed");
+      break;
+    }
+  }
+  state.counters["arena_bytes"] = model.GetArenaSize();
+}
+
+BENCHMARK(BM_SDPA)
+    ->ArgNames({"seq_len", "kv_len", "threads"})
+    ->ArgsProduct({{1, 128}, {512, 2048, 8192}, {1, 4}});
+
+}  // namespace
+}  // namespace tflite
+
+BENCHMARK_MAIN();
@@ -0,0 +1,222 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/lite/c/c_api_types.h"
+#include "tensorflow/lite/experimental/genai/genai_ops.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+struct AttentionShape {
+  int batch;
+  int seq_len;
+  int num_heads;
+  int kv_heads;
+  int head_dim;
+  int kv_len;
+};
+
+class SDPAOpModel : public SingleOpModel {
+ public:
+  // `mask_shape` is empty for causal attention without a mask.
+  SDPAOpModel(const AttentionShape& shape, const std::vector<int>& mask_shape,
+              bool causal, int num_threads) {
+    const std::vector<int> q_shape = {shape.batch, shape.seq_len,
+                                      shape.num_heads, shape.head_dim};
+    const std::vector<int> kv_shape = {shape.batch, shape.kv_len,
+                                       shape.kv_heads, shape.head_dim};
+    q_ = AddInput({TensorType_FLOAT32, q_shape});
+    k_ = AddInput({TensorType_FLOAT32, kv_shape});
+    v_ = AddInput({TensorType_FLOAT32, kv_shape});
+    mask_ = mask_shape.empty() ? AddNullInput()
+                               : AddInput({TensorType_FLOAT32, mask_shape});
+    output_ = AddOutput({TensorType_FLOAT32, q_shape});
+    flexbuffers::Builder fbb;
+    fbb.Map([&]() { fbb.Bool("causal", causal); });
+    fbb.Finish();
+    SetCustomOp("SDPA", fbb.GetBuffer(), ops::custom::Register_SDPA);
+
+    BuildInterpreter({q_shape, kv_shape, kv_shape, mask_shape}, num_threads,
+                     /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/true);
+  }
+
+  std::vector<float> Run(const std::vector<float>& query,
+                         const std::vector<float>& key,
+                         const std::vector<float>& value,
+                         const std::vector<float>& mask) {
+    PopulateTensor(q_, query);
+    PopulateTensor(k_, key);
+    PopulateTensor(v_, value);
+    if (!mask.empty()) PopulateTensor(mask_, mask);
+    EXPECT_EQ(Invoke(), kTfLiteOk);
+    return ExtractVector<float>(output_);
+  }
+
+ protected:
+  int q_;
+  int k_;
+  int v_;
+  int mask_;
+  int output_;
+};
+
+std::vector<float> RandomVector(int size, std::mt19937* random) {
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  std::vector<float> result(size);
+  for (float& x : result) x = distribution(*random);
+  return result;
+}
+
+// Computes the attention naively, the mask being [batch, 1, seq_len, kv_len]
+// or empty.
+std::vector<float> ReferenceAttention(const AttentionShape& shape,
+                                      const std::vector<float>& query,
+                                      const std::vector<float>& key,
+                                      const std::vector<float>& value,
+                                      const std::vector<float>& mask,
+                                      bool causal) {
+  const int s_len = shape.seq_len;
+  const int h_dim = shape.head_dim;
+  const int t_len = shape.kv_len;
+  const float scale = 1.0f / std::sqrt(static_cast<float>(h_dim));
+  std::vector<float> output(query.size());
+  std::vector<float> scores(t_len);
+  for (int b = 0; b < shape.batch; ++b) {
+    for (int s = 0; s < s_len; ++s) {
+      for (int h = 0; h < shape.num_heads; ++h) {
+        const int kv_head = h / (shape.num_heads / shape.kv_heads);
+        const float* q =
+            &query[((b * s_len + s) * shape.num_heads + h) * h_dim];
+        float max_score = -std::numeric_limits<float>::infinity();
+        for (int t = 0; t < t_len; ++t) {
+          const float* k = &key[((b * t_len + t) * shape.kv_heads + kv_head) *
+                                h_dim];
+          float score = 0.0f;
+          for (int d = 0; d < h_dim; ++d) score += q[d] * k[d];
+          score *= scale;
+          if (!mask.empty()) score += mask[(b * s_len + s) * t_len + t];
+          if (causal && t > t_len - s_len + s) {
+            score = -std::numeric_limits<float>::infinity();
+          }
+          scores[t] = score;
+          max_score = std::max(max_score, score);
+        }
+        float sum = 0.0f;
+        for (float& score : scores) {
+          score = std::exp(score - max_score);
+          sum += score;
+        }
+        float* out = &output[((b * s_len + s) * shape.num_heads + h) * h_dim];
+        for (int t = 0; t < t_len; ++t) {
+          const float* v =
+              &value[((b * t_len + t) * shape.kv_heads + kv_head) * h_dim];
+          for (int d = 0; d < h_dim; ++d) out[d] += scores[t] / sum * v[d];
+        }
+      }
+    }
+  }
+  return output;
+}
+
+void TestMatchesReference(const AttentionShape& shape, bool with_mask,
+                          bool causal, int num_threads) {
+  std::mt19937 random(0);
+  const int q_size =
+      shape.batch * shape.seq_len * shape.num_heads * shape.head_dim;
+  const int kv_size =
+      shape.batch * shape.kv_len * shape.kv_heads * shape.head_dim;
+  const std::vector<float> query = RandomVector(q_size, &random);
+  const std::vector<float> key = RandomVector(kv_size, &random);
+  const std::vector<float> value = RandomVector(kv_size, &random);
+  std::vector<float> mask;
+  std::vector<int> mask_shape;
+  if (with_mask) {
+    mask = RandomVector(shape.batch * shape.seq_len * shape.kv_len, &random);
+    mask_shape = {shape.batch, 1, shape.seq_len, shape.kv_len};
+  }
+
+  SDPAOpModel m(shape, mask_shape, causal, num_threads);
+  EXPECT_THAT(m.Run(query, key, value, mask),
+              ElementsAreArray(ArrayFloatNear(ReferenceAttention(
+                  shape, query, key, value, mask, causal))));
+}
+
+TEST(SDPAOpTest, MultiHeadAttention) {
+  TestMatchesReference({/*batch=*/1, /*seq_len=*/3, /*num_heads=*/4,
+                        /*kv_heads=*/4, /*head_dim=*/8, /*kv_len=*/10},
+                       /*with_mask=*/true, /*causal=*/false,
+                       /*num_threads=*/1);
+}
+
+TEST(SDPAOpTest, GroupedQueryAttention) {
+  TestMatchesReference({/*batch=*/2, /*seq_len=*/2, /*num_heads=*/8,
+                        /*kv_heads=*/2, /*head_dim=*/4, /*kv_len=*/7},
+                       /*with_mask=*/true, /*causal=*/false,
+                       /*num_threads=*/1);
+}
+
+TEST(SDPAOpTest, MultiQueryAttentionOverSeveralKeyBlocks) {
+  TestMatchesReference({/*batch=*/1, /*seq_len=*/1, /*num_heads=*/4,
+                        /*kv_heads=*/1, /*head_dim=*/16, /*kv_len=*/300},
+                       /*with_mask=*/true, /*causal=*/false,
+                       /*num_threads=*/1);
+}
+
+TEST(SDPAOpTest, CausalWithoutMask) {
+  TestMatchesReference({/*batch=*/1, /*seq_len=*/70, /*num_heads=*/2,
+                        /*kv_heads=*/2, /*head_dim=*/4, /*kv_len=*/70},
+                       /*with_mask=*/false, /*causal=*/true,
+                       /*num_threads=*/1);
+}
+
+TEST(SDPAOpTest, CausalWithMask) {
+  TestMatchesReference({/*batch=*/1, /*seq_len=*/4, /*num_heads=*/2,
+                        /*kv_heads=*/1, /*head_dim=*/4, /*kv_len=*/9},
+                       /*with_mask=*/true, /*causal=*/true,
+                       /*num_threads=*/1);
+}
+
+TEST(SDPAOpTest, MultithreadedMatchesReference) {
+  TestMatchesReference({/*batch=*/2, /*seq_len=*/3, /*num_heads=*/6,
+                        /*kv_heads=*/3, /*head_dim=*/8, /*kv_len=*/100},
+                       /*with_mask=*/true, /*causal=*/true,
+                       /*num_threads=*/4);
+}
+
+TEST(SDPAOpTest, FullyMaskedQueryOutputsZeros) {
+  const AttentionShape shape = {/*batch=*/1, /*seq_len=*/1, /*num_heads=*/1,
+                                /*kv_heads=*/1, /*head_dim=*/2, /*kv_len=*/2};
+  const float kMasked = -std::numeric_limits<float>::infinity();
+  SDPAOpModel m(shape, {1, 1, 1, 2}, /*causal=*/false, /*num_threads=*/1);
+  EXPECT_THAT(m.Run({1, 2}, {3, 4, 5, 6}, {7, 8, 9, 10}, {kMasked, kMasked}),
+              ElementsAreArray({0.0f, 0.0f}));
+}
+
+}  // namespace
+}  // namespace tflite
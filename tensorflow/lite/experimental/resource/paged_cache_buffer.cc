@@ -0,0 +1,168 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/resource/paged_cache_buffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+
+namespace tflite {
+namespace resource {
+
+TfLiteStatus PagedCacheBuffer::Initialize(int num_layers, int num_blocks,
+                                          int block_size, int entry_size) {
+  if (num_layers <= 0 || num_blocks <= 0 || block_size <= 0 ||
+      entry_size <= 0) {
+    return kTfLiteError;
+  }
+  num_blocks_ = num_blocks;
+  block_size_ = block_size;
+  entry_size_ = entry_size;
+  const size_t pool_size =
+      static_cast<size_t>(num_blocks) * block_size * entry_size;
+  layers_.resize(num_layers);
+  for (Layer& layer : layers_) {
+    layer.keys.reset(new float[pool_size]);
+    layer.values.reset(new float[pool_size]);
+    memset(layer.keys.get(), 0, sizeof(float) * pool_size);
+    memset(layer.values.get(), 0, sizeof(float) * pool_size);
+    layer.ref_counts.assign(num_blocks, 0);
+    // Hand out the lowest blocks first.
+    layer.free_blocks.resize(num_blocks);
+    for (int i = 0; i < num_blocks; ++i) {
+      layer.free_blocks[i] = num_blocks - 1 - i;
+    }
+  }
+  return kTfLiteOk;
+}
+
+size_t PagedCacheBuffer::GetMemoryUsage() {
+  return 2 * sizeof(float) * layers_.size() * num_blocks_ * block_size_ *
+         entry_size_;
+}
+
+const std::vector<int>& PagedCacheBuffer::GetBlockTable(int sequence,
+                                                        int layer) const {
+  static const std::vector<int>* const kEmpty = new std::vector<int>();
+  auto it = sequences_.find(sequence);
+  if (it == sequences_.end()) return *kEmpty;
+  return it->second[layer].block_table;
+}
+
+size_t PagedCacheBuffer::GetNumEntries(int sequence, int layer) const {
+  auto it = sequences_.find(sequence);
+  if (it == sequences_.end()) return 0;
+  return it->second[layer].num_entries;
+}
+
+TfLiteStatus PagedCacheBuffer::PrepareWrite(int sequence, int layer,
+                                            int first, int count) {
+  if (first < 0 || count < 0) return kTfLiteError;
+  if (count == 0) return kTfLiteOk;
+  std::vector<SequenceLayer>& sequence_layers = sequences_[sequence];
+  sequence_layers.resize(layers_.size());
+  std::vector<int>& block_table = sequence_layers[layer].block_table;
+  Layer& pool = layers_[layer];
+  const int first_block = first / block_size_;
+  const int end_block = (first + count + block_size_ - 1) / block_size_;
+  if (end_block > static_cast<int>(block_table.size())) {
+    block_table.resize(end_block, -1);
+  }
+  const size_t block_floats = static_cast<size_t>(block_size_) * entry_size_;
+  for (int i = 0; i < end_block; ++i) {
+    const int block = block_table[i];
+    // Blocks before the written ones are allocated too, so that the table
+    // has no holes.
+    if (block >= 0 && (i < first_block || pool.ref_counts[block] == 1)) {
+      continue;
+    }
+    if (pool.free_blocks.empty()) return kTfLiteError;
+    const int new_block = pool.free_blocks.back();
+    pool.free_blocks.pop_back();
+    pool.ref_counts[new_block] = 1;
+    if (block >= 0) {
+      // Copy on write.
+      memcpy(pool.keys.get() + new_block * block_floats,
+             pool.keys.get() + block * block_floats,
+             sizeof(float) * block_floats);
+      memcpy(pool.values.get() + new_block * block_floats,
+             pool.values.get() + block * block_floats,
+             sizeof(float) * block_floats);
+      --pool.ref_counts[block];
+    }
+    block_table[i] = new_block;
+  }
+  return kTfLiteOk;
+}
+
+void PagedCacheBuffer::SetNumEntries(int sequence, int layer, size_t count) {
+  std::vector<SequenceLayer>& sequence_layers = sequences_[sequence];
+  sequence_layers.resize(layers_.size());
+  SequenceLayer& sequence_layer = sequence_layers[layer];
+  TFLITE_DCHECK(count <= sequence_layer.block_table.size() * block_size_);
+  sequence_layer.num_entries = count;
+}
+
+TfLiteStatus PagedCacheBuffer::ForkSequence(int parent, int sequence,
+                                            size_t num_entries) {
+  if (parent == sequence) return kTfLiteError;
+  FreeSequence(sequence);
+  auto it = sequences_.find(parent);
+  if (it == sequences_.end()) return kTfLiteOk;
+  std::vector<SequenceLayer> forked(layers_.size());
+  for (int layer = 0; layer < num_layers(); ++layer) {
+    const SequenceLayer& parent_layer = it->second[layer];
+    SequenceLayer& forked_layer = forked[layer];
+    forked_layer.num_entries = std::min(num_entries, parent_layer.num_entries);
+    const size_t num_shared =
+        (forked_layer.num_entries + block_size_ - 1) / block_size_;
+    forked_layer.block_table.assign(
+        parent_layer.block_table.begin(),
+        parent_layer.block_table.begin() + num_shared);
+    for (int block : forked_layer.block_table) {
+      ++layers_[layer].ref_counts[block];
+    }
+  }
+  sequences_[sequence] = std::move(forked);
+  return kTfLiteOk;
+}
+
+void PagedCacheBuffer::FreeSequence(int sequence) {
+  auto it = sequences_.find(sequence);
+  if (it == sequences_.end()) return;
+  for (int layer = 0; layer < num_layers(); ++layer) {
+    ReleaseBlocks(layer, it->second[layer].block_table);
+  }
+  sequences_.erase(it);
+}
+
+void PagedCacheBuffer::ReleaseBlocks(int layer,
+                                     const std::vector<int>& blocks) {
+  Layer& pool = layers_[layer];
+  for (int block : blocks) {
+    if (block >= 0 && --pool.ref_counts[block] == 0) {
+      pool.free_blocks.push_back(block);
+    }
+  }
+}
+
+}  // namespace resource
+}  // namespace tflite
@@ -0,0 +1,109 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_PAGED_CACHE_BUFFER_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_PAGED_CACHE_BUFFER_H_
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/experimental/resource/resource_base.h"
+
+namespace tflite {
+namespace resource {
+
+/// WARNING: Experimental interface, subject to change.
+// A paged cache for the keys and values of the attention layers of a
+// transformer, shared by several sequences (e.g. decoding sessions).
+//
+// Each layer has a pool of fixed-size blocks of entries, and each sequence a
+// block table per layer mapping its entries to blocks. Blocks are allocated as
+// sequences grow, so a sequence only takes the memory it uses. Sequences
+// forked from another one share its blocks (e.g. of a common system prompt)
+// until either writes to them, which copies the block first.
+class PagedCacheBuffer : public ResourceBase {
+ public:
+  PagedCacheBuffer() = default;
+  PagedCacheBuffer(const PagedCacheBuffer &) = delete;
+  PagedCacheBuffer &operator=(const PagedCacheBuffer &) = delete;
+
+  // Allocates `num_blocks` blocks for each of `num_layers` layers, each
+  // holding the keys and the values of `block_size` entries of `entry_size`
+  // floats.
+  TfLiteStatus Initialize(int num_layers, int num_blocks, int block_size,
+                          int entry_size);
+  bool IsInitialized() override { return !layers_.empty(); }
+  size_t GetMemoryUsage() override;
+
+  int num_layers() const { return layers_.size(); }
+  int num_blocks() const { return num_blocks_; }
+  int block_size() const { return block_size_; }
+  int entry_size() const { return entry_size_; }
+
+  // The keys and values of `layer`, as [num_blocks, block_size, entry_size].
+  float *GetKeys(int layer) { return layers_[layer].keys.get(); }
+  float *GetValues(int layer) { return layers_[layer].values.get(); }
+
+  // Returns the blocks holding the entries of `sequence` at `layer`, in
+  // order. Empty for unknown sequences.
+  const std::vector<int> &GetBlockTable(int sequence, int layer) const;
+  size_t GetNumEntries(int sequence, int layer) const;
+  int GetNumFreeBlocks(int layer) const {
+    return layers_[layer].free_blocks.size();
+  }
+
+  // Makes the entries [first, first + count) of `sequence` at `layer`
+  // writable: allocates their blocks, and copies the ones shared with other
+  // sequences. Fails if the pool has no free block left.
+  TfLiteStatus PrepareWrite(int sequence, int layer, int first, int count);
+  // Sets the number of entries of `sequence` at `layer`, which must have
+  // their blocks.
+  void SetNumEntries(int sequence, int layer, size_t count);
+
+  // Starts `sequence` with the first `num_entries` entries of `parent` at
+  // all layers, sharing their blocks. Replaces the entries `sequence` had.
+  TfLiteStatus ForkSequence(int parent, int sequence, size_t num_entries);
+  // Releases the blocks of `sequence`.
+  void FreeSequence(int sequence);
+
+ private:
+  struct Layer {
+    std::unique_ptr<float[]> keys;
+    std::unique_ptr<float[]> values;
+    // Number of block tables referencing each block.
+    std::vector<int> ref_counts;
+    std::vector<int> free_blocks;
+  };
+  struct SequenceLayer {
+    std::vector<int> block_table;
+    size_t num_entries = 0;
+  };
+
+  void ReleaseBlocks(int layer, const std::vector<int> &blocks);
+
+  int num_blocks_ = 0;
+  int block_size_ = 0;
+  int entry_size_ = 0;
+  std::vector<Layer> layers_;
+  // The layers of each sequence.
+  std::unordered_map<int, std::vector<SequenceLayer>> sequences_;
+};
+
+}  // namespace resource
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_PAGED_CACHE_BUFFER_H_
@@ -0,0 +1,126 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/resource/cache_buffer.h"
+
+#include "tensorflow/lite/experimental/resource/paged_cache_buffer.h"
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/c_api_types.h"
+
+namespace tflite {
+namespace resource {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Returns the offset of entry `index` of `sequence` in the pool of `layer`.
+int EntryOffset(const PagedCacheBuffer& cache, int sequence, int layer,
+                int index) {
+  const std::vector<int>& block_table = cache.GetBlockTable(sequence, layer);
+  const int block = block_table[index / cache.block_size()];
+  return (block * cache.block_size() + index % cache.block_size()) *
+         cache.entry_size();
+}
+
+// Writes `value` to all the keys and values of entry `index` of `sequence`.
+void WriteEntry(PagedCacheBuffer& cache, int sequence, int layer, int index,
+                float value) {
+  const int offset = EntryOffset(cache, sequence, layer, index);
+  for (int i = 0; i < cache.entry_size(); ++i) {
+    cache.GetKeys(layer)[offset + i] = value;
+    cache.GetValues(layer)[offset + i] = value;
+  }
+}
+
+float ReadKey(PagedCacheBuffer& cache, int sequence, int layer, int index) {
+  return cache.GetKeys(layer)[EntryOffset(cache, sequence, layer, index)];
+}
+
+TEST(PagedCacheBufferTest, AllocatesBlocksAsSequencesGrow) {
+  PagedCacheBuffer cache;
+  ASSERT_EQ(cache.Initialize(/*num_layers=*/2, /*num_blocks=*/4,
+                             /*block_size=*/2, /*entry_size=*/3),
+            kTfLiteOk);
+  EXPECT_EQ(cache.GetMemoryUsage(), 2 * sizeof(float) * 2 * 4 * 2 * 3);
+
+  ASSERT_EQ(cache.PrepareWrite(/*sequence=*/7, /*layer=*/0, 0, 3), kTfLiteOk);
+  cache.SetNumEntries(7, 0, 3);
+  EXPECT_THAT(cache.GetBlockTable(7, 0), ElementsAre(0, 1));
+  EXPECT_EQ(cache.GetNumEntries(7, 0), 3);
+  EXPECT_EQ(cache.GetNumFreeBlocks(0), 2);
+  // Other layers are not affected.
+  EXPECT_TRUE(cache.GetBlockTable(7, 1).empty());
+  EXPECT_EQ(cache.GetNumFreeBlocks(1), 4);
+
+  // Writing in an allocated block needs no new block.
+  ASSERT_EQ(cache.PrepareWrite(7, 0, 3, 1), kTfLiteOk);
+  EXPECT_EQ(cache.GetNumFreeBlocks(0), 2);
+
+  ASSERT_EQ(cache.PrepareWrite(8, 0, 0, 4), kTfLiteOk);
+  EXPECT_EQ(cache.GetNumFreeBlocks(0), 0);
+  EXPECT_EQ(cache.PrepareWrite(8, 0, 4, 1), kTfLiteError);
+
+  cache.FreeSequence(7);
+  EXPECT_EQ(cache.GetNumFreeBlocks(0), 2);
+  EXPECT_TRUE(cache.GetBlockTable(7, 0).empty());
+}
+
+TEST(PagedCacheBufferTest, ForkedSequencesCopyOnWrite) {
+  PagedCacheBuffer cache;
+  ASSERT_EQ(cache.Initialize(/*num_layers=*/1, /*num_blocks=*/8,
+                             /*block_size=*/2, /*entry_size=*/1),
+            kTfLiteOk);
+  ASSERT_EQ(cache.PrepareWrite(/*sequence=*/0, /*layer=*/0, 0, 4), kTfLiteOk);
+  for (int i = 0; i < 4; ++i) WriteEntry(cache, 0, 0, i, i);
+  cache.SetNumEntries(0, 0, 4);
+
+  // The fork shares the blocks of the first 3 entries.
+  ASSERT_EQ(cache.ForkSequence(0, 1, /*num_entries=*/3), kTfLiteOk);
+  EXPECT_EQ(cache.GetNumEntries(1, 0), 3);
+  EXPECT_EQ(cache.GetBlockTable(1, 0), cache.GetBlockTable(0, 0));
+  EXPECT_EQ(cache.GetNumFreeBlocks(0), 6);
+
+  // Overwriting entry 3 copies the second block only.
+  ASSERT_EQ(cache.PrepareWrite(1, 0, 3, 1), kTfLiteOk);
+  WriteEntry(cache, 1, 0, 3, 30);
+  EXPECT_EQ(cache.GetBlockTable(1, 0)[0], cache.GetBlockTable(0, 0)[0]);
+  EXPECT_NE(cache.GetBlockTable(1, 0)[1], cache.GetBlockTable(0, 0)[1]);
+  EXPECT_EQ(cache.GetNumFreeBlocks(0), 5);
+  EXPECT_EQ(ReadKey(cache, 1, 0, 2), 2);
+  EXPECT_EQ(ReadKey(cache, 1, 0, 3), 30);
+  EXPECT_EQ(ReadKey(cache, 0, 0, 3), 3);
+
+  // The shared block is only released by the last sequence using it.
+  cache.FreeSequence(0);
+  EXPECT_EQ(cache.GetNumFreeBlocks(0), 6);
+  EXPECT_EQ(ReadKey(cache, 1, 0, 0), 0);
+  cache.FreeSequence(1);
+  EXPECT_EQ(cache.GetNumFreeBlocks(0), 8);
+}
+
+TEST(PagedCacheBufferTest, InvalidConfigurationFails) {
+  PagedCacheBuffer cache;
+  EXPECT_EQ(cache.Initialize(/*num_layers=*/1, /*num_blocks=*/0,
+                             /*block_size=*/2, /*entry_size=*/1),
+            kTfLiteError);
+  EXPECT_FALSE(cache.IsInitialized());
+}
+
+}  // namespace
+}  // namespace resource
+}  // namespace tflite
@@ -103,12 +103,51 @@ class InterpreterOptions {
     return experimental_cache_constant_cast_op_;
   }
 
+  // If set to `true`, the subgraphs run by control flow ops (e.g. IF and
+  // WHILE) place their non-persistent tensors in the part of the caller's arena
+  // that is not live while the op runs, as far as they fit, instead of in
+  // arenas of their own. This lowers the peak memory of models with control
+  // flow. It has no effect when all tensors are preserved.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetShareSubgraphArenas(bool value = true) {
+    experimental_share_subgraph_arenas_ = value;
+  }
+
+  // Returns if the `experimental_share_subgraph_arenas_` feature is enabled.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  bool GetShareSubgraphArenas() const {
+    return experimental_share_subgraph_arenas_;
+  }
+
+  // Sets the number of threads that run independent ops of a subgraph
+  // concurrently. Ops run together only if they don't depend on each other and
+  // the memory plan gives their tensors disjoint memory. Ops that have side
+  // effects, produce dynamic tensors, or run subgraphs or delegates run alone.
+  // Each of the extra threads runs its ops with one CPU backend thread. Values
+  // below 2 disable the feature.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetInterOpNumThreads(int value) {
+    experimental_inter_op_num_threads_ = value;
+  }
+
+  // Returns the number of threads set by `SetInterOpNumThreads`.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  int GetInterOpNumThreads() const {
+    return experimental_inter_op_num_threads_;
+  }
+
  private:
   bool experimental_preserve_all_tensors_ = false;
   bool experimental_ensure_dynamic_tensors_are_released_ = false;
   int experimental_optimize_memory_for_large_tensors_ = 0;
   bool experimental_disable_delegate_clustering_ = false;
   bool experimental_cache_constant_cast_op_ = false;
+  bool experimental_share_subgraph_arenas_ = false;
+  int experimental_inter_op_num_threads_ = 0;
 };
 
 }  // namespace tflite
@@ -28,21 +28,120 @@ limitations under the License.
 //   or a dequantized value in the case of a uint8 input.
 //   When indices are out of bound, the ops will not succeed.
 //
+//   Rows are read in place from the matrix. When it is mapped from the model
+//   file, only the pages of the looked up rows are read from storage.
+//
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 
+#if defined(__APPLE__) || defined(__linux__) || defined(__Fuchsia__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace tflite {
 namespace ops {
 namespace builtin {
 namespace embedding_lookup {
 
+// Matrices mapped from the model file that are at least this large get paging
+// hints. Smaller ones are cheap to read entirely.
+constexpr size_t kMinAdvisedTableBytes = 1 << 20;
+
+// Looked up rows are only prefetched from matrices at least this large. The
+// pages of smaller ones quickly become resident, after which prefetching is
+// pure overhead.
+constexpr size_t kMinPrefetchedTableBytes = 16 << 20;
+
+// Batches whose rows span more page ranges than this are not prefetched.
+constexpr size_t kMaxPrefetchedRanges = 64;
+
+bool ShouldAdviseTable(const TfLiteTensor* value) {
+  return value->allocation_type == kTfLiteMmapRo &&
+         value->bytes >= kMinAdvisedTableBytes;
+}
+
+// Tells the OS not to read ahead around the pages of the matrix that are
+// accessed, so that large vocabulary tables don't become resident while only a
+// few rows are looked up per inference.
+void AdviseRandomAccess(const TfLiteTensor* value) {
+#ifdef MADV_RANDOM
+  if (!ShouldAdviseTable(value)) return;
+  // The hint is restricted to the pages entirely within the matrix, so that it
+  // doesn't apply to the neighbouring buffers.
+  static const uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+  const uintptr_t data = reinterpret_cast<uintptr_t>(value->data.raw);
+  const uintptr_t begin = (data + pagesize - 1) / pagesize * pagesize;
+  const uintptr_t end = (data + value->bytes) / pagesize * pagesize;
+  if (end > begin) {
+    // The kernel might ignore the hint, so errors are ignored too.
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_RANDOM);
+  }
+#endif
+}
+
+// Asks the OS to start reading the pages of all the looked up rows, so that
+// reading them from storage overlaps instead of faulting on each row in turn.
+// The pages of the rows are merged into ranges first, so that duplicate ids and
+// rows sharing pages cost a single system call.
+void PrefetchRows(const TfLiteTensor* value, const TfLiteTensor* lookup) {
+#ifdef MADV_WILLNEED
+  const int num_lookups = SizeOfDimension(lookup, 0);
+  if (num_lookups < 2 || !ShouldAdviseTable(value) ||
+      value->bytes < kMinPrefetchedTableBytes) {
+    return;
+  }
+  static const uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+  const int row_size = SizeOfDimension(value, 0);
+  const int32_t* lookup_data = GetTensorData<int32_t>(lookup);
+  const uintptr_t data = reinterpret_cast<uintptr_t>(value->data.raw);
+  // First and last page of each looked up row.
+  std::vector<std::pair<uintptr_t, uintptr_t>> pages;
+  pages.reserve(num_lookups);
+  for (int i = 0; i < num_lookups; i++) {
+    const int64_t idx = lookup_data[i];
+    // Out of bounds indices are reported by the lookup itself.
+    if (idx >= row_size || idx < 0) continue;
+    // Computed from the total size, as rows of packed types might not start
+    // on a byte boundary.
+    const uintptr_t row_begin = data + idx * value->bytes / row_size;
+    const uintptr_t row_end = data + ((idx + 1) * value->bytes + row_size - 1) /
+                                         row_size;
+    if (row_end > row_begin) {
+      pages.emplace_back(row_begin / pagesize, (row_end - 1) / pagesize);
+    }
+  }
+  std::sort(pages.begin(), pages.end());
+  size_t num_ranges = 0;
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (num_ranges > 0 && pages[i].first <= pages[num_ranges - 1].second + 1) {
+      pages[num_ranges - 1].second =
+          std::max(pages[num_ranges - 1].second, pages[i].second);
+    } else {
+      pages[num_ranges++] = pages[i];
+    }
+  }
+  // The system calls of batches scattered over many ranges would cost more
+  // than the page faults they save.
+  if (num_ranges > kMaxPrefetchedRanges) return;
+  for (size_t i = 0; i < num_ranges; i++) {
+    madvise(reinterpret_cast<void*>(pages[i].first * pagesize),
+            (pages[i].second - pages[i].first + 1) * pagesize, MADV_WILLNEED);
+  }
+#endif
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 2);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
@@ -55,6 +154,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const TfLiteTensor* value;
   TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 1, &value));
   TF_LITE_ENSURE(context, NumDimensions(value) >= 2);
+  AdviseRandomAccess(value);
 
   if (value->quantization.type == kTfLiteAffineQuantization) {
     const auto qparams = static_cast<const TfLiteAffineQuantization*>(
@@ -192,6 +292,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 1, &value));
   TfLiteTensor* output;
   TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
+  PrefetchRows(value, lookup);
   switch (value->type) {
     case kTfLiteFloat32:
       return EvalSimple(context, node, lookup, value, output);
@@ -107,6 +107,37 @@ class EmbeddingLookupOpModel : public BaseEmbeddingLookupOpModel {
   }
 };
 
+// A model whose matrix is a constant, read in place from the model buffer like
+// a matrix mapped from the model file.
+class ConstEmbeddingLookupOpModel : public SingleOpModel {
+ public:
+  ConstEmbeddingLookupOpModel(std::initializer_list<int> index_shape,
+                              std::initializer_list<int> weight_shape,
+                              const std::vector<float>& weight) {
+    input_ = AddInput(TensorType_INT32);
+    weight_ = AddConstInput(TensorData{TensorType_FLOAT32, weight_shape},
+                            weight);
+    output_ = AddOutput(TensorType_FLOAT32);
+    SetBuiltinOp(BuiltinOperator_EMBEDDING_LOOKUP, BuiltinOptions_NONE, 0);
+    BuildInterpreter({index_shape, weight_shape});
+  }
+
+  void SetInput(std::initializer_list<int> data) {
+    PopulateTensor(input_, data);
+  }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+  TfLiteAllocationType GetWeightAllocationType() {
+    return interpreter_->tensor(weight_)->allocation_type;
+  }
+
+ private:
+  int input_;
+  int weight_;
+  int output_;
+};
+
 class HybridEmbeddingLookupOpModel : public BaseEmbeddingLookupOpModel {
  public:
   HybridEmbeddingLookupOpModel(std::initializer_list<int> index_shape,
@@ -157,6 +188,34 @@ TEST(EmbeddingLookupOpTest, SimpleTest) {
               })));
 }
 
+TEST(EmbeddingLookupOpTest, LargeConstTableTest) {
+  // Large enough for the looked up rows to be prefetched.
+  const int rows = 4096;
+  const int columns = 1024;
+  std::vector<float> weight(rows * columns);
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < columns; j++) {
+      weight[i * columns + j] = i + j / 10000.0f;
+    }
+  }
+  ConstEmbeddingLookupOpModel m({8}, {rows, columns}, weight);
+  ASSERT_EQ(m.GetWeightAllocationType(), kTfLiteMmapRo);
+
+  // Duplicate, adjacent and distant rows, out of order.
+  const std::vector<int> ids = {5, 5, 6, 4095, 0, 2048, 4, 5};
+  m.SetInput({5, 5, 6, 4095, 0, 2048, 4, 5});
+  // The second invocation finds the rows resident.
+  for (int run = 0; run < 2; run++) {
+    ASSERT_EQ(m.Invoke(), kTfLiteOk);
+    std::vector<float> expected;
+    for (int id : ids) {
+      expected.insert(expected.end(), weight.begin() + id * columns,
+                      weight.begin() + (id + 1) * columns);
+    }
+    EXPECT_THAT(m.GetOutput(), ElementsAreArray(expected));
+  }
+}
+
 #if !defined(MEMORY_SANITIZER) && !defined(GOOGLE_UNSUPPORTED_OS_LOONIX) && \
     defined(__LP64__)
 TEST(EmbeddingLookupOpTest, LargeTableTest) {
@@ -353,6 +353,94 @@ TfLiteStatus PrepareImpl4Bit(TfLiteContext* context, TfLiteNode* node,
                           cols);
 }
 
+// Returns the number of groups of columns of a 4-bit filter with their own
+// scales, or 0 if the optimized kernel does not support them: each group must
+// span a multiple of FilterDepth columns.
+int GetFilterScaleGroups4Bit(const TfLiteTensor* filter) {
+  const auto* filter_params =
+      reinterpret_cast<TfLiteAffineQuantization*>(filter->quantization.params);
+  const int units = filter->dims->data[0];
+  const int cols = filter->dims->data[1];
+  if (filter->quantization.type != kTfLiteAffineQuantization ||
+      !filter_params || !filter_params->scale ||
+      filter_params->scale->size <= units) {
+    return 1;
+  }
+  const int groups = filter_params->scale->size / units;
+  if (filter_params->scale->size % units != 0 || cols % groups != 0 ||
+      (cols / groups) % optimized_4bit::FilterDepth != 0) {
+    return 0;
+  }
+  return groups;
+}
+
+// Packs the constant 4-bit `filter` and its scales for the optimized kernel.
+void Prepack4BitFilter(const TfLiteTensor* filter, int num_groups,
+                       optimized_4bit::OpData4Bit* op_data_4bit) {
+  const int output_depth = filter->dims->data[0];
+  const int cols = filter->dims->data[1];
+  const int depth = optimized_4bit::FilterDepth;
+  const int lhs_width = optimized_4bit::FilterWidth;
+  const int lhs_layout_rows =
+      (output_depth + (lhs_width - 1)) & ~(lhs_width - 1);
+  const int lhs_layout_cols = (cols + (depth - 1)) & ~(depth - 1);
+  const int weight_size = lhs_layout_rows * lhs_layout_cols / 2;
+  const int required_size =
+      optimized_4bit::kDefaultAlignmentPadding + weight_size;
+  op_data_4bit->AllocatePackedRegion(required_size);
+  const int8_t* weight_ptr = GetTensorData<int8_t>(filter);
+  optimized_4bit::api::Prepack(op_data_4bit->prepacked_cache, weight_ptr,
+                               lhs_layout_rows, lhs_layout_cols, output_depth,
+                               cols, lhs_width, depth);
+  op_data_4bit->needs_prepack = false;
+#ifdef MADV_PAGEOUT
+  // After prepacking, we will never use the weights from the model file. Mark
+  // them with MADV_PAGEOUT so the kernel can reclaim the pages, decreasing
+  // the resident memory size.
+  //
+  // This is Linux specific. There is no effect on other platforms (e.g. on
+  // Windows, but possibly other POSIX platforms!). It requires a minimum
+  // Kernel version of 5.4 - on older kernels the call will return with an
+  // error, but we ignore it. The kernel might also ignore this hint.
+  //
+  // Note, due to rounding the pointer up (which is necessary due to madvise
+  // requiring an address that aligns with the page size), the first partial
+  // page will not be reclaimed. Madvise also rounds the end of the hinted
+  // range down, so the last partial page is also unaffected. Because of this
+  // behavior, on average one memory page (usually 4 kiB) per buffer holding 4
+  // bit data will not be paged out.
+  static const uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+  int8_t* up_aligned_ptr = reinterpret_cast<int8_t*>(
+      ((reinterpret_cast<uintptr_t>(weight_ptr) + pagesize - 1) / pagesize) *
+      pagesize);
+  const auto rounding_size = up_aligned_ptr - weight_ptr;
+  madvise(up_aligned_ptr, weight_size - rounding_size, MADV_PAGEOUT);
+#endif
+
+  op_data_4bit->num_groups = num_groups;
+  std::vector<float>& filter_scales = op_data_4bit->filter_scales;
+  filter_scales.assign(num_groups * lhs_layout_rows, filter->params.scale);
+  auto* filter_params =
+      reinterpret_cast<TfLiteAffineQuantization*>(filter->quantization.params);
+  if (filter_params && filter_params->scale && filter_params->scale->size > 0) {
+    if (filter_params->scale->size == 1) {
+      std::fill(filter_scales.begin(), filter_scales.end(),
+                filter_params->scale->data[0]);
+    } else if (num_groups == 1) {
+      for (int i = 0; i < filter_params->scale->size; i++) {
+        filter_scales[i] = filter_params->scale->data[i];
+      }
+    } else {
+      for (int i = 0; i < output_depth; i++) {
+        for (int g = 0; g < num_groups; g++) {
+          filter_scales[g * lhs_layout_rows + i] =
+              filter_params->scale->data[i * num_groups + g];
+        }
+      }
+    }
+  }
+}
+
 TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node,
                          KernelType kernel_type) {
   auto* params =
@@ -517,15 +605,24 @@ TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node,
   const bool is_sparse = filter->sparsity != nullptr;
   if (is_hybrid) {
     // Use optimized implementation for 4bit
+    const int filter_scale_groups =
+        filter->type == kTfLiteInt4 ? GetFilterScaleGroups4Bit(filter) : 1;
     if (filter->type == kTfLiteInt4 && kernel_type == kGenericOptimized &&
         IsConstantTensor(filter) && batch_size &&
         ((input_size / batch_size) % 2 == 0) &&
         num_units >= optimized_4bit::FilterWidth &&
-        (input_size / batch_size) >= optimized_4bit::FilterDepth) {
+        (input_size / batch_size) >= optimized_4bit::FilterDepth &&
+        filter_scale_groups > 0) {
       const int cols = input_size / batch_size;
       if (!data->op_data_4bit) {
         data->op_data_4bit = std::make_unique<optimized_4bit::OpData4Bit>();
       }
+      // The filter is constant, so pack it once here rather than in the first
+      // Eval.
+      if (data->op_data_4bit->needs_prepack) {
+        Prepack4BitFilter(filter, filter_scale_groups,
+                          data->op_data_4bit.get());
+      }
       if (data->op_data_4bit->batch_size == batch_size) {
         return kTfLiteOk;
       }
@@ -542,6 +639,14 @@ TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node,
                              optimized_4bit::FilterDepth, batch_size, cols,
                              num_units);
     }
+    if (filter_scale_groups != 1) {
+      TF_LITE_KERNEL_LOG(context,
+                         "Group-wise scales of 4-bit filters are only "
+                         "supported by the optimized kernel, with groups of a "
+                         "multiple of %d columns.",
+                         optimized_4bit::FilterDepth);
+      return kTfLiteError;
+    }
     TfLiteIntArrayFree(node->temporaries);
     data->compute_row_sums = true;
     if (is_sparse) {
@@ -947,6 +1052,105 @@ struct SparseHybridFullyConnectedTask : cpu_backend_threadpool::Task {
   TfLiteTensor* output;
 };
 
+// Computes the output channels [row_start, row_end) of the optimized 4-bit
+// kernel, a multiple of FilterWidth rows of the packed filter.
+struct Dense4BitFullyConnectedTask : cpu_backend_threadpool::Task {
+  Dense4BitFullyConnectedTask(const optimized_4bit::OpData4Bit* op_data_4bit,
+                              const int8_t* rhs, const float* scaling_factors,
+                              int32_t* dst, float* output, int row_start,
+                              int row_end, int output_depth, int batch_size,
+                              int lhs_layout_rows, int lhs_layout_cols,
+                              int rhs_layout_rows)
+      : op_data_4bit(op_data_4bit),
+        rhs(rhs),
+        scaling_factors(scaling_factors),
+        dst(dst),
+        output(output),
+        row_start(row_start),
+        row_end(row_end),
+        output_depth(output_depth),
+        batch_size(batch_size),
+        lhs_layout_rows(lhs_layout_rows),
+        lhs_layout_cols(lhs_layout_cols),
+        rhs_layout_rows(rhs_layout_rows) {}
+
+  void Run() override {
+    const int rhs_width = op_data_4bit->rows_right;
+    const int units = std::min(row_end, output_depth) - row_start;
+    const int rows = row_end - row_start;
+    const uint8_t* lhs = op_data_4bit->prepacked_cache +
+                         row_start * lhs_layout_cols / 2;
+    int32_t* task_dst = dst + row_start * rhs_layout_rows;
+    // Unpack writes rows of `units` outputs, so the outputs of several
+    // batches go through a buffer unless the task computes all the channels.
+    float* task_output = output + row_start;
+    if (batch_size > 1 && units != output_depth) {
+      output_buffer.resize(batch_size * units);
+      for (int b = 0; b < batch_size; ++b) {
+        std::copy_n(output + b * output_depth + row_start, units,
+                    output_buffer.data() + b * units);
+      }
+      task_output = output_buffer.data();
+    }
+    const int num_groups = op_data_4bit->num_groups;
+    if (num_groups == 1) {
+      optimized_4bit::api::RunAndUnpack(
+          rhs_width, lhs, rhs, task_dst, units, batch_size, rows,
+          lhs_layout_cols, rhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
+          rows, task_output, scaling_factors,
+          op_data_4bit->filter_scales.data() + row_start);
+    } else {
+      // Each group is accumulated and scaled separately, one block of
+      // rhs_width batches at a time since the packed inputs of a block are
+      // contiguous only within a group.
+      const int group_cols = lhs_layout_cols / num_groups;
+      for (int g = 0; g < num_groups; ++g) {
+        const float* group_scales = op_data_4bit->filter_scales.data() +
+                                    g * lhs_layout_rows + row_start;
+        const int32_t* group_offsets =
+            op_data_4bit->group_input_offsets.data() + g * batch_size;
+        for (int b = 0; b < batch_size; b += rhs_width) {
+          const int batches = std::min(rhs_width, batch_size - b);
+          optimized_4bit::api::RunAndUnpack(
+              rhs_width, lhs + g * group_cols * optimized_4bit::FilterWidth / 2,
+              rhs + b * lhs_layout_cols + g * group_cols * rhs_width, task_dst,
+              units, batches, rows, lhs_layout_cols, rhs_width, group_cols,
+              rhs_width, rows, task_output + b * units, scaling_factors + b,
+              group_scales);
+          for (int i = b; i < b + batches; ++i) {
+            const float offset = group_offsets[i] * scaling_factors[i];
+            float* output_row = task_output + i * units;
+            for (int o = 0; o < units; ++o) {
+              output_row[o] += offset * group_scales[o];
+            }
+          }
+        }
+      }
+    }
+    if (task_output == output_buffer.data()) {
+      for (int b = 0; b < batch_size; ++b) {
+        std::copy_n(output_buffer.data() + b * units, units,
+                    output + b * output_depth + row_start);
+      }
+    }
+  }
+
+ private:
+  const optimized_4bit::OpData4Bit* op_data_4bit;
+  const int8_t* rhs;
+  const float* scaling_factors;
+  int32_t* dst;
+  float* output;
+  const int row_start;
+  const int row_end;
+  const int output_depth;
+  const int batch_size;
+  const int lhs_layout_rows;
+  const int lhs_layout_cols;
+  const int rhs_layout_rows;
+  std::vector<float> output_buffer;
+};
+
 TfLiteStatus EvalHybridDense4Bit(
     TfLiteContext* context, TfLiteNode* node,
     TfLiteFullyConnectedParams* params, OpData* data, const TfLiteTensor* input,
@@ -967,72 +1171,58 @@ TfLiteStatus EvalHybridDense4Bit(
       (output_depth + (lhs_width - 1)) & ~(lhs_width - 1);
   const int lhs_layout_cols = (cols + (depth - 1)) & ~(depth - 1);
   const int rhs_layout_rows = (batch_size + (rhs_width - 1)) & ~(rhs_width - 1);
-  const int rhs_layout_cols = lhs_layout_cols;
-  const int dst_layout_rows = rhs_layout_rows;
-  const int dst_layout_cols = lhs_layout_rows;
-  if (data->op_data_4bit->needs_prepack) {
-    const int weight_size = lhs_layout_rows * lhs_layout_cols / 2;
-    const int required_size =
-        optimized_4bit::kDefaultAlignmentPadding + weight_size;
-    data->op_data_4bit->AllocatePackedRegion(required_size);
-    const int8_t* weight_ptr = GetTensorData<int8_t>(filter);
-    optimized_4bit::api::Prepack(data->op_data_4bit->prepacked_cache,
-                                 weight_ptr, lhs_layout_rows, lhs_layout_cols,
-                                 output_depth, cols, lhs_width, depth);
-    data->op_data_4bit->needs_prepack = false;
-#ifdef MADV_PAGEOUT
-    // After prepacking, we will never use the weights from the model file. Mark
-    // them with MADV_PAGEOUT so the kernel can reclaim the pages, decreasing
-    // the resident memory size.
-    //
-    // This is Linux specific. There is no effect on other platforms (e.g. on
-    // Windows, but possibly other POSIX platforms!). It requires a minimum
-    // Kernel version of 5.4 - on older kernels the call will return with an
-    // error, but we ignore it. The kernel might also ignore this hint.
-    //
-    // Note, due to rounding the pointer up (which is necessary due to madvise
-    // requiring an address that aligns with the page size), the first partial
-    // page will not be reclaimed. Madvise also rounds the end of the hinted
-    // range down, so the last partial page is also unaffected. Because of this
-    // behavior, on average one memory page (usually 4 kiB) per buffer holding 4
-    // bit data will not be paged out.
-    static const uintptr_t pagesize = sysconf(_SC_PAGESIZE);
-    int8_t* up_aligned_ptr = reinterpret_cast<int8_t*>(
-        ((reinterpret_cast<uintptr_t>(weight_ptr) + pagesize - 1) / pagesize) *
-        pagesize);
-    const auto rounding_size = up_aligned_ptr - weight_ptr;
-    madvise(up_aligned_ptr, weight_size - rounding_size, MADV_PAGEOUT);
-#endif
-  }
-
-  std::vector<float> filter_scales(lhs_layout_rows, filter->params.scale);
-  auto* filter_params =
-      reinterpret_cast<TfLiteAffineQuantization*>(filter->quantization.params);
-  if (filter_params && filter_params->scale && filter_params->scale->size > 0) {
-    if (filter_params->scale->size == 1) {
-      std::fill(filter_scales.begin(), filter_scales.end(),
-                filter_params->scale->data[0]);
-    } else {
-      for (int i = 0; i < filter_params->scale->size; i++) {
-        filter_scales[i] = filter_params->scale->data[i];
-      }
-    }
-  }
+  optimized_4bit::OpData4Bit* op_data_4bit = data->op_data_4bit.get();
   optimized_4bit::api::BatchQuantizeFloats4Bit(
       GetTensorData<float>(input), batch_size, cols, quant_data,
       scaling_factors_ptr, rhs_width, depth, input_offset_ptr);
   const float* bias_ptr =
       bias != nullptr ? GetTensorData<float>(bias) : nullptr;
-  optimized_4bit::api::AssignBiasAndComputeOffsets(
-      input_offset_ptr, scaling_factors_ptr, filter_scales.data(), bias_ptr,
-      GetTensorData<float>(output), output_depth, batch_size);
-  const uint8_t* lhs = data->op_data_4bit->prepacked_cache;
+  float* output_ptr = GetTensorData<float>(output);
+  if (op_data_4bit->num_groups == 1) {
+    optimized_4bit::api::AssignBiasAndComputeOffsets(
+        input_offset_ptr, scaling_factors_ptr,
+        op_data_4bit->filter_scales.data(), bias_ptr, output_ptr, output_depth,
+        batch_size);
+  } else {
+    // The input offsets are scaled by each group, so they are added by the
+    // tasks.
+    for (int b = 0; b < batch_size; ++b) {
+      float* output_row = output_ptr + b * output_depth;
+      if (bias_ptr) {
+        std::copy_n(bias_ptr, output_depth, output_row);
+      } else {
+        std::fill_n(output_row, output_depth, 0.0f);
+      }
+    }
+    op_data_4bit->group_input_offsets.resize(op_data_4bit->num_groups *
+                                             batch_size);
+    optimized_4bit::api::ComputeGroupInputOffsets(
+        quant_data, batch_size, lhs_layout_cols, op_data_4bit->num_groups,
+        rhs_width, depth, op_data_4bit->group_input_offsets.data());
+  }
+
+  // The tasks split the output channels, in blocks of lhs_width rows of the
+  // packed filter.
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  const int blocks = lhs_layout_rows / lhs_width;
+  const int thread_count =
+      std::max(1, std::min(blocks, cpu_backend_context->max_num_threads()));
   int32_t* dst = GetTensorData<int32_t>(accum_scratch);
-  optimized_4bit::api::RunAndUnpack(
-      data->op_data_4bit->rows_right, lhs, quant_data, dst, output_depth,
-      batch_size, lhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
-      rhs_layout_cols, dst_layout_rows, dst_layout_cols,
-      GetTensorData<float>(output), scaling_factors_ptr, filter_scales.data());
+  std::vector<Dense4BitFullyConnectedTask> tasks;
+  tasks.reserve(thread_count);
+  int block_start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    int block_end = block_start + blocks / thread_count;
+    if (i < blocks % thread_count) block_end++;
+    tasks.emplace_back(op_data_4bit, quant_data, scaling_factors_ptr, dst,
+                       output_ptr, block_start * lhs_width,
+                       block_end * lhs_width, output_depth, batch_size,
+                       lhs_layout_rows, lhs_layout_cols, rhs_layout_rows);
+    block_start = block_end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
   tensor_utils::ApplyActivationToVector(
       GetTensorData<float>(output), batch_size * output_depth,
       params->activation, GetTensorData<float>(output));
@@ -32,7 +32,8 @@ class FullyConnected4BitOpModel : public SingleOpModel {
       int units, int batches, const TensorData& input,
       const TensorData& weights, const TensorData& output,
       std::vector<int8_t> weights_initializer, TfLiteRegistration* registration,
-      ActivationFunctionType activation_func = ActivationFunctionType_RELU)
+      ActivationFunctionType activation_func = ActivationFunctionType_RELU,
+      int num_threads = -1)
       : batches_(batches), units_(units) {
     // Calculate input_size_ from batch and input shape.
     int total_input_size = 1;
@@ -64,8 +65,12 @@ class FullyConnected4BitOpModel : public SingleOpModel {
                      .Union());
     resolver_ = std::make_unique<SingleOpResolver>(
         BuiltinOperator_FULLY_CONNECTED, registration);
-    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)});
-    SetUnitScale();
+    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)},
+                     num_threads, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/true);
+    if (!weights.per_channel_quantization) {
+      SetUnitScale();
+    }
   }
 
   void SetUnitScale() {
@@ -185,6 +190,86 @@ TEST(Hybrid4BitFullyConnectedOpTest, TestHybridInt4AllZeroBatch) {
                   /*max_abs_err=*/1.3f)));
 }
 
+TEST(Hybrid4BitFullyConnectedOpTest, TestHybridInt4GroupwiseScales) {
+  const int units = 6;
+  const int batches = 3;
+  const int cols = 128;
+  const int groups = 4;
+  std::mt19937 engine(2024);
+  std::uniform_int_distribution<int32_t> weight_dist(-7, 7);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::vector<int8_t> weight_data(units * cols);
+  for (int8_t& weight : weight_data) weight = weight_dist(engine);
+  std::vector<float> scales(units * groups);
+  for (float& scale : scales) scale = 0.05f + 0.1f * dist(engine);
+  std::vector<float> input_data(batches * cols);
+  for (float& input : input_data) input = dist(engine);
+  std::vector<float> bias_data(units);
+  for (float& bias : bias_data) bias = dist(engine);
+  std::vector<float> expected(batches * units);
+  for (int b = 0; b < batches; ++b) {
+    for (int u = 0; u < units; ++u) {
+      float sum = bias_data[u];
+      for (int c = 0; c < cols; ++c) {
+        sum += weight_data[u * cols + c] *
+               scales[u * groups + c / (cols / groups)] *
+               input_data[b * cols + c];
+      }
+      expected[b * units + u] = sum;
+    }
+  }
+
+  for (int num_threads : {1, 2}) {
+    FullyConnected4BitOpModel m(
+        units, batches,
+        /*input=*/{TensorType_FLOAT32, {batches, cols}},
+        /*weights=*/
+        {TensorType_INT4, {units, cols}, 0.0, 0.0, 0.0, 0,
+         /*per_channel_quantization=*/true, scales,
+         std::vector<int64_t>(scales.size(), 0), /*channel_index=*/0},
+        /*output=*/{TensorType_FLOAT32, {units, batches}}, weight_data,
+        ops::builtin::Register_FULLY_CONNECTED_GENERIC_OPT(),
+        ActivationFunctionType_NONE, num_threads);
+    m.SetBias(bias_data);
+    m.SetInput(input_data);
+    ASSERT_EQ(m.Invoke(), kTfLiteOk);
+    EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear(
+                                   expected, /*max_abs_err=*/0.1f)));
+  }
+}
+
+TEST(Hybrid4BitFullyConnectedOpTest, TestHybridInt4MultithreadedMatches) {
+  const int units = 37;
+  const int batches = 5;
+  const int cols = 96;
+  std::mt19937 engine(2024);
+  std::uniform_int_distribution<int32_t> weight_dist(-7, 7);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::vector<int8_t> weight_data(units * cols);
+  for (int8_t& weight : weight_data) weight = weight_dist(engine);
+  std::vector<float> input_data(batches * cols);
+  for (float& input : input_data) input = dist(engine);
+  std::vector<float> bias_data(units);
+  for (float& bias : bias_data) bias = dist(engine);
+
+  std::vector<std::vector<float>> outputs;
+  for (int num_threads : {1, 4}) {
+    FullyConnected4BitOpModel m(
+        units, batches,
+        /*input=*/{TensorType_FLOAT32, {batches, cols}},
+        /*weights=*/{TensorType_INT4, {units, cols}, 0.0, 0.0, 1.0},
+        /*output=*/{TensorType_FLOAT32, {units, batches}}, weight_data,
+        ops::builtin::Register_FULLY_CONNECTED_GENERIC_OPT(),
+        ActivationFunctionType_NONE, num_threads);
+    m.SetBias(bias_data);
+    m.SetInput(input_data);
+    ASSERT_EQ(m.Invoke(), kTfLiteOk);
+    outputs.push_back(m.GetOutput());
+  }
+  EXPECT_THAT(outputs[1], ElementsAreArray(ArrayFloatNear(
+                              outputs[0], /*max_abs_err=*/1e-5f)));
+}
+
 std::mt19937 random_engine(2023);
 std::uniform_real_distribution<float> real_dist(0.f, 1.f);
 std::uniform_int_distribution<int32_t> int_dist(-7, 7);
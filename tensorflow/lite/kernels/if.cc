@@ -269,6 +269,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   } else {
     active_branch_subgraph = else_subgraph;
   }
+  this_subgraph->LendFreeArenaTo({active_branch_subgraph});
 
   if (op_data->subgraph_has_dynamic_output_tensors) {
     TF_LITE_ENSURE_OK(context,
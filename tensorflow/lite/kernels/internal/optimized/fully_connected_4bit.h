@@ -23,6 +23,9 @@ limitations under the License.
 
 #include <cstdlib>
 #include <memory>
+#include <vector>
+
+#include "tensorflow/lite/kernels/internal/optimized/4bit/fully_connected_common.h"
 
 #if defined(FC_4BIT_SSE) && defined(__SSSE3__)
 #include "tensorflow/lite/kernels/internal/optimized/4bit/sse_fully_connected.h"
@@ -62,6 +65,15 @@ struct OpData4Bit {
   uint8_t* prepacked_cache = nullptr;
   std::unique_ptr<uint8_t[], Deleter> prepacked_cache_buffer;
   size_t prepacked_cache_buffer_size = 0;
+  // The filter columns are split in `num_groups` groups of equal size, each
+  // with its own scale per output channel. `filter_scales` holds the scales
+  // of each group in turn, each padded to the packed number of rows.
+  int num_groups = 1;
+  std::vector<float> filter_scales;
+  // Sum of the quantized inputs of each batch in each group, times
+  // zero_point_4bit, in [num_groups, batch_size]. Only used with several
+  // groups.
+  std::vector<int32_t> group_input_offsets;
 
   void AllocatePackedRegion(size_t required_size) {
 #ifdef TFLITE_MMAP_DISABLED
@@ -131,6 +143,33 @@ inline void AssignBiasAndComputeOffsets(const int32_t* input_offsets,
       output_depth, batch_size);
 }
 
+/* Write to group_input_offsets[g * batch_size + b] the sum of the quantized
+ * inputs of batch b in the columns of group g, times zero_point_4bit, from
+ * quantized_data_ptr as packed by BatchQuantizeFloats4Bit. Groups span
+ * layout_cols / num_groups columns, a multiple of depth.
+ */
+inline void ComputeGroupInputOffsets(const int8_t* quantized_data_ptr,
+                                     int batch_size, int layout_cols,
+                                     int num_groups, int width, int depth,
+                                     int32_t* group_input_offsets) {
+  const int group_cols = layout_cols / num_groups;
+  for (int b = 0; b < batch_size; ++b) {
+    const int8_t* row = quantized_data_ptr + (b / width) * width * layout_cols +
+                        (b % width) * depth;
+    for (int g = 0; g < num_groups; ++g) {
+      int32_t sum = 0;
+      for (int col = g * group_cols; col < (g + 1) * group_cols;
+           col += depth) {
+        const int8_t* block = row + col * width;
+        for (int d = 0; d < depth; ++d) {
+          sum += block[d];
+        }
+      }
+      group_input_offsets[g * batch_size + b] = sum * zero_point_4bit;
+    }
+  }
+}
+
 // Compute sum of lhs * rhs columnwise and write output to output_ptr.
 inline void RunAndUnpack(int rhs_width, const uint8_t* lhs, const int8_t* rhs,
                          int32_t* dst, int output_depth, int batch_size,
@@ -1071,6 +1071,63 @@ void NeonMatrixBatchVectorMultiplyAccumulate(
                                       output_zp, scratch, output);
 }
 
+void NeonFourMatrixVectorMultiplyAccumulate(
+    const int8_t* input, const int32_t* const* biases,
+    const int8_t* const* matrices, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_input, int32_t n_output,
+    int16_t** outputs) {
+  const int32_t output_min = std::numeric_limits<int16_t>::min();
+  const int32_t output_max = std::numeric_limits<int16_t>::max();
+  const int postamble_start =
+      RoundDownVectors<kInt8ValuesPerNeonVector>(n_input);
+
+  for (int row = 0; row < n_output; ++row) {
+    const int8_t* row_ptrs[4];
+    int32x4_t dotprod_32x4[4];
+    for (int g = 0; g < 4; ++g) {
+      row_ptrs[g] =
+          matrices[g] != nullptr ? matrices[g] + row * n_input : nullptr;
+      dotprod_32x4[g] = vmovq_n_s32(0);
+    }
+
+    // The input is loaded once for the rows of the four matrices.
+    int col = 0;
+    for (; col < postamble_start; col += kInt8ValuesPerNeonVector) {
+      const int8x16_t s1_8x16 = vld1q_s8(input + col);
+      for (int g = 0; g < 4; ++g) {
+        if (row_ptrs[g] == nullptr) continue;
+        const int8x16_t s2_8x16 = vld1q_s8(row_ptrs[g] + col);
+#ifdef __ARM_FEATURE_DOTPROD
+        dotprod_32x4[g] = vdotq_s32(dotprod_32x4[g], s1_8x16, s2_8x16);
+#else
+        // As in NeonMatrixBatchVectorMultiplyImpl, the sum of two products
+        // doesn't overflow as the weights are quantized to [-127, 127].
+        int16x8_t prod_16x8 =
+            vmull_s8(vget_low_s8(s1_8x16), vget_low_s8(s2_8x16));
+        prod_16x8 =
+            vmlal_s8(prod_16x8, vget_high_s8(s1_8x16), vget_high_s8(s2_8x16));
+        dotprod_32x4[g] = vpadalq_s16(dotprod_32x4[g], prod_16x8);
+#endif  // __ARM_FEATURE_DOTPROD
+      }
+    }
+
+    for (int g = 0; g < 4; ++g) {
+      if (row_ptrs[g] == nullptr) continue;
+      int32_t dotprod = AccumulateNeonLane(dotprod_32x4[g]);
+      // Postamble loop.
+      for (int c = col; c < n_input; ++c) {
+        dotprod += row_ptrs[g][c] * input[c];
+      }
+      dotprod += biases[g][row];
+      int32_t acc =
+          MultiplyByQuantizedMultiplier(dotprod, multipliers[g], shifts[g]);
+      acc += outputs[g][row];
+      acc = std::max(output_min, std::min(output_max, acc));
+      outputs[g][row] = static_cast<int16_t>(acc);
+    }
+  }
+}
+
 void NeonMatrixBatchVectorMultiplyAccumulate(const int8_t* __restrict__ matrix,
                                              const int m_rows, const int m_cols,
                                              const int8_t* __restrict__ vectors,
@@ -99,6 +99,12 @@ void NeonMatrixBatchVectorMultiplyAccumulate(
     int32_t n_batch, int32_t n_input, int32_t n_output, int32_t output_zp,
     int32_t* scratch, int16_t* output, CpuBackendContext* context);
 
+void NeonFourMatrixVectorMultiplyAccumulate(
+    const int8_t* input, const int32_t* const* biases,
+    const int8_t* const* matrices, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_input, int32_t n_output,
+    int16_t** outputs);
+
 void NeonMatrixScalarMultiplyAccumulate(const int8_t* matrix, int32_t scalar,
                                         int32_t n_row, int32_t n_col,
                                         int32_t* output);
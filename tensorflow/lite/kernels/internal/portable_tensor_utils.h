@@ -554,6 +554,26 @@ void MatrixBatchVectorMultiplyAccumulate(
     int32_t n_batch, int32_t n_input, int32_t n_output, int32_t output_zp,
     int32_t* scratch, int16_t* output, CpuBackendContext* context);
 
+// Same as the function above for a single batch with no output zero point,
+// but multiplies the input by four matrices in one pass, e.g. the gate weights
+// of an LSTM. `outputs[g]` accumulates the product with `matrices[g]`, and
+// null matrices are skipped, e.g. the input gate of a CIFG LSTM.
+// Parameters:
+//     - input: vector of size n_input
+//     - biases: four vectors of size n_output
+//     - matrices: four matrices of size n_input * n_output
+//     - multipliers: four scalars
+//     - shifts: four scalars
+//     - n_input: the input size
+//     - n_output: the output size
+//     - outputs: four 16 bit vectors of size n_output
+void FourMatrixVectorMultiplyAccumulate(const int8_t* input,
+                                        const int32_t* const* biases,
+                                        const int8_t* const* matrices,
+                                        const int32_t* multipliers,
+                                        const int32_t* shifts, int32_t n_input,
+                                        int32_t n_output, int16_t** outputs);
+
 // Multiplies a matrix by a "batched" vector (i.e. a matrix with a batch
 // dimension composed by input vectors independent from each other). The result
 // of the multiplication is accumulated to the passed result buffer.
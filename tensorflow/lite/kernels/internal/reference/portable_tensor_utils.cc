@@ -384,6 +384,34 @@ void PortableMatrixBatchVectorMultiplyAccumulate(
       n_output, output_zp, output);
 }
 
+void PortableFourMatrixVectorMultiplyAccumulate(
+    const int8_t* input, const int32_t* const* biases,
+    const int8_t* const* matrices, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_input, int32_t n_output,
+    int16_t** outputs) {
+  const int32_t output_max = std::numeric_limits<int16_t>::max();
+  const int32_t output_min = std::numeric_limits<int16_t>::min();
+  for (int row = 0; row < n_output; ++row) {
+    int32_t acc[4] = {0, 0, 0, 0};
+    for (int col = 0; col < n_input; ++col) {
+      const int32_t input_val = input[col];
+      for (int g = 0; g < 4; ++g) {
+        if (matrices[g] != nullptr) {
+          acc[g] += input_val * matrices[g][row * n_input + col];
+        }
+      }
+    }
+    for (int g = 0; g < 4; ++g) {
+      if (matrices[g] == nullptr) continue;
+      int32_t value = MultiplyByQuantizedMultiplier(acc[g] + biases[g][row],
+                                                    multipliers[g], shifts[g]);
+      value += outputs[g][row];
+      value = std::max(output_min, std::min(output_max, value));
+      outputs[g][row] = static_cast<int16_t>(value);
+    }
+  }
+}
+
 void PortableMatrixBatchVectorMultiply(const int8_t* input,
                                        int32_t input_zeropoint,
                                        const int8_t* input_to_gate_weights,
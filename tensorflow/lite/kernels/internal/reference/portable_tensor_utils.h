@@ -158,6 +158,17 @@ void MatrixBatchVectorMultiplyAccumulate(
       n_output, output_zp, scratch, output, context);
 }
 
+void FourMatrixVectorMultiplyAccumulate(const int8_t* input,
+                                        const int32_t* const* biases,
+                                        const int8_t* const* matrices,
+                                        const int32_t* multipliers,
+                                        const int32_t* shifts, int32_t n_input,
+                                        int32_t n_output, int16_t** outputs) {
+  PortableFourMatrixVectorMultiplyAccumulate(input, biases, matrices,
+                                             multipliers, shifts, n_input,
+                                             n_output, outputs);
+}
+
 void MatrixScalarMultiplyAccumulate(const int8_t* matrix, int32_t scalar,
                                     int32_t n_row, int32_t n_col,
                                     int32_t* output) {
@@ -124,6 +124,12 @@ void PortableMatrixBatchVectorMultiplyAccumulate(
     int32_t n_batch, int32_t n_input, int32_t n_output, int32_t output_zp,
     int32_t* scratch, int16_t* output, CpuBackendContext* context);
 
+void PortableFourMatrixVectorMultiplyAccumulate(
+    const int8_t* input, const int32_t* const* biases,
+    const int8_t* const* matrices, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_input, int32_t n_output,
+    int16_t** outputs);
+
 void PortableMatrixBatchVectorMultiplyAccumulate(
     const int8_t* input, const int32_t* bias,
     const int8_t* input_to_gate_weights, int32_t multiplier, int32_t shift,
@@ -411,6 +411,55 @@ TEST(uKernels, QuantMatrixBatchVectorMultiplyAccumulate8x8_16Test) {
   EXPECT_THAT(output, testing::ElementsAreArray(expected_output));
 }
 
+TEST(uKernels, FourMatrixVectorMultiplyAccumulateTest) {
+  CpuBackendContext context;
+  const int n_input = 20;
+  const int n_output = 5;
+  std::vector<int8_t> input(n_input);
+  for (int i = 0; i < n_input; ++i) input[i] = i * 13 % 51 - 25;
+  std::vector<std::vector<int8_t>> weights(4);
+  std::vector<std::vector<int32_t>> biases(4);
+  std::vector<std::vector<int16_t>> expected_outputs(4);
+  std::vector<std::vector<int16_t>> outputs(4);
+  const int32_t multipliers[4] = {1073741824, 1717986918, 2080364544,
+                                  1288490189};
+  const int32_t shifts[4] = {-1, -2, -2, 0};
+  for (int g = 0; g < 4; ++g) {
+    for (int i = 0; i < n_input * n_output; ++i) {
+      weights[g].push_back((i * (g + 3) + g) % 41 - 20);
+    }
+    for (int i = 0; i < n_output; ++i) {
+      biases[g].push_back((i - 2) * 150 * (g + 1));
+      expected_outputs[g].push_back(i * 100 - 20 * g);
+    }
+    // The output saturates.
+    expected_outputs[g][0] = 32700;
+    outputs[g] = expected_outputs[g];
+  }
+
+  // The first matrix is skipped.
+  std::vector<int32_t> scratch(n_output);
+  for (int g = 1; g < 4; ++g) {
+    MatrixBatchVectorMultiplyAccumulate(
+        input.data(), biases[g].data(), weights[g].data(), multipliers[g],
+        shifts[g], /*n_batch=*/1, n_input, n_output, /*output_zp=*/0,
+        scratch.data(), expected_outputs[g].data(), &context);
+  }
+  const int8_t* matrices[4] = {nullptr, weights[1].data(), weights[2].data(),
+                               weights[3].data()};
+  const int32_t* bias_ptrs[4] = {biases[0].data(), biases[1].data(),
+                                 biases[2].data(), biases[3].data()};
+  int16_t* output_ptrs[4] = {outputs[0].data(), outputs[1].data(),
+                             outputs[2].data(), outputs[3].data()};
+  FourMatrixVectorMultiplyAccumulate(input.data(), bias_ptrs, matrices,
+                                     multipliers, shifts, n_input, n_output,
+                                     output_ptrs);
+
+  for (int g = 0; g < 4; ++g) {
+    EXPECT_THAT(outputs[g], testing::ElementsAreArray(expected_outputs[g]));
+  }
+}
+
 TEST(uKernels, HybridMatrixBatchVectorMultiplyAccumulate8x8_16Test) {
   CpuBackendContext context;
   const std::vector<int8_t> input = {
@@ -42,6 +42,11 @@ namespace builtin {
 namespace lstm_eval {
 namespace {
 
+// The largest batch for which the int8x8_16 LSTM step is computed one batch at
+// a time with fused gate matmuls. Larger batches amortize the weights better
+// with the batched matmuls.
+constexpr int kMaxFusedLstmBatchSize = 4;
+
 void MatrixBatchVectorMultiplyAccumulate(
     const float* matrix, const float* vector, const float* result,
     float* output, int m_rows, int m_cols, int n_batch,
@@ -549,6 +554,52 @@ void CalculateLstmOutputHybrid(
   }
 }
 
+// Applies the peephole connection, layer normalization and activation to the
+// matmul results of a single LSTM gate, int8x8_16 version.
+void FinishLstmGateInteger8x8_16(
+    // Cell state and weights
+    const int16_t* cell_state, const int16_t* cell_to_gate_weights,
+    const int32_t cell_to_gate_scale_a, const int32_t cell_to_gate_scale_b,
+    // Layer normalization parameters (layer norm LSTM)
+    const int16_t* layer_norm_coefficients, const int32_t* layer_norm_bias,
+    const int32_t layer_norm_input_scale_a,
+    const int32_t layer_norm_input_scale_b,
+    const int32_t layer_norm_variance_guard,
+    // Array sizes
+    const int n_batch, const int n_output, const int n_cell,
+    const TfLiteFusedActivation activation,
+    // Input/output
+    int16_t* gate) {
+  const bool use_peephole = (cell_to_gate_weights != nullptr);
+  const bool use_layer_norm = (layer_norm_coefficients != nullptr);
+
+  // For each batch and cell: compute cell_weight * cell_state (peephole LSTM)
+  if (use_peephole) {
+    tensor_utils::VectorBatchVectorCwiseProductAccumulate(
+        cell_to_gate_weights, n_output, cell_state, n_batch,
+        cell_to_gate_scale_a, cell_to_gate_scale_b, gate);
+  }
+  // Do layer normalization (if layer norm LSTM)
+  if (use_layer_norm) {
+    tensor_utils::ApplyLayerNorm(
+        gate, layer_norm_coefficients, layer_norm_bias,
+        layer_norm_input_scale_a, layer_norm_input_scale_b,
+        layer_norm_variance_guard, n_batch, n_cell, gate);
+  }
+  // Apply activation
+  switch (activation) {
+    case kTfLiteActSigmoid:
+      tensor_utils::ApplySigmoid(gate, n_batch, n_cell, gate);
+      break;
+    case kTfLiteActTanh:
+      tensor_utils::ApplyTanh(3, gate, n_batch, n_cell, gate);
+      break;
+    default:
+      // Only Sigmoid or Tanh is used.
+      TFLITE_ASSERT_FALSE;
+  }
+}
+
 // Calculates a single LSTM gate, int8x8_16 version.
 // Implements the same functionality as CalculateLstmGateFloat.
 void CalculateLstmGateInteger8x8_16(
@@ -578,9 +629,6 @@ void CalculateLstmGateInteger8x8_16(
     CpuBackendContext* context,
     // Scratch arrays
     int32_t* scratch5) {
-  const bool use_peephole = (cell_to_gate_weights != nullptr);
-  const bool use_layer_norm = (layer_norm_coefficients != nullptr);
-
   // Initialize scratch buffers with zeros. Note that unlike float and hybrid
   // versions, bias is only used in layer normalization.
   std::fill_n(gate, n_batch * n_cell, 0);
@@ -596,31 +644,11 @@ void CalculateLstmGateInteger8x8_16(
       output_state, recurrent_to_gate_bias, recurrent_to_gate_weights,
       recurrent_to_gate_scale_a, recurrent_to_gate_scale_b, n_batch, n_output,
       n_cell, 0, scratch5, gate, context);
-  // For each batch and cell: compute cell_weight * cell_state (peephole LSTM)
-  if (use_peephole) {
-    tensor_utils::VectorBatchVectorCwiseProductAccumulate(
-        cell_to_gate_weights, n_output, cell_state, n_batch,
-        cell_to_gate_scale_a, cell_to_gate_scale_b, gate);
-  }
-  // Do layer normalization (if layer norm LSTM)
-  if (use_layer_norm) {
-    tensor_utils::ApplyLayerNorm(
-        gate, layer_norm_coefficients, layer_norm_bias,
-        layer_norm_input_scale_a, layer_norm_input_scale_b,
-        layer_norm_variance_guard, n_batch, n_cell, gate);
-  }
-  // Apply activation
-  switch (activation) {
-    case kTfLiteActSigmoid:
-      tensor_utils::ApplySigmoid(gate, n_batch, n_cell, gate);
-      break;
-    case kTfLiteActTanh:
-      tensor_utils::ApplyTanh(3, gate, n_batch, n_cell, gate);
-      break;
-    default:
-      // Only Sigmoid or Tanh is used.
-      TFLITE_ASSERT_FALSE;
-  }
+  FinishLstmGateInteger8x8_16(
+      cell_state, cell_to_gate_weights, cell_to_gate_scale_a,
+      cell_to_gate_scale_b, layer_norm_coefficients, layer_norm_bias,
+      layer_norm_input_scale_a, layer_norm_input_scale_b,
+      layer_norm_variance_guard, n_batch, n_output, n_cell, activation, gate);
 }
 
 // Updates the LSTM cell state, used by both integer LSTM versions.
@@ -1507,6 +1535,105 @@ inline void LstmStepInteger8x8_16(
   if (use_projection) {
     TFLITE_DCHECK(projection_effective_bias);
   }
+  // Small batches are computed one batch at a time, with the matmuls of the
+  // four gates fused so that the input and output state are read once for all
+  // of them, and the gates of the batch stay in cache until the cell and
+  // output are updated. Larger batches use the batched matmuls of each gate.
+  // The per batch peephole computation only matches the batched one if
+  // n_output == n_cell.
+  const bool use_peephole = (cell_to_forget_weight_ptr != nullptr);
+  if (n_batch <= kMaxFusedLstmBatchSize &&
+      (!use_peephole || n_batch == 1 || n_output == n_cell)) {
+    const int8_t* input_weights[4] = {
+        input_to_input_weight_ptr, input_to_forget_weight_ptr,
+        input_to_cell_weight_ptr, input_to_output_weight_ptr};
+    const int32_t* input_biases[4] = {
+        input_to_input_effective_bias, input_to_forget_effective_bias,
+        input_to_cell_effective_bias, input_to_output_effective_bias};
+    const int32_t input_scales_a[4] = {
+        effective_input_to_input_scale_a, effective_input_to_forget_scale_a,
+        effective_input_to_cell_scale_a, effective_input_to_output_scale_a};
+    const int32_t input_scales_b[4] = {
+        effective_input_to_input_scale_b, effective_input_to_forget_scale_b,
+        effective_input_to_cell_scale_b, effective_input_to_output_scale_b};
+    const int8_t* recurrent_weights[4] = {
+        recurrent_to_input_weight_ptr, recurrent_to_forget_weight_ptr,
+        recurrent_to_cell_weight_ptr, recurrent_to_output_weight_ptr};
+    const int32_t* recurrent_biases[4] = {
+        recurrent_to_input_effective_bias, recurrent_to_forget_effective_bias,
+        recurrent_to_cell_effective_bias, recurrent_to_output_effective_bias};
+    const int32_t recurrent_scales_a[4] = {
+        effective_recurrent_to_input_scale_a,
+        effective_recurrent_to_forget_scale_a,
+        effective_recurrent_to_cell_scale_a,
+        effective_recurrent_to_output_scale_a};
+    const int32_t recurrent_scales_b[4] = {
+        effective_recurrent_to_input_scale_b,
+        effective_recurrent_to_forget_scale_b,
+        effective_recurrent_to_cell_scale_b,
+        effective_recurrent_to_output_scale_b};
+
+    for (int b = 0; b < n_batch; ++b) {
+      int16_t* gates[4] = {
+          input_gate_scratch + b * n_cell, forget_gate_scratch + b * n_cell,
+          cell_gate_scratch + b * n_cell, output_gate_scratch + b * n_cell};
+      int16_t* cell_state = cell_state_ptr + b * n_cell;
+      int8_t* output_state = output_state_ptr + b * n_output;
+      for (int g = 0; g < 4; ++g) {
+        if (input_weights[g] != nullptr) std::fill_n(gates[g], n_cell, 0);
+      }
+      tensor_utils::FourMatrixVectorMultiplyAccumulate(
+          input_ptr + b * n_input, input_biases, input_weights, input_scales_a,
+          input_scales_b, n_input, n_cell, gates);
+      tensor_utils::FourMatrixVectorMultiplyAccumulate(
+          output_state, recurrent_biases, recurrent_weights,
+          recurrent_scales_a, recurrent_scales_b, n_output, n_cell, gates);
+
+      if (!use_cifg) {
+        FinishLstmGateInteger8x8_16(
+            cell_state, cell_to_input_weight_ptr,
+            effective_cell_to_input_scale_a, effective_cell_to_input_scale_b,
+            layer_norm_input_weight_ptr, input_gate_bias_ptr,
+            layer_norm_input_scale_a, layer_norm_input_scale_b,
+            input_variance_guard, /*n_batch=*/1, n_output, n_cell,
+            kTfLiteActSigmoid, gates[0]);
+      }
+      FinishLstmGateInteger8x8_16(
+          cell_state, cell_to_forget_weight_ptr,
+          effective_cell_to_forget_scale_a, effective_cell_to_forget_scale_b,
+          layer_norm_forget_weight_ptr, forget_gate_bias_ptr,
+          layer_norm_forget_scale_a, layer_norm_forget_scale_b,
+          forget_variance_guard, /*n_batch=*/1, n_output, n_cell,
+          kTfLiteActSigmoid, gates[1]);
+      FinishLstmGateInteger8x8_16(
+          cell_state, /*cell_to_gate_weights=*/nullptr,
+          /*cell_to_gate_scale_a=*/0, /*cell_to_gate_scale_b=*/0,
+          layer_norm_cell_weight_ptr, cell_gate_bias_ptr,
+          layer_norm_cell_scale_a, layer_norm_cell_scale_b,
+          cell_variance_guard, /*n_batch=*/1, n_output, n_cell,
+          kTfLiteActTanh, gates[2]);
+      UpdateLstmCellInteger(/*n_batch=*/1, n_cell, cell_state,
+                            cell_state_scale, gates[0], gates[1], gates[2],
+                            use_cifg, quantized_cell_clip);
+      // The output gate peephole uses the updated cell state.
+      FinishLstmGateInteger8x8_16(
+          cell_state, cell_to_output_weight_ptr,
+          effective_cell_to_output_scale_a, effective_cell_to_output_scale_b,
+          layer_norm_output_weight_ptr, output_gate_bias_ptr,
+          layer_norm_output_scale_a, layer_norm_output_scale_b,
+          output_variance_guard, /*n_batch=*/1, n_output, n_cell,
+          kTfLiteActSigmoid, gates[3]);
+      CalculateLstmOutputInteger8x8_16(
+          /*n_batch=*/1, n_cell, n_output, cell_state, cell_state_scale,
+          gates[3], effective_hidden_scale_a, effective_hidden_scale_b,
+          hidden_zp, projection_weight_ptr, effective_proj_scale_a,
+          effective_proj_scale_b, projection_effective_bias, output_state_zp,
+          quantized_proj_clip, output_state, context, scratch0 + b * n_cell,
+          scratch4 + b * n_cell, scratch5);
+    }
+    std::copy_n(output_state_ptr, n_batch * n_output, output_ptr);
+    return;
+  }
   if (!use_cifg) {
     // Calculate the input gate. (If not CIFG.)
     CalculateLstmGateInteger8x8_16(
@@ -226,6 +226,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* subgraphs = this_subgraph->GetSubgraphs();
   Subgraph* decomposition_subgraph =
       (*subgraphs)[op_state->subgraph_index].get();
+  this_subgraph->LendFreeArenaTo({decomposition_subgraph});
 
   if (op_state->subgraph_has_dynamic_output_tensors) {
     TF_LITE_ENSURE_OK(context, Eval_dynamic(context, node, this_subgraph,
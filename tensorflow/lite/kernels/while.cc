@@ -460,6 +460,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   if (op_data->subgraphs_prepared == false) {
     TF_LITE_ENSURE_OK(context, Prepare_impl(context, node));
   } else {
+    this_subgraph->LendFreeArenaTo({cond_subgraph, body_subgraph});
     TF_LITE_ENSURE_OK(context, cond_subgraph->AllocateTensors());
     TF_LITE_ENSURE_OK(context, body_subgraph->AllocateTensors());
   }
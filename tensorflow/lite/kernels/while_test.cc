@@ -380,6 +380,38 @@ TEST_F(WhileTest, TestTriangularNumberSequence) {
   }
 }
 
+TEST_F(WhileTest, TestTriangularNumberSequenceWithSharedArenas) {
+  const std::vector<int> expected = {1, 3, 6, 10, 15, 21, 28};
+  for (int i = 0; i < expected.size(); ++i) {
+    interpreter_ = std::make_unique<Interpreter>();
+    AddSubgraphs(2);
+    builder_->BuildLessEqualCondSubgraph(interpreter_->subgraph(1), i);
+    builder_->BuildAccumulateLoopBodySubgraph(interpreter_->subgraph(2));
+    builder_->BuildWhileSubgraph(&interpreter_->primary_subgraph());
+
+    InterpreterOptions options;
+    options.SetShareSubgraphArenas();
+    ASSERT_EQ(interpreter_->ApplyOptions(&options), kTfLiteOk);
+    ASSERT_EQ(interpreter_->ResizeInputTensor(interpreter_->inputs()[0], {1}),
+              kTfLiteOk);
+    ASSERT_EQ(interpreter_->ResizeInputTensor(interpreter_->inputs()[1], {1}),
+              kTfLiteOk);
+    ASSERT_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+
+    // The first invocation runs the subgraphs on the memory allocated by
+    // AllocateTensors(), the later ones on memory lent by the caller.
+    for (int run = 0; run < 3; ++run) {
+      FillIntTensor(interpreter_->tensor(interpreter_->inputs()[0]), {1});
+      FillIntTensor(interpreter_->tensor(interpreter_->inputs()[1]), {1});
+      ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+      TfLiteTensor* output1 = interpreter_->tensor(interpreter_->outputs()[0]);
+      CheckIntTensor(output1, {1}, {i + 1});
+      TfLiteTensor* output2 = interpreter_->tensor(interpreter_->outputs()[1]);
+      CheckIntTensor(output2, {1}, {expected[i]});
+    }
+  }
+}
+
 TEST_F(WhileTest, TestTriangularNumberSequenceWithShallowCopy) {
   const std::vector<int> expected = {1, 3, 6, 10, 15, 21, 28};
   for (int i = 0; i < expected.size(); ++i) {
@@ -69,6 +69,23 @@ class MemoryPlanner {
   // Returns a map of allocation information. It's only used for debugging.
   virtual void GetAllocInfo(size_t *arena_size,
                             size_t *arena_persist_size) const = 0;
+
+  // Returns in `ptr` and `size` the part of the non-persistent memory that no
+  // tensor live at `node` uses, which may be lent to the subgraphs the node
+  // runs. Planners that can't tell return an empty region.
+  virtual void GetFreeNonPersistentMemory(int node, char **ptr,
+                                          size_t *size) const {
+    *ptr = nullptr;
+    *size = 0;
+  }
+
+  // Lends the `size` bytes at `ptr` to hold the non-persistent tensors as far
+  // as they fit, until ReleaseNonPersistentMemory() is called. Planners may
+  // ignore the loan.
+  virtual void LendNonPersistentMemory(char *ptr, size_t size) {}
+
+  // Returns the size of the non-persistent memory that the current plan needs.
+  virtual size_t GetRequiredNonPersistentMemory() const { return 0; }
 };
 
 }  // namespace tflite
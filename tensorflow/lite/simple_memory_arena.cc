@@ -50,6 +50,16 @@ limitations under the License.
 #define TF_LITE_HAS_ALIGNED_ALLOC 1
 #endif
 
+#if defined(__linux__) && !defined(__ANDROID__)
+// Large arenas are mapped directly from the OS on Linux servers, see
+// ResizableAlignedBuffer::ResizeMapped().
+#define TF_LITE_USE_MAPPED_ARENA 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define TF_LITE_USE_MAPPED_ARENA 0
+#endif
+
 namespace {
 
 template <typename T>
@@ -145,6 +155,13 @@ tflite::PointerAlignedPointerPair AlignedRealloc(
   return new_buffer;
 }
 #endif
+
+#if TF_LITE_USE_MAPPED_ARENA
+// Arenas of at least this size are mapped rather than allocated with malloc,
+// and their mappings are sized in multiples of it. It is the size of a huge
+// page on x86-64 and most aarch64 configurations.
+constexpr size_t kMappedArenaGranularity = size_t{2} << 20;  // 2MB
+#endif
 }  // namespace
 
 namespace tflite {
@@ -163,9 +180,12 @@ bool ResizableAlignedBuffer::Resize(size_t new_size) {
                          reinterpret_cast<std::uintptr_t>(this), data_size_);
   }
 #endif
-  auto new_buffer = AlignedRealloc(buffer_, data_size_, new_size, alignment_);
-  bool reallocated = (new_buffer.aligned_pointer != buffer_.aligned_pointer);
-  buffer_ = new_buffer;
+  bool reallocated = false;
+  if (!ResizeMapped(new_size, &reallocated)) {
+    auto new_buffer = AlignedRealloc(buffer_, data_size_, new_size, alignment_);
+    reallocated = (new_buffer.aligned_pointer != buffer_.aligned_pointer);
+    buffer_ = new_buffer;
+  }
   data_size_ = new_size;
 #ifdef TF_LITE_TENSORFLOW_PROFILER
   PauseHeapMonitoring(/*pause=*/false);
@@ -173,6 +193,63 @@ bool ResizableAlignedBuffer::Resize(size_t new_size) {
   return reallocated;
 }
 
+bool ResizableAlignedBuffer::ResizeMapped(size_t new_size, bool* reallocated) {
+#if TF_LITE_USE_MAPPED_ARENA
+  if (mapped_size_ == 0 &&
+      (new_size < kMappedArenaGranularity ||
+       alignment_ > static_cast<size_t>(sysconf(_SC_PAGESIZE)))) {
+    return false;
+  }
+  const size_t new_mapped_size = AlignTo(kMappedArenaGranularity, new_size);
+  if (new_mapped_size <= mapped_size_) {
+    // The mapping is already large enough.
+    *reallocated = false;
+    return true;
+  }
+  void* pointer;
+  if (mapped_size_ > 0) {
+    // mremap() moves the pages of the mapping if it cannot grow in place, so
+    // the contents are never copied.
+    pointer = mremap(buffer_.pointer, mapped_size_, new_mapped_size,
+                     MREMAP_MAYMOVE);
+    if (pointer == MAP_FAILED) {
+      // Fall back to malloc, which needs the old contents copied over.
+      auto new_buffer = AlignedAlloc(new_size, alignment_);
+      std::memcpy(new_buffer.aligned_pointer, buffer_.aligned_pointer,
+                  data_size_);
+      munmap(buffer_.pointer, mapped_size_);
+      mapped_size_ = 0;
+      buffer_ = new_buffer;
+      *reallocated = true;
+      return true;
+    }
+  } else {
+    pointer = mmap(nullptr, new_mapped_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pointer == MAP_FAILED) {
+      return false;
+    }
+    if (data_size_ > 0) {
+      std::memcpy(pointer, buffer_.aligned_pointer, data_size_);
+    }
+    AlignedFree(buffer_);
+  }
+#ifdef MADV_HUGEPAGE
+  // Large arenas are accessed all over for each inference, so back them with
+  // transparent huge pages where the kernel allows it. This is only advice,
+  // and failing to follow it is harmless.
+  madvise(pointer, new_mapped_size, MADV_HUGEPAGE);
+#endif
+  *reallocated = pointer != buffer_.aligned_pointer;
+  buffer_.pointer = reinterpret_cast<char*>(pointer);
+  buffer_.aligned_pointer = buffer_.pointer;
+  mapped_size_ = new_mapped_size;
+  return true;
+#else
+  return false;
+#endif
+}
+
 void ResizableAlignedBuffer::Release() {
   if (buffer_.pointer == nullptr) {
     return;
@@ -181,7 +258,16 @@ void ResizableAlignedBuffer::Release() {
   OnTfLiteArenaDealloc(subgraph_index_, reinterpret_cast<std::uintptr_t>(this),
                        data_size_);
 #endif
+#if TF_LITE_USE_MAPPED_ARENA
+  if (mapped_size_ > 0) {
+    munmap(buffer_.pointer, mapped_size_);
+    mapped_size_ = 0;
+  } else {
+    AlignedFree(buffer_);
+  }
+#else
   AlignedFree(buffer_);
+#endif
   buffer_.pointer = nullptr;
   buffer_.aligned_pointer = nullptr;
   data_size_ = 0;
@@ -228,6 +314,19 @@ void SimpleMemoryArena::CalculateActiveAllocs(
   std::sort(active_allocs_.begin(), active_allocs_.end());
 }
 
+void SimpleMemoryArena::RestoreAllocs(
+    const std::vector<ArenaAllocWithUsageInterval>& allocs) {
+  active_allocs_.clear();
+  high_water_mark_ = 0;
+  for (const ArenaAllocWithUsageInterval& alloc : allocs) {
+    if (alloc.size == 0) continue;
+    active_allocs_.push_back(alloc);
+    high_water_mark_ = std::max(high_water_mark_, alloc.offset + alloc.size);
+  }
+  // Allocate() inserts after the allocs with the same offset.
+  std::stable_sort(active_allocs_.begin(), active_allocs_.end());
+}
+
 void SimpleMemoryArena::ResetAllocs() { active_allocs_.clear(); }
 
 TfLiteStatus SimpleMemoryArena::Allocate(
@@ -285,25 +384,57 @@ TfLiteStatus SimpleMemoryArena::Allocate(
 }
 
 TfLiteStatus SimpleMemoryArena::Commit(bool* arena_reallocated) {
-  // Resize the arena to the high water mark (calculated by Allocate), retaining
-  // old contents and alignment in the process. Since Alloc pointers are offset
-  // based, they will remain valid in the new memory block.
-  *arena_reallocated = underlying_buffer_.Resize(high_water_mark_);
+  const bool fits_borrowed =
+      borrowed_ptr_ != nullptr && high_water_mark_ <= borrowed_size_ &&
+      reinterpret_cast<std::uintptr_t>(borrowed_ptr_) %
+              underlying_buffer_.GetAlignment() ==
+          0;
+  if (!fits_borrowed && !using_borrowed_) {
+    // Resize the arena to the high water mark (calculated by Allocate),
+    // retaining old contents and alignment in the process. Since Alloc pointers
+    // are offset based, they will remain valid in the new memory block.
+    *arena_reallocated = underlying_buffer_.Resize(high_water_mark_);
+    committed_ = true;
+    return kTfLiteOk;
+  }
+
+  // Move the old contents between the own buffer and the borrowed region, or
+  // between two borrowed regions, which may overlap.
+  char* const old_ptr = GetCommittedPtr();
+  const size_t old_size = GetCommittedSize();
+  char* new_ptr;
+  if (fits_borrowed) {
+    new_ptr = borrowed_ptr_;
+    borrowed_used_size_ = high_water_mark_;
+  } else {
+    underlying_buffer_.Resize(high_water_mark_);
+    new_ptr = underlying_buffer_.GetPtr();
+  }
+  if (new_ptr != old_ptr && old_ptr != nullptr) {
+    std::memmove(new_ptr, old_ptr, std::min(old_size, high_water_mark_));
+  }
+  if (fits_borrowed && !using_borrowed_) underlying_buffer_.Release();
+  using_borrowed_ = fits_borrowed;
+  *arena_reallocated = new_ptr != old_ptr;
   committed_ = true;
   return kTfLiteOk;
 }
 
+void SimpleMemoryArena::BorrowBuffer(char* ptr, size_t size) {
+  borrowed_ptr_ = ptr;
+  borrowed_size_ = ptr == nullptr ? 0 : size;
+}
+
 TfLiteStatus SimpleMemoryArena::ResolveAlloc(
     TfLiteContext* context, const ArenaAllocWithUsageInterval& alloc,
     char** output_ptr) {
   TF_LITE_ENSURE(context, committed_);
   TF_LITE_ENSURE(context, output_ptr != nullptr);
-  TF_LITE_ENSURE(context,
-                 underlying_buffer_.GetSize() >= (alloc.offset + alloc.size));
+  TF_LITE_ENSURE(context, GetCommittedSize() >= (alloc.offset + alloc.size));
   if (alloc.size == 0) {
     *output_ptr = nullptr;
   } else {
-    *output_ptr = underlying_buffer_.GetPtr() + alloc.offset;
+    *output_ptr = GetCommittedPtr() + alloc.offset;
   }
   return kTfLiteOk;
 }
@@ -318,6 +449,10 @@ TfLiteStatus SimpleMemoryArena::ClearPlan() {
 TfLiteStatus SimpleMemoryArena::ReleaseBuffer() {
   committed_ = false;
   underlying_buffer_.Release();
+  borrowed_ptr_ = nullptr;
+  borrowed_size_ = 0;
+  using_borrowed_ = false;
+  borrowed_used_size_ = 0;
   return kTfLiteOk;
 }
 
@@ -329,7 +464,7 @@ TFLITE_ATTRIBUTE_WEAK void DumpArenaInfo(
 
 void SimpleMemoryArena::DumpDebugInfo(
     const std::string& name, const std::vector<int>& execution_plan) const {
-  tflite::DumpArenaInfo(name, execution_plan, underlying_buffer_.GetSize(),
+  tflite::DumpArenaInfo(name, execution_plan, GetCommittedSize(),
                         active_allocs_);
 }
 
@@ -63,11 +63,13 @@ class ResizableAlignedBuffer {
   ResizableAlignedBuffer(size_t alignment, int subgraph_index)
       : buffer_{nullptr, nullptr},
         data_size_(0),
+        mapped_size_(0),
         alignment_(alignment),
         subgraph_index_(subgraph_index) {
-    // To silence unused private member warning, only used with
-    // TF_LITE_TENSORFLOW_PROFILER
+    // To silence unused private member warnings, only used with
+    // TF_LITE_TENSORFLOW_PROFILER and on Linux respectively.
     (void)subgraph_index_;
+    (void)mapped_size_;
   }
 
   ~ResizableAlignedBuffer() { Release(); }
@@ -93,8 +95,15 @@ class ResizableAlignedBuffer {
   ResizableAlignedBuffer(ResizableAlignedBuffer&&) = delete;
   ResizableAlignedBuffer& operator=(ResizableAlignedBuffer&&) = delete;
 
+  // On Linux, buffers of 2MB or more are mmap()ed in multiples of 2MB, advised
+  // to use transparent huge pages, and grown with mremap() instead of copies.
+  // Returns false if the buffer should be resized with malloc instead.
+  bool ResizeMapped(size_t new_size, bool* reallocated);
+
   PointerAlignedPointerPair buffer_;
   size_t data_size_;
+  // Size of the mapping holding the buffer, or 0 if it was malloc()ed.
+  size_t mapped_size_;
   size_t alignment_;
 
   int subgraph_index_;
@@ -111,6 +120,10 @@ class SimpleMemoryArena {
       : committed_(false),
         high_water_mark_(0),
         underlying_buffer_(arena_alignment, subgraph_index),
+        borrowed_ptr_(nullptr),
+        borrowed_size_(0),
+        using_borrowed_(false),
+        borrowed_used_size_(0),
         active_allocs_() {}
 
   // Delete all allocs. This should be called when allocating the first node of
@@ -135,6 +148,11 @@ class SimpleMemoryArena {
   void CalculateActiveAllocs(
       const std::vector<ArenaAllocWithUsageInterval>& allocs, int32_t node);
 
+  // Replaces all allocs with `allocs`, in the state Allocate() would have left
+  // the arena in after allocating them in order following ClearPlan(). This
+  // restores a plan calculated earlier without searching for offsets again.
+  void RestoreAllocs(const std::vector<ArenaAllocWithUsageInterval>& allocs);
+
   // Schedule memory allocation for a tensor with a given size, assuming that it
   // needs to be allocated before the execution of first_node, and deallocated
   // after the execution of last_node.
@@ -144,6 +162,14 @@ class SimpleMemoryArena {
 
   TfLiteStatus Commit(bool* arena_reallocated);
 
+  // Lends the arena the `size` bytes at `ptr`, which it then commits its
+  // allocations to instead of its own buffer as long as they fit. If they
+  // outgrow the region, Commit() moves them back to the own buffer. The region
+  // must stay valid until ReleaseBuffer(), which ends the loan, or until the
+  // Commit() after the next call. Passing nullptr ends the loan at the next
+  // Commit().
+  void BorrowBuffer(char* ptr, size_t size);
+
   TfLiteStatus ResolveAlloc(TfLiteContext* context,
                             const ArenaAllocWithUsageInterval& alloc,
                             char** output_ptr);
@@ -158,10 +184,21 @@ class SimpleMemoryArena {
   // again until Commit() is called & tensor allocations are resolved.
   TfLiteStatus ReleaseBuffer();
 
+  // Size of the buffer owned by the arena, which is 0 while the allocations
+  // live in a borrowed region.
   size_t GetBufferSize() const { return underlying_buffer_.GetSize(); }
 
+  // Size of the memory that the committed allocations live in, owned or
+  // borrowed.
+  size_t GetCommittedSize() const {
+    return using_borrowed_ ? borrowed_used_size_ : underlying_buffer_.GetSize();
+  }
+
+  // Size of the memory needed by the planned allocations.
+  size_t GetRequiredSize() const { return high_water_mark_; }
+
   std::intptr_t BasePointer() const {
-    return reinterpret_cast<std::intptr_t>(underlying_buffer_.GetPtr());
+    return reinterpret_cast<std::intptr_t>(GetCommittedPtr());
   }
 
   // Dumps the memory allocation information of this memory arena (which could
@@ -182,9 +219,19 @@ class SimpleMemoryArena {
                      const std::vector<int>& execution_plan) const;
 
  private:
+  char* GetCommittedPtr() const {
+    return using_borrowed_ ? borrowed_ptr_ : underlying_buffer_.GetPtr();
+  }
+
   bool committed_;
   size_t high_water_mark_;
   ResizableAlignedBuffer underlying_buffer_;
+  // Region lent by BorrowBuffer(), and whether the allocations live in it, in
+  // which case they use its first `borrowed_used_size_` bytes.
+  char* borrowed_ptr_;
+  size_t borrowed_size_;
+  bool using_borrowed_;
+  size_t borrowed_used_size_;
   std::vector<ArenaAllocWithUsageInterval> active_allocs_;
 };
 
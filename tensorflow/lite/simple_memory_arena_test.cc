@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/simple_memory_arena.h"
 
+#include <cstring>
+
 #include <gtest/gtest.h>
 #include "tensorflow/lite/core/c/common.h"
 
@@ -323,6 +325,68 @@ TEST(SimpleMemoryArenaTest, TestClearBuffer) {
 
 // Test parameterized by whether ClearBuffer() is called before ClearPlan(), or
 // vice versa.
+TEST(SimpleMemoryArenaTest, TestBorrowBuffer) {
+  TfLiteContext context;
+  SimpleMemoryArena arena(64);
+  ArenaAllocWithUsageInterval allocs[2];
+  alignas(64) char borrowed[256];
+
+  arena.Allocate(&context, 32, 128, 0, 0, 2, &allocs[0]);
+  arena.BorrowBuffer(borrowed, sizeof(borrowed));
+  bool reallocated = false;
+  ASSERT_EQ(arena.Commit(&reallocated), kTfLiteOk);
+  EXPECT_TRUE(reallocated);
+  EXPECT_EQ(arena.GetBufferSize(), size_t{0});
+  char* resolved_ptr = nullptr;
+  ASSERT_EQ(arena.ResolveAlloc(&context, allocs[0], &resolved_ptr), kTfLiteOk);
+  EXPECT_EQ(resolved_ptr, borrowed);
+  std::memset(resolved_ptr, 7, 128);
+
+  // Outgrowing the borrowed region moves the allocations to an own buffer,
+  // with their contents.
+  arena.Allocate(&context, 32, 256, 1, 1, 2, &allocs[1]);
+  ASSERT_EQ(arena.Commit(&reallocated), kTfLiteOk);
+  EXPECT_TRUE(reallocated);
+  EXPECT_GE(arena.GetBufferSize(), size_t{384});
+  ASSERT_EQ(arena.ResolveAlloc(&context, allocs[0], &resolved_ptr), kTfLiteOk);
+  EXPECT_NE(resolved_ptr, borrowed);
+  EXPECT_EQ(resolved_ptr[0], 7);
+  EXPECT_EQ(resolved_ptr[127], 7);
+
+  // Releasing the buffer ends the loan.
+  ASSERT_EQ(arena.ReleaseBuffer(), kTfLiteOk);
+  EXPECT_EQ(arena.GetCommittedSize(), size_t{0});
+}
+
+TEST(SimpleMemoryArenaTest, TestGrowLargeArena) {
+  TfLiteContext context;
+  SimpleMemoryArena arena(64);
+  ArenaAllocWithUsageInterval allocs[3];
+
+  // Grow the arena from a small buffer to several megabytes, in steps that
+  // cross the sizes at which large arenas are handled differently, and check
+  // that the contents are kept.
+  const size_t sizes[] = {1 << 10, 3 << 20, 9 << 20};
+  char* resolved_ptr = nullptr;
+  for (int i = 0; i < 3; ++i) {
+    arena.Allocate(&context, 64, sizes[i], i, i, 3, &allocs[i]);
+    bool reallocated = false;
+    ASSERT_EQ(arena.Commit(&reallocated), kTfLiteOk);
+    EXPECT_GE(arena.GetBufferSize(), allocs[i].offset + sizes[i]);
+    ASSERT_EQ(arena.ResolveAlloc(&context, allocs[i], &resolved_ptr),
+              kTfLiteOk);
+    std::memset(resolved_ptr, i + 1, sizes[i]);
+    for (int j = 0; j < i; ++j) {
+      ASSERT_EQ(arena.ResolveAlloc(&context, allocs[j], &resolved_ptr),
+                kTfLiteOk);
+      EXPECT_EQ(resolved_ptr[0], j + 1);
+      EXPECT_EQ(resolved_ptr[sizes[j] - 1], j + 1);
+    }
+  }
+  ASSERT_EQ(arena.ReleaseBuffer(), kTfLiteOk);
+  EXPECT_EQ(arena.GetBufferSize(), size_t{0});
+}
+
 class BufferAndPlanClearingTest : public ::testing::Test,
                                   public ::testing::WithParamInterface<bool> {};
 
@@ -0,0 +1,378 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/benchmark_concurrent_models.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_params.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+// The delegates that --concurrent_delegates can pick, with the parameter that
+// enables each of them. "cpu" disables all of them.
+constexpr const char* kDelegates[][2] = {{"xnnpack", "use_xnnpack"},
+                                         {"gpu", "use_gpu"},
+                                         {"nnapi", "use_nnapi"}};
+
+TfLiteStatus UseDelegate(const std::string& delegate,
+                         BenchmarkParams* params) {
+  bool found = delegate == "cpu";
+  for (const auto& [name, param] : kDelegates) {
+    if (params->HasParam(param)) params->Set<bool>(param, false);
+    if (delegate != name) continue;
+    if (!params->HasParam(param)) {
+      TFLITE_LOG(ERROR) << "The " << delegate
+                        << " delegate isn't available in this binary.";
+      return kTfLiteError;
+    }
+    params->Set<bool>(param, true);
+    found = true;
+  }
+  if (!found) {
+    TFLITE_LOG(ERROR) << "Unknown delegate in --concurrent_delegates: '"
+                      << delegate << "'. Valid values are cpu, xnnpack, gpu "
+                      << "and nnapi.";
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+void LatencyRecorder::OnBenchmarkStart(const BenchmarkParams& params) {
+  started_ = true;
+  if (on_benchmark_start) on_benchmark_start();
+}
+
+void LatencyRecorder::OnSingleRunStart(RunType run_type) {
+  regular_run_ = run_type == REGULAR;
+  run_start_us_ = profiling::time::NowMicros();
+}
+
+void LatencyRecorder::OnSingleRunEnd() {
+  if (!regular_run_) return;
+  const int64_t end_us = profiling::time::NowMicros();
+  latencies_us_.push_back(end_us - run_start_us_);
+  if (first_start_us_ < 0) first_start_us_ = run_start_us_;
+  last_end_us_ = end_us;
+}
+
+int64_t LatencyRecorder::Percentile(double percentile) const {
+  if (latencies_us_.empty()) return -1;
+  std::vector<int64_t> sorted = latencies_us_;
+  std::sort(sorted.begin(), sorted.end());
+  const size_t rank = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+void BenchmarkConcurrentModels::StartGate::Arrive() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (--pending_ <= 0) {
+    all_arrived_.notify_all();
+    return;
+  }
+  all_arrived_.wait(lock, [this] { return pending_ <= 0; });
+}
+
+void BenchmarkConcurrentModels::StartGate::Leave() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (--pending_ <= 0) all_arrived_.notify_all();
+}
+
+BenchmarkConcurrentModels::BenchmarkConcurrentModels(ModelFactory create_model)
+    : params_(DefaultParams()), create_model_(std::move(create_model)) {}
+
+BenchmarkParams BenchmarkConcurrentModels::DefaultParams() {
+  BenchmarkParams params;
+  params.AddParam("concurrent_graphs",
+                  BenchmarkParam::Create<std::string>(""));
+  params.AddParam("num_concurrent_instances",
+                  BenchmarkParam::Create<int32_t>(2));
+  params.AddParam("concurrent_delegates",
+                  BenchmarkParam::Create<std::string>(""));
+  params.AddParam("concurrent_run_frequencies",
+                  BenchmarkParam::Create<std::string>(""));
+  params.AddParam("measure_isolated_latency",
+                  BenchmarkParam::Create<bool>(true));
+  return params;
+}
+
+std::vector<Flag> BenchmarkConcurrentModels::GetFlags() {
+  return {
+      CreateFlag<std::string>(
+          "concurrent_graphs", &params_,
+          "A comma-separated list of models to run concurrently, each in its "
+          "own interpreter and thread. A model may be repeated. By default, "
+          "--num_concurrent_instances instances of --graph are run."),
+      CreateFlag<int32_t>("num_concurrent_instances", &params_,
+                          "The number of instances of --graph to run "
+                          "concurrently when --concurrent_graphs isn't set."),
+      CreateFlag<std::string>(
+          "concurrent_delegates", &params_,
+          "A comma-separated list of delegates (cpu, xnnpack, gpu or nnapi) "
+          "used by the instances, in order. The list is repeated if it is "
+          "shorter than the number of instances. By default, all the instances "
+          "use the delegates set by the single-model flags."),
+      CreateFlag<std::string>(
+          "concurrent_run_frequencies", &params_,
+          "A comma-separated list of run frequencies (i.e. arrival rates in "
+          "runs per second) of the instances, in order. The list is repeated "
+          "if it is shorter than the number of instances. A non-positive value "
+          "runs the instance back to back. By default, --run_frequency is "
+          "used."),
+      CreateFlag<bool>(
+          "measure_isolated_latency", &params_,
+          "Whether to also run each instance alone first, to report how much "
+          "slower it is when running concurrently with the others.")};
+}
+
+TfLiteStatus BenchmarkConcurrentModels::ParseFlags(int* argc, char** argv) {
+  auto flag_list = GetFlags();
+  const bool parse_result =
+      Flags::Parse(argc, const_cast<const char**>(argv), flag_list);
+  if (!parse_result) {
+    std::string usage = Flags::Usage(argv[0], flag_list);
+    TFLITE_LOG(ERROR) << usage;
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkConcurrentModels::CreateInstanceParams() {
+  std::vector<std::string> graphs;
+  const auto& graphs_list = params_.Get<std::string>("concurrent_graphs");
+  if (!graphs_list.empty()) {
+    if (!util::SplitAndParse(graphs_list, ',', &graphs) || graphs.empty()) {
+      TFLITE_LOG(ERROR) << "Cannot parse --concurrent_graphs: '" << graphs_list
+                        << "'.";
+      return kTfLiteError;
+    }
+  } else {
+    const int32_t num_instances =
+        params_.Get<int32_t>("num_concurrent_instances");
+    if (num_instances < 1) {
+      TFLITE_LOG(ERROR) << "--num_concurrent_instances must be positive.";
+      return kTfLiteError;
+    }
+    // An empty graph keeps the one set by --graph.
+    graphs.resize(num_instances);
+  }
+
+  std::vector<std::string> delegates;
+  const auto& delegates_list = params_.Get<std::string>("concurrent_delegates");
+  if (!delegates_list.empty() &&
+      !util::SplitAndParse(delegates_list, ',', &delegates)) {
+    TFLITE_LOG(ERROR) << "Cannot parse --concurrent_delegates: '"
+                      << delegates_list << "'.";
+    return kTfLiteError;
+  }
+
+  std::vector<float> frequencies;
+  const auto& frequencies_list =
+      params_.Get<std::string>("concurrent_run_frequencies");
+  if (!frequencies_list.empty() &&
+      !util::SplitAndParse(frequencies_list, ',', &frequencies)) {
+    TFLITE_LOG(ERROR) << "Cannot parse --concurrent_run_frequencies: '"
+                      << frequencies_list << "'.";
+    return kTfLiteError;
+  }
+
+  instance_params_.clear();
+  instance_delegates_.clear();
+  for (size_t i = 0; i < graphs.size(); ++i) {
+    BenchmarkParams params;
+    params.Merge(*template_model_->mutable_params());
+    if (!graphs[i].empty()) {
+      if (!params.HasParam("graph")) {
+        TFLITE_LOG(ERROR) << "--concurrent_graphs isn't supported by the "
+                             "benchmarked models.";
+        return kTfLiteError;
+      }
+      params.Set<std::string>("graph", graphs[i]);
+    }
+    if (delegates.empty()) {
+      instance_delegates_.emplace_back("default delegates");
+    } else {
+      const std::string& delegate = delegates[i % delegates.size()];
+      TF_LITE_ENSURE_STATUS(UseDelegate(delegate, &params));
+      instance_delegates_.push_back(delegate);
+    }
+    if (!frequencies.empty()) {
+      params.Set<float>("run_frequency", frequencies[i % frequencies.size()]);
+    }
+    instance_params_.push_back(std::move(params));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkConcurrentModels::RunConcurrently(
+    const std::vector<const BenchmarkParams*>& params,
+    std::vector<std::unique_ptr<LatencyRecorder>>* recorders) {
+  const int num_instances = params.size();
+  StartGate gate(num_instances);
+  std::vector<std::unique_ptr<BenchmarkModel>> models;
+  recorders->clear();
+  for (const BenchmarkParams* instance_params : params) {
+    models.push_back(create_model_());
+    models.back()->mutable_params()->Set(*instance_params);
+    recorders->push_back(std::make_unique<LatencyRecorder>());
+    // Start the warmup runs of all the instances together, as the time they
+    // take to initialize differs.
+    recorders->back()->on_benchmark_start = [&gate] { gate.Arrive(); };
+    models.back()->AddListener(recorders->back().get());
+  }
+
+  std::vector<TfLiteStatus> statuses(num_instances, kTfLiteOk);
+  std::vector<std::thread> threads;
+  threads.reserve(num_instances);
+  for (int i = 0; i < num_instances; ++i) {
+    threads.emplace_back([&, i] {
+      statuses[i] = models[i]->Run();
+      if (!(*recorders)[i]->started()) gate.Leave();
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (int i = 0; i < num_instances; ++i) {
+    if (statuses[i] != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Error while running concurrent instance " << i
+                        << ": " << statuses[i];
+      return statuses[i];
+    }
+  }
+  return kTfLiteOk;
+}
+
+void BenchmarkConcurrentModels::OutputStats(
+    const std::vector<std::unique_ptr<LatencyRecorder>>& concurrent,
+    const std::vector<std::unique_ptr<LatencyRecorder>>& isolated) const {
+  TFLITE_LOG(INFO) << "\n==============Summary of Concurrent Runs"
+                      "==============";
+  int64_t first_start_us = std::numeric_limits<int64_t>::max();
+  int64_t last_end_us = -1;
+  size_t num_runs = 0;
+  for (size_t i = 0; i < concurrent.size(); ++i) {
+    const LatencyRecorder& recorder = *concurrent[i];
+    const BenchmarkParams& params = instance_params_[i];
+    std::stringstream stream;
+    stream << "Instance " << i << " (";
+    if (params.HasParam("graph")) {
+      stream << params.Get<std::string>("graph") << ", ";
+    }
+    stream << instance_delegates_[i];
+    const float run_frequency = params.Get<float>("run_frequency");
+    if (run_frequency > 0) stream << ", " << run_frequency << " runs/s";
+    const int64_t p50 = recorder.Percentile(50);
+    stream << "): count=" << recorder.latencies_us().size() << " p50=" << p50
+           << " p90=" << recorder.Percentile(90)
+           << " p99=" << recorder.Percentile(99)
+           << " max=" << recorder.Percentile(100) << " (us)";
+    if (i < isolated.size()) {
+      const int64_t isolated_p50 = isolated[i]->Percentile(50);
+      stream << ", isolated p50=" << isolated_p50 << " (us)";
+      if (p50 >= 0 && isolated_p50 > 0) {
+        stream << ", slowdown=" << std::setprecision(3)
+               << static_cast<double>(p50) / isolated_p50 << "x";
+      }
+    }
+    TFLITE_LOG(INFO) << stream.str();
+
+    if (!recorder.latencies_us().empty()) {
+      num_runs += recorder.latencies_us().size();
+      first_start_us = std::min(first_start_us, recorder.first_start_us());
+      last_end_us = std::max(last_end_us, recorder.last_end_us());
+    }
+  }
+  if (num_runs > 0 && last_end_us > first_start_us) {
+    const double duration_secs = (last_end_us - first_start_us) / 1e6;
+    TFLITE_LOG(INFO) << "Aggregate throughput: " << num_runs / duration_secs
+                     << " runs/s (" << num_runs << " runs in " << duration_secs
+                     << " s).";
+  }
+}
+
+TfLiteStatus BenchmarkConcurrentModels::Run() {
+  if (template_model_ == nullptr) template_model_ = create_model_();
+  TF_LITE_ENSURE_STATUS(CreateInstanceParams());
+
+  std::vector<const BenchmarkParams*> all_params;
+  for (const BenchmarkParams& params : instance_params_) {
+    all_params.push_back(&params);
+  }
+
+  std::vector<std::unique_ptr<LatencyRecorder>> isolated;
+  if (params_.Get<bool>("measure_isolated_latency")) {
+    for (const BenchmarkParams* params : all_params) {
+      std::vector<std::unique_ptr<LatencyRecorder>> recorders;
+      TF_LITE_ENSURE_STATUS(RunConcurrently({params}, &recorders));
+      isolated.push_back(std::move(recorders.front()));
+    }
+  }
+
+  std::vector<std::unique_ptr<LatencyRecorder>> concurrent;
+  TF_LITE_ENSURE_STATUS(RunConcurrently(all_params, &concurrent));
+  OutputStats(concurrent, isolated);
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkConcurrentModels::Run(int argc, char** argv) {
+  // Parse flags that are supported by this particular binary first.
+  if (TfLiteStatus status = ParseFlags(&argc, argv); status != kTfLiteOk) {
+    TFLITE_LOG(ERROR) << "Error while parsing the flags for concurrent runs: "
+                      << status;
+    return status;
+  }
+
+  // Then parse the single-model flags, which all the instances share.
+  template_model_ = create_model_();
+  if (TfLiteStatus status = template_model_->ParseFlags(&argc, argv);
+      status != kTfLiteOk) {
+    TFLITE_LOG(ERROR) << "Error while parsing the flags for single-model runs: "
+                      << status;
+    return status;
+  }
+
+  // Now, the remaining are unrecognized flags and we simply print them out.
+  for (int i = 1; i < argc; ++i) {
+    TFLITE_LOG(WARN) << "WARNING: unrecognized commandline flag: " << argv[i];
+  }
+
+  return Run();
+}
+
+}  // namespace benchmark
+}  // namespace tflite
@@ -0,0 +1,135 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_BENCHMARK_CONCURRENT_MODELS_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_BENCHMARK_CONCURRENT_MODELS_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_model.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_params.h"
+
+namespace tflite {
+namespace benchmark {
+
+// Records the latency of each regular run of a benchmark, and when the first
+// one started and the last one ended.
+class LatencyRecorder : public BenchmarkListener {
+ public:
+  void OnBenchmarkStart(const BenchmarkParams& params) override;
+  void OnSingleRunStart(RunType run_type) override;
+  void OnSingleRunEnd() override;
+
+  // Returns the `percentile`th (in [0, 100]) latency in microseconds, using
+  // the nearest-rank method, or -1 if nothing was recorded.
+  int64_t Percentile(double percentile) const;
+
+  bool started() const { return started_; }
+  const std::vector<int64_t>& latencies_us() const { return latencies_us_; }
+  int64_t first_start_us() const { return first_start_us_; }
+  int64_t last_end_us() const { return last_end_us_; }
+
+  // Called from OnBenchmarkStart, i.e. after the model was initialized.
+  std::function<void()> on_benchmark_start;
+
+ private:
+  bool started_ = false;
+  bool regular_run_ = false;
+  int64_t run_start_us_ = 0;
+  int64_t first_start_us_ = -1;
+  int64_t last_end_us_ = -1;
+  std::vector<int64_t> latencies_us_;
+};
+
+// Benchmarks several models running at the same time, each in its own
+// interpreter and thread, to measure how they interfere when they compete for
+// cores, caches and accelerators.
+//
+// All the instances share the single-model flags, and each of them can use a
+// different graph, delegate and run frequency (i.e. arrival rate). Instances
+// start their warmup together once all of them are initialized. The summary
+// reports the latency percentiles of each instance, the aggregate throughput
+// and, unless disabled, the slowdown compared to running the instance alone.
+class BenchmarkConcurrentModels {
+ public:
+  using ModelFactory = std::function<std::unique_ptr<BenchmarkModel>()>;
+
+  // `create_model` creates the model of each run. The single-model flags are
+  // parsed with a model created by it too.
+  explicit BenchmarkConcurrentModels(ModelFactory create_model);
+
+  virtual ~BenchmarkConcurrentModels() = default;
+
+  TfLiteStatus Run();
+  TfLiteStatus Run(int argc, char** argv);
+
+ protected:
+  static BenchmarkParams DefaultParams();
+
+  // Unparsable flags will remain in 'argv' in the original order and 'argc'
+  // will be updated accordingly.
+  TfLiteStatus ParseFlags(int* argc, char** argv);
+  virtual std::vector<Flag> GetFlags();
+
+  // Fills `instance_params_` from the flags.
+  TfLiteStatus CreateInstanceParams();
+
+  // Runs the models with `params` at the same time, and stores what they
+  // recorded in `recorders`. Fails if any of the runs fails.
+  TfLiteStatus RunConcurrently(
+      const std::vector<const BenchmarkParams*>& params,
+      std::vector<std::unique_ptr<LatencyRecorder>>* recorders);
+
+  void OutputStats(
+      const std::vector<std::unique_ptr<LatencyRecorder>>& concurrent,
+      const std::vector<std::unique_ptr<LatencyRecorder>>& isolated) const;
+
+  // Waits for all the instances of a run to be initialized.
+  class StartGate {
+   public:
+    explicit StartGate(int num_instances) : pending_(num_instances) {}
+
+    // Blocks until all the instances arrived or left.
+    void Arrive();
+    // Called for an instance that will never arrive, e.g. if it failed to
+    // initialize.
+    void Leave();
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable all_arrived_;
+    int pending_;
+  };
+
+  BenchmarkParams params_;
+  ModelFactory create_model_;
+  // The single-model parameters, shared by all the instances.
+  std::unique_ptr<BenchmarkModel> template_model_;
+  std::vector<BenchmarkParams> instance_params_;
+  // The delegate of each instance, for reporting.
+  std::vector<std::string> instance_delegates_;
+};
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_BENCHMARK_CONCURRENT_MODELS_H_
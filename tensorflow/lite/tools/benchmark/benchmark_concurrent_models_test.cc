@@ -0,0 +1,103 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/benchmark_concurrent_models.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_model.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_params.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+BenchmarkParams TestParams() {
+  BenchmarkParams params = BenchmarkModel::DefaultParams();
+  params.AddParam("fail_init", BenchmarkParam::Create<bool>(false));
+  params.Set<int32_t>("num_runs", 5);
+  params.Set<float>("min_secs", 0.0f);
+  params.Set<int32_t>("warmup_runs", 0);
+  params.Set<float>("warmup_min_secs", 0.0f);
+  return params;
+}
+
+// A model whose runs sleep for 10ms.
+class SleepingModel : public BenchmarkModel {
+ public:
+  SleepingModel() : BenchmarkModel(TestParams()) {}
+
+  TfLiteStatus Init() override {
+    return params_.Get<bool>("fail_init") ? kTfLiteError : kTfLiteOk;
+  }
+  uint64_t ComputeInputBytes() override { return 0; }
+  TfLiteStatus RunImpl() override {
+    util::SleepForSeconds(0.01);
+    return kTfLiteOk;
+  }
+};
+
+class TestBenchmarkConcurrentModels : public BenchmarkConcurrentModels {
+ public:
+  TestBenchmarkConcurrentModels()
+      : BenchmarkConcurrentModels(
+            [] { return std::make_unique<SleepingModel>(); }) {}
+
+  using BenchmarkConcurrentModels::RunConcurrently;
+};
+
+TEST(BenchmarkConcurrentModelsTest, RunsInstancesConcurrently) {
+  const BenchmarkParams params = TestParams();
+  TestBenchmarkConcurrentModels benchmark;
+  std::vector<std::unique_ptr<LatencyRecorder>> recorders;
+  ASSERT_EQ(benchmark.RunConcurrently({&params, &params, &params}, &recorders),
+            kTfLiteOk);
+
+  ASSERT_EQ(recorders.size(), size_t{3});
+  for (const auto& recorder : recorders) {
+    EXPECT_EQ(recorder->latencies_us().size(), size_t{5});
+    EXPECT_GE(recorder->Percentile(0), 10000);
+    EXPECT_LE(recorder->Percentile(50), recorder->Percentile(100));
+    // The instances ran at the same time.
+    for (const auto& other : recorders) {
+      EXPECT_LT(recorder->first_start_us(), other->last_end_us());
+    }
+  }
+}
+
+TEST(BenchmarkConcurrentModelsTest, FailedInstanceDoesntBlockOthers) {
+  const BenchmarkParams params = TestParams();
+  BenchmarkParams failing_params = TestParams();
+  failing_params.Set<bool>("fail_init", true);
+  TestBenchmarkConcurrentModels benchmark;
+  std::vector<std::unique_ptr<LatencyRecorder>> recorders;
+  EXPECT_EQ(benchmark.RunConcurrently({&params, &failing_params}, &recorders),
+            kTfLiteError);
+  EXPECT_EQ(recorders[0]->latencies_us().size(), size_t{5});
+}
+
+TEST(LatencyRecorderTest, PercentileOfNoRunIsInvalid) {
+  LatencyRecorder recorder;
+  EXPECT_EQ(recorder.Percentile(50), -1);
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace tflite
@@ -0,0 +1,90 @@
+# Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Benchmarks for staging `MultiDeviceIterator` elements in pinned memory."""
+import os
+import time
+
+import numpy as np
+
+from tensorflow.python.data.benchmarks import benchmark_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.ops import multi_device_iterator_ops
+from tensorflow.python.eager import context
+from tensorflow.python.framework import config
+
+
+class MultiDeviceIteratorBenchmark(benchmark_base.DatasetBenchmarkBase):
+  """Benchmarks for the `pinned_staging_ring` experiment."""
+
+  def _devices(self):
+    """Returns the GPUs, or two logical CPUs on hosts without a GPU."""
+    gpus = config.list_logical_devices("GPU")
+    if gpus:
+      return [d.name for d in gpus]
+    cpus = config.list_physical_devices("CPU")
+    if len(config.list_logical_devices("CPU")) < 3:
+      config.set_logical_device_configuration(
+          cpus[0], [context.LogicalDeviceConfiguration()] * 3)
+    return [d.name for d in config.list_logical_devices("CPU")[1:3]]
+
+  def _run(self, experiment, element_bytes, step_time_s, num_steps):
+    """Returns the mean time per step that `get_next()` stalls the step."""
+    old_opt_in = os.environ.get("TF_DATA_EXPERIMENT_OPT_IN")
+    os.environ["TF_DATA_EXPERIMENT_OPT_IN"] = experiment
+    try:
+      devices = self._devices()
+      dataset = dataset_ops.Dataset.from_tensors(
+          np.ones([element_bytes // 4], dtype=np.float32)).repeat()
+      # Produce a fresh buffer for every element.
+      dataset = dataset.map(lambda x: x + 1)
+      iterator = multi_device_iterator_ops.OwnedMultiDeviceIterator(
+          dataset, devices, max_buffer_size=2)
+      stalls = []
+      for step in range(num_steps):
+        start = time.time()
+        for device in devices:
+          iterator.get_next(device)
+        # Skip the first steps, which include filling the buffers.
+        if step >= 2:
+          stalls.append(time.time() - start)
+        # Simulates the compute of one step, during which the background
+        # thread refills the per-device buffers.
+        time.sleep(step_time_s)
+      return np.mean(stalls)
+    finally:
+      if old_opt_in is None:
+        del os.environ["TF_DATA_EXPERIMENT_OPT_IN"]
+      else:
+        os.environ["TF_DATA_EXPERIMENT_OPT_IN"] = old_opt_in
+
+  def benchmark_input_stall_per_step(self):
+    for element_bytes in [1 << 16, 1 << 20, 16 << 20]:
+      for experiment in ["", "pinned_staging_ring"]:
+        stall = self._run(
+            experiment, element_bytes, step_time_s=0.01, num_steps=50)
+        name = "stall_%d_bytes%s" % (element_bytes,
+                                     "_pinned" if experiment else "")
+        self.report_benchmark(
+            wall_time=stall,
+            iters=50,
+            extras={
+                "model_name": "multi_device_iterator.benchmark.1",
+                "parameters": "%d.%s" % (element_bytes, bool(experiment)),
+            },
+            name=name)
+
+
+if __name__ == "__main__":
+  benchmark_base.test.main()
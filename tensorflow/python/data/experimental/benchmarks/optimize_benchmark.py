@@ -13,6 +13,7 @@
 # limitations under the License.
 # ==============================================================================
 """Benchmarks for static optimizations."""
+import os
 
 from tensorflow.python.data.benchmarks import benchmark_base
 from tensorflow.python.data.ops import dataset_ops
@@ -160,6 +161,43 @@ class OptimizationBenchmark(benchmark_base.DatasetBenchmarkBase):
         name="filter_parallelization_{}_chain_length_{}".format(opt_mark,
                                                                 chain_length))
 
+  # This benchmark compares the throughput of `map(...).batch(...)` with and
+  # without the `map_vectorization` experiment.
+
+  def benchmark_map_vectorization(self):
+    for batch_size in [1, 16, 256]:
+      self._benchmark_map_vectorization(
+          batch_size=batch_size, optimize_dataset=False)
+      self._benchmark_map_vectorization(
+          batch_size=batch_size, optimize_dataset=True)
+
+  def _benchmark_map_vectorization(self, batch_size, optimize_dataset):
+    old_opt_in = os.environ.get("TF_DATA_EXPERIMENT_OPT_IN")
+    os.environ["TF_DATA_EXPERIMENT_OPT_IN"] = (
+        "map_vectorization" if optimize_dataset else "")
+    try:
+      dataset = dataset_ops.Dataset.from_tensors([1.0] * 64).repeat()
+      dataset = dataset.map(
+          lambda x: math_ops.sigmoid(x * 2.0 + 1.0) * x).batch(batch_size)
+
+      opt_mark = "opt" if optimize_dataset else "noopt"
+      self.run_and_report_benchmark(
+          dataset=dataset,
+          num_elements=1000,
+          iters=10,
+          warmup=True,
+          extras={
+              "model_name": "optimize.benchmark.5",
+              "parameters": "%d.%s" % (batch_size, optimize_dataset),
+          },
+          name="map_vectorization_{}_batch_size_{}".format(
+              opt_mark, batch_size))
+    finally:
+      if old_opt_in is None:
+        del os.environ["TF_DATA_EXPERIMENT_OPT_IN"]
+      else:
+        os.environ["TF_DATA_EXPERIMENT_OPT_IN"] = old_opt_in
+
 
 if __name__ == "__main__":
   benchmark_base.test.main()
@@ -0,0 +1,86 @@
+# Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the `MapVectorization` optimization."""
+import functools
+import os
+from unittest import mock
+
+from absl.testing import parameterized
+
+from tensorflow.python.data.experimental.ops import testing
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.ops import options as options_lib
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import dtypes
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+
+
+def _test_combinations():
+  cases = [
+      ("Increment", lambda x: x + 1, ["Batch", "Map"]),
+      ("Polynomial", lambda x: x * x - 3 * x + 2, ["Batch", "Map"]),
+      ("CastAndSquare",
+       lambda x: math_ops.square(math_ops.cast(x, dtypes.float32)),
+       ["Batch", "Map"]),
+      # `reverse` is not vectorized, so it runs per element in `MapDefun`.
+      ("Reverse", lambda x: array_ops.reverse(array_ops.stack([x, x + 1]), [0]),
+       ["Batch", "Map"]),
+      # Broadcasting the element into a vector is not vectorized.
+      ("Broadcast", lambda x: x + [1, 2, 3], ["Map", "Batch"]),
+  ]
+
+  def reduce_fn(x, y):
+    name, function, next_nodes = y
+    return x + combinations.combine(
+        function=combinations.NamedObject(name, function),
+        next_nodes=next_nodes)
+
+  return functools.reduce(reduce_fn, cases, [])
+
+
+class MapVectorizationTest(test_base.DatasetTestBase, parameterized.TestCase):
+
+  def _make_dataset(self, function, next_nodes=None):
+    dataset = dataset_ops.Dataset.range(20)
+    if next_nodes:
+      dataset = dataset.apply(testing.assert_next(next_nodes))
+    dataset = dataset.map(function).batch(5)
+    options = options_lib.Options()
+    options.experimental_optimization.apply_default_optimizations = False
+    return dataset.with_options(options)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         _test_combinations()))
+  def testMapVectorization(self, function, next_nodes):
+    expected_output = self.getDatasetOutput(self._make_dataset(function))
+    with mock.patch.dict(
+        os.environ, {"TF_DATA_EXPERIMENT_OPT_IN": "map_vectorization"}):
+      dataset = self._make_dataset(function, next_nodes)
+      self.assertDatasetProduces(dataset, expected_output=expected_output)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testNoVectorizationWithoutOptIn(self):
+    dataset = self._make_dataset(lambda x: x + 1, ["Batch"])
+    with mock.patch.dict(os.environ, {"TF_DATA_EXPERIMENT_OPT_IN": ""}):
+      with self.assertRaisesOpError("Asserted transformation matching"):
+        self.getDatasetOutput(dataset)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -78,8 +78,12 @@ def distributed_save(
     data_service_address: tf.data service dispatcher address.
     compression: (Optional.) Whether and how to compress the `dataset` snapshot.
       If `"AUTO"`, the tf.data runtime decides which algorithm to use. If
-      `"GZIP"` or `"SNAPPY"`, that specific algorithm is used.  If `None`, the
-      `dataset` snapshot is not compressed.
+      `"GZIP"` or `"SNAPPY"`, that specific algorithm is used. If
+      `"COLUMNAR"`, every component of the elements is stored and compressed
+      separately, so that readers only decode the components they need. If
+      `"ADAPTIVE"`, every chunk file picks among no compression, Snappy, and
+      zstd levels from the compression ratio and the CPU headroom of the
+      writers. If `None`, the `dataset` snapshot is not compressed.
 
   Returns:
     An operation which when executed performs the distributed save.
@@ -166,6 +166,23 @@ class UniqueTest(test.TestCase):
     self.assertAllEqual(tf_y, true_y)
     self.assertAllEqual(tf_idx, true_idx)
 
+  def testLargeIntegers(self):
+    # Large enough for the partitioned implementation of integer keys.
+    for dtype in [np.int32, np.int64]:
+      for high in [10, 100000]:
+        with self.subTest(dtype=dtype, high=high):
+          x = np.random.randint(-high, high=high, size=200000).astype(dtype)
+          true_y, first, true_idx = np.unique(
+              x, return_index=True, return_inverse=True)
+          # Orders the unique elements by appearance, as the op does.
+          order = np.argsort(first)
+          rank = np.empty_like(order)
+          rank[order] = np.arange(len(order))
+          y, idx = array_ops.unique(x)
+          tf_y, tf_idx = self.evaluate([y, idx])
+          self.assertAllEqual(tf_y, true_y[order])
+          self.assertAllEqual(tf_idx, rank[true_idx])
+
 
 class UniqueWithCountsTest(test.TestCase):
 
@@ -313,6 +330,22 @@ class UniqueWithCountsTest(test.TestCase):
     self.assertAllEqual(tf_idx, true_idx)
     self.assertAllEqual(tf_count, true_count)
 
+  def testLargeIntegers(self):
+    # Large enough for the partitioned implementation of integer keys.
+    for dtype in [np.int32, np.int64]:
+      with self.subTest(dtype=dtype):
+        x = np.random.randint(1000, size=200000).astype(dtype)
+        true_y, first, true_idx, true_count = np.unique(
+            x, return_index=True, return_inverse=True, return_counts=True)
+        order = np.argsort(first)
+        rank = np.empty_like(order)
+        rank[order] = np.arange(len(order))
+        y, idx, count = array_ops.unique_with_counts(x)
+        tf_y, tf_idx, tf_count = self.evaluate([y, idx, count])
+        self.assertAllEqual(tf_y, true_y[order])
+        self.assertAllEqual(tf_idx, rank[true_idx])
+        self.assertAllEqual(tf_count, true_count[order])
+
 
 if __name__ == '__main__':
   test.main()
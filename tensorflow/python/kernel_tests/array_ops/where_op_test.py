@@ -19,6 +19,7 @@ import sys
 
 import numpy as np
 
+from tensorflow.core.protobuf import config_pb2
 from tensorflow.python.client import session
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
@@ -263,6 +264,30 @@ class WhereOpTest(test.TestCase):
       tf_val = array_ops.where(c_vec, x * x, -x).eval()
     self.assertAllEqual(tf_val, np_val)
 
+  def testShardedMatchesSerial(self):
+    # The CPU kernel splits inputs with at least 64K elements per thread into
+    # shards, which must produce the indices in the same order as one thread.
+    np.random.seed(7)
+    inputs = [
+        np.random.rand(1000003) < 0.001,  # Large and sparse.
+        np.ones([1001, 517], dtype=np.bool_),
+        np.zeros([64, 128, 65], dtype=np.bool_),
+        (np.random.rand(67, 129, 61) < 0.5).astype(np.int32),
+        np.random.rand(5, 7, 11, 13, 101) < 0.3,
+        np.where(np.random.rand(600, 1000) < 0.01, 1.5, 0.).astype(np.float32),
+    ]
+    for x in inputs:
+      truth = np.vstack(np.where(x)).T.astype(np.int64)
+      with ops.Graph().as_default():
+        x_ph = array_ops.placeholder(dtypes.as_dtype(x.dtype), shape=x.shape)
+        ans = array_ops.where(x_ph)
+        for num_threads in [1, 4]:
+          with session.Session(
+              config=config_pb2.ConfigProto(
+                  intra_op_parallelism_threads=num_threads)) as sess:
+            tf_ans = sess.run(ans, feed_dict={x_ph: x})
+          self.assertAllEqual(tf_ans, truth)
+
 
 class WhereBenchmark(test.Benchmark):
 
@@ -694,6 +694,35 @@ class ListOpsTest(test_util.TensorFlowTestCase, parameterized.TestCase):
     with context.device("gpu:0"):
       self.testGetSetReserved()
 
+  def testSetAllReservedThenStack(self):
+    # Elements of 16 floats fill whole aligned slots of a contiguous buffer.
+    l = list_ops.tensor_list_reserve(
+        element_dtype=dtypes.float32, element_shape=[16], num_elements=3)
+    for i in [2, 0, 1]:
+      l = list_ops.tensor_list_set_item(l, i, array_ops.fill([16], float(i)))
+    t = list_ops.tensor_list_stack(l, element_dtype=dtypes.float32)
+    self.assertAllEqual(t, np.repeat([[0.0], [1.0], [2.0]], 16, axis=1))
+    # Setting an element again does not change what was stacked before.
+    l2 = list_ops.tensor_list_set_item(l, 1, array_ops.fill([16], 5.0))
+    t2 = list_ops.tensor_list_stack(l2, element_dtype=dtypes.float32)
+    self.assertAllEqual(t, np.repeat([[0.0], [1.0], [2.0]], 16, axis=1))
+    self.assertAllEqual(t2, np.repeat([[0.0], [5.0], [2.0]], 16, axis=1))
+    e1 = list_ops.tensor_list_get_item(l, 1, element_dtype=dtypes.float32)
+    self.assertAllEqual(e1, np.ones([16]))
+
+  def testSetReservedInWhileLoopThenStack(self):
+
+    def body(i, l):
+      return i + 1, list_ops.tensor_list_set_item(
+          l, i, array_ops.fill([4, 16], math_ops.cast(i, dtypes.float32)))
+
+    l = list_ops.tensor_list_reserve(
+        element_dtype=dtypes.float32, element_shape=[4, 16], num_elements=10)
+    _, l = while_loop.while_loop(lambda i, l: i < 10, body, (0, l))
+    t = list_ops.tensor_list_stack(l, element_dtype=dtypes.float32)
+    self.assertAllEqual(
+        t, np.broadcast_to(np.arange(10.0).reshape([10, 1, 1]), [10, 4, 16]))
+
   def testSetGetGrad(self):
     with backprop.GradientTape() as tape:
       t = constant_op.constant(5.)
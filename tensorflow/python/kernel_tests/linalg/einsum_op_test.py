@@ -110,6 +110,22 @@ class EinsumOpTest(test.TestCase):
     self._check('ab,ab->', (3, 4), (3, 4))
     self._check('abce,badf->abcd', (1, 2, 3, 4), (2, 1, 4, 3))
 
+  def testTransposedOutput(self):
+    # The free dimensions of the second input come first in the output.
+    self._check('ij,jk->ki', (2, 3), (3, 4))
+    self._check('ij,kj->ki', (2, 3), (4, 3))
+    self._check('bij,bjk->bki', (5, 2, 3), (5, 3, 4))
+    self._check('...ij,...jk->...ki', (2, 3), (5, 3, 4))
+    self._check('ij,jkl->kli', (2, 3), (3, 4, 5))
+    self._check('ij,jk->kii', (2, 3), (3, 4))
+
+  def testChangingShapes(self):
+    # The same equation with different shapes must not reuse a stale plan.
+    self._check('...ij,...jk->...ik', (2, 3), (3, 4))
+    self._check('...ij,...jk->...ik', (5, 2, 3), (3, 4))
+    self._check('...ij,...jk->...ik', (5, 4, 2), (2, 1))
+    self._check('...ij,...jk->...ik', (2, 3), (3, 4))
+
   def testRepeatedIndices(self):
     # Repeated indices.
     self._check('ijj,k->ik', (2, 3, 3), (4,))
@@ -285,6 +285,26 @@ class SoftmaxTest(test.TestCase):
           tf_softmax = self.evaluate(y)
         self.assertAllClose(tf_softmax, np_softmax)
 
+  def testManyClasses(self):
+    # The CPU kernel reduces each row in blocks of 512 classes. The rising
+    # and falling trends make the row maximum change between blocks.
+    np.random.seed(42)
+    for cols in [513, 1024, 2049]:
+      trend = np.linspace(-8., 8., cols)
+      data = np.random.rand(7, cols) * 4. + np.stack(
+          [trend, -trend, np.zeros(cols)] * 2 + [trend])
+      for dtype in [np.float32, np.float64, np.float16]:
+        logging.info("Testing softmax %s dtype with %d classes",
+                     np.dtype(dtype).name, cols)
+        self._testSoftmax(data.astype(dtype), use_gpu=False)
+        self._testSoftmax(data.astype(dtype), log=True, use_gpu=False)
+      # The reference result is computed in float32 from the bfloat16 logits.
+      bf16_data = data.astype(dtypes.bfloat16.as_numpy_dtype).astype(
+          np.float32)
+      self._testSoftmax(bf16_data, dtype=dtypes.bfloat16, use_gpu=False)
+      self._testSoftmax(
+          bf16_data, dtype=dtypes.bfloat16, log=True, use_gpu=False)
+
 
 if __name__ == "__main__":
   test.main()
@@ -211,6 +211,79 @@ class SparseTensorDenseMatMulTest(test.TestCase):
         sparse_ops.sparse_tensor_dense_matmul(
             sparse_t, dense_t, adjoint_a=True))
 
+  def _testUnorderedManyRows(self, np_dtype, adjoint_a, adjoint_b):
+    # Enough output rows and nonzeros for the CPU kernel to shard the output
+    # rows, with shuffled and duplicated indices.
+    m, k, n = 3001, 257, 67
+    nnz = 40000
+    a_rows = np.random.randint(0, m, size=nnz)
+    a_cols = np.random.randint(0, k, size=nnz)
+    a_values = _maybe_complex(np.random.randn(nnz).astype(np_dtype))
+    x = np.zeros([m, k], dtype=np_dtype)
+    np.add.at(x, (a_rows, a_cols), a_values)
+    y = _maybe_complex(np.random.randn(k, n).astype(np_dtype))
+    np_ans = x.dot(y)
+
+    indices = np.stack([a_rows, a_cols], axis=1).astype(np.int64)
+    shape = [m, k]
+    if adjoint_a:
+      indices = indices[:, ::-1]
+      shape = [k, m]
+      a_values = np.conj(a_values)
+    if adjoint_b:
+      y = y.T.conj()
+    with ops.Graph().as_default():
+      sp_x = sparse_tensor.SparseTensor(indices, a_values, shape)
+      ans = sparse_ops.sparse_tensor_dense_matmul(
+          sp_x, y, adjoint_a=adjoint_a, adjoint_b=adjoint_b)
+      for num_threads in [1, 4]:
+        with session.Session(
+            config=config_pb2.ConfigProto(
+                intra_op_parallelism_threads=num_threads)) as sess:
+          tf_ans = sess.run(ans)
+        if np_dtype in (np.float32, np.complex64):
+          self.assertAllClose(np_ans, tf_ans, rtol=1e-4, atol=1e-4)
+        else:
+          self.assertAllClose(np_ans, tf_ans, rtol=1e-6, atol=1e-6)
+
+  def testUnorderedManyRows(self):
+    np.random.seed(127)  # Repeatable results
+    for np_dtype in [np.float32, np.float64, np.complex64]:
+      for adjoint_a in [False, True]:
+        for adjoint_b in [False, True]:
+          self._testUnorderedManyRows(np_dtype, adjoint_a, adjoint_b)
+
+  @test_util.run_in_graph_and_eager_modes(use_gpu=False)
+  def testInvalidIndicesAmongManyRows(self):
+    # The indices are validated before any output row is computed, so an
+    # invalid index after many valid ones is reported, whatever the order.
+    np.random.seed(127)  # Repeatable results
+    nnz = 20000
+    indices = np.stack(
+        [np.random.randint(0, 3000, size=nnz),
+         np.random.randint(0, 100, size=nnz)], axis=1).astype(np.int64)
+    values = np.random.randn(nnz).astype(np.float32)
+    dense_t = np.random.randn(100, 64).astype(np.float32)
+
+    bad_k = indices.copy()
+    bad_k[nnz - 1] = [5, 100]
+    with self.assertRaisesOpError(
+        "k .100. from index.19999,1. out of bounds .>=100."):
+      self.evaluate(
+          sparse_ops.sparse_tensor_dense_matmul(
+              sparse_tensor.SparseTensor(bad_k, values, [3000, 100]),
+              dense_t))
+
+    bad_m = indices[:, ::-1].copy()
+    bad_m[nnz - 1] = [7, -1]
+    with self.assertRaisesOpError(
+        "m .-1. from index.19999,1. out of bounds .>=3000."):
+      self.evaluate(
+          sparse_ops.sparse_tensor_dense_matmul(
+              sparse_tensor.SparseTensor(bad_m, values, [100, 3000]),
+              dense_t,
+              adjoint_a=True))
+
   def _testLarge(self, np_dtype):
     r1 = np.random.randint(6000, 20000)
     r2 = np.random.randint(1, 10)
@@ -0,0 +1,114 @@
+# Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Compares two benchmark results to spot performance regressions.
+
+The results are TestResults protos (test_log.proto) in JSON format, as written
+by run_and_gather_logs with --test_log_output_dir, e.g. for two commits:
+
+  bazel run -c opt //tensorflow/tools/test:kernel_benchmark_suite -- \
+      --test_log_output_dir=/tmp/results
+  bazel run //tensorflow/tools/test:compare_benchmarks -- \
+      --baseline=/tmp/results/<old>.json --candidate=/tmp/results/<new>.json
+
+Benchmarks are matched by name and compared by wall time per iteration.
+"""
+
+import collections
+import sys
+
+from absl import app
+from absl import flags
+
+from google.protobuf import json_format
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+
+FLAGS = flags.FLAGS
+
+flags.DEFINE_string("baseline", "", "TestResults JSON file to compare to.")
+flags.DEFINE_string("candidate", "", "TestResults JSON file to compare.")
+flags.DEFINE_float(
+    "threshold", 0.1,
+    "Relative increase of the wall time above which a benchmark regressed.")
+flags.DEFINE_boolean("fail_on_regression", True,
+                     "Whether to exit with an error if a benchmark regressed.")
+
+Comparison = collections.namedtuple(
+    "Comparison", ["name", "baseline_time", "candidate_time", "ratio"])
+
+
+def load_entries(path):
+  """Returns the BenchmarkEntry of each benchmark of a TestResults file."""
+  results = test_log_pb2.TestResults()
+  json_format.Parse(gfile.GFile(path, "r").read(), results)
+  return {entry.name: entry for entry in results.entries.entry}
+
+
+def compare(baseline, candidate):
+  """Compares the benchmarks that have results in both `baseline` and
+  `candidate`, which map names to BenchmarkEntry protos.
+
+  Returns:
+    A list of Comparisons by decreasing ratio of the candidate wall time to
+    the baseline wall time.
+  """
+  comparisons = []
+  for name in baseline.keys() & candidate.keys():
+    baseline_time = baseline[name].wall_time
+    candidate_time = candidate[name].wall_time
+    if baseline_time <= 0:
+      continue
+    comparisons.append(
+        Comparison(name, baseline_time, candidate_time,
+                   candidate_time / baseline_time))
+  return sorted(comparisons, key=lambda c: (-c.ratio, c.name))
+
+
+def regressions(comparisons, threshold):
+  return [c for c in comparisons if c.ratio > 1 + threshold]
+
+
+def format_report(comparisons, baseline, candidate, threshold):
+  """Returns a human readable report of `comparisons`."""
+  lines = ["%-60s %14s %14s %8s" %
+           ("Benchmark", "Baseline (us)", "Candidate (us)", "Change")]
+  for c in comparisons:
+    marker = " REGRESSED" if c.ratio > 1 + threshold else ""
+    lines.append("%-60s %14.2f %14.2f %+7.1f%%%s" %
+                 (c.name, c.baseline_time * 1e6, c.candidate_time * 1e6,
+                  (c.ratio - 1) * 100, marker))
+  for name in sorted(baseline.keys() - candidate.keys()):
+    lines.append("%-60s only in the baseline" % name)
+  for name in sorted(candidate.keys() - baseline.keys()):
+    lines.append("%-60s only in the candidate" % name)
+  lines.append("%d of %d benchmarks regressed by more than %.0f%%." %
+               (len(regressions(comparisons, threshold)), len(comparisons),
+                threshold * 100))
+  return "\n".join(lines)
+
+
+def main(unused_args):
+  if not FLAGS.baseline or not FLAGS.candidate:
+    raise app.UsageError("--baseline and --candidate are required.")
+  baseline = load_entries(FLAGS.baseline)
+  candidate = load_entries(FLAGS.candidate)
+  comparisons = compare(baseline, candidate)
+  print(format_report(comparisons, baseline, candidate, FLAGS.threshold))
+  if FLAGS.fail_on_regression and regressions(comparisons, FLAGS.threshold):
+    sys.exit(1)
+
+
+if __name__ == "__main__":
+  app.run(main)
@@ -0,0 +1,73 @@
+# Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for compare_benchmarks."""
+
+import os
+
+from google.protobuf import json_format
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import googletest
+from tensorflow.tools.test import compare_benchmarks
+
+
+def _entry(name, wall_time):
+  return test_log_pb2.BenchmarkEntry(name=name, iters=10, wall_time=wall_time)
+
+
+class CompareBenchmarksTest(googletest.TestCase):
+
+  def testLoadEntries(self):
+    results = test_log_pb2.TestResults()
+    results.entries.entry.extend([_entry("BM_A", 1.0), _entry("BM_B", 2.0)])
+    path = os.path.join(googletest.GetTempDir(), "results.json")
+    with open(path, "w") as f:
+      f.write(json_format.MessageToJson(results))
+
+    entries = compare_benchmarks.load_entries(path)
+    self.assertEqual(sorted(entries), ["BM_A", "BM_B"])
+    self.assertEqual(entries["BM_B"].wall_time, 2.0)
+
+  def testCompare(self):
+    baseline = {
+        "BM_Faster": _entry("BM_Faster", 2.0),
+        "BM_Slower": _entry("BM_Slower", 1.0),
+        "BM_Same": _entry("BM_Same", 1.0),
+        "BM_Removed": _entry("BM_Removed", 1.0),
+    }
+    candidate = {
+        "BM_Faster": _entry("BM_Faster", 1.0),
+        "BM_Slower": _entry("BM_Slower", 1.5),
+        "BM_Same": _entry("BM_Same", 1.05),
+        "BM_Added": _entry("BM_Added", 1.0),
+    }
+
+    comparisons = compare_benchmarks.compare(baseline, candidate)
+    self.assertEqual([c.name for c in comparisons],
+                     ["BM_Slower", "BM_Same", "BM_Faster"])
+    self.assertAlmostEqual(comparisons[0].ratio, 1.5)
+    self.assertEqual(
+        [c.name for c in compare_benchmarks.regressions(comparisons, 0.1)],
+        ["BM_Slower"])
+
+    report = compare_benchmarks.format_report(comparisons, baseline, candidate,
+                                              0.1)
+    self.assertIn("+50.0% REGRESSED", report)
+    self.assertIn("BM_Removed", report)
+    self.assertIn("BM_Added", report)
+    self.assertIn("1 of 3 benchmarks regressed", report)
+
+
+if __name__ == "__main__":
+  googletest.main()
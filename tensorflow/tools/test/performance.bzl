@@ -39,7 +39,7 @@ def tf_cc_logged_benchmark(
         args = [
             "--name=//%s:%s" % (native.package_name(), name),
             "--test_name=" + target,
-            "--test_args=--benchmarks=%s" % benchmarks,
+            "--test_args=--benchmark_filter=%s" % benchmarks,
             "--benchmark_type=%s" % benchmark_type,
         ],
         data = [
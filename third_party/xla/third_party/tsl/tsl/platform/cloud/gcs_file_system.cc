@@ -46,6 +46,7 @@ limitations under the License.
 #include "tsl/platform/cloud/google_auth_provider.h"
 #include "tsl/platform/cloud/ram_file_block_cache.h"
 #include "tsl/platform/cloud/time_util.h"
+#include "tsl/platform/blocking_counter.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/mutex.h"
@@ -65,6 +66,33 @@ limitations under the License.
 #endif
 
 namespace tsl {
+
+// Hands out the bytes by which the read buffers of files may grow beyond the
+// block size, so that readahead cannot exhaust memory when many files are
+// read at once.
+class GcsFileSystem::ReadaheadBudget {
+ public:
+  explicit ReadaheadBudget(size_t limit) : limit_(limit) {}
+
+  // Reserves up to `bytes` bytes and returns how many were reserved.
+  size_t Reserve(size_t bytes) {
+    mutex_lock l(mu_);
+    const size_t reserved = std::min(bytes, limit_ - used_);
+    used_ += reserved;
+    return reserved;
+  }
+
+  void Release(size_t bytes) {
+    mutex_lock l(mu_);
+    used_ -= bytes;
+  }
+
+ private:
+  const size_t limit_;
+  mutex mu_;
+  size_t used_ TF_GUARDED_BY(mu_) = 0;
+};
+
 namespace {
 constexpr char kGcsUriBase[] = "https://www.googleapis.com/storage/v1/";
 constexpr char kGcsUploadUriBase[] =
@@ -122,6 +150,18 @@ constexpr char kReadRequestTimeout[] = "GCS_READ_REQUEST_TIMEOUT_SECS";
 // The environment variable to configure the overall request timeout for
 // upload requests.
 constexpr char kWriteRequestTimeout[] = "GCS_WRITE_REQUEST_TIMEOUT_SECS";
+// The environment variable that enables splitting large reads into range
+// requests of this many MB, which are sent concurrently.
+constexpr char kReadParallelChunkSize[] = "GCS_READ_PARALLEL_CHUNK_SIZE_MB";
+// The environment variable that overrides the maximum number of concurrent
+// range requests of split reads.
+constexpr char kReadMaxParallelRequests[] = "GCS_READ_MAX_PARALLEL_REQUESTS";
+// The environment variable that lets the read buffers of sequentially read
+// files grow up to this many MB.
+constexpr char kReadMaxReadaheadSize[] = "GCS_READ_MAX_READAHEAD_SIZE_MB";
+// The environment variable that overrides the total number of MB by which the
+// read buffers of all files may grow.
+constexpr char kReadaheadMemoryLimit[] = "GCS_READAHEAD_MEMORY_LIMIT_MB";
 // The environment variable to configure an additional header to send with
 // all requests to GCS (format HEADERNAME:HEADERCONTENT)
 constexpr char kAdditionalRequestHeader[] = "GCS_ADDITIONAL_REQUEST_HEADER";
@@ -350,11 +390,32 @@ class BufferedGcsRandomAccessFile : public RandomAccessFile {
   // Initialize the reader. Provided read_fn should be thread safe.
   BufferedGcsRandomAccessFile(const string& filename, uint64 buffer_size,
                               ReadFn read_fn)
+      : BufferedGcsRandomAccessFile(filename, buffer_size, buffer_size,
+                                    nullptr, std::move(read_fn)) {}
+
+  // As above, but the buffer grows up to `max_buffer_size` bytes while the
+  // file is read sequentially, taking the bytes beyond `buffer_size` from
+  // `readahead_budget`.
+  BufferedGcsRandomAccessFile(
+      const string& filename, uint64 buffer_size, uint64 max_buffer_size,
+      std::shared_ptr<GcsFileSystem::ReadaheadBudget> readahead_budget,
+      ReadFn read_fn)
       : filename_(filename),
         read_fn_(std::move(read_fn)),
         buffer_size_(buffer_size),
+        max_buffer_size_(readahead_budget == nullptr
+                             ? buffer_size
+                             : std::max(buffer_size, max_buffer_size)),
+        readahead_budget_(std::move(readahead_budget)),
         buffer_start_(0),
-        buffer_end_is_past_eof_(false) {}
+        buffer_end_is_past_eof_(false),
+        fill_size_(buffer_size) {}
+
+  ~BufferedGcsRandomAccessFile() override {
+    if (reserved_bytes_ > 0) {
+      readahead_budget_->Release(reserved_bytes_);
+    }
+  }
 
   absl::Status Name(absl::string_view* result) const override {
     *result = filename_;
@@ -406,25 +467,55 @@ class BufferedGcsRandomAccessFile : public RandomAccessFile {
  private:
   absl::Status FillBuffer(uint64 start) const
       TF_EXCLUSIVE_LOCKS_REQUIRED(buffer_mutex_) {
+    if (max_buffer_size_ > buffer_size_) {
+      ResizeReadahead(start);
+    }
     buffer_start_ = start;
-    buffer_.resize(buffer_size_);
+    buffer_.resize(fill_size_);
     absl::string_view str_piece;
-    absl::Status status = read_fn_(filename_, buffer_start_, buffer_size_,
+    absl::Status status = read_fn_(filename_, buffer_start_, fill_size_,
                                    &str_piece, &(buffer_[0]));
     buffer_end_is_past_eof_ = absl::IsOutOfRange(status);
     buffer_.resize(str_piece.size());
     return status;
   }
 
+  // A refill that starts where the buffer ends continues a sequential scan, so
+  // it doubles the readahead as far as the budget allows. Any other refill
+  // shrinks it back to `buffer_size_`.
+  void ResizeReadahead(uint64 start) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(buffer_mutex_) {
+    const bool sequential =
+        !buffer_.empty() && start == buffer_start_ + buffer_.size();
+    const uint64 wanted =
+        sequential ? std::min(2 * fill_size_, max_buffer_size_) : buffer_size_;
+    const size_t previously_reserved = reserved_bytes_;
+    readahead_budget_->Release(reserved_bytes_);
+    reserved_bytes_ = readahead_budget_->Reserve(wanted - buffer_size_);
+    fill_size_ = buffer_size_ + reserved_bytes_;
+    if (reserved_bytes_ < previously_reserved) {
+      buffer_.resize(0);
+      buffer_.shrink_to_fit();
+    }
+  }
+
   // The filename of this file.
   const string filename_;
 
   // The implementation of the read operation (provided by the GCSFileSystem).
   const ReadFn read_fn_;
 
-  // Size of buffer that we read from GCS each time we send a request.
+  // Size of buffer that we read from GCS each time we send a request, unless
+  // the file is read sequentially.
   const uint64 buffer_size_;
 
+  // Size the buffer may grow to while the file is read sequentially.
+  const uint64 max_buffer_size_;
+
+  // Source of the bytes the buffer holds beyond `buffer_size_`. Null if the
+  // buffer does not grow.
+  const std::shared_ptr<GcsFileSystem::ReadaheadBudget> readahead_budget_;
+
   // Mutex for buffering operations that can be accessed from multiple threads.
   // The following members are mutable in order to provide a const Read.
   mutable mutex buffer_mutex_;
@@ -435,6 +526,12 @@ class BufferedGcsRandomAccessFile : public RandomAccessFile {
   mutable bool buffer_end_is_past_eof_ TF_GUARDED_BY(buffer_mutex_);
 
   mutable string buffer_ TF_GUARDED_BY(buffer_mutex_);
+
+  // Number of bytes the next refill reads.
+  mutable uint64 fill_size_ TF_GUARDED_BY(buffer_mutex_);
+
+  // Bytes of `readahead_budget_` held by this file.
+  mutable size_t reserved_bytes_ TF_GUARDED_BY(buffer_mutex_) = 0;
 };
 
 // Function object declaration with params needed to create upload sessions.
@@ -967,6 +1064,27 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
     throttle_.SetConfig(config);
   }
 
+  ReadConfig read_config;
+  if (GetEnvVar(kReadParallelChunkSize, strings::safe_strtou64, &value)) {
+    read_config.chunk_size = value * 1024 * 1024;
+  }
+  if (GetEnvVar(kReadMaxParallelRequests, strings::safe_strtou64, &value) &&
+      value > 0) {
+    read_config.max_parallel_requests = value;
+  }
+  if (GetEnvVar(kReadMaxReadaheadSize, strings::safe_strtou64, &value)) {
+    read_config.max_readahead = value * 1024 * 1024;
+  }
+  if (GetEnvVar(kReadaheadMemoryLimit, strings::safe_strtou64, &value)) {
+    read_config.readahead_memory_limit = value * 1024 * 1024;
+  }
+  VLOG(1) << "GCS parallel read chunk size = " << read_config.chunk_size
+          << " ; max parallel requests = " << read_config.max_parallel_requests
+          << " ; max readahead = " << read_config.max_readahead
+          << " ; readahead memory limit = "
+          << read_config.readahead_memory_limit;
+  SetReadConfig(read_config);
+
   GetEnvVar(kAllowedBucketLocations, SplitByCommaToLowercaseSet,
             &allowed_locations_);
 
@@ -1047,7 +1165,7 @@ absl::Status GcsFileSystem::NewRandomAccessFile(
     }));
   } else {
     result->reset(new BufferedGcsRandomAccessFile(
-        fname, block_size_,
+        fname, block_size_, read_config_.max_readahead, readahead_budget_,
         [this, bucket, object](const string& fname, uint64 offset, size_t n,
                                absl::string_view* result, char* scratch) {
           *result = absl::string_view();
@@ -1066,6 +1184,21 @@ absl::Status GcsFileSystem::NewRandomAccessFile(
   return absl::OkStatus();
 }
 
+void GcsFileSystem::SetReadConfig(const ReadConfig& config) {
+  read_config_ = config;
+  read_thread_pool_.reset();
+  if (config.chunk_size > 0) {
+    read_thread_pool_ = std::make_unique<thread::ThreadPool>(
+        Env::Default(), "gcs_parallel_read",
+        std::max(1, config.max_parallel_requests));
+  }
+  readahead_budget_.reset();
+  if (config.max_readahead > 0) {
+    readahead_budget_ =
+        std::make_shared<ReadaheadBudget>(config.readahead_memory_limit);
+  }
+}
+
 void GcsFileSystem::ResetFileBlockCache(size_t block_size_bytes,
                                         size_t max_bytes,
                                         uint64 max_staleness_secs) {
@@ -1106,30 +1239,89 @@ absl::Status GcsFileSystem::LoadBufferFromGCS(const string& fname,
   profiler::TraceMe activity(
       [fname]() { return absl::StrCat("LoadBufferFromGCS ", fname); });
 
-  std::unique_ptr<HttpRequest> request;
-  TF_RETURN_WITH_CONTEXT_IF_ERROR(CreateHttpRequest(&request),
+  const size_t chunk_size = read_config_.chunk_size;
+  const size_t num_chunks =
+      read_thread_pool_ == nullptr ? 1 : (n + chunk_size - 1) / chunk_size;
+  if (num_chunks <= 1) {
+    std::unique_ptr<HttpRequest> request;
+    TF_RETURN_IF_ERROR(
+        CreateRangeRequest(bucket, object, offset, n, buffer, &request));
+    TF_RETURN_IF_ERROR(
+        SendRangeRequest(fname, offset, n, request.get(), bytes_transferred));
+  } else {
+    // The requests are created up front so that only their transfers, which
+    // write to disjoint parts of `buffer`, run concurrently.
+    std::vector<std::unique_ptr<HttpRequest>> requests(num_chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+      const size_t chunk_offset = i * chunk_size;
+      TF_RETURN_IF_ERROR(CreateRangeRequest(
+          bucket, object, offset + chunk_offset,
+          std::min(chunk_size, n - chunk_offset), buffer + chunk_offset,
+          &requests[i]));
+    }
+    std::vector<absl::Status> statuses(num_chunks);
+    std::vector<size_t> chunk_bytes(num_chunks, 0);
+    BlockingCounter counter(static_cast<int>(num_chunks));
+    for (size_t i = 0; i < num_chunks; ++i) {
+      read_thread_pool_->Schedule([&, i]() {
+        const size_t chunk_offset = i * chunk_size;
+        statuses[i] = SendRangeRequest(
+            fname, offset + chunk_offset, std::min(chunk_size, n - chunk_offset),
+            requests[i].get(), &chunk_bytes[i]);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+    size_t bytes_read = 0;
+    for (size_t i = 0; i < num_chunks; ++i) {
+      TF_RETURN_IF_ERROR(statuses[i]);
+      if (bytes_read < i * chunk_size && chunk_bytes[i] > 0) {
+        // An earlier chunk ended the object, so it changed during the read.
+        return errors::Internal(strings::Printf(
+            "File contents are inconsistent for file: %s @ %lu.", fname.c_str(),
+            offset));
+      }
+      bytes_read += chunk_bytes[i];
+    }
+    *bytes_transferred = bytes_read;
+  }
+
+  activity.AppendMetadata([bytes_transferred]() {
+    return profiler::TraceMeEncode({{"block_size", *bytes_transferred}});
+  });
+  return absl::OkStatus();
+}
+
+absl::Status GcsFileSystem::CreateRangeRequest(
+    const string& bucket, const string& object, size_t offset, size_t n,
+    char* buffer, std::unique_ptr<HttpRequest>* request) {
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(CreateHttpRequest(request),
                                   "when reading gs://", bucket, "/", object);
 
-  request->SetUri(strings::StrCat("https://", kStorageHost, "/", bucket, "/",
-                                  request->EscapeString(object)));
-  request->SetRange(offset, offset + n - 1);
-  request->SetResultBufferDirect(buffer, n);
-  request->SetTimeouts(timeouts_.connect, timeouts_.idle, timeouts_.read);
+  (*request)->SetUri(strings::StrCat("https://", kStorageHost, "/", bucket,
+                                     "/", (*request)->EscapeString(object)));
+  (*request)->SetRange(offset, offset + n - 1);
+  (*request)->SetResultBufferDirect(buffer, n);
+  (*request)->SetTimeouts(timeouts_.connect, timeouts_.idle, timeouts_.read);
+  return absl::OkStatus();
+}
+
+absl::Status GcsFileSystem::SendRangeRequest(const string& fname,
+                                             size_t offset, size_t n,
+                                             HttpRequest* request,
+                                             size_t* bytes_transferred) {
+  *bytes_transferred = 0;
 
   if (stats_ != nullptr) {
     stats_->RecordBlockLoadRequest(fname, offset);
   }
 
-  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading gs://",
-                                  bucket, "/", object);
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading ", fname);
 
   size_t bytes_read = request->GetResultBufferDirectBytesTransferred();
   *bytes_transferred = bytes_read;
-  VLOG(1) << "Successful read of gs://" << bucket << "/" << object << " @ "
-          << offset << " of size: " << bytes_read;
-  activity.AppendMetadata([bytes_read]() {
-    return profiler::TraceMeEncode({{"block_size", bytes_read}});
-  });
+  VLOG(1) << "Successful read of " << fname << " @ " << offset
+          << " of size: " << bytes_read;
 
   if (stats_ != nullptr) {
     stats_->RecordBlockRetrieved(fname, offset, bytes_read);
@@ -1146,8 +1338,8 @@ absl::Status GcsFileSystem::LoadBufferFromGCS(const string& fname,
             "File contents are inconsistent for file: %s @ %lu.", fname.c_str(),
             offset));
       }
-      VLOG(2) << "Successful integrity check for: gs://" << bucket << "/"
-              << object << " @ " << offset;
+      VLOG(2) << "Successful integrity check for: " << fname << " @ "
+              << offset;
     }
   }
 
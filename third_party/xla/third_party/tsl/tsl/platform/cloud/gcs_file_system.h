@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_TSL_PLATFORM_CLOUD_GCS_FILE_SYSTEM_H_
 #define TENSORFLOW_TSL_PLATFORM_CLOUD_GCS_FILE_SYSTEM_H_
 
+#include <memory>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -32,6 +33,7 @@ limitations under the License.
 #include "tsl/platform/file_system.h"
 #include "tsl/platform/retrying_file_system.h"
 #include "tsl/platform/status.h"
+#include "tsl/platform/threadpool.h"
 
 namespace tsl {
 
@@ -125,6 +127,8 @@ struct UploadSessionHandle {
 class GcsFileSystem : public FileSystem {
  public:
   struct TimeoutConfig;
+  struct ReadConfig;
+  class ReadaheadBudget;
 
   // Main constructor used (via RetryingFileSystem) throughout Tensorflow
   explicit GcsFileSystem(bool make_default_cache = true);
@@ -216,6 +220,7 @@ class GcsFileSystem : public FileSystem {
     return file_block_cache_->max_staleness();
   }
   TimeoutConfig timeouts() const { return timeouts_; }
+  const ReadConfig& read_config() const { return read_config_; }
   std::unordered_set<string> allowed_locations() const {
     return allowed_locations_;
   }
@@ -273,6 +278,32 @@ class GcsFileSystem : public FileSystem {
           write(write) {}
   };
 
+  /// Structure containing the knobs for reading large ranges of objects.
+  struct ReadConfig {
+    // Reads of more than `chunk_size` bytes are split into range requests of
+    // at most `chunk_size` bytes, which are sent concurrently. A value of 0
+    // (the default) sends every read as a single request.
+    size_t chunk_size = 0;
+
+    // The maximum number of range requests in flight at once across all the
+    // files of the filesystem.
+    int max_parallel_requests = 8;
+
+    // Once a file is read sequentially, its read buffer doubles on each refill
+    // up to `max_readahead` bytes. Any other refill shrinks it back to the
+    // block size. A value of 0 (the default) keeps the block size.
+    size_t max_readahead = 0;
+
+    // The maximum number of bytes by which the read buffers of all the files
+    // of the filesystem may grow beyond the block size.
+    size_t readahead_memory_limit = 1024 * 1024 * 1024;
+  };
+
+  /// \brief Sets the knobs for reading large ranges of objects.
+  ///
+  /// Must be called before any file is opened.
+  void SetReadConfig(const ReadConfig& config);
+
   absl::Status CreateHttpRequest(std::unique_ptr<HttpRequest>* request);
 
   /// \brief Sets a new AuthProvider on the GCS FileSystem.
@@ -412,6 +443,16 @@ class GcsFileSystem : public FileSystem {
 
   absl::Status RenameObject(const string& src, const string& target);
 
+  /// Creates a request that reads `n` bytes at `offset` of an object directly
+  /// into `buffer`.
+  absl::Status CreateRangeRequest(const string& bucket, const string& object,
+                                  size_t offset, size_t n, char* buffer,
+                                  std::unique_ptr<HttpRequest>* request);
+  /// Sends a request created by CreateRangeRequest and checks its result.
+  absl::Status SendRangeRequest(const string& fname, size_t offset, size_t n,
+                                HttpRequest* request,
+                                size_t* bytes_transferred);
+
   // Clear all the caches related to the file with name `filename`.
   void ClearFileCaches(const string& fname);
 
@@ -446,6 +487,12 @@ class GcsFileSystem : public FileSystem {
 
   GcsStatsInterface* stats_ = nullptr;  // Not owned.
 
+  ReadConfig read_config_;
+  // Sends the range requests of split reads. Null if reads are not split.
+  std::unique_ptr<thread::ThreadPool> read_thread_pool_;
+  // Shared with the files whose read buffers may grow. Null if they may not.
+  std::shared_ptr<ReadaheadBudget> readahead_budget_;
+
   // Additional header material to be transmitted with all GCS requests
   std::unique_ptr<std::pair<const string, const string>> additional_header_;
 
@@ -383,6 +383,199 @@ TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered_Growing) {
   EXPECT_EQ("0123456789", result);
 }
 
+TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered_ParallelRanges) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-3\n"
+           "Timeouts: 5 1 20\n",
+           "0123"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 4-7\n"
+           "Timeouts: 5 1 20\n",
+           "4567"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 8-9\n"
+           "Timeouts: 5 1 20\n",
+           "89"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 10-13\n"
+           "Timeouts: 5 1 20\n",
+           "ab"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 14-17\n"
+           "Timeouts: 5 1 20\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 18-19\n"
+           "Timeouts: 5 1 20\n",
+           "")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 10 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  GcsFileSystem::ReadConfig read_config;
+  read_config.chunk_size = 4;
+  read_config.max_parallel_requests = 2;
+  fs.SetReadConfig(read_config);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(
+      fs.NewRandomAccessFile("gs://bucket/random_access.txt", nullptr, &file));
+
+  char scratch[6];
+  absl::string_view result;
+
+  // The buffer is filled by three concurrent range requests.
+  TF_EXPECT_OK(file->Read(0, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("012345", result);
+
+  // The object ends in the first range of the second buffer.
+  TF_EXPECT_OK(file->Read(sizeof(scratch), sizeof(scratch), &result, scratch));
+  EXPECT_EQ("6789ab", result);
+  EXPECT_TRUE(
+      errors::IsOutOfRange(file->Read(12, sizeof(scratch), &result, scratch)));
+}
+
+TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered_AdaptiveReadahead) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-9\n"
+           "Timeouts: 5 1 20\n",
+           "0123456789"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 10-29\n"
+           "Timeouts: 5 1 20\n",
+           "abcdefghijklmnopqrst"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 30-59\n"
+           "Timeouts: 5 1 20\n",
+           "ABCDEFGHIJKLMNOPQRSTUVWXYZ!@#$"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 5-14\n"
+           "Timeouts: 5 1 20\n",
+           "56789abcde")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 10 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  GcsFileSystem::ReadConfig read_config;
+  read_config.max_readahead = 30;
+  fs.SetReadConfig(read_config);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(
+      fs.NewRandomAccessFile("gs://bucket/random_access.txt", nullptr, &file));
+
+  char scratch[8];
+  absl::string_view result;
+
+  // Sequential reads double the buffer up to the maximum readahead.
+  TF_EXPECT_OK(file->Read(0, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("01234567", result);
+  TF_EXPECT_OK(file->Read(8, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("89abcdef", result);
+  TF_EXPECT_OK(file->Read(16, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("ghijklmn", result);
+  TF_EXPECT_OK(file->Read(24, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("opqrstAB", result);
+  TF_EXPECT_OK(file->Read(32, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("CDEFGHIJ", result);
+
+  // A jump back shrinks the buffer to the block size.
+  TF_EXPECT_OK(file->Read(5, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("56789abc", result);
+}
+
+TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered_ReadaheadMemoryLimit) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/a.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-9\n"
+           "Timeouts: 5 1 20\n",
+           "0123456789"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/b.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-9\n"
+           "Timeouts: 5 1 20\n",
+           "0123456789"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/a.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 10-24\n"
+           "Timeouts: 5 1 20\n",
+           "abcdefghijklmno"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/b.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 10-19\n"
+           "Timeouts: 5 1 20\n",
+           "abcdefghij")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 10 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  GcsFileSystem::ReadConfig read_config;
+  read_config.max_readahead = 40;
+  read_config.readahead_memory_limit = 5;
+  fs.SetReadConfig(read_config);
+
+  std::unique_ptr<RandomAccessFile> a, b;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/a.txt", nullptr, &a));
+  TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/b.txt", nullptr, &b));
+
+  char scratch[10];
+  absl::string_view result;
+
+  TF_EXPECT_OK(a->Read(0, sizeof(scratch), &result, scratch));
+  TF_EXPECT_OK(b->Read(0, sizeof(scratch), &result, scratch));
+
+  // The first file takes the whole budget, so the second one can't grow.
+  TF_EXPECT_OK(a->Read(10, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("abcdefghij", result);
+  TF_EXPECT_OK(b->Read(10, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("abcdefghij", result);
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered_ReadBackwards) {
   // Go backwards in the file. It should trigger a new read.
   std::vector<HttpRequest*> requests(
@@ -3680,6 +3873,23 @@ TEST(GcsFileSystemTest, OverrideCacheParameters) {
   EXPECT_EQ(20, fs5.timeouts().metadata);
   EXPECT_EQ(30, fs5.timeouts().read);
   EXPECT_EQ(40, fs5.timeouts().write);
+
+  // Verify parallel read and readahead overrides.
+  EXPECT_EQ(0, fs5.read_config().chunk_size);
+  EXPECT_EQ(0, fs5.read_config().max_readahead);
+  setenv("GCS_READ_PARALLEL_CHUNK_SIZE_MB", "8", 1);
+  setenv("GCS_READ_MAX_PARALLEL_REQUESTS", "4", 1);
+  setenv("GCS_READ_MAX_READAHEAD_SIZE_MB", "64", 1);
+  setenv("GCS_READAHEAD_MEMORY_LIMIT_MB", "256", 1);
+  GcsFileSystem fs6;
+  EXPECT_EQ(8 * 1024 * 1024, fs6.read_config().chunk_size);
+  EXPECT_EQ(4, fs6.read_config().max_parallel_requests);
+  EXPECT_EQ(64 * 1024 * 1024, fs6.read_config().max_readahead);
+  EXPECT_EQ(256 * 1024 * 1024, fs6.read_config().readahead_memory_limit);
+  unsetenv("GCS_READ_PARALLEL_CHUNK_SIZE_MB");
+  unsetenv("GCS_READ_MAX_PARALLEL_REQUESTS");
+  unsetenv("GCS_READ_MAX_READAHEAD_SIZE_MB");
+  unsetenv("GCS_READAHEAD_MEMORY_LIMIT_MB");
 }
 
 TEST(GcsFileSystemTest, CreateHttpRequest) {
@@ -71,6 +71,15 @@ constexpr absl::Duration kDefaultShutdownTimeout = absl::Seconds(10);
 constexpr char kHeartbeatThread[] = "CoordinationServiceHeartbeatLoop";
 constexpr char kErrorPollingThread[] = "CoordinationServiceErrorPolling";
 
+// Returns true if a request that failed with `status` at the parent task in
+// hierarchical mode should be retried with the leader: the parent may be down
+// or may not aggregate requests yet. Coordination errors come from the leader
+// and are final.
+bool ShouldRetryWithLeader(const absl::Status& status) {
+  return !status.ok() && !absl::IsCancelled(status) &&
+         !status.GetPayload(CoordinationErrorPayloadKey()).has_value();
+}
+
 class CoordinationServiceAgentImpl : public CoordinationServiceAgent {
  public:
   CoordinationServiceAgentImpl() = default;
@@ -86,6 +95,8 @@ class CoordinationServiceAgentImpl : public CoordinationServiceAgent {
                           const CoordinationServiceConfig& configs,
                           std::unique_ptr<CoordinationClient> leader_client,
                           StatusCallback error_fn) override;
+  absl::Status SetParentClient(
+      std::unique_ptr<CoordinationClient> parent_client) override;
   bool IsInitialized() override;
   bool IsConnected() override;
   bool IsError() override;
@@ -187,6 +198,8 @@ class CoordinationServiceAgentImpl : public CoordinationServiceAgent {
   std::unique_ptr<CancellationManager> error_polling_cancellation_manager_ =
       std::make_unique<CancellationManager>();
   std::unique_ptr<CoordinationClient> leader_client_;
+  // Parent task in hierarchical mode, or null.
+  std::unique_ptr<CoordinationClient> parent_client_;
 
   CoordinationServiceAgentImpl(const CoordinationServiceAgentImpl&) = delete;
   void operator=(const CoordinationServiceAgentImpl&) = delete;
@@ -232,6 +245,18 @@ absl::Status CoordinationServiceAgentImpl::Initialize(
   return absl::OkStatus();
 }
 
+absl::Status CoordinationServiceAgentImpl::SetParentClient(
+    std::unique_ptr<CoordinationClient> parent_client) {
+  absl::MutexLock l(&state_mu_);
+  if (state_ != CoordinatedTaskState::TASKSTATE_DISCONNECTED) {
+    return MakeCoordinationError(absl::FailedPreconditionError(
+        "The parent client must be set after Initialize() and before "
+        "Connect()."));
+  }
+  parent_client_ = std::move(parent_client);
+  return absl::OkStatus();
+}
+
 bool CoordinationServiceAgentImpl::IsInitialized() {
   absl::MutexLock l(&state_mu_);
   return state_ != CoordinatedTaskState::TASKSTATE_UNINITIALIZED;
@@ -364,19 +389,34 @@ void CoordinationServiceAgentImpl::StartSendingHeartbeats() {
   CallOptions call_opts;
   call_opts.SetTimeout(heartbeat_interval_ms);
 
-  while (true) {
+  auto send_heartbeat = [&](CoordinationClient* client) {
     absl::Status status;
     absl::Notification n;
     // Heartbeat RPC implementation automatically retries to tolerate
     // transient network failures.
     VLOG(10) << "HeartbeatRequest: " << request.DebugString();
-    leader_client_->HeartbeatAsync(&call_opts, &request, &response,
-                                   [&](absl::Status s) {
-                                     status = s;
-                                     n.Notify();
-                                   });
+    client->HeartbeatAsync(&call_opts, &request, &response,
+                           [&](absl::Status s) {
+                             status = s;
+                             n.Notify();
+                           });
     n.WaitForNotification();
     VLOG(10) << "HeartbeatResponse: " << status;
+    return status;
+  };
+  while (true) {
+    absl::Status status;
+    if (parent_client_ != nullptr) {
+      status = send_heartbeat(parent_client_.get());
+      if (ShouldRetryWithLeader(status)) {
+        VLOG(3) << "Heartbeat to parent task failed, retrying with the "
+                   "leader: "
+                << status;
+        status = send_heartbeat(leader_client_.get());
+      }
+    } else {
+      status = send_heartbeat(leader_client_.get());
+    }
     if (!status.ok()) {
       // Ignore heartbeat errors and exit thread if shutting down. For
       // example, the agent may send a heartbeat right after Shutdown()
@@ -740,22 +780,41 @@ std::shared_ptr<CallOptions> CoordinationServiceAgentImpl::GetKeyValueAsync(
     done(absl::CancelledError("GetKeyValueAsync() was cancelled."));
     return call_opts;
   }
-  leader_client_->GetKeyValueAsync(
+  StatusCallback on_done = [call_opts, request, response,
+                            done = std::move(done),
+                            &cm = cancellation_manager_,
+                            token](const absl::Status& s) {
+    // RPC call has completed (no longer needs to be cancelled if agent is
+    // destroyed).
+    cm.TryDeregisterCallback(token);
+
+    // Retrieve server response.
+    if (!s.ok()) {
+      done(s);
+      VLOG(3) << "GetKeyValueResponse: " << s;
+    } else {
+      done(response->kv().value());
+      VLOG(3) << "GetKeyValueResponse: " << response->DebugString();
+    }
+  };
+  if (parent_client_ == nullptr) {
+    leader_client_->GetKeyValueAsync(call_opts.get(), request.get(),
+                                     response.get(), std::move(on_done));
+    return call_opts;
+  }
+  parent_client_->GetKeyValueAsync(
       call_opts.get(), request.get(), response.get(),
-      [call_opts, request, response, done = std::move(done),
-       &cm = cancellation_manager_, token](const absl::Status& s) {
-        // RPC call has completed (no longer needs to be cancelled if agent is
-        // destroyed).
-        cm.TryDeregisterCallback(token);
-
-        // Retrieve server response.
-        if (!s.ok()) {
-          done(s);
-          VLOG(3) << "GetKeyValueResponse: " << s;
-        } else {
-          done(response->kv().value());
-          VLOG(3) << "GetKeyValueResponse: " << response->DebugString();
+      [leader_client = leader_client_.get(), call_opts, request, response,
+       on_done = std::move(on_done)](const absl::Status& s) {
+        if (ShouldRetryWithLeader(s)) {
+          VLOG(3) << "GetKeyValue at parent task failed, retrying with the "
+                     "leader: "
+                  << s;
+          leader_client->GetKeyValueAsync(call_opts.get(), request.get(),
+                                          response.get(), on_done);
+          return;
         }
+        on_done(s);
       });
   return call_opts;
 }
@@ -941,12 +1000,29 @@ void CoordinationServiceAgentImpl::WaitAtBarrierAsync(
   *request->mutable_source_task() = task_;
   *request->mutable_tasks() = {tasks.begin(), tasks.end()};
   VLOG(3) << "WaitAtBarrierRequest: " << request->DebugString();
-  leader_client_->BarrierAsync(
+  StatusCallback on_done = [request, response,
+                            done = std::move(done)](const absl::Status& s) {
+    auto status = TrimCoordinationErrorMessage(s);
+    done(status);
+    VLOG(3) << "WaitAtBarrierResponse: " << status;
+  };
+  if (parent_client_ == nullptr) {
+    leader_client_->BarrierAsync(request.get(), response.get(),
+                                 std::move(on_done));
+    return;
+  }
+  parent_client_->BarrierAsync(
       request.get(), response.get(),
-      [request, response, done = std::move(done)](const absl::Status& s) {
-        auto status = TrimCoordinationErrorMessage(s);
-        done(status);
-        VLOG(3) << "WaitAtBarrierResponse: " << status;
+      [leader_client = leader_client_.get(), request, response,
+       on_done = std::move(on_done)](const absl::Status& s) {
+        if (ShouldRetryWithLeader(s)) {
+          VLOG(3) << "WaitAtBarrier at parent task failed, retrying with the "
+                     "leader: "
+                  << s;
+          leader_client->BarrierAsync(request.get(), response.get(), on_done);
+          return;
+        }
+        on_done(s);
       });
 }
 
@@ -83,6 +83,17 @@ class CoordinationServiceAgent {
       std::unique_ptr<CoordinationClient> leader_client,
       StatusCallback error_fn) = 0;
 
+  // Sends barrier, heartbeat and blocking key-value read requests to
+  // `parent_client` instead of the leader, for hierarchical coordination (see
+  // `CoordinationServiceConfig.hierarchical_fanout`). Requests that fail with
+  // an RPC error are retried with the leader. Must be called after
+  // Initialize() and before Connect().
+  virtual absl::Status SetParentClient(
+      std::unique_ptr<CoordinationClient> parent_client) {
+    return absl::UnimplementedError(
+        "CoordinationServiceAgent::SetParentClient is not implemented.");
+  }
+
   // Return true if the coordination service agent has been initialized.
   virtual bool IsInitialized() = 0;
 
@@ -0,0 +1,418 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "xla/tsl/distributed_runtime/coordination/coordination_service_aggregator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/tsl/distributed_runtime/call_options.h"
+#include "xla/tsl/distributed_runtime/coordination/coordination_client.h"
+#include "xla/tsl/distributed_runtime/coordination/coordination_service_error_util.h"
+#include "xla/tsl/util/device_name_utils.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/status.h"
+#include "tsl/protobuf/coordination_config.pb.h"
+#include "tsl/protobuf/coordination_service.pb.h"
+
+namespace tsl {
+namespace {
+using tensorflow::BarrierRequest;
+using tensorflow::BarrierResponse;
+using tensorflow::CoordinatedTask;
+using tensorflow::CoordinatedTaskStateInfo;
+using tensorflow::CoordinationServiceConfig;
+using tensorflow::GetKeyValueRequest;
+using tensorflow::GetKeyValueResponse;
+using tensorflow::HeartbeatRequest;
+using tensorflow::HeartbeatResponse;
+
+constexpr int64_t kDefaultHeartbeatTimeoutMs = 10 * 1000;  // 10 seconds
+
+std::string GetTaskName(const CoordinatedTask& task) {
+  return absl::StrCat("/job:", task.job_name(), "/replica:", 0,
+                      "/task:", task.task_id());
+}
+
+CoordinatedTask GetTaskFromName(std::string_view task_name) {
+  DeviceNameUtils::ParsedName parsed;
+  DeviceNameUtils::ParseFullName(task_name, &parsed);
+  CoordinatedTask task;
+  task.set_job_name(parsed.job);
+  task.set_task_id(parsed.task);
+  return task;
+}
+
+bool SameTask(const CoordinatedTask& lhs, const CoordinatedTask& rhs) {
+  return lhs.job_name() == rhs.job_name() && lhs.task_id() == rhs.task_id();
+}
+
+// Returns the position of `task` in `hierarchy`, or -1.
+int FindTask(const std::vector<CoordinatedTask>& hierarchy,
+             const CoordinatedTask& task) {
+  for (int i = 0; i < hierarchy.size(); ++i) {
+    if (SameTask(hierarchy[i], task)) return i;
+  }
+  return -1;
+}
+
+}  // namespace
+
+bool IsHierarchicalCoordination(const CoordinationServiceConfig& config) {
+  return config.hierarchical_fanout() >= 2;
+}
+
+std::vector<CoordinatedTask> GetCoordinationHierarchy(
+    const CoordinationServiceConfig& config) {
+  const CoordinatedTask leader = GetTaskFromName(config.service_leader());
+  std::vector<CoordinatedTask> hierarchy = {leader};
+  for (const auto& job : config.coordinated_job_list()) {
+    for (int i = 0; i < job.num_tasks(); ++i) {
+      CoordinatedTask task;
+      task.set_job_name(job.name());
+      task.set_task_id(i);
+      if (!SameTask(task, leader)) hierarchy.push_back(std::move(task));
+    }
+  }
+  return hierarchy;
+}
+
+std::optional<CoordinatedTask> GetCoordinationParent(
+    const CoordinationServiceConfig& config, const CoordinatedTask& task) {
+  if (!IsHierarchicalCoordination(config)) return std::nullopt;
+  const std::vector<CoordinatedTask> hierarchy =
+      GetCoordinationHierarchy(config);
+  const int index = FindTask(hierarchy, task);
+  if (index <= 0) return std::nullopt;
+  return hierarchy[(index - 1) / config.hierarchical_fanout()];
+}
+
+std::vector<CoordinatedTask> GetCoordinationSubtree(
+    const CoordinationServiceConfig& config, const CoordinatedTask& task) {
+  std::vector<CoordinatedTask> subtree;
+  if (!IsHierarchicalCoordination(config)) return subtree;
+  const std::vector<CoordinatedTask> hierarchy =
+      GetCoordinationHierarchy(config);
+  const int64_t fanout = config.hierarchical_fanout();
+  const int index = FindTask(hierarchy, task);
+  if (index < 0) return subtree;
+  // The descendants at each depth form a contiguous range of positions.
+  int64_t begin = index;
+  int64_t end = index + 1;
+  while (true) {
+    begin = begin * fanout + 1;
+    end = std::min<int64_t>((end - 1) * fanout + fanout + 1, hierarchy.size());
+    if (begin >= end) break;
+    for (int64_t i = begin; i < end; ++i) subtree.push_back(hierarchy[i]);
+  }
+  return subtree;
+}
+
+CoordinatedTaskStateInfo HeartbeatResultFromStatus(const CoordinatedTask& task,
+                                                   const absl::Status& status) {
+  CoordinatedTaskStateInfo result;
+  *result.mutable_task() = task;
+  if (status.ok()) return result;
+  result.set_error_code(static_cast<int>(status.code()));
+  result.set_error_message(std::string(status.message()));
+  std::optional<absl::Cord> payload =
+      status.GetPayload(CoordinationErrorPayloadKey());
+  if (payload.has_value()) {
+    result.mutable_error_payload()->ParseFromString(std::string(*payload));
+  }
+  return result;
+}
+
+absl::Status StatusFromHeartbeatResult(const CoordinatedTaskStateInfo& result) {
+  if (result.error_code() == 0) return absl::OkStatus();
+  absl::Status status(static_cast<absl::StatusCode>(result.error_code()),
+                      result.error_message());
+  if (result.has_error_payload()) {
+    return MakeCoordinationError(status, result.error_payload());
+  }
+  return status;
+}
+
+/* static */
+std::shared_ptr<CoordinationServiceAggregator>
+CoordinationServiceAggregator::Create(
+    Env* env, const CoordinationServiceConfig& config,
+    const CoordinatedTask& task,
+    std::unique_ptr<CoordinationClient> upstream_client) {
+  return std::shared_ptr<CoordinationServiceAggregator>(
+      new CoordinationServiceAggregator(env, config, task,
+                                        std::move(upstream_client)));
+}
+
+CoordinationServiceAggregator::CoordinationServiceAggregator(
+    Env* env, const CoordinationServiceConfig& config,
+    const CoordinatedTask& task,
+    std::unique_ptr<CoordinationClient> upstream_client)
+    : env_(env),
+      config_(config),
+      task_(task),
+      upstream_client_(std::move(upstream_client)),
+      subtree_([&] {
+        absl::flat_hash_set<std::string> subtree;
+        for (const CoordinatedTask& t : GetCoordinationSubtree(config, task)) {
+          subtree.insert(GetTaskName(t));
+        }
+        return subtree;
+      }()) {}
+
+void CoordinationServiceAggregator::HeartbeatAsync(
+    const HeartbeatRequest* request, HeartbeatResponse* response,
+    StatusCallback done) {
+  std::vector<PendingHeartbeat> batch;
+  {
+    absl::MutexLock l(&mu_);
+    pending_heartbeats_.push_back({request, response, std::move(done)});
+    if (heartbeat_in_flight_) return;
+    heartbeat_in_flight_ = true;
+    batch.swap(pending_heartbeats_);
+  }
+  SendHeartbeats(std::move(batch));
+}
+
+void CoordinationServiceAggregator::SendHeartbeats(
+    std::vector<PendingHeartbeat> batch) {
+  auto request = std::make_shared<HeartbeatRequest>();
+  auto response = std::make_shared<HeartbeatResponse>();
+  auto call_opts = std::make_shared<CallOptions>();
+  call_opts->SetTimeout((config_.heartbeat_timeout_in_ms() > 0
+                             ? config_.heartbeat_timeout_in_ms()
+                             : kDefaultHeartbeatTimeoutMs) /
+                        2);
+  *request->mutable_source_task() = task_;
+  for (const PendingHeartbeat& pending : batch) {
+    if (pending.request->aggregated_heartbeats_size() > 0) {
+      request->mutable_aggregated_heartbeats()->MergeFrom(
+          pending.request->aggregated_heartbeats());
+    } else {
+      auto* heartbeat = request->add_aggregated_heartbeats();
+      *heartbeat->mutable_source_task() = pending.request->source_task();
+      heartbeat->set_incarnation(pending.request->incarnation());
+    }
+  }
+  VLOG(10) << "Forwarding " << request->aggregated_heartbeats_size()
+           << " heartbeats";
+  upstream_client_->HeartbeatAsync(
+      call_opts.get(), request.get(), response.get(),
+      [self = shared_from_this(), call_opts, request, response,
+       batch = std::move(batch)](const absl::Status& s) {
+        absl::flat_hash_map<std::string, const CoordinatedTaskStateInfo*>
+            results;
+        for (const CoordinatedTaskStateInfo& result :
+             response->aggregated_results()) {
+          results[GetTaskName(result.task())] = &result;
+        }
+        auto result_for = [&](const CoordinatedTask& task) {
+          auto it = results.find(GetTaskName(task));
+          if (it != results.end()) return *it->second;
+          return HeartbeatResultFromStatus(
+              task, MakeCoordinationError(absl::InternalError(absl::StrCat(
+                        "No heartbeat result for ", GetTaskName(task)))));
+        };
+        for (const PendingHeartbeat& pending : batch) {
+          pending.response->set_leader_incarnation(
+              response->leader_incarnation());
+          if (!s.ok()) {
+            pending.done(s);
+          } else if (pending.request->aggregated_heartbeats_size() > 0) {
+            for (const auto& heartbeat :
+                 pending.request->aggregated_heartbeats()) {
+              *pending.response->add_aggregated_results() =
+                  result_for(heartbeat.source_task());
+            }
+            pending.done(absl::OkStatus());
+          } else {
+            pending.done(StatusFromHeartbeatResult(
+                result_for(pending.request->source_task())));
+          }
+        }
+        std::vector<PendingHeartbeat> next;
+        {
+          absl::MutexLock l(&self->mu_);
+          if (self->pending_heartbeats_.empty()) {
+            self->heartbeat_in_flight_ = false;
+            return;
+          }
+          next.swap(self->pending_heartbeats_);
+        }
+        self->SendHeartbeats(std::move(next));
+      });
+}
+
+void CoordinationServiceAggregator::BarrierAsync(const BarrierRequest* request,
+                                                 BarrierResponse* response,
+                                                 StatusCallback done) {
+  const std::string& barrier_id = request->barrier_id();
+  std::optional<BarrierBatch> batch;
+  {
+    absl::MutexLock l(&mu_);
+    auto [it, inserted] = barriers_.try_emplace(barrier_id);
+    PendingBarrier* barrier = &it->second;
+    if (inserted) {
+      barrier->timeout_ms = request->barrier_timeout_in_ms();
+      barrier->tasks = {request->tasks().begin(), request->tasks().end()};
+      absl::flat_hash_set<std::string> participants;
+      for (const CoordinatedTask& task : request->tasks()) {
+        participants.insert(GetTaskName(task));
+      }
+      for (const std::string& task : subtree_) {
+        if (participants.empty() || participants.contains(task)) {
+          barrier->waiting_for.insert(task);
+        }
+      }
+    }
+    if (request->aggregated_source_tasks_size() > 0) {
+      for (const CoordinatedTask& task : request->aggregated_source_tasks()) {
+        barrier->waiting_for.erase(GetTaskName(task));
+        barrier->arrived.push_back(task);
+      }
+    } else {
+      barrier->waiting_for.erase(GetTaskName(request->source_task()));
+      barrier->arrived.push_back(request->source_task());
+    }
+    barrier->callbacks.push_back(std::move(done));
+    batch = TakeBarrierBatch(barrier_id, barrier);
+  }
+  if (batch.has_value()) SendBarrier(barrier_id, *std::move(batch));
+}
+
+std::optional<CoordinationServiceAggregator::BarrierBatch>
+CoordinationServiceAggregator::TakeBarrierBatch(const std::string& barrier_id,
+                                                PendingBarrier* barrier) {
+  if (barrier->arrived.empty()) return std::nullopt;
+  if (!barrier->waiting_for.empty() && !barrier->deadline_passed) {
+    // Give the rest of the subtree half of the timeout to arrive, so that
+    // the leader still reports the missing tasks before the barrier times
+    // out.
+    if (!barrier->timer_scheduled) {
+      barrier->timer_scheduled = true;
+      env_->SchedClosureAfter(
+          barrier->timeout_ms * 1000 / 2,
+          [weak_self = weak_from_this(), barrier_id]() {
+            if (auto self = weak_self.lock()) {
+              self->OnBarrierDeadline(barrier_id);
+            }
+          });
+    }
+    return std::nullopt;
+  }
+  BarrierBatch batch;
+  batch.timeout_ms = barrier->timeout_ms;
+  batch.tasks = barrier->tasks;
+  batch.arrived.swap(barrier->arrived);
+  batch.callbacks.swap(barrier->callbacks);
+  return batch;
+}
+
+void CoordinationServiceAggregator::SendBarrier(const std::string& barrier_id,
+                                                BarrierBatch batch) {
+  auto request = std::make_shared<BarrierRequest>();
+  auto response = std::make_shared<BarrierResponse>();
+  request->set_barrier_id(barrier_id);
+  request->set_barrier_timeout_in_ms(batch.timeout_ms);
+  *request->mutable_tasks() = {batch.tasks.begin(), batch.tasks.end()};
+  *request->mutable_source_task() = task_;
+  *request->mutable_aggregated_source_tasks() = {batch.arrived.begin(),
+                                                 batch.arrived.end()};
+  VLOG(3) << "Forwarding " << batch.arrived.size() << " arrivals at barrier "
+          << barrier_id;
+  upstream_client_->BarrierAsync(
+      request.get(), response.get(),
+      [self = shared_from_this(), request, response,
+       callbacks = std::move(batch.callbacks)](const absl::Status& s) {
+        for (const StatusCallback& callback : callbacks) callback(s);
+        self->OnBarrierDone(request->barrier_id(), s);
+      });
+}
+
+void CoordinationServiceAggregator::OnBarrierDeadline(
+    const std::string& barrier_id) {
+  std::optional<BarrierBatch> batch;
+  {
+    absl::MutexLock l(&mu_);
+    auto it = barriers_.find(barrier_id);
+    if (it == barriers_.end()) return;
+    it->second.deadline_passed = true;
+    batch = TakeBarrierBatch(barrier_id, &it->second);
+  }
+  if (batch.has_value()) SendBarrier(barrier_id, *std::move(batch));
+}
+
+void CoordinationServiceAggregator::OnBarrierDone(const std::string& barrier_id,
+                                                  const absl::Status& status) {
+  // The barrier has completed or failed at the leader, so the arrivals that
+  // have not been forwarded yet share its result.
+  std::vector<StatusCallback> callbacks;
+  {
+    absl::MutexLock l(&mu_);
+    auto it = barriers_.find(barrier_id);
+    if (it == barriers_.end()) return;
+    callbacks.swap(it->second.callbacks);
+    barriers_.erase(it);
+  }
+  for (const StatusCallback& callback : callbacks) callback(status);
+}
+
+void CoordinationServiceAggregator::GetKeyValueAsync(
+    const GetKeyValueRequest* request, GetKeyValueResponse* response,
+    StatusCallback done) {
+  const std::string& key = request->key();
+  {
+    absl::MutexLock l(&mu_);
+    std::vector<PendingRead>& readers = reads_[key];
+    readers.push_back({response, std::move(done)});
+    if (readers.size() > 1) return;
+  }
+  auto upstream_request = std::make_shared<GetKeyValueRequest>(*request);
+  auto upstream_response = std::make_shared<GetKeyValueResponse>();
+  auto call_opts = std::make_shared<CallOptions>();
+  upstream_client_->GetKeyValueAsync(
+      call_opts.get(), upstream_request.get(), upstream_response.get(),
+      [self = shared_from_this(), call_opts, upstream_request,
+       upstream_response](const absl::Status& s) {
+        std::vector<PendingRead> readers;
+        {
+          absl::MutexLock l(&self->mu_);
+          auto it = self->reads_.find(upstream_request->key());
+          readers.swap(it->second);
+          self->reads_.erase(it);
+        }
+        for (const PendingRead& reader : readers) {
+          reader.response->mutable_kv()->set_key(upstream_request->key());
+          if (s.ok()) {
+            reader.response->mutable_kv()->set_value(
+                upstream_response->kv().value());
+          }
+          reader.done(s);
+        }
+      });
+}
+
+}  // namespace tsl
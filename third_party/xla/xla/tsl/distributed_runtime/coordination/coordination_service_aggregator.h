@@ -0,0 +1,170 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef XLA_TSL_DISTRIBUTED_RUNTIME_COORDINATION_COORDINATION_SERVICE_AGGREGATOR_H_
+#define XLA_TSL_DISTRIBUTED_RUNTIME_COORDINATION_COORDINATION_SERVICE_AGGREGATOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/tsl/distributed_runtime/coordination/coordination_client.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/status.h"
+#include "tsl/protobuf/coordination_config.pb.h"
+#include "tsl/protobuf/coordination_service.pb.h"
+
+namespace tsl {
+
+// Returns true if `config` arranges the tasks in a tree, see
+// `CoordinationServiceConfig.hierarchical_fanout`.
+bool IsHierarchicalCoordination(
+    const tensorflow::CoordinationServiceConfig& config);
+
+// Returns all coordinated tasks in tree order: the service leader first,
+// followed by the tasks of `coordinated_job_list` in order. With a fanout of
+// `f`, the parent of the task at position `i > 0` is at position
+// `(i - 1) / f`.
+std::vector<tensorflow::CoordinatedTask> GetCoordinationHierarchy(
+    const tensorflow::CoordinationServiceConfig& config);
+
+// Returns the parent of `task` in the tree, or nullopt if hierarchical
+// coordination is disabled, or if `task` is the leader or is not coordinated.
+std::optional<tensorflow::CoordinatedTask> GetCoordinationParent(
+    const tensorflow::CoordinationServiceConfig& config,
+    const tensorflow::CoordinatedTask& task);
+
+// Returns the descendants of `task` in the tree, excluding `task` itself.
+std::vector<tensorflow::CoordinatedTask> GetCoordinationSubtree(
+    const tensorflow::CoordinationServiceConfig& config,
+    const tensorflow::CoordinatedTask& task);
+
+// Converts the result of one aggregated heartbeat to and from the status that
+// `CoordinationServiceInterface::RecordHeartbeat()` returned for it.
+tensorflow::CoordinatedTaskStateInfo HeartbeatResultFromStatus(
+    const tensorflow::CoordinatedTask& task, const absl::Status& status);
+absl::Status StatusFromHeartbeatResult(
+    const tensorflow::CoordinatedTaskStateInfo& result);
+
+// CoordinationServiceAggregator runs on the inner tasks of the tree in
+// hierarchical mode. It receives the barrier, heartbeat and blocking
+// key-value requests of its children, and forwards them to its own parent
+// with one request per batch:
+//
+//   - Barrier arrivals are held until every task of the subtree that takes
+//     part in the barrier has arrived, or until half of the barrier timeout
+//     has passed, after which arrivals are forwarded as they come. The
+//     children are released when the barrier completes at the leader.
+//   - Heartbeats that arrive while a batch is in flight are sent together in
+//     the next batch.
+//   - Concurrent reads of the same key share one upstream read.
+//
+// This class is thread-safe.
+class CoordinationServiceAggregator
+    : public std::enable_shared_from_this<CoordinationServiceAggregator> {
+ public:
+  // `upstream_client` talks to the parent of `task`.
+  static std::shared_ptr<CoordinationServiceAggregator> Create(
+      Env* env, const tensorflow::CoordinationServiceConfig& config,
+      const tensorflow::CoordinatedTask& task,
+      std::unique_ptr<CoordinationClient> upstream_client);
+
+  CoordinationServiceAggregator(const CoordinationServiceAggregator&) = delete;
+  void operator=(const CoordinationServiceAggregator&) = delete;
+
+  void HeartbeatAsync(const tensorflow::HeartbeatRequest* request,
+                      tensorflow::HeartbeatResponse* response,
+                      StatusCallback done);
+
+  void BarrierAsync(const tensorflow::BarrierRequest* request,
+                    tensorflow::BarrierResponse* response, StatusCallback done);
+
+  void GetKeyValueAsync(const tensorflow::GetKeyValueRequest* request,
+                        tensorflow::GetKeyValueResponse* response,
+                        StatusCallback done);
+
+ private:
+  struct PendingHeartbeat {
+    const tensorflow::HeartbeatRequest* request;
+    tensorflow::HeartbeatResponse* response;
+    StatusCallback done;
+  };
+
+  struct PendingBarrier {
+    int64_t timeout_ms = 0;
+    std::vector<tensorflow::CoordinatedTask> tasks;
+    // Names of the tasks of the subtree that are still expected.
+    absl::flat_hash_set<std::string> waiting_for;
+    // Arrivals that have not been forwarded yet, and their callbacks.
+    std::vector<tensorflow::CoordinatedTask> arrived;
+    std::vector<StatusCallback> callbacks;
+    bool timer_scheduled = false;
+    // Set once half of the timeout has passed. Arrivals are then forwarded
+    // immediately.
+    bool deadline_passed = false;
+  };
+
+  // Arrivals at a barrier that are forwarded in one request.
+  struct BarrierBatch {
+    int64_t timeout_ms = 0;
+    std::vector<tensorflow::CoordinatedTask> tasks;
+    std::vector<tensorflow::CoordinatedTask> arrived;
+    std::vector<StatusCallback> callbacks;
+  };
+
+  struct PendingRead {
+    tensorflow::GetKeyValueResponse* response;
+    StatusCallback done;
+  };
+
+  CoordinationServiceAggregator(
+      Env* env, const tensorflow::CoordinationServiceConfig& config,
+      const tensorflow::CoordinatedTask& task,
+      std::unique_ptr<CoordinationClient> upstream_client);
+
+  void SendHeartbeats(std::vector<PendingHeartbeat> batch);
+  // Returns the arrivals at `barrier` that should be forwarded now, if any.
+  std::optional<BarrierBatch> TakeBarrierBatch(const std::string& barrier_id,
+                                               PendingBarrier* barrier)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void SendBarrier(const std::string& barrier_id, BarrierBatch batch);
+  void OnBarrierDeadline(const std::string& barrier_id);
+  void OnBarrierDone(const std::string& barrier_id, const absl::Status& status);
+
+  Env* const env_;
+  const tensorflow::CoordinationServiceConfig config_;
+  const tensorflow::CoordinatedTask task_;
+  const std::unique_ptr<CoordinationClient> upstream_client_;
+  // Names of the tasks in the subtree of `task_`, excluding `task_`.
+  const absl::flat_hash_set<std::string> subtree_;
+
+  absl::Mutex mu_;
+  std::vector<PendingHeartbeat> pending_heartbeats_ ABSL_GUARDED_BY(mu_);
+  bool heartbeat_in_flight_ ABSL_GUARDED_BY(mu_) = false;
+  absl::flat_hash_map<std::string, PendingBarrier> barriers_
+      ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string, std::vector<PendingRead>> reads_
+      ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace tsl
+
+#endif  // XLA_TSL_DISTRIBUTED_RUNTIME_COORDINATION_COORDINATION_SERVICE_AGGREGATOR_H_
@@ -0,0 +1,381 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "xla/tsl/distributed_runtime/coordination/coordination_service_aggregator.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xla/tsl/distributed_runtime/call_options.h"
+#include "xla/tsl/distributed_runtime/coordination/coordination_client.h"
+#include "xla/tsl/distributed_runtime/coordination/coordination_service_error_util.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/protobuf.h"
+#include "tsl/platform/status.h"
+#include "tsl/platform/test.h"
+#include "tsl/protobuf/coordination_config.pb.h"
+#include "tsl/protobuf/coordination_service.pb.h"
+
+namespace tsl {
+namespace {
+using tensorflow::CoordinatedTask;
+using tensorflow::CoordinationServiceConfig;
+
+CoordinatedTask Task(int task_id) {
+  CoordinatedTask task;
+  task.set_job_name("worker");
+  task.set_task_id(task_id);
+  return task;
+}
+
+std::vector<int> TaskIds(const std::vector<CoordinatedTask>& tasks) {
+  std::vector<int> ids;
+  for (const CoordinatedTask& task : tasks) ids.push_back(task.task_id());
+  return ids;
+}
+
+// Returns the config of a job of `num_tasks` workers led by worker 0.
+CoordinationServiceConfig Config(int num_tasks, int fanout) {
+  CoordinationServiceConfig config;
+  config.set_service_type("standalone");
+  config.set_service_leader("/job:worker/replica:0/task:0");
+  config.set_hierarchical_fanout(fanout);
+  auto* job = config.add_coordinated_job_list();
+  job->set_name("worker");
+  job->set_num_tasks(num_tasks);
+  return config;
+}
+
+// Records the requests forwarded by the aggregator, which the test completes
+// explicitly.
+class FakeUpstreamClient : public CoordinationClient {
+ public:
+  struct Call {
+    const tsl::protobuf::Message* request;
+    tsl::protobuf::Message* response;
+    StatusCallback done;
+  };
+
+  std::vector<Call> barriers() {
+    absl::MutexLock l(&mu_);
+    return barriers_;
+  }
+  std::vector<Call> heartbeats() {
+    absl::MutexLock l(&mu_);
+    return heartbeats_;
+  }
+  std::vector<Call> reads() {
+    absl::MutexLock l(&mu_);
+    return reads_;
+  }
+
+  void HeartbeatAsync(CallOptions*, const HeartbeatRequest* request,
+                      HeartbeatResponse* response,
+                      StatusCallback done) override {
+    absl::MutexLock l(&mu_);
+    heartbeats_.push_back({request, response, std::move(done)});
+  }
+  void BarrierAsync(const BarrierRequest* request, BarrierResponse* response,
+                    StatusCallback done) override {
+    absl::MutexLock l(&mu_);
+    barriers_.push_back({request, response, std::move(done)});
+  }
+  void GetKeyValueAsync(CallOptions*, const GetKeyValueRequest* request,
+                        GetKeyValueResponse* response,
+                        StatusCallback done) override {
+    absl::MutexLock l(&mu_);
+    reads_.push_back({request, response, std::move(done)});
+  }
+
+  void RegisterTaskAsync(CallOptions*, const RegisterTaskRequest*,
+                         RegisterTaskResponse*, StatusCallback done) override {
+    done(absl::UnimplementedError("RegisterTaskAsync"));
+  }
+  void WaitForAllTasksAsync(const WaitForAllTasksRequest*,
+                            WaitForAllTasksResponse*,
+                            StatusCallback done) override {
+    done(absl::UnimplementedError("WaitForAllTasksAsync"));
+  }
+  void ShutdownTaskAsync(CallOptions*, const ShutdownTaskRequest*,
+                         ShutdownTaskResponse*, StatusCallback done) override {
+    done(absl::UnimplementedError("ShutdownTaskAsync"));
+  }
+  void ResetTaskAsync(const ResetTaskRequest*, ResetTaskResponse*,
+                      StatusCallback done) override {
+    done(absl::UnimplementedError("ResetTaskAsync"));
+  }
+  void ReportErrorToTaskAsync(CallOptions*, const ReportErrorToTaskRequest*,
+                              ReportErrorToTaskResponse*,
+                              StatusCallback done) override {
+    done(absl::UnimplementedError("ReportErrorToTaskAsync"));
+  }
+  void ReportErrorToServiceAsync(const ReportErrorToServiceRequest*,
+                                 ReportErrorToServiceResponse*,
+                                 StatusCallback done) override {
+    done(absl::UnimplementedError("ReportErrorToServiceAsync"));
+  }
+  void GetTaskStateAsync(const GetTaskStateRequest*, GetTaskStateResponse*,
+                         StatusCallback done) override {
+    done(absl::UnimplementedError("GetTaskStateAsync"));
+  }
+  void InsertKeyValueAsync(const InsertKeyValueRequest*,
+                           InsertKeyValueResponse*,
+                           StatusCallback done) override {
+    done(absl::UnimplementedError("InsertKeyValueAsync"));
+  }
+  void TryGetKeyValueAsync(const TryGetKeyValueRequest*,
+                           TryGetKeyValueResponse*,
+                           StatusCallback done) override {
+    done(absl::UnimplementedError("TryGetKeyValueAsync"));
+  }
+  void GetKeyValueDirAsync(const GetKeyValueDirRequest*,
+                           GetKeyValueDirResponse*,
+                           StatusCallback done) override {
+    done(absl::UnimplementedError("GetKeyValueDirAsync"));
+  }
+  void DeleteKeyValueAsync(const DeleteKeyValueRequest*,
+                           DeleteKeyValueResponse*,
+                           StatusCallback done) override {
+    done(absl::UnimplementedError("DeleteKeyValueAsync"));
+  }
+  void CancelBarrierAsync(const CancelBarrierRequest*, CancelBarrierResponse*,
+                          StatusCallback done) override {
+    done(absl::UnimplementedError("CancelBarrierAsync"));
+  }
+  void PollForErrorAsync(CallOptions*, const PollForErrorRequest*,
+                         PollForErrorResponse*, StatusCallback done) override {
+    done(absl::UnimplementedError("PollForErrorAsync"));
+  }
+
+ private:
+  absl::Mutex mu_;
+  std::vector<Call> barriers_ ABSL_GUARDED_BY(mu_);
+  std::vector<Call> heartbeats_ ABSL_GUARDED_BY(mu_);
+  std::vector<Call> reads_ ABSL_GUARDED_BY(mu_);
+};
+
+TEST(CoordinationHierarchyTest, ParentsAndSubtrees) {
+  const CoordinationServiceConfig config = Config(/*num_tasks=*/7,
+                                                  /*fanout=*/2);
+  EXPECT_TRUE(IsHierarchicalCoordination(config));
+  EXPECT_EQ(TaskIds(GetCoordinationHierarchy(config)),
+            std::vector<int>({0, 1, 2, 3, 4, 5, 6}));
+
+  EXPECT_EQ(GetCoordinationParent(config, Task(0)), std::nullopt);
+  EXPECT_EQ(GetCoordinationParent(config, Task(2))->task_id(), 0);
+  EXPECT_EQ(GetCoordinationParent(config, Task(4))->task_id(), 1);
+  EXPECT_EQ(GetCoordinationParent(config, Task(5))->task_id(), 2);
+
+  EXPECT_EQ(TaskIds(GetCoordinationSubtree(config, Task(0))),
+            std::vector<int>({1, 2, 3, 4, 5, 6}));
+  EXPECT_EQ(TaskIds(GetCoordinationSubtree(config, Task(1))),
+            std::vector<int>({3, 4}));
+  EXPECT_TRUE(GetCoordinationSubtree(config, Task(6)).empty());
+}
+
+TEST(CoordinationHierarchyTest, LeaderIsTheRoot) {
+  CoordinationServiceConfig config = Config(/*num_tasks=*/4, /*fanout=*/2);
+  config.set_service_leader("/job:worker/replica:0/task:2");
+  EXPECT_EQ(TaskIds(GetCoordinationHierarchy(config)),
+            std::vector<int>({2, 0, 1, 3}));
+  EXPECT_EQ(GetCoordinationParent(config, Task(3))->task_id(), 0);
+}
+
+TEST(CoordinationHierarchyTest, DisabledWithoutFanout) {
+  const CoordinationServiceConfig config = Config(/*num_tasks=*/4,
+                                                  /*fanout=*/0);
+  EXPECT_FALSE(IsHierarchicalCoordination(config));
+  EXPECT_EQ(GetCoordinationParent(config, Task(3)), std::nullopt);
+  EXPECT_TRUE(GetCoordinationSubtree(config, Task(0)).empty());
+}
+
+TEST(CoordinationHierarchyTest, HeartbeatResultRoundTrip) {
+  const absl::Status error = MakeCoordinationError(
+      absl::AbortedError("Incarnation mismatch"), Task(3));
+  const absl::Status status =
+      StatusFromHeartbeatResult(HeartbeatResultFromStatus(Task(3), error));
+  EXPECT_EQ(status, error);
+  TF_EXPECT_OK(StatusFromHeartbeatResult(
+      HeartbeatResultFromStatus(Task(3), absl::OkStatus())));
+}
+
+class CoordinationServiceAggregatorTest : public ::testing::Test {
+ protected:
+  CoordinationServiceAggregatorTest() {
+    auto upstream = std::make_unique<FakeUpstreamClient>();
+    upstream_ = upstream.get();
+    // Worker 1 aggregates the requests of workers 3 and 4.
+    aggregator_ = CoordinationServiceAggregator::Create(
+        Env::Default(), Config(/*num_tasks=*/7, /*fanout=*/2), Task(1),
+        std::move(upstream));
+  }
+
+  tensorflow::BarrierRequest BarrierFrom(int task_id, int64_t timeout_ms) {
+    tensorflow::BarrierRequest request;
+    request.set_barrier_id("barrier");
+    request.set_barrier_timeout_in_ms(timeout_ms);
+    *request.mutable_source_task() = Task(task_id);
+    return request;
+  }
+
+  FakeUpstreamClient* upstream_;
+  std::shared_ptr<CoordinationServiceAggregator> aggregator_;
+};
+
+TEST_F(CoordinationServiceAggregatorTest, BarrierWaitsForSubtree) {
+  const tensorflow::BarrierRequest request3 = BarrierFrom(3, 60 * 1000);
+  const tensorflow::BarrierRequest request4 = BarrierFrom(4, 60 * 1000);
+  tensorflow::BarrierResponse response3, response4;
+  std::optional<absl::Status> status3, status4;
+  aggregator_->BarrierAsync(&request3, &response3,
+                            [&](const absl::Status& s) { status3 = s; });
+  EXPECT_TRUE(upstream_->barriers().empty());
+  aggregator_->BarrierAsync(&request4, &response4,
+                            [&](const absl::Status& s) { status4 = s; });
+
+  std::vector<FakeUpstreamClient::Call> calls = upstream_->barriers();
+  ASSERT_EQ(calls.size(), 1);
+  const auto* forwarded =
+      static_cast<const tensorflow::BarrierRequest*>(calls[0].request);
+  EXPECT_EQ(forwarded->barrier_id(), "barrier");
+  EXPECT_EQ(forwarded->source_task().task_id(), 1);
+  EXPECT_EQ(TaskIds({forwarded->aggregated_source_tasks().begin(),
+                     forwarded->aggregated_source_tasks().end()}),
+            std::vector<int>({3, 4}));
+  EXPECT_FALSE(status3.has_value());
+
+  calls[0].done(absl::OkStatus());
+  ASSERT_TRUE(status3.has_value());
+  ASSERT_TRUE(status4.has_value());
+  TF_EXPECT_OK(*status3);
+  TF_EXPECT_OK(*status4);
+}
+
+TEST_F(CoordinationServiceAggregatorTest, BarrierForwardsStragglersLate) {
+  const tensorflow::BarrierRequest request3 = BarrierFrom(3, 200);
+  const tensorflow::BarrierRequest request4 = BarrierFrom(4, 200);
+  tensorflow::BarrierResponse response3, response4;
+  absl::Mutex mu;
+  std::vector<absl::Status> statuses;
+  auto done = [&](const absl::Status& s) {
+    absl::MutexLock l(&mu);
+    statuses.push_back(s);
+  };
+  aggregator_->BarrierAsync(&request3, &response3, done);
+  // Worker 3 is forwarded on its own once half of the timeout has passed.
+  for (int i = 0; i < 100 && upstream_->barriers().empty(); ++i) {
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  ASSERT_EQ(upstream_->barriers().size(), 1);
+  // Later arrivals are forwarded immediately.
+  aggregator_->BarrierAsync(&request4, &response4, done);
+  std::vector<FakeUpstreamClient::Call> calls = upstream_->barriers();
+  ASSERT_EQ(calls.size(), 2);
+  EXPECT_EQ(static_cast<const tensorflow::BarrierRequest*>(calls[1].request)
+                ->aggregated_source_tasks(0)
+                .task_id(),
+            4);
+
+  const absl::Status timeout = MakeCoordinationError(
+      absl::DeadlineExceededError("Barrier timed out"));
+  calls[0].done(timeout);
+  calls[1].done(timeout);
+  absl::MutexLock l(&mu);
+  EXPECT_EQ(statuses, std::vector<absl::Status>({timeout, timeout}));
+}
+
+TEST_F(CoordinationServiceAggregatorTest, HeartbeatsAreBatched) {
+  tensorflow::HeartbeatRequest request3, request4;
+  *request3.mutable_source_task() = Task(3);
+  request3.set_incarnation(33);
+  *request4.mutable_source_task() = Task(4);
+  request4.set_incarnation(44);
+  tensorflow::HeartbeatResponse response3, response4;
+  std::optional<absl::Status> status3, status4;
+  aggregator_->HeartbeatAsync(&request3, &response3,
+                              [&](const absl::Status& s) { status3 = s; });
+  // Worker 4 waits for the heartbeat in flight.
+  aggregator_->HeartbeatAsync(&request4, &response4,
+                              [&](const absl::Status& s) { status4 = s; });
+  std::vector<FakeUpstreamClient::Call> calls = upstream_->heartbeats();
+  ASSERT_EQ(calls.size(), 1);
+  const auto* forwarded =
+      static_cast<const tensorflow::HeartbeatRequest*>(calls[0].request);
+  ASSERT_EQ(forwarded->aggregated_heartbeats_size(), 1);
+  EXPECT_EQ(forwarded->aggregated_heartbeats(0).incarnation(), 33);
+
+  auto* response =
+      static_cast<tensorflow::HeartbeatResponse*>(calls[0].response);
+  response->set_leader_incarnation(7);
+  *response->add_aggregated_results() =
+      HeartbeatResultFromStatus(Task(3), absl::OkStatus());
+  calls[0].done(absl::OkStatus());
+  ASSERT_TRUE(status3.has_value());
+  TF_EXPECT_OK(*status3);
+  EXPECT_EQ(response3.leader_incarnation(), 7);
+
+  calls = upstream_->heartbeats();
+  ASSERT_EQ(calls.size(), 2);
+  forwarded =
+      static_cast<const tensorflow::HeartbeatRequest*>(calls[1].request);
+  ASSERT_EQ(forwarded->aggregated_heartbeats_size(), 1);
+  EXPECT_EQ(forwarded->aggregated_heartbeats(0).incarnation(), 44);
+  const absl::Status error =
+      MakeCoordinationError(absl::AbortedError("Incarnation mismatch"));
+  response = static_cast<tensorflow::HeartbeatResponse*>(calls[1].response);
+  *response->add_aggregated_results() =
+      HeartbeatResultFromStatus(Task(4), error);
+  calls[1].done(absl::OkStatus());
+  ASSERT_TRUE(status4.has_value());
+  EXPECT_EQ(*status4, error);
+}
+
+TEST_F(CoordinationServiceAggregatorTest, ConcurrentReadsShareOneRequest) {
+  tensorflow::GetKeyValueRequest request;
+  request.set_key("key");
+  tensorflow::GetKeyValueResponse response3, response4;
+  int num_done = 0;
+  auto done = [&](const absl::Status& s) {
+    TF_EXPECT_OK(s);
+    ++num_done;
+  };
+  aggregator_->GetKeyValueAsync(&request, &response3, done);
+  aggregator_->GetKeyValueAsync(&request, &response4, done);
+  std::vector<FakeUpstreamClient::Call> calls = upstream_->reads();
+  ASSERT_EQ(calls.size(), 1);
+
+  static_cast<tensorflow::GetKeyValueResponse*>(calls[0].response)
+      ->mutable_kv()
+      ->set_value("value");
+  calls[0].done(absl::OkStatus());
+  EXPECT_EQ(num_done, 2);
+  EXPECT_EQ(response3.kv().value(), "value");
+  EXPECT_EQ(response4.kv().key(), "key");
+  EXPECT_EQ(response4.kv().value(), "value");
+
+  // A read after the first one completed is sent again.
+  aggregator_->GetKeyValueAsync(&request, &response3, done);
+  EXPECT_EQ(upstream_->reads().size(), 2);
+}
+
+}  // namespace
+}  // namespace tsl
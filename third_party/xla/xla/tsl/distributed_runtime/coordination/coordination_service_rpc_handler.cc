@@ -28,6 +28,7 @@ limitations under the License.
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "xla/tsl/distributed_runtime/coordination/coordination_service.h"
+#include "xla/tsl/distributed_runtime/coordination/coordination_service_aggregator.h"
 #include "xla/tsl/distributed_runtime/coordination/coordination_service_agent.h"
 #include "xla/tsl/distributed_runtime/coordination/coordination_service_error_util.h"
 #include "tsl/platform/protobuf.h"
@@ -39,6 +40,15 @@ namespace {
 using tensorflow::CoordinatedTask;
 using tensorflow::CoordinationServiceError;
 using tensorflow::KeyValueEntry;
+
+// Returned by tasks that receive requests meant for an aggregator before it
+// is set up. This is not a coordination error, so that agents retry the
+// request with the leader.
+absl::Status AggregatorNotEnabledError() {
+  return absl::UnavailableError(
+      "Coordination service is not enabled and this task does not aggregate "
+      "requests.");
+}
 }  // namespace
 
 void CoordinationServiceRpcHandler::SetAgentInstance(
@@ -53,6 +63,12 @@ void CoordinationServiceRpcHandler::SetServiceInstance(
   service_ = service;
 }
 
+void CoordinationServiceRpcHandler::SetAggregatorInstance(
+    CoordinationServiceAggregator* aggregator) {
+  absl::MutexLock l(&mu_);
+  aggregator_ = aggregator;
+}
+
 void CoordinationServiceRpcHandler::RegisterTaskAsync(
     const tensorflow::RegisterTaskRequest* request,
     tensorflow::RegisterTaskResponse* response, StatusCallback done) {
@@ -74,13 +90,27 @@ void CoordinationServiceRpcHandler::HeartbeatAsync(
     tensorflow::HeartbeatResponse* response, StatusCallback done) {
   absl::ReaderMutexLock l(&mu_);
   if (service_ == nullptr) {
-    done(MakeCoordinationError(
-        absl::InternalError("Coordination service is not enabled.")));
+    if (aggregator_ != nullptr) {
+      aggregator_->HeartbeatAsync(request, response, std::move(done));
+    } else {
+      done(AggregatorNotEnabledError());
+    }
+    return;
+  }
+  const uint64_t leader_incarnation = service_->GetServiceIncarnation();
+  if (request->aggregated_heartbeats_size() > 0) {
+    for (const auto& heartbeat : request->aggregated_heartbeats()) {
+      *response->add_aggregated_results() = HeartbeatResultFromStatus(
+          heartbeat.source_task(),
+          service_->RecordHeartbeat(heartbeat.source_task(),
+                                    heartbeat.incarnation()));
+    }
+    response->set_leader_incarnation(leader_incarnation);
+    done(absl::OkStatus());
     return;
   }
   const CoordinatedTask& task = request->source_task();
   const uint64_t incarnation = request->incarnation();
-  const uint64_t leader_incarnation = service_->GetServiceIncarnation();
   absl::Status s = service_->RecordHeartbeat(task, incarnation);
   if (!s.ok()) {
     done(s);
@@ -207,8 +237,11 @@ void CoordinationServiceRpcHandler::GetKeyValueAsync(
     tensorflow::GetKeyValueResponse* response, StatusCallback done) {
   absl::ReaderMutexLock l(&mu_);
   if (service_ == nullptr) {
-    done(MakeCoordinationError(
-        absl::InternalError("Coordination service is not enabled.")));
+    if (aggregator_ != nullptr) {
+      aggregator_->GetKeyValueAsync(request, response, std::move(done));
+    } else {
+      done(AggregatorNotEnabledError());
+    }
     return;
   }
   response->mutable_kv()->set_key(request->key());
@@ -276,12 +309,44 @@ void CoordinationServiceRpcHandler::BarrierAsync(
     tensorflow::BarrierResponse* response, StatusCallback done) {
   absl::ReaderMutexLock l(&mu_);
   if (service_ == nullptr) {
-    done(MakeCoordinationError(
-        absl::InternalError("Coordination service is not enabled.")));
+    if (aggregator_ != nullptr) {
+      aggregator_->BarrierAsync(request, response, std::move(done));
+    } else {
+      done(AggregatorNotEnabledError());
+    }
     return;
   }
   std::vector<CoordinatedTask> tasks = {request->tasks().begin(),
                                         request->tasks().end()};
+  if (request->aggregated_source_tasks_size() > 0) {
+    // Record every forwarded arrival, and respond once the barrier has
+    // released all of them.
+    struct AggregatedBarrier {
+      absl::Mutex mu;
+      int pending ABSL_GUARDED_BY(mu);
+      absl::Status status ABSL_GUARDED_BY(mu);
+      StatusCallback done;
+    };
+    auto aggregated = std::make_shared<AggregatedBarrier>();
+    aggregated->pending = request->aggregated_source_tasks_size();
+    aggregated->done = std::move(done);
+    for (const CoordinatedTask& task : request->aggregated_source_tasks()) {
+      service_->BarrierAsync(
+          request->barrier_id(),
+          absl::Milliseconds(request->barrier_timeout_in_ms()), task, tasks,
+          [aggregated](const absl::Status& status) {
+            absl::Status result;
+            {
+              absl::MutexLock l(&aggregated->mu);
+              aggregated->status.Update(status);
+              if (--aggregated->pending > 0) return;
+              result = aggregated->status;
+            }
+            aggregated->done(result);
+          });
+    }
+    return;
+  }
   service_->BarrierAsync(
       request->barrier_id(),
       absl::Milliseconds(request->barrier_timeout_in_ms()),
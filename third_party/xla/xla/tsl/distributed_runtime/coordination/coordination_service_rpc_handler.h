@@ -19,6 +19,7 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
 #include "xla/tsl/distributed_runtime/coordination/coordination_service.h"
+#include "xla/tsl/distributed_runtime/coordination/coordination_service_aggregator.h"
 #include "xla/tsl/distributed_runtime/coordination/coordination_service_agent.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/thread_annotations.h"
@@ -33,6 +34,10 @@ class CoordinationServiceRpcHandler {
 
   void SetServiceInstance(CoordinationServiceInterface* service);
 
+  // Sets the aggregator that handles barrier, heartbeat and blocking
+  // key-value requests on tasks other than the leader in hierarchical mode.
+  void SetAggregatorInstance(CoordinationServiceAggregator* aggregator);
+
   void RegisterTaskAsync(const tensorflow::RegisterTaskRequest* request,
                          tensorflow::RegisterTaskResponse* response,
                          StatusCallback done);
@@ -100,6 +105,7 @@ class CoordinationServiceRpcHandler {
   absl::Mutex mu_;
   CoordinationServiceAgent* agent_ TF_GUARDED_BY(mu_) = nullptr;
   CoordinationServiceInterface* service_ TF_GUARDED_BY(mu_) = nullptr;
+  CoordinationServiceAggregator* aggregator_ TF_GUARDED_BY(mu_) = nullptr;
 };
 
 }  // namespace tsl
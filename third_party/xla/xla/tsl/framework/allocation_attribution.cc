@@ -0,0 +1,170 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/tsl/framework/allocation_attribution.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "tsl/platform/mutex.h"
+#include "tsl/profiler/lib/scoped_memory_debug_annotation.h"
+
+namespace tsl {
+namespace {
+
+mutex registry_mu(LINKER_INITIALIZED);
+
+std::vector<AllocationAttribution*>& Registry()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(registry_mu) {
+  static auto* registry = new std::vector<AllocationAttribution*>();
+  return *registry;
+}
+
+}  // namespace
+
+AllocationAttribution::AllocationAttribution(std::string allocator_name,
+                                             const Options& options)
+    : allocator_name_(std::move(allocator_name)), options_(options) {
+  mutex_lock lock(registry_mu);
+  Registry().push_back(this);
+}
+
+AllocationAttribution::~AllocationAttribution() {
+  mutex_lock lock(registry_mu);
+  auto& registry = Registry();
+  registry.erase(std::find(registry.begin(), registry.end(), this));
+}
+
+/*static*/ bool AllocationAttribution::EnabledByEnv() {
+  static const bool enabled = [] {
+    const char* value = std::getenv("TF_ALLOCATION_ATTRIBUTION");
+    bool result = false;
+    return value != nullptr && absl::SimpleAtob(value, &result) && result;
+  }();
+  return enabled;
+}
+
+int AllocationAttribution::CurrentOp() {
+  const char* op_name = profiler::ScopedMemoryDebugAnnotation::
+      CurrentAnnotation().pending_op_name;
+  absl::string_view name = op_name != nullptr ? op_name : kUnknownOp;
+  auto it = op_indices_.find(name);
+  if (it != op_indices_.end()) return it->second;
+  if (op_names_.size() >= static_cast<size_t>(options_.max_ops)) {
+    name = kOtherOps;
+    it = op_indices_.find(name);
+    if (it != op_indices_.end()) return it->second;
+  }
+  const int op = op_names_.size();
+  op_indices_.emplace(name, op);
+  op_names_.emplace_back(name);
+  op_stats_.emplace_back();
+  op_updated_at_.push_back(0);
+  return op;
+}
+
+void AllocationAttribution::Update(int op, int64_t bytes) {
+  ++num_updates_;
+  OpStats& stats = op_stats_[op];
+  // The live bytes of the op didn't change since the last peak, so they are
+  // the bytes at that peak. See GetSnapshot().
+  if (op_updated_at_[op] <= peak_at_) stats.bytes_at_peak = stats.live_bytes;
+  stats.live_bytes += bytes;
+  stats.peak_live_bytes = std::max(stats.peak_live_bytes, stats.live_bytes);
+  op_updated_at_[op] = num_updates_;
+
+  bytes_in_use_ += bytes;
+  if (bytes_in_use_ > peak_bytes_in_use_) {
+    peak_bytes_in_use_ = bytes_in_use_;
+    peak_at_ = num_updates_;
+  }
+
+  bytes_since_sample_ += std::abs(bytes);
+  if (bytes_since_sample_ >= options_.sample_interval_bytes) {
+    bytes_since_sample_ %= options_.sample_interval_bytes;
+    const auto& annotation =
+        profiler::ScopedMemoryDebugAnnotation::CurrentAnnotation();
+    Sample sample;
+    sample.time_ns = absl::GetCurrentTimeNanos();
+    sample.bytes_in_use = bytes_in_use_;
+    sample.bytes = bytes;
+    sample.op_name = op_names_[op];
+    sample.step_id = annotation.pending_step_id;
+    timeline_.push_back(std::move(sample));
+    while (timeline_.size() > static_cast<size_t>(options_.max_samples)) {
+      timeline_.pop_front();
+    }
+  }
+}
+
+void AllocationAttribution::RecordAllocation(const void* ptr, int64_t bytes) {
+  mutex_lock lock(mu_);
+  const int op = CurrentOp();
+  OpStats& stats = op_stats_[op];
+  ++stats.num_allocs;
+  stats.total_bytes += bytes;
+  live_[ptr] = {op, bytes};
+  Update(op, bytes);
+}
+
+void AllocationAttribution::RecordDeallocation(const void* ptr) {
+  mutex_lock lock(mu_);
+  auto it = live_.find(ptr);
+  if (it == live_.end()) return;
+  const auto [op, bytes] = it->second;
+  live_.erase(it);
+  Update(op, -bytes);
+}
+
+AllocationAttribution::Snapshot AllocationAttribution::GetSnapshot() const {
+  Snapshot snapshot;
+  snapshot.allocator_name = allocator_name_;
+  mutex_lock lock(mu_);
+  snapshot.bytes_in_use = bytes_in_use_;
+  snapshot.peak_bytes_in_use = peak_bytes_in_use_;
+  snapshot.ops.reserve(op_names_.size());
+  for (int op = 0; op < static_cast<int>(op_names_.size()); ++op) {
+    OpStats stats = op_stats_[op];
+    if (op_updated_at_[op] <= peak_at_) stats.bytes_at_peak = stats.live_bytes;
+    snapshot.ops.emplace_back(op_names_[op], stats);
+  }
+  std::sort(snapshot.ops.begin(), snapshot.ops.end(),
+            [](const auto& a, const auto& b) {
+              return a.second.bytes_at_peak != b.second.bytes_at_peak
+                         ? a.second.bytes_at_peak > b.second.bytes_at_peak
+                         : a.first < b.first;
+            });
+  snapshot.timeline.assign(timeline_.begin(), timeline_.end());
+  return snapshot;
+}
+
+/*static*/ std::vector<AllocationAttribution::Snapshot>
+AllocationAttribution::GetAllSnapshots() {
+  std::vector<Snapshot> snapshots;
+  mutex_lock lock(registry_mu);
+  for (const AllocationAttribution* attribution : Registry()) {
+    snapshots.push_back(attribution->GetSnapshot());
+  }
+  return snapshots;
+}
+
+}  // namespace tsl
@@ -0,0 +1,136 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_TSL_FRAMEWORK_ALLOCATION_ATTRIBUTION_H_
+#define XLA_TSL_FRAMEWORK_ALLOCATION_ATTRIBUTION_H_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tsl/platform/mutex.h"
+#include "tsl/platform/thread_annotations.h"
+
+namespace tsl {
+
+// Attributes the live bytes of an allocator to the ops that allocated them,
+// as given by ScopedMemoryDebugAnnotation, and keeps a sampled timeline of
+// the bytes in use.
+//
+// Unlike the per-allocation TraceMes of the allocators, which are only
+// recorded during profiling sessions, this is cheap enough to stay enabled:
+// each allocation costs a hash map insertion and an op name lookup, and the
+// memory used is bounded by the number of live allocations, `max_ops` and
+// `max_samples`. It is enabled for the BFC and CPU allocators by setting the
+// TF_ALLOCATION_ATTRIBUTION environment variable to true.
+class AllocationAttribution {
+ public:
+  struct Options {
+    // A sample is added to the timeline each time this many bytes were
+    // allocated or deallocated since the previous one.
+    int64_t sample_interval_bytes = 1 << 20;
+    // The number of most recent samples that are kept.
+    int max_samples = 4096;
+    // The maximum number of distinct op names. The allocations of other ops
+    // are attributed to kOtherOps.
+    int max_ops = 4096;
+  };
+
+  static constexpr char kUnknownOp[] = "(unknown)";
+  static constexpr char kOtherOps[] = "(other)";
+
+  struct OpStats {
+    int64_t live_bytes = 0;
+    int64_t peak_live_bytes = 0;
+    // The live bytes of the op when the allocator reached its peak.
+    int64_t bytes_at_peak = 0;
+    int64_t num_allocs = 0;
+    int64_t total_bytes = 0;
+  };
+
+  struct Sample {
+    // In ns since the Unix epoch, like the timestamps of TraceMes.
+    int64_t time_ns = 0;
+    int64_t bytes_in_use = 0;
+    // The allocation or, if negative, the deallocation that was sampled.
+    int64_t bytes = 0;
+    std::string op_name;
+    int64_t step_id = 0;
+  };
+
+  struct Snapshot {
+    std::string allocator_name;
+    int64_t bytes_in_use = 0;
+    int64_t peak_bytes_in_use = 0;
+    // Statistics per op, by decreasing bytes at peak.
+    std::vector<std::pair<std::string, OpStats>> ops;
+    // The most recent samples, oldest first.
+    std::vector<Sample> timeline;
+  };
+
+  AllocationAttribution(std::string allocator_name, const Options& options);
+  ~AllocationAttribution();
+
+  AllocationAttribution(const AllocationAttribution&) = delete;
+  AllocationAttribution& operator=(const AllocationAttribution&) = delete;
+
+  // Returns true if the TF_ALLOCATION_ATTRIBUTION environment variable
+  // enables the attribution of the allocators.
+  static bool EnabledByEnv();
+
+  // Records the allocation of `bytes` at `ptr` by the current op.
+  void RecordAllocation(const void* ptr, int64_t bytes);
+  // Records the deallocation of `ptr`. Ignores pointers whose allocation was
+  // not recorded.
+  void RecordDeallocation(const void* ptr);
+
+  Snapshot GetSnapshot() const;
+
+  // Returns the snapshots of all the existing AllocationAttributions.
+  static std::vector<Snapshot> GetAllSnapshots();
+
+ private:
+  // Returns the index of the stats of the current op in `op_stats_`.
+  int CurrentOp() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Updates the live bytes of an op and the allocator by `bytes`.
+  void Update(int op, int64_t bytes) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::string allocator_name_;
+  const Options options_;
+
+  mutable mutex mu_;
+  absl::flat_hash_map<std::string, int> op_indices_ TF_GUARDED_BY(mu_);
+  std::vector<std::string> op_names_ TF_GUARDED_BY(mu_);
+  std::vector<OpStats> op_stats_ TF_GUARDED_BY(mu_);
+  // The number of updates at which each op was last updated.
+  std::vector<int64_t> op_updated_at_ TF_GUARDED_BY(mu_);
+  // The op and size of each live allocation.
+  absl::flat_hash_map<const void*, std::pair<int, int64_t>> live_
+      TF_GUARDED_BY(mu_);
+  int64_t num_updates_ TF_GUARDED_BY(mu_) = 0;
+  // The number of updates at which the allocator reached its peak.
+  int64_t peak_at_ TF_GUARDED_BY(mu_) = 0;
+  int64_t bytes_in_use_ TF_GUARDED_BY(mu_) = 0;
+  int64_t peak_bytes_in_use_ TF_GUARDED_BY(mu_) = 0;
+  int64_t bytes_since_sample_ TF_GUARDED_BY(mu_) = 0;
+  std::deque<Sample> timeline_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace tsl
+
+#endif  // XLA_TSL_FRAMEWORK_ALLOCATION_ATTRIBUTION_H_
@@ -0,0 +1,173 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/tsl/framework/allocation_attribution.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tsl/platform/test.h"
+#include "tsl/profiler/lib/scoped_memory_debug_annotation.h"
+
+namespace tsl {
+namespace {
+
+using profiler::ScopedMemoryDebugAnnotation;
+
+const void* Ptr(uintptr_t address) {
+  return reinterpret_cast<const void*>(address);
+}
+
+AllocationAttribution::OpStats StatsOf(
+    const AllocationAttribution::Snapshot& snapshot,
+    const std::string& op_name) {
+  for (const auto& [name, stats] : snapshot.ops) {
+    if (name == op_name) return stats;
+  }
+  ADD_FAILURE() << "No stats for " << op_name;
+  return {};
+}
+
+TEST(AllocationAttributionTest, AttributesLiveBytesToOps) {
+  AllocationAttribution attribution("test", {});
+  {
+    ScopedMemoryDebugAnnotation annotation("a");
+    attribution.RecordAllocation(Ptr(1), 100);
+    attribution.RecordAllocation(Ptr(2), 20);
+  }
+  {
+    ScopedMemoryDebugAnnotation annotation("b");
+    attribution.RecordAllocation(Ptr(3), 50);
+    // Deallocations are attributed to the op that allocated.
+    attribution.RecordDeallocation(Ptr(2));
+  }
+  attribution.RecordAllocation(Ptr(4), 1);
+  // Unknown pointers are ignored.
+  attribution.RecordDeallocation(Ptr(5));
+
+  const auto snapshot = attribution.GetSnapshot();
+  EXPECT_EQ(snapshot.allocator_name, "test");
+  EXPECT_EQ(snapshot.bytes_in_use, 151);
+  EXPECT_EQ(snapshot.peak_bytes_in_use, 170);
+  ASSERT_EQ(snapshot.ops.size(), 3);
+  EXPECT_EQ(snapshot.ops[0].first, "a");
+  EXPECT_EQ(snapshot.ops[1].first, "b");
+  EXPECT_EQ(snapshot.ops[2].first, AllocationAttribution::kUnknownOp);
+
+  const auto a = StatsOf(snapshot, "a");
+  EXPECT_EQ(a.live_bytes, 100);
+  EXPECT_EQ(a.peak_live_bytes, 120);
+  EXPECT_EQ(a.num_allocs, 2);
+  EXPECT_EQ(a.total_bytes, 120);
+  EXPECT_EQ(StatsOf(snapshot, "b").live_bytes, 50);
+  EXPECT_EQ(StatsOf(snapshot, AllocationAttribution::kUnknownOp).live_bytes,
+            1);
+}
+
+TEST(AllocationAttributionTest, RecordsBytesAtPeak) {
+  AllocationAttribution attribution("test", {});
+  {
+    ScopedMemoryDebugAnnotation annotation("a");
+    attribution.RecordAllocation(Ptr(1), 100);
+  }
+  ScopedMemoryDebugAnnotation annotation("b");
+  attribution.RecordAllocation(Ptr(2), 50);
+  attribution.RecordDeallocation(Ptr(1));
+  attribution.RecordAllocation(Ptr(3), 80);
+
+  auto snapshot = attribution.GetSnapshot();
+  EXPECT_EQ(snapshot.peak_bytes_in_use, 150);
+  EXPECT_EQ(StatsOf(snapshot, "a").bytes_at_peak, 100);
+  EXPECT_EQ(StatsOf(snapshot, "a").live_bytes, 0);
+  // The peak of "b" is after the peak of the allocator.
+  EXPECT_EQ(StatsOf(snapshot, "b").bytes_at_peak, 50);
+  EXPECT_EQ(StatsOf(snapshot, "b").peak_live_bytes, 130);
+
+  attribution.RecordAllocation(Ptr(4), 100);
+  snapshot = attribution.GetSnapshot();
+  EXPECT_EQ(snapshot.peak_bytes_in_use, 230);
+  EXPECT_EQ(StatsOf(snapshot, "a").bytes_at_peak, 0);
+  EXPECT_EQ(StatsOf(snapshot, "b").bytes_at_peak, 230);
+  EXPECT_EQ(snapshot.ops[0].first, "b");
+}
+
+TEST(AllocationAttributionTest, LimitsNumberOfOps) {
+  AllocationAttribution::Options options;
+  options.max_ops = 2;
+  AllocationAttribution attribution("test", options);
+  const std::vector<std::string> op_names = {"a", "b", "c", "d"};
+  for (int i = 0; i < static_cast<int>(op_names.size()); ++i) {
+    ScopedMemoryDebugAnnotation annotation(op_names[i].c_str());
+    attribution.RecordAllocation(Ptr(i + 1), 10);
+  }
+
+  const auto snapshot = attribution.GetSnapshot();
+  ASSERT_EQ(snapshot.ops.size(), 3);
+  EXPECT_EQ(StatsOf(snapshot, "a").live_bytes, 10);
+  EXPECT_EQ(StatsOf(snapshot, "b").live_bytes, 10);
+  EXPECT_EQ(StatsOf(snapshot, AllocationAttribution::kOtherOps).live_bytes,
+            20);
+}
+
+TEST(AllocationAttributionTest, SamplesTimeline) {
+  AllocationAttribution::Options options;
+  options.sample_interval_bytes = 100;
+  options.max_samples = 2;
+  AllocationAttribution attribution("test", options);
+  ScopedMemoryDebugAnnotation annotation("a", /*step_id=*/7);
+  attribution.RecordAllocation(Ptr(1), 60);
+  EXPECT_TRUE(attribution.GetSnapshot().timeline.empty());
+  attribution.RecordAllocation(Ptr(2), 60);
+
+  auto timeline = attribution.GetSnapshot().timeline;
+  ASSERT_EQ(timeline.size(), 1);
+  EXPECT_GT(timeline[0].time_ns, 0);
+  EXPECT_EQ(timeline[0].bytes_in_use, 120);
+  EXPECT_EQ(timeline[0].bytes, 60);
+  EXPECT_EQ(timeline[0].op_name, "a");
+  EXPECT_EQ(timeline[0].step_id, 7);
+
+  attribution.RecordAllocation(Ptr(3), 100);
+  attribution.RecordDeallocation(Ptr(3));
+  timeline = attribution.GetSnapshot().timeline;
+  // Only the most recent samples are kept.
+  ASSERT_EQ(timeline.size(), 2);
+  EXPECT_EQ(timeline[0].bytes, 100);
+  EXPECT_EQ(timeline[0].bytes_in_use, 220);
+  EXPECT_EQ(timeline[1].bytes, -100);
+  EXPECT_EQ(timeline[1].bytes_in_use, 120);
+}
+
+TEST(AllocationAttributionTest, GetsAllSnapshots) {
+  AllocationAttribution first("first", {});
+  std::vector<std::string> names;
+  {
+    AllocationAttribution second("second", {});
+    for (const auto& snapshot : AllocationAttribution::GetAllSnapshots()) {
+      names.push_back(snapshot.allocator_name);
+    }
+    EXPECT_THAT(names, ::testing::IsSupersetOf({"first", "second"}));
+  }
+  names.clear();
+  for (const auto& snapshot : AllocationAttribution::GetAllSnapshots()) {
+    names.push_back(snapshot.allocator_name);
+  }
+  EXPECT_THAT(names, ::testing::Contains("first"));
+  EXPECT_THAT(names, ::testing::Not(::testing::Contains("second")));
+}
+
+}  // namespace
+}  // namespace tsl
@@ -32,6 +32,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "xla/tsl/framework/allocation_attribution.h"
 #include "xla/tsl/framework/allocator.h"
 #include "xla/tsl/framework/allocator_retry.h"
 #include "xla/tsl/protobuf/bfc_memory_map.pb.h"
@@ -94,6 +95,11 @@ BFCAllocator::BFCAllocator(std::unique_ptr<SubAllocator> sub_allocator,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  if (AllocationAttribution::EnabledByEnv()) {
+    attribution_ = std::make_unique<AllocationAttribution>(
+        name, AllocationAttribution::Options());
+  }
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -343,26 +349,9 @@ bool BFCAllocator::DeallocateFreeRegions(size_t rounded_bytes)
   }
 
   // Searching for free regions.
-  absl::flat_hash_set<void*> free_region_ptrs;
   size_t total_free_bytes = 0;
-  for (const AllocationRegion& region : region_manager_.regions()) {
-    ChunkHandle h = region_manager_.get_handle(region.ptr());
-    bool any_use = false;
-    while (h != kInvalidChunkHandle) {
-      const Chunk* c = ChunkFromHandle(h);
-      if (c->in_use()) {
-        any_use = true;
-        break;
-      }
-      h = c->next;
-    }
-
-    if (!any_use) {
-      VLOG(2) << "Found free region with ptr = " << region.ptr();
-      free_region_ptrs.insert(region.ptr());
-      total_free_bytes += region.memory_size();
-    }
-  }
+  absl::flat_hash_set<void*> free_region_ptrs =
+      FindFreeRegions(&total_free_bytes);
 
   if (total_free_bytes == 0) {
     return false;
@@ -391,6 +380,44 @@ bool BFCAllocator::DeallocateFreeRegions(size_t rounded_bytes)
   return true;
 }
 
+absl::flat_hash_set<void*> BFCAllocator::FindFreeRegions(size_t* total_bytes)
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+  absl::flat_hash_set<void*> free_region_ptrs;
+  *total_bytes = 0;
+  for (const AllocationRegion& region : region_manager_.regions()) {
+    ChunkHandle h = region_manager_.get_handle(region.ptr());
+    bool any_use = false;
+    while (h != kInvalidChunkHandle) {
+      const Chunk* c = ChunkFromHandle(h);
+      // Chunks on timestamped_chunks_ must not be deleted either.
+      if (c->in_use() || c->freed_at_count > 0) {
+        any_use = true;
+        break;
+      }
+      h = c->next;
+    }
+
+    if (!any_use) {
+      VLOG(2) << "Found free region with ptr = " << region.ptr();
+      free_region_ptrs.insert(region.ptr());
+      *total_bytes += region.memory_size();
+    }
+  }
+  return free_region_ptrs;
+}
+
+size_t BFCAllocator::ReleaseFreeRegions() {
+  absl::MutexLock l(&mutex_);
+  size_t total_bytes = 0;
+  absl::flat_hash_set<void*> free_region_ptrs = FindFreeRegions(&total_bytes);
+  if (!free_region_ptrs.empty()) {
+    VLOG(1) << "Releasing " << free_region_ptrs.size() << " free regions ("
+            << total_bytes << " bytes) of " << Name();
+    DeallocateRegions(free_region_ptrs);
+  }
+  return total_bytes;
+}
+
 void BFCAllocator::DeallocateRegions(
     const absl::flat_hash_set<void*>& region_ptrs)
     ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
@@ -641,6 +668,9 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
           size_history_[slot] = stats_.bytes_in_use;
         }
 #endif
+        if (attribution_) {
+          attribution_->RecordAllocation(chunk->ptr, chunk->size);
+        }
 
         VLOG(4) << "Returning: " << chunk->ptr;
         if (VLOG_IS_ON(4)) {
@@ -719,6 +749,7 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   int64_t alloc_bytes = chunk->size;
 
   MarkFree(h);
+  if (attribution_) attribution_->RecordDeallocation(chunk_ptr);
 
   // Consider coalescing it.
   if (timing_counter_) {
@@ -1220,6 +1251,24 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
   return md;
 }
 
+BFCAllocator::FragmentationStats BFCAllocator::GetFragmentationStats() {
+  absl::MutexLock l(&mutex_);
+  FragmentationStats stats;
+  stats.largest_free_chunk = LargestFreeChunk();
+  if (*stats_.pool_bytes > stats_.bytes_in_use) {
+    stats.fragmentation = GetFragmentation();
+  }
+  stats.bin_free_bytes.resize(kNumBins);
+  stats.bin_free_chunks.resize(kNumBins);
+  for (BinNum b = 0; b < kNumBins; ++b) {
+    for (ChunkHandle h : BinFromIndex(b)->free_chunks) {
+      stats.bin_free_bytes[b] += ChunkFromHandle(h)->size;
+      ++stats.bin_free_chunks[b];
+    }
+  }
+  return stats;
+}
+
 std::optional<AllocatorStats> BFCAllocator::GetStats() {
   absl::MutexLock l(&mutex_);
   return stats_;
@@ -30,6 +30,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "xla/tsl/framework/allocation_attribution.h"
 #include "xla/tsl/framework/allocator.h"
 #include "xla/tsl/framework/allocator_retry.h"
 #include "xla/tsl/framework/shared_counter.h"
@@ -112,6 +113,25 @@ class BFCAllocator : public Allocator {
 
   MemoryDump RecordMemoryMap();
 
+  // Summary of how the free memory of the allocator is fragmented.
+  struct FragmentationStats {
+    // Fraction of the free bytes that are not part of the largest free chunk.
+    double fragmentation = 0;
+    int64_t largest_free_chunk = 0;
+    // Free bytes and number of free chunks of each bin. Bin i holds chunks of
+    // at least 256 << i bytes.
+    std::vector<int64_t> bin_free_bytes;
+    std::vector<int64_t> bin_free_chunks;
+  };
+  FragmentationStats GetFragmentationStats();
+
+  // Returns the regions without memory in use to the sub-allocator, and
+  // returns the number of bytes released. Free chunks are always coalesced
+  // with their free neighbors, so this is the only compaction possible
+  // without moving memory in use. Unlike the garbage collection done on OOM,
+  // this does not depend on Options::garbage_collection.
+  size_t ReleaseFreeRegions();
+
  private:
   struct Bin;
 
@@ -467,6 +487,11 @@ class BFCAllocator : public Allocator {
   // found and freed; false otherwise.
   bool DeallocateFreeRegions(size_t rounded_bytes);
 
+  // Returns the regions without chunks in use, or freed chunks that are not
+  // yet safe to merge, and sets `total_bytes` to their total size.
+  absl::flat_hash_set<void*> FindFreeRegions(size_t* total_bytes)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Helper function to deallocate regions.
   void DeallocateRegions(const absl::flat_hash_set<void*>& region_ptrs)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
@@ -594,6 +619,8 @@ class BFCAllocator : public Allocator {
 
   // Stats.
   AllocatorStats stats_ ABSL_GUARDED_BY(mutex_);
+  // Set if TF_ALLOCATION_ATTRIBUTION is enabled.
+  std::unique_ptr<AllocationAttribution> attribution_;
 
 #ifdef TENSORFLOW_MEM_DEBUG
   int64 action_counter_ ABSL_GUARDED_BY(mutex_);
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <memory>
 
+#include "xla/tsl/framework/allocation_attribution.h"
 #include "xla/tsl/framework/allocator.h"
 #include "xla/tsl/framework/allocator_registry.h"
 #include "xla/tsl/framework/tracking_allocator.h"
@@ -70,7 +72,12 @@ class CPUAllocator : public Allocator {
  public:
   CPUAllocator()
       : single_allocation_warning_count_(0),
-        total_allocation_warning_count_(0) {}
+        total_allocation_warning_count_(0) {
+    if (AllocationAttribution::EnabledByEnv()) {
+      attribution_ = std::make_unique<AllocationAttribution>(
+          Name(), AllocationAttribution::Options());
+    }
+  }
 
   ~CPUAllocator() override = default;
 
@@ -107,6 +114,9 @@ class CPUAllocator : public Allocator {
         AddTraceMe("MemoryAllocation", p, num_bytes, alloc_size);
       }
     }
+    if (attribution_ && p != nullptr) {
+      attribution_->RecordAllocation(p, num_bytes);
+    }
     return p;
   }
 
@@ -118,6 +128,7 @@ class CPUAllocator : public Allocator {
       stats_.bytes_in_use -= alloc_size;
       AddTraceMe("MemoryDeallocation", ptr, 0, alloc_size);
     }
+    if (attribution_) attribution_->RecordDeallocation(ptr);
     port::AlignedFree(ptr);
   }
 
@@ -129,6 +140,7 @@ class CPUAllocator : public Allocator {
       stats_.bytes_in_use -= alloc_size;
       AddTraceMe("MemoryDeallocation", ptr, 0, alloc_size);
     }
+    if (attribution_) attribution_->RecordDeallocation(ptr);
     port::AlignedSizedFree(ptr, alignment, num_bytes);
   }
 
@@ -188,6 +200,10 @@ class CPUAllocator : public Allocator {
   std::atomic<int> single_allocation_warning_count_;
   int total_allocation_warning_count_ TF_GUARDED_BY(mu_);
 
+  // Set if TF_ALLOCATION_ATTRIBUTION is enabled. Unlike the stats, it doesn't
+  // depend on cpu_allocator_collect_stats.
+  std::unique_ptr<AllocationAttribution> attribution_;
+
   CPUAllocator(const CPUAllocator&) = delete;
   void operator=(const CPUAllocator&) = delete;
 };
@@ -133,6 +133,13 @@ class ServingDeviceSelector {
   // Struct of all tracked device states, which will be passed to Policy.
   struct DeviceStates {
     absl::Span<const DeviceState> states;
+    // Estimated nanoseconds until each device becomes idle, from the predicted
+    // execution times of the programs queued on it. Empty if the selector does
+    // not provide it.
+    absl::Span<const int64_t> estimated_time_till_idle_ns;
+    // Free memory of each device in bytes, -1 if unknown. Empty if the selector
+    // does not provide it.
+    absl::Span<const int64_t> free_memory_bytes;
   };
 
   // Policy used to select a device.
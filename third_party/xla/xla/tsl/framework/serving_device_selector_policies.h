@@ -23,6 +23,9 @@ namespace tsl {
 
 enum class ServingDeviceSelectorPolicy {
   kRoundRobin,
+  // Selects the device that becomes idle first among those with enough free
+  // memory. Requires a selector that provides load and memory estimates.
+  kLoadAndMemoryAware,
 };
 
 class RoundRobinPolicy : public ServingDeviceSelector::Policy {
@@ -20,6 +20,8 @@ limitations under the License.
 #include <stdlib.h>
 #include <string.h>
 
+#include "xla/tsl/util/env_var.h"
+#include "tsl/platform/logging.h"
 #include "tsl/platform/mutex.h"
 #include "tsl/platform/raw_coding.h"
 
@@ -445,6 +447,23 @@ class ShardedLRUCache : public Cache {
 
 Cache* NewLRUCache(size_t capacity) { return new ShardedLRUCache(capacity); }
 
+Cache* SharedBlockCache() {
+  static Cache* cache = []() -> Cache* {
+    int64_t size_in_mb;
+    absl::Status s = ReadInt64FromEnvVar(
+        "TF_TABLE_SHARED_BLOCK_CACHE_SIZE_IN_MB", 0, &size_in_mb);
+    if (!s.ok()) {
+      LOG(WARNING) << "Not using a shared table block cache: " << s;
+      return nullptr;
+    }
+    if (size_in_mb <= 0) {
+      return nullptr;
+    }
+    return NewLRUCache(static_cast<size_t>(size_in_mb) << 20);
+  }();
+  return cache;
+}
+
 }  // namespace table
 
 }  // namespace tsl
@@ -45,6 +45,13 @@ class Cache;
 // of Cache uses a least-recently-used eviction policy.
 Cache* NewLRUCache(size_t capacity);
 
+// Returns the process-wide LRU cache that tables opened by unrelated readers
+// can share, so that all of their cached blocks count against a single
+// memory budget.  The budget is TF_TABLE_SHARED_BLOCK_CACHE_SIZE_IN_MB
+// megabytes, read on the first call.  Returns nullptr if it is not positive,
+// which is the default.
+Cache* SharedBlockCache();
+
 class Cache {
  public:
   Cache() = default;
@@ -0,0 +1,234 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "xla/tsl/lib/io/readahead_inputstream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/threadpool.h"
+
+namespace tsl {
+namespace io {
+namespace {
+
+// Pieces of chunks smaller than this are copied into Cords rather than
+// referenced, as referencing them costs more than copying them.
+constexpr size_t kMaxBytesToCopyToCord = 511;
+
+// Readahead threads spend their time blocked on I/O, so the pool is sized for
+// queue depth rather than for the number of cores.
+constexpr int kNumReadaheadThreads = 32;
+
+thread::ThreadPool* ReadaheadThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "tf_readahead", kNumReadaheadThreads);
+  return pool;
+}
+
+}  // namespace
+
+ReadaheadInputStream::ReadaheadInputStream(RandomAccessFile* file,
+                                           int64_t chunk_bytes,
+                                           int max_outstanding_reads,
+                                           bool owns_file)
+    : file_(file),
+      chunk_bytes_(std::max<int64_t>(1, chunk_bytes)),
+      max_outstanding_reads_(std::max(1, max_outstanding_reads)),
+      owns_file_(owns_file) {}
+
+ReadaheadInputStream::~ReadaheadInputStream() {
+  {
+    mutex_lock l(mu_);
+    while (num_in_flight_ > 0) {
+      cv_.wait(l);
+    }
+  }
+  if (owns_file_) {
+    delete file_;
+  }
+}
+
+void ReadaheadInputStream::IssueReads() {
+  while (!end_of_file_ && chunks_.size() < max_outstanding_reads_) {
+    auto chunk = std::make_shared<Chunk>();
+    chunk->offset = next_offset_;
+    next_offset_ += chunk_bytes_;
+    chunks_.push_back(chunk);
+    ++num_in_flight_;
+    ReadaheadThreadPool()->Schedule([this, chunk]() {
+      std::string buffer;
+      buffer.resize(chunk_bytes_);
+      absl::string_view data;
+      absl::Status s =
+          file_->Read(chunk->offset, chunk_bytes_, &data, &buffer[0]);
+      if (data.data() != buffer.data()) {
+        memmove(&buffer[0], data.data(), data.size());
+      }
+      buffer.resize(data.size());
+      mutex_lock l(mu_);
+      chunk->data = std::move(buffer);
+      chunk->status = std::move(s);
+      chunk->done = true;
+      --num_in_flight_;
+      cv_.notify_all();
+    });
+  }
+}
+
+void ReadaheadInputStream::DiscardChunks() {
+  chunks_.clear();
+  next_offset_ = pos_;
+}
+
+absl::Status ReadaheadInputStream::Consume(
+    int64_t bytes,
+    absl::FunctionRef<void(const std::shared_ptr<Chunk>&, absl::string_view)>
+        append,
+    int64_t* consumed, mutex_lock* lock) {
+  *consumed = 0;
+  while (*consumed < bytes) {
+    IssueReads();
+    if (chunks_.empty()) {
+      return errors::OutOfRange("reached end of file");
+    }
+    std::shared_ptr<Chunk> chunk = chunks_.front();
+    while (!chunk->done) {
+      cv_.wait(*lock);
+    }
+    if (!chunk->status.ok() && !errors::IsOutOfRange(chunk->status)) {
+      // Restart the readahead at `pos_` if the caller retries.
+      DiscardChunks();
+      return chunk->status;
+    }
+    const int64_t chunk_end = chunk->offset + chunk->data.size();
+    if (pos_ >= chunk_end) {
+      chunks_.pop_front();
+      if (chunk->data.size() < chunk_bytes_) {
+        // A short read marks the end of the file, so the chunks after it are
+        // empty.
+        DiscardChunks();
+        end_of_file_ = true;
+      }
+      continue;
+    }
+    const int64_t n = std::min(bytes - *consumed, chunk_end - pos_);
+    append(chunk,
+           absl::string_view(chunk->data).substr(pos_ - chunk->offset, n));
+    *consumed += n;
+    pos_ += n;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ReadaheadInputStream::ReadNBytes(int64_t bytes_to_read,
+                                              tstring* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  mutex_lock l(mu_);
+  result->clear();
+  result->resize_uninitialized(bytes_to_read);
+  char* dst = &(*result)[0];
+  int64_t consumed = 0;
+  absl::Status s = Consume(
+      bytes_to_read,
+      [&dst](const std::shared_ptr<Chunk>&, absl::string_view piece) {
+        memcpy(dst, piece.data(), piece.size());
+        dst += piece.size();
+      },
+      &consumed, &l);
+  result->resize(consumed);
+  return s;
+}
+
+#if defined(TF_CORD_SUPPORT)
+absl::Status ReadaheadInputStream::ReadNBytes(int64_t bytes_to_read,
+                                              absl::Cord* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  mutex_lock l(mu_);
+  result->Clear();
+  int64_t consumed = 0;
+  return Consume(
+      bytes_to_read,
+      [result](const std::shared_ptr<Chunk>& chunk, absl::string_view piece) {
+        if (piece.size() <= kMaxBytesToCopyToCord) {
+          result->Append(piece);
+          return;
+        }
+        // The data of a chunk is not modified once it is read, so the Cord
+        // can point into it for as long as it holds a reference to the chunk.
+        result->Append(absl::MakeCordFromExternal(
+            piece, [chunk](absl::string_view) {}));
+      },
+      &consumed, &l);
+}
+#endif
+
+absl::Status ReadaheadInputStream::SkipNBytes(int64_t bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes: ",
+                                   bytes_to_skip);
+  }
+  mutex_lock l(mu_);
+  const int64_t start = pos_;
+  const int64_t target = pos_ + bytes_to_skip;
+  auto skip = [](const std::shared_ptr<Chunk>&, absl::string_view) {};
+  int64_t consumed = 0;
+  if (bytes_to_skip > 0 && target > next_offset_) {
+    // The target is past the window. Restart the readahead there, reading the
+    // last skipped byte to check that the file is long enough.
+    pos_ = target - 1;
+    DiscardChunks();
+    end_of_file_ = false;
+    absl::Status s = Consume(1, skip, &consumed, &l);
+    if (!errors::IsOutOfRange(s)) {
+      return s;
+    }
+    // The file ends before the target. Find out where by skipping from the
+    // start position.
+    pos_ = start;
+    DiscardChunks();
+    end_of_file_ = false;
+  }
+  return Consume(target - pos_, skip, &consumed, &l);
+}
+
+int64_t ReadaheadInputStream::Tell() const {
+  mutex_lock l(mu_);
+  return pos_;
+}
+
+absl::Status ReadaheadInputStream::Reset() {
+  mutex_lock l(mu_);
+  pos_ = 0;
+  DiscardChunks();
+  end_of_file_ = false;
+  return absl::OkStatus();
+}
+
+}  // namespace io
+}  // namespace tsl
@@ -0,0 +1,117 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef XLA_TSL_LIB_IO_READAHEAD_INPUTSTREAM_H_
+#define XLA_TSL_LIB_IO_READAHEAD_INPUTSTREAM_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "xla/tsl/lib/io/inputstream_interface.h"
+#include "tsl/platform/file_system.h"
+#include "tsl/platform/mutex.h"
+#include "tsl/platform/thread_annotations.h"
+
+namespace tsl {
+namespace io {
+
+// Reads a RandomAccessFile sequentially while keeping several reads in flight.
+//
+// The stream divides the file into chunks of `chunk_bytes` bytes and reads up
+// to `max_outstanding_reads` chunks ahead of the current position, in parallel,
+// on a process-wide pool of I/O threads. This keeps the device queue full on
+// storage whose bandwidth is only reached with several concurrent requests,
+// e.g. NVMe drives and network file systems, where a single blocking read per
+// file would otherwise require a very wide interleave.
+//
+// Skipping within the readahead window reuses the chunks already read, and
+// skipping past it restarts the readahead at the new position. A given
+// instance of ReadaheadInputStream is NOT safe for concurrent use by multiple
+// threads.
+//
+// With Cord support, ReadNBytes(int64, absl::Cord*) returns the bytes as
+// references to the chunks that hold them instead of copies, so the chunks
+// stay alive as long as the returned Cord.
+class ReadaheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file` unless `owns_file` is set to true.
+  // `file` must outlive *this.
+  ReadaheadInputStream(RandomAccessFile* file, int64_t chunk_bytes,
+                       int max_outstanding_reads, bool owns_file = false);
+
+  // Waits for the reads in flight to complete.
+  ~ReadaheadInputStream() override;
+
+  absl::Status ReadNBytes(int64_t bytes_to_read, tstring* result) override;
+
+#if defined(TF_CORD_SUPPORT)
+  absl::Status ReadNBytes(int64_t bytes_to_read, absl::Cord* result) override;
+#endif
+
+  absl::Status SkipNBytes(int64_t bytes_to_skip) override;
+
+  int64_t Tell() const override;
+
+  absl::Status Reset() override;
+
+ private:
+  struct Chunk {
+    int64_t offset = 0;
+    std::string data;
+    absl::Status status;
+    bool done = false;
+  };
+
+  // Issues reads until `max_outstanding_reads_` chunks are buffered or in
+  // flight.
+  void IssueReads() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Drops the readahead window. The next read starts at `pos_`.
+  void DiscardChunks() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Advances the stream by up to `bytes` bytes, passing each contiguous piece
+  // of them to `append` along with the chunk that holds it, and stores the
+  // number of bytes advanced in `*consumed`.
+  absl::Status Consume(
+      int64_t bytes,
+      absl::FunctionRef<void(const std::shared_ptr<Chunk>&, absl::string_view)>
+          append,
+      int64_t* consumed, mutex_lock* lock) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  RandomAccessFile* const file_;
+  const int64_t chunk_bytes_;
+  const int max_outstanding_reads_;
+  const bool owns_file_;
+
+  mutable mutex mu_;
+  condition_variable cv_;
+  // Position of the stream in the file.
+  int64_t pos_ TF_GUARDED_BY(mu_) = 0;
+  // Offset of the next chunk to read.
+  int64_t next_offset_ TF_GUARDED_BY(mu_) = 0;
+  // Whether a short read has shown that the file ends in the window.
+  bool end_of_file_ TF_GUARDED_BY(mu_) = false;
+  // Contiguous chunks starting at the chunk that contains `pos_`.
+  std::deque<std::shared_ptr<Chunk>> chunks_ TF_GUARDED_BY(mu_);
+  // Reads in flight, including those of discarded chunks.
+  int num_in_flight_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace io
+}  // namespace tsl
+
+#endif  // XLA_TSL_LIB_IO_READAHEAD_INPUTSTREAM_H_
@@ -0,0 +1,158 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "xla/tsl/lib/io/readahead_inputstream.h"
+
+#include <memory>
+#include <string>
+
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/test.h"
+
+namespace tsl {
+namespace io {
+namespace {
+
+std::unique_ptr<RandomAccessFile> MakeFile(const string& contents) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  return file;
+}
+
+TEST(ReadaheadInputStream, ReadNBytes) {
+  std::unique_ptr<RandomAccessFile> file = MakeFile("0123456789");
+  for (int chunk_bytes : {1, 3, 10, 64}) {
+    for (int max_outstanding_reads : {1, 2, 8}) {
+      tstring read;
+      ReadaheadInputStream in(file.get(), chunk_bytes, max_outstanding_reads);
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "012");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(5, &read));
+      EXPECT_EQ(read, "34567");
+      EXPECT_EQ(8, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(20, &read)));
+      EXPECT_EQ(read, "89");
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(10, in.Tell());
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, SkipNBytes) {
+  std::unique_ptr<RandomAccessFile> file = MakeFile("0123456789");
+  for (int chunk_bytes : {1, 3, 10, 64}) {
+    for (int max_outstanding_reads : {1, 2, 8}) {
+      tstring read;
+      ReadaheadInputStream in(file.get(), chunk_bytes, max_outstanding_reads);
+      TF_ASSERT_OK(in.SkipNBytes(3));
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "34");
+      TF_ASSERT_OK(in.SkipNBytes(0));
+      EXPECT_EQ(5, in.Tell());
+      TF_ASSERT_OK(in.SkipNBytes(4));
+      EXPECT_EQ(9, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(1, &read));
+      EXPECT_EQ(read, "9");
+      EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(1)));
+      EXPECT_EQ(10, in.Tell());
+    }
+  }
+}
+
+#if defined(TF_CORD_SUPPORT)
+TEST(ReadaheadInputStream, ReadNBytesCord) {
+  string contents;
+  for (int i = 0; i < 10000; ++i) {
+    contents.push_back('a' + i % 26);
+  }
+  std::unique_ptr<RandomAccessFile> file = MakeFile(contents);
+  for (int chunk_bytes : {3, 1000, 4096}) {
+    ReadaheadInputStream in(file.get(), chunk_bytes,
+                            /*max_outstanding_reads=*/4);
+    absl::Cord read;
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, contents.substr(0, 2));
+    TF_ASSERT_OK(in.ReadNBytes(5000, &read));
+    EXPECT_EQ(read, contents.substr(2, 5000));
+    EXPECT_EQ(5002, in.Tell());
+    // The Cord holds on to the chunks after the stream is done with them.
+    TF_ASSERT_OK(in.Reset());
+    EXPECT_EQ(read, contents.substr(2, 5000));
+    TF_ASSERT_OK(in.SkipNBytes(9000));
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(2000, &read)));
+    EXPECT_EQ(read, contents.substr(9000));
+    EXPECT_EQ(10000, in.Tell());
+  }
+}
+#endif
+
+TEST(ReadaheadInputStream, SkipPastEndOfFile) {
+  std::unique_ptr<RandomAccessFile> file = MakeFile("0123456789");
+  for (int chunk_bytes : {1, 3, 10, 64}) {
+    ReadaheadInputStream in(file.get(), chunk_bytes,
+                            /*max_outstanding_reads=*/2);
+    TF_ASSERT_OK(in.SkipNBytes(2));
+    EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(100)));
+    EXPECT_EQ(10, in.Tell());
+  }
+}
+
+TEST(ReadaheadInputStream, Reset) {
+  std::unique_ptr<RandomAccessFile> file = MakeFile("0123456789");
+  tstring read;
+  ReadaheadInputStream in(file.get(), /*chunk_bytes=*/4,
+                          /*max_outstanding_reads=*/2);
+  TF_ASSERT_OK(in.ReadNBytes(6, &read));
+  EXPECT_EQ(read, "012345");
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(20, &read)));
+  TF_ASSERT_OK(in.Reset());
+  EXPECT_EQ(0, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(10, &read));
+  EXPECT_EQ(read, "0123456789");
+}
+
+TEST(ReadaheadInputStream, LargeFile) {
+  string contents;
+  for (int i = 0; i < 100000; ++i) {
+    contents.push_back('a' + i % 26);
+  }
+  std::unique_ptr<RandomAccessFile> file = MakeFile(contents);
+  ReadaheadInputStream in(file.get(), /*chunk_bytes=*/4096,
+                          /*max_outstanding_reads=*/4);
+  string read_back;
+  tstring read;
+  absl::Status s;
+  while ((s = in.ReadNBytes(1000, &read)).ok()) {
+    read_back.append(read.data(), read.size());
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(s));
+  read_back.append(read.data(), read.size());
+  EXPECT_EQ(read_back, contents);
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tsl
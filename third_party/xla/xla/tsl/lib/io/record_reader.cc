@@ -17,10 +17,20 @@ limitations under the License.
 
 #include <limits.h>
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "xla/tsl/lib/hash/crc32c.h"
 #include "xla/tsl/lib/io/buffered_inputstream.h"
 #include "xla/tsl/lib/io/compression.h"
 #include "xla/tsl/lib/io/random_inputstream.h"
+#include "xla/tsl/lib/io/readahead_inputstream.h"
+#include "tsl/platform/coding.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/raw_coding.h"
@@ -57,9 +67,16 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
 RecordReader::RecordReader(RandomAccessFile* file,
                            const RecordReaderOptions& options)
     : options_(options),
+      file_(file),
       input_stream_(new RandomAccessInputStream(file)),
       last_read_failed_(false) {
-  if (options.buffer_size > 0) {
+  if (options.readahead_buffer_size > 0) {
+    const int max_outstanding_reads =
+        std::max(1, options.readahead_max_outstanding_reads);
+    input_stream_.reset(new ReadaheadInputStream(
+        file, options.readahead_buffer_size / max_outstanding_reads,
+        max_outstanding_reads));
+  } else if (options.buffer_size > 0) {
     input_stream_.reset(new BufferedInputStream(input_stream_.release(),
                                                 options.buffer_size, true));
   }
@@ -86,12 +103,45 @@ RecordReader::RecordReader(RandomAccessFile* file,
 }
 
 namespace {
+
+constexpr char kRecordIndexMagic[] = "TFRIDX01";
+constexpr size_t kRecordIndexMagicSize = sizeof(kRecordIndexMagic) - 1;
+constexpr size_t kRecordIndexHeaderSize =
+    kRecordIndexMagicSize + sizeof(uint64);
+
 inline const char* GetChecksumErrorSuffix(uint64 offset) {
   if (offset == 0) {
     return " (Is this even a TFRecord file?)";
   }
   return "";
 }
+
+// Reads exactly `n` bytes at `offset` of `file` into `*result`.
+absl::Status ReadExactly(const RandomAccessFile* file, uint64 offset, size_t n,
+                         absl::string_view* result, char* scratch) {
+  absl::Status s = file->Read(offset, n, result, scratch);
+  if (!s.ok() && !errors::IsOutOfRange(s)) return s;
+  if (result->size() != n) {
+    if (result->empty()) {
+      return errors::OutOfRange("eof", GetChecksumErrorSuffix(offset));
+    }
+    return errors::DataLoss("truncated record at ", offset,
+                            GetChecksumErrorSuffix(offset));
+  }
+  return absl::OkStatus();
+}
+
+// Verifies that the checksum of the first `n` bytes of `data` is stored in the
+// 4 bytes that follow them.
+absl::Status VerifyChecksum(const char* data, size_t n, uint64 offset) {
+  const uint32 masked_crc = core::DecodeFixed32(data + n);
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(data, n)) {
+    return errors::DataLoss("corrupted record at ", offset,
+                            GetChecksumErrorSuffix(offset));
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 // Read n+4 bytes from file, verify that checksum of first n bytes is
@@ -129,6 +179,45 @@ absl::Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
   return absl::OkStatus();
 }
 
+#if defined(TF_CORD_SUPPORT)
+absl::Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
+                                           absl::Cord* result) {
+  if (n >= SIZE_MAX - sizeof(uint32)) {
+    return errors::DataLoss("record size too large",
+                            GetChecksumErrorSuffix(offset));
+  }
+
+  const size_t expected = n + sizeof(uint32);
+  absl::Status s = input_stream_->ReadNBytes(expected, result);
+  if (errors::IsUnimplemented(s)) {
+    // The stream can't return Cords, e.g. with buffering only.
+    tstring buffer;
+    s = input_stream_->ReadNBytes(expected, &buffer);
+    *result = absl::Cord(absl::string_view(buffer));
+  }
+  TF_RETURN_IF_ERROR(s);
+
+  if (result->size() != expected) {
+    if (result->empty()) {
+      return errors::OutOfRange("eof", GetChecksumErrorSuffix(offset));
+    } else {
+      return errors::DataLoss("truncated record at ", offset,
+                              GetChecksumErrorSuffix(offset));
+    }
+  }
+
+  std::string footer;
+  absl::CopyCordToString(result->Subcord(n, sizeof(uint32)), &footer);
+  result->RemoveSuffix(sizeof(uint32));
+  const uint32 masked_crc = core::DecodeFixed32(footer.data());
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(*result)) {
+    return errors::DataLoss("corrupted record at ", offset,
+                            GetChecksumErrorSuffix(offset));
+  }
+  return absl::OkStatus();
+}
+#endif
+
 absl::Status RecordReader::GetMetadata(Metadata* md) {
   if (!md) {
     return errors::InvalidArgument(
@@ -224,6 +313,36 @@ absl::Status RecordReader::ReadRecord(uint64* offset, tstring* record) {
   return absl::OkStatus();
 }
 
+#if defined(TF_CORD_SUPPORT)
+absl::Status RecordReader::ReadRecord(uint64* offset, absl::Cord* record) {
+  TF_RETURN_IF_ERROR(PositionInputStream(*offset));
+
+  // Read header data.
+  tstring header;
+  absl::Status s = ReadChecksummed(*offset, sizeof(uint64), &header);
+  if (!s.ok()) {
+    last_read_failed_ = true;
+    return s;
+  }
+  const uint64 length = core::DecodeFixed64(header.data());
+
+  // Read data
+  s = ReadChecksummed(*offset + kHeaderSize, length, record);
+  if (!s.ok()) {
+    last_read_failed_ = true;
+    if (errors::IsOutOfRange(s)) {
+      s = errors::DataLoss("truncated record at ", *offset, "' failed with ",
+                           s.message());
+    }
+    return s;
+  }
+
+  *offset += kHeaderSize + length + kFooterSize;
+  DCHECK_EQ(*offset, input_stream_->Tell());
+  return absl::OkStatus();
+}
+#endif
+
 absl::Status RecordReader::SkipRecords(uint64* offset, int num_to_skip,
                                        int* num_skipped) {
   TF_RETURN_IF_ERROR(PositionInputStream(*offset));
@@ -256,6 +375,136 @@ absl::Status RecordReader::SkipRecords(uint64* offset, int num_to_skip,
   return absl::OkStatus();
 }
 
+absl::Status RecordReader::ReadRecordAt(uint64 offset, uint64 record_size,
+                                        tstring* record) const {
+  if (options_.compression_type != RecordReaderOptions::NONE) {
+    return errors::FailedPrecondition(
+        "Random access reads are not supported for compressed TFRecord "
+        "files.");
+  }
+  absl::string_view result;
+  if (record_size == 0) {
+    char header[kHeaderSize];
+    TF_RETURN_IF_ERROR(
+        ReadExactly(file_, offset, kHeaderSize, &result, header));
+    TF_RETURN_IF_ERROR(VerifyChecksum(result.data(), sizeof(uint64), offset));
+    record_size =
+        kHeaderSize + core::DecodeFixed64(result.data()) + kFooterSize;
+  }
+  if (record_size < kHeaderSize + kFooterSize || record_size >= SIZE_MAX) {
+    return errors::InvalidArgument("Invalid size ", record_size,
+                                   " of record at ", offset);
+  }
+
+  // Read the record into `*record` and then move its data to the front.
+  record->resize_uninitialized(record_size);
+  absl::Status s =
+      ReadExactly(file_, offset, record_size, &result, record->mdata());
+  if (errors::IsOutOfRange(s)) {
+    return errors::DataLoss("truncated record at ", offset, "' failed with ",
+                            s.message());
+  }
+  TF_RETURN_IF_ERROR(s);
+  TF_RETURN_IF_ERROR(VerifyChecksum(result.data(), sizeof(uint64), offset));
+  const uint64 length = core::DecodeFixed64(result.data());
+  if (kHeaderSize + length + kFooterSize != record_size) {
+    return errors::DataLoss("record at ", offset, " has length ", length,
+                            ", but its size is expected to be ", record_size);
+  }
+  TF_RETURN_IF_ERROR(
+      VerifyChecksum(result.data() + kHeaderSize, length, offset));
+  std::memmove(record->mdata(), result.data() + kHeaderSize, length);
+  record->resize(length);
+  return absl::OkStatus();
+}
+
+absl::Status RecordIndex::Build(RandomAccessFile* file, RecordIndex* index) {
+  RecordReader reader(file);
+  index->offsets_ = {0};
+  uint64 offset = 0;
+  while (true) {
+    int num_skipped;
+    absl::Status s = reader.SkipRecords(&offset, 1, &num_skipped);
+    if (errors::IsOutOfRange(s)) break;
+    TF_RETURN_IF_ERROR(s);
+    index->offsets_.push_back(offset);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RecordIndex::Read(RandomAccessFile* file, RecordIndex* index) {
+  char header[kRecordIndexHeaderSize];
+  absl::string_view result;
+  TF_RETURN_IF_ERROR(
+      ReadExactly(file, 0, kRecordIndexHeaderSize, &result, header));
+  if (result.substr(0, kRecordIndexMagicSize) != kRecordIndexMagic) {
+    return errors::DataLoss("Not a TFRecord index file.");
+  }
+  const uint64 num_records =
+      core::DecodeFixed64(result.data() + kRecordIndexMagicSize);
+  if (num_records > SIZE_MAX / sizeof(uint64) - 8) {
+    return errors::DataLoss("Invalid number of records in TFRecord index: ",
+                            num_records);
+  }
+
+  const size_t size = kRecordIndexHeaderSize +
+                      (num_records + 1) * sizeof(uint64) + sizeof(uint32);
+  std::string contents;
+  contents.resize(size);
+  TF_RETURN_IF_ERROR(ReadExactly(file, 0, size, &result, &contents[0]));
+  TF_RETURN_IF_ERROR(VerifyChecksum(result.data(), size - sizeof(uint32), 0));
+  std::vector<uint64> offsets(num_records + 1);
+  for (uint64 i = 0; i <= num_records; ++i) {
+    offsets[i] = core::DecodeFixed64(result.data() + kRecordIndexHeaderSize +
+                                     i * sizeof(uint64));
+    if (i > 0 && offsets[i] < offsets[i - 1] + RecordReader::kHeaderSize +
+                                  RecordReader::kFooterSize) {
+      return errors::DataLoss("Invalid offset ", offsets[i], " of record ", i,
+                              " in TFRecord index.");
+    }
+  }
+  if (offsets[0] != 0) {
+    return errors::DataLoss("Invalid offset ", offsets[0],
+                            " of the first record in TFRecord index.");
+  }
+  index->offsets_ = std::move(offsets);
+  return absl::OkStatus();
+}
+
+absl::Status RecordIndex::Write(WritableFile* file) const {
+  std::string contents(kRecordIndexMagic, kRecordIndexMagicSize);
+  core::PutFixed64(&contents, num_records());
+  for (uint64 offset : offsets_) {
+    core::PutFixed64(&contents, offset);
+  }
+  const uint32 crc = crc32c::Value(contents.data(), contents.size());
+  core::PutFixed32(&contents, crc32c::Mask(crc));
+  return file->Append(contents);
+}
+
+std::string RecordIndex::IndexFileName(absl::string_view record_filename) {
+  return absl::StrCat(record_filename, ".index");
+}
+
+absl::Status WriteRecordIndexFile(Env* env,
+                                  const std::string& record_filename) {
+  std::unique_ptr<RandomAccessFile> record_file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(record_filename, &record_file));
+  RecordIndex index;
+  TF_RETURN_IF_ERROR(RecordIndex::Build(record_file.get(), &index));
+
+  // Write to a temporary file first, so that readers never see a partially
+  // written index.
+  const std::string index_filename =
+      RecordIndex::IndexFileName(record_filename);
+  const std::string tmp_filename = absl::StrCat(index_filename, ".tmp");
+  std::unique_ptr<WritableFile> index_file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(tmp_filename, &index_file));
+  TF_RETURN_IF_ERROR(index.Write(index_file.get()));
+  TF_RETURN_IF_ERROR(index_file->Close());
+  return env->RenameFile(tmp_filename, index_filename);
+}
+
 SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
@@ -16,6 +16,11 @@ limitations under the License.
 #ifndef XLA_TSL_LIB_IO_RECORD_READER_H_
 #define XLA_TSL_LIB_IO_RECORD_READER_H_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
 #include "xla/tsl/lib/io/inputstream_interface.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/stringpiece.h"
@@ -29,7 +34,9 @@ limitations under the License.
 #include "tsl/platform/types.h"
 
 namespace tsl {
+class Env;
 class RandomAccessFile;
+class WritableFile;
 
 namespace io {
 
@@ -46,6 +53,14 @@ struct RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64_t buffer_size = 0;
 
+  // If readahead_buffer_size is non-zero, the file is read through a
+  // `ReadaheadInputStream` that keeps up to `readahead_max_outstanding_reads`
+  // reads of `readahead_buffer_size / readahead_max_outstanding_reads` bytes
+  // in flight, and `buffer_size` is ignored. As with buffering, reads must be
+  // sequential.
+  int64_t readahead_buffer_size = 0;
+  int readahead_max_outstanding_reads = 4;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -96,6 +111,13 @@ class RecordReader {
   // OUT_OF_RANGE for end of file, or something else for an error.
   absl::Status ReadRecord(uint64* offset, tstring* record);
 
+#if defined(TF_CORD_SUPPORT)
+  // Same as above, but returns the record as a Cord. With readahead, the Cord
+  // refers to the buffers the file was read into rather than copying the
+  // record out of them.
+  absl::Status ReadRecord(uint64* offset, absl::Cord* record);
+#endif
+
   // Skip num_to_skip record starting at "*offset" and update *offset
   // to point to the offset of the next num_to_skip + 1 record.
   // Return OK on success, OUT_OF_RANGE for end of file, or something
@@ -103,6 +125,17 @@ class RecordReader {
   // are actually skipped. It should be equal to num_to_skip on success.
   absl::Status SkipRecords(uint64* offset, int num_to_skip, int* num_skipped);
 
+  // Reads the record at `offset` into *record with positional reads of the
+  // file, without going through the input stream. `record_size` is the size
+  // of the record including its header and footer, e.g. from a `RecordIndex`;
+  // if it is 0, it is read from the record header with an additional read.
+  //
+  // Unlike `ReadRecord`, reads may be issued in any order and from several
+  // threads concurrently. Returns FAILED_PRECONDITION for compressed files,
+  // which can only be read sequentially.
+  absl::Status ReadRecordAt(uint64 offset, uint64 record_size,
+                            tstring* record) const;
+
   // Return the metadata of the Record file.
   //
   // The current implementation scans the file to completion,
@@ -116,9 +149,13 @@ class RecordReader {
 
  private:
   absl::Status ReadChecksummed(uint64 offset, size_t n, tstring* result);
+#if defined(TF_CORD_SUPPORT)
+  absl::Status ReadChecksummed(uint64 offset, size_t n, absl::Cord* result);
+#endif
   absl::Status PositionInputStream(uint64 offset);
 
   RecordReaderOptions options_;
+  tsl::RandomAccessFile* const file_;  // Not owned.
   std::unique_ptr<InputStreamInterface> input_stream_;
   bool last_read_failed_;
 
@@ -128,6 +165,53 @@ class RecordReader {
   void operator=(const RecordReader&) = delete;
 };
 
+// The offsets of the records of an uncompressed TFRecord file, which allow
+// reading its records in any order with `RecordReader::ReadRecordAt`.
+//
+// Indices are stored in sidecar files next to the record files (see
+// `IndexFileName`), so that existing TFRecord files can be read randomly
+// without being rewritten. Format of an index file, with all integers in
+// little-endian byte order:
+//  char      magic[8]  "TFRIDX01"
+//  uint64    num_records
+//  uint64    offsets[num_records + 1]  (the last offset is the file size)
+//  uint32    masked crc of all of the preceding bytes
+class RecordIndex {
+ public:
+  RecordIndex() = default;
+
+  // Builds the index of `file` by scanning the headers of its records.
+  static absl::Status Build(tsl::RandomAccessFile* file, RecordIndex* index);
+
+  // Reads an index written by `Write` from `file`.
+  static absl::Status Read(tsl::RandomAccessFile* file, RecordIndex* index);
+
+  // Appends the encoded index to `file`.
+  absl::Status Write(tsl::WritableFile* file) const;
+
+  // Returns the name of the sidecar index file of `record_filename`.
+  static std::string IndexFileName(absl::string_view record_filename);
+
+  int64_t num_records() const {
+    return static_cast<int64_t>(offsets_.size()) - 1;
+  }
+
+  // Returns the offset of the `i`-th record.
+  uint64 offset(int64_t i) const { return offsets_[i]; }
+
+  // Returns the size of the `i`-th record, including its header and footer.
+  uint64 record_size(int64_t i) const { return offsets_[i + 1] - offsets_[i]; }
+
+ private:
+  // The offsets of the records, followed by the end of the last record.
+  std::vector<uint64> offsets_ = {0};
+};
+
+// Builds the index of the TFRecord file `record_filename` and writes it to its
+// sidecar index file.
+absl::Status WriteRecordIndexFile(tsl::Env* env,
+                                  const std::string& record_filename);
+
 // High-level interface to read TFRecord files.
 //
 // Note: this class is not thread safe; external synchronization required.
@@ -147,6 +231,12 @@ class SequentialRecordReader {
     return underlying_.ReadRecord(&offset_, record);
   }
 
+#if defined(TF_CORD_SUPPORT)
+  absl::Status ReadRecord(absl::Cord* record) {
+    return underlying_.ReadRecord(&offset_, record);
+  }
+#endif
+
   // Skip the next num_to_skip record in the file. Return OK on success,
   // OUT_OF_RANGE for end of file, or something else for an error.
   // "*num_skipped" records the number of records that are actually skipped.
@@ -233,6 +233,74 @@ TEST(RecordReaderWriterTest, TestSkipOutOfRange) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestReadahead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_readahead_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    for (int i = 0; i < 100; ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(strings::StrCat("record_", i)));
+    }
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  for (int64_t readahead_buffer_size : {1, 20, 1000, 1 << 20}) {
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReaderOptions options;
+    options.readahead_buffer_size = readahead_buffer_size;
+    io::SequentialRecordReader reader(read_file.get(), options);
+    int num_skipped;
+    TF_CHECK_OK(reader.SkipRecords(10, &num_skipped));
+    EXPECT_EQ(10, num_skipped);
+    tstring record;
+    for (int i = 10; i < 100; ++i) {
+      TF_CHECK_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(strings::StrCat("record_", i), record);
+    }
+    EXPECT_EQ(error::OUT_OF_RANGE, reader.ReadRecord(&record).code());
+  }
+}
+
+#if defined(TF_CORD_SUPPORT)
+TEST(RecordReaderWriterTest, TestReadCord) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_cord_test";
+  std::vector<string> records;
+  for (int i = 0; i < 20; ++i) {
+    records.push_back(string(i * 100, 'a' + i));
+  }
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    for (const string& record : records) {
+      TF_EXPECT_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  for (int64_t readahead_buffer_size : {0, 20, 1000, 1 << 20}) {
+    for (int64_t buffer_size : {0, 100}) {
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+      io::RecordReaderOptions options;
+      options.readahead_buffer_size = readahead_buffer_size;
+      options.buffer_size = buffer_size;
+      io::SequentialRecordReader reader(read_file.get(), options);
+      absl::Cord record;
+      for (const string& expected : records) {
+        TF_CHECK_OK(reader.ReadRecord(&record));
+        EXPECT_EQ(expected, record);
+      }
+      EXPECT_EQ(error::OUT_OF_RANGE, reader.ReadRecord(&record).code());
+    }
+  }
+}
+#endif
+
 TEST(RecordReaderWriterTest, TestMalformedInput) {
   Env* env = Env::Default();
   string fname =
@@ -343,6 +411,78 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestRecordIndex) {
+  std::vector<string> records = {"abc", "", "defghijklmnop", "q"};
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_index_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    for (const string& record : records) {
+      TF_EXPECT_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+  }
+  TF_ASSERT_OK(io::WriteRecordIndexFile(env, fname));
+
+  std::unique_ptr<RandomAccessFile> index_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(io::RecordIndex::IndexFileName(fname),
+                                       &index_file));
+  io::RecordIndex index;
+  TF_ASSERT_OK(io::RecordIndex::Read(index_file.get(), &index));
+  ASSERT_EQ(index.num_records(), records.size());
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReader reader(read_file.get());
+  tstring record;
+  for (int i = records.size() - 1; i >= 0; --i) {
+    TF_ASSERT_OK(
+        reader.ReadRecordAt(index.offset(i), index.record_size(i), &record));
+    EXPECT_EQ(records[i], record);
+    // Without the record size, it is read from the header.
+    TF_ASSERT_OK(reader.ReadRecordAt(index.offset(i), 0, &record));
+    EXPECT_EQ(records[i], record);
+  }
+  EXPECT_TRUE(errors::IsDataLoss(
+      reader.ReadRecordAt(index.offset(0), index.record_size(0) + 1, &record)));
+  EXPECT_TRUE(errors::IsOutOfRange(
+      reader.ReadRecordAt(index.offset(records.size()), 0, &record)));
+}
+
+TEST(RecordReaderWriterTest, TestRecordIndexCorrupted) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_bad_index_test";
+  TF_CHECK_OK(WriteStringToFile(env, fname, "TFRIDX01 not an index"));
+  std::unique_ptr<RandomAccessFile> index_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &index_file));
+  io::RecordIndex index;
+  EXPECT_TRUE(
+      errors::IsDataLoss(io::RecordIndex::Read(index_file.get(), &index)));
+}
+
+TEST(RecordReaderWriterTest, TestReadRecordAtCompressed) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_read_at_zlib_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(
+        file.get(), io::RecordWriterOptions::CreateRecordWriterOptions("ZLIB"));
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_CHECK_OK(writer.Close());
+  }
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReader reader(
+      read_file.get(),
+      io::RecordReaderOptions::CreateRecordReaderOptions("ZLIB"));
+  tstring record;
+  EXPECT_TRUE(
+      errors::IsFailedPrecondition(reader.ReadRecordAt(0, 0, &record)));
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
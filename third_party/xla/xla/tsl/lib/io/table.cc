@@ -15,8 +15,20 @@ limitations under the License.
 
 #include "xla/tsl/lib/io/table.h"
 
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "xla/tsl/lib/io/block.h"
 #include "xla/tsl/lib/io/cache.h"
+#include "xla/tsl/lib/io/filter_block.h"
+#include "xla/tsl/lib/io/filter_policy.h"
 #include "xla/tsl/lib/io/format.h"
 #include "xla/tsl/lib/io/table_options.h"
 #include "xla/tsl/lib/io/two_level_iterator.h"
@@ -28,12 +40,18 @@ namespace tsl {
 namespace table {
 
 struct Table::Rep {
-  ~Rep() { delete index_block; }
+  ~Rep() {
+    delete filter;
+    delete[] filter_data;
+    delete index_block;
+  }
 
   Options options;
   absl::Status status;
   RandomAccessFile* file;
   uint64 cache_id;
+  FilterBlockReader* filter = nullptr;
+  const char* filter_data = nullptr;
 
   BlockHandle metaindex_handle;  // Handle to metaindex_block: saved from footer
   Block* index_block;
@@ -75,6 +93,7 @@ absl::Status Table::Open(const Options& options, RandomAccessFile* file,
     rep->index_block = index_block;
     rep->cache_id = (options.block_cache ? options.block_cache->NewId() : 0);
     *table = new Table(rep);
+    (*table)->ReadMeta(footer);
   } else {
     if (index_block) delete index_block;
   }
@@ -82,6 +101,47 @@ absl::Status Table::Open(const Options& options, RandomAccessFile* file,
   return s;
 }
 
+void Table::ReadMeta(const Footer& footer) {
+  if (rep_->options.filter_policy == nullptr) {
+    return;  // Do not need any metadata
+  }
+
+  BlockContents contents;
+  if (!ReadBlock(rep_->file, footer.metaindex_handle(), &contents).ok()) {
+    // Do not propagate errors since meta info is not needed for operation
+    return;
+  }
+  Block* meta = new Block(contents);
+
+  Iterator* iter = meta->NewIterator();
+  std::string key = "filter.";
+  key.append(rep_->options.filter_policy->Name());
+  iter->Seek(key);
+  if (iter->Valid() && iter->key() == absl::string_view(key)) {
+    ReadFilter(iter->value());
+  }
+  delete iter;
+  delete meta;
+}
+
+void Table::ReadFilter(const absl::string_view& filter_handle_value) {
+  absl::string_view v = filter_handle_value;
+  BlockHandle filter_handle;
+  if (!filter_handle.DecodeFrom(&v).ok()) {
+    return;
+  }
+
+  BlockContents block;
+  if (!ReadBlock(rep_->file, filter_handle, &block).ok()) {
+    return;
+  }
+  if (block.heap_allocated) {
+    rep_->filter_data = block.data.data();  // Will need to delete later
+  }
+  rep_->filter =
+      new FilterBlockReader(rep_->options.filter_policy, block.data);
+}
+
 Table::~Table() { delete rep_; }
 
 static void DeleteBlock(void* arg, void* ignored) {
@@ -164,7 +224,7 @@ absl::Status Table::InternalGet(const absl::string_view& k, void* arg,
   absl::Status s;
   Iterator* iiter = rep_->index_block->NewIterator();
   iiter->Seek(k);
-  if (iiter->Valid()) {
+  if (iiter->Valid() && BlockMayContain(iiter->value(), k)) {
     Iterator* block_iter = BlockReader(this, iiter->value());
     block_iter->Seek(k);
     if (block_iter->Valid()) {
@@ -180,6 +240,65 @@ absl::Status Table::InternalGet(const absl::string_view& k, void* arg,
   return s;
 }
 
+bool Table::BlockMayContain(const absl::string_view& index_value,
+                            const absl::string_view& key) const {
+  if (rep_->filter == nullptr) {
+    return true;
+  }
+  BlockHandle handle;
+  absl::string_view input = index_value;
+  return !handle.DecodeFrom(&input).ok() ||
+         rep_->filter->KeyMayMatch(handle.offset(), key);
+}
+
+bool Table::KeyMayMatch(const absl::string_view& key) const {
+  std::unique_ptr<Iterator> index_iter(rep_->index_block->NewIterator());
+  index_iter->Seek(key);
+  if (!index_iter->Valid()) {
+    // The key is past the last key in the file, or the index is corrupted,
+    // in which case reading the key reports the error.
+    return !index_iter->status().ok();
+  }
+  return BlockMayContain(index_iter->value(), key);
+}
+
+absl::Status Table::MultiGet(
+    absl::Span<const absl::string_view> keys,
+    std::vector<std::optional<std::string>>* values) const {
+  values->assign(keys.size(), std::nullopt);
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+  std::unique_ptr<Iterator> index_iter(rep_->index_block->NewIterator());
+  // The data block read last, and the index value it was read for.
+  std::unique_ptr<Iterator> block_iter;
+  std::string block_index_value;
+  for (size_t i : order) {
+    const absl::string_view key = keys[i];
+    index_iter->Seek(key);
+    if (!index_iter->Valid()) {
+      // This key and the ones after it are past the last key in the file.
+      break;
+    }
+    if (!BlockMayContain(index_iter->value(), key)) {
+      continue;
+    }
+    if (block_iter == nullptr || index_iter->value() != block_index_value) {
+      block_iter.reset(
+          BlockReader(const_cast<Table*>(this), index_iter->value()));
+      block_index_value = std::string(index_iter->value());
+    }
+    block_iter->Seek(key);
+    if (block_iter->Valid() && block_iter->key() == key) {
+      (*values)[i] = std::string(block_iter->value());
+    }
+    TF_RETURN_IF_ERROR(block_iter->status());
+  }
+  return index_iter->status();
+}
+
 uint64 Table::ApproximateOffsetOf(const absl::string_view& key) const {
   Iterator* index_iter = rep_->index_block->NewIterator();
   index_iter->Seek(key);
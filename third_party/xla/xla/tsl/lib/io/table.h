@@ -18,6 +18,13 @@ limitations under the License.
 
 #include <stdint.h>
 
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "xla/tsl/lib/io/iterator.h"
 
 namespace tsl {
@@ -26,6 +33,7 @@ class RandomAccessFile;
 
 namespace table {
 
+class Footer;
 struct Options;
 
 // A Table is a sorted map from strings to strings.  Tables are
@@ -61,6 +69,19 @@ class Table {
   // be close to the file length.
   uint64 ApproximateOffsetOf(const absl::string_view& key) const;
 
+  // Returns false if the table certainly does not contain "key", which is
+  // decided without reading any data block.  Returns true otherwise.  Only
+  // tables with filters (see Options::filter_policy) rule out keys that are
+  // within the range of keys of the table.
+  bool KeyMayMatch(const absl::string_view& key) const;
+
+  // Looks up "keys" and sets (*values)[i] to the value of keys[i], or to
+  // nullopt if the table does not contain keys[i].  The keys are looked up
+  // in sorted order, so that keys in the same data block share a single
+  // read of the block, and keys that the filter rules out read no block.
+  absl::Status MultiGet(absl::Span<const absl::string_view> keys,
+                        std::vector<std::optional<std::string>>* values) const;
+
  private:
   struct Rep;
   Rep* rep_;
@@ -68,6 +89,14 @@ class Table {
   explicit Table(Rep* rep) { rep_ = rep; }
   static Iterator* BlockReader(void*, const absl::string_view&);
 
+  void ReadMeta(const Footer& footer);
+  void ReadFilter(const absl::string_view& filter_handle_value);
+
+  // Returns false if the filter of the data block at "index_value", an
+  // encoded BlockHandle, shows that the block does not contain "key".
+  bool BlockMayContain(const absl::string_view& index_value,
+                       const absl::string_view& key) const;
+
   // Calls (*handle_result)(arg, ...) with the entry found after a call
   // to Seek(key).  May not make such a call if filter policy says
   // that key is not present.
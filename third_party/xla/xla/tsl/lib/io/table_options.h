@@ -22,6 +22,7 @@ namespace tsl {
 namespace table {
 
 class Cache;
+class FilterPolicy;
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -68,6 +69,13 @@ struct Options {
 
   // If non-null, use the specified cache for blocks.
   Cache* block_cache = nullptr;
+
+  // If non-null, use the specified filter policy to reduce disk reads.
+  // Tables built with a filter policy store a filter of the keys of each
+  // data block, which lets lookups of missing keys skip reading the block.
+  // Tables opened with the same policy use the filters; tables built
+  // without one, or opened without one, are read as before.
+  const FilterPolicy* filter_policy = nullptr;
 };
 
 }  // namespace table
@@ -17,12 +17,18 @@ limitations under the License.
 
 #include <algorithm>
 #include <map>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "xla/tsl/lib/core/status_test_util.h"
 #include "xla/tsl/lib/io/block.h"
 #include "xla/tsl/lib/io/block_builder.h"
+#include "xla/tsl/lib/io/cache.h"
+#include "xla/tsl/lib/io/filter_policy.h"
 #include "xla/tsl/lib/io/format.h"
 #include "xla/tsl/lib/io/iterator.h"
 #include "xla/tsl/lib/io/table_builder.h"
@@ -236,8 +242,7 @@ class TableConstructor : public Constructor {
 
     // Open the table
     source_ = new StringSource(sink.contents());
-    Options table_options;
-    return Table::Open(table_options, source_, sink.contents().size(), &table_);
+    return Table::Open(options, source_, sink.contents().size(), &table_);
   }
 
   Iterator* NewIterator() const override { return table_->NewIterator(); }
@@ -248,6 +253,8 @@ class TableConstructor : public Constructor {
 
   uint64 BytesRead() const { return source_->BytesRead(); }
 
+  const Table* table() const { return table_; }
+
  private:
   void Reset() {
     delete table_;
@@ -634,5 +641,130 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+TEST(TableTest, BloomFilterPolicy) {
+  std::unique_ptr<const FilterPolicy> policy(NewBloomFilterPolicy(10));
+  std::vector<string> keys;
+  for (int i = 0; i < 1000; i++) {
+    keys.push_back(absl::StrCat("key", i));
+  }
+  std::vector<absl::string_view> key_views(keys.begin(), keys.end());
+  string filter;
+  policy->CreateFilter(key_views.data(), key_views.size(), &filter);
+  for (const string& key : keys) {
+    EXPECT_TRUE(policy->KeyMayMatch(key, filter)) << key;
+  }
+  int false_positives = 0;
+  for (int i = 0; i < 10000; i++) {
+    if (policy->KeyMayMatch(absl::StrCat("missing", i), filter)) {
+      false_positives++;
+    }
+  }
+  // ~1% for 10 bits per key.
+  EXPECT_LT(false_positives, 300);
+}
+
+TEST(TableTest, FilterSkipsDataBlocksOfMissingKeys) {
+  std::unique_ptr<const FilterPolicy> policy(NewBloomFilterPolicy(10));
+  TableConstructor c;
+  for (int i = 0; i < 1000; i += 2) {
+    c.Add(absl::StrCat("k", 10000 + i), string(100, 'x'));
+  }
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 1024;
+  options.compression = kNoCompression;
+  options.filter_policy = policy.get();
+  c.Finish(options, &keys, &kvmap);
+
+  const uint64 bytes_read_at_open = c.BytesRead();
+  int matched_missing_keys = 0;
+  for (int i = 1; i < 1000; i += 2) {
+    if (c.table()->KeyMayMatch(absl::StrCat("k", 10000 + i))) {
+      matched_missing_keys++;
+    }
+  }
+  EXPECT_LT(matched_missing_keys, 50);
+  for (const string& key : keys) {
+    EXPECT_TRUE(c.table()->KeyMayMatch(key)) << key;
+  }
+  EXPECT_FALSE(c.table()->KeyMayMatch("z"));
+  // Filters are read when the table is opened.
+  EXPECT_EQ(bytes_read_at_open, c.BytesRead());
+}
+
+TEST(TableTest, TableWithoutFilterMayMatchAnyKey) {
+  TableConstructor c;
+  c.Add("k01", "hello");
+  c.Add("k03", "hello3");
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.compression = kNoCompression;
+  c.Finish(options, &keys, &kvmap);
+  EXPECT_TRUE(c.table()->KeyMayMatch("k01"));
+  EXPECT_TRUE(c.table()->KeyMayMatch("k02"));
+  EXPECT_FALSE(c.table()->KeyMayMatch("z"));
+}
+
+TEST(TableTest, MultiGet) {
+  std::unique_ptr<const FilterPolicy> policy(NewBloomFilterPolicy(10));
+  std::vector<const FilterPolicy*> filter_policies = {nullptr, policy.get()};
+  for (const FilterPolicy* filter_policy : filter_policies) {
+    TableConstructor c;
+    for (int i = 0; i < 100; i += 2) {
+      c.Add(absl::StrCat("k", 100 + i), absl::StrCat("v", i));
+    }
+    std::vector<string> keys;
+    KVMap kvmap;
+    Options options;
+    options.block_size = 256;
+    options.compression = kNoCompression;
+    options.filter_policy = filter_policy;
+    c.Finish(options, &keys, &kvmap);
+
+    std::vector<absl::string_view> lookups = {"k150", "k101", "k100", "z",
+                                              "a",    "k198", "k150"};
+    std::vector<std::optional<string>> values;
+    TF_ASSERT_OK(c.table()->MultiGet(lookups, &values));
+    ASSERT_EQ(values.size(), lookups.size());
+    EXPECT_EQ(values[0], "v50");
+    EXPECT_EQ(values[1], std::nullopt);
+    EXPECT_EQ(values[2], "v0");
+    EXPECT_EQ(values[3], std::nullopt);
+    EXPECT_EQ(values[4], std::nullopt);
+    EXPECT_EQ(values[5], "v98");
+    EXPECT_EQ(values[6], "v50");
+  }
+}
+
+TEST(TableTest, SharedBlockCache) {
+  std::unique_ptr<Cache> cache(NewLRUCache(1 << 20));
+  TableConstructor c1, c2;
+  c1.Add("k01", string(1000, 'a'));
+  c2.Add("k01", string(1000, 'b'));
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.compression = kNoCompression;
+  options.block_cache = cache.get();
+  c1.Finish(options, &keys, &kvmap);
+  c2.Finish(options, &keys, &kvmap);
+
+  // Tables sharing a cache don't see each other's blocks.
+  std::vector<std::optional<string>> values;
+  TF_ASSERT_OK(c1.table()->MultiGet({"k01"}, &values));
+  EXPECT_EQ(values[0], string(1000, 'a'));
+  TF_ASSERT_OK(c2.table()->MultiGet({"k01"}, &values));
+  EXPECT_EQ(values[0], string(1000, 'b'));
+  EXPECT_GT(cache->TotalCharge(), 2000u);
+
+  // Blocks found in the cache are not read again.
+  const uint64 bytes_read = c1.BytesRead();
+  TF_ASSERT_OK(c1.table()->MultiGet({"k01"}, &values));
+  EXPECT_EQ(values[0], string(1000, 'a'));
+  EXPECT_EQ(bytes_read, c1.BytesRead());
+}
+
 }  // namespace table
 }  // namespace tsl
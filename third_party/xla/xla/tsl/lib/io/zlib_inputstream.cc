@@ -236,7 +236,7 @@ absl::Status ZlibInputStream::ReadNBytes(int64_t bytes_to_read,
   tstring buf;
   TF_RETURN_IF_ERROR(ReadNBytes(bytes_to_read, &buf));
   result->Clear();
-  result->Append(buf.data());
+  result->Append(absl::string_view(buf));
   return absl::OkStatus();
 }
 #endif
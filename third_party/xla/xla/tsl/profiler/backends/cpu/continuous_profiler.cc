@@ -0,0 +1,226 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/tsl/profiler/backends/cpu/continuous_profiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "xla/tsl/profiler/backends/cpu/traceme_recorder.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/mutex.h"
+#include "tsl/profiler/lib/profiler_lock.h"
+#include "tsl/profiler/utils/time_utils.h"
+
+namespace tsl {
+namespace profiler {
+namespace {
+
+void AddDuration(int64_t duration_ns, ContinuousProfiler::Stats* stats) {
+  ++stats->count;
+  stats->total_ns += duration_ns;
+  stats->max_ns = std::max(stats->max_ns, duration_ns);
+}
+
+std::string FormatStats(const ContinuousProfiler::Stats& stats) {
+  return absl::StrCat("count=", stats.count,
+                      " total_us=", stats.total_ns / 1000,
+                      " avg_us=", stats.total_ns / 1000 / stats.count,
+                      " max_us=", stats.max_ns / 1000);
+}
+
+mutex global_mu(LINKER_INITIALIZED);
+ContinuousProfiler* global_profiler TF_GUARDED_BY(global_mu) = nullptr;
+
+}  // namespace
+
+ContinuousProfiler::ContinuousProfiler(
+    const ContinuousProfilerOptions& options)
+    : options_(options) {}
+
+ContinuousProfiler::~ContinuousProfiler() { Stop(); }
+
+void ContinuousProfiler::Start() {
+  mutex_lock lock(thread_mu_);
+  if (thread_ != nullptr) return;
+  stop_ = false;
+  thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "continuous_profiler", [this] { Run(); }));
+}
+
+void ContinuousProfiler::Stop() {
+  std::unique_ptr<Thread> thread;
+  {
+    mutex_lock lock(thread_mu_);
+    stop_ = true;
+    stop_cv_.notify_all();
+    thread = std::move(thread_);
+  }
+  // Joins the thread.
+  thread.reset();
+}
+
+void ContinuousProfiler::Run() {
+  const int64_t wait_ms =
+      std::max<int64_t>(options_.period_ms - options_.window_ms, 0);
+  while (true) {
+    {
+      mutex_lock lock(thread_mu_);
+      const int64_t deadline_ns = GetCurrentTimeNanos() + wait_ms * 1000000;
+      while (!stop_ && GetCurrentTimeNanos() < deadline_ns) {
+        WaitForMilliseconds(
+            &lock, &stop_cv_,
+            (deadline_ns - GetCurrentTimeNanos()) / 1000000 + 1);
+      }
+      if (stop_) return;
+    }
+    RecordWindow();
+  }
+}
+
+bool ContinuousProfiler::RecordWindow() {
+  absl::StatusOr<ProfilerLock> profiler_lock = ProfilerLock::Acquire();
+  if (!profiler_lock.ok() || !TraceMeRecorder::Start(options_.trace_level)) {
+    mutex_lock lock(stats_mu_);
+    ++num_skipped_windows_;
+    return false;
+  }
+  const int64_t start_ns = GetCurrentTimeNanos();
+  Env::Default()->SleepForMicroseconds(options_.window_ms * 1000);
+  TraceMeRecorder::Events events = TraceMeRecorder::Stop();
+  const int64_t end_ns = GetCurrentTimeNanos();
+  profiler_lock->ReleaseIfActive();
+  AddWindow(start_ns, end_ns, std::move(events));
+  return true;
+}
+
+void ContinuousProfiler::AddWindow(int64_t start_ns, int64_t end_ns,
+                                   TraceMeRecorder::Events&& events) {
+  WindowSummary window;
+  window.start_ns = start_ns;
+  window.end_ns = end_ns;
+
+  mutex_lock lock(stats_mu_);
+  for (const TraceMeRecorder::ThreadEvents& thread : events) {
+    for (const TraceMeRecorder::Event& event : thread.events) {
+      // Events that started or ended outside of the window are incomplete.
+      if (!event.IsComplete()) continue;
+      ++window.num_events;
+      const int64_t duration_ns = event.end_time - event.start_time;
+      // TraceMe encodes its metadata as "name#key=value,...#".
+      absl::string_view name = event.name;
+      absl::string_view metadata;
+      if (const size_t pos = name.find('#'); pos != absl::string_view::npos) {
+        metadata = name.substr(pos);
+        name = name.substr(0, pos);
+      }
+      if (absl::StrContains(metadata, "step_num=")) {
+        ++window.num_steps;
+        AddDuration(duration_ns, &steps_);
+      }
+      auto it = events_.find(name);
+      if (it == events_.end()) {
+        if (events_.size() >= static_cast<size_t>(options_.max_names)) {
+          ++num_untracked_events_;
+          continue;
+        }
+        it = events_.emplace(name, Stats()).first;
+      }
+      AddDuration(duration_ns, &it->second);
+    }
+  }
+  windows_.push_back(window);
+  while (windows_.size() > static_cast<size_t>(options_.max_windows)) {
+    windows_.pop_front();
+  }
+  ++num_windows_;
+  recorded_ns_ += end_ns - start_ns;
+}
+
+ContinuousProfiler::Snapshot ContinuousProfiler::GetSnapshot() const {
+  Snapshot snapshot;
+  mutex_lock lock(stats_mu_);
+  snapshot.events.assign(events_.begin(), events_.end());
+  std::sort(snapshot.events.begin(), snapshot.events.end(),
+            [](const auto& a, const auto& b) {
+              return a.second.total_ns != b.second.total_ns
+                         ? a.second.total_ns > b.second.total_ns
+                         : a.first < b.first;
+            });
+  snapshot.steps = steps_;
+  snapshot.windows.assign(windows_.begin(), windows_.end());
+  snapshot.num_windows = num_windows_;
+  snapshot.num_skipped_windows = num_skipped_windows_;
+  snapshot.num_untracked_events = num_untracked_events_;
+  snapshot.recorded_ns = recorded_ns_;
+  return snapshot;
+}
+
+/*static*/ void ContinuousProfiler::StartGlobal(
+    const ContinuousProfilerOptions& options) {
+  mutex_lock lock(global_mu);
+  if (global_profiler != nullptr) return;
+  global_profiler = new ContinuousProfiler(options);
+  global_profiler->Start();
+}
+
+/*static*/ void ContinuousProfiler::StopGlobal() {
+  mutex_lock lock(global_mu);
+  delete global_profiler;
+  global_profiler = nullptr;
+}
+
+/*static*/ std::optional<ContinuousProfiler::Snapshot>
+ContinuousProfiler::GetGlobalSnapshot() {
+  mutex_lock lock(global_mu);
+  if (global_profiler == nullptr) return std::nullopt;
+  return global_profiler->GetSnapshot();
+}
+
+std::string FormatContinuousProfile(
+    const ContinuousProfiler::Snapshot& snapshot, int max_events) {
+  std::string result = absl::StrCat(
+      "Continuous profile: ", snapshot.num_windows, " windows (",
+      snapshot.num_skipped_windows, " skipped), ",
+      snapshot.recorded_ns / 1000000, " ms recorded\n");
+  if (snapshot.steps.count > 0) {
+    absl::StrAppend(&result, "Steps: ", FormatStats(snapshot.steps), "\n");
+  }
+  const int num_events =
+      std::min<int>(max_events, snapshot.events.size());
+  absl::StrAppend(&result, "Top ", num_events, " of ", snapshot.events.size(),
+                  " events by total time:\n");
+  for (int i = 0; i < num_events; ++i) {
+    const auto& [name, stats] = snapshot.events[i];
+    absl::StrAppend(&result, "  ", name, ": ", FormatStats(stats), "\n");
+  }
+  if (snapshot.num_untracked_events > 0) {
+    absl::StrAppend(&result, snapshot.num_untracked_events,
+                    " events of untracked names\n");
+  }
+  return result;
+}
+
+}  // namespace profiler
+}  // namespace tsl
@@ -0,0 +1,142 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_TSL_PROFILER_BACKENDS_CPU_CONTINUOUS_PROFILER_H_
+#define XLA_TSL_PROFILER_BACKENDS_CPU_CONTINUOUS_PROFILER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "xla/tsl/profiler/backends/cpu/traceme_recorder.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/mutex.h"
+#include "tsl/platform/thread_annotations.h"
+
+namespace tsl {
+namespace profiler {
+
+struct ContinuousProfilerOptions {
+  // A window of `window_ms` is recorded every `period_ms`, so the overhead of
+  // recording TraceMes is only paid window_ms / period_ms of the time.
+  int64_t period_ms = 10000;
+  int64_t window_ms = 100;
+  // Only TraceMes with a level <= trace_level are recorded.
+  int trace_level = 1;
+  // The maximum number of distinct event names with statistics. Events with
+  // other names are only counted.
+  int max_names = 1024;
+  // The number of most recent windows whose summaries are kept.
+  int max_windows = 64;
+};
+
+// Profiles the host continuously at a low duty cycle, so that it can stay
+// enabled in production.
+//
+// TraceMes are recorded in short periodic windows. Rather than keeping the
+// events, their durations are aggregated per name, and per step for the
+// events with a step_num. Memory is bounded by `max_names` and `max_windows`.
+//
+// Windows are skipped while another profiling session is active, and a
+// ProfilerSession started during a window fails with kProfilerLockContention,
+// so short windows should be used when sessions are expected.
+class ContinuousProfiler {
+ public:
+  struct Stats {
+    int64_t count = 0;
+    int64_t total_ns = 0;
+    int64_t max_ns = 0;
+  };
+
+  struct WindowSummary {
+    int64_t start_ns = 0;
+    int64_t end_ns = 0;
+    int64_t num_events = 0;
+    int64_t num_steps = 0;
+  };
+
+  struct Snapshot {
+    // Statistics per event name, by decreasing total time.
+    std::vector<std::pair<std::string, Stats>> events;
+    Stats steps;
+    // The most recent windows, oldest first.
+    std::vector<WindowSummary> windows;
+    int64_t num_windows = 0;
+    int64_t num_skipped_windows = 0;
+    int64_t num_untracked_events = 0;
+    int64_t recorded_ns = 0;
+  };
+
+  explicit ContinuousProfiler(const ContinuousProfilerOptions& options);
+  ~ContinuousProfiler();
+
+  ContinuousProfiler(const ContinuousProfiler&) = delete;
+  ContinuousProfiler& operator=(const ContinuousProfiler&) = delete;
+
+  // Starts or stops recording windows in a background thread.
+  void Start();
+  void Stop();
+
+  // Records a single window, blocking for `window_ms`. Returns false if the
+  // window was skipped because another profiling session is active.
+  bool RecordWindow();
+
+  // Aggregates the events of a window recorded in [start_ns, end_ns].
+  void AddWindow(int64_t start_ns, int64_t end_ns,
+                 TraceMeRecorder::Events&& events);
+
+  Snapshot GetSnapshot() const;
+
+  // Starts or stops the process wide profiler that the profiler service
+  // reports.
+  static void StartGlobal(const ContinuousProfilerOptions& options);
+  static void StopGlobal();
+  // Returns the snapshot of the process wide profiler, if it is running.
+  static std::optional<Snapshot> GetGlobalSnapshot();
+
+ private:
+  void Run();
+
+  const ContinuousProfilerOptions options_;
+
+  mutex thread_mu_;
+  condition_variable stop_cv_;
+  bool stop_ TF_GUARDED_BY(thread_mu_) = false;
+  std::unique_ptr<Thread> thread_;
+
+  mutable mutex stats_mu_;
+  absl::flat_hash_map<std::string, Stats> events_ TF_GUARDED_BY(stats_mu_);
+  Stats steps_ TF_GUARDED_BY(stats_mu_);
+  std::deque<WindowSummary> windows_ TF_GUARDED_BY(stats_mu_);
+  int64_t num_windows_ TF_GUARDED_BY(stats_mu_) = 0;
+  int64_t num_skipped_windows_ TF_GUARDED_BY(stats_mu_) = 0;
+  int64_t num_untracked_events_ TF_GUARDED_BY(stats_mu_) = 0;
+  int64_t recorded_ns_ TF_GUARDED_BY(stats_mu_) = 0;
+};
+
+// Formats the `max_events` events with the largest total time of `snapshot`
+// for humans.
+std::string FormatContinuousProfile(
+    const ContinuousProfiler::Snapshot& snapshot, int max_events);
+
+}  // namespace profiler
+}  // namespace tsl
+
+#endif  // XLA_TSL_PROFILER_BACKENDS_CPU_CONTINUOUS_PROFILER_H_
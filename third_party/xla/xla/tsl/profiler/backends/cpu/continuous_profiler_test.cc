@@ -0,0 +1,150 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/tsl/profiler/backends/cpu/continuous_profiler.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "xla/tsl/profiler/backends/cpu/traceme_recorder.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/notification.h"
+#include "tsl/platform/test.h"
+#include "tsl/profiler/lib/profiler_lock.h"
+#include "tsl/profiler/utils/time_utils.h"
+
+namespace tsl {
+namespace profiler {
+namespace {
+
+TraceMeRecorder::Event MakeEvent(std::string name, int64_t start_time,
+                                 int64_t end_time) {
+  return TraceMeRecorder::Event{std::move(name), start_time, end_time};
+}
+
+TraceMeRecorder::Events MakeEvents(
+    std::initializer_list<TraceMeRecorder::Event> events) {
+  TraceMeRecorder::Events result(1);
+  result[0].events.assign(events.begin(), events.end());
+  return result;
+}
+
+TEST(ContinuousProfilerTest, AggregatesEventsByName) {
+  ContinuousProfiler profiler({});
+  profiler.AddWindow(0, 1000,
+                     MakeEvents({MakeEvent("Conv#id=1#", 100, 300),
+                                 MakeEvent("Conv#id=2#", 400, 500),
+                                 MakeEvent("MatMul", 500, 900),
+                                 MakeEvent("Train#step_num=3#", 10, 990),
+                                 MakeEvent("Started", 100, -7)}));
+
+  ContinuousProfiler::Snapshot snapshot = profiler.GetSnapshot();
+  ASSERT_EQ(snapshot.events.size(), 3);
+  EXPECT_EQ(snapshot.events[0].first, "Train");
+  EXPECT_EQ(snapshot.events[1].first, "MatMul");
+  EXPECT_EQ(snapshot.events[2].first, "Conv");
+  EXPECT_EQ(snapshot.events[2].second.count, 2);
+  EXPECT_EQ(snapshot.events[2].second.total_ns, 300);
+  EXPECT_EQ(snapshot.events[2].second.max_ns, 200);
+  EXPECT_EQ(snapshot.steps.count, 1);
+  EXPECT_EQ(snapshot.steps.total_ns, 980);
+  ASSERT_EQ(snapshot.windows.size(), 1);
+  EXPECT_EQ(snapshot.windows[0].num_events, 4);
+  EXPECT_EQ(snapshot.windows[0].num_steps, 1);
+  EXPECT_EQ(snapshot.num_windows, 1);
+  EXPECT_EQ(snapshot.recorded_ns, 1000);
+}
+
+TEST(ContinuousProfilerTest, BoundsNamesAndWindows) {
+  ContinuousProfilerOptions options;
+  options.max_names = 2;
+  options.max_windows = 2;
+  ContinuousProfiler profiler(options);
+  for (int i = 0; i < 3; ++i) {
+    profiler.AddWindow(i * 1000, i * 1000 + 100,
+                       MakeEvents({MakeEvent("A", 1, 2), MakeEvent("B", 1, 2),
+                                   MakeEvent("C", 1, 2)}));
+  }
+
+  ContinuousProfiler::Snapshot snapshot = profiler.GetSnapshot();
+  EXPECT_EQ(snapshot.events.size(), 2);
+  EXPECT_EQ(snapshot.num_untracked_events, 3);
+  ASSERT_EQ(snapshot.windows.size(), 2);
+  EXPECT_EQ(snapshot.windows[0].start_ns, 1000);
+  EXPECT_EQ(snapshot.num_windows, 3);
+  EXPECT_EQ(snapshot.recorded_ns, 300);
+}
+
+TEST(ContinuousProfilerTest, SkipsWindowsDuringOtherSessions) {
+  absl::StatusOr<ProfilerLock> profiler_lock = ProfilerLock::Acquire();
+  ASSERT_TRUE(profiler_lock.ok());
+  ContinuousProfiler profiler({});
+  EXPECT_FALSE(profiler.RecordWindow());
+  EXPECT_EQ(profiler.GetSnapshot().num_skipped_windows, 1);
+  EXPECT_EQ(profiler.GetSnapshot().num_windows, 0);
+}
+
+TEST(ContinuousProfilerTest, RecordsTraceMes) {
+  ContinuousProfilerOptions options;
+  options.window_ms = 200;
+  ContinuousProfiler profiler(options);
+  Notification recorded;
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      ThreadOptions(), "recorder", [&recorded] {
+        // Wait for the window to start.
+        while (!TraceMeRecorder::Active()) {
+          Env::Default()->SleepForMicroseconds(1000);
+        }
+        const int64_t start_time = GetCurrentTimeNanos();
+        TraceMeRecorder::Record(
+            MakeEvent("Work", start_time, GetCurrentTimeNanos() + 1));
+        recorded.Notify();
+      }));
+
+  EXPECT_TRUE(profiler.RecordWindow());
+  recorded.WaitForNotification();
+  ContinuousProfiler::Snapshot snapshot = profiler.GetSnapshot();
+  ASSERT_EQ(snapshot.events.size(), 1);
+  EXPECT_EQ(snapshot.events[0].first, "Work");
+  EXPECT_GE(snapshot.recorded_ns, 200000000);
+}
+
+TEST(ContinuousProfilerTest, GlobalProfiler) {
+  EXPECT_FALSE(ContinuousProfiler::GetGlobalSnapshot().has_value());
+  ContinuousProfilerOptions options;
+  options.period_ms = 20;
+  options.window_ms = 10;
+  ContinuousProfiler::StartGlobal(options);
+  std::optional<ContinuousProfiler::Snapshot> snapshot;
+  do {
+    Env::Default()->SleepForMicroseconds(10000);
+    snapshot = ContinuousProfiler::GetGlobalSnapshot();
+    ASSERT_TRUE(snapshot.has_value());
+  } while (snapshot->num_windows == 0);
+  ContinuousProfiler::StopGlobal();
+  EXPECT_FALSE(ContinuousProfiler::GetGlobalSnapshot().has_value());
+  EXPECT_TRUE(absl::StrContains(FormatContinuousProfile(*snapshot, 10),
+                                "Continuous profile: "));
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tsl
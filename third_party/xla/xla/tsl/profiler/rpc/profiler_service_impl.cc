@@ -16,10 +16,12 @@ limitations under the License.
 #include "xla/tsl/profiler/rpc/profiler_service_impl.h"
 
 #include <memory>
+#include <optional>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_replace.h"
 #include "grpcpp/support/status.h"
+#include "xla/tsl/profiler/backends/cpu/continuous_profiler.h"
 #include "xla/tsl/profiler/rpc/client/save_profile.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/env_time.h"
@@ -68,7 +70,17 @@ class ProfilerServiceImpl : public tensorflow::grpc::ProfilerService::Service {
  public:
   ::grpc::Status Monitor(::grpc::ServerContext* ctx, const MonitorRequest* req,
                          MonitorResponse* response) override {
-    return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "unimplemented.");
+    // Reports what the continuous profiler aggregated so far, rather than
+    // profiling for req->duration_ms().
+    std::optional<ContinuousProfiler::Snapshot> snapshot =
+        ContinuousProfiler::GetGlobalSnapshot();
+    if (!snapshot.has_value()) {
+      return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION,
+                            "Continuous profiling is not running.");
+    }
+    response->set_data(FormatContinuousProfile(
+        *snapshot, /*max_events=*/req->monitoring_level() <= 1 ? 10 : 100));
+    return ::grpc::Status::OK;
   }
 
   ::grpc::Status Profile(::grpc::ServerContext* ctx, const ProfileRequest* req,